@@ -78,15 +78,15 @@ void BanMapFromJson(const UniValue& bans_json, banmap_t& bans)
     }
 }
 
-template <typename Stream, typename Data>
-bool SerializeDB(Stream& stream, const Data& data)
+template <typename Data>
+bool SerializeDB(CDataStream& stream, const Data& data)
 {
-    // Write and commit header, data
+    // Serialize header and data once into memory and checksum the result. Data that takes a
+    // lock for serializing, like CAddrMan, is only locked for this copy and not during disk I/O.
     try {
-        CHashWriter hasher(stream.GetType(), stream.GetVersion());
         stream << Params().MessageStart() << data;
-        hasher << Params().MessageStart() << data;
-        stream << hasher.GetHash();
+        const uint256 hash{Hash(MakeUCharSpan(stream))};
+        stream << hash;
     } catch (const std::exception& e) {
         return error("%s: Serialize or I/O error - %s", __func__, e.what());
     }
@@ -102,6 +102,11 @@ bool SerializeFileDB(const std::string& prefix, const fs::path& path, const Data
     GetRandBytes((unsigned char*)&randv, sizeof(randv));
     std::string tmpfn = strprintf("%s.%04x", prefix, randv);
 
+    CDataStream ssData(SER_DISK, version);
+    if (!SerializeDB(ssData, data)) {
+        return false;
+    }
+
     // open temp output file, and associate with CAutoFile
     fs::path pathTmp = GetDataDir() / tmpfn;
     FILE *file = fsbridge::fopen(pathTmp, "wb");
@@ -112,11 +117,13 @@ bool SerializeFileDB(const std::string& prefix, const fs::path& path, const Data
         return error("%s: Failed to open file %s", __func__, pathTmp.string());
     }
 
-    // Serialize
-    if (!SerializeDB(fileout, data)) {
+    // Write the serialized snapshot
+    try {
+        fileout.write(MakeByteSpan(ssData));
+    } catch (const std::exception& e) {
         fileout.fclose();
         remove(pathTmp);
-        return false;
+        return error("%s: I/O error - %s", __func__, e.what());
     }
     if (!FileCommit(fileout.Get())) {
         fileout.fclose();
@@ -175,7 +182,16 @@ bool DeserializeFileDB(const fs::path& path, Data& data, int version)
         LogPrintf("Missing or invalid file %s\n", path.string());
         return false;
     }
-    return DeserializeDB(filein, data);
+    // Read the whole file at once and parse it from memory, which avoids the many small reads
+    // of deserializing and hashing straight from the file.
+    CDataStream ssData(SER_DISK, version);
+    try {
+        ssData.resize(fs::file_size(path));
+        filein.read(MakeWritableByteSpan(ssData));
+    } catch (const std::exception& e) {
+        return error("%s: I/O error - %s", __func__, e.what());
+    }
+    return DeserializeDB(ssData, data);
 }
 } // namespace
 
@@ -214,6 +214,24 @@ public:
     }
 };
 
+/** Running totals of an address, kept next to its entries so balances don't need a full scan */
+struct CAddressBalanceValue {
+public:
+    CAmount m_balance{0};
+    CAmount m_received{0};
+
+public:
+    bool IsNull() const {
+        return m_balance == 0 && m_received == 0;
+    }
+
+public:
+    SERIALIZE_METHODS(CAddressBalanceValue, obj)
+    {
+        READWRITE(obj.m_balance, obj.m_received);
+    }
+};
+
 bool AddressBytesFromScript(const CScript& script, AddressType& address_type, uint160& address_bytes);
 
 #endif // BITCOIN_ADDRESSINDEX_H
@@ -101,10 +101,11 @@ void CAddrMan::RemoveInvalid()
             if (addr_info.IsValid()) {
                 continue;
             }
-            vvTried[bucket][i] = -1;
+            SetTried(bucket, i, -1);
             --nTried;
             SwapRandom(addr_info.nRandomPos, vRandom.size() - 1);
             vRandom.pop_back();
+            m_size = vRandom.size();
             mapAddr.erase(addr_info);
             mapInfo.erase(id);
             m_tried_collisions.erase(id);
@@ -143,11 +144,28 @@ CAddrInfo* CAddrMan::Create(const CAddress& addr, const CNetAddr& addrSource, in
     mapAddr[addr2] = nId;
     mapInfo[nId].nRandomPos = vRandom.size();
     vRandom.push_back(nId);
+    m_size = vRandom.size();
     if (pnId)
         *pnId = nId;
     return &mapInfo[nId];
 }
 
+void CAddrMan::SetTried(int nKBucket, int nKBucketPos, int nId)
+{
+    AssertLockHeld(cs);
+
+    vvTried[nKBucket][nKBucketPos] = nId;
+    m_tried_slots.Set(nKBucket * ADDRMAN_BUCKET_SIZE + nKBucketPos, nId != -1);
+}
+
+void CAddrMan::SetNew(int nUBucket, int nUBucketPos, int nId)
+{
+    AssertLockHeld(cs);
+
+    vvNew[nUBucket][nUBucketPos] = nId;
+    m_new_slots.Set(nUBucket * ADDRMAN_BUCKET_SIZE + nUBucketPos, nId != -1);
+}
+
 void CAddrMan::SwapRandom(unsigned int nRndPos1, unsigned int nRndPos2) const
 {
     AssertLockHeld(cs);
@@ -188,6 +206,7 @@ void CAddrMan::Delete(int nId)
 
     SwapRandom(info.nRandomPos, vRandom.size() - 1);
     vRandom.pop_back();
+    m_size = vRandom.size();
     mapAddr.erase(addr);
     mapInfo.erase(nId);
     nNew--;
@@ -203,7 +222,7 @@ void CAddrMan::ClearNew(int nUBucket, int nUBucketPos)
         CAddrInfo& infoDelete = mapInfo[nIdDelete];
         assert(infoDelete.nRefCount > 0);
         infoDelete.nRefCount--;
-        vvNew[nUBucket][nUBucketPos] = -1;
+        SetNew(nUBucket, nUBucketPos, -1);
         if (infoDelete.nRefCount == 0) {
             Delete(nIdDelete);
         }
@@ -218,7 +237,7 @@ void CAddrMan::MakeTried(CAddrInfo& info, int nId)
     for (int bucket = 0; bucket < ADDRMAN_NEW_BUCKET_COUNT; bucket++) {
         int pos = info.GetBucketPosition(nKey, true, bucket);
         if (vvNew[bucket][pos] == nId) {
-            vvNew[bucket][pos] = -1;
+            SetNew(bucket, pos, -1);
             info.nRefCount--;
         }
     }
@@ -239,7 +258,7 @@ void CAddrMan::MakeTried(CAddrInfo& info, int nId)
 
         // Remove the to-be-evicted item from the tried set.
         infoOld.fInTried = false;
-        vvTried[nKBucket][nKBucketPos] = -1;
+        SetTried(nKBucket, nKBucketPos, -1);
         nTried--;
 
         // find which new bucket it belongs to
@@ -250,12 +269,12 @@ void CAddrMan::MakeTried(CAddrInfo& info, int nId)
 
         // Enter it into the new set again.
         infoOld.nRefCount = 1;
-        vvNew[nUBucket][nUBucketPos] = nIdEvict;
+        SetNew(nUBucket, nUBucketPos, nIdEvict);
         nNew++;
     }
     assert(vvTried[nKBucket][nKBucketPos] == -1);
 
-    vvTried[nKBucket][nKBucketPos] = nId;
+    SetTried(nKBucket, nKBucketPos, nId);
     nTried++;
     info.fInTried = true;
 }
@@ -399,7 +418,7 @@ bool CAddrMan::Add_(const CAddress& addr, const CNetAddr& source, int64_t nTimeP
         if (fInsert) {
             ClearNew(nUBucket, nUBucketPos);
             pinfo->nRefCount++;
-            vvNew[nUBucket][nUBucketPos] = nId;
+            SetNew(nUBucket, nUBucketPos, nId);
         } else {
             if (pinfo->nRefCount == 0) {
                 Delete(nId);
@@ -444,18 +463,15 @@ CAddrInfo CAddrMan::Select_(bool newOnly) const
         return CAddrInfo();
 
     // Use a 50% chance for choosing between tried and new table entries.
+    // Positions are drawn from the occupied ones directly instead of probing the table for
+    // one, which took long on a sparse table.
     if (!newOnly &&
        (nTried > 0 && (nNew == 0 || insecure_rand.randbool() == 0))) {
         // use a tried node
         double fChanceFactor = 1.0;
         while (1) {
-            int nKBucket = insecure_rand.randrange(ADDRMAN_TRIED_BUCKET_COUNT);
-            int nKBucketPos = insecure_rand.randrange(ADDRMAN_BUCKET_SIZE);
-            while (vvTried[nKBucket][nKBucketPos] == -1) {
-                nKBucket = (nKBucket + insecure_rand.randbits(ADDRMAN_TRIED_BUCKET_COUNT_LOG2)) % ADDRMAN_TRIED_BUCKET_COUNT;
-                nKBucketPos = (nKBucketPos + insecure_rand.randbits(ADDRMAN_BUCKET_SIZE_LOG2)) % ADDRMAN_BUCKET_SIZE;
-            }
-            int nId = vvTried[nKBucket][nKBucketPos];
+            const int slot = m_tried_slots[insecure_rand.randrange(m_tried_slots.size())];
+            int nId = vvTried[slot / ADDRMAN_BUCKET_SIZE][slot % ADDRMAN_BUCKET_SIZE];
             const auto it_found{mapInfo.find(nId)};
             assert(it_found != mapInfo.end());
             const CAddrInfo& info{it_found->second};
@@ -467,13 +483,8 @@ CAddrInfo CAddrMan::Select_(bool newOnly) const
         // use a new node
         double fChanceFactor = 1.0;
         while (1) {
-            int nUBucket = insecure_rand.randrange(ADDRMAN_NEW_BUCKET_COUNT);
-            int nUBucketPos = insecure_rand.randrange(ADDRMAN_BUCKET_SIZE);
-            while (vvNew[nUBucket][nUBucketPos] == -1) {
-                nUBucket = (nUBucket + insecure_rand.randbits(ADDRMAN_NEW_BUCKET_COUNT_LOG2)) % ADDRMAN_NEW_BUCKET_COUNT;
-                nUBucketPos = (nUBucketPos + insecure_rand.randbits(ADDRMAN_BUCKET_SIZE_LOG2)) % ADDRMAN_BUCKET_SIZE;
-            }
-            int nId = vvNew[nUBucket][nUBucketPos];
+            const int slot = m_new_slots[insecure_rand.randrange(m_new_slots.size())];
+            int nId = vvNew[slot / ADDRMAN_BUCKET_SIZE][slot % ADDRMAN_BUCKET_SIZE];
             const auto it_found{mapInfo.find(nId)};
             assert(it_found != mapInfo.end());
             const CAddrInfo& info{it_found->second};
@@ -525,8 +536,12 @@ int CAddrMan::Check_()
     if (mapNew.size() != (size_t)nNew)
         return -10;
 
+    if (m_tried_slots.size() != (size_t)nTried)
+        return -20;
     for (int n = 0; n < ADDRMAN_TRIED_BUCKET_COUNT; n++) {
         for (int i = 0; i < ADDRMAN_BUCKET_SIZE; i++) {
+            if ((vvTried[n][i] != -1) != m_tried_slots.Contains(n * ADDRMAN_BUCKET_SIZE + i))
+                return -21;
             if (vvTried[n][i] != -1) {
                 if (!setTried.count(vvTried[n][i]))
                     return -11;
@@ -541,6 +556,8 @@ int CAddrMan::Check_()
 
     for (int n = 0; n < ADDRMAN_NEW_BUCKET_COUNT; n++) {
         for (int i = 0; i < ADDRMAN_BUCKET_SIZE; i++) {
+            if ((vvNew[n][i] != -1) != m_new_slots.Contains(n * ADDRMAN_BUCKET_SIZE + i))
+                return -21;
             if (vvNew[n][i] != -1) {
                 if (!mapNew.count(vvNew[n][i]))
                     return -12;
@@ -812,8 +829,8 @@ void CAddrMan::ResetI2PPorts()
 
             // Reposition from i to i_target, removing the entry from i_target (if any).
             ClearNew(bucket, i_target);
-            vvNew[bucket][i_target] = id;
-            vvNew[bucket][i] = -1;
+            SetNew(bucket, i_target, id);
+            SetNew(bucket, i, -1);
             addr_info = addr_info_newport;
         }
     }
@@ -854,7 +871,7 @@ void CAddrMan::ResetI2PPorts()
                 CAddrInfo& old_target_info = mapInfo[old_target_id];
 
                 old_target_info.fInTried = false;
-                vvTried[bucket_target][i_target] = -1;
+                SetTried(bucket_target, i_target, -1);
                 --nTried;
 
                 const auto new_bucket = old_target_info.GetNewBucket(nKey, m_asmap);
@@ -862,12 +879,12 @@ void CAddrMan::ResetI2PPorts()
                 ClearNew(new_bucket, new_bucket_i);
 
                 old_target_info.nRefCount = 1;
-                vvNew[new_bucket][new_bucket_i] = old_target_id;
+                SetNew(new_bucket, new_bucket_i, old_target_id);
                 ++nNew;
             }
 
-            vvTried[bucket_target][i_target] = id;
-            vvTried[bucket][i] = -1;
+            SetTried(bucket_target, i_target, id);
+            SetTried(bucket, i, -1);
             addr_info = addr_info_newport;
         }
     }
@@ -10,6 +10,7 @@
 #include <config/bitcoin-config.h>
 #include <fs.h>
 #include <hash.h>
+#include <memusage.h>
 #include <netaddress.h>
 #include <protocol.h>
 #include <random.h>
@@ -19,6 +20,7 @@
 #include <tinyformat.h>
 #include <util/system.h>
 
+#include <atomic>
 #include <ios>
 #include <optional>
 #include <set>
@@ -172,6 +174,49 @@ public:
 //! the maximum time we'll spend trying to resolve a tried table collision, in seconds
 static const int64_t ADDRMAN_TEST_WINDOW = 40*60; // 40 minutes
 
+/**
+ * The occupied positions (bucket * ADDRMAN_BUCKET_SIZE + position) of a bucket table, so that
+ * a random occupied position can be picked in constant time however full the table is.
+ */
+class AddrTableSlots
+{
+private:
+    //! the occupied positions in no particular order
+    std::vector<int> m_slots;
+    //! index of every position in m_slots, -1 if the position is empty
+    std::vector<int> m_index;
+
+public:
+    explicit AddrTableSlots(size_t positions) : m_index(positions, -1) {}
+
+    void Set(int slot, bool occupied)
+    {
+        int& index = m_index[slot];
+        if (occupied && index == -1) {
+            index = m_slots.size();
+            m_slots.push_back(slot);
+        } else if (!occupied && index != -1) {
+            m_index[m_slots.back()] = index;
+            m_slots[index] = m_slots.back();
+            m_slots.pop_back();
+            index = -1;
+        }
+    }
+
+    bool Contains(int slot) const { return m_index[slot] != -1; }
+    size_t size() const { return m_slots.size(); }
+    int operator[](size_t i) const { return m_slots[i]; }
+    size_t DynamicMemoryUsage() const { return memusage::DynamicUsage(m_slots) + memusage::DynamicUsage(m_index); }
+
+    void Clear()
+    {
+        for (const int slot : m_slots) {
+            m_index[slot] = -1;
+        }
+        m_slots.clear();
+    }
+};
+
 /**
  * Stochastical (IP) address manager
  */
@@ -377,7 +422,7 @@ public:
                 vRandom.push_back(nIdCount);
                 mapInfo[nIdCount] = info;
                 mapAddr[info] = nIdCount;
-                vvTried[nKBucket][nKBucketPos] = nIdCount;
+                SetTried(nKBucket, nKBucketPos, nIdCount);
                 nIdCount++;
             } else {
                 nLost++;
@@ -433,7 +478,7 @@ public:
             int bucket_position = info.GetBucketPosition(nKey, true, bucket);
             if (restore_bucketing && vvNew[bucket][bucket_position] == -1) {
                 // Bucketing has not changed, using existing bucket positions for the new table
-                vvNew[bucket][bucket_position] = entry_index;
+                SetNew(bucket, bucket_position, entry_index);
                 ++info.nRefCount;
             } else {
                 // In case the new table data cannot be used (bucket count wrong or new asmap),
@@ -441,7 +486,7 @@ public:
                 bucket = info.GetNewBucket(nKey, m_asmap);
                 bucket_position = info.GetBucketPosition(nKey, true, bucket);
                 if (vvNew[bucket][bucket_position] == -1) {
-                    vvNew[bucket][bucket_position] = entry_index;
+                    SetNew(bucket, bucket_position, entry_index);
                     ++info.nRefCount;
                 }
             }
@@ -466,6 +511,8 @@ public:
 
         ResetI2PPorts();
 
+        m_size = vRandom.size();
+
         Check();
     }
 
@@ -474,6 +521,7 @@ public:
     {
         LOCK(cs);
         std::vector<int>().swap(vRandom);
+        m_size = 0;
         nKey = insecure_rand.rand256();
         for (size_t bucket = 0; bucket < ADDRMAN_NEW_BUCKET_COUNT; bucket++) {
             for (size_t entry = 0; entry < ADDRMAN_BUCKET_SIZE; entry++) {
@@ -485,6 +533,8 @@ public:
                 vvTried[bucket][entry] = -1;
             }
         }
+        m_new_slots.Clear();
+        m_tried_slots.Clear();
 
         nIdCount = 0;
         nTried = 0;
@@ -507,10 +557,18 @@ public:
 
     //! Return the number of (unique) addresses in all tables.
     size_t size() const
+    {
+        return m_size.load(std::memory_order_relaxed);
+    }
+
+    //! Estimated memory used by the address tables, including the fixed size bucket arrays.
+    size_t DynamicMemoryUsage() const
         EXCLUSIVE_LOCKS_REQUIRED(!cs)
     {
-        LOCK(cs); // TODO: Cache this in an atomic to avoid this overhead
-        return vRandom.size();
+        LOCK(cs);
+        return memusage::DynamicUsage(mapInfo) + memusage::DynamicUsage(mapAddr) + memusage::DynamicUsage(vRandom) +
+               sizeof(vvTried) + sizeof(vvNew) + m_tried_slots.DynamicMemoryUsage() + m_new_slots.DynamicMemoryUsage() +
+               memusage::DynamicUsage(m_tried_collisions);
     }
 
     //! Add a single address.
@@ -693,6 +751,9 @@ private:
     //! changes to it (even in const methods) are also unobservable.
     mutable std::vector<int> vRandom GUARDED_BY(cs);
 
+    //! vRandom.size(), readable without taking cs
+    std::atomic<size_t> m_size{0};
+
     // number of "tried" entries
     int nTried GUARDED_BY(cs);
 
@@ -705,6 +766,10 @@ private:
     //! list of "new" buckets
     int vvNew[ADDRMAN_NEW_BUCKET_COUNT][ADDRMAN_BUCKET_SIZE] GUARDED_BY(cs);
 
+    //! occupied positions of vvTried and vvNew, only to be changed through SetTried and SetNew
+    AddrTableSlots m_tried_slots GUARDED_BY(cs){ADDRMAN_TRIED_BUCKET_COUNT * ADDRMAN_BUCKET_SIZE};
+    AddrTableSlots m_new_slots GUARDED_BY(cs){ADDRMAN_NEW_BUCKET_COUNT * ADDRMAN_BUCKET_SIZE};
+
     //! last time Good was called (memory only)
     int64_t nLastGood GUARDED_BY(cs);
 
@@ -720,6 +785,10 @@ private:
     //! Create a new entry and add it to the internal data structures mapInfo, mapAddr and vRandom.
     CAddrInfo* Create(const CAddress &addr, const CNetAddr &addrSource, int *pnId = nullptr) EXCLUSIVE_LOCKS_REQUIRED(cs);
 
+    //! Store nId (-1 for none) at a position of the tried or new table.
+    void SetTried(int nKBucket, int nKBucketPos, int nId) EXCLUSIVE_LOCKS_REQUIRED(cs);
+    void SetNew(int nUBucket, int nUBucketPos, int nId) EXCLUSIVE_LOCKS_REQUIRED(cs);
+
     //! Swap two elements in vRandom.
     void SwapRandom(unsigned int nRandomPos1, unsigned int nRandomPos2) const EXCLUSIVE_LOCKS_REQUIRED(cs);
 
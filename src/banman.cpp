@@ -12,12 +12,35 @@
 #include <util/time.h>
 #include <util/translation.h>
 
+#include <algorithm>
+#include <functional>
+#include <vector>
+
+/**
+ * Bans sorted by subnet together with the CIDR prefix lengths that occur among them. An
+ * address is checked by masking it to each of those lengths and looking the resulting
+ * subnet up, so the cost depends on the number of distinct prefix lengths instead of on
+ * the number of bans.
+ */
+struct BanMan::BanSnapshot {
+    std::vector<std::pair<CSubNet, int64_t>> entries;
+    std::vector<int> prefix_lengths;
+
+    bool IsBanned(const CSubNet& sub_net, int64_t current_time) const
+    {
+        const auto it = std::lower_bound(entries.begin(), entries.end(), sub_net,
+                                         [](const auto& entry, const CSubNet& s) { return entry.first < s; });
+        return it != entries.end() && it->first == sub_net && current_time < it->second;
+    }
+};
 
 BanMan::BanMan(fs::path ban_file, CClientUIInterface* client_interface, int64_t default_ban_time)
     : m_client_interface(client_interface), m_ban_db(std::move(ban_file)), m_default_ban_time(default_ban_time)
 {
     if (m_client_interface) m_client_interface->InitMessage(_("Loading banlist...").translated);
 
+    std::atomic_store(&m_snapshot, std::make_shared<const BanSnapshot>());
+
     int64_t n_start = GetTimeMillis();
     if (m_ban_db.Read(m_banned)) {
         SweepBanned(); // sweep out unused entries
@@ -29,6 +52,7 @@ BanMan::BanMan(fs::path ban_file, CClientUIInterface* client_interface, int64_t
         m_banned = {};
         m_is_dirty = true;
     }
+    WITH_LOCK(m_cs_banned, UpdateSnapshot());
 
     DumpBanlist();
 }
@@ -67,6 +91,7 @@ void BanMan::ClearBanned()
         LOCK(m_cs_banned);
         m_banned.clear();
         m_is_dirty = true;
+        UpdateSnapshot();
     }
     DumpBanlist(); //store banlist to disk
     if (m_client_interface) m_client_interface->BannedListChanged();
@@ -90,13 +115,21 @@ bool BanMan::IsDiscouraged(const CNetAddr& net_addr)
 
 bool BanMan::IsBanned(const CNetAddr& net_addr)
 {
+    if (!net_addr.IsValid()) return false;
+
     auto current_time = GetTime();
-    LOCK(m_cs_banned);
-    for (const auto& it : m_banned) {
-        CSubNet sub_net = it.first;
-        CBanEntry ban_entry = it.second;
+    const auto snapshot = std::atomic_load(&m_snapshot);
+    if (snapshot->entries.empty()) return false;
 
-        if (current_time < ban_entry.nBanUntil && sub_net.Match(net_addr)) {
+    if (!net_addr.IsIPv4() && !net_addr.IsIPv6()) {
+        // Tor, I2P and CJDNS bans only ever cover a single address
+        const CSubNet sub_net(net_addr);
+        return sub_net.IsValid() && snapshot->IsBanned(sub_net, current_time);
+    }
+    for (const int prefix_length : snapshot->prefix_lengths) {
+        // lengths that don't fit the address family (e.g. /64 for IPv4) yield an invalid subnet
+        const CSubNet sub_net(net_addr, prefix_length);
+        if (sub_net.IsValid() && snapshot->IsBanned(sub_net, current_time)) {
             return true;
         }
     }
@@ -146,6 +179,7 @@ void BanMan::Ban(const CSubNet& sub_net, int64_t ban_time_offset, bool since_uni
         if (m_banned[sub_net].nBanUntil < ban_entry.nBanUntil) {
             m_banned[sub_net] = ban_entry;
             m_is_dirty = true;
+            UpdateSnapshot();
         } else
             return;
     }
@@ -167,6 +201,7 @@ bool BanMan::Unban(const CSubNet& sub_net)
         LOCK(m_cs_banned);
         if (m_banned.erase(sub_net) == 0) return false;
         m_is_dirty = true;
+        UpdateSnapshot();
     }
     if (m_client_interface) m_client_interface->BannedListChanged();
     DumpBanlist(); //store banlist to disk immediately
@@ -199,6 +234,7 @@ void BanMan::SweepBanned()
             } else
                 ++it;
         }
+        if (notify_ui) UpdateSnapshot();
     }
     // update UI
     if (notify_ui && m_client_interface) {
@@ -206,6 +242,25 @@ void BanMan::SweepBanned()
     }
 }
 
+void BanMan::UpdateSnapshot()
+{
+    AssertLockHeld(m_cs_banned);
+    auto snapshot = std::make_shared<BanSnapshot>();
+    snapshot->entries.reserve(m_banned.size());
+    for (const auto& [sub_net, ban_entry] : m_banned) {
+        if (!sub_net.IsValid()) continue;
+        // m_banned is ordered by subnet already, so entries stay sorted
+        snapshot->entries.emplace_back(sub_net, ban_entry.nBanUntil);
+        const int prefix_length = sub_net.GetPrefixLength();
+        if (prefix_length >= 0) snapshot->prefix_lengths.push_back(prefix_length);
+    }
+    // try the most specific lengths first, single-address bans being the usual case
+    std::sort(snapshot->prefix_lengths.begin(), snapshot->prefix_lengths.end(), std::greater<int>());
+    snapshot->prefix_lengths.erase(std::unique(snapshot->prefix_lengths.begin(), snapshot->prefix_lengths.end()),
+                                   snapshot->prefix_lengths.end());
+    std::atomic_store(&m_snapshot, std::shared_ptr<const BanSnapshot>{std::move(snapshot)});
+}
+
 bool BanMan::BannedSetIsDirty()
 {
     LOCK(m_cs_banned);
@@ -86,10 +86,18 @@ private:
     void SetBannedSetDirty(bool dirty = true);
     //!clean unused entries (if bantime has expired)
     void SweepBanned();
+    //!publish a new read-only copy of m_banned for lookups by address
+    void UpdateSnapshot() EXCLUSIVE_LOCKS_REQUIRED(m_cs_banned);
+
+    struct BanSnapshot;
 
     RecursiveMutex m_cs_banned;
     banmap_t m_banned GUARDED_BY(m_cs_banned);
     bool m_is_dirty GUARDED_BY(m_cs_banned){false};
+    //! Copy of m_banned that IsBanned(CNetAddr) reads without taking m_cs_banned, which
+    //! keeps the accept loop off the lock while RPC or the scheduler update the banlist.
+    //! Replaced on every change and only accessed with std::atomic_load/std::atomic_store.
+    std::shared_ptr<const BanSnapshot> m_snapshot;
     CClientUIInterface* m_client_interface = nullptr;
     CBanDB m_ban_db;
     const int64_t m_default_ban_time;
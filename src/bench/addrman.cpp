@@ -91,6 +91,35 @@ static void AddrManSelect(benchmark::Bench& bench)
     });
 }
 
+static void AddrManSelectFromAlmostEmpty(benchmark::Bench& bench)
+{
+    CreateAddresses();
+
+    CAddrMan addrman;
+
+    // One address in the new table and one in the tried table leave both tables almost
+    // empty, the worst case for finding an occupied position by probing.
+    addrman.Add(g_addresses[0][0], g_sources[0]);
+    addrman.Add(g_addresses[0][1], g_sources[0]);
+    addrman.Good(g_addresses[0][1]);
+
+    bench.run([&] {
+        (void)addrman.Select();
+    });
+}
+
+static void AddrManSelectNewOnly(benchmark::Bench& bench)
+{
+    CAddrMan addrman;
+
+    FillAddrMan(addrman);
+
+    bench.run([&] {
+        const auto& address = addrman.Select(/* newOnly */ true);
+        assert(address.GetPort() > 0);
+    });
+}
+
 static void AddrManGetAddr(benchmark::Bench& bench)
 {
     CAddrMan addrman;
@@ -136,5 +165,7 @@ static void AddrManGood(benchmark::Bench& bench)
 
 BENCHMARK(AddrManAdd);
 BENCHMARK(AddrManSelect);
+BENCHMARK(AddrManSelectFromAlmostEmpty);
+BENCHMARK(AddrManSelectNewOnly);
 BENCHMARK(AddrManGetAddr);
 BENCHMARK(AddrManGood);
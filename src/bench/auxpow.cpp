@@ -0,0 +1,141 @@
+// Copyright (c) 2024 The Maximus developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <auxpow.h>
+#include <bench/bench.h>
+#include <chainparams.h>
+#include <crypto/common.h>
+#include <hash.h>
+#include <primitives/block.h>
+#include <primitives/transaction.h>
+#include <random.h>
+#include <script/script.h>
+#include <streams.h>
+#include <test/util/setup_common.h>
+#include <version.h>
+
+#include <algorithm>
+#include <vector>
+
+static constexpr size_t HEADERS_BATCH = 2000;
+// Depth of the coinbase in the parent block, i.e. a parent block with a few thousand transactions
+static constexpr unsigned AUXPOW_PARENT_BRANCH = 12;
+
+static std::vector<CBlockHeader> BuildHeaders(size_t count)
+{
+    FastRandomContext rng(true);
+    std::vector<CBlockHeader> headers(count);
+    for (auto& header : headers) {
+        header.nVersion = 0x20000000;
+        header.hashPrevBlock = rng.rand256();
+        header.hashMerkleRoot = rng.rand256();
+        header.nTime = rng.rand32();
+        header.nBits = 0x1e0ffff0;
+        header.nNonce = rng.rand32();
+    }
+    return headers;
+}
+
+/* Proof-of-work hashes of a headers message, one header at a time */
+static void POW_HeadersSingle(benchmark::Bench& bench)
+{
+    const auto headers = BuildHeaders(HEADERS_BATCH);
+    bench.batch(HEADERS_BATCH).unit("header").minEpochIterations(5).run([&] {
+        for (const auto& header : headers) {
+            ankerl::nanobench::doNotOptimizeAway(header.GetPoWHash());
+        }
+    });
+}
+
+/* The same headers through the multi-lane X11 engine */
+static void POW_HeadersBatch(benchmark::Bench& bench)
+{
+    const auto headers = BuildHeaders(HEADERS_BATCH);
+    bench.batch(HEADERS_BATCH).unit("header").minEpochIterations(5).run([&] {
+        const auto hashes = CPureBlockHeader::GetPoWHashes(headers);
+        assert(hashes.size() == HEADERS_BATCH);
+    });
+}
+
+static uint256 MerkleBranchRoot(uint256 hash, const std::vector<uint256>& branch, int index)
+{
+    for (const auto& sibling : branch) {
+        hash = (index & 1) ? Hash(sibling, hash) : Hash(hash, sibling);
+        index >>= 1;
+    }
+    return hash;
+}
+
+/**
+ * Builds a valid auxpow for block with a chain merkle branch of the given height, the same way
+ * a merge-mining pool does: the chain merkle root goes into the parent coinbase behind the
+ * merged mining header, and the coinbase sits AUXPOW_PARENT_BRANCH levels deep in the parent.
+ */
+static CAuxPow BuildAuxPow(const CBlockHeader& block, unsigned chainBranchHeight)
+{
+    FastRandomContext rng(true);
+    const auto& params = Params().GetConsensus();
+    const uint32_t nonce = 7;
+
+    std::vector<uint256> chainBranch(chainBranchHeight);
+    for (auto& h : chainBranch) h = rng.rand256();
+    const int chainIndex = CAuxPow::getExpectedIndex(nonce, params.nAuxpowChainId, chainBranchHeight);
+    const uint256 chainRoot = MerkleBranchRoot(block.GetPoWHash(), chainBranch, chainIndex);
+
+    std::vector<unsigned char> data(pchMergedMiningHeader, pchMergedMiningHeader + sizeof(pchMergedMiningHeader));
+    data.insert(data.end(), chainRoot.begin(), chainRoot.end());
+    std::reverse(data.end() - 32, data.end());
+    data.resize(data.size() + 8);
+    WriteLE32(data.data() + data.size() - 8, 1u << chainBranchHeight);
+    WriteLE32(data.data() + data.size() - 4, nonce);
+
+    CMutableTransaction coinbase;
+    coinbase.vin.resize(1);
+    coinbase.vin[0].prevout.SetNull();
+    coinbase.vin[0].scriptSig = CScript() << 2809 << 2013 << OP_2 << data;
+    const CTransactionRef coinbaseRef = MakeTransactionRef(std::move(coinbase));
+
+    std::vector<uint256> parentBranch(AUXPOW_PARENT_BRANCH);
+    for (auto& h : parentBranch) h = rng.rand256();
+    CPureBlockHeader parent;
+    parent.SetBaseVersion(1, params.nAuxpowChainId + 1);
+    parent.hashPrevBlock = rng.rand256();
+    parent.hashMerkleRoot = MerkleBranchRoot(coinbaseRef->GetHash(), parentBranch, 0);
+    parent.nTime = block.nTime;
+    parent.nBits = block.nBits;
+
+    // The members are private, so go through the wire format like a received block does
+    CDataStream ss(SER_NETWORK, PROTOCOL_VERSION);
+    ss << coinbaseRef << parentBranch << int{0} << chainBranch << chainIndex << parent;
+    CAuxPow auxpow;
+    ss >> auxpow;
+    assert(auxpow.check(block.GetPoWHash(), params.nAuxpowChainId, params));
+    return auxpow;
+}
+
+/* Merkle branch verification of an auxpow header (CAuxPow::check) plus the parent's X11 hash,
+   which is what CheckProofOfWork adds for a merge-mined header */
+static void AUXPOW_Check(benchmark::Bench& bench, unsigned chainBranchHeight)
+{
+    const auto testing_setup = MakeNoLogFileContext<const BasicTestingSetup>();
+    const auto& params = Params().GetConsensus();
+    const CBlockHeader block = BuildHeaders(1).front();
+    const uint256 powHash = block.GetPoWHash();
+    const CAuxPow auxpow = BuildAuxPow(block, chainBranchHeight);
+
+    bench.minEpochIterations(1000).run([&] {
+        assert(auxpow.check(powHash, params.nAuxpowChainId, params));
+        ankerl::nanobench::doNotOptimizeAway(auxpow.getParentBlockPoWHash());
+    });
+}
+
+static void AUXPOW_Check_ChainBranch0(benchmark::Bench& bench) { AUXPOW_Check(bench, 0); }
+static void AUXPOW_Check_ChainBranch8(benchmark::Bench& bench) { AUXPOW_Check(bench, 8); }
+static void AUXPOW_Check_ChainBranch30(benchmark::Bench& bench) { AUXPOW_Check(bench, 30); }
+
+BENCHMARK(POW_HeadersSingle);
+BENCHMARK(POW_HeadersBatch);
+BENCHMARK(AUXPOW_Check_ChainBranch0);
+BENCHMARK(AUXPOW_Check_ChainBranch8);
+BENCHMARK(AUXPOW_Check_ChainBranch30);
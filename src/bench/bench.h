@@ -45,6 +45,14 @@ struct Args {
     std::string output_json;
 };
 
+/**
+ * Replay the blocks stored in a file in the blk?????.dat format (e.g. written by
+ * contrib/linearize) on a fresh chain in a temporary datadir, headers first, and print
+ * the time spent in the phases of block validation. The file has to start right after
+ * the genesis block of the chain. Returns false if a block can't be read or connected.
+ */
+bool ReplayBlocks(const std::string& path, const std::string& chain);
+
 class BenchRunner
 {
     typedef std::map<std::string, BenchFunction> BenchmarkMap;
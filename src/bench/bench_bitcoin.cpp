@@ -4,7 +4,11 @@
 
 #include <bench/bench.h>
 
+#include <chainparamsbase.h>
+#include <crypto/aes.h>
+#include <crypto/chacha20.h>
 #include <crypto/sha256.h>
+#include <crypto/x11.h>
 #include <stacktraces.h>
 #include <util/strencodings.h>
 #include <util/system.h>
@@ -22,6 +26,8 @@ static void SetupBenchArgs(ArgsManager& argsman)
     argsman.AddArg("-asymptote=n1,n2,n3,...", strprintf("Test asymptotic growth of the runtime of an algorithm, if supported by the benchmark"), ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
     argsman.AddArg("-output_csv=<output.csv>", "Generate CSV file with the most important benchmark results.", ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
     argsman.AddArg("-output_json=<output.json>", "Generate JSON file with all benchmark results.", ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
+    argsman.AddArg("-replay=<blocks.dat>", "Instead of running benchmarks, replay the blocks stored in this file (in the blk?????.dat format, starting after genesis) and print per-phase validation timings", ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
+    argsman.AddArg("-replaychain=<chain>", strprintf("Chain the replayed blocks belong to (default: %s)", CBaseChainParams::MAIN), ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
 }
 
 // parses a comma separated list like "10,20,30,50"
@@ -42,6 +48,9 @@ int main(int argc, char** argv)
     ArgsManager argsman;
     SetupBenchArgs(argsman);
     SHA256AutoDetect();
+    X11AutoDetect();
+    ChaCha20AutoDetect();
+    AES256AutoDetect();
     std::string error;
     if (!argsman.ParseParameters(argc, argv, error)) {
         tfm::format(std::cerr, "Error parsing command line arguments: %s\n", error);
@@ -53,6 +62,11 @@ int main(int argc, char** argv)
         return EXIT_SUCCESS;
     }
 
+    if (argsman.IsArgSet("-replay")) {
+        const bool ok = benchmark::ReplayBlocks(argsman.GetArg("-replay", ""), argsman.GetArg("-replaychain", CBaseChainParams::MAIN));
+        return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+
     benchmark::Args args;
     args.regex_filter = argsman.GetArg("-filter", DEFAULT_BENCH_FILTER);
     args.is_list_only = argsman.GetBoolArg("-list", false);
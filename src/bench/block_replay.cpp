@@ -0,0 +1,148 @@
+// Copyright (c) 2024 The Maximus developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <bench/bench.h>
+#include <chainparams.h>
+#include <fs.h>
+#include <primitives/block.h>
+#include <protocol.h>
+#include <streams.h>
+#include <test/util/setup_common.h>
+#include <tinyformat.h>
+#include <validation.h>
+#include <validationinterface.h>
+#include <version.h>
+
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <vector>
+
+/** Number of headers handed to ProcessNewBlockHeaders at once, like a HEADERS message */
+static constexpr size_t REPLAY_HEADERS_BATCH = 2000;
+
+using ReplayClock = std::chrono::steady_clock;
+
+static int64_t MicrosSince(ReplayClock::time_point start)
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>(ReplayClock::now() - start).count();
+}
+
+/** Read all blocks of a file in the blk?????.dat format: message start, size, block */
+static bool ReadBlockFile(const fs::path& path, std::vector<std::shared_ptr<const CBlock>>& blocks)
+{
+    CAutoFile file(fsbridge::fopen(path, "rb"), SER_DISK, CLIENT_VERSION);
+    if (file.IsNull()) {
+        tfm::format(std::cerr, "Error: cannot open %s\n", path.string());
+        return false;
+    }
+    const auto& message_start = Params().MessageStart();
+    while (true) {
+        CMessageHeader::MessageStartChars blk_start;
+        unsigned int blk_size;
+        try {
+            file >> blk_start >> blk_size;
+        } catch (const std::ios_base::failure&) {
+            break; // end of file
+        }
+        if (memcmp(blk_start, message_start, CMessageHeader::MESSAGE_START_SIZE)) {
+            static const CMessageHeader::MessageStartChars zero{};
+            if (!memcmp(blk_start, zero, CMessageHeader::MESSAGE_START_SIZE)) {
+                break; // preallocated but unused space at the end of a block file
+            }
+            tfm::format(std::cerr, "Error: block %u: message start mismatch\n", blocks.size());
+            return false;
+        }
+        auto block = std::make_shared<CBlock>();
+        try {
+            file >> *block;
+        } catch (const std::exception& e) {
+            tfm::format(std::cerr, "Error: block %u: %s\n", blocks.size(), e.what());
+            return false;
+        }
+        if (block->GetHash() != Params().GetConsensus().hashGenesisBlock) {
+            blocks.emplace_back(std::move(block));
+        }
+    }
+    return true;
+}
+
+static void PrintPhase(const std::string& name, int64_t micros, int64_t blocks, int64_t total)
+{
+    tfm::format(std::cout, "%-36s %12.2f %10.3f %6.1f%%\n", name, micros * 0.001, blocks ? micros * 0.001 / blocks : 0.0,
+                total ? 100.0 * micros / total : 0.0);
+}
+
+bool benchmark::ReplayBlocks(const std::string& path, const std::string& chain)
+{
+    const auto testing_setup = MakeNoLogFileContext<const TestingSetup>(chain);
+    ChainstateManager& chainman = *testing_setup->m_node.chainman;
+    const CChainParams& chainparams = Params();
+
+    std::vector<std::shared_ptr<const CBlock>> blocks;
+    if (!ReadBlockFile(fs::path(path), blocks)) {
+        return false;
+    }
+    tfm::format(std::cout, "Replaying %u blocks from %s on %s\n", blocks.size(), path, chain);
+
+    // Headers first, the way they arrive during IBD
+    const auto headers_start = ReplayClock::now();
+    int64_t headers_pow{0};
+    for (size_t i = 0; i < blocks.size(); i += REPLAY_HEADERS_BATCH) {
+        std::vector<CBlockHeader> headers;
+        for (size_t j = i; j < std::min(blocks.size(), i + REPLAY_HEADERS_BATCH); j++) {
+            headers.emplace_back(blocks[j]->GetBlockHeader());
+        }
+        const auto pow_start = ReplayClock::now();
+        std::vector<uint256> pow_hashes;
+        if (!CheckHeadersProofOfWork(headers, pow_hashes, chainparams.GetConsensus())) {
+            tfm::format(std::cerr, "Error: headers %u-%u: proof of work failed\n", i, i + headers.size() - 1);
+            return false;
+        }
+        headers_pow += MicrosSince(pow_start);
+        BlockValidationState state;
+        if (!chainman.ProcessNewBlockHeaders(headers, state, chainparams, nullptr, &pow_hashes)) {
+            tfm::format(std::cerr, "Error: headers %u-%u: %s\n", i, i + headers.size() - 1, state.ToString());
+            return false;
+        }
+    }
+    const int64_t headers_total = MicrosSince(headers_start);
+
+    const BlockValidationTimings before = GetBlockValidationTimings();
+    const auto blocks_start = ReplayClock::now();
+    for (const auto& block : blocks) {
+        if (!chainman.ProcessNewBlock(chainparams, block, /* fForceProcessing */ true, /* fNewBlock */ nullptr)) {
+            tfm::format(std::cerr, "Error: block %s was not accepted\n", block->GetHash().ToString());
+            return false;
+        }
+    }
+    SyncWithValidationInterfaceQueue();
+    const int64_t blocks_total = MicrosSince(blocks_start);
+    const BlockValidationTimings after = GetBlockValidationTimings();
+
+    const int tip_height = WITH_LOCK(cs_main, return chainman.ActiveChain().Height());
+    if (tip_height != int(blocks.size())) {
+        tfm::format(std::cerr, "Error: chain stopped at height %d of %u\n", tip_height, blocks.size());
+        return false;
+    }
+
+    const int64_t n = after.blocks - before.blocks;
+    tfm::format(std::cout, "%-36s %12s %10s %7s\n", "phase", "total ms", "ms/block", "share");
+    PrintPhase("headers (total)", headers_total, n, headers_total + blocks_total);
+    PrintPhase("  proof of work", headers_pow, n, headers_total + blocks_total);
+    PrintPhase("blocks (total)", blocks_total, n, headers_total + blocks_total);
+    PrintPhase("  proof of work", after.pow - before.pow, n, blocks_total);
+    PrintPhase("  CheckBlock", after.check_block - before.check_block, n, blocks_total);
+    PrintPhase("  ConnectTip", after.total - before.total, n, blocks_total);
+    PrintPhase("    coins prefetch", after.prefetch - before.prefetch, n, blocks_total);
+    PrintPhase("    input fetch", after.connect_inputs - before.connect_inputs, n, blocks_total);
+    PrintPhase("    script checks", after.script_checks - before.script_checks, n, blocks_total);
+    PrintPhase("    special tx processing", after.special_txes - before.special_txes, n, blocks_total);
+    PrintPhase("    maximus specific checks", after.maximus_specific - before.maximus_specific, n, blocks_total);
+    PrintPhase("    coins view flush", after.coins_flush - before.coins_flush, n, blocks_total);
+    PrintPhase("    evo db writes", after.evo_commit - before.evo_commit, n, blocks_total);
+    PrintPhase("    chainstate flush", after.chainstate_flush - before.chainstate_flush, n, blocks_total);
+    return true;
+}
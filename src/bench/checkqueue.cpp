@@ -71,4 +71,58 @@ static void CCheckQueueSpeedPrevectorJob(benchmark::Bench& bench)
     queue.StopWorkerThreads();
     ECC_Stop();
 }
+
+// A block of small transactions added one at a time, the way ConnectBlock does. Every
+// expensive_every-th transaction is a large CoinJoin-like one whose inputs cost ten times as
+// much, which leaves the workers with uneven amounts of work.
+static void CCheckQueueBlock(benchmark::Bench& bench, int threads, size_t expensive_every)
+{
+    static constexpr size_t BLOCK_TXS{2000};
+    static constexpr size_t CHECK_ROUNDS{200};
+
+    struct SpinJob {
+        size_t rounds{0};
+        SpinJob() = default;
+        explicit SpinJob(size_t rounds_in) : rounds(rounds_in) {}
+        bool operator()()
+        {
+            uint64_t x{rounds};
+            for (size_t i = 0; i < rounds; ++i) {
+                x = x * 6364136223846793005ULL + 1442695040888963407ULL;
+            }
+            ankerl::nanobench::doNotOptimizeAway(x);
+            return true;
+        }
+        void swap(SpinJob& x) noexcept { std::swap(rounds, x.rounds); }
+    };
+    CCheckQueue<SpinJob> queue{QUEUE_BATCH_SIZE};
+    queue.StartWorkerThreads(threads - 1);
+
+    std::vector<std::vector<SpinJob>> txs(BLOCK_TXS);
+    size_t checks{0};
+    for (size_t i = 0; i < txs.size(); ++i) {
+        const bool expensive = expensive_every && i % expensive_every == 0;
+        txs[i].assign(expensive ? 50 : 2, SpinJob{expensive ? 10 * CHECK_ROUNDS : CHECK_ROUNDS});
+        checks += txs[i].size();
+    }
+
+    bench.minEpochIterations(10).batch(checks).unit("check").run([&] {
+        CCheckQueueControl<SpinJob> control(&queue);
+        for (auto tx : txs) {
+            control.Add(tx);
+        }
+        control.Wait();
+    });
+    queue.StopWorkerThreads();
+}
+
+static void CCheckQueueCheapChecks16Threads(benchmark::Bench& bench) { CCheckQueueBlock(bench, 16, 0); }
+static void CCheckQueueCheapChecks32Threads(benchmark::Bench& bench) { CCheckQueueBlock(bench, 32, 0); }
+static void CCheckQueueUnevenChecks16Threads(benchmark::Bench& bench) { CCheckQueueBlock(bench, 16, 100); }
+static void CCheckQueueUnevenChecks32Threads(benchmark::Bench& bench) { CCheckQueueBlock(bench, 32, 100); }
+
 BENCHMARK(CCheckQueueSpeedPrevectorJob);
+BENCHMARK(CCheckQueueCheapChecks16Threads);
+BENCHMARK(CCheckQueueCheapChecks32Threads);
+BENCHMARK(CCheckQueueUnevenChecks16Threads);
+BENCHMARK(CCheckQueueUnevenChecks32Threads);
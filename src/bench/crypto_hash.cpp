@@ -12,6 +12,18 @@
 #include <crypto/sha3.h>
 #include <crypto/sha512.h>
 #include <crypto/siphash.h>
+#include <crypto/sph_blake.h>
+#include <crypto/sph_bmw.h>
+#include <crypto/sph_cubehash.h>
+#include <crypto/sph_echo.h>
+#include <crypto/sph_groestl.h>
+#include <crypto/sph_jh.h>
+#include <crypto/sph_keccak.h>
+#include <crypto/sph_luffa.h>
+#include <crypto/sph_shavite.h>
+#include <crypto/sph_simd.h>
+#include <crypto/sph_skein.h>
+#include <crypto/x11.h>
 #include <hash.h>
 #include <random.h>
 #include <uint256.h>
@@ -160,6 +172,43 @@ static void HASH_X11_0080b_single(benchmark::Bench& bench)
     });
 }
 
+static void HASH_X11_0080b_batch2000(benchmark::Bench& bench)
+{
+    std::vector<uint8_t> in(80 * 2000, 0);
+    std::vector<uint8_t> out(32 * 2000);
+    bench.batch(2000).unit("header").minEpochIterations(5).run([&] {
+        X11Hash80(out.data(), in.data(), 2000);
+    });
+}
+
+/* Hash through a single X11 stage. Blake sees the 80-byte header, every later stage the 64-byte
+   output of the previous one */
+
+#define BENCH_X11_STAGE(algo, bytes) \
+    static void HASH_X11_stage_##algo##_##bytes##b(benchmark::Bench& bench) \
+    { \
+        sph_##algo##512_context ctx; \
+        std::vector<uint8_t> in(bytes, 0); \
+        uint512 hash; \
+        bench.minEpochIterations(10000).run([&] { \
+            sph_##algo##512_init(&ctx); \
+            sph_##algo##512(&ctx, in.data(), in.size()); \
+            sph_##algo##512_close(&ctx, hash.begin()); \
+        }); \
+    }
+
+BENCH_X11_STAGE(blake, 80)
+BENCH_X11_STAGE(bmw, 64)
+BENCH_X11_STAGE(groestl, 64)
+BENCH_X11_STAGE(skein, 64)
+BENCH_X11_STAGE(jh, 64)
+BENCH_X11_STAGE(keccak, 64)
+BENCH_X11_STAGE(luffa, 64)
+BENCH_X11_STAGE(cubehash, 64)
+BENCH_X11_STAGE(shavite, 64)
+BENCH_X11_STAGE(simd, 64)
+BENCH_X11_STAGE(echo, 64)
+
 static void HASH_X11_0128b_single(benchmark::Bench& bench)
 {
     uint256 hash;
@@ -227,6 +276,16 @@ static void HASH_SHA256D64_1024(benchmark::Bench& bench)
     });
 }
 
+/* Hash 1024 blobs 64 bytes each via SHA256 */
+
+static void HASH_SHA256S64_1024(benchmark::Bench& bench)
+{
+    std::vector<uint8_t> in(64 * 1024, 0);
+    bench.minEpochIterations(1000).run([&] {
+        SHA256S64(in.data(), in.data(), 1024);
+    });
+}
+
 /* FastRandom for uint32_t and bool */
 
 static void FastRandom_32bit(benchmark::Bench& bench)
@@ -309,15 +368,28 @@ BENCHMARK(HASH_DSHA256_1024b_single);
 BENCHMARK(HASH_DSHA256_2048b_single);
 BENCHMARK(HASH_X11_0032b_single);
 BENCHMARK(HASH_X11_0080b_single);
+BENCHMARK(HASH_X11_0080b_batch2000);
 BENCHMARK(HASH_X11_0128b_single);
 BENCHMARK(HASH_X11_0512b_single);
 BENCHMARK(HASH_X11_1024b_single);
 BENCHMARK(HASH_X11_2048b_single);
+BENCHMARK(HASH_X11_stage_blake_80b);
+BENCHMARK(HASH_X11_stage_bmw_64b);
+BENCHMARK(HASH_X11_stage_groestl_64b);
+BENCHMARK(HASH_X11_stage_skein_64b);
+BENCHMARK(HASH_X11_stage_jh_64b);
+BENCHMARK(HASH_X11_stage_keccak_64b);
+BENCHMARK(HASH_X11_stage_luffa_64b);
+BENCHMARK(HASH_X11_stage_cubehash_64b);
+BENCHMARK(HASH_X11_stage_shavite_64b);
+BENCHMARK(HASH_X11_stage_simd_64b);
+BENCHMARK(HASH_X11_stage_echo_64b);
 
 BENCHMARK(HASH_SHA256_32b);
 BENCHMARK(HASH_SipHash_32b);
 
 BENCHMARK(HASH_SHA256D64_1024);
+BENCHMARK(HASH_SHA256S64_1024);
 
 BENCHMARK(FastRandom_32bit);
 BENCHMARK(FastRandom_1bit);
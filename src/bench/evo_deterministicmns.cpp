@@ -0,0 +1,308 @@
+// Copyright (c) 2024 The Maximus developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <bench/bench.h>
+#include <bls/bls.h>
+#include <chain.h>
+#include <crypto/common.h>
+#include <evo/deterministicmns.h>
+#include <evo/dmnstate.h>
+#include <evo/simplifiedmns.h>
+#include <netaddress.h>
+#include <script/standard.h>
+#include <test/util/setup_common.h>
+#include <tinyformat.h>
+
+#include <deque>
+#include <unordered_set>
+#include <vector>
+
+// Height of the synthetic tip, every masternode was registered and confirmed before it
+static constexpr int MNLIST_TIP_HEIGHT = 2000;
+// Number of consecutive lists kept around, like the manager's mnListsCache after a few blocks
+static constexpr int MNLIST_CACHED_LISTS = 16;
+// A few ProUpServ/ProUpReg updates per block on top of the payee bookkeeping
+static constexpr size_t MNLIST_UPDATES_PER_BLOCK = 4;
+
+static uint256 MakeHash(uint64_t n, uint64_t salt)
+{
+    uint256 hash;
+    WriteLE64(hash.begin(), n + 1);
+    WriteLE64(hash.begin() + 24, (n + 1) * 0x9E3779B97F4A7C15ull ^ salt);
+    return hash;
+}
+
+static CDeterministicMNList BuildMNList(size_t count)
+{
+    CDeterministicMNList mnList(MakeHash(MNLIST_TIP_HEIGHT, 0), MNLIST_TIP_HEIGHT, 0);
+    for (size_t i = 0; i < count; i++) {
+        auto dmn = std::make_shared<CDeterministicMN>(i);
+        dmn->proTxHash = MakeHash(i, 1);
+        dmn->collateralOutpoint = COutPoint(MakeHash(i, 2), 0);
+
+        auto state = std::make_shared<CDeterministicMNState>();
+        state->nRegisteredHeight = 1;
+        state->nLastPaidHeight = int(i % MNLIST_TIP_HEIGHT);
+        state->UpdateConfirmedHash(dmn->proTxHash, MakeHash(i, 3));
+        state->keyIDOwner = CKeyID(uint160(Span{MakeHash(i, 4).begin(), 20}));
+        state->keyIDVoting = state->keyIDOwner;
+        CBLSSecretKey sk;
+        sk.MakeNewKey();
+        state->pubKeyOperator.Set(sk.GetPublicKey(), bls::bls_legacy_scheme.load());
+        in_addr ip;
+        ip.s_addr = htonl(0x0A000000 | uint32_t(i));
+        state->addr = CService(CNetAddr(ip), 9999);
+        state->scriptPayout = GetScriptForDestination(PKHash(state->keyIDOwner));
+        dmn->pdmnState = state;
+
+        mnList.AddMN(dmn);
+    }
+    return mnList;
+}
+
+// A chain of bare block indexes up to the tip, enough for the deployment checks in GetMNPayee
+class BenchChain
+{
+private:
+    std::vector<uint256> hashes;
+    std::vector<CBlockIndex> blocks;
+
+public:
+    explicit BenchChain(int height) :
+        hashes(height + MNLIST_CACHED_LISTS + 1),
+        blocks(height + MNLIST_CACHED_LISTS + 1)
+    {
+        for (size_t i = 0; i < blocks.size(); i++) {
+            hashes[i] = MakeHash(i, 0);
+            blocks[i].phashBlock = &hashes[i];
+            blocks[i].nHeight = int(i);
+            blocks[i].pprev = i > 0 ? &blocks[i - 1] : nullptr;
+            blocks[i].BuildSkip();
+        }
+    }
+
+    const CBlockIndex* operator[](int height) const { return &blocks[height]; }
+};
+
+// What CDeterministicMNManager::ProcessBlock does to the list for a block without special
+// transactions: pay the next payee and apply a handful of state updates
+static CDeterministicMNList NextList(const CDeterministicMNList& prevList, const BenchChain& chain)
+{
+    const int nHeight = prevList.GetHeight() + 1;
+    CDeterministicMNList newList = prevList;
+    newList.SetBlockHash(chain[nHeight]->GetBlockHash());
+    newList.SetHeight(nHeight);
+
+    const auto payee = prevList.GetMNPayee(chain[nHeight - 1]);
+    auto payeeState = std::make_shared<CDeterministicMNState>(*payee->pdmnState);
+    payeeState->nLastPaidHeight = nHeight;
+    newList.UpdateMN(payee->proTxHash, payeeState);
+
+    for (size_t i = 0; i < MNLIST_UPDATES_PER_BLOCK; i++) {
+        const auto dmn = prevList.GetMNByInternalId((uint64_t(nHeight) * 7919 + i * 104729) % prevList.GetAllMNsCount());
+        auto state = std::make_shared<CDeterministicMNState>(*dmn->pdmnState);
+        state->scriptOperatorPayout = GetScriptForDestination(PKHash(CKeyID(uint160(Span{MakeHash(nHeight, i).begin(), 20}))));
+        newList.UpdateMN(dmn->proTxHash, state);
+    }
+    return newList;
+}
+
+static void MNList_GetMNPayee(benchmark::Bench& bench, size_t count)
+{
+    const auto testing_setup = MakeNoLogFileContext<const BasicTestingSetup>();
+    const auto mnList = BuildMNList(count);
+    const BenchChain chain(MNLIST_TIP_HEIGHT);
+
+    bench.run([&] {
+        assert(mnList.GetMNPayee(chain[MNLIST_TIP_HEIGHT]) != nullptr);
+    });
+}
+
+static void MNList_CalculateQuorum(benchmark::Bench& bench, size_t count)
+{
+    const auto testing_setup = MakeNoLogFileContext<const BasicTestingSetup>();
+    const auto mnList = BuildMNList(count);
+    uint64_t n{0};
+
+    bench.run([&] {
+        const auto members = mnList.CalculateQuorum(400, MakeHash(n++, 5));
+        assert(members.size() == std::min<size_t>(400, count));
+    });
+}
+
+static void MNList_BuildDiff(benchmark::Bench& bench, size_t count)
+{
+    const auto testing_setup = MakeNoLogFileContext<const BasicTestingSetup>();
+    const auto mnList = BuildMNList(count);
+    const BenchChain chain(MNLIST_TIP_HEIGHT);
+    const auto nextList = NextList(mnList, chain);
+
+    bench.run([&] {
+        const auto diff = mnList.BuildDiff(nextList);
+        assert(!diff.updatedMNs.empty() && diff.updatedMNs.size() <= MNLIST_UPDATES_PER_BLOCK + 1);
+    });
+}
+
+static void MNList_ApplyDiff(benchmark::Bench& bench, size_t count)
+{
+    const auto testing_setup = MakeNoLogFileContext<const BasicTestingSetup>();
+    const auto mnList = BuildMNList(count);
+    const BenchChain chain(MNLIST_TIP_HEIGHT);
+    const auto diff = mnList.BuildDiff(NextList(mnList, chain));
+
+    bench.run([&] {
+        const auto nextList = mnList.ApplyDiff(chain[MNLIST_TIP_HEIGHT + 1], diff);
+        assert(nextList.GetHeight() == MNLIST_TIP_HEIGHT + 1);
+    });
+}
+
+// Full SML construction and hashing, i.e. the uncached path of CalcCbTxMerkleRootMNList
+static void MNList_SMLMerkleRoot(benchmark::Bench& bench, size_t count)
+{
+    const auto testing_setup = MakeNoLogFileContext<const BasicTestingSetup>();
+    const auto mnList = BuildMNList(count);
+
+    bench.run([&] {
+        CSimplifiedMNList sml(mnList);
+        assert(!sml.CalcMerkleRoot().IsNull());
+    });
+}
+
+// Incremental SML root for the next block, which is what CalcCbTxMerkleRootMNList does on ConnectBlock
+static void MNList_SMLMerkleTreeUpdate(benchmark::Bench& bench, size_t count)
+{
+    const auto testing_setup = MakeNoLogFileContext<const BasicTestingSetup>();
+    const auto mnList = BuildMNList(count);
+    const BenchChain chain(MNLIST_TIP_HEIGHT);
+    const auto nextList = NextList(mnList, chain);
+    CSimplifiedMNListMerkleTree tree;
+    tree.Update(mnList);
+    bool next{true};
+
+    bench.run([&] {
+        tree.Update(next ? nextList : mnList);
+        next = !next;
+    });
+}
+
+// Footprint of a window of consecutive cached lists, which share all unchanged masternodes
+// and map nodes. The footprint is reported in the benchmark name, the timing is that of the
+// accounting done by CDeterministicMNManager::GetListsCacheMemoryUsage
+static void MNList_CachedMemoryUsage(benchmark::Bench& bench, size_t count)
+{
+    const auto testing_setup = MakeNoLogFileContext<const BasicTestingSetup>();
+    const BenchChain chain(MNLIST_TIP_HEIGHT);
+    std::vector<CDeterministicMNList> lists{BuildMNList(count)};
+    for (int i = 1; i < MNLIST_CACHED_LISTS; i++) {
+        lists.emplace_back(NextList(lists.back(), chain));
+    }
+
+    const auto cacheUsage = [&] {
+        std::unordered_set<const void*> seen;
+        size_t usage{0};
+        for (const auto& list : lists) {
+            usage += list.DynamicMemoryUsage(seen);
+        }
+        return usage;
+    };
+    std::unordered_set<const void*> seenSingle;
+    const size_t singleUsage = lists.front().DynamicMemoryUsage(seenSingle);
+    const size_t totalUsage = cacheUsage();
+
+    bench.name(strprintf("%s (%u KiB for one list, %u KiB for %d cached lists)", bench.name(),
+                         singleUsage / 1024, totalUsage / 1024, MNLIST_CACHED_LISTS));
+    bench.run([&] {
+        assert(cacheUsage() == totalUsage);
+    });
+}
+
+// The churn of the maps backing the lists under a given immer memory policy: each block copies the
+// newest map and updates a few entries, while the oldest of the cached maps is dropped and its nodes
+// freed. Every MNLIST_CACHED_LISTS blocks a whole map is rebuilt, like a list loaded from a snapshot.
+template <typename MemoryPolicy>
+static void MNList_MapChurn(benchmark::Bench& bench, size_t count)
+{
+    struct Hasher {
+        size_t operator()(const uint256& hash) const { return ReadLE64(hash.begin()); }
+    };
+    using Map = immer::map<uint256, std::shared_ptr<const int>, Hasher, std::equal_to<uint256>, MemoryPolicy>;
+
+    const auto value = std::make_shared<const int>(0);
+    const auto buildMap = [&] {
+        Map map;
+        for (size_t i = 0; i < count; i++) {
+            map = std::move(map).set(MakeHash(i, 1), value);
+        }
+        return map;
+    };
+    std::deque<Map> maps{buildMap()};
+    uint64_t nHeight{0};
+
+    bench.run([&] {
+        nHeight++;
+        if (nHeight % MNLIST_CACHED_LISTS == 0) {
+            maps.emplace_back(buildMap());
+        } else {
+            Map map = maps.back();
+            for (size_t i = 0; i <= MNLIST_UPDATES_PER_BLOCK; i++) {
+                map = map.set(MakeHash((nHeight * 7919 + i * 104729) % count, 1), value);
+            }
+            maps.emplace_back(std::move(map));
+        }
+        if (maps.size() > MNLIST_CACHED_LISTS) {
+            maps.pop_front();
+        }
+    });
+}
+
+static void MNList_MapChurnDefaultPolicy(benchmark::Bench& bench, size_t count)
+{
+    MNList_MapChurn<immer::default_memory_policy>(bench, count);
+}
+
+static void MNList_MapChurnMnListPolicy(benchmark::Bench& bench, size_t count)
+{
+    MNList_MapChurn<MnListMemoryPolicy>(bench, count);
+}
+
+#define BENCH_MNList(name, count) \
+    static void MNList_##name##_##count(benchmark::Bench& bench) \
+    { \
+        MNList_##name(bench, count); \
+    } \
+    BENCHMARK(MNList_##name##_##count)
+
+BENCH_MNList(GetMNPayee, 1000)
+BENCH_MNList(GetMNPayee, 5000)
+BENCH_MNList(GetMNPayee, 20000)
+
+BENCH_MNList(CalculateQuorum, 1000)
+BENCH_MNList(CalculateQuorum, 5000)
+BENCH_MNList(CalculateQuorum, 20000)
+
+BENCH_MNList(BuildDiff, 1000)
+BENCH_MNList(BuildDiff, 5000)
+BENCH_MNList(BuildDiff, 20000)
+
+BENCH_MNList(ApplyDiff, 1000)
+BENCH_MNList(ApplyDiff, 5000)
+BENCH_MNList(ApplyDiff, 20000)
+
+BENCH_MNList(SMLMerkleRoot, 1000)
+BENCH_MNList(SMLMerkleRoot, 5000)
+BENCH_MNList(SMLMerkleRoot, 20000)
+
+BENCH_MNList(SMLMerkleTreeUpdate, 1000)
+BENCH_MNList(SMLMerkleTreeUpdate, 5000)
+BENCH_MNList(SMLMerkleTreeUpdate, 20000)
+
+BENCH_MNList(CachedMemoryUsage, 1000)
+BENCH_MNList(CachedMemoryUsage, 5000)
+BENCH_MNList(CachedMemoryUsage, 20000)
+
+BENCH_MNList(MapChurnDefaultPolicy, 5000)
+BENCH_MNList(MapChurnDefaultPolicy, 20000)
+
+BENCH_MNList(MapChurnMnListPolicy, 5000)
+BENCH_MNList(MapChurnMnListPolicy, 20000)
@@ -38,5 +38,43 @@ static void MatchGCSFilter(benchmark::Bench& bench)
     });
 }
 
+// A wallet rescan matching its scripts against the same filter, decoded by the first call
+static void MatchAnyGCSFilter(benchmark::Bench& bench)
+{
+    GCSFilter::ElementSet elements, queries;
+    for (int i = 0; i < 10000; ++i) {
+        GCSFilter::Element element(32);
+        element[0] = static_cast<unsigned char>(i);
+        element[1] = static_cast<unsigned char>(i >> 8);
+        elements.insert(element);
+        element[2] = 1;
+        if (i % 10 == 0) queries.insert(std::move(element));
+    }
+    GCSFilter filter({0, 0, 20, 1 << 20}, elements);
+
+    bench.unit("elem").run([&] {
+        filter.MatchAny(queries);
+    });
+}
+
+static void DecodeGCSFilter(benchmark::Bench& bench)
+{
+    GCSFilter::ElementSet elements;
+    for (int i = 0; i < 10000; ++i) {
+        GCSFilter::Element element(32);
+        element[0] = static_cast<unsigned char>(i);
+        element[1] = static_cast<unsigned char>(i >> 8);
+        elements.insert(std::move(element));
+    }
+    GCSFilter filter({0, 0, 20, 1 << 20}, elements);
+    const auto encoded = filter.GetEncoded();
+
+    bench.batch(elements.size()).unit("elem").run([&] {
+        GCSFilter decoded({0, 0, 20, 1 << 20}, encoded);
+    });
+}
+
 BENCHMARK(ConstructGCSFilter);
 BENCHMARK(MatchGCSFilter);
+BENCHMARK(MatchAnyGCSFilter);
+BENCHMARK(DecodeGCSFilter);
@@ -0,0 +1,205 @@
+// Copyright (c) 2024 The Maximus developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <bench/bench.h>
+#include <bls/bls_batchverifier.h>
+#include <bls/bls_worker.h>
+#include <crypto/common.h>
+#include <llmq/signing.h>
+#include <llmq/signing_shares.h>
+#include <streams.h>
+#include <util/irange.h>
+#include <version.h>
+
+#include <vector>
+
+static constexpr Consensus::LLMQType BENCH_LLMQ_TYPE = Consensus::LLMQType::LLMQ_50_60;
+// Number of independent signing sessions (e.g. ISLOCKs) verified together in one batch
+static constexpr size_t RECSIGS_BATCH = 32;
+
+// A quorum produced by a single dealer, which yields the same key shares a real DKG would
+// without paying for the full n*n contribution exchange during setup
+class SigningQuorum
+{
+private:
+    CBLSWorker blsWorker;
+
+public:
+    const size_t threshold;
+    std::vector<CBLSId> ids;
+    std::vector<CBLSSecretKey> skShares;
+    std::vector<CBLSPublicKey> pkShares;
+    CBLSPublicKey quorumPublicKey;
+
+    explicit SigningQuorum(size_t quorumSize) :
+        threshold(quorumSize * 60 / 100)
+    {
+        ids.reserve(quorumSize);
+        for (const size_t i : irange::range(quorumSize)) {
+            uint256 id;
+            WriteLE64(id.begin(), i + 1);
+            ids.emplace_back(id);
+        }
+
+        blsWorker.Start();
+        BLSVerificationVectorPtr vvec;
+        blsWorker.GenerateContributions(threshold, ids, vvec, skShares);
+        blsWorker.Stop();
+
+        quorumPublicKey = (*vvec)[0];
+        pkShares.reserve(quorumSize);
+        for (const auto& sk : skShares) {
+            pkShares.emplace_back(sk.GetPublicKey());
+        }
+    }
+
+    static uint256 SessionId(size_t n)
+    {
+        uint256 id;
+        WriteLE64(id.begin(), n + 1);
+        return id;
+    }
+
+    uint256 SignHash(size_t session) const
+    {
+        const uint256 id = SessionId(session);
+        return llmq::BuildSignHash(BENCH_LLMQ_TYPE, uint256::ONE, id, id);
+    }
+
+    // Shares of the first `threshold` members, serialized the way they arrive in QSIGSHARE/QBSIGSHARES
+    std::vector<CDataStream> SerializedShares(size_t session) const
+    {
+        const uint256 signHash = SignHash(session);
+        std::vector<CDataStream> ret;
+        ret.reserve(threshold);
+        for (const size_t i : irange::range(threshold)) {
+            CDataStream ss(SER_NETWORK, PROTOCOL_VERSION);
+            ss << skShares[i].Sign(signHash);
+            ret.emplace_back(std::move(ss));
+        }
+        return ret;
+    }
+
+    CBLSSignature Recover(size_t session)
+    {
+        const uint256 signHash = SignHash(session);
+        std::vector<CBLSSignature> sigShares;
+        sigShares.reserve(threshold);
+        for (const size_t i : irange::range(threshold)) {
+            sigShares.emplace_back(skShares[i].Sign(signHash));
+        }
+        std::vector<CBLSId> sigIds(ids.begin(), ids.begin() + threshold);
+        CBLSSignature recovered;
+        bool ok = recovered.Recover(sigShares, sigIds);
+        assert(ok);
+        return recovered;
+    }
+};
+
+// Mirrors what CSigSharesManager does per incoming share before it reaches the store: lazy
+// deserialization, key computation, insertion and a threshold check, then the actual point decode
+static void LLMQ_ProcessSigShares(benchmark::Bench& bench, size_t quorumSize)
+{
+    SigningQuorum quorum(quorumSize);
+    const auto serialized = quorum.SerializedShares(0);
+    const uint256 id = SigningQuorum::SessionId(0);
+
+    bench.batch(quorum.threshold).unit("share").run([&] {
+        llmq::SigShareMap<llmq::CSigShare> sigShares;
+        for (const size_t i : irange::range(quorum.threshold)) {
+            CDataStream ss(serialized[i]);
+            CBLSLazySignature lazySig;
+            ss >> lazySig;
+            llmq::CSigShare sigShare(BENCH_LLMQ_TYPE, uint256::ONE, id, id, uint16_t(i), lazySig);
+            sigShare.UpdateKey();
+            sigShares.Add(sigShare.GetKey(), sigShare);
+            assert(sigShare.sigShare.Get().IsValid());
+        }
+        assert(sigShares.CountForSignHash(quorum.SignHash(0)) == quorum.threshold);
+    });
+}
+
+// Batched share verification as done in ProcessPendingSigShares (insecure batch, per-message fallback)
+static void LLMQ_VerifySigShares(benchmark::Bench& bench, size_t quorumSize)
+{
+    SigningQuorum quorum(quorumSize);
+    const uint256 signHash = quorum.SignHash(0);
+    std::vector<CBLSSignature> sigs;
+    sigs.reserve(quorum.threshold);
+    for (const size_t i : irange::range(quorum.threshold)) {
+        sigs.emplace_back(quorum.skShares[i].Sign(signHash));
+    }
+
+    bench.batch(quorum.threshold).unit("share").run([&] {
+        CBLSBatchVerifier<NodeId, llmq::SigShareKey> batchVerifier(false, true);
+        for (const size_t i : irange::range(quorum.threshold)) {
+            batchVerifier.PushMessage(NodeId(i % 8), std::make_pair(signHash, uint16_t(i)), signHash, sigs[i], quorum.pkShares[i]);
+        }
+        batchVerifier.Verify();
+        assert(batchVerifier.badSources.empty());
+    });
+}
+
+// Lagrange interpolation of the threshold signature from the collected shares (TryRecoverSig)
+static void LLMQ_RecoverSig(benchmark::Bench& bench, size_t quorumSize)
+{
+    SigningQuorum quorum(quorumSize);
+    const uint256 signHash = quorum.SignHash(0);
+    std::vector<CBLSSignature> sigShares;
+    sigShares.reserve(quorum.threshold);
+    for (const size_t i : irange::range(quorum.threshold)) {
+        sigShares.emplace_back(quorum.skShares[i].Sign(signHash));
+    }
+    std::vector<CBLSId> sigIds(quorum.ids.begin(), quorum.ids.begin() + quorum.threshold);
+
+    bench.run([&] {
+        CBLSSignature recovered;
+        bool ok = recovered.Recover(sigShares, sigIds);
+        assert(ok && recovered.VerifyInsecure(quorum.quorumPublicKey, signHash));
+    });
+}
+
+// Batched verification of recovered signatures, which is the cost of accepting a burst of
+// ISLOCKs/CLSIGs or QSIGREC messages (ProcessPendingRecoveredSigs / ProcessPendingInstantSendLocks).
+// Only the quorum public key is involved, so the cost does not depend on the quorum size
+static void LLMQ_VerifyRecoveredSigs(benchmark::Bench& bench, size_t quorumSize)
+{
+    SigningQuorum quorum(quorumSize);
+    std::vector<uint256> signHashes;
+    std::vector<CBLSSignature> recoveredSigs;
+    for (const size_t i : irange::range(RECSIGS_BATCH)) {
+        signHashes.emplace_back(quorum.SignHash(i));
+        recoveredSigs.emplace_back(quorum.Recover(i));
+    }
+
+    bench.batch(RECSIGS_BATCH).unit("recsig").run([&] {
+        CBLSBatchVerifier<NodeId, uint256> batchVerifier(false, false);
+        for (const size_t i : irange::range(RECSIGS_BATCH)) {
+            batchVerifier.PushMessage(NodeId(i % 8), signHashes[i], signHashes[i], recoveredSigs[i], quorum.quorumPublicKey);
+        }
+        batchVerifier.Verify();
+        assert(batchVerifier.badSources.empty());
+    });
+}
+
+#define BENCH_LLMQSigning(name, quorumSize) \
+    static void LLMQ_##name##_##quorumSize(benchmark::Bench& bench) \
+    { \
+        LLMQ_##name(bench, quorumSize); \
+    } \
+    BENCHMARK(LLMQ_##name##_##quorumSize)
+
+BENCH_LLMQSigning(ProcessSigShares, 50)
+BENCH_LLMQSigning(ProcessSigShares, 100)
+BENCH_LLMQSigning(ProcessSigShares, 400)
+
+BENCH_LLMQSigning(VerifySigShares, 50)
+BENCH_LLMQSigning(VerifySigShares, 100)
+BENCH_LLMQSigning(VerifySigShares, 400)
+
+BENCH_LLMQSigning(RecoverSig, 50)
+BENCH_LLMQSigning(RecoverSig, 100)
+BENCH_LLMQSigning(RecoverSig, 400)
+
+BENCH_LLMQSigning(VerifyRecoveredSigs, 50)
@@ -0,0 +1,65 @@
+// Copyright (c) 2024 The Maximus developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <bench/bench.h>
+#include <crypto/common.h>
+#include <llmq/signing_shares.h>
+#include <uint256.h>
+
+#include <thread>
+#include <vector>
+
+static constexpr size_t SIGSHARES_SESSIONS = 64;
+static constexpr size_t SIGSHARES_MEMBERS = 50;
+
+static std::vector<llmq::CSigShare> BuildSigShares()
+{
+    std::vector<llmq::CSigShare> sigShares;
+    sigShares.reserve(SIGSHARES_SESSIONS * SIGSHARES_MEMBERS);
+    for (size_t i = 0; i < SIGSHARES_SESSIONS; i++) {
+        uint256 id;
+        WriteLE64(id.begin(), i + 1);
+        for (size_t j = 0; j < SIGSHARES_MEMBERS; j++) {
+            llmq::CSigShare sigShare(Consensus::LLMQType::LLMQ_50_60, uint256::ONE, id, id, uint16_t(j), {});
+            sigShare.UpdateKey();
+            sigShares.emplace_back(sigShare);
+        }
+    }
+    return sigShares;
+}
+
+// Every thread plays a peer delivering the shares of its own subset of sessions, like the message
+// handler and the worker thread do when they process different signing sessions at the same time
+static void SigSharesIngest(benchmark::Bench& bench, size_t threadCount)
+{
+    const auto sigShares = BuildSigShares();
+
+    bench.batch(sigShares.size()).unit("share").run([&] {
+        llmq::CSigSharesStore store;
+        std::vector<std::thread> threads;
+        threads.reserve(threadCount);
+        for (size_t t = 0; t < threadCount; t++) {
+            threads.emplace_back([&, t] {
+                size_t count{0};
+                for (size_t i = t * SIGSHARES_MEMBERS; i < sigShares.size(); i += threadCount * SIGSHARES_MEMBERS) {
+                    for (size_t j = i; j < i + SIGSHARES_MEMBERS; j++) {
+                        if (!store.Has(sigShares[j].GetKey())) {
+                            store.Add(sigShares[j], 0, count);
+                        }
+                    }
+                }
+            });
+        }
+        for (auto& thread : threads) {
+            thread.join();
+        }
+        assert(store.CountForSignHash(sigShares.back().GetSignHash()) == SIGSHARES_MEMBERS);
+    });
+}
+
+static void SigShares_Ingest_1Thread(benchmark::Bench& bench) { SigSharesIngest(bench, 1); }
+static void SigShares_Ingest_4Threads(benchmark::Bench& bench) { SigSharesIngest(bench, 4); }
+
+BENCHMARK(SigShares_Ingest_1Thread)
+BENCHMARK(SigShares_Ingest_4Threads)
@@ -0,0 +1,61 @@
+// Copyright (c) 2024 The Maximus developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <bench/bench.h>
+#include <crypto/common.h>
+#include <masternode/meta.h>
+#include <test/util/setup_common.h>
+#include <uint256.h>
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+static constexpr size_t META_MASTERNODES = 4000;
+static constexpr size_t META_LOOKUPS_PER_THREAD = 1000;
+
+// Every thread plays a message handler checking DSQUEUE messages, i.e. it looks up the
+// queue's masternode, checks its dsq threshold and sometimes accepts the queue
+static void MasternodeMetaDsq(benchmark::Bench& bench, size_t threadCount)
+{
+    const auto testing_setup = MakeNoLogFileContext<const BasicTestingSetup>();
+    CMasternodeMetaMan metaman(/* load_cache */ false);
+
+    std::vector<uint256> proTxHashes(META_MASTERNODES);
+    for (size_t i = 0; i < proTxHashes.size(); i++) {
+        WriteLE64(proTxHashes[i].begin(), i + 1);
+        WriteLE64(proTxHashes[i].begin() + 24, (i + 1) * 0x9E3779B97F4A7C15ull);
+        metaman.GetMetaInfo(proTxHashes[i]);
+    }
+
+    bench.batch(threadCount * META_LOOKUPS_PER_THREAD).unit("lookup").run([&] {
+        std::atomic<int64_t> allowed{0};
+        std::vector<std::thread> threads;
+        threads.reserve(threadCount);
+        for (size_t t = 0; t < threadCount; t++) {
+            threads.emplace_back([&, t] {
+                for (size_t i = 0; i < META_LOOKUPS_PER_THREAD; i++) {
+                    const uint256& proTxHash = proTxHashes[(t * 7919 + i * 31) % proTxHashes.size()];
+                    int64_t nLastDsq = metaman.GetMetaInfo(proTxHash)->GetLastDsq();
+                    if (nLastDsq == 0 || metaman.GetDsqThreshold(proTxHash, META_MASTERNODES) <= metaman.GetDsqCount()) {
+                        if (i % 16 == 0) {
+                            metaman.AllowMixing(proTxHash);
+                            allowed++;
+                        }
+                    }
+                }
+            });
+        }
+        for (auto& thread : threads) {
+            thread.join();
+        }
+        ankerl::nanobench::doNotOptimizeAway(allowed.load());
+    });
+}
+
+static void MasternodeMeta_Dsq_1Thread(benchmark::Bench& bench) { MasternodeMetaDsq(bench, 1); }
+static void MasternodeMeta_Dsq_4Threads(benchmark::Bench& bench) { MasternodeMetaDsq(bench, 4); }
+
+BENCHMARK(MasternodeMeta_Dsq_1Thread)
+BENCHMARK(MasternodeMeta_Dsq_4Threads)
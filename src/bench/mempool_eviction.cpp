@@ -7,6 +7,8 @@
 #include <test/util/setup_common.h>
 #include <txmempool.h>
 
+#include <chrono>
+#include <vector>
 
 static void AddTx(const CTransactionRef& tx, const CAmount& nFee, CTxMemPool& pool) EXCLUSIVE_LOCKS_REQUIRED(cs_main, pool.cs)
 {
@@ -122,4 +124,66 @@ static void MempoolEviction(benchmark::Bench& bench)
     });
 }
 
+/** A spam wave of mostly unrelated transactions, some of them bumped by a child. */
+static std::vector<std::pair<CTransactionRef, CAmount>> CreateSpamWave(int count)
+{
+    std::vector<std::pair<CTransactionRef, CAmount>> txs;
+    for (int i = 0; i < count; ++i) {
+        CMutableTransaction tx;
+        tx.vin.resize(1);
+        tx.vin[0].scriptSig = CScript() << CScriptNum(i);
+        tx.vout.resize(1);
+        tx.vout[0].scriptPubKey = CScript() << OP_1 << OP_EQUAL;
+        tx.vout[0].nValue = 10 * COIN;
+        txs.emplace_back(MakeTransactionRef(tx), 1000 + (i % 97) * 10);
+        if (i % 5 == 0) {
+            CMutableTransaction child;
+            child.vin.resize(1);
+            child.vin[0].prevout = COutPoint(tx.GetHash(), 0);
+            child.vin[0].scriptSig = CScript() << OP_2;
+            child.vout.resize(1);
+            child.vout[0].scriptPubKey = CScript() << OP_2 << OP_EQUAL;
+            child.vout[0].nValue = 10 * COIN;
+            txs.emplace_back(MakeTransactionRef(child), 3000);
+        }
+    }
+    return txs;
+}
+
+static void MempoolEvictionSpam(benchmark::Bench& bench)
+{
+    const auto testing_setup = MakeNoLogFileContext<const TestingSetup>();
+    const auto txs = CreateSpamWave(2000);
+
+    CTxMemPool pool;
+    LOCK2(cs_main, pool.cs);
+
+    bench.run([&]() NO_THREAD_SAFETY_ANALYSIS {
+        for (const auto& [tx, fee] : txs) {
+            AddTx(tx, fee, pool);
+        }
+        pool.TrimToSize(pool.DynamicMemoryUsage() / 2);
+        pool.TrimToSize(0);
+    });
+}
+
+static void MempoolExpire(benchmark::Bench& bench)
+{
+    const auto testing_setup = MakeNoLogFileContext<const TestingSetup>();
+    const auto txs = CreateSpamWave(2000);
+
+    CTxMemPool pool;
+    LOCK2(cs_main, pool.cs);
+
+    bench.run([&]() NO_THREAD_SAFETY_ANALYSIS {
+        for (const auto& [tx, fee] : txs) {
+            AddTx(tx, fee, pool);
+        }
+        // every transaction was added at time 0
+        pool.Expire(std::chrono::seconds{1});
+    });
+}
+
 BENCHMARK(MempoolEviction);
+BENCHMARK(MempoolEvictionSpam);
+BENCHMARK(MempoolExpire);
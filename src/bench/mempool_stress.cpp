@@ -26,14 +26,8 @@ struct Available {
     Available(CTransactionRef& ref, size_t tx_count) : ref(ref), tx_count(tx_count){}
 };
 
-static void ComplexMemPool(benchmark::Bench& bench)
+static std::vector<CTransactionRef> CreateOrderedCoins(FastRandomContext& det_rand, int childTxs)
 {
-    int childTxs = 800;
-    if (bench.complexityN() > 1) {
-        childTxs = static_cast<int>(bench.complexityN());
-    }
-
-    FastRandomContext det_rand{true};
     std::vector<Available> available_coins;
     std::vector<CTransactionRef> ordered_coins;
     // Create some base transactions
@@ -77,6 +71,17 @@ static void ComplexMemPool(benchmark::Bench& bench)
         ordered_coins.emplace_back(MakeTransactionRef(tx));
         available_coins.emplace_back(ordered_coins.back(), tx_counter++);
     }
+    return ordered_coins;
+}
+
+static void ComplexMemPool(benchmark::Bench& bench)
+{
+    int childTxs = 800;
+    if (bench.complexityN() > 1) {
+        childTxs = static_cast<int>(bench.complexityN());
+    }
+    FastRandomContext det_rand{true};
+    std::vector<CTransactionRef> ordered_coins = CreateOrderedCoins(det_rand, childTxs);
     const auto testing_setup = MakeNoLogFileContext<const TestingSetup>(CBaseChainParams::MAIN);
     CTxMemPool pool;
     LOCK2(cs_main, pool.cs);
@@ -89,4 +94,24 @@ static void ComplexMemPool(benchmark::Bench& bench)
     });
 }
 
+static void ComplexMemPoolTrimSteps(benchmark::Bench& bench)
+{
+    FastRandomContext det_rand{true};
+    std::vector<CTransactionRef> ordered_coins = CreateOrderedCoins(det_rand, 800);
+    const auto testing_setup = MakeNoLogFileContext<const TestingSetup>(CBaseChainParams::MAIN);
+    CTxMemPool pool;
+    LOCK2(cs_main, pool.cs);
+    bench.run([&]() NO_THREAD_SAFETY_ANALYSIS {
+        for (auto& tx : ordered_coins) {
+            AddTx(tx, pool);
+        }
+        // A full mempool is trimmed a little after every accepted transaction
+        // during a spam wave, so take it down in many small steps.
+        while (pool.size() > 0) {
+            pool.TrimToSize(pool.DynamicMemoryUsage() * 19 / 20);
+        }
+    });
+}
+
 BENCHMARK(ComplexMemPool);
+BENCHMARK(ComplexMemPoolTrimSteps);
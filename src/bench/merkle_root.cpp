@@ -5,9 +5,13 @@
 #include <bench/bench.h>
 
 #include <consensus/merkle.h>
+#include <evo/simplifiedmns.h>
+#include <merkleblock.h>
 #include <random.h>
 #include <uint256.h>
 
+#include <map>
+
 static void MerkleRoot(benchmark::Bench& bench)
 {
     FastRandomContext rng(true);
@@ -23,4 +27,79 @@ static void MerkleRoot(benchmark::Bench& bench)
     });
 }
 
+static void MerkleLevels(benchmark::Bench& bench)
+{
+    FastRandomContext rng(true);
+    std::vector<uint256> leaves(9001);
+    for (auto& item : leaves) {
+        item = rng.rand256();
+    }
+    bench.batch(leaves.size()).unit("leaf").run([&] {
+        const auto levels = ComputeMerkleLevels(leaves);
+        leaves[0] = levels.back()[0];
+    });
+}
+
+static void PartialMerkleTreeBuild(benchmark::Bench& bench)
+{
+    // A filtered block with a few matches, as served to SPV clients
+    FastRandomContext rng(true);
+    std::vector<uint256> txids(9001);
+    std::vector<bool> matches(txids.size());
+    for (size_t i = 0; i < txids.size(); i++) {
+        txids[i] = rng.rand256();
+        matches[i] = rng.randrange(1000) == 0;
+    }
+    bench.batch(txids.size()).unit("leaf").run([&] {
+        CPartialMerkleTree tree(txids, matches);
+        ankerl::nanobench::doNotOptimizeAway(tree);
+    });
+}
+
+static std::vector<CSimplifiedMNListEntry> RandomSMLEntries(FastRandomContext& rng, size_t count)
+{
+    std::vector<CSimplifiedMNListEntry> entries(count);
+    for (auto& entry : entries) {
+        entry.proRegTxHash = rng.rand256();
+        entry.confirmedHash = rng.rand256();
+        entry.isValid = rng.randbool();
+    }
+    return entries;
+}
+
+static void SimplifiedMNListMerkleRoot(benchmark::Bench& bench)
+{
+    FastRandomContext rng(true);
+    const CSimplifiedMNList sml(RandomSMLEntries(rng, 3000));
+    bench.batch(sml.mnList.size()).unit("entry").run([&] {
+        bool mutated = false;
+        ankerl::nanobench::doNotOptimizeAway(sml.CalcMerkleRoot(&mutated));
+    });
+}
+
+static void SimplifiedMNListMerkleTreeUpdate(benchmark::Bench& bench)
+{
+    // The per-block case: a few entries of a large list change their leaf hash
+    FastRandomContext rng(true);
+    const auto entries = RandomSMLEntries(rng, 3000);
+    std::map<uint256, uint256> initial;
+    for (const auto& entry : entries) {
+        initial.emplace(entry.proRegTxHash, entry.CalcHash());
+    }
+    CSimplifiedMNListMerkleTree tree;
+    tree.Apply({}, initial);
+    bench.run([&] {
+        std::map<uint256, uint256> updated;
+        for (int i = 0; i < 20; i++) {
+            updated.emplace(entries[rng.randrange(entries.size())].proRegTxHash, rng.rand256());
+        }
+        tree.Apply({}, updated);
+        ankerl::nanobench::doNotOptimizeAway(tree.GetMerkleRoot());
+    });
+}
+
 BENCHMARK(MerkleRoot);
+BENCHMARK(MerkleLevels);
+BENCHMARK(PartialMerkleTreeBuild);
+BENCHMARK(SimplifiedMNListMerkleRoot);
+BENCHMARK(SimplifiedMNListMerkleTreeUpdate);
@@ -0,0 +1,39 @@
+// Copyright (c) 2024 The Maximus developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <bench/bench.h>
+#include <random.h>
+#include <streams.h>
+
+#include <vector>
+
+/** XOR a mix of value sizes as found in the chainstate: mostly small coins, some bigger scripts and undo data. */
+static void ObfuscateChainstateValues(benchmark::Bench& bench)
+{
+    FastRandomContext rng(/* deterministic */ true);
+    const std::vector<unsigned char> key = rng.randbytes(8);
+    std::vector<CDataStream> values;
+    for (size_t size : {12, 25, 33, 35, 37, 41, 44, 48, 57, 73, 110, 150, 280, 1024}) {
+        values.emplace_back(rng.randbytes(size), SER_DISK, 0);
+    }
+    bench.batch(values.size()).unit("value").run([&] {
+        for (auto& value : values) {
+            value.Xor(key);
+        }
+    });
+}
+
+/** XOR a single block sized buffer. */
+static void ObfuscateLargeValue(benchmark::Bench& bench)
+{
+    FastRandomContext rng(/* deterministic */ true);
+    const std::vector<unsigned char> key = rng.randbytes(8);
+    CDataStream value(rng.randbytes(1000000), SER_DISK, 0);
+    bench.batch(value.size()).unit("byte").run([&] {
+        value.Xor(key);
+    });
+}
+
+BENCHMARK(ObfuscateChainstateValues);
+BENCHMARK(ObfuscateLargeValue);
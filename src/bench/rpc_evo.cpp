@@ -0,0 +1,159 @@
+// Copyright (c) 2024 The Maximus developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <bench/bench.h>
+#include <bls/bls.h>
+#include <evo/dmn_types.h>
+#include <evo/providertx.h>
+#include <evo/specialtx.h>
+#include <netbase.h>
+#include <rpc/client.h>
+#include <rpc/server.h>
+#include <script/sign.h>
+#include <script/signingprovider.h>
+#include <script/standard.h>
+#include <test/util/setup_common.h>
+#include <util/string.h>
+#include <validation.h>
+
+#include <univalue.h>
+
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+// Masternodes registered on top of the DIP3 chain, in blocks of MNS_PER_BLOCK ProRegTxs
+static constexpr int RPC_EVO_MN_COUNT = 40;
+static constexpr int RPC_EVO_MNS_PER_BLOCK = 10;
+
+namespace {
+
+/**
+ * Regtest chain past DIP3 activation with masternodes registered through real ProRegTxs, so the calls below go through
+ * the same masternode list, block and special tx payload code as on a node serving an RPC backend.
+ */
+struct RPCEvoSetup : public TestChainSetup {
+    std::vector<uint256> m_protx_hashes;
+    uint256 m_registration_block;
+    int m_first_registration_height{0};
+
+    RPCEvoSetup() : TestChainSetup(431, {"-nodebuglogfile", "-nodebug"})
+    {
+        FillableSigningProvider keystore;
+        keystore.AddKeyPubKey(coinbaseKey, coinbaseKey.GetPubKey());
+        const CScript payout{GetScriptForDestination(PKHash(coinbaseKey.GetPubKey()))};
+
+        size_t next_coinbase{0};
+        m_first_registration_height = WITH_LOCK(cs_main, return m_node.chainman->ActiveChain().Height()) + 1;
+        for (int i = 0; i < RPC_EVO_MN_COUNT; i += RPC_EVO_MNS_PER_BLOCK) {
+            std::vector<CMutableTransaction> txs;
+            for (int j = i; j < i + RPC_EVO_MNS_PER_BLOCK; j++) {
+                CMutableTransaction tx;
+                tx.nVersion = 3;
+                tx.nType = TRANSACTION_PROVIDER_REGISTER;
+                std::vector<CTransactionRef> spent;
+                CAmount in{0};
+                const CAmount out{dmn_types::Regular.collat_amount + 1000};
+                while (in < out) {
+                    const CTransactionRef& coinbase{m_coinbase_txns.at(next_coinbase++)};
+                    tx.vin.emplace_back(COutPoint(coinbase->GetHash(), 0));
+                    spent.push_back(coinbase);
+                    in += coinbase->vout[0].nValue;
+                }
+                tx.vout.emplace_back(dmn_types::Regular.collat_amount, payout);
+                tx.vout.emplace_back(in - out, payout);
+
+                CKey owner_key;
+                owner_key.MakeNewKey(true);
+                CBLSSecretKey operator_key;
+                operator_key.MakeNewKey();
+                CProRegTx proTx;
+                proTx.nVersion = CProRegTx::GetVersion(!bls::bls_legacy_scheme);
+                proTx.collateralOutpoint.n = 0;
+                proTx.addr = LookupNumeric("1.1.1.1", 10000 + j);
+                proTx.keyIDOwner = owner_key.GetPubKey().GetID();
+                proTx.pubKeyOperator.Set(operator_key.GetPublicKey(), bls::bls_legacy_scheme.load());
+                proTx.keyIDVoting = proTx.keyIDOwner;
+                proTx.scriptPayout = payout;
+                proTx.inputsHash = CalcTxInputsHash(CTransaction(tx));
+                SetTxPayload(tx, proTx);
+                for (size_t k = 0; k < tx.vin.size(); k++) {
+                    if (!SignSignature(keystore, *spent[k], tx, k, SIGHASH_ALL)) {
+                        throw std::runtime_error("failed to sign ProRegTx");
+                    }
+                }
+                m_protx_hashes.push_back(tx.GetHash());
+                txs.push_back(tx);
+            }
+            m_registration_block = CreateAndProcessBlock(txs, coinbaseKey).GetHash();
+        }
+        // a few more blocks to have payees and confirmed masternodes
+        mineBlocks(10);
+        if (RPCIsInWarmup(nullptr)) SetRPCWarmupFinished();
+    }
+
+    UniValue CallRPC(const std::vector<std::string>& args)
+    {
+        CoreContext context{m_node};
+        JSONRPCRequest request(context);
+        request.strMethod = args[0];
+        request.params = RPCConvertValues(args[0], {args.begin() + 1, args.end()});
+        return tableRPC.execute(request);
+    }
+};
+
+void RunRPC(benchmark::Bench& bench, RPCEvoSetup& setup, const std::vector<std::string>& args)
+{
+    // the reply is serialized as well, that's part of what a client waits for
+    bench.run([&] {
+        const std::string reply{setup.CallRPC(args).write()};
+        ankerl::nanobench::doNotOptimizeAway(reply);
+    });
+}
+
+} // namespace
+
+static void RpcProtxList(benchmark::Bench& bench)
+{
+    RPCEvoSetup setup;
+    RunRPC(bench, setup, {"protx", "list", "registered", "false"});
+}
+
+static void RpcProtxListDetailed(benchmark::Bench& bench)
+{
+    RPCEvoSetup setup;
+    RunRPC(bench, setup, {"protx", "list", "registered", "true"});
+}
+
+static void RpcProtxDiff(benchmark::Bench& bench)
+{
+    RPCEvoSetup setup;
+    const int tip_height{WITH_LOCK(cs_main, return setup.m_node.chainman->ActiveChain().Height())};
+    RunRPC(bench, setup, {"protx", "diff", ToString(setup.m_first_registration_height - 1), ToString(tip_height)});
+}
+
+static void RpcMasternodeWinners(benchmark::Bench& bench)
+{
+    RPCEvoSetup setup;
+    RunRPC(bench, setup, {"masternode", "winners", "10"});
+}
+
+static void RpcGetBlockVerbose2SpecialTxs(benchmark::Bench& bench)
+{
+    RPCEvoSetup setup;
+    RunRPC(bench, setup, {"getblock", setup.m_registration_block.GetHex(), "2"});
+}
+
+static void RpcGetRawTransactionVerboseProRegTx(benchmark::Bench& bench)
+{
+    RPCEvoSetup setup;
+    RunRPC(bench, setup, {"getrawtransaction", setup.m_protx_hashes.back().GetHex(), "true", setup.m_registration_block.GetHex()});
+}
+
+BENCHMARK(RpcProtxList);
+BENCHMARK(RpcProtxListDetailed);
+BENCHMARK(RpcProtxDiff);
+BENCHMARK(RpcMasternodeWinners);
+BENCHMARK(RpcGetBlockVerbose2SpecialTxs);
+BENCHMARK(RpcGetRawTransactionVerboseProRegTx);
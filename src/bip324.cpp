@@ -0,0 +1,99 @@
+// Copyright (c) 2024 The Maximus developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <bip324.h>
+
+#include <chainparams.h>
+#include <crypto/common.h>
+#include <crypto/hkdf_sha256_32.h>
+#include <support/cleanse.h>
+
+#include <algorithm>
+#include <assert.h>
+#include <string>
+
+BIP324Cipher::BIP324Cipher(const CKey& key, Span<const std::byte> ent32) :
+    m_key(key), m_our_pubkey(key.EllSwiftCreate(ent32))
+{
+}
+
+BIP324Cipher::BIP324Cipher(const CKey& key, const EllSwiftPubKey& pubkey) :
+    m_key(key), m_our_pubkey(pubkey)
+{
+}
+
+void BIP324Cipher::Initialize(const EllSwiftPubKey& their_pubkey, bool initiator, bool self_decrypt)
+{
+    assert(!*this);
+    // Whether the initiator keys are used for sending and receiving
+    const bool send_initiator = initiator;
+    const bool recv_initiator = initiator == self_decrypt;
+
+    ECDHSecret ecdh_secret = m_key.ComputeBIP324ECDHSecret(their_pubkey, m_our_pubkey, initiator);
+
+    const auto& message_start = Params().MessageStart();
+    const std::string salt = std::string{"bitcoin_v2_shared_secret"} + std::string(std::begin(message_start), std::end(message_start));
+    CHKDF_HMAC_SHA256_L32 hkdf(UCharCast(ecdh_secret.data()), ecdh_secret.size(), salt);
+
+    unsigned char okm[32];
+    hkdf.Expand32("initiator_L", okm);
+    if (send_initiator) m_send_l_cipher.emplace(okm, REKEY_INTERVAL);
+    if (recv_initiator) m_recv_l_cipher.emplace(okm, REKEY_INTERVAL);
+    hkdf.Expand32("initiator_P", okm);
+    if (send_initiator) m_send_p_cipher.emplace(okm, REKEY_INTERVAL);
+    if (recv_initiator) m_recv_p_cipher.emplace(okm, REKEY_INTERVAL);
+    hkdf.Expand32("responder_L", okm);
+    if (!send_initiator) m_send_l_cipher.emplace(okm, REKEY_INTERVAL);
+    if (!recv_initiator) m_recv_l_cipher.emplace(okm, REKEY_INTERVAL);
+    hkdf.Expand32("responder_P", okm);
+    if (!send_initiator) m_send_p_cipher.emplace(okm, REKEY_INTERVAL);
+    if (!recv_initiator) m_recv_p_cipher.emplace(okm, REKEY_INTERVAL);
+
+    // The first half is sent by the initiator, the second half by the responder
+    hkdf.Expand32("garbage_terminators", okm);
+    const std::byte* initiator_terminator = reinterpret_cast<const std::byte*>(okm);
+    const std::byte* responder_terminator = initiator_terminator + GARBAGE_TERMINATOR_LEN;
+    std::copy_n(send_initiator ? initiator_terminator : responder_terminator, GARBAGE_TERMINATOR_LEN, m_send_garbage_terminator.begin());
+    std::copy_n(recv_initiator ? initiator_terminator : responder_terminator, GARBAGE_TERMINATOR_LEN, m_recv_garbage_terminator.begin());
+
+    hkdf.Expand32("session_id", UCharCast(m_session_id.data()));
+
+    memory_cleanse(okm, sizeof(okm));
+    memory_cleanse(ecdh_secret.data(), ecdh_secret.size());
+    // Our private key is not needed anymore
+    m_key = CKey();
+}
+
+void BIP324Cipher::Encrypt(Span<const std::byte> contents, Span<const std::byte> aad, bool ignore, Span<std::byte> output)
+{
+    assert(output.size() == contents.size() + EXPANSION);
+
+    unsigned char len[4];
+    WriteLE32(len, contents.size());
+    m_send_l_cipher->Crypt(len, UCharCast(output.data()), LENGTH_LEN);
+
+    const unsigned char header = std::to_integer<unsigned char>(ignore ? IGNORE_BIT : std::byte{0});
+    m_send_p_cipher->Encrypt(&header, HEADER_LEN, UCharCast(contents.data()), contents.size(), UCharCast(aad.data()), aad.size(), UCharCast(output.data() + LENGTH_LEN));
+}
+
+uint32_t BIP324Cipher::DecryptLength(Span<const std::byte> input)
+{
+    assert(input.size() == LENGTH_LEN);
+
+    unsigned char len[4] = {0};
+    m_recv_l_cipher->Crypt(UCharCast(input.data()), len, LENGTH_LEN);
+    return ReadLE32(len);
+}
+
+bool BIP324Cipher::Decrypt(Span<const std::byte> input, Span<const std::byte> aad, bool& ignore, Span<std::byte> contents)
+{
+    assert(input.size() == contents.size() + HEADER_LEN + FSChaCha20Poly1305::EXPANSION);
+
+    unsigned char header;
+    if (!m_recv_p_cipher->Decrypt(UCharCast(input.data()), input.size(), UCharCast(aad.data()), aad.size(), &header, HEADER_LEN, UCharCast(contents.data()), contents.size())) {
+        return false;
+    }
+    ignore = (std::byte{header} & IGNORE_BIT) == IGNORE_BIT;
+    return true;
+}
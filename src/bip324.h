@@ -0,0 +1,90 @@
+// Copyright (c) 2024 The Maximus developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_BIP324_H
+#define BITCOIN_BIP324_H
+
+#include <crypto/chacha20.h>
+#include <crypto/chacha20poly1305.h>
+#include <key.h>
+#include <pubkey.h>
+#include <span.h>
+
+#include <array>
+#include <cstddef>
+#include <optional>
+
+/** The packet encryption of the BIP324 v2 P2P transport.
+ *
+ * Each packet is the 3-byte packet length encrypted with an FSChaCha20, followed by a header byte and the contents
+ * encrypted with an FSChaCha20Poly1305. Both directions have their own pair of ciphers, all derived from the
+ * ElligatorSwift ECDH secret and the network magic.
+ */
+class BIP324Cipher
+{
+public:
+    static constexpr unsigned SESSION_ID_LEN{32};
+    static constexpr unsigned GARBAGE_TERMINATOR_LEN{16};
+    static constexpr unsigned REKEY_INTERVAL{224};
+    static constexpr unsigned LENGTH_LEN{3};
+    static constexpr unsigned HEADER_LEN{1};
+    /** Number of bytes a packet is longer than its contents. */
+    static constexpr unsigned EXPANSION = LENGTH_LEN + HEADER_LEN + FSChaCha20Poly1305::EXPANSION;
+    /** Bit in the header byte of packets the receiver must ignore (decoys). */
+    static constexpr std::byte IGNORE_BIT{0x80};
+
+private:
+    std::optional<FSChaCha20> m_send_l_cipher;
+    std::optional<FSChaCha20> m_recv_l_cipher;
+    std::optional<FSChaCha20Poly1305> m_send_p_cipher;
+    std::optional<FSChaCha20Poly1305> m_recv_p_cipher;
+
+    CKey m_key;
+    EllSwiftPubKey m_our_pubkey;
+
+    std::array<std::byte, SESSION_ID_LEN> m_session_id;
+    std::array<std::byte, GARBAGE_TERMINATOR_LEN> m_send_garbage_terminator;
+    std::array<std::byte, GARBAGE_TERMINATOR_LEN> m_recv_garbage_terminator;
+
+public:
+    BIP324Cipher() = delete;
+
+    /** Initialize with our private key and 32 bytes of entropy for the ElligatorSwift encoding of our public key. */
+    BIP324Cipher(const CKey& key, Span<const std::byte> ent32);
+
+    /** Initialize with our private key and an already encoded public key, only useful for tests. */
+    BIP324Cipher(const CKey& key, const EllSwiftPubKey& pubkey);
+
+    /** The public key to send to the other side. */
+    const EllSwiftPubKey& GetOurPubKey() const { return m_our_pubkey; }
+
+    /** Derive the session keys from the public key sent by the other side. Can only be called once, and wipes our
+     *  private key. With self_decrypt, the receive ciphers use the send keys, so that we can decrypt our own packets. */
+    void Initialize(const EllSwiftPubKey& their_pubkey, bool initiator, bool self_decrypt = false);
+
+    /** Whether Initialize has been called. */
+    explicit operator bool() const { return m_send_l_cipher.has_value(); }
+
+    /** Encrypt a packet. output must be exactly contents.size() + EXPANSION bytes long. */
+    void Encrypt(Span<const std::byte> contents, Span<const std::byte> aad, bool ignore, Span<std::byte> output);
+
+    /** Decrypt the length of the next packet, from its first LENGTH_LEN bytes. The remainder of the packet is
+     *  the returned number of bytes plus HEADER_LEN and FSChaCha20Poly1305::EXPANSION. */
+    uint32_t DecryptLength(Span<const std::byte> input);
+
+    /** Decrypt the packet that follows the length, and verify it. input is the remainder of the packet, contents
+     *  must be exactly as long as returned by DecryptLength. Returns false if the packet is not authentic. */
+    bool Decrypt(Span<const std::byte> input, Span<const std::byte> aad, bool& ignore, Span<std::byte> contents);
+
+    /** The session id, only available after Initialize. */
+    Span<const std::byte> GetSessionID() const { return m_session_id; }
+
+    /** The garbage terminator to send after our garbage, only available after Initialize. */
+    Span<const std::byte> GetSendGarbageTerminator() const { return m_send_garbage_terminator; }
+
+    /** The garbage terminator to expect after the garbage of the other side, only available after Initialize. */
+    Span<const std::byte> GetReceiveGarbageTerminator() const { return m_recv_garbage_terminator; }
+};
+
+#endif // BITCOIN_BIP324_H
@@ -2,11 +2,13 @@
 // Distributed under the MIT software license, see the accompanying
 // file COPYING or http://www.opensource.org/licenses/mit-license.php.
 
+#include <algorithm>
 #include <mutex>
 #include <sstream>
 #include <set>
 
 #include <blockfilter.h>
+#include <crypto/common.h>
 #include <crypto/siphash.h>
 #include <hash.h>
 #include <primitives/transaction.h>
@@ -20,10 +22,36 @@ static constexpr int GCS_SER_TYPE = SER_NETWORK;
 /// Protocol version used to serialize parameters in GCS filter encoding.
 static constexpr int GCS_SER_VERSION = 0;
 
+/// Element sets from this size on are sorted with RadixSort instead of std::sort.
+static constexpr size_t GCS_RADIX_SORT_MIN_ELEMENTS = 256;
+
 static const std::map<BlockFilterType, std::string> g_filter_types = {
     {BlockFilterType::BASIC_FILTER, "basic"},
 };
 
+/** Least significant digit first radix sort of values not above max_value, one pass per byte in use. */
+static void RadixSort(std::vector<uint64_t>& values, uint64_t max_value)
+{
+    std::vector<uint64_t> sorted(values.size());
+    const unsigned int bits = CountBits(max_value);
+    for (unsigned int shift = 0; shift < bits; shift += 8) {
+        size_t offsets[256] = {};
+        for (uint64_t value : values) {
+            ++offsets[(value >> shift) & 0xff];
+        }
+        size_t pos = 0;
+        for (size_t& offset : offsets) {
+            const size_t count = offset;
+            offset = pos;
+            pos += count;
+        }
+        for (uint64_t value : values) {
+            sorted[offsets[(value >> shift) & 0xff]++] = value;
+        }
+        values.swap(sorted);
+    }
+}
+
 uint64_t GCSFilter::HashToRange(const Element& element) const
 {
     uint64_t hash = CSipHasher(m_params.m_siphash_k0, m_params.m_siphash_k1)
@@ -39,7 +67,11 @@ std::vector<uint64_t> GCSFilter::BuildHashedSet(const ElementSet& elements) cons
     for (const Element& element : elements) {
         hashed_elements.push_back(HashToRange(element));
     }
-    std::sort(hashed_elements.begin(), hashed_elements.end());
+    if (hashed_elements.size() >= GCS_RADIX_SORT_MIN_ELEMENTS) {
+        RadixSort(hashed_elements, m_F - 1);
+    } else {
+        std::sort(hashed_elements.begin(), hashed_elements.end());
+    }
     return hashed_elements;
 }
 
@@ -61,11 +93,12 @@ GCSFilter::GCSFilter(const Params& params, std::vector<unsigned char> encoded_fi
 
     // Verify that the encoded filter contains exactly N elements. If it has too much or too little
     // data, a std::ios_base::failure exception will be raised.
-    BitStreamReader<SpanReader> bitreader{stream};
+    const auto data = Span{m_encoded}.subspan(GetSizeOfCompactSize(N));
+    GolombRiceReader reader{data, m_params.m_P};
     for (uint64_t i = 0; i < m_N; ++i) {
-        GolombRiceDecode(bitreader, m_params.m_P);
+        reader.Decode();
     }
-    if (!stream.empty()) {
+    if (reader.BytesRead() != data.size()) {
         throw std::ios_base::failure("encoded_filter contains excess data");
     }
 }
@@ -88,44 +121,91 @@ GCSFilter::GCSFilter(const Params& params, const ElementSet& elements)
         return;
     }
 
-    BitStreamWriter<CVectorWriter> bitwriter(stream);
+    const std::vector<uint64_t> hashed_elements = BuildHashedSet(elements);
+    // About N * (P + 2) bits, so the vector doesn't have to grow while encoding
+    m_encoded.reserve(m_encoded.size() + (hashed_elements.size() * (m_params.m_P + 2) + 7) / 8);
+    GolombRiceWriter writer{m_encoded, m_params.m_P};
 
     uint64_t last_value = 0;
-    for (uint64_t value : BuildHashedSet(elements)) {
+    for (uint64_t value : hashed_elements) {
         uint64_t delta = value - last_value;
-        GolombRiceEncode(bitwriter, m_params.m_P, delta);
+        writer.Encode(delta);
         last_value = value;
     }
 
-    bitwriter.Flush();
+    writer.Flush();
 }
 
-bool GCSFilter::MatchInternal(const uint64_t* element_hashes, size_t size) const
+GCSFilter::GCSFilter(const GCSFilter& other)
+    : m_params(other.m_params), m_N(other.m_N), m_F(other.m_F), m_encoded(other.m_encoded),
+      m_decoded(WITH_LOCK(other.m_decoded_mutex, return other.m_decoded))
+{}
+
+GCSFilter::GCSFilter(GCSFilter&& other) noexcept
+    : m_params(other.m_params), m_N(other.m_N), m_F(other.m_F), m_encoded(std::move(other.m_encoded)),
+      m_decoded(WITH_LOCK(other.m_decoded_mutex, return std::move(other.m_decoded)))
+{}
+
+GCSFilter& GCSFilter::operator=(const GCSFilter& other)
 {
-    SpanReader stream{GCS_SER_TYPE, GCS_SER_VERSION, m_encoded, 0};
+    if (this != &other) {
+        auto decoded = WITH_LOCK(other.m_decoded_mutex, return other.m_decoded);
+        m_params = other.m_params;
+        m_N = other.m_N;
+        m_F = other.m_F;
+        m_encoded = other.m_encoded;
+        LOCK(m_decoded_mutex);
+        m_decoded = std::move(decoded);
+    }
+    return *this;
+}
 
-    // Seek forward by size of N
-    uint64_t N = ReadCompactSize(stream);
-    assert(N == m_N);
-
-    BitStreamReader<SpanReader> bitreader{stream};
-
-    uint64_t value = 0;
-    size_t hashes_index = 0;
-    for (uint32_t i = 0; i < m_N; ++i) {
-        uint64_t delta = GolombRiceDecode(bitreader, m_params.m_P);
-        value += delta;
-
-        while (true) {
-            if (hashes_index == size) {
-                return false;
-            } else if (element_hashes[hashes_index] == value) {
-                return true;
-            } else if (element_hashes[hashes_index] > value) {
-                break;
-            }
+GCSFilter& GCSFilter::operator=(GCSFilter&& other) noexcept
+{
+    if (this != &other) {
+        auto decoded = WITH_LOCK(other.m_decoded_mutex, return std::move(other.m_decoded));
+        m_params = other.m_params;
+        m_N = other.m_N;
+        m_F = other.m_F;
+        m_encoded = std::move(other.m_encoded);
+        LOCK(m_decoded_mutex);
+        m_decoded = std::move(decoded);
+    }
+    return *this;
+}
 
-            hashes_index++;
+std::shared_ptr<const std::vector<uint64_t>> GCSFilter::GetDecoded() const
+{
+    LOCK(m_decoded_mutex);
+    if (!m_decoded) {
+        auto decoded = std::make_shared<std::vector<uint64_t>>();
+        decoded->reserve(m_N);
+        GolombRiceReader reader{Span{m_encoded}.subspan(GetSizeOfCompactSize(m_N)), m_params.m_P};
+        uint64_t value = 0;
+        for (uint32_t i = 0; i < m_N; ++i) {
+            value += reader.Decode();
+            decoded->push_back(value);
+        }
+        m_decoded = std::move(decoded);
+    }
+    return m_decoded;
+}
+
+bool GCSFilter::MatchInternal(const uint64_t* element_hashes, size_t size) const
+{
+    const auto decoded = GetDecoded();
+
+    // Few queries are looked up by binary search, many are merged with the filter elements
+    const bool search = size * 16 < decoded->size();
+    auto it = decoded->begin();
+    for (size_t i = 0; i < size && it != decoded->end(); ++i) {
+        if (search) {
+            it = std::lower_bound(it, decoded->end(), element_hashes[i]);
+        } else {
+            while (it != decoded->end() && *it < element_hashes[i]) ++it;
+        }
+        if (it != decoded->end() && *it == element_hashes[i]) {
+            return true;
         }
     }
 
@@ -6,6 +6,7 @@
 #define BITCOIN_BLOCKFILTER_H
 
 #include <stdint.h>
+#include <memory>
 #include <string>
 #include <set>
 #include <unordered_set>
@@ -14,6 +15,7 @@
 #include <attributes.h>
 #include <primitives/block.h>
 #include <serialize.h>
+#include <sync.h>
 #include <uint256.h>
 #include <undo.h>
 #include <util/bytevectorhash.h>
@@ -46,13 +48,20 @@ private:
     uint64_t m_F;  //!< Range of element hashes, F = N * M
     std::vector<unsigned char> m_encoded;
 
+    mutable Mutex m_decoded_mutex;
+    /** Sorted element hashes decoded by the first Match or MatchAny call, shared between copies of the filter. */
+    mutable std::shared_ptr<const std::vector<uint64_t>> m_decoded GUARDED_BY(m_decoded_mutex);
+
     /** Hash a data element to an integer in the range [0, N * M). */
     uint64_t HashToRange(const Element& element) const;
 
     std::vector<uint64_t> BuildHashedSet(const ElementSet& elements) const;
 
+    /** Get the sorted element hashes of the filter, decoding them on the first call. */
+    std::shared_ptr<const std::vector<uint64_t>> GetDecoded() const EXCLUSIVE_LOCKS_REQUIRED(!m_decoded_mutex);
+
     /** Helper method used to implement Match and MatchAny */
-    bool MatchInternal(const uint64_t* sorted_element_hashes, size_t size) const;
+    bool MatchInternal(const uint64_t* sorted_element_hashes, size_t size) const EXCLUSIVE_LOCKS_REQUIRED(!m_decoded_mutex);
 
 public:
 
@@ -65,6 +74,11 @@ public:
     /** Builds a new filter from the params and set of elements. */
     GCSFilter(const Params& params, const ElementSet& elements);
 
+    GCSFilter(const GCSFilter& other);
+    GCSFilter(GCSFilter&& other) noexcept;
+    GCSFilter& operator=(const GCSFilter& other);
+    GCSFilter& operator=(GCSFilter&& other) noexcept;
+
     uint32_t GetN() const { return m_N; }
     const Params& GetParams() const LIFETIMEBOUND { return m_params; }
     const std::vector<unsigned char>& GetEncoded() const LIFETIMEBOUND { return m_encoded; }
@@ -73,14 +87,14 @@ public:
      * Checks if the element may be in the set. False positives are possible
      * with probability 1/M.
      */
-    bool Match(const Element& element) const;
+    bool Match(const Element& element) const EXCLUSIVE_LOCKS_REQUIRED(!m_decoded_mutex);
 
     /**
      * Checks if any of the given elements may be in the set. False positives
      * are possible with probability 1/M per element checked. This is more
      * efficient that checking Match on multiple elements separately.
      */
-    bool MatchAny(const ElementSet& elements) const;
+    bool MatchAny(const ElementSet& elements) const EXCLUSIVE_LOCKS_REQUIRED(!m_decoded_mutex);
 };
 
 constexpr uint8_t BASIC_FILTER_P = 19;
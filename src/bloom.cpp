@@ -110,6 +110,16 @@ bool CBloomFilter::CheckScript(const CScript &script) const
     return false;
 }
 
+// Match if the filter contains any of the given script data elements
+bool CBloomFilter::CheckElements(const TxScriptElements& elements, std::pair<size_t, size_t> range) const
+{
+    for (size_t i = range.first; i < range.second; ++i) {
+        if (contains(elements.Element(i)))
+            return true;
+    }
+    return false;
+}
+
 // If the transaction is a special transaction that has a registration
 // transaction hash, test the registration transaction hash.
 // If the transaction is a special transaction with any public keys or any
@@ -202,21 +212,24 @@ bool CBloomFilter::ProcessTxOut(const CTxOut& txout, const uint256& hash, unsign
     // If this matches, also add the specific output that was matched.
     // This means clients don't have to update the filter themselves when a new relevant tx
     // is discovered in order to find spending transactions, which avoids round-tripping and race conditions.
-    bool fFound = false;
-    if(CheckScript(txout.scriptPubKey)) {
-        fFound = true;
-        if ((nFlags & BLOOM_UPDATE_MASK) == BLOOM_UPDATE_ALL)
+    if (!CheckScript(txout.scriptPubKey))
+        return false;
+    UpdateForMatchingTxOut(txout, hash, index);
+    return true;
+}
+
+void CBloomFilter::UpdateForMatchingTxOut(const CTxOut& txout, const uint256& hash, unsigned int index)
+{
+    if ((nFlags & BLOOM_UPDATE_MASK) == BLOOM_UPDATE_ALL)
+        insert(COutPoint(hash, index));
+    else if ((nFlags & BLOOM_UPDATE_MASK) == BLOOM_UPDATE_P2PUBKEY_ONLY)
+    {
+        std::vector<std::vector<unsigned char> > vSolutions;
+        TxoutType type = Solver(txout.scriptPubKey, vSolutions);
+        if (type == TxoutType::PUBKEY || type == TxoutType::MULTISIG) {
             insert(COutPoint(hash, index));
-        else if ((nFlags & BLOOM_UPDATE_MASK) == BLOOM_UPDATE_P2PUBKEY_ONLY)
-        {
-            std::vector<std::vector<unsigned char> > vSolutions;
-            TxoutType type = Solver(txout.scriptPubKey, vSolutions);
-            if (type == TxoutType::PUBKEY || type == TxoutType::MULTISIG) {
-                insert(COutPoint(hash, index));
-            }
         }
     }
-    return fFound;
 }
 
 bool CBloomFilter::IsRelevantAndUpdate(const CTransaction& tx)
@@ -233,22 +246,28 @@ bool CBloomFilter::IsRelevantAndUpdate(const CTransaction& tx)
     // Check additional matches for special transactions
     fFound = fFound || CheckSpecialTransactionMatchesAndUpdate(tx);
 
+    // The script data elements are extracted once per transaction and shared by all filters
+    // it is matched against, instead of parsing the scripts for every peer
+    const TxScriptElements& elements = tx.GetScriptElements();
     for (unsigned int i = 0; i < tx.vout.size(); i++)
     {
-        fFound = ProcessTxOut(tx.vout[i], hash, i) || fFound;
+        if (CheckElements(elements, elements.OutputElements(i))) {
+            fFound = true;
+            UpdateForMatchingTxOut(tx.vout[i], hash, i);
+        }
     }
 
     if (fFound)
         return true;
 
-    for (const CTxIn& txin : tx.vin)
+    for (unsigned int i = 0; i < tx.vin.size(); i++)
     {
         // Match if the filter contains an outpoint tx spends
-        if (contains(txin.prevout))
+        if (contains(tx.vin[i].prevout))
             return true;
 
         // Match if the filter contains any arbitrary script data element in any scriptSig in tx
-        if(CheckScript(txin.scriptSig))
+        if (CheckElements(elements, elements.InputElements(i)))
             return true;
     }
 
@@ -15,6 +15,7 @@ class CScript;
 class CTransaction;
 class CTxOut;
 class uint256;
+struct TxScriptElements;
 
 //! 20,000 items with fp rate < 0.1% or 10,000 items and <0.0001%
 static constexpr unsigned int MAX_BLOOM_FILTER_SIZE = 36000; // bytes
@@ -56,8 +57,12 @@ private:
 
     // Check matches for arbitrary script data elements
     bool CheckScript(const CScript& script) const;
+    // Check matches for a range of the script data elements of a transaction
+    bool CheckElements(const TxScriptElements& elements, std::pair<size_t, size_t> range) const;
     // Check particular CTxOut helper
     bool ProcessTxOut(const CTxOut& txout, const uint256& hash, unsigned int index);
+    // Add the outpoint of a matching CTxOut, as far as nFlags asks for it
+    void UpdateForMatchingTxOut(const CTxOut& txout, const uint256& hash, unsigned int index);
     // Check additional matches for special transactions
     bool CheckSpecialTransactionMatchesAndUpdate(const CTransaction& tx);
 public:
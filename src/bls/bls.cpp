@@ -12,6 +12,7 @@
 
 #include <cassert>
 #include <cstring>
+#include <unordered_map>
 
 namespace bls {
     std::atomic<bool> bls_legacy_scheme = std::atomic<bool>(true);
@@ -357,6 +358,50 @@ bool CBLSSignature::VerifySecureAggregated(Span<CBLSPublicKey> pks, const uint25
     }
 }
 
+/** Recoveries of a quorum mostly use the shares of the same fast members, so few sets of ids come up at all */
+static constexpr size_t MAX_CACHED_LAGRANGE_COEFFICIENTS = 512;
+
+namespace {
+struct LagrangeCoefficientsCache
+{
+    struct Hasher
+    {
+        size_t operator()(const uint256& key) const { return key.GetUint64(0); }
+    };
+
+    std::mutex mutex;
+    /** Coefficients by the hash of the ordered ids they were computed for */
+    std::unordered_map<uint256, std::shared_ptr<const std::vector<std::vector<uint8_t>>>, Hasher> coefficients;
+};
+} // namespace
+
+static std::shared_ptr<const std::vector<std::vector<uint8_t>>> GetLagrangeCoefficients(const std::vector<bls::Bytes>& ids)
+{
+    static LagrangeCoefficientsCache cache;
+
+    CHashWriter hasher(SER_GETHASH, 0);
+    for (const auto& id : ids) {
+        hasher.write(AsBytes(Span{id.begin(), id.size()}));
+    }
+    const uint256 key = hasher.GetHash();
+    {
+        std::lock_guard<std::mutex> l(cache.mutex);
+        const auto it = cache.coefficients.find(key);
+        if (it != cache.coefficients.end()) {
+            return it->second;
+        }
+    }
+
+    auto coefficients = std::make_shared<const std::vector<std::vector<uint8_t>>>(bls::Threshold::LagrangeCoefficients(ids));
+
+    std::lock_guard<std::mutex> l(cache.mutex);
+    if (cache.coefficients.size() >= MAX_CACHED_LAGRANGE_COEFFICIENTS) {
+        cache.coefficients.erase(cache.coefficients.begin());
+    }
+    cache.coefficients.emplace(key, coefficients);
+    return coefficients;
+}
+
 bool CBLSSignature::Recover(Span<CBLSSignature> sigs, Span<CBLSId> ids)
 {
     fValid = false;
@@ -380,7 +425,7 @@ bool CBLSSignature::Recover(Span<CBLSSignature> sigs, Span<CBLSId> ids)
     }
 
     try {
-        impl = bls::Threshold::SignatureRecover(sigsVec, idsVec);
+        impl = bls::Threshold::SignatureRecoverWithCoefficients(sigsVec, *GetLagrangeCoefficients(idsVec));
     } catch (...) {
         return false;
     }
@@ -392,6 +437,51 @@ bool CBLSSignature::Recover(Span<CBLSSignature> sigs, Span<CBLSId> ids)
 
 #ifndef BUILD_BITCOIN_INTERNAL
 
+/** Enough for every operator key of a full masternode list, twice over across a scheme switch */
+static constexpr size_t MAX_CACHED_PUBLIC_KEYS = 16384;
+
+namespace {
+struct PublicKeyCache
+{
+    struct Hasher
+    {
+        size_t operator()(const uint256& key) const { return key.GetUint64(0); }
+    };
+
+    std::mutex mutex;
+    /** Valid decompressed keys, by the hash of their serialization and scheme */
+    std::unordered_map<uint256, CBLSPublicKey, Hasher> keys;
+};
+} // namespace
+
+bool DecompressPublicKeyCached(Span<uint8_t> vecBytes, bool specificLegacyScheme, CBLSPublicKey& pk)
+{
+    static PublicKeyCache cache;
+
+    const std::array<uint8_t, 1> scheme{uint8_t(specificLegacyScheme)};
+    const uint256 key = Hash(vecBytes, scheme);
+    {
+        std::lock_guard<std::mutex> l(cache.mutex);
+        const auto it = cache.keys.find(key);
+        if (it != cache.keys.end()) {
+            pk = it->second;
+            return true;
+        }
+    }
+
+    pk.SetByteVector(vecBytes, specificLegacyScheme);
+    if (!pk.IsValid() || !pk.CheckMalleable(vecBytes, specificLegacyScheme)) {
+        return false;
+    }
+
+    std::lock_guard<std::mutex> l(cache.mutex);
+    if (cache.keys.size() >= MAX_CACHED_PUBLIC_KEYS) {
+        cache.keys.erase(cache.keys.begin());
+    }
+    cache.keys.emplace(key, pk);
+    return true;
+}
+
 static std::once_flag init_flag;
 static mt_pooled_secure_allocator<uint8_t>* secure_allocator_instance;
 static void create_secure_allocator()
@@ -27,6 +27,7 @@
 #include <unistd.h>
 
 #include <atomic>
+#include <type_traits>
 
 namespace bls {
     extern std::atomic<bool> bls_legacy_scheme;
@@ -179,8 +180,15 @@ public:
     template <typename Stream>
     inline void Unserialize(Stream& s, const bool specificLegacyScheme)
     {
-        std::array<uint8_t, SerSize> vecBytes{};
-        s.read(AsWritableBytes(Span{vecBytes.data(), SerSize}));
+        std::array<uint8_t, SerSize> buf{};
+        Span<const uint8_t> vecBytes;
+        if constexpr (has_read_view<Stream>::value) {
+            // Parse the object straight from the buffer of the stream
+            vecBytes = UCharSpanCast(s.ReadView(SerSize));
+        } else {
+            s.read(AsWritableBytes(Span{buf}));
+            vecBytes = buf;
+        }
         SetByteVector(vecBytes, specificLegacyScheme);
 
         if (!CheckMalleable(vecBytes, specificLegacyScheme)) {
@@ -204,7 +212,7 @@ public:
         Unserialize(s, bls::bls_legacy_scheme.load());
     }
 
-    inline bool CheckMalleable(Span<uint8_t> vecBytes, const bool specificLegacyScheme) const
+    inline bool CheckMalleable(Span<const uint8_t> vecBytes, const bool specificLegacyScheme) const
     {
         if (memcmp(vecBytes.data(), ToByteVector(specificLegacyScheme).data(), SerSize)) {
             // TODO not sure if this is actually possible with the BLS libs. I'm assuming here that somewhere deep inside
@@ -215,7 +223,7 @@ public:
         return true;
     }
 
-    inline bool CheckMalleable(Span<uint8_t> vecBytes) const
+    inline bool CheckMalleable(Span<const uint8_t> vecBytes) const
     {
         return CheckMalleable(vecBytes, bls::bls_legacy_scheme.load());
     }
@@ -390,6 +398,14 @@ public:
 };
 
 #ifndef BUILD_BITCOIN_INTERNAL
+/**
+ * Decompress the public key serialized in vecBytes into pk. Decompressed keys are interned in a
+ * bounded process-wide cache, so every lazy copy of the same operator key (one per deserialized
+ * masternode list, quorum member list or mnauth) pays for the point decompression only once.
+ * Returns false if vecBytes is not a valid, non-malleable key in the given scheme.
+ */
+bool DecompressPublicKeyCached(Span<uint8_t> vecBytes, bool specificLegacyScheme, CBLSPublicKey& pk);
+
 template<typename BLSObject>
 class CBLSLazyWrapper
 {
@@ -499,14 +515,21 @@ public:
             return invalidObj;
         }
         if (!objInitialized) {
-            obj.SetByteVector(vecBytes, bufLegacyScheme);
-            if (!obj.IsValid()) {
-                bufValid = false;
-                return invalidObj;
-            }
-            if (!obj.CheckMalleable(vecBytes, bufLegacyScheme)) {
-                bufValid = false;
-                return invalidObj;
+            if constexpr (std::is_same_v<BLSObject, CBLSPublicKey>) {
+                if (!DecompressPublicKeyCached(vecBytes, bufLegacyScheme, obj)) {
+                    bufValid = false;
+                    return invalidObj;
+                }
+            } else {
+                obj.SetByteVector(vecBytes, bufLegacyScheme);
+                if (!obj.IsValid()) {
+                    bufValid = false;
+                    return invalidObj;
+                }
+                if (!obj.CheckMalleable(vecBytes, bufLegacyScheme)) {
+                    bufValid = false;
+                    return invalidObj;
+                }
             }
             objInitialized = true;
         }
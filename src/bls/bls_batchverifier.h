@@ -6,8 +6,13 @@
 #define MAXIMUS_CRYPTO_BLS_BATCHVERIFIER_H
 
 #include <bls/bls.h>
+#include <bls/bls_sigcache.h>
+#include <bls/bls_worker.h>
 
+#include <algorithm>
+#include <future>
 #include <map>
+#include <set>
 #include <vector>
 
 template<typename SourceId, typename MessageId>
@@ -24,10 +29,21 @@ private:
     using MessageMap = std::map<MessageId, Message>;
     using MessageMapIterator = typename MessageMap::iterator;
     using MessagesBySourceMap = std::map<SourceId, std::vector<MessageMapIterator>>;
+    using ByMessageHashMap = std::map<uint256, std::vector<MessageMapIterator>>;
+
+    // Number of messages a batch must at least have per worker job before it is split up
+    static constexpr size_t PARALLEL_CHUNK_SIZE = 16;
 
     bool secureVerification;
     bool perMessageFallback;
     size_t subBatchSize;
+    // Skip messages found in the BLS signature cache, and add the ones verified on their own here.
+    // Aggregated verification doesn't prove each signature valid (errors can cancel out between
+    // messages), so messages only ever validated as part of a larger batch are not cached.
+    bool useSigCache;
+    // When set, the pairings of large batches, the per-source and the per-message fallback are spread
+    // over the worker threads. Verify() then waits for worker jobs and must not run on a worker thread.
+    CBLSWorker* worker;
 
     MessageMap messages;
     MessagesBySourceMap messagesBySource;
@@ -37,10 +53,13 @@ public:
     std::set<MessageId> badMessages;
 
 public:
-    CBLSBatchVerifier(bool _secureVerification, bool _perMessageFallback, size_t _subBatchSize = 0) :
+    CBLSBatchVerifier(bool _secureVerification, bool _perMessageFallback, size_t _subBatchSize = 0, bool _useSigCache = false,
+                      CBLSWorker* _worker = nullptr) :
             secureVerification(_secureVerification),
             perMessageFallback(_perMessageFallback),
-            subBatchSize(_subBatchSize)
+            subBatchSize(_subBatchSize),
+            useSigCache(_useSigCache),
+            worker(_worker)
     {
     }
 
@@ -48,6 +67,11 @@ public:
     {
         assert(sig.IsValid() && pubKey.IsValid());
 
+        if (useSigCache && BLSSigCacheContains(pubKey, msgHash, sig)) {
+            // verified before, nothing to batch
+            return;
+        }
+
         auto it = messages.emplace(msgId, Message{msgId, msgHash, sig, pubKey}).first;
         messagesBySource[sourceId].emplace_back(it);
 
@@ -70,60 +94,141 @@ public:
 
     void Verify()
     {
-        std::map<uint256, std::vector<MessageMapIterator>> byMessageHash;
+        ByMessageHashMap byMessageHash;
 
         for (auto it = messages.begin(); it != messages.end(); ++it) {
             byMessageHash[it->second.msgHash].emplace_back(it);
         }
 
-        if (VerifyBatch(byMessageHash)) {
+        if (VerifyBatchParallel(byMessageHash)) {
             // full batch is valid
+            if (messages.size() == 1) {
+                AddToSigCache(messages.begin()->second);
+            }
             return;
         }
 
-        // revert to per-source verification
+        // revert to per-source verification, no need to verify it again if there was just one source
+        std::vector<std::pair<const SourceId*, const std::vector<MessageMapIterator>*>> sources;
+        sources.reserve(messagesBySource.size());
         for (const auto& p : messagesBySource) {
-            bool batchValid = false;
-
-            // no need to verify it again if there was just one source
-            if (messagesBySource.size() != 1) {
-                byMessageHash.clear();
-                for (auto it = p.second.begin(); it != p.second.end(); ++it) {
-                    byMessageHash[(*it)->second.msgHash].emplace_back(*it);
+            sources.emplace_back(&p.first, &p.second);
+        }
+        const std::vector<bool> sourcesValid = messagesBySource.size() == 1 ? std::vector<bool>{false} : RunJobs(sources.size(), [&](size_t i) {
+            ByMessageHashMap sourceByMessageHash;
+            for (const auto& msgIt : *sources[i].second) {
+                sourceByMessageHash[msgIt->second.msgHash].emplace_back(msgIt);
+            }
+            return VerifyBatch(sourceByMessageHash);
+        });
+
+        std::vector<const Message*> toVerify;
+        std::set<MessageId> queued;
+        for (size_t i = 0; i < sources.size(); ++i) {
+            const auto& msgIts = *sources[i].second;
+            if (sourcesValid[i]) {
+                if (msgIts.size() == 1) {
+                    AddToSigCache(msgIts[0]->second);
                 }
-                batchValid = VerifyBatch(byMessageHash);
+                continue;
             }
-            if (!batchValid) {
-                badSources.emplace(p.first);
-
-                if (perMessageFallback) {
-                    // revert to per-message verification
-                    if (p.second.size() == 1) {
-                        // no need to re-verify a single message
-                        badMessages.emplace(p.second[0]->second.msgId);
-                    } else {
-                        for (const auto& msgIt : p.second) {
-                            if (badMessages.count(msgIt->first)) {
-                                // same message might be invalid from different source, so no need to re-verify it
-                                continue;
-                            }
-
-                            const auto& msg = msgIt->second;
-                            if (!msg.sig.VerifyInsecure(msg.pubKey, msg.msgHash)) {
-                                badMessages.emplace(msg.msgId);
-                            }
+
+            badSources.emplace(*sources[i].first);
+
+            if (perMessageFallback) {
+                // revert to per-message verification
+                if (msgIts.size() == 1) {
+                    // no need to re-verify a single message
+                    badMessages.emplace(msgIts[0]->second.msgId);
+                } else {
+                    for (const auto& msgIt : msgIts) {
+                        // same message might be invalid from different source, so verify it only once
+                        if (queued.emplace(msgIt->first).second) {
+                            toVerify.emplace_back(&msgIt->second);
                         }
                     }
                 }
             }
         }
+
+        // skip what a single-message source just proved invalid
+        toVerify.erase(std::remove_if(toVerify.begin(), toVerify.end(), [this](const Message* msg) {
+            return badMessages.count(msg->msgId) != 0;
+        }), toVerify.end());
+        const std::vector<bool> messagesValid = RunJobs(toVerify.size(), [&](size_t i) {
+            return toVerify[i]->sig.VerifyInsecure(toVerify[i]->pubKey, toVerify[i]->msgHash);
+        });
+        for (size_t i = 0; i < toVerify.size(); ++i) {
+            if (messagesValid[i]) {
+                AddToSigCache(*toVerify[i]);
+            } else {
+                badMessages.emplace(toVerify[i]->msgId);
+            }
+        }
     }
 
 private:
+    // Runs job(0) ... job(count - 1), spread over the worker threads if there is a worker
+    template <typename F>
+    std::vector<bool> RunJobs(size_t count, const F& job) const
+    {
+        std::vector<bool> results(count);
+        if (worker == nullptr || count < 2) {
+            for (size_t i = 0; i < count; ++i) {
+                results[i] = job(i);
+            }
+            return results;
+        }
+
+        std::vector<std::future<bool>> futures;
+        futures.reserve(count - 1);
+        for (size_t i = 1; i < count; ++i) {
+            futures.emplace_back(worker->AsyncRun([&job, i] { return job(i); }));
+        }
+        results[0] = job(0);
+        for (size_t i = 1; i < count; ++i) {
+            results[i] = futures[i - 1].get();
+        }
+        return results;
+    }
+
+    // Verifies the batch in chunks of whole message hashes, one per worker job. Each chunk is a subset of the batch, so
+    // aggregating within it keeps the guarantees of VerifyBatch. It only costs one more pairing and final
+    // exponentiation per chunk, as the pairings of a chunk are still computed together.
+    bool VerifyBatchParallel(ByMessageHashMap& byMessageHash)
+    {
+        if (worker == nullptr || messages.size() < 2 * PARALLEL_CHUNK_SIZE) {
+            return VerifyBatch(byMessageHash);
+        }
+
+        std::vector<ByMessageHashMap> chunks(1);
+        size_t chunkMessages = 0;
+        for (auto& p : byMessageHash) {
+            if (chunkMessages >= PARALLEL_CHUNK_SIZE) {
+                chunks.emplace_back();
+                chunkMessages = 0;
+            }
+            chunkMessages += p.second.size();
+            chunks.back().emplace(p.first, std::move(p.second));
+        }
+
+        const std::vector<bool> chunksValid = RunJobs(chunks.size(), [&](size_t i) {
+            return VerifyBatch(chunks[i]);
+        });
+        return std::all_of(chunksValid.begin(), chunksValid.end(), [](bool valid) { return valid; });
+    }
+
+    void AddToSigCache(const Message& msg) const
+    {
+        if (useSigCache) {
+            BLSSigCacheAdd(msg.pubKey, msg.msgHash, msg.sig);
+        }
+    }
+
     // All Verify methods take ownership of the passed byMessageHash map and thus might modify the map. This is to avoid
     // unnecessary copies
 
-    bool VerifyBatch(std::map<uint256, std::vector<MessageMapIterator>>& byMessageHash)
+    bool VerifyBatch(ByMessageHashMap& byMessageHash) const
     {
         if (secureVerification) {
             return VerifyBatchSecure(byMessageHash);
@@ -132,7 +237,7 @@ private:
         }
     }
 
-    bool VerifyBatchInsecure(const std::map<uint256, std::vector<MessageMapIterator>>& byMessageHash)
+    bool VerifyBatchInsecure(const ByMessageHashMap& byMessageHash) const
     {
         CBLSSignature aggSig;
         std::vector<uint256> msgHashes;
@@ -183,7 +288,7 @@ private:
         return aggSig.VerifyInsecureAggregated(pubKeys, msgHashes);
     }
 
-    bool VerifyBatchSecure(std::map<uint256, std::vector<MessageMapIterator>>& byMessageHash)
+    bool VerifyBatchSecure(ByMessageHashMap& byMessageHash) const
     {
         // Loop until the byMessageHash map is empty, which means that all messages were verified
         // The secure form of verification will only aggregate one message for the same message hash, even if multiple
@@ -197,7 +302,7 @@ private:
         return true;
     }
 
-    bool VerifyBatchSecureStep(std::map<uint256, std::vector<MessageMapIterator>>& byMessageHash)
+    bool VerifyBatchSecureStep(ByMessageHashMap& byMessageHash) const
     {
         CBLSSignature aggSig;
         std::vector<uint256> msgHashes;
@@ -0,0 +1,133 @@
+// Copyright (c) 2024 The Maximus developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <bls/bls_sigcache.h>
+
+#include <crypto/sha256.h>
+#include <cuckoocache.h>
+#include <logging.h>
+#include <random.h>
+#include <util/hasher.h>
+#include <util/system.h>
+
+#include <algorithm>
+#include <mutex>
+#include <shared_mutex>
+#include <vector>
+
+namespace {
+/** Kinds of verification an entry can stand for */
+enum class VerifyKind : uint8_t {
+    INSECURE = 0,
+    SECURE_AGGREGATED = 1,
+};
+
+class CBLSSignatureCache
+{
+private:
+    //! Entries are SHA256(nonce || kind || scheme || message hash || public key(s) || signature)
+    CSHA256 m_salted_hasher;
+    typedef CuckooCache::cache<uint256, SignatureCacheHasher> map_type;
+    map_type setValid;
+    std::shared_mutex cs_sigcache;
+
+public:
+    CBLSSignatureCache()
+    {
+        // See CSignatureCache: a 64 byte nonce makes later hash computations more efficient
+        uint256 nonce = GetRandHash();
+        m_salted_hasher.Write(nonce.begin(), 32);
+        m_salted_hasher.Write(nonce.begin(), 32);
+    }
+
+    uint256 ComputeEntry(VerifyKind kind, const uint256& hash, Span<const CBLSPublicKey> pks, const CBLSSignature& sig) const
+    {
+        // Serialize with the scheme the verification is done under, which is part of the entry as well
+        const bool legacy = bls::bls_legacy_scheme.load();
+        const uint8_t header[2] = {static_cast<uint8_t>(kind), static_cast<uint8_t>(legacy)};
+        CSHA256 hasher = m_salted_hasher;
+        hasher.Write(header, sizeof(header)).Write(hash.begin(), 32);
+        for (const CBLSPublicKey& pk : pks) {
+            const std::vector<uint8_t> vch = pk.ToByteVector(legacy);
+            hasher.Write(vch.data(), vch.size());
+        }
+        const std::vector<uint8_t> vchSig = sig.ToByteVector(legacy);
+        hasher.Write(vchSig.data(), vchSig.size());
+        uint256 entry;
+        hasher.Finalize(entry.begin());
+        return entry;
+    }
+
+    bool Get(const uint256& entry)
+    {
+        std::shared_lock<std::shared_mutex> lock(cs_sigcache);
+        return setValid.contains(entry, false);
+    }
+
+    void Set(const uint256& entry)
+    {
+        std::unique_lock<std::shared_mutex> lock(cs_sigcache);
+        setValid.insert(entry);
+    }
+
+    uint32_t setup_bytes(size_t n)
+    {
+        return setValid.setup_bytes(n);
+    }
+};
+
+static CBLSSignatureCache blsSignatureCache;
+} // namespace
+
+// To be called once in AppInitMain/BasicTestingSetup to initialize the
+// blsSignatureCache.
+void InitBLSSignatureCache()
+{
+    size_t nMaxCacheSize = std::min(std::max((int64_t)0, gArgs.GetArg("-blssigcachesize", DEFAULT_BLS_SIG_CACHE_SIZE)), MAX_BLS_SIG_CACHE_SIZE) * ((size_t) 1 << 20);
+    size_t nElems = blsSignatureCache.setup_bytes(nMaxCacheSize);
+    LogPrintf("Using %zu MiB out of %zu requested for BLS signature cache, able to store %zu elements\n",
+            (nElems*sizeof(uint256)) >>20, nMaxCacheSize>>20, nElems);
+}
+
+bool BLSSigCacheContains(const CBLSPublicKey& pubKey, const uint256& hash, const CBLSSignature& sig)
+{
+    return blsSignatureCache.Get(blsSignatureCache.ComputeEntry(VerifyKind::INSECURE, hash, Span{&pubKey, 1}, sig));
+}
+
+void BLSSigCacheAdd(const CBLSPublicKey& pubKey, const uint256& hash, const CBLSSignature& sig)
+{
+    blsSignatureCache.Set(blsSignatureCache.ComputeEntry(VerifyKind::INSECURE, hash, Span{&pubKey, 1}, sig));
+}
+
+bool VerifyInsecureCached(const CBLSSignature& sig, const CBLSPublicKey& pubKey, const uint256& hash)
+{
+    if (!sig.IsValid() || !pubKey.IsValid()) {
+        return false;
+    }
+    const uint256 entry = blsSignatureCache.ComputeEntry(VerifyKind::INSECURE, hash, Span{&pubKey, 1}, sig);
+    if (blsSignatureCache.Get(entry)) {
+        return true;
+    }
+    if (!sig.VerifyInsecure(pubKey, hash)) {
+        return false;
+    }
+    blsSignatureCache.Set(entry);
+    return true;
+}
+
+bool VerifySecureAggregatedCached(const CBLSSignature& sig, Span<CBLSPublicKey> pks, const uint256& hash)
+{
+    if (pks.empty() || !sig.IsValid()) {
+        return false;
+    }
+    const uint256 entry = blsSignatureCache.ComputeEntry(VerifyKind::SECURE_AGGREGATED, hash, pks, sig);
+    if (blsSignatureCache.Get(entry)) {
+        return true;
+    }
+    if (!sig.VerifySecureAggregated(pks, hash)) {
+        return false;
+    }
+    blsSignatureCache.Set(entry);
+    return true;
+}
@@ -0,0 +1,34 @@
+// Copyright (c) 2024 The Maximus developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef MAXIMUS_CRYPTO_BLS_SIGCACHE_H
+#define MAXIMUS_CRYPTO_BLS_SIGCACHE_H
+
+#include <bls/bls.h>
+#include <span.h>
+
+#include <cstdint>
+
+// Default for -blssigcachesize, in MiB
+static const unsigned int DEFAULT_BLS_SIG_CACHE_SIZE = 8;
+// Maximum -blssigcachesize allowed
+static const int64_t MAX_BLS_SIG_CACHE_SIZE = 16384;
+
+/**
+ * Valid BLS signature cache, shared by the mempool, block and LLMQ paths so that a
+ * (public key, message hash, signature) triple already found valid under the current
+ * scheme isn't verified again, e.g. when the same ISLOCK comes in from several peers or
+ * a ProTx is checked on mempool and on block acceptance. Only valid results are kept.
+ */
+void InitBLSSignatureCache();
+
+bool BLSSigCacheContains(const CBLSPublicKey& pubKey, const uint256& hash, const CBLSSignature& sig);
+void BLSSigCacheAdd(const CBLSPublicKey& pubKey, const uint256& hash, const CBLSSignature& sig);
+
+/** CBLSSignature::VerifyInsecure() going through the cache */
+bool VerifyInsecureCached(const CBLSSignature& sig, const CBLSPublicKey& pubKey, const uint256& hash);
+/** CBLSSignature::VerifySecureAggregated() going through the cache */
+bool VerifySecureAggregatedCached(const CBLSSignature& sig, Span<CBLSPublicKey> pks, const uint256& hash);
+
+#endif // MAXIMUS_CRYPTO_BLS_SIGCACHE_H
@@ -8,6 +8,8 @@
 
 #include <util/ranges.h>
 #include <util/system.h>
+#include <util/threadbudget.h>
+#include <version.h>
 
 #include <memory>
 #include <utility>
@@ -59,9 +61,7 @@ CBLSWorker::~CBLSWorker()
 
 void CBLSWorker::Start()
 {
-    int workerCount = std::thread::hardware_concurrency() / 2;
-    workerCount = std::max(std::min(1, workerCount), 4);
-    workerPool.resize(workerCount);
+    workerPool.resize(GetThreadBudget(TaskPriority::LLMQ, 4));
     RenameThreadPool(workerPool, "bls-work");
 }
 
@@ -71,6 +71,17 @@ void CBLSWorker::Stop()
     workerPool.stop(true);
 }
 
+size_t CBLSWorker::GetQueueDepth()
+{
+    return workerPool.queue_size();
+}
+
+size_t CBLSWorker::GetSigVerifyQueueDepth()
+{
+    std::unique_lock<std::mutex> l(sigVerifyMutex);
+    return sigVerifyQueue.size();
+}
+
 bool CBLSWorker::GenerateContributions(int quorumThreshold, Span<CBLSId> ids, BLSVerificationVectorPtr& vvecRet, std::vector<CBLSSecretKey>& skSharesRet)
 {
     auto svec = std::vector<CBLSSecretKey>((size_t)quorumThreshold);
@@ -114,6 +125,36 @@ bool CBLSWorker::GenerateContributions(int quorumThreshold, Span<CBLSId> ids, BL
     });
 }
 
+bool CBLSWorker::DecryptContributions(Span<const CBLSIESEncryptedObject<CBLSSecretKey>> vecEncrypted, size_t idx,
+                                      const CBLSSecretKey& secretKey, std::vector<CBLSSecretKey>& skContributionsRet)
+{
+    skContributionsRet.resize(vecEncrypted.size());
+
+    size_t batchSize = 8;
+    std::vector<std::future<bool>> futures;
+    futures.reserve(vecEncrypted.size() / batchSize + 1);
+
+    for (size_t i = 0; i < vecEncrypted.size(); i += batchSize) {
+        size_t start = i;
+        size_t count = std::min(batchSize, vecEncrypted.size() - start);
+        auto f = [&, start, count](int threadId) {
+            for (size_t j = start; j < start + count; j++) {
+                if (!vecEncrypted[j].Decrypt(idx, secretKey, skContributionsRet[j], PROTOCOL_VERSION)) {
+                    return false;
+                }
+            }
+            return true;
+        };
+        futures.emplace_back(workerPool.push(f));
+    }
+    // wait for all of them, the lambdas reference the arguments
+    bool ret{true};
+    for (auto& f : futures) {
+        ret &= f.get();
+    }
+    return ret;
+}
+
 // aggregates a single vector of BLS objects in parallel
 // the input vector is split into batches and each batch is aggregated in parallel
 // when enough batches are finished to form a new batch, the new batch is queued for further parallel aggregation
@@ -6,6 +6,7 @@
 #define MAXIMUS_CRYPTO_BLS_WORKER_H
 
 #include <bls/bls.h>
+#include <bls/bls_ies.h>
 
 #include <ctpl_stl.h>
 
@@ -55,8 +56,17 @@ public:
     void Start();
     void Stop();
 
+    //! Jobs waiting for a worker thread and signature verifications waiting to be batched
+    size_t GetQueueDepth();
+    size_t GetSigVerifyQueueDepth();
+
     bool GenerateContributions(int threshold, Span<CBLSId> ids, BLSVerificationVectorPtr& vvecRet, std::vector<CBLSSecretKey>& skSharesRet);
 
+    // Decrypts the contributions sent to the member at idx in batches on the worker threads,
+    // returns false if any of them fails to decrypt
+    bool DecryptContributions(Span<const CBLSIESEncryptedObject<CBLSSecretKey>> vecEncrypted, size_t idx,
+                              const CBLSSecretKey& secretKey, std::vector<CBLSSecretKey>& skContributionsRet);
+
     // The following functions are all used to aggregate verification (public key) vectors
     // Inputs are in the following form:
     //   [
@@ -111,6 +121,14 @@ public:
 
     std::future<bool> AsyncVerifyContributionShare(const CBLSId& forId, const BLSVerificationVectorPtr& vvec, const CBLSSecretKey& skContribution);
 
+    // Runs f on the worker pool. Used to move preparatory work (e.g. decrypting received contributions) off the
+    // calling thread. f may start any of the async functions above, but must not wait for them
+    template <typename F>
+    auto AsyncRun(F&& f)
+    {
+        return workerPool.push([f = std::forward<F>(f)](int threadId) mutable { return f(); });
+    }
+
     // Simple verification of vectors. Checks x.IsValid() for every entry and checks for duplicate entries
     static bool VerifyVerificationVector(Span<CBLSPublicKey> vvec);
     static bool VerifyVerificationVectors(Span<BLSVerificationVectorPtr> vvecs);
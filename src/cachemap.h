@@ -5,10 +5,14 @@
 #ifndef BITCOIN_CACHEMAP_H
 #define BITCOIN_CACHEMAP_H
 
-#include <map>
-#include <list>
 #include <cstddef>
+#include <functional>
+#include <iterator>
+#include <list>
+#include <type_traits>
+#include <unordered_map>
 
+#include <memusage.h>
 #include <serialize.h>
 
 /**
@@ -37,8 +41,12 @@ struct CacheItem
 
 /**
  * Map like container that keeps the N most recently added items
+ *
+ * Items are kept in a list ordered from the most to the least recently added one and indexed by a hash map. Once
+ * the container is full, inserting reuses the list and index nodes of the evicted item, so a full cache of assignable
+ * values does not allocate.
  */
-template<typename K, typename V, typename Size = uint32_t>
+template<typename K, typename V, typename Size = uint32_t, typename Hash = std::hash<K>>
 class CacheMap
 {
 public:
@@ -52,7 +60,7 @@ public:
 
     using list_cit = typename list_t::const_iterator;
 
-    using map_t = std::map<K, list_it>;
+    using map_t = std::unordered_map<K, list_it, Hash>;
 
     using map_it = typename map_t::iterator;
 
@@ -72,7 +80,7 @@ public:
           mapIndex()
     {}
 
-    explicit CacheMap(const CacheMap<K,V>& other)
+    explicit CacheMap(const CacheMap& other)
         : nMaxSize(other.nMaxSize),
           listItems(other.listItems),
           mapIndex()
@@ -99,13 +107,31 @@ public:
         return listItems.size();
     }
 
+    /** Memory used by the items and the index, not counting what keys and values allocate themselves */
+    size_t DynamicMemoryUsage() const {
+        return memusage::DynamicUsage(listItems) + memusage::DynamicUsage(mapIndex);
+    }
+
     bool Insert(const K& key, const V& value)
     {
         if(mapIndex.find(key) != mapIndex.end()) {
             return false;
         }
-        if(listItems.size() == nMaxSize) {
-            PruneLast();
+        if(!listItems.empty() && listItems.size() == nMaxSize) {
+            if constexpr (std::is_copy_assignable_v<V>) {
+                // Recycle the nodes of the least recently added item for the new one
+                list_it lit = std::prev(listItems.end());
+                auto node = mapIndex.extract(lit->key);
+                lit->key = key;
+                lit->value = value;
+                listItems.splice(listItems.begin(), listItems, lit);
+                node.key() = key;
+                node.mapped() = lit;
+                mapIndex.insert(std::move(node));
+                return true;
+            } else {
+                PruneLast();
+            }
         }
         listItems.push_front(item_t(key, value));
         mapIndex.emplace(key, listItems.begin());
@@ -142,7 +168,7 @@ public:
         return listItems;
     }
 
-    CacheMap<K,V>& operator=(const CacheMap<K,V>& other)
+    CacheMap& operator=(const CacheMap& other)
     {
         nMaxSize = other.nMaxSize;
         listItems = other.listItems;
@@ -170,6 +196,7 @@ private:
     void RebuildIndex()
     {
         mapIndex.clear();
+        mapIndex.reserve(listItems.size());
         for(list_it it = listItems.begin(); it != listItems.end(); ++it) {
             mapIndex.emplace(it->key, it);
         }
@@ -6,18 +6,25 @@
 #define BITCOIN_CACHEMULTIMAP_H
 
 #include <cstddef>
-#include <map>
+#include <functional>
+#include <iterator>
 #include <list>
-#include <set>
+#include <map>
+#include <type_traits>
+#include <unordered_map>
 
+#include <memusage.h>
 #include <serialize.h>
 
 #include <cachemap.h>
 
 /**
  * Map like container that keeps the N most recently added items
+ *
+ * Like CacheMap, keys are indexed by a hash map and a full container of assignable values reuses the list node of the
+ * evicted item.
  */
-template<typename K, typename V, typename Size = uint32_t>
+template<typename K, typename V, typename Size = uint32_t, typename Hash = std::hash<K>>
 class CacheMultiMap
 {
 public:
@@ -37,7 +44,7 @@ public:
 
     using it_map_cit = typename it_map_t::const_iterator;
 
-    using map_t = std::map<K, it_map_t>;
+    using map_t = std::unordered_map<K, it_map_t, Hash>;
 
     using map_it = typename map_t::iterator;
 
@@ -57,7 +64,7 @@ public:
           mapIndex()
     {}
 
-    explicit CacheMultiMap(const CacheMap<K,V>& other)
+    explicit CacheMultiMap(const CacheMultiMap& other)
         : nMaxSize(other.nMaxSize),
           listItems(other.listItems),
           mapIndex()
@@ -84,24 +91,47 @@ public:
         return listItems.size();
     }
 
+    /** Memory used by the items and the index, not counting what keys and values allocate themselves */
+    size_t DynamicMemoryUsage() const {
+        size_t nUsage = memusage::DynamicUsage(listItems) + memusage::DynamicUsage(mapIndex);
+        for (const auto& [_, mapIt] : mapIndex) {
+            nUsage += memusage::DynamicUsage(mapIt);
+        }
+        return nUsage;
+    }
+
     bool Insert(const K& key, const V& value)
     {
         map_it mit = mapIndex.find(key);
-        if(mit == mapIndex.end()) {
-            mit = mapIndex.emplace(key, it_map_t()).first;
-        }
-        it_map_t& mapIt = mit->second;
-
-        if(mapIt.count(value) > 0) {
+        if(mit != mapIndex.end() && mit->second.count(value) > 0) {
             // Don't insert duplicates
             return false;
         }
 
-        if(listItems.size() == nMaxSize) {
-            PruneLast();
+        bool fRecycled{false};
+        if(!listItems.empty() && listItems.size() == nMaxSize) {
+            // Evicting may drop the index entry of key, so look it up again below
+            list_it lit = std::prev(listItems.end());
+            EraseIndex(*lit);
+            if constexpr (std::is_copy_assignable_v<V>) {
+                // Recycle the list node of the least recently added item for the new one
+                lit->key = key;
+                lit->value = value;
+                listItems.splice(listItems.begin(), listItems, lit);
+                fRecycled = true;
+            } else {
+                listItems.erase(lit);
+            }
         }
-        listItems.push_front(item_t(key, value));
-        mapIt.emplace(value, listItems.begin());
+        if(!fRecycled) {
+            listItems.push_front(item_t(key, value));
+        }
+
+        mit = mapIndex.find(key);
+        if(mit == mapIndex.end()) {
+            mit = mapIndex.emplace(key, it_map_t()).first;
+        }
+        mit->second.emplace(value, listItems.begin());
         return true;
     }
 
@@ -184,7 +214,7 @@ public:
         return listItems;
     }
 
-    CacheMap<K,V>& operator=(const CacheMap<K,V>& other)
+    CacheMultiMap& operator=(const CacheMultiMap& other)
     {
         nMaxSize = other.nMaxSize;
         listItems = other.listItems;
@@ -199,16 +229,8 @@ public:
     }
 
 private:
-    void PruneLast()
+    void EraseIndex(const item_t& item)
     {
-        if(listItems.empty()) {
-            return;
-        }
-
-        list_it lit = listItems.end();
-        --lit;
-        item_t& item = *lit;
-
         map_it mit = mapIndex.find(item.key);
 
         if(mit != mapIndex.end()) {
@@ -217,16 +239,15 @@ private:
             mapIt.erase(item.value);
 
             if(mapIt.empty()) {
-                mapIndex.erase(item.key);
+                mapIndex.erase(mit);
             }
         }
-
-        listItems.pop_back();
     }
 
     void RebuildIndex()
     {
         mapIndex.clear();
+        mapIndex.reserve(listItems.size());
         for(list_it lit = listItems.begin(); lit != listItems.end(); ++lit) {
             item_t& item = *lit;
             map_it mit = mapIndex.find(item.key);
@@ -48,6 +48,11 @@ struct AssumeutxoData {
     //! We need to hardcode the value here because this is computed cumulatively using block data,
     //! which we do not necessarily have at the time of snapshot load.
     const unsigned int nChainTx;
+
+    //! The expected hash of the evo database section, not checked when null. The masternode
+    //! list, quorum and credit pool commitments of the coinbases after the base are checked
+    //! against the imported state either way.
+    const uint256 hash_evodb{};
 };
 
 using MapAssumeutxo = std::map<int, const AssumeutxoData>;
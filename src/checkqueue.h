@@ -10,6 +10,10 @@
 #include <util/threadnames.h>
 
 #include <algorithm>
+#include <atomic>
+#include <deque>
+#include <memory>
+#include <string>
 #include <vector>
 
 template <typename T>
@@ -24,12 +28,31 @@ class CCheckQueueControl;
   * onto the queue, where they are processed by N-1 worker threads. When
   * the master is done adding work, it temporarily joins the worker pool
   * as an N'th worker, until all jobs are done.
+  *
+  * Every worker has a queue of its own which the added checks are spread
+  * over, workers which run out of checks steal from the others. The shared
+  * mutex is only taken to sleep and to wake up sleeping threads.
   */
 template <typename T>
 class CCheckQueue
 {
 private:
-    //! Mutex to protect the inner state
+    /**
+     * Checks waiting for one of the workers. The owner takes its batches from the back, other
+     * workers that ran out of checks steal from the front.
+     */
+    struct WorkerQueue {
+        Mutex m_mutex;
+        std::deque<T> checks GUARDED_BY(m_mutex);
+    };
+
+    //! One queue per worker thread (at least one), the master only steals from them
+    std::vector<std::unique_ptr<WorkerQueue>> m_queues;
+
+    //! Queue the next Add starts distributing its checks to, only used by the master
+    size_t m_next_queue{0};
+
+    //! Mutex to protect the state that workers and the master sleep on
     Mutex m_mutex;
 
     //! Worker threads block on this when out of work
@@ -38,25 +61,25 @@ private:
     //! Master thread blocks on this when out of work
     std::condition_variable m_master_cv;
 
-    //! The queue of elements to be processed.
-    //! As the order of booleans doesn't matter, it is used as a LIFO (stack)
-    std::vector<T> queue GUARDED_BY(m_mutex);
+    /**
+     * Number of checks in the worker queues. Only increased under m_mutex, so that workers
+     * checking it under m_mutex before they sleep can't miss new checks. It can be briefly
+     * behind while a thief takes the checks of an Add which is still in progress.
+     */
+    std::atomic<int64_t> m_queued{0};
 
-    //! The number of workers (including the master) that are idle.
+    //! The number of workers (excluding the master) that are sleeping.
     int nIdle GUARDED_BY(m_mutex){0};
 
-    //! The total number of workers (including the master).
-    int nTotal GUARDED_BY(m_mutex){0};
-
     //! The temporary evaluation result.
-    bool fAllOk GUARDED_BY(m_mutex){true};
+    std::atomic<bool> m_all_ok{true};
 
     /**
      * Number of verifications that haven't completed yet.
      * This includes elements that are no longer queued, but still in the
      * worker's own batches.
      */
-    unsigned int nTodo GUARDED_BY(m_mutex){0};
+    std::atomic<int64_t> m_todo{0};
 
     //! The maximum number of elements to be processed in one batch
     const unsigned int nBatchSize;
@@ -64,68 +87,92 @@ private:
     std::vector<std::thread> m_worker_threads;
     bool m_request_stop GUARDED_BY(m_mutex){false};
 
+    /**
+     * Move checks of one of the queues into batch. Batches are half of what is left in the
+     * queue, capped at nBatchSize, so they shrink towards the end and a thief takes enough to
+     * even out the work of a block with a few expensive transactions.
+     */
+    bool TakeBatch(size_t index, bool own, std::vector<T>& batch)
+    {
+        WorkerQueue& queue = *m_queues[index];
+        LOCK(queue.m_mutex);
+        if (queue.checks.empty()) {
+            return false;
+        }
+        const size_t count = std::max<size_t>(1, std::min<size_t>(nBatchSize, queue.checks.size() / 2));
+        batch.resize(count);
+        for (T& check : batch) {
+            // Swap the jobs into the batch instead of copying
+            if (own) {
+                check.swap(queue.checks.back());
+                queue.checks.pop_back();
+            } else {
+                check.swap(queue.checks.front());
+                queue.checks.pop_front();
+            }
+        }
+        m_queued -= count;
+        return true;
+    }
+
+    /** Take a batch from the home queue, or steal one from the next queue that has checks. */
+    bool FindBatch(size_t home, std::vector<T>& batch)
+    {
+        for (size_t i = 0; i < m_queues.size(); ++i) {
+            if (TakeBatch((home + i) % m_queues.size(), i == 0, batch)) {
+                return true;
+            }
+        }
+        return false;
+    }
+
     /** Internal function that does bulk of the verification work. */
-    bool Loop(bool fMaster)
+    bool Loop(bool fMaster, size_t home)
     {
-        std::condition_variable& cond = fMaster ? m_master_cv : m_worker_cv;
         std::vector<T> vChecks;
         vChecks.reserve(nBatchSize);
-        unsigned int nNow = 0;
-        bool fOk = true;
-        do {
-            {
-                WAIT_LOCK(m_mutex, lock);
-                // first do the clean-up of the previous loop run (allowing us to do it in the same critsect)
-                if (nNow) {
-                    fAllOk &= fOk;
-                    nTodo -= nNow;
-                    if (nTodo == 0 && !fMaster)
-                        // We processed the last element; inform the master it can exit and return the result
-                        m_master_cv.notify_one();
-                } else {
-                    // first iteration
-                    nTotal++;
+        while (true) {
+            if (FindBatch(home, vChecks)) {
+                // Check whether we need to do work at all
+                bool fOk = m_all_ok;
+                for (T& check : vChecks) {
+                    if (fOk) fOk = check();
+                }
+                if (!fOk) m_all_ok = false;
+                const int64_t done = vChecks.size();
+                vChecks.clear();
+                if (m_todo.fetch_sub(done) == done && !fMaster) {
+                    // We processed the last element; inform the master it can exit and return the result.
+                    // Taking the lock makes sure the master is either waiting already or sees m_todo == 0.
+                    { LOCK(m_mutex); }
+                    m_master_cv.notify_one();
+                }
+                continue;
+            }
+
+            WAIT_LOCK(m_mutex, lock);
+            if (fMaster) {
+                while (m_todo > 0 && m_queued <= 0 && !m_request_stop) {
+                    m_master_cv.wait(lock);
+                }
+                if (m_request_stop) {
+                    return false;
+                }
+                if (m_todo == 0) {
+                    // reset the status for new work later and return the current status
+                    return m_all_ok.exchange(true);
                 }
-                // logically, the do loop starts here
-                while (queue.empty() && !m_request_stop) {
-                    if (fMaster && nTodo == 0) {
-                        nTotal--;
-                        bool fRet = fAllOk;
-                        // reset the status for new work later
-                        fAllOk = true;
-                        // return the current status
-                        return fRet;
-                    }
+            } else {
+                while (m_queued <= 0 && !m_request_stop) {
                     nIdle++;
-                    cond.wait(lock); // wait
+                    m_worker_cv.wait(lock); // wait
                     nIdle--;
                 }
                 if (m_request_stop) {
                     return false;
                 }
-
-                // Decide how many work units to process now.
-                // * Do not try to do everything at once, but aim for increasingly smaller batches so
-                //   all workers finish approximately simultaneously.
-                // * Try to account for idle jobs which will instantly start helping.
-                // * Don't do batches smaller than 1 (duh), or larger than nBatchSize.
-                nNow = std::max(1U, std::min(nBatchSize, (unsigned int)queue.size() / (nTotal + nIdle + 1)));
-                vChecks.resize(nNow);
-                for (unsigned int i = 0; i < nNow; i++) {
-                    // We want the lock on the m_mutex to be as short as possible, so swap jobs from the global
-                    // queue to the local batch vector instead of copying.
-                    vChecks[i].swap(queue.back());
-                    queue.pop_back();
-                }
-                // Check whether we need to do work at all
-                fOk = fAllOk;
             }
-            // execute work
-            for (T& check : vChecks)
-                if (fOk)
-                    fOk = check();
-            vChecks.clear();
-        } while (true);
+        }
     }
 
 public:
@@ -136,22 +183,27 @@ public:
     explicit CCheckQueue(unsigned int nBatchSizeIn)
         : nBatchSize(nBatchSizeIn)
     {
+        m_queues.emplace_back(std::make_unique<WorkerQueue>());
     }
 
     //! Create a pool of new worker threads.
-    void StartWorkerThreads(const int threads_num)
+    void StartWorkerThreads(const int threads_num, const std::string& thread_name = "scriptch")
     {
         {
             LOCK(m_mutex);
             nIdle = 0;
-            nTotal = 0;
-            fAllOk = true;
+            m_all_ok = true;
         }
         assert(m_worker_threads.empty());
+        m_queues.clear();
+        for (int n = 0; n < std::max(threads_num, 1); ++n) {
+            m_queues.emplace_back(std::make_unique<WorkerQueue>());
+        }
+        m_next_queue = 0;
         for (int n = 0; n < threads_num; ++n) {
-            m_worker_threads.emplace_back([this, n]() {
-                util::ThreadRename(strprintf("scriptch.%i", n));
-                Loop(false /* worker thread */);
+            m_worker_threads.emplace_back([this, n, thread_name]() {
+                util::ThreadRename(strprintf("%s.%i", thread_name, n));
+                Loop(false /* worker thread */, n);
             });
         }
     }
@@ -159,7 +211,7 @@ public:
     //! Wait until execution finishes, and return whether all evaluations were successful.
     bool Wait()
     {
-        return Loop(true /* master thread */);
+        return Loop(true /* master thread */, 0);
     }
 
     //! Add a batch of checks to the queue
@@ -169,16 +221,30 @@ public:
             return;
         }
 
+        m_todo += vChecks.size();
+        // Spread the checks over the worker queues up front, so the workers mostly take them
+        // from their own queue. Small batches go round-robin.
+        const size_t chunk = (vChecks.size() + m_queues.size() - 1) / m_queues.size();
+        for (size_t pos = 0; pos < vChecks.size();) {
+            WorkerQueue& queue = *m_queues[m_next_queue];
+            m_next_queue = (m_next_queue + 1) % m_queues.size();
+            LOCK(queue.m_mutex);
+            for (const size_t end = std::min(pos + chunk, vChecks.size()); pos < end; ++pos) {
+                queue.checks.emplace_back();
+                vChecks[pos].swap(queue.checks.back());
+            }
+        }
+
+        int idle;
         {
             LOCK(m_mutex);
-            for (T& check : vChecks) {
-                queue.emplace_back();
-                check.swap(queue.back());
-            }
-            nTodo += vChecks.size();
+            m_queued += vChecks.size();
+            idle = nIdle;
         }
 
-        if (vChecks.size() == 1) {
+        if (idle == 0) {
+            return;
+        } else if (vChecks.size() == 1) {
             m_worker_cv.notify_one();
         } else {
             m_worker_cv.notify_all();
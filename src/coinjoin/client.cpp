@@ -12,6 +12,7 @@
 #include <masternode/meta.h>
 #include <masternode/sync.h>
 #include <net.h>
+#include <net_processing.h>
 #include <netmessagemaker.h>
 #include <shutdown.h>
 #include <util/check.h>
@@ -27,21 +28,26 @@
 #include <wallet/fees.h>
 
 #include <memory>
+#include <optional>
 #include <univalue.h>
 
-PeerMsgRet CCoinJoinClientQueueManager::ProcessMessage(const CNode& peer, std::string_view msg_type, CDataStream& vRecv)
+PeerMsgRet CCoinJoinClientQueueManager::ProcessMessage(const CNode& peer, PeerManager& peerman, CBLSWorker& blsWorker, std::string_view msg_type, CDataStream& vRecv)
 {
     if (fMasternodeMode) return {};
     if (!m_mn_sync.IsBlockchainSynced()) return {};
 
     if (msg_type == NetMsgType::DSQUEUE) {
-        return CCoinJoinClientQueueManager::ProcessDSQueue(peer, vRecv);
+        return CCoinJoinClientQueueManager::ProcessDSQueue(peer, peerman, blsWorker, vRecv);
     }
     return {};
 }
 
-PeerMsgRet CCoinJoinClientQueueManager::ProcessDSQueue(const CNode& peer, CDataStream& vRecv)
+PeerMsgRet CCoinJoinClientQueueManager::ProcessDSQueue(const CNode& peer, PeerManager& peerman, CBLSWorker& blsWorker, CDataStream& vRecv)
 {
+    if (!MarkQueueSeen(Hash(vRecv))) {
+        return {};
+    }
+
     CCoinJoinQueue dsq;
     vRecv >> dsq;
 
@@ -58,40 +64,42 @@ PeerMsgRet CCoinJoinClientQueueManager::ProcessDSQueue(const CNode& peer, CDataS
         }
     }
 
-    {
-        LOCK(cs_ProcessDSQueue);
+    if (!WITH_LOCK(cs_vecqueue, return IsNewQueue(dsq, &peer))) {
+        return {};
+    }
 
-        {
-            LOCK(cs_vecqueue);
-            // process every dsq only once
-            for (const auto &q: vecCoinJoinQueue) {
-                if (q == dsq) {
-                    return {};
-                }
-                if (q.fReady == dsq.fReady && q.masternodeOutpoint == dsq.masternodeOutpoint) {
-                    // no way the same mn can send another dsq with the same readiness this soon
-                    LogPrint(BCLog::COINJOIN, /* Continued */
-                             "DSQUEUE -- Peer %s is sending WAY too many dsq messages for a masternode with collateral %s\n",
-                             peer.GetLogString(), dsq.masternodeOutpoint.ToStringShort());
-                    return {};
-                }
-            }
-        } // cs_vecqueue
+    LogPrint(BCLog::COINJOIN, "DSQUEUE -- %s new\n", dsq.ToString());
 
-        LogPrint(BCLog::COINJOIN, "DSQUEUE -- %s new\n", dsq.ToString());
+    if (dsq.IsTimeOutOfBounds()) return {};
 
-        if (dsq.IsTimeOutOfBounds()) return {};
+    auto mnList = deterministicMNManager->GetListAtChainTip();
+    auto dmn = mnList.GetValidMNByCollateral(dsq.masternodeOutpoint);
+    if (!dmn) return {};
 
-        auto mnList = deterministicMNManager->GetListAtChainTip();
-        auto dmn = mnList.GetValidMNByCollateral(dsq.masternodeOutpoint);
-        if (!dmn) return {};
+    if (dsq.m_protxHash.IsNull()) {
+        dsq.m_protxHash = dmn->proTxHash;
+    }
 
-        if (dsq.m_protxHash.IsNull()) {
-            dsq.m_protxHash = dmn->proTxHash;
-        }
+    AsyncCheckSignature(blsWorker, dsq, dmn->pdmnState->pubKeyOperator.Get(),
+        [this, &peerman, nodeId = peer.GetId(), dsq, dmn](bool valid) {
+            if (!valid) {
+                LogPrint(BCLog::COINJOIN, "DSQUEUE -- invalid signature for queue (%s)\n", dsq.ToString());
+                peerman.Misbehaving(nodeId, 10);
+                return;
+            }
+            ProcessVerifiedDSQueue(dsq, dmn);
+        });
+    return {};
+}
 
-        if (!dsq.CheckSignature(dmn->pdmnState->pubKeyOperator.Get())) {
-            return tl::unexpected{10};
+void CCoinJoinClientQueueManager::ProcessVerifiedDSQueue(CCoinJoinQueue dsq, const CDeterministicMNCPtr& dmn)
+{
+    {
+        LOCK(cs_ProcessDSQueue);
+
+        // a queue from the same masternode could have been added while the signature was checked
+        if (!WITH_LOCK(cs_vecqueue, return IsNewQueue(dsq, nullptr))) {
+            return;
         }
 
         // if the queue is ready, submit if we can
@@ -102,17 +110,17 @@ PeerMsgRet CCoinJoinClientQueueManager::ProcessDSQueue(const CNode& peer, CDataS
                                          })) {
             LogPrint(BCLog::COINJOIN, "DSQUEUE -- CoinJoin queue (%s) is ready on masternode %s\n", dsq.ToString(),
                      dmn->pdmnState->addr.ToString());
-            return {};
+            return;
         } else {
             int64_t nLastDsq = mmetaman->GetMetaInfo(dmn->proTxHash)->GetLastDsq();
-            int64_t nDsqThreshold = mmetaman->GetDsqThreshold(dmn->proTxHash, mnList.GetValidMNsCount());
+            int64_t nDsqThreshold = mmetaman->GetDsqThreshold(dmn->proTxHash, deterministicMNManager->GetListAtChainTip().GetValidMNsCount());
             LogPrint(BCLog::COINJOIN, "DSQUEUE -- nLastDsq: %d  nDsqThreshold: %d  nDsqCount: %d\n", nLastDsq,
                      nDsqThreshold, mmetaman->GetDsqCount());
             // don't allow a few nodes to dominate the queuing process
             if (nLastDsq != 0 && nDsqThreshold > mmetaman->GetDsqCount()) {
                 LogPrint(BCLog::COINJOIN, "DSQUEUE -- Masternode %s is sending too many dsq messages\n",
                          dmn->proTxHash.ToString());
-                return {};
+                return;
             }
 
             mmetaman->AllowMixing(dmn->proTxHash);
@@ -123,11 +131,10 @@ PeerMsgRet CCoinJoinClientQueueManager::ProcessDSQueue(const CNode& peer, CDataS
             ranges::any_of(m_walletman.raw(),
                            [&dsq](const auto &pair) { return pair.second->MarkAlreadyJoinedQueueAsTried(dsq); });
 
-            WITH_LOCK(cs_vecqueue, vecCoinJoinQueue.push_back(dsq));
+            WITH_LOCK(cs_vecqueue, AddQueue(dsq));
         }
     } // cs_ProcessDSQueue
     dsq.Relay(connman);
-    return {};
 }
 
 void CCoinJoinClientManager::ProcessMessage(CNode& peer, CConnman& connman, const CTxMemPool& mempool, std::string_view msg_type, CDataStream& vRecv)
@@ -777,7 +784,94 @@ bool CCoinJoinClientManager::CheckAutomaticBackup()
 //
 // Passively run mixing in the background to mix funds based on the given configuration.
 //
-bool CCoinJoinClientSession::DoAutomaticDenominating(CConnman& connman, CBlockPolicyEstimator& fee_estimator, CTxMemPool& mempool, bool fDryRun)
+void CCoinJoinClientRound::Init(CWallet& wallet)
+{
+    LOCK(wallet.cs_wallet);
+
+    const auto bal = wallet.GetBalance();
+    nBalanceAnonymized = bal.m_anonymized;
+    nBalanceDenominatedConf = bal.m_denominated_trusted;
+    nBalanceDenominatedUnconf = bal.m_denominated_untrusted_pending;
+    // including denoms but applying some restrictions
+    nBalanceAnonymizable = wallet.GetAnonymizableBalance();
+    // excluding denoms
+    nBalanceAnonimizableNonDenom = wallet.GetAnonymizableBalance(true);
+    fHasCollateralInputs = wallet.HasCollateralInputs();
+    fHasUnconfirmedCollateralInputs = !fHasCollateralInputs && wallet.HasCollateralInputs(false);
+
+    std::vector<COutput> vCoins;
+    CCoinControl coin_control;
+    coin_control.nCoinType = CoinType::ONLY_READY_TO_MIX;
+    wallet.AvailableCoins(vCoins, true, &coin_control);
+
+    mapDenominatedInputs.clear();
+    for (const auto& out : vCoins) {
+        const CTxOut& txout = out.tx->tx->vout[out.i];
+        const int nDenom = CoinJoin::AmountToDenomination(txout.nValue);
+        if (nDenom == 0) continue;
+        const COutPoint outpoint(out.tx->GetHash(), out.i);
+        mapDenominatedInputs[nDenom].emplace_back(CTxIn(outpoint), txout.scriptPubKey, wallet.GetRealOutpointCoinJoinRounds(outpoint));
+    }
+    fStale = false;
+}
+
+bool CCoinJoinClientRound::SelectTxDSInsByDenomination(CWallet& wallet, int nDenom, CAmount nValueMax, std::vector<CTxDSIn>& vecTxDSInRet) const
+{
+    vecTxDSInRet.clear();
+
+    const auto it = mapDenominatedInputs.find(nDenom);
+    if (it == mapDenominatedInputs.end()) return false;
+
+    std::vector<CTxDSIn> vecCandidates = it->second;
+    Shuffle(vecCandidates.begin(), vecCandidates.end(), FastRandomContext());
+
+    const CAmount nDenomAmount = CoinJoin::DenominationToAmount(nDenom);
+    CAmount nValueTotal{0};
+    std::set<uint256> setRecentTxIds;
+
+    // Other sessions may have locked some of the inputs since the round started
+    LOCK(wallet.cs_wallet);
+    for (const auto& txdsin : vecCandidates) {
+        if (nValueTotal + nDenomAmount > nValueMax) break;
+        if (setRecentTxIds.count(txdsin.prevout.hash)) continue; // no duplicate txids
+        if (wallet.IsLockedCoin(txdsin.prevout.hash, txdsin.prevout.n)) continue;
+
+        nValueTotal += nDenomAmount;
+        vecTxDSInRet.emplace_back(txdsin);
+        setRecentTxIds.emplace(txdsin.prevout.hash);
+    }
+
+    return nValueTotal > 0;
+}
+
+bool CCoinJoinClientRound::SelectDenominatedAmounts(CAmount nValueMax, std::set<CAmount>& setAmountsRet) const
+{
+    CAmount nValueTotal{0};
+    setAmountsRet.clear();
+
+    // larger denoms first
+    std::vector<std::pair<CAmount, size_t>> vecDenomCounts;
+    for (const auto& [nDenom, vecInputs] : mapDenominatedInputs) {
+        vecDenomCounts.emplace_back(CoinJoin::DenominationToAmount(nDenom), vecInputs.size());
+    }
+    std::sort(vecDenomCounts.rbegin(), vecDenomCounts.rend());
+
+    for (const auto& [nValue, nCount] : vecDenomCounts) {
+        for (size_t i = 0; i < nCount && nValueTotal + nValue <= nValueMax; ++i) {
+            nValueTotal += nValue;
+            setAmountsRet.emplace(nValue);
+        }
+    }
+
+    return nValueTotal >= CoinJoin::GetSmallestDenomination();
+}
+
+void CCoinJoinClientSession::ScheduleNextRun(int64_t nTimeNow)
+{
+    nTimeNextRun = nTimeNow + COINJOIN_AUTO_TIMEOUT_MIN + GetRandInt(COINJOIN_AUTO_TIMEOUT_MAX - COINJOIN_AUTO_TIMEOUT_MIN);
+}
+
+bool CCoinJoinClientSession::DoAutomaticDenominating(CConnman& connman, CBlockPolicyEstimator& fee_estimator, CTxMemPool& mempool, CCoinJoinClientRound& round, bool fDryRun)
 {
     if (fMasternodeMode) return false; // no client-side mixing on masternodes
     if (nState != POOL_STATE_IDLE) return false;
@@ -817,10 +911,8 @@ bool CCoinJoinClientSession::DoAutomaticDenominating(CConnman& connman, CBlockPo
             return false;
         }
 
-        const auto bal = m_wallet.GetBalance();
-
         // check if there is anything left to do
-        CAmount nBalanceAnonymized = bal.m_anonymized;
+        CAmount nBalanceAnonymized = round.nBalanceAnonymized;
         nBalanceNeedsAnonymized = CCoinJoinClientOptions::GetAmount() * COIN - nBalanceAnonymized;
 
         if (nBalanceNeedsAnonymized < 0) {
@@ -832,13 +924,13 @@ bool CCoinJoinClientSession::DoAutomaticDenominating(CConnman& connman, CBlockPo
         CAmount nValueMin = CoinJoin::GetSmallestDenomination();
 
         // if there are no confirmed DS collateral inputs yet
-        if (!m_wallet.HasCollateralInputs()) {
+        if (!round.fHasCollateralInputs) {
             // should have some additional amount for them
             nValueMin += CoinJoin::GetMaxCollateralAmount();
         }
 
         // including denoms but applying some restrictions
-        CAmount nBalanceAnonymizable = m_wallet.GetAnonymizableBalance();
+        CAmount nBalanceAnonymizable = round.nBalanceAnonymizable;
 
         // mixable balance is way too small
         if (nBalanceAnonymizable < nValueMin) {
@@ -848,10 +940,10 @@ bool CCoinJoinClientSession::DoAutomaticDenominating(CConnman& connman, CBlockPo
         }
 
         // excluding denoms
-        CAmount nBalanceAnonimizableNonDenom = m_wallet.GetAnonymizableBalance(true);
+        CAmount nBalanceAnonimizableNonDenom = round.nBalanceAnonimizableNonDenom;
         // denoms
-        CAmount nBalanceDenominatedConf = bal.m_denominated_trusted;
-        CAmount nBalanceDenominatedUnconf = bal.m_denominated_untrusted_pending;
+        CAmount nBalanceDenominatedConf = round.nBalanceDenominatedConf;
+        CAmount nBalanceDenominatedUnconf = round.nBalanceDenominatedUnconf;
         CAmount nBalanceDenominated = nBalanceDenominatedConf + nBalanceDenominatedUnconf;
         CAmount nBalanceToDenominate = CCoinJoinClientOptions::GetAmount() * COIN - nBalanceDenominated;
 
@@ -896,12 +988,17 @@ bool CCoinJoinClientSession::DoAutomaticDenominating(CConnman& connman, CBlockPo
         // there are funds to denominate and denominated balance does not exceed
         // max amount to mix yet.
         if (nBalanceAnonimizableNonDenom >= nValueMin + CoinJoin::GetCollateralAmount() && nBalanceToDenominate > 0) {
-            CreateDenominated(fee_estimator, nBalanceToDenominate);
+            if (CreateDenominated(fee_estimator, nBalanceToDenominate)) {
+                round.fStale = true;
+            }
         }
 
-        //check if we have the collateral sized inputs
-        if (!m_wallet.HasCollateralInputs()) {
-            return !m_wallet.HasCollateralInputs(false) && MakeCollateralAmounts(fee_estimator);
+        //check if we have the collateral sized inputs, denominating might have created some
+        if (round.fStale ? !m_wallet.HasCollateralInputs() : !round.fHasCollateralInputs) {
+            const bool fHasUnconfirmed = round.fStale ? m_wallet.HasCollateralInputs(false) : round.fHasUnconfirmedCollateralInputs;
+            if (fHasUnconfirmed || !MakeCollateralAmounts(fee_estimator)) return false;
+            round.fStale = true;
+            return true;
         }
 
         if (nSessionID) {
@@ -946,18 +1043,23 @@ bool CCoinJoinClientSession::DoAutomaticDenominating(CConnman& connman, CBlockPo
     } // LOCK(m_wallet.cs_wallet);
 
     // Always attempt to join an existing queue
-    if (JoinExistingQueue(nBalanceNeedsAnonymized, connman)) {
+    if (JoinExistingQueue(round, nBalanceNeedsAnonymized, connman)) {
         return true;
     }
 
     // If we were unable to find/join an existing queue then start a new one.
-    if (StartNewQueue(nBalanceNeedsAnonymized, connman)) return true;
+    if (StartNewQueue(round, nBalanceNeedsAnonymized, connman)) return true;
 
     strAutoDenomResult = _("No compatible Masternode found.");
     return false;
 }
 
 bool CCoinJoinClientManager::DoAutomaticDenominating(CConnman& connman, CBlockPolicyEstimator& fee_estimator, CTxMemPool& mempool, bool fDryRun)
+{
+    return DoAutomaticDenominating(connman, fee_estimator, mempool, fDryRun, /* fOnlyDueSessions */ false);
+}
+
+bool CCoinJoinClientManager::DoAutomaticDenominating(CConnman& connman, CBlockPolicyEstimator& fee_estimator, CTxMemPool& mempool, bool fDryRun, bool fOnlyDueSessions)
 {
     if (fMasternodeMode) return false; // no client-side mixing on masternodes
     if (!CCoinJoinClientOptions::IsEnabled() || !IsMixing()) return false;
@@ -990,7 +1092,14 @@ bool CCoinJoinClientManager::DoAutomaticDenominating(CConnman& connman, CBlockPo
     if (int(deqSessions.size()) < CCoinJoinClientOptions::GetSessions()) {
         deqSessions.emplace_back(m_wallet, m_walletman, m_mn_sync, m_queueman);
     }
+    const int64_t nTimeNow = GetTime();
+    std::optional<CCoinJoinClientRound> round;
     for (auto& session : deqSessions) {
+        if (fOnlyDueSessions) {
+            if (!session.IsDueToRun(nTimeNow)) continue;
+            session.ScheduleNextRun(nTimeNow);
+        }
+
         if (!CheckAutomaticBackup()) return false;
 
         if (WaitForAnotherBlock()) {
@@ -999,7 +1108,13 @@ bool CCoinJoinClientManager::DoAutomaticDenominating(CConnman& connman, CBlockPo
             return false;
         }
 
-        fResult &= session.DoAutomaticDenominating(connman, fee_estimator, mempool, fDryRun);
+        // Prepare the wallet state once for all sessions of this round
+        if (!round || round->fStale) {
+            if (!round) round.emplace();
+            round->Init(m_wallet);
+        }
+
+        fResult &= session.DoAutomaticDenominating(connman, fee_estimator, mempool, *round, fDryRun);
     }
 
     return fResult;
@@ -1055,7 +1170,7 @@ static int WinnersToSkip()
             ? 1 : 8;
 }
 
-bool CCoinJoinClientSession::JoinExistingQueue(CAmount nBalanceNeedsAnonymized, CConnman& connman)
+bool CCoinJoinClientSession::JoinExistingQueue(const CCoinJoinClientRound& round, CAmount nBalanceNeedsAnonymized, CConnman& connman)
 {
     if (!CCoinJoinClientOptions::IsEnabled()) return false;
     if (m_queueman == nullptr) return false;
@@ -1080,7 +1195,7 @@ bool CCoinJoinClientSession::JoinExistingQueue(CAmount nBalanceNeedsAnonymized,
         }
 
         // mixing rate limit i.e. nLastDsq check should already pass in DSQUEUE ProcessMessage
-        // in order for dsq to get into vecCoinJoinQueue, so we should be safe to mix already,
+        // in order for dsq to get into mapCoinJoinQueue, so we should be safe to mix already,
         // no need for additional verification here
 
         WalletCJLogPrint(m_wallet, "CCoinJoinClientSession::JoinExistingQueue -- trying queue: %s\n", dsq.ToString());
@@ -1088,7 +1203,7 @@ bool CCoinJoinClientSession::JoinExistingQueue(CAmount nBalanceNeedsAnonymized,
         std::vector<CTxDSIn> vecTxDSInTmp;
 
         // Try to match their denominations if possible, select exact number of denominations
-        if (!m_wallet.SelectTxDSInsByDenomination(dsq.nDenom, nBalanceNeedsAnonymized, vecTxDSInTmp)) {
+        if (!round.SelectTxDSInsByDenomination(m_wallet, dsq.nDenom, nBalanceNeedsAnonymized, vecTxDSInTmp)) {
             WalletCJLogPrint(m_wallet, "CCoinJoinClientSession::JoinExistingQueue -- Couldn't match denomination %d (%s)\n", dsq.nDenom, CoinJoin::DenominationToString(dsq.nDenom));
             continue;
         }
@@ -1115,7 +1230,7 @@ bool CCoinJoinClientSession::JoinExistingQueue(CAmount nBalanceNeedsAnonymized,
     return false;
 }
 
-bool CCoinJoinClientSession::StartNewQueue(CAmount nBalanceNeedsAnonymized, CConnman& connman)
+bool CCoinJoinClientSession::StartNewQueue(const CCoinJoinClientRound& round, CAmount nBalanceNeedsAnonymized, CConnman& connman)
 {
     if (!CCoinJoinClientOptions::IsEnabled()) return false;
     if (nBalanceNeedsAnonymized <= 0) return false;
@@ -1127,7 +1242,7 @@ bool CCoinJoinClientSession::StartNewQueue(CAmount nBalanceNeedsAnonymized, CCon
 
     // find available denominated amounts
     std::set<CAmount> setAmounts;
-    if (!m_wallet.SelectDenominatedAmounts(nBalanceNeedsAnonymized, setAmounts)) {
+    if (!round.SelectDenominatedAmounts(nBalanceNeedsAnonymized, setAmounts)) {
         // this should never happen
         strAutoDenomResult = _("Can't mix: no compatible inputs found!");
         WalletCJLogPrint(m_wallet, "CCoinJoinClientSession::StartNewQueue -- %s\n", strAutoDenomResult.original);
@@ -1843,16 +1958,9 @@ void CCoinJoinClientManager::DoMaintenance(CConnman& connman, CBlockPolicyEstima
 
     if (!m_mn_sync.IsBlockchainSynced() || ShutdownRequested()) return;
 
-    static int nTick = 0;
-    static int nDoAutoNextRun = nTick + COINJOIN_AUTO_TIMEOUT_MIN;
-
-    nTick++;
     CheckTimeout();
     ProcessPendingDsaRequest(connman);
-    if (nDoAutoNextRun == nTick) {
-        DoAutomaticDenominating(connman, fee_estimator, mempool);
-        nDoAutoNextRun = nTick + COINJOIN_AUTO_TIMEOUT_MIN + GetRandInt(COINJOIN_AUTO_TIMEOUT_MAX - COINJOIN_AUTO_TIMEOUT_MIN);
-    }
+    DoAutomaticDenominating(connman, fee_estimator, mempool, /* fDryRun */ false, /* fOnlyDueSessions */ true);
 }
 
 void CCoinJoinClientSession::GetJsonInfo(UniValue& obj) const
@@ -13,8 +13,11 @@
 
 #include <atomic>
 #include <deque>
+#include <map>
 #include <memory>
+#include <set>
 #include <utility>
+#include <vector>
 
 class CBlockPolicyEstimator;
 class CCoinJoinClientManager;
@@ -25,6 +28,7 @@ class CoinJoinWalletManager;
 class CNode;
 class CMasternodeSync;
 class CTxMemPool;
+class PeerManager;
 
 class UniValue;
 
@@ -101,6 +105,32 @@ private:
     wallet_name_cjman_map m_wallet_manager_map;
 };
 
+/**
+ * Wallet state shared by all sessions that run in the same mixing round. It is read once
+ * under a single cs_wallet lock, so that every session doesn't rescan the wallet itself.
+ */
+struct CCoinJoinClientRound
+{
+    CAmount nBalanceAnonymized{0};
+    CAmount nBalanceAnonymizable{0};
+    CAmount nBalanceAnonimizableNonDenom{0};
+    CAmount nBalanceDenominatedConf{0};
+    CAmount nBalanceDenominatedUnconf{0};
+    bool fHasCollateralInputs{false};
+    bool fHasUnconfirmedCollateralInputs{false};
+    /// Ready to mix denominated inputs, by denomination
+    std::map<int, std::vector<CTxDSIn>> mapDenominatedInputs;
+    /// Set by a session that created transactions, the next session needs a fresh round
+    bool fStale{false};
+
+    void Init(CWallet& wallet);
+
+    /// Select inputs of the given denomination which are not locked yet, at most one per txid
+    bool SelectTxDSInsByDenomination(CWallet& wallet, int nDenom, CAmount nValueMax, std::vector<CTxDSIn>& vecTxDSInRet) const;
+    /// Select the denominated amounts to offer in a new queue, larger denominations first
+    bool SelectDenominatedAmounts(CAmount nValueMax, std::set<CAmount>& setAmountsRet) const;
+};
+
 class CCoinJoinClientSession : public CCoinJoinBaseSession
 {
 private:
@@ -122,6 +152,9 @@ private:
 
     CKeyHolderStorage keyHolderStorage; // storage for keys used in PrepareDenominate
 
+    // Each session runs DoAutomaticDenominating on its own timer
+    int64_t nTimeNextRun{0};
+
     /// Create denominations
     bool CreateDenominated(CBlockPolicyEstimator& fee_estimator, CAmount nBalanceToDenominate);
     bool CreateDenominated(CBlockPolicyEstimator& fee_estimator, CAmount nBalanceToDenominate, const CompactTallyItem& tallyItem, bool fCreateMixingCollaterals);
@@ -132,8 +165,8 @@ private:
 
     bool CreateCollateralTransaction(CMutableTransaction& txCollateral, std::string& strReason);
 
-    bool JoinExistingQueue(CAmount nBalanceNeedsAnonymized, CConnman& connman);
-    bool StartNewQueue(CAmount nBalanceNeedsAnonymized, CConnman& connman);
+    bool JoinExistingQueue(const CCoinJoinClientRound& round, CAmount nBalanceNeedsAnonymized, CConnman& connman);
+    bool StartNewQueue(const CCoinJoinClientRound& round, CAmount nBalanceNeedsAnonymized, CConnman& connman);
 
     /// step 0: select denominated inputs and txouts
     bool SelectDenominate(std::string& strErrorRet, std::vector<CTxDSIn>& vecTxDSInRet);
@@ -171,7 +204,10 @@ public:
     bool GetMixingMasternodeInfo(CDeterministicMNCPtr& ret) const;
 
     /// Passively run mixing in the background according to the configuration in settings
-    bool DoAutomaticDenominating(CConnman& connman, CBlockPolicyEstimator& fee_estimator, CTxMemPool& mempool, bool fDryRun = false) LOCKS_EXCLUDED(cs_coinjoin);
+    bool DoAutomaticDenominating(CConnman& connman, CBlockPolicyEstimator& fee_estimator, CTxMemPool& mempool, CCoinJoinClientRound& round, bool fDryRun = false) LOCKS_EXCLUDED(cs_coinjoin);
+
+    bool IsDueToRun(int64_t nTimeNow) const { return nTimeNow >= nTimeNextRun; }
+    void ScheduleNextRun(int64_t nTimeNow);
 
     /// As a client, submit part of a future mixing transaction to a Masternode to start the process
     bool SubmitDenominate(CConnman& connman);
@@ -197,8 +233,10 @@ public:
     explicit CCoinJoinClientQueueManager(CConnman& _connman, CoinJoinWalletManager& walletman, const CMasternodeSync& mn_sync) :
         connman(_connman), m_walletman(walletman), m_mn_sync(mn_sync) {};
 
-    PeerMsgRet ProcessMessage(const CNode& peer, std::string_view msg_type, CDataStream& vRecv) LOCKS_EXCLUDED(cs_vecqueue);
-    PeerMsgRet ProcessDSQueue(const CNode& peer, CDataStream& vRecv);
+    PeerMsgRet ProcessMessage(const CNode& peer, PeerManager& peerman, CBLSWorker& blsWorker, std::string_view msg_type, CDataStream& vRecv) LOCKS_EXCLUDED(cs_vecqueue);
+    PeerMsgRet ProcessDSQueue(const CNode& peer, PeerManager& peerman, CBLSWorker& blsWorker, CDataStream& vRecv) LOCKS_EXCLUDED(cs_vecqueue);
+    /// Continue processing a dsq once its signature was checked, runs on the BLS worker
+    void ProcessVerifiedDSQueue(CCoinJoinQueue dsq, const CDeterministicMNCPtr& dmn) LOCKS_EXCLUDED(cs_vecqueue, cs_ProcessDSQueue);
     void DoMaintenance();
 };
 
@@ -234,6 +272,8 @@ private:
     // Make sure we have enough keys since last backup
     bool CheckAutomaticBackup();
 
+    bool DoAutomaticDenominating(CConnman& connman, CBlockPolicyEstimator& fee_estimator, CTxMemPool& mempool, bool fDryRun, bool fOnlyDueSessions) LOCKS_EXCLUDED(cs_deqsessions);
+
 public:
     int nCachedNumBlocks{std::numeric_limits<int>::max()};    // used for the overview screen
     bool fCreateAutoBackups{true}; // builtin support for automatic backups
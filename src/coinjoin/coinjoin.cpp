@@ -5,6 +5,7 @@
 #include <coinjoin/coinjoin.h>
 
 #include <bls/bls.h>
+#include <bls/bls_worker.h>
 #include <chain.h>
 #include <chainparams.h>
 #include <consensus/validation.h>
@@ -14,6 +15,7 @@
 #include <masternode/node.h>
 #include <masternode/sync.h>
 #include <messagesigner.h>
+#include <net.h>
 #include <netmessagemaker.h>
 #include <txmempool.h>
 #include <util/moneystr.h>
@@ -22,6 +24,7 @@
 #include <validation.h>
 
 #include <tinyformat.h>
+#include <algorithm>
 #include <string>
 
 constexpr static CAmount DEFAULT_MAX_RAW_TX_FEE{COIN / 10};
@@ -71,7 +74,7 @@ bool CCoinJoinQueue::CheckSignature(const CBLSPublicKey& blsPubKey) const
     return true;
 }
 
-bool CCoinJoinQueue::Relay(CConnman& connman)
+bool CCoinJoinQueue::Relay(CConnman& connman) const
 {
     connman.ForEachNode([&connman, this](CNode* pnode) {
         CNetMsgMaker msgMaker(pnode->GetCommonVersion());
@@ -167,7 +170,8 @@ void CCoinJoinBaseSession::SetNull()
 void CCoinJoinBaseManager::SetNull()
 {
     LOCK(cs_vecqueue);
-    vecCoinJoinQueue.clear();
+    mapCoinJoinQueue.clear();
+    mapSeenQueues.clear();
 }
 
 void CCoinJoinBaseManager::CheckQueue()
@@ -176,33 +180,99 @@ void CCoinJoinBaseManager::CheckQueue()
     if (!lockDS) return; // it's ok to fail here, we run this quite frequently
 
     // check mixing queue objects for timeouts
-    auto it = vecCoinJoinQueue.begin();
-    while (it != vecCoinJoinQueue.end()) {
-        if (it->IsTimeOutOfBounds()) {
-            LogPrint(BCLog::COINJOIN, "CCoinJoinBaseManager::%s -- Removing a queue (%s)\n", __func__, it->ToString());
-            it = vecCoinJoinQueue.erase(it);
+    for (auto it = mapCoinJoinQueue.begin(); it != mapCoinJoinQueue.end();) {
+        auto& queues = it->second;
+        queues.erase(std::remove_if(queues.begin(), queues.end(), [](const CCoinJoinQueue& dsq) {
+            if (!dsq.IsTimeOutOfBounds()) return false;
+            LogPrint(BCLog::COINJOIN, "CCoinJoinBaseManager::CheckQueue -- Removing a queue (%s)\n", dsq.ToString());
+            return true;
+        }), queues.end());
+        if (queues.empty()) {
+            it = mapCoinJoinQueue.erase(it);
         } else {
             ++it;
         }
     }
 }
 
+int CCoinJoinBaseManager::GetQueueSize() const
+{
+    LOCK(cs_vecqueue);
+    size_t nSize{0};
+    for (const auto& [_, queues] : mapCoinJoinQueue) {
+        nSize += queues.size();
+    }
+    return nSize;
+}
+
 bool CCoinJoinBaseManager::GetQueueItemAndTry(CCoinJoinQueue& dsqRet)
 {
     TRY_LOCK(cs_vecqueue, lockDS);
     if (!lockDS) return false; // it's ok to fail here, we run this quite frequently
 
-    for (auto& dsq : vecCoinJoinQueue) {
-        // only try each queue once
-        if (dsq.fTried || dsq.IsTimeOutOfBounds()) continue;
-        dsq.fTried = true;
-        dsqRet = dsq;
-        return true;
+    for (auto& [_, queues] : mapCoinJoinQueue) {
+        for (auto& dsq : queues) {
+            // only try each queue once
+            if (dsq.fTried || dsq.IsTimeOutOfBounds()) continue;
+            dsq.fTried = true;
+            dsqRet = dsq;
+            return true;
+        }
     }
 
     return false;
 }
 
+bool CCoinJoinBaseManager::MarkQueueSeen(const uint256& hash)
+{
+    LOCK(cs_vecqueue);
+    if (mapSeenQueues.exists(hash)) {
+        return false;
+    }
+    mapSeenQueues.insert(hash, true);
+    return true;
+}
+
+bool CCoinJoinBaseManager::IsNewQueue(const CCoinJoinQueue& dsq, const CNode* peer) const
+{
+    AssertLockHeld(cs_vecqueue);
+
+    const auto it = mapCoinJoinQueue.find(dsq.masternodeOutpoint);
+    if (it == mapCoinJoinQueue.end()) {
+        return true;
+    }
+    // process every dsq only once
+    for (const auto& q : it->second) {
+        if (q == dsq) {
+            return false;
+        }
+        if (q.fReady == dsq.fReady) {
+            // no way the same mn can send another dsq with the same readiness this soon
+            if (peer != nullptr) {
+                LogPrint(BCLog::COINJOIN, "DSQUEUE -- Peer %s is sending WAY too many dsq messages for a masternode with collateral %s\n", peer->GetLogString(), dsq.masternodeOutpoint.ToStringShort());
+            }
+            return false;
+        }
+    }
+    return true;
+}
+
+void CCoinJoinBaseManager::AddQueue(const CCoinJoinQueue& dsq)
+{
+    AssertLockHeld(cs_vecqueue);
+    mapCoinJoinQueue[dsq.masternodeOutpoint].push_back(dsq);
+}
+
+void CCoinJoinBaseManager::AsyncCheckSignature(CBLSWorker& blsWorker, const CCoinJoinQueue& dsq, const CBLSPublicKey& blsPubKey, std::function<void(bool)>&& callback)
+{
+    if (bls::bls_legacy_scheme.load()) {
+        // dsq signatures always use the basic scheme, batched verification only supports the active one
+        callback(dsq.CheckSignature(blsPubKey));
+        return;
+    }
+    blsWorker.AsyncVerifySig(CBLSSignature(Span{dsq.vchSig}), blsPubKey, dsq.GetSignatureHash(), std::move(callback));
+}
+
 std::string CCoinJoinBaseSession::GetStateString() const
 {
     switch (nState) {
@@ -268,8 +338,6 @@ bool CCoinJoinBaseSession::IsValidInOuts(const CTxMemPool& mempool, const std::v
         nFees -= txout.nValue;
     }
 
-    CCoinsViewMemPool viewMemPool(WITH_LOCK(cs_main, return &::ChainstateActive().CoinsTip()), mempool);
-
     for (const auto& txin : vin) {
         LogPrint(BCLog::COINJOIN, "CCoinJoinBaseSession::%s -- txin=%s\n", __func__, txin.ToString());
 
@@ -279,11 +347,24 @@ bool CCoinJoinBaseSession::IsValidInOuts(const CTxMemPool& mempool, const std::v
             if (fConsumeCollateralRet) *fConsumeCollateralRet = true;
             return false;
         }
+    }
+
+    // Look up all inputs in a single pass over the chain tip and the mempool
+    std::vector<Coin> coins(vin.size());
+    {
+        LOCK2(cs_main, mempool.cs);
+        CCoinsViewMemPool viewMemPool(&::ChainstateActive().CoinsTip(), mempool);
+        for (size_t i = 0; i < vin.size(); ++i) {
+            if (!viewMemPool.GetCoin(vin[i].prevout, coins[i])) {
+                coins[i].Clear();
+            }
+        }
+    }
 
-        Coin coin;
-        if (!viewMemPool.GetCoin(txin.prevout, coin) || coin.IsSpent() ||
-            (coin.nHeight == MEMPOOL_HEIGHT && !llmq::quorumInstantSendManager->IsLocked(txin.prevout.hash))) {
-            LogPrint(BCLog::COINJOIN, "CCoinJoinBaseSession::%s -- ERROR: missing, spent or non-locked mempool input! txin=%s\n", __func__, txin.ToString());
+    for (size_t i = 0; i < vin.size(); ++i) {
+        const Coin& coin = coins[i];
+        if (coin.IsSpent() || (coin.nHeight == MEMPOOL_HEIGHT && !llmq::quorumInstantSendManager->IsLocked(vin[i].prevout.hash))) {
+            LogPrint(BCLog::COINJOIN, "CCoinJoinBaseSession::%s -- ERROR: missing, spent or non-locked mempool input! txin=%s\n", __func__, vin[i].ToString());
             nMessageIDRet = ERR_MISSING_TX;
             return false;
         }
@@ -343,39 +424,50 @@ bool CoinJoin::IsCollateralValid(CTxMemPool& mempool, const CTransaction& txColl
         }
     }
 
-    for (const auto& txin : txCollateral.vin) {
-        Coin coin;
-        auto mempoolTx = mempool.get(txin.prevout.hash);
-        if (mempoolTx != nullptr) {
-            if (mempool.isSpent(txin.prevout) || !llmq::quorumInstantSendManager->IsLocked(txin.prevout.hash)) {
-                LogPrint(BCLog::COINJOIN, "CoinJoin::IsCollateralValid -- spent or non-locked mempool input! txin=%s\n", txin.ToString());
+    // Look up all inputs and run the mempool test under a single cs_main lock, InstantSend
+    // locks of mempool parents are checked afterwards as they don't need it
+    std::vector<uint256> vecMempoolParents;
+    {
+        LOCK2(cs_main, mempool.cs);
+        for (const auto& txin : txCollateral.vin) {
+            Coin coin;
+            auto mempoolTx = mempool.get(txin.prevout.hash);
+            if (mempoolTx != nullptr) {
+                if (txin.prevout.n >= mempoolTx->vout.size() || mempool.isSpent(txin.prevout)) {
+                    LogPrint(BCLog::COINJOIN, "CoinJoin::IsCollateralValid -- spent or non-locked mempool input! txin=%s\n", txin.ToString());
+                    return false;
+                }
+                vecMempoolParents.emplace_back(txin.prevout.hash);
+                nValueIn += mempoolTx->vout[txin.prevout.n].nValue;
+            } else if (::ChainstateActive().CoinsTip().GetCoin(txin.prevout, coin) && !coin.IsSpent()) {
+                nValueIn += coin.out.nValue;
+            } else {
+                LogPrint(BCLog::COINJOIN, "CoinJoin::IsCollateralValid -- Unknown inputs in collateral transaction, txCollateral=%s", txCollateral.ToString()); /* Continued */
                 return false;
             }
-            nValueIn += mempoolTx->vout[txin.prevout.n].nValue;
-        } else if (GetUTXOCoin(txin.prevout, coin)) {
-            nValueIn += coin.out.nValue;
-        } else {
-            LogPrint(BCLog::COINJOIN, "CoinJoin::IsCollateralValid -- Unknown inputs in collateral transaction, txCollateral=%s", txCollateral.ToString()); /* Continued */
-            return false;
         }
-    }
 
-    //collateral transactions are required to pay out a small fee to the miners
-    if (nValueIn - nValueOut < GetCollateralAmount()) {
-        LogPrint(BCLog::COINJOIN, "CoinJoin::IsCollateralValid -- did not include enough fees in transaction: fees: %d, txCollateral=%s", nValueOut - nValueIn, txCollateral.ToString()); /* Continued */
-        return false;
-    }
+        //collateral transactions are required to pay out a small fee to the miners
+        if (nValueIn - nValueOut < GetCollateralAmount()) {
+            LogPrint(BCLog::COINJOIN, "CoinJoin::IsCollateralValid -- did not include enough fees in transaction: fees: %d, txCollateral=%s", nValueOut - nValueIn, txCollateral.ToString()); /* Continued */
+            return false;
+        }
 
-    LogPrint(BCLog::COINJOIN, "CoinJoin::IsCollateralValid -- %s", txCollateral.ToString()); /* Continued */
+        LogPrint(BCLog::COINJOIN, "CoinJoin::IsCollateralValid -- %s", txCollateral.ToString()); /* Continued */
 
-    {
-        LOCK(cs_main);
         if (!ATMPIfSaneFee(::ChainstateActive(), mempool, MakeTransactionRef(txCollateral), /*test_accept=*/true)) {
             LogPrint(BCLog::COINJOIN, "CoinJoin::IsCollateralValid -- didn't pass AcceptToMemoryPool()\n");
             return false;
         }
     }
 
+    for (const auto& hash : vecMempoolParents) {
+        if (!llmq::quorumInstantSendManager->IsLocked(hash)) {
+            LogPrint(BCLog::COINJOIN, "CoinJoin::IsCollateralValid -- spent or non-locked mempool input! txid=%s\n", hash.ToString());
+            return false;
+        }
+    }
+
     return true;
 }
 
@@ -438,30 +530,49 @@ void CDSTXManager::AddDSTX(const CCoinJoinBroadcastTx& dstx)
 {
     AssertLockNotHeld(cs_mapdstx);
     LOCK(cs_mapdstx);
-    mapDSTX.insert(std::make_pair(dstx.tx->GetHash(), dstx));
+    const uint256& hash = dstx.tx->GetHash();
+    const auto map = std::atomic_load(&mapDSTX);
+    if (map->count(hash)) return;
+    std::atomic_store(&mapDSTX, std::make_shared<const DSTXMap>(map->insert({hash, dstx})));
+    if (const auto nHeight = dstx.GetConfirmedHeight()) {
+        mapDSTXByHeight[*nHeight].push_back(hash);
+    }
 }
 
-CCoinJoinBroadcastTx CDSTXManager::GetDSTX(const uint256& hash)
+CCoinJoinBroadcastTx CDSTXManager::GetDSTX(const uint256& hash) const
 {
-    AssertLockNotHeld(cs_mapdstx);
-    LOCK(cs_mapdstx);
-    auto it = mapDSTX.find(hash);
-    return (it == mapDSTX.end()) ? CCoinJoinBroadcastTx() : it->second;
+    const auto map = std::atomic_load(&mapDSTX);
+    const auto* dstx = map->find(hash);
+    return dstx ? *dstx : CCoinJoinBroadcastTx();
+}
+
+bool CDSTXManager::HasDSTX(const uint256& hash) const
+{
+    return std::atomic_load(&mapDSTX)->count(hash) != 0;
 }
 
 void CDSTXManager::CheckDSTXes(const CBlockIndex* pindex, const llmq::CChainLocksHandler& clhandler)
 {
     AssertLockNotHeld(cs_mapdstx);
     LOCK(cs_mapdstx);
-    auto it = mapDSTX.begin();
-    while (it != mapDSTX.end()) {
-        if (it->second.IsExpired(pindex, clhandler)) {
-            mapDSTX.erase(it++);
-        } else {
-            ++it;
+    // Same as CCoinJoinBroadcastTx::IsExpired: a chainlocked tip expires everything confirmed up to it, otherwise
+    // DSTXes expire more than 24 blocks after their confirmation
+    const int nExpiredHeight = clhandler.HasChainLock(pindex->nHeight, *pindex->phashBlock) ? pindex->nHeight : pindex->nHeight - 25;
+    const auto itEnd = mapDSTXByHeight.upper_bound(nExpiredHeight);
+    if (mapDSTXByHeight.begin() == itEnd) return;
+
+    auto map = *std::atomic_load(&mapDSTX);
+    for (auto it = mapDSTXByHeight.begin(); it != itEnd; ++it) {
+        for (const uint256& hash : it->second) {
+            const auto* dstx = map.find(hash);
+            if (dstx && dstx->GetConfirmedHeight() == it->first) {
+                map = map.erase(hash);
+            }
         }
     }
-    LogPrint(BCLog::COINJOIN, "CoinJoin::CheckDSTXes -- mapDSTX.size()=%llu\n", mapDSTX.size());
+    mapDSTXByHeight.erase(mapDSTXByHeight.begin(), itEnd);
+    LogPrint(BCLog::COINJOIN, "CoinJoin::CheckDSTXes -- mapDSTX.size()=%llu\n", map.size());
+    std::atomic_store(&mapDSTX, std::make_shared<const DSTXMap>(std::move(map)));
 }
 
 void CDSTXManager::UpdatedBlockTip(const CBlockIndex* pindex, const llmq::CChainLocksHandler& clhandler, const CMasternodeSync& mn_sync)
@@ -478,24 +589,34 @@ void CDSTXManager::NotifyChainLock(const CBlockIndex* pindex, const llmq::CChain
     }
 }
 
-void CDSTXManager::UpdateDSTXConfirmedHeight(const CTransactionRef& tx, std::optional<int> nHeight)
+bool CDSTXManager::UpdateDSTXConfirmedHeight(DSTXMap& map, const CTransactionRef& tx, std::optional<int> nHeight)
 {
     AssertLockHeld(cs_mapdstx);
 
-    auto it = mapDSTX.find(tx->GetHash());
-    if (it == mapDSTX.end()) {
-        return;
+    const auto* dstx = map.find(tx->GetHash());
+    if (dstx == nullptr) {
+        return false;
     }
 
-    it->second.SetConfirmedHeight(nHeight);
+    CCoinJoinBroadcastTx updated(*dstx);
+    updated.SetConfirmedHeight(nHeight);
+    map = map.set(tx->GetHash(), std::move(updated));
+    if (nHeight) {
+        mapDSTXByHeight[*nHeight].push_back(tx->GetHash());
+    }
     LogPrint(BCLog::COINJOIN, "CDSTXManager::%s -- txid=%s, nHeight=%d\n", __func__, tx->GetHash().ToString(), nHeight.value_or(-1));
+    return true;
 }
 
 void CDSTXManager::TransactionAddedToMempool(const CTransactionRef& tx)
 {
     AssertLockNotHeld(cs_mapdstx);
+    if (!HasDSTX(tx->GetHash())) return;
     LOCK(cs_mapdstx);
-    UpdateDSTXConfirmedHeight(tx, std::nullopt);
+    auto map = *std::atomic_load(&mapDSTX);
+    if (UpdateDSTXConfirmedHeight(map, tx, std::nullopt)) {
+        std::atomic_store(&mapDSTX, std::make_shared<const DSTXMap>(std::move(map)));
+    }
 }
 
 void CDSTXManager::BlockConnected(const std::shared_ptr<const CBlock>& pblock, const CBlockIndex* pindex)
@@ -503,8 +624,13 @@ void CDSTXManager::BlockConnected(const std::shared_ptr<const CBlock>& pblock, c
     AssertLockNotHeld(cs_mapdstx);
     LOCK(cs_mapdstx);
 
+    auto map = *std::atomic_load(&mapDSTX);
+    bool fUpdated{false};
     for (const auto& tx : pblock->vtx) {
-        UpdateDSTXConfirmedHeight(tx, pindex->nHeight);
+        fUpdated |= UpdateDSTXConfirmedHeight(map, tx, pindex->nHeight);
+    }
+    if (fUpdated) {
+        std::atomic_store(&mapDSTX, std::make_shared<const DSTXMap>(std::move(map)));
     }
 }
 
@@ -512,8 +638,14 @@ void CDSTXManager::BlockDisconnected(const std::shared_ptr<const CBlock>& pblock
 {
     AssertLockNotHeld(cs_mapdstx);
     LOCK(cs_mapdstx);
+
+    auto map = *std::atomic_load(&mapDSTX);
+    bool fUpdated{false};
     for (const auto& tx : pblock->vtx) {
-        UpdateDSTXConfirmedHeight(tx, std::nullopt);
+        fUpdated |= UpdateDSTXConfirmedHeight(map, tx, std::nullopt);
+    }
+    if (fUpdated) {
+        std::atomic_store(&mapDSTX, std::make_shared<const DSTXMap>(std::move(map)));
     }
 }
 
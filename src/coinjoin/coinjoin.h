@@ -11,22 +11,33 @@
 #include <netaddress.h>
 #include <primitives/block.h>
 #include <primitives/transaction.h>
+#include <saltedhasher.h>
 #include <sync.h>
 #include <timedata.h>
 #include <univalue.h>
+#include <unordered_lru_cache.h>
+#include <util/hasher.h>
 #include <util/translation.h>
 #include <version.h>
 
 #include <atomic>
+#include <functional>
 #include <map>
+#include <memory>
 #include <optional>
+#include <unordered_map>
 #include <utility>
+#include <vector>
+
+#include <immer/map.hpp>
 
 class CChainState;
 class CConnman;
 class CBLSPublicKey;
+class CBLSWorker;
 class CBlockIndex;
 class CMasternodeSync;
+class CNode;
 class CTxMemPool;
 class TxValidationState;
 
@@ -217,7 +228,7 @@ public:
     /// Check if we have a valid Masternode address
     [[nodiscard]] bool CheckSignature(const CBLSPublicKey& blsPubKey) const;
 
-    bool Relay(CConnman& connman);
+    bool Relay(CConnman& connman) const;
 
     /// Check if a queue is too old or too far into the future
     [[nodiscard]] bool IsTimeOutOfBounds(int64_t current_time = GetAdjustedTime()) const;
@@ -288,6 +299,7 @@ public:
     [[nodiscard]] bool CheckSignature(const CBLSPublicKey& blsPubKey) const;
 
     void SetConfirmedHeight(std::optional<int> nConfirmedHeightIn) { assert(nConfirmedHeightIn == std::nullopt || *nConfirmedHeightIn > 0); nConfirmedHeight = nConfirmedHeightIn; }
+    [[nodiscard]] std::optional<int> GetConfirmedHeight() const { return nConfirmedHeight; }
     bool IsExpired(const CBlockIndex* pindex, const llmq::CChainLocksHandler& clhandler) const;
     [[nodiscard]] bool IsValidStructure() const;
 };
@@ -327,18 +339,31 @@ public:
 class CCoinJoinBaseManager
 {
 protected:
+    static constexpr size_t MAX_SEEN_QUEUES{10000};
+
     mutable Mutex cs_vecqueue;
 
-    // The current mixing sessions in progress on the network
-    std::vector<CCoinJoinQueue> vecCoinJoinQueue GUARDED_BY(cs_vecqueue);
+    // The current mixing sessions in progress on the network, by masternode collateral. A masternode has at most one
+    // queue per readiness.
+    std::unordered_map<COutPoint, std::vector<CCoinJoinQueue>, SaltedOutpointHasher> mapCoinJoinQueue GUARDED_BY(cs_vecqueue);
+    // Hashes of the dsq messages seen so far, so that a dsq which is relayed by many peers is only checked once
+    unordered_lru_cache<uint256, bool, StaticSaltedHasher, MAX_SEEN_QUEUES> mapSeenQueues GUARDED_BY(cs_vecqueue);
 
     void SetNull() LOCKS_EXCLUDED(cs_vecqueue);
     void CheckQueue() LOCKS_EXCLUDED(cs_vecqueue);
 
+    /// Mark the dsq message with the given hash as seen, returns false if it was seen already
+    bool MarkQueueSeen(const uint256& hash) LOCKS_EXCLUDED(cs_vecqueue);
+    /// Check that a dsq doesn't duplicate a known queue, peer is the node which sent it, if any
+    bool IsNewQueue(const CCoinJoinQueue& dsq, const CNode* peer) const EXCLUSIVE_LOCKS_REQUIRED(cs_vecqueue);
+    void AddQueue(const CCoinJoinQueue& dsq) EXCLUSIVE_LOCKS_REQUIRED(cs_vecqueue);
+    /// Check the signature of a dsq on the BLS worker, where it is batched with other pending signature checks
+    static void AsyncCheckSignature(CBLSWorker& blsWorker, const CCoinJoinQueue& dsq, const CBLSPublicKey& blsPubKey, std::function<void(bool)>&& callback);
+
 public:
     CCoinJoinBaseManager() = default;
 
-    int GetQueueSize() const LOCKS_EXCLUDED(cs_vecqueue) { LOCK(cs_vecqueue); return vecCoinJoinQueue.size(); }
+    int GetQueueSize() const LOCKS_EXCLUDED(cs_vecqueue);
     bool GetQueueItemAndTry(CCoinJoinQueue& dsqRet) LOCKS_EXCLUDED(cs_vecqueue);
 };
 
@@ -360,13 +385,22 @@ namespace CoinJoin
 
 class CDSTXManager
 {
+    using DSTXMap = immer::map<uint256, CCoinJoinBroadcastTx, StaticSaltedHasher>;
+
+    // Serializes modifications of mapDSTX and guards the height index. Lookups don't take it, they load the current
+    // version of mapDSTX, which is replaced as a whole on every modification.
     Mutex cs_mapdstx;
-    std::map<uint256, CCoinJoinBroadcastTx> mapDSTX GUARDED_BY(cs_mapdstx);
+    //! Only accessed with std::atomic_load/std::atomic_store
+    std::shared_ptr<const DSTXMap> mapDSTX{std::make_shared<const DSTXMap>()};
+    //! Txids of confirmed DSTXes by confirmation height, so that a new tip only touches the DSTXes it expires. Entries
+    //! of DSTXes which got unconfirmed or confirmed at another height since are dropped when their height expires.
+    std::map<int, std::vector<uint256>> mapDSTXByHeight GUARDED_BY(cs_mapdstx);
 
 public:
     CDSTXManager() = default;
     void AddDSTX(const CCoinJoinBroadcastTx& dstx) LOCKS_EXCLUDED(cs_mapdstx);
-    CCoinJoinBroadcastTx GetDSTX(const uint256& hash) LOCKS_EXCLUDED(cs_mapdstx);
+    CCoinJoinBroadcastTx GetDSTX(const uint256& hash) const;
+    bool HasDSTX(const uint256& hash) const;
 
     void UpdatedBlockTip(const CBlockIndex* pindex, const llmq::CChainLocksHandler& clhandler, const CMasternodeSync& mn_sync);
     void NotifyChainLock(const CBlockIndex* pindex, const llmq::CChainLocksHandler& clhandler, const CMasternodeSync& mn_sync);
@@ -376,8 +410,8 @@ public:
     void BlockDisconnected(const std::shared_ptr<const CBlock>& pblock, const CBlockIndex*) LOCKS_EXCLUDED(cs_mapdstx);
 
 private:
-    void CheckDSTXes(const CBlockIndex* pindex, const llmq::CChainLocksHandler& clhandler);
-    void UpdateDSTXConfirmedHeight(const CTransactionRef& tx, std::optional<int> nHeight);
+    void CheckDSTXes(const CBlockIndex* pindex, const llmq::CChainLocksHandler& clhandler) LOCKS_EXCLUDED(cs_mapdstx);
+    bool UpdateDSTXConfirmedHeight(DSTXMap& map, const CTransactionRef& tx, std::optional<int> nHeight) EXCLUSIVE_LOCKS_REQUIRED(cs_mapdstx);
 
 };
 
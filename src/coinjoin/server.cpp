@@ -11,7 +11,9 @@
 #include <masternode/node.h>
 #include <masternode/sync.h>
 #include <net.h>
+#include <net_processing.h>
 #include <netmessagemaker.h>
+#include <policy/policy.h>
 #include <script/interpreter.h>
 #include <shutdown.h>
 #include <streams.h>
@@ -24,7 +26,7 @@
 
 #include <univalue.h>
 
-PeerMsgRet CCoinJoinServer::ProcessMessage(CNode& peer, std::string_view msg_type, CDataStream& vRecv)
+PeerMsgRet CCoinJoinServer::ProcessMessage(CNode& peer, PeerManager& peerman, CBLSWorker& blsWorker, std::string_view msg_type, CDataStream& vRecv)
 {
     if (!fMasternodeMode) return {};
     if (!m_mn_sync.IsBlockchainSynced()) return {};
@@ -32,7 +34,7 @@ PeerMsgRet CCoinJoinServer::ProcessMessage(CNode& peer, std::string_view msg_typ
     if (msg_type == NetMsgType::DSACCEPT) {
         ProcessDSACCEPT(peer, vRecv);
     } else if (msg_type == NetMsgType::DSQUEUE) {
-        return ProcessDSQUEUE(peer, vRecv);
+        return ProcessDSQUEUE(peer, peerman, blsWorker, vRecv);
     } else if (msg_type == NetMsgType::DSVIN) {
         ProcessDSVIN(peer, vRecv);
     } else if (msg_type == NetMsgType::DSSIGNFINALTX) {
@@ -69,8 +71,7 @@ void CCoinJoinServer::ProcessDSACCEPT(CNode& peer, CDataStream& vRecv)
 
             auto mnOutpoint = WITH_LOCK(activeMasternodeInfoCs, return activeMasternodeInfo.outpoint);
 
-            if (ranges::any_of(vecCoinJoinQueue,
-                               [&mnOutpoint](const auto& q){return q.masternodeOutpoint == mnOutpoint;})) {
+            if (mapCoinJoinQueue.count(mnOutpoint)) {
                 // refuse to create another queue this often
                 LogPrint(BCLog::COINJOIN, "DSACCEPT -- last dsq is still in queue, refuse to mix\n");
                 PushStatus(peer, STATUS_REJECTED, ERR_RECENT);
@@ -106,8 +107,12 @@ void CCoinJoinServer::ProcessDSACCEPT(CNode& peer, CDataStream& vRecv)
     }
 }
 
-PeerMsgRet CCoinJoinServer::ProcessDSQUEUE(const CNode& peer, CDataStream& vRecv)
+PeerMsgRet CCoinJoinServer::ProcessDSQUEUE(const CNode& peer, PeerManager& peerman, CBLSWorker& blsWorker, CDataStream& vRecv)
 {
+    if (!MarkQueueSeen(Hash(vRecv))) {
+        return {};
+    }
+
     CCoinJoinQueue dsq;
     vRecv >> dsq;
 
@@ -128,16 +133,8 @@ PeerMsgRet CCoinJoinServer::ProcessDSQUEUE(const CNode& peer, CDataStream& vRecv
         TRY_LOCK(cs_vecqueue, lockRecv);
         if (!lockRecv) return {};
 
-        // process every dsq only once
-        for (const auto& q : vecCoinJoinQueue) {
-            if (q == dsq) {
-                return {};
-            }
-            if (q.fReady == dsq.fReady && q.masternodeOutpoint == dsq.masternodeOutpoint) {
-                // no way the same mn can send another dsq with the same readiness this soon
-                LogPrint(BCLog::COINJOIN, "DSQUEUE -- Peer %s is sending WAY too many dsq messages for a masternode with collateral %s\n", peer.GetLogString(), dsq.masternodeOutpoint.ToStringShort());
-                return {};
-            }
+        if (!IsNewQueue(dsq, &peer)) {
+            return {};
         }
     } // cs_vecqueue
 
@@ -153,29 +150,41 @@ PeerMsgRet CCoinJoinServer::ProcessDSQUEUE(const CNode& peer, CDataStream& vRecv
         dsq.m_protxHash = dmn->proTxHash;
     }
 
-    if (!dsq.CheckSignature(dmn->pdmnState->pubKeyOperator.Get())) {
-        return tl::unexpected{10};
-    }
+    AsyncCheckSignature(blsWorker, dsq, dmn->pdmnState->pubKeyOperator.Get(),
+        [this, &peerman, nodeId = peer.GetId(), dsq, proTxHash = dmn->proTxHash](bool valid) {
+            if (!valid) {
+                LogPrint(BCLog::COINJOIN, "DSQUEUE -- invalid signature for queue (%s)\n", dsq.ToString());
+                peerman.Misbehaving(nodeId, 10);
+                return;
+            }
+            ProcessVerifiedDSQUEUE(dsq, proTxHash);
+        });
+    return {};
+}
 
-    if (!dsq.fReady) {
-        int64_t nLastDsq = mmetaman->GetMetaInfo(dmn->proTxHash)->GetLastDsq();
-        int64_t nDsqThreshold = mmetaman->GetDsqThreshold(dmn->proTxHash, mnList.GetValidMNsCount());
-        LogPrint(BCLog::COINJOIN, "DSQUEUE -- nLastDsq: %d  nDsqThreshold: %d  nDsqCount: %d\n", nLastDsq, nDsqThreshold, mmetaman->GetDsqCount());
-        //don't allow a few nodes to dominate the queuing process
-        if (nLastDsq != 0 && nDsqThreshold > mmetaman->GetDsqCount()) {
-            LogPrint(BCLog::COINJOIN, "DSQUEUE -- Masternode %s is sending too many dsq messages\n", dmn->pdmnState->addr.ToString());
-            return {};
-        }
-        mmetaman->AllowMixing(dmn->proTxHash);
+void CCoinJoinServer::ProcessVerifiedDSQUEUE(const CCoinJoinQueue& dsq, const uint256& proTxHash)
+{
+    if (dsq.fReady) return;
+
+    int64_t nLastDsq = mmetaman->GetMetaInfo(proTxHash)->GetLastDsq();
+    int64_t nDsqThreshold = mmetaman->GetDsqThreshold(proTxHash, deterministicMNManager->GetListAtChainTip().GetValidMNsCount());
+    LogPrint(BCLog::COINJOIN, "DSQUEUE -- nLastDsq: %d  nDsqThreshold: %d  nDsqCount: %d\n", nLastDsq, nDsqThreshold, mmetaman->GetDsqCount());
+    //don't allow a few nodes to dominate the queuing process
+    if (nLastDsq != 0 && nDsqThreshold > mmetaman->GetDsqCount()) {
+        LogPrint(BCLog::COINJOIN, "DSQUEUE -- Masternode %s is sending too many dsq messages\n", proTxHash.ToString());
+        return;
+    }
+    mmetaman->AllowMixing(proTxHash);
 
-        LogPrint(BCLog::COINJOIN, "DSQUEUE -- new CoinJoin queue (%s) from masternode %s\n", dsq.ToString(), dmn->pdmnState->addr.ToString());
+    LogPrint(BCLog::COINJOIN, "DSQUEUE -- new CoinJoin queue (%s) from masternode %s\n", dsq.ToString(), proTxHash.ToString());
 
-        TRY_LOCK(cs_vecqueue, lockRecv);
-        if (!lockRecv) return {};
-        vecCoinJoinQueue.push_back(dsq);
-        dsq.Relay(connman);
+    {
+        LOCK(cs_vecqueue);
+        // a queue from the same masternode could have been added while the signature was checked
+        if (!IsNewQueue(dsq, nullptr)) return;
+        AddQueue(dsq);
     }
-    return {};
+    dsq.Relay(connman);
 }
 
 void CCoinJoinServer::ProcessDSVIN(CNode& peer, CDataStream& vRecv)
@@ -304,6 +313,26 @@ void CCoinJoinServer::CreateFinalTransaction()
     RelayFinalTransaction(CTransaction(finalMutableTransaction));
 }
 
+bool CCoinJoinServer::CheckFinalTransactionScripts(const CTransaction& tx) const
+{
+    // Look up the outputs spent by all participants in a single pass
+    std::vector<CTxOut> spent_outputs(tx.vin.size());
+    {
+        LOCK2(cs_main, mempool.cs);
+        CCoinsViewMemPool viewMemPool(&m_chainstate.CoinsTip(), mempool);
+        for (size_t i = 0; i < tx.vin.size(); ++i) {
+            Coin coin;
+            if (!viewMemPool.GetCoin(tx.vin[i].prevout, coin) || coin.IsSpent()) {
+                LogPrint(BCLog::COINJOIN, "CCoinJoinServer::%s -- missing input %s\n", __func__, tx.vin[i].prevout.ToStringShort());
+                return false;
+            }
+            spent_outputs[i] = coin.out;
+        }
+    }
+
+    return CheckTransactionScripts(tx, std::move(spent_outputs), STANDARD_SCRIPT_VERIFY_FLAGS);
+}
+
 void CCoinJoinServer::CommitFinalTransaction()
 {
     AssertLockNotHeld(cs_coinjoin);
@@ -314,6 +343,16 @@ void CCoinJoinServer::CommitFinalTransaction()
 
     LogPrint(BCLog::COINJOIN, "CCoinJoinServer::CommitFinalTransaction -- finalTransaction=%s", finalTransaction->ToString()); /* Continued */
 
+    // Verify the participants' signatures on the script check threads before taking cs_main,
+    // so that the mempool test below finds them in the signature cache
+    if (!CheckFinalTransactionScripts(*finalTransaction)) {
+        LogPrint(BCLog::COINJOIN, "CCoinJoinServer::CommitFinalTransaction -- CheckFinalTransactionScripts() error: Transaction not valid\n");
+        WITH_LOCK(cs_coinjoin, SetNull());
+        // not much we can do in this case, just notify clients
+        RelayCompletedTransaction(ERR_INVALID_TX);
+        return;
+    }
+
     {
         // See if the transaction is valid
         TRY_LOCK(cs_main, lockMain);
@@ -330,7 +369,7 @@ void CCoinJoinServer::CommitFinalTransaction()
     LogPrint(BCLog::COINJOIN, "CCoinJoinServer::CommitFinalTransaction -- CREATING DSTX\n");
 
     // create and sign masternode dstx transaction
-    if (!::dstxManager->GetDSTX(hashTx)) {
+    if (!::dstxManager->HasDSTX(hashTx)) {
         CCoinJoinBroadcastTx dstxNew(finalTransaction,
                                     WITH_LOCK(activeMasternodeInfoCs, return activeMasternodeInfo.outpoint),
                                     WITH_LOCK(activeMasternodeInfoCs, return activeMasternodeInfo.proTxHash),
@@ -721,7 +760,7 @@ bool CCoinJoinServer::CreateNewSession(const CCoinJoinAccept& dsa, PoolMessage&
         dsq.Sign();
         dsq.Relay(connman);
         LOCK(cs_vecqueue);
-        vecCoinJoinQueue.push_back(dsq);
+        AddQueue(dsq);
     }
 
     vecSessionCollaterals.push_back(MakeTransactionRef(dsa.txCollateral));
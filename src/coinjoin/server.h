@@ -14,6 +14,7 @@ class CCoinJoinServer;
 class CDataStream;
 class CNode;
 class CTxMemPool;
+class PeerManager;
 
 class UniValue;
 
@@ -49,6 +50,7 @@ private:
     void CheckPool();
 
     void CreateFinalTransaction() LOCKS_EXCLUDED(cs_coinjoin);
+    bool CheckFinalTransactionScripts(const CTransaction& tx) const;
     void CommitFinalTransaction() LOCKS_EXCLUDED(cs_coinjoin);
 
     /// Is this nDenom and txCollateral acceptable?
@@ -73,7 +75,9 @@ private:
     void RelayCompletedTransaction(PoolMessage nMessageID) LOCKS_EXCLUDED(cs_coinjoin);
 
     void ProcessDSACCEPT(CNode& peer, CDataStream& vRecv) LOCKS_EXCLUDED(cs_vecqueue);
-    PeerMsgRet ProcessDSQUEUE(const CNode& peer, CDataStream& vRecv) LOCKS_EXCLUDED(cs_vecqueue);
+    PeerMsgRet ProcessDSQUEUE(const CNode& peer, PeerManager& peerman, CBLSWorker& blsWorker, CDataStream& vRecv) LOCKS_EXCLUDED(cs_vecqueue);
+    /// Continue processing a dsq once its signature was checked, runs on the BLS worker
+    void ProcessVerifiedDSQUEUE(const CCoinJoinQueue& dsq, const uint256& proTxHash) LOCKS_EXCLUDED(cs_vecqueue);
     void ProcessDSVIN(CNode& peer, CDataStream& vRecv) LOCKS_EXCLUDED(cs_coinjoin);
     void ProcessDSSIGNFINALTX(CDataStream& vRecv) LOCKS_EXCLUDED(cs_coinjoin);
 
@@ -89,7 +93,7 @@ public:
         fUnitTest(false)
     {}
 
-    PeerMsgRet ProcessMessage(CNode& pfrom, std::string_view msg_type, CDataStream& vRecv);
+    PeerMsgRet ProcessMessage(CNode& pfrom, PeerManager& peerman, CBLSWorker& blsWorker, std::string_view msg_type, CDataStream& vRecv);
 
     bool HasTimedOut() const;
     void CheckTimeout();
@@ -61,6 +61,37 @@ uint256 ComputeMerkleRoot(std::vector<uint256> hashes, bool* mutated) {
     return hashes[0];
 }
 
+std::vector<std::vector<uint256>> ComputeMerkleLevels(std::vector<uint256> hashes)
+{
+    std::vector<std::vector<uint256>> levels;
+    levels.emplace_back(std::move(hashes));
+    while (levels.back().size() > 1) {
+        std::vector<uint256> parents(levels.back());
+        if (parents.size() & 1) {
+            parents.push_back(parents.back());
+        }
+        SHA256D64(parents[0].begin(), parents[0].begin(), parents.size() / 2);
+        parents.resize(parents.size() / 2);
+        levels.emplace_back(std::move(parents));
+    }
+    return levels;
+}
+
+void ComputeMerkleParents(const std::vector<uint256>& children, const std::vector<size_t>& positions, std::vector<uint256>& parents)
+{
+    if (positions.empty()) return;
+
+    std::vector<uint256> pairs(positions.size() * 2);
+    for (size_t i = 0; i < positions.size(); i++) {
+        const size_t left = positions[i] * 2;
+        pairs[i * 2] = children[left];
+        pairs[i * 2 + 1] = left + 1 < children.size() ? children[left + 1] : children[left];
+    }
+    SHA256D64(pairs[0].begin(), pairs[0].begin(), positions.size());
+    for (size_t i = 0; i < positions.size(); i++) {
+        parents[positions[i]] = pairs[i];
+    }
+}
 
 uint256 BlockMerkleRoot(const CBlock& block, bool* mutated)
 {
@@ -12,6 +12,20 @@
 
 uint256 ComputeMerkleRoot(std::vector<uint256> hashes, bool* mutated = nullptr);
 
+/*
+ * Compute all levels of the Merkle tree over hashes, levels[0] being the hashes themselves and
+ * levels.back() the root (empty for no hashes). Like in ComputeMerkleRoot, an odd last node of a
+ * level is paired with itself, and the pairs of each level are hashed in one SHA256D64 batch.
+ */
+std::vector<std::vector<uint256>> ComputeMerkleLevels(std::vector<uint256> hashes);
+
+/*
+ * Recompute the parents at the given positions of a level, parents[i] being the hash of children
+ * 2 * i and 2 * i + 1 (or 2 * i twice, if it is the last child). All pairs are hashed in one
+ * SHA256D64 batch, parents must already be large enough.
+ */
+void ComputeMerkleParents(const std::vector<uint256>& children, const std::vector<size_t>& positions, std::vector<uint256>& parents);
+
 /*
  * Compute the Merkle root of the transactions in a block.
  * *mutated is set to true if a duplicated subtree was found.
@@ -4,40 +4,102 @@
 
 #include <crypto/aes.h>
 
+#include <compat/cpuid.h>
+#include <crypto/common.h>
+
+#include <assert.h>
 #include <string.h>
 
+#if defined(__linux__) && defined(ENABLE_ARM_AES) && !defined(BUILD_BITCOIN_INTERNAL)
+#include <sys/auxv.h>
+#include <asm/hwcap.h>
+#endif
+
+#if defined(MAC_OSX) && defined(ENABLE_ARM_AES) && !defined(BUILD_BITCOIN_INTERNAL)
+#include <sys/types.h>
+#include <sys/sysctl.h>
+#endif
+
 extern "C" {
 #include <crypto/ctaes/ctaes.c>
 }
 
-AES256Encrypt::AES256Encrypt(const unsigned char key[32])
+namespace aes_x86_aesni
+{
+void ExpandEncryptKey(unsigned char rk[AES256_ROUNDKEYS_SIZE], const unsigned char key[AES256_KEYSIZE]);
+void ExpandDecryptKey(unsigned char rk[AES256_ROUNDKEYS_SIZE], const unsigned char key[AES256_KEYSIZE]);
+void Encrypt(const unsigned char rk[AES256_ROUNDKEYS_SIZE], unsigned char out[AES_BLOCKSIZE], const unsigned char in[AES_BLOCKSIZE]);
+void Decrypt(const unsigned char rk[AES256_ROUNDKEYS_SIZE], unsigned char out[AES_BLOCKSIZE], const unsigned char in[AES_BLOCKSIZE]);
+}
+
+namespace aes_arm_aes
+{
+void ExpandEncryptKey(unsigned char rk[AES256_ROUNDKEYS_SIZE], const unsigned char key[AES256_KEYSIZE]);
+void ExpandDecryptKey(unsigned char rk[AES256_ROUNDKEYS_SIZE], const unsigned char key[AES256_KEYSIZE]);
+void Encrypt(const unsigned char rk[AES256_ROUNDKEYS_SIZE], unsigned char out[AES_BLOCKSIZE], const unsigned char in[AES_BLOCKSIZE]);
+void Decrypt(const unsigned char rk[AES256_ROUNDKEYS_SIZE], unsigned char out[AES_BLOCKSIZE], const unsigned char in[AES_BLOCKSIZE]);
+}
+
+struct AES256HwImpl {
+    void (*ExpandEncryptKey)(unsigned char rk[AES256_ROUNDKEYS_SIZE], const unsigned char key[AES256_KEYSIZE]);
+    void (*ExpandDecryptKey)(unsigned char rk[AES256_ROUNDKEYS_SIZE], const unsigned char key[AES256_KEYSIZE]);
+    void (*Encrypt)(const unsigned char rk[AES256_ROUNDKEYS_SIZE], unsigned char out[AES_BLOCKSIZE], const unsigned char in[AES_BLOCKSIZE]);
+    void (*Decrypt)(const unsigned char rk[AES256_ROUNDKEYS_SIZE], unsigned char out[AES_BLOCKSIZE], const unsigned char in[AES_BLOCKSIZE]);
+};
+
+namespace {
+
+/** The hardware implementation in use, nullptr for ctaes. */
+const AES256HwImpl* g_aes256_hw = nullptr;
+
+} // namespace
+
+AES256Encrypt::AES256Encrypt(const unsigned char key[32]) : hw(g_aes256_hw)
 {
-    AES256_init(&ctx, key);
+    if (hw) {
+        hw->ExpandEncryptKey(rk, key);
+    } else {
+        AES256_init(&ctx, key);
+    }
 }
 
 AES256Encrypt::~AES256Encrypt()
 {
     memset(&ctx, 0, sizeof(ctx));
+    memset(rk, 0, sizeof(rk));
 }
 
 void AES256Encrypt::Encrypt(unsigned char ciphertext[16], const unsigned char plaintext[16]) const
 {
-    AES256_encrypt(&ctx, 1, ciphertext, plaintext);
+    if (hw) {
+        hw->Encrypt(rk, ciphertext, plaintext);
+    } else {
+        AES256_encrypt(&ctx, 1, ciphertext, plaintext);
+    }
 }
 
-AES256Decrypt::AES256Decrypt(const unsigned char key[32])
+AES256Decrypt::AES256Decrypt(const unsigned char key[32]) : hw(g_aes256_hw)
 {
-    AES256_init(&ctx, key);
+    if (hw) {
+        hw->ExpandDecryptKey(rk, key);
+    } else {
+        AES256_init(&ctx, key);
+    }
 }
 
 AES256Decrypt::~AES256Decrypt()
 {
     memset(&ctx, 0, sizeof(ctx));
+    memset(rk, 0, sizeof(rk));
 }
 
 void AES256Decrypt::Decrypt(unsigned char plaintext[16], const unsigned char ciphertext[16]) const
 {
-    AES256_decrypt(&ctx, 1, plaintext, ciphertext);
+    if (hw) {
+        hw->Decrypt(rk, plaintext, ciphertext);
+    } else {
+        AES256_decrypt(&ctx, 1, plaintext, ciphertext);
+    }
 }
 
 
@@ -150,3 +212,82 @@ AES256CBCDecrypt::~AES256CBCDecrypt()
 {
     memset(iv, 0, sizeof(iv));
 }
+
+namespace {
+
+/** Check a hardware implementation against the FIPS-197 AES-256 example vector. */
+[[maybe_unused]] bool SelfTest(const AES256HwImpl& impl)
+{
+    static const unsigned char key[AES256_KEYSIZE] = {
+        0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0x0f,
+        0x10, 0x11, 0x12, 0x13, 0x14, 0x15, 0x16, 0x17, 0x18, 0x19, 0x1a, 0x1b, 0x1c, 0x1d, 0x1e, 0x1f,
+    };
+    static const unsigned char plaintext[AES_BLOCKSIZE] = {
+        0x00, 0x11, 0x22, 0x33, 0x44, 0x55, 0x66, 0x77, 0x88, 0x99, 0xaa, 0xbb, 0xcc, 0xdd, 0xee, 0xff,
+    };
+    static const unsigned char ciphertext[AES_BLOCKSIZE] = {
+        0x8e, 0xa2, 0xb7, 0xca, 0x51, 0x67, 0x45, 0xbf, 0xea, 0xfc, 0x49, 0x90, 0x4b, 0x49, 0x60, 0x89,
+    };
+    unsigned char rk[AES256_ROUNDKEYS_SIZE];
+    unsigned char out[AES_BLOCKSIZE];
+    impl.ExpandEncryptKey(rk, key);
+    impl.Encrypt(rk, out, plaintext);
+    if (memcmp(out, ciphertext, sizeof(out)) != 0) return false;
+    impl.ExpandDecryptKey(rk, key);
+    impl.Decrypt(rk, out, ciphertext);
+    return memcmp(out, plaintext, sizeof(out)) == 0;
+}
+
+} // namespace
+
+std::string AES256AutoDetect()
+{
+    std::string ret = "standard";
+    g_aes256_hw = nullptr;
+#if defined(USE_ASM) && defined(HAVE_GETCPUID) && defined(ENABLE_X86_AESNI) && !defined(BUILD_BITCOIN_INTERNAL)
+    uint32_t eax, ebx, ecx, edx;
+    GetCPUID(1, 0, eax, ebx, ecx, edx);
+    const bool have_sse2 = (edx >> 26) & 1;
+    const bool have_aesni = (ecx >> 25) & 1;
+    if (have_sse2 && have_aesni) {
+        static const AES256HwImpl aesni{aes_x86_aesni::ExpandEncryptKey, aes_x86_aesni::ExpandDecryptKey, aes_x86_aesni::Encrypt, aes_x86_aesni::Decrypt};
+        assert(SelfTest(aesni));
+        g_aes256_hw = &aesni;
+        ret = "aes-ni";
+    }
+#endif
+
+#if defined(ENABLE_ARM_AES) && !defined(BUILD_BITCOIN_INTERNAL)
+    bool have_arm_aes = false;
+
+#if defined(__linux__)
+#if defined(__arm__) // 32-bit
+    if (getauxval(AT_HWCAP2) & HWCAP2_AES) {
+        have_arm_aes = true;
+    }
+#endif
+#if defined(__aarch64__) // 64-bit
+    if (getauxval(AT_HWCAP) & HWCAP_AES) {
+        have_arm_aes = true;
+    }
+#endif
+#endif
+
+#if defined(MAC_OSX)
+    int val = 0;
+    size_t len = sizeof(val);
+    if (sysctlbyname("hw.optional.arm.FEAT_AES", &val, &len, nullptr, 0) == 0) {
+        have_arm_aes = val != 0;
+    }
+#endif
+
+    if (have_arm_aes) {
+        static const AES256HwImpl arm_aes{aes_arm_aes::ExpandEncryptKey, aes_arm_aes::ExpandDecryptKey, aes_arm_aes::Encrypt, aes_arm_aes::Decrypt};
+        assert(SelfTest(arm_aes));
+        g_aes256_hw = &arm_aes;
+        ret = "arm_aes";
+    }
+#endif
+
+    return ret;
+}
@@ -11,14 +11,23 @@ extern "C" {
 #include <crypto/ctaes/ctaes.h>
 }
 
+#include <string>
+
 static const int AES_BLOCKSIZE = 16;
 static const int AES256_KEYSIZE = 32;
+static const int AES256_ROUNDKEYS_SIZE = 15 * AES_BLOCKSIZE;
+
+/** Block functions of a hardware AES-256 implementation, selected by AES256AutoDetect. */
+struct AES256HwImpl;
 
 /** An encryption class for AES-256. */
 class AES256Encrypt
 {
 private:
     AES256_ctx ctx;
+    //! Used instead of ctx when a hardware implementation was selected
+    const AES256HwImpl* hw;
+    unsigned char rk[AES256_ROUNDKEYS_SIZE];
 
 public:
     explicit AES256Encrypt(const unsigned char key[32]);
@@ -31,6 +40,9 @@ class AES256Decrypt
 {
 private:
     AES256_ctx ctx;
+    //! Used instead of ctx when a hardware implementation was selected
+    const AES256HwImpl* hw;
+    unsigned char rk[AES256_ROUNDKEYS_SIZE];
 
 public:
     explicit AES256Decrypt(const unsigned char key[32]);
@@ -64,4 +76,7 @@ private:
     unsigned char iv[AES_BLOCKSIZE];
 };
 
+/** Autodetect AES-NI or ARMv8 AES support and use it for AES-256, falling back to ctaes. Returns the name used. */
+std::string AES256AutoDetect();
+
 #endif // BITCOIN_CRYPTO_AES_H
@@ -0,0 +1,90 @@
+// Copyright (c) 2024 The Maximus developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifdef ENABLE_ARM_AES
+
+#include <crypto/common.h>
+
+#include <cstdint>
+#include <arm_acle.h>
+#include <arm_neon.h>
+
+namespace {
+
+/** SubWord through AESE: with all four columns equal, ShiftRows leaves the state unchanged. */
+uint32_t inline SubWord(uint32_t w)
+{
+    const uint8x16_t s = vaeseq_u8(vreinterpretq_u8_u32(vdupq_n_u32(w)), vdupq_n_u8(0));
+    return vgetq_lane_u32(vreinterpretq_u32_u8(s), 0);
+}
+
+/** FIPS-197 key expansion, words are kept little endian so the round keys can be loaded as they are stored. */
+void ExpandKey(uint32_t w[60], const unsigned char key[32])
+{
+    static const uint8_t RCON[7] = {0x01, 0x02, 0x04, 0x08, 0x10, 0x20, 0x40};
+    for (int i = 0; i < 8; ++i) {
+        w[i] = ReadLE32(key + 4 * i);
+    }
+    for (int i = 8; i < 60; ++i) {
+        uint32_t t = w[i - 1];
+        if (i % 8 == 0) {
+            t = SubWord((t >> 8) | (t << 24)) ^ RCON[i / 8 - 1];
+        } else if (i % 8 == 4) {
+            t = SubWord(t);
+        }
+        w[i] = w[i - 8] ^ t;
+    }
+}
+
+void Store(unsigned char* out, const uint32_t w[60])
+{
+    for (int i = 0; i < 60; ++i) {
+        WriteLE32(out + 4 * i, w[i]);
+    }
+}
+
+} // namespace
+
+namespace aes_arm_aes {
+void ExpandEncryptKey(unsigned char out[240], const unsigned char key[32])
+{
+    uint32_t w[60];
+    ExpandKey(w, key);
+    Store(out, w);
+}
+
+void ExpandDecryptKey(unsigned char out[240], const unsigned char key[32])
+{
+    // Round keys of the equivalent inverse cipher: reversed, with InvMixColumns applied to the inner ones
+    unsigned char rk[240];
+    ExpandEncryptKey(rk, key);
+    vst1q_u8(out, vld1q_u8(rk + 16 * 14));
+    for (int i = 1; i < 14; ++i) {
+        vst1q_u8(out + 16 * i, vaesimcq_u8(vld1q_u8(rk + 16 * (14 - i))));
+    }
+    vst1q_u8(out + 16 * 14, vld1q_u8(rk));
+}
+
+void Encrypt(const unsigned char rk[240], unsigned char out[16], const unsigned char in[16])
+{
+    uint8x16_t m = vld1q_u8(in);
+    for (int i = 0; i < 13; ++i) {
+        m = vaesmcq_u8(vaeseq_u8(m, vld1q_u8(rk + 16 * i)));
+    }
+    m = vaeseq_u8(m, vld1q_u8(rk + 16 * 13));
+    vst1q_u8(out, veorq_u8(m, vld1q_u8(rk + 16 * 14)));
+}
+
+void Decrypt(const unsigned char rk[240], unsigned char out[16], const unsigned char in[16])
+{
+    uint8x16_t m = vld1q_u8(in);
+    for (int i = 0; i < 13; ++i) {
+        m = vaesimcq_u8(vaesdq_u8(m, vld1q_u8(rk + 16 * i)));
+    }
+    m = vaesdq_u8(m, vld1q_u8(rk + 16 * 13));
+    vst1q_u8(out, veorq_u8(m, vld1q_u8(rk + 16 * 14)));
+}
+} // namespace aes_arm_aes
+
+#endif
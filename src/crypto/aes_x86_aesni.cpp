@@ -0,0 +1,106 @@
+// Copyright (c) 2024 The Maximus developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+//
+// Key expansion follows the Intel AES-NI white paper by Shay Gueron.
+
+#ifdef ENABLE_X86_AESNI
+
+#include <stdint.h>
+#include <immintrin.h>
+
+namespace {
+
+/** Shift the words of a round key left, xoring each into the next, and mix in the SubWord/RotWord output. */
+__m128i inline ExpandStep(__m128i key, __m128i assist)
+{
+    key = _mm_xor_si128(key, _mm_slli_si128(key, 4));
+    key = _mm_xor_si128(key, _mm_slli_si128(key, 4));
+    key = _mm_xor_si128(key, _mm_slli_si128(key, 4));
+    return _mm_xor_si128(key, assist);
+}
+
+/** Derive the next even round key, rcon has to be an immediate. */
+template <int RCON>
+__m128i inline EvenRoundKey(__m128i prev_even, __m128i prev_odd)
+{
+    return ExpandStep(prev_even, _mm_shuffle_epi32(_mm_aeskeygenassist_si128(prev_odd, RCON), 0xff));
+}
+
+/** Derive the next odd round key, which uses SubWord without RotWord or rcon. */
+__m128i inline OddRoundKey(__m128i prev_odd, __m128i even)
+{
+    return ExpandStep(prev_odd, _mm_shuffle_epi32(_mm_aeskeygenassist_si128(even, 0), 0xaa));
+}
+
+void ExpandKey(__m128i rk[15], const unsigned char key[32])
+{
+    rk[0] = _mm_loadu_si128((const __m128i*)key);
+    rk[1] = _mm_loadu_si128((const __m128i*)(key + 16));
+    rk[2] = EvenRoundKey<0x01>(rk[0], rk[1]);
+    rk[3] = OddRoundKey(rk[1], rk[2]);
+    rk[4] = EvenRoundKey<0x02>(rk[2], rk[3]);
+    rk[5] = OddRoundKey(rk[3], rk[4]);
+    rk[6] = EvenRoundKey<0x04>(rk[4], rk[5]);
+    rk[7] = OddRoundKey(rk[5], rk[6]);
+    rk[8] = EvenRoundKey<0x08>(rk[6], rk[7]);
+    rk[9] = OddRoundKey(rk[7], rk[8]);
+    rk[10] = EvenRoundKey<0x10>(rk[8], rk[9]);
+    rk[11] = OddRoundKey(rk[9], rk[10]);
+    rk[12] = EvenRoundKey<0x20>(rk[10], rk[11]);
+    rk[13] = OddRoundKey(rk[11], rk[12]);
+    rk[14] = EvenRoundKey<0x40>(rk[12], rk[13]);
+}
+
+void Store(unsigned char* out, const __m128i rk[15])
+{
+    for (int i = 0; i < 15; ++i) {
+        _mm_storeu_si128((__m128i*)(out + 16 * i), rk[i]);
+    }
+}
+
+} // namespace
+
+namespace aes_x86_aesni {
+void ExpandEncryptKey(unsigned char out[240], const unsigned char key[32])
+{
+    __m128i rk[15];
+    ExpandKey(rk, key);
+    Store(out, rk);
+}
+
+void ExpandDecryptKey(unsigned char out[240], const unsigned char key[32])
+{
+    // Round keys of the equivalent inverse cipher: reversed, with InvMixColumns applied to the inner ones
+    __m128i rk[15], drk[15];
+    ExpandKey(rk, key);
+    drk[0] = rk[14];
+    for (int i = 1; i < 14; ++i) {
+        drk[i] = _mm_aesimc_si128(rk[14 - i]);
+    }
+    drk[14] = rk[0];
+    Store(out, drk);
+}
+
+void Encrypt(const unsigned char rk[240], unsigned char out[16], const unsigned char in[16])
+{
+    __m128i m = _mm_xor_si128(_mm_loadu_si128((const __m128i*)in), _mm_loadu_si128((const __m128i*)rk));
+    for (int i = 1; i < 14; ++i) {
+        m = _mm_aesenc_si128(m, _mm_loadu_si128((const __m128i*)(rk + 16 * i)));
+    }
+    m = _mm_aesenclast_si128(m, _mm_loadu_si128((const __m128i*)(rk + 16 * 14)));
+    _mm_storeu_si128((__m128i*)out, m);
+}
+
+void Decrypt(const unsigned char rk[240], unsigned char out[16], const unsigned char in[16])
+{
+    __m128i m = _mm_xor_si128(_mm_loadu_si128((const __m128i*)in), _mm_loadu_si128((const __m128i*)rk));
+    for (int i = 1; i < 14; ++i) {
+        m = _mm_aesdec_si128(m, _mm_loadu_si128((const __m128i*)(rk + 16 * i)));
+    }
+    m = _mm_aesdeclast_si128(m, _mm_loadu_si128((const __m128i*)(rk + 16 * 14)));
+    _mm_storeu_si128((__m128i*)out, m);
+}
+} // namespace aes_x86_aesni
+
+#endif
@@ -7,10 +7,28 @@
 
 #include <crypto/common.h>
 #include <crypto/chacha20.h>
+#include <support/cleanse.h>
 
 #include <algorithm>
+#include <assert.h>
 #include <string.h>
 
+#include <compat/cpuid.h>
+
+namespace chacha20_avx2
+{
+void Keystream_8way(const uint32_t* input, unsigned char* out);
+}
+
+namespace {
+
+/** A multi-block kernel computing 8 keystream blocks from the input words of a ChaCha20Aligned, without seeking. */
+typedef void (*Keystream8wayType)(const uint32_t*, unsigned char*);
+
+Keystream8wayType Keystream_8way = nullptr;
+
+} // namespace
+
 constexpr static inline uint32_t rotl32(uint32_t v, int c) { return (v << c) | (v >> (32 - c)); }
 
 #define QUARTERROUND(a,b,c,d) \
@@ -64,6 +82,15 @@ inline void ChaCha20Aligned::Keystream64(unsigned char* c, size_t blocks)
     uint32_t x0, x1, x2, x3, x4, x5, x6, x7, x8, x9, x10, x11, x12, x13, x14, x15;
     uint32_t j4, j5, j6, j7, j8, j9, j10, j11, j12, j13, j14, j15;
 
+    if (Keystream_8way) {
+        while (blocks >= 8) {
+            Keystream_8way(input, c);
+            Seek64((input[8] | uint64_t{input[9]} << 32) + 8);
+            c += 512;
+            blocks -= 8;
+        }
+    }
+
     if (!blocks) return;
 
     j4 = input[0];
@@ -161,6 +188,20 @@ inline void ChaCha20Aligned::Crypt64(const unsigned char* m, unsigned char* c, s
     uint32_t x0, x1, x2, x3, x4, x5, x6, x7, x8, x9, x10, x11, x12, x13, x14, x15;
     uint32_t j4, j5, j6, j7, j8, j9, j10, j11, j12, j13, j14, j15;
 
+    if (Keystream_8way) {
+        unsigned char keystream[512];
+        while (blocks >= 8) {
+            Keystream_8way(input, keystream);
+            Seek64((input[8] | uint64_t{input[9]} << 32) + 8);
+            for (size_t i = 0; i < 512; i += 8) {
+                WriteLE64(c + i, ReadLE64(m + i) ^ ReadLE64(keystream + i));
+            }
+            m += 512;
+            c += 512;
+            blocks -= 8;
+        }
+    }
+
     if (!blocks) return;
 
     j4 = input[0];
@@ -322,3 +363,95 @@ void ChaCha20::Crypt(const unsigned char* m, unsigned char* c, size_t bytes)
         m_bufleft = 64 - bytes;
     }
 }
+
+FSChaCha20::FSChaCha20(const unsigned char* key32, uint32_t rekey_interval) :
+    m_chacha20(key32), m_rekey_interval(rekey_interval)
+{
+    // A 96-bit RFC 8439 nonce of {0, m_rekey_counter}, the first nonce word shares the 64-bit block counter
+    m_chacha20.SetIV(0);
+    m_chacha20.Seek64(0);
+}
+
+void FSChaCha20::Crypt(const unsigned char* input, unsigned char* output, size_t bytes)
+{
+    m_chacha20.Crypt(input, output, bytes);
+    if (++m_chunk_counter == m_rekey_interval) {
+        unsigned char new_key[KEYLEN];
+        m_chacha20.Keystream(new_key, sizeof(new_key));
+        m_chacha20.SetKey32(new_key);
+        memory_cleanse(new_key, sizeof(new_key));
+        m_chunk_counter = 0;
+        ++m_rekey_counter;
+        m_chacha20.SetIV(m_rekey_counter);
+        m_chacha20.Seek64(0);
+    }
+}
+
+namespace {
+
+/** Compare a multi-block kernel against the generic implementation, across a wrap of the low counter word. */
+[[maybe_unused]] bool SelfTest(Keystream8wayType kernel)
+{
+    unsigned char key[32];
+    for (size_t i = 0; i < sizeof(key); ++i) {
+        key[i] = (unsigned char)(i * 37 + 11);
+    }
+    ChaCha20Aligned cipher(key);
+    cipher.SetIV(0x0706050403020100ull);
+    cipher.Seek64(0xfffffffdull);
+    unsigned char expected[512], out[512];
+    cipher.Keystream64(expected, 8);
+
+    const uint32_t input[12] = {
+        ReadLE32(key + 0), ReadLE32(key + 4), ReadLE32(key + 8), ReadLE32(key + 12),
+        ReadLE32(key + 16), ReadLE32(key + 20), ReadLE32(key + 24), ReadLE32(key + 28),
+        0xfffffffd, 0, 0x03020100, 0x07060504,
+    };
+    kernel(input, out);
+    return memcmp(out, expected, sizeof(out)) == 0;
+}
+
+#if defined(USE_ASM) && (defined(__x86_64__) || defined(__amd64__) || defined(__i386__))
+/** Check whether the OS has enabled AVX registers. */
+bool AVXEnabled()
+{
+    uint32_t a, d;
+    __asm__("xgetbv" : "=a"(a), "=d"(d) : "c"(0));
+    return (a & 6) == 6;
+}
+#endif
+
+} // namespace
+
+std::string ChaCha20AutoDetect()
+{
+    std::string ret = "standard";
+#if defined(USE_ASM) && defined(HAVE_GETCPUID)
+    bool have_xsave = false;
+    bool have_avx = false;
+    [[maybe_unused]] bool have_avx2 = false;
+    [[maybe_unused]] bool enabled_avx = false;
+
+    uint32_t eax, ebx, ecx, edx;
+    GetCPUID(1, 0, eax, ebx, ecx, edx);
+    have_xsave = (ecx >> 27) & 1;
+    have_avx = (ecx >> 28) & 1;
+    if (have_xsave && have_avx) {
+        enabled_avx = AVXEnabled();
+    }
+    GetCPUID(7, 0, eax, ebx, ecx, edx);
+    have_avx2 = (ebx >> 5) & 1;
+
+#if defined(ENABLE_AVX2) && !defined(BUILD_BITCOIN_INTERNAL)
+    if (have_avx2 && have_avx && enabled_avx) {
+        // The generic implementation used by the self test must still be selected
+        Keystream_8way = nullptr;
+        assert(SelfTest(chacha20_avx2::Keystream_8way));
+        Keystream_8way = chacha20_avx2::Keystream_8way;
+        ret = "avx2(8way)";
+    }
+#endif
+#endif // defined(USE_ASM) && defined(HAVE_GETCPUID)
+
+    return ret;
+}
@@ -8,6 +8,8 @@
 #include <stdint.h>
 #include <stdlib.h>
 
+#include <string>
+
 // classes for ChaCha20 256-bit stream cipher developed by Daniel J. Bernstein
 // https://cr.yp.to/chacha/chacha-20080128.pdf */
 
@@ -81,4 +83,32 @@ public:
     void Crypt(const unsigned char* input, unsigned char* output, size_t bytes);
 };
 
+/** Forward-secure ChaCha20, as used for the encrypted packet lengths of BIP324.
+ *
+ * The keystream runs on across calls to Crypt(). After every rekey_interval calls, the key is replaced by the next
+ * 32 keystream bytes and the nonce is increased, so that past chunks can't be decrypted with the current state.
+ */
+class FSChaCha20
+{
+private:
+    ChaCha20 m_chacha20;
+    const uint32_t m_rekey_interval;
+    uint32_t m_chunk_counter{0};
+    uint64_t m_rekey_counter{0};
+
+public:
+    static constexpr unsigned KEYLEN{32};
+
+    FSChaCha20(const unsigned char* key32, uint32_t rekey_interval);
+
+    FSChaCha20(const FSChaCha20&) = delete;
+    FSChaCha20& operator=(const FSChaCha20&) = delete;
+
+    /** Encrypt or decrypt a chunk of <bytes> bytes */
+    void Crypt(const unsigned char* input, unsigned char* output, size_t bytes);
+};
+
+/** Autodetect the best available multi-block ChaCha20 kernel. Returns the name of the selected implementation. */
+std::string ChaCha20AutoDetect();
+
 #endif // BITCOIN_CRYPTO_CHACHA20_H
@@ -0,0 +1,89 @@
+// Copyright (c) 2024 The Maximus developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifdef ENABLE_AVX2
+
+#include <stdint.h>
+#include <immintrin.h>
+
+#include <crypto/common.h>
+
+namespace chacha20_avx2 {
+namespace {
+
+__m256i inline K(uint32_t x) { return _mm256_set1_epi32(x); }
+__m256i inline Add(__m256i x, __m256i y) { return _mm256_add_epi32(x, y); }
+__m256i inline Xor(__m256i x, __m256i y) { return _mm256_xor_si256(x, y); }
+__m256i inline Rol(__m256i x, int n) { return _mm256_or_si256(_mm256_slli_epi32(x, n), _mm256_srli_epi32(x, 32 - n)); }
+/** Rotations by whole bytes are a single shuffle. */
+__m256i inline Rol16(__m256i x) { return _mm256_shuffle_epi8(x, _mm256_set_epi8(13, 12, 15, 14, 9, 8, 11, 10, 5, 4, 7, 6, 1, 0, 3, 2, 13, 12, 15, 14, 9, 8, 11, 10, 5, 4, 7, 6, 1, 0, 3, 2)); }
+__m256i inline Rol8(__m256i x) { return _mm256_shuffle_epi8(x, _mm256_set_epi8(14, 13, 12, 15, 10, 9, 8, 11, 6, 5, 4, 7, 2, 1, 0, 3, 14, 13, 12, 15, 10, 9, 8, 11, 6, 5, 4, 7, 2, 1, 0, 3)); }
+
+void inline __attribute__((always_inline)) QuarterRound(__m256i& a, __m256i& b, __m256i& c, __m256i& d)
+{
+    a = Add(a, b); d = Rol16(Xor(d, a));
+    c = Add(c, d); b = Rol(Xor(b, c), 12);
+    a = Add(a, b); d = Rol8(Xor(d, a));
+    c = Add(c, d); b = Rol(Xor(b, c), 7);
+}
+
+}
+
+/**
+ * Compute 8 consecutive keystream blocks, one per 32-bit lane, for the 12 input words (key, 64-bit block counter,
+ * 64-bit nonce) of a ChaCha20Aligned. The counter is not advanced.
+ */
+void Keystream_8way(const uint32_t* input, unsigned char* out)
+{
+    // 64-bit block counters of the 8 lanes, with the carry into the high word
+    const __m256i lanes = _mm256_set_epi32(7, 6, 5, 4, 3, 2, 1, 0);
+    const __m256i j12 = Add(K(input[8]), lanes);
+    const __m256i carry = _mm256_cmpgt_epi32(Xor(lanes, K(0x80000000)), Xor(j12, K(0x80000000)));
+    const __m256i j13 = _mm256_sub_epi32(K(input[9]), carry);
+
+    __m256i x[16] = {
+        K(0x61707865), K(0x3320646e), K(0x79622d32), K(0x6b206574),
+        K(input[0]), K(input[1]), K(input[2]), K(input[3]),
+        K(input[4]), K(input[5]), K(input[6]), K(input[7]),
+        j12, j13, K(input[10]), K(input[11]),
+    };
+
+    for (int i = 0; i < 10; ++i) {
+        QuarterRound(x[0], x[4], x[8], x[12]);
+        QuarterRound(x[1], x[5], x[9], x[13]);
+        QuarterRound(x[2], x[6], x[10], x[14]);
+        QuarterRound(x[3], x[7], x[11], x[15]);
+        QuarterRound(x[0], x[5], x[10], x[15]);
+        QuarterRound(x[1], x[6], x[11], x[12]);
+        QuarterRound(x[2], x[7], x[8], x[13]);
+        QuarterRound(x[3], x[4], x[9], x[14]);
+    }
+
+    x[0] = Add(x[0], K(0x61707865));
+    x[1] = Add(x[1], K(0x3320646e));
+    x[2] = Add(x[2], K(0x79622d32));
+    x[3] = Add(x[3], K(0x6b206574));
+    for (int i = 0; i < 8; ++i) {
+        x[4 + i] = Add(x[4 + i], K(input[i]));
+    }
+    x[12] = Add(x[12], j12);
+    x[13] = Add(x[13], j13);
+    x[14] = Add(x[14], K(input[10]));
+    x[15] = Add(x[15], K(input[11]));
+
+    // Transpose the state words into the 8 blocks
+    alignas(32) uint32_t words[16][8];
+    for (int i = 0; i < 16; ++i) {
+        _mm256_store_si256(reinterpret_cast<__m256i*>(words[i]), x[i]);
+    }
+    for (int block = 0; block < 8; ++block) {
+        for (int i = 0; i < 16; ++i) {
+            WriteLE32(out + 64 * block + 4 * i, words[i][block]);
+        }
+    }
+}
+
+}
+
+#endif
@@ -0,0 +1,129 @@
+// Copyright (c) 2024 The Maximus developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <crypto/chacha20poly1305.h>
+
+#include <crypto/common.h>
+#include <support/cleanse.h>
+
+#include <assert.h>
+#include <string.h>
+#include <vector>
+
+namespace {
+
+/** Constant-time comparison of two tags. */
+bool TagsEqual(const unsigned char* a, const unsigned char* b)
+{
+    unsigned char diff = 0;
+    for (unsigned i = 0; i < POLY1305_TAGLEN; ++i) {
+        diff |= a[i] ^ b[i];
+    }
+    return diff == 0;
+}
+
+} // namespace
+
+AEADChaCha20Poly1305::AEADChaCha20Poly1305(const unsigned char* key32) : m_chacha20(key32)
+{
+}
+
+void AEADChaCha20Poly1305::SetKey(const unsigned char* key32)
+{
+    m_chacha20.SetKey32(key32);
+}
+
+void AEADChaCha20Poly1305::Seek(Nonce96 nonce, uint32_t block)
+{
+    // The 64-bit counter of ChaCha20 is the RFC 8439 block counter followed by the first nonce word, the 64-bit nonce
+    // of ChaCha20 holds the other two. SetIV has to come first, as Seek64 discards the buffered keystream.
+    m_chacha20.SetIV(nonce.second);
+    m_chacha20.Seek64((uint64_t{nonce.first} << 32) | block);
+}
+
+void AEADChaCha20Poly1305::ComputeTag(const unsigned char* aad, size_t aad_len, const unsigned char* cipher, size_t cipher_len, Nonce96 nonce, unsigned char tag[POLY1305_TAGLEN])
+{
+    unsigned char poly_key[64];
+    Seek(nonce, 0);
+    m_chacha20.Keystream(poly_key, sizeof(poly_key));
+
+    // aad || pad16 || ciphertext || pad16 || le64(aad_len) || le64(cipher_len)
+    const size_t aad_padded = (aad_len + 15) & ~size_t{15};
+    const size_t cipher_padded = (cipher_len + 15) & ~size_t{15};
+    std::vector<unsigned char> mac_data(aad_padded + cipher_padded + 16, 0);
+    if (aad_len) memcpy(mac_data.data(), aad, aad_len);
+    if (cipher_len) memcpy(mac_data.data() + aad_padded, cipher, cipher_len);
+    WriteLE64(mac_data.data() + aad_padded + cipher_padded, aad_len);
+    WriteLE64(mac_data.data() + aad_padded + cipher_padded + 8, cipher_len);
+
+    poly1305_auth(tag, mac_data.data(), mac_data.size(), poly_key);
+    memory_cleanse(poly_key, sizeof(poly_key));
+}
+
+void AEADChaCha20Poly1305::Encrypt(const unsigned char* plain1, size_t plain1_len, const unsigned char* plain2, size_t plain2_len,
+                                   const unsigned char* aad, size_t aad_len, Nonce96 nonce, unsigned char* cipher)
+{
+    // The payload keystream starts at block 1, block 0 is the Poly1305 key
+    Seek(nonce, 1);
+    if (plain1_len) m_chacha20.Crypt(plain1, cipher, plain1_len);
+    if (plain2_len) m_chacha20.Crypt(plain2, cipher + plain1_len, plain2_len);
+
+    const size_t cipher_len = plain1_len + plain2_len;
+    ComputeTag(aad, aad_len, cipher, cipher_len, nonce, cipher + cipher_len);
+}
+
+bool AEADChaCha20Poly1305::Decrypt(const unsigned char* cipher, size_t cipher_len, const unsigned char* aad, size_t aad_len,
+                                   Nonce96 nonce, unsigned char* plain1, size_t plain1_len, unsigned char* plain2, size_t plain2_len)
+{
+    assert(cipher_len == plain1_len + plain2_len + EXPANSION);
+    const size_t payload_len = cipher_len - EXPANSION;
+
+    unsigned char tag[POLY1305_TAGLEN];
+    ComputeTag(aad, aad_len, cipher, payload_len, nonce, tag);
+    if (!TagsEqual(tag, cipher + payload_len)) return false;
+
+    Seek(nonce, 1);
+    if (plain1_len) m_chacha20.Crypt(cipher, plain1, plain1_len);
+    if (plain2_len) m_chacha20.Crypt(cipher + plain1_len, plain2, plain2_len);
+    return true;
+}
+
+void AEADChaCha20Poly1305::Keystream(Nonce96 nonce, unsigned char* out, size_t len)
+{
+    Seek(nonce, 1);
+    m_chacha20.Keystream(out, len);
+}
+
+FSChaCha20Poly1305::FSChaCha20Poly1305(const unsigned char* key32, uint32_t rekey_interval) :
+    m_aead(key32), m_rekey_interval(rekey_interval)
+{
+}
+
+void FSChaCha20Poly1305::NextPacket()
+{
+    if (++m_packet_counter == m_rekey_interval) {
+        // The keystream of the nonce with an all-ones packet counter is never used for a packet
+        unsigned char new_key[64];
+        m_aead.Keystream({0xffffffff, m_rekey_counter}, new_key, sizeof(new_key));
+        m_aead.SetKey(new_key);
+        memory_cleanse(new_key, sizeof(new_key));
+        m_packet_counter = 0;
+        ++m_rekey_counter;
+    }
+}
+
+void FSChaCha20Poly1305::Encrypt(const unsigned char* plain1, size_t plain1_len, const unsigned char* plain2, size_t plain2_len,
+                                 const unsigned char* aad, size_t aad_len, unsigned char* cipher)
+{
+    m_aead.Encrypt(plain1, plain1_len, plain2, plain2_len, aad, aad_len, {m_packet_counter, m_rekey_counter}, cipher);
+    NextPacket();
+}
+
+bool FSChaCha20Poly1305::Decrypt(const unsigned char* cipher, size_t cipher_len, const unsigned char* aad, size_t aad_len,
+                                 unsigned char* plain1, size_t plain1_len, unsigned char* plain2, size_t plain2_len)
+{
+    const bool ret = m_aead.Decrypt(cipher, cipher_len, aad, aad_len, {m_packet_counter, m_rekey_counter}, plain1, plain1_len, plain2, plain2_len);
+    NextPacket();
+    return ret;
+}
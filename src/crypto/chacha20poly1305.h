@@ -0,0 +1,93 @@
+// Copyright (c) 2024 The Maximus developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_CRYPTO_CHACHA20POLY1305_H
+#define BITCOIN_CRYPTO_CHACHA20POLY1305_H
+
+#include <crypto/chacha20.h>
+#include <crypto/poly1305.h>
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <utility>
+
+/** The RFC 8439 ChaCha20-Poly1305 AEAD.
+ *
+ * Not to be confused with the chacha20-poly1305@bitcoin construction in chacha_poly_aead.h, which encrypts the
+ * packet lengths with a second key and uses a different MAC layout.
+ */
+class AEADChaCha20Poly1305
+{
+public:
+    /** 96-bit nonce, the first 32 bits followed by the last 64 bits in little endian. */
+    using Nonce96 = std::pair<uint32_t, uint64_t>;
+
+private:
+    ChaCha20 m_chacha20;
+
+    /** Position the cipher at block <block> of the keystream for <nonce>. */
+    void Seek(Nonce96 nonce, uint32_t block);
+
+    /** Compute the tag over aad and ciphertext with the one-time key in block 0 of <nonce>. */
+    void ComputeTag(const unsigned char* aad, size_t aad_len, const unsigned char* cipher, size_t cipher_len, Nonce96 nonce, unsigned char tag[POLY1305_TAGLEN]);
+
+public:
+    static constexpr unsigned KEYLEN{32};
+    /** Number of bytes the ciphertext is longer than the plaintext. */
+    static constexpr unsigned EXPANSION{POLY1305_TAGLEN};
+
+    explicit AEADChaCha20Poly1305(const unsigned char* key32);
+
+    /** Switch to another 32-byte key. */
+    void SetKey(const unsigned char* key32);
+
+    /** Encrypt the concatenation of plain1 and plain2 into cipher, which must have room for
+     *  plain1_len + plain2_len + EXPANSION bytes. */
+    void Encrypt(const unsigned char* plain1, size_t plain1_len, const unsigned char* plain2, size_t plain2_len,
+                 const unsigned char* aad, size_t aad_len, Nonce96 nonce, unsigned char* cipher);
+
+    /** Verify and decrypt cipher (cipher_len >= EXPANSION) into plain1 and plain2, whose lengths must add up to
+     *  cipher_len - EXPANSION. Returns false, leaving the outputs untouched, if the tag doesn't match. */
+    bool Decrypt(const unsigned char* cipher, size_t cipher_len, const unsigned char* aad, size_t aad_len,
+                 Nonce96 nonce, unsigned char* plain1, size_t plain1_len, unsigned char* plain2, size_t plain2_len);
+
+    /** Output the keystream for <nonce>, starting after the block used for the Poly1305 key. */
+    void Keystream(Nonce96 nonce, unsigned char* out, size_t len);
+};
+
+/** Forward-secure ChaCha20-Poly1305, the packet cipher of BIP324.
+ *
+ * The nonce is derived from a packet counter, and every rekey_interval packets the key is replaced by keystream
+ * of the current key that is never used for packets.
+ */
+class FSChaCha20Poly1305
+{
+private:
+    AEADChaCha20Poly1305 m_aead;
+    const uint32_t m_rekey_interval;
+    uint32_t m_packet_counter{0};
+    uint64_t m_rekey_counter{0};
+
+    /** Update the counters, and rekey after rekey_interval packets. */
+    void NextPacket();
+
+public:
+    static constexpr unsigned KEYLEN{AEADChaCha20Poly1305::KEYLEN};
+    static constexpr unsigned EXPANSION{AEADChaCha20Poly1305::EXPANSION};
+
+    FSChaCha20Poly1305(const unsigned char* key32, uint32_t rekey_interval);
+
+    FSChaCha20Poly1305(const FSChaCha20Poly1305&) = delete;
+    FSChaCha20Poly1305& operator=(const FSChaCha20Poly1305&) = delete;
+
+    /** Encrypt the next packet, see AEADChaCha20Poly1305::Encrypt. */
+    void Encrypt(const unsigned char* plain1, size_t plain1_len, const unsigned char* plain2, size_t plain2_len,
+                 const unsigned char* aad, size_t aad_len, unsigned char* cipher);
+
+    /** Decrypt the next packet, see AEADChaCha20Poly1305::Decrypt. Advances the packet counter even on failure. */
+    bool Decrypt(const unsigned char* cipher, size_t cipher_len, const unsigned char* aad, size_t aad_len,
+                 unsigned char* plain1, size_t plain1_len, unsigned char* plain2, size_t plain2_len);
+};
+
+#endif // BITCOIN_CRYPTO_CHACHA20POLY1305_H
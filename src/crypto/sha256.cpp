@@ -32,11 +32,13 @@ void Transform(uint32_t* s, const unsigned char* chunk, size_t blocks);
 namespace sha256d64_sse41
 {
 void Transform_4way(unsigned char* out, const unsigned char* in);
+void Transform_4way_single(unsigned char* out, const unsigned char* in);
 }
 
 namespace sha256d64_avx2
 {
 void Transform_8way(unsigned char* out, const unsigned char* in);
+void Transform_8way_single(unsigned char* out, const unsigned char* in);
 }
 
 namespace sha256d64_x86_shani
@@ -476,11 +478,37 @@ void TransformD64Wrapper(unsigned char* out, const unsigned char* in)
     WriteBE32(out + 28, s[7]);
 }
 
+template<TransformType tr>
+void TransformS64Wrapper(unsigned char* out, const unsigned char* in)
+{
+    uint32_t s[8];
+    static const unsigned char padding1[64] = {
+        0x80, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+        0,    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+        0,    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+        0,    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 2, 0
+    };
+    sha256::Initialize(s);
+    tr(s, in, 1);
+    tr(s, padding1, 1);
+    WriteBE32(out + 0, s[0]);
+    WriteBE32(out + 4, s[1]);
+    WriteBE32(out + 8, s[2]);
+    WriteBE32(out + 12, s[3]);
+    WriteBE32(out + 16, s[4]);
+    WriteBE32(out + 20, s[5]);
+    WriteBE32(out + 24, s[6]);
+    WriteBE32(out + 28, s[7]);
+}
+
 TransformType Transform = sha256::Transform;
 TransformD64Type TransformD64 = sha256::TransformD64;
 TransformD64Type TransformD64_2way = nullptr;
 TransformD64Type TransformD64_4way = nullptr;
 TransformD64Type TransformD64_8way = nullptr;
+TransformD64Type TransformS64 = TransformS64Wrapper<sha256::Transform>;
+TransformD64Type TransformS64_4way = nullptr;
+TransformD64Type TransformS64_8way = nullptr;
 
 bool SelfTest() {
     // Input state (equal to the initial SHA256 state)
@@ -564,6 +592,30 @@ bool SelfTest() {
         if (!std::equal(out, out + 256, result_d64)) return false;
     }
 
+    // Test TransformS64 and its multi-way variants against the generic single SHA256
+    unsigned char result_s64[256];
+    for (size_t i = 0; i < 8; ++i) {
+        TransformS64Wrapper<sha256::Transform>(result_s64 + 32 * i, data + 1 + 64 * i);
+    }
+    for (size_t i = 0; i < 8; ++i) {
+        TransformS64(out, data + 1 + 64 * i);
+        if (!std::equal(out, out + 32, result_s64 + 32 * i)) return false;
+    }
+
+    // Test TransformS64_4way, if available.
+    if (TransformS64_4way) {
+        unsigned char out[128];
+        TransformS64_4way(out, data + 1);
+        if (!std::equal(out, out + 128, result_s64)) return false;
+    }
+
+    // Test TransformS64_8way, if available.
+    if (TransformS64_8way) {
+        unsigned char out[256];
+        TransformS64_8way(out, data + 1);
+        if (!std::equal(out, out + 256, result_s64)) return false;
+    }
+
     return true;
 }
 
@@ -608,6 +660,7 @@ std::string SHA256AutoDetect()
     if (have_x86_shani) {
         Transform = sha256_x86_shani::Transform;
         TransformD64 = TransformD64Wrapper<sha256_x86_shani::Transform>;
+        TransformS64 = TransformS64Wrapper<sha256_x86_shani::Transform>;
         TransformD64_2way = sha256d64_x86_shani::Transform_2way;
         ret = "x86_shani(1way,2way)";
         have_sse4 = false; // Disable SSE4/AVX2;
@@ -619,10 +672,12 @@ std::string SHA256AutoDetect()
 #if defined(__x86_64__) || defined(__amd64__)
         Transform = sha256_sse4::Transform;
         TransformD64 = TransformD64Wrapper<sha256_sse4::Transform>;
+        TransformS64 = TransformS64Wrapper<sha256_sse4::Transform>;
         ret = "sse4(1way)";
 #endif
 #if defined(ENABLE_SSE41) && !defined(BUILD_BITCOIN_INTERNAL)
         TransformD64_4way = sha256d64_sse41::Transform_4way;
+        TransformS64_4way = sha256d64_sse41::Transform_4way_single;
         ret += ",sse41(4way)";
 #endif
     }
@@ -630,6 +685,7 @@ std::string SHA256AutoDetect()
 #if defined(ENABLE_AVX2) && !defined(BUILD_BITCOIN_INTERNAL)
     if (have_avx2 && have_avx && enabled_avx) {
         TransformD64_8way = sha256d64_avx2::Transform_8way;
+        TransformS64_8way = sha256d64_avx2::Transform_8way_single;
         ret += ",avx2(8way)";
     }
 #endif
@@ -662,6 +718,7 @@ std::string SHA256AutoDetect()
     if (have_arm_shani) {
         Transform = sha256_arm_shani::Transform;
         TransformD64 = TransformD64Wrapper<sha256_arm_shani::Transform>;
+        TransformS64 = TransformS64Wrapper<sha256_arm_shani::Transform>;
         TransformD64_2way = sha256d64_arm_shani::Transform_2way;
         ret = "arm_shani(1way,2way)";
     }
@@ -761,3 +818,29 @@ void SHA256D64(unsigned char* out, const unsigned char* in, size_t blocks)
         --blocks;
     }
 }
+
+void SHA256S64(unsigned char* out, const unsigned char* in, size_t blocks)
+{
+    if (TransformS64_8way) {
+        while (blocks >= 8) {
+            TransformS64_8way(out, in);
+            out += 256;
+            in += 512;
+            blocks -= 8;
+        }
+    }
+    if (TransformS64_4way) {
+        while (blocks >= 4) {
+            TransformS64_4way(out, in);
+            out += 128;
+            in += 256;
+            blocks -= 4;
+        }
+    }
+    while (blocks) {
+        TransformS64(out, in);
+        out += 32;
+        in += 64;
+        --blocks;
+    }
+}
@@ -70,9 +70,9 @@ void inline Write8(unsigned char* out, int offset, __m256i v) {
     WriteLE32(out + 224 + offset, _mm256_extract_epi32(v, 0));
 }
 
-}
-
-void Transform_8way(unsigned char* out, const unsigned char* in)
+/** Double SHA256 of the input blobs, or the single SHA256 when double_hash is false. */
+template <bool double_hash>
+void inline __attribute__((always_inline)) TransformImpl(unsigned char* out, const unsigned char* in)
 {
     // Transform 1
     __m256i a = K(0x6a09e667ul);
@@ -237,6 +237,18 @@ void Transform_8way(unsigned char* out, const unsigned char* in)
     w6 = Add(t6, g);
     w7 = Add(t7, h);
 
+    if constexpr (!double_hash) {
+        Write8(out, 0, w0);
+        Write8(out, 4, w1);
+        Write8(out, 8, w2);
+        Write8(out, 12, w3);
+        Write8(out, 16, w4);
+        Write8(out, 20, w5);
+        Write8(out, 24, w6);
+        Write8(out, 28, w7);
+        return;
+    }
+
     // Transform 3
     a = K(0x6a09e667ul);
     b = K(0xbb67ae85ul);
@@ -325,4 +337,16 @@ void Transform_8way(unsigned char* out, const unsigned char* in)
 
 }
 
+void Transform_8way(unsigned char* out, const unsigned char* in)
+{
+    TransformImpl<true>(out, in);
+}
+
+void Transform_8way_single(unsigned char* out, const unsigned char* in)
+{
+    TransformImpl<false>(out, in);
+}
+
+}
+
 #endif
@@ -62,9 +62,9 @@ void inline Write4(unsigned char* out, int offset, __m128i v) {
     WriteLE32(out + 96 + offset, _mm_extract_epi32(v, 0));
 }
 
-}
-
-void Transform_4way(unsigned char* out, const unsigned char* in)
+/** Double SHA256 of the input blobs, or the single SHA256 when double_hash is false. */
+template <bool double_hash>
+void inline __attribute__((always_inline)) TransformImpl(unsigned char* out, const unsigned char* in)
 {
     // Transform 1
     __m128i a = K(0x6a09e667ul);
@@ -229,6 +229,18 @@ void Transform_4way(unsigned char* out, const unsigned char* in)
     w6 = Add(t6, g);
     w7 = Add(t7, h);
 
+    if constexpr (!double_hash) {
+        Write4(out, 0, w0);
+        Write4(out, 4, w1);
+        Write4(out, 8, w2);
+        Write4(out, 12, w3);
+        Write4(out, 16, w4);
+        Write4(out, 20, w5);
+        Write4(out, 24, w6);
+        Write4(out, 28, w7);
+        return;
+    }
+
     // Transform 3
     a = K(0x6a09e667ul);
     b = K(0xbb67ae85ul);
@@ -317,4 +329,16 @@ void Transform_4way(unsigned char* out, const unsigned char* in)
 
 }
 
+void Transform_4way(unsigned char* out, const unsigned char* in)
+{
+    TransformImpl<true>(out, in);
+}
+
+void Transform_4way_single(unsigned char* out, const unsigned char* in)
+{
+    TransformImpl<false>(out, in);
+}
+
+}
+
 #endif
@@ -4,6 +4,8 @@
 
 #include <crypto/siphash.h>
 
+#include <crypto/common.h>
+
 #define ROTL(x, b) (uint64_t)(((x) << (b)) | ((x) >> (64 - (b))))
 
 #define SIPROUND do { \
@@ -51,8 +53,21 @@ CSipHasher& CSipHasher::Write(const unsigned char* data, size_t size)
     uint64_t t = tmp;
     uint8_t c = count;
 
-    while (size--) {
+    while (size > 0) {
+        if ((c & 7) == 0 && size >= 8) {
+            // At a word boundary of the message, so whole words can be consumed at once
+            const uint64_t w = ReadLE64(data);
+            v3 ^= w;
+            SIPROUND;
+            SIPROUND;
+            v0 ^= w;
+            data += 8;
+            size -= 8;
+            c += 8;
+            continue;
+        }
         t |= ((uint64_t)(*(data++))) << (8 * (c % 8));
+        size--;
         c++;
         if ((c & 7) == 0) {
             v3 ^= t;
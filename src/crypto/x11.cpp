@@ -0,0 +1,161 @@
+// Copyright (c) 2024 The Maximus developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <crypto/x11.h>
+#include <crypto/common.h>
+
+#include <crypto/sph_blake.h>
+#include <crypto/sph_bmw.h>
+#include <crypto/sph_cubehash.h>
+#include <crypto/sph_echo.h>
+#include <crypto/sph_groestl.h>
+#include <crypto/sph_jh.h>
+#include <crypto/sph_keccak.h>
+#include <crypto/sph_luffa.h>
+#include <crypto/sph_shavite.h>
+#include <crypto/sph_simd.h>
+#include <crypto/sph_skein.h>
+
+#include <assert.h>
+#include <string.h>
+
+#include <compat/cpuid.h>
+
+namespace x11_avx2
+{
+void Keccak512_64_4way(unsigned char* out, const unsigned char* in);
+}
+
+namespace {
+
+/** Number of headers processed per pass through the stage pipeline. */
+constexpr size_t BATCH_LANES = 8;
+
+/** A multi-lane kernel hashing four consecutive 64-byte inputs into 64-byte outputs. */
+typedef void (*Stage64Type)(unsigned char*, const unsigned char*);
+
+template<typename Ctx, void (*Init)(void*), void (*Update)(void*, const void*, size_t), void (*Close)(void*, void*)>
+void inline Hash512(unsigned char* out, const unsigned char* in, size_t len)
+{
+    Ctx ctx;
+    Init(&ctx);
+    Update(&ctx, in, len);
+    Close(&ctx, out);
+}
+
+#define X11_STAGE(name) Hash512<sph_##name##512_context, sph_##name##512_init, sph_##name##512, sph_##name##512_close>
+
+/** Run a 64 -> 64 byte stage over `lanes` inputs, using the 4-way kernel for full groups of four. */
+void inline RunStage(void (*single)(unsigned char*, const unsigned char*, size_t), Stage64Type four_way, unsigned char* out, const unsigned char* in, size_t lanes)
+{
+    size_t i = 0;
+    if (four_way) {
+        for (; i + 4 <= lanes; i += 4) {
+            four_way(out + 64 * i, in + 64 * i);
+        }
+    }
+    for (; i < lanes; ++i) {
+        single(out + 64 * i, in + 64 * i, 64);
+    }
+}
+
+Stage64Type Keccak512_4way = nullptr;
+
+void X11Hash80Lanes(unsigned char* out, const unsigned char* in, size_t lanes)
+{
+    alignas(32) unsigned char a[BATCH_LANES * 64];
+    alignas(32) unsigned char b[BATCH_LANES * 64];
+
+    for (size_t i = 0; i < lanes; ++i) {
+        X11_STAGE(blake)(a + 64 * i, in + 80 * i, 80);
+    }
+    RunStage(X11_STAGE(bmw), nullptr, b, a, lanes);
+    RunStage(X11_STAGE(groestl), nullptr, a, b, lanes);
+    RunStage(X11_STAGE(skein), nullptr, b, a, lanes);
+    RunStage(X11_STAGE(jh), nullptr, a, b, lanes);
+    RunStage(X11_STAGE(keccak), Keccak512_4way, b, a, lanes);
+    RunStage(X11_STAGE(luffa), nullptr, a, b, lanes);
+    RunStage(X11_STAGE(cubehash), nullptr, b, a, lanes);
+    RunStage(X11_STAGE(shavite), nullptr, a, b, lanes);
+    RunStage(X11_STAGE(simd), nullptr, b, a, lanes);
+    RunStage(X11_STAGE(echo), nullptr, a, b, lanes);
+
+    for (size_t i = 0; i < lanes; ++i) {
+        memcpy(out + 32 * i, a + 64 * i, 32);
+    }
+}
+
+bool SelfTest()
+{
+    // Some deterministic input data to test with.
+    unsigned char data[BATCH_LANES * 64];
+    for (size_t i = 0; i < sizeof(data); ++i) {
+        data[i] = (unsigned char)(i * 37 + 11);
+    }
+
+    // Every multi-lane kernel must match its single-lane counterpart.
+    if (Keccak512_4way) {
+        unsigned char expected[256], out[256];
+        for (size_t i = 0; i < 4; ++i) {
+            X11_STAGE(keccak)(expected + 64 * i, data + 64 * i, 64);
+        }
+        Keccak512_4way(out, data);
+        if (memcmp(out, expected, sizeof(out)) != 0) return false;
+    }
+
+    return true;
+}
+
+#if defined(USE_ASM) && (defined(__x86_64__) || defined(__amd64__) || defined(__i386__))
+/** Check whether the OS has enabled AVX registers. */
+bool AVXEnabled()
+{
+    uint32_t a, d;
+    __asm__("xgetbv" : "=a"(a), "=d"(d) : "c"(0));
+    return (a & 6) == 6;
+}
+#endif
+} // namespace
+
+std::string X11AutoDetect()
+{
+    std::string ret = "standard";
+#if defined(USE_ASM) && defined(HAVE_GETCPUID)
+    bool have_xsave = false;
+    bool have_avx = false;
+    [[maybe_unused]] bool have_avx2 = false;
+    [[maybe_unused]] bool enabled_avx = false;
+
+    uint32_t eax, ebx, ecx, edx;
+    GetCPUID(1, 0, eax, ebx, ecx, edx);
+    have_xsave = (ecx >> 27) & 1;
+    have_avx = (ecx >> 28) & 1;
+    if (have_xsave && have_avx) {
+        enabled_avx = AVXEnabled();
+    }
+    GetCPUID(7, 0, eax, ebx, ecx, edx);
+    have_avx2 = (ebx >> 5) & 1;
+
+#if defined(ENABLE_AVX2) && !defined(BUILD_BITCOIN_INTERNAL)
+    if (have_avx2 && have_avx && enabled_avx) {
+        Keccak512_4way = x11_avx2::Keccak512_64_4way;
+        ret = "avx2(keccak 4way)";
+    }
+#endif
+#endif // defined(USE_ASM) && defined(HAVE_GETCPUID)
+
+    assert(SelfTest());
+    return ret;
+}
+
+void X11Hash80(unsigned char* out, const unsigned char* in, size_t blocks)
+{
+    while (blocks > 0) {
+        const size_t lanes = blocks < BATCH_LANES ? blocks : BATCH_LANES;
+        X11Hash80Lanes(out, in, lanes);
+        out += 32 * lanes;
+        in += 80 * lanes;
+        blocks -= lanes;
+    }
+}
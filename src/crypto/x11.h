@@ -0,0 +1,23 @@
+// Copyright (c) 2024 The Maximus developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_CRYPTO_X11_H
+#define BITCOIN_CRYPTO_X11_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+
+/** Autodetect the best available multi-lane X11 kernels. Returns the name of the selected implementation. */
+std::string X11AutoDetect();
+
+/**
+ * Compute the X11 hash of `blocks` consecutive 80-byte inputs (block headers).
+ * The (trimmed) 32-byte result for input i is written to out + 32 * i.
+ * Stages with a multi-lane kernel process several headers at once; the result is
+ * identical to calling HashX11 on every input separately.
+ */
+void X11Hash80(unsigned char* out, const unsigned char* in, size_t blocks);
+
+#endif // BITCOIN_CRYPTO_X11_H
@@ -0,0 +1,92 @@
+// Copyright (c) 2024 The Maximus developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifdef ENABLE_AVX2
+
+#include <stdint.h>
+#include <immintrin.h>
+
+#include <crypto/common.h>
+
+namespace x11_avx2 {
+namespace {
+
+const uint64_t RC[24] = {
+    0x0000000000000001ull, 0x0000000000008082ull, 0x800000000000808aull, 0x8000000080008000ull,
+    0x000000000000808bull, 0x0000000080000001ull, 0x8000000080008081ull, 0x8000000000008009ull,
+    0x000000000000008aull, 0x0000000000000088ull, 0x0000000080008009ull, 0x000000008000000aull,
+    0x000000008000808bull, 0x800000000000008bull, 0x8000000000008089ull, 0x8000000000008003ull,
+    0x8000000000008002ull, 0x8000000000000080ull, 0x000000000000800aull, 0x800000008000000aull,
+    0x8000000080008081ull, 0x8000000000008080ull, 0x0000000080000001ull, 0x8000000080008008ull,
+};
+
+/** Rho rotation offsets, in pi lane order. */
+const int ROTC[24] = {1, 3, 6, 10, 15, 21, 28, 36, 45, 55, 2, 14, 27, 41, 56, 8, 25, 43, 62, 18, 39, 61, 20, 44};
+/** Pi lane permutation. */
+const int PILN[24] = {10, 7, 11, 17, 18, 3, 5, 16, 8, 21, 24, 4, 15, 23, 19, 13, 12, 2, 20, 14, 22, 9, 6, 1};
+
+__m256i inline Xor(__m256i x, __m256i y) { return _mm256_xor_si256(x, y); }
+__m256i inline AndNot(__m256i x, __m256i y) { return _mm256_andnot_si256(x, y); }
+__m256i inline Rol(__m256i x, int n) { return _mm256_or_si256(_mm256_sllv_epi64(x, _mm256_set1_epi64x(n)), _mm256_srlv_epi64(x, _mm256_set1_epi64x(64 - n))); }
+
+/** Keccak-f[1600] on four interleaved states. */
+void inline __attribute__((always_inline)) KeccakF(__m256i* a)
+{
+    __m256i c[5], t;
+    for (int round = 0; round < 24; ++round) {
+        // Theta
+        for (int i = 0; i < 5; ++i) c[i] = Xor(Xor(Xor(a[i], a[i + 5]), Xor(a[i + 10], a[i + 15])), a[i + 20]);
+        for (int i = 0; i < 5; ++i) {
+            t = Xor(c[(i + 4) % 5], Rol(c[(i + 1) % 5], 1));
+            for (int j = 0; j < 25; j += 5) a[j + i] = Xor(a[j + i], t);
+        }
+        // Rho and pi
+        t = a[1];
+        for (int i = 0; i < 24; ++i) {
+            const int j = PILN[i];
+            c[0] = a[j];
+            a[j] = Rol(t, ROTC[i]);
+            t = c[0];
+        }
+        // Chi
+        for (int j = 0; j < 25; j += 5) {
+            for (int i = 0; i < 5; ++i) c[i] = a[j + i];
+            for (int i = 0; i < 5; ++i) a[j + i] = Xor(a[j + i], AndNot(c[(i + 1) % 5], c[(i + 2) % 5]));
+        }
+        // Iota
+        a[0] = Xor(a[0], _mm256_set1_epi64x(RC[round]));
+    }
+}
+
+} // namespace
+
+/**
+ * Keccak-512 (original Keccak padding, as implemented by sph_keccak512) of four
+ * independent 64-byte messages. `in` and `out` hold the four messages back to back.
+ */
+void Keccak512_64_4way(unsigned char* out, const unsigned char* in)
+{
+    __m256i a[25];
+    for (int i = 0; i < 8; ++i) {
+        a[i] = _mm256_set_epi64x(ReadLE64(in + 192 + 8 * i), ReadLE64(in + 128 + 8 * i), ReadLE64(in + 64 + 8 * i), ReadLE64(in + 8 * i));
+    }
+    // The 64-byte message and its padding fit in a single 72-byte block.
+    a[8] = _mm256_set1_epi64x(0x8000000000000001ull);
+    for (int i = 9; i < 25; ++i) a[i] = _mm256_setzero_si256();
+
+    KeccakF(a);
+
+    alignas(32) uint64_t lanes[4];
+    for (int i = 0; i < 8; ++i) {
+        _mm256_store_si256((__m256i*)lanes, a[i]);
+        WriteLE64(out + 8 * i, lanes[0]);
+        WriteLE64(out + 64 + 8 * i, lanes[1]);
+        WriteLE64(out + 128 + 8 * i, lanes[2]);
+        WriteLE64(out + 192 + 8 * i, lanes[3]);
+    }
+}
+
+} // namespace x11_avx2
+
+#endif
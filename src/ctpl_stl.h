@@ -62,6 +62,10 @@ namespace ctpl {
                 std::unique_lock<std::mutex> lock(this->mutex);
                 return this->q.empty();
             }
+            size_t size() {
+                std::unique_lock<std::mutex> lock(this->mutex);
+                return this->q.size();
+            }
         private:
             std::queue<T> q;
             std::mutex mutex;
@@ -85,6 +89,8 @@ namespace ctpl {
 
         // number of idle threads
         int n_idle() { return this->nWaiting; }
+        // number of queued functors which no thread has picked up yet
+        size_t queue_size() { return this->q.size(); }
         std::thread & get_thread(int i) { return *this->threads[i]; }
 
         // change the number of threads in the pool
@@ -21,6 +21,11 @@ namespace bls {
         G2Element SignatureShare(const std::vector<G2Element>& sks, const Bytes& id);
         G2Element SignatureRecover(const std::vector<G2Element>& sigs, const std::vector<Bytes>& ids);
 
+        // The Lagrange coefficients used by the *Recover functions for the given ids, as big endian numbers of
+        // 32 bytes. They only depend on the ids, recovering from the same ids again can reuse them.
+        std::vector<std::vector<uint8_t>> LagrangeCoefficients(const std::vector<Bytes>& ids);
+        G2Element SignatureRecoverWithCoefficients(const std::vector<G2Element>& sigs, const std::vector<std::vector<uint8_t>>& coefficients);
+
         G2Element Sign(const PrivateKey& privateKey, const Bytes& vecMessage);
         bool Verify(const G1Element& pubKey, const Bytes& vecMessage, const G2Element& signature);
     } // end namespace Threshold
@@ -88,6 +88,9 @@ namespace bls {
 
         template <typename BLSType>
         BLSType LagrangeInterpolate(const std::vector<BLSType>& vec, const std::vector<Bytes>& ids);
+
+        template <typename BLSType>
+        BLSType LinearCombination(const std::vector<BLSType>& vec, const std::vector<std::vector<uint8_t>>& coefficients);
     } // end namespace Poly
 
     struct PolyOpsBase {
@@ -186,29 +189,20 @@ namespace bls {
         return y;
     }
 
-    template<typename BLSType>
-    BLSType Poly::LagrangeInterpolate(const std::vector<BLSType>& vec, const std::vector<Bytes>& ids) {
-        typedef PolyOps<BLSType> Ops;
-        Ops ops;
-
-        if (vec.size() < 2) {
-            throw std::length_error("At least 2 shares required");
-        }
-        if (vec.size() != ids.size()) {
-            throw std::length_error("Numbers of shares and ids must be equal");
-        }
-
+    /*
+        Computes the Lagrange coefficients delta_{i,S}(0) for all ids into delta, which must hold ids.size()
+        initialized numbers.
+    */
+    static void LagrangeCoefficients(PolyOpsBase& ops, bn_t* delta, const std::vector<Bytes>& ids) {
         /*
             delta_{i,S}(0) = prod_{j != i} S[j] / (S[j] - S[i]) = a / b
             where a = prod S[j], b = S[i] * prod_{j != i} (S[j] - S[i])
         */
-        const size_t k = vec.size();
+        const size_t k = ids.size();
 
-        bn_t *delta = new bn_t[k];
         bn_t *ids2 = new bn_t[k];
 
         for (size_t i = 0; i < k; i++) {
-            bn_new(delta[i]);
             bn_new(ids2[i]);
             bn_read_bin(ids2[i], ids[i].begin(), Poly::nIdSize);
             ops.ModOrder(ids2[i]);
@@ -224,10 +218,8 @@ namespace bls {
             bn_free(b);
             bn_free(v);
             for (size_t i = 0; i < k; i++) {
-                bn_free(delta[i]);
                 bn_free(ids2[i]);
             }
-            delete[] delta;
             delete[] ids2;
         };
 
@@ -254,6 +246,42 @@ namespace bls {
             ops.DivFP(delta[i], a, b);
         }
 
+        cleanup();
+    }
+
+    template<typename BLSType>
+    BLSType Poly::LagrangeInterpolate(const std::vector<BLSType>& vec, const std::vector<Bytes>& ids) {
+        typedef PolyOps<BLSType> Ops;
+        Ops ops;
+
+        if (vec.size() < 2) {
+            throw std::length_error("At least 2 shares required");
+        }
+        if (vec.size() != ids.size()) {
+            throw std::length_error("Numbers of shares and ids must be equal");
+        }
+
+        const size_t k = vec.size();
+
+        bn_t *delta = new bn_t[k];
+        for (size_t i = 0; i < k; i++) {
+            bn_new(delta[i]);
+        }
+
+        auto cleanup = [&](){
+            for (size_t i = 0; i < k; i++) {
+                bn_free(delta[i]);
+            }
+            delete[] delta;
+        };
+
+        try {
+            LagrangeCoefficients(ops, delta, ids);
+        } catch (...) {
+            cleanup();
+            throw;
+        }
+
         /*
             f(0) = sum_i f(S[i]) delta_{i,S}(0)
         */
@@ -267,6 +295,69 @@ namespace bls {
         return r;
     }
 
+    template<typename BLSType>
+    BLSType Poly::LinearCombination(const std::vector<BLSType>& vec, const std::vector<std::vector<uint8_t>>& coefficients) {
+        typedef PolyOps<BLSType> Ops;
+        Ops ops;
+
+        if (vec.size() < 2) {
+            throw std::length_error("At least 2 shares required");
+        }
+        if (vec.size() != coefficients.size()) {
+            throw std::length_error("Numbers of shares and coefficients must be equal");
+        }
+
+        bn_t c;
+        bn_new(c);
+
+        BLSType r;
+        for (size_t i = 0; i < vec.size(); i++) {
+            bn_read_bin(c, coefficients[i].data(), coefficients[i].size());
+            r = ops.Add(r, ops.Mul(vec[i], c));
+        }
+
+        bn_free(c);
+
+        return r;
+    }
+
+    std::vector<std::vector<uint8_t>> Threshold::LagrangeCoefficients(const std::vector<Bytes>& ids) {
+        PolyOpsBase ops;
+
+        if (ids.size() < 2) {
+            throw std::length_error("At least 2 shares required");
+        }
+
+        const size_t k = ids.size();
+
+        bn_t *delta = new bn_t[k];
+        for (size_t i = 0; i < k; i++) {
+            bn_new(delta[i]);
+        }
+
+        auto cleanup = [&](){
+            for (size_t i = 0; i < k; i++) {
+                bn_free(delta[i]);
+            }
+            delete[] delta;
+        };
+
+        std::vector<std::vector<uint8_t>> coefficients(k, std::vector<uint8_t>(Poly::nIdSize));
+        try {
+            bls::LagrangeCoefficients(ops, delta, ids);
+            for (size_t i = 0; i < k; i++) {
+                bn_write_bin(coefficients[i].data(), Poly::nIdSize, delta[i]);
+            }
+        } catch (...) {
+            cleanup();
+            throw;
+        }
+
+        cleanup();
+
+        return coefficients;
+    }
+
     PrivateKey Threshold::PrivateKeyShare(const std::vector<PrivateKey>& sks, const Bytes& id) {
         return Poly::Evaluate(sks, id);
     }
@@ -290,6 +381,10 @@ namespace bls {
     G2Element Threshold::SignatureRecover(const std::vector<G2Element>& sigs, const std::vector<Bytes>& ids) {
         return Poly::LagrangeInterpolate(sigs, ids);
     }
+
+    G2Element Threshold::SignatureRecoverWithCoefficients(const std::vector<G2Element>& sigs, const std::vector<std::vector<uint8_t>>& coefficients) {
+        return Poly::LinearCombination(sigs, coefficients);
+    }
     
     G2Element Threshold::Sign(const PrivateKey& privateKey, const Bytes& vecMessage) {
         return pThresholdScheme->Sign(privateKey, vecMessage);
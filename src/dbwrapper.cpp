@@ -4,16 +4,138 @@
 
 #include <dbwrapper.h>
 
+#include <ctpl_stl.h>
 #include <memory>
 #include <random.h>
 
+#include <sync.h>
+#include <util/string.h>
+#include <util/thread.h>
+
 #include <leveldb/cache.h>
 #include <leveldb/env.h>
 #include <leveldb/filter_policy.h>
 #include <leveldb/helpers/memenv/memenv.h>
 #include <stdint.h>
 #include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <deque>
+#include <future>
 #include <optional>
+#include <set>
+
+/** Block cache of a single database, forwarding to a possibly shared LevelDB cache and counting lookups */
+class CountingCache final : public leveldb::Cache
+{
+public:
+    CountingCache(std::shared_ptr<leveldb::Cache> cache, size_t capacity) : m_cache(std::move(cache)), m_capacity(capacity) {}
+
+    Handle* Insert(const leveldb::Slice& key, void* value, size_t charge, void (*deleter)(const leveldb::Slice& key, void* value)) override
+    {
+        return m_cache->Insert(key, value, charge, deleter);
+    }
+    Handle* Lookup(const leveldb::Slice& key) override
+    {
+        Handle* handle = m_cache->Lookup(key);
+        ++(handle ? m_hits : m_misses);
+        return handle;
+    }
+    void Release(Handle* handle) override { m_cache->Release(handle); }
+    void* Value(Handle* handle) override { return m_cache->Value(handle); }
+    void Erase(const leveldb::Slice& key) override { m_cache->Erase(key); }
+    // Ids keep the entries of the databases sharing a cache apart
+    uint64_t NewId() override { return m_cache->NewId(); }
+    void Prune() override { m_cache->Prune(); }
+    size_t TotalCharge() const override { return m_cache->TotalCharge(); }
+
+    size_t Capacity() const { return m_capacity; }
+    uint64_t Hits() const { return m_hits; }
+    uint64_t Misses() const { return m_misses; }
+
+private:
+    const std::shared_ptr<leveldb::Cache> m_cache;
+    const size_t m_capacity;
+    std::atomic<uint64_t> m_hits{0};
+    std::atomic<uint64_t> m_misses{0};
+};
+
+/**
+ * LevelDB runs the compactions of all databases on the single background thread of Env::Default(), so a database
+ * flushing a lot (the chainstate during IBD) holds back the compactions of the others until their writes stall too.
+ * This environment gives a database a compaction thread of its own.
+ */
+class CompactionThreadEnv final : public leveldb::EnvWrapper
+{
+private:
+    Mutex m_mutex;
+    std::condition_variable m_cond;
+    std::deque<std::pair<void (*)(void*), void*>> m_queue GUARDED_BY(m_mutex);
+    bool m_stop GUARDED_BY(m_mutex){false};
+    std::thread m_thread;
+
+    void Run()
+    {
+        while (true) {
+            std::pair<void (*)(void*), void*> work;
+            {
+                WAIT_LOCK(m_mutex, lock);
+                m_cond.wait(lock, [&]() EXCLUSIVE_LOCKS_REQUIRED(m_mutex) { return m_stop || !m_queue.empty(); });
+                if (m_queue.empty()) return;
+                work = m_queue.front();
+                m_queue.pop_front();
+            }
+            work.first(work.second);
+        }
+    }
+
+public:
+    explicit CompactionThreadEnv(leveldb::Env* base) :
+        leveldb::EnvWrapper(base),
+        m_thread(&util::TraceThread, "dbcompact", [this] { Run(); }) {}
+
+    ~CompactionThreadEnv() override
+    {
+        WITH_LOCK(m_mutex, m_stop = true);
+        m_cond.notify_one();
+        m_thread.join();
+    }
+
+    void Schedule(void (*function)(void*), void* arg) override
+    {
+        WITH_LOCK(m_mutex, m_queue.emplace_back(function, arg));
+        m_cond.notify_one();
+    }
+};
+
+// leveldb::config::kL0_SlowdownWritesTrigger and kL0_StopWritesTrigger of the bundled LevelDB
+static constexpr int LEVELDB_L0_SLOWDOWN_TRIGGER = 8;
+static constexpr int LEVELDB_L0_STOP_TRIGGER = 12;
+
+static Mutex g_dbs_mutex;
+static std::shared_ptr<leveldb::Cache> g_shared_cache GUARDED_BY(g_dbs_mutex);
+static size_t g_shared_cache_size GUARDED_BY(g_dbs_mutex){0};
+static std::set<const CDBWrapper*> g_dbs GUARDED_BY(g_dbs_mutex);
+
+void InitSharedDBCache(size_t size)
+{
+    LOCK(g_dbs_mutex);
+    // Databases which are still open keep the previous cache alive
+    g_shared_cache.reset(size ? leveldb::NewLRUCache(size) : nullptr);
+    g_shared_cache_size = size;
+}
+
+std::vector<DBStats> GetDBStats()
+{
+    LOCK(g_dbs_mutex);
+    std::vector<DBStats> ret;
+    for (const CDBWrapper* db : g_dbs) {
+        ret.push_back(db->GetStats());
+    }
+    return ret;
+}
 
 class CBitcoinLevelDBLogger : public leveldb::Logger {
 public:
@@ -73,6 +195,21 @@ public:
     }
 };
 
+//! Number of threads shared by all databases for MultiRead() and MultiExists()
+static constexpr int DBWRAPPER_READ_THREADS = 4;
+//! Batches with fewer keys are looked up on the calling thread only
+static constexpr size_t DBWRAPPER_MIN_PARALLEL_READ_KEYS = 16;
+
+static ctpl::thread_pool& GetReadPool()
+{
+    static const std::unique_ptr<ctpl::thread_pool> pool = [] {
+        auto pool = std::make_unique<ctpl::thread_pool>(DBWRAPPER_READ_THREADS);
+        RenameThreadPool(*pool, "dbread");
+        return pool;
+    }();
+    return *pool;
+}
+
 static void SetMaxOpenFiles(leveldb::Options *options) {
     // On most platforms the default setting of max_open_files (which is 1000)
     // is optimal. On Windows using a large file count is OK because the handles
@@ -98,12 +235,20 @@ static void SetMaxOpenFiles(leveldb::Options *options) {
              options->max_open_files, default_open_files);
 }
 
-static leveldb::Options GetOptions(size_t nCacheSize)
+static leveldb::Options GetOptions(size_t nCacheSize, const DBProfile& profile)
 {
     leveldb::Options options;
-    options.block_cache = leveldb::NewLRUCache(nCacheSize / 2);
-    options.write_buffer_size = nCacheSize / 4; // up to two write buffers may be held in memory simultaneously
-    options.filter_policy = leveldb::NewBloomFilterPolicy(10);
+    {
+        LOCK(g_dbs_mutex);
+        if (profile.shared_cache && g_shared_cache) {
+            options.block_cache = new CountingCache(g_shared_cache, g_shared_cache_size);
+        } else {
+            options.block_cache = new CountingCache(std::shared_ptr<leveldb::Cache>(leveldb::NewLRUCache(nCacheSize / 2)), nCacheSize / 2);
+        }
+    }
+    // up to two write buffers may be held in memory simultaneously
+    options.write_buffer_size = profile.write_buffer_size ? profile.write_buffer_size : nCacheSize / 4;
+    options.filter_policy = profile.bloom_bits > 0 ? leveldb::NewBloomFilterPolicy(profile.bloom_bits) : nullptr;
     options.compression = leveldb::kNoCompression;
     options.info_log = new CBitcoinLevelDBLogger();
     if (leveldb::kMajorVersion > 1 || (leveldb::kMajorVersion == 1 && leveldb::kMinorVersion >= 16)) {
@@ -115,15 +260,16 @@ static leveldb::Options GetOptions(size_t nCacheSize)
     return options;
 }
 
-CDBWrapper::CDBWrapper(const fs::path& path, size_t nCacheSize, bool fMemory, bool fWipe, bool obfuscate)
-    : m_name{path.stem().string()}
+CDBWrapper::CDBWrapper(const fs::path& path, size_t nCacheSize, bool fMemory, bool fWipe, bool obfuscate, const DBProfile& profile)
+    : m_name{path.stem().string()}, m_profile{profile}
 {
     penv = nullptr;
     readoptions.verify_checksums = true;
     iteroptions.verify_checksums = true;
     iteroptions.fill_cache = false;
     syncoptions.sync = true;
-    options = GetOptions(nCacheSize);
+    options = GetOptions(nCacheSize, profile);
+    m_cache = static_cast<CountingCache*>(options.block_cache);
     options.create_if_missing = true;
     if (fMemory) {
         penv = leveldb::NewMemEnv(leveldb::Env::Default());
@@ -137,6 +283,10 @@ CDBWrapper::CDBWrapper(const fs::path& path, size_t nCacheSize, bool fMemory, bo
         TryCreateDirectories(path);
         LogPrintf("Opening LevelDB in %s\n", path.string());
     }
+    if (profile.own_compaction_thread) {
+        m_compaction_env = std::make_unique<CompactionThreadEnv>(options.env);
+        options.env = m_compaction_env.get();
+    }
     leveldb::Status status = leveldb::DB::Open(options, path.string(), &pdb);
     dbwrapper_private::HandleError(status);
     LogPrintf("Opened LevelDB successfully\n");
@@ -165,12 +315,19 @@ CDBWrapper::CDBWrapper(const fs::path& path, size_t nCacheSize, bool fMemory, bo
     }
 
     LogPrintf("Using obfuscation key for %s: %s\n", path.string(), HexStr(obfuscate_key));
+    m_obfuscated = std::any_of(obfuscate_key.begin(), obfuscate_key.end(), [](unsigned char c) { return c != 0; });
+
+    LOCK(g_dbs_mutex);
+    g_dbs.insert(this);
 }
 
 CDBWrapper::~CDBWrapper()
 {
+    WITH_LOCK(g_dbs_mutex, g_dbs.erase(this));
+    // waits for a running compaction, so nothing is scheduled on the compaction thread anymore
     delete pdb;
     pdb = nullptr;
+    m_compaction_env.reset();
     delete options.filter_policy;
     options.filter_policy = nullptr;
     delete options.info_log;
@@ -188,8 +345,18 @@ bool CDBWrapper::WriteBatch(CDBBatch& batch, bool fSync)
     if (log_memory) {
         mem_before = DynamicMemoryUsage() / 1024.0 / 1024;
     }
+    // LevelDB delays writes once level 0 files pile up faster than they are compacted, and stops them at the stop
+    // trigger until compaction catches up
+    const int level0_files{GetLevel0Files()};
+    const auto write_start{std::chrono::steady_clock::now()};
     leveldb::Status status = pdb->Write(fSync ? syncoptions : writeoptions, &batch.batch);
     dbwrapper_private::HandleError(status);
+    if (level0_files >= LEVELDB_L0_SLOWDOWN_TRIGGER) {
+        const auto stall_us{std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - write_start).count()};
+        ++(level0_files >= LEVELDB_L0_STOP_TRIGGER ? m_write_stops : m_write_slowdowns);
+        m_write_stall_us += stall_us;
+        LogPrint(BCLog::LEVELDB, "WriteBatch stalled on %d level 0 files: db=%s, %.2fms\n", level0_files, m_name, stall_us / 1000.0);
+    }
     if (log_memory) {
         double mem_after = DynamicMemoryUsage() / 1024.0 / 1024;
         LogPrint(BCLog::LEVELDB, "WriteBatch memory usage: db=%s, before=%.1fMiB, after=%.1fMiB\n",
@@ -209,6 +376,50 @@ size_t CDBWrapper::DynamicMemoryUsage() const
     return parsed.value();
 }
 
+int CDBWrapper::GetLevel0Files() const
+{
+    std::string files;
+    int parsed{0};
+    if (!pdb->GetProperty("leveldb.num-files-at-level0", &files) || !ParseInt32(files, &parsed)) {
+        return 0;
+    }
+    return parsed;
+}
+
+DBStats CDBWrapper::GetStats() const
+{
+    DBStats stats;
+    stats.name = m_name;
+    stats.shared_cache = m_profile.shared_cache;
+    stats.bloom_bits = m_profile.bloom_bits;
+    stats.write_buffer_size = options.write_buffer_size;
+    stats.cache_size = m_cache->Capacity();
+    stats.cache_usage = m_cache->TotalCharge();
+    stats.cache_hits = m_cache->Hits();
+    stats.cache_misses = m_cache->Misses();
+    stats.memory_usage = DynamicMemoryUsage();
+    stats.own_compaction_thread = m_profile.own_compaction_thread;
+    stats.level0_files = GetLevel0Files();
+    stats.write_slowdowns = m_write_slowdowns;
+    stats.write_stops = m_write_stops;
+    stats.write_stall_us = m_write_stall_us;
+    stats.compaction_seconds = stats.compaction_read_mib = stats.compaction_write_mib = 0;
+    // one "level files size(MB) time(sec) read(MB) write(MB)" row per level below the table header
+    std::string table;
+    if (pdb->GetProperty("leveldb.stats", &table)) {
+        for (const std::string& line : SplitString(table, '\n')) {
+            int level, files;
+            double size_mib, seconds, read_mib, write_mib;
+            if (std::sscanf(line.c_str(), "%d %d %lf %lf %lf %lf", &level, &files, &size_mib, &seconds, &read_mib, &write_mib) == 6) {
+                stats.compaction_seconds += seconds;
+                stats.compaction_read_mib += read_mib;
+                stats.compaction_write_mib += write_mib;
+            }
+        }
+    }
+    return stats;
+}
+
 // Prefixed with null character to avoid collisions with other keys
 //
 // We must use a string constructor which specifies length so that we copy
@@ -228,6 +439,69 @@ std::vector<unsigned char> CDBWrapper::CreateObfuscateKey() const
     return ret;
 }
 
+void CDBWrapper::Deobfuscate(std::string& strValue) const
+{
+    if (!m_obfuscated) return;
+    for (size_t i = 0; i < strValue.size(); i++) {
+        strValue[i] ^= obfuscate_key[i % obfuscate_key.size()];
+    }
+}
+
+bool CDBWrapper::ReadRaw(const CDataStream& ssKey, std::string& strValue) const
+{
+    leveldb::Slice slKey((const char*)ssKey.data(), ssKey.size());
+
+    leveldb::Status status = pdb->Get(readoptions, slKey, &strValue);
+    if (!status.ok()) {
+        if (status.IsNotFound())
+            return false;
+        LogPrintf("LevelDB read failure: %s\n", status.ToString());
+        dbwrapper_private::HandleError(status);
+    }
+    Deobfuscate(strValue);
+    return true;
+}
+
+void CDBWrapper::MultiReadRaw(const std::vector<leveldb::Slice>& keys, std::vector<std::string>& values, std::vector<uint8_t>& found) const
+{
+    values.resize(keys.size());
+    found.assign(keys.size(), 0);
+
+    // Runs on the read threads, errors are handled on the calling thread once all lookups are done
+    auto read_range = [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i++) {
+            leveldb::Status status = pdb->Get(readoptions, keys[i], &values[i]);
+            if (!status.ok()) {
+                if (status.IsNotFound()) continue;
+                return status;
+            }
+            Deobfuscate(values[i]);
+            found[i] = 1;
+        }
+        return leveldb::Status::OK();
+    };
+
+    size_t chunk_size = keys.size();
+    std::vector<std::future<leveldb::Status>> futures;
+    if (keys.size() >= DBWRAPPER_MIN_PARALLEL_READ_KEYS) {
+        chunk_size = (keys.size() + DBWRAPPER_READ_THREADS) / (DBWRAPPER_READ_THREADS + 1);
+        ctpl::thread_pool& pool = GetReadPool();
+        for (size_t begin = chunk_size; begin < keys.size(); begin += chunk_size) {
+            const size_t end = std::min(begin + chunk_size, keys.size());
+            futures.emplace_back(pool.push([&read_range, begin, end](int) { return read_range(begin, end); }));
+        }
+    }
+    leveldb::Status status = read_range(0, std::min(chunk_size, keys.size()));
+    for (auto& future : futures) {
+        leveldb::Status chunk_status = future.get();
+        if (status.ok()) status = chunk_status;
+    }
+    if (!status.ok()) {
+        LogPrintf("LevelDB read failure: %s\n", status.ToString());
+        dbwrapper_private::HandleError(status);
+    }
+}
+
 bool CDBWrapper::IsEmpty()
 {
     std::unique_ptr<CDBIterator> it(NewIterator());
@@ -257,4 +531,9 @@ const std::vector<unsigned char>& GetObfuscateKey(const CDBWrapper &w)
     return w.obfuscate_key;
 }
 
+bool IsObfuscated(const CDBWrapper &w)
+{
+    return w.m_obfuscated;
+}
+
 } // namespace dbwrapper_private
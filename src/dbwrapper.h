@@ -13,7 +13,11 @@
 #include <util/strencodings.h>
 #include <util/system.h>
 
+#include <atomic>
+#include <memory>
+#include <optional>
 #include <typeindex>
+#include <vector>
 
 #include <leveldb/db.h>
 #include <leveldb/write_batch.h>
@@ -28,6 +32,53 @@ public:
 };
 
 class CDBWrapper;
+class CountingCache;
+
+/** LevelDB tuning of a single database */
+struct DBProfile {
+    //! Bits per key of the bloom filter used to skip tables not holding a key, 0 disables it
+    int bloom_bits{10};
+    //! Size of the write buffer, 0 uses a quarter of the cache size
+    size_t write_buffer_size{0};
+    //! Use the block cache shared between databases instead of a private one of half the cache size
+    bool shared_cache{false};
+    //! Run compactions on a thread of its own instead of the one LevelDB shares between all databases
+    bool own_compaction_thread{false};
+};
+
+/** Point in time statistics of an open database, see GetDBStats() */
+struct DBStats {
+    std::string name;
+    bool shared_cache;
+    int bloom_bits;
+    size_t write_buffer_size;
+    //! Capacity and current usage of the block cache used by the database (the whole shared cache if shared)
+    size_t cache_size;
+    size_t cache_usage;
+    //! Block cache lookups done by this database
+    uint64_t cache_hits;
+    uint64_t cache_misses;
+    size_t memory_usage;
+    bool own_compaction_thread;
+    int level0_files;
+    //! Writes LevelDB delayed or stopped because too many level 0 files were waiting for compaction, and the time they took
+    uint64_t write_slowdowns;
+    uint64_t write_stops;
+    uint64_t write_stall_us;
+    //! Time spent compacting and data compacted since the database was opened, as reported by LevelDB
+    double compaction_seconds;
+    double compaction_read_mib;
+    double compaction_write_mib;
+};
+
+/**
+ * Set up the block cache shared by the databases opened afterwards with a DBProfile::shared_cache
+ * profile. Without this (or with a size of 0) such databases use a private cache.
+ */
+void InitSharedDBCache(size_t size);
+
+/** Statistics of all open databases */
+std::vector<DBStats> GetDBStats();
 
 /** These should be considered an implementation detail of the specific database.
  */
@@ -43,6 +94,9 @@ void HandleError(const leveldb::Status& status);
  */
 const std::vector<unsigned char>& GetObfuscateKey(const CDBWrapper &w);
 
+/** Whether values of the database need to be deobfuscated before they can be deserialized */
+bool IsObfuscated(const CDBWrapper &w);
+
 };
 
 /** Batch of changes queued to be written to a CDBWrapper */
@@ -158,9 +212,9 @@ public:
     void Next();
 
     template<typename K> bool GetKey(K& key) {
+        leveldb::Slice slKey = piter->key();
         try {
-            CDataStream ssKey = GetKey();
-            ssKey >> key;
+            SpanReader{SER_DISK, CLIENT_VERSION, MakeUCharSpan(slKey), 0} >> key;
         } catch (const std::exception&) {
             return false;
         }
@@ -179,6 +233,11 @@ public:
     template<typename V> bool GetValue(V& value) {
         leveldb::Slice slValue = piter->value();
         try {
+            if (!dbwrapper_private::IsObfuscated(parent)) {
+                // Nothing to undo, deserialize straight from the buffer of the iterator
+                SpanReader{SER_DISK, CLIENT_VERSION, MakeUCharSpan(slValue), 0} >> value;
+                return true;
+            }
             CDataStream ssValue{MakeByteSpan(slValue), SER_DISK, CLIENT_VERSION};
             ssValue.Xor(dbwrapper_private::GetObfuscateKey(parent));
             ssValue >> value;
@@ -197,6 +256,7 @@ public:
 class CDBWrapper
 {
     friend const std::vector<unsigned char>& dbwrapper_private::GetObfuscateKey(const CDBWrapper &w);
+    friend bool dbwrapper_private::IsObfuscated(const CDBWrapper &w);
 private:
     //! custom environment this database is using (may be nullptr in case of default environment)
     leveldb::Env* penv;
@@ -222,9 +282,27 @@ private:
     //! the name of this database
     std::string m_name;
 
+    //! tuning the database was opened with
+    DBProfile m_profile;
+
+    //! the block cache in options, counting the lookups of this database
+    CountingCache* m_cache{nullptr};
+
+    //! environment running the compactions of this database if it has its own compaction thread
+    std::unique_ptr<leveldb::Env> m_compaction_env;
+
+    std::atomic<uint64_t> m_write_slowdowns{0};
+    std::atomic<uint64_t> m_write_stops{0};
+    std::atomic<uint64_t> m_write_stall_us{0};
+
+    int GetLevel0Files() const;
+
     //! a key used for optional XOR-obfuscation of the database
     std::vector<unsigned char> obfuscate_key;
 
+    //! whether obfuscate_key is not all zeros
+    bool m_obfuscated{false};
+
     //! the key under which the obfuscation key is stored
     static const std::string OBFUSCATE_KEY_KEY;
 
@@ -233,6 +311,39 @@ private:
 
     std::vector<unsigned char> CreateObfuscateKey() const;
 
+    //! Serialize keys back to back into ssKeys and return a slice for each of them
+    template <typename K>
+    static std::vector<leveldb::Slice> SerializeKeys(const std::vector<K>& keys, CDataStream& ssKeys)
+    {
+        std::vector<size_t> ends;
+        ends.reserve(keys.size());
+        ssKeys.reserve(keys.size() * DBWRAPPER_PREALLOC_KEY_SIZE);
+        for (const K& key : keys) {
+            ssKeys << key;
+            ends.push_back(ssKeys.size());
+        }
+        std::vector<leveldb::Slice> slKeys;
+        slKeys.reserve(keys.size());
+        size_t begin = 0;
+        for (size_t end : ends) {
+            slKeys.emplace_back((const char*)ssKeys.data() + begin, end - begin);
+            begin = end;
+        }
+        return slKeys;
+    }
+
+    /**
+     * Look up all keys, on the database read threads if there are enough of them. found[i] is
+     * set if keys[i] exists, in which case values[i] holds its deobfuscated value.
+     */
+    void MultiReadRaw(const std::vector<leveldb::Slice>& keys, std::vector<std::string>& values, std::vector<uint8_t>& found) const;
+
+    //! Undo the obfuscation of a value read from the database in place
+    void Deobfuscate(std::string& strValue) const;
+
+    //! Look up a serialized key and deobfuscate its value in place, false if it doesn't exist
+    bool ReadRaw(const CDataStream& ssKey, std::string& strValue) const;
+
 public:
     /**
      * @param[in] path        Location in the filesystem where leveldb data will be stored.
@@ -241,8 +352,9 @@ public:
      * @param[in] fWipe       If true, remove all existing data.
      * @param[in] obfuscate   If true, store data obfuscated via simple XOR. If false, XOR
      *                        with a zero'd byte array.
+     * @param[in] profile     LevelDB tuning of this database.
      */
-    CDBWrapper(const fs::path& path, size_t nCacheSize, bool fMemory = false, bool fWipe = false, bool obfuscate = false);
+    CDBWrapper(const fs::path& path, size_t nCacheSize, bool fMemory = false, bool fWipe = false, bool obfuscate = false, const DBProfile& profile = {});
     ~CDBWrapper();
 
     CDBWrapper(const CDBWrapper&) = delete;
@@ -259,19 +371,11 @@ public:
 
     bool ReadDataStream(const CDataStream& ssKey, CDataStream& ssValue) const
     {
-        leveldb::Slice slKey((const char*)ssKey.data(), ssKey.size());
-
         std::string strValue;
-        leveldb::Status status = pdb->Get(readoptions, slKey, &strValue);
-        if (!status.ok()) {
-            if (status.IsNotFound())
-                return false;
-            LogPrintf("LevelDB read failure: %s\n", status.ToString());
-            dbwrapper_private::HandleError(status);
+        if (!ReadRaw(ssKey, strValue)) {
+            return false;
         }
-        CDataStream ssValueTmp{MakeByteSpan(strValue), SER_DISK, CLIENT_VERSION};
-        ssValueTmp.Xor(obfuscate_key);
-        ssValue = std::move(ssValueTmp);
+        ssValue = CDataStream{MakeByteSpan(strValue), SER_DISK, CLIENT_VERSION};
         return true;
     }
 
@@ -287,19 +391,55 @@ public:
     template <typename V>
     bool Read(const CDataStream& ssKey, V& value) const
     {
-        CDataStream ssValue(SER_DISK, CLIENT_VERSION);
-        if (!ReadDataStream(ssKey, ssValue)) {
+        // Deserialize straight from the value LevelDB returned instead of copying it into a stream first
+        std::string strValue;
+        if (!ReadRaw(ssKey, strValue)) {
             return false;
         }
 
         try {
-            ssValue >> value;
+            SpanReader{SER_DISK, CLIENT_VERSION, MakeUCharSpan(strValue), 0} >> value;
         } catch (const std::exception&) {
             return false;
         }
         return true;
     }
 
+    /**
+     * Read the values of several keys at once. values[i] is set if keys[i] was found and its
+     * value could be deserialized.
+     */
+    template <typename K, typename V>
+    void MultiRead(const std::vector<K>& keys, std::vector<std::optional<V>>& values) const
+    {
+        CDataStream ssKeys(SER_DISK, CLIENT_VERSION);
+        std::vector<std::string> strValues;
+        std::vector<uint8_t> found;
+        MultiReadRaw(SerializeKeys(keys, ssKeys), strValues, found);
+
+        values.assign(keys.size(), std::nullopt);
+        for (size_t i = 0; i < keys.size(); i++) {
+            if (!found[i]) continue;
+            try {
+                V value;
+                SpanReader{SER_DISK, CLIENT_VERSION, MakeUCharSpan(strValues[i]), 0} >> value;
+                values[i] = std::move(value);
+            } catch (const std::exception&) {
+            }
+        }
+    }
+
+    /** Check for several keys at once, element i of the result tells if keys[i] exists. */
+    template <typename K>
+    std::vector<bool> MultiExists(const std::vector<K>& keys) const
+    {
+        CDataStream ssKeys(SER_DISK, CLIENT_VERSION);
+        std::vector<std::string> strValues;
+        std::vector<uint8_t> found;
+        MultiReadRaw(SerializeKeys(keys, ssKeys), strValues, found);
+        return {found.begin(), found.end()};
+    }
+
     template <typename K, typename V>
     bool Write(const K& key, const V& value, bool fSync = false)
     {
@@ -345,11 +485,30 @@ public:
     // Get an estimate of LevelDB memory usage (in bytes).
     size_t DynamicMemoryUsage() const;
 
+    DBStats GetStats() const;
+
     CDBIterator *NewIterator()
     {
         return new CDBIterator(*this, pdb->NewIterator(iteroptions));
     }
 
+    /** Take a snapshot of the current state of the database, which is released with its last reference. */
+    std::shared_ptr<const leveldb::Snapshot> GetSnapshot() const
+    {
+        leveldb::DB* db = pdb;
+        return std::shared_ptr<const leveldb::Snapshot>(pdb->GetSnapshot(), [db](const leveldb::Snapshot* snapshot) {
+            db->ReleaseSnapshot(snapshot);
+        });
+    }
+
+    /** Iterator reading the state of the snapshot, which must outlive it. */
+    CDBIterator *NewIterator(const leveldb::Snapshot& snapshot) const
+    {
+        leveldb::ReadOptions options = iteroptions;
+        options.snapshot = &snapshot;
+        return new CDBIterator(*this, pdb->NewIterator(options));
+    }
+
     /**
      * Return true if the database managed by this class contains no entries.
      */
@@ -11,6 +11,7 @@
 #include <dsnotificationinterface.h>
 #include <governance/governance.h>
 #include <masternode/sync.h>
+#include <node/chainsnapshot.h>
 #include <validation.h>
 
 #include <evo/deterministicmns.h>
@@ -48,10 +49,16 @@ void CDSNotificationInterface::NotifyHeaderTip(const CBlockIndex *pindexNew, boo
 
 void CDSNotificationInterface::SynchronousUpdatedBlockTip(const CBlockIndex *pindexNew, const CBlockIndex *pindexFork, bool fInitialDownload)
 {
-    if (pindexNew == pindexFork) // blocks were disconnected without any new ones
+    if (pindexNew == pindexFork) { // blocks were disconnected without any new ones
+        // still drop the tallies the disconnected blocks invalidated
+        govman.UpdatedMasternodeListTip();
         return;
+    }
 
     dmnman->UpdatedBlockTip(pindexNew);
+    PublishChainTip(pindexNew, dmnman->GetListForBlock(pindexNew));
+    // tallies are only recounted against the new tip list from here on
+    govman.UpdatedMasternodeListTip();
 }
 
 void CDSNotificationInterface::UpdatedBlockTip(const CBlockIndex *pindexNew, const CBlockIndex *pindexFork, bool fInitialDownload)
@@ -113,7 +120,7 @@ void CDSNotificationInterface::BlockDisconnected(const std::shared_ptr<const CBl
 void CDSNotificationInterface::NotifyMasternodeListChanged(bool undo, const CDeterministicMNList& oldMNList, const CDeterministicMNListDiff& diff)
 {
     CMNAuth::NotifyMasternodeListChanged(undo, oldMNList, diff, connman);
-    govman.UpdateCachesAndClean();
+    govman.NotifyMasternodeListChanged(undo, oldMNList, diff);
 }
 
 void CDSNotificationInterface::NotifyChainLock(const CBlockIndex* pindex, const std::shared_ptr<const llmq::CChainLockSig>& clsig)
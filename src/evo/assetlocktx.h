@@ -13,9 +13,11 @@
 #include <univalue.h>
 
 #include <optional>
+#include <vector>
 
 class CBlockIndex;
 class CRangesSet;
+class CSpecialTxSigCheck;
 class TxValidationState;
 
 class CAssetLockPayload
@@ -127,7 +129,8 @@ public:
         return obj;
     }
 
-    bool VerifySig(const uint256& msgHash, gsl::not_null<const CBlockIndex*> pindexTip, TxValidationState& state) const;
+    // If pvChecks is not null, the check of the quorum signature itself is appended to it instead of being run
+    bool VerifySig(const uint256& msgHash, gsl::not_null<const CBlockIndex*> pindexTip, TxValidationState& state, std::vector<CSpecialTxSigCheck>* pvChecks = nullptr) const;
 
     // getters
     uint8_t getVersion() const
@@ -169,8 +172,8 @@ public:
 };
 
 bool CheckAssetLockTx(const CTransaction& tx, TxValidationState& state);
-bool CheckAssetUnlockTx(const CTransaction& tx, gsl::not_null<const CBlockIndex*> pindexPrev, const std::optional<CRangesSet>& indexes, TxValidationState& state);
-bool CheckAssetLockUnlockTx(const CTransaction& tx, gsl::not_null<const CBlockIndex*> pindexPrev, const std::optional<CRangesSet>& indexes, TxValidationState& state);
+bool CheckAssetUnlockTx(const CTransaction& tx, gsl::not_null<const CBlockIndex*> pindexPrev, const std::optional<CRangesSet>& indexes, TxValidationState& state, std::vector<CSpecialTxSigCheck>* pvChecks = nullptr);
+bool CheckAssetLockUnlockTx(const CTransaction& tx, gsl::not_null<const CBlockIndex*> pindexPrev, const std::optional<CRangesSet>& indexes, TxValidationState& state, std::vector<CSpecialTxSigCheck>* pvChecks = nullptr);
 bool GetAssetUnlockFee(const CTransaction& tx, CAmount& txfee, TxValidationState& state);
 
 #endif // BITCOIN_EVO_ASSETLOCKTX_H
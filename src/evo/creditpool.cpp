@@ -27,6 +27,7 @@ CAmount PlatformShare(const CAmount masternodeReward);
 } // namespace MasternodePayments
 
 static const std::string DB_CREDITPOOL_SNAPSHOT = "cpm_S";
+static const std::string DB_CREDITPOOL_UNLOCKED = "cpm_U";
 
 std::unique_ptr<CCreditPoolManager> creditPoolManager;
 
@@ -93,12 +94,11 @@ std::optional<CCreditPool> CCreditPoolManager::GetFromCache(const CBlockIndex& b
             return pool;
         }
     }
-    if (block_index.nHeight % DISK_SNAPSHOT_PERIOD == 0) {
-        if (evoDb.Read(std::make_pair(DB_CREDITPOOL_SNAPSHOT, block_hash), pool)) {
-            LOCK(cache_mutex);
-            creditPoolCache.insert(block_hash, pool);
-            return pool;
-        }
+    // besides the periodic snapshots, recently connected blocks have one as well
+    if (evoDb.Read(std::make_pair(DB_CREDITPOOL_SNAPSHOT, block_hash), pool)) {
+        LOCK(cache_mutex);
+        creditPoolCache.insert(block_hash, pool);
+        return pool;
     }
     return std::nullopt;
 }
@@ -130,11 +130,41 @@ static std::optional<CBlock> GetBlockForCreditPool(const CBlockIndex* const bloc
     return block;
 }
 
+CAmount CCreditPoolManager::GetBlockUnlocked(const CBlockIndex* const block_index, const Consensus::Params& consensusParams)
+{
+    const uint256 block_hash = block_index->GetBlockHash();
+    CAmount unlocked{0};
+    {
+        LOCK(cache_mutex);
+        if (blockUnlockedCache.get(block_hash, unlocked)) {
+            return unlocked;
+        }
+    }
+    if (!evoDb.Read(std::make_pair(DB_CREDITPOOL_UNLOCKED, block_hash), unlocked)) {
+        if (std::optional<CBlock> block = GetBlockForCreditPool(block_index, consensusParams); block) {
+            unlocked = GetDataFromUnlockTxes(block->vtx).unlocked;
+        }
+    }
+    LOCK(cache_mutex);
+    blockUnlockedCache.insert(block_hash, unlocked);
+    return unlocked;
+}
+
 CCreditPool CCreditPoolManager::ConstructCreditPool(const CBlockIndex* const block_index, CCreditPool prev, const Consensus::Params& consensusParams)
 {
-    std::optional<CBlock> block = GetBlockForCreditPool(block_index, consensusParams);
-    if (!block) {
-        // If reading of previous block is not successfully, but
+    CBlock block;
+    if (!ReadBlockFromDisk(block, block_index, consensusParams)) {
+        throw std::runtime_error("failed-getcbforblock-read");
+    }
+    return ConstructCreditPool(block_index, std::move(prev), block, consensusParams);
+}
+
+CCreditPool CCreditPoolManager::ConstructCreditPool(const CBlockIndex* const block_index, CCreditPool prev, const CBlock& block, const Consensus::Params& consensusParams)
+{
+    assert(!block.vtx.empty());
+    // Should not fail if V20 (DIP0027) is active but it happens for RegChain (unit tests)
+    if (block.vtx[0]->nVersion != 3) {
+        // If the block has no CbTx payload, but
         // prev contains credit pool related data, something strange happened
         assert(prev.locked == 0);
         assert(prev.indexes.IsEmpty());
@@ -144,7 +174,7 @@ CCreditPool CCreditPoolManager::ConstructCreditPool(const CBlockIndex* const blo
         return emptyPool;
     }
     CAmount locked = [&, func=__func__]() {
-        const auto opt_cbTx = GetTxPayload<CCbTx>(block->vtx[0]->vExtraPayload);
+        const auto opt_cbTx = GetTxPayload<CCbTx>(block.vtx[0]->vExtraPayload);
         if (!opt_cbTx) {
             throw std::runtime_error(strprintf("%s: failed-getcreditpool-cbtx-payload", func));
         }
@@ -155,7 +185,7 @@ CCreditPool CCreditPoolManager::ConstructCreditPool(const CBlockIndex* const blo
     // current limits for asset unlock transactions.
     // Indexes should not be duplicated since genesis block, but the Unlock Amount
     // of withdrawal transaction is limited only by this window
-    UnlockDataPerBlock blockData = GetDataFromUnlockTxes(block->vtx);
+    UnlockDataPerBlock blockData = GetDataFromUnlockTxes(block.vtx);
     CRangesSet indexes{std::move(prev.indexes)};
     if (std::any_of(blockData.indexes.begin(), blockData.indexes.end(), [&](const uint64_t index) { return !indexes.Add(index); })) {
         throw std::runtime_error(strprintf("%s: failed-getcreditpool-index-duplicated", __func__));
@@ -166,12 +196,7 @@ CCreditPool CCreditPoolManager::ConstructCreditPool(const CBlockIndex* const blo
         distant_block_index = distant_block_index->pprev;
         if (distant_block_index == nullptr) break;
     }
-    CAmount distantUnlocked{0};
-    if (distant_block_index) {
-        if (std::optional<CBlock> distant_block = GetBlockForCreditPool(distant_block_index, consensusParams); distant_block) {
-            distantUnlocked = GetDataFromUnlockTxes(distant_block->vtx).unlocked;
-        }
-    }
+    const CAmount distantUnlocked = distant_block_index ? GetBlockUnlocked(distant_block_index, consensusParams) : 0;
 
     // Unlock limits are # max(100, min(.10 * assetlockpool, 1000)) inside window
     CAmount currentLimit = locked;
@@ -193,8 +218,11 @@ CCreditPool CCreditPoolManager::ConstructCreditPool(const CBlockIndex* const blo
 
     CCreditPool pool{locked, currentLimit, latelyUnlocked, indexes};
     AddToCache(block_index->GetBlockHash(), block_index->nHeight, pool);
+    {
+        LOCK(cache_mutex);
+        blockUnlockedCache.insert(block_index->GetBlockHash(), blockData.unlocked);
+    }
     return pool;
-
 }
 
 CCreditPool CCreditPoolManager::GetCreditPool(const CBlockIndex* block_index, const Consensus::Params& consensusParams)
@@ -214,6 +242,37 @@ CCreditPool CCreditPoolManager::GetCreditPool(const CBlockIndex* block_index, co
     return *poolTmp;
 }
 
+void CCreditPoolManager::ProcessBlock(const CBlock& block, const CBlockIndex* pindex, const Consensus::Params& consensusParams)
+{
+    if (!DeploymentActiveAt(*pindex, consensusParams, Consensus::DEPLOYMENT_V20)) return;
+
+    const uint256 block_hash = pindex->GetBlockHash();
+    // the parent was processed the same way when it was connected, so this is a cache or disk hit
+    const CCreditPool pool = ConstructCreditPool(pindex, GetCreditPool(pindex->pprev, consensusParams), block, consensusParams);
+    evoDb.Write(std::make_pair(DB_CREDITPOOL_SNAPSHOT, block_hash), pool);
+    evoDb.Write(std::make_pair(DB_CREDITPOOL_UNLOCKED, block_hash), GetBlockUnlocked(pindex, consensusParams));
+
+    if (pindex->nHeight <= DISK_SNAPSHOT_KEEP) return;
+    const CBlockIndex* pindexOld = pindex->GetAncestor(pindex->nHeight - DISK_SNAPSHOT_KEEP);
+    assert(pindexOld);
+    if (pindexOld->nHeight % DISK_SNAPSHOT_PERIOD != 0) {
+        evoDb.Erase(std::make_pair(DB_CREDITPOOL_SNAPSHOT, pindexOld->GetBlockHash()));
+    }
+    evoDb.Erase(std::make_pair(DB_CREDITPOOL_UNLOCKED, pindexOld->GetBlockHash()));
+}
+
+void CCreditPoolManager::UndoBlock(const CBlockIndex* pindex)
+{
+    const uint256 block_hash = pindex->GetBlockHash();
+    {
+        LOCK(cache_mutex);
+        creditPoolCache.erase(block_hash);
+        blockUnlockedCache.erase(block_hash);
+    }
+    evoDb.Erase(std::make_pair(DB_CREDITPOOL_SNAPSHOT, block_hash));
+    evoDb.Erase(std::make_pair(DB_CREDITPOOL_UNLOCKED, block_hash));
+}
+
 CCreditPoolManager::CCreditPoolManager(CEvoDB& _evoDb)
 : evoDb(_evoDb)
 {
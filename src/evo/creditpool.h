@@ -20,6 +20,7 @@
 #include <optional>
 #include <unordered_set>
 
+class CBlock;
 class CBlockIndex;
 class BlockValidationState;
 class TxValidationState;
@@ -106,10 +107,14 @@ private:
     static constexpr size_t CreditPoolCacheSize = 1000;
     RecursiveMutex cache_mutex;
     unordered_lru_cache<uint256, CCreditPool, StaticSaltedHasher> creditPoolCache GUARDED_BY(cache_mutex) {CreditPoolCacheSize};
+    // amount unlocked by each block, needed to slide the window of unlock limits without re-reading old blocks
+    unordered_lru_cache<uint256, CAmount, StaticSaltedHasher> blockUnlockedCache GUARDED_BY(cache_mutex) {CreditPoolCacheSize};
 
     CEvoDB& evoDb;
 
     static constexpr int DISK_SNAPSHOT_PERIOD = 576; // once per day
+    // connected blocks get a snapshot on disk too, which is kept for this many blocks (periodic ones stay forever)
+    static constexpr int DISK_SNAPSHOT_KEEP = 2 * DISK_SNAPSHOT_PERIOD;
 
 public:
     static constexpr int LimitBlocksToTrace = 576;
@@ -127,11 +132,22 @@ public:
       */
     CCreditPool GetCreditPool(const CBlockIndex* block, const Consensus::Params& consensusParams);
 
+    /**
+     * Builds the credit pool of a connected block from the pool of its parent and persists it,
+     * so GetCreditPool never has to walk back further than one block on the active chain.
+     * Throws the same exceptions as GetCreditPool.
+     */
+    void ProcessBlock(const CBlock& block, const CBlockIndex* pindex, const Consensus::Params& consensusParams);
+    /** Drops the snapshot of a disconnected block */
+    void UndoBlock(const CBlockIndex* pindex);
+
 private:
     std::optional<CCreditPool> GetFromCache(const CBlockIndex& block_index);
     void AddToCache(const uint256& block_hash, int height, const CCreditPool& pool);
+    CAmount GetBlockUnlocked(const CBlockIndex* block_index, const Consensus::Params& consensusParams);
 
     CCreditPool ConstructCreditPool(const CBlockIndex* block_index, CCreditPool prev, const Consensus::Params& consensusParams);
+    CCreditPool ConstructCreditPool(const CBlockIndex* block_index, CCreditPool prev, const CBlock& block, const Consensus::Params& consensusParams);
 };
 
 std::optional<CCreditPoolDiff> GetCreditPoolDiffForBlock(const CBlock& block, const CBlockIndex* pindexPrev, const Consensus::Params& consensusParams,
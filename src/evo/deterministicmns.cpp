@@ -11,8 +11,12 @@
 #include <llmq/utils.h>
 
 #include <base58.h>
+#include <bls/bls_sigcache.h>
 #include <chainparams.h>
 #include <consensus/validation.h>
+#include <core_memusage.h>
+#include <crypto/sha256.h>
+#include <memusage.h>
 #include <deploymentstatus.h>
 #include <script/standard.h>
 #include <validation.h>
@@ -25,7 +29,9 @@
 #include <memory>
 
 static const std::string DB_LIST_SNAPSHOT = "dmn_S3";
+static const std::string DB_LIST_SNAPSHOT_COMPACT = "dmn_S4";
 static const std::string DB_LIST_DIFF = "dmn_D3";
+static const std::string DB_LIST_UNDO = "dmn_U1";
 
 std::unique_ptr<CDeterministicMNManager> deterministicMNManager;
 
@@ -71,11 +77,7 @@ UniValue CDeterministicMN::ToJson() const
 
 bool CDeterministicMNList::IsMNValid(const uint256& proTxHash) const
 {
-    auto p = mnMap.find(proTxHash);
-    if (p == nullptr) {
-        return false;
-    }
-    return IsMNValid(**p);
+    return mnValidMap.find(proTxHash) != nullptr;
 }
 
 bool CDeterministicMNList::IsMNPoSeBanned(const uint256& proTxHash) const
@@ -108,11 +110,11 @@ CDeterministicMNCPtr CDeterministicMNList::GetMN(const uint256& proTxHash) const
 
 CDeterministicMNCPtr CDeterministicMNList::GetValidMN(const uint256& proTxHash) const
 {
-    auto dmn = GetMN(proTxHash);
-    if (dmn && !IsMNValid(*dmn)) {
+    auto p = mnValidMap.find(proTxHash);
+    if (p == nullptr) {
         return nullptr;
     }
-    return dmn;
+    return *p;
 }
 
 CDeterministicMNCPtr CDeterministicMNList::GetMNByOperatorKey(const CBLSPublicKey& pubKey) const
@@ -179,42 +181,37 @@ static bool CompareByLastPaid(const CDeterministicMN* _a, const CDeterministicMN
     return CompareByLastPaid(*_a, *_b);
 }
 
-CDeterministicMNCPtr CDeterministicMNList::GetMNPayee(gsl::not_null<const CBlockIndex*> pindexPrev) const
+std::shared_ptr<const std::vector<CDeterministicMNCPtr>> CDeterministicMNList::GetPaymentQueue() const
 {
-    if (mnMap.size() == 0) {
-        return nullptr;
-    }
-
-    const bool isv19Active{DeploymentActiveAfter(pindexPrev, Params().GetConsensus(), Consensus::DEPLOYMENT_V19)};
-    const bool isMNRewardReallocation{DeploymentActiveAfter(pindexPrev, Params().GetConsensus(), Consensus::DEPLOYMENT_MN_RR)};
-    // EvoNodes are rewarded 4 blocks in a row until MNRewardReallocation (Platform release)
-    // For optimization purposes we also check if v19 active to avoid loop over all masternodes
-    CDeterministicMNCPtr best = nullptr;
-    if (isv19Active && !isMNRewardReallocation) {
+    // keep the cache alive even if this list is modified meanwhile
+    const auto cache = m_payment_queue;
+    LOCK(cache->cs);
+    if (!cache->queue) {
+        std::vector<CDeterministicMNCPtr> queue;
+        queue.reserve(mnMap.size());
         ForEachMNShared(true, [&](const CDeterministicMNCPtr& dmn) {
-            if (dmn->pdmnState->nLastPaidHeight == nHeight) {
-                // We found the last MN Payee.
-                // If the last payee is an EvoNode, we need to check its consecutive payments and pay him again if needed
-                // Disable Evonodes
-                // if (dmn->nType == MnType::Evo && dmn->pdmnState->nConsecutivePayments < dmn_types::Evo.voting_weight) {
-                //     best = dmn;
-                // }
-            }
+            queue.emplace_back(dmn);
         });
-
-        if (best != nullptr) return best;
-
-        // Note: If the last payee was a regular MN or if the payee is an EvoNode that was removed from the mnList then that's fine.
-        // We can proceed with classic MN payee selection
+        std::sort(queue.begin(), queue.end(), [](const CDeterministicMNCPtr& a, const CDeterministicMNCPtr& b) {
+            return CompareByLastPaid(a.get(), b.get());
+        });
+        cache->queue = std::make_shared<const std::vector<CDeterministicMNCPtr>>(std::move(queue));
     }
+    return cache->queue;
+}
 
-    ForEachMNShared(true, [&](const CDeterministicMNCPtr& dmn) {
-        if (best == nullptr || CompareByLastPaid(dmn.get(), best.get())) {
-            best = dmn;
-        }
-    });
+CDeterministicMNCPtr CDeterministicMNList::GetMNPayee(gsl::not_null<const CBlockIndex*> pindexPrev) const
+{
+    if (mnMap.size() == 0) {
+        return nullptr;
+    }
 
-    return best;
+    // EvoNodes are rewarded 4 blocks in a row until MNRewardReallocation (Platform release), which would require
+    // finding the last payee (nLastPaidHeight == nHeight) and paying it again if it is an EvoNode with
+    // nConsecutivePayments < dmn_types::Evo.voting_weight. EvoNodes are disabled, so the payee is always the head of
+    // the payment queue.
+    const auto queue = GetPaymentQueue();
+    return queue->empty() ? nullptr : queue->front();
 }
 
 std::vector<CDeterministicMNCPtr> CDeterministicMNList::GetProjectedMNPayees(gsl::not_null<const CBlockIndex* const> pindexPrev, int nCount) const
@@ -222,52 +219,19 @@ std::vector<CDeterministicMNCPtr> CDeterministicMNList::GetProjectedMNPayees(gsl
     if (nCount < 0 ) {
         return {};
     }
-    const auto weighted_count = GetValidWeightedMNsCount();
-    nCount = std::min(nCount, int(weighted_count));
+    // With EvoNodes disabled there is no payee in the middle of its consecutive payments (see GetMNPayee), the
+    // projection is the payment queue with every masternode repeated by its voting weight
+    const auto queue = GetPaymentQueue();
 
     std::vector<CDeterministicMNCPtr> result;
-    result.reserve(weighted_count);
-
-    int remaining_evo_payments{0};
-    CDeterministicMNCPtr evo_to_be_skipped{nullptr};
-    const bool isMNRewardReallocation{DeploymentActiveAfter(pindexPrev, Params().GetConsensus(), Consensus::DEPLOYMENT_MN_RR)};
-    if (!isMNRewardReallocation) {
-        ForEachMNShared(true, [&](const CDeterministicMNCPtr& dmn) {
-            if (dmn->pdmnState->nLastPaidHeight == nHeight) {
-                // We found the last MN Payee.
-                // If the last payee is an EvoNode, we need to check its consecutive payments and pay him again if needed
-                // Disable Evonodes
-                // if (dmn->nType == MnType::Evo && dmn->pdmnState->nConsecutivePayments < dmn_types::Evo.voting_weight) {
-                //     remaining_evo_payments = dmn_types::Evo.voting_weight - dmn->pdmnState->nConsecutivePayments;
-                //     for ([[maybe_unused]] auto _ : irange::range(remaining_evo_payments)) {
-                //         result.emplace_back(dmn);
-                //         evo_to_be_skipped = dmn;
-                //     }
-                // }
-            }
-        });
-    }
-
-    ForEachMNShared(true, [&](const CDeterministicMNCPtr& dmn) {
-        if (dmn == evo_to_be_skipped) return;
+    result.reserve(std::min<size_t>(nCount, queue->size()));
+    for (const auto& dmn : *queue) {
         for ([[maybe_unused]] auto _ : irange::range(GetMnType(dmn->nType).voting_weight)) {
+            if (result.size() == size_t(nCount)) return result;
             result.emplace_back(dmn);
         }
-    });
-
-    if (evo_to_be_skipped != nullptr) {
-        // if EvoNode is in the middle of payments, add entries for already paid ones to the end of the list
-        for ([[maybe_unused]] auto _ : irange::range(evo_to_be_skipped->pdmnState->nConsecutivePayments)) {
-            result.emplace_back(evo_to_be_skipped);
-        }
     }
 
-    std::sort(result.begin() + remaining_evo_payments, result.end(), [&](const CDeterministicMNCPtr& a, const CDeterministicMNCPtr& b) {
-        return CompareByLastPaid(a.get(), b.get());
-    });
-
-    result.resize(nCount);
-
     return result;
 }
 
@@ -275,18 +239,24 @@ std::vector<CDeterministicMNCPtr> CDeterministicMNList::CalculateQuorum(size_t m
 {
     auto scores = CalculateScores(modifier, onlyEvoNodes);
 
-    // sort is descending order
-    std::sort(scores.rbegin(), scores.rend(), [](const std::pair<arith_uint256, CDeterministicMNCPtr>& a, const std::pair<arith_uint256, CDeterministicMNCPtr>& b) {
+    // descending order, the comparison is a strict total order so only the top maxSize entries need to be ordered
+    const auto cmp = [](const std::pair<arith_uint256, CDeterministicMNCPtr>& a, const std::pair<arith_uint256, CDeterministicMNCPtr>& b) {
         if (a.first == b.first) {
             // this should actually never happen, but we should stay compatible with how the non-deterministic MNs did the sorting
-            return a.second->collateralOutpoint < b.second->collateralOutpoint;
+            return b.second->collateralOutpoint < a.second->collateralOutpoint;
         }
-        return a.first < b.first;
-    });
+        return b.first < a.first;
+    };
+    const size_t nResultSize = std::min(maxSize, scores.size());
+    if (nResultSize < scores.size()) {
+        std::partial_sort(scores.begin(), scores.begin() + nResultSize, scores.end(), cmp);
+    } else {
+        std::sort(scores.begin(), scores.end(), cmp);
+    }
 
     // take top maxSize entries and return it
     std::vector<CDeterministicMNCPtr> result;
-    result.resize(std::min(maxSize, scores.size()));
+    result.resize(nResultSize);
     for (size_t i = 0; i < result.size(); i++) {
         result[i] = std::move(scores[i].second);
     }
@@ -295,8 +265,8 @@ std::vector<CDeterministicMNCPtr> CDeterministicMNList::CalculateQuorum(size_t m
 
 std::vector<std::pair<arith_uint256, CDeterministicMNCPtr>> CDeterministicMNList::CalculateScores(const uint256& modifier, const bool onlyEvoNodes) const
 {
-    std::vector<std::pair<arith_uint256, CDeterministicMNCPtr>> scores;
-    scores.reserve(GetAllMNsCount());
+    std::vector<CDeterministicMNCPtr> dmns;
+    dmns.reserve(GetAllMNsCount());
     ForEachMNShared(true, [&](const CDeterministicMNCPtr& dmn) {
         if (dmn->pdmnState->confirmedHash.IsNull()) {
             // we only take confirmed MNs into account to avoid hash grinding on the ProRegTxHash to sneak MNs into a
@@ -308,19 +278,28 @@ std::vector<std::pair<arith_uint256, CDeterministicMNCPtr>> CDeterministicMNList
         //     if (dmn->nType != MnType::Evo)
         //         return;
         // }
-        // calculate sha256(sha256(proTxHash, confirmedHash), modifier) per MN
-        // Please note that this is not a double-sha256 but a single-sha256
-        // The first part is already precalculated (confirmedHashWithProRegTxHash)
-        // TODO When https://github.com/bitcoin/bitcoin/pull/13191 gets backported, implement something that is similar but for single-sha256
-        uint256 h;
-        CSHA256 sha256;
-        sha256.Write(dmn->pdmnState->confirmedHashWithProRegTxHash.begin(), dmn->pdmnState->confirmedHashWithProRegTxHash.size());
-        sha256.Write(modifier.begin(), modifier.size());
-        sha256.Finalize(h.begin());
-
-        scores.emplace_back(UintToArith256(h), dmn);
+        dmns.emplace_back(dmn);
     });
 
+    // calculate sha256(sha256(proTxHash, confirmedHash), modifier) per MN
+    // Please note that this is not a double-sha256 but a single-sha256
+    // The first part is already precalculated (confirmedHashWithProRegTxHash)
+    // All the 64 byte inputs are hashed in one batch so that the multi-way SHA256 implementations can be used
+    std::vector<unsigned char> input(dmns.size() * 64);
+    for (size_t i = 0; i < dmns.size(); ++i) {
+        const uint256& confirmedHashWithProRegTxHash = dmns[i]->pdmnState->confirmedHashWithProRegTxHash;
+        std::copy(confirmedHashWithProRegTxHash.begin(), confirmedHashWithProRegTxHash.end(), input.begin() + i * 64);
+        std::copy(modifier.begin(), modifier.end(), input.begin() + i * 64 + 32);
+    }
+    std::vector<uint256> hashes(dmns.size());
+    SHA256S64(hashes.empty() ? nullptr : hashes.front().begin(), input.data(), dmns.size());
+
+    std::vector<std::pair<arith_uint256, CDeterministicMNCPtr>> scores;
+    scores.reserve(dmns.size());
+    for (size_t i = 0; i < dmns.size(); ++i) {
+        scores.emplace_back(UintToArith256(hashes[i]), std::move(dmns[i]));
+    }
+
     return scores;
 }
 
@@ -426,6 +405,33 @@ CDeterministicMNListDiff CDeterministicMNList::BuildDiff(const CDeterministicMNL
     return diffRet;
 }
 
+CDeterministicMNListDiff CDeterministicMNList::BuildUndoDiff(const CDeterministicMNList& from, const CDeterministicMNListDiff& diff) const
+{
+    CDeterministicMNListDiff diffRet;
+
+    for (const auto& dmn : diff.addedMNs) {
+        diffRet.removedMns.emplace(dmn->GetInternalId());
+    }
+    for (const auto& id : diff.removedMns) {
+        diffRet.addedMNs.emplace_back(from.GetMNByInternalId(id));
+    }
+    for (const auto& p : diff.updatedMNs) {
+        const auto toPtr = from.GetMNByInternalId(p.first);
+        const auto fromPtr = GetMNByInternalId(p.first);
+        CDeterministicMNStateDiff stateDiff(*fromPtr->pdmnState, *toPtr->pdmnState);
+        if (stateDiff.fields) {
+            diffRet.updatedMNs.emplace(p.first, std::move(stateDiff));
+        }
+    }
+
+    // see BuildDiff
+    std::sort(diffRet.addedMNs.begin(), diffRet.addedMNs.end(), [](const CDeterministicMNCPtr& a, const CDeterministicMNCPtr& b) {
+        return a->GetInternalId() < b->GetInternalId();
+    });
+
+    return diffRet;
+}
+
 CDeterministicMNList CDeterministicMNList::ApplyDiff(gsl::not_null<const CBlockIndex*> pindex, const CDeterministicMNListDiff& diff) const
 {
     CDeterministicMNList result = *this;
@@ -450,6 +456,95 @@ CDeterministicMNList CDeterministicMNList::ApplyDiff(gsl::not_null<const CBlockI
     return result;
 }
 
+// Walks all nodes of an immer map which are not in seen yet and returns their memory usage, plus the usage reported by
+// valueUsage for the values stored in these nodes
+template <typename Map, typename Fn>
+static size_t ImmerMapDynamicUsage(const Map& map, std::unordered_set<const void*>& seen, Fn&& valueUsage)
+{
+    using champ_t = std::decay_t<decltype(map.impl())>;
+    using node_t = typename champ_t::node_t;
+    using count_t = immer::detail::hamts::count_t;
+    constexpr auto max_depth = immer::detail::hamts::max_depth<champ_t::bits>;
+
+    size_t usage{0};
+    std::vector<std::pair<const node_t*, count_t>> todo{{map.impl().root, 0}};
+    while (!todo.empty()) {
+        const auto [node, depth] = todo.back();
+        todo.pop_back();
+        if (!seen.emplace(node).second) {
+            continue;
+        }
+        if (depth < max_depth) {
+            const auto nChildren = node->children_count();
+            const auto nValues = node->data_count();
+            usage += memusage::MallocUsage(node_t::sizeof_inner_n(nChildren));
+            // nodes which only differ in their children share the values
+            if (nValues != 0 && seen.emplace(node->values()).second) {
+                usage += memusage::MallocUsage(node_t::sizeof_values_n(nValues));
+                for (auto it = node->values(); it != node->values() + nValues; ++it) {
+                    usage += valueUsage(*it);
+                }
+            }
+            for (auto it = node->children(); it != node->children() + nChildren; ++it) {
+                todo.emplace_back(*it, depth + 1);
+            }
+        } else {
+            const auto nCollisions = node->collision_count();
+            usage += memusage::MallocUsage(node_t::sizeof_collision_n(nCollisions));
+            for (auto it = node->collisions(); it != node->collisions() + nCollisions; ++it) {
+                usage += valueUsage(*it);
+            }
+        }
+    }
+    return usage;
+}
+
+size_t CDeterministicMNList::DynamicMemoryUsage(std::unordered_set<const void*>& seen) const
+{
+    const auto noUsage = [](const auto&) { return size_t{0}; };
+    const auto mnUsage = [&seen](const std::pair<uint256, CDeterministicMNCPtr>& p) {
+        size_t usage{0};
+        const auto& dmn = p.second;
+        if (seen.emplace(dmn.get()).second) {
+            usage += memusage::DynamicUsage(dmn);
+            const auto& state = dmn->pdmnState;
+            if (seen.emplace(state.get()).second) {
+                usage += memusage::DynamicUsage(state);
+                usage += RecursiveDynamicUsage(state->scriptPayout) + RecursiveDynamicUsage(state->scriptOperatorPayout);
+            }
+        }
+        return usage;
+    };
+    return ImmerMapDynamicUsage(mnMap, seen, mnUsage) +
+           ImmerMapDynamicUsage(mnInternalIdMap, seen, noUsage) +
+           ImmerMapDynamicUsage(mnUniquePropertyMap, seen, noUsage) +
+           ImmerMapDynamicUsage(mnValidMap, seen, noUsage);
+}
+
+void CDeterministicMNList::UpdateValidIndex(const CDeterministicMNCPtr& dmn)
+{
+    const bool wasValid = mnValidMap.find(dmn->proTxHash) != nullptr;
+    const bool isValid = IsMNValid(*dmn);
+    if (isValid) {
+        mnValidMap = mnValidMap.set(dmn->proTxHash, dmn);
+    } else if (wasValid) {
+        mnValidMap = mnValidMap.erase(dmn->proTxHash);
+    }
+    if (wasValid != isValid && size_t(dmn->nType) < nValidCountByType.size()) {
+        auto& count = nValidCountByType[size_t(dmn->nType)];
+        count = isValid ? count + 1 : count - 1;
+    }
+}
+
+void CDeterministicMNList::RemoveFromValidIndex(const CDeterministicMN& dmn)
+{
+    if (mnValidMap.find(dmn.proTxHash) == nullptr) return;
+    mnValidMap = mnValidMap.erase(dmn.proTxHash);
+    if (size_t(dmn.nType) < nValidCountByType.size()) {
+        --nValidCountByType[size_t(dmn.nType)];
+    }
+}
+
 void CDeterministicMNList::AddMN(const CDeterministicMNCPtr& dmn, bool fBumpTotalCount)
 {
     assert(dmn != nullptr);
@@ -497,6 +592,8 @@ void CDeterministicMNList::AddMN(const CDeterministicMNCPtr& dmn, bool fBumpTota
 
     mnMap = mnMap.set(dmn->proTxHash, dmn);
     mnInternalIdMap = mnInternalIdMap.set(dmn->GetInternalId(), dmn->proTxHash);
+    UpdateValidIndex(dmn);
+    InvalidatePaymentQueue();
     if (fBumpTotalCount) {
         // nTotalRegisteredCount acts more like a checkpoint, not as a limit,
         nTotalRegisteredCount = std::max(dmn->GetInternalId() + 1, (uint64_t)nTotalRegisteredCount);
@@ -538,6 +635,8 @@ void CDeterministicMNList::UpdateMN(const CDeterministicMN& oldDmn, const std::s
 
     dmn->pdmnState = pdmnState;
     mnMap = mnMap.set(oldDmn.proTxHash, dmn);
+    UpdateValidIndex(dmn);
+    InvalidatePaymentQueue();
 }
 
 void CDeterministicMNList::UpdateMN(const uint256& proTxHash, const std::shared_ptr<const CDeterministicMNState>& pdmnState)
@@ -600,6 +699,8 @@ void CDeterministicMNList::RemoveMN(const uint256& proTxHash)
 
     mnMap = mnMap.erase(proTxHash);
     mnInternalIdMap = mnInternalIdMap.erase(dmn->GetInternalId());
+    RemoveFromValidIndex(*dmn);
+    InvalidatePaymentQueue();
 }
 
 bool CDeterministicMNManager::ProcessBlock(const CBlock& block, gsl::not_null<const CBlockIndex*> pindex, BlockValidationState& state, const CCoinsViewCache& view, bool fJustCheck, std::optional<MNListUpdates>& updatesRet)
@@ -634,8 +735,12 @@ bool CDeterministicMNManager::ProcessBlock(const CBlock& block, gsl::not_null<co
         diff = oldList.BuildDiff(newList);
 
         m_evoDb.Write(std::make_pair(DB_LIST_DIFF, newList.GetBlockHash()), diff);
-        if ((nHeight % DISK_SNAPSHOT_PERIOD) == 0 || pindex->pprev == m_initial_snapshot_index) {
-            m_evoDb.Write(std::make_pair(DB_LIST_SNAPSHOT, newList.GetBlockHash()), newList);
+        if (diff.HasChanges()) {
+            m_evoDb.Write(std::make_pair(DB_LIST_UNDO, newList.GetBlockHash()),
+                          CDeterministicMNListUndo{oldList.GetTotalRegisteredCount(), newList.BuildUndoDiff(oldList, diff)});
+        }
+        if ((nHeight % m_snapshot_interval) == 0 || pindex->pprev == m_initial_snapshot_index) {
+            m_evoDb.Write(std::make_pair(DB_LIST_SNAPSHOT_COMPACT, newList.GetBlockHash()), CDeterministicMNListCompactSnapshot(newList));
             mnListsCache.emplace(newList.GetBlockHash(), newList);
             LogPrintf("CDeterministicMNManager::%s -- Wrote snapshot. nHeight=%d, mapCurMNs.allMNsCount=%d\n",
                 __func__, nHeight, newList.GetAllMNsCount());
@@ -673,11 +778,34 @@ bool CDeterministicMNManager::UndoBlock(gsl::not_null<const CBlockIndex*> pindex
     CDeterministicMNList curList;
     CDeterministicMNList prevList;
     CDeterministicMNListDiff diff;
+    CDeterministicMNListUndo undo;
+    bool fFromUndo{false};
     {
         LOCK(cs);
-        m_evoDb.Read(std::make_pair(DB_LIST_DIFF, blockHash), diff);
-
-        if (diff.HasChanges()) {
+        const bool fHaveDiff = m_evoDb.Read(std::make_pair(DB_LIST_DIFF, blockHash), diff);
+
+        // The list of the disconnected tip is normally cached, derive the previous list from it and the undo record
+        // instead of replaying diffs from the last snapshot, and cache the result for the next block of a reorg
+        const auto itCur = mnListsCache.find(blockHash);
+        if (fHaveDiff && itCur != mnListsCache.end() &&
+            (!diff.HasChanges() || m_evoDb.Read(std::make_pair(DB_LIST_UNDO, blockHash), undo))) {
+            try {
+                curList = itCur->second;
+                if (diff.HasChanges()) {
+                    prevList = curList.ApplyDiff(pindex->pprev, undo.diff);
+                    prevList.SetTotalRegisteredCount(undo.nTotalRegisteredCount);
+                } else {
+                    prevList = curList;
+                    prevList.SetBlockHash(pindex->pprev->GetBlockHash());
+                    prevList.SetHeight(pindex->pprev->nHeight);
+                }
+                fFromUndo = true;
+            } catch (const std::exception& e) {
+                LogPrintf("CDeterministicMNManager::%s -- can't apply undo record, rebuilding list. blockHash=%s: %s\n",
+                          __func__, blockHash.ToString(), e.what());
+            }
+        }
+        if (!fFromUndo && diff.HasChanges()) {
             // need to call this before erasing
             curList = GetListForBlockInternal(pindex);
             prevList = GetListForBlockInternal(pindex->pprev);
@@ -685,10 +813,13 @@ bool CDeterministicMNManager::UndoBlock(gsl::not_null<const CBlockIndex*> pindex
 
         mnListsCache.erase(blockHash);
         mnListDiffsCache.erase(blockHash);
+        if (fFromUndo) {
+            mnListsCache.emplace(prevList.GetBlockHash(), prevList);
+        }
     }
 
     if (diff.HasChanges()) {
-        auto inversedDiff = curList.BuildDiff(prevList);
+        auto inversedDiff = fFromUndo ? std::move(undo.diff) : curList.BuildDiff(prevList);
         updatesRet = {curList, prevList, inversedDiff};
     }
 
@@ -1036,6 +1167,12 @@ CDeterministicMNList CDeterministicMNManager::GetListForBlockInternal(gsl::not_n
             break;
         }
 
+        // snapshots written before the compact format was introduced are still read in the full one
+        if (CDeterministicMNListCompactSnapshot compact; m_evoDb.Read(std::make_pair(DB_LIST_SNAPSHOT_COMPACT, pindex->GetBlockHash()), compact)) {
+            snapshot = std::move(compact.list);
+            mnListsCache.emplace(pindex->GetBlockHash(), snapshot);
+            break;
+        }
         if (m_evoDb.Read(std::make_pair(DB_LIST_SNAPSHOT, pindex->GetBlockHash()), snapshot)) {
             mnListsCache.emplace(pindex->GetBlockHash(), snapshot);
             break;
@@ -1076,6 +1213,22 @@ CDeterministicMNList CDeterministicMNManager::GetListForBlockInternal(gsl::not_n
         }
     }
 
+    if (!listDiffIndexes.empty() && int(listDiffIndexes.size()) >= std::max(m_snapshot_interval / ADAPTIVE_SNAPSHOT_REPLAY_DIVISOR, 1)) {
+        int queries{0};
+        expensiveListQueries.get(snapshot.GetBlockHash(), queries);
+        if (++queries >= ADAPTIVE_SNAPSHOT_MIN_QUERIES) {
+            // this list is requested repeatedly and is expensive to rebuild, store it so that the next rebuild of this
+            // or any following list can start from here
+            m_evoDb.Write(std::make_pair(DB_LIST_SNAPSHOT_COMPACT, snapshot.GetBlockHash()), CDeterministicMNListCompactSnapshot(snapshot));
+            mnListsCache.emplace(snapshot.GetBlockHash(), snapshot);
+            expensiveListQueries.erase(snapshot.GetBlockHash());
+            LogPrintf("CDeterministicMNManager::%s -- Wrote extra snapshot. nHeight=%d, replayed diffs=%d\n",
+                __func__, snapshot.GetHeight(), listDiffIndexes.size());
+        } else {
+            expensiveListQueries.insert(snapshot.GetBlockHash(), queries);
+        }
+    }
+
     if (tipIndex) {
         // always keep a snapshot for the tip
         if (snapshot.GetBlockHash() == tipIndex->GetBlockHash()) {
@@ -1109,6 +1262,17 @@ CDeterministicMNList CDeterministicMNManager::GetListAtChainTip()
     return GetListForBlockInternal(tipIndex);
 }
 
+size_t CDeterministicMNManager::GetListsCacheMemoryUsage()
+{
+    LOCK(cs);
+    std::unordered_set<const void*> seen;
+    size_t usage{0};
+    for (const auto& p : mnListsCache) {
+        usage += p.second.DynamicMemoryUsage(seen);
+    }
+    return usage;
+}
+
 bool CDeterministicMNManager::IsProTxWithCollateral(const CTransactionRef& tx, uint32_t n)
 {
     if (tx->nVersion != 3 || tx->nType != TRANSACTION_PROVIDER_REGISTER) {
@@ -1141,7 +1305,7 @@ void CDeterministicMNManager::CleanupCache(int nHeight)
     std::vector<uint256> toDeleteLists;
     std::vector<uint256> toDeleteDiffs;
     for (const auto& p : mnListsCache) {
-        if (p.second.GetHeight() + LIST_DIFFS_CACHE_SIZE < nHeight) {
+        if (p.second.GetHeight() + m_list_diffs_cache_size < nHeight) {
             // too old, drop it
             toDeleteLists.emplace_back(p.first);
             continue;
@@ -1165,8 +1329,32 @@ void CDeterministicMNManager::CleanupCache(int nHeight)
     for (const auto& h : toDeleteLists) {
         mnListsCache.erase(h);
     }
+
+    // Keep the tip and then the newest lists as long as their combined footprint fits into the budget. Lists share
+    // most of their map nodes and entries, so only what a list adds on top of the newer ones is accounted for it.
+    // Older lists can be rebuilt from the snapshots and diffs on disk
+    std::unordered_set<const void*> seen;
+    size_t cacheUsage{0};
+    std::vector<std::pair<int, uint256>> byHeight;
+    for (const auto& p : mnListsCache) {
+        if (tipIndex != nullptr && p.first == tipIndex->GetBlockHash()) {
+            cacheUsage += p.second.DynamicMemoryUsage(seen);
+        } else {
+            byHeight.emplace_back(p.second.GetHeight(), p.first);
+        }
+    }
+    std::sort(byHeight.begin(), byHeight.end(), std::greater<>());
+    for (const auto& [_, h] : byHeight) {
+        if (cacheUsage <= m_cache_size_bytes) {
+            cacheUsage += mnListsCache.at(h).DynamicMemoryUsage(seen);
+        }
+        if (cacheUsage > m_cache_size_bytes) {
+            mnListsCache.erase(h);
+        }
+    }
+
     for (const auto& p : mnListDiffsCache) {
-        if (p.second.nHeight + LIST_DIFFS_CACHE_SIZE < nHeight) {
+        if (p.second.nHeight + m_list_diffs_cache_size < nHeight) {
             toDeleteDiffs.emplace_back(p.first);
         }
     }
@@ -1277,7 +1465,7 @@ bool CDeterministicMNManager::MigrateDBIfNeeded()
         batch.Write(std::make_pair(DB_LIST_DIFF, pindex->GetBlockHash()), mndiff);
         CDataStream snapshot_data(SER_DISK, CLIENT_VERSION);
         if (!m_evoDb.GetRawDB().ReadDataStream(std::make_pair(DB_OLD_LIST_SNAPSHOT, pindex->GetBlockHash()), snapshot_data)) {
-            // it's ok, we write snapshots every DISK_SNAPSHOT_PERIOD blocks only
+            // it's ok, snapshots are not written for every block
             continue;
         }
         CDeterministicMNList mnList;
@@ -1388,7 +1576,7 @@ bool CDeterministicMNManager::MigrateDBIfNeeded2()
         batch.Write(std::make_pair(DB_LIST_DIFF, pindex->GetBlockHash()), mndiff);
         CDataStream snapshot_data(SER_DISK, CLIENT_VERSION);
         if (!m_evoDb.GetRawDB().ReadDataStream(std::make_pair(DB_OLD_LIST_SNAPSHOT, pindex->GetBlockHash()), snapshot_data)) {
-            // it's ok, we write snapshots every DISK_SNAPSHOT_PERIOD blocks only
+            // it's ok, snapshots are not written for every block
             continue;
         }
         CDeterministicMNList mnList;
@@ -1494,30 +1682,29 @@ static bool CheckPlatformFields(const ProTx& proTx, TxValidationState& state)
 }
 
 template <typename ProTx>
-static bool CheckHashSig(const ProTx& proTx, const PKHash& pkhash, TxValidationState& state)
+static bool CheckHashSig(const ProTx& proTx, const PKHash& pkhash, TxValidationState& state, std::vector<CSpecialTxSigCheck>* pvChecks)
 {
-    if (std::string strError; !CHashSigner::VerifyHash(::SerializeHash(proTx), ToKeyID(pkhash), proTx.vchSig, strError)) {
-        return state.Invalid(TxValidationResult::TX_CONSENSUS, "bad-protx-sig");
-    }
-    return true;
+    return RunOrDeferSigCheck([hash = ::SerializeHash(proTx), keyID = ToKeyID(pkhash), vchSig = proTx.vchSig]() {
+        std::string strError;
+        return CHashSigner::VerifyHash(hash, keyID, vchSig, strError);
+    }, "bad-protx-sig", pvChecks, state);
 }
 
 template <typename ProTx>
-static bool CheckStringSig(const ProTx& proTx, const PKHash& pkhash, TxValidationState& state)
+static bool CheckStringSig(const ProTx& proTx, const PKHash& pkhash, TxValidationState& state, std::vector<CSpecialTxSigCheck>* pvChecks)
 {
-    if (std::string strError; !CMessageSigner::VerifyMessage(ToKeyID(pkhash), proTx.vchSig, proTx.MakeSignString(), strError)) {
-        return state.Invalid(TxValidationResult::TX_CONSENSUS, "bad-protx-sig");
-    }
-    return true;
+    return RunOrDeferSigCheck([keyID = ToKeyID(pkhash), vchSig = proTx.vchSig, strMessage = proTx.MakeSignString()]() {
+        std::string strError;
+        return CMessageSigner::VerifyMessage(keyID, vchSig, strMessage, strError);
+    }, "bad-protx-sig", pvChecks, state);
 }
 
 template <typename ProTx>
-static bool CheckHashSig(const ProTx& proTx, const CBLSPublicKey& pubKey, TxValidationState& state)
+static bool CheckHashSig(const ProTx& proTx, const CBLSPublicKey& pubKey, TxValidationState& state, std::vector<CSpecialTxSigCheck>* pvChecks)
 {
-    if (!proTx.sig.VerifyInsecure(pubKey, ::SerializeHash(proTx))) {
-        return state.Invalid(TxValidationResult::TX_CONSENSUS, "bad-protx-sig");
-    }
-    return true;
+    return RunOrDeferSigCheck([hash = ::SerializeHash(proTx), pubKey, sig = proTx.sig]() {
+        return VerifyInsecureCached(sig, pubKey, hash);
+    }, "bad-protx-sig", pvChecks, state);
 }
 
 template<typename ProTx>
@@ -1541,7 +1728,7 @@ static std::optional<ProTx> GetValidatedPayload(const CTransaction& tx, gsl::not
     return opt_ptx;
 }
 
-bool CheckProRegTx(const CTransaction& tx, gsl::not_null<const CBlockIndex*> pindexPrev, TxValidationState& state, const CCoinsViewCache& view, bool check_sigs)
+bool CheckProRegTx(const CTransaction& tx, gsl::not_null<const CBlockIndex*> pindexPrev, TxValidationState& state, const CCoinsViewCache& view, bool check_sigs, std::vector<CSpecialTxSigCheck>* pvChecks)
 {
     const auto opt_ptx = GetValidatedPayload<CProRegTx>(tx, pindexPrev, state);
     if (!opt_ptx) {
@@ -1643,7 +1830,7 @@ bool CheckProRegTx(const CTransaction& tx, gsl::not_null<const CBlockIndex*> pin
 
     if (keyForPayloadSig) {
         // collateral is not part of this ProRegTx, so we must verify ownership of the collateral
-        if (check_sigs && !CheckStringSig(*opt_ptx, *keyForPayloadSig, state)) {
+        if (check_sigs && !CheckStringSig(*opt_ptx, *keyForPayloadSig, state, pvChecks)) {
             // pass the state returned by the function above
             return false;
         }
@@ -1657,7 +1844,7 @@ bool CheckProRegTx(const CTransaction& tx, gsl::not_null<const CBlockIndex*> pin
     return true;
 }
 
-bool CheckProUpServTx(const CTransaction& tx, gsl::not_null<const CBlockIndex*> pindexPrev, TxValidationState& state, bool check_sigs)
+bool CheckProUpServTx(const CTransaction& tx, gsl::not_null<const CBlockIndex*> pindexPrev, TxValidationState& state, bool check_sigs, std::vector<CSpecialTxSigCheck>* pvChecks)
 {
     const auto opt_ptx = GetValidatedPayload<CProUpServTx>(tx, pindexPrev, state);
     if (!opt_ptx) {
@@ -1710,7 +1897,7 @@ bool CheckProUpServTx(const CTransaction& tx, gsl::not_null<const CBlockIndex*>
         // pass the state returned by the function above
         return false;
     }
-    if (check_sigs && !CheckHashSig(*opt_ptx, mn->pdmnState->pubKeyOperator.Get(), state)) {
+    if (check_sigs && !CheckHashSig(*opt_ptx, mn->pdmnState->pubKeyOperator.Get(), state, pvChecks)) {
         // pass the state returned by the function above
         return false;
     }
@@ -1718,7 +1905,7 @@ bool CheckProUpServTx(const CTransaction& tx, gsl::not_null<const CBlockIndex*>
     return true;
 }
 
-bool CheckProUpRegTx(const CTransaction& tx, gsl::not_null<const CBlockIndex*> pindexPrev, TxValidationState& state, const CCoinsViewCache& view, bool check_sigs)
+bool CheckProUpRegTx(const CTransaction& tx, gsl::not_null<const CBlockIndex*> pindexPrev, TxValidationState& state, const CCoinsViewCache& view, bool check_sigs, std::vector<CSpecialTxSigCheck>* pvChecks)
 {
     const auto opt_ptx = GetValidatedPayload<CProUpRegTx>(tx, pindexPrev, state);
     if (!opt_ptx) {
@@ -1775,7 +1962,7 @@ bool CheckProUpRegTx(const CTransaction& tx, gsl::not_null<const CBlockIndex*> p
         // pass the state returned by the function above
         return false;
     }
-    if (check_sigs && !CheckHashSig(*opt_ptx, PKHash(dmn->pdmnState->keyIDOwner), state)) {
+    if (check_sigs && !CheckHashSig(*opt_ptx, PKHash(dmn->pdmnState->keyIDOwner), state, pvChecks)) {
         // pass the state returned by the function above
         return false;
     }
@@ -1783,7 +1970,7 @@ bool CheckProUpRegTx(const CTransaction& tx, gsl::not_null<const CBlockIndex*> p
     return true;
 }
 
-bool CheckProUpRevTx(const CTransaction& tx, gsl::not_null<const CBlockIndex*> pindexPrev, TxValidationState& state, bool check_sigs)
+bool CheckProUpRevTx(const CTransaction& tx, gsl::not_null<const CBlockIndex*> pindexPrev, TxValidationState& state, bool check_sigs, std::vector<CSpecialTxSigCheck>* pvChecks)
 {
     const auto opt_ptx = GetValidatedPayload<CProUpRevTx>(tx, pindexPrev, state);
     if (!opt_ptx) {
@@ -1800,7 +1987,7 @@ bool CheckProUpRevTx(const CTransaction& tx, gsl::not_null<const CBlockIndex*> p
         // pass the state returned by the function above
         return false;
     }
-    if (check_sigs && !CheckHashSig(*opt_ptx, dmn->pdmnState->pubKeyOperator.Get(), state)) {
+    if (check_sigs && !CheckHashSig(*opt_ptx, dmn->pdmnState->pubKeyOperator.Get(), state, pvChecks)) {
         // pass the state returned by the function above
         return false;
     }
@@ -16,20 +16,26 @@
 #include <saltedhasher.h>
 #include <scheduler.h>
 #include <sync.h>
+#include <unordered_lru_cache.h>
 #include <gsl/pointers.h>
 
 #include <immer/map.hpp>
+#include <immer/memory_policy.hpp>
 
+#include <array>
 #include <atomic>
 #include <limits>
+#include <map>
 #include <numeric>
 #include <unordered_map>
+#include <unordered_set>
 #include <utility>
 
 class CBlock;
 class CBlockIndex;
 class CChainState;
 class CConnman;
+class CSpecialTxSigCheck;
 class TxValidationState;
 
 extern RecursiveMutex cs_main;
@@ -124,18 +130,28 @@ using CDeterministicMNCPtr = std::shared_ptr<const CDeterministicMN>;
 
 class CDeterministicMNListDiff;
 
-template <typename Stream, typename K, typename T, typename Hash, typename Equal>
-void SerializeImmerMap(Stream& os, const immer::map<K, T, Hash, Equal>& m)
+/**
+ * Memory policy of the immer maps backing CDeterministicMNList. Like immer's default policy, freed nodes go to a
+ * thread local free list backed by a global lock-free one, but the free lists are sized for whole lists being built
+ * and evicted from the manager's caches on every block rather than for a handful of nodes. Refcounting stays atomic,
+ * the lists are shared between the validation, RPC and LLMQ threads.
+ */
+static constexpr size_t MNLIST_FREE_LIST_SIZE = 1 << 13;
+using MnListMemoryPolicy = immer::memory_policy<immer::free_list_heap_policy<immer::cpp_heap, MNLIST_FREE_LIST_SIZE>,
+                                                immer::refcount_policy, immer::spinlock_policy>;
+
+template <typename Stream, typename K, typename T, typename Hash, typename Equal, typename MemoryPolicy, immer::detail::hamts::bits_t B>
+void SerializeImmerMap(Stream& os, const immer::map<K, T, Hash, Equal, MemoryPolicy, B>& m)
 {
     WriteCompactSize(os, m.size());
-    for (typename immer::map<K, T, Hash, Equal>::const_iterator mi = m.begin(); mi != m.end(); ++mi)
+    for (typename immer::map<K, T, Hash, Equal, MemoryPolicy, B>::const_iterator mi = m.begin(); mi != m.end(); ++mi)
         Serialize(os, (*mi));
 }
 
-template <typename Stream, typename K, typename T, typename Hash, typename Equal>
-void UnserializeImmerMap(Stream& is, immer::map<K, T, Hash, Equal>& m)
+template <typename Stream, typename K, typename T, typename Hash, typename Equal, typename MemoryPolicy, immer::detail::hamts::bits_t B>
+void UnserializeImmerMap(Stream& is, immer::map<K, T, Hash, Equal, MemoryPolicy, B>& m)
 {
-    m = immer::map<K, T, Hash, Equal>();
+    m = immer::map<K, T, Hash, Equal, MemoryPolicy, B>();
     unsigned int nSize = ReadCompactSize(is);
     for (unsigned int i = 0; i < nSize; i++) {
         std::pair<K, T> item;
@@ -146,14 +162,14 @@ void UnserializeImmerMap(Stream& is, immer::map<K, T, Hash, Equal>& m)
 
 // For some reason the compiler is not able to choose the correct Serialize/Deserialize methods without a specialized
 // version of SerReadWrite. It otherwise always chooses the version that calls a.Serialize()
-template<typename Stream, typename K, typename T, typename Hash, typename Equal>
-inline void SerReadWrite(Stream& s, const immer::map<K, T, Hash, Equal>& m, CSerActionSerialize ser_action)
+template<typename Stream, typename K, typename T, typename Hash, typename Equal, typename MemoryPolicy, immer::detail::hamts::bits_t B>
+inline void SerReadWrite(Stream& s, const immer::map<K, T, Hash, Equal, MemoryPolicy, B>& m, CSerActionSerialize ser_action)
 {
     ::SerializeImmerMap(s, m);
 }
 
-template<typename Stream, typename K, typename T, typename Hash, typename Equal>
-inline void SerReadWrite(Stream& s, immer::map<K, T, Hash, Equal>& obj, CSerActionUnserialize ser_action)
+template<typename Stream, typename K, typename T, typename Hash, typename Equal, typename MemoryPolicy, immer::detail::hamts::bits_t B>
+inline void SerReadWrite(Stream& s, immer::map<K, T, Hash, Equal, MemoryPolicy, B>& obj, CSerActionUnserialize ser_action)
 {
     ::UnserializeImmerMap(s, obj);
 }
@@ -168,9 +184,9 @@ private:
     };
 
 public:
-    using MnMap = immer::map<uint256, CDeterministicMNCPtr, ImmerHasher>;
-    using MnInternalIdMap = immer::map<uint64_t, uint256>;
-    using MnUniquePropertyMap = immer::map<uint256, std::pair<uint256, uint32_t>, ImmerHasher>;
+    using MnMap = immer::map<uint256, CDeterministicMNCPtr, ImmerHasher, std::equal_to<uint256>, MnListMemoryPolicy>;
+    using MnInternalIdMap = immer::map<uint64_t, uint256, std::hash<uint64_t>, std::equal_to<uint64_t>, MnListMemoryPolicy>;
+    using MnUniquePropertyMap = immer::map<uint256, std::pair<uint256, uint32_t>, ImmerHasher, std::equal_to<uint256>, MnListMemoryPolicy>;
 
 private:
     uint256 blockHash;
@@ -183,6 +199,27 @@ private:
     // we keep track of this as checking for duplicates would otherwise be painfully slow
     MnUniquePropertyMap mnUniquePropertyMap;
 
+    // valid (not PoSe-banned) subset of mnMap and its size per MnType, maintained by AddMN/UpdateMN/RemoveMN so that
+    // iterating and counting valid masternodes doesn't skip over the banned ones each time. The subset has the same
+    // hasher as mnMap, so it is iterated in the same order.
+    MnMap mnValidMap;
+    std::array<size_t, size_t(MnType::COUNT)> nValidCountByType{};
+
+    void UpdateValidIndex(const CDeterministicMNCPtr& dmn);
+    void RemoveFromValidIndex(const CDeterministicMN& dmn);
+
+    // valid masternodes in the order they get paid, computed on first use. Copies of a list share it until one of
+    // them is modified, so the copies handed out by CDeterministicMNManager sort the list only once per block.
+    struct PaymentQueue
+    {
+        Mutex cs;
+        std::shared_ptr<const std::vector<CDeterministicMNCPtr>> queue GUARDED_BY(cs);
+    };
+    std::shared_ptr<PaymentQueue> m_payment_queue{std::make_shared<PaymentQueue>()};
+
+    std::shared_ptr<const std::vector<CDeterministicMNCPtr>> GetPaymentQueue() const;
+    void InvalidatePaymentQueue() { m_payment_queue = std::make_shared<PaymentQueue>(); }
+
 public:
     CDeterministicMNList() = default;
     explicit CDeterministicMNList(const uint256& _blockHash, int _height, uint32_t _totalRegisteredCount) :
@@ -217,6 +254,9 @@ public:
         mnMap = MnMap();
         mnUniquePropertyMap = MnUniquePropertyMap();
         mnInternalIdMap = MnInternalIdMap();
+        mnValidMap = MnMap();
+        nValidCountByType = {};
+        InvalidatePaymentQueue();
 
         SerializationOpBase(s, CSerActionUnserialize());
 
@@ -226,6 +266,7 @@ public:
             if (evodb_migration) {
                 const auto dmn = std::make_shared<CDeterministicMN>(deserialize, s, format_version);
                 mnMap = mnMap.set(dmn->proTxHash, dmn);
+                UpdateValidIndex(dmn);
             } else {
                 AddMN(std::make_shared<CDeterministicMN>(deserialize, s, format_version), false);
             }
@@ -237,9 +278,16 @@ public:
         return mnMap.size();
     }
 
+    /**
+     * Memory used by this list which is not already in seen; everything accounted is added to seen. Accounting several
+     * lists with the same seen set gives their combined footprint, with the map nodes, masternodes and states they
+     * share counted only once.
+     */
+    size_t DynamicMemoryUsage(std::unordered_set<const void*>& seen) const;
+
     [[nodiscard]] size_t GetValidMNsCount() const
     {
-        return ranges::count_if(mnMap, [this](const auto& p){ return IsMNValid(*p.second); });
+        return mnValidMap.size();
     }
 
     [[nodiscard]] size_t GetAllEvoCount() const
@@ -249,15 +297,16 @@ public:
 
     [[nodiscard]] size_t GetValidEvoCount() const
     {
-        return ranges::count_if(mnMap, [this](const auto& p) { return p.second->nType == MnType::Evo && IsMNValid(*p.second); });
+        return nValidCountByType[size_t(MnType::Evo)];
     }
 
     [[nodiscard]] size_t GetValidWeightedMNsCount() const
     {
-        return std::accumulate(mnMap.begin(), mnMap.end(), 0, [this](auto res, const auto& p) {
-                                                                if (!IsMNValid(*p.second)) return res;
-                                                                return res + GetMnType(p.second->nType).voting_weight;
-                                                            });
+        size_t count{0};
+        for (size_t type = 0; type < nValidCountByType.size(); ++type) {
+            count += nValidCountByType[type] * GetMnType(MnType(type)).voting_weight;
+        }
+        return count;
     }
 
     /**
@@ -269,10 +318,8 @@ public:
     template <typename Callback>
     void ForEachMN(bool onlyValid, Callback&& cb) const
     {
-        for (const auto& p : mnMap) {
-            if (!onlyValid || IsMNValid(*p.second)) {
-                cb(*p.second);
-            }
+        for (const auto& p : onlyValid ? mnValidMap : mnMap) {
+            cb(*p.second);
         }
     }
 
@@ -286,10 +333,8 @@ public:
     template <typename Callback>
     void ForEachMNShared(bool onlyValid, Callback&& cb) const
     {
-        for (const auto& p : mnMap) {
-            if (!onlyValid || IsMNValid(*p.second)) {
-                cb(p.second);
-            }
+        for (const auto& p : onlyValid ? mnValidMap : mnMap) {
+            cb(p.second);
         }
     }
 
@@ -315,6 +360,10 @@ public:
     {
         return nTotalRegisteredCount;
     }
+    void SetTotalRegisteredCount(uint32_t _totalRegisteredCount)
+    {
+        nTotalRegisteredCount = _totalRegisteredCount;
+    }
 
     [[nodiscard]] bool IsMNValid(const uint256& proTxHash) const;
     [[nodiscard]] bool IsMNPoSeBanned(const uint256& proTxHash) const;
@@ -393,6 +442,11 @@ public:
     void PoSeDecrease(const CDeterministicMN& dmn);
 
     [[nodiscard]] CDeterministicMNListDiff BuildDiff(const CDeterministicMNList& to) const;
+    /**
+     * Build the diff turning this list back into `from`, where this list is `from` with `diff` applied. Unlike
+     * BuildDiff, this only looks at the masternodes changed by `diff`.
+     */
+    [[nodiscard]] CDeterministicMNListDiff BuildUndoDiff(const CDeterministicMNList& from, const CDeterministicMNListDiff& diff) const;
     [[nodiscard]] CDeterministicMNList ApplyDiff(gsl::not_null<const CBlockIndex*> pindex, const CDeterministicMNListDiff& diff) const;
 
     void AddMN(const CDeterministicMNCPtr& dmn, bool fBumpTotalCount = true);
@@ -492,6 +546,179 @@ private:
     }
 };
 
+/**
+ * Compact disk format of CDeterministicMNList snapshots. Many masternodes share payout scripts (pools, hosting
+ * providers) and all revoked ones have the null operator key, so every distinct value is written once in a dictionary
+ * and masternodes refer to it by position. confirmedHashWithProRegTxHash and a voting key equal to the owner key are
+ * derived on load instead of stored, heights and counters are VARINTs.
+ */
+class CDeterministicMNListCompactSnapshot
+{
+private:
+    static constexpr uint8_t CURRENT_VERSION = 1;
+
+    enum : uint8_t {
+        FLAG_CONFIRMED_HASH = 0x01,
+        FLAG_HASH_WITH_PROTX = 0x02, // confirmedHashWithProRegTxHash doesn't follow from proTxHash and confirmedHash
+        FLAG_VOTING_IS_OWNER = 0x04,
+        FLAG_PLATFORM_FIELDS = 0x08,
+    };
+
+    // heights and the like are -1 when unset
+    template <typename Stream>
+    static void WriteInt(Stream& s, int v) { s << VARINT(uint32_t(int64_t{v} + 1)); }
+    template <typename Stream>
+    static int ReadInt(Stream& s)
+    {
+        uint32_t v;
+        s >> VARINT(v);
+        return int(int64_t{v} - 1);
+    }
+
+    static uint256 HashWithProTx(const uint256& proTxHash, const uint256& confirmedHash)
+    {
+        CDeterministicMNState tmp;
+        tmp.UpdateConfirmedHash(proTxHash, confirmedHash);
+        return tmp.confirmedHashWithProRegTxHash;
+    }
+
+public:
+    CDeterministicMNList list;
+
+    CDeterministicMNListCompactSnapshot() = default;
+    explicit CDeterministicMNListCompactSnapshot(CDeterministicMNList _list) : list(std::move(_list)) {}
+
+    template <typename Stream>
+    void Serialize(Stream& s) const
+    {
+        std::vector<CScript> scripts;
+        std::map<CScript, uint32_t> script_ids;
+        std::vector<std::vector<unsigned char>> keys;
+        std::map<std::vector<unsigned char>, uint32_t> key_ids;
+        const auto get_id = [](auto& dict, auto& ids, const auto& value) {
+            const auto [it, inserted] = ids.emplace(value, uint32_t(dict.size()));
+            if (inserted) dict.push_back(value);
+            return it->second;
+        };
+
+        struct Refs {
+            CDeterministicMNCPtr dmn;
+            uint32_t payout, operator_payout, key;
+        };
+        std::vector<Refs> mns;
+        mns.reserve(list.GetAllMNsCount());
+        list.ForEachMNShared(false, [&](const CDeterministicMNCPtr& dmn) {
+            const auto& state = *dmn->pdmnState;
+            std::vector<unsigned char> key_bytes;
+            CVectorWriter(SER_DISK, CLIENT_VERSION, key_bytes, 0,
+                          CBLSLazyPublicKeyVersionWrapper(const_cast<CBLSLazyPublicKey&>(state.pubKeyOperator), state.nVersion == CProRegTx::LEGACY_BLS_VERSION));
+            mns.push_back({dmn, get_id(scripts, script_ids, state.scriptPayout), get_id(scripts, script_ids, state.scriptOperatorPayout),
+                           get_id(keys, key_ids, key_bytes)});
+        });
+
+        s << CURRENT_VERSION << list.GetBlockHash() << list.GetHeight() << list.GetTotalRegisteredCount();
+        s << scripts << keys;
+        WriteCompactSize(s, mns.size());
+        for (const auto& [dmn, payout, operator_payout, key] : mns) {
+            const auto& state = *dmn->pdmnState;
+            s << dmn->proTxHash << VARINT(dmn->GetInternalId()) << dmn->collateralOutpoint << dmn->nOperatorReward << dmn->nType;
+
+            uint8_t flags{0};
+            if (!state.confirmedHash.IsNull()) flags |= FLAG_CONFIRMED_HASH;
+            if (state.confirmedHashWithProRegTxHash != (state.confirmedHash.IsNull() ? uint256() : HashWithProTx(dmn->proTxHash, state.confirmedHash))) {
+                flags |= FLAG_HASH_WITH_PROTX;
+            }
+            if (state.keyIDVoting == state.keyIDOwner) flags |= FLAG_VOTING_IS_OWNER;
+            if (!state.platformNodeID.IsNull() || state.platformP2PPort != 0 || state.platformHTTPPort != 0) flags |= FLAG_PLATFORM_FIELDS;
+            s << flags;
+
+            WriteInt(s, state.nVersion);
+            WriteInt(s, state.nRegisteredHeight);
+            WriteInt(s, state.nLastPaidHeight);
+            WriteInt(s, state.nConsecutivePayments);
+            WriteInt(s, state.nPoSePenalty);
+            WriteInt(s, state.nPoSeRevivedHeight);
+            WriteInt(s, state.GetBannedHeight());
+            s << VARINT(state.nRevocationReason);
+            if (flags & FLAG_CONFIRMED_HASH) s << state.confirmedHash;
+            if (flags & FLAG_HASH_WITH_PROTX) s << state.confirmedHashWithProRegTxHash;
+            s << state.keyIDOwner;
+            if (!(flags & FLAG_VOTING_IS_OWNER)) s << state.keyIDVoting;
+            s << state.addr << VARINT(payout) << VARINT(operator_payout) << VARINT(key);
+            if (flags & FLAG_PLATFORM_FIELDS) s << state.platformNodeID << state.platformP2PPort << state.platformHTTPPort;
+        }
+    }
+
+    template <typename Stream>
+    void Unserialize(Stream& s)
+    {
+        uint8_t version;
+        s >> version;
+        if (version != CURRENT_VERSION) {
+            throw std::ios_base::failure("Unknown compact masternode list snapshot version");
+        }
+        uint256 blockHash;
+        int nHeight;
+        uint32_t nTotalRegisteredCount;
+        std::vector<CScript> scripts;
+        std::vector<std::vector<unsigned char>> keys;
+        s >> blockHash >> nHeight >> nTotalRegisteredCount >> scripts >> keys;
+        list = CDeterministicMNList(blockHash, nHeight, nTotalRegisteredCount);
+
+        const auto lookup = [](const auto& dict, uint32_t id) -> const auto& {
+            if (id >= dict.size()) throw std::ios_base::failure("Invalid dictionary reference in masternode list snapshot");
+            return dict[id];
+        };
+        const size_t cnt = ReadCompactSize(s);
+        for (size_t i = 0; i < cnt; i++) {
+            uint256 proTxHash;
+            uint64_t internalId;
+            COutPoint collateralOutpoint;
+            uint16_t nOperatorReward;
+            MnType nType;
+            uint8_t flags;
+            s >> proTxHash >> VARINT(internalId) >> collateralOutpoint >> nOperatorReward >> nType >> flags;
+
+            auto dmn = std::make_shared<CDeterministicMN>(internalId, nType);
+            dmn->proTxHash = proTxHash;
+            dmn->collateralOutpoint = collateralOutpoint;
+            dmn->nOperatorReward = nOperatorReward;
+
+            auto state = std::make_shared<CDeterministicMNState>();
+            state->nVersion = ReadInt(s);
+            state->nRegisteredHeight = ReadInt(s);
+            state->nLastPaidHeight = ReadInt(s);
+            state->nConsecutivePayments = ReadInt(s);
+            state->nPoSePenalty = ReadInt(s);
+            state->nPoSeRevivedHeight = ReadInt(s);
+            state->BanIfNotBanned(ReadInt(s));
+            s >> VARINT(state->nRevocationReason);
+            if (flags & FLAG_CONFIRMED_HASH) {
+                uint256 confirmedHash;
+                s >> confirmedHash;
+                state->UpdateConfirmedHash(proTxHash, confirmedHash);
+            }
+            if (flags & FLAG_HASH_WITH_PROTX) s >> state->confirmedHashWithProRegTxHash;
+            s >> state->keyIDOwner;
+            if (flags & FLAG_VOTING_IS_OWNER) {
+                state->keyIDVoting = state->keyIDOwner;
+            } else {
+                s >> state->keyIDVoting;
+            }
+            uint32_t payout, operator_payout, key;
+            s >> state->addr >> VARINT(payout) >> VARINT(operator_payout) >> VARINT(key);
+            state->scriptPayout = lookup(scripts, payout);
+            state->scriptOperatorPayout = lookup(scripts, operator_payout);
+            SpanReader(SER_DISK, CLIENT_VERSION, lookup(keys, key), 0)
+                >> CBLSLazyPublicKeyVersionWrapper(state->pubKeyOperator, state->nVersion == CProRegTx::LEGACY_BLS_VERSION);
+            if (flags & FLAG_PLATFORM_FIELDS) s >> state->platformNodeID >> state->platformP2PPort >> state->platformHTTPPort;
+
+            dmn->pdmnState = state;
+            list.AddMN(dmn, false);
+        }
+    }
+};
+
 class CDeterministicMNListDiff
 {
 public:
@@ -555,6 +782,29 @@ public:
     }
 };
 
+/**
+ * Undo record of the masternode list changes of a block, stored when the block is connected so that disconnecting it
+ * derives the previous list from the current one instead of replaying diffs from the last snapshot.
+ */
+class CDeterministicMNListUndo
+{
+public:
+    //! nTotalRegisteredCount of the previous list, it is not reverted by applying the diff
+    uint32_t nTotalRegisteredCount{0};
+    //! Turns the list of the block into the list of its parent
+    CDeterministicMNListDiff diff;
+
+    SERIALIZE_METHODS(CDeterministicMNListUndo, obj)
+    {
+        READWRITE(obj.nTotalRegisteredCount, obj.diff);
+    }
+};
+
+//! Default for -mnlistsnapshotinterval, the number of blocks between two regular MN list snapshots on disk
+static constexpr int DEFAULT_MNLIST_SNAPSHOT_INTERVAL = 576;
+//! Default for -mnlistcachesize, the memory budget in MiB for MN lists kept in memory
+static constexpr int64_t DEFAULT_MNLIST_CACHE_SIZE = 256;
+
 struct MNListUpdates
 {
     CDeterministicMNList old_list;
@@ -564,10 +814,12 @@ struct MNListUpdates
 
 class CDeterministicMNManager
 {
-    static constexpr int DISK_SNAPSHOT_PERIOD = 576; // once per day
     // keep cache for enough disk snapshots to have all active quourms covered
-    static constexpr int DISK_SNAPSHOTS = 2304 / DISK_SNAPSHOT_PERIOD + 1;
-    static constexpr int LIST_DIFFS_CACHE_SIZE = DISK_SNAPSHOT_PERIOD * DISK_SNAPSHOTS;
+    static constexpr int ACTIVE_QUORUMS_BLOCKS = 2304;
+    // A list which had to be rebuilt from at least this many diffs (relative to the snapshot interval) for the second
+    // time gets its own snapshot on disk, so that lists which are queried often are cheap to rebuild
+    static constexpr int ADAPTIVE_SNAPSHOT_REPLAY_DIVISOR = 8;
+    static constexpr int ADAPTIVE_SNAPSHOT_MIN_QUERIES = 2;
 
 private:
     Mutex cs;
@@ -582,14 +834,26 @@ private:
     CConnman& connman;
     CEvoDB& m_evoDb;
 
+    const int m_snapshot_interval;
+    // ACTIVE_QUORUMS_BLOCKS rounded up to whole snapshot intervals, plus one more snapshot
+    const int m_list_diffs_cache_size;
+    const size_t m_cache_size_bytes;
+
     std::unordered_map<uint256, CDeterministicMNList, StaticSaltedHasher> mnListsCache GUARDED_BY(cs);
     std::unordered_map<uint256, CDeterministicMNListDiff, StaticSaltedHasher> mnListDiffsCache GUARDED_BY(cs);
+    // how often lists which are expensive to rebuild were requested
+    unordered_lru_cache<uint256, int, StaticSaltedHasher, 1024> expensiveListQueries GUARDED_BY(cs);
     const CBlockIndex* tipIndex GUARDED_BY(cs) {nullptr};
     const CBlockIndex* m_initial_snapshot_index GUARDED_BY(cs) {nullptr};
 
 public:
-    explicit CDeterministicMNManager(CChainState& chainstate, CConnman& _connman, CEvoDB& evoDb) :
-        m_chainstate(chainstate), connman(_connman), m_evoDb(evoDb) {}
+    explicit CDeterministicMNManager(CChainState& chainstate, CConnman& _connman, CEvoDB& evoDb,
+                                     int snapshot_interval = DEFAULT_MNLIST_SNAPSHOT_INTERVAL,
+                                     int64_t cache_size_mb = DEFAULT_MNLIST_CACHE_SIZE) :
+        m_chainstate(chainstate), connman(_connman), m_evoDb(evoDb),
+        m_snapshot_interval(std::max(snapshot_interval, 1)),
+        m_list_diffs_cache_size(m_snapshot_interval * (ACTIVE_QUORUMS_BLOCKS / m_snapshot_interval + 1)),
+        m_cache_size_bytes(size_t(std::max<int64_t>(cache_size_mb, 0)) << 20) {}
     ~CDeterministicMNManager() = default;
 
     bool ProcessBlock(const CBlock& block, gsl::not_null<const CBlockIndex*> pindex, BlockValidationState& state,
@@ -609,6 +873,9 @@ public:
     };
     CDeterministicMNList GetListAtChainTip() LOCKS_EXCLUDED(cs);
 
+    // Memory used by all cached lists, with everything they share counted once
+    size_t GetListsCacheMemoryUsage() LOCKS_EXCLUDED(cs);
+
     // Test if given TX is a ProRegTx which also contains the collateral at index n
     static bool IsProTxWithCollateral(const CTransactionRef& tx, uint32_t n);
 
@@ -622,10 +889,11 @@ private:
     CDeterministicMNList GetListForBlockInternal(gsl::not_null<const CBlockIndex*> pindex) EXCLUSIVE_LOCKS_REQUIRED(cs);
 };
 
-bool CheckProRegTx(const CTransaction& tx, gsl::not_null<const CBlockIndex*> pindexPrev, TxValidationState& state, const CCoinsViewCache& view, bool check_sigs);
-bool CheckProUpServTx(const CTransaction& tx, gsl::not_null<const CBlockIndex*> pindexPrev, TxValidationState& state, bool check_sigs);
-bool CheckProUpRegTx(const CTransaction& tx, gsl::not_null<const CBlockIndex*> pindexPrev, TxValidationState& state, const CCoinsViewCache& view, bool check_sigs);
-bool CheckProUpRevTx(const CTransaction& tx, gsl::not_null<const CBlockIndex*> pindexPrev, TxValidationState& state, bool check_sigs);
+// If pvChecks is not null, the payload signature checks are appended to it instead of being run
+bool CheckProRegTx(const CTransaction& tx, gsl::not_null<const CBlockIndex*> pindexPrev, TxValidationState& state, const CCoinsViewCache& view, bool check_sigs, std::vector<CSpecialTxSigCheck>* pvChecks = nullptr);
+bool CheckProUpServTx(const CTransaction& tx, gsl::not_null<const CBlockIndex*> pindexPrev, TxValidationState& state, bool check_sigs, std::vector<CSpecialTxSigCheck>* pvChecks = nullptr);
+bool CheckProUpRegTx(const CTransaction& tx, gsl::not_null<const CBlockIndex*> pindexPrev, TxValidationState& state, const CCoinsViewCache& view, bool check_sigs, std::vector<CSpecialTxSigCheck>* pvChecks = nullptr);
+bool CheckProUpRevTx(const CTransaction& tx, gsl::not_null<const CBlockIndex*> pindexPrev, TxValidationState& state, bool check_sigs, std::vector<CSpecialTxSigCheck>* pvChecks = nullptr);
 
 extern std::unique_ptr<CDeterministicMNManager> deterministicMNManager;
 
@@ -4,7 +4,12 @@
 
 #include <evo/evodb.h>
 
+#include <hash.h>
+#include <logging.h>
+#include <streams.h>
 #include <uint256.h>
+#include <util/time.h>
+#include <util/trace.h>
 
 CEvoDBScopedCommitter::CEvoDBScopedCommitter(CEvoDB &_evoDB) :
     evoDB(_evoDB)
@@ -31,11 +36,17 @@ void CEvoDBScopedCommitter::Rollback()
     evoDB.RollbackCurTransaction();
 }
 
-CEvoDB::CEvoDB(size_t nCacheSize, bool fMemory, bool fWipe) :
-    db(fMemory ? "" : (GetDataDir() / "evodb"), nCacheSize, fMemory, fWipe),
+// Masternode list and quorum lookups are spread over a large key range, a private cache too small for them
+// would mostly thrash while the other databases sharing the cache are idle. It is written on every block alongside the
+// chainstate, so it compacts on its own thread as well.
+static const DBProfile EVODB_PROFILE{/*bloom_bits=*/10, /*write_buffer_size=*/0, /*shared_cache=*/true, /*own_compaction_thread=*/true};
+
+CEvoDB::CEvoDB(size_t nCacheSize, bool fMemory, bool fWipe, size_t nIBDBatchSize) :
+    db(fMemory ? "" : (GetDataDir() / "evodb"), nCacheSize, fMemory, fWipe, /*obfuscate=*/false, EVODB_PROFILE),
     rootBatch(db),
     rootDBTransaction(db, rootBatch),
-    curDBTransaction(rootDBTransaction, rootDBTransaction)
+    curDBTransaction(rootDBTransaction, rootDBTransaction),
+    nMaxIBDBatchSize(nIBDBatchSize)
 {
 }
 
@@ -55,9 +66,16 @@ bool CEvoDB::CommitRootTransaction()
 {
     LOCK(cs);
     assert(curDBTransaction.IsClean());
+    [[maybe_unused]] const int64_t nStart = GetTimeMicros();
     rootDBTransaction.Commit();
+    [[maybe_unused]] const size_t nBatchSize = rootBatch.SizeEstimate();
     bool ret = db.WriteBatch(rootBatch);
     rootBatch.Clear();
+    TRACE3(evodb, commit,
+        nBatchSize,
+        GetTimeMicros() - nStart,
+        ret
+    );
     return ret;
 }
 
@@ -76,3 +94,89 @@ void CEvoDB::WriteBestBlock(const uint256& hash)
 {
     Write(EVODB_BEST_BLOCK, hash);
 }
+
+static bool IsBestBlockKey(const std::vector<unsigned char>& key)
+{
+    static const std::vector<unsigned char> best_block_key = [] {
+        CDataStream ss(SER_DISK, CLIENT_VERSION);
+        ss << EVODB_BEST_BLOCK;
+        return std::vector<unsigned char>(UCharCast(ss.data()), UCharCast(ss.data() + ss.size()));
+    }();
+    return key == best_block_key;
+}
+
+static bool GetSnapshotEntry(CDBIterator& cursor, std::vector<unsigned char>& key, std::vector<unsigned char>& value)
+{
+    const CDataStream ssKey = cursor.GetKey();
+    key.assign(UCharCast(ssKey.data()), UCharCast(ssKey.data() + ssKey.size()));
+    if (IsBestBlockKey(key)) {
+        return false;
+    }
+    value.resize(cursor.GetValueSize());
+    Span<unsigned char> value_span{value};
+    return cursor.GetValue(value_span);
+}
+
+uint64_t CEvoDB::CountSnapshotEntries(CDBIterator& cursor)
+{
+    uint64_t nEntries{0};
+    std::vector<unsigned char> key, value;
+    for (cursor.SeekToFirst(); cursor.Valid(); cursor.Next()) {
+        if (GetSnapshotEntry(cursor, key, value)) {
+            nEntries++;
+        }
+    }
+    return nEntries;
+}
+
+uint256 CEvoDB::DumpSnapshot(CDBIterator& cursor, CAutoFile& file)
+{
+    CHashWriter hasher(SER_GETHASH, 0);
+    std::vector<unsigned char> key, value;
+    for (cursor.SeekToFirst(); cursor.Valid(); cursor.Next()) {
+        if (GetSnapshotEntry(cursor, key, value)) {
+            file << key << value;
+            hasher << key << value;
+        }
+    }
+    return hasher.GetHash();
+}
+
+std::optional<uint256> CEvoDB::ReadSnapshot(CAutoFile& file, uint64_t nEntries, CDBBatch& batch)
+{
+    CHashWriter hasher(SER_GETHASH, 0);
+    std::vector<unsigned char> key, value;
+    uint64_t nSkipped{0};
+    for (uint64_t i = 0; i < nEntries; i++) {
+        try {
+            file >> key >> value;
+        } catch (const std::ios_base::failure&) {
+            LogPrintf("CEvoDB::%s -- truncated snapshot after %d of %d entries\n", __func__, i, nEntries);
+            return std::nullopt;
+        }
+        if (IsBestBlockKey(key)) {
+            LogPrintf("CEvoDB::%s -- unexpected best block entry in snapshot\n", __func__);
+            return std::nullopt;
+        }
+        hasher << key << value;
+        const Span<const unsigned char> key_span{key};
+        if (db.Exists(key_span)) {
+            nSkipped++;
+            continue;
+        }
+        batch.Write(key_span, Span<const unsigned char>{value});
+    }
+    LogPrintf("CEvoDB::%s -- read %d entries, %d of them already known\n", __func__, nEntries, nSkipped);
+    return hasher.GetHash();
+}
+
+bool CEvoDB::ApplySnapshot(CDBBatch& batch, const uint256& base_blockhash)
+{
+    // Pending writes go first, the snapshot entries must not be shadowed by the transaction caches
+    if (!CommitRootTransaction()) {
+        return false;
+    }
+    LOCK(cs);
+    batch.Write(EVODB_BEST_BLOCK, base_blockhash);
+    return db.WriteBatch(batch, true);
+}
@@ -8,6 +8,9 @@
 #include <dbwrapper.h>
 #include <sync.h>
 
+#include <optional>
+
+class CAutoFile;
 class uint256;
 // "b_b" was used in the initial version of deterministic MN storage
 // "b_b2" was used after compact diffs were introduced
@@ -15,6 +18,9 @@ class uint256;
 // "b_b4" was used after storing protx version for each masternode in evoDB
 static const std::string EVODB_BEST_BLOCK = "b_b4";
 
+//! Pending EvoDB writes (in MiB) which force a chainstate flush
+static constexpr size_t DEFAULT_EVODB_BATCH_SIZE = 64;
+
 class CEvoDB;
 
 class CEvoDBScopedCommitter
@@ -45,8 +51,11 @@ private:
     RootTransaction rootDBTransaction;
     CurTransaction curDBTransaction;
 
+    // limit for pending writes while in initial block download, see IsFlushNeeded()
+    const size_t nMaxIBDBatchSize;
+
 public:
-    explicit CEvoDB(size_t nCacheSize, bool fMemory = false, bool fWipe = false);
+    explicit CEvoDB(size_t nCacheSize, bool fMemory = false, bool fWipe = false, size_t nIBDBatchSize = DEFAULT_EVODB_BATCH_SIZE << 20);
 
     std::unique_ptr<CEvoDBScopedCommitter> BeginTransaction() LOCKS_EXCLUDED(cs)
     {
@@ -98,6 +107,16 @@ public:
         return rootDBTransaction.GetMemoryUsage();
     }
 
+    /**
+     * Whether the writes pending in the root transaction are large enough to force a flush.
+     * They are committed together with the coins cache, which carries the best block marker,
+     * so during initial block download a larger limit folds more blocks into one batch.
+     */
+    [[nodiscard]] bool IsFlushNeeded(bool fInitialDownload) const
+    {
+        return GetMemoryUsage() >= (fInitialDownload ? nMaxIBDBatchSize : DEFAULT_EVODB_BATCH_SIZE << 20);
+    }
+
     bool CommitRootTransaction() LOCKS_EXCLUDED(cs);
 
     bool IsEmpty() { return db.IsEmpty(); }
@@ -105,6 +124,22 @@ public:
     bool VerifyBestBlock(const uint256& hash);
     void WriteBestBlock(const uint256& hash);
 
+    /**
+     * The evo database section of a UTXO snapshot: every entry but the best block marker, as raw
+     * key and value bytes in key order. The cursor must be taken right after a flush, so that
+     * it reflects the state at the snapshot base. Returns the hash of the written entries.
+     */
+    static uint64_t CountSnapshotEntries(CDBIterator& cursor);
+    static uint256 DumpSnapshot(CDBIterator& cursor, CAutoFile& file);
+    /**
+     * Read the evo section of a snapshot into batch, skipping entries already on disk. Their
+     * keys contain the block or quorum hash they belong to, so a chainstate validating the
+     * history below the snapshot base writes the same values. Returns the hash of the section.
+     */
+    std::optional<uint256> ReadSnapshot(CAutoFile& file, uint64_t nEntries, CDBBatch& batch) LOCKS_EXCLUDED(cs);
+    /** Write a batch filled by ReadSnapshot() with the snapshot base as best block */
+    bool ApplySnapshot(CDBBatch& batch, const uint256& base_blockhash) LOCKS_EXCLUDED(cs);
+
 private:
     // only CEvoDBScopedCommitter is allowed to invoke these
     friend class CEvoDBScopedCommitter;
@@ -5,6 +5,7 @@
 #include <evo/mnauth.h>
 
 #include <bls/bls.h>
+#include <bls/bls_worker.h>
 #include <chain.h>
 #include <chainparams.h>
 #include <deploymentstatus.h>
@@ -14,10 +15,12 @@
 #include <masternode/node.h>
 #include <masternode/sync.h>
 #include <net.h>
+#include <net_processing.h>
 #include <net_types.h>
 #include <netmessagemaker.h>
 #include <util/time.h>
 #include <validation.h>
+#include <version.h>
 
 void CMNAuth::PushMNAUTH(CNode& peer, CConnman& connman, const CBlockIndex* tip)
 {
@@ -58,65 +61,13 @@ void CMNAuth::PushMNAUTH(CNode& peer, CConnman& connman, const CBlockIndex* tip)
     connman.PushMessage(&peer, CNetMsgMaker(peer.GetCommonVersion()).Make(NetMsgType::MNAUTH, mnauth));
 }
 
-PeerMsgRet CMNAuth::ProcessMessage(CNode& peer, CConnman& connman, std::string_view msg_type, CDataStream& vRecv)
-{
-    if (msg_type != NetMsgType::MNAUTH || !::masternodeSync->IsBlockchainSynced()) {
-        // we can't verify MNAUTH messages when we don't have the latest MN list
-        return {};
-    }
-
-    CMNAuth mnauth;
-    vRecv >> mnauth;
-
-    // only one MNAUTH allowed
-    if (!peer.GetVerifiedProRegTxHash().IsNull()) {
-        return tl::unexpected{MisbehavingError{100, "duplicate mnauth"}};
-    }
-
-    if ((~peer.nServices) & (NODE_NETWORK | NODE_BLOOM)) {
-        // either NODE_NETWORK or NODE_BLOOM bit is missing in node's services
-        return tl::unexpected{MisbehavingError{100, "mnauth from a node with invalid services"}};
-    }
-
-    if (mnauth.proRegTxHash.IsNull()) {
-        return tl::unexpected{MisbehavingError{100, "empty mnauth proRegTxHash"}};
-    }
-
-    if (!mnauth.sig.IsValid()) {
-        LogPrint(BCLog::NET_NETCONN, "CMNAuth::ProcessMessage -- invalid mnauth for protx=%s with sig=%s\n", mnauth.proRegTxHash.ToString(), mnauth.sig.ToString());
-        return tl::unexpected{MisbehavingError{100, "invalid mnauth signature"}};
-    }
-
-    const auto mnList = deterministicMNManager->GetListAtChainTip();
-    const auto dmn = mnList.GetMN(mnauth.proRegTxHash);
-    if (!dmn) {
-        // in case node was unlucky and not up to date, just let it be connected as a regular node, which gives it
-        // a chance to get up-to-date and thus realize that it's not a MN anymore. We still give it a
-        // low DoS score.
-        return tl::unexpected{MisbehavingError{10, "missing mnauth masternode"}};
-    }
+/** Serializes the verified MNAUTHs, which are completed on the BLS worker threads, for the duplicate checks below */
+static Mutex cs_verified_mnauth;
 
-    uint256 signHash;
-    int nOurNodeVersion{PROTOCOL_VERSION};
-    if (Params().NetworkIDString() != CBaseChainParams::MAIN && gArgs.IsArgSet("-pushversion")) {
-        nOurNodeVersion = gArgs.GetArg("-pushversion", PROTOCOL_VERSION);
-    }
-    const CBlockIndex* tip = ::ChainActive().Tip();
-    const bool is_basic_scheme_active{DeploymentActiveAfter(tip, Params().GetConsensus(), Consensus::DEPLOYMENT_V19)};
-    ConstCBLSPublicKeyVersionWrapper pubKey(dmn->pdmnState->pubKeyOperator.Get(), !is_basic_scheme_active);
-    // See comment in PushMNAUTH (fInbound is negated here as we're on the other side of the connection)
-    if (peer.nVersion < MNAUTH_NODE_VER_VERSION || nOurNodeVersion < MNAUTH_NODE_VER_VERSION) {
-        signHash = ::SerializeHash(std::make_tuple(pubKey, peer.GetSentMNAuthChallenge(), !peer.IsInboundConn()));
-    } else {
-        signHash = ::SerializeHash(std::make_tuple(pubKey, peer.GetSentMNAuthChallenge(), !peer.IsInboundConn(), peer.nVersion.load()));
-    }
-    LogPrint(BCLog::NET_NETCONN, "CMNAuth::%s -- constructed signHash for nVersion %d, peer=%d\n", __func__, peer.nVersion, peer.GetId());
-
-    if (!mnauth.sig.VerifyInsecure(dmn->pdmnState->pubKeyOperator.Get(), signHash)) {
-        // Same as above, MN seems to not know its fate yet, so give it a chance to update. If this is a
-        // malicious node (DoSing us), it'll get banned soon.
-        return tl::unexpected{MisbehavingError{10, "mnauth signature verification failed"}};
-    }
+/** The part of MNAUTH processing done once the signature was verified by the BLS worker */
+static void ProcessVerifiedMNAUTH(CNode& peer, CConnman& connman, const CMNAuth& mnauth, const CDeterministicMNCPtr& dmn)
+{
+    LOCK(cs_verified_mnauth);
 
     if (!peer.IsInboundConn()) {
         mmetaman->GetMetaInfo(mnauth.proRegTxHash)->SetLastOutboundSuccess(GetTime<std::chrono::seconds>().count());
@@ -124,7 +75,7 @@ PeerMsgRet CMNAuth::ProcessMessage(CNode& peer, CConnman& connman, std::string_v
             LogPrint(BCLog::NET_NETCONN, "CMNAuth::ProcessMessage -- Masternode probe successful for %s, disconnecting. peer=%d\n",
                      mnauth.proRegTxHash.ToString(), peer.GetId());
             peer.fDisconnect = true;
-            return {};
+            return;
         }
     }
 
@@ -169,7 +120,7 @@ PeerMsgRet CMNAuth::ProcessMessage(CNode& peer, CConnman& connman, std::string_v
     });
 
     if (peer.fDisconnect) {
-        return {};
+        return;
     }
 
     peer.SetVerifiedProRegTxHash(mnauth.proRegTxHash);
@@ -182,39 +133,131 @@ PeerMsgRet CMNAuth::ProcessMessage(CNode& peer, CConnman& connman, std::string_v
         // this message as they are usually only interested in the higher level messages.
         const CNetMsgMaker msgMaker(peer.GetCommonVersion());
         connman.PushMessage(&peer, msgMaker.Make(NetMsgType::QSENDRECSIGS, true));
+        // We can rebuild ISLOCKs/CLSIGs from those recovered sigs, so ask for them in compact form too
+        if (peer.GetCommonVersion() >= COMPACT_LOCKS_PROTO_VERSION) {
+            connman.PushMessage(&peer, msgMaker.Make(NetMsgType::SENDCMPCTLOCKS, true));
+        }
         peer.m_masternode_iqr_connection = true;
     }
 
-    LogPrint(BCLog::NET_NETCONN, "CMNAuth::%s -- Valid MNAUTH for %s, peer=%d\n", __func__, mnauth.proRegTxHash.ToString(), peer.GetId());
+    LogPrint(BCLog::NET_NETCONN, "CMNAuth::ProcessMessage -- Valid MNAUTH for %s, peer=%d\n", mnauth.proRegTxHash.ToString(), peer.GetId());
+}
+
+PeerMsgRet CMNAuth::ProcessMessage(CNode& peer, PeerManager& peerman, CConnman& connman, CBLSWorker& blsWorker, std::string_view msg_type, CDataStream& vRecv)
+{
+    if (msg_type != NetMsgType::MNAUTH || !::masternodeSync->IsBlockchainSynced()) {
+        // we can't verify MNAUTH messages when we don't have the latest MN list
+        return {};
+    }
+
+    CMNAuth mnauth;
+    vRecv >> mnauth;
+
+    // only one MNAUTH allowed
+    if (!peer.GetVerifiedProRegTxHash().IsNull()) {
+        return tl::unexpected{MisbehavingError{100, "duplicate mnauth"}};
+    }
+
+    if ((~peer.nServices) & (NODE_NETWORK | NODE_BLOOM)) {
+        // either NODE_NETWORK or NODE_BLOOM bit is missing in node's services
+        return tl::unexpected{MisbehavingError{100, "mnauth from a node with invalid services"}};
+    }
+
+    if (mnauth.proRegTxHash.IsNull()) {
+        return tl::unexpected{MisbehavingError{100, "empty mnauth proRegTxHash"}};
+    }
+
+    if (!mnauth.sig.IsValid()) {
+        LogPrint(BCLog::NET_NETCONN, "CMNAuth::ProcessMessage -- invalid mnauth for protx=%s with sig=%s\n", mnauth.proRegTxHash.ToString(), mnauth.sig.ToString());
+        return tl::unexpected{MisbehavingError{100, "invalid mnauth signature"}};
+    }
+
+    const auto mnList = deterministicMNManager->GetListAtChainTip();
+    const auto dmn = mnList.GetMN(mnauth.proRegTxHash);
+    if (!dmn) {
+        // in case node was unlucky and not up to date, just let it be connected as a regular node, which gives it
+        // a chance to get up-to-date and thus realize that it's not a MN anymore. We still give it a
+        // low DoS score.
+        return tl::unexpected{MisbehavingError{10, "missing mnauth masternode"}};
+    }
+
+    uint256 signHash;
+    int nOurNodeVersion{PROTOCOL_VERSION};
+    if (Params().NetworkIDString() != CBaseChainParams::MAIN && gArgs.IsArgSet("-pushversion")) {
+        nOurNodeVersion = gArgs.GetArg("-pushversion", PROTOCOL_VERSION);
+    }
+    const CBlockIndex* tip = ::ChainActive().Tip();
+    const bool is_basic_scheme_active{DeploymentActiveAfter(tip, Params().GetConsensus(), Consensus::DEPLOYMENT_V19)};
+    ConstCBLSPublicKeyVersionWrapper pubKey(dmn->pdmnState->pubKeyOperator.Get(), !is_basic_scheme_active);
+    // See comment in PushMNAUTH (fInbound is negated here as we're on the other side of the connection)
+    if (peer.nVersion < MNAUTH_NODE_VER_VERSION || nOurNodeVersion < MNAUTH_NODE_VER_VERSION) {
+        signHash = ::SerializeHash(std::make_tuple(pubKey, peer.GetSentMNAuthChallenge(), !peer.IsInboundConn()));
+    } else {
+        signHash = ::SerializeHash(std::make_tuple(pubKey, peer.GetSentMNAuthChallenge(), !peer.IsInboundConn(), peer.nVersion.load()));
+    }
+    LogPrint(BCLog::NET_NETCONN, "CMNAuth::%s -- constructed signHash for nVersion %d, peer=%d\n", __func__, peer.nVersion, peer.GetId());
+
+    // The peer's next messages are only processed once the signature was checked, they may depend on the peer being
+    // verified (e.g. quorum relay messages)
+    peer.m_mnauth_pending = true;
+    blsWorker.AsyncVerifySig(mnauth.sig, dmn->pdmnState->pubKeyOperator.Get(), signHash,
+        [&peerman, &connman, nodeId = peer.GetId(), mnauth, dmn](bool valid) {
+            CNode* pnode{nullptr};
+            connman.ForNode(nodeId, CConnman::AllNodes, [&pnode](CNode* pnode2) {
+                pnode = pnode2->AddRef();
+                return true;
+            });
+            if (pnode == nullptr) {
+                return;
+            }
+            if (!valid) {
+                // Same as above, MN seems to not know its fate yet, so give it a chance to update. If this is a
+                // malicious node (DoSing us), it'll get banned soon.
+                peerman.Misbehaving(nodeId, 10, "mnauth signature verification failed");
+            } else if (!pnode->fDisconnect) {
+                ProcessVerifiedMNAUTH(*pnode, connman, mnauth, dmn);
+            }
+            pnode->m_mnauth_pending = false;
+            pnode->Release();
+            connman.WakeMessageHandler();
+        });
     return {};
 }
 
 void CMNAuth::NotifyMasternodeListChanged(bool undo, const CDeterministicMNList& oldMNList, const CDeterministicMNListDiff& diff, CConnman& connman)
 {
-    // we're only interested in updated/removed MNs. Added MNs are of no interest for us
-    if (diff.updatedMNs.empty() && diff.removedMns.empty()) {
+    // we're only interested in removed MNs and changed operator keys. Added MNs are of no interest for us. The
+    // affected MNs are collected first so that the nodes are only walked when a verified link may be invalid now,
+    // most diffs only update payment or PoSe state.
+    // proTxHash -> new operator key hash, null for removed MNs
+    std::map<uint256, uint256> changedMNs;
+    for (const auto& internalId : diff.removedMns) {
+        if (const auto dmn = oldMNList.GetMNByInternalId(internalId)) {
+            changedMNs.emplace(dmn->proTxHash, uint256());
+        }
+    }
+    for (const auto& [internalId, stateDiff] : diff.updatedMNs) {
+        if (!(stateDiff.fields & CDeterministicMNStateDiff::Field_pubKeyOperator)) {
+            continue;
+        }
+        if (const auto dmn = oldMNList.GetMNByInternalId(internalId)) {
+            changedMNs.emplace(dmn->proTxHash, stateDiff.state.pubKeyOperator.GetHash());
+        }
+    }
+    if (changedMNs.empty()) {
         return;
     }
 
-    connman.ForEachNode([&oldMNList, &diff](CNode* pnode) {
+    connman.ForEachNode([&changedMNs](CNode* pnode) {
         const auto verifiedProRegTxHash = pnode->GetVerifiedProRegTxHash();
         if (verifiedProRegTxHash.IsNull()) {
             return;
         }
-        const auto verifiedDmn = oldMNList.GetMN(verifiedProRegTxHash);
-        if (!verifiedDmn) {
+        const auto it = changedMNs.find(verifiedProRegTxHash);
+        if (it == changedMNs.end()) {
             return;
         }
-        bool doRemove = false;
-        if (diff.removedMns.count(verifiedDmn->GetInternalId())) {
-            doRemove = true;
-        } else if (const auto it = diff.updatedMNs.find(verifiedDmn->GetInternalId()); it != diff.updatedMNs.end()) {
-            if ((it->second.fields & CDeterministicMNStateDiff::Field_pubKeyOperator) && it->second.state.pubKeyOperator.GetHash() != pnode->GetVerifiedPubKeyHash()) {
-                doRemove = true;
-            }
-        }
-
-        if (doRemove) {
+        if (it->second.IsNull() || it->second != pnode->GetVerifiedPubKeyHash()) {
             LogPrint(BCLog::NET_NETCONN, "CMNAuth::NotifyMasternodeListChanged -- Disconnecting MN %s due to key changed/removed, peer=%d\n",
                      verifiedProRegTxHash.ToString(), pnode->GetId());
             pnode->fDisconnect = true;
@@ -10,12 +10,14 @@
 #include <serialize.h>
 
 class CBlockIndex;
+class CBLSWorker;
 class CConnman;
 class CDataStream;
 class CDeterministicMN;
 class CDeterministicMNList;
 class CDeterministicMNListDiff;
 class CNode;
+class PeerManager;
 
 class UniValue;
 
@@ -48,7 +50,11 @@ public:
     }
 
     static void PushMNAUTH(CNode& peer, CConnman& connman, const CBlockIndex* tip);
-    static PeerMsgRet ProcessMessage(CNode& peer, CConnman& connman, std::string_view msg_type, CDataStream& vRecv);
+    /**
+     * The signature is verified by the BLS worker, the peer's later messages wait for the result. Misbehavior found
+     * after the verification is reported to peerman directly.
+     */
+    static PeerMsgRet ProcessMessage(CNode& peer, PeerManager& peerman, CConnman& connman, CBLSWorker& blsWorker, std::string_view msg_type, CDataStream& vRecv);
     static void NotifyMasternodeListChanged(bool undo, const CDeterministicMNList& oldMNList, const CDeterministicMNListDiff& diff, CConnman& connman);
 };
 
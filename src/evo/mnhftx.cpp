@@ -2,6 +2,7 @@
 // Distributed under the MIT software license, see the accompanying
 // file COPYING or http://www.opensource.org/licenses/mit-license.php.
 
+#include <bls/bls_sigcache.h>
 #include <consensus/validation.h>
 #include <deploymentstatus.h>
 #include <evo/mnhftx.h>
@@ -93,7 +94,7 @@ bool MNHFTx::Verify(const uint256& quorumHash, const uint256& requestId, const u
     const auto quorum = llmq::quorumManager->GetQuorum(llmqType, quorumHash);
 
     const uint256 signHash = llmq::BuildSignHash(llmqType, quorum->qc->quorumHash, requestId, msgHash);
-    if (!sig.VerifyInsecure(quorum->qc->quorumPublicKey, signHash)) {
+    if (!VerifyInsecureCached(sig, quorum->qc->quorumPublicKey, signHash)) {
         return state.Invalid(TxValidationResult::TX_CONSENSUS, "bad-mnhf-invalid");
     }
 
@@ -282,6 +283,11 @@ CMNHFManager::Signals CMNHFManager::GetForBlock(const CBlockIndex* pindex)
         if (!ReadBlockFromDisk(block, pindex_top, consensusParams)) {
             throw std::runtime_error("failed-getehfforblock-read");
         }
+        if (WITH_LOCK(::cs_main, return pindex_top->IsValid(BLOCK_VALID_SCRIPTS))) {
+            signalsTmp = ReplayBlock(block, pindex_top);
+            to_calculate.pop();
+            continue;
+        }
         BlockValidationState state;
         signalsTmp = ProcessBlock(block, pindex_top, false, state);
         if (!signalsTmp.has_value()) {
@@ -294,6 +300,19 @@ CMNHFManager::Signals CMNHFManager::GetForBlock(const CBlockIndex* pindex)
     return *signalsTmp;
 }
 
+CMNHFManager::Signals CMNHFManager::ReplayBlock(const CBlock& block, const CBlockIndex* const pindex)
+{
+    Signals signals = GetSignalsStage(pindex->pprev);
+    for (size_t i = 1; i < block.vtx.size(); ++i) {
+        const auto versionBit = extractEHFSignal(*block.vtx[i]);
+        if (versionBit && Params().IsValidMNActivation(*versionBit, pindex->GetMedianTimePast())) {
+            signals.insert({*versionBit, pindex->nHeight});
+        }
+    }
+    AddToCache(signals, pindex);
+    return signals;
+}
+
 std::optional<CMNHFManager::Signals> CMNHFManager::GetFromCache(const CBlockIndex* const pindex)
 {
     Signals signals{};
@@ -306,35 +325,45 @@ std::optional<CMNHFManager::Signals> CMNHFManager::GetFromCache(const CBlockInde
 
 
     const uint256& blockHash = pindex->GetBlockHash();
+    std::shared_ptr<const Signals> cached;
     {
         LOCK(cs_cache);
-        if (mnhfCache.get(blockHash, signals)) {
-            return signals;
+        if (mnhfCache.get(blockHash, cached)) {
+            return *cached;
         }
     }
     {
         LOCK(cs_cache);
         if (ThresholdState::ACTIVE != v20_activation.State(pindex->pprev, Params().GetConsensus(), Consensus::DEPLOYMENT_V20)) {
-            mnhfCache.insert(blockHash, signals);
+            mnhfCache.insert(blockHash, std::make_shared<const Signals>());
             return signals;
         }
     }
     if (m_evoDb.Read(std::make_pair(DB_SIGNALS, blockHash), signals)) {
-        LOCK(cs_cache);
-        mnhfCache.insert(blockHash, signals);
+        InsertToCache(signals, pindex);
         return signals;
     }
     return std::nullopt;
 }
 
+void CMNHFManager::InsertToCache(const Signals& signals, const CBlockIndex* const pindex)
+{
+    std::shared_ptr<const Signals> shared;
+    LOCK(cs_cache);
+    if (pindex->pprev != nullptr && pindex->pprev->phashBlock != nullptr &&
+        mnhfCache.get(pindex->pprev->GetBlockHash(), shared) && *shared == signals) {
+        // most blocks keep the signals of their parent, share its copy
+    } else {
+        shared = std::make_shared<const Signals>(signals);
+    }
+    mnhfCache.insert(pindex->GetBlockHash(), shared);
+}
+
 void CMNHFManager::AddToCache(const Signals& signals, const CBlockIndex* const pindex)
 {
     assert(pindex != nullptr);
     const uint256& blockHash = pindex->GetBlockHash();
-    {
-        LOCK(cs_cache);
-        mnhfCache.insert(blockHash, signals);
-    }
+    InsertToCache(signals, pindex);
     {
         LOCK(cs_cache);
         if (ThresholdState::ACTIVE != v20_activation.State(pindex->pprev, Params().GetConsensus(), Consensus::DEPLOYMENT_V20)) return;
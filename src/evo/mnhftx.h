@@ -11,6 +11,7 @@
 #include <threadsafety.h>
 #include <univalue.h>
 
+#include <memory>
 #include <optional>
 #include <saltedhasher.h>
 #include <unordered_map>
@@ -96,10 +97,12 @@ class CMNHFManager : public AbstractEHFManager
 private:
     CEvoDB& m_evoDb;
 
-    static constexpr size_t MNHFCacheSize = 1000;
+    // Signals rarely change, blocks with the same signals as their parent share its copy so entries are about the size
+    // of a pointer and a hash: the cache covers a few weeks of blocks in about a MB
+    static constexpr size_t MNHFCacheSize = 10000;
     Mutex cs_cache;
     // versionBit <-> height
-    unordered_lru_cache<uint256, Signals, StaticSaltedHasher> mnhfCache GUARDED_BY(cs_cache) {MNHFCacheSize};
+    unordered_lru_cache<uint256, std::shared_ptr<const Signals>, StaticSaltedHasher> mnhfCache GUARDED_BY(cs_cache) {MNHFCacheSize};
 
     // This cache is used only for v20 activation to avoid double lock through VersionBitsConditionChecker::SignalHeight
     VersionBitsCache v20_activation GUARDED_BY(cs_cache);
@@ -131,6 +134,13 @@ public:
     void AddSignal(const CBlockIndex* const pindex, int bit) LOCKS_EXCLUDED(cs_cache);
 private:
     void AddToCache(const Signals& signals, const CBlockIndex* const pindex);
+    void InsertToCache(const Signals& signals, const CBlockIndex* const pindex) LOCKS_EXCLUDED(cs_cache);
+
+    /**
+     * Recompute and store the signals of a block which was already fully validated when it was connected, by only
+     * extracting the bits it signals instead of verifying its MNHF transactions again like ProcessBlock does.
+     */
+    Signals ReplayBlock(const CBlock& block, const CBlockIndex* const pindex);
 
     /**
      * This function returns list of signals available on previous block.
@@ -21,12 +21,19 @@
 #include <base58.h>
 #include <chainparams.h>
 #include <consensus/merkle.h>
+#include <hash.h>
+#include <unordered_lru_cache.h>
 #include <univalue.h>
 #include <validation.h>
 #include <key_io.h>
 #include <util/underlying.h>
 #include <util/enumerate.h>
 
+#include <algorithm>
+#include <limits>
+#include <numeric>
+#include <set>
+
 CSimplifiedMNListEntry::CSimplifiedMNListEntry(const CDeterministicMN& dmn) :
     proRegTxHash(dmn.proTxHash),
     confirmedHash(dmn.pdmnState->confirmedHash),
@@ -96,6 +103,42 @@ UniValue CSimplifiedMNListEntry::ToJson(bool extended) const
     return obj;
 }
 
+namespace {
+struct StatePtrHasher
+{
+    size_t operator()(const CDeterministicMNState* p) const
+    {
+        // spread the pointer bits over the whole word, the cache picks its shard from the high ones
+        return size_t(uint64_t(reinterpret_cast<uintptr_t>(p)) * 0x9E3779B97F4A7C15ULL);
+    }
+};
+
+// Enough for the states of a few thousand masternodes in the lists of the last few hundred blocks
+static constexpr size_t SML_ENTRY_CACHE_SIZE{32768};
+using SMLEntryCache = sharded_unordered_lru_cache<const CDeterministicMNState*, std::shared_ptr<const CCachedSimplifiedMNListEntry>, StatePtrHasher, SML_ENTRY_CACHE_SIZE>;
+
+SMLEntryCache& GetSMLEntryCache()
+{
+    // constructed on first use, registering its stats needs the globals of unordered_lru_cache.h
+    static SMLEntryCache cache{"evo.smlEntries"};
+    return cache;
+}
+} // namespace
+
+std::shared_ptr<const CCachedSimplifiedMNListEntry> GetSimplifiedMNListEntry(const CDeterministicMN& dmn)
+{
+    std::shared_ptr<const CCachedSimplifiedMNListEntry> cached;
+    if (GetSMLEntryCache().get(dmn.pdmnState.get(), cached) &&
+        cached->entry.proRegTxHash == dmn.proTxHash && cached->entry.nType == dmn.nType) {
+        return cached;
+    }
+    CSimplifiedMNListEntry entry(dmn);
+    const uint256 hash = entry.CalcHash();
+    cached = std::make_shared<const CCachedSimplifiedMNListEntry>(CCachedSimplifiedMNListEntry{dmn.pdmnState, std::move(entry), hash});
+    GetSMLEntryCache().insert(dmn.pdmnState.get(), cached);
+    return cached;
+}
+
 CSimplifiedMNList::CSimplifiedMNList(const std::vector<CSimplifiedMNListEntry>& smlEntries)
 {
     mnList.reserve(smlEntries.size());
@@ -112,7 +155,7 @@ CSimplifiedMNList::CSimplifiedMNList(const CDeterministicMNList& dmnList)
 {
     mnList.reserve(dmnList.GetAllMNsCount());
     dmnList.ForEachMN(false, [this](auto& dmn) {
-        mnList.emplace_back(std::make_unique<CSimplifiedMNListEntry>(dmn));
+        mnList.emplace_back(std::make_unique<CSimplifiedMNListEntry>(GetSimplifiedMNListEntry(dmn)->entry));
     });
 
     std::sort(mnList.begin(), mnList.end(), [&](const std::unique_ptr<CSimplifiedMNListEntry>& a, const std::unique_ptr<CSimplifiedMNListEntry>& b) {
@@ -130,6 +173,156 @@ uint256 CSimplifiedMNList::CalcMerkleRoot(bool* pmutated) const
     return ComputeMerkleRoot(leaves, pmutated);
 }
 
+uint256 CSimplifiedMNListMerkleTree::Update(const CDeterministicMNList& newList, bool* pmutated)
+{
+    const auto diff = dmnList.BuildDiff(newList);
+
+    std::vector<uint256> removed;
+    std::map<uint256, uint256> upserted;
+    removed.reserve(diff.removedMns.size());
+    for (const auto& id : diff.removedMns) {
+        auto dmn = dmnList.GetMNByInternalId(id);
+        if (!dmn) {
+            throw std::runtime_error(strprintf("%s: can't find a removed masternode, id=%d", __func__, id));
+        }
+        removed.emplace_back(dmn->proTxHash);
+    }
+    for (const auto& dmn : diff.addedMNs) {
+        upserted.emplace(dmn->proTxHash, GetSimplifiedMNListEntry(*dmn)->hash);
+    }
+    for (const auto& p : diff.updatedMNs) {
+        auto dmn = newList.GetMNByInternalId(p.first);
+        if (!dmn) {
+            throw std::runtime_error(strprintf("%s: can't find an updated masternode, id=%d", __func__, p.first));
+        }
+        upserted.emplace(dmn->proTxHash, GetSimplifiedMNListEntry(*dmn)->hash);
+    }
+
+    Apply(removed, upserted);
+    dmnList = newList;
+
+    return GetMerkleRoot(pmutated);
+}
+
+void CSimplifiedMNListMerkleTree::Apply(const std::vector<uint256>& removed, const std::map<uint256, uint256>& upserted)
+{
+    const std::set<uint256> removedSet(removed.begin(), removed.end());
+    const size_t oldSize = keys.size();
+
+    // leaves which keep their key only need a new hash and stay at their position
+    std::vector<size_t> dirty;
+    std::vector<std::pair<uint256, uint256>> inserted;
+    for (const auto& [key, hash] : upserted) {
+        auto it = std::lower_bound(keys.begin(), keys.end(), key);
+        if (it != keys.end() && *it == key && removedSet.count(key) == 0) {
+            const size_t pos = it - keys.begin();
+            levels[0][pos] = hash;
+            dirty.emplace_back(pos);
+        } else {
+            inserted.emplace_back(key, hash);
+        }
+    }
+    std::sort(dirty.begin(), dirty.end());
+
+    if (!removedSet.empty() || !inserted.empty()) {
+        // all leaves behind the first inserted or removed one move, so these all have to be rehashed
+        std::vector<uint256> newKeys;
+        std::vector<uint256> newLeaves;
+        newKeys.reserve(oldSize + inserted.size());
+        newLeaves.reserve(oldSize + inserted.size());
+        size_t firstChange = std::numeric_limits<size_t>::max();
+        auto ins = inserted.begin();
+        for (size_t i = 0; i <= oldSize; i++) {
+            while (ins != inserted.end() && (i == oldSize || ins->first < keys[i])) {
+                firstChange = std::min(firstChange, newKeys.size());
+                newKeys.emplace_back(ins->first);
+                newLeaves.emplace_back(ins->second);
+                ++ins;
+            }
+            if (i == oldSize) {
+                break;
+            }
+            if (removedSet.count(keys[i])) {
+                firstChange = std::min(firstChange, newKeys.size());
+                continue;
+            }
+            newKeys.emplace_back(keys[i]);
+            newLeaves.emplace_back(levels[0][i]);
+        }
+        keys = std::move(newKeys);
+        levels[0] = std::move(newLeaves);
+
+        dirty.erase(std::lower_bound(dirty.begin(), dirty.end(), firstChange), dirty.end());
+        for (size_t i = firstChange; i < keys.size(); i++) {
+            dirty.emplace_back(i);
+        }
+    }
+
+    size_t level = 0;
+    size_t oldLevelSize = oldSize;
+    for (; levels[level].size() > 1; level++) {
+        if (levels.size() == level + 1) {
+            levels.emplace_back();
+            equalChildren.emplace_back();
+        }
+        const auto& children = levels[level];
+        auto& parents = levels[level + 1];
+        auto& equal = equalChildren[level];
+
+        const size_t parentSize = (children.size() + 1) / 2;
+        const size_t oldParentSize = parents.size();
+        for (size_t i = parentSize; i < oldParentSize; i++) {
+            nEqualChildren -= equal[i];
+        }
+        parents.resize(parentSize);
+        equal.resize(parentSize, false);
+
+        std::vector<size_t> parentDirty;
+        parentDirty.reserve(dirty.size() / 2 + 1);
+        for (const auto i : dirty) {
+            if (parentDirty.empty() || parentDirty.back() != i / 2) {
+                parentDirty.emplace_back(i / 2);
+            }
+        }
+        // the last parent might have lost or gained its second child
+        if (children.size() != oldLevelSize && (parentDirty.empty() || parentDirty.back() != parentSize - 1)) {
+            parentDirty.emplace_back(parentSize - 1);
+        }
+
+        ComputeMerkleParents(children, parentDirty, parents);
+        for (const auto i : parentDirty) {
+            const bool isEqual = 2 * i + 1 < children.size() && children[2 * i] == children[2 * i + 1];
+            if (isEqual != equal[i]) {
+                isEqual ? nEqualChildren++ : nEqualChildren--;
+                equal[i] = isEqual;
+            }
+        }
+
+        dirty = std::move(parentDirty);
+        oldLevelSize = oldParentSize;
+    }
+
+    // the tree might have become lower
+    for (size_t i = level; i < equalChildren.size(); i++) {
+        for (const bool isEqual : equalChildren[i]) {
+            nEqualChildren -= isEqual;
+        }
+    }
+    levels.resize(level + 1);
+    equalChildren.resize(level);
+}
+
+uint256 CSimplifiedMNListMerkleTree::GetMerkleRoot(bool* pmutated) const
+{
+    if (pmutated) {
+        *pmutated = nEqualChildren != 0;
+    }
+    if (keys.empty()) {
+        return uint256();
+    }
+    return levels.back()[0];
+}
+
 bool CSimplifiedMNList::operator==(const CSimplifiedMNList& rhs) const
 {
     return mnList.size() == rhs.mnList.size() &&
@@ -295,14 +488,14 @@ CSimplifiedMNListDiff BuildSimplifiedDiff(const CDeterministicMNList& from, cons
     to.ForEachMN(false, [&](const auto& toPtr) {
         auto fromPtr = from.GetMN(toPtr.proTxHash);
         if (fromPtr == nullptr) {
-            CSimplifiedMNListEntry sme(toPtr);
-            diffRet.mnList.push_back(std::move(sme));
-        } else {
-            CSimplifiedMNListEntry sme1(toPtr);
-            CSimplifiedMNListEntry sme2(*fromPtr);
-            if ((sme1 != sme2) ||
-                (extended && (sme1.scriptPayout != sme2.scriptPayout || sme1.scriptOperatorPayout != sme2.scriptOperatorPayout))) {
-                    diffRet.mnList.push_back(std::move(sme1));
+            diffRet.mnList.push_back(GetSimplifiedMNListEntry(toPtr)->entry);
+        } else if (fromPtr->pdmnState != toPtr.pdmnState || fromPtr->nType != toPtr.nType) {
+            // an unchanged state can't give a different entry
+            const auto sme1 = GetSimplifiedMNListEntry(toPtr);
+            const auto sme2 = GetSimplifiedMNListEntry(*fromPtr);
+            if ((sme1->entry != sme2->entry) ||
+                (extended && (sme1->entry.scriptPayout != sme2->entry.scriptPayout || sme1->entry.scriptOperatorPayout != sme2->entry.scriptOperatorPayout))) {
+                    diffRet.mnList.push_back(sme1->entry);
             }
         }
     });
@@ -384,3 +577,110 @@ bool BuildSimplifiedMNListDiff(const uint256& baseBlockHash, const uint256& bloc
 
     return true;
 }
+
+CSimplifiedMNListDiffCache::DiffPtr CSimplifiedMNListDiffCache::Lookup(const uint256& baseBlockHash, const uint256& blockHash)
+{
+    AssertLockHeld(cs);
+    auto it = entriesByKey.find({baseBlockHash, blockHash});
+    if (it == entriesByKey.end()) {
+        return nullptr;
+    }
+    entries.splice(entries.begin(), entries, it->second);
+    return it->second->diff;
+}
+
+void CSimplifiedMNListDiffCache::Insert(const uint256& baseBlockHash, const uint256& blockHash, DiffPtr diff)
+{
+    AssertLockHeld(cs);
+    if (entriesByKey.count({baseBlockHash, blockHash})) {
+        return;
+    }
+    // Rough in-memory footprint, dominated by the masternode entries and quorum commitments
+    const size_t size = sizeof(Entry) + sizeof(CSimplifiedMNListDiff) + diff->cbTx->GetTotalSize() +
+                        diff->mnList.size() * sizeof(CSimplifiedMNListEntry) +
+                        diff->deletedMNs.size() * sizeof(uint256) +
+                        diff->deletedQuorums.size() * sizeof(std::pair<uint8_t, uint256>) +
+                        std::accumulate(diff->newQuorums.begin(), diff->newQuorums.end(), size_t{0}, [](size_t sum, const auto& qc) {
+                            return sum + sizeof(qc) + (qc.signers.size() + qc.validMembers.size()) / 8;
+                        });
+    entries.push_front({baseBlockHash, blockHash, std::move(diff), size});
+    entriesByKey.emplace(std::make_pair(baseBlockHash, blockHash), entries.begin());
+    cacheBytes += size;
+    // Keep at least the new entry, even a single oversized diff is worth not building twice
+    while (cacheBytes > MAX_CACHE_BYTES && entries.size() > 1) {
+        const Entry& last = entries.back();
+        cacheBytes -= last.size;
+        entriesByKey.erase({last.baseBlockHash, last.blockHash});
+        entries.pop_back();
+    }
+}
+
+CSimplifiedMNListDiffCache::DiffPtr CSimplifiedMNListDiffCache::Get(const uint256& baseBlockHash, const uint256& blockHash,
+                                                                    const llmq::CQuorumBlockProcessor& quorum_block_processor,
+                                                                    std::string& errorRet)
+{
+    AssertLockHeld(cs_main);
+
+    const CBlockIndex* baseBlockIndex = baseBlockHash.IsNull() ? ::ChainActive().Genesis() : g_chainman.m_blockman.LookupBlockIndex(baseBlockHash);
+    const CBlockIndex* blockIndex = g_chainman.m_blockman.LookupBlockIndex(blockHash);
+    const bool inChain = baseBlockIndex && blockIndex && ::ChainActive().Contains(baseBlockIndex) && ::ChainActive().Contains(blockIndex);
+    {
+        LOCK(cs);
+        if (inChain) {
+            if (baseRequests.size() < MAX_TRACKED_BASES) {
+                baseRequests[baseBlockHash]++;
+            } else if (auto it = baseRequests.find(baseBlockHash); it != baseRequests.end()) {
+                it->second++;
+            }
+            if (auto diff = Lookup(baseBlockHash, blockHash)) {
+                return diff;
+            }
+        }
+    }
+
+    // Not cached or failing, let BuildSimplifiedMNListDiff do all checks and report the error
+    auto diff = std::make_shared<CSimplifiedMNListDiff>();
+    if (!BuildSimplifiedMNListDiff(baseBlockHash, blockHash, *diff, quorum_block_processor, errorRet)) {
+        return nullptr;
+    }
+    LOCK(cs);
+    Insert(baseBlockHash, blockHash, diff);
+    return diff;
+}
+
+void CSimplifiedMNListDiffCache::UpdatedBlockTip(const CBlockIndex* pindexNew, const llmq::CQuorumBlockProcessor& quorum_block_processor)
+{
+    std::vector<std::pair<uint32_t, uint256>> bases;
+    {
+        LOCK(cs);
+        for (const auto& [baseBlockHash, count] : baseRequests) {
+            // a single request is likely a client catching up from its own last block
+            if (count > 1) bases.emplace_back(count, baseBlockHash);
+        }
+        baseRequests.clear();
+    }
+    if (bases.empty()) {
+        return;
+    }
+    std::sort(bases.begin(), bases.end(), std::greater<>());
+    bases.resize(std::min(bases.size(), PRECOMPUTED_BASES));
+
+    LOCK(cs_main);
+    if (::ChainActive().Tip() != pindexNew) {
+        // another tip is already on its way
+        return;
+    }
+    for (const auto& [count, baseBlockHash] : bases) {
+        if (WITH_LOCK(cs, return Lookup(baseBlockHash, pindexNew->GetBlockHash())) != nullptr) {
+            continue;
+        }
+        auto diff = std::make_shared<CSimplifiedMNListDiff>();
+        std::string strError;
+        if (!BuildSimplifiedMNListDiff(baseBlockHash, pindexNew->GetBlockHash(), *diff, quorum_block_processor, strError)) {
+            // e.g. the base got reorged out
+            continue;
+        }
+        LOCK(cs);
+        Insert(baseBlockHash, pindexNew->GetBlockHash(), diff);
+    }
+}
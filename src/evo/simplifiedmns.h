@@ -11,12 +11,20 @@
 #include <merkleblock.h>
 #include <netaddress.h>
 #include <pubkey.h>
+#include <sync.h>
+
+#include <list>
+#include <map>
+#include <memory>
+#include <vector>
 
 class UniValue;
 class CBlockIndex;
 class CDeterministicMNList;
 class CDeterministicMN;
 
+extern RecursiveMutex cs_main;
+
 namespace llmq {
 class CFinalCommitment;
 class CQuorumBlockProcessor;
@@ -95,6 +103,22 @@ public:
     [[nodiscard]] UniValue ToJson(bool extended = false) const;
 };
 
+/** An SML entry built from a masternode and its hash */
+struct CCachedSimplifiedMNListEntry
+{
+    // the state the entry was built from, holding it keeps its address from being reused by another state
+    std::shared_ptr<const CDeterministicMNState> pdmnState;
+    CSimplifiedMNListEntry entry;
+    uint256 hash;
+};
+
+/**
+ * The SML entry of a masternode and its hash. Masternode states are immutable and shared by all lists until the
+ * masternode is updated, so entries are cached by state: every list containing the same state gets the same entry
+ * and only masternodes changed since the entry was built are converted and hashed again.
+ */
+std::shared_ptr<const CCachedSimplifiedMNListEntry> GetSimplifiedMNListEntry(const CDeterministicMN& dmn);
+
 class CSimplifiedMNList
 {
 public:
@@ -110,6 +134,35 @@ public:
     bool operator==(const CSimplifiedMNList& rhs) const;
 };
 
+/**
+ * Merkle tree over the SML entry hashes of a deterministic MN list, sorted by proRegTxHash. The root (and mutation
+ * flag) is the same as CSimplifiedMNList::CalcMerkleRoot would give for that list, but updating the tree only hashes
+ * the entries which changed according to CDeterministicMNList::BuildDiff and the inner nodes depending on them.
+ */
+class CSimplifiedMNListMerkleTree
+{
+private:
+    // the list the tree currently represents
+    CDeterministicMNList dmnList;
+    // proRegTxHashes of the leaves, sorted
+    std::vector<uint256> keys;
+    // levels[0] holds the leaf hashes, levels.back() the root
+    std::vector<std::vector<uint256>> levels{1};
+    // equalChildren[i][j] is true if both children of levels[i + 1][j] are equal (see ComputeMerkleRoot)
+    std::vector<std::vector<bool>> equalChildren;
+    size_t nEqualChildren{0};
+
+public:
+    // Updates the tree to represent newList and returns the new merkle root
+    uint256 Update(const CDeterministicMNList& newList, bool* pmutated = nullptr);
+
+    // Removes the leaves keyed by removed, then inserts or replaces the leaves in upserted (key -> leaf hash)
+    void Apply(const std::vector<uint256>& removed, const std::map<uint256, uint256>& upserted);
+
+    uint256 GetMerkleRoot(bool* pmutated = nullptr) const;
+    size_t size() const { return keys.size(); }
+};
+
 /// P2P messages
 
 class CGetSimplifiedMNListDiff
@@ -173,4 +226,51 @@ public:
 bool BuildSimplifiedMNListDiff(const uint256& baseBlockHash, const uint256& blockHash, CSimplifiedMNListDiff& mnListDiffRet,
                                const llmq::CQuorumBlockProcessor& quorum_block_processor, std::string& errorRet, bool extended = false);
 
+/**
+ * LRU of the diffs served in MNLISTDIFF messages. The diff between two blocks never changes, so an entry only
+ * has to pass the chain checks of BuildSimplifiedMNListDiff again to be reused.
+ * Light clients ask for diffs to the tip from a few common bases (e.g. genesis or their last sync), so bases
+ * requested repeatedly between two tips get their diff to the new tip built right when the tip changes.
+ */
+class CSimplifiedMNListDiffCache
+{
+public:
+    using DiffPtr = std::shared_ptr<const CSimplifiedMNListDiff>;
+
+private:
+    //! Budget for the cached diffs, a diff from genesis is a few MB on mainnet
+    static constexpr size_t MAX_CACHE_BYTES{32 * 1024 * 1024};
+    //! Number of distinct bases counted between two tips
+    static constexpr size_t MAX_TRACKED_BASES{1024};
+    //! Number of most requested bases to build the diff to a new tip for
+    static constexpr size_t PRECOMPUTED_BASES{4};
+
+    struct Entry {
+        uint256 baseBlockHash;
+        uint256 blockHash;
+        DiffPtr diff;
+        size_t size;
+    };
+
+    mutable Mutex cs;
+    //! Most recently used first
+    std::list<Entry> entries GUARDED_BY(cs);
+    std::map<std::pair<uint256, uint256>, std::list<Entry>::iterator> entriesByKey GUARDED_BY(cs);
+    size_t cacheBytes GUARDED_BY(cs){0};
+    //! Requests per base since the last tip
+    std::map<uint256, uint32_t> baseRequests GUARDED_BY(cs);
+
+    DiffPtr Lookup(const uint256& baseBlockHash, const uint256& blockHash) EXCLUSIVE_LOCKS_REQUIRED(cs);
+    void Insert(const uint256& baseBlockHash, const uint256& blockHash, DiffPtr diff) EXCLUSIVE_LOCKS_REQUIRED(cs);
+
+public:
+    /** The diff for a GETMNLISTDIFF request, or nullptr with errorRet set like BuildSimplifiedMNListDiff does */
+    DiffPtr Get(const uint256& baseBlockHash, const uint256& blockHash, const llmq::CQuorumBlockProcessor& quorum_block_processor,
+                std::string& errorRet) EXCLUSIVE_LOCKS_REQUIRED(cs_main, !cs);
+
+    /** Build the diffs from the most requested bases to the new tip */
+    void UpdatedBlockTip(const CBlockIndex* pindexNew, const llmq::CQuorumBlockProcessor& quorum_block_processor)
+        LOCKS_EXCLUDED(cs_main) EXCLUSIVE_LOCKS_REQUIRED(!cs);
+};
+
 #endif // BITCOIN_EVO_SIMPLIFIEDMNS_H
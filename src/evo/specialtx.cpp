@@ -5,6 +5,7 @@
 #include <evo/specialtx.h>
 
 #include <clientversion.h>
+#include <consensus/validation.h>
 #include <hash.h>
 
 uint256 CalcTxInputsHash(const CTransaction& tx)
@@ -15,3 +16,15 @@ uint256 CalcTxInputsHash(const CTransaction& tx)
     }
     return hw.GetHash();
 }
+
+bool RunOrDeferSigCheck(std::function<bool()> check, const std::string& reject_reason, std::vector<CSpecialTxSigCheck>* pvChecks, TxValidationState& state)
+{
+    if (pvChecks) {
+        pvChecks->emplace_back(std::move(check), reject_reason);
+        return true;
+    }
+    if (!check()) {
+        return state.Invalid(TxValidationResult::TX_CONSENSUS, reject_reason);
+    }
+    return true;
+}
@@ -11,10 +11,15 @@
 #include <uint256.h>
 #include <version.h>
 
+#include <functional>
+#include <memory>
+#include <string>
 #include <string_view>
 #include <optional>
 #include <vector>
 
+class TxValidationState;
+
 template <typename T>
 std::optional<T> GetTxPayload(const std::vector<unsigned char>& payload)
 {
@@ -35,6 +40,30 @@ std::optional<T> GetTxPayload(const TxType& tx, bool assert_type = true)
     return GetTxPayload<T>(tx.vExtraPayload);
 }
 
+template <typename T>
+struct CachedTxPayloadOf final : public CachedTxPayload
+{
+    explicit CachedTxPayloadOf(std::optional<T> _payload) : payload(std::move(_payload)) {}
+    const std::optional<T> payload;
+};
+
+/** Immutable transactions parse their payload only once and keep the result */
+template <typename T>
+std::optional<T> GetTxPayload(const CTransaction& tx, bool assert_type = true)
+{
+    if (assert_type) { ASSERT_IF_DEBUG(tx.nType == T::SPECIALTX_TYPE); }
+    if (tx.nType != T::SPECIALTX_TYPE) return std::nullopt;
+    const CachedTxPayload* cached = tx.GetCachedPayload();
+    if (cached == nullptr) {
+        cached = tx.SetCachedPayload(std::make_unique<const CachedTxPayloadOf<T>>(GetTxPayload<T>(tx.vExtraPayload)));
+    }
+    if (const auto* typed = dynamic_cast<const CachedTxPayloadOf<T>*>(cached)) {
+        return typed->payload;
+    }
+    // Another payload type of the same tx type was cached first
+    return GetTxPayload<T>(tx.vExtraPayload);
+}
+
 template <typename T>
 void SetTxPayload(CMutableTransaction& tx, const T& payload)
 {
@@ -45,4 +74,36 @@ void SetTxPayload(CMutableTransaction& tx, const T& payload)
 
 uint256 CalcTxInputsHash(const CTransaction& tx);
 
+/**
+ * A signature check of a special transaction payload. These only depend on data which was gathered while checking the
+ * payload, so during block validation they are deferred and run on the script check threads (see CCheckQueue).
+ */
+class CSpecialTxSigCheck
+{
+private:
+    std::function<bool()> m_check;
+    std::string m_reject_reason;
+
+public:
+    CSpecialTxSigCheck() = default;
+    CSpecialTxSigCheck(std::function<bool()> check, std::string reject_reason) :
+        m_check(std::move(check)), m_reject_reason(std::move(reject_reason)) {}
+
+    bool operator()() const { return m_check(); }
+
+    void swap(CSpecialTxSigCheck& check) noexcept
+    {
+        std::swap(m_check, check.m_check);
+        std::swap(m_reject_reason, check.m_reject_reason);
+    }
+
+    const std::string& GetRejectReason() const { return m_reject_reason; }
+};
+
+/**
+ * Runs check, or appends it to pvChecks instead if that is not null. If the check is run and fails, state is marked
+ * invalid with reject_reason.
+ */
+bool RunOrDeferSigCheck(std::function<bool()> check, const std::string& reject_reason, std::vector<CSpecialTxSigCheck>* pvChecks, TxValidationState& state);
+
 #endif // BITCOIN_EVO_SPECIALTX_H
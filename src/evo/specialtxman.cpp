@@ -5,6 +5,7 @@
 #include <evo/specialtxman.h>
 
 #include <chainparams.h>
+#include <checkqueue.h>
 #include <consensus/validation.h>
 #include <deploymentstatus.h>
 #include <evo/cbtx.h>
@@ -13,13 +14,29 @@
 #include <evo/mnhftx.h>
 #include <evo/providertx.h>
 #include <evo/assetlocktx.h>
+#include <evo/specialtx.h>
 #include <hash.h>
 #include <llmq/blockprocessor.h>
 #include <llmq/commitment.h>
 #include <primitives/block.h>
+#include <util/irange.h>
 #include <validation.h>
 
-static bool CheckSpecialTxInner(const CTransaction& tx, const CBlockIndex* pindexPrev, const CCoinsViewCache& view, const std::optional<CRangesSet>& indexes, bool check_sigs, TxValidationState& state)
+// Signature checks are expensive compared to the queue overhead, so these are handed out one by one
+static CCheckQueue<CSpecialTxSigCheck> specialtxcheckqueue(1);
+
+void StartSpecialTxCheckWorkerThreads(int threads_num)
+{
+    specialtxcheckqueue.StartWorkerThreads(threads_num, "spectxch");
+}
+
+void StopSpecialTxCheckWorkerThreads()
+{
+    specialtxcheckqueue.StopWorkerThreads();
+}
+
+static bool CheckSpecialTxInner(const CTransaction& tx, const CBlockIndex* pindexPrev, const CCoinsViewCache& view, const std::optional<CRangesSet>& indexes, bool check_sigs, TxValidationState& state,
+                                std::vector<CSpecialTxSigCheck>* pvChecks = nullptr)
 {
     AssertLockHeld(cs_main);
 
@@ -34,13 +51,13 @@ static bool CheckSpecialTxInner(const CTransaction& tx, const CBlockIndex* pinde
     try {
         switch (tx.nType) {
         case TRANSACTION_PROVIDER_REGISTER:
-            return CheckProRegTx(tx, pindexPrev, state, view, check_sigs);
+            return CheckProRegTx(tx, pindexPrev, state, view, check_sigs, pvChecks);
         case TRANSACTION_PROVIDER_UPDATE_SERVICE:
-            return CheckProUpServTx(tx, pindexPrev, state, check_sigs);
+            return CheckProUpServTx(tx, pindexPrev, state, check_sigs, pvChecks);
         case TRANSACTION_PROVIDER_UPDATE_REGISTRAR:
-            return CheckProUpRegTx(tx, pindexPrev, state, view, check_sigs);
+            return CheckProUpRegTx(tx, pindexPrev, state, view, check_sigs, pvChecks);
         case TRANSACTION_PROVIDER_UPDATE_REVOKE:
-            return CheckProUpRevTx(tx, pindexPrev, state, check_sigs);
+            return CheckProUpRevTx(tx, pindexPrev, state, check_sigs, pvChecks);
         case TRANSACTION_COINBASE:
             return CheckCbTx(tx, pindexPrev, state);
         case TRANSACTION_QUORUM_COMMITMENT:
@@ -54,7 +71,7 @@ static bool CheckSpecialTxInner(const CTransaction& tx, const CBlockIndex* pinde
             if (!DeploymentActiveAfter(pindexPrev, consensusParams, Consensus::DEPLOYMENT_V20)) {
                 return state.Invalid(TxValidationResult::TX_CONSENSUS, "assetlocks-before-v20");
             }
-            return CheckAssetLockUnlockTx(tx, pindexPrev, indexes, state);
+            return CheckAssetLockUnlockTx(tx, pindexPrev, indexes, state, pvChecks);
         case TRANSACTION_ASSET_UNLOCK:
             if (Params().NetworkIDString() == CBaseChainParams::REGTEST && !DeploymentActiveAfter(pindexPrev, consensusParams, Consensus::DEPLOYMENT_V20)) {
                 // TODO:  adjust functional tests to make it activated by MN_RR on regtest too
@@ -63,7 +80,7 @@ static bool CheckSpecialTxInner(const CTransaction& tx, const CBlockIndex* pinde
             if (Params().NetworkIDString() != CBaseChainParams::REGTEST && !DeploymentActiveAfter(pindexPrev, consensusParams, Consensus::DEPLOYMENT_MN_RR)) {
                 return state.Invalid(TxValidationResult::TX_CONSENSUS, "assetunlocks-before-mn_rr");
             }
-            return CheckAssetLockUnlockTx(tx, pindexPrev, indexes, state);
+            return CheckAssetLockUnlockTx(tx, pindexPrev, indexes, state, pvChecks);
         }
     } catch (const std::exception& e) {
         LogPrintf("%s -- failed: %s\n", __func__, e.what());
@@ -76,7 +93,17 @@ static bool CheckSpecialTxInner(const CTransaction& tx, const CBlockIndex* pinde
 bool CheckSpecialTx(const CTransaction& tx, const CBlockIndex* pindexPrev, const CCoinsViewCache& view, bool check_sigs, TxValidationState& state)
 {
     AssertLockHeld(cs_main);
-    return CheckSpecialTxInner(tx, pindexPrev, view, std::nullopt, check_sigs, state);
+    std::optional<CRangesSet> indexes;
+    if (tx.nVersion == 3 && tx.nType == TRANSACTION_ASSET_UNLOCK && creditPoolManager) {
+        // Every connected block keeps a snapshot of its credit pool, so this is a lookup rather than a walk back
+        try {
+            indexes = creditPoolManager->GetCreditPool(pindexPrev, Params().GetConsensus()).indexes;
+        } catch (const std::exception& e) {
+            LogPrintf("%s -- failed: %s\n", __func__, e.what());
+            return state.Invalid(TxValidationResult::TX_CONSENSUS, "failed-check-special-tx");
+        }
+    }
+    return CheckSpecialTxInner(tx, pindexPrev, view, indexes, check_sigs, state);
 }
 
 static bool ProcessSpecialTx(const CTransaction& tx, const CBlockIndex* pindex, TxValidationState& state)
@@ -153,11 +180,20 @@ bool ProcessSpecialTxsInBlock(const CBlock& block, const CBlockIndex* pindex, CM
             LogPrint(BCLog::CREDITPOOL, "%s: CCreditPool is %s\n", __func__, creditPool.ToString());
         }
 
-        for (const auto& ptr_tx : block.vtx) {
+        // The payload signatures only depend on the state before this block, so they are verified on the script check
+        // threads while the payloads are checked and processed here. sigChecks keeps a copy of every deferred check and
+        // the index of its transaction, to find the failing one if the batch fails
+        const bool fParallelSigChecks = fCheckCbTxMerleRoots && g_parallel_script_checks;
+        CCheckQueueControl<CSpecialTxSigCheck> control(fParallelSigChecks ? &specialtxcheckqueue : nullptr);
+        std::vector<std::pair<size_t, CSpecialTxSigCheck>> sigChecks;
+
+        for (const auto i : irange::range(block.vtx.size())) {
+            const auto& ptr_tx = block.vtx[i];
             TxValidationState tx_state;
+            std::vector<CSpecialTxSigCheck> vChecks;
             // At this moment CheckSpecialTx() and ProcessSpecialTx() may fail by 2 possible ways:
             // consensus failures and "TX_BAD_SPECIAL"
-            if (!CheckSpecialTxInner(*ptr_tx, pindex->pprev, view, creditPool.indexes, fCheckCbTxMerleRoots, tx_state)) {
+            if (!CheckSpecialTxInner(*ptr_tx, pindex->pprev, view, creditPool.indexes, fCheckCbTxMerleRoots, tx_state, fParallelSigChecks ? &vChecks : nullptr)) {
                 assert(tx_state.GetResult() == TxValidationResult::TX_CONSENSUS || tx_state.GetResult() == TxValidationResult::TX_BAD_SPECIAL);
                 return state.Invalid(BlockValidationResult::BLOCK_CONSENSUS, tx_state.GetRejectReason(),
                                  strprintf("Special Transaction check failed (tx hash %s) %s", ptr_tx->GetHash().ToString(), tx_state.GetDebugMessage()));
@@ -167,6 +203,21 @@ bool ProcessSpecialTxsInBlock(const CBlock& block, const CBlockIndex* pindex, CM
                 return state.Invalid(BlockValidationResult::BLOCK_CONSENSUS, tx_state.GetRejectReason(),
                                  strprintf("Process Special Transaction failed (tx hash %s) %s", ptr_tx->GetHash().ToString(), tx_state.GetDebugMessage()));
             }
+            for (const auto& check : vChecks) {
+                sigChecks.emplace_back(i, check);
+            }
+            control.Add(vChecks);
+        }
+
+        if (!control.Wait()) {
+            for (const auto& [i, check] : sigChecks) {
+                if (!check()) {
+                    return state.Invalid(BlockValidationResult::BLOCK_CONSENSUS, check.GetRejectReason(),
+                                     strprintf("Special Transaction check failed (tx hash %s)", block.vtx[i]->GetHash().ToString()));
+                }
+            }
+            // the checks are deterministic, so one of them must have failed again
+            assert(false);
         }
 
         int64_t nTime2 = GetTimeMicros();
@@ -253,6 +304,8 @@ bool UndoSpecialTxsInBlock(const CBlock& block, const CBlockIndex* pindex, CMNHF
             }
         }
 
+        creditPoolManager->UndoBlock(pindex);
+
         if (!mnhfManager.UndoBlock(block, pindex)) {
             return false;
         }
@@ -300,6 +353,8 @@ bool CheckCreditPoolDiffForBlock(const CBlock& block, const CBlockIndex* pindex,
             return state.Invalid(BlockValidationResult::BLOCK_CONSENSUS, "bad-cbtx-assetlocked-amount");
         }
 
+        creditPoolManager->ProcessBlock(block, pindex, consensusParams);
+
     } catch (const std::exception& e) {
         LogPrintf("%s -- failed: %s\n", __func__, e.what());
         return state.Invalid(BlockValidationResult::BLOCK_CONSENSUS, "failed-checkcreditpooldiff");
@@ -10,12 +10,14 @@
 #include <threadsafety.h>
 
 #include <optional>
+#include <vector>
 
 class BlockValidationState;
 class CBlock;
 class CBlockIndex;
 class CCoinsViewCache;
 class CMNHFManager;
+class CSpecialTxSigCheck;
 class TxValidationState;
 struct MNListUpdates;
 namespace llmq {
@@ -28,6 +30,11 @@ struct Params;
 
 extern RecursiveMutex cs_main;
 
+/** Run the special transaction signature checks of ProcessSpecialTxsInBlock on threads_num threads */
+void StartSpecialTxCheckWorkerThreads(int threads_num);
+/** Stop the special transaction signature check threads */
+void StopSpecialTxCheckWorkerThreads();
+
 bool CheckSpecialTx(const CTransaction& tx, const CBlockIndex* pindexPrev, const CCoinsViewCache& view, bool check_sigs,
                     TxValidationState& state) EXCLUSIVE_LOCKS_REQUIRED(cs_main);
 bool ProcessSpecialTxsInBlock(const CBlock& block, const CBlockIndex* pindex, CMNHFManager& mnhfManager,
@@ -42,86 +42,96 @@ private:
 
         int64_t nStart = GetTimeMillis();
 
-        // serialize, checksum data up to that point, then append checksum
-        CDataStream ssObj(SER_DISK, CLIENT_VERSION);
-        ssObj << strMagicMessage; // specific magic message for this type of object
-        ssObj << Params().MessageStart(); // network specific magic number
-        ssObj << objToSave;
-        uint256 hash = Hash(ssObj);
-        ssObj << hash;
-
-        // open output file, and associate with CAutoFile
-        FILE *file = fopen(pathDB.string().c_str(), "wb");
+        // Serialize straight into a temporary file while hashing it, then append the checksum and move the file
+        // into place. The file format is unchanged, but the object is never held in memory a second time.
+        fs::path pathTmp = pathDB;
+        pathTmp += ".new";
+        FILE *file = fsbridge::fopen(pathTmp, "wb");
         CAutoFile fileout(file, SER_DISK, CLIENT_VERSION);
         if (fileout.IsNull())
-            return error("%s: Failed to open file %s", __func__, pathDB.string());
+            return error("%s: Failed to open file %s", __func__, pathTmp.string());
 
-        // Write and commit header, data
         try {
-            fileout << ssObj;
+            CHashedWriter<CAutoFile> hashwriter(&fileout);
+            hashwriter << strMagicMessage; // specific magic message for this type of object
+            hashwriter << Params().MessageStart(); // network specific magic number
+            hashwriter << objToSave;
+            fileout << hashwriter.GetHash();
         }
         catch (std::exception &e) {
+            fileout.fclose();
+            fs::remove(pathTmp);
             return error("%s: Serialize or I/O error - %s", __func__, e.what());
         }
+        if (!FileCommit(fileout.Get())) {
+            fileout.fclose();
+            fs::remove(pathTmp);
+            return error("%s: Failed to flush file %s", __func__, pathTmp.string());
+        }
         fileout.fclose();
 
+        if (!RenameOver(pathTmp, pathDB)) {
+            fs::remove(pathTmp);
+            return error("%s: Rename-into-place failed", __func__);
+        }
+
         LogPrintf("Written info to %s  %dms\n", strFilename, GetTimeMillis() - nStart);
         LogPrintf("     %s\n", objToSave.ToString());
 
         return true;
     }
 
-    ReadResult CoreRead(T& objToLoad)
+    /** Hash the file in chunks and compare with the stored checksum, to tell corrupted files from format changes */
+    ReadResult CheckFileHash() const
     {
-        //LOCK(objToLoad.cs);
-
-        int64_t nStart = GetTimeMillis();
-        // open input file, and associate with CAutoFile
-        FILE *file = fopen(pathDB.string().c_str(), "rb");
+        FILE *file = fsbridge::fopen(pathDB, "rb");
         CAutoFile filein(file, SER_DISK, CLIENT_VERSION);
-        if (filein.IsNull())
-        {
-            error("%s: Failed to open file %s", __func__, pathDB.string());
+        if (filein.IsNull()) {
             return FileError;
         }
 
-        // use file size to size memory buffer
-        int fileSize = fs::file_size(pathDB);
-        int dataSize = fileSize - sizeof(uint256);
-        // Don't try to resize to a negative number if file is small
-        if (dataSize < 0)
-            dataSize = 0;
-        std::vector<unsigned char> vchData;
-        vchData.resize(dataSize);
-        uint256 hashIn;
+        uint64_t dataSize = fs::file_size(pathDB);
+        if (dataSize < sizeof(uint256)) {
+            return HashReadError;
+        }
+        dataSize -= sizeof(uint256);
 
-        // read data and checksum from file
         try {
-            filein.read(MakeWritableByteSpan(vchData));
+            CHashVerifier<CAutoFile> verifier(&filein);
+            verifier.ignore(dataSize);
+            uint256 hashIn;
             filein >> hashIn;
+            if (hashIn != verifier.GetHash()) {
+                return IncorrectHash;
+            }
         }
         catch (std::exception &e) {
-            error("%s: Deserialize or I/O error - %s", __func__, e.what());
             return HashReadError;
         }
-        filein.fclose();
+        return Ok;
+    }
 
-        CDataStream ssObj(vchData, SER_DISK, CLIENT_VERSION);
+    ReadResult CoreRead(T& objToLoad)
+    {
+        //LOCK(objToLoad.cs);
 
-        // verify stored checksum matches input data
-        uint256 hashTmp = Hash(ssObj);
-        if (hashIn != hashTmp)
+        int64_t nStart = GetTimeMillis();
+        // open input file, and associate with CAutoFile
+        FILE *file = fsbridge::fopen(pathDB, "rb");
+        CAutoFile filein(file, SER_DISK, CLIENT_VERSION);
+        if (filein.IsNull())
         {
-            error("%s: Checksum mismatch, data corrupted", __func__);
-            return IncorrectHash;
+            error("%s: Failed to open file %s", __func__, pathDB.string());
+            return FileError;
         }
 
-
+        // Deserialize straight from the file while hashing what was read, the checksum of all data is stored after it
+        CHashVerifier<CAutoFile> verifier(&filein);
         unsigned char pchMsgTmp[4];
         std::string strMagicMessageTmp;
         try {
             // de-serialize file header (file specific magic message) and ..
-            ssObj >> strMagicMessageTmp;
+            verifier >> strMagicMessageTmp;
 
             // ... verify the message matches predefined one
             if (strMagicMessage != strMagicMessageTmp)
@@ -132,7 +142,7 @@ private:
 
 
             // de-serialize file header (network specific magic number) and ..
-            ssObj >> pchMsgTmp;
+            verifier >> pchMsgTmp;
 
             // ... verify the network matches ours
             if (memcmp(pchMsgTmp, Params().MessageStart(), sizeof(pchMsgTmp)))
@@ -142,14 +152,39 @@ private:
             }
 
             // de-serialize data into T object
-            ssObj >> objToLoad;
+            verifier >> objToLoad;
         }
         catch (std::exception &e) {
             objToLoad.Clear();
             error("%s: Deserialize or I/O error - %s", __func__, e.what());
+            // only a file with a valid checksum has an unexpected format, anything else is corrupted
+            filein.fclose();
+            if (ReadResult hashResult = CheckFileHash(); hashResult != Ok) {
+                if (hashResult == IncorrectHash) error("%s: Checksum mismatch, data corrupted", __func__);
+                return hashResult;
+            }
             return IncorrectFormat;
         }
 
+        // verify stored checksum matches input data
+        uint256 hashIn;
+        try {
+            filein >> hashIn;
+        }
+        catch (std::exception &e) {
+            objToLoad.Clear();
+            error("%s: Deserialize or I/O error - %s", __func__, e.what());
+            return HashReadError;
+        }
+        filein.fclose();
+
+        if (hashIn != verifier.GetHash())
+        {
+            objToLoad.Clear();
+            error("%s: Checksum mismatch, data corrupted", __func__);
+            return IncorrectHash;
+        }
+
         LogPrintf("Loaded info from %s  %dms\n", strFilename, GetTimeMillis() - nStart);
         LogPrintf("     %s\n", objToLoad.ToString());
 
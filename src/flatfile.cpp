@@ -10,6 +10,13 @@
 #include <tinyformat.h>
 #include <util/system.h>
 
+#ifndef WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
 FlatFileSeq::FlatFileSeq(fs::path dir, const char* prefix, size_t chunk_size) :
     m_dir(std::move(dir)),
     m_prefix(prefix),
@@ -52,6 +59,47 @@ FILE* FlatFileSeq::Open(const FlatFilePos& pos, bool read_only)
     return file;
 }
 
+MappedFlatFile::~MappedFlatFile()
+{
+#ifndef WIN32
+    munmap(const_cast<uint8_t*>(m_data), m_size);
+#endif
+}
+
+std::shared_ptr<const MappedFlatFile> MapFile(const fs::path& path)
+{
+#ifndef WIN32
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd == -1) {
+        LogPrintf("Unable to open file %s\n", path.string());
+        return nullptr;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size <= 0) {
+        close(fd);
+        return nullptr;
+    }
+    void* data = mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    // The mapping stays valid once its file descriptor is closed
+    close(fd);
+    if (data == MAP_FAILED) {
+        LogPrintf("Unable to map file %s\n", path.string());
+        return nullptr;
+    }
+    return std::make_shared<const MappedFlatFile>(static_cast<const uint8_t*>(data), st.st_size);
+#else
+    return nullptr;
+#endif
+}
+
+std::shared_ptr<const MappedFlatFile> FlatFileSeq::Map(const FlatFilePos& pos) const
+{
+    if (pos.IsNull()) {
+        return nullptr;
+    }
+    return MapFile(FileName(pos));
+}
+
 size_t FlatFileSeq::Allocate(const FlatFilePos& pos, size_t add_size, bool& out_of_space)
 {
     out_of_space = false;
@@ -6,10 +6,12 @@
 #ifndef BITCOIN_FLATFILE_H
 #define BITCOIN_FLATFILE_H
 
+#include <memory>
 #include <string>
 
 #include <fs.h>
 #include <serialize.h>
+#include <span.h>
 
 struct FlatFilePos
 {
@@ -42,6 +44,29 @@ struct FlatFilePos
     std::string ToString() const;
 };
 
+/** A read-only memory mapping of a whole file, unmapped when destroyed. */
+class MappedFlatFile
+{
+private:
+    const uint8_t* const m_data;
+    const size_t m_size;
+
+public:
+    MappedFlatFile(const uint8_t* data, size_t size) : m_data(data), m_size(size) {}
+    ~MappedFlatFile();
+
+    MappedFlatFile(const MappedFlatFile&) = delete;
+    MappedFlatFile& operator=(const MappedFlatFile&) = delete;
+
+    Span<const uint8_t> Data() const { return {m_data, m_size}; }
+};
+
+/**
+ * Map a whole file into memory, read-only and as large as it is now. Returns nullptr if it can't be mapped,
+ * which is always the case on platforms without mmap.
+ */
+std::shared_ptr<const MappedFlatFile> MapFile(const fs::path& path);
+
 /**
  * FlatFileSeq represents a sequence of numbered files storing raw data. This class facilitates
  * access to and efficient management of these files.
@@ -69,6 +94,13 @@ public:
     /** Open a handle to the file at the given position. */
     FILE* Open(const FlatFilePos& pos, bool read_only = false);
 
+    /**
+     * Map the file at the given position into memory, read-only and as large as it is now. Returns nullptr if it
+     * can't be mapped, which is always the case on platforms without mmap. The file must not be truncated while
+     * it is mapped.
+     */
+    std::shared_ptr<const MappedFlatFile> Map(const FlatFilePos& pos) const;
+
     /**
      * Allocate additional space in a file after the given starting position. The amount allocated
      * will be the minimum multiple of the sequence chunk size greater than add_size.
@@ -8,6 +8,7 @@
 #include <consensus/validation.h>
 #include <core_io.h>
 #include <deploymentstatus.h>
+#include <evo/deterministicmns.h>
 #include <governance/governance.h>
 #include <key_io.h>
 #include <primitives/transaction.h>
@@ -21,6 +22,8 @@
 
 #include <univalue.h>
 
+#include <optional>
+
 // DECLARE GLOBAL VARIABLES FOR GOVERNANCE CLASSES
 CGovernanceTriggerManager triggerman;
 
@@ -240,6 +243,8 @@ bool CSuperblockManager::IsSuperblockTriggered(CGovernanceManager& governanceMan
 
     LogPrint(BCLog::GOBJECT, "CSuperblockManager::IsSuperblockTriggered -- vecTriggers.size() = %d\n", vecTriggers.size());
 
+    std::optional<int> nWeightedMnCount;
+
     for (const auto& pSuperblock : vecTriggers) {
         if (!pSuperblock) {
             LogPrintf("CSuperblockManager::IsSuperblockTriggered -- Non-superblock found, continuing\n");
@@ -266,7 +271,10 @@ bool CSuperblockManager::IsSuperblockTriggered(CGovernanceManager& governanceMan
 
         // MAKE SURE THIS TRIGGER IS ACTIVE VIA FUNDING CACHE FLAG
 
-        pObj->UpdateSentinelVariables();
+        if (!nWeightedMnCount) {
+            nWeightedMnCount = (int)deterministicMNManager->GetListAtChainTip().GetValidWeightedMNsCount();
+        }
+        pObj->UpdateSentinelVariables(*nWeightedMnCount);
 
         if (pObj->IsSetCachedFunding()) {
             LogPrint(BCLog::GOBJECT, "CSuperblockManager::IsSuperblockTriggered -- fCacheFunding = true, returning true\n");
@@ -342,23 +350,23 @@ bool CSuperblockManager::GetSuperblockPayments(CGovernanceManager& governanceMan
     //       Consider at least following limits:
     //          - max coinbase tx size
     //          - max "budget" available
-    for (int i = 0; i < pSuperblock->CountPayments(); i++) {
-        CGovernancePayment payment;
-        if (pSuperblock->GetPayment(i, payment)) {
-            // SET COINBASE OUTPUT TO SUPERBLOCK SETTING
+    const auto& payments = pSuperblock->GetPayments();
+    voutSuperblockRet.reserve(payments.size());
+    for (size_t i = 0; i < payments.size(); i++) {
+        const CGovernancePayment& payment = payments[i];
+
+        // SET COINBASE OUTPUT TO SUPERBLOCK SETTING
 
-            CTxOut txout = CTxOut(payment.nAmount, payment.script);
-            voutSuperblockRet.push_back(txout);
+        voutSuperblockRet.emplace_back(payment.nAmount, payment.script);
 
-            // PRINT NICE LOG OUTPUT FOR SUPERBLOCK PAYMENT
+        // PRINT NICE LOG OUTPUT FOR SUPERBLOCK PAYMENT
 
+        if (LogAcceptCategory(BCLog::GOBJECT)) {
             CTxDestination dest;
             ExtractDestination(payment.script, dest);
 
             LogPrint(BCLog::GOBJECT, "CSuperblockManager::GetSuperblockPayments -- NEW Superblock: output %d (addr %s, amount %d.%08d)\n",
                         i, EncodeDestination(dest), payment.nAmount / COIN, payment.nAmount % COIN);
-        } else {
-            LogPrint(BCLog::GOBJECT, "CSuperblockManager::GetSuperblockPayments -- Payment not found\n");
         }
     }
 
@@ -441,11 +449,14 @@ CSuperblock::
 
 CSuperblock::CSuperblock(int nBlockHeight, std::vector<CGovernancePayment> vecPayments) : nBlockHeight(nBlockHeight), vecPayments(std::move(vecPayments))
 {
+    for (const auto& payment : this->vecPayments) {
+        nPaymentsTotalAmount += payment.nAmount;
+    }
     nStatus = SeenObjectStatus::Valid; //TODO: Investigate this
     nGovObjHash = GetHash();
 }
 
-CGovernanceObject* CSuperblock::GetGovernanceObject(CGovernanceManager& governanceManager)
+CGovernanceObject* CSuperblock::GetGovernanceObject(CGovernanceManager& governanceManager) const
 {
     AssertLockHeld(governanceManager.cs);
     CGovernanceObject* pObj = governanceManager.FindGovernanceObject(nGovObjHash);
@@ -576,8 +587,10 @@ void CSuperblock::ParsePaymentSchedule(const std::string& strPaymentAddresses, c
         CGovernancePayment payment(dest, nAmount, proposalHash);
         if (payment.IsValid()) {
             vecPayments.push_back(payment);
+            nPaymentsTotalAmount += nAmount;
         } else {
             vecPayments.clear();
+            nPaymentsTotalAmount = 0;
             std::ostringstream ostr;
             ostr << "CSuperblock::ParsePaymentSchedule -- Invalid payment found: address = " << EncodeDestination(dest)
                  << ", amount = " << nAmount;
@@ -587,7 +600,7 @@ void CSuperblock::ParsePaymentSchedule(const std::string& strPaymentAddresses, c
     }
 }
 
-bool CSuperblock::GetPayment(int nPaymentIndex, CGovernancePayment& paymentRet)
+bool CSuperblock::GetPayment(int nPaymentIndex, CGovernancePayment& paymentRet) const
 {
     if ((nPaymentIndex < 0) || (nPaymentIndex >= (int)vecPayments.size())) {
         return false;
@@ -597,25 +610,13 @@ bool CSuperblock::GetPayment(int nPaymentIndex, CGovernancePayment& paymentRet)
     return true;
 }
 
-CAmount CSuperblock::GetPaymentsTotalAmount()
-{
-    CAmount nPaymentsTotalAmount = 0;
-    int nPayments = CountPayments();
-
-    for (int i = 0; i < nPayments; i++) {
-        nPaymentsTotalAmount += vecPayments[i].nAmount;
-    }
-
-    return nPaymentsTotalAmount;
-}
-
 /**
 *   Is Transaction Valid
 *
 *   - Does this transaction match the superblock?
 */
 
-bool CSuperblock::IsValid(const CTransaction& txNew, int nBlockHeight, CAmount blockReward)
+bool CSuperblock::IsValid(const CTransaction& txNew, int nBlockHeight, CAmount blockReward) const
 {
     // TODO : LOCK(cs);
     // No reason for a lock here now since this method only accesses data
@@ -662,37 +663,26 @@ bool CSuperblock::IsValid(const CTransaction& txNew, int nBlockHeight, CAmount b
         return false;
     }
 
-    int nVoutIndex = 0;
-    for (int i = 0; i < nPayments; i++) {
-        CGovernancePayment payment;
-        if (!GetPayment(i, payment)) {
-            // This shouldn't happen so log a warning
-            LogPrintf("CSuperblock::IsValid -- WARNING: Failed to find payment: %d of %d total payments\n", i, nPayments);
-            continue;
-        }
-
-        bool fPaymentMatch = false;
-
-        for (int j = nVoutIndex; j < nOutputs; j++) {
-            // Find superblock payment
-            fPaymentMatch = ((payment.script == txNew.vout[j].scriptPubKey) &&
-                             (payment.nAmount == txNew.vout[j].nValue));
-
-            if (fPaymentMatch) {
-                nVoutIndex = j;
-                break;
-            }
+    // Every payment has to be matched by an output at or after the output matching the previous payment, so a single
+    // pass over the outputs matches the payments in order. Consecutive identical payments may match the same output.
+    int nPaymentIndex = 0;
+    for (int j = 0; j < nOutputs && nPaymentIndex < nPayments; j++) {
+        const CTxOut& txout = txNew.vout[j];
+        while (nPaymentIndex < nPayments && vecPayments[nPaymentIndex].nAmount == txout.nValue &&
+               vecPayments[nPaymentIndex].script == txout.scriptPubKey) {
+            nPaymentIndex++;
         }
+    }
 
-        if (!fPaymentMatch) {
-            // Superblock payment not found!
+    if (nPaymentIndex < nPayments) {
+        // Superblock payment not found!
 
-            CTxDestination dest;
-            ExtractDestination(payment.script, dest);
-            LogPrintf("CSuperblock::IsValid -- ERROR: Block invalid: %d payment %d to %s not found\n", i, payment.nAmount, EncodeDestination(dest));
+        const CGovernancePayment& payment = vecPayments[nPaymentIndex];
+        CTxDestination dest;
+        ExtractDestination(payment.script, dest);
+        LogPrintf("CSuperblock::IsValid -- ERROR: Block invalid: %d payment %d to %s not found\n", nPaymentIndex, payment.nAmount, EncodeDestination(dest));
 
-            return false;
-        }
+        return false;
     }
 
     return true;
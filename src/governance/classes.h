@@ -122,7 +122,9 @@ private:
 
     int nBlockHeight;
     SeenObjectStatus nStatus;
+    // The payment schedule, parsed once when the trigger is added and never modified afterwards
     std::vector<CGovernancePayment> vecPayments;
+    CAmount nPaymentsTotalAmount{0};
 
     void ParsePaymentSchedule(const std::string& strPaymentAddresses, const std::string& strPaymentAmounts, const std::string& strProposalHashes);
 
@@ -143,7 +145,7 @@ public:
     // TELL THE ENGINE WE EXECUTED THIS EVENT
     void SetExecuted() { nStatus = SeenObjectStatus::Executed; }
 
-    CGovernanceObject* GetGovernanceObject(CGovernanceManager& governanceManager);
+    CGovernanceObject* GetGovernanceObject(CGovernanceManager& governanceManager) const;
 
     int GetBlockHeight() const
     {
@@ -151,10 +153,11 @@ public:
     }
 
     int CountPayments() const { return (int)vecPayments.size(); }
-    bool GetPayment(int nPaymentIndex, CGovernancePayment& paymentRet);
-    CAmount GetPaymentsTotalAmount();
+    bool GetPayment(int nPaymentIndex, CGovernancePayment& paymentRet) const;
+    const std::vector<CGovernancePayment>& GetPayments() const { return vecPayments; }
+    CAmount GetPaymentsTotalAmount() const { return nPaymentsTotalAmount; }
 
-    bool IsValid(const CTransaction& txNew, int nBlockHeight, CAmount blockReward);
+    bool IsValid(const CTransaction& txNew, int nBlockHeight, CAmount blockReward) const;
     bool IsExpired(const CGovernanceManager& governanceManager) const;
 
     std::vector<uint256> GetProposalHashes() const;
@@ -17,14 +17,19 @@
 #include <masternode/meta.h>
 #include <masternode/node.h>
 #include <masternode/sync.h>
+#include <memusage.h>
 #include <netfulfilledman.h>
 #include <netmessagemaker.h>
 #include <protocol.h>
 #include <shutdown.h>
 #include <spork.h>
+#include <util/ranges.h>
+#include <util/threadbudget.h>
 #include <util/time.h>
 #include <validation.h>
 
+#include <future>
+
 std::unique_ptr<CGovernanceManager> governance;
 
 int nSubmittedFinalBudget;
@@ -33,6 +38,36 @@ const std::string GovernanceStore::SERIALIZATION_VERSION_STRING = "CGovernanceMa
 const int CGovernanceManager::MAX_TIME_FUTURE_DEVIATION = 60 * 60;
 const int CGovernanceManager::RELIABLE_PROPAGATION_TIME = 60;
 
+//! More collaterals of added or removed masternodes than this pending at once drop all vote tallies instead
+static constexpr size_t MAX_PENDING_TALLY_COLLATERALS{1000};
+
+//! Fewer objects or votes than this are checked on the calling thread only, not worth starting threads for
+static constexpr size_t MIN_PARALLEL_GOVERNANCE_CHECKS{64};
+
+/**
+ * Call check(i) for every i in [0, count), strided over a few threads when there are enough items. check must only touch
+ * state belonging to item i and must not take cs_main or CGovernanceManager::cs, the caller keeps holding them while
+ * waiting for the threads.
+ */
+template <typename Check>
+static void RunGovernanceChecks(size_t count, const Check& check)
+{
+    const size_t nThreads = count < MIN_PARALLEL_GOVERNANCE_CHECKS ? 1 : std::min<size_t>(GetThreadBudget(TaskPriority::BACKGROUND, 8), count);
+    const auto check_part = [&](size_t first) {
+        for (size_t i = first; i < count; i += nThreads) {
+            check(i);
+        }
+    };
+    std::vector<std::future<void>> workers;
+    for (size_t t = 1; t < nThreads; ++t) {
+        workers.push_back(std::async(std::launch::async, check_part, t));
+    }
+    check_part(0);
+    for (auto& worker : workers) {
+        worker.get();
+    }
+}
+
 GovernanceStore::GovernanceStore() :
     cs(),
     mapObjects(),
@@ -114,7 +149,7 @@ bool CGovernanceManager::SerializeVoteForHash(const uint256& nHash, CDataStream&
     return cmapVoteToObject.Get(nHash, pGovobj) && pGovobj->GetVoteFile().SerializeVoteToStream(nHash, ss);
 }
 
-PeerMsgRet CGovernanceManager::ProcessMessage(CNode& peer, CConnman& connman, std::string_view msg_type, CDataStream& vRecv)
+PeerMsgRet CGovernanceManager::ProcessMessage(CNode& peer, CConnman& connman, CBLSWorker& bls_worker, std::string_view msg_type, CDataStream& vRecv)
 {
     if (fDisableGovernance) return {};
     if (::masternodeSync == nullptr || !::masternodeSync->IsBlockchainSynced()) return {};
@@ -251,6 +286,65 @@ PeerMsgRet CGovernanceManager::ProcessMessage(CNode& peer, CConnman& connman, st
             return {};
         }
     }
+
+    // VOTES WE ASKED A PEER FOR VIA MNGOVERNANCESYNC HAVE ARRIVED
+    else if (msg_type == NetMsgType::MNGOVERNANCEOBJECTVOTES) {
+        std::vector<CGovernanceVote> vecVotes;
+        vRecv >> vecVotes;
+
+        if (vecVotes.size() > MAX_GOVERNANCE_VOTES_BATCH) {
+            LogPrint(BCLog::GOBJECT, "MNGOVERNANCEOBJECTVOTES -- too many votes: %d, peer = %d\n", vecVotes.size(), peer.GetId());
+            return tl::unexpected{20};
+        }
+        if (vecVotes.empty()) return {};
+
+        // All votes must be for an object we requested the votes for from this peer
+        const uint256 nParentHash = vecVotes.front().GetParentHash();
+        if (ranges::any_of(vecVotes, [&nParentHash](const auto& vote) { return vote.GetParentHash() != nParentHash; })) {
+            LogPrint(BCLog::GOBJECT, "MNGOVERNANCEOBJECTVOTES -- votes for different objects, peer = %d\n", peer.GetId());
+            return tl::unexpected{20};
+        }
+        {
+            LOCK(cs);
+            auto it = mapVoteBatchRequests.find(nParentHash);
+            if (it == mapVoteBatchRequests.end() || !it->second.count(peer.addr) || it->second[peer.addr] < GetTime()) {
+                LogPrint(BCLog::GOBJECT, "MNGOVERNANCEOBJECTVOTES -- Received unrequested votes for object: %s, peer = %d\n",
+                    nParentHash.ToString(), peer.GetId());
+                return {};
+            }
+        }
+
+        LogPrint(BCLog::GOBJECT, "MNGOVERNANCEOBJECTVOTES -- Received %d votes for object: %s, peer = %d\n", vecVotes.size(), nParentHash.ToString(), peer.GetId());
+
+        {
+            LOCK(cs_main);
+            for (const auto& vote : vecVotes) {
+                EraseObjectRequest(peer.GetId(), CInv(MSG_GOVERNANCE_OBJECT_VOTE, vote.GetHash()));
+            }
+        }
+
+        // Check all signatures at once on the BLS workers, ProcessVote below then finds them in the signature cache
+        // and applies the votes in the order they were sent. Votes for unknown objects are orphans and not checked yet.
+        const std::optional<GovernanceObject> objType = WITH_LOCK(cs, const CGovernanceObject* pObj = FindConstGovernanceObject(nParentHash);
+                                                                  return pObj ? std::make_optional(pObj->GetObjectType()) : std::nullopt);
+        if (objType) {
+            CGovernanceVote::VerifySignatures(bls_worker, vecVotes, *objType == GovernanceObject::PROPOSAL);
+        }
+
+        for (const auto& vote : vecVotes) {
+            CGovernanceException exception;
+            if (ProcessVote(&peer, vote, exception, connman)) {
+                LogPrint(BCLog::GOBJECT, "MNGOVERNANCEOBJECTVOTES -- %s new\n", vote.GetHash().ToString());
+                ::masternodeSync->BumpAssetLastTime("MNGOVERNANCEOBJECTVOTES");
+                vote.Relay(connman);
+            } else {
+                LogPrint(BCLog::GOBJECT, "MNGOVERNANCEOBJECTVOTES -- Rejected vote, error = %s\n", exception.what());
+                if ((exception.GetNodePenalty() != 0) && ::masternodeSync->IsSynced()) {
+                    return tl::unexpected{exception.GetNodePenalty()};
+                }
+            }
+        }
+    }
     return {};
 }
 
@@ -263,6 +357,15 @@ void CGovernanceManager::CheckOrphanVotes(CGovernanceObject& govobj, CConnman& c
     ScopedLockBool guard(cs, fRateChecksEnabled, false);
 
     int64_t nNow = GetAdjustedTime();
+
+    // Verify the signatures up front on a few threads, ProcessVote below then finds them in the signature cache
+    RunGovernanceChecks(vecVotePairs.size(), [&](size_t i) {
+        const auto& [vote, nExpiration] = vecVotePairs[i];
+        if (nExpiration < nNow) return;
+        const bool onlyVotingKeyAllowed = govobj.GetObjectType() == GovernanceObject::PROPOSAL && vote.GetSignal() == VOTE_SIGNAL_FUNDING;
+        (void)vote.IsValid(onlyVotingKeyAllowed);
+    });
+
     for (const auto& pairVote : vecVotePairs) {
         bool fRemove = false;
         const CGovernanceVote& vote = pairVote.first;
@@ -337,6 +440,54 @@ void CGovernanceManager::AddGovernanceObject(CGovernanceObject& govobj, CConnman
     GetMainSignals().NotifyGovernanceObject(std::make_shared<const Governance::Object>(govobj.Object()));
 }
 
+void CGovernanceManager::NotifyMasternodeListChanged(bool undo, const CDeterministicMNList& oldMNList, const CDeterministicMNListDiff& diff)
+{
+    // Vote weights don't depend on masternode state, only added and removed masternodes can change tallies.
+    // This runs from ConnectBlock/DisconnectBlock while the tip list is still the previous one, tallies dropped now
+    // would be recounted against it. Only remember what changed, UpdatedMasternodeListTip drops them.
+    LOCK(cs);
+    if (fPendingTallyReset) return;
+    if (undo) {
+        // the diff describes the reverted block, just recount everything
+        fPendingTallyReset = true;
+        setPendingTallyCollaterals.clear();
+        return;
+    }
+    for (const auto& dmn : diff.addedMNs) {
+        setPendingTallyCollaterals.emplace(dmn->collateralOutpoint);
+    }
+    for (const auto& internalId : diff.removedMns) {
+        if (auto dmn = oldMNList.GetMNByInternalId(internalId)) {
+            setPendingTallyCollaterals.emplace(dmn->collateralOutpoint);
+        }
+    }
+    if (setPendingTallyCollaterals.size() > MAX_PENDING_TALLY_COLLATERALS) {
+        // many blocks connected at once, cheaper to recount everything
+        fPendingTallyReset = true;
+        setPendingTallyCollaterals.clear();
+    }
+}
+
+void CGovernanceManager::UpdatedMasternodeListTip()
+{
+    {
+        LOCK(cs);
+        if (fPendingTallyReset || !setPendingTallyCollaterals.empty()) {
+            for (auto& [_, govobj] : mapObjects) {
+                if (fPendingTallyReset) {
+                    govobj.InvalidateVoteTally();
+                } else {
+                    govobj.InvalidateVoteTally(setPendingTallyCollaterals);
+                }
+            }
+            fPendingTallyReset = false;
+            setPendingTallyCollaterals.clear();
+        }
+    }
+
+    UpdateCachesAndClean();
+}
+
 void CGovernanceManager::UpdateCachesAndClean()
 {
     // Return on initial sync, spammed the debug.log and provided no use
@@ -363,12 +514,19 @@ void CGovernanceManager::UpdateCachesAndClean()
 
     auto it = mapObjects.begin();
     int64_t nNow = GetTime<std::chrono::seconds>().count();
+    const int nWeightedMnCount = (int)deterministicMNManager->GetListAtChainTip().GetValidWeightedMNsCount();
 
-    while (it != mapObjects.end()) {
-        CGovernanceObject* pObj = &((*it).second);
-
-        uint256 nHash = it->first;
-        std::string strHash = nHash.ToString();
+    // Parsing and validating the object data dominates this after a restart, when every object is dirty. It only
+    // depends on the object itself, so do it for all objects on a few threads first.
+    std::vector<CGovernanceObject*> vecObjects;
+    vecObjects.reserve(mapObjects.size());
+    for (auto& [_, govobj] : mapObjects) {
+        vecObjects.push_back(&govobj);
+    }
+    // Each object is only touched by one thread, std::vector<bool> can't be written concurrently
+    std::vector<char> vecProposalValid(vecObjects.size(), 1);
+    RunGovernanceChecks(vecObjects.size(), [&](size_t i) {
+        CGovernanceObject* pObj = vecObjects[i];
 
         // IF CACHE IS NOT DIRTY, WHY DO THIS?
         if (pObj->IsSetDirtyCache()) {
@@ -376,8 +534,22 @@ void CGovernanceManager::UpdateCachesAndClean()
             pObj->UpdateLocalValidity();
 
             // UPDATE SENTINEL SIGNALING VARIABLES
-            pObj->UpdateSentinelVariables();
+            pObj->UpdateSentinelVariables(nWeightedMnCount);
+        }
+
+        // NOTE: triggers are handled via triggerman
+        if (pObj->GetObjectType() == GovernanceObject::PROPOSAL) {
+            vecProposalValid[i] = CProposalValidator(pObj->GetDataAsHexString()).Validate();
         }
+    });
+
+    size_t nIndex = 0;
+    while (it != mapObjects.end()) {
+        CGovernanceObject* pObj = &((*it).second);
+        const bool fProposalValid = vecProposalValid[nIndex++];
+
+        uint256 nHash = it->first;
+        std::string strHash = nHash.ToString();
 
         // IF DELETE=TRUE, THEN CLEAN THE MESS UP!
 
@@ -417,13 +589,9 @@ void CGovernanceManager::UpdateCachesAndClean()
             mapErasedGovernanceObjects.insert(std::make_pair(nHash, nTimeExpired));
             mapObjects.erase(it++);
         } else {
-            // NOTE: triggers are handled via triggerman
-            if (pObj->GetObjectType() == GovernanceObject::PROPOSAL) {
-                CProposalValidator validator(pObj->GetDataAsHexString());
-                if (!validator.Validate()) {
-                    LogPrint(BCLog::GOBJECT, "CGovernanceManager::UpdateCachesAndClean -- set for deletion expired obj %s\n", strHash);
-                    pObj->PrepareDeletion(nNow);
-                }
+            if (!fProposalValid) {
+                LogPrint(BCLog::GOBJECT, "CGovernanceManager::UpdateCachesAndClean -- set for deletion expired obj %s\n", strHash);
+                pObj->PrepareDeletion(nNow);
             }
             ++it;
         }
@@ -877,6 +1045,11 @@ void CGovernanceManager::SyncSingleObjVotes(CNode& peer, const uint256& nProp, c
     }
 
     const auto& fileVotes = govobj.GetVoteFile();
+    CNetMsgMaker msgMaker(peer.GetCommonVersion());
+
+    // Peers which support it get the votes they asked for right away instead of an inv for each of them
+    const bool fBatch = peer.GetCommonVersion() >= GOVOBJVOTES_PROTO_VERSION;
+    std::vector<CGovernanceVote> vecBatch;
 
     for (const auto& vote : fileVotes.GetVotes()) {
         uint256 nVoteHash = vote.GetHash();
@@ -886,11 +1059,21 @@ void CGovernanceManager::SyncSingleObjVotes(CNode& peer, const uint256& nProp, c
         if (filter.contains(nVoteHash) || !vote.IsValid(onlyVotingKeyAllowed)) {
             continue;
         }
-        peer.PushInventory(CInv(MSG_GOVERNANCE_OBJECT_VOTE, nVoteHash));
+        if (fBatch) {
+            vecBatch.emplace_back(vote);
+            if (vecBatch.size() == MAX_GOVERNANCE_VOTES_BATCH) {
+                connman.PushMessage(&peer, msgMaker.Make(NetMsgType::MNGOVERNANCEOBJECTVOTES, vecBatch));
+                vecBatch.clear();
+            }
+        } else {
+            peer.PushInventory(CInv(MSG_GOVERNANCE_OBJECT_VOTE, nVoteHash));
+        }
         ++nVoteCount;
     }
+    if (!vecBatch.empty()) {
+        connman.PushMessage(&peer, msgMaker.Make(NetMsgType::MNGOVERNANCEOBJECTVOTES, vecBatch));
+    }
 
-    CNetMsgMaker msgMaker(peer.GetCommonVersion());
     connman.PushMessage(&peer, msgMaker.Make(NetMsgType::SYNCSTATUSCOUNT, MASTERNODE_SYNC_GOVOBJ_VOTE, nVoteCount));
     LogPrint(BCLog::GOBJECT, "CGovernanceManager::%s -- sent %d votes to peer=%d\n", __func__, nVoteCount, peer.GetId());
 }
@@ -1104,6 +1287,23 @@ void CGovernanceManager::CheckPostponedObjects(CConnman& connman)
 {
     if (!::masternodeSync->IsSynced()) return;
 
+    // Look the collaterals up in the tx index in one go before taking cs_main, on a few threads when there are many
+    std::vector<std::pair<uint256, uint256>> vecPostponed;
+    {
+        LOCK(cs);
+        for (const auto& [nHash, govobj] : mapPostponedObjects) {
+            vecPostponed.emplace_back(nHash, govobj.GetCollateralHash());
+        }
+    }
+    std::vector<std::pair<CTransactionRef, uint256>> vecCollaterals(vecPostponed.size());
+    RunGovernanceChecks(vecPostponed.size(), [&](size_t i) {
+        vecCollaterals[i].first = CGovernanceObject::GetCollateralTransaction(vecPostponed[i].second, vecCollaterals[i].second);
+    });
+    std::map<uint256, std::pair<CTransactionRef, uint256>> mapCollaterals;
+    for (size_t i = 0; i < vecPostponed.size(); ++i) {
+        mapCollaterals.emplace(vecPostponed[i].first, std::move(vecCollaterals[i]));
+    }
+
     LOCK2(cs_main, cs);
 
     // Check postponed proposals
@@ -1115,7 +1315,15 @@ void CGovernanceManager::CheckPostponedObjects(CConnman& connman)
 
         std::string strError;
         bool fMissingConfirmations;
-        if (govobj.IsCollateralValid(strError, fMissingConfirmations)) {
+        // objects postponed in the meantime weren't looked up yet
+        auto itCollateral = mapCollaterals.find(nHash);
+        if (itCollateral == mapCollaterals.end()) {
+            uint256 nBlockHash;
+            CTransactionRef txCollateral = CGovernanceObject::GetCollateralTransaction(govobj.GetCollateralHash(), nBlockHash);
+            itCollateral = mapCollaterals.emplace(nHash, std::make_pair(std::move(txCollateral), nBlockHash)).first;
+        }
+        const auto& [txCollateral, nBlockHash] = itCollateral->second;
+        if (govobj.IsCollateralValid(strError, fMissingConfirmations, txCollateral, nBlockHash)) {
             if (govobj.IsValidLocally(strError, false)) {
                 AddGovernanceObject(govobj, connman);
             } else {
@@ -1192,6 +1400,19 @@ void CGovernanceManager::RequestGovernanceObject(CNode* pfrom, const uint256& nH
         }
     }
 
+    if (pfrom->GetCommonVersion() >= GOVOBJVOTES_PROTO_VERSION) {
+        LOCK(cs);
+        const int64_t nNow = GetTime();
+        for (auto it = mapVoteBatchRequests.begin(); it != mapVoteBatchRequests.end(); ) {
+            auto& mapPeers = it->second;
+            for (auto jt = mapPeers.begin(); jt != mapPeers.end(); ) {
+                jt = jt->second < nNow ? mapPeers.erase(jt) : std::next(jt);
+            }
+            it = mapPeers.empty() ? mapVoteBatchRequests.erase(it) : std::next(it);
+        }
+        mapVoteBatchRequests[nHash][pfrom->addr] = nNow + GOVERNANCE_VOTES_BATCH_TIMEOUT;
+    }
+
     LogPrint(BCLog::GOBJECT, "CGovernanceManager::RequestGovernanceObject -- nHash %s nVoteCount %d peer=%d\n", nHash.ToString(), nVoteCount, pfrom->GetId());
     connman.PushMessage(pfrom, msgMaker.Make(NetMsgType::MNGOVERNANCESYNC, nHash, filter));
 }
@@ -1385,6 +1606,27 @@ void GovernanceStore::Clear()
     mapLastMasternodeObject.clear();
 }
 
+size_t CGovernanceManager::DynamicMemoryUsage() const
+{
+    LOCK(cs);
+    size_t nUsage = memusage::DynamicUsage(mapObjects) + memusage::DynamicUsage(mapPostponedObjects) +
+                    memusage::DynamicUsage(mapErasedGovernanceObjects) + memusage::DynamicUsage(mapLastMasternodeObject) +
+                    memusage::DynamicUsage(setAdditionalRelayObjects) + memusage::DynamicUsage(setRequestedObjects) +
+                    memusage::DynamicUsage(setRequestedVotes) + memusage::DynamicUsage(mapVoteBatchRequests) +
+                    cmapVoteToObject.DynamicMemoryUsage() + cmapInvalidVotes.DynamicMemoryUsage() +
+                    cmmapOrphanVotes.DynamicMemoryUsage();
+    for (const auto& [_, govobj] : mapObjects) {
+        nUsage += govobj.DynamicMemoryUsage();
+    }
+    for (const auto& [_, govobj] : mapPostponedObjects) {
+        nUsage += govobj.DynamicMemoryUsage();
+    }
+    for (const auto& [_, requests] : mapVoteBatchRequests) {
+        nUsage += memusage::DynamicUsage(requests);
+    }
+    return nUsage;
+}
+
 std::string GovernanceStore::ToString() const
 {
     LOCK(cs);
@@ -10,12 +10,15 @@
 
 #include <cachemap.h>
 #include <cachemultimap.h>
+#include <netaddress.h>
 #include <net_types.h>
+#include <saltedhasher.h>
 
 #include <optional>
 
 class CBloomFilter;
 class CBlockIndex;
+class CBLSWorker;
 template<typename T>
 class CFlatDB;
 class CInv;
@@ -30,7 +33,13 @@ extern std::unique_ptr<CGovernanceManager> governance;
 
 static constexpr int RATE_BUFFER_SIZE = 5;
 
+/// Maximum number of votes in a single "govobjvotes" message
+static constexpr size_t MAX_GOVERNANCE_VOTES_BATCH = 1000;
+/// How long after a "govsync" request for the votes of an object we accept "govobjvotes" for it from that peer
+static constexpr int64_t GOVERNANCE_VOTES_BATCH_TIMEOUT = 10 * 60;
+
 class CDeterministicMNList;
+class CDeterministicMNListDiff;
 using CDeterministicMNListPtr = std::shared_ptr<CDeterministicMNList>;
 
 class CRateCheckBuffer
@@ -147,9 +156,9 @@ protected:
         bool fStatusOK;
     };
 
-    using object_ref_cm_t = CacheMap<uint256, CGovernanceObject*>;
+    using object_ref_cm_t = CacheMap<uint256, CGovernanceObject*, uint32_t, StaticSaltedHasher>;
     using txout_m_t = std::map<COutPoint, last_object_rec>;
-    using vote_cmm_t = CacheMultiMap<uint256, vote_time_pair_t>;
+    using vote_cmm_t = CacheMultiMap<uint256, vote_time_pair_t, uint32_t, StaticSaltedHasher>;
 
 protected:
     static constexpr int MAX_CACHE_SIZE = 1000000;
@@ -167,7 +176,7 @@ protected:
     //   value - expiration time for deleted objects
     std::map<uint256, int64_t> mapErasedGovernanceObjects;
     object_ref_cm_t cmapVoteToObject;
-    CacheMap<uint256, CGovernanceVote> cmapInvalidVotes;
+    CacheMap<uint256, CGovernanceVote, uint32_t, StaticSaltedHasher> cmapInvalidVotes;
     vote_cmm_t cmmapOrphanVotes;
     txout_m_t mapLastMasternodeObject;
     // used to check for changed voting keys
@@ -261,8 +270,14 @@ private:
     hash_s_t setAdditionalRelayObjects;
     hash_s_t setRequestedObjects;
     hash_s_t setRequestedVotes;
+    /// objects we asked peers to send votes for, with the time until which we accept vote batches for them
+    mutable std::map<uint256, std::map<CService, int64_t>> mapVoteBatchRequests;
     bool fRateChecksEnabled;
     std::optional<uint256> votedFundingYesTriggerHash;
+    /// collaterals of masternodes added or removed since the tip list was last updated, their vote tallies are stale
+    std::set<COutPoint> setPendingTallyCollaterals GUARDED_BY(cs);
+    /// blocks were disconnected since the tip list was last updated, all vote tallies are stale
+    bool fPendingTallyReset GUARDED_BY(cs){false};
 
 public:
     CGovernanceManager();
@@ -282,7 +297,7 @@ public:
     void SyncSingleObjVotes(CNode& peer, const uint256& nProp, const CBloomFilter& filter, CConnman& connman);
     PeerMsgRet SyncObjects(CNode& peer, CConnman& connman) const;
 
-    PeerMsgRet ProcessMessage(CNode& peer, CConnman& connman, std::string_view msg_type, CDataStream& vRecv);
+    PeerMsgRet ProcessMessage(CNode& peer, CConnman& connman, CBLSWorker& bls_worker, std::string_view msg_type, CDataStream& vRecv);
 
     void ResetVotedFundingTrigger();
 
@@ -303,8 +318,16 @@ public:
 
     void CheckAndRemove() { UpdateCachesAndClean(); }
 
+    /// Remembers the vote tallies affected by added/removed masternodes, they are dropped by UpdatedMasternodeListTip
+    void NotifyMasternodeListChanged(bool undo, const CDeterministicMNList& oldMNList, const CDeterministicMNListDiff& diff);
+    /// Called once the tip masternode list was updated, drops the affected vote tallies and updates the caches of changed objects
+    void UpdatedMasternodeListTip();
+
     UniValue ToJson() const;
 
+    /** Estimated memory used by the governance objects, their votes and the vote caches */
+    size_t DynamicMemoryUsage() const;
+
     void UpdatedBlockTip(const CBlockIndex* pindex, CConnman& connman);
     int64_t GetLastDiffTime() const { return nTimeLastDiff; }
     void UpdateLastDiffTime(int64_t nTimeIn) { nTimeLastDiff = nTimeIn; }
@@ -189,6 +189,16 @@ bool CGovernanceObject::ProcessVote(const CGovernanceVote& vote, CGovernanceExce
         return false;
     }
 
+    if (cachedVoteTally) {
+        const int nWeight = GetMnType(dmn->nType).voting_weight;
+        auto& signalCounts = cachedVoteTally->counts[eSignal];
+        if (voteInstanceRef.eOutcome > VOTE_OUTCOME_NONE && voteInstanceRef.eOutcome <= VOTE_OUTCOME_ABSTAIN) {
+            signalCounts[voteInstanceRef.eOutcome] -= nWeight;
+        }
+        if (vote.GetOutcome() > VOTE_OUTCOME_NONE && vote.GetOutcome() <= VOTE_OUTCOME_ABSTAIN) {
+            signalCounts[vote.GetOutcome()] += nWeight;
+        }
+    }
     voteInstanceRef = vote_instance_t(vote.GetOutcome(), nVoteTimeUpdate, vote.GetTimestamp());
     fileVotes.AddVote(vote);
     fDirtyCache = true;
@@ -208,6 +218,7 @@ void CGovernanceObject::ClearMasternodeVotes()
         if (!mnList.HasMNByCollateral(it->first)) {
             fileVotes.RemoveVotesFromMasternode(it->first);
             mapCurrentMNVotes.erase(it++);
+            cachedVoteTally.reset();
             fDirtyCache = true;
         } else {
             ++it;
@@ -215,6 +226,29 @@ void CGovernanceObject::ClearMasternodeVotes()
     }
 }
 
+void CGovernanceObject::InvalidateVoteTally(const std::set<COutPoint>& collaterals)
+{
+    LOCK(cs);
+
+    if (!cachedVoteTally) {
+        return;
+    }
+    for (const auto& collateral : collaterals) {
+        if (mapCurrentMNVotes.count(collateral)) {
+            cachedVoteTally.reset();
+            fDirtyCache = true;
+            return;
+        }
+    }
+}
+
+void CGovernanceObject::InvalidateVoteTally()
+{
+    LOCK(cs);
+    cachedVoteTally.reset();
+    fDirtyCache = true;
+}
+
 std::set<uint256> CGovernanceObject::RemoveInvalidVotes(const COutPoint& mnOutpoint)
 {
     LOCK(cs);
@@ -243,6 +277,7 @@ std::set<uint256> CGovernanceObject::RemoveInvalidVotes(const COutPoint& mnOutpo
     if (it->second.mapInstances.empty()) {
         mapCurrentMNVotes.erase(it);
     }
+    cachedVoteTally.reset();
 
     std::string removedStr;
     for (const auto& h : removedVotes) {
@@ -399,9 +434,8 @@ UniValue CGovernanceObject::ToJson() const
 
 void CGovernanceObject::UpdateLocalValidity()
 {
-    AssertLockHeld(cs_main);
     // THIS DOES NOT CHECK COLLATERAL, THIS IS CHECKED UPON ORIGINAL ARRIVAL
-    fCachedLocalValidity = IsValidLocally(strLocalValidityError, false);
+    fCachedLocalValidity = IsDataValid(strLocalValidityError);
 }
 
 
@@ -412,12 +446,8 @@ bool CGovernanceObject::IsValidLocally(std::string& strError, bool fCheckCollate
     return IsValidLocally(strError, fMissingConfirmations, fCheckCollateral);
 }
 
-bool CGovernanceObject::IsValidLocally(std::string& strError, bool& fMissingConfirmations, bool fCheckCollateral) const
+bool CGovernanceObject::IsDataValid(std::string& strError) const
 {
-    AssertLockHeld(cs_main);
-
-    fMissingConfirmations = false;
-
     if (fUnparsable) {
         strError = "Object data unparsable";
         return false;
@@ -433,18 +463,41 @@ bool CGovernanceObject::IsValidLocally(std::string& strError, bool& fMissingConf
             strError = strprintf("Invalid proposal data, error messages: %s", validator.GetErrorMessages());
             return false;
         }
-        if (fCheckCollateral && !IsCollateralValid(strError, fMissingConfirmations)) {
+        return true;
+    }
+    case GovernanceObject::TRIGGER: {
+        // the signature needs the masternode list, see IsValidLocally
+        return true;
+    }
+    default: {
+        strError = strprintf("Invalid object type %d", ToUnderlying(m_obj.type));
+        return false;
+    }
+    }
+}
+
+bool CGovernanceObject::IsValidLocally(std::string& strError, bool& fMissingConfirmations, bool fCheckCollateral) const
+{
+    AssertLockHeld(cs_main);
+
+    fMissingConfirmations = false;
+
+    if (!IsDataValid(strError)) {
+        return false;
+    }
+    if (!fCheckCollateral) {
+        return true;
+    }
+
+    switch (m_obj.type) {
+    case GovernanceObject::PROPOSAL: {
+        if (!IsCollateralValid(strError, fMissingConfirmations)) {
             strError = "Invalid proposal collateral";
             return false;
         }
         return true;
     }
     case GovernanceObject::TRIGGER: {
-        if (!fCheckCollateral) {
-            // nothing else we can check here (yet?)
-            return true;
-        }
-
         auto mnList = deterministicMNManager->GetListAtChainTip();
 
         std::string strOutpoint = m_obj.masternodeOutpoint.ToStringShort();
@@ -485,17 +538,29 @@ CAmount CGovernanceObject::GetMinCollateralFee() const
     }
 }
 
+CTransactionRef CGovernanceObject::GetCollateralTransaction(const uint256& nCollateralHash, uint256& nBlockHash)
+{
+    return GetTransaction(/* block_index */ nullptr, /* mempool */ nullptr, nCollateralHash, Params().GetConsensus(), nBlockHash);
+}
+
 bool CGovernanceObject::IsCollateralValid(std::string& strError, bool& fMissingConfirmations) const
 {
     AssertLockHeld(cs_main);
 
+    // RETRIEVE TRANSACTION IN QUESTION
+    uint256 nBlockHash;
+    const CTransactionRef txCollateral = GetCollateralTransaction(m_obj.collateralHash, nBlockHash);
+    return IsCollateralValid(strError, fMissingConfirmations, txCollateral, nBlockHash);
+}
+
+bool CGovernanceObject::IsCollateralValid(std::string& strError, bool& fMissingConfirmations, const CTransactionRef& txCollateral, const uint256& nBlockHash) const
+{
+    AssertLockHeld(cs_main);
+
     strError = "";
     fMissingConfirmations = false;
     uint256 nExpectedHash = GetHash();
 
-    // RETRIEVE TRANSACTION IN QUESTION
-    uint256 nBlockHash;
-    CTransactionRef txCollateral = GetTransaction(/* block_index */ nullptr, /* mempool */ nullptr, m_obj.collateralHash, Params().GetConsensus(), nBlockHash);
     if (!txCollateral) {
         strError = strprintf("Can't find collateral tx %s", m_obj.collateralHash.ToString());
         LogPrintf("CGovernanceObject::IsCollateralValid -- %s\n", strError);
@@ -574,22 +639,32 @@ bool CGovernanceObject::IsCollateralValid(std::string& strError, bool& fMissingC
 
 int CGovernanceObject::CountMatchingVotes(vote_signal_enum_t eVoteSignalIn, vote_outcome_enum_t eVoteOutcomeIn) const
 {
-    auto mnList = deterministicMNManager->GetListAtChainTip();
+    if (eVoteSignalIn < VOTE_SIGNAL_NONE || eVoteSignalIn > MAX_SUPPORTED_VOTE_SIGNAL ||
+        eVoteOutcomeIn <= VOTE_OUTCOME_NONE || eVoteOutcomeIn > VOTE_OUTCOME_ABSTAIN) {
+        return 0;
+    }
 
     LOCK(cs);
 
-    int nCount = 0;
-    for (const auto& votepair : mapCurrentMNVotes) {
-        const vote_rec_t& recVote = votepair.second;
-        auto it2 = recVote.mapInstances.find(eVoteSignalIn);
-        if (it2 != recVote.mapInstances.end() && it2->second.eOutcome == eVoteOutcomeIn) {
+    // Tally all signals and outcomes in one pass, it is kept up to date by ProcessVote afterwards
+    if (!cachedVoteTally) {
+        auto mnList = deterministicMNManager->GetListAtChainTip();
+        vote_tally_t tally;
+        for (const auto& votepair : mapCurrentMNVotes) {
             // 4x times weight vote for EvoNode owners.
             // No need to check if v19 is active since no EvoNode are allowed to register before v19s
             auto dmn = mnList.GetMNByCollateral(votepair.first);
-            if (dmn != nullptr) nCount += GetMnType(dmn->nType).voting_weight;
+            if (dmn == nullptr) continue;
+            const int nWeight = GetMnType(dmn->nType).voting_weight;
+            for (const auto& [nSignal, voteInstance] : votepair.second.mapInstances) {
+                if (nSignal < VOTE_SIGNAL_NONE || nSignal > MAX_SUPPORTED_VOTE_SIGNAL) continue;
+                if (voteInstance.eOutcome <= VOTE_OUTCOME_NONE || voteInstance.eOutcome > VOTE_OUTCOME_ABSTAIN) continue;
+                tally.counts[nSignal][voteInstance.eOutcome] += nWeight;
+            }
         }
+        cachedVoteTally = std::move(tally);
     }
-    return nCount;
+    return cachedVoteTally->counts[eVoteSignalIn][eVoteOutcomeIn];
 }
 
 /**
@@ -659,10 +734,14 @@ void CGovernanceObject::Relay(CConnman& connman) const
 }
 
 void CGovernanceObject::UpdateSentinelVariables()
+{
+    UpdateSentinelVariables((int)deterministicMNManager->GetListAtChainTip().GetValidWeightedMNsCount());
+}
+
+void CGovernanceObject::UpdateSentinelVariables(int nWeightedMnCount)
 {
     // CALCULATE MINIMUM SUPPORT LEVELS REQUIRED
 
-    int nWeightedMnCount = (int)deterministicMNManager->GetListAtChainTip().GetValidWeightedMNsCount();
     if (nWeightedMnCount == 0) return;
 
     // CALCULATE THE MINIMUM VOTE COUNT REQUIRED FOR FULL SIGNAL
@@ -691,3 +770,14 @@ void CGovernanceObject::UpdateSentinelVariables()
 
     if (GetAbsoluteNoCount(VOTE_SIGNAL_VALID) >= nAbsVoteReq) fCachedValid = false;
 }
+
+size_t CGovernanceObject::DynamicMemoryUsage() const
+{
+    LOCK(cs);
+    size_t nUsage = memusage::DynamicUsage(m_obj.vchData) + memusage::DynamicUsage(m_obj.vchSig) +
+                    memusage::DynamicUsage(mapCurrentMNVotes) + fileVotes.DynamicMemoryUsage();
+    for (const auto& [_, voteRecord] : mapCurrentMNVotes) {
+        nUsage += memusage::DynamicUsage(voteRecord.mapInstances);
+    }
+    return nUsage;
+}
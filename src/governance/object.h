@@ -9,10 +9,14 @@
 #include <governance/exceptions.h>
 #include <governance/vote.h>
 #include <governance/votedb.h>
+#include <primitives/transaction.h>
 #include <sync.h>
 
 #include <univalue.h>
 
+#include <array>
+#include <optional>
+
 class CBLSSecretKey;
 class CBLSPublicKey;
 class CNode;
@@ -72,6 +76,16 @@ struct vote_instance_t {
 
 using vote_instance_m_t = std::map<int, vote_instance_t>;
 
+/**
+ * Weighted vote counts of an object for every signal and outcome, indexed by [signal][outcome].
+ * A vote's weight only depends on whether its collateral belongs to a masternode and on the masternode's type, so a
+ * tally stays valid until votes change or masternodes with voting collaterals are added or removed.
+ * VOTE_OUTCOME_NONE is not tallied.
+ */
+struct vote_tally_t {
+    std::array<std::array<int, VOTE_OUTCOME_ABSTAIN + 1>, MAX_SUPPORTED_VOTE_SIGNAL + 1> counts{};
+};
+
 struct vote_rec_t {
     vote_instance_m_t mapInstances;
 
@@ -132,6 +146,9 @@ private:
 
     vote_m_t mapCurrentMNVotes;
 
+    /// tallies of mapCurrentMNVotes, updated by ProcessVote and dropped by InvalidateVoteTally
+    mutable std::optional<vote_tally_t> cachedVoteTally;
+
     CGovernanceObjectVoteFile fileVotes;
 
 public:
@@ -213,6 +230,9 @@ public:
         return fileVotes;
     }
 
+    /** Memory used by the object data and its votes, not counting the object itself */
+    size_t DynamicMemoryUsage() const;
+
     // Signature related functions
 
     void SetMasternodeOutpoint(const COutPoint& outpoint);
@@ -229,10 +249,19 @@ public:
 
     /// Check the collateral transaction for the budget proposal/finalized budget
     bool IsCollateralValid(std::string& strError, bool& fMissingConfirmations) const EXCLUSIVE_LOCKS_REQUIRED(cs_main);
+    /// Same as above with the collateral transaction already looked up by GetCollateralTransaction, nullptr if it wasn't found
+    bool IsCollateralValid(std::string& strError, bool& fMissingConfirmations, const CTransactionRef& txCollateral, const uint256& nBlockHash) const EXCLUSIVE_LOCKS_REQUIRED(cs_main);
+    /// Find a collateral transaction in the tx index, doesn't need cs_main so it can be done before taking it
+    static CTransactionRef GetCollateralTransaction(const uint256& nCollateralHash, uint256& nBlockHash);
+
+    /// Checks which only depend on the object itself (data and type), safe to run on any thread
+    bool IsDataValid(std::string& strError) const;
 
     void UpdateLocalValidity();
 
     void UpdateSentinelVariables();
+    /// Same as above with the valid weighted masternode count of the tip list passed in, to share it between objects
+    void UpdateSentinelVariables(int nWeightedMnCount);
 
     void PrepareDeletion(int64_t nDeletionTime_)
     {
@@ -277,6 +306,7 @@ public:
         if (s.GetType() & SER_DISK) {
             // Only include these for the disk file format
             READWRITE(obj.nDeletionTime, obj.fExpired, obj.mapCurrentMNVotes, obj.fileVotes);
+            SER_READ(obj, obj.cachedVoteTally.reset());
         }
 
         // AFTER DESERIALIZATION OCCURS, CACHED VARIABLES MUST BE CALCULATED MANUALLY
@@ -293,6 +323,10 @@ public:
     /// Called when MN's which have voted on this object have been removed
     void ClearMasternodeVotes();
 
+    /// Called when masternodes with these collaterals were added or removed, drops the tally if any of them has voted
+    void InvalidateVoteTally(const std::set<COutPoint>& collaterals);
+    void InvalidateVoteTally();
+
     // Revalidate all votes from this MN and delete them if validation fails.
     // This is the case for DIP3 MNs that changed voting or operator keys and
     // also for MNs that were removed from the list completely.
@@ -6,17 +6,49 @@
 #include <governance/vote.h>
 
 #include <bls/bls.h>
+#include <bls/bls_batchverifier.h>
+#include <bls/bls_worker.h>
 #include <chainparams.h>
 #include <key.h>
 #include <masternode/sync.h>
 #include <messagesigner.h>
 #include <net.h>
+#include <saltedhasher.h>
+#include <unordered_lru_cache.h>
 #include <util/string.h>
 #include <util/system.h>
 #include <validation.h>
 
 #include <evo/deterministicmns.h>
 
+#include <future>
+
+/** Number of ECDSA vote signatures verified per worker job */
+static constexpr size_t VOTE_ECDSA_VERIFY_BATCH_SIZE = 64;
+
+// Votes are verified again whenever they are synced to peers or masternodes change keys, so remember which
+// vote/signature/key combinations were already found valid
+static Mutex cs_verified_sigs;
+static unordered_lru_cache<uint256, bool, StaticSaltedHasher, 1 << 17> verifiedSigs GUARDED_BY(cs_verified_sigs);
+
+template <typename Key>
+static uint256 GetVerifiedSigKey(const CGovernanceVote& vote, const std::vector<unsigned char>& vchSig, const Key& key)
+{
+    return ::SerializeHash(std::make_tuple(vote.GetHash(), vchSig, key));
+}
+
+static bool IsSigVerified(const uint256& sigKey)
+{
+    LOCK(cs_verified_sigs);
+    return verifiedSigs.exists(sigKey);
+}
+
+static void AddVerifiedSig(const uint256& sigKey)
+{
+    LOCK(cs_verified_sigs);
+    verifiedSigs.insert(sigKey, true);
+}
+
 std::string CGovernanceVoting::ConvertOutcomeToString(vote_outcome_enum_t nOutcome)
 {
     static const std::map<vote_outcome_enum_t, std::string> mapOutcomeString = {
@@ -200,6 +232,11 @@ bool CGovernanceVote::Sign(const CKey& key, const CKeyID& keyID)
 
 bool CGovernanceVote::CheckSignature(const CKeyID& keyID) const
 {
+    const uint256 sigKey = GetVerifiedSigKey(*this, vchSig, keyID);
+    if (IsSigVerified(sigKey)) {
+        return true;
+    }
+
     std::string strError;
 
     // Harden Spork6 so that it is active on testnet and no other networks
@@ -220,6 +257,7 @@ bool CGovernanceVote::CheckSignature(const CKeyID& keyID) const
         }
     }
 
+    AddVerifiedSig(sigKey);
     return true;
 }
 
@@ -235,15 +273,78 @@ bool CGovernanceVote::Sign(const CBLSSecretKey& key)
 
 bool CGovernanceVote::CheckSignature(const CBLSPublicKey& pubKey) const
 {
+    const uint256 sigKey = GetVerifiedSigKey(*this, vchSig, pubKey.GetHash());
+    if (IsSigVerified(sigKey)) {
+        return true;
+    }
+
     CBLSSignature sig;
     sig.SetByteVector(vchSig, false);
     if (!sig.VerifyInsecure(pubKey, GetSignatureHash(), false)) {
         LogPrintf("CGovernanceVote::CheckSignature -- VerifyInsecure() failed\n");
         return false;
     }
+    AddVerifiedSig(sigKey);
     return true;
 }
 
+void CGovernanceVote::VerifySignatures(CBLSWorker& worker, const std::vector<CGovernanceVote>& votes, bool fProposal)
+{
+    auto mnList = deterministicMNManager->GetListAtChainTip();
+
+    // The batch verifier verifies with the default scheme, CheckSignature always uses the basic one
+    const bool fBatchBLS = !bls::bls_legacy_scheme.load();
+    CBLSBatchVerifier<uint256, uint256> batchVerifier(true, true);
+    std::map<uint256, uint256> mapBLSSigKeys;
+    std::vector<std::pair<const CGovernanceVote*, CKeyID>> vecECDSA;
+
+    for (const auto& vote : votes) {
+        auto dmn = mnList.GetMNByCollateral(vote.GetMasternodeOutpoint());
+        if (!dmn) continue;
+
+        if (fProposal && vote.GetSignal() == VOTE_SIGNAL_FUNDING) {
+            if (!IsSigVerified(GetVerifiedSigKey(vote, vote.vchSig, dmn->pdmnState->keyIDVoting))) {
+                vecECDSA.emplace_back(&vote, dmn->pdmnState->keyIDVoting);
+            }
+            continue;
+        }
+        if (!fBatchBLS) continue;
+
+        const CBLSPublicKey pubKey = dmn->pdmnState->pubKeyOperator.Get();
+        const uint256 sigKey = GetVerifiedSigKey(vote, vote.vchSig, pubKey.GetHash());
+        if (IsSigVerified(sigKey)) continue;
+        CBLSSignature sig;
+        sig.SetByteVector(vote.vchSig, false);
+        if (!sig.IsValid() || !pubKey.IsValid()) continue;
+        const uint256 nHash = vote.GetHash();
+        if (!mapBLSSigKeys.emplace(nHash, sigKey).second) continue;
+        batchVerifier.PushMessage(pubKey.GetHash(), nHash, vote.GetSignatureHash(), sig, pubKey);
+    }
+
+    std::vector<std::future<void>> vecJobs;
+    for (size_t i = 0; i < vecECDSA.size(); i += VOTE_ECDSA_VERIFY_BATCH_SIZE) {
+        const size_t nEnd = std::min(vecECDSA.size(), i + VOTE_ECDSA_VERIFY_BATCH_SIZE);
+        vecJobs.emplace_back(worker.AsyncRun([&vecECDSA, i, nEnd] {
+            for (size_t j = i; j < nEnd; ++j) {
+                // adds valid signatures to the cache
+                (void)vecECDSA[j].first->CheckSignature(vecECDSA[j].second);
+            }
+        }));
+    }
+    if (!mapBLSSigKeys.empty()) {
+        vecJobs.emplace_back(worker.AsyncRun([&batchVerifier] { batchVerifier.Verify(); }));
+    }
+    for (auto& job : vecJobs) {
+        job.wait();
+    }
+
+    for (const auto& [nHash, sigKey] : mapBLSSigKeys) {
+        if (!batchVerifier.badMessages.count(nHash)) {
+            AddVerifiedSig(sigKey);
+        }
+    }
+}
+
 bool CGovernanceVote::IsValid(bool useVotingKey) const
 {
     if (nTime > GetAdjustedTime() + (60 * 60)) {
@@ -5,12 +5,16 @@
 #ifndef BITCOIN_GOVERNANCE_VOTE_H
 #define BITCOIN_GOVERNANCE_VOTE_H
 
+#include <memusage.h>
 #include <primitives/transaction.h>
 #include <uint256.h>
 
+#include <vector>
+
 class CGovernanceVote;
 class CBLSPublicKey;
 class CBLSSecretKey;
+class CBLSWorker;
 class CConnman;
 class CKey;
 class CKeyID;
@@ -98,6 +102,8 @@ public:
 
     void SetSignature(const std::vector<unsigned char>& vchSigIn) { vchSig = vchSigIn; }
 
+    size_t DynamicMemoryUsage() const { return memusage::DynamicUsage(vchSig); }
+
     bool Sign(const CKey& key, const CKeyID& keyID);
     bool CheckSignature(const CKeyID& keyID) const;
     bool Sign(const CBLSSecretKey& key);
@@ -105,6 +111,13 @@ public:
     bool IsValid(bool useVotingKey) const;
     void Relay(CConnman& connman) const;
 
+    /**
+     * Verify the signatures of many votes for the same object at once. BLS signatures are batch verified (grouped by
+     * operator key), ECDSA signatures are spread over the BLS workers. This only fills the cache CheckSignature
+     * consults, votes still have to be checked with IsValid.
+     */
+    static void VerifySignatures(CBLSWorker& worker, const std::vector<CGovernanceVote>& votes, bool fProposal);
+
     const COutPoint& GetMasternodeOutpoint() const { return masternodeOutpoint; }
 
     /**
@@ -4,17 +4,24 @@
 
 #include <governance/votedb.h>
 
+#include <memusage.h>
+
+#include <algorithm>
+#include <cassert>
+
 CGovernanceObjectVoteFile::CGovernanceObjectVoteFile() :
     nMemoryVotes(0),
     listVotes(),
-    mapVoteIndex()
+    mapVoteIndex(),
+    mapMasternodeVotes()
 {
 }
 
 CGovernanceObjectVoteFile::CGovernanceObjectVoteFile(const CGovernanceObjectVoteFile& other) :
     nMemoryVotes(other.nMemoryVotes),
     listVotes(other.listVotes),
-    mapVoteIndex()
+    mapVoteIndex(),
+    mapMasternodeVotes()
 {
     RebuildIndex();
 }
@@ -27,6 +34,7 @@ void CGovernanceObjectVoteFile::AddVote(const CGovernanceVote& vote)
         return;
     listVotes.push_front(vote);
     mapVoteIndex.emplace(nHash, listVotes.begin());
+    IndexVote(listVotes.begin());
     ++nMemoryVotes;
     RemoveOldVotes(vote);
 }
@@ -56,35 +64,38 @@ std::vector<CGovernanceVote> CGovernanceObjectVoteFile::GetVotes() const
 
 void CGovernanceObjectVoteFile::RemoveVotesFromMasternode(const COutPoint& outpointMasternode)
 {
-    auto it = listVotes.begin();
-    while (it != listVotes.end()) {
-        if (it->GetMasternodeOutpoint() == outpointMasternode) {
-            --nMemoryVotes;
-            mapVoteIndex.erase(it->GetHash());
-            listVotes.erase(it++);
-        } else {
-            ++it;
-        }
+    auto mnIt = mapMasternodeVotes.find(outpointMasternode);
+    if (mnIt == mapMasternodeVotes.end()) {
+        return;
+    }
+    for (const auto& it : mnIt->second) {
+        --nMemoryVotes;
+        mapVoteIndex.erase(it->GetHash());
+        listVotes.erase(it);
     }
+    mapMasternodeVotes.erase(mnIt);
 }
 
 std::set<uint256> CGovernanceObjectVoteFile::RemoveInvalidVotes(const COutPoint& outpointMasternode, bool fProposal)
 {
     std::set<uint256> removedVotes;
 
-    auto it = listVotes.begin();
-    while (it != listVotes.end()) {
-        if (it->GetMasternodeOutpoint() == outpointMasternode) {
-            bool useVotingKey = fProposal && (it->GetSignal() == VOTE_SIGNAL_FUNDING);
-            if (!it->IsValid(useVotingKey)) {
-                removedVotes.emplace(it->GetHash());
-                --nMemoryVotes;
-                mapVoteIndex.erase(it->GetHash());
-                listVotes.erase(it++);
-                continue;
-            }
+    auto mnIt = mapMasternodeVotes.find(outpointMasternode);
+    if (mnIt == mapMasternodeVotes.end()) {
+        return removedVotes;
+    }
+
+    // EraseVote modifies the index entry, so collect the invalid votes first
+    std::vector<vote_l_t::iterator> vecInvalid;
+    for (const auto& it : mnIt->second) {
+        bool useVotingKey = fProposal && (it->GetSignal() == VOTE_SIGNAL_FUNDING);
+        if (!it->IsValid(useVotingKey)) {
+            vecInvalid.emplace_back(it);
         }
-        ++it;
+    }
+    for (const auto& it : vecInvalid) {
+        removedVotes.emplace(it->GetHash());
+        EraseVote(it);
     }
 
     return removedVotes;
@@ -92,25 +103,49 @@ std::set<uint256> CGovernanceObjectVoteFile::RemoveInvalidVotes(const COutPoint&
 
 void CGovernanceObjectVoteFile::RemoveOldVotes(const CGovernanceVote& vote)
 {
-    auto it = listVotes.begin();
-    while (it != listVotes.end()) {
-        if (it->GetMasternodeOutpoint() == vote.GetMasternodeOutpoint() // same masternode
-            && it->GetParentHash() == vote.GetParentHash() // same governance object (e.g. same proposal)
+    auto mnIt = mapMasternodeVotes.find(vote.GetMasternodeOutpoint());
+    if (mnIt == mapMasternodeVotes.end()) {
+        return;
+    }
+
+    std::vector<vote_l_t::iterator> vecOld;
+    for (const auto& it : mnIt->second) {
+        if (it->GetParentHash() == vote.GetParentHash() // same governance object (e.g. same proposal)
             && it->GetSignal() == vote.GetSignal() // same signal (e.g. "funding", "delete", etc.)
             && it->GetTimestamp() < vote.GetTimestamp()) // older than new vote
         {
-            --nMemoryVotes;
-            mapVoteIndex.erase(it->GetHash());
-            listVotes.erase(it++);
-        } else {
-            ++it;
+            vecOld.emplace_back(it);
         }
     }
+    for (const auto& it : vecOld) {
+        EraseVote(it);
+    }
+}
+
+void CGovernanceObjectVoteFile::IndexVote(vote_l_t::iterator it)
+{
+    mapMasternodeVotes[it->GetMasternodeOutpoint()].emplace_back(it);
+}
+
+void CGovernanceObjectVoteFile::EraseVote(vote_l_t::iterator it)
+{
+    auto mnIt = mapMasternodeVotes.find(it->GetMasternodeOutpoint());
+    assert(mnIt != mapMasternodeVotes.end());
+    auto& vecVotes = mnIt->second;
+    vecVotes.erase(std::find(vecVotes.begin(), vecVotes.end(), it));
+    if (vecVotes.empty()) {
+        mapMasternodeVotes.erase(mnIt);
+    }
+
+    --nMemoryVotes;
+    mapVoteIndex.erase(it->GetHash());
+    listVotes.erase(it);
 }
 
 void CGovernanceObjectVoteFile::RebuildIndex()
 {
     mapVoteIndex.clear();
+    mapMasternodeVotes.clear();
     nMemoryVotes = 0;
     auto it = listVotes.begin();
     while (it != listVotes.end()) {
@@ -118,6 +153,7 @@ void CGovernanceObjectVoteFile::RebuildIndex()
         uint256 nHash = vote.GetHash();
         if (mapVoteIndex.find(nHash) == mapVoteIndex.end()) {
             mapVoteIndex[nHash] = it;
+            IndexVote(it);
             ++nMemoryVotes;
             ++it;
         } else {
@@ -125,3 +161,15 @@ void CGovernanceObjectVoteFile::RebuildIndex()
         }
     }
 }
+
+size_t CGovernanceObjectVoteFile::DynamicMemoryUsage() const
+{
+    size_t nUsage = memusage::DynamicUsage(listVotes) + memusage::DynamicUsage(mapVoteIndex) + memusage::DynamicUsage(mapMasternodeVotes);
+    for (const auto& vote : listVotes) {
+        nUsage += vote.DynamicMemoryUsage();
+    }
+    for (const auto& [_, votes] : mapMasternodeVotes) {
+        nUsage += memusage::DynamicUsage(votes);
+    }
+    return nUsage;
+}
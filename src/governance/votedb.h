@@ -29,6 +29,8 @@ public: // Types
 
     using vote_m_t = std::map<uint256, vote_l_t::iterator>;
 
+    using vote_mn_m_t = std::map<COutPoint, std::vector<vote_l_t::iterator>>;
+
 private:
     int nMemoryVotes;
 
@@ -36,6 +38,9 @@ private:
 
     vote_m_t mapVoteIndex;
 
+    /// votes by masternode collateral, so that per-masternode operations don't need to walk all votes
+    vote_mn_m_t mapMasternodeVotes;
+
 public:
     CGovernanceObjectVoteFile();
 
@@ -61,6 +66,8 @@ public:
         return nMemoryVotes;
     }
 
+    size_t DynamicMemoryUsage() const;
+
     std::vector<CGovernanceVote> GetVotes() const;
 
     void RemoveVotesFromMasternode(const COutPoint& outpointMasternode);
@@ -76,6 +83,9 @@ private:
     // Drop older votes for the same gobject from the same masternode
     void RemoveOldVotes(const CGovernanceVote& vote);
 
+    void IndexVote(vote_l_t::iterator it);
+    void EraseVote(vote_l_t::iterator it);
+
     void RebuildIndex();
 };
 
@@ -111,6 +111,8 @@ public:
     uint256 GetID() const { LOCK(cs); return id; }
 
     uint256 GetSeedHash();
+    /** Derive the key of the external or internal chain of an account, m/44'/coin_type'/account'/change */
+    void DeriveChainExtKey(uint32_t nAccountIndex, bool fInternal, CExtKey& extKeyRet, KeyOriginInfo& key_origin);
     void DeriveChildExtKey(uint32_t nAccountIndex, bool fInternal, uint32_t nChildIndex, CExtKey& extKeyRet, KeyOriginInfo& key_origin);
 
     void AddAccount();
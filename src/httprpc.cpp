@@ -6,9 +6,14 @@
 
 #include <chainparams.h>
 #include <crypto/hmac_sha256.h>
+#include <crypto/sha256.h>
 #include <httpserver.h>
+#include <random.h>
 #include <rpc/protocol.h>
 #include <rpc/server.h>
+#include <saltedhasher.h>
+#include <statsd_client.h>
+#include <sync.h>
 #include <util/strencodings.h>
 #include <util/string.h>
 #include <util/system.h>
@@ -16,11 +21,13 @@
 #include <walletinitinterface.h>
 
 #include <algorithm>
+#include <chrono>
 #include <iterator>
 #include <map>
 #include <memory>
 #include <set>
 #include <string>
+#include <unordered_map>
 
 /** WWW-Authenticate to present with 401 Unauthorized response */
 static const char* WWW_AUTH_HEADER_DATA = "Basic realm=\"jsonrpc\"";
@@ -72,6 +79,107 @@ static std::vector<std::vector<std::string>> g_rpcauth;
 static std::map<std::string, std::set<std::string>> g_rpc_whitelist;
 static bool g_rpc_whitelist_default = false;
 
+/** How long a successfully authenticated Authorization header is remembered */
+static constexpr auto RPC_AUTH_CACHE_TTL{std::chrono::seconds{60}};
+/** Maximum number of remembered Authorization headers */
+static constexpr size_t RPC_AUTH_CACHE_SIZE{64};
+
+/**
+ * Authorization headers which recently passed RPCAuthorized, so that clients on keep-alive connections don't pay
+ * for the base64 decoding and the -rpcauth HMAC on every call. Headers are only kept as a salted hash.
+ */
+class RPCAuthCache
+{
+private:
+    struct Entry {
+        std::string username;
+        std::chrono::seconds expiry;
+    };
+
+    Mutex cs;
+    const uint256 salt{GetRandHash()};
+    std::unordered_map<uint256, Entry, StaticSaltedHasher> entries GUARDED_BY(cs);
+
+    uint256 Key(const std::string& strAuth) const
+    {
+        uint256 key;
+        CSHA256().Write(salt.begin(), salt.size()).Write((const unsigned char*)strAuth.data(), strAuth.size()).Finalize(key.begin());
+        return key;
+    }
+
+public:
+    bool Get(const std::string& strAuth, std::string& strAuthUsernameOut) EXCLUSIVE_LOCKS_REQUIRED(!cs)
+    {
+        const uint256 key = Key(strAuth);
+        LOCK(cs);
+        auto it = entries.find(key);
+        if (it == entries.end()) {
+            return false;
+        }
+        if (it->second.expiry <= GetTime<std::chrono::seconds>()) {
+            entries.erase(it);
+            return false;
+        }
+        strAuthUsernameOut = it->second.username;
+        return true;
+    }
+
+    void Add(const std::string& strAuth, const std::string& username) EXCLUSIVE_LOCKS_REQUIRED(!cs)
+    {
+        const uint256 key = Key(strAuth);
+        const auto now = GetTime<std::chrono::seconds>();
+        LOCK(cs);
+        if (entries.size() >= RPC_AUTH_CACHE_SIZE) {
+            for (auto it = entries.begin(); it != entries.end();) {
+                it = it->second.expiry <= now ? entries.erase(it) : std::next(it);
+            }
+        }
+        if (entries.size() >= RPC_AUTH_CACHE_SIZE) {
+            entries.erase(std::min_element(entries.begin(), entries.end(), [](const auto& a, const auto& b) {
+                return a.second.expiry < b.second.expiry;
+            }));
+        }
+        entries.insert_or_assign(key, Entry{username, now + RPC_AUTH_CACHE_TTL});
+    }
+
+    void Clear() EXCLUSIVE_LOCKS_REQUIRED(!cs)
+    {
+        LOCK(cs);
+        entries.clear();
+    }
+};
+static RPCAuthCache g_rpc_auth_cache;
+
+/** Cheap RPCs which only return cached state. They are scheduled ahead of
+ * everything else so monitoring does not stall behind expensive calls. */
+static const std::set<std::string> FAST_RPC_METHODS{
+    "getbestblockhash",
+    "getbestchainlock",
+    "getblockcount",
+    "getconnectioncount",
+    "getdifficulty",
+    "getrpcinfo",
+    "uptime",
+};
+/** Larger request bodies are not inspected and the request counts as expensive */
+static const size_t MAX_CLASSIFIED_BODY_SIZE = 1024;
+
+static HTTPRequestClass ClassifyJSONRPC(const HTTPRequest* req)
+{
+    UniValue val;
+    if (req->GetRequestMethod() != HTTPRequest::POST || !val.read(req->PeekBody(MAX_CLASSIFIED_BODY_SIZE + 1))) {
+        return {"unknown"};
+    }
+    if (val.isArray()) {
+        return {"batch"};
+    }
+    const UniValue& method = val.isObject() ? find_value(val, "method") : NullUniValue;
+    if (!method.isStr()) {
+        return {"unknown"};
+    }
+    return {method.get_str(), FAST_RPC_METHODS.count(method.get_str()) > 0};
+}
+
 static void JSONErrorReply(HTTPRequest* req, const UniValue& objError, const UniValue& id)
 {
     // Send error reply from json-rpc error object
@@ -131,6 +239,9 @@ static bool RPCAuthorized(const std::string& strAuth, std::string& strAuthUserna
         return false;
     if (strAuth.substr(0, 6) != "Basic ")
         return false;
+    if (g_rpc_auth_cache.Get(strAuth, strAuthUsernameOut)) {
+        return true;
+    }
     std::string strUserPass64 = TrimString(strAuth.substr(6));
     bool invalid;
     std::string strUserPass = DecodeBase64(strUserPass64, &invalid);
@@ -140,10 +251,11 @@ static bool RPCAuthorized(const std::string& strAuth, std::string& strAuthUserna
         strAuthUsernameOut = strUserPass.substr(0, strUserPass.find(':'));
 
     //Check if authorized under single-user field
-    if (TimingResistantEqual(strUserPass, strRPCUserColonPass)) {
+    if (TimingResistantEqual(strUserPass, strRPCUserColonPass) || multiUserAuthorized(strUserPass)) {
+        g_rpc_auth_cache.Add(strAuth, strAuthUsernameOut);
         return true;
     }
-    return multiUserAuthorized(strUserPass);
+    return false;
 }
 
 static bool HTTPReq_JSONRPC(const CoreContext& context, HTTPRequest* req)
@@ -185,7 +297,8 @@ static bool HTTPReq_JSONRPC(const CoreContext& context, HTTPRequest* req)
         // Set the URI
         jreq.URI = req->GetURI();
 
-        std::string strReply;
+        // Replies are serialized straight into the HTTP output buffer
+        JSONStreamWriter writer([req](const std::string& chunk) { req->AppendReplyBody(chunk); });
         bool user_has_whitelist = g_rpc_whitelist.count(jreq.authUser);
         if (!user_has_whitelist && g_rpc_whitelist_default) {
             LogPrintf("RPC User %s not allowed to call any methods\n", jreq.authUser);
@@ -203,7 +316,9 @@ static bool HTTPReq_JSONRPC(const CoreContext& context, HTTPRequest* req)
             UniValue result = tableRPC.execute(jreq);
 
             // Send reply
-            strReply = JSONRPCReply(result, NullUniValue, jreq.id);
+            req->WriteHeader("Content-Type", "application/json");
+            writer.WriteReply(result, NullUniValue, jreq.id);
+            writer.WriteRaw("\n");
 
         // array of requests
         } else if (valRequest.isArray()) {
@@ -223,13 +338,14 @@ static bool HTTPReq_JSONRPC(const CoreContext& context, HTTPRequest* req)
                     }
                 }
             }
-            strReply = JSONRPCExecBatch(jreq, valRequest.get_array());
+            req->WriteHeader("Content-Type", "application/json");
+            JSONRPCExecBatch(jreq, valRequest.get_array(), writer);
         }
         else
             throw JSONRPCError(RPC_PARSE_ERROR, "Top-level object parse error");
 
-        req->WriteHeader("Content-Type", "application/json");
-        req->WriteReply(HTTP_OK, strReply);
+        writer.Flush();
+        req->WriteReply(HTTP_OK);
     } catch (const UniValue& objError) {
         JSONErrorReply(req, objError, jreq.id);
         return false;
@@ -242,6 +358,7 @@ static bool HTTPReq_JSONRPC(const CoreContext& context, HTTPRequest* req)
 
 static bool InitRPCAuthentication()
 {
+    g_rpc_auth_cache.Clear();
     if (gArgs.GetArg("-rpcpassword", "") == "")
     {
         LogPrintf("Using random cookie authentication.\n");
@@ -291,6 +408,29 @@ static bool InitRPCAuthentication()
     return true;
 }
 
+static bool HTTPReq_Metrics(HTTPRequest* req)
+{
+    if (req->GetRequestMethod() != HTTPRequest::GET) {
+        req->WriteReply(HTTP_BAD_METHOD, "Metrics are only served to GET requests");
+        return false;
+    }
+    // Same credentials as the RPC interface, which Prometheus supports through basic_auth
+    std::pair<bool, std::string> authHeader = req->GetHeader("authorization");
+    std::string authUser;
+    if (!authHeader.first || !RPCAuthorized(authHeader.second, authUser)) {
+        if (authHeader.first) {
+            LogPrintf("ThreadRPCServer incorrect password attempt from %s\n", req->GetPeer().ToString());
+            UninterruptibleSleep(std::chrono::milliseconds{250});
+        }
+        req->WriteHeader("WWW-Authenticate", WWW_AUTH_HEADER_DATA);
+        req->WriteReply(HTTP_UNAUTHORIZED);
+        return false;
+    }
+    req->WriteHeader("Content-Type", "text/plain; version=0.0.4");
+    req->WriteReply(HTTP_OK, statsClient.prometheusMetrics());
+    return true;
+}
+
 bool StartHTTPRPC(const CoreContext& context)
 {
     LogPrint(BCLog::RPC, "Starting HTTP RPC server\n");
@@ -298,9 +438,14 @@ bool StartHTTPRPC(const CoreContext& context)
         return false;
 
     auto handle_rpc = [&context](HTTPRequest* req, const std::string&) { return HTTPReq_JSONRPC(context, req); };
-    RegisterHTTPHandler("/", true, handle_rpc);
+    auto classify_rpc = [](const HTTPRequest* req, const std::string&) { return ClassifyJSONRPC(req); };
+    RegisterHTTPHandler("/", true, handle_rpc, classify_rpc);
     if (g_wallet_init_interface.HasWalletSupport()) {
-        RegisterHTTPHandler("/wallet/", false, handle_rpc);
+        RegisterHTTPHandler("/wallet/", false, handle_rpc, classify_rpc);
+    }
+    if (statsClient.metricsEnabled()) {
+        RegisterHTTPHandler("/metrics", true, [](HTTPRequest* req, const std::string&) { return HTTPReq_Metrics(req); },
+                            [](const HTTPRequest*, const std::string&) { return HTTPRequestClass{"metrics", /* fast */ true}; });
     }
     struct event_base* eventBase = EventBase();
     assert(eventBase);
@@ -321,6 +466,9 @@ void StopHTTPRPC()
     if (g_wallet_init_interface.HasWalletSupport()) {
         UnregisterHTTPHandler("/wallet/", false);
     }
+    if (statsClient.metricsEnabled()) {
+        UnregisterHTTPHandler("/metrics", true);
+    }
     if (httpRPCTimerInterface) {
         RPCUnsetTimerInterface(httpRPCTimerInterface.get());
         httpRPCTimerInterface.reset();
@@ -19,7 +19,9 @@
 #include <util/threadnames.h>
 #include <util/translation.h>
 
+#include <chrono>
 #include <deque>
+#include <map>
 #include <stdio.h>
 #include <string>
 
@@ -39,6 +41,9 @@
 /** Maximum size of http request (request line + headers) */
 static const size_t MAX_HEADERS_SIZE = 8192;
 
+/** Queue time statistics are kept for at most this many labels, others are merged */
+static const size_t MAX_QUEUE_TIME_LABELS = 256;
+
 /** HTTP request work item */
 class HTTPWorkItem final : public HTTPClosure
 {
@@ -59,22 +64,65 @@ private:
     HTTPRequestHandler func;
 };
 
-/** Simple work queue for distributing work over multiple threads.
- * Work items are simply callable objects.
+/** Work queue for distributing work over multiple threads.
+ * Work items are simply callable objects. Fast items are served first and
+ * cannot be starved by expensive ones: those may occupy all workers but one.
+ * Expensive items are queued per client and clients take turns, so a single
+ * client flooding the server only delays its own requests.
  */
 template <typename WorkItem>
 class WorkQueue
 {
 private:
+    using Clock = std::chrono::steady_clock;
+    struct Entry {
+        std::unique_ptr<WorkItem> item;
+        std::string label;
+        Clock::time_point queued;
+    };
+
     Mutex cs;
     std::condition_variable cond GUARDED_BY(cs);
-    std::deque<std::unique_ptr<WorkItem>> queue GUARDED_BY(cs);
+    //! Fast items in arrival order
+    std::deque<Entry> fast_queue GUARDED_BY(cs);
+    //! Expensive items per client
+    std::map<std::string, std::deque<Entry>> client_queues GUARDED_BY(cs);
+    //! Clients with queued expensive items, in the order they are served
+    std::deque<std::string> client_order GUARDED_BY(cs);
+    size_t slow_depth GUARDED_BY(cs){0};
+    //! Workers currently running an expensive item
+    size_t slow_busy GUARDED_BY(cs){0};
+    std::map<std::string, HTTPQueueTimeStats> queue_time_stats GUARDED_BY(cs);
     bool running GUARDED_BY(cs);
+    //! Bound of both the fast and the expensive queue
     const size_t maxDepth;
+    const size_t maxSlowWorkers;
+
+    bool HasRunnable() const EXCLUSIVE_LOCKS_REQUIRED(cs)
+    {
+        return !fast_queue.empty() || (slow_depth > 0 && (slow_busy < maxSlowWorkers || !running));
+    }
+
+    Entry PopSlow() EXCLUSIVE_LOCKS_REQUIRED(cs)
+    {
+        std::string client = std::move(client_order.front());
+        client_order.pop_front();
+        auto it = client_queues.find(client);
+        Entry e = std::move(it->second.front());
+        it->second.pop_front();
+        if (it->second.empty()) {
+            client_queues.erase(it);
+        } else {
+            client_order.push_back(std::move(client));
+        }
+        --slow_depth;
+        return e;
+    }
 
 public:
-    explicit WorkQueue(size_t _maxDepth) : running(true),
-                                 maxDepth(_maxDepth)
+    WorkQueue(size_t _maxDepth, size_t workers) : running(true),
+                                 maxDepth(_maxDepth),
+                                 maxSlowWorkers(std::max<size_t>(workers, 2) - 1)
     {
     }
     /** Precondition: worker threads have all stopped (they have been joined).
@@ -82,14 +130,22 @@ public:
     ~WorkQueue()
     {
     }
-    /** Enqueue a work item */
-    bool Enqueue(WorkItem* item)
+    /** Enqueue a work item of client */
+    bool Enqueue(WorkItem* item, const std::string& client, const HTTPRequestClass& req_class)
     {
         LOCK(cs);
-        if (!running || queue.size() >= maxDepth) {
+        if (!running || (req_class.fast ? fast_queue.size() : slow_depth) >= maxDepth) {
             return false;
         }
-        queue.emplace_back(std::unique_ptr<WorkItem>(item));
+        Entry e{std::unique_ptr<WorkItem>(item), req_class.label, Clock::now()};
+        if (req_class.fast) {
+            fast_queue.push_back(std::move(e));
+        } else {
+            auto& q = client_queues[client];
+            if (q.empty()) client_order.push_back(client);
+            q.push_back(std::move(e));
+            ++slow_depth;
+        }
         cond.notify_one();
         return true;
     }
@@ -97,17 +153,37 @@ public:
     void Run()
     {
         while (true) {
-            std::unique_ptr<WorkItem> i;
+            Entry e;
+            bool fast;
             {
                 WAIT_LOCK(cs, lock);
-                while (running && queue.empty())
+                while (running && !HasRunnable())
                     cond.wait(lock);
-                if (!running && queue.empty())
+                if (!HasRunnable())
                     break;
-                i = std::move(queue.front());
-                queue.pop_front();
+                fast = !fast_queue.empty();
+                if (fast) {
+                    e = std::move(fast_queue.front());
+                    fast_queue.pop_front();
+                } else {
+                    e = PopSlow();
+                    ++slow_busy;
+                }
+                const int64_t waited = std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - e.queued).count();
+                if (queue_time_stats.size() >= MAX_QUEUE_TIME_LABELS && !queue_time_stats.count(e.label)) {
+                    e.label = "other";
+                }
+                auto& stats = queue_time_stats[e.label];
+                ++stats.count;
+                stats.total_us += waited;
+                stats.max_us = std::max(stats.max_us, waited);
+            }
+            (*e.item)();
+            if (!fast) {
+                LOCK(cs);
+                --slow_busy;
+                if (slow_depth > 0) cond.notify_one();
             }
-            (*i)();
         }
     }
     /** Interrupt and exit loops */
@@ -117,17 +193,23 @@ public:
         running = false;
         cond.notify_all();
     }
+    std::map<std::string, HTTPQueueTimeStats> GetQueueTimeStats()
+    {
+        LOCK(cs);
+        return queue_time_stats;
+    }
 };
 
 struct HTTPPathHandler
 {
-    HTTPPathHandler(std::string _prefix, bool _exactMatch, HTTPRequestHandler _handler):
-        prefix(_prefix), exactMatch(_exactMatch), handler(_handler)
+    HTTPPathHandler(std::string _prefix, bool _exactMatch, HTTPRequestHandler _handler, HTTPRequestClassifier _classifier):
+        prefix(_prefix), exactMatch(_exactMatch), handler(_handler), classifier(_classifier)
     {
     }
     std::string prefix;
     bool exactMatch;
     HTTPRequestHandler handler;
+    HTTPRequestClassifier classifier;
 };
 
 /** HTTP module state */
@@ -258,9 +340,11 @@ static void http_request_cb(struct evhttp_request* req, void* arg)
 
     // Dispatch to worker thread
     if (i != iend) {
+        const HTTPRequestClass req_class{i->classifier ? i->classifier(hreq.get(), path) : HTTPRequestClass{i->prefix}};
+        const std::string client{hreq->GetPeer().ToStringIP()};
         auto item{std::make_unique<HTTPWorkItem>(std::move(hreq), path, i->handler)};
         assert(g_work_queue);
-        if (g_work_queue->Enqueue(item.get())) {
+        if (g_work_queue->Enqueue(item.get(), client, req_class)) {
             item.release(); /* if true, queue took ownership */
         } else {
             LogPrintf("WARNING: request rejected because http work queue depth exceeded, it can be increased with the -rpcworkqueue= setting\n");
@@ -393,9 +477,10 @@ bool InitHTTPServer()
 
     LogPrint(BCLog::HTTP, "Initialized HTTP server\n");
     int workQueueDepth = std::max((long)gArgs.GetArg("-rpcworkqueue", DEFAULT_HTTP_WORKQUEUE), 1L);
+    int rpcThreads = std::max((long)gArgs.GetArg("-rpcthreads", DEFAULT_HTTP_THREADS), 1L);
     LogPrintf("HTTP: creating work queue of depth %d\n", workQueueDepth);
 
-    g_work_queue = std::make_unique<WorkQueue<HTTPClosure>>(workQueueDepth);
+    g_work_queue = std::make_unique<WorkQueue<HTTPClosure>>(workQueueDepth, rpcThreads);
     // transfer ownership to eventBase/HTTP via .release()
     eventBase = base_ctr.release();
     eventHTTP = http_ctr.release();
@@ -475,6 +560,12 @@ void StopHTTPServer()
     LogPrint(BCLog::HTTP, "Stopped HTTP server\n");
 }
 
+std::map<std::string, HTTPQueueTimeStats> GetHTTPQueueTimeStats()
+{
+    if (!g_work_queue) return {};
+    return g_work_queue->GetQueueTimeStats();
+}
+
 struct event_base* EventBase()
 {
     return eventBase;
@@ -551,6 +642,18 @@ std::string HTTPRequest::ReadBody()
     return rv;
 }
 
+std::string HTTPRequest::PeekBody(size_t max_size) const
+{
+    struct evbuffer* buf = evhttp_request_get_input_buffer(req);
+    if (!buf)
+        return "";
+    const size_t size = std::min(evbuffer_get_length(buf), max_size);
+    std::string rv(size, '\0');
+    if (size > 0 && evbuffer_copyout(buf, rv.data(), size) != (ev_ssize_t)size)
+        return "";
+    return rv;
+}
+
 void HTTPRequest::WriteHeader(const std::string& hdr, const std::string& value)
 {
     struct evkeyvalq* headers = evhttp_request_get_output_headers(req);
@@ -563,6 +666,14 @@ void HTTPRequest::WriteHeader(const std::string& hdr, const std::string& value)
  * Replies must be sent in the main loop in the main http thread,
  * this cannot be done from worker threads.
  */
+void HTTPRequest::AppendReplyBody(const std::string& data)
+{
+    assert(!replySent && req);
+    struct evbuffer* evb = evhttp_request_get_output_buffer(req);
+    assert(evb);
+    evbuffer_add(evb, data.data(), data.size());
+}
+
 void HTTPRequest::WriteReply(int nStatus, const std::string& strReply)
 {
     assert(!replySent && req);
@@ -639,10 +750,11 @@ HTTPRequest::RequestMethod HTTPRequest::GetRequestMethod() const
     }
 }
 
-void RegisterHTTPHandler(const std::string &prefix, bool exactMatch, const HTTPRequestHandler &handler)
+void RegisterHTTPHandler(const std::string &prefix, bool exactMatch, const HTTPRequestHandler &handler,
+                         const HTTPRequestClassifier &classifier)
 {
     LogPrint(BCLog::HTTP, "Registering HTTP handler for %s (exactmatch %d)\n", prefix, exactMatch);
-    pathHandlers.push_back(HTTPPathHandler(prefix, exactMatch, handler));
+    pathHandlers.push_back(HTTPPathHandler(prefix, exactMatch, handler, classifier));
 }
 
 void UnregisterHTTPHandler(const std::string &prefix, bool exactMatch)
@@ -5,8 +5,10 @@
 #ifndef BITCOIN_HTTPSERVER_H
 #define BITCOIN_HTTPSERVER_H
 
-#include <string>
+#include <cstdint>
 #include <functional>
+#include <map>
+#include <string>
 
 static const int DEFAULT_HTTP_THREADS=4;
 static const int DEFAULT_HTTP_WORKQUEUE=16;
@@ -37,11 +39,27 @@ bool UpdateHTTPServerLogging(bool enable);
 
 /** Handler for requests to a certain HTTP path */
 typedef std::function<bool(HTTPRequest* req, const std::string &)> HTTPRequestHandler;
+
+/** How the work queue should schedule a request */
+struct HTTPRequestClass
+{
+    //! Name queue time statistics are accounted under, e.g. the RPC method
+    std::string label;
+    //! Cheap request which is served ahead of, and never waits behind, expensive ones
+    bool fast{false};
+};
+/** Classifier called on the HTTP thread before a request is queued.
+ * It must be cheap and must not consume the request body.
+ */
+typedef std::function<HTTPRequestClass(const HTTPRequest* req, const std::string &)> HTTPRequestClassifier;
+
 /** Register handler for prefix.
  * If multiple handlers match a prefix, the first-registered one will
- * be invoked.
+ * be invoked. Without a classifier all requests of the handler are
+ * accounted under its prefix and treated as expensive.
  */
-void RegisterHTTPHandler(const std::string &prefix, bool exactMatch, const HTTPRequestHandler &handler);
+void RegisterHTTPHandler(const std::string &prefix, bool exactMatch, const HTTPRequestHandler &handler,
+                         const HTTPRequestClassifier &classifier = nullptr);
 /** Unregister handler for prefix */
 void UnregisterHTTPHandler(const std::string &prefix, bool exactMatch);
 
@@ -50,6 +68,16 @@ void UnregisterHTTPHandler(const std::string &prefix, bool exactMatch);
  */
 struct event_base* EventBase();
 
+/** Time requests of one label spent in the work queue before a worker picked them up */
+struct HTTPQueueTimeStats
+{
+    uint64_t count{0};
+    int64_t total_us{0};
+    int64_t max_us{0};
+};
+/** Return work queue statistics per request label, empty if the server is not running */
+std::map<std::string, HTTPQueueTimeStats> GetHTTPQueueTimeStats();
+
 /** In-flight HTTP request.
  * Thin C++ wrapper around evhttp_request.
  */
@@ -97,6 +125,12 @@ public:
      */
     std::string ReadBody();
 
+    /**
+     * Return up to max_size bytes of the request body without consuming it,
+     * so a later ReadBody still returns the whole body.
+     */
+    std::string PeekBody(size_t max_size) const;
+
     /**
      * Write output header.
      *
@@ -104,6 +138,13 @@ public:
      */
     void WriteHeader(const std::string& hdr, const std::string& value);
 
+    /**
+     * Append to the reply body, so large replies need not be built in one string first.
+     *
+     * @note call this before WriteReply, which sends the appended data followed by strReply.
+     */
+    void AppendReplyBody(const std::string& data);
+
     /**
      * Write HTTP reply.
      * nStatus is the HTTP status code to send.
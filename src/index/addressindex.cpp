@@ -0,0 +1,428 @@
+// Copyright (c) 2016 BitPay, Inc.
+// Copyright (c) 2024 The Maximus developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <chainparams.h>
+#include <index/addressindex.h>
+#include <node/blockstorage.h>
+#include <undo.h>
+#include <util/system.h>
+#include <validation.h>
+
+#include <algorithm>
+#include <map>
+#include <tuple>
+
+static constexpr uint8_t DB_ADDRESSINDEX{'a'};
+static constexpr uint8_t DB_ADDRESSBALANCE{'b'};
+static constexpr uint8_t DB_ADDRESSUNSPENTINDEX{'u'};
+static constexpr uint8_t DB_TIMESTAMPINDEX{'s'};
+static constexpr uint8_t DB_SPENTINDEX{'p'};
+static constexpr uint8_t DB_ENABLED_INDEXES{'E'};
+
+static constexpr uint8_t ENABLED_ADDRESS_INDEX{1 << 0};
+static constexpr uint8_t ENABLED_SPENT_INDEX{1 << 1};
+static constexpr uint8_t ENABLED_TIMESTAMP_INDEX{1 << 2};
+
+std::unique_ptr<AddressIndex> g_address_index;
+
+/** Access to the address index database (indexes/addressindex/) */
+class AddressIndex::DB : public BaseIndex::DB
+{
+public:
+    explicit DB(size_t n_cache_size, bool f_memory = false, bool f_wipe = false);
+
+    bool ReadSpentIndex(const CSpentIndexKey& key, CSpentIndexValue& value);
+    bool ReadSpentIndexes(const std::vector<CSpentIndexKey>& keys, CSpentIndexTxInfo& info);
+    bool ReadAddressUnspentIndex(const uint160& addressHash, AddressType type,
+                                 std::vector<std::pair<CAddressUnspentKey, CAddressUnspentValue>>& unspentOutputs);
+    bool ScanAddressIndex(const uint160& addressHash, AddressType type, int start, int end, const CAddressIndexKey* from,
+                          const std::function<bool(const CAddressIndexKey&, CAmount)>& fn);
+    bool ReadAddressBalance(const uint160& addressHash, AddressType type, CAddressBalanceValue& value);
+};
+
+AddressIndex::DB::DB(size_t n_cache_size, bool f_memory, bool f_wipe) :
+    BaseIndex::DB(GetDataDir() / "indexes" / "addressindex", n_cache_size, f_memory, f_wipe)
+{}
+
+bool AddressIndex::DB::ReadSpentIndex(const CSpentIndexKey& key, CSpentIndexValue& value)
+{
+    return Read(std::make_pair(DB_SPENTINDEX, key), value);
+}
+
+bool AddressIndex::DB::ReadSpentIndexes(const std::vector<CSpentIndexKey>& keys, CSpentIndexTxInfo& info)
+{
+    // Outputs of the same transaction are adjacent in the database, visiting the keys in order
+    // lets the iterator step to the next one instead of seeking for it
+    std::vector<CSpentIndexKey> sorted_keys{keys};
+    std::sort(sorted_keys.begin(), sorted_keys.end(), CSpentIndexKeyCompare());
+
+    std::unique_ptr<CDBIterator> pcursor(NewIterator());
+    for (const auto& wanted : sorted_keys) {
+        std::pair<uint8_t, CSpentIndexKey> key;
+        if (!pcursor->Valid() || !pcursor->GetKey(key) || key.first != DB_SPENTINDEX ||
+            key.second.m_tx_hash != wanted.m_tx_hash || key.second.m_tx_index != wanted.m_tx_index) {
+            pcursor->Seek(std::make_pair(DB_SPENTINDEX, wanted));
+            if (!pcursor->Valid() || !pcursor->GetKey(key) || key.first != DB_SPENTINDEX ||
+                key.second.m_tx_hash != wanted.m_tx_hash || key.second.m_tx_index != wanted.m_tx_index) {
+                continue;
+            }
+        }
+        CSpentIndexValue value;
+        if (!pcursor->GetValue(value)) {
+            return error("failed to get spent index value");
+        }
+        info.mSpentInfo.emplace(wanted, value);
+        pcursor->Next();
+    }
+
+    return true;
+}
+
+bool AddressIndex::DB::ReadAddressUnspentIndex(const uint160& addressHash, AddressType type,
+                                               std::vector<std::pair<CAddressUnspentKey, CAddressUnspentValue>>& unspentOutputs)
+{
+    std::unique_ptr<CDBIterator> pcursor(NewIterator());
+
+    pcursor->Seek(std::make_pair(DB_ADDRESSUNSPENTINDEX, CAddressIndexIteratorKey(type, addressHash)));
+
+    while (pcursor->Valid()) {
+        std::pair<uint8_t, CAddressUnspentKey> key;
+        if (pcursor->GetKey(key) && key.first == DB_ADDRESSUNSPENTINDEX && key.second.m_address_bytes == addressHash) {
+            CAddressUnspentValue nValue;
+            if (pcursor->GetValue(nValue)) {
+                unspentOutputs.push_back(std::make_pair(key.second, nValue));
+                pcursor->Next();
+            } else {
+                return error("failed to get address unspent value");
+            }
+        } else {
+            break;
+        }
+    }
+
+    return true;
+}
+
+bool AddressIndex::DB::ScanAddressIndex(const uint160& addressHash, AddressType type, int start, int end, const CAddressIndexKey* from,
+                                        const std::function<bool(const CAddressIndexKey&, CAmount)>& fn)
+{
+    std::unique_ptr<CDBIterator> pcursor(NewIterator());
+
+    // Keys sort by address and then big-endian height, so a range is one contiguous run
+    if (from) {
+        pcursor->Seek(std::make_pair(DB_ADDRESSINDEX, *from));
+    } else if (start > 0) {
+        pcursor->Seek(std::make_pair(DB_ADDRESSINDEX, CAddressIndexIteratorHeightKey(type, addressHash, start)));
+    } else {
+        pcursor->Seek(std::make_pair(DB_ADDRESSINDEX, CAddressIndexIteratorKey(type, addressHash)));
+    }
+
+    while (pcursor->Valid()) {
+        std::pair<uint8_t, CAddressIndexKey> key;
+        if (pcursor->GetKey(key) && key.first == DB_ADDRESSINDEX && key.second.m_address_type == type && key.second.m_address_bytes == addressHash) {
+            if (end > 0 && key.second.m_block_height > end) {
+                break;
+            }
+            CAmount nValue;
+            if (pcursor->GetValue(nValue)) {
+                if (!fn(key.second, nValue)) break;
+                pcursor->Next();
+            } else {
+                return error("failed to get address index value");
+            }
+        } else {
+            break;
+        }
+    }
+
+    return true;
+}
+
+bool AddressIndex::DB::ReadAddressBalance(const uint160& addressHash, AddressType type, CAddressBalanceValue& value)
+{
+    // Addresses which never appeared have no record
+    if (!Read(std::make_pair(DB_ADDRESSBALANCE, CAddressIndexIteratorKey(type, addressHash)), value)) {
+        value = CAddressBalanceValue{};
+    }
+    return true;
+}
+
+AddressIndex::AddressIndex(size_t n_cache_size, bool f_address_index, bool f_spent_index, bool f_timestamp_index,
+                           bool f_memory, bool f_wipe) :
+    m_address_index(f_address_index), m_spent_index(f_spent_index), m_timestamp_index(f_timestamp_index)
+{
+    const uint8_t enabled = (m_address_index ? ENABLED_ADDRESS_INDEX : 0) |
+                            (m_spent_index ? ENABLED_SPENT_INDEX : 0) |
+                            (m_timestamp_index ? ENABLED_TIMESTAMP_INDEX : 0);
+
+    m_db = std::make_unique<AddressIndex::DB>(n_cache_size, f_memory, f_wipe);
+
+    // The indexes share one best block, so a newly enabled one can only be built from scratch
+    uint8_t db_enabled;
+    if (m_db->Read(DB_ENABLED_INDEXES, db_enabled) && db_enabled != enabled) {
+        LogPrintf("%s: set of enabled indexes changed, rebuilding\n", GetName());
+        m_db.reset();
+        m_db = std::make_unique<AddressIndex::DB>(n_cache_size, f_memory, /* f_wipe */ true);
+    }
+    m_db->Write(DB_ENABLED_INDEXES, enabled);
+}
+
+AddressIndex::~AddressIndex() {}
+
+bool AddressIndex::Init()
+{
+    if (!BaseIndex::Init()) {
+        return false;
+    }
+    if (m_timestamp_index) {
+        LOCK(m_timestamp_mutex);
+        for (const CBlockIndex* pindex = CurrentIndex(); pindex && pindex->nHeight > 0; pindex = pindex->pprev) {
+            if (m_timestamp_blocks.empty()) {
+                m_timestamp_blocks.resize(pindex->nHeight + 1);
+            }
+            m_timestamp_blocks[pindex->nHeight] = pindex;
+        }
+    }
+    return true;
+}
+
+bool AddressIndex::UpdateBlock(const CBlock& block, const CBlockIndex* pindex, bool fDisconnect)
+{
+    CBlockUndo blockUndo;
+    if (m_address_index || m_spent_index) {
+        if (!UndoReadFromDisk(blockUndo, pindex)) {
+            return error("%s: Failed to read undo data of block %s", __func__, pindex->GetBlockHash().ToString());
+        }
+        if (blockUndo.vtxundo.size() + 1 != block.vtx.size()) {
+            return error("%s: block %s and undo data inconsistent", __func__, pindex->GetBlockHash().ToString());
+        }
+    }
+
+    CDBBatch batch(*m_db);
+
+    // Balance changes per address, applied to the stored totals once the block is done
+    std::map<std::pair<AddressType, uint160>, CAddressBalanceValue> balance_deltas;
+    const int sign = fDisconnect ? -1 : 1;
+
+    const auto update_inputs = [&](const CTransaction& tx, uint32_t i) {
+        const CTxUndo& txundo = blockUndo.vtxundo[i - 1];
+        if (txundo.vprevout.size() != tx.vin.size()) {
+            return false;
+        }
+        const uint256& txhash = tx.GetHash();
+        for (uint32_t j = 0; j < tx.vin.size(); j++) {
+            const COutPoint& input = tx.vin[j].prevout;
+            const Coin& coin = txundo.vprevout[j];
+            const CTxOut& prevout = coin.out;
+
+            AddressType address_type{AddressType::UNKNOWN};
+            uint160 address_bytes;
+
+            AddressBytesFromScript(prevout.scriptPubKey, address_type, address_bytes);
+
+            if (m_address_index && address_type != AddressType::UNKNOWN) {
+                // spending activity, and the spent output leaving the unspent index
+                const auto index_key = std::make_pair(DB_ADDRESSINDEX, CAddressIndexKey(address_type, address_bytes, pindex->nHeight, i, txhash, j, true));
+                const auto unspent_key = std::make_pair(DB_ADDRESSUNSPENTINDEX, CAddressUnspentKey(address_type, address_bytes, input.hash, input.n));
+                if (fDisconnect) {
+                    batch.Erase(index_key);
+                    batch.Write(unspent_key, CAddressUnspentValue(prevout.nValue, prevout.scriptPubKey, coin.nHeight));
+                } else {
+                    batch.Write(index_key, prevout.nValue * -1);
+                    batch.Erase(unspent_key);
+                }
+                balance_deltas[{address_type, address_bytes}].m_balance -= sign * prevout.nValue;
+            }
+
+            if (m_spent_index) {
+                // the txid and input that spent an output, and the amount and address of an input
+                const auto spent_key = std::make_pair(DB_SPENTINDEX, CSpentIndexKey(input.hash, input.n));
+                if (fDisconnect) {
+                    batch.Erase(spent_key);
+                } else {
+                    batch.Write(spent_key, CSpentIndexValue(txhash, j, pindex->nHeight, prevout.nValue, address_type, address_bytes));
+                }
+            }
+        }
+        return true;
+    };
+
+    const auto update_outputs = [&](const CTransaction& tx, uint32_t i) {
+        const uint256& txhash = tx.GetHash();
+        for (uint32_t k = 0; k < tx.vout.size(); k++) {
+            const CTxOut& out = tx.vout[k];
+
+            AddressType address_type{AddressType::UNKNOWN};
+            uint160 address_bytes;
+
+            if (!AddressBytesFromScript(out.scriptPubKey, address_type, address_bytes)) {
+                continue;
+            }
+
+            // receiving activity, and the new output in the unspent index
+            const auto index_key = std::make_pair(DB_ADDRESSINDEX, CAddressIndexKey(address_type, address_bytes, pindex->nHeight, i, txhash, k, false));
+            const auto unspent_key = std::make_pair(DB_ADDRESSUNSPENTINDEX, CAddressUnspentKey(address_type, address_bytes, txhash, k));
+            if (fDisconnect) {
+                batch.Erase(index_key);
+                batch.Erase(unspent_key);
+            } else {
+                batch.Write(index_key, out.nValue);
+                batch.Write(unspent_key, CAddressUnspentValue(out.nValue, out.scriptPubKey, pindex->nHeight));
+            }
+            CAddressBalanceValue& delta = balance_deltas[{address_type, address_bytes}];
+            delta.m_balance += sign * out.nValue;
+            delta.m_received += sign * out.nValue;
+        }
+    };
+
+    // Transactions are undone in reverse order, so outputs created and spent within the
+    // block don't resurface in the unspent index.
+    for (size_t n = 0; n < block.vtx.size(); n++) {
+        const uint32_t i = fDisconnect ? block.vtx.size() - 1 - n : n;
+        const CTransaction& tx = *block.vtx[i];
+
+        if (fDisconnect && m_address_index) {
+            update_outputs(tx, i);
+        }
+        if (!tx.IsCoinBase() && (m_address_index || m_spent_index)) {
+            if (!update_inputs(tx, i)) {
+                return error("%s: transaction %s and undo data inconsistent", __func__, tx.GetHash().ToString());
+            }
+        }
+        if (!fDisconnect && m_address_index) {
+            update_outputs(tx, i);
+        }
+    }
+
+    for (const auto& [address, delta] : balance_deltas) {
+        const auto balance_key = std::make_pair(DB_ADDRESSBALANCE, CAddressIndexIteratorKey(address.first, address.second));
+        CAddressBalanceValue value;
+        m_db->ReadAddressBalance(address.second, address.first, value);
+        value.m_balance += delta.m_balance;
+        value.m_received += delta.m_received;
+        if (value.IsNull()) {
+            batch.Erase(balance_key);
+        } else {
+            batch.Write(balance_key, value);
+        }
+    }
+
+    if (m_timestamp_index) {
+        const auto timestamp_key = std::make_pair(DB_TIMESTAMPINDEX, CTimestampIndexKey(pindex->nTime, pindex->GetBlockHash()));
+        if (fDisconnect) {
+            batch.Erase(timestamp_key);
+        } else {
+            batch.Write(timestamp_key, 0);
+        }
+    }
+
+    // Move the best block along in the same batch, so that after a crash the index is
+    // never ahead of the block it resumes from.
+    {
+        LOCK(cs_main);
+        m_db->WriteBestBlock(batch, m_chainstate->m_chain.GetLocator(fDisconnect ? pindex->pprev : pindex));
+    }
+    return m_db->WriteBatch(batch);
+}
+
+bool AddressIndex::WriteBlock(const CBlock& block, const CBlockIndex* pindex)
+{
+    // The genesis block is never connected, see CChainState::ConnectBlock
+    if (pindex->nHeight == 0) return true;
+
+    if (!UpdateBlock(block, pindex, /* fDisconnect */ false)) {
+        return false;
+    }
+    if (m_timestamp_index) {
+        LOCK(m_timestamp_mutex);
+        m_timestamp_blocks.resize(pindex->nHeight + 1);
+        m_timestamp_blocks[pindex->nHeight] = pindex;
+    }
+    return true;
+}
+
+bool AddressIndex::Rewind(const CBlockIndex* current_tip, const CBlockIndex* new_tip)
+{
+    assert(current_tip->GetAncestor(new_tip->nHeight) == new_tip);
+
+    const auto& consensus_params{Params().GetConsensus()};
+    for (const CBlockIndex* pindex = current_tip; pindex != new_tip; pindex = pindex->pprev) {
+        CBlock block;
+        if (!ReadBlockFromDisk(block, pindex, consensus_params)) {
+            return error("%s: Failed to read block %s from disk",
+                         __func__, pindex->GetBlockHash().ToString());
+        }
+        if (!UpdateBlock(block, pindex, /* fDisconnect */ true)) {
+            return false;
+        }
+        if (m_timestamp_index) {
+            LOCK(m_timestamp_mutex);
+            m_timestamp_blocks.resize(pindex->nHeight);
+        }
+    }
+
+    return BaseIndex::Rewind(current_tip, new_tip);
+}
+
+BaseIndex::DB& AddressIndex::GetDB() const { return *m_db; }
+
+bool AddressIndex::ReadSpentIndex(const CSpentIndexKey& key, CSpentIndexValue& value) const
+{
+    return m_spent_index && m_db->ReadSpentIndex(key, value);
+}
+
+bool AddressIndex::ReadSpentIndexes(const std::vector<CSpentIndexKey>& keys, CSpentIndexTxInfo& info) const
+{
+    return m_spent_index && m_db->ReadSpentIndexes(keys, info);
+}
+
+bool AddressIndex::ReadAddressUnspentIndex(const uint160& addressHash, AddressType type,
+                                           std::vector<std::pair<CAddressUnspentKey, CAddressUnspentValue>>& unspentOutputs) const
+{
+    return m_address_index && m_db->ReadAddressUnspentIndex(addressHash, type, unspentOutputs);
+}
+
+bool AddressIndex::ScanAddressIndex(const uint160& addressHash, AddressType type, int start, int end, const CAddressIndexKey* from,
+                                    const std::function<bool(const CAddressIndexKey&, CAmount)>& fn) const
+{
+    return m_address_index && m_db->ScanAddressIndex(addressHash, type, start, end, from, fn);
+}
+
+bool AddressIndex::ReadAddressBalance(const uint160& addressHash, AddressType type, CAddressBalanceValue& value) const
+{
+    return m_address_index && m_db->ReadAddressBalance(addressHash, type, value);
+}
+
+bool AddressIndex::ReadTimestampIndex(unsigned int high, unsigned int low, std::vector<uint256>& hashes) const
+{
+    if (!m_timestamp_index) return false;
+
+    std::vector<std::pair<unsigned int, uint256>> found;
+    {
+        LOCK(m_timestamp_mutex);
+        // The genesis block isn't indexed. Blocks before the first one whose running maximum
+        // time reaches low are all older than low.
+        const auto begin = m_timestamp_blocks.size() > 1 ? m_timestamp_blocks.begin() + 1 : m_timestamp_blocks.end();
+        auto it = std::lower_bound(begin, m_timestamp_blocks.end(), low, [](const CBlockIndex* pindex, unsigned int time) {
+            return pindex->GetBlockTimeMax() < time;
+        });
+        for (; it != m_timestamp_blocks.end(); ++it) {
+            const CBlockIndex* pindex = *it;
+            if (pindex->nTime >= low && pindex->nTime <= high) {
+                found.emplace_back(pindex->nTime, pindex->GetBlockHash());
+            }
+            // Every block is newer than the median time past of its parent, and that median
+            // never decreases along the chain, so no later block can be in the range
+            if (pindex->GetMedianTimePast() >= (int64_t)high) break;
+        }
+    }
+
+    // Same order as the database keys: by time, then by hash
+    std::sort(found.begin(), found.end());
+    for (const auto& [_, hash] : found) {
+        hashes.push_back(hash);
+    }
+    return true;
+}
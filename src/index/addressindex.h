@@ -0,0 +1,86 @@
+// Copyright (c) 2016 BitPay, Inc.
+// Copyright (c) 2024 The Maximus developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_INDEX_ADDRESSINDEX_H
+#define BITCOIN_INDEX_ADDRESSINDEX_H
+
+#include <addressindex.h>
+#include <chain.h>
+#include <index/base.h>
+#include <spentindex.h>
+#include <sync.h>
+#include <timestampindex.h>
+
+#include <functional>
+#include <memory>
+#include <utility>
+#include <vector>
+
+/**
+ * AddressIndex maintains the indexes enabled by -addressindex, -spentindex and
+ * -timestampindex in their own database (indexes/addressindex/). The on-disk
+ * block and undo data of every connected block is indexed from the validation
+ * interface queue, so the index can trail the chain tip for a short while:
+ * callers wanting it in sync with the tip use BlockUntilSyncedToCurrentChain().
+ */
+class AddressIndex final : public BaseIndex
+{
+protected:
+    class DB;
+
+private:
+    std::unique_ptr<DB> m_db;
+
+    const bool m_address_index;
+    const bool m_spent_index;
+    const bool m_timestamp_index;
+
+    mutable Mutex m_timestamp_mutex;
+    /// The indexed blocks by height, for answering timestamp queries from memory. As block times
+    /// are nearly monotonic, a range is found by a binary search over the running maximum time.
+    std::vector<const CBlockIndex*> m_timestamp_blocks GUARDED_BY(m_timestamp_mutex);
+
+    /// Write the index changes of connecting (or, with fDisconnect, disconnecting) a block.
+    bool UpdateBlock(const CBlock& block, const CBlockIndex* pindex, bool fDisconnect);
+
+protected:
+    bool Init() override;
+
+    bool WriteBlock(const CBlock& block, const CBlockIndex* pindex) override;
+
+    bool Rewind(const CBlockIndex* current_tip, const CBlockIndex* new_tip) override;
+
+    BaseIndex::DB& GetDB() const override;
+
+    const char* GetName() const override { return "addressindex"; }
+
+public:
+    /// Constructs the index, which becomes available to be queried. The database is wiped
+    /// when the set of enabled indexes differs from the one it was built with.
+    AddressIndex(size_t n_cache_size, bool f_address_index, bool f_spent_index, bool f_timestamp_index,
+                 bool f_memory = false, bool f_wipe = false);
+
+    // Destructor is declared because this class contains a unique_ptr to an incomplete type.
+    virtual ~AddressIndex() override;
+
+    bool ReadSpentIndex(const CSpentIndexKey& key, CSpentIndexValue& value) const;
+    /// Read the spent index entries of several outputs through a single database iterator, the
+    /// entries found are added to info.
+    bool ReadSpentIndexes(const std::vector<CSpentIndexKey>& keys, CSpentIndexTxInfo& info) const;
+    bool ReadAddressUnspentIndex(const uint160& addressHash, AddressType type,
+                                 std::vector<std::pair<CAddressUnspentKey, CAddressUnspentValue>>& unspentOutputs) const;
+    /// Pass the entries of an address, in key order, to fn until it returns false. The scan
+    /// starts at the first entry at or after from if given, else at height start, and stops
+    /// after height end (when positive).
+    bool ScanAddressIndex(const uint160& addressHash, AddressType type, int start, int end, const CAddressIndexKey* from,
+                          const std::function<bool(const CAddressIndexKey&, CAmount)>& fn) const;
+    bool ReadAddressBalance(const uint160& addressHash, AddressType type, CAddressBalanceValue& value) const;
+    bool ReadTimestampIndex(unsigned int high, unsigned int low, std::vector<uint256>& hashes) const LOCKS_EXCLUDED(m_timestamp_mutex);
+};
+
+/// The global address, spent and timestamp index. May be null.
+extern std::unique_ptr<AddressIndex> g_address_index;
+
+#endif // BITCOIN_INDEX_ADDRESSINDEX_H
@@ -3,16 +3,22 @@
 // file COPYING or http://www.opensource.org/licenses/mit-license.php.
 
 #include <chainparams.h>
+#include <ctpl_stl.h>
 #include <index/base.h>
 #include <node/blockstorage.h>
 #include <node/ui_interface.h>
 #include <shutdown.h>
 #include <tinyformat.h>
+#include <util/system.h>
 #include <util/thread.h>
 #include <util/translation.h>
 #include <validation.h> // For g_chainman
 #include <warnings.h>
 
+#include <algorithm>
+#include <deque>
+#include <future>
+
 constexpr uint8_t DB_BEST_BLOCK{'B'};
 
 constexpr auto SYNC_LOG_INTERVAL{30s};
@@ -131,6 +137,28 @@ void BaseIndex::ThreadSync()
     if (!m_synced) {
         auto& consensus_params = Params().GetConsensus();
 
+        // Blocks are read (and prepared) ahead on a pool of reader threads, the sync thread
+        // consumes them in height order. Blocks queued for a chain we reorged away from are
+        // dropped, the pool's destructor waits for their reads to end.
+        struct ReadAhead {
+            const CBlockIndex* pindex;
+            std::future<std::shared_ptr<const CBlock>> block;
+        };
+        std::deque<ReadAhead> read_ahead;
+        const size_t read_ahead_max = size_t(m_sync_threads) * INDEX_SYNC_BLOCKS_PER_THREAD;
+        ctpl::thread_pool read_pool(m_sync_threads);
+        if (m_sync_threads > 0) {
+            RenameThreadPool(read_pool, "idxread");
+        }
+        const auto read_block = [this, &consensus_params](int, const CBlockIndex* pindex_read) -> std::shared_ptr<const CBlock> {
+            auto block = std::make_shared<CBlock>();
+            if (!ReadBlockFromDisk(*block, pindex_read, consensus_params)) {
+                return nullptr;
+            }
+            PrepareBlock(*block, pindex_read);
+            return block;
+        };
+
         std::chrono::steady_clock::time_point last_log_time{0s};
         std::chrono::steady_clock::time_point last_locator_write_time{0s};
         while (true) {
@@ -159,6 +187,15 @@ void BaseIndex::ThreadSync()
                     return;
                 }
                 pindex = pindex_next;
+
+                if (!read_ahead.empty() && read_ahead.front().pindex != pindex) {
+                    read_ahead.clear();
+                }
+                const CBlockIndex* pindex_queue = read_ahead.empty() ? pindex : m_chainstate->m_chain.Next(read_ahead.back().pindex);
+                while (pindex_queue && read_ahead.size() < read_ahead_max) {
+                    read_ahead.push_back({pindex_queue, read_pool.push(read_block, pindex_queue)});
+                    pindex_queue = m_chainstate->m_chain.Next(pindex_queue);
+                }
             }
 
             auto current_time{std::chrono::steady_clock::now()};
@@ -175,13 +212,19 @@ void BaseIndex::ThreadSync()
                 Commit();
             }
 
-            CBlock block;
-            if (!ReadBlockFromDisk(block, pindex, consensus_params)) {
+            std::shared_ptr<const CBlock> block;
+            if (!read_ahead.empty()) {
+                block = read_ahead.front().block.get();
+                read_ahead.pop_front();
+            } else {
+                block = read_block(0, pindex);
+            }
+            if (!block) {
                 FatalError("%s: Failed to read block %s from disk",
                            __func__, pindex->GetBlockHash().ToString());
                 return;
             }
-            if (!WriteBlock(block, pindex)) {
+            if (!WriteBlock(*block, pindex)) {
                 FatalError("%s: Failed to write block %s to index database",
                            __func__, pindex->GetBlockHash().ToString());
                 return;
@@ -351,9 +394,11 @@ bool BaseIndex::Start(CChainState& active_chainstate)
 {
     assert(std::addressof(::ChainstateActive()) == std::addressof(active_chainstate));
     m_chainstate = &active_chainstate;
+    m_sync_threads = std::clamp<int>(gArgs.GetArg("-indexsyncthreads", DEFAULT_INDEX_SYNC_THREADS), 0, MAX_INDEX_SYNC_THREADS);
     // Need to register this ValidationInterface before running Init(), so that
-    // callbacks are not missed if Init sets m_synced to true.
-    RegisterValidationInterface(this);
+    // callbacks are not missed if Init sets m_synced to true. Indexes get a queue of their own,
+    // so a slow wallet or another index doesn't hold them back.
+    RegisterValidationInterface(this, /*own_queue=*/true);
     if (!Init()) {
         return false;
     }
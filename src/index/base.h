@@ -16,6 +16,12 @@
 class CBlockIndex;
 class CChainState;
 
+/** Default number of threads reading (and preparing) blocks ahead of the index sync thread */
+static constexpr int DEFAULT_INDEX_SYNC_THREADS{4};
+static constexpr int MAX_INDEX_SYNC_THREADS{16};
+/** Blocks read ahead of the sync thread per reader thread */
+static constexpr int INDEX_SYNC_BLOCKS_PER_THREAD{8};
+
 struct IndexSummary {
     std::string name;
     bool synced{false};
@@ -66,6 +72,9 @@ private:
     std::thread m_thread_sync;
     CThreadInterrupt m_interrupt;
 
+    /// Number of threads reading blocks ahead of ThreadSync, 0 to read them on the sync thread.
+    int m_sync_threads{0};
+
     /// Sync the index with the block index starting from the current best block.
     /// Intended to be run in its own thread, m_thread_sync, and can be
     /// interrupted with m_interrupt. Once the index gets in sync, the m_synced
@@ -97,6 +106,12 @@ protected:
     /// Write update index entries for a newly connected block.
     virtual bool WriteBlock(const CBlock& block, const CBlockIndex* pindex) { return true; }
 
+    /// Called during the initial sync on a reader thread, possibly for several blocks at the
+    /// same time, after the block has been read and before it is passed to WriteBlock in height
+    /// order. Can be overridden to do the work that doesn't depend on the previous blocks being
+    /// indexed already. The block may never be written if the chain reorganizes meanwhile.
+    virtual void PrepareBlock(const CBlock& block, const CBlockIndex* pindex) {}
+
     /// Virtual method called internally by Commit that can be overridden to atomically
     /// commit more index state.
     virtual bool CommitInternal(CDBBatch& batch);
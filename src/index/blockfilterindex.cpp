@@ -3,6 +3,7 @@
 // file COPYING or http://www.opensource.org/licenses/mit-license.php.
 
 #include <map>
+#include <optional>
 
 #include <dbwrapper.h>
 #include <index/blockfilterindex.h>
@@ -212,13 +213,38 @@ size_t BlockFilterIndex::WriteFilterToDisk(FlatFilePos& pos, const BlockFilter&
     return data_size;
 }
 
+void BlockFilterIndex::PrepareBlock(const CBlock& block, const CBlockIndex* pindex)
+{
+    // Reading the undo data and building the filter don't depend on the previous filters, the
+    // header chain is left to WriteBlock
+    CBlockUndo block_undo;
+    if (pindex->nHeight > 0 && !UndoReadFromDisk(block_undo, pindex)) {
+        return;
+    }
+    BlockFilter filter(m_filter_type, block, block_undo);
+
+    LOCK(m_cs_prepared_filters);
+    m_prepared_filters.insert_or_assign(pindex->nHeight, std::move(filter));
+}
+
 bool BlockFilterIndex::WriteBlock(const CBlock& block, const CBlockIndex* pindex)
 {
+    std::optional<BlockFilter> prepared_filter;
+    {
+        LOCK(m_cs_prepared_filters);
+        auto it = m_prepared_filters.find(pindex->nHeight);
+        if (it != m_prepared_filters.end() && it->second.GetBlockHash() == pindex->GetBlockHash()) {
+            prepared_filter = std::move(it->second);
+        }
+        // Filters of lower heights belong to blocks which were reorged away from
+        m_prepared_filters.erase(m_prepared_filters.begin(), m_prepared_filters.upper_bound(pindex->nHeight));
+    }
+
     CBlockUndo block_undo;
     uint256 prev_header;
 
     if (pindex->nHeight > 0) {
-        if (!UndoReadFromDisk(block_undo, pindex)) {
+        if (!prepared_filter && !UndoReadFromDisk(block_undo, pindex)) {
             return false;
         }
 
@@ -236,7 +262,7 @@ bool BlockFilterIndex::WriteBlock(const CBlock& block, const CBlockIndex* pindex
         prev_header = read_out.second.header;
     }
 
-    BlockFilter filter(m_filter_type, block, block_undo);
+    const BlockFilter filter = prepared_filter ? std::move(*prepared_filter) : BlockFilter(m_filter_type, block, block_undo);
 
     size_t bytes_written = WriteFilterToDisk(m_next_filter_pos, filter);
     if (bytes_written == 0) return false;
@@ -12,6 +12,8 @@
 #include <index/base.h>
 #include <util/hasher.h>
 
+#include <map>
+
 /** Interval between compact filter checkpoints. See BIP 157. */
 static constexpr int CFCHECKPT_INTERVAL = 1000;
 
@@ -39,6 +41,10 @@ private:
     /** cache of block hash to filter header, to avoid disk access when responding to getcfcheckpt. */
     std::unordered_map<uint256, uint256, FilterHeaderHasher> m_headers_cache GUARDED_BY(m_cs_headers_cache);
 
+    Mutex m_cs_prepared_filters;
+    /** filters built by PrepareBlock during the initial sync and not written yet, by height */
+    std::map<int, BlockFilter> m_prepared_filters GUARDED_BY(m_cs_prepared_filters);
+
 protected:
     bool Init() override;
 
@@ -46,6 +52,8 @@ protected:
 
     bool WriteBlock(const CBlock& block, const CBlockIndex* pindex) override;
 
+    void PrepareBlock(const CBlock& block, const CBlockIndex* pindex) override;
+
     bool Rewind(const CBlockIndex* current_tip, const CBlockIndex* new_tip) override;
 
     BaseIndex::DB& GetDB() const LIFETIMEBOUND override { return *m_db; }
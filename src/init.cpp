@@ -18,6 +18,10 @@
 #include <chain.h>
 #include <chainparams.h>
 #include <context.h>
+#include <crypto/aes.h>
+#include <crypto/chacha20.h>
+#include <crypto/x11.h>
+#include <dbwrapper.h>
 #include <deploymentstatus.h>
 #include <node/coinstats.h>
 #include <fs.h>
@@ -27,6 +31,7 @@
 #include <interfaces/chain.h>
 #include <index/blockfilterindex.h>
 #include <index/coinstatsindex.h>
+#include <index/addressindex.h>
 #include <index/txindex.h>
 #include <interfaces/node.h>
 #include <key.h>
@@ -36,8 +41,13 @@
 #include <net_permissions.h>
 #include <net_processing.h>
 #include <netbase.h>
+#include <node/blockindexsnapshot.h>
 #include <node/blockstorage.h>
+#include <node/chainsnapshot.h>
 #include <node/context.h>
+#include <node/memoryusage.h>
+#include <node/speculativecheck.h>
+#include <node/txreconciliation.h>
 #include <node/ui_interface.h>
 #include <policy/feerate.h>
 #include <policy/fees.h>
@@ -56,6 +66,7 @@
 #include <torcontrol.h>
 #include <txdb.h>
 #include <txmempool.h>
+#include <unordered_lru_cache.h>
 #include <util/asmap.h>
 #include <util/error.h>
 #include <util/moneystr.h>
@@ -63,6 +74,7 @@
 #include <util/string.h>
 #include <util/system.h>
 #include <util/thread.h>
+#include <util/threadbudget.h>
 #include <util/threadnames.h>
 #include <util/translation.h>
 #include <validation.h>
@@ -98,6 +110,7 @@
 #include <llmq/quorums.h>
 #include <llmq/dkgsessionmgr.h>
 #include <llmq/options.h>
+#include <llmq/pendingbudget.h>
 #include <llmq/signing.h>
 #include <llmq/snapshot.h>
 #include <llmq/signing_shares.h>
@@ -114,6 +127,7 @@
 #include <vector>
 
 #include <bls/bls.h>
+#include <bls/bls_sigcache.h>
 
 #ifndef WIN32
 #include <attributes.h>
@@ -211,6 +225,9 @@ void Interrupt(NodeContext& node)
     if (g_txindex) {
         g_txindex->Interrupt();
     }
+    if (g_address_index) {
+        g_address_index->Interrupt();
+    }
     ForEachBlockFilterIndex([](BlockFilterIndex& index) { index.Interrupt(); });
     if (g_coin_stats_index) {
         g_coin_stats_index->Interrupt();
@@ -253,7 +270,7 @@ void PrepareShutdown(NodeContext& node)
     // * ProcessMessage locks cs_main and g_cs_orphans before indirectly calling ForEachNode which
     //   locks cs_vNodes.
     // * CConnman::Stop calls DeleteNode, which calls FinalizeNode, which locks cs_main and calls
-    //   EraseOrphansFor, which locks g_cs_orphans.
+    //   TxOrphanage::EraseForPeer under g_cs_orphans.
     //
     // Thus the implicit locking order requirement is: (1) cs_main, (2) g_cs_orphans, (3) cs_vNodes.
     if (node.connman) {
@@ -322,6 +339,10 @@ void PrepareShutdown(NodeContext& node)
         g_txindex->Stop();
         g_txindex.reset();
     }
+    if (g_address_index) {
+        g_address_index->Stop();
+        g_address_index.reset();
+    }
     if (g_coin_stats_index) {
         g_coin_stats_index->Stop();
         g_coin_stats_index.reset();
@@ -343,6 +364,9 @@ void PrepareShutdown(NodeContext& node)
                 chainstate->ResetCoinsViews();
             }
         }
+        if (pblocktree) {
+            node.chainman->m_blockman.WriteBlockIndexSnapshot(*pblocktree);
+        }
         pblocktree.reset();
         if (node.llmq_ctx) {
             node.llmq_ctx.reset();
@@ -372,6 +396,7 @@ void PrepareShutdown(NodeContext& node)
         delete pdsNotificationInterface;
         pdsNotificationInterface = nullptr;
     }
+    ResetChainSnapshot();
     if (fMasternodeMode) {
         UnregisterValidationInterface(activeMasternodeManager.get());
         activeMasternodeManager.reset();
@@ -426,6 +451,7 @@ void Shutdown(NodeContext& node)
 
     node.args = nullptr;
     LogPrintf("%s: done\n", __func__);
+    LogInstance().StopAsyncLogging();
 }
 
 /**
@@ -520,12 +546,18 @@ void SetupServerArgs(NodeContext& node)
     argsman.AddArg("-alertnotify=<cmd>", "Execute command when an alert is raised (%s in cmd is replaced by message)", ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
 #endif
     argsman.AddArg("-assumevalid=<hex>", strprintf("If this block is in the chain assume that it and its ancestors are valid and potentially skip their script verification (0 to verify all, default: %s, testnet: %s)", defaultChainParams->GetConsensus().defaultAssumeValid.GetHex(), testnetChainParams->GetConsensus().defaultAssumeValid.GetHex()), ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
+    argsman.AddArg("-blockindexsnapshot", strprintf("Write the block index to %s on shutdown and load it from there on the next start, rather than from the block index database (default: %u)", BLOCK_INDEX_SNAPSHOT_FILENAME, DEFAULT_BLOCK_INDEX_SNAPSHOT), ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
     argsman.AddArg("-blocksdir=<dir>", "Specify directory to hold blocks subdirectory for *.dat files (default: <datadir>)", ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
     argsman.AddArg("-fastprune", "Use smaller block files and lower minimum prune height for testing purposes", ArgsManager::ALLOW_ANY | ArgsManager::DEBUG_ONLY, OptionsCategory::DEBUG_TEST);
+#ifndef WIN32
+    argsman.AddArg("-blockmmap", strprintf("Read blocks from memory mappings of the block files no longer appended to, rather than through file reads (default: %u)", DEFAULT_BLOCK_MMAP), ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
+#endif
 #if HAVE_SYSTEM
     argsman.AddArg("-blocknotify=<cmd>", "Execute command when the best block changes (%s in cmd is replaced by block hash)", ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
 #endif
+    argsman.AddArg("-blockprecheckthreads=<n>", strprintf("Number of threads deserializing received blocks and checking their proof of work, merkle root and transactions before they are processed (0 to %d, 0 = check on the message handler thread, default: %d)", MAX_BLOCK_PRECHECK_THREADS, DEFAULT_BLOCK_PRECHECK_THREADS), ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
     argsman.AddArg("-blockreconstructionextratxn=<n>", strprintf("Extra transactions to keep in memory for compact block reconstructions (default: %u)", DEFAULT_BLOCK_RECONSTRUCTION_EXTRA_TXN), ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
+    argsman.AddArg("-blockreconstructionislocktxn=<n>", strprintf("InstantSend-locked transactions to keep in memory for compact block reconstructions, they are likely to be mined even when evicted from the mempool (default: %u)", DEFAULT_BLOCK_RECONSTRUCTION_ISLOCK_TXN), ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
     argsman.AddArg("-blocksonly", strprintf("Whether to reject transactions from network peers. Automatic broadcast and rebroadcast of any transactions from inbound peers is disabled, unless the peer has the 'forcerelay' permission. RPC transactions are not affected. (default: %u)", DEFAULT_BLOCKSONLY), ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
 #if HAVE_SYSTEM
     argsman.AddArg("-chainlocknotify=<cmd>", "Execute command when the best chainlock changes (%s in cmd is replaced by chainlocked block hash)", ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
@@ -535,11 +567,16 @@ void SetupServerArgs(NodeContext& node)
     argsman.AddArg("-datadir=<dir>", "Specify data directory", ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
     argsman.AddArg("-dbbatchsize", strprintf("Maximum database write batch size in bytes (default: %u)", nDefaultDbBatchSize), ArgsManager::ALLOW_ANY | ArgsManager::DEBUG_ONLY, OptionsCategory::OPTIONS);
     argsman.AddArg("-dbcache=<n>", strprintf("Maximum database cache size <n> MiB (%d to %d, default: %d). In addition, unused mempool memory is shared for this cache (see -maxmempool).", nMinDbCache, nMaxDbCache, nDefaultDbCache), ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
+    argsman.AddArg("-evodbbatchsize=<n>", strprintf("Maximum size of pending masternode and quorum database writes during initial block download in MiB, before they force a flush of the chainstate (default: %u)", DEFAULT_EVODB_BATCH_SIZE), ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
+    argsman.AddArg("-mnlistcachesize=<n>", strprintf("Maximum memory used for masternode lists kept in memory, in MiB (default: %u)", DEFAULT_MNLIST_CACHE_SIZE), ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
+    argsman.AddArg("-mnlistsnapshotinterval=<n>", strprintf("Store a full masternode list on disk every <n> blocks, lower values speed up lookups of old lists at the cost of disk space (default: %u)", DEFAULT_MNLIST_SNAPSHOT_INTERVAL), ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
     argsman.AddArg("-debuglogfile=<file>", strprintf("Specify location of debug log file. Relative paths will be prefixed by a net-specific datadir location. (-nodebuglogfile to disable; default: %s)", DEFAULT_DEBUGLOGFILE), ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
+    argsman.AddArg("-filteredblockthreads=<n>", strprintf("Number of threads building the filtered blocks of newly connected blocks for peers with a bloom filter before they request them (0 to %d, 0 = build on request, default: %d)", MAX_FILTERED_BLOCK_THREADS, DEFAULT_FILTERED_BLOCK_THREADS), ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
     argsman.AddArg("-includeconf=<file>", "Specify additional configuration file, relative to the -datadir path (only useable from configuration file, not command line)", ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
     argsman.AddArg("-loadblock=<file>", "Imports blocks from external file on startup", ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
     argsman.AddArg("-maxmempool=<n>", strprintf("Keep the transaction memory pool below <n> megabytes (default: %u)", DEFAULT_MAX_MEMPOOL_SIZE), ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
     argsman.AddArg("-maxorphantxsize=<n>", strprintf("Maximum total size of all orphan transactions in megabytes (default: %u)", DEFAULT_MAX_ORPHAN_TRANSACTIONS_SIZE), ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
+    argsman.AddArg("-llmq-pending-budget=<n>", strprintf("Memory in megabytes for received LLMQ messages waiting for verification. Reading from the peers queueing most is paused above it (default: %u)", llmq::DEFAULT_PENDING_MESSAGES_BUDGET), ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
     argsman.AddArg("-maxrecsigsage=<n>", strprintf("Number of seconds to keep LLMQ recovery sigs (default: %u)", llmq::DEFAULT_MAX_RECOVERED_SIGS_AGE), ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
     argsman.AddArg("-mempoolexpiry=<n>", strprintf("Do not keep transactions in the mempool longer than <n> hours (default: %u)", DEFAULT_MEMPOOL_EXPIRY), ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
     argsman.AddArg("-minimumchainwork=<hex>", strprintf("Minimum work assumed to exist on a valid chain in hex (default: %s, testnet: %s)", defaultChainParams->GetConsensus().nMinimumChainWork.GetHex(), testnetChainParams->GetConsensus().nMinimumChainWork.GetHex()), ArgsManager::ALLOW_ANY | ArgsManager::DEBUG_ONLY, OptionsCategory::OPTIONS);
@@ -550,7 +587,9 @@ void SetupServerArgs(NodeContext& node)
     argsman.AddArg("-prune=<n>", strprintf("Reduce storage requirements by enabling pruning (deleting) of old blocks. This allows the pruneblockchain RPC to be called to delete specific blocks, and enables automatic pruning of old blocks if a target size in MiB is provided. This mode is incompatible with -txindex, -coinstatsindex, -rescan and -disablegovernance=false. "
             "Warning: Reverting this setting requires re-downloading the entire blockchain. "
             "(default: 0 = disable pruning blocks, 1 = allow manual pruning via RPC, >%u = automatically prune block files to stay under the specified target size in MiB)", MIN_DISK_SPACE_FOR_BLOCK_FILES / 1024 / 1024), ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
+    argsman.AddArg("-schedulerthreads=<n>", strprintf("Set the number of threads running periodic tasks. With more than one, tasks of different kinds (validation notifications, network, LLMQ and maintenance tasks) run at the same time and slow maintenance tasks don't hold back the others (1 to %d, default: %d)", MAX_SCHEDULER_THREADS, DEFAULT_SCHEDULER_THREADS), ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
     argsman.AddArg("-settings=<file>", strprintf("Specify path to dynamic settings data file. Can be disabled with -nosettings. File is written at runtime and not meant to be edited by users (use %s instead for custom settings). Relative paths will be prefixed by datadir location. (default: %s)", BITCOIN_CONF_FILENAME, BITCOIN_SETTINGS_FILENAME), ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
+    argsman.AddArg("-speculativechecks", strprintf("Verify the scripts of received blocks which compete with the active tip on a background thread, so that a reorg to one of them is faster (default: %u)", DEFAULT_SPECULATIVE_CHECKS), ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
     argsman.AddArg("-syncmempool", strprintf("Sync mempool from other nodes on start (default: %u)", DEFAULT_SYNC_MEMPOOL), ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
 #if HAVE_SYSTEM
     argsman.AddArg("-startupnotify=<cmd>", "Execute command on startup.", ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
@@ -561,8 +600,10 @@ void SetupServerArgs(NodeContext& node)
     hidden_args.emplace_back("-sysperms");
 #endif
     argsman.AddArg("-version", "Print version and exit", ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
+    argsman.AddArg("-workerthreads=<n>", strprintf("Number of threads the worker pools are sized from: validation pools may use all of them, LLMQ pools half and background pools a quarter, unless set explicitly (0 = number of cores, default: %d)", DEFAULT_WORKER_THREADS), ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
 
     argsman.AddArg("-addressindex", strprintf("Maintain a full address index, used to query for the balance, txids and unspent outputs for addresses (default: %u)", DEFAULT_ADDRESSINDEX), ArgsManager::ALLOW_ANY, OptionsCategory::INDEXING);
+    argsman.AddArg("-indexsyncthreads=<n>", strprintf("Number of threads reading blocks ahead while an index catches up with the chain, 0 reads them on the index thread (0 to %d, default: %d)", MAX_INDEX_SYNC_THREADS, DEFAULT_INDEX_SYNC_THREADS), ArgsManager::ALLOW_ANY, OptionsCategory::INDEXING);
     argsman.AddArg("-reindex", "Rebuild chain state and block index from the blk*.dat files on disk", ArgsManager::ALLOW_ANY, OptionsCategory::INDEXING);
     argsman.AddArg("-reindex-chainstate", "Rebuild chain state from the currently indexed blocks. When in pruning mode or if blocks on disk might be corrupted, use full -reindex instead.", ArgsManager::ALLOW_ANY, OptionsCategory::INDEXING);
     argsman.AddArg("-spentindex", strprintf("Maintain a full spent index, used to query the spending txid and input index for an outpoint (default: %u)", DEFAULT_SPENTINDEX), ArgsManager::ALLOW_ANY, OptionsCategory::INDEXING);
@@ -592,10 +633,12 @@ void SetupServerArgs(NodeContext& node)
     argsman.AddArg("-maxsendbuffer=<n>", strprintf("Maximum per-connection send buffer, <n>*1000 bytes (default: %u)", DEFAULT_MAXSENDBUFFER), ArgsManager::ALLOW_ANY, OptionsCategory::CONNECTION);
     argsman.AddArg("-maxtimeadjustment", strprintf("Maximum allowed median peer time offset adjustment. Local perspective of time may be influenced by peers forward or backward by this amount. (default: %u seconds)", DEFAULT_MAX_TIME_ADJUSTMENT), ArgsManager::ALLOW_ANY, OptionsCategory::CONNECTION);
     argsman.AddArg("-maxuploadtarget=<n>", strprintf("Tries to keep outbound traffic under the given target (in MiB per 24h). Limit does not apply to peers with 'download' permission. 0 = no limit (default: %d)", DEFAULT_MAX_UPLOAD_TARGET), ArgsManager::ALLOW_ANY, OptionsCategory::CONNECTION);
+    argsman.AddArg("-messagehandlerthreads=<n>", strprintf("Number of threads processing peer messages. Every peer is handled by one of them; messages that don't need validation (LLMQ signature shares, sporks, MNAUTH) from different peers are processed in parallel (default: %u, maximum: %u)", DEFAULT_MESSAGE_HANDLER_THREADS, MAX_MESSAGE_HANDLER_THREADS), ArgsManager::ALLOW_ANY, OptionsCategory::CONNECTION);
     argsman.AddArg("-onion=<ip:port>", "Use separate SOCKS5 proxy to reach peers via Tor onion services, set -noonion to disable (default: -proxy)", ArgsManager::ALLOW_ANY, OptionsCategory::CONNECTION);
     argsman.AddArg("-i2psam=<ip:port>", "I2P SAM proxy to reach I2P peers and accept I2P connections (default: none)", ArgsManager::ALLOW_ANY, OptionsCategory::CONNECTION);
     argsman.AddArg("-i2pacceptincoming", "If set and -i2psam is also set then incoming I2P connections are accepted via the SAM proxy. If this is not set but -i2psam is set then only outgoing connections will be made to the I2P network. Ignored if -i2psam is not set. Listening for incoming I2P connections is done through the SAM proxy, not by binding to a local address and port (default: 1)", ArgsManager::ALLOW_BOOL, OptionsCategory::CONNECTION);
     argsman.AddArg("-onlynet=<net>", "Make outgoing connections only through network <net> (" + Join(GetNetworkNames(), ", ") + "). Incoming connections are not affected by this option. This option can be specified multiple times to allow multiple networks. Warning: if it is used with non-onion networks and the -onion or -proxy option is set, then outbound onion connections will still be made; use -noonion or -onion=0 to disable outbound onion connections in this case.", ArgsManager::ALLOW_ANY, OptionsCategory::CONNECTION);
+    argsman.AddArg("-packagerelay", strprintf("Fetch the unconfirmed ancestors of orphan transactions as one package from peers that support it and accept them to the mempool together, evaluating the fee rate of the whole package (default: %u)", DEFAULT_PACKAGE_RELAY), ArgsManager::ALLOW_ANY, OptionsCategory::CONNECTION);
     argsman.AddArg("-peerblockfilters", strprintf("Serve compact block filters to peers per BIP 157 (default: %u)", DEFAULT_PEERBLOCKFILTERS), ArgsManager::ALLOW_ANY, OptionsCategory::CONNECTION);
     argsman.AddArg("-peerbloomfilters", strprintf("Support filtering of blocks and transaction with bloom filters (default: %u)", DEFAULT_PEERBLOOMFILTERS), ArgsManager::ALLOW_ANY, OptionsCategory::CONNECTION);
     argsman.AddArg("-peertimeout=<n>", strprintf("Specify a p2p connection timeout delay in seconds. After connecting to a peer, wait this amount of time before considering disconnection based on inactivity (minimum: 1, default: %d)", DEFAULT_PEER_CONNECT_TIMEOUT), ArgsManager::ALLOW_ANY, OptionsCategory::CONNECTION);
@@ -605,9 +648,11 @@ void SetupServerArgs(NodeContext& node)
     argsman.AddArg("-proxyrandomize", strprintf("Randomize credentials for every proxy connection. This enables Tor stream isolation (default: %u)", DEFAULT_PROXYRANDOMIZE), ArgsManager::ALLOW_ANY, OptionsCategory::CONNECTION);
     argsman.AddArg("-seednode=<ip>", "Connect to a node to retrieve peer addresses, and disconnect. This option can be specified multiple times to connect to multiple nodes.", ArgsManager::ALLOW_ANY, OptionsCategory::CONNECTION);
     argsman.AddArg("-socketevents=<mode>", "Socket events mode, which must be one of 'select', 'poll', 'epoll' or 'kqueue', depending on your system (default: Linux - 'epoll', FreeBSD/Apple - 'kqueue', Windows - 'select')", ArgsManager::ALLOW_ANY, OptionsCategory::CONNECTION);
+    argsman.AddArg("-socketthreads=<n>", strprintf("Number of threads servicing peer sockets, each with its own event queue. Only used with -socketevents=epoll or kqueue (default: %u, maximum: %u)", DEFAULT_SOCKET_THREADS, MAX_SOCKET_THREADS), ArgsManager::ALLOW_ANY, OptionsCategory::CONNECTION);
     argsman.AddArg("-timeout=<n>", strprintf("Specify socket connection timeout in milliseconds. If an initial attempt to connect is unsuccessful after this amount of time, drop it (minimum: 1, default: %d)", DEFAULT_CONNECT_TIMEOUT), ArgsManager::ALLOW_ANY, OptionsCategory::CONNECTION);
     argsman.AddArg("-torcontrol=<ip>:<port>", strprintf("Tor control port to use if onion listening enabled (default: %s)", DEFAULT_TOR_CONTROL), ArgsManager::ALLOW_ANY, OptionsCategory::CONNECTION);
     argsman.AddArg("-torpassword=<pass>", "Tor control port password (default: empty)", ArgsManager::ALLOW_ANY | ArgsManager::SENSITIVE, OptionsCategory::CONNECTION);
+    argsman.AddArg("-txreconciliation", strprintf("Enable short id based transaction reconciliation with peers that support it, instead of flooding transaction announcements to them (default: %d)", DEFAULT_TXRECONCILIATION_ENABLE), ArgsManager::ALLOW_ANY, OptionsCategory::CONNECTION);
 #ifdef USE_UPNP
 #if USE_UPNP
     argsman.AddArg("-upnp", "Use UPnP to map the listening port (default: 1 when listening and no -proxy)", ArgsManager::ALLOW_ANY, OptionsCategory::CONNECTION);
@@ -640,6 +685,7 @@ void SetupServerArgs(NodeContext& node)
     argsman.AddArg("-zmqpubhashinstantsenddoublespend=<address>", "Enable publish transaction hashes of attempted InstantSend double spend in <address>", ArgsManager::ALLOW_ANY, OptionsCategory::ZMQ);
     argsman.AddArg("-zmqpubhashrecoveredsig=<address>", "Enable publish message hash of recovered signatures (recovered by LLMQs) in <address>", ArgsManager::ALLOW_ANY, OptionsCategory::ZMQ);
     argsman.AddArg("-zmqpubhashtx=<address>", "Enable publish hash transaction in <address>", ArgsManager::ALLOW_ANY, OptionsCategory::ZMQ);
+    argsman.AddArg("-zmqpubhashtxbatch=<address>", "Enable publish hash transaction in <address>, batched into frames (see -zmqbatchsize and -zmqbatchinterval)", ArgsManager::ALLOW_ANY, OptionsCategory::ZMQ);
     argsman.AddArg("-zmqpubhashtxlock=<address>", "Enable publish hash transaction (locked via InstantSend) in <address>", ArgsManager::ALLOW_ANY, OptionsCategory::ZMQ);
     argsman.AddArg("-zmqpubrawblock=<address>", "Enable publish raw block in <address>", ArgsManager::ALLOW_ANY, OptionsCategory::ZMQ);
     argsman.AddArg("-zmqpubrawchainlock=<address>", "Enable publish raw block (locked via ChainLocks) in <address>", ArgsManager::ALLOW_ANY, OptionsCategory::ZMQ);
@@ -648,8 +694,11 @@ void SetupServerArgs(NodeContext& node)
     argsman.AddArg("-zmqpubrawgovernanceobject=<address>", "Enable publish raw governance votes in <address>", ArgsManager::ALLOW_ANY, OptionsCategory::ZMQ);
     argsman.AddArg("-zmqpubrawinstantsenddoublespend=<address>", "Enable publish raw transactions of attempted InstantSend double spend in <address>", ArgsManager::ALLOW_ANY, OptionsCategory::ZMQ);
     argsman.AddArg("-zmqpubrawrecoveredsig=<address>", "Enable publish raw recovered signatures (recovered by LLMQs) in <address>", ArgsManager::ALLOW_ANY, OptionsCategory::ZMQ);
+    argsman.AddArg("-zmqpubrawrecoveredsigbatch=<address>", "Enable publish raw recovered signatures in <address>, batched into frames", ArgsManager::ALLOW_ANY, OptionsCategory::ZMQ);
     argsman.AddArg("-zmqpubrawtx=<address>", "Enable publish raw transaction in <address>", ArgsManager::ALLOW_ANY, OptionsCategory::ZMQ);
+    argsman.AddArg("-zmqpubrawtxbatch=<address>", "Enable publish raw transaction in <address>, batched into frames", ArgsManager::ALLOW_ANY, OptionsCategory::ZMQ);
     argsman.AddArg("-zmqpubrawtxlock=<address>", "Enable publish raw transaction (locked via InstantSend) in <address>", ArgsManager::ALLOW_ANY, OptionsCategory::ZMQ);
+    argsman.AddArg("-zmqpubrawtxlockbatch=<address>", "Enable publish raw transaction (locked via InstantSend) in <address>, batched into frames", ArgsManager::ALLOW_ANY, OptionsCategory::ZMQ);
     argsman.AddArg("-zmqpubrawtxlocksig=<address>", "Enable publish raw transaction (locked via InstantSend) and ISLOCK in <address>", ArgsManager::ALLOW_ANY, OptionsCategory::ZMQ);
     argsman.AddArg("-zmqpubhashblockhwm=<n>", strprintf("Set publish hash block outbound message high water mark (default: %d)", CZMQAbstractNotifier::DEFAULT_ZMQ_SNDHWM), ArgsManager::ALLOW_ANY, OptionsCategory::ZMQ);
     argsman.AddArg("-zmqpubhashchainlockhwm=<n>", strprintf("Set publish hash chain lock outbound message high water mark (default: %d)", CZMQAbstractNotifier::DEFAULT_ZMQ_SNDHWM), ArgsManager::ALLOW_ANY, OptionsCategory::ZMQ);
@@ -658,6 +707,7 @@ void SetupServerArgs(NodeContext& node)
     argsman.AddArg("-zmqpubhashinstantsenddoublespendhwm=<n>", strprintf("Set publish hash InstantSend double spend outbound message high water mark (default: %d)", CZMQAbstractNotifier::DEFAULT_ZMQ_SNDHWM), ArgsManager::ALLOW_ANY, OptionsCategory::ZMQ);
     argsman.AddArg("-zmqpubhashrecoveredsighwm=<n>", strprintf("Set publish hash recovered signature outbound message high water mark (default: %d)", CZMQAbstractNotifier::DEFAULT_ZMQ_SNDHWM), ArgsManager::ALLOW_ANY, OptionsCategory::ZMQ);
     argsman.AddArg("-zmqpubhashtxhwm=<n>", strprintf("Set publish hash transaction outbound message high water mark (default: %d)", CZMQAbstractNotifier::DEFAULT_ZMQ_SNDHWM), ArgsManager::ALLOW_ANY, OptionsCategory::ZMQ);
+    argsman.AddArg("-zmqpubhashtxbatchhwm=<n>", strprintf("Set publish batched hash transaction outbound message high water mark (default: %d)", CZMQAbstractNotifier::DEFAULT_ZMQ_SNDHWM), ArgsManager::ALLOW_ANY, OptionsCategory::ZMQ);
     argsman.AddArg("-zmqpubhashtxlockhwm=<n>", strprintf("Set publish hash transaction lock outbound message high water mark (default: %d)", CZMQAbstractNotifier::DEFAULT_ZMQ_SNDHWM), ArgsManager::ALLOW_ANY, OptionsCategory::ZMQ);
     argsman.AddArg("-zmqpubrawblockhwm=<n>", strprintf("Set publish raw block outbound message high water mark (default: %d)", CZMQAbstractNotifier::DEFAULT_ZMQ_SNDHWM), ArgsManager::ALLOW_ANY, OptionsCategory::ZMQ);
     argsman.AddArg("-zmqpubrawchainlockhwm=<n>", strprintf("Set publish raw chain lock outbound message high water mark (default: %d)", CZMQAbstractNotifier::DEFAULT_ZMQ_SNDHWM), ArgsManager::ALLOW_ANY, OptionsCategory::ZMQ);
@@ -666,9 +716,15 @@ void SetupServerArgs(NodeContext& node)
     argsman.AddArg("-zmqpubrawgovernancevotehwm=<n>", strprintf("Set publish raw governance vote outbound message high water mark (default: %d)", CZMQAbstractNotifier::DEFAULT_ZMQ_SNDHWM), ArgsManager::ALLOW_ANY, OptionsCategory::ZMQ);
     argsman.AddArg("-zmqpubrawinstantsenddoublespendhwm=<n>", strprintf("Set publish raw InstantSend double spend outbound message high water mark (default: %d)", CZMQAbstractNotifier::DEFAULT_ZMQ_SNDHWM), ArgsManager::ALLOW_ANY, OptionsCategory::ZMQ);
     argsman.AddArg("-zmqpubrawrecoveredsighwm=<n>", strprintf("Set publish raw recovered signature outbound message high water mark (default: %d)", CZMQAbstractNotifier::DEFAULT_ZMQ_SNDHWM), ArgsManager::ALLOW_ANY, OptionsCategory::ZMQ);
+    argsman.AddArg("-zmqpubrawrecoveredsigbatchhwm=<n>", strprintf("Set publish batched raw recovered signature outbound message high water mark (default: %d)", CZMQAbstractNotifier::DEFAULT_ZMQ_SNDHWM), ArgsManager::ALLOW_ANY, OptionsCategory::ZMQ);
     argsman.AddArg("-zmqpubrawtxhwm=<n>", strprintf("Set publish raw transaction outbound message high water mark (default: %d)", CZMQAbstractNotifier::DEFAULT_ZMQ_SNDHWM), ArgsManager::ALLOW_ANY, OptionsCategory::ZMQ);
+    argsman.AddArg("-zmqpubrawtxbatchhwm=<n>", strprintf("Set publish batched raw transaction outbound message high water mark (default: %d)", CZMQAbstractNotifier::DEFAULT_ZMQ_SNDHWM), ArgsManager::ALLOW_ANY, OptionsCategory::ZMQ);
     argsman.AddArg("-zmqpubrawtxlockhwm=<n>", strprintf("Set publish raw transaction lock outbound message high water mark (default: %d)", CZMQAbstractNotifier::DEFAULT_ZMQ_SNDHWM), ArgsManager::ALLOW_ANY, OptionsCategory::ZMQ);
+    argsman.AddArg("-zmqpubrawtxlockbatchhwm=<n>", strprintf("Set publish batched raw transaction lock outbound message high water mark (default: %d)", CZMQAbstractNotifier::DEFAULT_ZMQ_SNDHWM), ArgsManager::ALLOW_ANY, OptionsCategory::ZMQ);
     argsman.AddArg("-zmqpubrawtxlocksighwm=<n>", strprintf("Set publish raw transaction lock signature outbound message high water mark (default: %d)", CZMQAbstractNotifier::DEFAULT_ZMQ_SNDHWM), ArgsManager::ALLOW_ANY, OptionsCategory::ZMQ);
+    argsman.AddArg("-zmqbatchinterval=<n>", strprintf("Send a batched frame at most <n> milliseconds after its first event (default: %d)", CZMQAbstractNotifier::DEFAULT_ZMQ_BATCH_INTERVAL), ArgsManager::ALLOW_ANY, OptionsCategory::ZMQ);
+    argsman.AddArg("-zmqbatchsize=<n>", strprintf("Send a batched frame once it holds at least <n> bytes (default: %u)", CZMQAbstractNotifier::DEFAULT_ZMQ_BATCH_SIZE), ArgsManager::ALLOW_ANY, OptionsCategory::ZMQ);
+    argsman.AddArg("-zmqqueuesize=<n>", strprintf("Maximum number of notifications waiting to be published; newer ones are dropped while the queue is full (default: %u)", CZMQNotificationInterface::DEFAULT_ZMQ_QUEUE_SIZE), ArgsManager::ALLOW_ANY, OptionsCategory::ZMQ);
 #else
     hidden_args.emplace_back("-zmqpubhashblock=<address>");
     hidden_args.emplace_back("-zmqpubhashchainlock=<address>");
@@ -677,6 +733,7 @@ void SetupServerArgs(NodeContext& node)
     hidden_args.emplace_back("-zmqpubhashinstantsenddoublespend=<address>");
     hidden_args.emplace_back("-zmqpubhashrecoveredsig=<address>");
     hidden_args.emplace_back("-zmqpubhashtx=<address>");
+    hidden_args.emplace_back("-zmqpubhashtxbatch=<address>");
     hidden_args.emplace_back("-zmqpubhashtxlock=<address>");
     hidden_args.emplace_back("-zmqpubrawblock=<address>");
     hidden_args.emplace_back("-zmqpubrawchainlock=<address>");
@@ -685,8 +742,11 @@ void SetupServerArgs(NodeContext& node)
     hidden_args.emplace_back("-zmqpubrawgovernanceobject=<address>");
     hidden_args.emplace_back("-zmqpubrawinstantsenddoublespend=<address>");
     hidden_args.emplace_back("-zmqpubrawrecoveredsig=<address>");
+    hidden_args.emplace_back("-zmqpubrawrecoveredsigbatch=<address>");
     hidden_args.emplace_back("-zmqpubrawtx=<address>");
+    hidden_args.emplace_back("-zmqpubrawtxbatch=<address>");
     hidden_args.emplace_back("-zmqpubrawtxlock=<address>");
+    hidden_args.emplace_back("-zmqpubrawtxlockbatch=<address>");
     hidden_args.emplace_back("-zmqpubrawtxlocksig=<address>");
     hidden_args.emplace_back("-zmqpubhashblockhwm=<n>");
     hidden_args.emplace_back("-zmqpubhashchainlockhwm=<n>");
@@ -695,6 +755,7 @@ void SetupServerArgs(NodeContext& node)
     hidden_args.emplace_back("-zmqpubhashinstantsenddoublespendhwm=<n>");
     hidden_args.emplace_back("-zmqpubhashrecoveredsighwm=<n>");
     hidden_args.emplace_back("-zmqpubhashtxhwm=<n>");
+    hidden_args.emplace_back("-zmqpubhashtxbatchhwm=<n>");
     hidden_args.emplace_back("-zmqpubhashtxlockhwm=<n>");
     hidden_args.emplace_back("-zmqpubrawblockhwm=<n>");
     hidden_args.emplace_back("-zmqpubrawchainlockhwm=<n>");
@@ -703,9 +764,15 @@ void SetupServerArgs(NodeContext& node)
     hidden_args.emplace_back("-zmqpubrawgovernancevotehwm=<n>");
     hidden_args.emplace_back("-zmqpubrawinstantsenddoublespendhwm=<n>");
     hidden_args.emplace_back("-zmqpubrawrecoveredsighwm=<n>");
+    hidden_args.emplace_back("-zmqpubrawrecoveredsigbatchhwm=<n>");
     hidden_args.emplace_back("-zmqpubrawtxhwm=<n>");
+    hidden_args.emplace_back("-zmqpubrawtxbatchhwm=<n>");
     hidden_args.emplace_back("-zmqpubrawtxlockhwm=<n>");
+    hidden_args.emplace_back("-zmqpubrawtxlockbatchhwm=<n>");
     hidden_args.emplace_back("-zmqpubrawtxlocksighwm=<n>");
+    hidden_args.emplace_back("-zmqbatchinterval=<n>");
+    hidden_args.emplace_back("-zmqbatchsize=<n>");
+    hidden_args.emplace_back("-zmqqueuesize=<n>");
 #endif
 
     argsman.AddArg("-checkblockindex", strprintf("Do a consistency check for the block tree, and  occasionally. (default: %u, regtest: %u)", defaultChainParams->DefaultConsistencyChecks(), regtestChainParams->DefaultConsistencyChecks()), ArgsManager::ALLOW_ANY | ArgsManager::DEBUG_ONLY, OptionsCategory::DEBUG_TEST);
@@ -718,6 +785,7 @@ void SetupServerArgs(NodeContext& node)
     argsman.AddArg("-limitancestorsize=<n>", strprintf("Do not accept transactions whose size with all in-mempool ancestors exceeds <n> kilobytes (default: %u)", DEFAULT_ANCESTOR_SIZE_LIMIT), ArgsManager::ALLOW_ANY | ArgsManager::DEBUG_ONLY, OptionsCategory::DEBUG_TEST);
     argsman.AddArg("-limitdescendantcount=<n>", strprintf("Do not accept transactions if any ancestor would have <n> or more in-mempool descendants (default: %u)", DEFAULT_DESCENDANT_LIMIT), ArgsManager::ALLOW_ANY | ArgsManager::DEBUG_ONLY, OptionsCategory::DEBUG_TEST);
     argsman.AddArg("-limitdescendantsize=<n>", strprintf("Do not accept transactions if any ancestor would have more than <n> kilobytes of in-mempool descendants (default: %u).", DEFAULT_DESCENDANT_SIZE_LIMIT), ArgsManager::ALLOW_ANY | ArgsManager::DEBUG_ONLY, OptionsCategory::DEBUG_TEST);
+    argsman.AddArg("-lockstats", strprintf("Profile lock contention per lock and call site, see getlockstats (default: %u)", DEFAULT_LOCKSTATS), ArgsManager::ALLOW_ANY | ArgsManager::DEBUG_ONLY, OptionsCategory::DEBUG_TEST);
     argsman.AddArg("-stopafterblockimport", strprintf("Stop running after importing blocks from disk (default: %u)", DEFAULT_STOPAFTERBLOCKIMPORT), ArgsManager::ALLOW_ANY | ArgsManager::DEBUG_ONLY, OptionsCategory::DEBUG_TEST);
     argsman.AddArg("-stopatheight", strprintf("Stop running after reaching the given height in the main chain (default: %u)", DEFAULT_STOPATHEIGHT), ArgsManager::ALLOW_ANY | ArgsManager::DEBUG_ONLY, OptionsCategory::DEBUG_TEST);
     argsman.AddArg("-watchquorums=<n>", strprintf("Watch and validate quorum communication (default: %u)", llmq::DEFAULT_WATCH_QUORUMS), ArgsManager::ALLOW_ANY | ArgsManager::DEBUG_ONLY, OptionsCategory::DEBUG_TEST);
@@ -727,6 +795,7 @@ void SetupServerArgs(NodeContext& node)
         "If <category> is not supplied or if <category> = 1, output all debugging information. <category> can be: " + LogInstance().LogCategoriesString() + ". This option can be specified multiple times to output multiple categories.", ArgsManager::ALLOW_ANY, OptionsCategory::DEBUG_TEST);
     argsman.AddArg("-debugexclude=<category>", strprintf("Exclude debugging information for a category. Can be used in conjunction with -debug=1 to output debug logs for all categories except the specified category. This option can be specified multiple times to exclude multiple categories."), ArgsManager::ALLOW_ANY, OptionsCategory::DEBUG_TEST);
     argsman.AddArg("-disablegovernance", strprintf("Disable governance validation (0-1, default: %u)", 0), ArgsManager::ALLOW_ANY, OptionsCategory::DEBUG_TEST);
+    argsman.AddArg("-logasync=<n>", strprintf("Write debug output from a background thread, queueing up to <n> lines. Lines are dropped while the queue is full, 0 writes them on the logging thread (default: %u)", DEFAULT_LOGASYNC), ArgsManager::ALLOW_ANY, OptionsCategory::DEBUG_TEST);
     argsman.AddArg("-logips", strprintf("Include IP addresses in debug output (default: %u)", DEFAULT_LOGIPS), ArgsManager::ALLOW_ANY, OptionsCategory::DEBUG_TEST);
     argsman.AddArg("-logtimemicros", strprintf("Add microsecond precision to debug timestamps (default: %u)", DEFAULT_LOGTIMEMICROS), ArgsManager::ALLOW_ANY | ArgsManager::DEBUG_ONLY, OptionsCategory::DEBUG_TEST);
 #ifdef HAVE_THREAD_LOCAL
@@ -735,6 +804,7 @@ void SetupServerArgs(NodeContext& node)
     hidden_args.emplace_back("-logthreadnames");
 #endif
     argsman.AddArg("-logthreadnames", strprintf("Prepend debug output with name of the originating thread (only available on platforms supporting thread_local) (default: %u)", DEFAULT_LOGTHREADNAMES), ArgsManager::ALLOW_ANY | ArgsManager::DEBUG_ONLY, OptionsCategory::DEBUG_TEST);
+    argsman.AddArg("-blssigcachesize=<n>", strprintf("Limit the BLS signature cache to <n> MiB (default: %u)", DEFAULT_BLS_SIG_CACHE_SIZE), ArgsManager::ALLOW_ANY | ArgsManager::DEBUG_ONLY, OptionsCategory::DEBUG_TEST);
     argsman.AddArg("-maxsigcachesize=<n>", strprintf("Limit sum of signature cache and script execution cache sizes to <n> MiB (default: %u)", DEFAULT_MAX_SIG_CACHE_SIZE), ArgsManager::ALLOW_ANY | ArgsManager::DEBUG_ONLY, OptionsCategory::DEBUG_TEST);
     argsman.AddArg("-maxtipage=<n>", strprintf("Maximum tip age in seconds to consider node in initial block download (default: %u)", DEFAULT_MAX_TIP_AGE), ArgsManager::ALLOW_ANY | ArgsManager::DEBUG_ONLY, OptionsCategory::DEBUG_TEST);
     argsman.AddArg("-mocktime=<n>", "Replace actual time with " + UNIX_EPOCH_TIME + "(default: 0)", ArgsManager::ALLOW_ANY | ArgsManager::DEBUG_ONLY, OptionsCategory::DEBUG_TEST);
@@ -750,6 +820,7 @@ void SetupServerArgs(NodeContext& node)
     SetupChainParamsBaseOptions(argsman);
 
     argsman.AddArg("-llmq-data-recovery=<n>", strprintf("Enable automated quorum data recovery (default: %u)", llmq::DEFAULT_ENABLE_QUORUM_DATA_RECOVERY), ArgsManager::ALLOW_ANY, OptionsCategory::MASTERNODE);
+    argsman.AddArg("-llmq-data-recovery-parallel=<n>", strprintf("Number of quorum members asked at the same time during quorum data recovery, 1 asks one member after the other (default: %u, maximum: %u)", llmq::DEFAULT_QUORUM_DATA_RECOVERY_PARALLEL, llmq::MAX_QUORUM_DATA_RECOVERY_PARALLEL), ArgsManager::ALLOW_ANY, OptionsCategory::MASTERNODE);
     argsman.AddArg("-llmq-qvvec-sync=<quorum_name>:<mode>", strprintf("Defines from which LLMQ type the masternode should sync quorum verification vectors. Can be used multiple times with different LLMQ types. <mode>: %d (sync always from all quorums of the type defined by <quorum_name>), %d (sync from all quorums of the type defined by <quorum_name> if a member of any of the quorums)", (int32_t)llmq::QvvecSyncMode::Always, (int32_t)llmq::QvvecSyncMode::OnlyIfTypeMember), ArgsManager::ALLOW_ANY, OptionsCategory::MASTERNODE);
     argsman.AddArg("-masternodeblsprivkey=<hex>", "Set the masternode BLS private key and enable the client to act as a masternode", ArgsManager::ALLOW_ANY | ArgsManager::SENSITIVE, OptionsCategory::MASTERNODE);
     argsman.AddArg("-platform-user=<user>", "Set the username for the \"platform user\", a restricted user intended to be used by Maximus Platform, to the specified username.", ArgsManager::ALLOW_ANY, OptionsCategory::MASTERNODE);
@@ -772,6 +843,7 @@ void SetupServerArgs(NodeContext& node)
     argsman.AddArg("-rest", strprintf("Accept public REST requests (default: %u)", DEFAULT_REST_ENABLE), ArgsManager::ALLOW_ANY, OptionsCategory::RPC);
     argsman.AddArg("-rpcallowip=<ip>", "Allow JSON-RPC connections from specified source. Valid for <ip> are a single IP (e.g. 1.2.3.4), a network/netmask (e.g. 1.2.3.4/255.255.255.0) or a network/CIDR (e.g. 1.2.3.4/24). This option can be specified multiple times", ArgsManager::ALLOW_ANY, OptionsCategory::RPC);
     argsman.AddArg("-rpcauth=<userpw>", "Username and HMAC-SHA-256 hashed password for JSON-RPC connections. The field <userpw> comes in the format: <USERNAME>:<SALT>$<HASH>. A canonical python script is included in share/rpcuser. The client then connects normally using the rpcuser=<USERNAME>/rpcpassword=<PASSWORD> pair of arguments. This option can be specified multiple times", ArgsManager::ALLOW_ANY | ArgsManager::SENSITIVE, OptionsCategory::RPC);
+    argsman.AddArg("-rpcbatchthreads=<n>", strprintf("Number of threads executing the read-only calls of JSON-RPC batch requests concurrently (0 to %d, 0 = execute them one after another, default: %d)", MAX_RPC_BATCH_THREADS, DEFAULT_RPC_BATCH_THREADS), ArgsManager::ALLOW_ANY, OptionsCategory::RPC);
     argsman.AddArg("-rpcbind=<addr>[:port]", "Bind to given address to listen for JSON-RPC connections. Do not expose the RPC server to untrusted networks such as the public internet! This option is ignored unless -rpcallowip is also passed. Port is optional and overrides -rpcport. Use [host]:port notation for IPv6. This option can be specified multiple times (default: 127.0.0.1 and ::1 i.e., localhost, or if -rpcallowip has been specified, 0.0.0.0 and :: i.e., all addresses)", ArgsManager::ALLOW_ANY | ArgsManager::NETWORK_ONLY | ArgsManager::SENSITIVE, OptionsCategory::RPC);
     argsman.AddArg("-rpccookiefile=<loc>", "Location of the auth cookie. Relative paths will be prefixed by a net-specific datadir location. (default: data dir)", ArgsManager::ALLOW_ANY, OptionsCategory::RPC);
     argsman.AddArg("-rpcpassword=<pw>", "Password for JSON-RPC connections", ArgsManager::ALLOW_ANY | ArgsManager::SENSITIVE, OptionsCategory::RPC);
@@ -789,6 +861,7 @@ void SetupServerArgs(NodeContext& node)
     argsman.AddArg("-statshostname=<ip>", strprintf("Specify statsd host name (default: %s)", DEFAULT_STATSD_HOSTNAME), ArgsManager::ALLOW_ANY, OptionsCategory::STATSD);
     argsman.AddArg("-statsport=<port>", strprintf("Specify statsd port (default: %u)", DEFAULT_STATSD_PORT), ArgsManager::ALLOW_ANY, OptionsCategory::STATSD);
     argsman.AddArg("-statsns=<ns>", strprintf("Specify additional namespace prefix (default: %s)", DEFAULT_STATSD_NAMESPACE), ArgsManager::ALLOW_ANY, OptionsCategory::STATSD);
+    argsman.AddArg("-metrics", strprintf("Serve the internal stats in the Prometheus text format at /metrics on the RPC port, using the RPC credentials. Works without -statsenabled (default: %u)", DEFAULT_METRICS_ENABLE), ArgsManager::ALLOW_ANY, OptionsCategory::STATSD);
     argsman.AddArg("-statsperiod=<seconds>", strprintf("Specify the number of seconds between periodic measurements (default: %d)", DEFAULT_STATSD_PERIOD), ArgsManager::ALLOW_ANY, OptionsCategory::STATSD);
 #if HAVE_DECL_DAEMON
     argsman.AddArg("-daemon", "Run in the background as a daemon and accept commands", ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
@@ -886,15 +959,28 @@ static void StartupNotify(const ArgsManager& args)
 }
 #endif
 
-static void PeriodicStats(ArgsManager& args, const CTxMemPool& mempool)
+static void PeriodicStats(ArgsManager& args, const NodeContext& node, const CTxMemPool& mempool, const LLMQContext& llmq_ctx, const CScheduler& scheduler)
 {
-    assert(args.GetBoolArg("-statsenabled", DEFAULT_STATSD_ENABLE));
+    assert(args.GetBoolArg("-statsenabled", DEFAULT_STATSD_ENABLE) || statsClient.metricsEnabled());
     CCoinsStats stats{CoinStatsHashType::NONE};
-    ::ChainstateActive().ForceFlushStateToDisk();
-    if (WITH_LOCK(cs_main, return GetUTXOStats(&::ChainstateActive().CoinsDB(), std::ref(g_chainman.m_blockman), stats, RpcInterruptionPoint, ::ChainActive().Tip()))) {
-        statsClient.gauge("utxoset.tx", stats.nTransactions, 1.0f);
+    CCoinsViewDB* coins_db{WITH_LOCK(cs_main, return &::ChainstateActive().CoinsDB())};
+    const CBlockIndex* pindex_stats{nullptr};
+    if (g_coin_stats_index) {
+        // The index has the statistics of every block, report those of the last block it indexed
+        // instead of flushing and scanning the chainstate
+        const int index_height{g_coin_stats_index->GetSummary().best_block_height};
+        pindex_stats = WITH_LOCK(cs_main, return ::ChainActive()[index_height]);
+    } else {
+        // The scan reads a snapshot of the coins database, so cs_main is not held while it runs
+        ::ChainstateActive().ForceFlushStateToDisk();
+    }
+    if ((!g_coin_stats_index || pindex_stats) && GetUTXOStats(coins_db, g_chainman.m_blockman, stats, RpcInterruptionPoint, pindex_stats)) {
+        if (!stats.index_used) {
+            // The index doesn't count transactions
+            statsClient.gauge("utxoset.tx", stats.nTransactions, 1.0f);
+        }
         statsClient.gauge("utxoset.txOutputs", stats.nTransactionOutputs, 1.0f);
-        statsClient.gauge("utxoset.dbSizeBytes", stats.nDiskSize, 1.0f);
+        statsClient.gauge("utxoset.dbSizeBytes", stats.index_used ? coins_db->EstimateSize() : stats.nDiskSize, 1.0f);
         statsClient.gauge("utxoset.blockHeight", stats.nHeight, 1.0f);
         if (stats.total_amount.has_value()) {
             statsClient.gauge("utxoset.totalAmount", (double)stats.total_amount.value() / (double)COIN, 1.0f);
@@ -936,6 +1022,58 @@ static void PeriodicStats(ArgsManager& args, const CTxMemPool& mempool)
         statsClient.gauge("transactions.mempool.memoryUsageBytes", (int64_t) mempool.DynamicMemoryUsage(), 1.0f);
         statsClient.gauge("transactions.mempool.minFeePerKb", mempool.GetMinFee(args.GetArg("-maxmempool", DEFAULT_MAX_MEMPOOL_SIZE) * 1000000).GetFeePerK(), 1.0f);
     }
+
+    statsClient.gauge("llmq.bls.workerQueueDepth", llmq_ctx.bls_worker->GetQueueDepth(), 1.0f);
+    statsClient.gauge("llmq.bls.sigVerifyQueueDepth", llmq_ctx.bls_worker->GetSigVerifyQueueDepth(), 1.0f);
+    statsClient.gauge("llmq.pendingBudget.usageBytes", llmq::pendingMessagesBudget.GetUsage(), 1.0f);
+    statsClient.gauge("llmq.pendingBudget.pausedPeers", llmq::pendingMessagesBudget.GetPausedCount(), 1.0f);
+
+    if (g_lock_stats_enabled) {
+        std::map<std::string, LockSiteStats> locks;
+        for (const LockSiteStats& site : GetLockStats()) {
+            MergeLockStats(locks[site.lock_name], site);
+        }
+        for (const auto& [lock_name, stats] : locks) {
+            // Lock expressions like "m_node.mempool->cs" are not valid statsd keys
+            std::string key = "locks.";
+            for (const char c : lock_name) {
+                key += IsDigit(c) || (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') ? c : '_';
+            }
+            statsClient.gauge(key + ".acquisitions", stats.samples * LOCK_STATS_SAMPLE_RATE + stats.contentions, 1.0f);
+            statsClient.gauge(key + ".contentions", stats.contentions, 1.0f);
+            statsClient.gauge(key + ".waitUs", stats.wait_us, 1.0f);
+            statsClient.gauge(key + ".maxWaitUs", stats.max_wait_us, 1.0f);
+            statsClient.gauge(key + ".avgHoldUs", stats.holds ? stats.hold_us / stats.holds : 0, 1.0f);
+        }
+    }
+
+    for (const auto& [name, stats] : scheduler.GetTaskStats()) {
+        const std::string key = "scheduler." + SchedulerLaneName(stats.lane) + "." + name;
+        statsClient.gauge(key + ".runs", stats.runs, 1.0f);
+        statsClient.gauge(key + ".avgUs", stats.runs ? stats.total.count() / stats.runs : 0, 1.0f);
+        statsClient.gauge(key + ".maxUs", stats.max.count(), 1.0f);
+    }
+
+    for (const auto& [name, usage] : GetSubsystemMemoryUsage(node)) {
+        statsClient.gauge("memory." + name + "Bytes", usage, 1.0f);
+    }
+
+    for (const auto& [name, stats] : GetLRUCacheStats()) {
+        const std::string key = "caches." + name;
+        statsClient.gauge(key + ".hits", stats->hits.load(), 1.0f);
+        statsClient.gauge(key + ".misses", stats->misses.load(), 1.0f);
+        statsClient.gauge(key + ".evictions", stats->evictions.load(), 1.0f);
+    }
+
+    for (const DBStats& stats : GetDBStats()) {
+        const std::string key = "leveldb." + stats.name;
+        statsClient.gauge(key + ".level0Files", stats.level0_files, 1.0f);
+        statsClient.gauge(key + ".writeSlowdowns", stats.write_slowdowns, 1.0f);
+        statsClient.gauge(key + ".writeStops", stats.write_stops, 1.0f);
+        statsClient.gauge(key + ".writeStallUs", stats.write_stall_us, 1.0f);
+        statsClient.gaugeDouble(key + ".compactionSeconds", stats.compaction_seconds);
+        statsClient.gaugeDouble(key + ".compactionWriteMiB", stats.compaction_write_mib);
+    }
 }
 
 /** Sanity checks
@@ -1060,18 +1198,6 @@ void InitParameterInteraction(ArgsManager& args)
         }
     }
 
-    // Make sure additional indexes are recalculated correctly in VerifyDB
-    // (we must reconnect blocks whenever we disconnect them for these indexes to work)
-    bool fAdditionalIndexes =
-        args.GetBoolArg("-addressindex", DEFAULT_ADDRESSINDEX) ||
-        args.GetBoolArg("-spentindex", DEFAULT_SPENTINDEX) ||
-        args.GetBoolArg("-timestampindex", DEFAULT_TIMESTAMPINDEX);
-
-    if (fAdditionalIndexes && args.GetArg("-checklevel", DEFAULT_CHECKLEVEL) < 4) {
-        args.ForceSetArg("-checklevel", "4");
-        LogPrintf("%s: parameter interaction: additional indexes -> setting -checklevel=4\n", __func__);
-    }
-
     if (args.IsArgSet("-masternodeblsprivkey") && args.SoftSetBoolArg("-disablewallet", true)) {
         LogPrintf("%s: parameter interaction: -masternodeblsprivkey set -> setting -disablewallet=1\n", __func__);
     }
@@ -1090,6 +1216,7 @@ void InitLogging(const ArgsManager& args)
     LogInstance().m_print_to_console = args.GetBoolArg("-printtoconsole", !args.GetBoolArg("-daemon", false));
     LogInstance().m_log_timestamps = args.GetBoolArg("-logtimestamps", DEFAULT_LOGTIMESTAMPS);
     LogInstance().m_log_time_micros = args.GetBoolArg("-logtimemicros", DEFAULT_LOGTIMEMICROS);
+    LogInstance().m_async_capacity = std::max<int64_t>(args.GetArg("-logasync", DEFAULT_LOGASYNC), 0);
 #ifdef HAVE_THREAD_LOCAL
     LogInstance().m_log_threadnames = args.GetBoolArg("-logthreadnames", DEFAULT_LOGTHREADNAMES);
 #endif
@@ -1237,6 +1364,9 @@ bool AppInitParameterInteraction(const ArgsManager& args)
             return InitError(_("Prune mode is incompatible with -txindex."));
         if (args.GetBoolArg("-coinstatsindex", DEFAULT_COINSTATSINDEX))
             return InitError(_("Prune mode is incompatible with -coinstatsindex."));
+        if (args.GetBoolArg("-addressindex", DEFAULT_ADDRESSINDEX) || args.GetBoolArg("-spentindex", DEFAULT_SPENTINDEX) ||
+            args.GetBoolArg("-timestampindex", DEFAULT_TIMESTAMPINDEX))
+            return InitError(_("Prune mode is incompatible with -addressindex, -spentindex and -timestampindex."));
         if (!args.GetBoolArg("-disablegovernance", false)) {
             return InitError(_("Prune mode is incompatible with -disablegovernance=false."));
         }
@@ -1307,6 +1437,9 @@ bool AppInitParameterInteraction(const ArgsManager& args)
         }
     }
 
+    g_lock_stats_enabled = args.GetBoolArg("-lockstats", DEFAULT_LOCKSTATS);
+    statsClient.setMetricsEnabled(args.GetBoolArg("-metrics", DEFAULT_METRICS_ENABLE));
+
     fCheckBlockIndex = args.GetBoolArg("-checkblockindex", chainparams.DefaultConsistencyChecks());
     fCheckpointsEnabled = args.GetBoolArg("-checkpoints", DEFAULT_CHECKPOINTS_ENABLED);
 
@@ -1423,6 +1556,10 @@ bool AppInitParameterInteraction(const ArgsManager& args)
     fAcceptDatacarrier = args.GetBoolArg("-datacarrier", DEFAULT_ACCEPT_DATACARRIER);
     nMaxDatacarrierBytes = args.GetArg("-datacarriersize", nMaxDatacarrierBytes);
 
+    fAddressIndex = args.GetBoolArg("-addressindex", DEFAULT_ADDRESSINDEX);
+    fSpentIndex = args.GetBoolArg("-spentindex", DEFAULT_SPENTINDEX);
+    fTimestampIndex = args.GetBoolArg("-timestampindex", DEFAULT_TIMESTAMPINDEX);
+
     // Option to startup with mocktime set (used for regression testing):
     SetMockTime(args.GetArg("-mocktime", 0)); // SetMockTime(0) is a no-op
 
@@ -1445,6 +1582,8 @@ bool AppInitParameterInteraction(const ArgsManager& args)
         return InitError(Untranslated(e.what()));
     }
 
+    llmq::pendingMessagesBudget.SetLimit(std::max<int64_t>(args.GetArg("-llmq-pending-budget", llmq::DEFAULT_PENDING_MESSAGES_BUDGET), 1) << 20);
+
     if (args.IsArgSet("-masternodeblsprivkey")) {
         if (!args.GetBoolArg("-listen", DEFAULT_LISTEN) && Params().RequireRoutableExternalIP()) {
             return InitError(Untranslated("Masternode must accept connections from outside, set -listen=1"));
@@ -1499,6 +1638,12 @@ bool AppInitSanityChecks()
     // Initialize elliptic curve code
     std::string sha256_algo = SHA256AutoDetect();
     LogPrintf("Using the '%s' SHA256 implementation\n", sha256_algo);
+    std::string x11_algo = X11AutoDetect();
+    LogPrintf("Using the '%s' X11 implementation\n", x11_algo);
+    std::string chacha20_algo = ChaCha20AutoDetect();
+    LogPrintf("Using the '%s' ChaCha20 implementation\n", chacha20_algo);
+    std::string aes_algo = AES256AutoDetect();
+    LogPrintf("Using the '%s' AES-256 implementation\n", aes_algo);
     RandomInit();
     ECC_Start();
 
@@ -1589,6 +1734,9 @@ bool AppInitMain(const CoreContext& context, NodeContext& node, interfaces::Bloc
 
     InitSignatureCache();
     InitScriptExecutionCache();
+    InitBLSSignatureCache();
+
+    SetThreadBudget(args.GetArg("-workerthreads", DEFAULT_WORKER_THREADS));
 
     int script_threads = args.GetArg("-par", DEFAULT_SCRIPTCHECK_THREADS);
     if (script_threads <= 0) {
@@ -1637,8 +1785,14 @@ bool AppInitMain(const CoreContext& context, NodeContext& node, interfaces::Bloc
     assert(!node.scheduler);
     node.scheduler = std::make_unique<CScheduler>();
 
-    // Start the lightweight task scheduler thread
+    // Start the lightweight task scheduler threads
     node.scheduler->m_service_thread = std::thread(util::TraceThread, "scheduler", [&] { node.scheduler->serviceQueue(); });
+    const int scheduler_threads = std::clamp<int>(args.GetArg("-schedulerthreads", DEFAULT_SCHEDULER_THREADS), 1, MAX_SCHEDULER_THREADS);
+    for (int i = 1; i < scheduler_threads; i++) {
+        node.scheduler->m_extra_service_threads.emplace_back([&, i] {
+            util::TraceThread(strprintf("scheduler.%d", i).c_str(), [&] { node.scheduler->serviceQueue(); });
+        });
+    }
 
     // Gather some entropy once per minute.
     node.scheduler->scheduleEvery([]{
@@ -1868,7 +2022,7 @@ bool AppInitMain(const CoreContext& context, NodeContext& node, interfaces::Bloc
     g_zmq_notification_interface = CZMQNotificationInterface::Create();
 
     if (g_zmq_notification_interface) {
-        RegisterValidationInterface(g_zmq_notification_interface);
+        RegisterValidationInterface(g_zmq_notification_interface, /*own_queue=*/true);
     }
 #endif
 
@@ -1878,9 +2032,10 @@ bool AppInitMain(const CoreContext& context, NodeContext& node, interfaces::Bloc
     RegisterValidationInterface(pdsNotificationInterface);
 
     if (fMasternodeMode) {
-        // Create and register activeMasternodeManager, will init later in ThreadImport
+        // Create and register activeMasternodeManager, will init later in ThreadImport. It gets a queue of its own
+        // as Init() may do network lookups, which shouldn't hold back the LLMQ, governance and CoinJoin callbacks.
         activeMasternodeManager = std::make_unique<CActiveMasternodeManager>(*node.connman);
-        RegisterValidationInterface(activeMasternodeManager.get());
+        RegisterValidationInterface(activeMasternodeManager.get(), /*own_queue=*/true);
     }
 
     // ********************************************************* Step 7a: Load sporks
@@ -1903,6 +2058,8 @@ bool AppInitMain(const CoreContext& context, NodeContext& node, interfaces::Bloc
     nTotalCache -= nBlockTreeDBCache;
     int64_t nTxIndexCache = std::min(nTotalCache / 8, args.GetBoolArg("-txindex", DEFAULT_TXINDEX) ? nMaxTxIndexCache << 20 : 0);
     nTotalCache -= nTxIndexCache;
+    int64_t nAddressIndexCache = std::min(nTotalCache / 8, fAddressIndex || fSpentIndex || fTimestampIndex ? nMaxAddressIndexCache << 20 : 0);
+    nTotalCache -= nAddressIndexCache;
     int64_t filter_index_cache = 0;
     if (!g_enabled_filter_types.empty()) {
         size_t n_indexes = g_enabled_filter_types.size();
@@ -1916,17 +2073,27 @@ bool AppInitMain(const CoreContext& context, NodeContext& node, interfaces::Bloc
     int64_t nCoinCacheUsage = nTotalCache; // the rest goes to in-memory cache
     int64_t nMempoolSizeMax = args.GetArg("-maxmempool", DEFAULT_MAX_MEMPOOL_SIZE) * 1000000;
     int64_t nEvoDbCache = 1024 * 1024 * 64; // TODO
+    // evodb and the llmq databases share one block cache instead of each thrashing a small private one
+    int64_t nSharedDbCache = nEvoDbCache;
+    int64_t nEvoDbBatchSize = std::max<int64_t>(args.GetArg("-evodbbatchsize", DEFAULT_EVODB_BATCH_SIZE), DEFAULT_EVODB_BATCH_SIZE) << 20;
     LogPrintf("Cache configuration:\n");
     LogPrintf("* Using %.1f MiB for block index database\n", nBlockTreeDBCache * (1.0 / 1024 / 1024));
     if (args.GetBoolArg("-txindex", DEFAULT_TXINDEX)) {
         LogPrintf("* Using %.1f MiB for transaction index database\n", nTxIndexCache * (1.0 / 1024 / 1024));
     }
+    if (fAddressIndex || fSpentIndex || fTimestampIndex) {
+        LogPrintf("* Using %.1f MiB for address index database\n", nAddressIndexCache * (1.0 / 1024 / 1024));
+    }
     for (BlockFilterType filter_type : g_enabled_filter_types) {
         LogPrintf("* Using %.1f MiB for %s block filter index database\n",
                   filter_index_cache * (1.0 / 1024 / 1024), BlockFilterTypeName(filter_type));
     }
     LogPrintf("* Using %.1f MiB for chain state database\n", nCoinDBCache * (1.0 / 1024 / 1024));
+    LogPrintf("* Using %.1f MiB for the block cache shared by the evo and llmq databases\n", nSharedDbCache * (1.0 / 1024 / 1024));
     LogPrintf("* Using %.1f MiB for in-memory UTXO set (plus up to %.1f MiB of unused mempool space)\n", nCoinCacheUsage * (1.0 / 1024 / 1024), nMempoolSizeMax * (1.0 / 1024 / 1024));
+    LogPrintf("* Using up to %.1f MiB for pending evo database writes during initial block download\n", nEvoDbBatchSize * (1.0 / 1024 / 1024));
+
+    InitSharedDBCache(nSharedDbCache);
 
     bool fLoaded = false;
 
@@ -1946,7 +2113,7 @@ bool AppInitMain(const CoreContext& context, NodeContext& node, interfaces::Bloc
             try {
                 LOCK(cs_main);
                 node.evodb.reset();
-                node.evodb = std::make_unique<CEvoDB>(nEvoDbCache, false, fReset || fReindexChainState);
+                node.evodb = std::make_unique<CEvoDB>(nEvoDbCache, false, fReset || fReindexChainState, nEvoDbBatchSize);
                 node.mnhf_manager.reset();
                 node.mnhf_manager = std::make_unique<CMNHFManager>(*node.evodb);
 
@@ -1965,7 +2132,9 @@ bool AppInitMain(const CoreContext& context, NodeContext& node, interfaces::Bloc
 
                 // Same logic as above with pblocktree
                 deterministicMNManager.reset();
-                deterministicMNManager = std::make_unique<CDeterministicMNManager>(chainman.ActiveChainstate(), *node.connman, *node.evodb);
+                deterministicMNManager = std::make_unique<CDeterministicMNManager>(chainman.ActiveChainstate(), *node.connman, *node.evodb,
+                                                                                   args.GetArg("-mnlistsnapshotinterval", DEFAULT_MNLIST_SNAPSHOT_INTERVAL),
+                                                                                   args.GetArg("-mnlistcachesize", DEFAULT_MNLIST_CACHE_SIZE));
                 node.dmnman = deterministicMNManager.get();
                 creditPoolManager.reset();
                 creditPoolManager = std::make_unique<CCreditPoolManager>(*node.evodb);
@@ -2017,24 +2186,6 @@ bool AppInitMain(const CoreContext& context, NodeContext& node, interfaces::Bloc
                     return InitError(_("Incorrect or no devnet genesis block found. Wrong datadir for devnet specified?"));
                 }
 
-                // Check for changed -addressindex state
-                if (fAddressIndex != args.GetBoolArg("-addressindex", DEFAULT_ADDRESSINDEX)) {
-                    strLoadError = _("You need to rebuild the database using -reindex to change -addressindex");
-                    break;
-                }
-
-                // Check for changed -timestampindex state
-                if (fTimestampIndex != args.GetBoolArg("-timestampindex", DEFAULT_TIMESTAMPINDEX)) {
-                    strLoadError = _("You need to rebuild the database using -reindex to change -timestampindex");
-                    break;
-                }
-
-                // Check for changed -spentindex state
-                if (fSpentIndex != args.GetBoolArg("-spentindex", DEFAULT_SPENTINDEX)) {
-                    strLoadError = _("You need to rebuild the database using -reindex to change -spentindex");
-                    break;
-                }
-
                 // Check for changed -prune state.  What we are concerned about is a user who has pruned blocks
                 // in the past, but is now trying to run unpruned.
                 if (fHavePruned && !fPruneMode) {
@@ -2274,6 +2425,13 @@ bool AppInitMain(const CoreContext& context, NodeContext& node, interfaces::Bloc
         }
     }
 
+    if (fAddressIndex || fSpentIndex || fTimestampIndex) {
+        g_address_index = std::make_unique<AddressIndex>(nAddressIndexCache, fAddressIndex, fSpentIndex, fTimestampIndex, false, fReindex);
+        if (!g_address_index->Start(::ChainstateActive())) {
+            return false;
+        }
+    }
+
     for (const auto& filter_type : g_enabled_filter_types) {
         InitBlockFilterIndex(filter_type, filter_index_cache, false, fReindex);
         if (!GetBlockFilterIndex(filter_type)->Start(::ChainstateActive())) {
@@ -2329,28 +2487,28 @@ bool AppInitMain(const CoreContext& context, NodeContext& node, interfaces::Bloc
 
     // ********************************************************* Step 10a: schedule Maximus-specific tasks
 
-    node.scheduler->scheduleEvery(std::bind(&CNetFulfilledRequestManager::DoMaintenance, std::ref(*node.netfulfilledman)), std::chrono::minutes{1});
-    node.scheduler->scheduleEvery(std::bind(&CMasternodeSync::DoMaintenance, std::ref(*node.mn_sync)), std::chrono::seconds{1});
-    node.scheduler->scheduleEvery(std::bind(&CMasternodeUtils::DoMaintenance, std::ref(*node.connman), std::ref(*node.mn_sync), std::ref(*node.cj_ctx)), std::chrono::minutes{1});
-    node.scheduler->scheduleEvery(std::bind(&CDeterministicMNManager::DoMaintenance, std::ref(*node.dmnman)), std::chrono::seconds{10});
+    node.scheduler->scheduleEvery(std::bind(&CNetFulfilledRequestManager::DoMaintenance, std::ref(*node.netfulfilledman)), std::chrono::minutes{1}, SchedulerLane::NETWORK, "netfulfilled");
+    node.scheduler->scheduleEvery(std::bind(&CMasternodeSync::DoMaintenance, std::ref(*node.mn_sync)), std::chrono::seconds{1}, SchedulerLane::NETWORK, "mnsync");
+    node.scheduler->scheduleEvery(std::bind(&CMasternodeUtils::DoMaintenance, std::ref(*node.connman), std::ref(*node.mn_sync), std::ref(*node.cj_ctx)), std::chrono::minutes{1}, SchedulerLane::LLMQ, "mnutils");
+    node.scheduler->scheduleEvery(std::bind(&CDeterministicMNManager::DoMaintenance, std::ref(*node.dmnman)), std::chrono::seconds{10}, SchedulerLane::LLMQ, "dmnman");
 
     if (!fDisableGovernance) {
-        node.scheduler->scheduleEvery(std::bind(&CGovernanceManager::DoMaintenance, std::ref(*node.govman), std::ref(*node.connman)), std::chrono::minutes{5});
+        node.scheduler->scheduleEvery(std::bind(&CGovernanceManager::DoMaintenance, std::ref(*node.govman), std::ref(*node.connman)), std::chrono::minutes{5}, SchedulerLane::MAINTENANCE, "governance");
     }
 
     if (fMasternodeMode) {
-        node.scheduler->scheduleEvery(std::bind(&CCoinJoinServer::DoMaintenance, std::ref(*node.cj_ctx->server)), std::chrono::seconds{1});
-        node.scheduler->scheduleEvery(std::bind(&llmq::CDKGSessionManager::CleanupOldContributions, std::ref(*node.llmq_ctx->qdkgsman)), std::chrono::hours{1});
+        node.scheduler->scheduleEvery(std::bind(&CCoinJoinServer::DoMaintenance, std::ref(*node.cj_ctx->server)), std::chrono::seconds{1}, SchedulerLane::MAINTENANCE, "coinjoinserver");
+        node.scheduler->scheduleEvery(std::bind(&llmq::CDKGSessionManager::CleanupOldContributions, std::ref(*node.llmq_ctx->qdkgsman)), std::chrono::hours{1}, SchedulerLane::LLMQ, "dkgcleanup");
 #ifdef ENABLE_WALLET
     } else if (!ignores_incoming_txs) {
-        node.scheduler->scheduleEvery(std::bind(&CCoinJoinClientQueueManager::DoMaintenance, std::ref(*node.cj_ctx->queueman)), std::chrono::seconds{1});
-        node.scheduler->scheduleEvery(std::bind(&CoinJoinWalletManager::DoMaintenance, std::ref(*node.cj_ctx->walletman), std::ref(*node.fee_estimator)), std::chrono::seconds{1});
+        node.scheduler->scheduleEvery(std::bind(&CCoinJoinClientQueueManager::DoMaintenance, std::ref(*node.cj_ctx->queueman)), std::chrono::seconds{1}, SchedulerLane::MAINTENANCE, "coinjoinqueue");
+        node.scheduler->scheduleEvery(std::bind(&CoinJoinWalletManager::DoMaintenance, std::ref(*node.cj_ctx->walletman), std::ref(*node.fee_estimator)), std::chrono::seconds{1}, SchedulerLane::MAINTENANCE, "coinjoinwallet");
 #endif // ENABLE_WALLET
     }
 
-    if (args.GetBoolArg("-statsenabled", DEFAULT_STATSD_ENABLE)) {
+    if (args.GetBoolArg("-statsenabled", DEFAULT_STATSD_ENABLE) || statsClient.metricsEnabled()) {
         int nStatsPeriod = std::min(std::max((int)args.GetArg("-statsperiod", DEFAULT_STATSD_PERIOD), MIN_STATSD_PERIOD), MAX_STATSD_PERIOD);
-        node.scheduler->scheduleEvery(std::bind(&PeriodicStats, std::ref(*node.args), std::cref(*node.mempool)), std::chrono::seconds{nStatsPeriod});
+        node.scheduler->scheduleEvery(std::bind(&PeriodicStats, std::ref(*node.args), std::cref(node), std::cref(*node.mempool), std::cref(*node.llmq_ctx), std::cref(*node.scheduler)), std::chrono::seconds{nStatsPeriod}, SchedulerLane::MAINTENANCE, "stats");
     }
 
     // ********************************************************* Step 11: import blocks
@@ -2544,6 +2702,8 @@ bool AppInitMain(const CoreContext& context, NodeContext& node, interfaces::Bloc
     } else {
         return InitError(strprintf(_("Invalid -socketevents ('%s') specified. Only these modes are supported: %s"), strSocketEventsMode, GetSupportedSocketEventsStr()));
     }
+    connOptions.nSocketThreads = args.GetArg("-socketthreads", DEFAULT_SOCKET_THREADS);
+    connOptions.nMessageHandlerThreads = args.GetArg("-messagehandlerthreads", DEFAULT_MESSAGE_HANDLER_THREADS);
 
     const std::string& i2psam_arg = args.GetArg("-i2psam", "");
     if (!i2psam_arg.empty()) {
@@ -2575,7 +2735,7 @@ bool AppInitMain(const CoreContext& context, NodeContext& node, interfaces::Bloc
     BanMan* banman = node.banman.get();
     node.scheduler->scheduleEvery([banman]{
         banman->DumpBanlist();
-    }, DUMP_BANS_INTERVAL);
+    }, DUMP_BANS_INTERVAL, SchedulerLane::NETWORK, "dumpbanlist");
 
 #if HAVE_SYSTEM
     StartupNotify(args);
@@ -186,6 +186,12 @@ public:
     //! Get list of all wallet transactions.
     virtual std::vector<WalletTx> getWalletTxs() = 0;
 
+    //! Get transaction information for the given transactions, skipping unknown ones.
+    virtual std::vector<WalletTx> getWalletTxs(const std::vector<uint256>& txids) = 0;
+
+    //! Get the hashes of all wallet transactions, most recently added first.
+    virtual std::vector<uint256> getWalletTxHashes() = 0;
+
     //! Try to get updated status for a particular transaction, if possible without blocking.
     virtual bool tryGetTxStatus(const uint256& txid,
         WalletTxStatus& tx_status,
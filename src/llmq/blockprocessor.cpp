@@ -294,11 +294,20 @@ bool CQuorumBlockProcessor::ProcessCommitment(int nHeight, const uint256& blockH
         m_evoDb.Write(BuildInversedHeightKey(llmq_params.type, nHeight), pQuorumBaseBlockIndex->nHeight);
     }
 
+    {
+        LOCK(cs_mined_index);
+        if (fMinedCommitmentsIndexLoaded) {
+            auto& index = mapMinedCommitmentsIndex[{llmq_params.type, rotation_enabled ? int(qc.quorumIndex) : -1}];
+            index[nHeight] = {pQuorumBaseBlockIndex->nHeight, blockHash};
+        }
+    }
+
     {
         LOCK(minableCommitmentsCs);
         mapHasMinedCommitmentCache[qc.llmqType].erase(qc.quorumHash);
         minableCommitmentsByQuorum.erase(cacheKey);
         minableCommitments.erase(::SerializeHash(qc));
+        ++nMineableCommitmentsVersion;
     }
 
     LogPrint(BCLog::LLMQ, "CQuorumBlockProcessor::%s -- processed commitment from block. type=%d, quorumIndex=%d, quorumHash=%s, signers=%s, validMembers=%d, quorumPublicKey=%s\n", __func__,
@@ -330,12 +339,20 @@ bool CQuorumBlockProcessor::UndoBlock(const CBlock& block, gsl::not_null<const C
         const auto& llmq_params_opt = Params().GetLLMQ(qc.llmqType);
         assert(llmq_params_opt.has_value());
 
-        if (IsQuorumRotationEnabled(llmq_params_opt.value(), pindex)) {
+        const bool rotation_enabled = IsQuorumRotationEnabled(llmq_params_opt.value(), pindex);
+        if (rotation_enabled) {
             m_evoDb.Erase(BuildInversedHeightKeyIndexed(qc.llmqType, pindex->nHeight, int(qc.quorumIndex)));
         } else {
             m_evoDb.Erase(BuildInversedHeightKey(qc.llmqType, pindex->nHeight));
         }
 
+        {
+            LOCK(cs_mined_index);
+            if (fMinedCommitmentsIndexLoaded) {
+                mapMinedCommitmentsIndex[{qc.llmqType, rotation_enabled ? int(qc.quorumIndex) : -1}].erase(pindex->nHeight);
+            }
+        }
+
         {
             LOCK(minableCommitmentsCs);
             mapHasMinedCommitmentCache[qc.llmqType].erase(qc.quorumHash);
@@ -480,97 +497,103 @@ CFinalCommitmentPtr CQuorumBlockProcessor::GetMinedCommitment(Consensus::LLMQTyp
     return std::make_unique<CFinalCommitment>(p.first);
 }
 
-// The returned quorums are in reversed order, so the most recent one is at index 0
-std::vector<const CBlockIndex*> CQuorumBlockProcessor::GetMinedCommitmentsUntilBlock(Consensus::LLMQType llmqType, gsl::not_null<const CBlockIndex*> pindex, size_t maxCount) const
+void CQuorumBlockProcessor::LoadMinedCommitmentsIndex() const
 {
+    AssertLockHeld(cs_mined_index);
+    if (fMinedCommitmentsIndexLoaded) {
+        return;
+    }
+
     AssertLockNotHeld(m_evoDb.cs);
     LOCK(m_evoDb.cs);
 
     auto dbIt = m_evoDb.GetCurTransaction().NewIteratorUniquePtr();
 
-    auto firstKey = BuildInversedHeightKey(llmqType, pindex->nHeight);
-    auto lastKey = BuildInversedHeightKey(llmqType, 0);
-
-    dbIt->Seek(firstKey);
-
-    std::vector<const CBlockIndex*> ret;
-    ret.reserve(maxCount);
-
-    while (dbIt->Valid() && ret.size() < maxCount) {
-        decltype(firstKey) curKey;
-        int quorumHeight;
-        if (!dbIt->GetKey(curKey) || curKey >= lastKey) {
-            break;
-        }
-        if (std::get<0>(curKey) != DB_MINED_COMMITMENT_BY_INVERSED_HEIGHT || std::get<1>(curKey) != llmqType) {
-            break;
+    // Reads all rows of one key range into the index, the range ends where the key prefix changes
+    auto loadRows = [&dbIt](const auto& firstKey, auto&& sameRange, MinedCommitmentsIndex& index) {
+        dbIt->Seek(firstKey);
+        while (dbIt->Valid()) {
+            std::decay_t<decltype(firstKey)> curKey;
+            int quorumHeight;
+            if (!dbIt->GetKey(curKey) || !sameRange(curKey) || !dbIt->GetValue(quorumHeight)) {
+                break;
+            }
+            const uint32_t nMinedHeight = std::numeric_limits<uint32_t>::max() - be32toh(std::get<std::tuple_size_v<decltype(curKey)> - 1>(curKey));
+            index.emplace(int(nMinedHeight), MinedCommitmentsIndexEntry{quorumHeight, uint256()});
+            dbIt->Next();
         }
+    };
 
-        uint32_t nMinedHeight = std::numeric_limits<uint32_t>::max() - be32toh(std::get<2>(curKey));
-        if (nMinedHeight > static_cast<uint32_t>(pindex->nHeight)) {
-            break;
+    size_t nEntries{0};
+    for (const auto& [_, params] : Params().GetConsensus().llmqs) {
+        const auto llmqType = params.type;
+        auto& index = mapMinedCommitmentsIndex[{llmqType, -1}];
+        loadRows(BuildInversedHeightKey(llmqType, std::numeric_limits<int>::max()), [llmqType](const auto& key) {
+            return std::get<0>(key) == DB_MINED_COMMITMENT_BY_INVERSED_HEIGHT && std::get<1>(key) == llmqType;
+        }, index);
+        nEntries += index.size();
+
+        if (!params.useRotation) {
+            continue;
         }
-
-        if (!dbIt->GetValue(quorumHeight)) {
-            break;
+        for (const auto quorumIndex : irange::range(params.signingActiveQuorumCount)) {
+            auto& indexed = mapMinedCommitmentsIndex[{llmqType, quorumIndex}];
+            loadRows(BuildInversedHeightKeyIndexed(llmqType, std::numeric_limits<int>::max(), quorumIndex), [llmqType, quorumIndex](const auto& key) {
+                return std::get<0>(key) == DB_MINED_COMMITMENT_BY_INVERSED_HEIGHT_Q_INDEXED && std::get<1>(key) == llmqType && std::get<2>(key) == quorumIndex;
+            }, indexed);
+            nEntries += indexed.size();
         }
-
-        const auto* pQuorumBaseBlockIndex = pindex->GetAncestor(quorumHeight);
-        assert(pQuorumBaseBlockIndex);
-        ret.emplace_back(pQuorumBaseBlockIndex);
-
-        dbIt->Next();
     }
 
-    return ret;
+    fMinedCommitmentsIndexLoaded = true;
+    LogPrint(BCLog::LLMQ, "CQuorumBlockProcessor::%s -- loaded %d mined commitments\n", __func__, nEntries);
 }
 
-std::optional<const CBlockIndex*> CQuorumBlockProcessor::GetLastMinedCommitmentsByQuorumIndexUntilBlock(Consensus::LLMQType llmqType, const CBlockIndex* pindex, int quorumIndex, size_t cycle) const
+// The returned quorums are in reversed order, so the most recent one is at index 0
+std::vector<const CBlockIndex*> CQuorumBlockProcessor::GetMinedCommitmentsFromIndex(Consensus::LLMQType llmqType, int quorumIndex, const CBlockIndex* pindex, size_t maxCount) const
 {
-    AssertLockNotHeld(m_evoDb.cs);
-    LOCK(m_evoDb.cs);
-
-    auto dbIt = m_evoDb.GetCurTransaction().NewIteratorUniquePtr();
+    AssertLockHeld(cs_mined_index);
 
-    auto firstKey = BuildInversedHeightKeyIndexed(llmqType, pindex->nHeight, quorumIndex);
-    auto lastKey = BuildInversedHeightKeyIndexed(llmqType, 0, quorumIndex);
-
-    size_t currentCycle = 0;
-
-    dbIt->Seek(firstKey);
-
-    while (dbIt->Valid()) {
-        decltype(firstKey) curKey;
-        int quorumHeight;
-        if (!dbIt->GetKey(curKey) || curKey >= lastKey) {
-            return std::nullopt;
-        }
-        if (std::get<0>(curKey) != DB_MINED_COMMITMENT_BY_INVERSED_HEIGHT_Q_INDEXED || std::get<1>(curKey) != llmqType) {
-            return std::nullopt;
-        }
-
-        uint32_t nMinedHeight = std::numeric_limits<uint32_t>::max() - be32toh(std::get<3>(curKey));
-        if (nMinedHeight > static_cast<uint32_t>(pindex->nHeight)) {
-            return std::nullopt;
-        }
-
-        if (!dbIt->GetValue(quorumHeight)) {
-            return std::nullopt;
+    std::vector<const CBlockIndex*> ret;
+    const auto it = mapMinedCommitmentsIndex.find({llmqType, quorumIndex});
+    if (it == mapMinedCommitmentsIndex.end()) {
+        return ret;
+    }
+    const auto& index = it->second;
+    ret.reserve(std::min(maxCount, index.size()));
+
+    for (auto entryIt = index.lower_bound(pindex->nHeight); entryIt != index.end() && ret.size() < maxCount; ++entryIt) {
+        const auto& [nMinedHeight, entry] = *entryIt;
+        // Skip commitments of blocks which are not part of this chain, e.g. a block which failed to connect when
+        // the DB transaction holding its rows was discarded
+        if (!entry.minedBlockHash.IsNull() && pindex->GetAncestor(nMinedHeight)->GetBlockHash() != entry.minedBlockHash) {
+            continue;
         }
-
-        const auto* pQuorumBaseBlockIndex = pindex->GetAncestor(quorumHeight);
+        const auto* pQuorumBaseBlockIndex = pindex->GetAncestor(entry.nQuorumHeight);
         assert(pQuorumBaseBlockIndex);
+        ret.emplace_back(pQuorumBaseBlockIndex);
+    }
 
-        if (currentCycle == cycle) {
-            return std::make_optional(pQuorumBaseBlockIndex);
-        }
+    return ret;
+}
 
-        currentCycle++;
+// The returned quorums are in reversed order, so the most recent one is at index 0
+std::vector<const CBlockIndex*> CQuorumBlockProcessor::GetMinedCommitmentsUntilBlock(Consensus::LLMQType llmqType, gsl::not_null<const CBlockIndex*> pindex, size_t maxCount) const
+{
+    LOCK(cs_mined_index);
+    LoadMinedCommitmentsIndex();
+    return GetMinedCommitmentsFromIndex(llmqType, -1, pindex, maxCount);
+}
 
-        dbIt->Next();
+std::optional<const CBlockIndex*> CQuorumBlockProcessor::GetLastMinedCommitmentsByQuorumIndexUntilBlock(Consensus::LLMQType llmqType, const CBlockIndex* pindex, int quorumIndex, size_t cycle) const
+{
+    LOCK(cs_mined_index);
+    LoadMinedCommitmentsIndex();
+    const auto commitments = GetMinedCommitmentsFromIndex(llmqType, quorumIndex, pindex, cycle + 1);
+    if (commitments.size() <= cycle) {
+        return std::nullopt;
     }
-
-    return std::nullopt;
+    return std::make_optional(commitments[cycle]);
 }
 
 std::vector<std::pair<int, const CBlockIndex*>> CQuorumBlockProcessor::GetLastMinedCommitmentsPerQuorumIndexUntilBlock(Consensus::LLMQType llmqType, const CBlockIndex* pindex, size_t cycle) const
@@ -589,31 +612,34 @@ std::vector<std::pair<int, const CBlockIndex*>> CQuorumBlockProcessor::GetLastMi
     return ret;
 }
 
+// The returned quorums are ordered by cycle, most recent first, and by quorum index within a cycle
 std::vector<const CBlockIndex*> CQuorumBlockProcessor::GetMinedCommitmentsIndexedUntilBlock(Consensus::LLMQType llmqType, const CBlockIndex* pindex, size_t maxCount) const
 {
-    std::vector<const CBlockIndex*> ret;
+    const auto& llmq_params_opt = Params().GetLLMQ(llmqType);
+    assert(llmq_params_opt.has_value());
 
-    size_t cycle = 0;
+    LOCK(cs_mined_index);
+    LoadMinedCommitmentsIndex();
 
-    while (ret.size() < maxCount) {
-        std::vector<std::pair<int, const CBlockIndex*>> cycleRet = GetLastMinedCommitmentsPerQuorumIndexUntilBlock(llmqType, pindex, cycle);
+    std::vector<std::vector<const CBlockIndex*>> perQuorumIndex;
+    perQuorumIndex.reserve(llmq_params_opt->signingActiveQuorumCount);
+    for (const auto quorumIndex : irange::range(llmq_params_opt->signingActiveQuorumCount)) {
+        perQuorumIndex.emplace_back(GetMinedCommitmentsFromIndex(llmqType, quorumIndex, pindex, maxCount));
+    }
 
-        if (cycleRet.empty()) {
-            return ret;
+    std::vector<const CBlockIndex*> ret;
+    ret.reserve(maxCount);
+    for (size_t cycle = 0; ret.size() < maxCount; ++cycle) {
+        bool fFound{false};
+        for (const auto& commitments : perQuorumIndex) {
+            if (cycle < commitments.size() && ret.size() < maxCount) {
+                ret.emplace_back(commitments[cycle]);
+                fFound = true;
+            }
+        }
+        if (!fFound) {
+            break;
         }
-
-        std::vector<const CBlockIndex*> cycleRetTransformed;
-        std::transform(cycleRet.begin(),
-                       cycleRet.end(),
-                       std::back_inserter(cycleRetTransformed),
-                       [](const std::pair<int, const CBlockIndex*>& p) { return p.second; });
-
-        size_t needToCopy = maxCount - ret.size();
-
-        std::copy_n(cycleRetTransformed.begin(),
-                    std::min(needToCopy, cycleRetTransformed.size()),
-                    std::back_inserter(ret));
-        cycle++;
     }
 
     return ret;
@@ -659,6 +685,7 @@ void CQuorumBlockProcessor::AddMineableCommitment(const CFinalCommitment& fqc)
         if (ins.second) {
             minableCommitments.emplace(commitmentHash, fqc);
             relay = true;
+            ++nMineableCommitmentsVersion;
         } else {
             const auto& oldFqc = minableCommitments.at(ins.first->second);
             if (fqc.CountSigners() > oldFqc.CountSigners()) {
@@ -667,6 +694,7 @@ void CQuorumBlockProcessor::AddMineableCommitment(const CFinalCommitment& fqc)
                 minableCommitments.erase(ins.first->second);
                 minableCommitments.emplace(commitmentHash, fqc);
                 relay = true;
+                ++nMineableCommitmentsVersion;
             }
         }
     }
@@ -750,12 +778,25 @@ std::optional<std::vector<CFinalCommitment>> CQuorumBlockProcessor::GetMineableC
 bool CQuorumBlockProcessor::GetMineableCommitmentsTx(const Consensus::LLMQParams& llmqParams, int nHeight, std::vector<CTransactionRef>& ret) const
 {
     AssertLockHeld(cs_main);
-    std::optional<std::vector<CFinalCommitment>> qcs = GetMineableCommitments(llmqParams, nHeight);
-    if (!qcs.has_value()) {
-        return false;
+
+    // Templates are built over and over for the same tip, only look the commitments up again when
+    // the tip or the known mineable commitments changed
+    const uint256 tipHash = m_chainstate.m_chain.Tip()->GetBlockHash();
+    uint64_t nVersion;
+    {
+        LOCK(minableCommitmentsCs);
+        nVersion = nMineableCommitmentsVersion;
+        const auto it = mapMineableCommitmentsTxCache.find(llmqParams.type);
+        if (it != mapMineableCommitmentsTxCache.end() && it->second.tipHash == tipHash && it->second.nHeight == nHeight &&
+            it->second.nVersion == nVersion) {
+            ret.insert(ret.end(), it->second.vTx.begin(), it->second.vTx.end());
+            return it->second.fRet;
+        }
     }
 
-    for (const auto& f : qcs.value()) {
+    std::vector<CTransactionRef> vTx;
+    std::optional<std::vector<CFinalCommitment>> qcs = GetMineableCommitments(llmqParams, nHeight);
+    for (const auto& f : qcs.value_or(std::vector<CFinalCommitment>{})) {
         CFinalCommitmentTxPayload qc;
         qc.nHeight = nHeight;
         qc.commitment = f;
@@ -763,10 +804,13 @@ bool CQuorumBlockProcessor::GetMineableCommitmentsTx(const Consensus::LLMQParams
         tx.nVersion = 3;
         tx.nType = TRANSACTION_QUORUM_COMMITMENT;
         SetTxPayload(tx, qc);
-        ret.push_back(MakeTransactionRef(tx));
+        vTx.push_back(MakeTransactionRef(tx));
     }
+    ret.insert(ret.end(), vTx.begin(), vTx.end());
 
-    return true;
+    LOCK(minableCommitmentsCs);
+    mapMineableCommitmentsTxCache[llmqParams.type] = MineableCommitmentsTxCache{tipHash, nHeight, nVersion, qcs.has_value(), std::move(vTx)};
+    return qcs.has_value();
 }
 
 } // namespace llmq
@@ -46,6 +46,34 @@ private:
 
     mutable std::map<Consensus::LLMQType, unordered_lru_cache<uint256, bool, StaticSaltedHasher>> mapHasMinedCommitmentCache GUARDED_BY(minableCommitmentsCs);
 
+    struct MinedCommitmentsIndexEntry {
+        int nQuorumHeight{0};
+        //! Null for entries loaded from the DB, which only holds commitments of the active chain
+        uint256 minedBlockHash;
+    };
+    //! Mined height -> quorum, most recent first
+    using MinedCommitmentsIndex = std::map<int, MinedCommitmentsIndexEntry, std::greater<int>>;
+    /**
+     * In-memory copy of the DB_MINED_COMMITMENT_BY_INVERSED_HEIGHT(_Q_INDEXED) rows, keyed by LLMQ type and
+     * quorum index (-1 for the rows of non-rotated quorums). Loaded on first use and kept in sync by
+     * ProcessCommitment and UndoBlock.
+     */
+    mutable Mutex cs_mined_index;
+    mutable std::map<std::pair<Consensus::LLMQType, int>, MinedCommitmentsIndex> mapMinedCommitmentsIndex GUARDED_BY(cs_mined_index);
+    mutable bool fMinedCommitmentsIndexLoaded GUARDED_BY(cs_mined_index){false};
+
+    //! Bumped whenever a commitment is added to or removed from the mineable ones
+    uint64_t nMineableCommitmentsVersion GUARDED_BY(minableCommitmentsCs){0};
+    struct MineableCommitmentsTxCache {
+        uint256 tipHash;
+        int nHeight{0};
+        uint64_t nVersion{0};
+        bool fRet{false};
+        std::vector<CTransactionRef> vTx;
+    };
+    //! The last GetMineableCommitmentsTx result per LLMQ type, valid while tip, height and version match
+    mutable std::map<Consensus::LLMQType, MineableCommitmentsTxCache> mapMineableCommitmentsTxCache GUARDED_BY(minableCommitmentsCs);
+
 public:
     explicit CQuorumBlockProcessor(CChainState& chainstate, CConnman& _connman, CEvoDB& evoDb);
 
@@ -74,6 +102,9 @@ private:
     static bool IsMiningPhase(const Consensus::LLMQParams& llmqParams, int nHeight) EXCLUSIVE_LOCKS_REQUIRED(cs_main);
     size_t GetNumCommitmentsRequired(const Consensus::LLMQParams& llmqParams, int nHeight) const EXCLUSIVE_LOCKS_REQUIRED(cs_main);
     static uint256 GetQuorumBlockHash(const Consensus::LLMQParams& llmqParams, int nHeight, int quorumIndex) EXCLUSIVE_LOCKS_REQUIRED(cs_main);
+
+    void LoadMinedCommitmentsIndex() const EXCLUSIVE_LOCKS_REQUIRED(cs_mined_index);
+    std::vector<const CBlockIndex*> GetMinedCommitmentsFromIndex(Consensus::LLMQType llmqType, int quorumIndex, const CBlockIndex* pindex, size_t maxCount) const EXCLUSIVE_LOCKS_REQUIRED(cs_mined_index);
 };
 
 extern std::unique_ptr<CQuorumBlockProcessor> quorumBlockProcessor;
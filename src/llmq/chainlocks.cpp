@@ -3,24 +3,34 @@
 // file COPYING or http://www.opensource.org/licenses/mit-license.php.
 
 #include <llmq/chainlocks.h>
+#include <llmq/commitment.h>
 #include <llmq/quorums.h>
 #include <llmq/instantsend.h>
 #include <llmq/signing_shares.h>
 
+#include <bls/bls_batchverifier.h>
 #include <chain.h>
 #include <chainparams.h>
 #include <consensus/validation.h>
 #include <masternode/sync.h>
+#include <net_processing.h>
 #include <node/blockstorage.h>
 #include <node/ui_interface.h>
 #include <scheduler.h>
 #include <spork.h>
+#include <statsd_client.h>
 #include <txmempool.h>
 #include <util/thread.h>
+#include <util/trace.h>
 #include <util/time.h>
 #include <validation.h>
 #include <validationinterface.h>
 
+#include <cxxtimer.hpp>
+
+#include <algorithm>
+#include <unordered_set>
+
 namespace llmq
 {
 std::unique_ptr<CChainLocksHandler> chainLocksHandler;
@@ -89,42 +99,90 @@ CChainLockSig CChainLocksHandler::GetBestChainLock() const
     return bestChainLock;
 }
 
-PeerMsgRet CChainLocksHandler::ProcessMessage(const CNode& pfrom, const std::string& msg_type, CDataStream& vRecv)
+PeerMsgRet CChainLocksHandler::ProcessMessage(const CNode& pfrom, gsl::not_null<PeerManager*> peerman, const std::string& msg_type, CDataStream& vRecv)
 {
     if (!AreChainLocksEnabled(spork_manager)) {
         return {};
     }
 
     if (msg_type == NetMsgType::CLSIG) {
+        if (m_peerman == nullptr) {
+            m_peerman = peerman;
+        }
+        // we should never use one CChainLocksHandler with different PeerManager
+        assert(m_peerman == peerman);
+
         CChainLockSig clsig;
         vRecv >> clsig;
+        const uint256 hash = ::SerializeHash(clsig);
+
+        WITH_LOCK(cs_main, EraseObjectRequest(pfrom.GetId(), CInv(MSG_CLSIG, hash)));
 
-        return ProcessNewChainLock(pfrom.GetId(), clsig, ::SerializeHash(clsig));
+        {
+            LOCK(cs);
+            if (!InternalIsNewChainLock(clsig, hash)) {
+                return {};
+            }
+            // Don't verify right away, CLSIGs from all peers are collected for a short while and then verified
+            // together in ProcessPendingChainLocks
+            pendingChainLocks.try_emplace(hash, pfrom.GetId(), clsig);
+        }
+
+        if (bool expected = false; pendingChainLocksScheduled.compare_exchange_strong(expected, true)) {
+            scheduler->scheduleFromNow([&]() {
+                ProcessPendingChainLocks();
+            }, PENDING_CLSIG_BATCH_WINDOW);
+        }
+    } else if (msg_type == NetMsgType::CMPCTCLSIG) {
+        if (m_peerman == nullptr) {
+            m_peerman = peerman;
+        }
+        assert(m_peerman == peerman);
+
+        CCompactChainLockSig cmpctclsig;
+        vRecv >> cmpctclsig;
+        const CInv inv(MSG_CLSIG, cmpctclsig.hash);
+        if (AlreadyHave(inv)) {
+            return {};
+        }
+
+        if (const auto clsig = ReconstructChainLock(cmpctclsig)) {
+            return ProcessNewChainLock(pfrom.GetId(), *clsig, cmpctclsig.hash);
+        }
+        // We don't have the recovered sig (yet), fall back to fetching the full CLSIG
+        LOCK(cs_main);
+        RequestObject(pfrom.GetId(), inv, GetTime<std::chrono::microseconds>());
     }
     return {};
 }
 
+std::optional<CChainLockSig> CChainLocksHandler::ReconstructChainLock(const CCompactChainLockSig& cmpctclsig) const
+{
+    const uint256 requestId = ::SerializeHash(std::make_pair(CLSIG_REQUESTID_PREFIX, cmpctclsig.nHeight));
+    CRecoveredSig recSig;
+    if (!sigman.GetRecoveredSigForId(Params().GetConsensus().llmqTypeChainLocks, requestId, recSig) ||
+            recSig.getMsgHash() != cmpctclsig.blockHash) {
+        return std::nullopt;
+    }
+
+    CChainLockSig clsig = cmpctclsig.Expand(recSig.sig.Get());
+    if (!cmpctclsig.Matches(clsig)) {
+        return std::nullopt;
+    }
+    return clsig;
+}
+
 PeerMsgRet CChainLocksHandler::ProcessNewChainLock(const NodeId from, const llmq::CChainLockSig& clsig, const uint256& hash)
 {
     CheckActiveState();
 
-    CInv clsigInv(MSG_CLSIG, hash);
-
     if (from != -1) {
         LOCK(cs_main);
-        EraseObjectRequest(from, clsigInv);
+        EraseObjectRequest(from, CInv(MSG_CLSIG, hash));
     }
 
-    {
-        LOCK(cs);
-        if (!seenChainLocks.emplace(hash, GetTimeMillis()).second) {
-            return {};
-        }
-
-        if (!bestChainLock.IsNull() && clsig.getHeight() <= bestChainLock.getHeight()) {
-            // no need to process/relay older CLSIGs
-            return {};
-        }
+    if (!WITH_LOCK(cs, return InternalIsNewChainLock(clsig, hash))) {
+        return {};
     }
 
     if (!VerifyChainLock(clsig)) {
@@ -135,6 +193,102 @@ PeerMsgRet CChainLocksHandler::ProcessNewChainLock(const NodeId from, const llmq
         return {};
     }
 
+    ProcessVerifiedChainLock(from, clsig, hash);
+    return {};
+}
+
+void CChainLocksHandler::ProcessPendingChainLocks()
+{
+    // reset the flag before taking the queue, so that CLSIGs arriving from now on schedule another run
+    pendingChainLocksScheduled = false;
+
+    decltype(pendingChainLocks) pend;
+    {
+        LOCK(cs);
+        pend.swap(pendingChainLocks);
+    }
+
+    if (pend.empty()) {
+        return;
+    }
+
+    CheckActiveState();
+
+    const auto llmqType = Params().GetConsensus().llmqTypeChainLocks;
+    const auto& llmq_params_opt = Params().GetLLMQ(llmqType);
+    assert(llmq_params_opt);
+
+    // A single aggregated verification for the whole batch, per-source and per-message checks are only done if it fails
+    CBLSBatchVerifier<NodeId, uint256> batchVerifier(false, true, 0, /* useSigCache */ true);
+    std::unordered_set<uint256, StaticSaltedHasher> invalidCLSigs;
+
+    for (const auto& [hash, nodeid_clsig_pair] : pend) {
+        const auto& [nodeId, clsig] = nodeid_clsig_pair;
+
+        if (!clsig.getSig().IsValid()) {
+            invalidCLSigs.emplace(hash);
+            continue;
+        }
+
+        const uint256 nRequestId = ::SerializeHash(std::make_pair(llmq::CLSIG_REQUESTID_PREFIX, clsig.getHeight()));
+        const auto quorum = llmq::SelectQuorumForSigning(llmq_params_opt.value(), qman, nRequestId, clsig.getHeight());
+        if (!quorum) {
+            invalidCLSigs.emplace(hash);
+            continue;
+        }
+
+        const uint256 signHash = llmq::BuildSignHash(llmqType, quorum->qc->quorumHash, nRequestId, clsig.getBlockHash());
+        batchVerifier.PushMessage(nodeId, hash, signHash, clsig.getSig(), quorum->qc->quorumPublicKey);
+    }
+
+    cxxtimer::Timer verifyTimer(true);
+    batchVerifier.Verify();
+    verifyTimer.stop();
+
+    LogPrint(BCLog::CHAINLOCKS, "CChainLocksHandler::%s -- verified CLSIGs. count=%d, vt=%d, nodes=%d\n", __func__,
+             pend.size() - invalidCLSigs.size(), verifyTimer.count(), batchVerifier.GetUniqueSourceCount());
+
+    invalidCLSigs.insert(batchVerifier.badMessages.begin(), batchVerifier.badMessages.end());
+
+    // Accept in order of height, so that every valid CLSIG which improves on the best one gets relayed
+    std::vector<std::pair<uint256, std::pair<NodeId, CChainLockSig>>> valid;
+    valid.reserve(pend.size());
+    std::set<NodeId> badSources;
+    for (const auto& [hash, nodeid_clsig_pair] : pend) {
+        if (invalidCLSigs.count(hash)) {
+            LogPrint(BCLog::CHAINLOCKS, "CChainLocksHandler::%s -- invalid CLSIG (%s), peer=%d\n", __func__,
+                     nodeid_clsig_pair.second.ToString(), nodeid_clsig_pair.first);
+            badSources.emplace(nodeid_clsig_pair.first);
+            continue;
+        }
+        valid.emplace_back(hash, nodeid_clsig_pair);
+    }
+    std::sort(valid.begin(), valid.end(), [](const auto& a, const auto& b) {
+        return a.second.second.getHeight() < b.second.second.getHeight();
+    });
+
+    if (!badSources.empty()) {
+        LOCK(cs_main);
+        for (const auto& nodeId : badSources) {
+            m_peerman.load()->Misbehaving(nodeId, 10);
+        }
+    }
+
+    for (const auto& [hash, nodeid_clsig_pair] : valid) {
+        const auto& [nodeId, clsig] = nodeid_clsig_pair;
+        {
+            LOCK(cs);
+            if (!bestChainLock.IsNull() && clsig.getHeight() <= bestChainLock.getHeight()) {
+                // a newer CLSIG was accepted while this one was pending
+                continue;
+            }
+        }
+        ProcessVerifiedChainLock(nodeId, clsig, hash);
+    }
+}
+
+void CChainLocksHandler::ProcessVerifiedChainLock(const NodeId from, const llmq::CChainLockSig& clsig, const uint256& hash)
+{
     CBlockIndex* pindex = WITH_LOCK(cs_main, return m_chainstate.m_blockman.LookupBlockIndex(clsig.getBlockHash()));
 
     {
@@ -149,24 +303,37 @@ PeerMsgRet CChainLocksHandler::ProcessNewChainLock(const NodeId from, const llmq
                 LogPrintf("CChainLocksHandler::%s -- height of CLSIG (%s) does not match the specified block's height (%d)\n",
                         __func__, clsig.ToString(), pindex->nHeight);
                 // Note: not relaying clsig here
-                return {};
+                return;
             }
 
             bestChainLockWithKnownBlock = bestChainLock;
             bestChainLockBlockIndex = pindex;
+
+            statsClient.gauge("chainlocks.height", clsig.getHeight(), 1.0f);
+            if (const auto it = blockConnectedTime.find(clsig.getBlockHash()); it != blockConnectedTime.end()) {
+                statsClient.timing("chainlocks.blockToChainLock_ms", std::max<int64_t>(GetTimeMillis() - it->second, 0), 1.0f);
+            }
         }
         // else if (pindex == nullptr)
         // Note: make sure to still relay clsig further.
     }
 
+    TRACE4(chainlocks, accepted,
+        clsig.getBlockHash().data(),
+        clsig.getHeight(),
+        from,
+        pindex != nullptr
+    );
+
     // Note: do not hold cs while calling RelayInv
     AssertLockNotHeld(cs);
+    CInv clsigInv(MSG_CLSIG, hash);
     connman.RelayInv(clsigInv);
 
     if (pindex == nullptr) {
         // we don't know the block/header for this CLSIG yet, so bail out for now
         // when the block or the header later comes in, we will enforce the correct chain
-        return {};
+        return;
     }
 
     scheduler->scheduleFromNow([&]() {
@@ -176,7 +343,6 @@ PeerMsgRet CChainLocksHandler::ProcessNewChainLock(const NodeId from, const llmq
 
     LogPrint(BCLog::CHAINLOCKS, "CChainLocksHandler::%s -- processed new CLSIG (%s), peer=%d\n",
               __func__, clsig.ToString(), from);
-    return {};
 }
 
 void CChainLocksHandler::AcceptedBlockHeader(gsl::not_null<const CBlockIndex*> pindexNew)
@@ -311,17 +477,25 @@ void CChainLocksHandler::TrySignChainTip()
                 continue;
             }
 
-            for (const auto& txid : *txids) {
-                int64_t txAge = 0;
-                {
-                    LOCK(cs);
+            // collect the TXs which are not old enough yet in one go, IsLocked must be called without holding cs
+            std::vector<std::pair<uint256, int64_t>> youngTxs;
+            {
+                LOCK(cs);
+                const int64_t nNow = GetTime<std::chrono::seconds>().count();
+                for (const auto& txid : *txids) {
+                    int64_t txAge = 0;
                     auto it = txFirstSeenTime.find(txid);
                     if (it != txFirstSeenTime.end()) {
-                        txAge = GetTime<std::chrono::seconds>().count() - it->second;
+                        txAge = nNow - it->second;
+                    }
+                    if (txAge < WAIT_FOR_ISLOCK_TIMEOUT) {
+                        youngTxs.emplace_back(txid, txAge);
                     }
                 }
+            }
 
-                if (txAge < WAIT_FOR_ISLOCK_TIMEOUT && !quorumInstantSendManager->IsLocked(txid)) {
+            for (const auto& [txid, txAge] : youngTxs) {
+                if (!quorumInstantSendManager->IsLocked(txid)) {
                     LogPrint(BCLog::CHAINLOCKS, "CChainLocksHandler::%s -- not signing block %s due to TX %s not being islocked and not old enough. age=%d\n", __func__,
                               pindexWalk->GetBlockHash().ToString(), txid.ToString(), txAge);
                     return;
@@ -356,7 +530,26 @@ void CChainLocksHandler::TransactionAddedToMempool(const CTransactionRef& tx, in
     }
 
     LOCK(cs);
-    txFirstSeenTime.emplace(tx->GetHash(), nAcceptTime);
+    AddTxFirstSeen(tx->GetHash(), nAcceptTime);
+}
+
+void CChainLocksHandler::AddTxFirstSeen(const uint256& txid, int64_t nTime)
+{
+    AssertLockHeld(cs);
+    if (txFirstSeenTime.emplace(txid, nTime).second) {
+        AddToCurrentSeenBucket(txid);
+    }
+}
+
+void CChainLocksHandler::AddToCurrentSeenBucket(const uint256& txid)
+{
+    AssertLockHeld(cs);
+    const int64_t nBucket = GetTime<std::chrono::seconds>().count() / TX_SEEN_BUCKET_INTERVAL;
+    // with mocktime going backwards, keep adding to the newest bucket so that the buckets stay ordered
+    if (txFirstSeenBuckets.empty() || txFirstSeenBuckets.back().first < nBucket) {
+        txFirstSeenBuckets.emplace_back(nBucket, std::vector<uint256>());
+    }
+    txFirstSeenBuckets.back().second.emplace_back(txid);
 }
 
 void CChainLocksHandler::BlockConnected(const std::shared_ptr<const CBlock>& pblock, gsl::not_null<const CBlockIndex*> pindex)
@@ -369,33 +562,33 @@ void CChainLocksHandler::BlockConnected(const std::shared_ptr<const CBlock>& pbl
     // We need this information later when we try to sign a new tip, so that we can determine if all included TXs are
     // safe.
 
-    LOCK(cs);
-
-    auto it = blockTxs.find(pindex->GetBlockHash());
-    if (it == blockTxs.end()) {
-        // we must create this entry even if there are no lockable transactions in the block, so that TrySignChainTip
-        // later knows about this block
-        it = blockTxs.emplace(pindex->GetBlockHash(), std::make_shared<std::unordered_set<uint256, StaticSaltedHasher>>()).first;
-    }
-    auto& txids = *it->second;
-
-    int64_t curTime = GetTime<std::chrono::seconds>().count();
-
+    auto txids = std::make_shared<std::vector<uint256>>();
+    txids->reserve(pblock->vtx.size());
     for (const auto& tx : pblock->vtx) {
         if (tx->IsCoinBase() || tx->vin.empty()) {
             continue;
         }
-
-        txids.emplace(tx->GetHash());
-        txFirstSeenTime.emplace(tx->GetHash(), curTime);
+        txids->emplace_back(tx->GetHash());
     }
 
+    LOCK(cs);
+
+    // we must create this entry even if there are no lockable transactions in the block, so that TrySignChainTip
+    // later knows about this block
+    blockTxs.insert_or_assign(pindex->GetBlockHash(), txids);
+    blockConnectedTime.try_emplace(pindex->GetBlockHash(), GetTimeMillis());
+
+    int64_t curTime = GetTime<std::chrono::seconds>().count();
+    for (const auto& txid : *txids) {
+        AddTxFirstSeen(txid, curTime);
+    }
 }
 
 void CChainLocksHandler::BlockDisconnected(const std::shared_ptr<const CBlock>& pblock, gsl::not_null<const CBlockIndex*> pindexDisconnected)
 {
     LOCK(cs);
     blockTxs.erase(pindexDisconnected->GetBlockHash());
+    blockConnectedTime.erase(pindexDisconnected->GetBlockHash());
 }
 
 CChainLocksHandler::BlockTxs::mapped_type CChainLocksHandler::GetBlockTxs(const uint256& blockHash)
@@ -427,13 +620,15 @@ CChainLocksHandler::BlockTxs::mapped_type CChainLocksHandler::GetBlockTxs(const
                 return nullptr;
             }
 
-            ret = std::make_shared<std::unordered_set<uint256, StaticSaltedHasher>>();
+            auto txids = std::make_shared<std::vector<uint256>>();
+            txids->reserve(block.vtx.size());
             for (auto& tx : block.vtx) {
                 if (tx->IsCoinBase() || tx->vin.empty()) {
                     continue;
                 }
-                ret->emplace(tx->GetHash());
+                txids->emplace_back(tx->GetHash());
             }
+            ret = std::move(txids);
 
             blockTime = block.nTime;
         }
@@ -441,7 +636,7 @@ CChainLocksHandler::BlockTxs::mapped_type CChainLocksHandler::GetBlockTxs(const
         LOCK(cs);
         blockTxs.emplace(blockHash, ret);
         for (const auto& txid : *ret) {
-            txFirstSeenTime.emplace(txid, blockTime);
+            AddTxFirstSeen(txid, blockTime);
         }
     }
     return ret;
@@ -556,6 +751,22 @@ bool CChainLocksHandler::VerifyChainLock(const CChainLockSig& clsig) const
     return llmq::VerifyRecoveredSig(llmqType, qman, clsig.getHeight(), nRequestId, clsig.getBlockHash(), clsig.getSig());
 }
 
+bool CChainLocksHandler::InternalIsNewChainLock(const CChainLockSig& clsig, const uint256& hash)
+{
+    AssertLockHeld(cs);
+
+    if (!seenChainLocks.emplace(hash, GetTimeMillis()).second) {
+        return false;
+    }
+
+    if (!bestChainLock.IsNull() && clsig.getHeight() <= bestChainLock.getHeight()) {
+        // no need to process/relay older CLSIGs
+        return false;
+    }
+
+    return true;
+}
+
 bool CChainLocksHandler::InternalHasChainLock(int nHeight, const uint256& blockHash) const
 {
     AssertLockHeld(cs);
@@ -639,30 +850,49 @@ void CChainLocksHandler::Cleanup()
             for (const auto& txid : *it->second) {
                 txFirstSeenTime.erase(txid);
             }
+            blockConnectedTime.erase(it->first);
             it = blockTxs.erase(it);
         } else if (InternalHasConflictingChainLock(pindex->nHeight, pindex->GetBlockHash())) {
+            blockConnectedTime.erase(it->first);
             it = blockTxs.erase(it);
         } else {
             ++it;
         }
     }
-    for (auto it = txFirstSeenTime.begin(); it != txFirstSeenTime.end(); ) {
-        uint256 hashBlock;
-        CTransactionRef tx = GetTransaction(/* block_index */ nullptr, &mempool, it->first, Params().GetConsensus(), hashBlock);
-        if (!tx) {
-            // tx has vanished, probably due to conflicts
-            it = txFirstSeenTime.erase(it);
-        } else if (!hashBlock.IsNull()) {
-            const auto* pindex = m_chainstate.m_blockman.LookupBlockIndex(hashBlock);
-            if (m_chainstate.m_chain.Tip()->GetAncestor(pindex->nHeight) == pindex && m_chainstate.m_chain.Height() - pindex->nHeight >= 6) {
-                // tx got confirmed >= 6 times, so we can stop keeping track of it
-                it = txFirstSeenTime.erase(it);
+    // Only look at the txs of the buckets before the current one, the ones which are still tracked afterwards are
+    // moved to the current bucket so that they are checked again one bucket interval later
+    const int64_t nCurrentBucket = GetTime<std::chrono::seconds>().count() / TX_SEEN_BUCKET_INTERVAL;
+    std::vector<uint256> vStillTracked;
+    while (!txFirstSeenBuckets.empty() && txFirstSeenBuckets.front().first < nCurrentBucket) {
+        for (const auto& txid : txFirstSeenBuckets.front().second) {
+            auto it = txFirstSeenTime.find(txid);
+            if (it == txFirstSeenTime.end()) {
+                continue;
+            }
+            uint256 hashBlock;
+            CTransactionRef tx = GetTransaction(/* block_index */ nullptr, &mempool, txid, Params().GetConsensus(), hashBlock);
+            if (!tx) {
+                // tx has vanished, probably due to conflicts
+                txFirstSeenTime.erase(it);
+            } else if (!hashBlock.IsNull()) {
+                const auto* pindex = m_chainstate.m_blockman.LookupBlockIndex(hashBlock);
+                if (m_chainstate.m_chain.Tip()->GetAncestor(pindex->nHeight) == pindex && m_chainstate.m_chain.Height() - pindex->nHeight >= 6) {
+                    // tx got confirmed >= 6 times, so we can stop keeping track of it
+                    txFirstSeenTime.erase(it);
+                } else {
+                    vStillTracked.emplace_back(txid);
+                }
             } else {
-                ++it;
+                vStillTracked.emplace_back(txid);
             }
-        } else {
-            ++it;
         }
+        txFirstSeenBuckets.pop_front();
+    }
+    // a tx which was erased and added again is in two buckets
+    std::sort(vStillTracked.begin(), vStillTracked.end());
+    vStillTracked.erase(std::unique(vStillTracked.begin(), vStillTracked.end()), vStillTracked.end());
+    for (const auto& txid : vStillTracked) {
+        AddToCurrentSeenBucket(txid);
     }
 
     lastCleanupTime = GetTimeMillis();
@@ -19,15 +19,19 @@
 #include <gsl/pointers.h>
 
 #include <atomic>
+#include <chrono>
+#include <deque>
 #include <map>
+#include <optional>
 #include <unordered_map>
-#include <unordered_set>
+#include <vector>
 
 class CChainState;
 class CConnman;
 class CBlockIndex;
 class CMasternodeSync;
 class CScheduler;
+class PeerManager;
 class CSporkManager;
 class CTxMemPool;
 
@@ -44,6 +48,12 @@ class CChainLocksHandler : public CRecoveredSigsListener
     // how long to wait for islocks until we consider a block with non-islocked TXs to be safe to sign
     static constexpr int64_t WAIT_FOR_ISLOCK_TIMEOUT = 10 * 60;
 
+    // width in seconds of the txFirstSeenBuckets buckets, Cleanup looks at an entry at most once per bucket
+    static constexpr int64_t TX_SEEN_BUCKET_INTERVAL = 10 * 60;
+
+    // how long to collect CLSIGs received from peers before verifying them in one batch
+    static constexpr auto PENDING_CLSIG_BATCH_WINDOW = std::chrono::milliseconds{100};
+
 private:
     CChainState& m_chainstate;
     CConnman& connman;
@@ -59,6 +69,8 @@ private:
     mutable Mutex cs;
     std::atomic<bool> tryLockChainTipScheduled{false};
     std::atomic<bool> isEnabled{false};
+    std::atomic<bool> pendingChainLocksScheduled{false};
+    std::atomic<PeerManager*> m_peerman{nullptr};
 
     uint256 bestChainLockHash GUARDED_BY(cs);
     CChainLockSig bestChainLock GUARDED_BY(cs);
@@ -76,12 +88,20 @@ private:
     {
         size_t operator()(const uint256& hash) const { return ReadLE64(hash.begin()); }
     };
-    using BlockTxs = std::unordered_map<uint256, std::shared_ptr<std::unordered_set<uint256, StaticSaltedHasher>>, BlockHasher>;
+    using BlockTxs = std::unordered_map<uint256, std::shared_ptr<const std::vector<uint256>>, BlockHasher>;
     BlockTxs blockTxs GUARDED_BY(cs);
     std::unordered_map<uint256, int64_t, StaticSaltedHasher> txFirstSeenTime GUARDED_BY(cs);
+    // txids of txFirstSeenTime by the bucket (time / TX_SEEN_BUCKET_INTERVAL) they were added or last checked in,
+    // oldest first. May contain txids which were erased from txFirstSeenTime already.
+    std::deque<std::pair<int64_t, std::vector<uint256>>> txFirstSeenBuckets GUARDED_BY(cs);
+    // Time in milliseconds a block in blockTxs was connected, for block-to-ChainLock stats
+    std::unordered_map<uint256, int64_t, BlockHasher> blockConnectedTime GUARDED_BY(cs);
 
     std::map<uint256, int64_t> seenChainLocks GUARDED_BY(cs);
 
+    // CLSIGs received from peers which still need to be verified, keyed by CLSIG hash
+    std::unordered_map<uint256, std::pair<NodeId, CChainLockSig>, StaticSaltedHasher> pendingChainLocks GUARDED_BY(cs);
+
     std::atomic<int64_t> lastCleanupTime{0};
 
 public:
@@ -97,7 +117,7 @@ public:
     bool GetChainLockByHash(const uint256& hash, CChainLockSig& ret) const LOCKS_EXCLUDED(cs);
     CChainLockSig GetBestChainLock() const LOCKS_EXCLUDED(cs);
 
-    PeerMsgRet ProcessMessage(const CNode& pfrom, const std::string& msg_type, CDataStream& vRecv);
+    PeerMsgRet ProcessMessage(const CNode& pfrom, gsl::not_null<PeerManager*> peerman, const std::string& msg_type, CDataStream& vRecv) LOCKS_EXCLUDED(cs);
     PeerMsgRet ProcessNewChainLock(NodeId from, const CChainLockSig& clsig, const uint256& hash) LOCKS_EXCLUDED(cs);
 
     void AcceptedBlockHeader(gsl::not_null<const CBlockIndex*> pindexNew) LOCKS_EXCLUDED(cs);
@@ -120,8 +140,16 @@ private:
     // these require locks to be held already
     bool InternalHasChainLock(int nHeight, const uint256& blockHash) const EXCLUSIVE_LOCKS_REQUIRED(cs);
     bool InternalHasConflictingChainLock(int nHeight, const uint256& blockHash) const EXCLUSIVE_LOCKS_REQUIRED(cs);
+    bool InternalIsNewChainLock(const CChainLockSig& clsig, const uint256& hash) EXCLUSIVE_LOCKS_REQUIRED(cs);
+
+    std::optional<CChainLockSig> ReconstructChainLock(const CCompactChainLockSig& cmpctclsig) const;
+
+    void ProcessPendingChainLocks() LOCKS_EXCLUDED(cs);
+    void ProcessVerifiedChainLock(NodeId from, const CChainLockSig& clsig, const uint256& hash) LOCKS_EXCLUDED(cs);
 
     BlockTxs::mapped_type GetBlockTxs(const uint256& blockHash) LOCKS_EXCLUDED(cs);
+    void AddTxFirstSeen(const uint256& txid, int64_t nTime) EXCLUSIVE_LOCKS_REQUIRED(cs);
+    void AddToCurrentSeenBucket(const uint256& txid) EXCLUSIVE_LOCKS_REQUIRED(cs);
 
     void Cleanup() LOCKS_EXCLUDED(cs);
 };
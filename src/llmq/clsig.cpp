@@ -3,6 +3,7 @@
 // file COPYING or http://www.opensource.org/licenses/mit-license.php.
 
 #include <llmq/clsig.h>
+#include <hash.h>
 #include <tinyformat.h>
 
 namespace llmq {
@@ -24,4 +25,11 @@ namespace llmq {
     {
         return nHeight == -1 && blockHash == uint256();
     }
+
+    CChainLockSig CCompactChainLockSig::Expand(const CBLSSignature& sig) const {
+        return CChainLockSig(nHeight, blockHash, sig);
+    }
+    bool CCompactChainLockSig::Matches(const CChainLockSig& clsig) const {
+        return ::SerializeHash(clsig) == hash;
+    }
 }
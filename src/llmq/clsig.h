@@ -41,6 +41,31 @@ public:
         READWRITE(obj.nHeight, obj.blockHash, obj.sig);
     }
 };
+
+/**
+ * A CLSIG without its signature, which peers that know the recovered sig can rebuild. `hash` is the hash of the
+ * full CLSIG and is used to check the result.
+ */
+struct CCompactChainLockSig
+{
+    uint256 hash;
+    int32_t nHeight{-1};
+    uint256 blockHash;
+
+    CCompactChainLockSig() = default;
+    CCompactChainLockSig(const uint256& _hash, const CChainLockSig& clsig) :
+        hash(_hash), nHeight(clsig.getHeight()), blockHash(clsig.getBlockHash()) {}
+
+    SERIALIZE_METHODS(CCompactChainLockSig, obj)
+    {
+        READWRITE(obj.hash, obj.nHeight, obj.blockHash);
+    }
+
+    /** The CLSIG for this height and block, signed with the given recovered sig */
+    CChainLockSig Expand(const CBLSSignature& sig) const;
+    /** Whether clsig is the CLSIG this was made from, only then it may be used in place of fetching it */
+    bool Matches(const CChainLockSig& clsig) const;
+};
 } // namespace llmq
 
 #endif // BITCOIN_LLMQ_CLSIG_H
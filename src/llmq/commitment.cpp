@@ -4,6 +4,7 @@
 
 #include <llmq/commitment.h>
 
+#include <bls/bls_sigcache.h>
 #include <evo/deterministicmns.h>
 #include <evo/specialtx.h>
 
@@ -129,12 +130,12 @@ bool CFinalCommitment::Verify(gsl::not_null<const CBlockIndex*> pQuorumBaseBlock
             memberPubKeys.emplace_back(members[i]->pdmnState->pubKeyOperator.Get());
         }
 
-        if (!membersSig.VerifySecureAggregated(memberPubKeys, commitmentHash)) {
+        if (!VerifySecureAggregatedCached(membersSig, memberPubKeys, commitmentHash)) {
             LogPrintfFinalCommitment("q[%s] invalid aggregated members signature\n", quorumHash.ToString());
             return false;
         }
 
-        if (!quorumSig.VerifyInsecure(quorumPublicKey, commitmentHash)) {
+        if (!VerifyInsecureCached(quorumSig, quorumPublicKey, commitmentHash)) {
             LogPrintfFinalCommitment("q[%s] invalid quorum signature\n", quorumHash.ToString());
             return false;
         }
@@ -36,11 +36,11 @@ UniValue CDKGDebugSessionStatus::ToJson(int quorumIndex, int detailLevel) const
     ret.pushKV("quorumHeight", (int)quorumHeight);
     ret.pushKV("phase", ToUnderlying(phase));
 
-    ret.pushKV("sentContributions", statusBits.sentContributions);
-    ret.pushKV("sentComplaint", statusBits.sentComplaint);
-    ret.pushKV("sentJustification", statusBits.sentJustification);
-    ret.pushKV("sentPrematureCommitment", statusBits.sentPrematureCommitment);
-    ret.pushKV("aborted", statusBits.aborted);
+    ret.pushKV("sentContributions", Has(DKGSessionStatus::SentContributions));
+    ret.pushKV("sentComplaint", Has(DKGSessionStatus::SentComplaint));
+    ret.pushKV("sentJustification", Has(DKGSessionStatus::SentJustification));
+    ret.pushKV("sentPrematureCommitment", Has(DKGSessionStatus::SentPrematureCommitment));
+    ret.pushKV("aborted", Has(DKGSessionStatus::Aborted));
 
     struct ArrOrCount {
         int count{0};
@@ -53,7 +53,6 @@ UniValue CDKGDebugSessionStatus::ToJson(int quorumIndex, int detailLevel) const
     ArrOrCount receivedComplaints;
     ArrOrCount receivedJustifications;
     ArrOrCount receivedPrematureCommitments;
-    ArrOrCount complaintsFromMembers;
 
     auto add = [&](ArrOrCount& v, size_t idx, bool flag) {
         if (flag) {
@@ -81,12 +80,12 @@ UniValue CDKGDebugSessionStatus::ToJson(int quorumIndex, int detailLevel) const
 
     for (const auto i : irange::range(members.size())) {
         const auto& m = members[i];
-        add(badMembers, i, m.statusBits.bad);
-        add(weComplain, i, m.statusBits.weComplain);
-        add(receivedContributions, i, m.statusBits.receivedContribution);
-        add(receivedComplaints, i, m.statusBits.receivedComplaint);
-        add(receivedJustifications, i, m.statusBits.receivedJustification);
-        add(receivedPrematureCommitments, i, m.statusBits.receivedPrematureCommitment);
+        add(badMembers, i, m.Has(DKGMemberStatus::Bad));
+        add(weComplain, i, m.Has(DKGMemberStatus::WeComplain));
+        add(receivedContributions, i, m.Has(DKGMemberStatus::ReceivedContribution));
+        add(receivedComplaints, i, m.Has(DKGMemberStatus::ReceivedComplaint));
+        add(receivedJustifications, i, m.Has(DKGMemberStatus::ReceivedJustification));
+        add(receivedPrematureCommitments, i, m.Has(DKGMemberStatus::ReceivedPrematureCommitment));
     }
     push(badMembers, "badMembers");
     push(weComplain, "weComplain");
@@ -106,7 +105,28 @@ UniValue CDKGDebugSessionStatus::ToJson(int quorumIndex, int detailLevel) const
     return ret;
 }
 
-CDKGDebugManager::CDKGDebugManager() = default;
+CDKGDebugManager::LocalSessionStatus::LocalSessionStatus(Consensus::LLMQType _llmqType, const uint256& _quorumHash, uint32_t _quorumHeight, size_t _memberCount) :
+    llmqType(_llmqType),
+    quorumHash(_quorumHash),
+    quorumHeight(_quorumHeight),
+    phase(QuorumPhase{0}),
+    memberCount(_memberCount),
+    memberBitsets(std::make_unique<std::atomic<uint8_t>[]>(_memberCount))
+{
+    for (const auto i : irange::range(memberCount)) {
+        memberBitsets[i].store(0, std::memory_order_relaxed);
+    }
+}
+
+CDKGDebugManager::CDKGDebugManager()
+{
+    for (const auto& [_, params] : Params().GetConsensus().llmqs) {
+        const auto session_count = params.useRotation ? params.signingActiveQuorumCount : 1;
+        for (const auto i : irange::range(session_count)) {
+            localSessions.emplace(std::make_pair(params.type, i), nullptr);
+        }
+    }
+}
 
 UniValue CDKGDebugStatus::ToJson(int detailLevel) const
 {
@@ -134,69 +154,94 @@ UniValue CDKGDebugStatus::ToJson(int detailLevel) const
     return ret;
 }
 
+std::shared_ptr<CDKGDebugManager::LocalSessionStatus> CDKGDebugManager::GetLocalSession(Consensus::LLMQType llmqType, int quorumIndex) const
+{
+    auto it = localSessions.find(std::make_pair(llmqType, quorumIndex));
+    if (it == localSessions.end()) {
+        return nullptr;
+    }
+    return std::atomic_load(&it->second);
+}
+
 void CDKGDebugManager::GetLocalDebugStatus(llmq::CDKGDebugStatus& ret) const
 {
-    LOCK(cs);
-    ret = localStatus;
+    ret.nTime = nTime.load();
+    ret.sessions.clear();
+
+    for (const auto& [key, slot] : localSessions) {
+        const auto session = std::atomic_load(&slot);
+        if (!session) {
+            continue;
+        }
+        auto& status = ret.sessions[key];
+        status.llmqType = session->llmqType;
+        status.quorumHash = session->quorumHash;
+        status.quorumHeight = session->quorumHeight;
+        status.phase = session->phase.load(std::memory_order_relaxed);
+        status.statusBitset = session->statusBitset.load(std::memory_order_relaxed);
+        status.members.resize(session->memberCount);
+        for (const auto i : irange::range(session->memberCount)) {
+            status.members[i].statusBitset = session->memberBitsets[i].load(std::memory_order_relaxed);
+        }
+    }
 }
 
 void CDKGDebugManager::ResetLocalSessionStatus(Consensus::LLMQType llmqType, int quorumIndex)
 {
-    LOCK(cs);
-
-    auto it = localStatus.sessions.find(std::make_pair(llmqType, quorumIndex));
-    if (it == localStatus.sessions.end()) {
+    auto it = localSessions.find(std::make_pair(llmqType, quorumIndex));
+    if (it == localSessions.end()) {
         return;
     }
 
-    localStatus.sessions.erase(it);
-    localStatus.nTime = GetAdjustedTime();
+    if (std::atomic_exchange(&it->second, std::shared_ptr<LocalSessionStatus>()) != nullptr) {
+        nTime = GetAdjustedTime();
+    }
 }
 
 void CDKGDebugManager::InitLocalSessionStatus(const Consensus::LLMQParams& llmqParams, int quorumIndex, const uint256& quorumHash, int quorumHeight)
 {
-    LOCK(cs);
-
-    auto it = localStatus.sessions.find(std::make_pair(llmqParams.type, quorumIndex));
-    if (it == localStatus.sessions.end()) {
-        it = localStatus.sessions.emplace(std::make_pair(llmqParams.type, quorumIndex), CDKGDebugSessionStatus()).first;
+    auto it = localSessions.find(std::make_pair(llmqParams.type, quorumIndex));
+    if (it == localSessions.end()) {
+        return;
     }
 
-    auto& session = it->second;
-    session.llmqType = llmqParams.type;
-    session.quorumHash = quorumHash;
-    session.quorumHeight = (uint32_t)quorumHeight;
-    session.phase = QuorumPhase{0};
-    session.statusBitset = 0;
-    session.members.clear();
-    session.members.resize((size_t)llmqParams.size);
+    std::atomic_store(&it->second, std::make_shared<LocalSessionStatus>(llmqParams.type, quorumHash, (uint32_t)quorumHeight, (size_t)llmqParams.size));
 }
 
-void CDKGDebugManager::UpdateLocalSessionStatus(Consensus::LLMQType llmqType, int quorumIndex, std::function<bool(CDKGDebugSessionStatus& status)>&& func)
+void CDKGDebugManager::UpdateLocalSessionPhase(Consensus::LLMQType llmqType, int quorumIndex, QuorumPhase phase)
 {
-    LOCK(cs);
-
-    auto it = localStatus.sessions.find(std::make_pair(llmqType, quorumIndex));
-    if (it == localStatus.sessions.end()) {
+    const auto session = GetLocalSession(llmqType, quorumIndex);
+    if (!session) {
         return;
     }
 
-    if (func(it->second)) {
-        localStatus.nTime = GetAdjustedTime();
+    if (session->phase.exchange(phase, std::memory_order_relaxed) != phase) {
+        nTime = GetAdjustedTime();
     }
 }
 
-void CDKGDebugManager::UpdateLocalMemberStatus(Consensus::LLMQType llmqType, int quorumIndex, size_t memberIdx, std::function<bool(CDKGDebugMemberStatus& status)>&& func)
+void CDKGDebugManager::UpdateLocalSessionStatus(Consensus::LLMQType llmqType, int quorumIndex, DKGSessionStatus flag)
 {
-    LOCK(cs);
+    const auto session = GetLocalSession(llmqType, quorumIndex);
+    if (!session) {
+        return;
+    }
 
-    auto it = localStatus.sessions.find(std::make_pair(llmqType, quorumIndex));
-    if (it == localStatus.sessions.end()) {
+    const auto mask = static_cast<uint8_t>(flag);
+    session->statusBitset.fetch_or(mask, std::memory_order_relaxed);
+    nTime = GetAdjustedTime();
+}
+
+void CDKGDebugManager::UpdateLocalMemberStatus(Consensus::LLMQType llmqType, int quorumIndex, size_t memberIdx, DKGMemberStatus flag)
+{
+    const auto session = GetLocalSession(llmqType, quorumIndex);
+    if (!session || memberIdx >= session->memberCount) {
         return;
     }
 
-    if (func(it->second.members.at(memberIdx))) {
-        localStatus.nTime = GetAdjustedTime();
+    const auto mask = static_cast<uint8_t>(flag);
+    if ((session->memberBitsets[memberIdx].fetch_or(mask, std::memory_order_relaxed) & mask) == 0) {
+        nTime = GetAdjustedTime();
     }
 }
 
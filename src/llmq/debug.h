@@ -9,8 +9,10 @@
 #include <sync.h>
 #include <univalue.h>
 
-#include <functional>
-#include <set>
+#include <atomic>
+#include <map>
+#include <memory>
+#include <vector>
 
 class CDataStream;
 class CInv;
@@ -21,30 +23,36 @@ namespace llmq
 
 enum class QuorumPhase;
 
+enum class DKGMemberStatus : uint8_t {
+    // is it locally considered as bad (and thus removed from the validMembers set)
+    Bad = 1 << 0,
+    // did we complain about this member
+    WeComplain = 1 << 1,
+
+    // received message for DKG phases
+    ReceivedContribution = 1 << 2,
+    ReceivedComplaint = 1 << 3,
+    ReceivedJustification = 1 << 4,
+    ReceivedPrematureCommitment = 1 << 5,
+};
+
+enum class DKGSessionStatus : uint8_t {
+    // sent messages for DKG phases
+    SentContributions = 1 << 0,
+    SentComplaint = 1 << 1,
+    SentJustification = 1 << 2,
+    SentPrematureCommitment = 1 << 3,
+
+    Aborted = 1 << 4,
+};
+
 class CDKGDebugMemberStatus
 {
 public:
-    union {
-        struct
-        {
-            // is it locally considered as bad (and thus removed from the validMembers set)
-            bool bad : 1;
-            // did we complain about this member
-            bool weComplain : 1;
-
-            // received message for DKG phases
-            bool receivedContribution : 1;
-            bool receivedComplaint : 1;
-            bool receivedJustification : 1;
-            bool receivedPrematureCommitment : 1;
-        } statusBits;
-        uint8_t statusBitset;
-    };
-
-    std::set<uint16_t> complaintsFromMembers;
+    uint8_t statusBitset{0};
 
 public:
-    CDKGDebugMemberStatus() : statusBitset(0) {}
+    bool Has(DKGMemberStatus flag) const { return statusBitset & static_cast<uint8_t>(flag); }
 };
 
 class CDKGDebugSessionStatus
@@ -55,24 +63,12 @@ public:
     uint32_t quorumHeight{0};
     QuorumPhase phase{0};
 
-    union {
-        struct
-        {
-            // sent messages for DKG phases
-            bool sentContributions : 1;
-            bool sentComplaint : 1;
-            bool sentJustification : 1;
-            bool sentPrematureCommitment : 1;
-
-            bool aborted : 1;
-        } statusBits;
-        uint8_t statusBitset;
-    };
+    uint8_t statusBitset{0};
 
     std::vector<CDKGDebugMemberStatus> members;
 
 public:
-    CDKGDebugSessionStatus() : statusBitset(0) {}
+    bool Has(DKGSessionStatus flag) const { return statusBitset & static_cast<uint8_t>(flag); }
 
     UniValue ToJson(int quorumIndex, int detailLevel) const;
 };
@@ -89,11 +85,34 @@ public:
     UniValue ToJson(int detailLevel) const;
 };
 
+/**
+ * Keeps the status of the local DKG sessions for the quorum dkgstatus RPC.
+ *
+ * DKG messages update the status of their sender for every message, so updates must not block. The slots for all
+ * sessions are created in the constructor and never removed, a session status is swapped in atomically by
+ * InitLocalSessionStatus and all its flags are atomics. GetLocalDebugStatus copies the flags into a CDKGDebugStatus
+ * without blocking the updates, the snapshot may therefore miss updates which happen while it is built.
+ */
 class CDKGDebugManager
 {
 private:
-    mutable RecursiveMutex cs;
-    CDKGDebugStatus localStatus GUARDED_BY(cs);
+    struct LocalSessionStatus {
+        const Consensus::LLMQType llmqType;
+        const uint256 quorumHash;
+        const uint32_t quorumHeight;
+        std::atomic<QuorumPhase> phase;
+        std::atomic<uint8_t> statusBitset{0};
+        const size_t memberCount;
+        const std::unique_ptr<std::atomic<uint8_t>[]> memberBitsets;
+
+        LocalSessionStatus(Consensus::LLMQType _llmqType, const uint256& _quorumHash, uint32_t _quorumHeight, size_t _memberCount);
+    };
+
+    //! One slot per LLMQ type and quorum index, only accessed with std::atomic_load/std::atomic_store
+    std::map<std::pair<Consensus::LLMQType, int>, std::shared_ptr<LocalSessionStatus>> localSessions;
+    std::atomic<int64_t> nTime{0};
+
+    std::shared_ptr<LocalSessionStatus> GetLocalSession(Consensus::LLMQType llmqType, int quorumIndex) const;
 
 public:
     CDKGDebugManager();
@@ -103,8 +122,9 @@ public:
     void ResetLocalSessionStatus(Consensus::LLMQType llmqType, int quorumIndex);
     void InitLocalSessionStatus(const Consensus::LLMQParams& llmqParams, int quorumIndex, const uint256& quorumHash, int quorumHeight);
 
-    void UpdateLocalSessionStatus(Consensus::LLMQType llmqType, int quorumIndex, std::function<bool(CDKGDebugSessionStatus& status)>&& func);
-    void UpdateLocalMemberStatus(Consensus::LLMQType llmqType, int quorumIndex, size_t memberIdx, std::function<bool(CDKGDebugMemberStatus& status)>&& func);
+    void UpdateLocalSessionPhase(Consensus::LLMQType llmqType, int quorumIndex, QuorumPhase phase);
+    void UpdateLocalSessionStatus(Consensus::LLMQType llmqType, int quorumIndex, DKGSessionStatus flag);
+    void UpdateLocalMemberStatus(Consensus::LLMQType llmqType, int quorumIndex, size_t memberIdx, DKGMemberStatus flag);
 };
 
 } // namespace llmq
@@ -203,10 +203,7 @@ void CDKGSession::SendContributions(CDKGPendingMessages& pendingMessages)
 
     logger.Flush();
 
-    dkgDebugManager.UpdateLocalSessionStatus(params.type, quorumIndex, [&](CDKGDebugSessionStatus& status) {
-        status.statusBits.sentContributions = true;
-        return true;
-    });
+    dkgDebugManager.UpdateLocalSessionStatus(params.type, quorumIndex, DKGSessionStatus::SentContributions);
 
     pendingMessages.PushPendingMessage(-1, nullptr, qc);
 }
@@ -262,6 +259,9 @@ void CDKGSession::ReceiveMessage(const CDKGContribution& qc, bool& retBan)
 {
     LOCK(cs_pending);
 
+    // apply the results of batches the worker finished in the meantime
+    ProcessContributionVerifications(false);
+
     CDKGLogger logger(*this, __func__);
 
     retBan = false;
@@ -286,10 +286,7 @@ void CDKGSession::ReceiveMessage(const CDKGContribution& qc, bool& retBan)
     CInv inv(MSG_QUORUM_CONTRIB, hash);
     RelayInvToParticipants(inv);
 
-    dkgDebugManager.UpdateLocalMemberStatus(params.type, quorumIndex, member->idx, [&](CDKGDebugMemberStatus& status) {
-        status.statusBits.receivedContribution = true;
-        return true;
-    });
+    dkgDebugManager.UpdateLocalMemberStatus(params.type, quorumIndex, member->idx, DKGMemberStatus::ReceivedContribution);
 
     if (member->contributions.size() > 1) {
         // don't do any further processing if we got more than 1 contribution. we already relayed it,
@@ -305,8 +302,6 @@ void CDKGSession::ReceiveMessage(const CDKGContribution& qc, bool& retBan)
 
     logger.Batch("received and relayed contribution. received=%d/%d, time=%d", receivedCount, members.size(), t1.count());
 
-    cxxtimer::Timer t2(true);
-
     if (!AreWeMember()) {
         // can't further validate
         return;
@@ -314,97 +309,148 @@ void CDKGSession::ReceiveMessage(const CDKGContribution& qc, bool& retBan)
 
     dkgManager.WriteVerifiedVvecContribution(params.type, m_quorum_base_block_index, qc.proTxHash, qc.vvec);
 
-    bool complain = false;
-    CBLSSecretKey skContribution;
-    if (!qc.contributions->Decrypt(*myIdx, WITH_LOCK(activeMasternodeInfoCs, return *activeMasternodeInfo.blsKeyOperator), skContribution, PROTOCOL_VERSION)) {
-        logger.Batch("contribution from %s could not be decrypted", member->dmn->proTxHash.ToString());
-        complain = true;
-    } else if (member->idx != myIdx && ShouldSimulateError(DKGError::type::COMPLAIN_LIE)) {
+    if (member->idx != myIdx && ShouldSimulateError(DKGError::type::COMPLAIN_LIE)) {
         logger.Batch("lying/complaining for %s", member->dmn->proTxHash.ToString());
-        complain = true;
-    }
-
-    if (complain) {
         member->weComplain = true;
-        dkgDebugManager.UpdateLocalMemberStatus(params.type, quorumIndex, member->idx, [&](CDKGDebugMemberStatus& status) {
-            status.statusBits.weComplain = true;
-            return true;
-        });
+        dkgDebugManager.UpdateLocalMemberStatus(params.type, quorumIndex, member->idx, DKGMemberStatus::WeComplain);
         return;
     }
 
-    logger.Batch("decrypted our contribution share. time=%d", t2.count());
-
-    bool verifyPending = false;
-    receivedSkContributions[member->idx] = skContribution;
+    // Our share is decrypted together with the verification of the batch it ends up in, see StartVerifyPendingContributions
     vecEncryptedContributions[member->idx] = qc.contributions;
     pendingContributionVerifications.emplace_back(member->idx);
     if (pendingContributionVerifications.size() >= 32) {
-        verifyPending = true;
+        StartVerifyPendingContributions();
     }
+}
 
-    if (verifyPending) {
-        VerifyPendingContributions();
-    }
+// Verifies all pending secret key contributions and waits for the results of all batches which are still in progress
+void CDKGSession::VerifyPendingContributions()
+{
+    AssertLockHeld(cs_pending);
+
+    StartVerifyPendingContributions();
+    ProcessContributionVerifications(true);
 }
 
-// Verifies all pending secret key contributions in one batch
+// Hands all pending secret key contributions to the BLS worker as one batch, without waiting for the result
+// The worker first decrypts our share from each contribution and then verifies the decrypted ones in one go
 // This is done by aggregating the verification vectors belonging to the secret key contributions
 // The resulting aggregated vvec is then used to recover a public key share
 // The public key share must match the public key belonging to the aggregated secret key contributions
 // See CBLSWorker::VerifyContributionShares for more details.
-void CDKGSession::VerifyPendingContributions()
+void CDKGSession::StartVerifyPendingContributions()
 {
     AssertLockHeld(cs_pending);
 
-    CDKGLogger logger(*this, __func__);
-
-    cxxtimer::Timer t1(true);
-
     std::vector<size_t> pend = std::move(pendingContributionVerifications);
     if (pend.empty()) {
         return;
     }
 
-    std::vector<size_t> memberIndexes;
-    std::vector<BLSVerificationVectorPtr> vvecs;
-    std::vector<CBLSSecretKey> skContributions;
-
+    auto pBatch = contributionVerificationBatches.emplace_back(std::make_shared<ContributionVerificationBatch>());
+    auto& batch = *pBatch;
     for (const auto& idx : pend) {
         const auto& m = members[idx];
         if (m->bad || m->weComplain) {
             continue;
         }
-        memberIndexes.emplace_back(idx);
-        vvecs.emplace_back(receivedVvecs[idx]);
-        skContributions.emplace_back(receivedSkContributions[idx]);
-        // Write here to definitely store one contribution for each member no matter if
-        // our share is valid or not, could be that others are still correct
-        dkgManager.WriteEncryptedContributions(params.type, m_quorum_base_block_index, m->dmn->proTxHash, *vecEncryptedContributions[idx]);
+        batch.memberIndexes.emplace_back(idx);
+        batch.encryptedContributions.emplace_back(vecEncryptedContributions[idx]);
+        batch.vvecs.emplace_back(receivedVvecs[idx]);
     }
+    batch.result = batch.promise.get_future();
 
-    auto result = blsWorker.VerifyContributionShares(myId, vvecs, skContributions);
-    if (result.size() != memberIndexes.size()) {
-        logger.Batch("VerifyContributionShares returned result of size %d but size %d was expected, something is wrong", result.size(), memberIndexes.size());
+    if (batch.memberIndexes.empty()) {
+        batch.promise.set_value({});
         return;
     }
 
-    for (const auto i : irange::range(memberIndexes.size())) {
-        if (!result[i]) {
-            const auto& m = members[memberIndexes[i]];
-            logger.Batch("invalid contribution from %s. will complain later", m->dmn->proTxHash.ToString());
-            m->weComplain = true;
-            dkgDebugManager.UpdateLocalMemberStatus(params.type, quorumIndex, m->idx, [&](CDKGDebugMemberStatus& status) {
-                status.statusBits.weComplain = true;
-                return true;
-            });
-        } else {
-            size_t memberIdx = memberIndexes[i];
-            dkgManager.WriteVerifiedSkContribution(params.type, m_quorum_base_block_index, members[memberIdx]->dmn->proTxHash, skContributions[i]);
+    auto f = [pBatch, myIdx = *myIdx, myId = myId, &worker = blsWorker,
+              operatorKey = WITH_LOCK(activeMasternodeInfoCs, return *activeMasternodeInfo.blsKeyOperator)]() {
+        auto& batch = *pBatch;
+        const size_t count = batch.memberIndexes.size();
+        batch.decrypted.assign(count, 0);
+        batch.skContributions.resize(count);
+        for (const auto i : irange::range(count)) {
+            if (batch.encryptedContributions[i]->Decrypt(myIdx, operatorKey, batch.skContributions[i], PROTOCOL_VERSION)) {
+                batch.decrypted[i] = 1;
+                batch.verifyVvecs.emplace_back(batch.vvecs[i]);
+                batch.verifySkContributions.emplace_back(batch.skContributions[i]);
+            }
+        }
+        if (batch.verifyVvecs.empty()) {
+            batch.promise.set_value(std::vector<char>(count, 0));
+            return;
+        }
+        worker.AsyncVerifyContributionShares(myId, batch.verifyVvecs, batch.verifySkContributions, true, true, [pBatch](const std::vector<bool>& verified) {
+            auto& batch = *pBatch;
+            std::vector<char> result(batch.memberIndexes.size(), 0);
+            if (verified.size() != batch.verifyVvecs.size()) {
+                // signals the unexpected result size to ProcessContributionVerifications
+                batch.promise.set_value({});
+                return;
+            }
+            for (size_t i = 0, j = 0; i < result.size(); i++) {
+                if (batch.decrypted[i]) {
+                    result[i] = verified[j++];
+                }
+            }
+            batch.promise.set_value(std::move(result));
+        });
+    };
+    blsWorker.AsyncRun(std::move(f));
+}
+
+// Applies the results of finished verification batches, in the order they were started. If wait is true, this waits
+// for all batches to finish
+void CDKGSession::ProcessContributionVerifications(bool wait)
+{
+    AssertLockHeld(cs_pending);
+
+    while (!contributionVerificationBatches.empty()) {
+        auto& batch = *contributionVerificationBatches.front();
+        if (!wait && batch.result.wait_for(std::chrono::seconds{0}) != std::future_status::ready) {
+            break;
         }
-    }
 
-    logger.Batch("verified %d pending contributions. time=%d", pend.size(), t1.count());
+        CDKGLogger logger(*this, __func__);
+        cxxtimer::Timer t1(true);
+        const auto result = batch.result.get();
+        logger.Batch("waited for verification of %d contributions. time=%d", batch.memberIndexes.size(), t1.count());
+        if (result.size() != batch.memberIndexes.size()) {
+            logger.Batch("VerifyContributionShares returned a result of unexpected size for %d contributions, something is wrong", batch.verifyVvecs.size());
+            contributionVerificationBatches.pop_front();
+            continue;
+        }
+
+        for (const auto i : irange::range(batch.memberIndexes.size())) {
+            const auto& m = members[batch.memberIndexes[i]];
+            bool complain{false};
+            if (!batch.decrypted[i]) {
+                logger.Batch("contribution from %s could not be decrypted", m->dmn->proTxHash.ToString());
+                complain = true;
+            } else {
+                receivedSkContributions[m->idx] = batch.skContributions[i];
+                // Write here to definitely store one contribution for each member no matter if
+                // our share is valid or not, could be that others are still correct
+                dkgManager.WriteEncryptedContributions(params.type, m_quorum_base_block_index, m->dmn->proTxHash, *batch.encryptedContributions[i]);
+                if (!result[i]) {
+                    logger.Batch("invalid contribution from %s. will complain later", m->dmn->proTxHash.ToString());
+                    complain = true;
+                } else {
+                    dkgManager.WriteVerifiedSkContribution(params.type, m_quorum_base_block_index, m->dmn->proTxHash, batch.skContributions[i]);
+                }
+            }
+            if (complain) {
+                m->weComplain = true;
+                dkgDebugManager.UpdateLocalMemberStatus(params.type, quorumIndex, m->idx, DKGMemberStatus::WeComplain);
+            }
+        }
+
+        logger.Batch("verified %d pending contributions", batch.memberIndexes.size());
+        contributionVerificationBatches.pop_front();
+    }
 }
 
 void CDKGSession::VerifyAndComplain(CDKGPendingMessages& pendingMessages)
@@ -521,10 +567,7 @@ void CDKGSession::SendComplaint(CDKGPendingMessages& pendingMessages)
 
     logger.Flush();
 
-    dkgDebugManager.UpdateLocalSessionStatus(params.type, quorumIndex, [&](CDKGDebugSessionStatus& status) {
-        status.statusBits.sentComplaint = true;
-        return true;
-    });
+    dkgDebugManager.UpdateLocalSessionStatus(params.type, quorumIndex, DKGSessionStatus::SentComplaint);
 
     pendingMessages.PushPendingMessage(-1, nullptr, qc);
 }
@@ -594,10 +637,7 @@ void CDKGSession::ReceiveMessage(const CDKGComplaint& qc, bool& retBan)
     CInv inv(MSG_QUORUM_COMPLAINT, hash);
     RelayInvToParticipants(inv);
 
-    dkgDebugManager.UpdateLocalMemberStatus(params.type, quorumIndex, member->idx, [&](CDKGDebugMemberStatus& status) {
-        status.statusBits.receivedComplaint = true;
-        return true;
-    });
+    dkgDebugManager.UpdateLocalMemberStatus(params.type, quorumIndex, member->idx, DKGMemberStatus::ReceivedComplaint);
 
     if (member->complaints.size() > 1) {
         // don't do any further processing if we got more than 1 complaint. we already relayed it,
@@ -620,9 +660,6 @@ void CDKGSession::ReceiveMessage(const CDKGComplaint& qc, bool& retBan)
         if (qc.complainForMembers[i]) {
             m->complaintsFromOthers.emplace(qc.proTxHash);
             m->someoneComplain = true;
-            dkgDebugManager.UpdateLocalMemberStatus(params.type, quorumIndex, m->idx, [&](CDKGDebugMemberStatus& status) {
-                return status.complaintsFromMembers.emplace(member->idx).second;
-            });
             if (AreWeMember() && i == myIdx) {
                 logger.Batch("%s complained about us", member->dmn->proTxHash.ToString());
             }
@@ -715,10 +752,7 @@ void CDKGSession::SendJustification(CDKGPendingMessages& pendingMessages, const
 
     logger.Flush();
 
-    dkgDebugManager.UpdateLocalSessionStatus(params.type, quorumIndex, [&](CDKGDebugSessionStatus& status) {
-        status.statusBits.sentJustification = true;
-        return true;
-    });
+    dkgDebugManager.UpdateLocalSessionStatus(params.type, quorumIndex, DKGSessionStatus::SentJustification);
 
     pendingMessages.PushPendingMessage(-1, nullptr, qj);
 }
@@ -805,10 +839,7 @@ void CDKGSession::ReceiveMessage(const CDKGJustification& qj, bool& retBan)
     CInv inv(MSG_QUORUM_JUSTIFICATION, hash);
     RelayInvToParticipants(inv);
 
-    dkgDebugManager.UpdateLocalMemberStatus(params.type, quorumIndex, member->idx, [&](CDKGDebugMemberStatus& status) {
-        status.statusBits.receivedJustification = true;
-        return true;
-    });
+    dkgDebugManager.UpdateLocalMemberStatus(params.type, quorumIndex, member->idx, DKGMemberStatus::ReceivedJustification);
 
     if (member->justifications.size() > 1) {
         // don't do any further processing if we got more than 1 justification. we already relayed it,
@@ -1027,10 +1058,7 @@ void CDKGSession::SendCommitment(CDKGPendingMessages& pendingMessages)
 
     logger.Flush();
 
-    dkgDebugManager.UpdateLocalSessionStatus(params.type, quorumIndex, [&](CDKGDebugSessionStatus& status) {
-        status.statusBits.sentPrematureCommitment = true;
-        return true;
-    });
+    dkgDebugManager.UpdateLocalSessionStatus(params.type, quorumIndex, DKGSessionStatus::SentPrematureCommitment);
 
     pendingMessages.PushPendingMessage(-1, nullptr, qc);
 }
@@ -1164,10 +1192,7 @@ void CDKGSession::ReceiveMessage(const CDKGPrematureCommitment& qc, bool& retBan
     CInv inv(MSG_QUORUM_PREMATURE_COMMITMENT, hash);
     RelayInvToParticipants(inv);
 
-    dkgDebugManager.UpdateLocalMemberStatus(params.type, quorumIndex, member->idx, [&](CDKGDebugMemberStatus& status) {
-        status.statusBits.receivedPrematureCommitment = true;
-        return true;
-    });
+    dkgDebugManager.UpdateLocalMemberStatus(params.type, quorumIndex, member->idx, DKGMemberStatus::ReceivedPrematureCommitment);
 
     int receivedCount = ranges::count_if(members, [](const auto& m){ return !m->prematureCommitments.empty(); });
 
@@ -1299,10 +1324,7 @@ void CDKGSession::MarkBadMember(size_t idx)
     if (member->bad) {
         return;
     }
-    dkgDebugManager.UpdateLocalMemberStatus(params.type, quorumIndex, idx, [&](CDKGDebugMemberStatus& status) {
-        status.statusBits.bad = true;
-        return true;
-    });
+    dkgDebugManager.UpdateLocalMemberStatus(params.type, quorumIndex, idx, DKGMemberStatus::Bad);
     member->bad = true;
 }
 
@@ -13,6 +13,8 @@
 #include <util/underlying.h>
 #include <sync.h>
 
+#include <deque>
+#include <future>
 #include <optional>
 
 class UniValue;
@@ -304,8 +306,26 @@ private:
     std::map<uint256, CDKGJustification> justifications GUARDED_BY(invCs);
     std::map<uint256, CDKGPrematureCommitment> prematureCommitments GUARDED_BY(invCs);
 
+    // A batch of received contributions which is decrypted and verified on the BLS worker, while we continue to
+    // receive further contributions. Results are applied in order by ProcessContributionVerifications
+    struct ContributionVerificationBatch {
+        std::vector<size_t> memberIndexes;
+        std::vector<std::shared_ptr<CBLSIESMultiRecipientObjects<CBLSSecretKey>>> encryptedContributions;
+        std::vector<BLSVerificationVectorPtr> vvecs;
+        // filled by the worker, the vvecs and decrypted contributions of the entries which could be decrypted
+        std::vector<char> decrypted;
+        std::vector<CBLSSecretKey> skContributions;
+        std::vector<BLSVerificationVectorPtr> verifyVvecs;
+        std::vector<CBLSSecretKey> verifySkContributions;
+        // one entry per memberIndexes entry, true if our share was decrypted and is valid
+        std::promise<std::vector<char>> promise;
+        std::future<std::vector<char>> result;
+    };
+
     mutable RecursiveMutex cs_pending;
     std::vector<size_t> pendingContributionVerifications GUARDED_BY(cs_pending);
+    // shared with the worker jobs, so that a session can go away while its batches are still in progress
+    std::deque<std::shared_ptr<ContributionVerificationBatch>> contributionVerificationBatches GUARDED_BY(cs_pending);
 
     // filled by ReceivePrematureCommitment and used by FinalizeCommitments
     std::set<uint256> validCommitments GUARDED_BY(invCs);
@@ -337,6 +357,8 @@ public:
     bool PreVerifyMessage(const CDKGContribution& qc, bool& retBan) const;
     void ReceiveMessage(const CDKGContribution& qc, bool& retBan);
     void VerifyPendingContributions() EXCLUSIVE_LOCKS_REQUIRED(cs_pending);
+    void StartVerifyPendingContributions() EXCLUSIVE_LOCKS_REQUIRED(cs_pending);
+    void ProcessContributionVerifications(bool wait) EXCLUSIVE_LOCKS_REQUIRED(cs_pending);
 
     // Phase 2: complaint
     void VerifyAndComplain(CDKGPendingMessages& pendingMessages);
@@ -9,6 +9,7 @@
 #include <llmq/blockprocessor.h>
 #include <llmq/debug.h>
 #include <llmq/options.h>
+#include <llmq/pendingbudget.h>
 #include <llmq/utils.h>
 
 #include <evo/deterministicmns.h>
@@ -17,8 +18,10 @@
 #include <masternode/node.h>
 #include <chainparams.h>
 #include <net_processing.h>
+#include <statsd_client.h>
 #include <validation.h>
 #include <util/thread.h>
+#include <util/trace.h>
 #include <util/underlying.h>
 
 namespace llmq
@@ -84,6 +87,7 @@ void CDKGPendingMessages::PushPendingMessage(NodeId from, PeerManager* peerman,
         return;
     }
 
+    pendingMessagesBudget.Charge(from, pm->size());
     pendingMessages.emplace_back(std::make_pair(from, std::move(pm)));
 }
 
@@ -93,6 +97,7 @@ std::list<CDKGPendingMessages::BinaryMessage> CDKGPendingMessages::PopPendingMes
 
     std::list<BinaryMessage> ret;
     while (!pendingMessages.empty() && ret.size() < maxCount) {
+        pendingMessagesBudget.Release(pendingMessages.front().first, pendingMessages.front().second->size());
         ret.emplace_back(std::move(pendingMessages.front()));
         pendingMessages.pop_front();
     }
@@ -115,6 +120,9 @@ void CDKGPendingMessages::Misbehaving(const NodeId from, const int score)
 void CDKGPendingMessages::Clear()
 {
     LOCK(cs);
+    for (const auto& [from, pm] : pendingMessages) {
+        pendingMessagesBudget.Release(from, pm->size());
+    }
     pendingMessages.clear();
     messagesPerNode.clear();
     seenMessages.clear();
@@ -144,6 +152,15 @@ void CDKGSessionHandler::UpdatedBlockTip(const CBlockIndex* pindexNew)
     if (fNewPhase && phaseInt >= ToUnderlying(QuorumPhase::Initialized) && phaseInt <= ToUnderlying(QuorumPhase::Idle)) {
         phase = static_cast<QuorumPhase>(phaseInt);
     }
+    if (phase != oldPhase) {
+        TRACE5(llmq, dkg_phase,
+            ToUnderlying(params.type),
+            quorumIndex,
+            quorumHash.data(),
+            ToUnderlying(oldPhase),
+            ToUnderlying(phase)
+        );
+    }
 
     LogPrint(BCLog::LLMQ_DKG, "CDKGSessionHandler::%s -- %s qi[%d] currentHeight=%d, pQuorumBaseBlockIndex->nHeight=%d, oldPhase=%d, newPhase=%d\n", __func__,
              params.name, quorumIndex, currentHeight, pQuorumBaseBlockIndex->nHeight, ToUnderlying(oldPhase), ToUnderlying(phase));
@@ -242,11 +259,7 @@ void CDKGSessionHandler::WaitForNextPhase(std::optional<QuorumPhase> curPhase,
     if (nextPhase == QuorumPhase::Initialized) {
         dkgDebugManager.ResetLocalSessionStatus(params.type, quorumIndex);
     } else {
-        dkgDebugManager.UpdateLocalSessionStatus(params.type, quorumIndex, [&](CDKGDebugSessionStatus& status) {
-            bool changed = status.phase != nextPhase;
-            status.phase = nextPhase;
-            return changed;
-        });
+        dkgDebugManager.UpdateLocalSessionPhase(params.type, quorumIndex, nextPhase);
     }
 }
 
@@ -343,10 +356,18 @@ void CDKGSessionHandler::HandlePhase(QuorumPhase curPhase,
 {
     LogPrint(BCLog::LLMQ_DKG, "CDKGSessionManager::%s -- %s qi[%d] - starting, curPhase=%d, nextPhase=%d\n", __func__, params.name, quorumIndex, ToUnderlying(curPhase), ToUnderlying(nextPhase));
 
+    const int64_t phaseStart = GetTimeMillis();
     SleepBeforePhase(curPhase, expectedQuorumHash, randomSleepFactor, runWhileWaiting);
+    const int64_t workStart = GetTimeMillis();
     startPhaseFunc();
+    const int64_t workEnd = GetTimeMillis();
     WaitForNextPhase(curPhase, nextPhase, expectedQuorumHash, runWhileWaiting);
 
+    // The phase length is mostly set by block times, the work done when it starts is what slow members show up in
+    const std::string statsPrefix = strprintf("llmq.dkg.%s.phase%d", params.name, ToUnderlying(curPhase));
+    statsClient.timing(statsPrefix + ".work_ms", workEnd - workStart, 1.0f);
+    statsClient.timing(statsPrefix + ".duration_ms", GetTimeMillis() - phaseStart, 1.0f);
+
     LogPrint(BCLog::LLMQ_DKG, "CDKGSessionManager::%s -- %s qi[%d] - done, curPhase=%d, nextPhase=%d\n", __func__, params.name, quorumIndex, ToUnderlying(curPhase), ToUnderlying(nextPhase));
 }
 
@@ -520,11 +541,7 @@ void CDKGSessionHandler::HandleDKGRound()
         throw AbortPhaseException();
     }
 
-    dkgDebugManager.UpdateLocalSessionStatus(params.type, quorumIndex, [&](CDKGDebugSessionStatus& status) {
-        bool changed = status.phase != QuorumPhase::Initialized;
-        status.phase = QuorumPhase::Initialized;
-        return changed;
-    });
+    dkgDebugManager.UpdateLocalSessionPhase(params.type, quorumIndex, QuorumPhase::Initialized);
 
     utils::EnsureQuorumConnections(params, pQuorumBaseBlockIndex, connman, curSession->myProTxHash);
     if (curSession->AreWeMember()) {
@@ -582,10 +599,7 @@ void CDKGSessionHandler::PhaseHandlerThread()
             LogPrint(BCLog::LLMQ_DKG, "CDKGSessionHandler::%s -- %s qi[%d] - starting HandleDKGRound\n", __func__, params.name, quorumIndex);
             HandleDKGRound();
         } catch (AbortPhaseException& e) {
-            dkgDebugManager.UpdateLocalSessionStatus(params.type, quorumIndex, [&](CDKGDebugSessionStatus& status) {
-                status.statusBits.aborted = true;
-                return true;
-            });
+            dkgDebugManager.UpdateLocalSessionStatus(params.type, quorumIndex, DKGSessionStatus::Aborted);
             LogPrint(BCLog::LLMQ_DKG, "CDKGSessionHandler::%s -- %s qi[%d] - aborted current DKG session\n", __func__, params.name, quorumIndex);
         }
     }
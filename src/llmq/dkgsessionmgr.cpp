@@ -24,10 +24,13 @@ static const std::string DB_VVEC = "qdkg_V";
 static const std::string DB_SKCONTRIB = "qdkg_S";
 static const std::string DB_ENC_CONTRIB = "qdkg_E";
 
+// Contributions of a whole DKG round are written in bursts, which a quarter of the tiny cache size would keep flushing
+static const DBProfile DKGDB_PROFILE{/*bloom_bits=*/10, /*write_buffer_size=*/4 << 20, /*shared_cache=*/true};
+
 CDKGSessionManager::CDKGSessionManager(CBLSWorker& _blsWorker, CChainState& chainstate, CConnman& _connman, CDKGDebugManager& _dkgDebugManager,
                                        CQuorumBlockProcessor& _quorumBlockProcessor, CSporkManager& sporkManager,
                                        bool unitTests, bool fWipe) :
-    db(std::make_unique<CDBWrapper>(unitTests ? "" : (GetDataDir() / "llmq/dkgdb"), 1 << 20, unitTests, fWipe)),
+    db(std::make_unique<CDBWrapper>(unitTests ? "" : (GetDataDir() / "llmq/dkgdb"), 1 << 20, unitTests, fWipe, /*obfuscate=*/false, DKGDB_PROFILE)),
     blsWorker(_blsWorker),
     m_chainstate(chainstate),
     connman(_connman),
@@ -6,21 +6,26 @@
 
 #include <llmq/chainlocks.h>
 #include <llmq/commitment.h>
+#include <llmq/pendingbudget.h>
 #include <llmq/quorums.h>
 #include <llmq/signing_shares.h>
 
 #include <bls/bls_batchverifier.h>
+#include <bls/bls_worker.h>
 #include <chainparams.h>
 #include <consensus/validation.h>
 #include <dbwrapper.h>
 #include <index/txindex.h>
 #include <masternode/sync.h>
+#include <memusage.h>
 #include <net_processing.h>
 #include <spork.h>
+#include <statsd_client.h>
 #include <txmempool.h>
 #include <util/irange.h>
 #include <util/ranges.h>
 #include <util/thread.h>
+#include <util/trace.h>
 #include <validation.h>
 
 #include <cxxtimer.hpp>
@@ -40,8 +45,19 @@ static const std::string_view DB_ARCHIVED_BY_HASH = "is_a2";
 
 static const std::string_view DB_VERSION = "is_v";
 
+//! Pending ISLOCK signatures are batch verified in chunks of this size
+static constexpr size_t ISLOCK_VERIFY_BATCH_SIZE = 32;
+//! Upper bound of locks taken from the pending queue in one round
+static constexpr size_t MAX_PENDING_ISLOCK_BATCH = 512;
+
 std::unique_ptr<CInstantSendManager> quorumInstantSendManager;
 
+//! What a pending islock is charged to its peer in pendingMessagesBudget
+static size_t GetPendingBudgetSize(const CInstantSendLock& islock)
+{
+    return sizeof(CInstantSendLock) + islock.inputs.size() * sizeof(COutPoint);
+}
+
 uint256 CInstantSendLock::GetRequestId() const
 {
     CHashWriter hw(SER_GETHASH, 0);
@@ -53,8 +69,11 @@ uint256 CInstantSendLock::GetRequestId() const
 ////////////////
 
 
+// Most inputs looked up have no islock, a larger bloom filter keeps more of them from reading a table
+static const DBProfile ISDB_PROFILE{/*bloom_bits=*/16, /*write_buffer_size=*/0, /*shared_cache=*/true};
+
 CInstantSendDb::CInstantSendDb(bool unitTests, bool fWipe) :
-    db(std::make_unique<CDBWrapper>(unitTests ? "" : (GetDataDir() / "llmq/isdb"), 32 << 20, unitTests, fWipe))
+    db(std::make_unique<CDBWrapper>(unitTests ? "" : (GetDataDir() / "llmq/isdb"), 32 << 20, unitTests, fWipe, /*obfuscate=*/false, ISDB_PROFILE))
 {
 }
 
@@ -95,7 +114,7 @@ void CInstantSendDb::Upgrade(const CTxMemPool& mempool)
     }
 }
 
-void CInstantSendDb::WriteNewInstantSendLock(const uint256& hash, const CInstantSendLock& islock)
+void CInstantSendDb::WriteNewInstantSendLock(const uint256& hash, const CInstantSendLock& islock, std::optional<int> nMinedHeight)
 {
     LOCK(cs_db);
     CDBBatch batch(*db);
@@ -104,6 +123,9 @@ void CInstantSendDb::WriteNewInstantSendLock(const uint256& hash, const CInstant
     for (const auto& in : islock.inputs) {
         batch.Write(std::make_tuple(DB_HASH_BY_OUTPOINT, in), hash);
     }
+    if (nMinedHeight) {
+        WriteInstantSendLockMined(batch, hash, *nMinedHeight);
+    }
     db->WriteBatch(batch);
 
     auto p = std::make_shared<CInstantSendLock>(islock);
@@ -358,14 +380,23 @@ uint256 CInstantSendDb::GetInstantSendLockHashByTxidInternal(const uint256& txid
 
 CInstantSendLockPtr CInstantSendDb::GetInstantSendLockByTxid(const uint256& txid) const
 {
+    uint256 islockHash;
+    CInstantSendLockPtr ret;
+    if (txidCache.get(txid, islockHash) && islockCache.get(islockHash, ret)) {
+        return ret;
+    }
     LOCK(cs_db);
     return GetInstantSendLockByHashInternal(GetInstantSendLockHashByTxidInternal(txid));
 }
 
 CInstantSendLockPtr CInstantSendDb::GetInstantSendLockByInput(const COutPoint& outpoint) const
 {
-    LOCK(cs_db);
     uint256 islockHash;
+    CInstantSendLockPtr ret;
+    if (outpointCache.get(outpoint, islockHash) && islockCache.get(islockHash, ret)) {
+        return ret;
+    }
+    LOCK(cs_db);
     if (!outpointCache.get(outpoint, islockHash)) {
         if (!db->Read(std::make_tuple(DB_HASH_BY_OUTPOINT, outpoint), islockHash)) {
             return nullptr;
@@ -375,6 +406,31 @@ CInstantSendLockPtr CInstantSendDb::GetInstantSendLockByInput(const COutPoint& o
     return GetInstantSendLockByHashInternal(islockHash);
 }
 
+void CInstantSendDb::PrefetchInputs(const std::vector<COutPoint>& outpoints) const
+{
+    LOCK(cs_db);
+    std::vector<COutPoint> toRead;
+    std::vector<std::tuple<std::string_view, COutPoint>> keys;
+    for (const auto& outpoint : outpoints) {
+        uint256 islockHash;
+        if (!outpointCache.get(outpoint, islockHash)) {
+            toRead.emplace_back(outpoint);
+            keys.emplace_back(DB_HASH_BY_OUTPOINT, outpoint);
+        }
+    }
+    // a single lookup is not worth a batch, GetInstantSendLockByInput will do it
+    if (keys.size() < 2) {
+        return;
+    }
+    std::vector<std::optional<uint256>> islockHashes;
+    db->MultiRead(keys, islockHashes);
+    for (size_t i = 0; i < toRead.size(); i++) {
+        if (islockHashes[i]) {
+            outpointCache.insert(toRead[i], *islockHashes[i]);
+        }
+    }
+}
+
 std::vector<uint256> CInstantSendDb::GetInstantSendLocksByParent(const uint256& parent) const
 {
     AssertLockHeld(cs_db);
@@ -744,8 +800,12 @@ void CInstantSendManager::HandleNewInstantSendLockRecoveredSig(const llmq::CReco
     if (WITH_LOCK(cs_pendingLocks, return pendingInstantSendLocks.count(hash)) || db.KnownInstantSendLock(hash)) {
         return;
     }
-    LOCK(cs_pendingLocks);
-    pendingInstantSendLocks.emplace(hash, std::make_pair(-1, islock));
+    {
+        LOCK(cs_pendingLocks);
+        pendingInstantSendLocks.emplace(hash, std::make_pair(-1, islock));
+        pendingInstantSendLockTimes.try_emplace(hash, GetTimeMillis());
+    }
+    SignalWork();
 }
 
 PeerMsgRet CInstantSendManager::ProcessMessage(const CNode& pfrom, gsl::not_null<PeerManager*> peerman, std::string_view msg_type, CDataStream& vRecv)
@@ -761,9 +821,51 @@ PeerMsgRet CInstantSendManager::ProcessMessage(const CNode& pfrom, gsl::not_null
         vRecv >> *islock;
         return ProcessMessageInstantSendLock(pfrom, islock);
     }
+    if (IsInstantSendEnabled() && msg_type == NetMsgType::CMPCTISDLOCK) {
+        if (m_peerman == nullptr) {
+            m_peerman = peerman;
+        }
+        assert(m_peerman == peerman);
+
+        CCompactInstantSendLock cmpctislock;
+        vRecv >> cmpctislock;
+        const CInv inv(MSG_ISDLOCK, cmpctislock.hash);
+        if (AlreadyHave(inv)) {
+            return {};
+        }
+
+        if (const auto islock = ReconstructInstantSendLock(cmpctislock)) {
+            return ProcessMessageInstantSendLock(pfrom, islock);
+        }
+        // We are missing the TX or the recovered sig, fall back to fetching the full ISLOCK
+        LOCK(cs_main);
+        RequestObject(pfrom.GetId(), inv, GetTime<std::chrono::microseconds>());
+    }
     return {};
 }
 
+CInstantSendLockPtr CInstantSendManager::ReconstructInstantSendLock(const CCompactInstantSendLock& cmpctislock) const
+{
+    const auto tx = mempool.get(cmpctislock.txid);
+    if (tx == nullptr) {
+        return nullptr;
+    }
+
+    const auto islock = cmpctislock.Expand(*tx);
+
+    CRecoveredSig recSig;
+    if (!sigman.GetRecoveredSigForId(Params().GetConsensus().llmqTypeDIP0024InstantSend, islock->GetRequestId(), recSig) ||
+            recSig.getMsgHash() != islock->txid) {
+        return nullptr;
+    }
+    islock->sig = recSig.sig;
+
+    if (!cmpctislock.Matches(*islock)) {
+        return nullptr;
+    }
+    return islock;
+}
+
 PeerMsgRet CInstantSendManager::ProcessMessageInstantSendLock(const CNode& pfrom, const llmq::CInstantSendLockPtr& islock)
 {
     auto hash = ::SerializeHash(*islock);
@@ -796,8 +898,14 @@ PeerMsgRet CInstantSendManager::ProcessMessageInstantSendLock(const CNode& pfrom
     LogPrint(BCLog::INSTANTSEND, "CInstantSendManager::%s -- txid=%s, islock=%s: received islock, peer=%d\n", __func__,
             islock->txid.ToString(), hash.ToString(), pfrom.GetId());
 
-    LOCK(cs_pendingLocks);
-    pendingInstantSendLocks.emplace(hash, std::make_pair(pfrom.GetId(), islock));
+    {
+        LOCK(cs_pendingLocks);
+        if (pendingInstantSendLocks.emplace(hash, std::make_pair(pfrom.GetId(), islock)).second) {
+            pendingMessagesBudget.Charge(pfrom.GetId(), GetPendingBudgetSize(*islock));
+        }
+        pendingInstantSendLockTimes.try_emplace(hash, GetTimeMillis());
+    }
+    SignalWork();
     return {};
 }
 
@@ -822,9 +930,28 @@ bool CInstantSendLock::TriviallyValid() const
     return true;
 }
 
+CInstantSendLockPtr CCompactInstantSendLock::Expand(const CTransaction& tx) const
+{
+    const auto islock = std::make_shared<CInstantSendLock>();
+    islock->nVersion = nVersion;
+    islock->txid = txid;
+    islock->cycleHash = cycleHash;
+    islock->inputs.reserve(tx.vin.size());
+    for (const auto& in : tx.vin) {
+        islock->inputs.emplace_back(in.prevout);
+    }
+    return islock;
+}
+
+bool CCompactInstantSendLock::Matches(const CInstantSendLock& islock) const
+{
+    return ::SerializeHash(islock) == hash;
+}
+
 bool CInstantSendManager::ProcessPendingInstantSendLocks()
 {
     decltype(pendingInstantSendLocks) pend;
+    decltype(pendingInstantSendLockTimes) arrivalTimes;
     bool fMoreWork{false};
 
     if (!IsInstantSendEnabled()) {
@@ -833,9 +960,10 @@ bool CInstantSendManager::ProcessPendingInstantSendLocks()
 
     {
         LOCK(cs_pendingLocks);
-        // only process a max 32 locks at a time to avoid duplicate verification of recovered signatures which have been
-        // verified by CSigningManager in parallel
-        const size_t maxCount = 32;
+        // only process a few locks at a time to avoid duplicate verification of recovered signatures which have been
+        // verified by CSigningManager in parallel. A backlog can't be caught up that way though, so with more locks
+        // waiting the batch grows with them and gets spread over the BLS workers
+        const size_t maxCount = std::clamp<size_t>(pendingInstantSendLocks.size() / 2, ISLOCK_VERIFY_BATCH_SIZE, MAX_PENDING_ISLOCK_BATCH);
         // The keys of the removed values are temporaily stored here to avoid invalidating an iterator
         std::vector<uint256> removed;
         removed.reserve(maxCount);
@@ -846,13 +974,20 @@ bool CInstantSendManager::ProcessPendingInstantSendLocks()
                 fMoreWork = true;
                 break;
             }
+            pendingMessagesBudget.Release(nodeid_islptr_pair.first, GetPendingBudgetSize(*nodeid_islptr_pair.second));
             pend.emplace(islockHash, std::move(nodeid_islptr_pair));
             removed.emplace_back(islockHash);
         }
 
         for (const auto& islockHash : removed) {
             pendingInstantSendLocks.erase(islockHash);
+            if (auto node = pendingInstantSendLockTimes.extract(islockHash)) {
+                arrivalTimes.insert(std::move(node));
+            }
         }
+
+        statsClient.gauge("instantsend.pendingLocks", pendingInstantSendLocks.size(), 1.0f);
+        statsClient.gauge("instantsend.pendingNoTxLocks", pendingNoTxInstantSendLocks.size(), 1.0f);
     }
 
     if (pend.empty()) {
@@ -868,6 +1003,7 @@ bool CInstantSendManager::ProcessPendingInstantSendLocks()
 
     // First check against the current active set and don't ban
     auto badISLocks = ProcessPendingInstantSendLocks(llmq_params, 0, pend, false);
+    auto invalidISLocks = badISLocks;
     if (!badISLocks.empty()) {
         LogPrint(BCLog::INSTANTSEND, "CInstantSendManager::%s -- doing verification on old active set\n", __func__);
 
@@ -880,30 +1016,89 @@ bool CInstantSendManager::ProcessPendingInstantSendLocks()
             }
         }
         // Now check against the previous active set and perform banning if this fails
-        ProcessPendingInstantSendLocks(llmq_params, dkgInterval, pend, true);
+        invalidISLocks = ProcessPendingInstantSendLocks(llmq_params, dkgInterval, pend, true);
+    }
+
+    const int64_t now = GetTimeMillis();
+    for (const auto& [islockHash, arrivalTime] : arrivalTimes) {
+        if (invalidISLocks.count(islockHash)) continue;
+        statsClient.timing("instantsend.islock.arrivalToApply_ms", std::max<int64_t>(now - arrivalTime, 0), 1.0f);
     }
 
     return fMoreWork;
 }
 
+namespace {
+struct ISLockSigCheck {
+    NodeId nodeId;
+    uint256 islockHash;
+    uint256 signHash;
+    CBLSSignature sig;
+    CBLSPublicKey pubKey;
+};
+} // anonymous namespace
+
+/**
+ * Batch verifies the given signatures, ISLOCK_VERIFY_BATCH_SIZE at a time. The first batch is verified by the calling
+ * thread while the other ones run on the BLS worker threads.
+ * @return the number of batches
+ */
+static size_t VerifyISLockSigs(CBLSWorker& blsWorker, const std::vector<ISLockSigCheck>& checks, std::set<NodeId>& badSources, std::set<uint256>& badMessages)
+{
+    using VerifyResult = std::pair<std::set<NodeId>, std::set<uint256>>;
+    auto verifyRange = [&checks](size_t begin, size_t end) {
+        CBLSBatchVerifier<NodeId, uint256> batchVerifier(false, true, 8, /* useSigCache */ true);
+        for (size_t i = begin; i < end; ++i) {
+            batchVerifier.PushMessage(checks[i].nodeId, checks[i].islockHash, checks[i].signHash, checks[i].sig, checks[i].pubKey);
+        }
+        batchVerifier.Verify();
+        return VerifyResult{std::move(batchVerifier.badSources), std::move(batchVerifier.badMessages)};
+    };
+
+    std::vector<std::future<VerifyResult>> futures;
+    for (size_t begin = ISLOCK_VERIFY_BATCH_SIZE; begin < checks.size(); begin += ISLOCK_VERIFY_BATCH_SIZE) {
+        const size_t end = std::min(begin + ISLOCK_VERIFY_BATCH_SIZE, checks.size());
+        futures.emplace_back(blsWorker.AsyncRun([verifyRange, begin, end] { return verifyRange(begin, end); }));
+    }
+
+    auto merge = [&](const VerifyResult& result) {
+        badSources.insert(result.first.begin(), result.first.end());
+        badMessages.insert(result.second.begin(), result.second.end());
+    };
+    merge(verifyRange(0, std::min(ISLOCK_VERIFY_BATCH_SIZE, checks.size())));
+    for (auto& future : futures) {
+        merge(future.get());
+    }
+    return futures.size() + 1;
+}
+
 std::unordered_set<uint256, StaticSaltedHasher> CInstantSendManager::ProcessPendingInstantSendLocks(const Consensus::LLMQParams& llmq_params, int signOffset, const std::unordered_map<uint256, std::pair<NodeId, CInstantSendLockPtr>, StaticSaltedHasher>& pend, bool ban)
 {
-    CBLSBatchVerifier<NodeId, uint256> batchVerifier(false, true, 8);
+    std::vector<ISLockSigCheck> sigChecks;
+    sigChecks.reserve(pend.size());
+    std::set<NodeId> badSources;
+    std::set<uint256> badMessages;
     std::unordered_map<uint256, CRecoveredSig, StaticSaltedHasher> recSigs;
 
-    size_t verifyCount = 0;
+    std::vector<uint256> ids;
+    ids.reserve(pend.size());
+    for (const auto& p : pend) {
+        ids.emplace_back(p.second.second->GetRequestId());
+    }
+    sigman.PrefetchRecoveredSigsForIds(llmq_params.type, ids);
+
     size_t alreadyVerified = 0;
     for (const auto& p : pend) {
         const auto& hash = p.first;
         auto nodeId = p.second.first;
         const auto& islock = p.second.second;
 
-        if (batchVerifier.badSources.count(nodeId)) {
+        if (badSources.count(nodeId)) {
             continue;
         }
 
         if (!islock->sig.Get().IsValid()) {
-            batchVerifier.badSources.emplace(nodeId);
+            badSources.emplace(nodeId);
             continue;
         }
 
@@ -917,7 +1112,7 @@ std::unordered_set<uint256, StaticSaltedHasher> CInstantSendManager::ProcessPend
 
         const auto blockIndex = WITH_LOCK(cs_main, return m_chainstate.m_blockman.LookupBlockIndex(islock->cycleHash));
         if (blockIndex == nullptr) {
-            batchVerifier.badSources.emplace(nodeId);
+            badSources.emplace(nodeId);
             continue;
         }
 
@@ -933,8 +1128,7 @@ std::unordered_set<uint256, StaticSaltedHasher> CInstantSendManager::ProcessPend
             return {};
         }
         uint256 signHash = BuildSignHash(llmq_params.type, quorum->qc->quorumHash, id, islock->txid);
-        batchVerifier.PushMessage(nodeId, hash, signHash, islock->sig.Get(), quorum->qc->quorumPublicKey);
-        verifyCount++;
+        sigChecks.push_back({nodeId, hash, signHash, islock->sig.Get(), quorum->qc->quorumPublicKey});
 
         // We can reconstruct the CRecoveredSig objects from the islock and pass it to the signing manager, which
         // avoids unnecessary double-verification of the signature. We however only do this when verification here
@@ -945,17 +1139,19 @@ std::unordered_set<uint256, StaticSaltedHasher> CInstantSendManager::ProcessPend
     }
 
     cxxtimer::Timer verifyTimer(true);
-    batchVerifier.Verify();
+    const size_t batchCount = sigChecks.empty() ? 0 : VerifyISLockSigs(blsWorker, sigChecks, badSources, badMessages);
     verifyTimer.stop();
 
-    LogPrint(BCLog::INSTANTSEND, "CInstantSendManager::%s -- verified locks. count=%d, alreadyVerified=%d, vt=%d, nodes=%d\n", __func__,
-            verifyCount, alreadyVerified, verifyTimer.count(), batchVerifier.GetUniqueSourceCount());
+    LogPrint(BCLog::INSTANTSEND, "CInstantSendManager::%s -- verified locks. count=%d, alreadyVerified=%d, vt=%d, batches=%d\n", __func__,
+            sigChecks.size(), alreadyVerified, verifyTimer.count(), batchCount);
 
     std::unordered_set<uint256, StaticSaltedHasher> badISLocks;
+    // locks of known TXs which got processed, their mempool conflicts are removed in one go
+    std::vector<std::tuple<uint256, CInstantSendLockPtr, CTransactionRef>> newLocks;
 
-    if (ban && !batchVerifier.badSources.empty()) {
+    if (ban && !badSources.empty()) {
         LOCK(cs_main);
-        for (const auto& nodeId : batchVerifier.badSources) {
+        for (const auto& nodeId : badSources) {
             // Let's not be too harsh, as the peer might simply be unlucky and might have sent us an old lock which
             // does not validate anymore due to changed quorums
             m_peerman.load()->Misbehaving(nodeId, 20);
@@ -966,14 +1162,16 @@ std::unordered_set<uint256, StaticSaltedHasher> CInstantSendManager::ProcessPend
         auto nodeId = p.second.first;
         const auto& islock = p.second.second;
 
-        if (batchVerifier.badMessages.count(hash)) {
+        if (badMessages.count(hash)) {
             LogPrint(BCLog::INSTANTSEND, "CInstantSendManager::%s -- txid=%s, islock=%s: invalid sig in islock, peer=%d\n", __func__,
                      islock->txid.ToString(), hash.ToString(), nodeId);
             badISLocks.emplace(hash);
             continue;
         }
 
-        ProcessInstantSendLock(nodeId, hash, islock);
+        if (auto tx = ProcessInstantSendLock(nodeId, hash, islock)) {
+            newLocks.emplace_back(hash, islock, std::move(tx));
+        }
 
         // See comment further on top. We pass a reconstructed recovered sig to the signing manager to avoid
         // double-verification of the sig.
@@ -988,10 +1186,13 @@ std::unordered_set<uint256, StaticSaltedHasher> CInstantSendManager::ProcessPend
         }
     }
 
+    NotifyNewLocks(newLocks);
+
     return badISLocks;
 }
 
-void CInstantSendManager::ProcessInstantSendLock(NodeId from, const uint256& hash, const CInstantSendLockPtr& islock)
+// Returns the locked TX if it is known and the lock was stored, the caller must pass it to NotifyNewLocks
+CTransactionRef CInstantSendManager::ProcessInstantSendLock(NodeId from, const uint256& hash, const CInstantSendLockPtr& islock)
 {
     LogPrint(BCLog::INSTANTSEND, "CInstantSendManager::%s -- txid=%s, islock=%s: processing islock, peer=%d\n", __func__,
              islock->txid.ToString(), hash.ToString(), from);
@@ -1001,7 +1202,7 @@ void CInstantSendManager::ProcessInstantSendLock(NodeId from, const uint256& has
         txToCreatingInstantSendLocks.erase(islock->txid);
     }
     if (db.KnownInstantSendLock(hash)) {
-        return;
+        return nullptr;
     }
 
     uint256 hashBlock;
@@ -1016,15 +1217,16 @@ void CInstantSendManager::ProcessInstantSendLock(NodeId from, const uint256& has
         if (pindexMined != nullptr && clhandler.HasChainLock(pindexMined->nHeight, pindexMined->GetBlockHash())) {
             LogPrint(BCLog::INSTANTSEND, "CInstantSendManager::%s -- txlock=%s, islock=%s: dropping islock as it already got a ChainLock in block %s, peer=%d\n", __func__,
                      islock->txid.ToString(), hash.ToString(), hashBlock.ToString(), from);
-            return;
+            return nullptr;
         }
     }
 
     const auto sameTxIsLock = db.GetInstantSendLockByTxid(islock->txid);
     if (sameTxIsLock != nullptr) {
         // can happen, nothing to do
-        return;
+        return nullptr;
     }
+    db.PrefetchInputs(islock->inputs);
     for (const auto& in : islock->inputs) {
         const auto sameOutpointIsLock = db.GetInstantSendLockByInput(in);
         if (sameOutpointIsLock != nullptr) {
@@ -1038,11 +1240,15 @@ void CInstantSendManager::ProcessInstantSendLock(NodeId from, const uint256& has
         LOCK(cs_pendingLocks);
         pendingNoTxInstantSendLocks.try_emplace(hash, std::make_pair(from, islock));
     } else {
-        db.WriteNewInstantSendLock(hash, *islock);
-        if (pindexMined) {
-            db.WriteInstantSendLockMined(hash, pindexMined->nHeight);
-        }
+        db.WriteNewInstantSendLock(hash, *islock, pindexMined ? std::make_optional(pindexMined->nHeight) : std::nullopt);
     }
+    TRACE5(instantsend, islock_processed,
+        islock->txid.data(),
+        hash.data(),
+        from,
+        islock->inputs.size(),
+        tx != nullptr
+    );
 
     // This will also add children TXs to pendingRetryTxs
     RemoveNonLockedTx(islock->txid, true);
@@ -1061,16 +1267,32 @@ void CInstantSendManager::ProcessInstantSendLock(NodeId from, const uint256& has
 
     ResolveBlockConflicts(hash, *islock);
 
-    if (tx != nullptr) {
-        RemoveMempoolConflictsForLock(hash, *islock);
+    if (tx == nullptr) {
+        AskNodesForLockedTx(islock->txid, connman);
+    }
+    return tx;
+}
+
+void CInstantSendManager::NotifyNewLocks(const std::vector<std::tuple<uint256, CInstantSendLockPtr, CTransactionRef>>& newLocks)
+{
+    if (newLocks.empty()) {
+        return;
+    }
+
+    std::vector<std::pair<uint256, CInstantSendLockPtr>> locks;
+    locks.reserve(newLocks.size());
+    for (const auto& [hash, islock, _] : newLocks) {
+        locks.emplace_back(hash, islock);
+    }
+    RemoveMempoolConflictsForLocks(locks);
+
+    for (const auto& [hash, islock, tx] : newLocks) {
         LogPrint(BCLog::INSTANTSEND, "CInstantSendManager::%s -- notify about lock %s for tx %s\n", __func__,
                 hash.ToString(), tx->GetHash().ToString());
         GetMainSignals().NotifyTransactionLock(tx, islock);
-        // bump mempool counter to make sure newly locked txes are picked up by getblocktemplate
-        mempool.AddTransactionsUpdated(1);
-    } else {
-        AskNodesForLockedTx(islock->txid, connman);
     }
+    // bump mempool counter to make sure newly locked txes are picked up by getblocktemplate
+    mempool.AddTransactionsUpdated(1);
 }
 
 void CInstantSendManager::TransactionAddedToMempool(const CTransactionRef& tx)
@@ -1089,8 +1311,11 @@ void CInstantSendManager::TransactionAddedToMempool(const CTransactionRef& tx)
                 LogPrint(BCLog::INSTANTSEND, "CInstantSendManager::%s -- txid=%s, islock=%s\n", __func__,
                          tx->GetHash().ToString(), it->first.ToString());
                 islock = it->second.second;
-                pendingInstantSendLocks.try_emplace(it->first, it->second);
+                if (pendingInstantSendLocks.try_emplace(it->first, it->second).second) {
+                    pendingMessagesBudget.Charge(it->second.first, GetPendingBudgetSize(*it->second.second));
+                }
                 pendingNoTxInstantSendLocks.erase(it);
+                SignalWork();
                 break;
             }
             ++it;
@@ -1102,7 +1327,7 @@ void CInstantSendManager::TransactionAddedToMempool(const CTransactionRef& tx)
         // TX is not locked, so make sure it is tracked
         AddNonLockedTx(tx, nullptr);
     } else {
-        RemoveMempoolConflictsForLock(::SerializeHash(*islock), *islock);
+        RemoveMempoolConflictsForLocks({{::SerializeHash(*islock), islock}});
     }
 }
 
@@ -1178,8 +1403,11 @@ void CInstantSendManager::AddNonLockedTx(const CTransactionRef& tx, const CBlock
                 // we received an islock earlier, let's put it back into pending and verify/lock
                 LogPrint(BCLog::INSTANTSEND, "CInstantSendManager::%s -- txid=%s, islock=%s\n", __func__,
                          tx->GetHash().ToString(), it->first.ToString());
-                pendingInstantSendLocks.try_emplace(it->first, it->second);
+                if (pendingInstantSendLocks.try_emplace(it->first, it->second).second) {
+                    pendingMessagesBudget.Charge(it->second.first, GetPendingBudgetSize(*it->second.second));
+                }
                 pendingNoTxInstantSendLocks.erase(it);
+                SignalWork();
                 break;
             }
             ++it;
@@ -1228,14 +1456,18 @@ void CInstantSendManager::RemoveNonLockedTx(const uint256& txid, bool retryChild
              txid.ToString(), retryChildren, retryChildrenCount);
 }
 
-void CInstantSendManager::RemoveConflictedTx(const CTransaction& tx)
+void CInstantSendManager::RemoveConflictedTxs(const std::vector<CTransactionRef>& txs)
 {
-    RemoveNonLockedTx(tx.GetHash(), false);
+    for (const auto& tx : txs) {
+        RemoveNonLockedTx(tx->GetHash(), false);
+    }
 
     LOCK(cs_inputReqests);
-    for (const auto& in : tx.vin) {
-        auto inputRequestId = ::SerializeHash(std::make_pair(INPUTLOCK_REQUESTID_PREFIX, in));
-        inputRequestIds.erase(inputRequestId);
+    for (const auto& tx : txs) {
+        for (const auto& in : tx->vin) {
+            auto inputRequestId = ::SerializeHash(std::make_pair(INPUTLOCK_REQUESTID_PREFIX, in));
+            inputRequestIds.erase(inputRequestId);
+        }
     }
 }
 
@@ -1319,36 +1551,46 @@ void CInstantSendManager::HandleFullyConfirmedBlock(const CBlockIndex* pindex)
     }
 }
 
-void CInstantSendManager::RemoveMempoolConflictsForLock(const uint256& hash, const CInstantSendLock& islock)
+void CInstantSendManager::RemoveMempoolConflictsForLocks(const std::vector<std::pair<uint256, CInstantSendLockPtr>>& locks)
 {
     std::unordered_map<uint256, CTransactionRef, StaticSaltedHasher> toDelete;
+    std::vector<CTransactionRef> vtxToDelete;
+    std::set<uint256> lockedTxidsWithConflicts;
 
     {
         LOCK(mempool.cs);
 
-        for (const auto& in : islock.inputs) {
-            auto it = mempool.mapNextTx.find(in);
-            if (it == mempool.mapNextTx.end()) {
-                continue;
-            }
-            if (it->second->GetHash() != islock.txid) {
-                toDelete.emplace(it->second->GetHash(), mempool.get(it->second->GetHash()));
+        for (const auto& [hash, islock] : locks) {
+            for (const auto& in : islock->inputs) {
+                auto it = mempool.mapNextTx.find(in);
+                if (it == mempool.mapNextTx.end()) {
+                    continue;
+                }
+                const uint256 conflictTxid = it->second->GetHash();
+                if (conflictTxid == islock->txid) {
+                    continue;
+                }
+                if (auto [jt, inserted] = toDelete.try_emplace(conflictTxid); inserted) {
+                    jt->second = mempool.get(conflictTxid);
+                    vtxToDelete.emplace_back(jt->second);
+                }
+                lockedTxidsWithConflicts.emplace(islock->txid);
 
                 LogPrintf("CInstantSendManager::%s -- txid=%s, islock=%s: mempool TX %s with input %s conflicts with islock\n", __func__,
-                         islock.txid.ToString(), hash.ToString(), it->second->GetHash().ToString(), in.ToStringShort());
+                         islock->txid.ToString(), hash.ToString(), conflictTxid.ToString(), in.ToStringShort());
             }
         }
 
-        for (const auto& p : toDelete) {
-            mempool.removeRecursive(*p.second, MemPoolRemovalReason::CONFLICT);
+        if (!vtxToDelete.empty()) {
+            mempool.removeRecursive(vtxToDelete, MemPoolRemovalReason::CONFLICT);
         }
     }
 
-    if (!toDelete.empty()) {
-        for (const auto& p : toDelete) {
-            RemoveConflictedTx(*p.second);
+    if (!vtxToDelete.empty()) {
+        RemoveConflictedTxs(vtxToDelete);
+        for (const auto& txid : lockedTxidsWithConflicts) {
+            AskNodesForLockedTx(txid, connman);
         }
-        AskNodesForLockedTx(islock.txid, connman);
     }
 }
 
@@ -1406,10 +1648,12 @@ void CInstantSendManager::ResolveBlockConflicts(const uint256& islockHash, const
     bool activateBestChain = false;
     for (const auto& p : conflicts) {
         const auto* pindex = p.first;
+        std::vector<CTransactionRef> conflictedTxs;
+        conflictedTxs.reserve(p.second.size());
         for (const auto& p2 : p.second) {
-            const auto& tx = *p2.second;
-            RemoveConflictedTx(tx);
+            conflictedTxs.emplace_back(p2.second);
         }
+        RemoveConflictedTxs(conflictedTxs);
 
         LogPrintf("CInstantSendManager::%s -- invalidating block %s\n", __func__, pindex->GetBlockHash().ToString());
 
@@ -1506,33 +1750,34 @@ void CInstantSendManager::ProcessPendingRetryLockTxs()
         return;
     }
 
-    int retryCount = 0;
-    for (const auto& txid : retryTxs) {
-        CTransactionRef tx;
-        {
-            {
-                LOCK(cs_nonLocked);
-                auto it = nonLockedTxs.find(txid);
-                if (it == nonLockedTxs.end()) {
-                    continue;
-                }
-                tx = it->second.tx;
-            }
-            if (!tx) {
-                continue;
+    // look up all TXs to retry at once instead of taking the locks for each of them
+    std::vector<CTransactionRef> txs;
+    txs.reserve(retryTxs.size());
+    {
+        LOCK(cs_nonLocked);
+        for (const auto& txid : retryTxs) {
+            auto it = nonLockedTxs.find(txid);
+            if (it != nonLockedTxs.end() && it->second.tx) {
+                txs.emplace_back(it->second.tx);
             }
+        }
+    }
+    {
+        LOCK(cs_creating);
+        // we're already in the middle of locking these
+        txs.erase(std::remove_if(txs.begin(), txs.end(), [this](const CTransactionRef& tx) EXCLUSIVE_LOCKS_REQUIRED(cs_creating) {
+            return txToCreatingInstantSendLocks.count(tx->GetHash()) != 0;
+        }), txs.end());
+    }
 
-            if (LOCK(cs_creating); txToCreatingInstantSendLocks.count(tx->GetHash())) {
-                // we're already in the middle of locking this one
-                continue;
-            }
-            if (IsLocked(tx->GetHash())) {
-                continue;
-            }
-            if (GetConflictingLock(*tx) != nullptr) {
-                // should not really happen as we have already filtered these out
-                continue;
-            }
+    int retryCount = 0;
+    for (const auto& tx : txs) {
+        if (IsLocked(tx->GetHash())) {
+            continue;
+        }
+        if (GetConflictingLock(*tx) != nullptr) {
+            // should not really happen as we have already filtered these out
+            continue;
         }
 
         // CheckCanLock is already called by ProcessTx, so we should avoid calling it twice. But we also shouldn't spam
@@ -1633,6 +1878,13 @@ CInstantSendLockPtr CInstantSendManager::GetConflictingLock(const CTransaction&
         return nullptr;
     }
 
+    std::vector<COutPoint> inputs;
+    inputs.reserve(tx.vin.size());
+    for (const auto& in : tx.vin) {
+        inputs.emplace_back(in.prevout);
+    }
+    db.PrefetchInputs(inputs);
+
     for (const auto& in : tx.vin) {
         auto otherIsLock = db.GetInstantSendLockByInput(in.prevout);
         if (!otherIsLock) {
@@ -1651,14 +1903,62 @@ size_t CInstantSendManager::GetInstantSendLockCount() const
     return db.GetInstantSendLockCount();
 }
 
+size_t CInstantSendManager::DynamicMemoryUsage() const
+{
+    const auto pendingUsage = [](const auto& pending) {
+        size_t nUsage = memusage::DynamicUsage(pending);
+        for (const auto& [_, p] : pending) {
+            nUsage += memusage::DynamicUsage(p.second) + memusage::DynamicUsage(p.second->inputs);
+        }
+        return nUsage;
+    };
+
+    size_t nUsage{0};
+    {
+        LOCK(cs_inputReqests);
+        nUsage += memusage::DynamicUsage(inputRequestIds);
+    }
+    {
+        LOCK(cs_creating);
+        nUsage += memusage::DynamicUsage(creatingInstantSendLocks) + memusage::DynamicUsage(txToCreatingInstantSendLocks);
+        for (const auto& [_, islock] : creatingInstantSendLocks) {
+            nUsage += memusage::DynamicUsage(islock.inputs);
+        }
+    }
+    {
+        LOCK(cs_pendingLocks);
+        nUsage += pendingUsage(pendingInstantSendLocks) + pendingUsage(pendingNoTxInstantSendLocks) +
+                  memusage::DynamicUsage(pendingInstantSendLockTimes);
+    }
+    {
+        // the txes themselves are shared with the mempool or blocks, only count the references
+        LOCK(cs_nonLocked);
+        nUsage += memusage::DynamicUsage(nonLockedTxs) + memusage::DynamicUsage(nonLockedTxsByOutpoints);
+        for (const auto& [_, info] : nonLockedTxs) {
+            nUsage += memusage::DynamicUsage(info.children);
+        }
+    }
+    LOCK(cs_pendingRetry);
+    return nUsage + memusage::DynamicUsage(pendingRetryTxs);
+}
+
+void CInstantSendManager::SignalWork()
+{
+    WITH_LOCK(cs_workSignal, fWorkSignaled = true);
+    workSignalCv.notify_one();
+}
+
 void CInstantSendManager::WorkThreadMain()
 {
     while (!workInterrupt) {
         bool fMoreWork = ProcessPendingInstantSendLocks();
         ProcessPendingRetryLockTxs();
 
-        if (!fMoreWork && !workInterrupt.sleep_for(std::chrono::milliseconds(100))) {
-            return;
+        if (!fMoreWork) {
+            // pending retry txs are only polled, so still wake up every 100ms
+            WAIT_LOCK(cs_workSignal, lock);
+            workSignalCv.wait_for(lock, std::chrono::milliseconds(100), [this]() EXCLUSIVE_LOCKS_REQUIRED(cs_workSignal) { return fWorkSignaled; });
+            fWorkSignaled = false;
         }
     }
 }
@@ -18,9 +18,12 @@
 #include <gsl/pointers.h>
 
 #include <atomic>
+#include <condition_variable>
+#include <optional>
 #include <unordered_map>
 #include <unordered_set>
 
+class CBLSWorker;
 class CChainState;
 class CDBWrapper;
 class CMasternodeSync;
@@ -61,6 +64,32 @@ struct CInstantSendLock
 
 using CInstantSendLockPtr = std::shared_ptr<CInstantSendLock>;
 
+/**
+ * An ISLOCK without its inputs and signature. Both can be rebuilt by peers which know the transaction and the
+ * recovered sig, `hash` is the hash of the full ISLOCK and is used to check the result.
+ */
+struct CCompactInstantSendLock
+{
+    uint256 hash;
+    uint8_t nVersion{CInstantSendLock::CURRENT_VERSION};
+    uint256 txid;
+    uint256 cycleHash;
+
+    CCompactInstantSendLock() = default;
+    CCompactInstantSendLock(const uint256& _hash, const CInstantSendLock& islock) :
+        hash(_hash), nVersion(islock.nVersion), txid(islock.txid), cycleHash(islock.cycleHash) {}
+
+    SERIALIZE_METHODS(CCompactInstantSendLock, obj)
+    {
+        READWRITE(obj.hash, obj.nVersion, obj.txid, obj.cycleHash);
+    }
+
+    /** The ISLOCK for tx, still without its signature. Its request id tells which recovered sig to add. */
+    CInstantSendLockPtr Expand(const CTransaction& tx) const;
+    /** Whether islock is the ISLOCK this was made from, only then it may be used in place of fetching it */
+    bool Matches(const CInstantSendLock& islock) const;
+};
+
 class CInstantSendDb
 {
 private:
@@ -71,10 +100,12 @@ private:
     int best_confirmed_height GUARDED_BY(cs_db) {0};
 
     std::unique_ptr<CDBWrapper> db GUARDED_BY(cs_db) {nullptr};
-    mutable unordered_lru_cache<uint256, CInstantSendLockPtr, StaticSaltedHasher, 10000> islockCache GUARDED_BY(cs_db);
-    mutable unordered_lru_cache<uint256, uint256, StaticSaltedHasher, 10000> txidCache GUARDED_BY(cs_db);
+    // The caches lock internally, so hits are served without cs_db. They are only changed while cs_db is held,
+    // which keeps them consistent with the database for everyone that falls back to it.
+    mutable sharded_unordered_lru_cache<uint256, CInstantSendLockPtr, StaticSaltedHasher, 10000> islockCache{"instantsend.islocks"};
+    mutable sharded_unordered_lru_cache<uint256, uint256, StaticSaltedHasher, 10000> txidCache{"instantsend.txids"};
 
-    mutable unordered_lru_cache<COutPoint, uint256, SaltedOutpointHasher, 10000> outpointCache GUARDED_BY(cs_db);
+    mutable sharded_unordered_lru_cache<COutPoint, uint256, SaltedOutpointHasher, 10000> outpointCache{"instantsend.outpoints"};
     void WriteInstantSendLockMined(CDBBatch& batch, const uint256& hash, int nHeight) EXCLUSIVE_LOCKS_REQUIRED(cs_db);
 
     void RemoveInstantSendLockMined(CDBBatch& batch, const uint256& hash, int nHeight) EXCLUSIVE_LOCKS_REQUIRED(cs_db);
@@ -122,8 +153,9 @@ public:
      * This method is called when an InstantSend Lock is processed and adds the lock to the database
      * @param hash The hash of the InstantSend Lock
      * @param islock The InstantSend Lock object itself
+     * @param nMinedHeight The height the locked transaction is already included at, written in the same batch
      */
-    void WriteNewInstantSendLock(const uint256& hash, const CInstantSendLock& islock) LOCKS_EXCLUDED(cs_db);
+    void WriteNewInstantSendLock(const uint256& hash, const CInstantSendLock& islock, std::optional<int> nMinedHeight = std::nullopt) LOCKS_EXCLUDED(cs_db);
     /**
      * This method updates a DB entry for an InstantSend Lock from being not included in a block to being included in a block
      * @param hash The hash of the InstantSend Lock
@@ -157,6 +189,10 @@ public:
      */
     CInstantSendLockPtr GetInstantSendLockByHash(const uint256& hash, bool use_cache = true) const LOCKS_EXCLUDED(cs_db)
     {
+        CInstantSendLockPtr ret;
+        if (use_cache && islockCache.get(hash, ret)) {
+            return ret;
+        }
         LOCK(cs_db);
         return GetInstantSendLockByHashInternal(hash, use_cache);
     };
@@ -167,6 +203,10 @@ public:
      */
     uint256 GetInstantSendLockHashByTxid(const uint256& txid) const LOCKS_EXCLUDED(cs_db)
     {
+        uint256 islockHash;
+        if (txidCache.get(txid, islockHash)) {
+            return islockHash;
+        }
         LOCK(cs_db);
         return GetInstantSendLockHashByTxidInternal(txid);
     };
@@ -182,6 +222,12 @@ public:
      * @return IS Lock Pointer associated with that input.
      */
     CInstantSendLockPtr GetInstantSendLockByInput(const COutPoint& outpoint) const LOCKS_EXCLUDED(cs_db);
+    /**
+     * Reads the IS Lock hashes of all the given inputs which are not cached yet with a single batched
+     * lookup, so that the following GetInstantSendLockByInput calls for them don't hit the db one by one
+     * @param outpoints The inputs which are about to be looked up
+     */
+    void PrefetchInputs(const std::vector<COutPoint>& outpoints) const LOCKS_EXCLUDED(cs_db);
     /**
      * Called when a ChainLock invalidated a IS Lock, removes any chained/children IS Locks and the invalidated IS Lock
      * @param islockHash IS Lock hash which has been invalidated
@@ -197,6 +243,7 @@ class CInstantSendManager : public CRecoveredSigsListener
 private:
     CInstantSendDb db;
 
+    CBLSWorker& blsWorker;
     CChainLocksHandler& clhandler;
     CChainState& m_chainstate;
     CConnman& connman;
@@ -213,6 +260,11 @@ private:
     std::thread workThread;
     CThreadInterrupt workInterrupt;
 
+    // Wakes up the work thread as soon as new locks are pending, instead of at its next poll
+    Mutex cs_workSignal;
+    std::condition_variable workSignalCv;
+    bool fWorkSignaled GUARDED_BY(cs_workSignal) {false};
+
     mutable Mutex cs_inputReqests;
 
     /**
@@ -237,6 +289,8 @@ private:
     std::unordered_map<uint256, std::pair<NodeId, CInstantSendLockPtr>, StaticSaltedHasher> pendingInstantSendLocks GUARDED_BY(cs_pendingLocks);
     // Tried to verify but there is no tx yet
     std::unordered_map<uint256, std::pair<NodeId, CInstantSendLockPtr>, StaticSaltedHasher> pendingNoTxInstantSendLocks GUARDED_BY(cs_pendingLocks);
+    // Arrival time in milliseconds of the locks in pendingInstantSendLocks, for arrival-to-apply stats
+    std::unordered_map<uint256, int64_t, StaticSaltedHasher> pendingInstantSendLockTimes GUARDED_BY(cs_pendingLocks);
 
     // TXs which are neither IS locked nor ChainLocked. We use this to determine for which TXs we need to retry IS locking
     // of child TXs
@@ -254,12 +308,12 @@ private:
     std::unordered_set<uint256, StaticSaltedHasher> pendingRetryTxs GUARDED_BY(cs_pendingRetry);
 
 public:
-    explicit CInstantSendManager(CChainLocksHandler& _clhandler, CChainState& chainstate, CConnman& _connman,
+    explicit CInstantSendManager(CBLSWorker& _blsWorker, CChainLocksHandler& _clhandler, CChainState& chainstate, CConnman& _connman,
                                  CQuorumManager& _qman, CSigningManager& _sigman, CSigSharesManager& _shareman,
                                  CSporkManager& sporkManager, CTxMemPool& _mempool, const CMasternodeSync& mn_sync,
                                  bool unitTests, bool fWipe) :
         db(unitTests, fWipe),
-        clhandler(_clhandler), m_chainstate(chainstate), connman(_connman), qman(_qman), sigman(_sigman),
+        blsWorker(_blsWorker), clhandler(_clhandler), m_chainstate(chainstate), connman(_connman), qman(_qman), sigman(_sigman),
         shareman(_shareman), spork_manager(sporkManager), mempool(_mempool), m_mn_sync(mn_sync)
     {
         workInterrupt.reset();
@@ -268,9 +322,11 @@ public:
 
     void Start();
     void Stop();
-    void InterruptWorkerThread() { workInterrupt(); };
+    void InterruptWorkerThread() { workInterrupt(); SignalWork(); };
 
 private:
+    void SignalWork() LOCKS_EXCLUDED(cs_workSignal);
+
     void ProcessTx(const CTransaction& tx, bool fRetroactive, const Consensus::Params& params);
     bool CheckCanLock(const CTransaction& tx, bool printDebug, const Consensus::Params& params) const;
     bool CheckCanLock(const COutPoint& outpoint, bool printDebug, const uint256& txHash, const Consensus::Params& params) const;
@@ -282,6 +338,7 @@ private:
     void TrySignInstantSendLock(const CTransaction& tx) LOCKS_EXCLUDED(cs_creating);
 
     PeerMsgRet ProcessMessageInstantSendLock(const CNode& pfrom, const CInstantSendLockPtr& islock);
+    CInstantSendLockPtr ReconstructInstantSendLock(const CCompactInstantSendLock& cmpctislock) const;
     bool ProcessPendingInstantSendLocks() LOCKS_EXCLUDED(cs_pendingLocks);
 
     std::unordered_set<uint256, StaticSaltedHasher> ProcessPendingInstantSendLocks(const Consensus::LLMQParams& llmq_params,
@@ -290,14 +347,15 @@ private:
                                                                                    std::pair<NodeId, CInstantSendLockPtr>,
                                                                                    StaticSaltedHasher>& pend,
                                                                                    bool ban) LOCKS_EXCLUDED(cs_pendingLocks);
-    void ProcessInstantSendLock(NodeId from, const uint256& hash, const CInstantSendLockPtr& islock) LOCKS_EXCLUDED(cs_creating, cs_pendingLocks);
+    CTransactionRef ProcessInstantSendLock(NodeId from, const uint256& hash, const CInstantSendLockPtr& islock) LOCKS_EXCLUDED(cs_creating, cs_pendingLocks);
+    void NotifyNewLocks(const std::vector<std::tuple<uint256, CInstantSendLockPtr, CTransactionRef>>& newLocks);
 
     void AddNonLockedTx(const CTransactionRef& tx, const CBlockIndex* pindexMined) LOCKS_EXCLUDED(cs_pendingLocks, cs_nonLocked);
     void RemoveNonLockedTx(const uint256& txid, bool retryChildren) LOCKS_EXCLUDED(cs_nonLocked, cs_pendingRetry);
-    void RemoveConflictedTx(const CTransaction& tx) LOCKS_EXCLUDED(cs_inputReqests);
+    void RemoveConflictedTxs(const std::vector<CTransactionRef>& txs) LOCKS_EXCLUDED(cs_inputReqests);
     void TruncateRecoveredSigsForInputs(const CInstantSendLock& islock) LOCKS_EXCLUDED(cs_inputReqests);
 
-    void RemoveMempoolConflictsForLock(const uint256& hash, const CInstantSendLock& islock);
+    void RemoveMempoolConflictsForLocks(const std::vector<std::pair<uint256, CInstantSendLockPtr>>& locks);
     void ResolveBlockConflicts(const uint256& islockHash, const CInstantSendLock& islock) LOCKS_EXCLUDED(cs_pendingLocks, cs_nonLocked);
     static void AskNodesForLockedTx(const uint256& txid, const CConnman& connman);
     void ProcessPendingRetryLockTxs() LOCKS_EXCLUDED(cs_creating, cs_nonLocked, cs_pendingRetry);
@@ -330,6 +388,8 @@ public:
     void RemoveConflictingLock(const uint256& islockHash, const CInstantSendLock& islock);
 
     size_t GetInstantSendLockCount() const;
+    /** Estimated memory used by the locks being created or pending verification and the not yet locked txes */
+    size_t DynamicMemoryUsage() const LOCKS_EXCLUDED(cs_inputReqests, cs_creating, cs_pendingLocks, cs_nonLocked, cs_pendingRetry);
 
     bool IsInstantSendEnabled() const;
     /**
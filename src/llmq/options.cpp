@@ -12,6 +12,7 @@
 #include <util/system.h>
 #include <util/underlying.h>
 
+#include <algorithm>
 #include <string>
 #include <stdexcept>
 
@@ -59,6 +60,12 @@ bool QuorumDataRecoveryEnabled()
     return gArgs.GetBoolArg("-llmq-data-recovery", DEFAULT_ENABLE_QUORUM_DATA_RECOVERY);
 }
 
+size_t QuorumDataRecoveryParallel()
+{
+    const int64_t parallel = gArgs.GetArg("-llmq-data-recovery-parallel", DEFAULT_QUORUM_DATA_RECOVERY_PARALLEL);
+    return size_t(std::clamp<int64_t>(parallel, 1, MAX_QUORUM_DATA_RECOVERY_PARALLEL));
+}
+
 bool IsWatchQuorumsEnabled()
 {
     static bool fIsWatchQuroumsEnabled = gArgs.GetBoolArg("-watchquorums", DEFAULT_WATCH_QUORUMS);
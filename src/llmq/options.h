@@ -24,6 +24,9 @@ enum class QvvecSyncMode {
 };
 
 static constexpr bool DEFAULT_ENABLE_QUORUM_DATA_RECOVERY{true};
+// Quorum members asked for the data of a quorum at the same time, the first valid response wins
+static constexpr size_t DEFAULT_QUORUM_DATA_RECOVERY_PARALLEL{3};
+static constexpr size_t MAX_QUORUM_DATA_RECOVERY_PARALLEL{16};
 
 // If true, we will connect to all new quorums and watch their communication
 static constexpr bool DEFAULT_WATCH_QUORUMS{false};
@@ -36,6 +39,9 @@ bool IsQuorumRotationEnabled(const Consensus::LLMQParams& llmqParams, gsl::not_n
 /// Returns the state of `-llmq-data-recovery`
 bool QuorumDataRecoveryEnabled();
 
+/// Returns the value of `-llmq-data-recovery-parallel`, clamped to [1, MAX_QUORUM_DATA_RECOVERY_PARALLEL]
+size_t QuorumDataRecoveryParallel();
+
 /// Returns the state of `-watchquorums`
 bool IsWatchQuorumsEnabled();
 
@@ -0,0 +1,107 @@
+// Copyright (c) 2024 The Maximus developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <llmq/pendingbudget.h>
+
+#include <logging.h>
+
+#include <algorithm>
+
+namespace llmq
+{
+
+CPendingMessagesBudget pendingMessagesBudget{DEFAULT_PENDING_MESSAGES_BUDGET << 20};
+
+void CPendingMessagesBudget::SetLimit(size_t _nMaxBytes)
+{
+    LOCK(cs);
+    nMaxBytes = _nMaxBytes;
+}
+
+void CPendingMessagesBudget::Charge(NodeId nodeId, size_t nBytes)
+{
+    if (nodeId < 0 || nBytes == 0) {
+        return;
+    }
+    LOCK(cs);
+    auto& nNodeBytes = mapBytesPerNode[nodeId];
+    nNodeBytes += nBytes;
+    nTotalBytes += nBytes;
+    if (nTotalBytes <= nMaxBytes || setPausedNodes.count(nodeId)) {
+        return;
+    }
+    // only the heaviest peers are paused, the others shouldn't wait for them
+    if (nNodeBytes * mapBytesPerNode.size() >= nTotalBytes) {
+        setPausedNodes.emplace(nodeId);
+        fAnyPaused = true;
+        LogPrint(BCLog::LLMQ, "CPendingMessagesBudget::%s -- pausing peer=%d, pending=%d, total=%d\n", __func__,
+                 nodeId, nNodeBytes, nTotalBytes);
+    }
+}
+
+void CPendingMessagesBudget::Release(NodeId nodeId, size_t nBytes)
+{
+    if (nodeId < 0 || nBytes == 0) {
+        return;
+    }
+    LOCK(cs);
+    auto it = mapBytesPerNode.find(nodeId);
+    if (it == mapBytesPerNode.end()) {
+        // the peer is gone already
+        return;
+    }
+    nBytes = std::min(nBytes, it->second);
+    it->second -= nBytes;
+    nTotalBytes -= nBytes;
+    if (it->second == 0) {
+        mapBytesPerNode.erase(it);
+        Resume(nodeId);
+    }
+    if (!setPausedNodes.empty() && nTotalBytes <= nMaxBytes / 4 * 3) {
+        LogPrint(BCLog::LLMQ, "CPendingMessagesBudget::%s -- resuming %d peers, total=%d\n", __func__,
+                 setPausedNodes.size(), nTotalBytes);
+        setPausedNodes.clear();
+        fAnyPaused = false;
+    }
+}
+
+void CPendingMessagesBudget::RemoveNode(NodeId nodeId)
+{
+    LOCK(cs);
+    if (auto it = mapBytesPerNode.find(nodeId); it != mapBytesPerNode.end()) {
+        nTotalBytes -= it->second;
+        mapBytesPerNode.erase(it);
+    }
+    Resume(nodeId);
+}
+
+void CPendingMessagesBudget::Resume(NodeId nodeId)
+{
+    if (setPausedNodes.erase(nodeId) != 0 && setPausedNodes.empty()) {
+        fAnyPaused = false;
+    }
+}
+
+bool CPendingMessagesBudget::IsPaused(NodeId nodeId) const
+{
+    if (!fAnyPaused) {
+        return false;
+    }
+    LOCK(cs);
+    return setPausedNodes.count(nodeId) != 0;
+}
+
+size_t CPendingMessagesBudget::GetUsage() const
+{
+    LOCK(cs);
+    return nTotalBytes;
+}
+
+size_t CPendingMessagesBudget::GetPausedCount() const
+{
+    LOCK(cs);
+    return setPausedNodes.size();
+}
+
+} // namespace llmq
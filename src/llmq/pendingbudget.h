@@ -0,0 +1,62 @@
+// Copyright (c) 2024 The Maximus developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_LLMQ_PENDINGBUDGET_H
+#define BITCOIN_LLMQ_PENDINGBUDGET_H
+
+#include <net.h>
+#include <sync.h>
+
+#include <atomic>
+#include <cstddef>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace llmq
+{
+
+/** Default for -llmq-pending-budget, in MiB */
+static constexpr int64_t DEFAULT_PENDING_MESSAGES_BUDGET{128};
+
+/**
+ * Memory budget shared by the LLMQ messages which were received but are not verified yet: pending sig shares,
+ * islocks, recovered sigs and DKG messages. Each of them is charged to the peer it came from when it's queued and
+ * released once it was taken for verification or dropped.
+ *
+ * When the budget is exceeded, a peer which queues more than the average of all peers with pending messages is
+ * paused, so the network thread stops reading from its socket (see CNode::fPauseRecvBudget) instead of queueing
+ * or dropping even more. The peers continue once they are drained or the total usage fell below 3/4 of the budget.
+ */
+class CPendingMessagesBudget
+{
+private:
+    mutable Mutex cs;
+    size_t nMaxBytes GUARDED_BY(cs);
+    size_t nTotalBytes GUARDED_BY(cs){0};
+    std::unordered_map<NodeId, size_t> mapBytesPerNode GUARDED_BY(cs);
+    std::unordered_set<NodeId> setPausedNodes GUARDED_BY(cs);
+    // lets IsPaused skip the lock while nobody is paused, which is the common case
+    std::atomic<bool> fAnyPaused{false};
+
+    void Resume(NodeId nodeId) EXCLUSIVE_LOCKS_REQUIRED(cs);
+
+public:
+    explicit CPendingMessagesBudget(size_t _nMaxBytes) : nMaxBytes(_nMaxBytes) {}
+
+    void SetLimit(size_t _nMaxBytes) LOCKS_EXCLUDED(cs);
+
+    void Charge(NodeId nodeId, size_t nBytes) LOCKS_EXCLUDED(cs);
+    void Release(NodeId nodeId, size_t nBytes) LOCKS_EXCLUDED(cs);
+    void RemoveNode(NodeId nodeId) LOCKS_EXCLUDED(cs);
+
+    bool IsPaused(NodeId nodeId) const LOCKS_EXCLUDED(cs);
+    size_t GetUsage() const LOCKS_EXCLUDED(cs);
+    size_t GetPausedCount() const LOCKS_EXCLUDED(cs);
+};
+
+extern CPendingMessagesBudget pendingMessagesBudget;
+
+} // namespace llmq
+
+#endif // BITCOIN_LLMQ_PENDINGBUDGET_H
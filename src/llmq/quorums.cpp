@@ -11,6 +11,7 @@
 #include <llmq/params.h>
 #include <llmq/utils.h>
 
+#include <bls/bls_sigcache.h>
 #include <evo/specialtx.h>
 #include <evo/deterministicmns.h>
 
@@ -21,6 +22,7 @@
 #include <netmessagemaker.h>
 #include <univalue.h>
 #include <util/irange.h>
+#include <util/threadbudget.h>
 #include <util/time.h>
 #include <util/underlying.h>
 #include <validation.h>
@@ -32,6 +34,7 @@ namespace llmq
 
 static const std::string DB_QUORUM_SK_SHARE = "q_Qsk";
 static const std::string DB_QUORUM_QUORUM_VVEC = "q_Qqvvec";
+static const std::string DB_QUORUM_PUBKEY_SHARES = "q_Qpks";
 
 std::unique_ptr<CQuorumManager> quorumManager;
 
@@ -135,6 +138,9 @@ CBLSPublicKey CQuorum::GetPubKeyShare(size_t memberIdx) const
     if (!HasVerificationVector() || memberIdx >= members.size() || !qc->validMembers[memberIdx]) {
         return CBLSPublicKey();
     }
+    if (memberIdx < pubKeyShares.size()) {
+        return pubKeyShares[memberIdx];
+    }
     const auto& m = members[memberIdx];
     return blsCache.BuildPubKeyShare(m->proTxHash, quorumVvec, CBLSId(m->proTxHash));
 }
@@ -150,6 +156,18 @@ CBLSSecretKey CQuorum::GetSkShare() const
     return skShare;
 }
 
+size_t CQuorum::DynamicMemoryUsage() const
+{
+    // members are shared with the masternode lists, only count the vector itself
+    size_t nUsage = memusage::DynamicUsage(members) + memusage::DynamicUsage(qc);
+    LOCK(cs);
+    nUsage += memusage::DynamicUsage(pubKeyShares);
+    if (quorumVvec) {
+        nUsage += memusage::DynamicUsage(quorumVvec) + memusage::DynamicUsage(*quorumVvec);
+    }
+    return nUsage;
+}
+
 int CQuorum::GetMemberIndex(const uint256& proTxHash) const
 {
     for (const auto i : irange::range(members.size())) {
@@ -205,6 +223,54 @@ bool CQuorum::ReadContributions(CEvoDB& evoDb)
     return true;
 }
 
+void CQuorum::SetPubKeyShares(std::vector<CBLSPublicKey>&& pubKeySharesIn) const
+{
+    assert(pubKeySharesIn.size() == members.size());
+    LOCK(cs);
+    pubKeyShares = std::move(pubKeySharesIn);
+}
+
+void CQuorum::WritePubKeyShares(CEvoDB& evoDb) const
+{
+    uint256 dbKey = MakeQuorumKey(*this);
+
+    LOCK(cs);
+    if (pubKeyShares.empty()) {
+        return;
+    }
+    CDataStream s(SER_DISK, CLIENT_VERSION);
+    WriteCompactSize(s, pubKeyShares.size());
+    for (auto& pubkey : pubKeyShares) {
+        s << CBLSPublicKeyVersionWrapper(pubkey, false);
+    }
+    evoDb.GetRawDB().Write(std::make_pair(DB_QUORUM_PUBKEY_SHARES, dbKey), s);
+}
+
+bool CQuorum::ReadPubKeyShares(CEvoDB& evoDb)
+{
+    uint256 dbKey = MakeQuorumKey(*this);
+    CDataStream s(SER_DISK, CLIENT_VERSION);
+
+    if (!evoDb.GetRawDB().ReadDataStream(std::make_pair(DB_QUORUM_PUBKEY_SHARES, dbKey), s)) {
+        return false;
+    }
+
+    size_t count = ReadCompactSize(s);
+    if (count != members.size()) {
+        return false;
+    }
+    CBLSPublicKey pubkey;
+    std::vector<CBLSPublicKey> pks;
+    pks.reserve(count);
+    for ([[maybe_unused]] size_t _ : irange::range(count)) {
+        s >> CBLSPublicKeyVersionWrapper(pubkey, false);
+        pks.emplace_back(pubkey);
+    }
+
+    SetPubKeyShares(std::move(pks));
+    return true;
+}
+
 CQuorumManager::CQuorumManager(CBLSWorker& _blsWorker, CChainState& chainstate, CConnman& _connman, CDKGSessionManager& _dkgManager,
                                CEvoDB& _evoDb, CQuorumBlockProcessor& _quorumBlockProcessor, const std::unique_ptr<CMasternodeSync>& mn_sync) :
     blsWorker(_blsWorker),
@@ -221,9 +287,7 @@ CQuorumManager::CQuorumManager(CBLSWorker& _blsWorker, CChainState& chainstate,
 
 void CQuorumManager::Start()
 {
-    int workerCount = std::thread::hardware_concurrency() / 2;
-    workerCount = std::max(std::min(1, workerCount), 4);
-    workerPool.resize(workerCount);
+    workerPool.resize(GetThreadBudget(TaskPriority::LLMQ, 4));
     RenameThreadPool(workerPool, "q-mngr");
 }
 
@@ -406,10 +470,11 @@ CQuorumPtr CQuorumManager::BuildQuorumFromCommitment(const Consensus::LLMQType l
         }
     }
 
-    if (hasValidVvec && populate_cache) {
+    if (hasValidVvec && populate_cache && !quorum->ReadPubKeyShares(m_evoDb)) {
         // pre-populate caches in the background
         // recovering public key shares is quite expensive and would result in serious lags for the first few signing
-        // sessions if the shares would be calculated on-demand
+        // sessions if the shares would be calculated on-demand. The populator stores the shares in evodb, so this
+        // only happens once per quorum
         StartCachePopulatorThread(quorum);
     }
 
@@ -515,26 +580,12 @@ std::vector<CQuorumCPtr> CQuorumManager::ScanQuorums(Consensus::LLMQType llmqTyp
         return {};
     }
 
-    gsl::not_null<const CBlockIndex*> pindexStore{pindexStart};
     const auto& llmq_params_opt = Params().GetLLMQ(llmqType);
     assert(llmq_params_opt.has_value());
 
-    // Quorum sets can only change during the mining phase of DKG.
-    // Find the closest known block index.
-    const int quorumCycleStartHeight = pindexStart->nHeight - (pindexStart->nHeight % llmq_params_opt->dkgInterval);
-    const int quorumCycleMiningStartHeight = quorumCycleStartHeight + llmq_params_opt->dkgMiningWindowStart;
-    const int quorumCycleMiningEndHeight = quorumCycleStartHeight + llmq_params_opt->dkgMiningWindowEnd;
-
-    if (pindexStart->nHeight < quorumCycleMiningStartHeight) {
-        // too early for this cycle, use the previous one
-        // bail out if it's below genesis block
-        if (quorumCycleMiningEndHeight < llmq_params_opt->dkgInterval) return {};
-        pindexStore = pindexStart->GetAncestor(quorumCycleMiningEndHeight - llmq_params_opt->dkgInterval);
-    } else if (pindexStart->nHeight > quorumCycleMiningEndHeight) {
-        // we are past the mining phase of this cycle, use it
-        pindexStore = pindexStart->GetAncestor(quorumCycleMiningEndHeight);
-    }
-    // everything else is inside the mining phase of this cycle, no pindexStore adjustment needed
+    const CBlockIndex* pindexSet = GetQuorumSetBlockIndex(*llmq_params_opt, pindexStart);
+    if (pindexSet == nullptr) return {};
+    gsl::not_null<const CBlockIndex*> pindexStore{pindexSet};
 
     gsl::not_null<const CBlockIndex*> pIndexScanCommitments{pindexStore};
     size_t nScanCommitments{nCountRequested};
@@ -796,16 +847,25 @@ PeerMsgRet CQuorumManager::ProcessMessage(CNode& pfrom, const std::string& msg_t
             }
         }
 
+        // The recovery thread asks several members at once, once one of them delivered the rest is ignored
+        const bool fHasVvec{pQuorum->HasVerificationVector()};
+        if ((!(request.GetDataMask() & CQuorumDataRequest::QUORUM_VERIFICATION_VECTOR) || fHasVvec) &&
+            (!(request.GetDataMask() & CQuorumDataRequest::ENCRYPTED_CONTRIBUTIONS) || pQuorum->GetSkShare().IsValid())) {
+            return errorHandler("Already recovered", 0);
+        }
+
         // Check if request has QUORUM_VERIFICATION_VECTOR data
         if (request.GetDataMask() & CQuorumDataRequest::QUORUM_VERIFICATION_VECTOR) {
 
             std::vector<CBLSPublicKey> verificationVector;
             vRecv >> verificationVector;
 
-            if (pQuorum->SetVerificationVector(verificationVector)) {
+            // Keep the one received from another member in the meantime, only the contributions are needed then
+            if (!fHasVvec) {
+                if (!pQuorum->SetVerificationVector(verificationVector)) {
+                    return errorHandler("Invalid quorum verification vector");
+                }
                 StartCachePopulatorThread(pQuorum);
-            } else {
-                return errorHandler("Invalid quorum verification vector");
             }
         }
 
@@ -825,12 +885,9 @@ PeerMsgRet CQuorumManager::ProcessMessage(CNode& pfrom, const std::string& msg_t
             vRecv >> vecEncrypted;
 
             std::vector<CBLSSecretKey> vecSecretKeys;
-            vecSecretKeys.resize(vecEncrypted.size());
             auto secret = WITH_LOCK(activeMasternodeInfoCs, return *activeMasternodeInfo.blsKeyOperator);
-            for (const auto i : irange::range(vecEncrypted.size())) {
-                if (!vecEncrypted[i].Decrypt(memberIdx, secret, vecSecretKeys[i], PROTOCOL_VERSION)) {
-                    return errorHandler("Failed to decrypt");
-                }
+            if (!blsWorker.DecryptContributions(vecEncrypted, memberIdx, secret, vecSecretKeys)) {
+                return errorHandler("Failed to decrypt");
             }
 
             CBLSSecretKey secretKeyShare = blsWorker.AggregateSecretKeys(vecSecretKeys);
@@ -858,14 +915,17 @@ void CQuorumManager::StartCachePopulatorThread(const CQuorumCPtr pQuorum) const
 
     // when then later some other thread tries to get keys, it will be much faster
     workerPool.push([pQuorum, t, this](int threadId) {
+        std::vector<CBLSPublicKey> pubKeyShares(pQuorum->members.size());
         for (const auto i : irange::range(pQuorum->members.size())) {
             if (quorumThreadInterrupt) {
-                break;
+                return;
             }
             if (pQuorum->qc->validMembers[i]) {
-                pQuorum->GetPubKeyShare(i);
+                pubKeyShares[i] = pQuorum->GetPubKeyShare(i);
             }
         }
+        pQuorum->SetPubKeyShares(std::move(pubKeyShares));
+        pQuorum->WritePubKeyShares(m_evoDb);
         LogPrint(BCLog::LLMQ, "CQuorumManager::StartCachePopulatorThread -- type=%d height=%d hash=%s done. time=%d\n",
                 ToUnderlying(pQuorum->params.type),
                 pQuorum->m_quorum_base_block_index->nHeight,
@@ -885,16 +945,17 @@ void CQuorumManager::StartQuorumDataRecoveryThread(const CQuorumCPtr pQuorum, co
     workerPool.push([pQuorum, pIndex, nDataMaskIn, this](int threadId) {
         size_t nTries{0};
         uint16_t nDataMask{nDataMaskIn};
-        int64_t nTimeLastSuccess{0};
-        uint256* pCurrentMemberHash{nullptr};
+        // Members asked at the moment, mapped to the time they were connected or last answered a request
+        std::map<uint256, int64_t> mapPendingMembers;
         std::vector<uint256> vecMemberHashes;
         const size_t nMyStartOffset{GetQuorumRecoveryStartOffset(pQuorum, pIndex)};
+        const size_t nParallel{QuorumDataRecoveryParallel()};
         const int64_t nRequestTimeout{10};
 
-        auto printLog = [&](const std::string& strMessage) {
-            const std::string strMember{pCurrentMemberHash == nullptr ? "nullptr" : pCurrentMemberHash->ToString()};
-            LogPrint(BCLog::LLMQ, "CQuorumManager::StartQuorumDataRecoveryThread -- %s - for llmqType %d, quorumHash %s, nDataMask (%d/%d), pCurrentMemberHash %s, nTries %d\n",
-                strMessage, ToUnderlying(pQuorum->qc->llmqType), pQuorum->qc->quorumHash.ToString(), nDataMask, nDataMaskIn, strMember, nTries);
+        auto printLog = [&](const std::string& strMessage, const uint256* pMemberHash = nullptr) {
+            const std::string strMember{pMemberHash == nullptr ? "nullptr" : pMemberHash->ToString()};
+            LogPrint(BCLog::LLMQ, "CQuorumManager::StartQuorumDataRecoveryThread -- %s - for llmqType %d, quorumHash %s, nDataMask (%d/%d), pCurrentMemberHash %s, nTries %d, nPending %d\n",
+                strMessage, ToUnderlying(pQuorum->qc->llmqType), pQuorum->qc->quorumHash.ToString(), nDataMask, nDataMaskIn, strMember, nTries, mapPendingMembers.size());
         };
         printLog("Start");
 
@@ -935,61 +996,80 @@ void CQuorumManager::StartQuorumDataRecoveryThread(const CQuorumCPtr pQuorum, co
                 break;
             }
 
-            if ((GetTime<std::chrono::seconds>().count() - nTimeLastSuccess) > nRequestTimeout) {
-                if (nTries >= vecMemberHashes.size()) {
-                    printLog("All tried but failed");
-                    break;
+            // Give up on members which didn't answer in time, responses still arriving from them are processed anyway
+            const int64_t nNow{GetTime<std::chrono::seconds>().count()};
+            for (auto it = mapPendingMembers.begin(); it != mapPendingMembers.end();) {
+                if (nNow - it->second > nRequestTimeout) {
+                    printLog("Timeout", &it->first);
+                    it = mapPendingMembers.erase(it);
+                } else {
+                    ++it;
                 }
+            }
+
+            if (mapPendingMembers.size() < nParallel && nTries < vecMemberHashes.size()) {
+                // Sleep a bit depending on the start offset to balance out multiple requests to same masternode
+                quorumThreadInterrupt.sleep_for(std::chrono::milliseconds(nMyStartOffset * 100));
+            }
+            while (mapPendingMembers.size() < nParallel && nTries < vecMemberHashes.size() && !quorumThreadInterrupt) {
                 // Access the member list of the quorum with the calculated offset applied to balance the load equally
-                pCurrentMemberHash = &vecMemberHashes[(nMyStartOffset + nTries++) % vecMemberHashes.size()];
+                const uint256& memberHash = vecMemberHashes[(nMyStartOffset + nTries++) % vecMemberHashes.size()];
                 {
                     LOCK(cs_data_requests);
-                    const CQuorumDataRequestKey key(*pCurrentMemberHash, true, pQuorum->qc->quorumHash, pQuorum->qc->llmqType);
+                    const CQuorumDataRequestKey key(memberHash, true, pQuorum->qc->quorumHash, pQuorum->qc->llmqType);
                     auto it = mapQuorumDataRequests.find(key);
                     if (it != mapQuorumDataRequests.end() && !it->second.IsExpired(/*add_bias=*/true)) {
-                        printLog("Already asked");
+                        printLog("Already asked", &memberHash);
                         continue;
                     }
                 }
-                // Sleep a bit depending on the start offset to balance out multiple requests to same masternode
-                quorumThreadInterrupt.sleep_for(std::chrono::milliseconds(nMyStartOffset * 100));
-                nTimeLastSuccess = GetTime<std::chrono::seconds>().count();
-                connman.AddPendingMasternode(*pCurrentMemberHash);
-                printLog("Connect");
+                mapPendingMembers.emplace(memberHash, GetTime<std::chrono::seconds>().count());
+                connman.AddPendingMasternode(memberHash);
+                printLog("Connect", &memberHash);
+            }
+
+            if (mapPendingMembers.empty()) {
+                printLog("All tried but failed");
+                break;
             }
 
             auto proTxHash = WITH_LOCK(activeMasternodeInfoCs, return activeMasternodeInfo.proTxHash);
             connman.ForEachNode([&](CNode* pNode) {
                 auto verifiedProRegTxHash = pNode->GetVerifiedProRegTxHash();
-                if (pCurrentMemberHash == nullptr || verifiedProRegTxHash != *pCurrentMemberHash) {
+                auto itPending = mapPendingMembers.find(verifiedProRegTxHash);
+                if (verifiedProRegTxHash.IsNull() || itPending == mapPendingMembers.end()) {
                     return;
                 }
 
                 if (RequestQuorumData(pNode, pQuorum->qc->llmqType, pQuorum->m_quorum_base_block_index, nDataMask, proTxHash)) {
-                    nTimeLastSuccess = GetTime<std::chrono::seconds>().count();
-                    printLog("Requested");
+                    itPending->second = GetTime<std::chrono::seconds>().count();
+                    printLog("Requested", &verifiedProRegTxHash);
                 } else {
                     LOCK(cs_data_requests);
-                    const CQuorumDataRequestKey key(*pCurrentMemberHash, true, pQuorum->qc->quorumHash, pQuorum->qc->llmqType);
+                    const CQuorumDataRequestKey key(verifiedProRegTxHash, true, pQuorum->qc->quorumHash, pQuorum->qc->llmqType);
                     auto it = mapQuorumDataRequests.find(key);
                     if (it == mapQuorumDataRequests.end()) {
-                        printLog("Failed");
+                        printLog("Failed", &verifiedProRegTxHash);
                         pNode->fDisconnect = true;
-                        pCurrentMemberHash = nullptr;
+                        mapPendingMembers.erase(itPending);
                         return;
                     } else if (it->second.IsProcessed()) {
-                        printLog("Processed");
+                        printLog("Processed", &verifiedProRegTxHash);
                         pNode->fDisconnect = true;
-                        pCurrentMemberHash = nullptr;
+                        mapPendingMembers.erase(itPending);
                         return;
                     } else {
-                        printLog("Waiting");
+                        printLog("Waiting", &verifiedProRegTxHash);
                         return;
                     }
                 }
             });
             quorumThreadInterrupt.sleep_for(std::chrono::seconds(1));
         }
+        if (!mapPendingMembers.empty()) {
+            // Responses of the remaining members are dropped by ProcessMessage once the data is recovered
+            printLog("Cancel outstanding requests");
+        }
         pQuorum->fQuorumDataRecoveryThreadRunning = false;
         printLog("Done");
     });
@@ -997,7 +1077,7 @@ void CQuorumManager::StartQuorumDataRecoveryThread(const CQuorumCPtr pQuorum, co
 
 static void DataCleanupHelper(CDBWrapper& db, std::set<uint256> skip_list, bool compact = false)
 {
-    const auto prefixes = {DB_QUORUM_QUORUM_VVEC, DB_QUORUM_SK_SHARE};
+    const auto prefixes = {DB_QUORUM_QUORUM_VVEC, DB_QUORUM_SK_SHARE, DB_QUORUM_PUBKEY_SHARES};
 
     CDBBatch batch(db);
     std::unique_ptr<CDBIterator> pcursor(db.NewIterator());
@@ -1097,10 +1177,110 @@ void CQuorumManager::StartCleanupOldQuorumDataThread(const CBlockIndex* pIndex)
     });
 }
 
-CQuorumCPtr SelectQuorumForSigning(const Consensus::LLMQParams& llmq_params, const CQuorumManager& quorum_manager, const uint256& selectionHash, int signHeight, int signOffset)
+const CBlockIndex* CQuorumManager::GetQuorumSetBlockIndex(const Consensus::LLMQParams& llmq_params, gsl::not_null<const CBlockIndex*> pindexStart)
+{
+    // Quorum sets can only change during the mining phase of DKG.
+    // Find the closest known block index.
+    const int quorumCycleStartHeight = pindexStart->nHeight - (pindexStart->nHeight % llmq_params.dkgInterval);
+    const int quorumCycleMiningStartHeight = quorumCycleStartHeight + llmq_params.dkgMiningWindowStart;
+    const int quorumCycleMiningEndHeight = quorumCycleStartHeight + llmq_params.dkgMiningWindowEnd;
+
+    if (pindexStart->nHeight < quorumCycleMiningStartHeight) {
+        // too early for this cycle, use the previous one
+        // bail out if it's below genesis block
+        if (quorumCycleMiningEndHeight < llmq_params.dkgInterval) return nullptr;
+        return pindexStart->GetAncestor(quorumCycleMiningEndHeight - llmq_params.dkgInterval);
+    } else if (pindexStart->nHeight > quorumCycleMiningEndHeight) {
+        // we are past the mining phase of this cycle, use it
+        return pindexStart->GetAncestor(quorumCycleMiningEndHeight);
+    }
+    // everything else is inside the mining phase of this cycle, no adjustment needed
+    return pindexStart;
+}
+
+std::shared_ptr<const CQuorumSelectionIndex> CQuorumManager::GetSelectionIndex(const Consensus::LLMQParams& llmq_params, const CBlockIndex* pindexStart) const
+{
+    if (pindexStart == nullptr || !IsQuorumTypeEnabled(llmq_params.type, pindexStart)) {
+        return nullptr;
+    }
+    const CBlockIndex* pindexSet = GetQuorumSetBlockIndex(llmq_params, pindexStart);
+    if (pindexSet == nullptr) {
+        return nullptr;
+    }
+
+    const auto cacheKey = std::make_pair(llmq_params.type, pindexSet->GetBlockHash());
+    std::shared_ptr<const CQuorumSelectionIndex> ret;
+    if (LOCK(cs_selection_index); selectionIndexCache.get(cacheKey, ret)) {
+        return ret;
+    }
+
+    auto index = std::make_shared<CQuorumSelectionIndex>();
+    index->quorums = ScanQuorums(llmq_params.type, pindexStart, llmq_params.signingActiveQuorumCount);
+    if (index->quorums.empty()) {
+        return nullptr;
+    }
+    index->scoreHashers.reserve(index->quorums.size());
+    for (const auto& quorum : index->quorums) {
+        const auto quorumIndex = quorum->qc->quorumIndex;
+        if (quorumIndex >= 0) {
+            if (static_cast<size_t>(quorumIndex) >= index->byQuorumIndex.size()) {
+                index->byQuorumIndex.resize(quorumIndex + 1);
+            }
+            // keep the first one, like a scan through quorums would
+            if (index->byQuorumIndex[quorumIndex] == nullptr) {
+                index->byQuorumIndex[quorumIndex] = quorum;
+            }
+        }
+        CHashWriter h(SER_NETWORK, 0);
+        h << llmq_params.type;
+        h << quorum->qc->quorumHash;
+        index->scoreHashers.emplace_back(std::move(h));
+    }
+
+    LOCK(cs_selection_index);
+    selectionIndexCache.insert(cacheKey, index);
+    return index;
+}
+
+size_t CQuorumManager::DynamicMemoryUsage() const
 {
-    size_t poolSize = llmq_params.signingActiveQuorumCount;
+    size_t nUsage{0};
+    {
+        LOCK(cs_map_quorums);
+        for (const auto& [_, cache] : mapQuorumsCache) {
+            nUsage += cache.DynamicMemoryUsage();
+            cache.for_each([&nUsage](const uint256&, const CQuorumPtr& quorum) {
+                nUsage += memusage::DynamicUsage(quorum) + quorum->DynamicMemoryUsage();
+            });
+        }
+    }
+    {
+        // the scanned quorums themselves are owned by mapQuorumsCache
+        LOCK(cs_scan_quorums);
+        for (const auto& [_, cache] : scanQuorumsCache) {
+            nUsage += cache.DynamicMemoryUsage();
+            cache.for_each([&nUsage](const uint256&, const std::vector<CQuorumCPtr>& quorums) {
+                nUsage += memusage::DynamicUsage(quorums);
+            });
+        }
+    }
+    {
+        LOCK(cs_selection_index);
+        nUsage += selectionIndexCache.DynamicMemoryUsage();
+        selectionIndexCache.for_each([&nUsage](const auto&, const std::shared_ptr<const CQuorumSelectionIndex>& index) {
+            nUsage += memusage::DynamicUsage(index) + memusage::DynamicUsage(index->quorums) +
+                      memusage::DynamicUsage(index->byQuorumIndex) + memusage::DynamicUsage(index->scoreHashers);
+        });
+    }
+    LOCK(cs_cleanup);
+    for (const auto& [_, cache] : cleanupQuorumsCache) {
+        nUsage += cache.DynamicMemoryUsage();
+    }
+    return nUsage;
+}
 
+CQuorumCPtr SelectQuorumForSigning(const Consensus::LLMQParams& llmq_params, const CQuorumManager& quorum_manager, const uint256& selectionHash, int signHeight, int signOffset)
+{
     CBlockIndex* pindexStart;
     {
         LOCK(cs_main);
@@ -1114,11 +1294,12 @@ CQuorumCPtr SelectQuorumForSigning(const Consensus::LLMQParams& llmq_params, con
         pindexStart = ::ChainActive()[startBlockHeight];
     }
 
+    const auto index = quorum_manager.GetSelectionIndex(llmq_params, pindexStart);
+    if (index == nullptr) {
+        return nullptr;
+    }
+
     if (IsQuorumRotationEnabled(llmq_params, pindexStart)) {
-        auto quorums = quorum_manager.ScanQuorums(llmq_params.type, pindexStart, poolSize);
-        if (quorums.empty()) {
-            return nullptr;
-        }
         //log2 int
         int n = std::log2(llmq_params.signingActiveQuorumCount);
         //Extract last 64 bits of selectionHash
@@ -1126,35 +1307,22 @@ CQuorumCPtr SelectQuorumForSigning(const Consensus::LLMQParams& llmq_params, con
         //Take last n bits of b
         uint64_t signer = (((1ull << n) - 1) & (b >> (64 - n - 1)));
 
-        if (signer > quorums.size()) {
-            return nullptr;
-        }
-        auto itQuorum = std::find_if(quorums.begin(),
-                                     quorums.end(),
-                                     [signer](const CQuorumCPtr& obj) {
-                                         return uint64_t(obj->qc->quorumIndex) == signer;
-                                     });
-        if (itQuorum == quorums.end()) {
+        if (signer > index->quorums.size() || signer >= index->byQuorumIndex.size()) {
             return nullptr;
         }
-        return *itQuorum;
+        return index->byQuorumIndex[signer];
     } else {
-        auto quorums = quorum_manager.ScanQuorums(llmq_params.type, pindexStart, poolSize);
-        if (quorums.empty()) {
-            return nullptr;
-        }
-
-        std::vector<std::pair<uint256, size_t>> scores;
-        scores.reserve(quorums.size());
-        for (const auto i : irange::range(quorums.size())) {
-            CHashWriter h(SER_NETWORK, 0);
-            h << llmq_params.type;
-            h << quorums[i]->qc->quorumHash;
+        // the quorum with the lowest score wins
+        std::pair<uint256, size_t> best;
+        for (const auto i : irange::range(index->quorums.size())) {
+            CHashWriter h(index->scoreHashers[i]);
             h << selectionHash;
-            scores.emplace_back(h.GetHash(), i);
+            std::pair<uint256, size_t> score{h.GetHash(), i};
+            if (i == 0 || score < best) {
+                best = std::move(score);
+            }
         }
-        std::sort(scores.begin(), scores.end());
-        return quorums[scores.front().second];
+        return index->quorums[best.second];
     }
 }
 
@@ -1168,6 +1336,6 @@ bool VerifyRecoveredSig(Consensus::LLMQType llmqType, const CQuorumManager& quor
     }
 
     uint256 signHash = BuildSignHash(llmqType, quorum->qc->quorumHash, id, msgHash);
-    return sig.VerifyInsecure(quorum->qc->quorumPublicKey, signHash);
+    return VerifyInsecureCached(sig, quorum->qc->quorumPublicKey, signHash);
 }
 } // namespace llmq
@@ -7,6 +7,7 @@
 
 #include <chain.h>
 #include <consensus/params.h>
+#include <hash.h>
 #include <saltedhasher.h>
 #include <threadinterrupt.h>
 #include <unordered_lru_cache.h>
@@ -183,6 +184,9 @@ private:
     // These are only valid when we either participated in the DKG or fully watched it
     BLSVerificationVectorPtr quorumVvec GUARDED_BY(cs);
     CBLSSecretKey skShare GUARDED_BY(cs);
+    // Public key shares of all members (invalid for invalid members), either recovered by the cache populator or read
+    // from evodb. Empty until one of both happened
+    mutable std::vector<CBLSPublicKey> pubKeyShares GUARDED_BY(cs);
 
 public:
     CQuorum(const Consensus::LLMQParams& _params, CBLSWorker& _blsWorker);
@@ -200,9 +204,27 @@ public:
     CBLSPublicKey GetPubKeyShare(size_t memberIdx) const;
     CBLSSecretKey GetSkShare() const;
 
+    size_t DynamicMemoryUsage() const;
+
 private:
     void WriteContributions(CEvoDB& evoDb) const;
     bool ReadContributions(CEvoDB& evoDb);
+    void SetPubKeyShares(std::vector<CBLSPublicKey>&& pubKeySharesIn) const;
+    void WritePubKeyShares(CEvoDB& evoDb) const;
+    bool ReadPubKeyShares(CEvoDB& evoDb);
+};
+
+/**
+ * The quorums which requests are assigned to while a quorum set is active, prepared for SelectQuorumForSigning
+ * so that a selection doesn't need to scan and order the quorums again.
+ */
+struct CQuorumSelectionIndex {
+    // in the order of ScanQuorums
+    std::vector<CQuorumCPtr> quorums;
+    // rotated quorums by their quorumIndex, nullptr for missing indexes
+    std::vector<CQuorumCPtr> byQuorumIndex;
+    // for each entry of quorums, the score hasher with llmqType and quorumHash already written
+    std::vector<CHashWriter> scoreHashers;
 };
 
 /**
@@ -226,6 +248,9 @@ private:
     mutable std::map<Consensus::LLMQType, unordered_lru_cache<uint256, CQuorumPtr, StaticSaltedHasher>> mapQuorumsCache GUARDED_BY(cs_map_quorums);
     mutable RecursiveMutex cs_scan_quorums;
     mutable std::map<Consensus::LLMQType, unordered_lru_cache<uint256, std::vector<CQuorumCPtr>, StaticSaltedHasher>> scanQuorumsCache GUARDED_BY(cs_scan_quorums);
+    // keyed by the block the quorum set was taken from, i.e. it only gains entries when the set changes
+    mutable Mutex cs_selection_index;
+    mutable unordered_lru_cache<std::pair<Consensus::LLMQType, uint256>, std::shared_ptr<const CQuorumSelectionIndex>, StaticSaltedHasher, 64> selectionIndexCache GUARDED_BY(cs_selection_index);
     mutable Mutex cs_cleanup;
     mutable std::map<Consensus::LLMQType, unordered_lru_cache<uint256, uint256, StaticSaltedHasher>> cleanupQuorumsCache GUARDED_BY(cs_cleanup);
 
@@ -257,8 +282,18 @@ public:
     // this one is cs_main-free
     std::vector<CQuorumCPtr> ScanQuorums(Consensus::LLMQType llmqType, const CBlockIndex* pindexStart, size_t nCountRequested) const;
 
+    // cs_main-free as well, returns nullptr if there are no quorums to sign with at pindexStart
+    std::shared_ptr<const CQuorumSelectionIndex> GetSelectionIndex(const Consensus::LLMQParams& llmq_params, const CBlockIndex* pindexStart) const;
+
+    /// Estimated memory used by the cached quorums, scan results and selection indexes
+    size_t DynamicMemoryUsage() const;
+
 private:
     // all private methods here are cs_main-free
+    /// The block the active quorum set at pindexStart is scanned from. Quorum sets only change during the mining phase of DKG,
+    /// so this is the end of the last mining phase or a block inside the current one. nullptr if that would be below genesis.
+    static const CBlockIndex* GetQuorumSetBlockIndex(const Consensus::LLMQParams& llmq_params, gsl::not_null<const CBlockIndex*> pindexStart);
+
     void CheckQuorumConnections(const Consensus::LLMQParams& llmqParams, const CBlockIndex *pindexNew) const;
 
     CQuorumPtr BuildQuorumFromCommitment(Consensus::LLMQType llmqType, gsl::not_null<const CBlockIndex*> pQuorumBaseBlockIndex, bool populate_cache) const;
@@ -6,6 +6,7 @@
 
 #include <llmq/commitment.h>
 #include <llmq/options.h>
+#include <llmq/pendingbudget.h>
 #include <llmq/quorums.h>
 #include <llmq/signing_shares.h>
 
@@ -13,6 +14,7 @@
 #include <chainparams.h>
 #include <cxxtimer.hpp>
 #include <dbwrapper.h>
+#include <crypto/siphash.h>
 #include <hash.h>
 #include <masternode/node.h>
 #include <net_processing.h>
@@ -43,10 +45,14 @@ UniValue CRecoveredSig::ToJson() const
 }
 
 
+// Most lookups are for sigs we don't have, a larger bloom filter keeps more of them from reading a table
+static const DBProfile RECSIGS_DB_PROFILE{/*bloom_bits=*/16, /*write_buffer_size=*/0, /*shared_cache=*/true};
+
 CRecoveredSigsDb::CRecoveredSigsDb(bool fMemory, bool fWipe) :
-        db(std::make_unique<CDBWrapper>(fMemory ? "" : (GetDataDir() / "llmq/recsigdb"), 8 << 20, fMemory, fWipe))
+        db(std::make_unique<CDBWrapper>(fMemory ? "" : (GetDataDir() / "llmq/recsigdb"), 8 << 20, fMemory, fWipe, /*obfuscate=*/false, RECSIGS_DB_PROFILE))
 {
     MigrateRecoveredSigs();
+    RebuildSigsFilter();
 }
 
 CRecoveredSigsDb::~CRecoveredSigsDb() = default;
@@ -236,8 +242,84 @@ void CRecoveredSigsDb::MigrateRecoveredSigs()
     LogPrint(BCLog::LLMQ, "CRecoveredSigsDb::%d -- done\n", __func__);
 }
 
+void CRecoveredSigsDb::RebuildSigsFilter()
+{
+    {
+        LOCK(cs);
+        // keys of sigs written from now on might be missed by the iterator below
+        fSigsFilterRebuilding = true;
+        sigsFilterPending.clear();
+    }
+
+    std::vector<uint256> keys;
+    std::unique_ptr<CDBIterator> pcursor(db->NewIterator());
+    // "rs_r" holds the ids (twice per sig, with and without msgHash), "rs_s" the sign hashes and "rs_h" the object hashes,
+    // which are also kept for truncated sigs
+    auto startId = std::make_tuple(std::string("rs_r"), (Consensus::LLMQType)0, uint256());
+    pcursor->Seek(startId);
+    while (pcursor->Valid()) {
+        decltype(startId) k;
+        if (!pcursor->GetKey(k) || std::get<0>(k) != "rs_r") {
+            break;
+        }
+        if (keys.empty() || keys.back() != std::get<2>(k)) {
+            keys.emplace_back(std::get<2>(k));
+        }
+        pcursor->Next();
+    }
+    for (const std::string prefix : {"rs_s", "rs_h"}) {
+        auto start = std::make_tuple(prefix, uint256());
+        pcursor->Seek(start);
+        while (pcursor->Valid()) {
+            decltype(start) k;
+            if (!pcursor->GetKey(k) || std::get<0>(k) != prefix) {
+                break;
+            }
+            keys.emplace_back(std::get<1>(k));
+            pcursor->Next();
+        }
+    }
+    pcursor.reset();
+
+    LOCK(cs);
+    const size_t capacity = std::max(MIN_SIGS_FILTER_CAPACITY, 2 * (keys.size() + sigsFilterPending.size()));
+    sigsFilter = CRollingBloomFilter(capacity, 0.001);
+    sigsFilterCapacity = capacity;
+    sigsFilterInserted = 0;
+    fSigsFilterRebuilding = false;
+    for (const auto& key : keys) {
+        AddToSigsFilter(key);
+    }
+    for (const auto& key : sigsFilterPending) {
+        AddToSigsFilter(key);
+    }
+    sigsFilterPending.clear();
+
+    LogPrint(BCLog::LLMQ, "CRecoveredSigsDb::%s -- %d keys, capacity %d\n", __func__, sigsFilterInserted, sigsFilterCapacity);
+}
+
+void CRecoveredSigsDb::AddToSigsFilter(const uint256& key)
+{
+    AssertLockHeld(cs);
+    sigsFilter.insert(key);
+    ++sigsFilterInserted;
+    if (fSigsFilterRebuilding) {
+        sigsFilterPending.emplace_back(key);
+    }
+}
+
+bool CRecoveredSigsDb::SigsFilterMayContain(const uint256& key) const
+{
+    AssertLockHeld(cs);
+    // beyond its capacity the rolling filter starts to forget keys
+    return sigsFilterInserted >= sigsFilterCapacity || sigsFilter.contains(key);
+}
+
 bool CRecoveredSigsDb::HasRecoveredSig(Consensus::LLMQType llmqType, const uint256& id, const uint256& msgHash) const
 {
+    if (!WITH_LOCK(cs, return SigsFilterMayContain(id))) {
+        return false;
+    }
     auto k = std::make_tuple(std::string("rs_r"), llmqType, id, msgHash);
     return db->Exists(k);
 }
@@ -246,10 +328,13 @@ bool CRecoveredSigsDb::HasRecoveredSigForId(Consensus::LLMQType llmqType, const
 {
     auto cacheKey = std::make_pair(llmqType, id);
     bool ret;
+    if (hasSigForIdCache.get(cacheKey, ret)) {
+        return ret;
+    }
     {
         LOCK(cs);
-        if (hasSigForIdCache.get(cacheKey, ret)) {
-            return ret;
+        if (!SigsFilterMayContain(id)) {
+            return false;
         }
     }
 
@@ -257,25 +342,54 @@ bool CRecoveredSigsDb::HasRecoveredSigForId(Consensus::LLMQType llmqType, const
     auto k = std::make_tuple(std::string("rs_r"), llmqType, id);
     ret = db->Exists(k);
 
-    LOCK(cs);
     hasSigForIdCache.insert(cacheKey, ret);
     return ret;
 }
 
+void CRecoveredSigsDb::PrefetchRecoveredSigsForIds(Consensus::LLMQType llmqType, const std::vector<uint256>& ids) const
+{
+    std::vector<uint256> toRead;
+    {
+        LOCK(cs);
+        for (const auto& id : ids) {
+            bool ret;
+            if (!hasSigForIdCache.get(std::make_pair(llmqType, id), ret) && SigsFilterMayContain(id)) {
+                toRead.emplace_back(id);
+            }
+        }
+    }
+    if (toRead.size() < 2) {
+        return;
+    }
+
+    std::vector<std::tuple<std::string, Consensus::LLMQType, uint256>> keys;
+    keys.reserve(toRead.size());
+    for (const auto& id : toRead) {
+        keys.emplace_back("rs_r", llmqType, id);
+    }
+    auto exists = db->MultiExists(keys);
+
+    for (size_t i = 0; i < toRead.size(); i++) {
+        hasSigForIdCache.insert(std::make_pair(llmqType, toRead[i]), exists[i]);
+    }
+}
+
 bool CRecoveredSigsDb::HasRecoveredSigForSession(const uint256& signHash) const
 {
     bool ret;
+    if (hasSigForSessionCache.get(signHash, ret)) {
+        return ret;
+    }
     {
         LOCK(cs);
-        if (hasSigForSessionCache.get(signHash, ret)) {
-            return ret;
+        if (!SigsFilterMayContain(signHash)) {
+            return false;
         }
     }
 
     auto k = std::make_tuple(std::string("rs_s"), signHash);
     ret = db->Exists(k);
 
-    LOCK(cs);
     hasSigForSessionCache.insert(signHash, ret);
     return ret;
 }
@@ -283,17 +397,19 @@ bool CRecoveredSigsDb::HasRecoveredSigForSession(const uint256& signHash) const
 bool CRecoveredSigsDb::HasRecoveredSigForHash(const uint256& hash) const
 {
     bool ret;
+    if (hasSigForHashCache.get(hash, ret)) {
+        return ret;
+    }
     {
         LOCK(cs);
-        if (hasSigForHashCache.get(hash, ret)) {
-            return ret;
+        if (!SigsFilterMayContain(hash)) {
+            return false;
         }
     }
 
     auto k = std::make_tuple(std::string("rs_h"), hash);
     ret = db->Exists(k);
 
-    LOCK(cs);
     hasSigForHashCache.insert(hash, ret);
     return ret;
 }
@@ -362,6 +478,9 @@ void CRecoveredSigsDb::WriteRecoveredSig(const llmq::CRecoveredSig& recSig)
 
     {
         LOCK(cs);
+        AddToSigsFilter(recSig.getId());
+        AddToSigsFilter(signHash);
+        AddToSigsFilter(recSig.GetHash());
         hasSigForIdCache.insert(std::make_pair(recSig.getLlmqType(), recSig.getId()), true);
         hasSigForSessionCache.insert(signHash, true);
         hasSigForHashCache.insert(recSig.GetHash(), true);
@@ -420,6 +539,11 @@ void CRecoveredSigsDb::TruncateRecoveredSig(Consensus::LLMQType llmqType, const
 
 void CRecoveredSigsDb::CleanupOldRecoveredSigs(int64_t maxAge)
 {
+    // resize the filter before it runs full, this also drops the keys of deleted sigs from it
+    if (WITH_LOCK(cs, return sigsFilterInserted >= sigsFilterCapacity * 3 / 4)) {
+        RebuildSigsFilter();
+    }
+
     std::unique_ptr<CDBIterator> pcursor(db->NewIterator());
 
     auto start = std::make_tuple(std::string("rs_t"), (uint32_t)0, (Consensus::LLMQType)0, uint256());
@@ -539,9 +663,9 @@ void CRecoveredSigsDb::CleanupOldVotes(int64_t maxAge)
 
 //////////////////
 
-CSigningManager::CSigningManager(CConnman& _connman, const CQuorumManager& _qman,
+CSigningManager::CSigningManager(CBLSWorker& _blsWorker, CConnman& _connman, const CQuorumManager& _qman,
                                  bool fMemory, bool fWipe) :
-    db(fMemory, fWipe), connman(_connman), qman(_qman)
+    db(fMemory, fWipe), blsWorker(_blsWorker), connman(_connman), qman(_qman)
 {
 }
 
@@ -550,6 +674,9 @@ bool CSigningManager::AlreadyHave(const CInv& inv) const
     if (inv.type != MSG_QUORUM_RECOVERED_SIG) {
         return false;
     }
+    if (bool tmp; knownRecSigShortIds.get(GetRecoveredSigShortId(inv.hash), tmp)) {
+        return true;
+    }
     {
         LOCK(cs);
         if (pendingReconstructedRecoveredSigs.count(inv.hash)) {
@@ -572,9 +699,21 @@ bool CSigningManager::GetRecoveredSigForGetData(const uint256& hash, CRecoveredS
     return true;
 }
 
+uint64_t CSigningManager::GetRecoveredSigShortId(const uint256& hash) const
+{
+    return SipHashUint256(shortIdK0, shortIdK1, hash);
+}
+
 PeerMsgRet CSigningManager::ProcessMessage(const CNode& pfrom, gsl::not_null<PeerManager*> peerman, const std::string& msg_type, CDataStream& vRecv)
 {
     if (msg_type == NetMsgType::QSIGREC) {
+        const uint256 hash = Hash(vRecv);
+        if (bool tmp; knownRecSigShortIds.get(GetRecoveredSigShortId(hash), tmp)) {
+            LOCK(cs_main);
+            EraseObjectRequest(pfrom.GetId(), CInv(MSG_QUORUM_RECOVERED_SIG, hash));
+            return {};
+        }
+
         auto recoveredSig = std::make_shared<CRecoveredSig>();
         vRecv >> *recoveredSig;
 
@@ -622,6 +761,7 @@ PeerMsgRet CSigningManager::ProcessMessageRecoveredSig(const CNode& pfrom, gsl::
     assert(m_peerman == peerman);
 
     pendingRecoveredSigs[pfrom.GetId()].emplace_back(recoveredSig);
+    pendingMessagesBudget.Charge(pfrom.GetId(), sizeof(CRecoveredSig));
     return {};
 }
 
@@ -676,6 +816,7 @@ void CSigningManager::CollectPendingRecoveredSigsToVerify(
                 retSigShares[nodeId].emplace_back(recSig);
             }
             ns.erase(ns.begin());
+            pendingMessagesBudget.Release(nodeId, sizeof(CRecoveredSig));
             return !ns.empty();
         }, rnd);
 
@@ -743,7 +884,7 @@ bool CSigningManager::ProcessPendingRecoveredSigs()
 
     // It's ok to perform insecure batched verification here as we verify against the quorum public keys, which are not
     // craftable by individual entities, making the rogue public key attack impossible
-    CBLSBatchVerifier<NodeId, uint256> batchVerifier(false, false);
+    CBLSBatchVerifier<NodeId, uint256> batchVerifier(false, false, 0, /* useSigCache */ true, &blsWorker);
 
     size_t verifyCount = 0;
     for (const auto& p : recSigsByNode) {
@@ -797,6 +938,7 @@ void CSigningManager::ProcessRecoveredSig(const std::shared_ptr<const CRecovered
 {
     auto llmqType = recoveredSig->getLlmqType();
 
+    knownRecSigShortIds.insert(GetRecoveredSigShortId(recoveredSig->GetHash()), true);
     if (db.HasRecoveredSigForHash(recoveredSig->GetHash())) {
         return;
     }
@@ -972,6 +1114,11 @@ bool CSigningManager::HasRecoveredSigForId(Consensus::LLMQType llmqType, const u
     return db.HasRecoveredSigForId(llmqType, id);
 }
 
+void CSigningManager::PrefetchRecoveredSigsForIds(Consensus::LLMQType llmqType, const std::vector<uint256>& ids) const
+{
+    db.PrefetchRecoveredSigsForIds(llmqType, ids);
+}
+
 bool CSigningManager::HasRecoveredSigForSession(const uint256& signHash) const
 {
     return db.HasRecoveredSigForSession(signHash);
@@ -5,6 +5,7 @@
 #ifndef BITCOIN_LLMQ_SIGNING_H
 #define BITCOIN_LLMQ_SIGNING_H
 
+#include <bloom.h>
 #include <bls/bls.h>
 #include <consensus/params.h>
 #include <gsl/pointers.h>
@@ -16,11 +17,13 @@
 #include <univalue.h>
 #include <unordered_lru_cache.h>
 
+#include <limits>
 #include <unordered_map>
 
 class CConnman;
 class CDataStream;
 class CDBBatch;
+class CBLSWorker;
 class CDBWrapper;
 class CInv;
 class CNode;
@@ -114,9 +117,20 @@ private:
     std::unique_ptr<CDBWrapper> db{nullptr};
 
     mutable RecursiveMutex cs;
-    mutable unordered_lru_cache<std::pair<Consensus::LLMQType, uint256>, bool, StaticSaltedHasher, 30000> hasSigForIdCache GUARDED_BY(cs);
-    mutable unordered_lru_cache<uint256, bool, StaticSaltedHasher, 30000> hasSigForSessionCache GUARDED_BY(cs);
-    mutable unordered_lru_cache<uint256, bool, StaticSaltedHasher, 30000> hasSigForHashCache GUARDED_BY(cs);
+    mutable sharded_unordered_lru_cache<std::pair<Consensus::LLMQType, uint256>, bool, StaticSaltedHasher, 30000> hasSigForIdCache{"recsigs.hasSigForId"};
+    mutable sharded_unordered_lru_cache<uint256, bool, StaticSaltedHasher, 30000> hasSigForSessionCache{"recsigs.hasSigForSession"};
+    mutable sharded_unordered_lru_cache<uint256, bool, StaticSaltedHasher, 30000> hasSigForHashCache{"recsigs.hasSigForHash"};
+
+    // Holds the id, sign hash and object hash of every stored recovered sig, so that a miss answers the has* queries
+    // without touching the db. Removed sigs stay in it until the next rebuild from the db, which also happens once the
+    // filter gets close to the capacity it is guaranteed to remember.
+    static constexpr size_t MIN_SIGS_FILTER_CAPACITY = 100000;
+    CRollingBloomFilter sigsFilter GUARDED_BY(cs) {MIN_SIGS_FILTER_CAPACITY, 0.001};
+    size_t sigsFilterCapacity GUARDED_BY(cs) {MIN_SIGS_FILTER_CAPACITY};
+    size_t sigsFilterInserted GUARDED_BY(cs) {0};
+    // keys written while a rebuild is scanning the db, added to the new filter when it is swapped in
+    bool fSigsFilterRebuilding GUARDED_BY(cs) {false};
+    std::vector<uint256> sigsFilterPending GUARDED_BY(cs);
 
 public:
     explicit CRecoveredSigsDb(bool fMemory, bool fWipe);
@@ -124,6 +138,8 @@ public:
 
     bool HasRecoveredSig(Consensus::LLMQType llmqType, const uint256& id, const uint256& msgHash) const;
     bool HasRecoveredSigForId(Consensus::LLMQType llmqType, const uint256& id) const;
+    // looks up the ids HasRecoveredSigForId doesn't know the answer for yet in one batch and caches the results
+    void PrefetchRecoveredSigsForIds(Consensus::LLMQType llmqType, const std::vector<uint256>& ids) const;
     bool HasRecoveredSigForSession(const uint256& signHash) const;
     bool HasRecoveredSigForHash(const uint256& hash) const;
     bool GetRecoveredSigByHash(const uint256& hash, CRecoveredSig& ret) const;
@@ -143,6 +159,11 @@ public:
 private:
     void MigrateRecoveredSigs();
 
+    void RebuildSigsFilter() LOCKS_EXCLUDED(cs);
+    void AddToSigsFilter(const uint256& key) EXCLUSIVE_LOCKS_REQUIRED(cs);
+    //! false if the key is definitely not in the db
+    bool SigsFilterMayContain(const uint256& key) const EXCLUSIVE_LOCKS_REQUIRED(cs);
+
     bool ReadRecoveredSig(Consensus::LLMQType llmqType, const uint256& id, CRecoveredSig& ret) const;
     void RemoveRecoveredSig(CDBBatch& batch, Consensus::LLMQType llmqType, const uint256& id, bool deleteHashKey, bool deleteTimeKey) EXCLUSIVE_LOCKS_REQUIRED(cs);
 };
@@ -161,6 +182,7 @@ private:
     mutable RecursiveMutex cs;
 
     CRecoveredSigsDb db;
+    CBLSWorker& blsWorker;
     CConnman& connman;
     const CQuorumManager& qman;
 
@@ -170,6 +192,13 @@ private:
     std::unordered_map<NodeId, std::list<std::shared_ptr<const CRecoveredSig>>> pendingRecoveredSigs GUARDED_BY(cs);
     std::unordered_map<uint256, std::shared_ptr<const CRecoveredSig>, StaticSaltedHasher> pendingReconstructedRecoveredSigs GUARDED_BY(cs);
 
+    // Salted short ids of recently processed recovered sigs. The hash of a recovered sig is the hash of its
+    // serialization, so copies arriving from other peers are dropped by hashing the raw message, before deserializing
+    // and checking them against the quorums and the db
+    const uint64_t shortIdK0{GetRand(std::numeric_limits<uint64_t>::max())};
+    const uint64_t shortIdK1{GetRand(std::numeric_limits<uint64_t>::max())};
+    mutable sharded_unordered_lru_cache<uint64_t, bool, std::hash<uint64_t>, 30000> knownRecSigShortIds{"recsigs.knownShortIds"};
+
     FastRandomContext rnd GUARDED_BY(cs);
 
     int64_t lastCleanupTime{0};
@@ -177,7 +206,7 @@ private:
     std::vector<CRecoveredSigsListener*> recoveredSigsListeners GUARDED_BY(cs);
 
 public:
-    CSigningManager(CConnman& _connman, const CQuorumManager& _qman, bool fMemory, bool fWipe);
+    CSigningManager(CBLSWorker& _blsWorker, CConnman& _connman, const CQuorumManager& _qman, bool fMemory, bool fWipe);
 
     bool AlreadyHave(const CInv& inv) const;
     bool GetRecoveredSigForGetData(const uint256& hash, CRecoveredSig& ret) const;
@@ -197,6 +226,7 @@ public:
 private:
     PeerMsgRet ProcessMessageRecoveredSig(const CNode& pfrom, gsl::not_null<PeerManager*> peerman, const std::shared_ptr<const CRecoveredSig>& recoveredSig);
     static bool PreVerifyRecoveredSig(const CQuorumManager& quorum_manager, const CRecoveredSig& recoveredSig, bool& retBan);
+    uint64_t GetRecoveredSigShortId(const uint256& hash) const;
 
     void CollectPendingRecoveredSigsToVerify(size_t maxUniqueSessions,
             std::unordered_map<NodeId, std::list<std::shared_ptr<const CRecoveredSig>>>& retSigShares,
@@ -217,6 +247,7 @@ public:
     bool AsyncSignIfMember(Consensus::LLMQType llmqType, CSigSharesManager& shareman, const uint256& id, const uint256& msgHash, const uint256& quorumHash = uint256(), bool allowReSign = false);
     bool HasRecoveredSig(Consensus::LLMQType llmqType, const uint256& id, const uint256& msgHash) const;
     bool HasRecoveredSigForId(Consensus::LLMQType llmqType, const uint256& id) const;
+    void PrefetchRecoveredSigsForIds(Consensus::LLMQType llmqType, const std::vector<uint256>& ids) const;
     bool HasRecoveredSigForSession(const uint256& signHash) const;
     bool GetRecoveredSigForId(Consensus::LLMQType llmqType, const uint256& id, CRecoveredSig& retRecSig) const;
     bool IsConflicting(Consensus::LLMQType llmqType, const uint256& id, const uint256& msgHash) const;
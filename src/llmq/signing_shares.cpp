@@ -5,6 +5,7 @@
 #include <llmq/signing_shares.h>
 
 #include <llmq/options.h>
+#include <llmq/pendingbudget.h>
 #include <llmq/quorums.h>
 #include <llmq/commitment.h>
 #include <llmq/signing.h>
@@ -19,7 +20,9 @@
 #include <util/irange.h>
 #include <util/thread.h>
 #include <util/time.h>
+#include <util/trace.h>
 #include <util/underlying.h>
+#include <statsd_client.h>
 
 #include <cxxtimer.hpp>
 
@@ -97,6 +100,110 @@ std::string CBatchedSigShares::ToInvString() const
     return inv.ToString();
 }
 
+bool CSigSharesBundle::empty() const
+{
+    return sessionAnns.empty() && requests.empty() && batchedSigShares.empty() && announcements.empty() && sigShares.empty();
+}
+
+std::string CSigSharesBundle::ToString() const
+{
+    return strprintf("sessionAnns=%d, requests=%d, batchedSigShares=%d, announcements=%d, sigShares=%d",
+                     sessionAnns.size(), requests.size(), batchedSigShares.size(), announcements.size(), sigShares.size());
+}
+
+bool CSigSharesStore::Add(const CSigShare& sigShare, int64_t now, size_t& retCount)
+{
+    auto& shard = GetShard(sigShare.GetSignHash());
+    LOCK(shard.cs);
+    if (!shard.sigShares.Add(sigShare.GetKey(), sigShare)) {
+        return false;
+    }
+    shard.timeSeenForSessions[sigShare.GetSignHash()] = now;
+    shard.timeFirstSeenForSessions.try_emplace(sigShare.GetSignHash(), GetTimeMillis());
+    retCount = shard.sigShares.CountForSignHash(sigShare.GetSignHash());
+    return true;
+}
+
+bool CSigSharesStore::Has(const SigShareKey& k) const
+{
+    const auto& shard = GetShard(k.first);
+    LOCK(shard.cs);
+    return shard.sigShares.Has(k);
+}
+
+std::optional<CSigShare> CSigSharesStore::Get(const SigShareKey& k) const
+{
+    const auto& shard = GetShard(k.first);
+    LOCK(shard.cs);
+    const auto* sigShare = shard.sigShares.Get(k);
+    if (sigShare == nullptr) {
+        return std::nullopt;
+    }
+    return *sigShare;
+}
+
+size_t CSigSharesStore::CountForSignHash(const uint256& signHash) const
+{
+    const auto& shard = GetShard(signHash);
+    LOCK(shard.cs);
+    return shard.sigShares.CountForSignHash(signHash);
+}
+
+void CSigSharesStore::EraseAllForSignHash(const uint256& signHash)
+{
+    auto& shard = GetShard(signHash);
+    LOCK(shard.cs);
+    shard.sigShares.EraseAllForSignHash(signHash);
+    shard.timeSeenForSessions.erase(signHash);
+    shard.timeFirstSeenForSessions.erase(signHash);
+}
+
+std::optional<int64_t> CSigSharesStore::GetFirstSeenTime(const uint256& signHash) const
+{
+    const auto& shard = GetShard(signHash);
+    LOCK(shard.cs);
+    const auto it = shard.timeFirstSeenForSessions.find(signHash);
+    if (it == shard.timeFirstSeenForSessions.end()) {
+        return std::nullopt;
+    }
+    return it->second;
+}
+
+size_t CSigSharesStore::SessionCount() const
+{
+    size_t ret{0};
+    for (const auto& shard : shards) {
+        LOCK(shard.cs);
+        ret += shard.timeSeenForSessions.size();
+    }
+    return ret;
+}
+
+size_t CSigSharesStore::DynamicMemoryUsage() const
+{
+    size_t ret{0};
+    for (const auto& shard : shards) {
+        LOCK(shard.cs);
+        ret += shard.sigShares.DynamicMemoryUsage() + memusage::DynamicUsage(shard.timeSeenForSessions) +
+               memusage::DynamicUsage(shard.timeFirstSeenForSessions);
+    }
+    return ret;
+}
+
+std::vector<uint256> CSigSharesStore::GetTimedOutSessions(int64_t now, int64_t timeout) const
+{
+    std::vector<uint256> ret;
+    for (const auto& shard : shards) {
+        LOCK(shard.cs);
+        for (const auto& [signHash, lastSeenTime] : shard.timeSeenForSessions) {
+            if (now - lastSeenTime >= timeout) {
+                ret.emplace_back(signHash);
+            }
+        }
+    }
+    return ret;
+}
+
 static void InitSession(CSigSharesNodeState::Session& s, const uint256& signHash, CSigBase from)
 {
     const auto& llmq_params_opt = Params().GetLLMQ(from.getLlmqType());
@@ -176,8 +283,31 @@ void CSigSharesNodeState::RemoveSession(const uint256& signHash)
     pendingIncomingSigShares.EraseAllForSignHash(signHash);
 }
 
+size_t CSigSharesNodeState::DynamicMemoryUsage() const
+{
+    size_t ret = memusage::DynamicUsage(sessions) + memusage::DynamicUsage(sessionByRecvId) +
+                 pendingIncomingSigShares.DynamicMemoryUsage() + requestedSigShares.DynamicMemoryUsage();
+    for (const auto& [_, session] : sessions) {
+        ret += memusage::DynamicUsage(session.announced.inv) + memusage::DynamicUsage(session.requested.inv) +
+               memusage::DynamicUsage(session.knows.inv);
+    }
+    return ret;
+}
+
 //////////////////////
 
+size_t CSigSharesManager::DynamicMemoryUsage() const
+{
+    LOCK2(cs, cs_nodeStates);
+    size_t ret = memusage::DynamicUsage(signedSessions) + memusage::DynamicUsage(nodeStates) +
+                 sigSharesRequested.DynamicMemoryUsage() + sigSharesQueuedToAnnounce.DynamicMemoryUsage() +
+                 unverifiedSigShares.DynamicMemoryUsage() + memusage::DynamicUsage(pendingSigns);
+    for (const auto& [_, nodeState] : nodeStates) {
+        ret += nodeState.DynamicMemoryUsage();
+    }
+    return ret + sigShares.DynamicMemoryUsage();
+}
+
 void CSigSharesManager::StartWorkerThread()
 {
     // can't start new thread if we have one running already
@@ -222,78 +352,100 @@ void CSigSharesManager::ProcessMessage(const CNode& pfrom, const CSporkManager&
         return;
     }
 
-    if (sporkManager.IsSporkActive(SPORK_21_QUORUM_ALL_CONNECTED) && msg_type == NetMsgType::QSIGSHARE) {
-        std::vector<CSigShare> receivedSigShares;
-        vRecv >> receivedSigShares;
-
-        if (receivedSigShares.size() > MAX_MSGS_SIG_SHARES) {
-            LogPrint(BCLog::LLMQ_SIGS, "CSigSharesManager::%s -- too many sigs in QSIGSHARE message. cnt=%d, max=%d, node=%d\n", __func__, receivedSigShares.size(), MAX_MSGS_SIG_SHARES, pfrom.GetId());
-            BanNode(pfrom.GetId());
-            return;
-        }
-
-        for (const auto& sigShare : receivedSigShares) {
-            ProcessMessageSigShare(pfrom.GetId(), sigShare);
-        }
-    }
-
-    if (msg_type == NetMsgType::QSIGSESANN) {
+    const bool fAllConnected = sporkManager.IsSporkActive(SPORK_21_QUORUM_ALL_CONNECTED);
+    bool fValid{true};
+
+    if (msg_type == NetMsgType::QSIGSHARESBUNDLE) {
+        CSigSharesBundle bundle;
+        vRecv >> bundle;
+        LogPrint(BCLog::LLMQ_SIGS, "CSigSharesManager::%s -- QSIGSHARESBUNDLE bundle={%s}, node=%d\n", __func__, bundle.ToString(), pfrom.GetId());
+        fValid = ProcessMessageSigSesAnns(pfrom, bundle.sessionAnns) &&
+                 ProcessMessageGetSigSharesInvs(pfrom, bundle.requests) &&
+                 ProcessMessageBatchedSigSharesList(pfrom, bundle.batchedSigShares) &&
+                 ProcessMessageSigSharesInvs(pfrom, bundle.announcements) &&
+                 (!fAllConnected || ProcessMessageSigShares(pfrom, bundle.sigShares));
+    } else if (fAllConnected && msg_type == NetMsgType::QSIGSHARE) {
+        std::vector<CSigShare> msgs;
+        vRecv >> msgs;
+        fValid = ProcessMessageSigShares(pfrom, msgs);
+    } else if (msg_type == NetMsgType::QSIGSESANN) {
         std::vector<CSigSesAnn> msgs;
         vRecv >> msgs;
-        if (msgs.size() > MAX_MSGS_CNT_QSIGSESANN) {
-            LogPrint(BCLog::LLMQ_SIGS, "CSigSharesManager::%s -- too many announcements in QSIGSESANN message. cnt=%d, max=%d, node=%d\n", __func__, msgs.size(), MAX_MSGS_CNT_QSIGSESANN, pfrom.GetId());
-            BanNode(pfrom.GetId());
-            return;
-        }
-        if (!ranges::all_of(msgs,
-                            [this, &pfrom](const auto& ann){ return ProcessMessageSigSesAnn(pfrom, ann); })) {
-            BanNode(pfrom.GetId());
-            return;
-        }
+        fValid = ProcessMessageSigSesAnns(pfrom, msgs);
     } else if (msg_type == NetMsgType::QSIGSHARESINV) {
         std::vector<CSigSharesInv> msgs;
         vRecv >> msgs;
-        if (msgs.size() > MAX_MSGS_CNT_QSIGSHARESINV) {
-            LogPrint(BCLog::LLMQ_SIGS, "CSigSharesManager::%s -- too many invs in QSIGSHARESINV message. cnt=%d, max=%d, node=%d\n", __func__, msgs.size(), MAX_MSGS_CNT_QSIGSHARESINV, pfrom.GetId());
-            BanNode(pfrom.GetId());
-            return;
-        }
-        if (!ranges::all_of(msgs,
-                            [this, &pfrom](const auto& inv){ return ProcessMessageSigSharesInv(pfrom, inv); })) {
-            BanNode(pfrom.GetId());
-            return;
-        }
+        fValid = ProcessMessageSigSharesInvs(pfrom, msgs);
     } else if (msg_type == NetMsgType::QGETSIGSHARES) {
         std::vector<CSigSharesInv> msgs;
         vRecv >> msgs;
-        if (msgs.size() > MAX_MSGS_CNT_QGETSIGSHARES) {
-            LogPrint(BCLog::LLMQ_SIGS, "CSigSharesManager::%s -- too many invs in QGETSIGSHARES message. cnt=%d, max=%d, node=%d\n", __func__, msgs.size(), MAX_MSGS_CNT_QGETSIGSHARES, pfrom.GetId());
-            BanNode(pfrom.GetId());
-            return;
-        }
-        if (!ranges::all_of(msgs,
-                            [this, &pfrom](const auto& inv){ return ProcessMessageGetSigShares(pfrom, inv); })) {
-            BanNode(pfrom.GetId());
-            return;
-        }
+        fValid = ProcessMessageGetSigSharesInvs(pfrom, msgs);
     } else if (msg_type == NetMsgType::QBSIGSHARES) {
         std::vector<CBatchedSigShares> msgs;
         vRecv >> msgs;
-        size_t totalSigsCount = 0;
-        for (const auto& bs : msgs) {
-            totalSigsCount += bs.sigShares.size();
-        }
-        if (totalSigsCount > MAX_MSGS_TOTAL_BATCHED_SIGS) {
-            LogPrint(BCLog::LLMQ_SIGS, "CSigSharesManager::%s -- too many sigs in QBSIGSHARES message. cnt=%d, max=%d, node=%d\n", __func__, msgs.size(), MAX_MSGS_TOTAL_BATCHED_SIGS, pfrom.GetId());
-            BanNode(pfrom.GetId());
-            return;
-        }
-        if (!ranges::all_of(msgs,
-                            [this, &pfrom](const auto& bs){ return ProcessMessageBatchedSigShares(pfrom, bs); })) {
-            BanNode(pfrom.GetId());
-            return;
-        }
+        fValid = ProcessMessageBatchedSigSharesList(pfrom, msgs);
+    }
+
+    if (!fValid) {
+        BanNode(pfrom.GetId());
+    }
+}
+
+bool CSigSharesManager::ProcessMessageSigShares(const CNode& pfrom, const std::vector<CSigShare>& msgs)
+{
+    if (msgs.size() > MAX_MSGS_SIG_SHARES) {
+        LogPrint(BCLog::LLMQ_SIGS, "CSigSharesManager::%s -- too many sigs in QSIGSHARE message. cnt=%d, max=%d, node=%d\n", __func__, msgs.size(), MAX_MSGS_SIG_SHARES, pfrom.GetId());
+        return false;
+    }
+
+    for (const auto& sigShare : msgs) {
+        ProcessMessageSigShare(pfrom.GetId(), sigShare);
+    }
+    return true;
+}
+
+bool CSigSharesManager::ProcessMessageSigSesAnns(const CNode& pfrom, const std::vector<CSigSesAnn>& msgs)
+{
+    if (msgs.size() > MAX_MSGS_CNT_QSIGSESANN) {
+        LogPrint(BCLog::LLMQ_SIGS, "CSigSharesManager::%s -- too many announcements in QSIGSESANN message. cnt=%d, max=%d, node=%d\n", __func__, msgs.size(), MAX_MSGS_CNT_QSIGSESANN, pfrom.GetId());
+        return false;
+    }
+    return ranges::all_of(msgs,
+                          [this, &pfrom](const auto& ann){ return ProcessMessageSigSesAnn(pfrom, ann); });
+}
+
+bool CSigSharesManager::ProcessMessageSigSharesInvs(const CNode& pfrom, const std::vector<CSigSharesInv>& msgs)
+{
+    if (msgs.size() > MAX_MSGS_CNT_QSIGSHARESINV) {
+        LogPrint(BCLog::LLMQ_SIGS, "CSigSharesManager::%s -- too many invs in QSIGSHARESINV message. cnt=%d, max=%d, node=%d\n", __func__, msgs.size(), MAX_MSGS_CNT_QSIGSHARESINV, pfrom.GetId());
+        return false;
+    }
+    return ranges::all_of(msgs,
+                          [this, &pfrom](const auto& inv){ return ProcessMessageSigSharesInv(pfrom, inv); });
+}
+
+bool CSigSharesManager::ProcessMessageGetSigSharesInvs(const CNode& pfrom, const std::vector<CSigSharesInv>& msgs)
+{
+    if (msgs.size() > MAX_MSGS_CNT_QGETSIGSHARES) {
+        LogPrint(BCLog::LLMQ_SIGS, "CSigSharesManager::%s -- too many invs in QGETSIGSHARES message. cnt=%d, max=%d, node=%d\n", __func__, msgs.size(), MAX_MSGS_CNT_QGETSIGSHARES, pfrom.GetId());
+        return false;
+    }
+    return ranges::all_of(msgs,
+                          [this, &pfrom](const auto& inv){ return ProcessMessageGetSigShares(pfrom, inv); });
+}
+
+bool CSigSharesManager::ProcessMessageBatchedSigSharesList(const CNode& pfrom, const std::vector<CBatchedSigShares>& msgs)
+{
+    size_t totalSigsCount = 0;
+    for (const auto& bs : msgs) {
+        totalSigsCount += bs.sigShares.size();
+    }
+    if (totalSigsCount > MAX_MSGS_TOTAL_BATCHED_SIGS) {
+        LogPrint(BCLog::LLMQ_SIGS, "CSigSharesManager::%s -- too many sigs in QBSIGSHARES message. cnt=%d, max=%d, node=%d\n", __func__, msgs.size(), MAX_MSGS_TOTAL_BATCHED_SIGS, pfrom.GetId());
+        return false;
     }
+    return ranges::all_of(msgs,
+                          [this, &pfrom](const auto& bs){ return ProcessMessageBatchedSigShares(pfrom, bs); });
 }
 
 bool CSigSharesManager::ProcessMessageSigSesAnn(const CNode& pfrom, const CSigSesAnn& ann)
@@ -316,7 +468,7 @@ bool CSigSharesManager::ProcessMessageSigSesAnn(const CNode& pfrom, const CSigSe
         return true; // let's still try other announcements from the same message
     }
 
-    LOCK(cs);
+    LOCK(cs_nodeStates);
     auto& nodeState = nodeStates[pfrom.GetId()];
     auto& session = nodeState.GetOrCreateSessionFromAnn(ann);
     nodeState.sessionByRecvId.erase(session.recvSessionId);
@@ -360,7 +512,7 @@ bool CSigSharesManager::ProcessMessageSigSharesInv(const CNode& pfrom, const CSi
         return true;
     }
 
-    LOCK(cs);
+    LOCK(cs_nodeStates);
     auto& nodeState = nodeStates[pfrom.GetId()];
     auto* session = nodeState.GetSessionByRecvId(inv.sessionId);
     if (session == nullptr) {
@@ -390,7 +542,7 @@ bool CSigSharesManager::ProcessMessageGetSigShares(const CNode& pfrom, const CSi
     LogPrint(BCLog::LLMQ_SIGS, "CSigSharesManager::%s -- signHash=%s, inv={%s}, node=%d\n", __func__,
             sessionInfo.signHash.ToString(), inv.ToString(), pfrom.GetId());
 
-    LOCK(cs);
+    LOCK(cs_nodeStates);
     auto& nodeState = nodeStates[pfrom.GetId()];
     auto* session = nodeState.GetSessionByRecvId(inv.sessionId);
     if (session == nullptr) {
@@ -416,7 +568,7 @@ bool CSigSharesManager::ProcessMessageBatchedSigShares(const CNode& pfrom, const
     sigSharesToProcess.reserve(batchedSigShares.sigShares.size());
 
     {
-        LOCK(cs);
+        LOCK(cs_nodeStates);
         auto& nodeState = nodeStates[pfrom.GetId()];
 
         for (const auto& sigSharetmp : batchedSigShares.sigShares) {
@@ -447,11 +599,13 @@ bool CSigSharesManager::ProcessMessageBatchedSigShares(const CNode& pfrom, const
         return true;
     }
 
-    LOCK(cs);
+    LOCK(cs_nodeStates);
     auto& nodeState = nodeStates[pfrom.GetId()];
+    size_t nAdded{0};
     for (const auto& s : sigSharesToProcess) {
-        nodeState.pendingIncomingSigShares.Add(s.GetKey(), s);
+        nAdded += nodeState.pendingIncomingSigShares.Add(s.GetKey(), s) ? 1 : 0;
     }
+    pendingMessagesBudget.Charge(pfrom.GetId(), nAdded * sizeof(CSigShare));
     return true;
 }
 
@@ -487,19 +641,20 @@ void CSigSharesManager::ProcessMessageSigShare(NodeId fromId, const CSigShare& s
         return;
     }
 
-    {
-        LOCK(cs);
-
-        if (sigShares.Has(sigShare.GetKey())) {
-            return;
-        }
+    if (sigShares.Has(sigShare.GetKey())) {
+        return;
+    }
 
-        if (sigman.HasRecoveredSigForId(sigShare.getLlmqType(), sigShare.getId())) {
-            return;
-        }
+    if (sigman.HasRecoveredSigForId(sigShare.getLlmqType(), sigShare.getId())) {
+        return;
+    }
 
+    {
+        LOCK(cs_nodeStates);
         auto& nodeState = nodeStates[fromId];
-        nodeState.pendingIncomingSigShares.Add(sigShare.GetKey(), sigShare);
+        if (nodeState.pendingIncomingSigShares.Add(sigShare.GetKey(), sigShare)) {
+            pendingMessagesBudget.Charge(fromId, sizeof(CSigShare));
+        }
     }
 
     LogPrint(BCLog::LLMQ_SIGS, "CSigSharesManager::%s -- signHash=%s, id=%s, msgHash=%s, member=%d, node=%d\n", __func__,
@@ -553,7 +708,7 @@ void CSigSharesManager::CollectPendingSigSharesToVerify(
         std::unordered_map<std::pair<Consensus::LLMQType, uint256>, CQuorumCPtr, StaticSaltedHasher>& retQuorums)
 {
     {
-        LOCK(cs);
+        LOCK(cs_nodeStates);
         if (nodeStates.empty()) {
             return;
         }
@@ -573,12 +728,12 @@ void CSigSharesManager::CollectPendingSigSharesToVerify(
             }
             const auto& sigShare = *ns.pendingIncomingSigShares.GetFirst();
 
-            AssertLockHeld(cs);
             if (const bool alreadyHave = this->sigShares.Has(sigShare.GetKey()); !alreadyHave) {
                 uniqueSignHashes.emplace(nodeId, sigShare.GetSignHash());
                 retSigShares[nodeId].emplace_back(sigShare);
             }
             ns.pendingIncomingSigShares.Erase(sigShare.GetKey());
+            pendingMessagesBudget.Release(nodeId, sizeof(CSigShare));
             return !ns.pendingIncomingSigShares.Empty();
         }, rnd);
 
@@ -618,10 +773,13 @@ bool CSigSharesManager::ProcessPendingSigShares(const CConnman& connman)
 
     // It's ok to perform insecure batched verification here as we verify against the quorum public key shares,
     // which are not craftable by individual entities, making the rogue public key attack impossible
-    CBLSBatchVerifier<NodeId, SigShareKey> batchVerifier(false, true);
+    CBLSBatchVerifier<NodeId, SigShareKey> batchVerifier(false, true, 0, /* useSigCache */ false, &blsWorker);
 
     cxxtimer::Timer prepareTimer(true);
     size_t verifyCount = 0;
+    std::unordered_set<NodeId> invalidNodes;
+    std::unordered_set<SigShareKey, StaticSaltedHasher> deferredKeys;
+    std::unordered_map<uint256, CQuorumCPtr, StaticSaltedHasher> deferredSessions;
     for (const auto& [nodeId, v] : sigSharesByNodes) {
         for (const auto& sigShare : v) {
             if (sigman.HasRecoveredSigForId(sigShare.getLlmqType(), sigShare.getId())) {
@@ -632,11 +790,22 @@ bool CSigSharesManager::ProcessPendingSigShares(const CConnman& connman)
             // deserialization in the message thread
             if (!sigShare.sigShare.Get().IsValid()) {
                 BanNode(nodeId);
+                invalidNodes.emplace(nodeId);
                 // don't process any additional shares from this node
                 break;
             }
 
             auto quorum = quorums.at(std::make_pair(sigShare.getLlmqType(), sigShare.getQuorumHash()));
+
+            if (IsAllMembersConnectedEnabled(sigShare.getLlmqType())) {
+                deferredKeys.emplace(sigShare.GetKey());
+                LOCK(cs);
+                if (!unverifiedSigShares.Has(sigShare.GetKey()) && !sigShares.Has(sigShare.GetKey())) {
+                    unverifiedSigShares.Add(sigShare.GetKey(), {nodeId, sigShare, GetTime<std::chrono::seconds>().count()});
+                    deferredSessions.try_emplace(sigShare.GetSignHash(), quorum);
+                }
+                continue;
+            }
             auto pubKeyShare = quorum->GetPubKeyShare(sigShare.getQuorumMember());
 
             if (!pubKeyShare.IsValid()) {
@@ -656,9 +825,12 @@ bool CSigSharesManager::ProcessPendingSigShares(const CConnman& connman)
     batchVerifier.Verify();
     verifyTimer.stop();
 
-    LogPrint(BCLog::LLMQ_SIGS, "CSigSharesManager::%s -- verified sig shares. count=%d, pt=%d, vt=%d, nodes=%d\n", __func__, verifyCount, prepareTimer.count(), verifyTimer.count(), sigSharesByNodes.size());
+    LogPrint(BCLog::LLMQ_SIGS, "CSigSharesManager::%s -- verified sig shares. count=%d, deferred=%d, pt=%d, vt=%d, nodes=%d\n", __func__, verifyCount, deferredKeys.size(), prepareTimer.count(), verifyTimer.count(), sigSharesByNodes.size());
 
-    for (const auto& [nodeId, v] : sigSharesByNodes) {
+    for (auto& [nodeId, v] : sigSharesByNodes) {
+        if (invalidNodes.count(nodeId) != 0) {
+            continue;
+        }
         if (batchVerifier.badSources.count(nodeId) != 0) {
             LogPrint(BCLog::LLMQ_SIGS, "CSigSharesManager::%s -- invalid sig shares from other node, banning peer=%d\n",
                      __func__, nodeId);
@@ -667,9 +839,18 @@ bool CSigSharesManager::ProcessPendingSigShares(const CConnman& connman)
             continue;
         }
 
+        if (!deferredKeys.empty()) {
+            v.erase(std::remove_if(v.begin(), v.end(), [&](const CSigShare& sigShare) {
+                return deferredKeys.count(sigShare.GetKey()) != 0;
+            }), v.end());
+        }
         ProcessPendingSigShares(v, quorums, connman);
     }
 
+    for (const auto& [signHash, quorum] : deferredSessions) {
+        TryOptimisticRecovery(quorum, signHash, connman);
+    }
+
     return sigSharesByNodes.size() >= nMaxBatchSize;
 }
 
@@ -707,19 +888,29 @@ void CSigSharesManager::ProcessSigShare(const CSigShare& sigShare, const CConnma
     }
 
     {
-        LOCK(cs);
-
-        if (!sigShares.Add(sigShare.GetKey(), sigShare)) {
+        // Also updates the time we've seen the last sigShare
+        size_t sigShareCount{0};
+        if (!sigShares.Add(sigShare, GetTime<std::chrono::seconds>().count(), sigShareCount)) {
             return;
         }
+        if (sigShareCount >= size_t(quorum->params.threshold)) {
+            canTryRecovery = true;
+        }
+        TRACE5(llmq, sigshare_received,
+            ToUnderlying(llmqType),
+            sigShare.GetSignHash().data(),
+            sigShare.getQuorumMember(),
+            sigShareCount,
+            quorum->params.threshold
+        );
+
         if (!IsAllMembersConnectedEnabled(llmqType)) {
+            LOCK(cs);
             sigSharesQueuedToAnnounce.Add(sigShare.GetKey(), true);
         }
 
-        // Update the time we've seen the last sigShare
-        timeSeenForSessions[sigShare.GetSignHash()] = GetTime<std::chrono::seconds>().count();
-
         if (!quorumNodes.empty()) {
+            LOCK(cs_nodeStates);
             // don't announce and wait for other nodes to request this share and directly send it to them
             // there is no way the other nodes know about this share as this is the one created on this node
             for (auto otherNodeId : quorumNodes) {
@@ -730,11 +921,6 @@ void CSigSharesManager::ProcessSigShare(const CSigShare& sigShare, const CConnma
                 session.knows.Set(sigShare.getQuorumMember(), true);
             }
         }
-
-        size_t sigShareCount = sigShares.CountForSignHash(sigShare.GetSignHash());
-        if (sigShareCount >= size_t(quorum->params.threshold)) {
-            canTryRecovery = true;
-        }
     }
 
     if (canTryRecovery) {
@@ -750,25 +936,20 @@ void CSigSharesManager::TryRecoverSig(const CQuorumCPtr& quorum, const uint256&
 
     std::vector<CBLSSignature> sigSharesForRecovery;
     std::vector<CBLSId> idsForRecovery;
+    const auto signHash = BuildSignHash(quorum->params.type, quorum->qc->quorumHash, id, msgHash);
     {
-        LOCK(cs);
-
-        auto signHash = BuildSignHash(quorum->params.type, quorum->qc->quorumHash, id, msgHash);
-        const auto* sigSharesForSignHash = sigShares.GetAllForSignHash(signHash);
-        if (sigSharesForSignHash == nullptr) {
-            return;
-        }
-
-        sigSharesForRecovery.reserve((size_t) quorum->params.threshold);
-        idsForRecovery.reserve((size_t) quorum->params.threshold);
-        for (auto it = sigSharesForSignHash->begin(); it != sigSharesForSignHash->end() && sigSharesForRecovery.size() < size_t(quorum->params.threshold); ++it) {
-            const auto& sigShare = it->second;
-            sigSharesForRecovery.emplace_back(sigShare.sigShare.Get());
-            idsForRecovery.emplace_back(quorum->members[sigShare.getQuorumMember()]->proTxHash);
-        }
+        const bool found = sigShares.WithSigSharesForSignHash(signHash, [&](const auto& sigSharesForSignHash) {
+            sigSharesForRecovery.reserve((size_t) quorum->params.threshold);
+            idsForRecovery.reserve((size_t) quorum->params.threshold);
+            for (auto it = sigSharesForSignHash.begin(); it != sigSharesForSignHash.end() && sigSharesForRecovery.size() < size_t(quorum->params.threshold); ++it) {
+                const auto& sigShare = it->second;
+                sigSharesForRecovery.emplace_back(sigShare.sigShare.Get());
+                idsForRecovery.emplace_back(quorum->members[sigShare.getQuorumMember()]->proTxHash);
+            }
+        });
 
         // check if we can recover the final signature
-        if (sigSharesForRecovery.size() < size_t(quorum->params.threshold)) {
+        if (!found || sigSharesForRecovery.size() < size_t(quorum->params.threshold)) {
             return;
         }
     }
@@ -784,6 +965,18 @@ void CSigSharesManager::TryRecoverSig(const CQuorumCPtr& quorum, const uint256&
 
     LogPrint(BCLog::LLMQ_SIGS, "CSigSharesManager::%s -- recovered signature. id=%s, msgHash=%s, time=%d\n", __func__,
               id.ToString(), msgHash.ToString(), t.count());
+    TRACE5(llmq, sig_recovered,
+        ToUnderlying(quorum->params.type),
+        id.data(),
+        msgHash.data(),
+        sigSharesForRecovery.size(),
+        t.count()
+    );
+    statsClient.timing("llmq.sigs.recover_ms", t.count(), 1.0f);
+    if (const auto firstSeen = sigShares.GetFirstSeenTime(signHash)) {
+        // from the first sig share of the session up to the recovered signature
+        statsClient.timing("llmq.sigs.firstShareToRecovery_ms", std::max<int64_t>(GetTimeMillis() - *firstSeen, 0), 1.0f);
+    }
 
     auto rs = std::make_shared<CRecoveredSig>(quorum->params.type, quorum->qc->quorumHash, id, msgHash, recoveredSig);
 
@@ -791,8 +984,7 @@ void CSigSharesManager::TryRecoverSig(const CQuorumCPtr& quorum, const uint256&
     // however still verify it from time to time, so that we have a chance to catch bugs. We do only this sporadic
     // verification because this is unbatched and thus slow verification that happens here.
     if (((recoveredSigsCounter++) % 100) == 0) {
-        auto signHash = rs->buildSignHash();
-        bool valid = recoveredSig.VerifyInsecure(quorum->qc->quorumPublicKey, signHash);
+        bool valid = recoveredSig.VerifyInsecure(quorum->qc->quorumPublicKey, rs->buildSignHash());
         if (!valid) {
             // this should really not happen as we have verified all signature shares before
             LogPrintf("CSigSharesManager::%s -- own recovered signature is invalid. id=%s, msgHash=%s\n", __func__,
@@ -804,6 +996,97 @@ void CSigSharesManager::TryRecoverSig(const CQuorumCPtr& quorum, const uint256&
     sigman.ProcessRecoveredSig(rs);
 }
 
+void CSigSharesManager::TryOptimisticRecovery(const CQuorumCPtr& quorum, const uint256& signHash, const CConnman& connman)
+{
+    std::vector<UnverifiedSigShare> unverified;
+    {
+        LOCK(cs);
+        const auto* m = unverifiedSigShares.GetAllForSignHash(signHash);
+        if (m == nullptr) {
+            return;
+        }
+        unverified.reserve(m->size());
+        for (const auto& [_, u] : *m) {
+            unverified.emplace_back(u);
+        }
+    }
+
+    const auto& firstSigShare = unverified.front().sigShare;
+    const uint256 id = firstSigShare.getId();
+    const uint256 msgHash = firstSigShare.getMsgHash();
+    if (sigman.HasRecoveredSigForId(quorum->params.type, id)) {
+        WITH_LOCK(cs, unverifiedSigShares.EraseAllForSignHash(signHash));
+        return;
+    }
+
+    // verified shares first, so that a single invalid unverified share is less likely to be used
+    const size_t threshold = quorum->params.threshold;
+    std::vector<CBLSSignature> sigSharesForRecovery;
+    std::vector<CBLSId> idsForRecovery;
+    std::unordered_set<uint16_t> members;
+    sigSharesForRecovery.reserve(threshold);
+    idsForRecovery.reserve(threshold);
+    sigShares.WithSigSharesForSignHash(signHash, [&](const auto& sigSharesForSignHash) {
+        for (auto it = sigSharesForSignHash.begin(); it != sigSharesForSignHash.end() && sigSharesForRecovery.size() < threshold; ++it) {
+            const auto& sigShare = it->second;
+            sigSharesForRecovery.emplace_back(sigShare.sigShare.Get());
+            idsForRecovery.emplace_back(quorum->members[sigShare.getQuorumMember()]->proTxHash);
+            members.emplace(sigShare.getQuorumMember());
+        }
+    });
+    for (auto it = unverified.begin(); it != unverified.end() && sigSharesForRecovery.size() < threshold; ++it) {
+        const auto& sigShare = it->sigShare;
+        if (members.emplace(sigShare.getQuorumMember()).second) {
+            sigSharesForRecovery.emplace_back(sigShare.sigShare.Get());
+            idsForRecovery.emplace_back(quorum->members[sigShare.getQuorumMember()]->proTxHash);
+        }
+    }
+    if (sigSharesForRecovery.size() < threshold) {
+        // wait for more shares
+        return;
+    }
+
+    WITH_LOCK(cs, unverifiedSigShares.EraseAllForSignHash(signHash));
+
+    cxxtimer::Timer t(true);
+    CBLSSignature recoveredSig;
+    if (recoveredSig.Recover(sigSharesForRecovery, idsForRecovery) && recoveredSig.VerifyInsecure(quorum->qc->quorumPublicKey, signHash)) {
+        LogPrint(BCLog::LLMQ_SIGS, "CSigSharesManager::%s -- recovered signature from unverified shares. id=%s, msgHash=%s, time=%d\n", __func__,
+                  id.ToString(), msgHash.ToString(), t.count());
+        TRACE5(llmq, sig_recovered,
+            ToUnderlying(quorum->params.type),
+            id.data(),
+            msgHash.data(),
+            sigSharesForRecovery.size(),
+            t.count()
+        );
+        statsClient.timing("llmq.sigs.recover_ms", t.count(), 1.0f);
+        sigman.ProcessRecoveredSig(std::make_shared<CRecoveredSig>(quorum->params.type, quorum->qc->quorumHash, id, msgHash, recoveredSig));
+        return;
+    }
+
+    // At least one of the shares is invalid, find it and continue with the verified ones as usual
+    LogPrint(BCLog::LLMQ_SIGS, "CSigSharesManager::%s -- recovery from unverified shares failed, verifying %d shares. signHash=%s\n", __func__,
+              unverified.size(), signHash.ToString());
+    CBLSBatchVerifier<NodeId, SigShareKey> batchVerifier(false, true, 0, /* useSigCache */ false, &blsWorker);
+    for (const auto& u : unverified) {
+        batchVerifier.PushMessage(u.nodeId, u.sigShare.GetKey(), signHash, u.sigShare.sigShare.Get(), quorum->GetPubKeyShare(u.sigShare.getQuorumMember()));
+    }
+    batchVerifier.Verify();
+
+    for (const auto& nodeId : batchVerifier.badSources) {
+        LogPrint(BCLog::LLMQ_SIGS, "CSigSharesManager::%s -- invalid sig shares from other node, banning peer=%d\n",
+                 __func__, nodeId);
+        // this will also cause re-requesting of the shares that were sent by this node
+        BanNode(nodeId);
+    }
+    for (const auto& u : unverified) {
+        if (batchVerifier.badSources.count(u.nodeId) == 0) {
+            ProcessSigShare(u.sigShare, connman, quorum);
+        }
+    }
+}
+
 CDeterministicMNCPtr CSigSharesManager::SelectMemberForRecovery(const CQuorumCPtr& quorum, const uint256 &id, size_t attempt)
 {
     assert(size_t(attempt) < quorum->members.size());
@@ -822,6 +1105,7 @@ CDeterministicMNCPtr CSigSharesManager::SelectMemberForRecovery(const CQuorumCPt
 void CSigSharesManager::CollectSigSharesToRequest(std::unordered_map<NodeId, std::unordered_map<uint256, CSigSharesInv, StaticSaltedHasher>>& sigSharesToRequest)
 {
     AssertLockHeld(cs);
+    AssertLockHeld(cs_nodeStates);
 
     int64_t now = GetTime<std::chrono::seconds>().count();
     const size_t maxRequestsForNode = 32;
@@ -918,7 +1202,7 @@ void CSigSharesManager::CollectSigSharesToRequest(std::unordered_map<NodeId, std
 
 void CSigSharesManager::CollectSigSharesToSend(std::unordered_map<NodeId, std::unordered_map<uint256, CBatchedSigShares, StaticSaltedHasher>>& sigSharesToSend)
 {
-    AssertLockHeld(cs);
+    AssertLockHeld(cs_nodeStates);
 
     for (auto& [nodeId, nodeState] : nodeStates) {
         if (nodeState.banned) {
@@ -945,8 +1229,8 @@ void CSigSharesManager::CollectSigSharesToSend(std::unordered_map<NodeId, std::u
                 session.requested.inv[i] = false;
 
                 auto k = std::make_pair(signHash, (uint16_t)i);
-                const CSigShare* sigShare = sigShares.Get(k);
-                if (sigShare == nullptr) {
+                const auto sigShare = sigShares.Get(k);
+                if (!sigShare) {
                     // he requested something we don't have
                     session.requested.inv[i] = false;
                     continue;
@@ -1014,15 +1298,16 @@ void CSigSharesManager::CollectSigSharesToSendConcentrated(std::unordered_map<No
 void CSigSharesManager::CollectSigSharesToAnnounce(std::unordered_map<NodeId, std::unordered_map<uint256, CSigSharesInv, StaticSaltedHasher>>& sigSharesToAnnounce)
 {
     AssertLockHeld(cs);
+    AssertLockHeld(cs_nodeStates);
 
     std::unordered_map<std::pair<Consensus::LLMQType, uint256>, std::unordered_set<NodeId>, StaticSaltedHasher> quorumNodesMap;
 
     sigSharesQueuedToAnnounce.ForEach([this, &quorumNodesMap, &sigSharesToAnnounce](const SigShareKey& sigShareKey, bool) {
-        AssertLockHeld(cs);
+        AssertLockHeld(cs_nodeStates);
         const auto& signHash = sigShareKey.first;
         auto quorumMember = sigShareKey.second;
-        const CSigShare* sigShare = sigShares.Get(sigShareKey);
-        if (sigShare == nullptr) {
+        const auto sigShare = sigShares.Get(sigShareKey);
+        if (!sigShare) {
             return;
         }
 
@@ -1074,7 +1359,7 @@ bool CSigSharesManager::SendMessages()
     std::unordered_map<NodeId, std::vector<CSigSesAnn>> sigSessionAnnouncements;
 
     auto addSigSesAnnIfNeeded = [&](NodeId nodeId, const uint256& signHash) {
-        AssertLockHeld(cs);
+        AssertLockHeld(cs_nodeStates);
         auto& nodeState = nodeStates[nodeId];
         auto* session = nodeState.GetSessionBySignHash(signHash);
         assert(session);
@@ -1092,7 +1377,7 @@ bool CSigSharesManager::SendMessages()
     std::vector<CNode*> vNodesCopy = connman.CopyNodeVector(CConnman::FullyConnectedOnly);
 
     {
-        LOCK(cs);
+        LOCK2(cs, cs_nodeStates);
         CollectSigSharesToRequest(sigSharesToRequest);
         CollectSigSharesToSend(sigShareBatchesToSend);
         CollectSigSharesToAnnounce(sigSharesToAnnounce);
@@ -1120,6 +1405,35 @@ bool CSigSharesManager::SendMessages()
     for (auto& pnode : vNodesCopy) {
         CNetMsgMaker msgMaker(pnode->GetCommonVersion());
 
+        if (pnode->GetCommonVersion() >= SIGSHARES_BUNDLE_PROTO_VERSION) {
+            // Queue everything for this peer in the order of the separate messages below, see CSigSharesBundle
+            auto& queue = peerSendQueues[pnode->GetId()];
+            auto& pending = queue.pending;
+            if (auto it = sigSessionAnnouncements.find(pnode->GetId()); it != sigSessionAnnouncements.end()) {
+                std::move(it->second.begin(), it->second.end(), std::back_inserter(pending.sessionAnns));
+            }
+            if (auto it = sigSharesToRequest.find(pnode->GetId()); it != sigSharesToRequest.end()) {
+                for (auto& [_, inv] : it->second) {
+                    pending.requests.emplace_back(std::move(inv));
+                }
+            }
+            if (auto it = sigShareBatchesToSend.find(pnode->GetId()); it != sigShareBatchesToSend.end()) {
+                for (auto& [_, batch] : it->second) {
+                    pending.batchedSigShares.emplace_back(std::move(batch));
+                }
+            }
+            if (auto it = sigSharesToAnnounce.find(pnode->GetId()); it != sigSharesToAnnounce.end()) {
+                for (auto& [_, inv] : it->second) {
+                    pending.announcements.emplace_back(std::move(inv));
+                }
+            }
+            if (auto it = sigSharesToSend.find(pnode->GetId()); it != sigSharesToSend.end()) {
+                std::move(it->second.begin(), it->second.end(), std::back_inserter(pending.sigShares));
+            }
+            didSend |= SendBundles(pnode, queue);
+            continue;
+        }
+
         if (const auto it1 = sigSessionAnnouncements.find(pnode->GetId()); it1 != sigSessionAnnouncements.end()) {
             std::vector<CSigSesAnn> msgs;
             msgs.reserve(it1->second.size());
@@ -1219,15 +1533,76 @@ bool CSigSharesManager::SendMessages()
         }
     }
 
+    // forget the queues of disconnected peers
+    for (auto it = peerSendQueues.begin(); it != peerSendQueues.end(); ) {
+        if (ranges::any_of(vNodesCopy, [&](const CNode* pnode) { return pnode->GetId() == it->first; })) {
+            ++it;
+        } else {
+            it = peerSendQueues.erase(it);
+        }
+    }
+
     // looped through all nodes, release them
     connman.ReleaseNodeVector(vNodesCopy);
 
     return didSend;
 }
 
+CSigSharesBundle CSigSharesManager::TakeBundle(CSigSharesBundle& pending)
+{
+    CSigSharesBundle bundle;
+    const auto take = [](auto& from, auto& to, size_t count) {
+        count = std::min(count, from.size());
+        to.assign(std::make_move_iterator(from.begin()), std::make_move_iterator(from.begin() + count));
+        from.erase(from.begin(), from.begin() + count);
+    };
+
+    take(pending.sessionAnns, bundle.sessionAnns, MAX_MSGS_CNT_QSIGSESANN);
+    if (!pending.sessionAnns.empty()) {
+        // everything else may refer to the sessions which still have to be announced
+        return bundle;
+    }
+    take(pending.requests, bundle.requests, MAX_MSGS_CNT_QGETSIGSHARES);
+    size_t batchesCount = 0;
+    size_t totalSigsCount = 0;
+    for (const auto& batch : pending.batchedSigShares) {
+        if (totalSigsCount + batch.sigShares.size() > MAX_MSGS_TOTAL_BATCHED_SIGS) break;
+        totalSigsCount += batch.sigShares.size();
+        ++batchesCount;
+    }
+    take(pending.batchedSigShares, bundle.batchedSigShares, batchesCount);
+    take(pending.announcements, bundle.announcements, MAX_MSGS_CNT_QSIGSHARESINV);
+    take(pending.sigShares, bundle.sigShares, MAX_MSGS_SIG_SHARES);
+    return bundle;
+}
+
+bool CSigSharesManager::SendBundles(CNode* pnode, PeerSendQueue& queue)
+{
+    const int64_t nNow = GetTimeMillis();
+    if (queue.lastRefillTime != 0) {
+        queue.budget = std::min(PEER_SEND_BUDGET_PER_SEC, queue.budget + (nNow - queue.lastRefillTime) * PEER_SEND_BUDGET_PER_SEC / 1000);
+    }
+    queue.lastRefillTime = nNow;
+
+    CNetMsgMaker msgMaker(pnode->GetCommonVersion());
+    bool didSend = false;
+    // The budget may go negative by one bundle, so that a peer is never starved by a single large one
+    while (!queue.pending.empty() && queue.budget > 0) {
+        CSigSharesBundle bundle = TakeBundle(queue.pending);
+        LogPrint(BCLog::LLMQ_SIGS, "CSigSharesManager::%s -- QSIGSHARESBUNDLE bundle={%s}, node=%d\n", __func__, bundle.ToString(), pnode->GetId());
+        queue.budget -= ::GetSerializeSize(bundle, PROTOCOL_VERSION);
+        connman.PushMessage(pnode, msgMaker.Make(NetMsgType::QSIGSHARESBUNDLE, bundle));
+        didSend = true;
+    }
+    if (!queue.pending.empty()) {
+        LogPrint(BCLog::LLMQ_SIGS, "CSigSharesManager::%s -- send budget exhausted, deferring {%s}, node=%d\n", __func__, queue.pending.ToString(), pnode->GetId());
+    }
+    return didSend;
+}
+
 bool CSigSharesManager::GetSessionInfoByRecvId(NodeId nodeId, uint32_t sessionId, CSigSharesNodeState::SessionInfo& retInfo)
 {
-    LOCK(cs);
+    LOCK(cs_nodeStates);
     return nodeStates[nodeId].GetSessionInfoByRecvId(sessionId, retInfo);
 }
 
@@ -1252,12 +1627,9 @@ void CSigSharesManager::Cleanup()
     // quorumHash -> quorumPtr (as GetQuorum() requires cs_main, leading to deadlocks with cs held)
     std::unordered_map<std::pair<Consensus::LLMQType, uint256>, CQuorumCPtr, StaticSaltedHasher> quorums;
 
-    {
-        LOCK(cs);
-        sigShares.ForEach([&quorums](const SigShareKey&, const CSigShare& sigShare) {
-            quorums.try_emplace(std::make_pair(sigShare.getLlmqType(), sigShare.getQuorumHash()), nullptr);
-        });
-    }
+    sigShares.ForEach([&quorums](const SigShareKey&, const CSigShare& sigShare) {
+        quorums.try_emplace(std::make_pair(sigShare.getLlmqType(), sigShare.getQuorumHash()), nullptr);
+    });
 
     // Find quorums which became inactive
     for (auto it = quorums.begin(); it != quorums.end(); ) {
@@ -1287,40 +1659,32 @@ void CSigSharesManager::Cleanup()
         LOCK(cs);
 
         // Remove sessions which were successfully recovered
-        std::unordered_set<uint256, StaticSaltedHasher> doneSessions;
-        sigShares.ForEach([&doneSessions, this](const SigShareKey&, const CSigShare& sigShare) {
-            if (doneSessions.count(sigShare.GetSignHash()) != 0) {
-                return;
-            }
-            if (sigman.HasRecoveredSigForSession(sigShare.GetSignHash())) {
-                doneSessions.emplace(sigShare.GetSignHash());
-            }
+        std::unordered_set<uint256, StaticSaltedHasher> sessions;
+        sigShares.ForEach([&sessions](const SigShareKey& k, const CSigShare&) {
+            sessions.emplace(k.first);
         });
-        for (const auto& signHash : doneSessions) {
-            RemoveSigSharesForSession(signHash);
-        }
-
-        // Remove sessions which timed out
-        std::unordered_set<uint256, StaticSaltedHasher> timeoutSessions;
-        for (const auto& [signHash, lastSeenTime] : timeSeenForSessions) {
-            if (now - lastSeenTime >= SESSION_NEW_SHARES_TIMEOUT) {
-                timeoutSessions.emplace(signHash);
+        for (const auto& signHash : sessions) {
+            if (sigman.HasRecoveredSigForSession(signHash)) {
+                RemoveSigSharesForSession(signHash);
             }
         }
-        for (const auto& signHash : timeoutSessions) {
 
-            if (const size_t count = sigShares.CountForSignHash(signHash); count > 0) {
-                const auto* m = sigShares.GetAllForSignHash(signHash);
-                assert(m);
+        // Drop deferred shares of sessions that never got enough shares for a recovery
+        unverifiedSigShares.EraseIf([now](const SigShareKey&, const UnverifiedSigShare& u) {
+            return now - u.receivedTime >= SESSION_NEW_SHARES_TIMEOUT;
+        });
 
-                const auto& oneSigShare = m->begin()->second;
+        // Remove sessions which timed out
+        for (const auto& signHash : sigShares.GetTimedOutSessions(now, SESSION_NEW_SHARES_TIMEOUT)) {
+            const bool hasSigShares = sigShares.WithSigSharesForSignHash(signHash, [&](const auto& m) {
+                const auto& oneSigShare = m.begin()->second;
 
                 std::string strMissingMembers;
                 if (LogAcceptCategory(BCLog::LLMQ_SIGS)) {
                     if (const auto quorumIt = quorums.find(std::make_pair(oneSigShare.getLlmqType(), oneSigShare.getQuorumHash())); quorumIt != quorums.end()) {
                         const auto& quorum = quorumIt->second;
                         for (const auto i : irange::range(quorum->members.size())) {
-                            if (m->count((uint16_t)i) == 0) {
+                            if (m.count((uint16_t)i) == 0) {
                                 const auto& dmn = quorum->members[i];
                                 strMissingMembers += strprintf("\n  %s", dmn->proTxHash.ToString());
                             }
@@ -1329,10 +1693,11 @@ void CSigSharesManager::Cleanup()
                 }
 
                 LogPrint(BCLog::LLMQ_SIGS, "CSigSharesManager::%s -- signing session timed out. signHash=%s, id=%s, msgHash=%s, sigShareCount=%d, missingMembers=%s\n", __func__,
-                          signHash.ToString(), oneSigShare.getId().ToString(), oneSigShare.getMsgHash().ToString(), count, strMissingMembers);
-            } else {
+                          signHash.ToString(), oneSigShare.getId().ToString(), oneSigShare.getMsgHash().ToString(), m.size(), strMissingMembers);
+            });
+            if (!hasSigShares) {
                 LogPrint(BCLog::LLMQ_SIGS, "CSigSharesManager::%s -- signing session timed out. signHash=%s, sigShareCount=%d\n", __func__,
-                          signHash.ToString(), count);
+                          signHash.ToString(), 0);
             }
             RemoveSigSharesForSession(signHash);
         }
@@ -1341,7 +1706,7 @@ void CSigSharesManager::Cleanup()
     // Find node states for peers that disappeared from CConnman
     std::unordered_set<NodeId> nodeStatesToDelete;
     {
-        LOCK(cs);
+        LOCK(cs_nodeStates);
         for (const auto& [nodeId, _] : nodeStates) {
             nodeStatesToDelete.emplace(nodeId);
         }
@@ -1351,7 +1716,7 @@ void CSigSharesManager::Cleanup()
     });
 
     // Now delete these node states
-    LOCK(cs);
+    LOCK2(cs, cs_nodeStates);
     for (const auto& nodeId : nodeStatesToDelete) {
         auto it = nodeStates.find(nodeId);
         if (it == nodeStates.end()) {
@@ -1365,6 +1730,16 @@ void CSigSharesManager::Cleanup()
         nodeStates.erase(nodeId);
     }
 
+    size_t pendingIncoming{0};
+    for (const auto& [_, nodeState] : nodeStates) {
+        pendingIncoming += nodeState.pendingIncomingSigShares.Size();
+    }
+    statsClient.gauge("llmq.sigShares.pendingIncoming", pendingIncoming, 1.0f);
+    statsClient.gauge("llmq.sigShares.sessions", sigShares.SessionCount(), 1.0f);
+    statsClient.gauge("llmq.sigShares.requested", sigSharesRequested.Size(), 1.0f);
+    statsClient.gauge("llmq.sigShares.queuedToAnnounce", sigSharesQueuedToAnnounce.Size(), 1.0f);
+    statsClient.gauge("llmq.sigShares.pendingSigns", pendingSigns.size(), 1.0f);
+
     lastCleanupTime = GetTime<std::chrono::seconds>().count();
 }
 
@@ -1372,22 +1747,27 @@ void CSigSharesManager::RemoveSigSharesForSession(const uint256& signHash)
 {
     AssertLockHeld(cs);
 
-    for (auto& [_, nodeState] : nodeStates) {
-        nodeState.RemoveSession(signHash);
+    {
+        LOCK(cs_nodeStates);
+        for (auto& [nodeId, nodeState] : nodeStates) {
+            const size_t nPending = nodeState.pendingIncomingSigShares.CountForSignHash(signHash);
+            nodeState.RemoveSession(signHash);
+            pendingMessagesBudget.Release(nodeId, nPending * sizeof(CSigShare));
+        }
     }
 
     sigSharesRequested.EraseAllForSignHash(signHash);
     sigSharesQueuedToAnnounce.EraseAllForSignHash(signHash);
+    unverifiedSigShares.EraseAllForSignHash(signHash);
     sigShares.EraseAllForSignHash(signHash);
     signedSessions.erase(signHash);
-    timeSeenForSessions.erase(signHash);
 }
 
 void CSigSharesManager::RemoveBannedNodeStates()
 {
     // Called regularly to cleanup local node states for banned nodes
 
-    LOCK(cs);
+    LOCK2(cs, cs_nodeStates);
     for (auto it = nodeStates.begin(); it != nodeStates.end();) {
         if (m_peerman->IsBanned(it->first)) {
             // re-request sigshares from other nodes
@@ -1412,7 +1792,7 @@ void CSigSharesManager::BanNode(NodeId nodeId)
         m_peerman->Misbehaving(nodeId, 100);
     }
 
-    LOCK(cs);
+    LOCK2(cs, cs_nodeStates);
     auto it = nodeStates.find(nodeId);
     if (it == nodeStates.end()) {
         return;
@@ -1534,12 +1914,14 @@ void CSigSharesManager::ForceReAnnouncement(const CQuorumCPtr& quorum, Consensus
 
     LOCK(cs);
     auto signHash = BuildSignHash(llmqType, quorum->qc->quorumHash, id, msgHash);
-    if (const auto *const sigs = sigShares.GetAllForSignHash(signHash)) {
-        for (const auto& [quorumMemberIndex, _] : *sigs) {
+    sigShares.WithSigSharesForSignHash(signHash, [&](const auto& sigs) {
+        AssertLockHeld(cs);
+        for (const auto& [quorumMemberIndex, _] : sigs) {
             // re-announce every sigshare to every node
             sigSharesQueuedToAnnounce.Add(std::make_pair(signHash, quorumMemberIndex), true);
         }
-    }
+    });
+    LOCK(cs_nodeStates);
     for (auto& [_, nodeState] : nodeStates) {
         auto* session = nodeState.GetSessionBySignHash(signHash);
         if (session == nullptr) {
@@ -6,7 +6,9 @@
 #define BITCOIN_LLMQ_SIGNING_SHARES_H
 
 #include <bls/bls.h>
+#include <crypto/common.h>
 #include <llmq/signing.h>
+#include <memusage.h>
 #include <net.h>
 #include <random.h>
 #include <saltedhasher.h>
@@ -15,13 +17,16 @@
 #include <sync.h>
 #include <uint256.h>
 
+#include <array>
 #include <atomic>
 #include <optional>
 #include <thread>
 #include <unordered_map>
 #include <utility>
+#include <vector>
 
 class CDeterministicMN;
+class CBLSWorker;
 class CEvoDB;
 class CScheduler;
 class CSporkManager;
@@ -149,17 +154,142 @@ public:
     [[nodiscard]] std::string ToInvString() const;
 };
 
+/**
+ * All sig share traffic for a peer, sent through the message QSIGSHARESBUNDLE to peers supporting
+ * SIGSHARES_BUNDLE_PROTO_VERSION instead of one message per kind. The parts are processed in the order of the members,
+ * so the sessions are announced before anything refers to them. Each part has the limit of its own message.
+ */
+class CSigSharesBundle
+{
+public:
+    std::vector<CSigSesAnn> sessionAnns;
+    std::vector<CSigSharesInv> requests;
+    std::vector<CBatchedSigShares> batchedSigShares;
+    std::vector<CSigSharesInv> announcements;
+    std::vector<CSigShare> sigShares;
+
+public:
+    SERIALIZE_METHODS(CSigSharesBundle, obj)
+    {
+        READWRITE(obj.sessionAnns, obj.requests, obj.batchedSigShares, obj.announcements, obj.sigShares);
+    }
+
+    [[nodiscard]] bool empty() const;
+    [[nodiscard]] std::string ToString() const;
+};
+
+/**
+ * Entries of a single signing session, indexed by quorum member. Member indexes are dense and bounded by the quorum
+ * size, so instead of a hash map this keeps the entries back to back in a vector and a flat table which maps each
+ * member index to its slot. Lookups stay O(1) and iterating all entries of a session is a linear scan.
+ * Erasing moves the last entry into the freed slot, so iteration order is not stable.
+ */
+template<typename T>
+class SigShareArray
+{
+private:
+    using Entry = std::pair<uint16_t, T>;
+    static constexpr uint16_t NO_SLOT{0};
+
+    // 1 + position in entries for each member index, NO_SLOT if there is no entry for it
+    std::vector<uint16_t> slots;
+    std::vector<Entry> entries;
+
+    [[nodiscard]] uint16_t SlotOf(uint16_t quorumMember) const
+    {
+        return quorumMember < slots.size() ? slots[quorumMember] : NO_SLOT;
+    }
+
+    void EraseSlot(uint16_t slot)
+    {
+        const size_t pos = slot - 1;
+        slots[entries[pos].first] = NO_SLOT;
+        if (pos + 1 != entries.size()) {
+            entries[pos] = std::move(entries.back());
+            slots[entries[pos].first] = slot;
+        }
+        entries.pop_back();
+    }
+
+public:
+    using iterator = typename std::vector<Entry>::iterator;
+    using const_iterator = typename std::vector<Entry>::const_iterator;
+
+    bool emplace(uint16_t quorumMember, const T& v)
+    {
+        if (SlotOf(quorumMember) != NO_SLOT) {
+            return false;
+        }
+        if (quorumMember >= slots.size()) {
+            // grow in steps of 64 members, so a session reaches the size of its quorum in a few steps at most
+            slots.resize((size_t(quorumMember) / 64 + 1) * 64, NO_SLOT);
+        }
+        entries.emplace_back(quorumMember, v);
+        slots[quorumMember] = uint16_t(entries.size());
+        return true;
+    }
+
+    size_t erase(uint16_t quorumMember)
+    {
+        const auto slot = SlotOf(quorumMember);
+        if (slot == NO_SLOT) {
+            return 0;
+        }
+        EraseSlot(slot);
+        return 1;
+    }
+
+    template<typename F>
+    void EraseIf(F&& f)
+    {
+        for (size_t pos = 0; pos < entries.size(); ) {
+            if (f(entries[pos].first, entries[pos].second)) {
+                // the last entry is moved to pos, so don't advance
+                EraseSlot(uint16_t(pos + 1));
+            } else {
+                ++pos;
+            }
+        }
+    }
+
+    [[nodiscard]] size_t count(uint16_t quorumMember) const
+    {
+        return SlotOf(quorumMember) != NO_SLOT ? 1 : 0;
+    }
+
+    iterator find(uint16_t quorumMember)
+    {
+        const auto slot = SlotOf(quorumMember);
+        return slot == NO_SLOT ? entries.end() : entries.begin() + (slot - 1);
+    }
+
+    const_iterator find(uint16_t quorumMember) const
+    {
+        const auto slot = SlotOf(quorumMember);
+        return slot == NO_SLOT ? entries.end() : entries.begin() + (slot - 1);
+    }
+
+    [[nodiscard]] size_t size() const { return entries.size(); }
+    [[nodiscard]] bool empty() const { return entries.empty(); }
+    [[nodiscard]] size_t DynamicMemoryUsage() const { return memusage::DynamicUsage(slots) + memusage::DynamicUsage(entries); }
+
+    iterator begin() { return entries.begin(); }
+    iterator end() { return entries.end(); }
+    const_iterator begin() const { return entries.begin(); }
+    const_iterator end() const { return entries.end(); }
+};
+
 template<typename T>
 class SigShareMap
 {
 private:
-    std::unordered_map<uint256, std::unordered_map<uint16_t, T>, StaticSaltedHasher> internalMap;
+    std::unordered_map<uint256, SigShareArray<T>, StaticSaltedHasher> internalMap;
 
 public:
     bool Add(const SigShareKey& k, const T& v)
     {
         auto& m = internalMap[k.first];
-        return m.emplace(k.second, v).second;
+        return m.emplace(k.second, v);
     }
 
     void Erase(const SigShareKey& k)
@@ -203,6 +333,11 @@ public:
         return &jt->second;
     }
 
+    const T* Get(const SigShareKey& k) const
+    {
+        return const_cast<SigShareMap*>(this)->Get(k);
+    }
+
     T& GetOrAdd(const SigShareKey& k)
     {
         T* v = Get(k);
@@ -230,6 +365,15 @@ public:
         return s;
     }
 
+    [[nodiscard]] size_t DynamicMemoryUsage() const
+    {
+        size_t s = memusage::DynamicUsage(internalMap);
+        for (auto& p : internalMap) {
+            s += p.second.DynamicMemoryUsage();
+        }
+        return s;
+    }
+
     [[nodiscard]] size_t CountForSignHash(const uint256& signHash) const
     {
         auto it = internalMap.find(signHash);
@@ -244,7 +388,7 @@ public:
         return internalMap.empty();
     }
 
-    const std::unordered_map<uint16_t, T>* GetAllForSignHash(const uint256& signHash) const
+    const SigShareArray<T>* GetAllForSignHash(const uint256& signHash) const
     {
         auto it = internalMap.find(signHash);
         if (it == internalMap.end()) {
@@ -264,14 +408,10 @@ public:
         for (auto it = internalMap.begin(); it != internalMap.end(); ) {
             SigShareKey k;
             k.first = it->first;
-            for (auto jt = it->second.begin(); jt != it->second.end(); ) {
-                k.second = jt->first;
-                if (f(k, jt->second)) {
-                    jt = it->second.erase(jt);
-                } else {
-                    ++jt;
-                }
-            }
+            it->second.EraseIf([&](uint16_t quorumMember, T& v) {
+                k.second = quorumMember;
+                return f(k, v);
+            });
             if (it->second.empty()) {
                 it = internalMap.erase(it);
             } else {
@@ -292,6 +432,89 @@ public:
             }
         }
     }
+
+    template<typename F>
+    void ForEach(F&& f) const
+    {
+        for (const auto& p : internalMap) {
+            SigShareKey k;
+            k.first = p.first;
+            for (const auto& p2 : p.second) {
+                k.second = p2.first;
+                f(k, p2.second);
+            }
+        }
+    }
+};
+
+/**
+ * Verified sig shares together with the time the last share of each signing session was seen.
+ * Sessions are spread by sign hash over independently locked shards, so that threads working on
+ * different sessions don't contend with each other. The shard locks are always taken last.
+ */
+class CSigSharesStore
+{
+public:
+    static constexpr size_t SHARD_COUNT{16};
+
+private:
+    struct Shard {
+        mutable Mutex cs;
+        SigShareMap<CSigShare> sigShares GUARDED_BY(cs);
+        // stores time of last receivedSigShare. Used to detect timeouts
+        std::unordered_map<uint256, int64_t, StaticSaltedHasher> timeSeenForSessions GUARDED_BY(cs);
+        // stores time in milliseconds of the first sig share of a session. Used for recovery latency stats
+        std::unordered_map<uint256, int64_t, StaticSaltedHasher> timeFirstSeenForSessions GUARDED_BY(cs);
+    };
+
+    std::array<Shard, SHARD_COUNT> shards;
+
+    Shard& GetShard(const uint256& signHash) { return shards[ReadLE64(signHash.begin()) % SHARD_COUNT]; }
+    const Shard& GetShard(const uint256& signHash) const { return shards[ReadLE64(signHash.begin()) % SHARD_COUNT]; }
+
+public:
+    /**
+     * Adds a sig share and records `now` as the time its session was last seen.
+     * @return false if the sig share was already known. Otherwise retCount is set to the number of sig shares
+     * now known for the session
+     */
+    bool Add(const CSigShare& sigShare, int64_t now, size_t& retCount);
+    [[nodiscard]] bool Has(const SigShareKey& k) const;
+    [[nodiscard]] std::optional<CSigShare> Get(const SigShareKey& k) const;
+    [[nodiscard]] size_t CountForSignHash(const uint256& signHash) const;
+    void EraseAllForSignHash(const uint256& signHash);
+    [[nodiscard]] std::vector<uint256> GetTimedOutSessions(int64_t now, int64_t timeout) const;
+    /** @return the time in milliseconds the first sig share of the session was added */
+    [[nodiscard]] std::optional<int64_t> GetFirstSeenTime(const uint256& signHash) const;
+    [[nodiscard]] size_t SessionCount() const;
+    [[nodiscard]] size_t DynamicMemoryUsage() const;
+
+    /**
+     * Calls f with all sig shares of a session (as SigShareArray<CSigShare>) while holding its shard.
+     * @return false if no sig shares are known for signHash, in which case f is not called
+     */
+    template<typename F>
+    bool WithSigSharesForSignHash(const uint256& signHash, F&& f) const
+    {
+        const auto& shard = GetShard(signHash);
+        LOCK(shard.cs);
+        const auto* m = shard.sigShares.GetAllForSignHash(signHash);
+        if (m == nullptr) {
+            return false;
+        }
+        f(*m);
+        return true;
+    }
+
+    // Locks one shard at a time, f must not call back into this store
+    template<typename F>
+    void ForEach(F&& f) const
+    {
+        for (const auto& shard : shards) {
+            LOCK(shard.cs);
+            shard.sigShares.ForEach(f);
+        }
+    }
 };
 
 class CSigSharesNodeState
@@ -343,6 +566,8 @@ public:
     bool GetSessionInfoByRecvId(uint32_t sessionId, SessionInfo& retInfo);
 
     void RemoveSession(const uint256& signHash);
+
+    [[nodiscard]] size_t DynamicMemoryUsage() const;
 };
 
 class CSignedSession
@@ -371,22 +596,33 @@ private:
     static constexpr int64_t EXP_SEND_FOR_RECOVERY_TIMEOUT{2000};
     static constexpr int64_t MAX_SEND_FOR_RECOVERY_TIMEOUT{10000};
     static constexpr size_t MAX_MSGS_SIG_SHARES{32};
+    // bytes of QSIGSHARESBUNDLE messages a peer may be sent per second, and at once after being idle
+    static constexpr int64_t PEER_SEND_BUDGET_PER_SEC{1000000};
 
-    RecursiveMutex cs;
+    // Lock order: cs, then cs_nodeStates, then the shards of sigShares. The message handler only needs the
+    // latter two for the common messages, so it doesn't have to wait for the worker thread holding cs
+    mutable RecursiveMutex cs;
+    mutable Mutex cs_nodeStates;
 
     std::thread workThread;
     CThreadInterrupt workInterrupt;
 
-    SigShareMap<CSigShare> sigShares GUARDED_BY(cs);
+    CSigSharesStore sigShares;
     std::unordered_map<uint256, CSignedSession, StaticSaltedHasher> signedSessions GUARDED_BY(cs);
 
-    // stores time of last receivedSigShare. Used to detect timeouts
-    std::unordered_map<uint256, int64_t, StaticSaltedHasher> timeSeenForSessions GUARDED_BY(cs);
-
-    std::unordered_map<NodeId, CSigSharesNodeState> nodeStates GUARDED_BY(cs);
+    std::unordered_map<NodeId, CSigSharesNodeState> nodeStates GUARDED_BY(cs_nodeStates);
     SigShareMap<std::pair<NodeId, int64_t>> sigSharesRequested GUARDED_BY(cs);
     SigShareMap<bool> sigSharesQueuedToAnnounce GUARDED_BY(cs);
 
+    // With all members connected, the sig shares of other members are never relayed and only needed for our own
+    // recovery. Their verification is deferred until a recovery is possible, see TryOptimisticRecovery
+    struct UnverifiedSigShare {
+        NodeId nodeId{-1};
+        CSigShare sigShare;
+        int64_t receivedTime{0};
+    };
+    SigShareMap<UnverifiedSigShare> unverifiedSigShares GUARDED_BY(cs);
+
     struct PendingSignatureData {
         const CQuorumCPtr quorum;
         const uint256 id;
@@ -397,8 +633,9 @@ private:
 
     std::vector<PendingSignatureData> pendingSigns GUARDED_BY(cs);
 
-    FastRandomContext rnd GUARDED_BY(cs);
+    FastRandomContext rnd GUARDED_BY(cs_nodeStates);
 
+    CBLSWorker& blsWorker;
     CConnman& connman;
     const CQuorumManager& qman;
     CSigningManager& sigman;
@@ -408,9 +645,18 @@ private:
     int64_t lastCleanupTime{0};
     std::atomic<uint32_t> recoveredSigsCounter{0};
 
+    // Traffic for peers supporting QSIGSHARESBUNDLE which didn't fit into their send budget yet. Only used by the
+    // worker thread
+    struct PeerSendQueue {
+        CSigSharesBundle pending;
+        int64_t budget{PEER_SEND_BUDGET_PER_SEC};
+        int64_t lastRefillTime{0};
+    };
+    std::unordered_map<NodeId, PeerSendQueue> peerSendQueues;
+
 public:
-    explicit CSigSharesManager(CConnman& _connman, CQuorumManager& _qman, CSigningManager& _sigman, const std::unique_ptr<PeerManager>& peerman) :
-        connman(_connman), qman(_qman), sigman(_sigman), m_peerman(peerman)
+    explicit CSigSharesManager(CBLSWorker& _blsWorker, CConnman& _connman, CQuorumManager& _qman, CSigningManager& _sigman, const std::unique_ptr<PeerManager>& peerman) :
+        blsWorker(_blsWorker), connman(_connman), qman(_qman), sigman(_sigman), m_peerman(peerman)
     {
         workInterrupt.reset();
     };
@@ -433,6 +679,10 @@ public:
 
     static CDeterministicMNCPtr SelectMemberForRecovery(const CQuorumCPtr& quorum, const uint256& id, size_t attempt);
 
+    /** Estimated memory used by sig shares, signing sessions and the per node states. The send queues of the worker
+     *  thread are not included */
+    size_t DynamicMemoryUsage() const;
+
 private:
     // all of these return false when the currently processed message should be aborted (as each message actually contains multiple messages)
     bool ProcessMessageSigSesAnn(const CNode& pfrom, const CSigSesAnn& ann);
@@ -440,6 +690,12 @@ private:
     bool ProcessMessageGetSigShares(const CNode& pfrom, const CSigSharesInv& inv);
     bool ProcessMessageBatchedSigShares(const CNode& pfrom, const CBatchedSigShares& batchedSigShares);
     void ProcessMessageSigShare(NodeId fromId, const CSigShare& sigShare);
+    // the contents of one message of each kind, these also check the limit of the message
+    bool ProcessMessageSigSesAnns(const CNode& pfrom, const std::vector<CSigSesAnn>& msgs);
+    bool ProcessMessageSigSharesInvs(const CNode& pfrom, const std::vector<CSigSharesInv>& msgs);
+    bool ProcessMessageGetSigSharesInvs(const CNode& pfrom, const std::vector<CSigSharesInv>& msgs);
+    bool ProcessMessageBatchedSigSharesList(const CNode& pfrom, const std::vector<CBatchedSigShares>& msgs);
+    bool ProcessMessageSigShares(const CNode& pfrom, const std::vector<CSigShare>& msgs);
 
     static bool VerifySigSharesInv(Consensus::LLMQType llmqType, const CSigSharesInv& inv);
     static bool PreVerifyBatchedSigShares(const CQuorumManager& quorum_manager, const CSigSharesNodeState::SessionInfo& session, const CBatchedSigShares& batchedSigShares, bool& retBan);
@@ -455,21 +711,30 @@ private:
 
     void ProcessSigShare(const CSigShare& sigShare, const CConnman& connman, const CQuorumCPtr& quorum);
     void TryRecoverSig(const CQuorumCPtr& quorum, const uint256& id, const uint256& msgHash);
-
-    bool GetSessionInfoByRecvId(NodeId nodeId, uint32_t sessionId, CSigSharesNodeState::SessionInfo& retInfo);
+    /**
+     * Recovers from the unverified sig shares of a session once there are enough and only verifies the recovered
+     * signature against the quorum public key. The shares are verified one by one only if that fails, so that the
+     * peers which sent invalid ones can be banned.
+     */
+    void TryOptimisticRecovery(const CQuorumCPtr& quorum, const uint256& signHash, const CConnman& connman) LOCKS_EXCLUDED(cs);
+
+    bool GetSessionInfoByRecvId(NodeId nodeId, uint32_t sessionId, CSigSharesNodeState::SessionInfo& retInfo) LOCKS_EXCLUDED(cs_nodeStates);
     static CSigShare RebuildSigShare(const CSigSharesNodeState::SessionInfo& session, const std::pair<uint16_t, CBLSLazySignature>& in);
 
     void Cleanup();
-    void RemoveSigSharesForSession(const uint256& signHash) EXCLUSIVE_LOCKS_REQUIRED(cs);
+    void RemoveSigSharesForSession(const uint256& signHash) EXCLUSIVE_LOCKS_REQUIRED(cs) LOCKS_EXCLUDED(cs_nodeStates);
     void RemoveBannedNodeStates();
 
     void BanNode(NodeId nodeId);
 
     bool SendMessages();
-    void CollectSigSharesToRequest(std::unordered_map<NodeId, std::unordered_map<uint256, CSigSharesInv, StaticSaltedHasher>>& sigSharesToRequest) EXCLUSIVE_LOCKS_REQUIRED(cs);
-    void CollectSigSharesToSend(std::unordered_map<NodeId, std::unordered_map<uint256, CBatchedSigShares, StaticSaltedHasher>>& sigSharesToSend) EXCLUSIVE_LOCKS_REQUIRED(cs);
+    /** Send as much of the pending traffic of a peer as its budget allows, in bundles which respect the message limits */
+    bool SendBundles(CNode* pnode, PeerSendQueue& queue);
+    static CSigSharesBundle TakeBundle(CSigSharesBundle& pending);
+    void CollectSigSharesToRequest(std::unordered_map<NodeId, std::unordered_map<uint256, CSigSharesInv, StaticSaltedHasher>>& sigSharesToRequest) EXCLUSIVE_LOCKS_REQUIRED(cs, cs_nodeStates);
+    void CollectSigSharesToSend(std::unordered_map<NodeId, std::unordered_map<uint256, CBatchedSigShares, StaticSaltedHasher>>& sigSharesToSend) EXCLUSIVE_LOCKS_REQUIRED(cs_nodeStates);
     void CollectSigSharesToSendConcentrated(std::unordered_map<NodeId, std::vector<CSigShare>>& sigSharesToSend, const std::vector<CNode*>& vNodes) EXCLUSIVE_LOCKS_REQUIRED(cs);
-    void CollectSigSharesToAnnounce(std::unordered_map<NodeId, std::unordered_map<uint256, CSigSharesInv, StaticSaltedHasher>>& sigSharesToAnnounce) EXCLUSIVE_LOCKS_REQUIRED(cs);
+    void CollectSigSharesToAnnounce(std::unordered_map<NodeId, std::unordered_map<uint256, CSigSharesInv, StaticSaltedHasher>>& sigSharesToAnnounce) EXCLUSIVE_LOCKS_REQUIRED(cs, cs_nodeStates);
     void SignPendingSigShares();
     void WorkThreadMain();
 };
@@ -19,6 +19,50 @@
 namespace llmq {
 
 static const std::string DB_QUORUM_SNAPSHOT = "llmq_S";
+static const std::string DB_QUORUM_MEMBERS = "llmq_M";
+
+// The height is stored big endian so that the keys of a type are ordered by height
+static std::tuple<std::string, Consensus::LLMQType, uint32_t, uint256> BuildQuorumMembersKey(Consensus::LLMQType llmqType, int nHeight, const uint256& blockHash)
+{
+    return std::make_tuple(DB_QUORUM_MEMBERS, llmqType, htobe32(uint32_t(nHeight)), blockHash);
+}
+
+/**
+ * The full MN entries are stored as members of older quarters come from older MN lists, looking them up by
+ * proTxHash in a single list would give them the wrong state.
+ */
+class CQuorumMembersRecord
+{
+public:
+    std::vector<std::vector<CDeterministicMNCPtr>> members;
+
+    template<typename Stream>
+    void Serialize(Stream& s) const
+    {
+        s << uint8_t(CDeterministicMN::MN_CURRENT_FORMAT);
+        WriteCompactSize(s, members.size());
+        for (const auto& quorumMembers : members) {
+            WriteCompactSize(s, quorumMembers.size());
+            for (const auto& dmn : quorumMembers) {
+                s << *dmn;
+            }
+        }
+    }
+
+    template<typename Stream>
+    void Unserialize(Stream& s)
+    {
+        uint8_t format_version;
+        s >> format_version;
+        members.resize(ReadCompactSize(s));
+        for (auto& quorumMembers : members) {
+            quorumMembers.resize(ReadCompactSize(s));
+            for (auto& dmn : quorumMembers) {
+                dmn = std::make_shared<const CDeterministicMN>(deserialize, s, format_version);
+            }
+        }
+    }
+};
 
 std::unique_ptr<CQuorumSnapshotManager> quorumSnapshotManager;
 
@@ -331,6 +375,31 @@ uint256 GetLastBaseBlockHash(Span<const CBlockIndex*> baseBlockIndexes, const CB
     return hash;
 }
 
+CQuorumRotationInfoCache::Data CQuorumRotationInfoCache::Get(const CGetQuorumRotationInfo& request, const uint256& tip, int nVersion)
+{
+    LOCK(cs);
+    if (tip != tipHash) {
+        return nullptr;
+    }
+    const auto it = responses.find({::SerializeHash(request), nVersion});
+    return it != responses.end() ? it->second : nullptr;
+}
+
+void CQuorumRotationInfoCache::Add(const CGetQuorumRotationInfo& request, const uint256& tip, int nVersion, Data data)
+{
+    LOCK(cs);
+    if (tip != tipHash) {
+        tipHash = tip;
+        responses.clear();
+        cacheBytes = 0;
+    }
+    if (cacheBytes + data->size() > MAX_CACHE_BYTES) {
+        return;
+    }
+    cacheBytes += data->size();
+    responses.emplace(std::make_pair(::SerializeHash(request), nVersion), std::move(data));
+}
+
 std::optional<CQuorumSnapshot> CQuorumSnapshotManager::GetSnapshotForBlock(const Consensus::LLMQType llmqType, const CBlockIndex* pindex)
 {
     CQuorumSnapshot snapshot = {};
@@ -361,4 +430,43 @@ void CQuorumSnapshotManager::StoreSnapshotForBlock(const Consensus::LLMQType llm
     quorumSnapshotCache.insert(snapshotHash, snapshot);
 }
 
+std::optional<std::vector<std::vector<CDeterministicMNCPtr>>> CQuorumSnapshotManager::GetQuorumMembers(const Consensus::LLMQType llmqType, const CBlockIndex* pindex) const
+{
+    CQuorumMembersRecord record;
+    try {
+        if (!m_evoDb.GetRawDB().Read(BuildQuorumMembersKey(llmqType, pindex->nHeight, pindex->GetBlockHash()), record)) {
+            return std::nullopt;
+        }
+    } catch (const std::exception& e) {
+        LogPrintf("CQuorumSnapshotManager::%s -- failed to read members: %s\n", __func__, e.what());
+        return std::nullopt;
+    }
+    return std::move(record.members);
+}
+
+void CQuorumSnapshotManager::StoreQuorumMembers(const Consensus::LLMQParams& llmqParams, const CBlockIndex* pindex, const std::vector<std::vector<CDeterministicMNCPtr>>& members)
+{
+    auto& db = m_evoDb.GetRawDB();
+
+    CDBBatch batch(db);
+    batch.Write(BuildQuorumMembersKey(llmqParams.type, pindex->nHeight, pindex->GetBlockHash()), CQuorumMembersRecord{members});
+
+    // Drop the members of quorums too old to be used for signing anymore
+    const int nPruneHeight = pindex->nHeight - llmqParams.max_store_depth();
+    if (nPruneHeight > 0) {
+        const auto firstKey = BuildQuorumMembersKey(llmqParams.type, 0, uint256());
+        const auto lastKey = BuildQuorumMembersKey(llmqParams.type, nPruneHeight, uint256());
+        std::unique_ptr<CDBIterator> pcursor(db.NewIterator());
+        for (pcursor->Seek(firstKey); pcursor->Valid(); pcursor->Next()) {
+            std::remove_const_t<decltype(firstKey)> key;
+            if (!pcursor->GetKey(key) || std::get<0>(key) != DB_QUORUM_MEMBERS || std::get<1>(key) != llmqParams.type || key >= lastKey) {
+                break;
+            }
+            batch.Erase(key);
+        }
+    }
+
+    db.WriteBatch(batch);
+}
+
 } // namespace llmq
@@ -15,7 +15,10 @@
 #include <unordered_lru_cache.h>
 #include <util/irange.h>
 
+#include <map>
+#include <memory>
 #include <optional>
+#include <vector>
 
 class CBlockIndex;
 class CDeterministicMN;
@@ -211,6 +214,31 @@ bool BuildQuorumRotationInfo(const CGetQuorumRotationInfo& request, CQuorumRotat
                              const CQuorumManager& qman, const CQuorumBlockProcessor& quorumBlockProcessor, std::string& errorRet);
 uint256 GetLastBaseBlockHash(Span<const CBlockIndex*> baseBlockIndexes, const CBlockIndex* blockIndex);
 
+/**
+ * Serialized QUORUMROTATIONINFO responses for the current tip. A response only depends on the request and
+ * the tip, so light clients syncing with the same bases share one build per block. Entries are keyed by the
+ * request and the serialization version of the peer, and all of them are dropped when the tip changes.
+ */
+class CQuorumRotationInfoCache
+{
+public:
+    using Data = std::shared_ptr<const std::vector<unsigned char>>;
+
+private:
+    //! Budget for the cached responses of one tip, further responses are built per request
+    static constexpr size_t MAX_CACHE_BYTES{16 * 1024 * 1024};
+
+    mutable Mutex cs;
+    uint256 tipHash GUARDED_BY(cs);
+    std::map<std::pair<uint256, int>, Data> responses GUARDED_BY(cs);
+    size_t cacheBytes GUARDED_BY(cs){0};
+
+public:
+    /** The cached response for a request at tip, or nullptr */
+    Data Get(const CGetQuorumRotationInfo& request, const uint256& tip, int nVersion) EXCLUSIVE_LOCKS_REQUIRED(!cs);
+    void Add(const CGetQuorumRotationInfo& request, const uint256& tip, int nVersion, Data data) EXCLUSIVE_LOCKS_REQUIRED(!cs);
+};
+
 class CQuorumSnapshotManager
 {
 private:
@@ -226,6 +254,14 @@ public:
 
     std::optional<CQuorumSnapshot> GetSnapshotForBlock(Consensus::LLMQType llmqType, const CBlockIndex* pindex);
     void StoreSnapshotForBlock(Consensus::LLMQType llmqType, const CBlockIndex* pindex, const CQuorumSnapshot& snapshot);
+
+    /**
+     * Members of the quorum based on pindex, or of all quorums of the rotation cycle starting at pindex. They only
+     * depend on the chain up to pindex and never change once computed. Members of quorums older than
+     * max_store_depth() are removed when newer ones are stored.
+     */
+    std::optional<std::vector<std::vector<CDeterministicMNCPtr>>> GetQuorumMembers(Consensus::LLMQType llmqType, const CBlockIndex* pindex) const;
+    void StoreQuorumMembers(const Consensus::LLMQParams& llmqParams, const CBlockIndex* pindex, const std::vector<std::vector<CDeterministicMNCPtr>>& members);
 };
 
 extern std::unique_ptr<CQuorumSnapshotManager> quorumSnapshotManager;
@@ -14,6 +14,8 @@
 #include <masternode/meta.h>
 #include <net.h>
 #include <random.h>
+#include <saltedhasher.h>
+#include <unordered_lru_cache.h>
 #include <util/irange.h>
 #include <util/ranges.h>
 #include <util/time.h>
@@ -21,6 +23,7 @@
 #include <validation.h>
 
 #include <atomic>
+#include <list>
 #include <optional>
 
 class CBLSSignature;
@@ -97,26 +100,94 @@ static uint256 GetHashModifier(const Consensus::LLMQParams& llmqParams, gsl::not
     return ::SerializeHash(std::make_pair(llmqParams.type, pCycleQuorumBaseBlockIndex->GetBlockHash()));
 }
 
+/**
+ * LRU cache of quorum members bounded by the memory the members take instead of the number of quorums, as member
+ * counts range from a handful to hundreds depending on the LLMQ type. An entry is either keyed by the quorum base
+ * block hash (index -1) or, for rotated quorums, by the cycle base block hash and the quorum index, as the base
+ * blocks of later quorums of a cycle are not known yet when the cycle is computed.
+ */
+class CQuorumMembersCache
+{
+private:
+    using Key = std::tuple<Consensus::LLMQType, uint256, int>;
+    using Members = std::shared_ptr<const std::vector<CDeterministicMNCPtr>>;
+    using Entries = std::list<std::pair<Key, Members>>;
+
+    Mutex cs;
+    Entries entries GUARDED_BY(cs);
+    std::map<Key, Entries::iterator> mapEntries GUARDED_BY(cs);
+    size_t nUsage GUARDED_BY(cs){0};
+    const size_t nMaxUsage;
+
+    static size_t Usage(const Members& members)
+    {
+        // MN entries shared with MN lists are counted as well, they are kept alive by the cache
+        return sizeof(Key) + sizeof(Members) + members->size() * (sizeof(CDeterministicMNCPtr) + sizeof(CDeterministicMN) + sizeof(CDeterministicMNState));
+    }
+
+public:
+    explicit CQuorumMembersCache(size_t _nMaxUsage) : nMaxUsage(_nMaxUsage) {}
+
+    bool Get(const Key& key, std::vector<CDeterministicMNCPtr>& members) LOCKS_EXCLUDED(cs)
+    {
+        LOCK(cs);
+        auto it = mapEntries.find(key);
+        if (it == mapEntries.end()) {
+            return false;
+        }
+        entries.splice(entries.begin(), entries, it->second);
+        members = *it->second->second;
+        return true;
+    }
+
+    void Insert(const Key& key, std::vector<CDeterministicMNCPtr> members) LOCKS_EXCLUDED(cs)
+    {
+        auto pmembers = std::make_shared<const std::vector<CDeterministicMNCPtr>>(std::move(members));
+        LOCK(cs);
+        if (auto it = mapEntries.find(key); it != mapEntries.end()) {
+            nUsage -= Usage(it->second->second);
+            entries.erase(it->second);
+            mapEntries.erase(it);
+        }
+        nUsage += Usage(pmembers);
+        entries.emplace_front(key, std::move(pmembers));
+        mapEntries.emplace(key, entries.begin());
+        // Always keep the entry just inserted
+        while (nUsage > nMaxUsage && entries.size() > 1) {
+            nUsage -= Usage(entries.back().second);
+            mapEntries.erase(entries.back().first);
+            entries.pop_back();
+        }
+    }
+
+    void Clear(Consensus::LLMQType llmqType) LOCKS_EXCLUDED(cs)
+    {
+        LOCK(cs);
+        for (auto it = entries.begin(); it != entries.end();) {
+            if (std::get<0>(it->first) == llmqType) {
+                nUsage -= Usage(it->second);
+                mapEntries.erase(it->first);
+                it = entries.erase(it);
+            } else {
+                ++it;
+            }
+        }
+    }
+};
+
+static constexpr size_t QUORUM_MEMBERS_CACHE_MAX_USAGE = 32 << 20;
+
 std::vector<CDeterministicMNCPtr> GetAllQuorumMembers(Consensus::LLMQType llmqType, gsl::not_null<const CBlockIndex*> pQuorumBaseBlockIndex, bool reset_cache)
 {
-    static RecursiveMutex cs_members;
-    static std::map<Consensus::LLMQType, unordered_lru_cache<uint256, std::vector<CDeterministicMNCPtr>, StaticSaltedHasher>> mapQuorumMembers GUARDED_BY(cs_members);
-    static RecursiveMutex cs_indexed_members;
-    static std::map<Consensus::LLMQType, unordered_lru_cache<std::pair<uint256, int>, std::vector<CDeterministicMNCPtr>, StaticSaltedHasher>> mapIndexedQuorumMembers GUARDED_BY(cs_indexed_members);
+    static CQuorumMembersCache cache(QUORUM_MEMBERS_CACHE_MAX_USAGE);
     if (!IsQuorumTypeEnabled(llmqType, pQuorumBaseBlockIndex->pprev)) {
         return {};
     }
     std::vector<CDeterministicMNCPtr> quorumMembers;
-    {
-        LOCK(cs_members);
-        if (mapQuorumMembers.empty()) {
-            InitQuorumsCache(mapQuorumMembers);
-        }
-        if (reset_cache) {
-            mapQuorumMembers[llmqType].clear();
-        } else if (mapQuorumMembers[llmqType].get(pQuorumBaseBlockIndex->GetBlockHash(), quorumMembers)) {
-            return quorumMembers;
-        }
+    if (reset_cache) {
+        cache.Clear(llmqType);
+    } else if (cache.Get({llmqType, pQuorumBaseBlockIndex->GetBlockHash(), -1}, quorumMembers)) {
+        return quorumMembers;
     }
 
     const auto& llmq_params_opt = Params().GetLLMQ(llmqType);
@@ -124,9 +195,6 @@ std::vector<CDeterministicMNCPtr> GetAllQuorumMembers(Consensus::LLMQType llmqTy
     const auto& llmq_params = llmq_params_opt.value();
 
     if (IsQuorumRotationEnabled(llmq_params, pQuorumBaseBlockIndex)) {
-        if (LOCK(cs_indexed_members); mapIndexedQuorumMembers.empty()) {
-            InitQuorumsCache(mapIndexedQuorumMembers);
-        }
         /*
          * Quorums created with rotation are now created in a different way. All signingActiveQuorumCount are created during the period of dkgInterval.
          * But they are not created exactly in the same block, they are spread overtime: one quorum in each block until all signingActiveQuorumCount are created.
@@ -144,31 +212,48 @@ std::vector<CDeterministicMNCPtr> GetAllQuorumMembers(Consensus::LLMQType llmqTy
         const CBlockIndex* pCycleQuorumBaseBlockIndex = pQuorumBaseBlockIndex->GetAncestor(cycleQuorumBaseHeight);
 
         /*
-         * Since mapQuorumMembers stores Quorum members per block hash, and we don't know yet the block hashes of blocks for all quorumIndexes (since these blocks are not created yet)
-         * We store them in a second cache mapIndexedQuorumMembers which stores them by {CycleQuorumBaseBlockHash, quorumIndex}
+         * The members of all quorums of a cycle are computed at once, but the base blocks of the later quorums aren't
+         * known yet at that point. They are cached by {CycleQuorumBaseBlockHash, quorumIndex} and stored in the DB
+         * by the cycle base block.
          */
-        if (reset_cache) {
-            LOCK(cs_indexed_members);
-            mapIndexedQuorumMembers[llmqType].clear();
-        } else if (LOCK(cs_indexed_members); mapIndexedQuorumMembers[llmqType].get(std::pair(pCycleQuorumBaseBlockIndex->GetBlockHash(), quorumIndex), quorumMembers)) {
-            LOCK(cs_members);
-            mapQuorumMembers[llmqType].insert(pQuorumBaseBlockIndex->GetBlockHash(), quorumMembers);
+        if (!reset_cache && cache.Get({llmqType, pCycleQuorumBaseBlockIndex->GetBlockHash(), quorumIndex}, quorumMembers)) {
+            cache.Insert({llmqType, pQuorumBaseBlockIndex->GetBlockHash(), -1}, quorumMembers);
             return quorumMembers;
         }
 
-        auto q = ComputeQuorumMembersByQuarterRotation(llmq_params, pCycleQuorumBaseBlockIndex);
-        LOCK(cs_indexed_members);
-        for (const size_t i : irange::range(q.size())) {
-            mapIndexedQuorumMembers[llmqType].insert(std::make_pair(pCycleQuorumBaseBlockIndex->GetBlockHash(), i), q[i]);
+        std::optional<std::vector<std::vector<CDeterministicMNCPtr>>> q;
+        if (!reset_cache && quorumSnapshotManager) {
+            q = quorumSnapshotManager->GetQuorumMembers(llmqType, pCycleQuorumBaseBlockIndex);
+        }
+        if (!q.has_value() || size_t(quorumIndex) >= q->size()) {
+            q = ComputeQuorumMembersByQuarterRotation(llmq_params, pCycleQuorumBaseBlockIndex);
+            // Results built without the snapshots of previous cycles are incomplete, only store full quorums
+            const bool fComplete = std::all_of(q->begin(), q->end(), [&](const auto& members) { return members.size() == size_t(llmq_params.size); });
+            if (fComplete && quorumSnapshotManager) {
+                quorumSnapshotManager->StoreQuorumMembers(llmq_params, pCycleQuorumBaseBlockIndex, *q);
+            }
+        }
+        for (const size_t i : irange::range(q->size())) {
+            cache.Insert({llmqType, pCycleQuorumBaseBlockIndex->GetBlockHash(), int(i)}, (*q)[i]);
         }
 
-        quorumMembers = q[quorumIndex];
+        quorumMembers = (*q)[quorumIndex];
     } else {
-        quorumMembers = ComputeQuorumMembers(llmqType, pQuorumBaseBlockIndex);
+        std::optional<std::vector<std::vector<CDeterministicMNCPtr>>> stored;
+        if (!reset_cache && quorumSnapshotManager) {
+            stored = quorumSnapshotManager->GetQuorumMembers(llmqType, pQuorumBaseBlockIndex);
+        }
+        if (stored.has_value() && stored->size() == 1) {
+            quorumMembers = std::move(stored->front());
+        } else {
+            quorumMembers = ComputeQuorumMembers(llmqType, pQuorumBaseBlockIndex);
+            if (!quorumMembers.empty() && quorumSnapshotManager) {
+                quorumSnapshotManager->StoreQuorumMembers(llmq_params, pQuorumBaseBlockIndex, {quorumMembers});
+            }
+        }
     }
 
-    LOCK(cs_members);
-    mapQuorumMembers[llmqType].insert(pQuorumBaseBlockIndex->GetBlockHash(), quorumMembers);
+    cache.Insert({llmqType, pQuorumBaseBlockIndex->GetBlockHash(), -1}, quorumMembers);
     return quorumMembers;
 }
 
@@ -649,13 +734,58 @@ uint256 DeterministicOutboundConnection(const uint256& proTxHash1, const uint256
     return proTxHash2;
 }
 
+/**
+ * Connection sets only depend on the quorum members and the member we compute them for, so they are cached per quorum
+ * and member. The member list an entry was computed from is kept with it so that the entry is dropped as soon as
+ * GetAllQuorumMembers returns a different list (e.g. after its cache was reset).
+ */
+struct CQuorumConnectionsCacheEntry {
+    std::vector<CDeterministicMNCPtr> members;
+    std::set<uint256> result;
+};
+
+static Mutex cs_quorum_connections;
+static unordered_lru_cache<uint256, CQuorumConnectionsCacheEntry, StaticSaltedHasher, 1024> quorumConnectionsCache GUARDED_BY(cs_quorum_connections);
+
+enum class QuorumConnectionsKind : uint8_t {
+    CONNECTIONS,
+    RELAY_MEMBERS,
+};
+
+template <typename Compute>
+static std::set<uint256> GetCachedQuorumConnections(QuorumConnectionsKind kind, Consensus::LLMQType llmqType, gsl::not_null<const CBlockIndex*> pQuorumBaseBlockIndex,
+                                                    const uint256& forMember, bool onlyOutbound, Compute&& compute)
+{
+    const uint256 cacheKey = ::SerializeHash(std::make_tuple(static_cast<uint8_t>(kind), llmqType, pQuorumBaseBlockIndex->GetBlockHash(), forMember, onlyOutbound));
+    auto mns = GetAllQuorumMembers(llmqType, pQuorumBaseBlockIndex);
+    {
+        LOCK(cs_quorum_connections);
+        CQuorumConnectionsCacheEntry entry;
+        if (quorumConnectionsCache.get(cacheKey, entry) && entry.members == mns) {
+            return entry.result;
+        }
+    }
+
+    CQuorumConnectionsCacheEntry entry;
+    entry.result = compute(mns);
+    entry.members = std::move(mns);
+    std::set<uint256> result = entry.result;
+    LOCK(cs_quorum_connections);
+    quorumConnectionsCache.insert(cacheKey, std::move(entry));
+    return result;
+}
+
+static std::set<uint256> ComputeQuorumRelayMembers(const std::vector<CDeterministicMNCPtr>& mns, const uint256& forMember, bool onlyOutbound);
+
 std::set<uint256> GetQuorumConnections(const Consensus::LLMQParams& llmqParams, gsl::not_null<const CBlockIndex*> pQuorumBaseBlockIndex,
                                                    const uint256& forMember, bool onlyOutbound)
 {
-    if (IsAllMembersConnectedEnabled(llmqParams.type)) {
-        auto mns = GetAllQuorumMembers(llmqParams.type, pQuorumBaseBlockIndex);
+    if (!IsAllMembersConnectedEnabled(llmqParams.type)) {
+        return GetQuorumRelayMembers(llmqParams, pQuorumBaseBlockIndex, forMember, onlyOutbound);
+    }
+    return GetCachedQuorumConnections(QuorumConnectionsKind::CONNECTIONS, llmqParams.type, pQuorumBaseBlockIndex, forMember, onlyOutbound,
+                                      [&](const std::vector<CDeterministicMNCPtr>& mns) {
         std::set<uint256> result;
-
         for (const auto& dmn : mns) {
             if (dmn->proTxHash == forMember) {
                 continue;
@@ -669,14 +799,20 @@ std::set<uint256> GetQuorumConnections(const Consensus::LLMQParams& llmqParams,
             }
         }
         return result;
-    }
-    return GetQuorumRelayMembers(llmqParams, pQuorumBaseBlockIndex, forMember, onlyOutbound);
+    });
 }
 
 std::set<uint256> GetQuorumRelayMembers(const Consensus::LLMQParams& llmqParams, gsl::not_null<const CBlockIndex*> pQuorumBaseBlockIndex,
                                                     const uint256& forMember, bool onlyOutbound)
 {
-    auto mns = GetAllQuorumMembers(llmqParams.type, pQuorumBaseBlockIndex);
+    return GetCachedQuorumConnections(QuorumConnectionsKind::RELAY_MEMBERS, llmqParams.type, pQuorumBaseBlockIndex, forMember, onlyOutbound,
+                                      [&](const std::vector<CDeterministicMNCPtr>& mns) {
+        return ComputeQuorumRelayMembers(mns, forMember, onlyOutbound);
+    });
+}
+
+static std::set<uint256> ComputeQuorumRelayMembers(const std::vector<CDeterministicMNCPtr>& mns, const uint256& forMember, bool onlyOutbound)
+{
     std::set<uint256> result;
 
     auto calcOutbound = [&](size_t i, const uint256& proTxHash) {
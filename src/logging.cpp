@@ -5,12 +5,18 @@
 
 #include <logging.h>
 #include <util/system.h>
+#include <util/thread.h>
 #include <util/threadnames.h>
 #include <util/time.h>
 
 #include <algorithm>
 #include <array>
 
+//! Upper bound for the writer thread to notice lines pushed while it went to sleep
+static constexpr auto ASYNC_LOG_WAKEUP_INTERVAL{std::chrono::milliseconds{100}};
+//! Lines written per m_cs acquisition by the writer thread
+static constexpr size_t ASYNC_LOG_BATCH{1024};
+
 const char * const DEFAULT_DEBUGLOGFILE = "debug.log";
 
 BCLog::Logger& LogInstance()
@@ -77,11 +83,56 @@ bool BCLog::Logger::StartLogging()
     }
     if (m_print_to_console) fflush(stdout);
 
+    if (m_async_capacity > 0 && !m_async_running) {
+        m_async_queue = std::make_unique<RingBuffer<std::string>>(m_async_capacity);
+        m_async_running = true;
+        m_async_thread = std::thread(&util::TraceThread, "logger", [this] { AsyncWriterThread(); });
+    }
+
     return true;
 }
 
+void BCLog::Logger::AsyncWriterThread()
+{
+    std::string str;
+    while (true) {
+        // Once stopped and no caller is pushing anymore, the queue only has to be drained
+        const bool stopping = !m_async_running && m_async_producers == 0;
+        size_t written{0};
+        {
+            StdLockGuard scoped_lock(m_cs);
+            while ((stopping || written < ASYNC_LOG_BATCH) && m_async_queue->TryPop(str)) {
+                WriteLogStr(str);
+                written++;
+            }
+            if (const uint64_t dropped = m_async_dropped.exchange(0)) {
+                m_started_new_line = true;
+                WriteLogStr(FormatLogStr(strprintf("Logging queue full, dropped %u lines\n", dropped)));
+            }
+        }
+        if (stopping) break;
+        if (written == 0) {
+            std::unique_lock<std::mutex> lock(m_async_mutex);
+            m_async_idle = true;
+            m_async_cv.wait_for(lock, ASYNC_LOG_WAKEUP_INTERVAL, [this] { return !m_async_queue->Empty() || !m_async_running; });
+            m_async_idle = false;
+        }
+    }
+}
+
+void BCLog::Logger::StopAsyncLogging()
+{
+    if (!m_async_running.exchange(false)) return;
+    while (m_async_producers > 0) {
+        std::this_thread::yield();
+    }
+    m_async_cv.notify_one();
+    m_async_thread.join();
+}
+
 void BCLog::Logger::DisconnectTestLogger()
 {
+    StopAsyncLogging();
     StdLockGuard scoped_lock(m_cs);
     m_buffering = true;
     if (m_fileout != nullptr) fclose(m_fileout);
@@ -268,9 +319,8 @@ namespace BCLog {
     }
 } // namespace BCLog
 
-void BCLog::Logger::LogPrintStr(const std::string& str)
+std::string BCLog::Logger::FormatLogStr(const std::string& str)
 {
-    StdLockGuard scoped_lock(m_cs);
     std::string str_prefixed = LogEscapeMessage(str);
 
     if (m_log_threadnames && m_started_new_line) {
@@ -282,12 +332,41 @@ void BCLog::Logger::LogPrintStr(const std::string& str)
 
     m_started_new_line = !str.empty() && str[str.size()-1] == '\n';
 
+    return str_prefixed;
+}
+
+void BCLog::Logger::LogPrintStr(const std::string& str)
+{
+    m_async_producers++;
+    if (m_async_running) {
+        // Formatting stays on the caller's thread for the timestamp and thread name, only
+        // the output is left to the writer. Lines of concurrent callers which don't end in
+        // a newline may get a prefix in the middle, like they would get interleaved.
+        std::string str_prefixed = FormatLogStr(str);
+        if (!m_async_queue->TryPush(std::move(str_prefixed))) {
+            m_async_dropped++;
+            m_async_dropped_total++;
+        }
+        m_async_producers--;
+        if (m_async_idle.load(std::memory_order_relaxed)) m_async_cv.notify_one();
+        return;
+    }
+    m_async_producers--;
+
+    StdLockGuard scoped_lock(m_cs);
+    std::string str_prefixed = FormatLogStr(str);
+
     if (m_buffering) {
         // buffer if we haven't started logging yet
         m_msgs_before_open.push_back(str_prefixed);
         return;
     }
 
+    WriteLogStr(str_prefixed);
+}
+
+void BCLog::Logger::WriteLogStr(const std::string& str_prefixed)
+{
     if (m_print_to_console) {
         // print to console
         fwrite(str_prefixed.data(), 1, str_prefixed.size(), stdout);
@@ -7,21 +7,27 @@
 #define BITCOIN_LOGGING_H
 
 #include <fs.h>
+#include <logging/ringbuffer.h>
 #include <tinyformat.h>
 #include <threadsafety.h>
 #include <util/string.h>
 
 #include <atomic>
+#include <condition_variable>
 #include <cstdint>
 #include <list>
+#include <memory>
 #include <mutex>
 #include <string>
+#include <thread>
 #include <vector>
 
 static const bool DEFAULT_LOGTIMEMICROS  = false;
 static const bool DEFAULT_LOGIPS         = false;
 static const bool DEFAULT_LOGTIMESTAMPS  = true;
 static const bool DEFAULT_LOGTHREADNAMES = false;
+//! Lines buffered for the background log writer, 0 writes on the logging thread
+static const size_t DEFAULT_LOGASYNC      = 0;
 extern const char * const DEFAULT_DEBUGLOGFILE;
 
 extern bool fLogThreadNames;
@@ -106,9 +112,32 @@ namespace BCLog {
         std::string LogTimestampStr(const std::string& str);
         std::string LogThreadNameStr(const std::string &str);
 
+        /** Escape and prefix a log string the way it appears in the outputs */
+        std::string FormatLogStr(const std::string& str);
+        /** Write a formatted string to the console, callbacks and debug.log */
+        void WriteLogStr(const std::string& str_prefixed) EXCLUSIVE_LOCKS_REQUIRED(m_cs);
+
         /** Slots that connect to the print signal */
         std::list<std::function<void(const std::string&)>> m_print_callbacks /* GUARDED_BY(m_cs) */ {};
 
+        /**
+         * Asynchronous logging: callers only format their line and push it to
+         * m_async_queue, the writer thread does all output under m_cs.
+         * m_async_producers counts callers between checking m_async_running
+         * and pushing, so that stopping can wait for them before the last drain.
+         */
+        std::unique_ptr<RingBuffer<std::string>> m_async_queue;
+        std::atomic<bool> m_async_running{false};
+        std::atomic<int> m_async_producers{0};
+        std::atomic<uint64_t> m_async_dropped{0};
+        std::atomic<uint64_t> m_async_dropped_total{0};
+        std::atomic<bool> m_async_idle{false};
+        std::mutex m_async_mutex;
+        std::condition_variable m_async_cv;
+        std::thread m_async_thread;
+
+        void AsyncWriterThread();
+
     public:
         bool m_print_to_console = false;
         bool m_print_to_file = false;
@@ -119,6 +148,8 @@ namespace BCLog {
 
         fs::path m_file_path;
         std::atomic<bool> m_reopen_file{false};
+        //! Capacity of the queue of the background writer started by StartLogging, 0 to log synchronously
+        size_t m_async_capacity{DEFAULT_LOGASYNC};
 
         /** Send a string to the log output */
         void LogPrintStr(const std::string& str);
@@ -126,6 +157,8 @@ namespace BCLog {
         /** Returns whether logs will be written to any output */
         bool Enabled() const
         {
+            // The writer thread only runs while there is an output, and holds m_cs while writing
+            if (m_async_running.load(std::memory_order_relaxed)) return true;
             StdLockGuard scoped_lock(m_cs);
             return m_buffering || m_print_to_console || m_print_to_file || !m_print_callbacks.empty();
         }
@@ -147,6 +180,10 @@ namespace BCLog {
 
         /** Start logging (and flush all buffered messages) */
         bool StartLogging();
+        /** Write all queued lines and go back to logging on the caller's thread */
+        void StopAsyncLogging();
+        /** Number of lines dropped because the queue of the background writer was full */
+        uint64_t GetAsyncDropped() const { return m_async_dropped_total.load(); }
         /** Only for testing */
         void DisconnectTestLogger();
 
@@ -0,0 +1,110 @@
+// Copyright (c) 2024 The Maximus developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_LOGGING_RINGBUFFER_H
+#define BITCOIN_LOGGING_RINGBUFFER_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+namespace BCLog {
+
+/**
+ * Bounded lock-free queue for many producers and a single consumer.
+ *
+ * Every cell carries a sequence number telling whether it is free for the
+ * producer claiming position `pos` (seq == pos) or holds a value for the
+ * consumer reading `pos` (seq == pos + 1). Producers claim positions with a
+ * CAS on the head, so neither side ever blocks; a full queue makes TryPush
+ * fail instead of waiting. The capacity is rounded up to a power of two.
+ */
+template <typename T>
+class RingBuffer
+{
+private:
+    struct Cell {
+        std::atomic<size_t> seq;
+        T value;
+    };
+
+    const size_t m_mask;
+    const std::unique_ptr<Cell[]> m_cells;
+    //! Next position to be claimed by a producer
+    alignas(64) std::atomic<size_t> m_head{0};
+    //! Next position to be read, only accessed by the consumer
+    alignas(64) size_t m_tail{0};
+
+    static size_t RoundUpCapacity(size_t capacity)
+    {
+        size_t ret{2};
+        while (ret < capacity) ret <<= 1;
+        return ret;
+    }
+
+public:
+    explicit RingBuffer(size_t capacity) :
+        m_mask(RoundUpCapacity(capacity) - 1),
+        m_cells(new Cell[m_mask + 1])
+    {
+        for (size_t i = 0; i <= m_mask; i++) {
+            m_cells[i].seq.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    RingBuffer(const RingBuffer&) = delete;
+    RingBuffer& operator=(const RingBuffer&) = delete;
+
+    size_t Capacity() const { return m_mask + 1; }
+
+    /** Append a value, returns false and leaves value untouched if the queue is full. Safe to call from any thread. */
+    bool TryPush(T&& value)
+    {
+        size_t pos = m_head.load(std::memory_order_relaxed);
+        while (true) {
+            Cell& cell = m_cells[pos & m_mask];
+            const size_t seq = cell.seq.load(std::memory_order_acquire);
+            const intptr_t diff = intptr_t(seq) - intptr_t(pos);
+            if (diff == 0) {
+                if (m_head.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    cell.value = std::move(value);
+                    cell.seq.store(pos + 1, std::memory_order_release);
+                    return true;
+                }
+                // pos was reloaded by the failed CAS
+            } else if (diff < 0) {
+                // the consumer hasn't freed this cell yet
+                return false;
+            } else {
+                pos = m_head.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    /** Remove the oldest value. Only one thread may consume. */
+    bool TryPop(T& value)
+    {
+        Cell& cell = m_cells[m_tail & m_mask];
+        const size_t seq = cell.seq.load(std::memory_order_acquire);
+        if (intptr_t(seq) - intptr_t(m_tail + 1) < 0) {
+            // empty, or the producer of this cell hasn't finished writing it
+            return false;
+        }
+        value = std::move(cell.value);
+        cell.seq.store(m_tail + m_mask + 1, std::memory_order_release);
+        ++m_tail;
+        return true;
+    }
+
+    /** Whether values are pending, which may be outdated when it returns. Only for the consumer. */
+    bool Empty() const
+    {
+        return m_head.load(std::memory_order_acquire) == m_tail;
+    }
+};
+
+} // namespace BCLog
+
+#endif // BITCOIN_LOGGING_RINGBUFFER_H
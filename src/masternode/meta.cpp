@@ -5,6 +5,7 @@
 #include <masternode/meta.h>
 
 #include <flat-database.h>
+#include <memusage.h>
 #include <util/time.h>
 
 #include <sstream>
@@ -65,15 +66,16 @@ void CMasternodeMetaInfo::RemoveGovernanceObject(const uint256& nGovernanceObjec
 
 CMasternodeMetaInfoPtr CMasternodeMetaMan::GetMetaInfo(const uint256& proTxHash, bool fCreate)
 {
-    LOCK(cs);
-    auto it = metaInfos.find(proTxHash);
-    if (it != metaInfos.end()) {
+    auto& shard = GetShard(proTxHash);
+    LOCK(shard.cs);
+    auto it = shard.metaInfos.find(proTxHash);
+    if (it != shard.metaInfos.end()) {
         return it->second;
     }
     if (!fCreate) {
         return nullptr;
     }
-    it = metaInfos.emplace(proTxHash, std::make_shared<CMasternodeMetaInfo>(proTxHash)).first;
+    it = shard.metaInfos.emplace(proTxHash, std::make_shared<CMasternodeMetaInfo>(proTxHash)).first;
     return it->second;
 }
 
@@ -114,9 +116,11 @@ bool CMasternodeMetaMan::AddGovernanceVote(const uint256& proTxHash, const uint2
 
 void CMasternodeMetaMan::RemoveGovernanceObject(const uint256& nGovernanceObjectHash)
 {
-    LOCK(cs);
-    for(const auto& p : metaInfos) {
-        p.second->RemoveGovernanceObject(nGovernanceObjectHash);
+    for (const auto& shard : shards) {
+        LOCK(shard.cs);
+        for (const auto& p : shard.metaInfos) {
+            p.second->RemoveGovernanceObject(nGovernanceObjectHash);
+        }
     }
 }
 
@@ -128,11 +132,34 @@ std::vector<uint256> CMasternodeMetaMan::GetAndClearDirtyGovernanceObjectHashes(
     return vecTmp;
 }
 
+size_t CMasternodeMetaInfo::DynamicMemoryUsage() const
+{
+    LOCK(cs);
+    return memusage::DynamicUsage(mapGovernanceObjectsVotedOn);
+}
+
+size_t CMasternodeMetaMan::DynamicMemoryUsage() const
+{
+    size_t nUsage{0};
+    for (const auto& shard : shards) {
+        LOCK(shard.cs);
+        nUsage += memusage::DynamicUsage(shard.metaInfos);
+        for (const auto& [_, metaInfo] : shard.metaInfos) {
+            nUsage += memusage::DynamicUsage(metaInfo) + metaInfo->DynamicMemoryUsage();
+        }
+    }
+    LOCK(cs);
+    return nUsage + memusage::DynamicUsage(vecDirtyGovernanceObjectHashes);
+}
+
 std::string MasternodeMetaStore::ToString() const
 {
     std::ostringstream info;
-    LOCK(cs);
-    info << "Masternodes: meta infos object count: " << (int)metaInfos.size() <<
+    size_t nCount{0};
+    for (const auto& shard : shards) {
+        nCount += WITH_LOCK(shard.cs, return shard.metaInfos.size());
+    }
+    info << "Masternodes: meta infos object count: " << (int)nCount <<
          ", nDsqCount: " << (int)nDsqCount;
     return info.str();
 }
@@ -5,14 +5,18 @@
 #ifndef BITCOIN_MASTERNODE_META_H
 #define BITCOIN_MASTERNODE_META_H
 
+#include <saltedhasher.h>
 #include <serialize.h>
 #include <sync.h>
 #include <uint256.h>
 
 #include <univalue.h>
 
+#include <algorithm>
+#include <array>
 #include <atomic>
 #include <memory>
+#include <unordered_map>
 
 class CConnman;
 template<typename T>
@@ -51,6 +55,7 @@ public:
         nLastDsq(ref.nLastDsq.load()),
         nMixingTxCount(ref.nMixingTxCount.load()),
         mapGovernanceObjectsVotedOn(ref.mapGovernanceObjectsVotedOn),
+        outboundAttemptCount(ref.outboundAttemptCount.load()),
         lastOutboundAttempt(ref.lastOutboundAttempt.load()),
         lastOutboundSuccess(ref.lastOutboundSuccess.load())
     {
@@ -89,6 +94,8 @@ public:
     int64_t GetLastOutboundAttempt() const { return lastOutboundAttempt; }
     void SetLastOutboundSuccess(int64_t t) { lastOutboundSuccess = t; outboundAttemptCount = 0; }
     int64_t GetLastOutboundSuccess() const { return lastOutboundSuccess; }
+
+    size_t DynamicMemoryUsage() const;
 };
 using CMasternodeMetaInfoPtr = std::shared_ptr<CMasternodeMetaInfo>;
 
@@ -96,19 +103,41 @@ class MasternodeMetaStore
 {
 protected:
     static const std::string SERIALIZATION_VERSION_STRING;
+    static constexpr size_t META_INFO_SHARDS{16};
+
+    // Meta infos are looked up for every DSQUEUE, mnauth and governance vote, spread them over
+    // independently locked shards so that these lookups don't serialize on a single lock
+    struct MetaInfoShard {
+        mutable Mutex cs;
+        std::unordered_map<uint256, CMasternodeMetaInfoPtr, StaticSaltedHasher> metaInfos GUARDED_BY(cs);
+    };
 
     mutable RecursiveMutex cs;
-    std::map<uint256, CMasternodeMetaInfoPtr> metaInfos GUARDED_BY(cs);
+    std::array<MetaInfoShard, META_INFO_SHARDS> shards;
     // keep track of dsq count to prevent masternodes from gaming coinjoin queue
     std::atomic<int64_t> nDsqCount{0};
 
+    // proTxHash is a txid, so any part of it is evenly distributed
+    MetaInfoShard& GetShard(const uint256& proTxHash)
+    {
+        return shards[proTxHash.GetUint64(3) % META_INFO_SHARDS];
+    }
+
 public:
     template<typename Stream>
     void Serialize(Stream &s) const
     {
         LOCK(cs);
+        std::vector<std::pair<uint256, CMasternodeMetaInfoPtr>> vecMetaInfos;
+        for (const auto& shard : shards) {
+            LOCK(shard.cs);
+            vecMetaInfos.insert(vecMetaInfos.end(), shard.metaInfos.begin(), shard.metaInfos.end());
+        }
+        // keep the file independent of the hash salt
+        std::sort(vecMetaInfos.begin(), vecMetaInfos.end(), [](const auto& a, const auto& b) { return a.first < b.first; });
         std::vector<CMasternodeMetaInfo> tmpMetaInfo;
-        for (const auto& p : metaInfos) {
+        tmpMetaInfo.reserve(vecMetaInfos.size());
+        for (const auto& p : vecMetaInfos) {
             tmpMetaInfo.emplace_back(*p.second);
         }
         s << SERIALIZATION_VERSION_STRING << tmpMetaInfo << nDsqCount;
@@ -127,9 +156,14 @@ public:
         }
         std::vector<CMasternodeMetaInfo> tmpMetaInfo;
         s >> tmpMetaInfo >> nDsqCount;
-        metaInfos.clear();
+        for (auto& shard : shards) {
+            LOCK(shard.cs);
+            shard.metaInfos.clear();
+        }
         for (auto& mm : tmpMetaInfo) {
-            metaInfos.emplace(mm.GetProTxHash(), std::make_shared<CMasternodeMetaInfo>(std::move(mm)));
+            auto& shard = GetShard(mm.GetProTxHash());
+            LOCK(shard.cs);
+            shard.metaInfos.emplace(mm.GetProTxHash(), std::make_shared<CMasternodeMetaInfo>(std::move(mm)));
         }
     }
 
@@ -137,7 +171,10 @@ public:
     {
         LOCK(cs);
 
-        metaInfos.clear();
+        for (auto& shard : shards) {
+            LOCK(shard.cs);
+            shard.metaInfos.clear();
+        }
     }
 
     std::string ToString() const;
@@ -172,6 +209,9 @@ public:
     void RemoveGovernanceObject(const uint256& nGovernanceObjectHash);
 
     std::vector<uint256> GetAndClearDirtyGovernanceObjectHashes();
+
+    /** Estimated memory used by the meta info of all known masternodes */
+    size_t DynamicMemoryUsage() const;
 };
 
 extern std::unique_ptr<CMasternodeMetaMan> mmetaman;
@@ -136,16 +136,28 @@ void CActiveMasternodeManager::Init(const CBlockIndex* pindex)
     state = MASTERNODE_READY;
 }
 
+void CActiveMasternodeManager::SynchronousUpdatedBlockTip(const CBlockIndex* pindexNew, const CBlockIndex* pindexFork, bool fInitialDownload)
+{
+    // Called in the same critical section in which UpdatedBlockTip is queued
+    m_latest_tip = pindexNew;
+}
+
 void CActiveMasternodeManager::UpdatedBlockTip(const CBlockIndex* pindexNew, const CBlockIndex* pindexFork, bool fInitialDownload)
 {
+    // A notification for a newer tip is queued already, only that one matters
+    if (const CBlockIndex* pindexLatest = m_latest_tip; pindexLatest && pindexNew != pindexLatest) return;
+
     LOCK2(cs_main, activeMasternodeInfoCs);
 
     if (!fMasternodeMode) return;
 
     if (!DeploymentDIP0003Enforced(pindexNew->nHeight, Params().GetConsensus())) return;
 
+    const CBlockIndex* pindexPrev = m_last_checked_tip ? m_last_checked_tip : pindexNew->pprev;
+    m_last_checked_tip = pindexNew;
+
     if (state == MASTERNODE_READY) {
-        auto oldMNList = deterministicMNManager->GetListForBlock(pindexNew->pprev);
+        auto oldMNList = deterministicMNManager->GetListForBlock(pindexPrev);
         auto newMNList = deterministicMNManager->GetListForBlock(pindexNew);
         if (!newMNList.IsMNValid(activeMasternodeInfo.proTxHash)) {
             // MN disappeared from MN list
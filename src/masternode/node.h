@@ -9,6 +9,8 @@
 #include <primitives/transaction.h>
 #include <validationinterface.h>
 
+#include <atomic>
+
 class CBLSPublicKey;
 class CBLSSecretKey;
 
@@ -50,10 +52,20 @@ private:
     std::string strError;
     CConnman& connman;
 
+    //! Tip of the most recently queued UpdatedBlockTip notification, notifications for older tips are skipped
+    std::atomic<const CBlockIndex*> m_latest_tip{nullptr};
+    //! Tip the masternode state was last checked against, changes are looked for between it and the new tip
+    const CBlockIndex* m_last_checked_tip GUARDED_BY(activeMasternodeInfoCs){nullptr};
+
 public:
     explicit CActiveMasternodeManager(CConnman& _connman) : connman(_connman) {};
     ~CActiveMasternodeManager() = default;
 
+    void SynchronousUpdatedBlockTip(const CBlockIndex* pindexNew, const CBlockIndex* pindexFork, bool fInitialDownload) override;
+    /**
+     * Runs on a validation interface queue of its own. During catch-up only the last of a burst of
+     * notifications does the work, the state is then compared against the tip it was last checked at.
+     */
     void UpdatedBlockTip(const CBlockIndex* pindexNew, const CBlockIndex* pindexFork, bool fInitialDownload) override;
 
     void Init(const CBlockIndex* pindex);
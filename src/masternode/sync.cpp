@@ -14,6 +14,9 @@
 #include <util/time.h>
 #include <util/translation.h>
 
+#include <algorithm>
+#include <limits>
+
 class CMasternodeSync;
 std::unique_ptr<CMasternodeSync> masternodeSync;
 
@@ -39,11 +42,20 @@ void CMasternodeSync::Reset(bool fForce, bool fNotifyReset)
     nTimeLastBumped = GetTime();
     nTimeLastUpdateBlockTip = 0;
     fReachedBestHeader = false;
+    ResetGovernanceSyncState();
     if (fNotifyReset) {
         uiInterface.NotifyAdditionalDataSyncProgressChanged(-1);
     }
 }
 
+void CMasternodeSync::ResetGovernanceSyncState()
+{
+    WITH_LOCK(cs_peers, mapPeerSync.clear());
+    nTimeNoObjectsLeft = 0;
+    nLastVotes = 0;
+    nTimeLastVotesSample = 0;
+}
+
 void CMasternodeSync::BumpAssetLastTime(const std::string& strFuncName)
 {
     if (IsSynced()) return;
@@ -80,6 +92,7 @@ void CMasternodeSync::SwitchToNextAsset()
                 netfulfilledman->AddFulfilledRequest(pnode->addr, "full-sync");
             });
             LogPrintf("CMasternodeSync::SwitchToNextAsset -- Sync has finished\n");
+            ResetGovernanceSyncState();
 
             break;
     }
@@ -98,7 +111,7 @@ std::string CMasternodeSync::GetSyncStatus() const
     }
 }
 
-void CMasternodeSync::ProcessMessage(const CNode& peer, std::string_view msg_type, CDataStream& vRecv) const
+void CMasternodeSync::ProcessMessage(const CNode& peer, std::string_view msg_type, CDataStream& vRecv)
 {
     //Sync status count
     if (msg_type != NetMsgType::SYNCSTATUSCOUNT) return;
@@ -111,6 +124,16 @@ void CMasternodeSync::ProcessMessage(const CNode& peer, std::string_view msg_typ
     vRecv >> nItemID >> nCount;
 
     LogPrint(BCLog::MNSYNC, "SYNCSTATUSCOUNT -- got inventory count: nItemID=%d  nCount=%d  peer=%d\n", nItemID, nCount, peer.GetId());
+
+    if (nItemID != MASTERNODE_SYNC_GOVOBJ) return;
+
+    // The object count concludes the peer's answer to our governance sync request,
+    // the round trip tells us how often we can ask it for votes.
+    LOCK(cs_peers);
+    auto it = mapPeerSync.find(peer.GetId());
+    if (it == mapPeerSync.end() || it->second.nLatency != -1) return;
+    it->second.nLatency = std::max<int64_t>(GetTimeMillis() - it->second.nTimeRequested, 0);
+    LogPrint(BCLog::MNSYNC, "SYNCSTATUSCOUNT -- governance sync answered in %dms, peer=%d\n", it->second.nLatency, peer.GetId());
 }
 
 void CMasternodeSync::ProcessTick()
@@ -130,7 +153,9 @@ void CMasternodeSync::ProcessTick()
         return;
     }
 
-    if(GetTime() - nTimeLastProcess < MASTERNODE_SYNC_TICK_SECONDS) {
+    // While syncing every call advances the state machine, so that finishing isn't held back
+    // by the tick length. Once synced, votes are only requested gradually.
+    if(IsSynced() && GetTime() - nTimeLastProcess < MASTERNODE_SYNC_TICK_SECONDS) {
         // too early, nothing to do here
         return;
     }
@@ -241,13 +266,23 @@ void CMasternodeSync::ProcessTick()
                     // to avoid deadlocks here
                     continue;
                 }
+
+                // Sync from several peers in parallel, but keep the number of unanswered requests
+                // bounded. Peers that don't answer within a tick don't hold their slot any longer.
+                {
+                    LOCK(cs_peers);
+                    const int64_t nNowMs = GetTimeMillis();
+                    const auto nPending = std::count_if(mapPeerSync.begin(), mapPeerSync.end(), [&](const auto& entry) {
+                        return entry.second.nLatency == -1 && nNowMs - entry.second.nTimeRequested < MASTERNODE_SYNC_TICK_SECONDS * 1000;
+                    });
+                    if (nPending >= MASTERNODE_SYNC_PARALLEL_PEERS) continue;
+                    mapPeerSync[pnode->GetId()].nTimeRequested = nNowMs;
+                }
                 netfulfilledman->AddFulfilledRequest(pnode->addr, "governance-sync");
 
                 nTriedPeerCount++;
 
                 SendGovernanceSyncRequest(pnode);
-
-                break; //this will cause each peer to get one request each six seconds for the various assets we need
             }
         }
     }
@@ -259,44 +294,73 @@ void CMasternodeSync::ProcessTick()
         return;
     }
 
-    // request votes on per-obj basis from each node
-    for (auto& pnode : vNodesCopy) {
-        if(!netfulfilledman->HasFulfilledRequest(pnode->addr, "governance-sync")) {
-            continue; // to early for this node
-        }
-        int nObjsLeftToAsk = m_govman.RequestGovernanceObjectVotes(*pnode, connman);
-        // check for data
-        if(nObjsLeftToAsk == 0) {
-            static int64_t nTimeNoObjectsLeft = 0;
-            static int nLastTick = 0;
-            static int nLastVotes = 0;
-            if(nTimeNoObjectsLeft == 0) {
-                // asked all objects for votes for the first time
-                nTimeNoObjectsLeft = GetTime();
+    ProcessGovernanceVotes(vNodesCopy, nTick);
+
+    // looped through all nodes, release them
+    connman.ReleaseNodeVector(vNodesCopy);
+}
+
+void CMasternodeSync::ProcessGovernanceVotes(const std::vector<CNode*>& vNodesCopy, int nTick)
+{
+    const int64_t nNowMs = GetTimeMillis();
+    const int64_t nTickMs = MASTERNODE_SYNC_TICK_SECONDS * 1000;
+
+    // Request votes on per-obj basis, fastest peers first. A peer that reported its
+    // round trip is asked again once that much time has passed, others once per tick.
+    std::vector<std::pair<int64_t, CNode*>> vPeers;
+    int64_t nMaxLatency{0};
+    bool fAllAnswered{true};
+    {
+        LOCK(cs_peers);
+        for (const auto& pnode : vNodesCopy) {
+            if(!netfulfilledman->HasFulfilledRequest(pnode->addr, "governance-sync")) {
+                continue; // to early for this node
             }
-            // make sure the condition below is checked only once per tick
-            if(nLastTick == nTick) continue;
-            if(GetTime() - nTimeNoObjectsLeft > MASTERNODE_SYNC_TIMEOUT_SECONDS &&
-                m_govman.GetVoteCount() - nLastVotes < std::max(int(0.0001 * nLastVotes), MASTERNODE_SYNC_TICK_SECONDS)
-            ) {
-                // We already asked for all objects, waited for MASTERNODE_SYNC_TIMEOUT_SECONDS
-                // after that and less then 0.01% or MASTERNODE_SYNC_TICK_SECONDS
-                // (i.e. 1 per second) votes were received during the last tick.
-                // We can be pretty sure that we are done syncing.
-                LogPrintf("CMasternodeSync::ProcessTick -- nTick %d nCurrentAsset %d -- asked for all objects, nothing to do\n", nTick, MASTERNODE_SYNC_GOVERNANCE);
-                // reset nTimeNoObjectsLeft to be able to use the same condition on resync
-                nTimeNoObjectsLeft = 0;
-                SwitchToNextAsset();
-                connman.ReleaseNodeVector(vNodesCopy);
-                return;
+            auto& state = mapPeerSync[pnode->GetId()];
+            if (state.nLatency == -1 && nNowMs - state.nTimeRequested < nTickMs) {
+                fAllAnswered = false;
             }
-            nLastTick = nTick;
-            nLastVotes = m_govman.GetVoteCount();
+            nMaxLatency = std::max(nMaxLatency, state.nLatency);
+            if (nNowMs < state.nTimeNextVoteRequest) continue;
+            state.nTimeNextVoteRequest = nNowMs + (state.nLatency == -1 ? nTickMs : std::clamp<int64_t>(state.nLatency, 1000, nTickMs));
+            vPeers.emplace_back(state.nLatency == -1 ? std::numeric_limits<int64_t>::max() : state.nLatency, pnode);
         }
     }
+    std::stable_sort(vPeers.begin(), vPeers.end(), [](const auto& a, const auto& b) { return a.first < b.first; });
 
-    // looped through all nodes, release them
-    connman.ReleaseNodeVector(vNodesCopy);
+    bool fNoObjectsLeft{false};
+    for (const auto& [_, pnode] : vPeers) {
+        int nObjsLeftToAsk = m_govman.RequestGovernanceObjectVotes(*pnode, connman);
+        // -2 means there are no objects at all, which is only conclusive once every peer answered
+        if (nObjsLeftToAsk == 0 || (nObjsLeftToAsk == -2 && fAllAnswered)) {
+            fNoObjectsLeft = true;
+        }
+    }
+
+    // check for data
+    if (fNoObjectsLeft && nTimeNoObjectsLeft == 0) {
+        // asked all objects for votes for the first time
+        nTimeNoObjectsLeft = nNowMs;
+        nLastVotes = m_govman.GetVoteCount();
+        nTimeLastVotesSample = nNowMs;
+    }
+    if (nTimeNoObjectsLeft == 0 || !fAllAnswered) return;
+
+    // Votes for the objects asked last need about a round trip to arrive, give them a few.
+    const int64_t nQuietMs = std::clamp<int64_t>(4 * nMaxLatency, 2000, MASTERNODE_SYNC_TIMEOUT_SECONDS * 1000);
+    if (nNowMs - nTimeLastVotesSample < nQuietMs) return;
+
+    const int nVotes = m_govman.GetVoteCount();
+    if (nVotes - nLastVotes < std::max(int(0.0001 * nLastVotes), int(nQuietMs / 1000))) {
+        // We already asked for all objects, every peer answered our sync request and
+        // less then 0.01% or 1 per second votes were received during the last window.
+        // We can be pretty sure that we are done syncing.
+        LogPrintf("CMasternodeSync::ProcessTick -- nTick %d nCurrentAsset %d -- asked for all objects, nothing to do\n", nTick, MASTERNODE_SYNC_GOVERNANCE);
+        SwitchToNextAsset();
+        return;
+    }
+    nLastVotes = nVotes;
+    nTimeLastVotesSample = nNowMs;
 }
 
 void CMasternodeSync::SendGovernanceSyncRequest(CNode* pnode) const
@@ -4,9 +4,13 @@
 #ifndef BITCOIN_MASTERNODE_SYNC_H
 #define BITCOIN_MASTERNODE_SYNC_H
 
+#include <sync.h>
+
 #include <atomic>
+#include <map>
 #include <memory>
 #include <string>
+#include <vector>
 
 class CMasternodeSync;
 class CBlockIndex;
@@ -24,6 +28,7 @@ static constexpr int MASTERNODE_SYNC_FINISHED        = 999;
 static constexpr int MASTERNODE_SYNC_TICK_SECONDS    = 6;
 static constexpr int MASTERNODE_SYNC_TIMEOUT_SECONDS = 30; // our blocks are 2.5 minutes so 30 seconds should be fine
 static constexpr int MASTERNODE_SYNC_RESET_SECONDS   = 900; // Reset fReachedBestHeader in CMasternodeSync::Reset if UpdateBlockTip hasn't been called for this seconds
+static constexpr int MASTERNODE_SYNC_PARALLEL_PEERS  = 3; // Max number of peers with an unanswered governance sync request
 
 extern std::unique_ptr<CMasternodeSync> masternodeSync;
 
@@ -49,6 +54,24 @@ private:
     /// Last time UpdateBlockTip has been called
     std::atomic<int64_t> nTimeLastUpdateBlockTip{0};
 
+    struct PeerSyncState {
+        /// When the governance sync request was sent (ms)
+        int64_t nTimeRequested{0};
+        /// Round trip until the peer reported its object count (ms), -1 while unanswered
+        int64_t nLatency{-1};
+        /// Earliest time the peer may be asked for the votes of another object (ms)
+        int64_t nTimeNextVoteRequest{0};
+    };
+    mutable Mutex cs_peers;
+    /// Governance sync state of the peers we've requested the asset from, keyed by NodeId
+    std::map<int64_t, PeerSyncState> mapPeerSync GUARDED_BY(cs_peers);
+
+    /// When all objects were asked for votes for the first time (ms), 0 if not yet
+    std::atomic<int64_t> nTimeNoObjectsLeft{0};
+    /// Vote count and time (ms) of the last sample used to detect that votes stopped coming in
+    std::atomic<int> nLastVotes{0};
+    std::atomic<int64_t> nTimeLastVotesSample{0};
+
     CConnman& connman;
     const CGovernanceManager& m_govman;
 
@@ -57,6 +80,12 @@ public:
 
     void SendGovernanceSyncRequest(CNode* pnode) const;
 
+private:
+    void ResetGovernanceSyncState() EXCLUSIVE_LOCKS_REQUIRED(!cs_peers);
+    void ProcessGovernanceVotes(const std::vector<CNode*>& vNodesCopy, int nTick) EXCLUSIVE_LOCKS_REQUIRED(!cs_peers);
+
+public:
+
     bool IsBlockchainSynced() const { return nCurrentAsset > MASTERNODE_SYNC_BLOCKCHAIN; }
     bool IsSynced() const { return nCurrentAsset == MASTERNODE_SYNC_FINISHED; }
 
@@ -67,11 +96,11 @@ public:
     std::string GetAssetName() const;
     std::string GetSyncStatus() const;
 
-    void Reset(bool fForce = false, bool fNotifyReset = true);
-    void SwitchToNextAsset();
+    void Reset(bool fForce = false, bool fNotifyReset = true) EXCLUSIVE_LOCKS_REQUIRED(!cs_peers);
+    void SwitchToNextAsset() EXCLUSIVE_LOCKS_REQUIRED(!cs_peers);
 
-    void ProcessMessage(const CNode& peer, std::string_view msg_type, CDataStream& vRecv) const;
-    void ProcessTick();
+    void ProcessMessage(const CNode& peer, std::string_view msg_type, CDataStream& vRecv) EXCLUSIVE_LOCKS_REQUIRED(!cs_peers);
+    void ProcessTick() EXCLUSIVE_LOCKS_REQUIRED(!cs_peers);
 
     void AcceptedBlockHeader(const CBlockIndex *pindexNew);
     void NotifyHeaderTip(const CBlockIndex *pindexNew, bool fInitialDownload);
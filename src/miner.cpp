@@ -25,6 +25,7 @@
 #include <evo/specialtx.h>
 #include <evo/cbtx.h>
 #include <evo/creditpool.h>
+#include <evo/deterministicmns.h>
 #include <evo/mnhftx.h>
 #include <evo/simplifiedmns.h>
 #include <governance/governance.h>
@@ -40,6 +41,63 @@
 #include <algorithm>
 #include <utility>
 
+namespace {
+/** The mempool transactions of the last template, which the next template on the same tip starts from */
+struct LastPackageSelection {
+    const CTxMemPool* mempool{nullptr};
+    uint256 hashPrevBlock;
+    unsigned int nBlockMaxSize{0};
+    CFeeRate blockMinFeeRate;
+    std::vector<uint256> txids;
+};
+Mutex g_last_selection_mutex;
+LastPackageSelection g_last_selection GUARDED_BY(g_last_selection_mutex);
+
+/**
+ * The CbTx payload parts of the last template. Each only depends on the parent block and the
+ * hash of the block's transactions it looks at, so templates on the same tip can reuse them.
+ */
+struct LastCbTxPayload {
+    uint256 hashPrevBlock;
+    std::optional<std::pair<uint256, uint256>> merkleRootMNList;
+    std::optional<std::pair<uint256, uint256>> merkleRootQuorums;
+    std::optional<std::pair<uint256, CAmount>> creditPoolBalance;
+    //! Best ChainLock known at the time -> bestCLHeightDiff, bestCLSignature and the result of CalcCbTxBestChainlock
+    std::optional<std::pair<uint256, std::tuple<uint32_t, CBLSSignature, bool>>> bestCL;
+};
+Mutex g_last_cbtx_mutex;
+LastCbTxPayload g_last_cbtx GUARDED_BY(g_last_cbtx_mutex);
+
+/** Hash the txids of the non-coinbase transactions of block for which fn returns true */
+template <typename F>
+uint256 HashBlockTxs(const CBlock& block, F fn)
+{
+    CHashWriter hw(SER_GETHASH, 0);
+    for (size_t i = 1; i < block.vtx.size(); ++i) {
+        if (fn(*block.vtx[i])) hw << block.vtx[i]->GetHash();
+    }
+    return hw.GetHash();
+}
+
+/** Hash the transactions of block that can change the masternode list */
+uint256 HashMNListTxs(const CBlock& block, const CBlockIndex* pindexPrev)
+{
+    const bool fRegister = std::any_of(block.vtx.begin() + 1, block.vtx.end(), [](const CTransactionRef& tx) {
+        return tx->nVersion == 3 && tx->nType == TRANSACTION_PROVIDER_REGISTER;
+    });
+    if (fRegister) {
+        // A registration's collateral may be spent by any other transaction
+        return HashBlockTxs(block, [](const CTransaction&) { return true; });
+    }
+    const CDeterministicMNList mnList = deterministicMNManager->GetListForBlock(pindexPrev);
+    return HashBlockTxs(block, [&mnList](const CTransaction& tx) {
+        return tx.nVersion == 3 || std::any_of(tx.vin.begin(), tx.vin.end(), [&mnList](const CTxIn& in) {
+            return mnList.HasMNByCollateral(in.prevout);
+        });
+    });
+}
+} // namespace
+
 int64_t UpdateTime(CBlockHeader* pblock, const Consensus::Params& consensusParams, const CBlockIndex* pindexPrev)
 {
     int64_t nOldTime = pblock->nTime;
@@ -181,7 +239,42 @@ std::unique_ptr<CBlockTemplate> BlockAssembler::CreateNewBlock(const CScript& sc
     int nPackagesSelected = 0;
     int nDescendantsUpdated = 0;
 
-    addPackageTxs(nPackagesSelected, nDescendantsUpdated, pindexPrev);
+    // Templates are requested over and over for the same tip. Transactions rarely leave the
+    // mempool without a new block, so start from the previous selection and only look for
+    // packages among the transactions that are new since. If the result could differ from
+    // a selection from scratch (e.g. once the block is full) select from scratch instead.
+    std::vector<uint256> vPrevious;
+    {
+        LOCK(g_last_selection_mutex);
+        if (g_last_selection.mempool == &m_mempool && g_last_selection.hashPrevBlock == pindexPrev->GetBlockHash() &&
+            g_last_selection.nBlockMaxSize == nBlockMaxSize && g_last_selection.blockMinFeeRate == blockMinFeeRate) {
+            vPrevious = g_last_selection.txids;
+        }
+    }
+    const size_t nFirstPackageTx = pblock->vtx.size();
+    bool fReused = false;
+    if (!vPrevious.empty()) {
+        const uint64_t nBlockSizeBefore = nBlockSize;
+        const unsigned int nBlockSigOpsBefore = nBlockSigOps;
+        const uint64_t nBlockTxBefore = nBlockTx;
+        const CAmount nFeesBefore = nFees;
+        fReused = addPackageTxs(nPackagesSelected, nDescendantsUpdated, pindexPrev, &vPrevious);
+        if (!fReused) {
+            pblock->vtx.resize(nFirstPackageTx);
+            pblocktemplate->vTxFees.resize(nFirstPackageTx);
+            pblocktemplate->vTxSigOps.resize(nFirstPackageTx);
+            inBlock.clear();
+            nBlockSize = nBlockSizeBefore;
+            nBlockSigOps = nBlockSigOpsBefore;
+            nBlockTx = nBlockTxBefore;
+            nFees = nFeesBefore;
+            nPackagesSelected = 0;
+            nDescendantsUpdated = 0;
+        }
+    }
+    if (!fReused) {
+        addPackageTxs(nPackagesSelected, nDescendantsUpdated, pindexPrev, nullptr);
+    }
 
     int64_t nTime1 = GetTimeMicros();
 
@@ -223,28 +316,67 @@ std::unique_ptr<CBlockTemplate> BlockAssembler::CreateNewBlock(const CScript& sc
 
         cbTx.nHeight = nHeight;
 
+        LOCK(g_last_cbtx_mutex);
+        if (g_last_cbtx.hashPrevBlock != pindexPrev->GetBlockHash()) {
+            g_last_cbtx = LastCbTxPayload{};
+            g_last_cbtx.hashPrevBlock = pindexPrev->GetBlockHash();
+        }
+
         BlockValidationState state;
-        if (!CalcCbTxMerkleRootMNList(*pblock, pindexPrev, cbTx.merkleRootMNList, state, ::ChainstateActive().CoinsTip())) {
-            throw std::runtime_error(strprintf("%s: CalcCbTxMerkleRootMNList failed: %s", __func__, state.ToString()));
+        const uint256 hashMNListTxs = HashMNListTxs(*pblock, pindexPrev);
+        if (g_last_cbtx.merkleRootMNList && g_last_cbtx.merkleRootMNList->first == hashMNListTxs) {
+            cbTx.merkleRootMNList = g_last_cbtx.merkleRootMNList->second;
+        } else {
+            if (!CalcCbTxMerkleRootMNList(*pblock, pindexPrev, cbTx.merkleRootMNList, state, ::ChainstateActive().CoinsTip())) {
+                throw std::runtime_error(strprintf("%s: CalcCbTxMerkleRootMNList failed: %s", __func__, state.ToString()));
+            }
+            g_last_cbtx.merkleRootMNList = std::make_pair(hashMNListTxs, cbTx.merkleRootMNList);
         }
         if (fDIP0008Active_context) {
-            if (!CalcCbTxMerkleRootQuorums(*pblock, pindexPrev, quorum_block_processor, cbTx.merkleRootQuorums, state)) {
-                throw std::runtime_error(strprintf("%s: CalcCbTxMerkleRootQuorums failed: %s", __func__, state.ToString()));
+            const uint256 hashQuorumTxs = HashBlockTxs(*pblock, [](const CTransaction& tx) {
+                return tx.nVersion == 3 && tx.nType == TRANSACTION_QUORUM_COMMITMENT;
+            });
+            if (g_last_cbtx.merkleRootQuorums && g_last_cbtx.merkleRootQuorums->first == hashQuorumTxs) {
+                cbTx.merkleRootQuorums = g_last_cbtx.merkleRootQuorums->second;
+            } else {
+                if (!CalcCbTxMerkleRootQuorums(*pblock, pindexPrev, quorum_block_processor, cbTx.merkleRootQuorums, state)) {
+                    throw std::runtime_error(strprintf("%s: CalcCbTxMerkleRootQuorums failed: %s", __func__, state.ToString()));
+                }
+                g_last_cbtx.merkleRootQuorums = std::make_pair(hashQuorumTxs, cbTx.merkleRootQuorums);
             }
             if (fV20Active_context) {
-                if (CalcCbTxBestChainlock(m_clhandler, pindexPrev, cbTx.bestCLHeightDiff, cbTx.bestCLSignature)) {
+                const llmq::CChainLockSig best_clsig = m_clhandler.GetBestChainLock();
+                const uint256 hashBestCL = (CHashWriter(SER_GETHASH, 0) << best_clsig.getHeight() << best_clsig.getBlockHash() << best_clsig.getSig()).GetHash();
+                if (!g_last_cbtx.bestCL || g_last_cbtx.bestCL->first != hashBestCL) {
+                    uint32_t bestCLHeightDiff;
+                    CBLSSignature bestCLSignature;
+                    const bool fFound = CalcCbTxBestChainlock(m_clhandler, pindexPrev, bestCLHeightDiff, bestCLSignature);
+                    g_last_cbtx.bestCL = std::make_pair(hashBestCL, std::make_tuple(bestCLHeightDiff, bestCLSignature, fFound));
+                }
+                const auto& [bestCLHeightDiff, bestCLSignature, fFound] = g_last_cbtx.bestCL->second;
+                cbTx.bestCLHeightDiff = bestCLHeightDiff;
+                cbTx.bestCLSignature = bestCLSignature;
+                if (fFound) {
                     LogPrintf("CreateNewBlock() h[%d] CbTx bestCLHeightDiff[%d] CLSig[%s]\n", nHeight, cbTx.bestCLHeightDiff, cbTx.bestCLSignature.ToString());
                 } else {
                     // not an error
                     LogPrintf("CreateNewBlock() h[%d] CbTx failed to find best CL. Inserting null CL\n", nHeight);
                 }
-                BlockValidationState state;
-                const auto creditPoolDiff = GetCreditPoolDiffForBlock(*pblock, pindexPrev, chainparams.GetConsensus(), blockSubsidy, state);
-                if (creditPoolDiff == std::nullopt) {
-                    throw std::runtime_error(strprintf("%s: GetCreditPoolDiffForBlock failed: %s", __func__, state.ToString()));
+                const uint256 hashCreditPoolTxs = HashBlockTxs(*pblock, [](const CTransaction& tx) {
+                    return tx.nVersion == 3 && (tx.nType == TRANSACTION_ASSET_LOCK || tx.nType == TRANSACTION_ASSET_UNLOCK);
+                });
+                if (g_last_cbtx.creditPoolBalance && g_last_cbtx.creditPoolBalance->first == hashCreditPoolTxs) {
+                    cbTx.creditPoolBalance = g_last_cbtx.creditPoolBalance->second;
+                } else {
+                    BlockValidationState state;
+                    const auto creditPoolDiff = GetCreditPoolDiffForBlock(*pblock, pindexPrev, chainparams.GetConsensus(), blockSubsidy, state);
+                    if (creditPoolDiff == std::nullopt) {
+                        throw std::runtime_error(strprintf("%s: GetCreditPoolDiffForBlock failed: %s", __func__, state.ToString()));
+                    }
+
+                    cbTx.creditPoolBalance = creditPoolDiff->GetTotalLocked();
+                    g_last_cbtx.creditPoolBalance = std::make_pair(hashCreditPoolTxs, cbTx.creditPoolBalance);
                 }
-
-                cbTx.creditPoolBalance = creditPoolDiff->GetTotalLocked();
             }
         }
 
@@ -276,7 +408,19 @@ std::unique_ptr<CBlockTemplate> BlockAssembler::CreateNewBlock(const CScript& sc
     }
     int64_t nTime2 = GetTimeMicros();
 
-    LogPrint(BCLog::BENCHMARK, "CreateNewBlock() packages: %.2fms (%d packages, %d updated descendants), validity: %.2fms (total %.2fms)\n", 0.001 * (nTime1 - nTimeStart), nPackagesSelected, nDescendantsUpdated, 0.001 * (nTime2 - nTime1), 0.001 * (nTime2 - nTimeStart));
+    {
+        LOCK(g_last_selection_mutex);
+        g_last_selection.mempool = &m_mempool;
+        g_last_selection.hashPrevBlock = pindexPrev->GetBlockHash();
+        g_last_selection.nBlockMaxSize = nBlockMaxSize;
+        g_last_selection.blockMinFeeRate = blockMinFeeRate;
+        g_last_selection.txids.clear();
+        for (size_t i = nFirstPackageTx; i < pblock->vtx.size(); ++i) {
+            g_last_selection.txids.push_back(pblock->vtx[i]->GetHash());
+        }
+    }
+
+    LogPrint(BCLog::BENCHMARK, "CreateNewBlock() packages: %.2fms (%d packages, %d updated descendants%s), validity: %.2fms (total %.2fms)\n", 0.001 * (nTime1 - nTimeStart), nPackagesSelected, nDescendantsUpdated, fReused ? strprintf(", %u txs reused", vPrevious.size()) : "", 0.001 * (nTime2 - nTime1), 0.001 * (nTime2 - nTimeStart));
 
     return std::move(pblocktemplate);
 }
@@ -348,7 +492,7 @@ int BlockAssembler::UpdatePackagesForAdded(const CTxMemPool::setEntries& already
 
     int nDescendantsUpdated = 0;
     for (CTxMemPool::txiter it : alreadyAdded) {
-        CTxMemPool::setEntries descendants;
+        CTxMemPool::vecEntries descendants;
         m_mempool.CalculateDescendants(it, descendants);
         // Insert all descendants (not yet in block) into the modified set
         for (CTxMemPool::txiter desc : descendants) {
@@ -408,14 +552,15 @@ void BlockAssembler::SortForBlock(const CTxMemPool::setEntries& package, std::ve
 // Each time through the loop, we compare the best transaction in
 // mapModifiedTxs with the next transaction in the mempool to decide what
 // transaction package to work on next.
-void BlockAssembler::addPackageTxs(int &nPackagesSelected, int &nDescendantsUpdated, const CBlockIndex* const pindexPrev)
+bool BlockAssembler::addPackageTxs(int &nPackagesSelected, int &nDescendantsUpdated, const CBlockIndex* const pindexPrev, const std::vector<uint256>* const previous)
 {
     AssertLockHeld(m_mempool.cs);
 
     // This credit pool is used only to check withdrawal limits and to find
-    // duplicates of indexes. There's used `BlockSubsidy` equaled to 0
+    // duplicates of indexes. There's used `BlockSubsidy` equaled to 0.
+    // Nothing has to be checked if the mempool has no asset lock/unlock txs at all.
     std::optional<CCreditPoolDiff> creditPoolDiff;
-    if (DeploymentActiveAfter(pindexPrev, chainparams.GetConsensus(), Consensus::DEPLOYMENT_V20)) {
+    if (m_mempool.hasAssetLockUnlockTxs() && DeploymentActiveAfter(pindexPrev, chainparams.GetConsensus(), Consensus::DEPLOYMENT_V20)) {
         CCreditPool creditPool = creditPoolManager->GetCreditPool(pindexPrev, chainparams.GetConsensus());
         creditPoolDiff.emplace(std::move(creditPool), pindexPrev, chainparams.GetConsensus(), 0);
     }
@@ -429,6 +574,30 @@ void BlockAssembler::addPackageTxs(int &nPackagesSelected, int &nDescendantsUpda
     // Keep track of entries that failed inclusion, to avoid duplicate work
     CTxMemPool::setEntries failedTx;
 
+    // Whether a package was left out for a reason that depends on the order packages are considered in
+    bool fOrderDependent = false;
+
+    if (previous) {
+        // The previous transactions are in a valid block order already, and any of them leaving
+        // the mempool takes its descendants with it.
+        for (const uint256& txid : *previous) {
+            const auto it = m_mempool.GetIter(txid);
+            if (!it || (*it)->GetModifiedFee() < (*it)->GetFee() ||
+                !TestPackage((*it)->GetTxSize(), (*it)->GetSigOpCount()) || !TestPackageTransactions({*it})) {
+                return false;
+            }
+            if (creditPoolDiff != std::nullopt) {
+                TxValidationState state;
+                if (!creditPoolDiff->ProcessLockUnlockTransaction((*it)->GetTx(), state)) return false;
+            }
+            if (std::optional<uint8_t> signal = extractEHFSignal((*it)->GetTx()); signal != std::nullopt) {
+                if (!signals.emplace(*signal, 0).second) return false;
+            }
+            AddToBlock(*it);
+        }
+        nDescendantsUpdated += UpdatePackagesForAdded(inBlock, mapModifiedTx);
+    }
+
     CTxMemPool::indexed_transaction_set::index<ancestor_score>::type::iterator mi = m_mempool.mapTx.get<ancestor_score>().begin();
     CTxMemPool::txiter iter;
 
@@ -485,6 +654,7 @@ void BlockAssembler::addPackageTxs(int &nPackagesSelected, int &nDescendantsUpda
                 }
                 LogPrintf("%s: asset-locks tx %s skipped due %s\n",
                           __func__, iter->GetTx().GetHash().ToString(), state.ToString());
+                fOrderDependent = true;
                 continue;
             }
         }
@@ -496,6 +666,7 @@ void BlockAssembler::addPackageTxs(int &nPackagesSelected, int &nDescendantsUpda
                 }
                 LogPrintf("%s: ehf signal tx %s skipped due to duplicate %d\n",
                           __func__, iter->GetTx().GetHash().ToString(), *signal);
+                fOrderDependent = true;
                 continue;
             }
             signals.insert({*signal, 0});
@@ -516,10 +687,11 @@ void BlockAssembler::addPackageTxs(int &nPackagesSelected, int &nDescendantsUpda
 
         if (packageFees < blockMinFeeRate.GetFee(packageSize)) {
             // Everything else we might consider has a lower fee rate
-            return;
+            return !fOrderDependent;
         }
 
         if (!TestPackage(packageSize, packageSigOps)) {
+            fOrderDependent = true;
             if (fUsingModified) {
                 // Since we always look at the best entry in mapModifiedTx,
                 // we must erase failed entries so that we can consider the
@@ -572,6 +744,7 @@ void BlockAssembler::addPackageTxs(int &nPackagesSelected, int &nDescendantsUpda
         // Update transactions that depend on each of these
         nDescendantsUpdated += UpdatePackagesForAdded(ancestors, mapModifiedTx);
     }
+    return !fOrderDependent;
 }
 
 void IncrementExtraNonce(CBlock* pblock, const CBlockIndex* pindexPrev, unsigned int& nExtraNonce)
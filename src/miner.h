@@ -193,9 +193,14 @@ private:
     // Methods for how to add transactions to a block.
     /** Add transactions based on feerate including unconfirmed ancestors
       * Increments nPackagesSelected / nDescendantsUpdated with corresponding
-      * statistics from the package selection (for logging statistics). */
-    void addPackageTxs(int& nPackagesSelected, int& nDescendantsUpdated,
-                       const CBlockIndex* pindexPrev) EXCLUSIVE_LOCKS_REQUIRED(m_mempool.cs);
+      * statistics from the package selection (for logging statistics).
+      * With previous, the transactions of the previous template are added first and
+      * only the remaining mempool is searched for packages. Returns false if that
+      * could give another block than a selection from scratch, i.e. if a previous
+      * transaction can't be added anymore or a package had to be left out for a
+      * reason that depends on the order packages are considered in. */
+    bool addPackageTxs(int& nPackagesSelected, int& nDescendantsUpdated,
+                       const CBlockIndex* pindexPrev, const std::vector<uint256>* previous) EXCLUSIVE_LOCKS_REQUIRED(m_mempool.cs);
 
     // helper functions for addPackageTxs()
     /** Remove confirmed (inBlock) entries from given set */
@@ -28,8 +28,10 @@
 #include <util/strencodings.h>
 #include <util/thread.h>
 #include <util/time.h>
+#include <util/trace.h>
 #include <util/translation.h>
 #include <validation.h> // for fDIP0001ActiveAtTip
+#include <version.h>
 
 #include <masternode/meta.h>
 #include <masternode/sync.h>
@@ -42,6 +44,7 @@
 #include <string.h>
 #else
 #include <fcntl.h>
+#include <sys/uio.h>
 #endif
 
 #if HAVE_DECL_GETIFADDRS && HAVE_DECL_FREEIFADDRS
@@ -63,6 +66,7 @@
 #include <algorithm>
 #include <cstdint>
 #include <functional>
+#include <iterator>
 #include <unordered_map>
 
 #include <math.h>
@@ -98,6 +102,11 @@ static constexpr std::chrono::seconds MAX_UPLOAD_TIMEFRAME{60 * 60 * 24};
 // A random time period (0 to 1 seconds) is added to feeler connections to prevent synchronization.
 static constexpr auto FEELER_SLEEP_WINDOW{1s};
 
+/** Maximum number of send buffers handed to a single sendmsg() call */
+static constexpr size_t MAX_SEND_IOVECS = 64;
+/** Messages are appended to the last queued send buffer as long as it stays below this size */
+static constexpr size_t MAX_SEND_COALESCE_SIZE = 16 * 1024;
+
 /** Used to pass flags to the Bind() function */
 enum BindFlags {
     BF_NONE         = 0,
@@ -553,12 +562,13 @@ void CNode::CloseSocketDisconnect(CConnman* connman)
     fHasRecvData = false;
     fCanSendData = false;
 
-    connman->mapSocketToNode.erase(hSocket);
-    connman->mapReceivableNodes.erase(GetId());
-    connman->mapSendableNodes.erase(GetId());
     {
-        LOCK(connman->cs_mapNodesWithDataToSend);
-        if (connman->mapNodesWithDataToSend.erase(GetId()) != 0) {
+        auto& shard = connman->GetSocketShard(this);
+        LOCK(shard.cs);
+        shard.mapSocketToNode.erase(hSocket);
+        shard.mapReceivableNodes.erase(GetId());
+        shard.mapSendableNodes.erase(GetId());
+        if (shard.mapNodesWithDataToSend.erase(GetId()) != 0) {
             // See comment in PushMessage
             Release();
         }
@@ -760,6 +770,39 @@ bool CNode::ReceiveMsgBytes(Span<const uint8_t> msg_bytes, bool& complete)
     return true;
 }
 
+CDataStream CNetMessageBufferPool::Get(int nTypeIn, int nVersionIn)
+{
+    LOCK(cs);
+    if (vBuffers.empty()) {
+        return CDataStream(nTypeIn, nVersionIn);
+    }
+    CDataStream stream(std::move(vBuffers.back()));
+    vBuffers.pop_back();
+    stream.SetType(nTypeIn);
+    stream.SetVersion(nVersionIn);
+    return stream;
+}
+
+void CNetMessageBufferPool::Return(CDataStream&& stream, size_t nSize)
+{
+    if (nSize > MAX_BUFFER_SIZE) {
+        return;
+    }
+    // keeps the capacity of the buffer
+    stream.clear();
+    LOCK(cs);
+    if (vBuffers.size() < MAX_BUFFERS) {
+        vBuffers.push_back(std::move(stream));
+    }
+}
+
+CNetMessage::~CNetMessage()
+{
+    if (m_pool) {
+        m_pool->Return(std::move(m_recv), m_message_size);
+    }
+}
+
 int V1TransportDeserializer::readHeader(Span<const uint8_t> msg_bytes)
 {
     // copy data to temporary parsing buffer
@@ -827,8 +870,10 @@ const uint256& V1TransportDeserializer::GetMessageHash() const
 
 std::optional<CNetMessage> V1TransportDeserializer::GetMessage(int64_t time, uint32_t& out_err_raw_size)
 {
-    // decompose a single CNetMessage from the TransportDeserializer
+    // decompose a single CNetMessage from the TransportDeserializer, the next message is parsed into a pooled buffer
     std::optional<CNetMessage> msg(std::move(vRecv));
+    vRecv = m_pool->Get(msg->m_recv.GetType(), msg->m_recv.GetVersion());
+    msg->m_pool = m_pool;
 
     // store command string, time, and sizes
     msg->m_command = hdr.GetCommand();
@@ -881,27 +926,52 @@ size_t CConnman::SocketSendData(CNode *pnode) EXCLUSIVE_LOCKS_REQUIRED(pnode->cs
     size_t nSentSize = 0;
 
     while (it != pnode->vSendMsg.end()) {
-        const auto &data = *it;
-        assert(data.size() > pnode->nSendOffset);
+        assert(it->size() > pnode->nSendOffset);
         int nBytes = 0;
+        size_t nBytesTried = 0;
         {
             LOCK(pnode->cs_hSocket);
             if (pnode->hSocket == INVALID_SOCKET)
                 break;
-            nBytes = send(pnode->hSocket, reinterpret_cast<const char*>(data.data()) + pnode->nSendOffset, data.size() - pnode->nSendOffset, MSG_NOSIGNAL | MSG_DONTWAIT);
+#ifdef WIN32
+            nBytesTried = it->size() - pnode->nSendOffset;
+            nBytes = send(pnode->hSocket, reinterpret_cast<const char*>(it->data()) + pnode->nSendOffset, nBytesTried, MSG_NOSIGNAL | MSG_DONTWAIT);
+#else
+            // hand as many queued buffers as possible to the kernel in a single call
+            struct iovec iov[MAX_SEND_IOVECS];
+            size_t nIov = 0;
+            for (auto jt = it; jt != pnode->vSendMsg.end() && nIov < MAX_SEND_IOVECS; ++jt, ++nIov) {
+                const size_t nOffset = nIov == 0 ? pnode->nSendOffset : 0;
+                iov[nIov].iov_base = jt->data() + nOffset;
+                iov[nIov].iov_len = jt->size() - nOffset;
+                nBytesTried += iov[nIov].iov_len;
+            }
+            struct msghdr msg{};
+            msg.msg_iov = iov;
+            msg.msg_iovlen = nIov;
+            nBytes = sendmsg(pnode->hSocket, &msg, MSG_NOSIGNAL | MSG_DONTWAIT);
+#endif
         }
         if (nBytes > 0) {
             pnode->nLastSend = GetSystemTimeInSeconds();
             pnode->nSendBytes += nBytes;
-            pnode->nSendOffset += nBytes;
             nSentSize += nBytes;
-            if (pnode->nSendOffset == data.size()) {
+            // drop the buffers that were sent completely, remember how far we got into the next one
+            size_t nBytesLeft = nBytes;
+            while (nBytesLeft > 0) {
+                const size_t nRemaining = it->size() - pnode->nSendOffset;
+                if (nBytesLeft < nRemaining) {
+                    pnode->nSendOffset += nBytesLeft;
+                    break;
+                }
+                nBytesLeft -= nRemaining;
                 pnode->nSendOffset = 0;
-                pnode->nSendSize -= data.size();
-                pnode->fPauseSend = pnode->nSendSize > nSendBufferMaxSize;
+                pnode->nSendSize -= it->size();
                 it++;
-            } else {
-                // could not send full message; stop sending more
+            }
+            pnode->fPauseSend = pnode->nSendSize > nSendBufferMaxSize;
+            if ((size_t)nBytes < nBytesTried) {
+                // could not send everything; stop sending more
                 pnode->fCanSendData = false;
                 break;
             }
@@ -1286,9 +1356,9 @@ void CConnman::CreateNodeFromAcceptedSocket(SOCKET hSocket,
     {
         LOCK(cs_vNodes);
         vNodes.push_back(pnode);
-        mapSocketToNode.emplace(hSocket, pnode);
+        AddToSocketShard(pnode);
         RegisterEvents(pnode);
-        WakeSelect();
+        WakeSelect(pnode);
     }
 
     // We received a new connection, harvest entropy from the time (and our peer count)
@@ -1530,8 +1600,11 @@ bool CConnman::InactivityCheck(const CNode& node) const
     return false;
 }
 
-bool CConnman::GenerateSelectSet(std::set<SOCKET> &recv_set, std::set<SOCKET> &send_set, std::set<SOCKET> &error_set)
+bool CConnman::GenerateSelectSet(SocketEventsShard& shard, std::set<SOCKET> &recv_set, std::set<SOCKET> &send_set, std::set<SOCKET> &error_set)
 {
+    // select() and poll() always service every socket from a single shard
+    assert(&shard == m_socket_shards.front().get());
+
     for (const ListenSocket& hListenSocket : vhListenSocket) {
         recv_set.insert(hListenSocket.socket);
     }
@@ -1563,14 +1636,14 @@ bool CConnman::GenerateSelectSet(std::set<SOCKET> &recv_set, std::set<SOCKET> &s
     // This is currently only implemented for POSIX compliant systems. This means that Windows will fall back to
     // timing out after 50ms and then trying to send. This is ok as we assume that heavy-load daemons are usually
     // run on Linux and friends.
-    recv_set.insert(wakeupPipe[0]);
+    recv_set.insert(shard.wakeupPipe[0]);
 #endif
 
     return !recv_set.empty() || !send_set.empty() || !error_set.empty();
 }
 
 #ifdef USE_KQUEUE
-void CConnman::SocketEventsKqueue(std::set<SOCKET> &recv_set, std::set<SOCKET> &send_set, std::set<SOCKET> &error_set, bool fOnlyPoll)
+void CConnman::SocketEventsKqueue(SocketEventsShard& shard, std::set<SOCKET> &recv_set, std::set<SOCKET> &send_set, std::set<SOCKET> &error_set, bool fOnlyPoll)
 {
     const size_t maxEvents = 64;
     struct kevent events[maxEvents];
@@ -1579,9 +1652,9 @@ void CConnman::SocketEventsKqueue(std::set<SOCKET> &recv_set, std::set<SOCKET> &
     timeout.tv_sec = fOnlyPoll ? 0 : SELECT_TIMEOUT_MILLISECONDS / 1000;
     timeout.tv_nsec = (fOnlyPoll ? 0 : SELECT_TIMEOUT_MILLISECONDS % 1000) * 1000 * 1000;
 
-    wakeupSelectNeeded = true;
-    int n = kevent(kqueuefd, nullptr, 0, events, maxEvents, &timeout);
-    wakeupSelectNeeded = false;
+    shard.wakeupSelectNeeded = true;
+    int n = kevent(shard.kqueuefd, nullptr, 0, events, maxEvents, &timeout);
+    shard.wakeupSelectNeeded = false;
     if (n == -1) {
         LogPrintf("kevent wait error\n");
     } else if (n > 0) {
@@ -1605,14 +1678,14 @@ void CConnman::SocketEventsKqueue(std::set<SOCKET> &recv_set, std::set<SOCKET> &
 #endif
 
 #ifdef USE_EPOLL
-void CConnman::SocketEventsEpoll(std::set<SOCKET> &recv_set, std::set<SOCKET> &send_set, std::set<SOCKET> &error_set, bool fOnlyPoll)
+void CConnman::SocketEventsEpoll(SocketEventsShard& shard, std::set<SOCKET> &recv_set, std::set<SOCKET> &send_set, std::set<SOCKET> &error_set, bool fOnlyPoll)
 {
     const size_t maxEvents = 64;
     epoll_event events[maxEvents];
 
-    wakeupSelectNeeded = true;
-    int n = epoll_wait(epollfd, events, maxEvents, fOnlyPoll ? 0 : SELECT_TIMEOUT_MILLISECONDS);
-    wakeupSelectNeeded = false;
+    shard.wakeupSelectNeeded = true;
+    int n = epoll_wait(shard.epollfd, events, maxEvents, fOnlyPoll ? 0 : SELECT_TIMEOUT_MILLISECONDS);
+    shard.wakeupSelectNeeded = false;
     for (int i = 0; i < n; i++) {
         auto& e = events[i];
         if((e.events & EPOLLERR) || (e.events & EPOLLHUP)) {
@@ -1632,10 +1705,10 @@ void CConnman::SocketEventsEpoll(std::set<SOCKET> &recv_set, std::set<SOCKET> &s
 #endif
 
 #ifdef USE_POLL
-void CConnman::SocketEventsPoll(std::set<SOCKET> &recv_set, std::set<SOCKET> &send_set, std::set<SOCKET> &error_set, bool fOnlyPoll)
+void CConnman::SocketEventsPoll(SocketEventsShard& shard, std::set<SOCKET> &recv_set, std::set<SOCKET> &send_set, std::set<SOCKET> &error_set, bool fOnlyPoll)
 {
     std::set<SOCKET> recv_select_set, send_select_set, error_select_set;
-    if (!GenerateSelectSet(recv_select_set, send_select_set, error_select_set)) {
+    if (!GenerateSelectSet(shard, recv_select_set, send_select_set, error_select_set)) {
         if (!fOnlyPoll) interruptNet.sleep_for(std::chrono::milliseconds(SELECT_TIMEOUT_MILLISECONDS));
         return;
     }
@@ -1663,9 +1736,9 @@ void CConnman::SocketEventsPoll(std::set<SOCKET> &recv_set, std::set<SOCKET> &se
         vpollfds.push_back(std::move(it.second));
     }
 
-    wakeupSelectNeeded = true;
+    shard.wakeupSelectNeeded = true;
     int r = poll(vpollfds.data(), vpollfds.size(), fOnlyPoll ? 0 : SELECT_TIMEOUT_MILLISECONDS);
-    wakeupSelectNeeded = false;
+    shard.wakeupSelectNeeded = false;
     if (r < 0) {
         return;
     }
@@ -1680,10 +1753,10 @@ void CConnman::SocketEventsPoll(std::set<SOCKET> &recv_set, std::set<SOCKET> &se
 }
 #endif
 
-void CConnman::SocketEventsSelect(std::set<SOCKET> &recv_set, std::set<SOCKET> &send_set, std::set<SOCKET> &error_set, bool fOnlyPoll)
+void CConnman::SocketEventsSelect(SocketEventsShard& shard, std::set<SOCKET> &recv_set, std::set<SOCKET> &send_set, std::set<SOCKET> &error_set, bool fOnlyPoll)
 {
     std::set<SOCKET> recv_select_set, send_select_set, error_select_set;
-    if (!GenerateSelectSet(recv_select_set, send_select_set, error_select_set)) {
+    if (!GenerateSelectSet(shard, recv_select_set, send_select_set, error_select_set)) {
         interruptNet.sleep_for(std::chrono::milliseconds(SELECT_TIMEOUT_MILLISECONDS));
         return;
     }
@@ -1718,9 +1791,9 @@ void CConnman::SocketEventsSelect(std::set<SOCKET> &recv_set, std::set<SOCKET> &
         hSocketMax = std::max(hSocketMax, hSocket);
     }
 
-    wakeupSelectNeeded = true;
+    shard.wakeupSelectNeeded = true;
     int nSelect = select(hSocketMax + 1, &fdsetRecv, &fdsetSend, &fdsetError, &timeout);
-    wakeupSelectNeeded = false;
+    shard.wakeupSelectNeeded = false;
     if (interruptNet)
         return;
 
@@ -1755,45 +1828,45 @@ void CConnman::SocketEventsSelect(std::set<SOCKET> &recv_set, std::set<SOCKET> &
     }
 }
 
-void CConnman::SocketEvents(std::set<SOCKET> &recv_set, std::set<SOCKET> &send_set, std::set<SOCKET> &error_set, bool fOnlyPoll)
+void CConnman::SocketEvents(SocketEventsShard& shard, std::set<SOCKET> &recv_set, std::set<SOCKET> &send_set, std::set<SOCKET> &error_set, bool fOnlyPoll)
 {
     switch (socketEventsMode) {
 #ifdef USE_KQUEUE
         case SOCKETEVENTS_KQUEUE:
-            SocketEventsKqueue(recv_set, send_set, error_set, fOnlyPoll);
+            SocketEventsKqueue(shard, recv_set, send_set, error_set, fOnlyPoll);
             break;
 #endif
 #ifdef USE_EPOLL
         case SOCKETEVENTS_EPOLL:
-            SocketEventsEpoll(recv_set, send_set, error_set, fOnlyPoll);
+            SocketEventsEpoll(shard, recv_set, send_set, error_set, fOnlyPoll);
             break;
 #endif
 #ifdef USE_POLL
         case SOCKETEVENTS_POLL:
-            SocketEventsPoll(recv_set, send_set, error_set, fOnlyPoll);
+            SocketEventsPoll(shard, recv_set, send_set, error_set, fOnlyPoll);
             break;
 #endif
         case SOCKETEVENTS_SELECT:
-            SocketEventsSelect(recv_set, send_set, error_set, fOnlyPoll);
+            SocketEventsSelect(shard, recv_set, send_set, error_set, fOnlyPoll);
             break;
         default:
             assert(false);
     }
 }
 
-void CConnman::SocketHandler()
+void CConnman::SocketHandler(SocketEventsShard& shard)
 {
     bool fOnlyPoll = false;
     {
         // check if we have work to do and thus should avoid waiting for events
-        LOCK2(cs_vNodes, cs_mapNodesWithDataToSend);
-        if (!mapReceivableNodes.empty()) {
+        LOCK(shard.cs);
+        if (!shard.mapReceivableNodes.empty()) {
             fOnlyPoll = true;
-        } else if (!mapSendableNodes.empty() && !mapNodesWithDataToSend.empty()) {
+        } else if (!shard.mapSendableNodes.empty() && !shard.mapNodesWithDataToSend.empty()) {
             // we must check if at least one of the nodes with pending messages is also sendable, as otherwise a single
             // node would be able to make the network thread busy with polling
-            for (auto& p : mapNodesWithDataToSend) {
-                if (mapSendableNodes.count(p.first)) {
+            for (auto& p : shard.mapNodesWithDataToSend) {
+                if (shard.mapSendableNodes.count(p.first)) {
                     fOnlyPoll = true;
                     break;
                 }
@@ -1802,14 +1875,14 @@ void CConnman::SocketHandler()
     }
 
     std::set<SOCKET> recv_set, send_set, error_set;
-    SocketEvents(recv_set, send_set, error_set, fOnlyPoll);
+    SocketEvents(shard, recv_set, send_set, error_set, fOnlyPoll);
 
 #ifdef USE_WAKEUP_PIPE
     // drain the wakeup pipe
-    if (recv_set.count(wakeupPipe[0])) {
+    if (recv_set.count(shard.wakeupPipe[0])) {
         char buf[128];
         while (true) {
-            int r = read(wakeupPipe[0], buf, sizeof(buf));
+            int r = read(shard.wakeupPipe[0], buf, sizeof(buf));
             if (r <= 0) {
                 break;
             }
@@ -1822,11 +1895,13 @@ void CConnman::SocketHandler()
     //
     // Accept new connections
     //
-    for (const ListenSocket& hListenSocket : vhListenSocket)
-    {
-        if (recv_set.count(hListenSocket.socket) > 0)
+    if (&shard == m_socket_shards.front().get()) {
+        for (const ListenSocket& hListenSocket : vhListenSocket)
         {
-            AcceptConnection(hListenSocket);
+            if (recv_set.count(hListenSocket.socket) > 0)
+            {
+                AcceptConnection(hListenSocket);
+            }
         }
     }
 
@@ -1834,10 +1909,10 @@ void CConnman::SocketHandler()
     std::vector<CNode*> vReceivableNodes;
     std::vector<CNode*> vSendableNodes;
     {
-        LOCK(cs_vNodes);
+        LOCK(shard.cs);
         for (auto hSocket : error_set) {
-            auto it = mapSocketToNode.find(hSocket);
-            if (it == mapSocketToNode.end()) {
+            auto it = shard.mapSocketToNode.find(hSocket);
+            if (it == shard.mapSocketToNode.end()) {
                 continue;
             }
             it->second->AddRef();
@@ -1849,32 +1924,32 @@ void CConnman::SocketHandler()
                 continue;
             }
 
-            auto it = mapSocketToNode.find(hSocket);
-            if (it == mapSocketToNode.end()) {
+            auto it = shard.mapSocketToNode.find(hSocket);
+            if (it == shard.mapSocketToNode.end()) {
                 continue;
             }
 
-            auto jt = mapReceivableNodes.emplace(it->second->GetId(), it->second);
+            auto jt = shard.mapReceivableNodes.emplace(it->second->GetId(), it->second);
             assert(jt.first->second == it->second);
             it->second->fHasRecvData = true;
         }
         for (auto hSocket : send_set) {
-            auto it = mapSocketToNode.find(hSocket);
-            if (it == mapSocketToNode.end()) {
+            auto it = shard.mapSocketToNode.find(hSocket);
+            if (it == shard.mapSocketToNode.end()) {
                 continue;
             }
 
-            auto jt = mapSendableNodes.emplace(it->second->GetId(), it->second);
+            auto jt = shard.mapSendableNodes.emplace(it->second->GetId(), it->second);
             assert(jt.first->second == it->second);
             it->second->fCanSendData = true;
         }
 
         // collect nodes that have a receivable socket
         // also clean up mapReceivableNodes from nodes that were receivable in the last iteration but aren't anymore
-        vReceivableNodes.reserve(mapReceivableNodes.size());
-        for (auto it = mapReceivableNodes.begin(); it != mapReceivableNodes.end(); ) {
+        vReceivableNodes.reserve(shard.mapReceivableNodes.size());
+        for (auto it = shard.mapReceivableNodes.begin(); it != shard.mapReceivableNodes.end(); ) {
             if (!it->second->fHasRecvData) {
-                it = mapReceivableNodes.erase(it);
+                it = shard.mapReceivableNodes.erase(it);
             } else {
                 // Implement the following logic:
                 // * If there is data to send, try sending data. As this only
@@ -1884,7 +1959,7 @@ void CConnman::SocketHandler()
                 //   receiving data. This means properly utilizing TCP flow control signalling.
                 // * Otherwise, if there is space left in the receive buffer (!fPauseRecv), try
                 //   receiving data (which should succeed as the socket signalled as receivable).
-                if (!it->second->fPauseRecv && it->second->nSendMsgSize == 0 && !it->second->fDisconnect) {
+                if (!it->second->fPauseRecv && !it->second->fPauseRecvBudget && it->second->nSendMsgSize == 0 && !it->second->fDisconnect) {
                     it->second->AddRef();
                     vReceivableNodes.emplace_back(it->second);
                 }
@@ -1895,13 +1970,12 @@ void CConnman::SocketHandler()
         // collect nodes that have data to send and have a socket with non-empty write buffers
         // also clean up mapNodesWithDataToSend from nodes that had messages to send in the last iteration
         // but don't have any in this iteration
-        LOCK(cs_mapNodesWithDataToSend);
-        vSendableNodes.reserve(mapNodesWithDataToSend.size());
-        for (auto it = mapNodesWithDataToSend.begin(); it != mapNodesWithDataToSend.end(); ) {
+        vSendableNodes.reserve(shard.mapNodesWithDataToSend.size());
+        for (auto it = shard.mapNodesWithDataToSend.begin(); it != shard.mapNodesWithDataToSend.end(); ) {
             if (it->second->nSendMsgSize == 0) {
                 // See comment in PushMessage
                 it->second->Release();
-                it = mapNodesWithDataToSend.erase(it);
+                it = shard.mapNodesWithDataToSend.erase(it);
             } else {
                 if (it->second->fCanSendData) {
                     it->second->AddRef();
@@ -1912,13 +1986,16 @@ void CConnman::SocketHandler()
         }
     }
 
+    // Completed messages are handed over to the message handler once for the whole batch
+    bool fWakeMessageHandler = false;
+
     for (CNode* pnode : vErrorNodes)
     {
         if (interruptNet) {
             break;
         }
         // let recv() return errors and then handle it
-        SocketRecvData(pnode);
+        SocketRecvData(pnode, fWakeMessageHandler);
     }
 
     for (CNode* pnode : vReceivableNodes)
@@ -1926,11 +2003,15 @@ void CConnman::SocketHandler()
         if (interruptNet) {
             break;
         }
-        if (pnode->fPauseRecv) {
+        if (pnode->fPauseRecv || pnode->fPauseRecvBudget) {
             continue;
         }
 
-        SocketRecvData(pnode);
+        SocketRecvData(pnode, fWakeMessageHandler);
+    }
+
+    if (fWakeMessageHandler) {
+        WakeMessageHandler();
     }
 
     for (CNode* pnode : vSendableNodes) {
@@ -1952,13 +2033,13 @@ void CConnman::SocketHandler()
     }
 
     {
-        LOCK(cs_vNodes);
+        LOCK(shard.cs);
         // remove nodes from mapSendableNodes, so that the next iteration knows that there is no work to do
         // (even if there are pending messages to be sent)
-        for (auto it = mapSendableNodes.begin(); it != mapSendableNodes.end(); ) {
+        for (auto it = shard.mapSendableNodes.begin(); it != shard.mapSendableNodes.end(); ) {
             if (!it->second->fCanSendData) {
                 LogPrint(BCLog::NET, "%s -- remove mapSendableNodes, peer=%d\n", __func__, it->second->GetId());
-                it = mapSendableNodes.erase(it);
+                it = shard.mapSendableNodes.erase(it);
             } else {
                 ++it;
             }
@@ -1966,7 +2047,7 @@ void CConnman::SocketHandler()
     }
 }
 
-size_t CConnman::SocketRecvData(CNode *pnode)
+size_t CConnman::SocketRecvData(CNode *pnode, bool& fWakeMessageHandler)
 {
     // typical socket buffer is 8K-64K
     uint8_t pchBuf[0x10000];
@@ -2002,7 +2083,7 @@ size_t CConnman::SocketRecvData(CNode *pnode)
                 pnode->nProcessQueueSize += nSizeAdded;
                 pnode->fPauseRecv = pnode->nProcessQueueSize > nReceiveFloodSize;
             }
-            WakeMessageHandler();
+            fWakeMessageHandler = true;
         }
     }
     else if (nBytes == 0)
@@ -2043,7 +2124,7 @@ void CConnman::ThreadSocketHandler()
     {
         // Handle sockets before we do the next round of disconnects. This allows us to flush send buffers one last time
         // before actually closing sockets. Receiving is however skipped in case a peer is pending to be disconnected
-        SocketHandler();
+        SocketHandler(*m_socket_shards.front());
         if (GetTimeMillis() - nLastCleanupNodes > 1000) {
             ForEachNode(AllNodes, [&](CNode* pnode) {
                 if (InactivityCheck(*pnode)) pnode->fDisconnect = true;
@@ -2055,29 +2136,61 @@ void CConnman::ThreadSocketHandler()
     }
 }
 
+void CConnman::ThreadSocketHandlerShard(SocketEventsShard& shard)
+{
+    // Disconnects and inactivity checks are left to ThreadSocketHandler, the linger time of disconnecting
+    // nodes gives this thread the chance to flush their send buffers
+    while (!interruptNet)
+    {
+        SocketHandler(shard);
+    }
+}
+
+CConnman::SocketEventsShard& CConnman::GetSocketShard(const CNode* pnode) const
+{
+    return *m_socket_shards[pnode->GetId() % m_socket_shards.size()];
+}
+
+void CConnman::AddToSocketShard(CNode* pnode)
+{
+    auto& shard = GetSocketShard(pnode);
+    LOCK2(pnode->cs_hSocket, shard.cs);
+    shard.mapSocketToNode.emplace(pnode->hSocket, pnode);
+}
+
 void CConnman::WakeMessageHandler()
 {
     {
         LOCK(mutexMsgProc);
-        fMsgProcWake = true;
+        ++nMsgProcWakeSeq;
     }
-    condMsgProc.notify_one();
+    condMsgProc.notify_all();
 }
 
-void CConnman::WakeSelect()
+void CConnman::WakeSelect(const CNode* pnode)
 {
+    const auto wake = [](SocketEventsShard& shard) {
 #ifdef USE_WAKEUP_PIPE
-    if (wakeupPipe[1] == -1) {
-        return;
-    }
+        if (shard.wakeupPipe[1] == -1) {
+            return;
+        }
 
-    char buf{0};
-    if (write(wakeupPipe[1], &buf, sizeof(buf)) != 1) {
-        LogPrint(BCLog::NET, "write to wakeupPipe failed\n");
-    }
+        char buf{0};
+        if (write(shard.wakeupPipe[1], &buf, sizeof(buf)) != 1) {
+            LogPrint(BCLog::NET, "write to wakeupPipe failed\n");
+        }
 #endif
 
-    wakeupSelectNeeded = false;
+        shard.wakeupSelectNeeded = false;
+    };
+
+    if (pnode != nullptr) {
+        wake(GetSocketShard(pnode));
+        return;
+    }
+    for (const auto& shard : m_socket_shards) {
+        wake(*shard);
+    }
 }
 
 void CConnman::ThreadDNSAddressSeed()
@@ -2884,17 +2997,14 @@ void CConnman::OpenNetworkConnection(const CAddress& addrConnect, bool fCountFai
     if (masternode_probe_connection == MasternodeProbeConn::IsConnection)
         pnode->m_masternode_probe_connection = true;
 
-    {
-        LOCK2(cs_vNodes, pnode->cs_hSocket);
-        mapSocketToNode.emplace(pnode->hSocket, pnode);
-    }
+    AddToSocketShard(pnode);
 
     m_msgproc->InitializeNode(pnode);
     {
         LOCK(cs_vNodes);
         vNodes.push_back(pnode);
         RegisterEvents(pnode);
-        WakeSelect();
+        WakeSelect(pnode);
     }
 }
 
@@ -2903,9 +3013,10 @@ void CConnman::OpenMasternodeConnection(const CAddress &addrConnect, MasternodeP
     OpenNetworkConnection(addrConnect, false, nullptr, nullptr, ConnectionType::OUTBOUND_FULL_RELAY, MasternodeConn::IsConnection, probe);
 }
 
-void CConnman::ThreadMessageHandler()
+void CConnman::ThreadMessageHandler(size_t nThread)
 {
     int64_t nLastSendMessagesTimeMasternodes = 0;
+    uint64_t nLastWakeSeq = WITH_LOCK(mutexMsgProc, return nMsgProcWakeSeq);
 
     while (!flagInterruptMsgProc)
     {
@@ -2921,6 +3032,10 @@ void CConnman::ThreadMessageHandler()
 
         for (CNode* pnode : vNodesCopy)
         {
+            // Nodes always stay with the same thread, which keeps their messages in order
+            if ((size_t)pnode->GetId() % threadMessageHandlers.size() != nThread)
+                continue;
+
             if (pnode->fDisconnect)
                 continue;
 
@@ -2943,9 +3058,9 @@ void CConnman::ThreadMessageHandler()
 
         WAIT_LOCK(mutexMsgProc, lock);
         if (!fMoreWork) {
-            condMsgProc.wait_until(lock, std::chrono::steady_clock::now() + std::chrono::milliseconds(100), [this]() EXCLUSIVE_LOCKS_REQUIRED(mutexMsgProc) { return fMsgProcWake; });
+            condMsgProc.wait_until(lock, std::chrono::steady_clock::now() + std::chrono::milliseconds(100), [&]() EXCLUSIVE_LOCKS_REQUIRED(mutexMsgProc) { return nMsgProcWakeSeq != nLastWakeSeq; });
         }
-        fMsgProcWake = false;
+        nLastWakeSeq = nMsgProcWakeSeq;
     }
 }
 
@@ -3049,7 +3164,7 @@ bool CConnman::BindListenPort(const CService& addrBind, bilingual_str& strError,
     if (socketEventsMode == SOCKETEVENTS_KQUEUE) {
         struct kevent event;
         EV_SET(&event, sock->Get(), EVFILT_READ, EV_ADD, 0, 0, nullptr);
-        if (kevent(kqueuefd, &event, 1, nullptr, 0, nullptr) != 0) {
+        if (kevent(m_socket_shards.front()->kqueuefd, &event, 1, nullptr, 0, nullptr) != 0) {
             strError = strprintf(_("Error: failed to add socket to kqueuefd (kevent returned error %s)"), NetworkErrorString(WSAGetLastError()));
             LogPrintf("%s\n", strError.original);
             return false;
@@ -3062,7 +3177,7 @@ bool CConnman::BindListenPort(const CService& addrBind, bilingual_str& strError,
         epoll_event event;
         event.data.fd = sock->Get();
         event.events = EPOLLIN;
-        if (epoll_ctl(epollfd, EPOLL_CTL_ADD, sock->Get(), &event) != 0) {
+        if (epoll_ctl(m_socket_shards.front()->epollfd, EPOLL_CTL_ADD, sock->Get(), &event) != 0) {
             strError = strprintf(_("Error: failed to add socket to epollfd (epoll_ctl returned error %s)"), NetworkErrorString(WSAGetLastError()));
             LogPrintf("%s\n", strError.original);
             return false;
@@ -3148,6 +3263,8 @@ CConnman::CConnman(uint64_t nSeed0In, uint64_t nSeed1In, CAddrMan& addrman_in) :
 {
     SetTryNewOutboundPeer(false);
 
+    m_socket_shards.emplace_back(std::make_unique<SocketEventsShard>());
+
     Options connOptions;
     Init(connOptions);
 }
@@ -3204,14 +3321,12 @@ bool CConnman::InitBinds(
     return fBound;
 }
 
-bool CConnman::Start(CScheduler& scheduler, const Options& connOptions)
+bool CConnman::StartSocketShard(SocketEventsShard& shard)
 {
-    Init(connOptions);
-
 #ifdef USE_KQUEUE
     if (socketEventsMode == SOCKETEVENTS_KQUEUE) {
-        kqueuefd = kqueue();
-        if (kqueuefd == -1) {
+        shard.kqueuefd = kqueue();
+        if (shard.kqueuefd == -1) {
             LogPrintf("kqueue failed\n");
             return false;
         }
@@ -3220,14 +3335,112 @@ bool CConnman::Start(CScheduler& scheduler, const Options& connOptions)
 
 #ifdef USE_EPOLL
     if (socketEventsMode == SOCKETEVENTS_EPOLL) {
-        epollfd = epoll_create1(0);
-        if (epollfd == -1) {
+        shard.epollfd = epoll_create1(0);
+        if (shard.epollfd == -1) {
             LogPrintf("epoll_create1 failed\n");
             return false;
         }
     }
 #endif
 
+#ifdef USE_WAKEUP_PIPE
+    if (pipe(shard.wakeupPipe) != 0) {
+        shard.wakeupPipe[0] = shard.wakeupPipe[1] = -1;
+        LogPrint(BCLog::NET, "pipe() for wakeupPipe failed\n");
+    } else {
+        int fFlags = fcntl(shard.wakeupPipe[0], F_GETFL, 0);
+        if (fcntl(shard.wakeupPipe[0], F_SETFL, fFlags | O_NONBLOCK) == -1) {
+            LogPrint(BCLog::NET, "fcntl for O_NONBLOCK on wakeupPipe failed\n");
+        }
+        fFlags = fcntl(shard.wakeupPipe[1], F_GETFL, 0);
+        if (fcntl(shard.wakeupPipe[1], F_SETFL, fFlags | O_NONBLOCK) == -1) {
+            LogPrint(BCLog::NET, "fcntl for O_NONBLOCK on wakeupPipe failed\n");
+        }
+#ifdef USE_KQUEUE
+        if (socketEventsMode == SOCKETEVENTS_KQUEUE) {
+            struct kevent event;
+            EV_SET(&event, shard.wakeupPipe[0], EVFILT_READ, EV_ADD, 0, 0, nullptr);
+            int r = kevent(shard.kqueuefd, &event, 1, nullptr, 0, nullptr);
+            if (r != 0) {
+                LogPrint(BCLog::NET, "%s -- kevent(%d, %d, %d, ...) failed. error: %s\n", __func__,
+                         shard.kqueuefd, EV_ADD, shard.wakeupPipe[0], NetworkErrorString(WSAGetLastError()));
+                return false;
+            }
+        }
+#endif
+#ifdef USE_EPOLL
+        if (socketEventsMode == SOCKETEVENTS_EPOLL) {
+            epoll_event event;
+            event.events = EPOLLIN;
+            event.data.fd = shard.wakeupPipe[0];
+            int r = epoll_ctl(shard.epollfd, EPOLL_CTL_ADD, shard.wakeupPipe[0], &event);
+            if (r != 0) {
+                LogPrint(BCLog::NET, "%s -- epoll_ctl(%d, %d, %d, ...) failed. error: %s\n", __func__,
+                         shard.epollfd, EPOLL_CTL_ADD, shard.wakeupPipe[0], NetworkErrorString(WSAGetLastError()));
+                return false;
+            }
+        }
+#endif
+    }
+#endif
+
+    return true;
+}
+
+void CConnman::StopSocketShard(SocketEventsShard& shard)
+{
+    {
+        LOCK(shard.cs);
+        shard.mapSocketToNode.clear();
+        shard.mapReceivableNodes.clear();
+        shard.mapSendableNodes.clear();
+        shard.mapNodesWithDataToSend.clear();
+    }
+
+#ifdef USE_KQUEUE
+    if (socketEventsMode == SOCKETEVENTS_KQUEUE && shard.kqueuefd != -1) {
+#ifdef USE_WAKEUP_PIPE
+        struct kevent event;
+        EV_SET(&event, shard.wakeupPipe[0], EVFILT_READ, EV_DELETE, 0, 0, nullptr);
+        kevent(shard.kqueuefd, &event, 1, nullptr, 0, nullptr);
+#endif
+        close(shard.kqueuefd);
+    }
+    shard.kqueuefd = -1;
+#endif
+#ifdef USE_EPOLL
+    if (socketEventsMode == SOCKETEVENTS_EPOLL && shard.epollfd != -1) {
+#ifdef USE_WAKEUP_PIPE
+        epoll_ctl(shard.epollfd, EPOLL_CTL_DEL, shard.wakeupPipe[0], nullptr);
+#endif
+        close(shard.epollfd);
+    }
+    shard.epollfd = -1;
+#endif
+
+#ifdef USE_WAKEUP_PIPE
+    if (shard.wakeupPipe[0] != -1) close(shard.wakeupPipe[0]);
+    if (shard.wakeupPipe[1] != -1) close(shard.wakeupPipe[1]);
+    shard.wakeupPipe[0] = shard.wakeupPipe[1] = -1;
+#endif
+}
+
+bool CConnman::Start(CScheduler& scheduler, const Options& connOptions)
+{
+    Init(connOptions);
+
+    // Only epoll and kqueue can split the sockets between several event queues and threads
+    if (socketEventsMode == SOCKETEVENTS_EPOLL || socketEventsMode == SOCKETEVENTS_KQUEUE) {
+        while (m_socket_shards.size() < (size_t)nSocketThreads) {
+            m_socket_shards.emplace_back(std::make_unique<SocketEventsShard>());
+        }
+    }
+    for (const auto& shard : m_socket_shards) {
+        if (!StartSocketShard(*shard)) {
+            return false;
+        }
+    }
+
     if (fListen && !InitBinds(connOptions.vBinds, connOptions.vWhiteBinds, connOptions.onion_binds)) {
         if (clientInterface) {
             clientInterface->ThreadSafeMessageBox(
@@ -3293,54 +3506,14 @@ bool CConnman::Start(CScheduler& scheduler, const Options& connOptions)
     interruptNet.reset();
     flagInterruptMsgProc = false;
 
-    {
-        LOCK(mutexMsgProc);
-        fMsgProcWake = false;
-    }
-
-#ifdef USE_WAKEUP_PIPE
-    if (pipe(wakeupPipe) != 0) {
-        wakeupPipe[0] = wakeupPipe[1] = -1;
-        LogPrint(BCLog::NET, "pipe() for wakeupPipe failed\n");
-    } else {
-        int fFlags = fcntl(wakeupPipe[0], F_GETFL, 0);
-        if (fcntl(wakeupPipe[0], F_SETFL, fFlags | O_NONBLOCK) == -1) {
-            LogPrint(BCLog::NET, "fcntl for O_NONBLOCK on wakeupPipe failed\n");
-        }
-        fFlags = fcntl(wakeupPipe[1], F_GETFL, 0);
-        if (fcntl(wakeupPipe[1], F_SETFL, fFlags | O_NONBLOCK) == -1) {
-            LogPrint(BCLog::NET, "fcntl for O_NONBLOCK on wakeupPipe failed\n");
-        }
-#ifdef USE_KQUEUE
-        if (socketEventsMode == SOCKETEVENTS_KQUEUE) {
-            struct kevent event;
-            EV_SET(&event, wakeupPipe[0], EVFILT_READ, EV_ADD, 0, 0, nullptr);
-            int r = kevent(kqueuefd, &event, 1, nullptr, 0, nullptr);
-            if (r != 0) {
-                LogPrint(BCLog::NET, "%s -- kevent(%d, %d, %d, ...) failed. error: %s\n", __func__,
-                         kqueuefd, EV_ADD, wakeupPipe[0], NetworkErrorString(WSAGetLastError()));
-                return false;
-            }
-        }
-#endif
-#ifdef USE_EPOLL
-        if (socketEventsMode == SOCKETEVENTS_EPOLL) {
-            epoll_event event;
-            event.events = EPOLLIN;
-            event.data.fd = wakeupPipe[0];
-            int r = epoll_ctl(epollfd, EPOLL_CTL_ADD, wakeupPipe[0], &event);
-            if (r != 0) {
-                LogPrint(BCLog::NET, "%s -- epoll_ctl(%d, %d, %d, ...) failed. error: %s\n", __func__,
-                         epollfd, EPOLL_CTL_ADD, wakeupPipe[0], NetworkErrorString(WSAGetLastError()));
-                return false;
-            }
-        }
-#endif
-    }
-#endif
-
     // Send and receive from sockets, accept connections
-    threadSocketHandler = std::thread(&util::TraceThread, "net", [this] { ThreadSocketHandler(); });
+    m_socket_shards.front()->thread = std::thread(&util::TraceThread, "net", [this] { ThreadSocketHandler(); });
+    for (size_t i = 1; i < m_socket_shards.size(); ++i) {
+        auto& shard = *m_socket_shards[i];
+        m_socket_shards[i]->thread = std::thread([this, &shard, thread_name = strprintf("net.%d", i)] {
+            util::TraceThread(thread_name.c_str(), [this, &shard] { ThreadSocketHandlerShard(shard); });
+        });
+    }
 
     if (!gArgs.GetBoolArg("-dnsseed", true))
         LogPrintf("DNS seeding disabled\n");
@@ -3368,7 +3541,14 @@ bool CConnman::Start(CScheduler& scheduler, const Options& connOptions)
     threadOpenMasternodeConnections = std::thread(&util::TraceThread, "mncon", [this] { ThreadOpenMasternodeConnections(); });
 
     // Process messages
-    threadMessageHandler = std::thread(&util::TraceThread, "msghand", [this] { ThreadMessageHandler(); });
+    // Process messages, messages which don't need validation are processed in parallel if there are several threads
+    threadMessageHandlers.resize(nMessageHandlerThreads);
+    threadMessageHandlers.front() = std::thread(&util::TraceThread, "msghand", [this] { ThreadMessageHandler(0); });
+    for (size_t i = 1; i < threadMessageHandlers.size(); ++i) {
+        threadMessageHandlers[i] = std::thread([this, i, thread_name = strprintf("msghand.%d", i)] {
+            util::TraceThread(thread_name.c_str(), [this, i] { ThreadMessageHandler(i); });
+        });
+    }
 
     if (connOptions.m_i2p_accept_incoming && m_i2p_sam_session.get() != nullptr) {
         threadI2PAcceptIncoming =
@@ -3376,7 +3556,7 @@ bool CConnman::Start(CScheduler& scheduler, const Options& connOptions)
     }
 
     // Dump network addresses
-    scheduler.scheduleEvery([this] { DumpAddresses(); }, DUMP_PEERS_INTERVAL);
+    scheduler.scheduleEvery([this] { DumpAddresses(); }, DUMP_PEERS_INTERVAL, SchedulerLane::NETWORK, "dumpaddresses");
 
     return true;
 }
@@ -3432,8 +3612,11 @@ void CConnman::StopThreads()
     if (threadI2PAcceptIncoming.joinable()) {
         threadI2PAcceptIncoming.join();
     }
-    if (threadMessageHandler.joinable())
-        threadMessageHandler.join();
+    for (auto& thread : threadMessageHandlers) {
+        if (thread.joinable())
+            thread.join();
+    }
+    threadMessageHandlers.clear();
     if (threadOpenMasternodeConnections.joinable())
         threadOpenMasternodeConnections.join();
     if (threadOpenConnections.joinable())
@@ -3442,8 +3625,10 @@ void CConnman::StopThreads()
         threadOpenAddedConnections.join();
     if (threadDNSAddressSeed.joinable())
         threadDNSAddressSeed.join();
-    if (threadSocketHandler.joinable())
-        threadSocketHandler.join();
+    for (const auto& shard : m_socket_shards) {
+        if (shard->thread.joinable())
+            shard->thread.join();
+    }
 }
 
 void CConnman::StopNodes()
@@ -3475,12 +3660,12 @@ void CConnman::StopNodes()
             if (socketEventsMode == SOCKETEVENTS_KQUEUE) {
                 struct kevent event;
                 EV_SET(&event, hListenSocket.socket, EVFILT_READ, EV_DELETE, 0, 0, nullptr);
-                kevent(kqueuefd, &event, 1, nullptr, 0, nullptr);
+                kevent(m_socket_shards.front()->kqueuefd, &event, 1, nullptr, 0, nullptr);
             }
 #endif
 #ifdef USE_EPOLL
             if (socketEventsMode == SOCKETEVENTS_EPOLL) {
-                epoll_ctl(epollfd, EPOLL_CTL_DEL, hListenSocket.socket, nullptr);
+                epoll_ctl(m_socket_shards.front()->epollfd, EPOLL_CTL_DEL, hListenSocket.socket, nullptr);
             }
 #endif
             if (!CloseSocket(hListenSocket.socket))
@@ -3496,46 +3681,14 @@ void CConnman::StopNodes()
     for (CNode* pnode : vNodesDisconnected) {
         DeleteNode(pnode);
     }
-    mapSocketToNode.clear();
-    {
-        LOCK(cs_vNodes);
-        mapReceivableNodes.clear();
-    }
-    {
-        LOCK(cs_mapNodesWithDataToSend);
-        mapNodesWithDataToSend.clear();
-    }
     vNodesDisconnected.clear();
     vhListenSocket.clear();
     semOutbound.reset();
     semAddnode.reset();
 
-#ifdef USE_KQUEUE
-    if (socketEventsMode == SOCKETEVENTS_KQUEUE && kqueuefd != -1) {
-#ifdef USE_WAKEUP_PIPE
-        struct kevent event;
-        EV_SET(&event, wakeupPipe[0], EVFILT_READ, EV_DELETE, 0, 0, nullptr);
-        kevent(kqueuefd, &event, 1, nullptr, 0, nullptr);
-#endif
-        close(kqueuefd);
+    for (const auto& shard : m_socket_shards) {
+        StopSocketShard(*shard);
     }
-    kqueuefd = -1;
-#endif
-#ifdef USE_EPOLL
-    if (socketEventsMode == SOCKETEVENTS_EPOLL && epollfd != -1) {
-#ifdef USE_WAKEUP_PIPE
-        epoll_ctl(epollfd, EPOLL_CTL_DEL, wakeupPipe[0], nullptr);
-#endif
-        close(epollfd);
-    }
-    epollfd = -1;
-#endif
-
-#ifdef USE_WAKEUP_PIPE
-    if (wakeupPipe[0] != -1) close(wakeupPipe[0]);
-    if (wakeupPipe[1] != -1) close(wakeupPipe[1]);
-    wakeupPipe[0] = wakeupPipe[1] = -1;
-#endif
 }
 
 void CConnman::DeleteNode(CNode* pnode)
@@ -3644,31 +3797,45 @@ void CConnman::SetMasternodeQuorumNodes(Consensus::LLMQType llmqType, const uint
 {
     LOCK(cs_vPendingMasternodes);
     auto it = masternodeQuorumNodes.emplace(std::make_pair(llmqType, quorumHash), proTxHashes);
-    if (!it.second) {
+    if (!it.second && it.first->second != proTxHashes) {
         it.first->second = proTxHashes;
     }
 }
 
 void CConnman::SetMasternodeQuorumRelayMembers(Consensus::LLMQType llmqType, const uint256& quorumHash, const std::set<uint256>& proTxHashes)
 {
+    // Only members which weren't relay members of this quorum before can need a QSENDRECSIGS, peers which were
+    // got it when they were added here or when they authenticated (see CMNAuth::ProcessMessage)
+    std::set<uint256> added;
     {
         LOCK(cs_vPendingMasternodes);
         auto it = masternodeQuorumRelayMembers.emplace(std::make_pair(llmqType, quorumHash), proTxHashes);
-        if (!it.second) {
+        if (it.second) {
+            added = proTxHashes;
+        } else if (it.first->second != proTxHashes) {
+            std::set_difference(proTxHashes.begin(), proTxHashes.end(), it.first->second.begin(), it.first->second.end(),
+                                std::inserter(added, added.end()));
             it.first->second = proTxHashes;
         }
     }
+    if (added.empty()) {
+        return;
+    }
 
     // Update existing connections
     ForEachNode([&](CNode* pnode) {
         auto verifiedProRegTxHash = pnode->GetVerifiedProRegTxHash();
-        if (!verifiedProRegTxHash.IsNull() && !pnode->m_masternode_iqr_connection && IsMasternodeQuorumRelayMember(verifiedProRegTxHash)) {
+        if (!verifiedProRegTxHash.IsNull() && !pnode->m_masternode_iqr_connection && added.count(verifiedProRegTxHash)) {
             // Tell our peer that we're interested in plain LLMQ recovered signatures.
             // Otherwise the peer would only announce/send messages resulting from QRECSIG,
             // e.g. InstantSend locks or ChainLocks. SPV and regular full nodes should not send
             // this message as they are usually only interested in the higher level messages.
             const CNetMsgMaker msgMaker(pnode->GetCommonVersion());
             PushMessage(pnode, msgMaker.Make(NetMsgType::QSENDRECSIGS, true));
+            // We can rebuild ISLOCKs/CLSIGs from those recovered sigs, so ask for them in compact form too
+            if (pnode->GetCommonVersion() >= COMPACT_LOCKS_PROTO_VERSION) {
+                PushMessage(pnode, msgMaker.Make(NetMsgType::SENDCMPCTLOCKS, true));
+            }
             pnode->m_masternode_iqr_connection = true;
         }
     });
@@ -3773,6 +3940,22 @@ void CConnman::AddPendingProbeConnections(const std::set<uint256> &proTxHashes)
     masternodePendingProbes.insert(proTxHashes.begin(), proTxHashes.end());
 }
 
+size_t CConnman::GetPeerBuffersSize()
+{
+    LOCK(cs_vNodes);
+
+    size_t nSize = 0;
+    for (const auto& pnode : vNodes) {
+        {
+            LOCK(pnode->cs_vSend);
+            nSize += pnode->nSendSize;
+        }
+        LOCK(pnode->cs_vProcessMsg);
+        nSize += pnode->nProcessQueueSize;
+    }
+    return nSize;
+}
+
 size_t CConnman::GetNodeCount(NumConnections flags)
 {
     LOCK(cs_vNodes);
@@ -3858,7 +4041,7 @@ void CConnman::RelayTransaction(const CTransaction& tx)
 {
     uint256 hash = tx.GetHash();
     int nInv = MSG_TX;
-    if (::dstxManager->GetDSTX(hash)) {
+    if (::dstxManager->HasDSTX(hash)) {
         nInv = MSG_DSTX;
     }
     CInv inv(nInv, hash);
@@ -4061,6 +4244,14 @@ void CConnman::PushMessage(CNode* pnode, CSerializedNetMsg&& msg)
 {
     size_t nMessageSize = msg.data.size();
     LogPrint(BCLog::NET, "sending %s (%d bytes) peer=%d\n", SanitizeString(msg.command), nMessageSize, pnode->GetId());
+    TRACE6(net, outbound_message,
+        pnode->GetId(),
+        pnode->GetAddrName().c_str(),
+        pnode->ConnectionTypeAsString().c_str(),
+        msg.command.c_str(),
+        msg.data.size(),
+        msg.data.data()
+    );
     if (gArgs.GetBoolArg("-capturemessages", false)) {
         CaptureMessage(pnode->addr, msg.command, msg.data, /* incoming */ false);
     }
@@ -4082,24 +4273,32 @@ void CConnman::PushMessage(CNode* pnode, CSerializedNetMsg&& msg)
         pnode->nSendSize += nTotalSize;
 
         if (pnode->nSendSize > nSendBufferMaxSize) pnode->fPauseSend = true;
-        pnode->vSendMsg.push_back(std::move(serializedHeader));
-        if (nMessageSize) pnode->vSendMsg.push_back(std::move(msg.data));
+        if (hasPendingData && pnode->vSendMsg.back().size() + nTotalSize <= MAX_SEND_COALESCE_SIZE) {
+            // batch small messages into one buffer so that they go out with a single send
+            auto& buffer = pnode->vSendMsg.back();
+            buffer.insert(buffer.end(), serializedHeader.begin(), serializedHeader.end());
+            buffer.insert(buffer.end(), msg.data.begin(), msg.data.end());
+        } else {
+            pnode->vSendMsg.push_back(std::move(serializedHeader));
+            if (nMessageSize) pnode->vSendMsg.push_back(std::move(msg.data));
+        }
         pnode->nSendMsgSize = pnode->vSendMsg.size();
 
+        auto& shard = GetSocketShard(pnode);
         {
-            LOCK(cs_mapNodesWithDataToSend);
+            LOCK(shard.cs);
             // we're not holding cs_vNodes here, so there is a chance of this node being disconnected shortly before
             // we get here. Whoever called PushMessage still has a ref to CNode*, but will later Release() it, so we
             // might end up having an entry in mapNodesWithDataToSend that is not in vNodes anymore. We need to
             // Add/Release refs when adding/erasing mapNodesWithDataToSend.
-            if (mapNodesWithDataToSend.emplace(pnode->GetId(), pnode).second) {
+            if (shard.mapNodesWithDataToSend.emplace(pnode->GetId(), pnode).second) {
                 pnode->AddRef();
             }
         }
 
         // wake up select() call in case there was no pending data before (so it was not selecting this socket for sending)
-        if (!hasPendingData && wakeupSelectNeeded)
-            WakeSelect();
+        if (!hasPendingData && shard.wakeupSelectNeeded)
+            WakeSelect(pnode);
     }
 }
 
@@ -4198,6 +4397,7 @@ void CConnman::RegisterEvents(CNode *pnode)
         return;
     }
 
+    auto& shard = GetSocketShard(pnode);
     LOCK(pnode->cs_hSocket);
     assert(pnode->hSocket != INVALID_SOCKET);
 
@@ -4205,10 +4405,10 @@ void CConnman::RegisterEvents(CNode *pnode)
     EV_SET(&events[0], pnode->hSocket, EVFILT_READ, EV_ADD, 0, 0, nullptr);
     EV_SET(&events[1], pnode->hSocket, EVFILT_WRITE, EV_ADD | EV_CLEAR, 0, 0, nullptr);
 
-    int r = kevent(kqueuefd, events, 2, nullptr, 0, nullptr);
+    int r = kevent(shard.kqueuefd, events, 2, nullptr, 0, nullptr);
     if (r != 0) {
         LogPrint(BCLog::NET, "%s -- kevent(%d, %d, %d, ...) failed. error: %s\n", __func__,
-                kqueuefd, EV_ADD, pnode->hSocket, NetworkErrorString(WSAGetLastError()));
+                shard.kqueuefd, EV_ADD, pnode->hSocket, NetworkErrorString(WSAGetLastError()));
     }
 #endif
 #ifdef USE_EPOLL
@@ -4216,6 +4416,7 @@ void CConnman::RegisterEvents(CNode *pnode)
         return;
     }
 
+    auto& shard = GetSocketShard(pnode);
     LOCK(pnode->cs_hSocket);
     assert(pnode->hSocket != INVALID_SOCKET);
 
@@ -4224,10 +4425,10 @@ void CConnman::RegisterEvents(CNode *pnode)
     e.events = EPOLLIN | EPOLLOUT | EPOLLET | EPOLLERR | EPOLLHUP;
     e.data.fd = pnode->hSocket;
 
-    int r = epoll_ctl(epollfd, EPOLL_CTL_ADD, pnode->hSocket, &e);
+    int r = epoll_ctl(shard.epollfd, EPOLL_CTL_ADD, pnode->hSocket, &e);
     if (r != 0) {
         LogPrint(BCLog::NET, "%s -- epoll_ctl(%d, %d, %d, ...) failed. error: %s\n", __func__,
-                epollfd, EPOLL_CTL_ADD, pnode->hSocket, NetworkErrorString(WSAGetLastError()));
+                shard.epollfd, EPOLL_CTL_ADD, pnode->hSocket, NetworkErrorString(WSAGetLastError()));
     }
 #endif
 }
@@ -4239,6 +4440,7 @@ void CConnman::UnregisterEvents(CNode *pnode)
         return;
     }
 
+    auto& shard = GetSocketShard(pnode);
     LOCK(pnode->cs_hSocket);
     if (pnode->hSocket == INVALID_SOCKET) {
         return;
@@ -4248,10 +4450,10 @@ void CConnman::UnregisterEvents(CNode *pnode)
     EV_SET(&events[0], pnode->hSocket, EVFILT_READ, EV_DELETE, 0, 0, nullptr);
     EV_SET(&events[1], pnode->hSocket, EVFILT_WRITE, EV_DELETE, 0, 0, nullptr);
 
-    int r = kevent(kqueuefd, events, 2, nullptr, 0, nullptr);
+    int r = kevent(shard.kqueuefd, events, 2, nullptr, 0, nullptr);
     if (r != 0) {
         LogPrint(BCLog::NET, "%s -- kevent(%d, %d, %d, ...) failed. error: %s\n", __func__,
-                kqueuefd, EV_DELETE, pnode->hSocket, NetworkErrorString(WSAGetLastError()));
+                shard.kqueuefd, EV_DELETE, pnode->hSocket, NetworkErrorString(WSAGetLastError()));
     }
 #endif
 #ifdef USE_EPOLL
@@ -4259,15 +4461,16 @@ void CConnman::UnregisterEvents(CNode *pnode)
         return;
     }
 
+    auto& shard = GetSocketShard(pnode);
     LOCK(pnode->cs_hSocket);
     if (pnode->hSocket == INVALID_SOCKET) {
         return;
     }
 
-    int r = epoll_ctl(epollfd, EPOLL_CTL_DEL, pnode->hSocket, nullptr);
+    int r = epoll_ctl(shard.epollfd, EPOLL_CTL_DEL, pnode->hSocket, nullptr);
     if (r != 0) {
         LogPrint(BCLog::NET, "%s -- epoll_ctl(%d, %d, %d, ...) failed. error: %s\n", __func__,
-                epollfd, EPOLL_CTL_DEL, pnode->hSocket, NetworkErrorString(WSAGetLastError()));
+                shard.epollfd, EPOLL_CTL_DEL, pnode->hSocket, NetworkErrorString(WSAGetLastError()));
     }
 #endif
 }
@@ -31,6 +31,7 @@
 #include <consensus/params.h>
 #include <util/check.h>
 
+#include <algorithm>
 #include <atomic>
 #include <condition_variable>
 #include <cstdint>
@@ -102,6 +103,15 @@ static const bool DEFAULT_FORCEDNSSEED = false;
 static const size_t DEFAULT_MAXRECEIVEBUFFER = 5 * 1000;
 static const size_t DEFAULT_MAXSENDBUFFER    = 1 * 1000;
 
+/** Default number of message handler threads */
+static const int DEFAULT_MESSAGE_HANDLER_THREADS = 1;
+/** Maximum number of message handler threads */
+static const int MAX_MESSAGE_HANDLER_THREADS = 8;
+/** Default number of socket handler threads, each with its own epoll/kqueue instance */
+static const int DEFAULT_SOCKET_THREADS = 1;
+/** Maximum number of socket handler threads */
+static const int MAX_SOCKET_THREADS = 16;
+
 #if defined USE_KQUEUE
 #define DEFAULT_SOCKETEVENTS "kqueue"
 #elif defined USE_EPOLL
@@ -253,6 +263,8 @@ public:
         std::vector<std::string> m_specified_outgoing;
         std::vector<std::string> m_added_nodes;
         SocketEventsMode socketEventsMode = SOCKETEVENTS_SELECT;
+        int nSocketThreads = DEFAULT_SOCKET_THREADS;
+        int nMessageHandlerThreads = DEFAULT_MESSAGE_HANDLER_THREADS;
         std::vector<bool> m_asmap;
         bool m_i2p_accept_incoming;
     };
@@ -282,6 +294,8 @@ public:
             vAddedNodes = connOptions.m_added_nodes;
         }
         socketEventsMode = connOptions.socketEventsMode;
+        nSocketThreads = std::clamp(connOptions.nSocketThreads, 1, MAX_SOCKET_THREADS);
+        nMessageHandlerThreads = std::clamp(connOptions.nMessageHandlerThreads, 1, MAX_MESSAGE_HANDLER_THREADS);
         m_onion_binds = connOptions.onion_binds;
     }
 
@@ -522,6 +536,8 @@ public:
     void AddPendingProbeConnections(const std::set<uint256>& proTxHashes);
 
     size_t GetNodeCount(NumConnections num);
+    //! Bytes queued for sending plus received messages waiting to be processed, summed over all peers
+    size_t GetPeerBuffersSize();
     size_t GetMaxOutboundNodeCount();
     void GetNodeStats(std::vector<CNodeStats>& vstats);
     bool DisconnectNode(const std::string& node);
@@ -562,7 +578,8 @@ public:
     unsigned int GetReceiveFloodSize() const;
 
     void WakeMessageHandler();
-    void WakeSelect();
+    /** Wake up the socket handler thread(s) servicing the given node, or all of them */
+    void WakeSelect(const CNode* pnode = nullptr);
 
     /** Attempts to obfuscate tx time through exponentially distributed emitting.
         Works assuming that a single interval is used.
@@ -593,7 +610,8 @@ private:
     void AddAddrFetch(const std::string& strDest);
     void ProcessAddrFetch();
     void ThreadOpenConnections(std::vector<std::string> connect);
-    void ThreadMessageHandler();
+    /** Process the messages of the nodes assigned to message handler thread nThread */
+    void ThreadMessageHandler(size_t nThread);
     void ThreadI2PAcceptIncoming();
     void AcceptConnection(const ListenSocket& hListenSocket);
 
@@ -615,20 +633,56 @@ private:
     void CalculateNumConnectionsChangedStats();
     /** Return true if the peer is inactive and should be disconnected. */
     bool InactivityCheck(const CNode& node) const;
-    bool GenerateSelectSet(std::set<SOCKET> &recv_set, std::set<SOCKET> &send_set, std::set<SOCKET> &error_set);
+
+    /**
+     * A subset of the node sockets together with the event queue and the thread servicing them.
+     * Nodes are assigned to shards by NodeId. The listening sockets are always serviced by the first
+     * shard, and select/poll modes only ever use a single shard.
+     */
+    struct SocketEventsShard
+    {
+#ifdef USE_WAKEUP_PIPE
+        /** a pipe which is added to select() calls to wakeup before the timeout */
+        int wakeupPipe[2]{-1,-1};
+#endif
+        std::atomic<bool> wakeupSelectNeeded{false};
+#ifdef USE_KQUEUE
+        int kqueuefd{-1};
+#endif
+#ifdef USE_EPOLL
+        int epollfd{-1};
+#endif
+
+        Mutex cs;
+        std::unordered_map<SOCKET, CNode*> mapSocketToNode GUARDED_BY(cs);
+        std::unordered_map<NodeId, CNode*> mapReceivableNodes GUARDED_BY(cs);
+        std::unordered_map<NodeId, CNode*> mapSendableNodes GUARDED_BY(cs);
+        std::unordered_map<NodeId, CNode*> mapNodesWithDataToSend GUARDED_BY(cs);
+
+        std::thread thread;
+    };
+
+    SocketEventsShard& GetSocketShard(const CNode* pnode) const;
+    bool StartSocketShard(SocketEventsShard& shard);
+    void StopSocketShard(SocketEventsShard& shard);
+    void AddToSocketShard(CNode* pnode);
+
+    bool GenerateSelectSet(SocketEventsShard& shard, std::set<SOCKET> &recv_set, std::set<SOCKET> &send_set, std::set<SOCKET> &error_set);
 #ifdef USE_KQUEUE
-    void SocketEventsKqueue(std::set<SOCKET> &recv_set, std::set<SOCKET> &send_set, std::set<SOCKET> &error_set, bool fOnlyPoll);
+    void SocketEventsKqueue(SocketEventsShard& shard, std::set<SOCKET> &recv_set, std::set<SOCKET> &send_set, std::set<SOCKET> &error_set, bool fOnlyPoll);
 #endif
 #ifdef USE_EPOLL
-    void SocketEventsEpoll(std::set<SOCKET> &recv_set, std::set<SOCKET> &send_set, std::set<SOCKET> &error_set, bool fOnlyPoll);
+    void SocketEventsEpoll(SocketEventsShard& shard, std::set<SOCKET> &recv_set, std::set<SOCKET> &send_set, std::set<SOCKET> &error_set, bool fOnlyPoll);
 #endif
 #ifdef USE_POLL
-    void SocketEventsPoll(std::set<SOCKET> &recv_set, std::set<SOCKET> &send_set, std::set<SOCKET> &error_set, bool fOnlyPoll);
+    void SocketEventsPoll(SocketEventsShard& shard, std::set<SOCKET> &recv_set, std::set<SOCKET> &send_set, std::set<SOCKET> &error_set, bool fOnlyPoll);
 #endif
-    void SocketEventsSelect(std::set<SOCKET> &recv_set, std::set<SOCKET> &send_set, std::set<SOCKET> &error_set, bool fOnlyPoll);
-    void SocketEvents(std::set<SOCKET> &recv_set, std::set<SOCKET> &send_set, std::set<SOCKET> &error_set, bool fOnlyPoll);
-    void SocketHandler();
+    void SocketEventsSelect(SocketEventsShard& shard, std::set<SOCKET> &recv_set, std::set<SOCKET> &send_set, std::set<SOCKET> &error_set, bool fOnlyPoll);
+    void SocketEvents(SocketEventsShard& shard, std::set<SOCKET> &recv_set, std::set<SOCKET> &send_set, std::set<SOCKET> &error_set, bool fOnlyPoll);
+    void SocketHandler(SocketEventsShard& shard);
     void ThreadSocketHandler();
+    /** Socket handler loop of the additional shards, which only service their own sockets */
+    void ThreadSocketHandlerShard(SocketEventsShard& shard);
     void ThreadDNSAddressSeed();
     void ThreadOpenMasternodeConnections();
 
@@ -654,7 +708,8 @@ private:
     NodeId GetNewNodeId();
 
     size_t SocketSendData(CNode *pnode);
-    size_t SocketRecvData(CNode* pnode);
+    /** Receive from the node's socket, fWakeMessageHandler is set when complete messages were queued */
+    size_t SocketRecvData(CNode* pnode, bool& fWakeMessageHandler);
     void DumpAddresses();
 
     // Network stats
@@ -708,7 +763,6 @@ private:
     std::set<uint256> masternodePendingProbes GUARDED_BY(cs_vPendingMasternodes);
     std::vector<CNode*> vNodes GUARDED_BY(cs_vNodes);
     std::list<CNode*> vNodesDisconnected;
-    std::unordered_map<SOCKET, CNode*> mapSocketToNode;
     mutable RecursiveMutex cs_vNodes;
     std::atomic<NodeId> nLastNodeId{0};
     unsigned int nPrevNodeCount{0};
@@ -783,8 +837,8 @@ private:
     /** SipHasher seeds for deterministic randomness */
     const uint64_t nSeed0, nSeed1;
 
-    /** flag for waking the message processor. */
-    bool fMsgProcWake GUARDED_BY(mutexMsgProc);
+    /** bumped for waking the message processors, every thread remembers the last value it has seen */
+    uint64_t nMsgProcWakeSeq GUARDED_BY(mutexMsgProc){0};
 
     std::condition_variable condMsgProc;
     Mutex mutexMsgProc;
@@ -804,33 +858,19 @@ private:
      */
     std::unique_ptr<i2p::sam::Session> m_i2p_sam_session;
 
-#ifdef USE_WAKEUP_PIPE
-    /** a pipe which is added to select() calls to wakeup before the timeout */
-    int wakeupPipe[2]{-1,-1};
-#endif
-    std::atomic<bool> wakeupSelectNeeded{false};
-
     SocketEventsMode socketEventsMode;
-#ifdef USE_KQUEUE
-    int kqueuefd{-1};
-#endif
-#ifdef USE_EPOLL
-    int epollfd{-1};
-#endif
+    int nSocketThreads{DEFAULT_SOCKET_THREADS};
+    int nMessageHandlerThreads{DEFAULT_MESSAGE_HANDLER_THREADS};
 
-    /** Protected by cs_vNodes */
-    std::unordered_map<NodeId, CNode*> mapReceivableNodes GUARDED_BY(cs_vNodes);
-    std::unordered_map<NodeId, CNode*> mapSendableNodes GUARDED_BY(cs_vNodes);
-    /** Protected by cs_mapNodesWithDataToSend */
-    std::unordered_map<NodeId, CNode*> mapNodesWithDataToSend GUARDED_BY(cs_mapNodesWithDataToSend);
-    mutable RecursiveMutex cs_mapNodesWithDataToSend;
+    /** Never shrinks while the connman exists, the first shard is created by the constructor */
+    std::vector<std::unique_ptr<SocketEventsShard>> m_socket_shards;
 
     std::thread threadDNSAddressSeed;
-    std::thread threadSocketHandler;
     std::thread threadOpenAddedConnections;
     std::thread threadOpenConnections;
     std::thread threadOpenMasternodeConnections;
-    std::thread threadMessageHandler;
+    /** Every node is handled by one of these threads only, chosen by NodeId */
+    std::vector<std::thread> threadMessageHandlers;
     std::thread threadI2PAcceptIncoming;
 
     /** flag for deciding to connect to an extra outbound peer,
@@ -997,6 +1037,26 @@ public:
  * Ideally it should only contain receive time, payload,
  * command and size.
  */
+/**
+ * Payload buffers of received messages. Buffers are handed back once their message was processed and
+ * reused for the following messages, so that parsing messages on a busy connection doesn't allocate.
+ */
+class CNetMessageBufferPool
+{
+public:
+    /** Number of idle buffers kept around */
+    static constexpr size_t MAX_BUFFERS = 4;
+    /** Buffers of larger messages (e.g. blocks) are freed instead of being kept */
+    static constexpr size_t MAX_BUFFER_SIZE = 256 * 1024;
+
+    CDataStream Get(int nTypeIn, int nVersionIn) EXCLUSIVE_LOCKS_REQUIRED(!cs);
+    void Return(CDataStream&& stream, size_t nSize) EXCLUSIVE_LOCKS_REQUIRED(!cs);
+
+private:
+    Mutex cs;
+    std::vector<CDataStream> vBuffers GUARDED_BY(cs);
+};
+
 class CNetMessage {
 public:
     CDataStream m_recv;                  // received message data
@@ -1004,8 +1064,12 @@ public:
     uint32_t m_message_size = 0;         // size of the payload
     uint32_t m_raw_message_size = 0;     // used wire size of the message (including header/checksum)
     std::string m_command;
+    std::shared_ptr<CNetMessageBufferPool> m_pool; // m_recv is returned to it once the message is gone
 
     CNetMessage(CDataStream&& recv_in) : m_recv(std::move(recv_in)) {}
+    CNetMessage(CNetMessage&&) = default;
+    CNetMessage& operator=(CNetMessage&&) = default;
+    ~CNetMessage();
 
     void SetVersion(int nVersionIn)
     {
@@ -1041,6 +1105,7 @@ private:
     CDataStream hdrbuf;             // partially received header
     CMessageHeader hdr;             // complete header
     CDataStream vRecv;              // received message data
+    const std::shared_ptr<CNetMessageBufferPool> m_pool{std::make_shared<CNetMessageBufferPool>()};
     unsigned int nHdrPos;
     unsigned int nDataPos;
 
@@ -1125,7 +1190,8 @@ public:
     /** Offset inside the first vSendMsg already sent */
     size_t nSendOffset GUARDED_BY(cs_vSend){0};
     uint64_t nSendBytes GUARDED_BY(cs_vSend){0};
-    std::list<std::vector<unsigned char>> vSendMsg GUARDED_BY(cs_vSend);
+    /** Queued outbound data; small messages are appended to the last buffer instead of getting their own */
+    std::deque<std::vector<unsigned char>> vSendMsg GUARDED_BY(cs_vSend);
     std::atomic<size_t> nSendMsgSize{0};
     RecursiveMutex cs_vSend;
     RecursiveMutex cs_hSocket;
@@ -1189,12 +1255,16 @@ public:
     std::atomic<bool> m_masternode_probe_connection{false};
     // If 'true', we identified it as an intra-quorum relay connection
     std::atomic<bool> m_masternode_iqr_connection{false};
+    // If 'true', the signature of the MNAUTH is being verified and the node's next messages wait for it
+    std::atomic<bool> m_mnauth_pending{false};
     CSemaphoreGrant grantOutbound;
     std::atomic<int> nRefCount{0};
 
     const uint64_t nKeyedNetGroup;
 
     std::atomic_bool fPauseRecv{false};
+    //! Set while the LLMQ messages of this peer which wait for verification exceed their share of the budget
+    std::atomic_bool fPauseRecvBudget{false};
     std::atomic_bool fPauseSend{false};
 
     std::atomic_bool fHasRecvData{false};
@@ -1354,6 +1424,8 @@ public:
 
     // If true, we will announce/send him plain recovered sigs (usually true for full nodes)
     std::atomic<bool> fSendRecSigs{false};
+    // If true, we will send him ISLOCKs/CLSIGs in compact form, leaving out what he can rebuild from plain recovered sigs
+    std::atomic<bool> fSendCompactLocks{false};
     // If true, we will send him all quorum related messages, even if he is not a member of our quorums
     std::atomic<bool> qwatch{false};
 
@@ -11,6 +11,7 @@
 #include <blockfilter.h>
 #include <chainparams.h>
 #include <consensus/validation.h>
+#include <ctpl_stl.h>
 #include <hash.h>
 #include <index/blockfilterindex.h>
 #include <validation.h>
@@ -19,6 +20,8 @@
 #include <netbase.h>
 #include <net_types.h>
 #include <node/blockstorage.h>
+#include <node/txreconciliation.h>
+#include <policy/packages.h>
 #include <policy/policy.h>
 #include <primitives/block.h>
 #include <primitives/transaction.h>
@@ -29,14 +32,19 @@
 #include <tinyformat.h>
 #include <index/txindex.h>
 #include <txmempool.h>
+#include <txorphanage.h>
 #include <util/check.h> // For NDEBUG compile time check
 #include <util/system.h>
 #include <util/strencodings.h>
+#include <util/threadbudget.h>
+#include <util/trace.h>
 
+#include <deque>
 #include <list>
 #include <memory>
 #include <optional>
 #include <typeinfo>
+#include <unordered_map>
 
 #include <spork.h>
 #include <governance/governance.h>
@@ -58,6 +66,7 @@
 #include <llmq/dkgsessionmgr.h>
 #include <llmq/instantsend.h>
 #include <llmq/options.h>
+#include <llmq/pendingbudget.h>
 #include <llmq/quorums.h>
 #include <llmq/signing.h>
 #include <llmq/signing_shares.h>
@@ -82,10 +91,14 @@ static_assert(INBOUND_PEER_TX_DELAY >= MAX_GETDATA_RANDOM_DELAY,
 /** Limit to avoid sending big packets. Not used in processing incoming GETDATA for compatibility */
 static const unsigned int MAX_GETDATA_SZ = 1000;
 
-/** Expiration time for orphan transactions in seconds */
-static constexpr int64_t ORPHAN_TX_EXPIRE_TIME = 20 * 60;
-/** Minimum time between orphan transactions expire time checks in seconds */
-static constexpr int64_t ORPHAN_TX_EXPIRE_INTERVAL = 5 * 60;
+/** Orphans of a single peer may take up at most this fraction of -maxorphantxsize */
+static constexpr size_t MAX_PEER_ORPHANS_SIZE_DIVISOR = 4;
+/** Version of the package relay protocol sent in SENDPACKAGES */
+static constexpr uint32_t PACKAGE_RELAY_VERSION{1};
+/** How long a peer may take to answer an ancestor package request before another one is made */
+static constexpr std::chrono::seconds PACKAGE_REQUEST_TIMEOUT{30};
+/** Maximum number of filtered blocks prepared ahead per peer, the oldest is dropped first */
+static constexpr size_t MAX_PREPARED_FILTERED_BLOCKS{4};
 /** How long to cache transactions in mapRelay for normal relay */
 static constexpr std::chrono::seconds RELAY_TX_CACHE_TIME = std::chrono::minutes{15};
 /** How long a transaction has to be in the mempool before it can unconditionally be relayed (even when not in mapRelay). */
@@ -118,8 +131,19 @@ static constexpr int HISTORICAL_BLOCK_AGE = 7 * 24 * 60 * 60;
 static const int PING_INTERVAL = 2 * 60;
 /** The maximum number of entries in a locator */
 static const unsigned int MAX_LOCATOR_SZ = 101;
-/** Number of blocks that can be requested at any given time from a single peer. */
+/** Number of blocks that can be requested at any given time from a single peer, until we measured its throughput. */
 static const int MAX_BLOCKS_IN_TRANSIT_PER_PEER = 16;
+/** Bounds of the per-peer block request window, which is scaled with the measured throughput and latency of the peer. */
+static const int MIN_ADAPTIVE_BLOCKS_IN_TRANSIT_PER_PEER = 2;
+static const int MAX_ADAPTIVE_BLOCKS_IN_TRANSIT_PER_PEER = 64;
+/** How much download time (in microseconds) beyond one round trip we keep requested from a peer. */
+static const int64_t BLOCK_DOWNLOAD_PIPELINE_TIME = 1000000;
+/** Number of received blocks of a peer which may wait for their precheck, further messages stay in its receive queue. */
+static const size_t MAX_PENDING_BLOCKS_PER_PEER = MAX_ADAPTIVE_BLOCKS_IN_TRANSIT_PER_PEER;
+/** Weight of a new sample in the moving averages of block download rate, latency and size. */
+static constexpr double BLOCK_DOWNLOAD_STATS_WEIGHT = 0.2;
+/** How many times faster a peer must be to take over the block a slower peer is stalling the download window with. */
+static constexpr double BLOCK_REREQUEST_MIN_SPEEDUP = 2.0;
 /** Timeout in seconds during which a peer must stall block download progress before being disconnected. */
 static const unsigned int BLOCK_STALLING_TIMEOUT = 2;
 /** Maximum depth of blocks we're willing to serve as compact blocks to peers
@@ -164,30 +188,18 @@ static constexpr unsigned int INVENTORY_MAX_RECENT_RELAY = 3500;
  *  lower bound, and it should be larger to account for higher inv rate to outbound
  *  peers, and random variations in the broadcast mechanism. */
 static_assert(INVENTORY_MAX_RECENT_RELAY >= INVENTORY_BROADCAST_PER_SECOND * UNCONDITIONAL_RELAY_DELAY / std::chrono::seconds{1}, "INVENTORY_RELAY_MAX too low");
+/** The number of recovered sigs remembered as known to a peer. */
+static constexpr unsigned int MAX_RECSIGS_KNOWN = 10000;
 /** Maximum number of compact filters that may be requested with one getcfilters. See BIP 157. */
 static constexpr uint32_t MAX_GETCFILTERS_SIZE = 1000;
 /** Maximum number of cf hashes that may be requested with one getcfheaders. See BIP 157. */
 static constexpr uint32_t MAX_GETCFHEADERS_SIZE = 2000;
 /** the maximum percentage of addresses from our addrman to return in response to a getaddr message. */
 static constexpr size_t MAX_PCT_ADDR_TO_SEND = 23;
-
-struct COrphanTx {
-    // When modifying, adapt the copy of this definition in tests/DoS_tests.
-    CTransactionRef tx;
-    NodeId fromPeer;
-    int64_t nTimeExpire;
-    size_t list_pos;
-    size_t nTxSize;
-};
-
-/** Guards orphan transactions and extra txs for compact blocks */
-RecursiveMutex g_cs_orphans;
-/** Map from txid to orphan transaction record. Limited by
- *  -maxorphantx/DEFAULT_MAX_ORPHAN_TRANSACTIONS */
-std::map<uint256, COrphanTx> mapOrphanTransactions GUARDED_BY(g_cs_orphans);
-
-size_t nMapOrphanTransactionsSize = 0;
-void EraseOrphansFor(NodeId peer);
+/** Memory used at most by the serialized headers shared by all peers, see SerializedHeaderCache */
+static constexpr size_t SERIALIZED_HEADER_CACHE_SIZE{16 << 20};
+/** Estimated memory used per cached header besides its serialization (map and list nodes) */
+static constexpr size_t SERIALIZED_HEADER_OVERHEAD{128};
 
 // Internal stuff
 namespace {
@@ -197,6 +209,87 @@ struct QueuedBlock {
     const CBlockIndex* pindex;                               //!< Optional.
     bool fValidatedHeaders;                                  //!< Whether this block has validated headers at the time of request.
     std::unique_ptr<PartiallyDownloadedBlock> partialBlock;  //!< Optional, used for CMPCTBLOCK downloads
+    int64_t nTimeRequested;                                  //!< When the block was requested (in microseconds).
+};
+
+/** A BLOCK message handed to the block precheck workers, in the order it was received from the peer */
+struct PendingBlock {
+    CDataStream vRecv;
+    const int64_t nTimeReceived;
+    //! The deserialized block, set by the worker unless deserialization failed
+    std::shared_ptr<CBlock> pblock;
+    //! Why deserialization failed
+    std::string strError;
+    //! Set by the worker once it is done with this entry
+    std::atomic<bool> fDone{false};
+
+    PendingBlock(CDataStream&& vRecvIn, int64_t nTimeReceivedIn) : vRecv(std::move(vRecvIn)), nTimeReceived(nTimeReceivedIn) {}
+};
+
+/**
+ * Serialized headers of recently sent blocks, shared by all peers. HEADERS messages are assembled by
+ * copying these bytes, so a header (including the auxpow of a merge-mined block, which is read from disk)
+ * is built and serialized once rather than for every announcement and every getheaders request.
+ */
+class SerializedHeaderCache
+{
+    struct Entry {
+        //! The header followed by a zero transaction count, as in HEADERS
+        std::vector<uint8_t> bytes;
+        std::list<const CBlockIndex*>::iterator lru_it;
+    };
+
+    Mutex m_mutex;
+    std::unordered_map<const CBlockIndex*, Entry> m_headers GUARDED_BY(m_mutex);
+    std::list<const CBlockIndex*> m_lru GUARDED_BY(m_mutex);
+    size_t m_size GUARDED_BY(m_mutex){0};
+
+    /** Append the serialized header of pindex to out, serializing and caching it if needed */
+    void Append(const CBlockIndex* pindex, const Consensus::Params& params, std::vector<uint8_t>& out) EXCLUSIVE_LOCKS_REQUIRED(!m_mutex)
+    {
+        {
+            LOCK(m_mutex);
+            const auto it = m_headers.find(pindex);
+            if (it != m_headers.end()) {
+                m_lru.splice(m_lru.begin(), m_lru, it->second.lru_it);
+                out.insert(out.end(), it->second.bytes.begin(), it->second.bytes.end());
+                return;
+            }
+        }
+        // Built without holding the lock, merge-mined headers are read from disk
+        std::vector<uint8_t> bytes;
+        CVectorWriter writer{SER_NETWORK, PROTOCOL_VERSION, bytes, 0};
+        writer << pindex->GetBlockHeader(params);
+        WriteCompactSize(writer, 0);
+        out.insert(out.end(), bytes.begin(), bytes.end());
+
+        LOCK(m_mutex);
+        if (m_headers.count(pindex)) return;
+        m_size += bytes.size() + SERIALIZED_HEADER_OVERHEAD;
+        m_lru.push_front(pindex);
+        m_headers.emplace(pindex, Entry{std::move(bytes), m_lru.begin()});
+        while (m_size > SERIALIZED_HEADER_CACHE_SIZE) {
+            const auto it = m_headers.find(m_lru.back());
+            m_size -= it->second.bytes.size() + SERIALIZED_HEADER_OVERHEAD;
+            m_headers.erase(it);
+            m_lru.pop_back();
+        }
+    }
+
+public:
+    /** Build a HEADERS message of the given headers, equal to serializing them as CBlocks without transactions */
+    CSerializedNetMsg MakeHeadersMsg(const std::vector<const CBlockIndex*>& headers, const Consensus::Params& params) EXCLUSIVE_LOCKS_REQUIRED(!m_mutex)
+    {
+        CSerializedNetMsg msg;
+        msg.command = NetMsgType::HEADERS;
+        msg.data.reserve(GetSizeOfCompactSize(headers.size()) + headers.size() * 81); // pure header and transaction count
+        CVectorWriter writer{SER_NETWORK, PROTOCOL_VERSION, msg.data, 0};
+        WriteCompactSize(writer, headers.size());
+        for (const CBlockIndex* pindex : headers) {
+            Append(pindex, params, msg.data);
+        }
+        return msg;
+    }
 };
 
 /**
@@ -223,16 +316,83 @@ struct Peer {
     /** Set of txids to reconsider once their parent transactions have been accepted **/
     std::set<uint256> m_orphan_work_set GUARDED_BY(g_cs_orphans);
 
+    /** Whether we both signaled package relay in SENDPACKAGES **/
+    std::atomic<bool> m_package_relay{false};
+
+    /** An ancestor package requested from this peer, there is at most one at a time **/
+    struct PackageRequest {
+        /** The orphan whose ancestor package is requested */
+        uint256 m_txid;
+        /** The txids of the package announced in ANCPKGINFO, parents first. Empty until then. */
+        std::vector<uint256> m_package;
+        std::chrono::microseconds m_time;
+    };
+    std::optional<PackageRequest> m_package_request GUARDED_BY(g_cs_orphans);
+
+    /** A filtered block built for this peer when the block was connected, serialized and ready to send **/
+    struct PreparedFilteredBlock {
+        uint256 m_block_hash;
+        /** MERKLEBLOCK followed by the matched transactions and their ISDLOCKs */
+        std::vector<CSerializedNetMsg> m_msgs;
+    };
+    /** Protects m_prepared_filtered_blocks **/
+    Mutex m_prepared_filtered_blocks_mutex;
+    /** Filtered blocks of the most recently connected blocks, oldest first **/
+    std::deque<PreparedFilteredBlock> m_prepared_filtered_blocks GUARDED_BY(m_prepared_filtered_blocks_mutex);
+
     /** Protects m_getdata_requests **/
     Mutex m_getdata_requests_mutex;
     /** Work queue of items requested by this peer **/
     std::deque<CInv> m_getdata_requests GUARDED_BY(m_getdata_requests_mutex);
 
+    /** Protects m_pending_blocks **/
+    Mutex m_pending_blocks_mutex;
+    /** Blocks received from this peer which are prechecked on the block precheck workers, in order of arrival **/
+    std::deque<std::shared_ptr<PendingBlock>> m_pending_blocks GUARDED_BY(m_pending_blocks_mutex);
+
+    /** Protects m_recsigs_known **/
+    Mutex m_recsigs_known_mutex;
+    /** Recovered sigs this peer announced, sent or was announced. Apart from the tx inventory filter, so that tx relay
+     *  doesn't push them out. Allocated with the first recovered sig **/
+    std::unique_ptr<CRollingBloomFilter> m_recsigs_known GUARDED_BY(m_recsigs_known_mutex);
+
+    /** Remember that this peer knows a recovered sig, returns false if it was known already **/
+    bool AddKnownRecoveredSig(const uint256& hash) LOCKS_EXCLUDED(m_recsigs_known_mutex)
+    {
+        LOCK(m_recsigs_known_mutex);
+        if (!m_recsigs_known) {
+            m_recsigs_known = std::make_unique<CRollingBloomFilter>(MAX_RECSIGS_KNOWN, 0.000001);
+        } else if (m_recsigs_known->contains(hash)) {
+            return false;
+        }
+        m_recsigs_known->insert(hash);
+        return true;
+    }
+
     explicit Peer(NodeId id) : m_id(id) {}
 };
 
 using PeerRef = std::shared_ptr<Peer>;
 
+/**
+ * Messages which neither touch validation state nor rely on other messages being processed in the
+ * meantime. Their handlers are guarded by their own locks, so they are processed outside of
+ * m_serial_msgproc_mutex when there are several message handler threads. ProcessMessage only hands
+ * them to the handler owning them, keep both in sync.
+ */
+bool IsParallelMessage(const std::string& msg_type)
+{
+    return msg_type == NetMsgType::QSIGSESANN ||
+           msg_type == NetMsgType::QSIGSHARESINV ||
+           msg_type == NetMsgType::QGETSIGSHARES ||
+           msg_type == NetMsgType::QBSIGSHARES ||
+           msg_type == NetMsgType::QSIGSHARE ||
+           msg_type == NetMsgType::QSIGSHARESBUNDLE ||
+           msg_type == NetMsgType::SPORK ||
+           msg_type == NetMsgType::GETSPORKS ||
+           msg_type == NetMsgType::MNAUTH;
+}
+
 class PeerManagerImpl final : public PeerManager
 {
 public:
@@ -247,6 +407,7 @@ public:
     void UpdatedBlockTip(const CBlockIndex *pindexNew, const CBlockIndex *pindexFork, bool fInitialDownload) override;
     void BlockChecked(const CBlock& block, const BlockValidationState& state) override;
     void NewPoWValidBlock(const CBlockIndex *pindex, const std::shared_ptr<const CBlock>& pblock) override;
+    void NotifyTransactionLock(const CTransactionRef& tx, const std::shared_ptr<const llmq::CInstantSendLock>& islock) override;
 
     /** Implement NetEventsInterface */
     void InitializeNode(CNode* pnode) override;
@@ -257,6 +418,7 @@ public:
     /** Implement PeerManager */
     void CheckForStaleTipAndEvictPeers() override;
     bool GetNodeStateStats(NodeId nodeid, CNodeStateStats& stats) override;
+    std::map<std::string, NetMsgStats> GetNetMsgStats(bool reset) override;
     bool IgnoresIncomingTxs() override { return m_ignore_incoming_txs; }
     void RelayTransaction(const uint256& txid) override;
     void SetBestHeight(int height) override { m_best_height = height; };
@@ -269,6 +431,9 @@ private:
     /** Helper to process result of external handlers of message */
     void ProcessPeerMsgRet(const PeerMsgRet& ret, CNode& pfrom);
 
+    /** Account the queue wait and processing time of a received message */
+    void RecordNetMsgStats(const std::string& msg_type, int64_t wait_us, int64_t process_us);
+
     /** Consider evicting an outbound peer based on the amount of time they've been behind our tip */
     void ConsiderEviction(CNode& pto, int64_t time_in_seconds) EXCLUSIVE_LOCKS_REQUIRED(cs_main);
 
@@ -315,8 +480,27 @@ private:
      */
     bool MaybeDiscourageAndDisconnect(CNode& pnode);
 
-    void ProcessOrphanTx(std::set<uint256>& orphan_work_set)
+    void ProcessOrphanTx(std::set<uint256>& orphan_work_set, bool process_all = false)
         EXCLUSIVE_LOCKS_REQUIRED(cs_main, g_cs_orphans);
+
+    /** Request the parents of an orphan one by one */
+    void RequestOrphanParents(CNode& pfrom, const CTransaction& tx) EXCLUSIVE_LOCKS_REQUIRED(cs_main);
+
+    /**
+     * Ask a package relay peer for the ancestor package of an orphan it sent us. Returns false
+     * if a request to the peer is still pending, in which case the parents are to be requested
+     * one by one. An expired request falls back to that as well.
+     */
+    bool MaybeRequestAncestorPackage(CNode& pfrom, Peer& peer, const uint256& txid) EXCLUSIVE_LOCKS_REQUIRED(cs_main, g_cs_orphans);
+
+    /**
+     * Submit the ancestor package announced by a peer as one package. Its transactions are taken from
+     * received, the orphanage or, if they are in the mempool already, left out.
+     */
+    void ProcessAncestorPackage(CNode& pfrom, Peer& peer, const std::vector<CTransactionRef>& received) EXCLUSIVE_LOCKS_REQUIRED(cs_main, g_cs_orphans);
+
+    /** Storage for orphan information */
+    TxOrphanage m_orphanage;
     /** Process a single headers message from a peer. */
     void ProcessHeadersMessage(CNode& pfrom, const std::vector<CBlockHeader>& headers, bool via_compact_block);
 
@@ -345,6 +529,46 @@ private:
     /** Whether this node is running in blocks only mode */
     const bool m_ignore_incoming_txs;
 
+    /** Whether ancestor packages are relayed with peers that support it (-packagerelay) */
+    const bool m_package_relay;
+
+    /** Per-peer state of the transaction reconciliation protocol, nullptr if -txreconciliation is off */
+    std::unique_ptr<TxReconciliationTracker> m_txreconciliation;
+
+    /** Announce transactions which the peer turned out to miss during reconciliation */
+    void AnnounceReconciledTxs(CNode& peer, const std::vector<uint256>& txids);
+
+    /** Serialized headers shared by the HEADERS messages to all peers */
+    SerializedHeaderCache m_headers_cache;
+
+    /**
+     * Deserializes received blocks and does their context-free checks (PoW, merkle root, transactions)
+     * while the message handler is busy with other work. No threads with -blockprecheckthreads=0.
+     * Declared last so that it is stopped before anything the workers use is destroyed.
+     */
+    ctpl::thread_pool m_block_precheck_pool;
+
+    /**
+     * Builds the filtered blocks of connected blocks for peers with a bloom filter, so that their
+     * MERKLEBLOCK requests are answered from prepared messages. No threads with -filteredblockthreads=0.
+     */
+    ctpl::thread_pool m_filtered_block_pool;
+
+    /**
+     * Serializes the message processing of the message handler threads, except for the messages
+     * which IsParallelMessage() allows to be processed concurrently for different peers.
+     */
+    Mutex m_serial_msgproc_mutex;
+
+    /** Diffs served in MNLISTDIFF messages */
+    CSimplifiedMNListDiffCache m_mnlistdiff_cache;
+    /** Responses served in QUORUMROTATIONINFO messages */
+    llmq::CQuorumRotationInfoCache m_qrinfo_cache;
+
+    Mutex m_net_msg_stats_mutex;
+    /** Per message type processing times. Holds all known types and NET_MESSAGE_COMMAND_OTHER, unknown ones are never added */
+    std::map<std::string, NetMsgStats> m_net_msg_stats GUARDED_BY(m_net_msg_stats_mutex);
+
     /** Protects m_peer_map */
     mutable Mutex m_peer_mutex;
     /**
@@ -370,6 +594,15 @@ private:
     bool BlockRequestAllowed(const CBlockIndex* pindex, const Consensus::Params& consensusParams) EXCLUSIVE_LOCKS_REQUIRED(cs_main);
     bool AlreadyHaveBlock(const uint256& block_hash) EXCLUSIVE_LOCKS_REQUIRED(cs_main);
     void ProcessGetBlockData(CNode& pfrom, const CChainParams& chainparams, const CInv& inv, CConnman& connman, llmq::CInstantSendManager& isman);
+    /**
+     * Serialize the MERKLEBLOCK, TX and ISDLOCK messages answering a filtered block request of node,
+     * updating its bloom filter. Returns false if the node has no filter loaded.
+     */
+    bool MakeFilteredBlockMsgs(CNode& node, const CBlock& block, llmq::CInstantSendManager& isman, std::vector<CSerializedNetMsg>& msgs);
+    /** Build the filtered block of a connected block for every peer with a bloom filter on m_filtered_block_pool */
+    void PrepareFilteredBlocks(const std::shared_ptr<const CBlock>& pblock);
+    /** Move out the messages prepared for a filtered block request of the peer, if any */
+    bool TakePreparedFilteredBlock(NodeId nodeid, const uint256& hash, std::vector<CSerializedNetMsg>& msgs);
 
     /**
      * Validation logic for compact filters request handling.
@@ -498,12 +731,16 @@ private:
      */
     bool MarkBlockAsInFlight(NodeId nodeid, const uint256& hash, const CBlockIndex* pindex = nullptr, std::list<QueuedBlock>::iterator** pit = nullptr) EXCLUSIVE_LOCKS_REQUIRED(cs_main);
 
+    /** Update the download rate and latency estimates of a peer which sent us a block we requested from it */
+    void UpdateBlockDownloadStats(NodeId nodeid, const uint256& hash, size_t nBlockSize, int64_t nTimeReceived) EXCLUSIVE_LOCKS_REQUIRED(cs_main);
+
     bool TipMayBeStale() EXCLUSIVE_LOCKS_REQUIRED(cs_main);
 
     /** Update pindexLastCommonBlock and add not-in-flight missing successors to vBlocks, until it has
-     *  at most count entries.
+     *  at most count entries. If the download window can't move, nodeStaller is set to the peer holding
+     *  it up and ppindexStaller (if given) to the in-flight block it is waiting for.
      */
-    void FindNextBlocksToDownload(NodeId nodeid, unsigned int count, std::vector<const CBlockIndex*>& vBlocks, NodeId& nodeStaller) EXCLUSIVE_LOCKS_REQUIRED(cs_main);
+    void FindNextBlocksToDownload(NodeId nodeid, unsigned int count, std::vector<const CBlockIndex*>& vBlocks, NodeId& nodeStaller, const CBlockIndex** ppindexStaller = nullptr) EXCLUSIVE_LOCKS_REQUIRED(cs_main);
 
     std::map<uint256, std::pair<NodeId, std::list<QueuedBlock>::iterator> > mapBlocksInFlight GUARDED_BY(cs_main);
 
@@ -517,6 +754,15 @@ private:
 
     void ProcessBlock(CNode& pfrom, const std::shared_ptr<const CBlock>& pblock, bool fForceProcessing);
 
+    /** Process a block received in a BLOCK message */
+    void ProcessReceivedBlock(CNode& pfrom, const std::shared_ptr<CBlock>& pblock, int64_t nTimeReceived);
+
+    /** Hand a BLOCK message to the block precheck workers, to deserialize it and do the context-free checks in advance */
+    void QueueBlockPrecheck(Peer& peer, CDataStream& vRecv, int64_t nTimeReceived);
+
+    /** Process the oldest block of the peer if its precheck is done. Returns whether another one is ready. */
+    bool ProcessPendingBlock(CNode& pfrom, Peer& peer);
+
     /** Relay map (txid -> CTransactionRef) */
     typedef std::map<uint256, CTransactionRef> MapRelay;
     MapRelay mapRelay GUARDED_BY(cs_main);
@@ -544,27 +790,19 @@ namespace {
     /** Number of preferable block download peers. */
     int nPreferredDownload GUARDED_BY(cs_main) = 0;
 
-    struct IteratorComparator
-    {
-        template<typename I>
-        bool operator()(const I& a, const I& b) const
-        {
-            return &(*a) < &(*b);
-        }
-    };
-
-    /** Index from the parents' COutPoint into the mapOrphanTransactions. Used
-     *  to remove orphan transactions from the mapOrphanTransactions */
-    std::map<COutPoint, std::set<std::map<uint256, COrphanTx>::iterator, IteratorComparator>> mapOrphanTransactionsByPrev GUARDED_BY(g_cs_orphans);
-    /** Orphan transactions in vector for quick random eviction */
-    std::vector<std::map<uint256, COrphanTx>::iterator> g_orphan_list GUARDED_BY(g_cs_orphans);
-
     /** Orphan/conflicted/etc transactions that are kept for compact block reconstruction.
      *  The last -blockreconstructionextratxn/DEFAULT_BLOCK_RECONSTRUCTION_EXTRA_TXN of
      *  these are kept in a ring buffer */
     static std::vector<std::pair<uint256, CTransactionRef>> vExtraTxnForCompact GUARDED_BY(g_cs_orphans);
     /** Offset into vExtraTxnForCompact to insert the next tx */
     static size_t vExtraTxnForCompactIt GUARDED_BY(g_cs_orphans) = 0;
+
+    /** The last -blockreconstructionislocktxn/DEFAULT_BLOCK_RECONSTRUCTION_ISLOCK_TXN InstantSend-locked
+     *  transactions, kept for compact block reconstruction in a ring buffer. Miners include them even
+     *  when they were evicted from our mempool or lost against a conflict. */
+    static std::vector<std::pair<uint256, CTransactionRef>> vIsLockedTxnForCompact GUARDED_BY(g_cs_orphans);
+    /** Offset into vIsLockedTxnForCompact to insert the next tx */
+    static size_t vIsLockedTxnForCompactIt GUARDED_BY(g_cs_orphans) = 0;
 } // namespace
 
 namespace {
@@ -598,6 +836,16 @@ struct CNodeState {
     int64_t nDownloadingSince;
     int nBlocksInFlight;
     int nBlocksInFlightValidHeaders;
+    //! How many blocks we currently allow to be in flight from this peer.
+    int nBlockDownloadWindow;
+    //! Moving average of the block download rate from this peer (in bytes per second), 0 until we received a block.
+    double dBlockDownloadRate;
+    //! Moving average of the time between requesting a block and receiving it (in microseconds).
+    int64_t nBlockDownloadLatency;
+    //! Moving average of the size of the blocks we downloaded from this peer (in bytes).
+    double dBlockDownloadAvgSize;
+    //! When we last received a block we requested from this peer (in microseconds).
+    int64_t nLastBlockReceived;
     //! Whether we consider this a preferred download peer.
     bool fPreferredDownload;
     //! Whether this peer wants invs or headers (when possible) for block announcements.
@@ -737,6 +985,11 @@ struct CNodeState {
         nDownloadingSince = 0;
         nBlocksInFlight = 0;
         nBlocksInFlightValidHeaders = 0;
+        nBlockDownloadWindow = MAX_BLOCKS_IN_TRANSIT_PER_PEER;
+        dBlockDownloadRate = 0;
+        nBlockDownloadLatency = 0;
+        dBlockDownloadAvgSize = 0;
+        nLastBlockReceived = 0;
         fPreferredDownload = false;
         fPreferHeaders = false;
         fPreferHeadersCompressed = false;
@@ -797,6 +1050,50 @@ bool PeerManagerImpl::MarkBlockAsReceived(const uint256& hash)
     return false;
 }
 
+void PeerManagerImpl::UpdateBlockDownloadStats(NodeId nodeid, const uint256& hash, size_t nBlockSize, int64_t nTimeReceived)
+{
+    const auto itInFlight = mapBlocksInFlight.find(hash);
+    if (itInFlight == mapBlocksInFlight.end() || itInFlight->second.first != nodeid) {
+        // Only blocks the peer sent on our request tell something about its link
+        return;
+    }
+    CNodeState *state = State(nodeid);
+    assert(state != nullptr);
+
+    const int64_t nNow = nTimeReceived;
+    const int64_t nTimeRequested = itInFlight->second.second->nTimeRequested;
+    const int64_t nLatency = std::max<int64_t>(nNow - nTimeRequested, 0);
+    // While the peer has several blocks queued, the time since the previous one arrived is
+    // what this block took to transfer, otherwise it's the time since we requested it.
+    const int64_t nTransferTime = std::max<int64_t>(nNow - std::max(state->nLastBlockReceived, nTimeRequested), 1000);
+    const double dRate = nBlockSize * 1000000.0 / nTransferTime;
+    if (state->dBlockDownloadRate == 0) {
+        state->dBlockDownloadRate = dRate;
+        state->nBlockDownloadLatency = nLatency;
+        state->dBlockDownloadAvgSize = nBlockSize;
+    } else {
+        state->dBlockDownloadRate += BLOCK_DOWNLOAD_STATS_WEIGHT * (dRate - state->dBlockDownloadRate);
+        state->nBlockDownloadLatency += BLOCK_DOWNLOAD_STATS_WEIGHT * (nLatency - state->nBlockDownloadLatency);
+        state->dBlockDownloadAvgSize += BLOCK_DOWNLOAD_STATS_WEIGHT * (nBlockSize - state->dBlockDownloadAvgSize);
+    }
+    state->nLastBlockReceived = nNow;
+}
+
+/** Number of blocks we want in flight from a peer, based on its throughput and round trip time */
+int GetBlockDownloadWindow(const CNodeState& state, int64_t nPingUsec)
+{
+    if (state.dBlockDownloadRate == 0 || state.dBlockDownloadAvgSize < 1) {
+        // Nothing measured yet
+        return MAX_BLOCKS_IN_TRANSIT_PER_PEER;
+    }
+    // Without a ping result yet, the block latency is an upper bound of the round trip time
+    const int64_t nRoundTrip = nPingUsec == std::numeric_limits<int64_t>::max() ? state.nBlockDownloadLatency : nPingUsec;
+    // Keep enough blocks requested to cover a round trip plus some transfer time (the
+    // bandwidth-delay product), so the link of the peer never runs idle waiting for our getdata.
+    const double dBlocks = state.dBlockDownloadRate * (nRoundTrip + BLOCK_DOWNLOAD_PIPELINE_TIME) / 1000000.0 / state.dBlockDownloadAvgSize;
+    return std::clamp<int>(std::ceil(std::min<double>(dBlocks, MAX_ADAPTIVE_BLOCKS_IN_TRANSIT_PER_PEER)), MIN_ADAPTIVE_BLOCKS_IN_TRANSIT_PER_PEER, MAX_ADAPTIVE_BLOCKS_IN_TRANSIT_PER_PEER);
+}
+
 bool PeerManagerImpl::MarkBlockAsInFlight(NodeId nodeid, const uint256& hash, const CBlockIndex *pindex, std::list<QueuedBlock>::iterator **pit)
 {
     CNodeState *state = State(nodeid);
@@ -815,7 +1112,7 @@ bool PeerManagerImpl::MarkBlockAsInFlight(NodeId nodeid, const uint256& hash, co
     MarkBlockAsReceived(hash);
 
     std::list<QueuedBlock>::iterator it = state->vBlocksInFlight.insert(state->vBlocksInFlight.end(),
-            {hash, pindex, pindex != nullptr, std::unique_ptr<PartiallyDownloadedBlock>(pit ? new PartiallyDownloadedBlock(&m_mempool) : nullptr)});
+            {hash, pindex, pindex != nullptr, std::unique_ptr<PartiallyDownloadedBlock>(pit ? new PartiallyDownloadedBlock(&m_mempool) : nullptr), GetTime<std::chrono::microseconds>().count()});
     state->nBlocksInFlight++;
     state->nBlocksInFlightValidHeaders += it->fValidatedHeaders;
     if (state->nBlocksInFlight == 1) {
@@ -925,7 +1222,7 @@ void PeerManagerImpl::UpdateBlockAvailability(NodeId nodeid, const uint256 &hash
     }
 }
 
-void PeerManagerImpl::FindNextBlocksToDownload(NodeId nodeid, unsigned int count, std::vector<const CBlockIndex*>& vBlocks, NodeId& nodeStaller)
+void PeerManagerImpl::FindNextBlocksToDownload(NodeId nodeid, unsigned int count, std::vector<const CBlockIndex*>& vBlocks, NodeId& nodeStaller, const CBlockIndex** ppindexStaller)
 {
     if (count == 0)
         return;
@@ -962,6 +1259,7 @@ void PeerManagerImpl::FindNextBlocksToDownload(NodeId nodeid, unsigned int count
     int nWindowEnd = state->pindexLastCommonBlock->nHeight + BLOCK_DOWNLOAD_WINDOW;
     int nMaxHeight = std::min<int>(state->pindexBestKnownBlock->nHeight, nWindowEnd + 1);
     NodeId waitingfor = -1;
+    const CBlockIndex* pindexWaitingFor = nullptr;
     while (pindexWalk->nHeight < nMaxHeight) {
         // Read up to 128 (or more, if more blocks than that are needed) successors of pindexWalk (towards
         // pindexBestKnownBlock) into vToFetch. We fetch 128, because CBlockIndex::GetAncestor may be as expensive
@@ -993,6 +1291,7 @@ void PeerManagerImpl::FindNextBlocksToDownload(NodeId nodeid, unsigned int count
                     if (vBlocks.size() == 0 && waitingfor != nodeid) {
                         // We aren't able to fetch anything, but we would be if the download window was one larger.
                         nodeStaller = waitingfor;
+                        if (ppindexStaller) *ppindexStaller = pindexWaitingFor;
                     }
                     return;
                 }
@@ -1003,6 +1302,7 @@ void PeerManagerImpl::FindNextBlocksToDownload(NodeId nodeid, unsigned int count
             } else if (waitingfor == -1) {
                 // This is the first already-in-flight block.
                 waitingfor = mapBlocksInFlight[pindex->GetBlockHash()].first;
+                pindexWaitingFor = pindex;
             }
         }
     }
@@ -1252,7 +1552,9 @@ void PeerManagerImpl::FinalizeNode(const CNode& node) {
     for (const QueuedBlock& entry : state->vBlocksInFlight) {
         mapBlocksInFlight.erase(entry.hash);
     }
-    EraseOrphansFor(nodeid);
+    WITH_LOCK(g_cs_orphans, m_orphanage.EraseForPeer(nodeid));
+    if (m_txreconciliation) m_txreconciliation->ForgetPeer(nodeid);
+    llmq::pendingMessagesBudget.RemoveNode(nodeid);
     nPreferredDownload -= state->fPreferredDownload;
     nPeersWithValidatedDownloads -= (state->nBlocksInFlightValidHeaders != 0);
     assert(nPeersWithValidatedDownloads >= 0);
@@ -1312,6 +1614,9 @@ bool PeerManagerImpl::GetNodeStateStats(NodeId nodeid, CNodeStateStats &stats)
             if (queue.pindex)
                 stats.vHeightInFlight.push_back(queue.pindex->nHeight);
         }
+        stats.nBlockDownloadWindow = state->nBlockDownloadWindow;
+        stats.dBlockDownloadRate = state->dBlockDownloadRate;
+        stats.nBlockDownloadLatency = state->nBlockDownloadLatency;
     }
 
     PeerRef peer = GetPeerRef(nodeid);
@@ -1323,7 +1628,7 @@ bool PeerManagerImpl::GetNodeStateStats(NodeId nodeid, CNodeStateStats &stats)
 
 //////////////////////////////////////////////////////////////////////////////
 //
-// mapOrphanTransactions
+// orphan transactions
 //
 
 static void AddToCompactExtraTransactions(const CTransactionRef& tx) EXCLUSIVE_LOCKS_REQUIRED(g_cs_orphans)
@@ -1337,129 +1642,15 @@ static void AddToCompactExtraTransactions(const CTransactionRef& tx) EXCLUSIVE_L
     vExtraTxnForCompactIt = (vExtraTxnForCompactIt + 1) % max_extra_txn;
 }
 
-bool AddOrphanTx(const CTransactionRef& tx, NodeId peer) EXCLUSIVE_LOCKS_REQUIRED(g_cs_orphans)
-{
-    const uint256& hash = tx->GetHash();
-    if (mapOrphanTransactions.count(hash))
-        return false;
-
-    // Ignore big transactions, to avoid a
-    // send-big-orphans memory exhaustion attack. If a peer has a legitimate
-    // large transaction with a missing parent then we assume
-    // it will rebroadcast it later, after the parent transaction(s)
-    // have been mined or received.
-    // 100 orphans, each of which is at most 99,999 bytes big is
-    // at most 10 megabytes of orphans and somewhat more byprev index (in the worst case):
-    unsigned int sz = GetSerializeSize(*tx, CTransaction::CURRENT_VERSION);
-    if (sz > MAX_STANDARD_TX_SIZE)
-    {
-        LogPrint(BCLog::MEMPOOL, "ignoring large orphan tx (size: %u, hash: %s)\n", sz, hash.ToString());
-        return false;
-    }
-
-    auto ret = mapOrphanTransactions.emplace(hash, COrphanTx{tx, peer, GetTime() + ORPHAN_TX_EXPIRE_TIME, g_orphan_list.size(), sz});
-    assert(ret.second);
-    g_orphan_list.push_back(ret.first);
-    for (const CTxIn& txin : tx->vin) {
-        mapOrphanTransactionsByPrev[txin.prevout].insert(ret.first);
-    }
-
-    AddToCompactExtraTransactions(tx);
-
-    nMapOrphanTransactionsSize += sz;
-
-    LogPrint(BCLog::MEMPOOL, "stored orphan tx %s (mapsz %u outsz %u)\n", hash.ToString(),
-             mapOrphanTransactions.size(), mapOrphanTransactionsByPrev.size());
-    statsClient.inc("transactions.orphans.add", 1.0f);
-    statsClient.gauge("transactions.orphans", mapOrphanTransactions.size());
-    return true;
-}
-
-int static EraseOrphanTx(uint256 hash) EXCLUSIVE_LOCKS_REQUIRED(g_cs_orphans)
+static void AddToCompactIsLockedTransactions(const CTransactionRef& tx) EXCLUSIVE_LOCKS_REQUIRED(g_cs_orphans)
 {
-    std::map<uint256, COrphanTx>::iterator it = mapOrphanTransactions.find(hash);
-    if (it == mapOrphanTransactions.end())
-        return 0;
-    for (const CTxIn& txin : it->second.tx->vin)
-    {
-        auto itPrev = mapOrphanTransactionsByPrev.find(txin.prevout);
-        if (itPrev == mapOrphanTransactionsByPrev.end())
-            continue;
-        itPrev->second.erase(it);
-        if (itPrev->second.empty())
-            mapOrphanTransactionsByPrev.erase(itPrev);
-    }
-
-    size_t old_pos = it->second.list_pos;
-    assert(g_orphan_list[old_pos] == it);
-    if (old_pos + 1 != g_orphan_list.size()) {
-        // Unless we're deleting the last entry in g_orphan_list, move the last
-        // entry to the position we're deleting.
-        auto it_last = g_orphan_list.back();
-        g_orphan_list[old_pos] = it_last;
-        it_last->second.list_pos = old_pos;
-    }
-    g_orphan_list.pop_back();
-
-    assert(nMapOrphanTransactionsSize >= it->second.nTxSize);
-    nMapOrphanTransactionsSize -= it->second.nTxSize;
-    mapOrphanTransactions.erase(it);
-    statsClient.inc("transactions.orphans.remove", 1.0f);
-    statsClient.gauge("transactions.orphans", mapOrphanTransactions.size());
-    return 1;
-}
-
-void EraseOrphansFor(NodeId peer)
-{
-    LOCK(g_cs_orphans);
-    int nErased = 0;
-    std::map<uint256, COrphanTx>::iterator iter = mapOrphanTransactions.begin();
-    while (iter != mapOrphanTransactions.end())
-    {
-        std::map<uint256, COrphanTx>::iterator maybeErase = iter++; // increment to avoid iterator becoming invalid
-        if (maybeErase->second.fromPeer == peer)
-        {
-            nErased += EraseOrphanTx(maybeErase->second.tx->GetHash());
-        }
-    }
-    if (nErased > 0) LogPrint(BCLog::MEMPOOL, "Erased %d orphan tx from peer=%d\n", nErased, peer);
-}
-
-
-unsigned int LimitOrphanTxSize(unsigned int nMaxOrphansSize)
-{
-    LOCK(g_cs_orphans);
-
-    unsigned int nEvicted = 0;
-    static int64_t nNextSweep;
-    int64_t nNow = GetTime();
-    if (nNextSweep <= nNow) {
-        // Sweep out expired orphan pool entries:
-        int nErased = 0;
-        int64_t nMinExpTime = nNow + ORPHAN_TX_EXPIRE_TIME - ORPHAN_TX_EXPIRE_INTERVAL;
-        std::map<uint256, COrphanTx>::iterator iter = mapOrphanTransactions.begin();
-        while (iter != mapOrphanTransactions.end())
-        {
-            std::map<uint256, COrphanTx>::iterator maybeErase = iter++;
-            if (maybeErase->second.nTimeExpire <= nNow) {
-                nErased += EraseOrphanTx(maybeErase->second.tx->GetHash());
-            } else {
-                nMinExpTime = std::min(maybeErase->second.nTimeExpire, nMinExpTime);
-            }
-        }
-        // Sweep again 5 minutes after the next entry that expires in order to batch the linear scan.
-        nNextSweep = nMinExpTime + ORPHAN_TX_EXPIRE_INTERVAL;
-        if (nErased > 0) LogPrint(BCLog::MEMPOOL, "Erased %d orphan tx due to expiration\n", nErased);
-    }
-    FastRandomContext rng;
-    while (!mapOrphanTransactions.empty() && nMapOrphanTransactionsSize > nMaxOrphansSize)
-    {
-        // Evict a random orphan:
-        size_t randompos = rng.randrange(g_orphan_list.size());
-        EraseOrphanTx(g_orphan_list[randompos]->first);
-        ++nEvicted;
-    }
-    return nEvicted;
+    size_t max_islock_txn = gArgs.GetArg("-blockreconstructionislocktxn", DEFAULT_BLOCK_RECONSTRUCTION_ISLOCK_TXN);
+    if (max_islock_txn <= 0)
+        return;
+    if (!vIsLockedTxnForCompact.size())
+        vIsLockedTxnForCompact.resize(max_islock_txn);
+    vIsLockedTxnForCompact[vIsLockedTxnForCompactIt] = std::make_pair(tx->GetHash(), tx);
+    vIsLockedTxnForCompactIt = (vIsLockedTxnForCompactIt + 1) % max_islock_txn;
 }
 
 void PeerManagerImpl::Misbehaving(const NodeId pnode, const int howmuch, const std::string& message)
@@ -1606,15 +1797,36 @@ PeerManagerImpl::PeerManagerImpl(const CChainParams& chainparams, CConnman& conn
       m_cj_ctx(cj_ctx),
       m_llmq_ctx(llmq_ctx),
       m_govman(govman),
-      m_ignore_incoming_txs(ignore_incoming_txs)
+      m_ignore_incoming_txs(ignore_incoming_txs),
+      m_package_relay(gArgs.GetBoolArg("-packagerelay", DEFAULT_PACKAGE_RELAY))
 {
+    if (gArgs.GetBoolArg("-txreconciliation", DEFAULT_TXRECONCILIATION_ENABLE)) {
+        m_txreconciliation = std::make_unique<TxReconciliationTracker>(TXRECONCILIATION_VERSION);
+    }
+    {
+        LOCK(m_net_msg_stats_mutex);
+        for (const std::string& msg_type : getAllNetMessageTypes()) {
+            m_net_msg_stats[msg_type];
+        }
+        m_net_msg_stats[NET_MESSAGE_COMMAND_OTHER];
+    }
+    const int nPrecheckThreads = std::clamp<int>(gArgs.GetArg("-blockprecheckthreads", GetThreadBudget(TaskPriority::CONSENSUS, DEFAULT_BLOCK_PRECHECK_THREADS)), 0, MAX_BLOCK_PRECHECK_THREADS);
+    if (nPrecheckThreads > 0) {
+        m_block_precheck_pool.resize(nPrecheckThreads);
+        RenameThreadPool(m_block_precheck_pool, "blkprecheck");
+    }
+    const int nFilteredBlockThreads = std::clamp<int>(gArgs.GetArg("-filteredblockthreads", GetThreadBudget(TaskPriority::BACKGROUND, DEFAULT_FILTERED_BLOCK_THREADS)), 0, MAX_FILTERED_BLOCK_THREADS);
+    if (nFilteredBlockThreads > 0) {
+        m_filtered_block_pool.resize(nFilteredBlockThreads);
+        RenameThreadPool(m_filtered_block_pool, "filteredblk");
+    }
     assert(std::addressof(g_chainman) == std::addressof(m_chainman));
     // Stale tip checking and peer eviction are on two different timers, but we
     // don't want them to get out of sync due to drift in the scheduler, so we
     // combine them in one function and schedule at the quicker (peer-eviction)
     // timer.
     static_assert(EXTRA_PEER_CHECK_INTERVAL < STALE_CHECK_INTERVAL, "peer eviction timer should be less than stale tip check timer");
-    scheduler.scheduleEvery([this] { this->CheckForStaleTipAndEvictPeers(); }, std::chrono::seconds{EXTRA_PEER_CHECK_INTERVAL});
+    scheduler.scheduleEvery([this] { this->CheckForStaleTipAndEvictPeers(); }, std::chrono::seconds{EXTRA_PEER_CHECK_INTERVAL}, SchedulerLane::NETWORK, "stalecheck");
 
     // schedule next run for 10-15 minutes in the future
     const std::chrono::milliseconds delta = std::chrono::minutes{10} + GetRandMillis(std::chrono::minutes{5});
@@ -1622,7 +1834,7 @@ PeerManagerImpl::PeerManagerImpl(const CChainParams& chainparams, CConnman& conn
 }
 
 /**
- * Evict orphan txn pool entries (EraseOrphanTx) based on a newly connected
+ * Evict orphan txn pool entries based on a newly connected
  * block. Also save the time of the last tip update.
  */
 void PeerManagerImpl::BlockConnected(const std::shared_ptr<const CBlock>& pblock, const CBlockIndex* pindex)
@@ -1630,45 +1842,12 @@ void PeerManagerImpl::BlockConnected(const std::shared_ptr<const CBlock>& pblock
     {
         LOCK2(cs_main, g_cs_orphans);
 
-        std::vector<uint256> vOrphanErase;
         std::set<uint256> orphanWorkSet;
+        m_orphanage.EraseForBlock(*pblock, orphanWorkSet);
 
-        for (const CTransactionRef& ptx : pblock->vtx) {
-            const CTransaction& tx = *ptx;
-
-            // Which orphan pool entries we should reprocess and potentially try to accept into mempool again?
-            for (size_t i = 0; i < tx.vin.size(); i++) {
-                auto itByPrev = mapOrphanTransactionsByPrev.find(COutPoint(tx.GetHash(), (uint32_t)i));
-                if (itByPrev == mapOrphanTransactionsByPrev.end()) continue;
-                for (const auto& elem : itByPrev->second) {
-                    orphanWorkSet.insert(elem->first);
-                }
-            }
-
-            // Which orphan pool entries must we evict?
-            for (const auto& txin : tx.vin) {
-                auto itByPrev = mapOrphanTransactionsByPrev.find(txin.prevout);
-                if (itByPrev == mapOrphanTransactionsByPrev.end()) continue;
-                for (auto mi = itByPrev->second.begin(); mi != itByPrev->second.end(); ++mi) {
-                    const CTransaction& orphanTx = *(*mi)->second.tx;
-                    const uint256& orphanHash = orphanTx.GetHash();
-                    vOrphanErase.push_back(orphanHash);
-                }
-            }
-        }
-
-        // Erase orphan transactions included or precluded by this block
-        if (vOrphanErase.size()) {
-            int nErased = 0;
-            for (const uint256& orphanHash : vOrphanErase) {
-                nErased += EraseOrphanTx(orphanHash);
-            }
-            LogPrint(BCLog::MEMPOOL, "Erased %d orphan tx included or conflicted by block\n", nErased);
-        }
-
-        while (!orphanWorkSet.empty()) {
+        if (!orphanWorkSet.empty()) {
             LogPrint(BCLog::MEMPOOL, "Trying to process %d orphans\n", orphanWorkSet.size());
-            ProcessOrphanTx(orphanWorkSet);
+            ProcessOrphanTx(orphanWorkSet, /*process_all=*/true);
         }
 
         m_last_tip_update = GetTime();
@@ -1679,6 +1858,9 @@ void PeerManagerImpl::BlockConnected(const std::shared_ptr<const CBlock>& pblock
             m_recent_confirmed_transactions.insert(ptx->GetHash());
         }
     }
+    if (!m_chainman.ActiveChainstate().IsInitialBlockDownload()) {
+        PrepareFilteredBlocks(pblock);
+    }
 }
 
 void PeerManagerImpl::BlockDisconnected(const std::shared_ptr<const CBlock> &block, const CBlockIndex* pindex)
@@ -1779,9 +1961,20 @@ void PeerManagerImpl::UpdatedBlockTip(const CBlockIndex *pindexNew, const CBlock
             }
         });
         m_connman.WakeMessageHandler();
+
+        // After the announcements, light clients will ask for diffs to this block as soon as they see it
+        if (m_llmq_ctx) {
+            m_mnlistdiff_cache.UpdatedBlockTip(pindexNew, *m_llmq_ctx->quorum_block_processor);
+        }
     }
 }
 
+void PeerManagerImpl::NotifyTransactionLock(const CTransactionRef& tx, const std::shared_ptr<const llmq::CInstantSendLock>& islock)
+{
+    LOCK(g_cs_orphans);
+    AddToCompactIsLockedTransactions(tx);
+}
+
 /**
  * Handle invalid block rejection and consequent peer discouragement, maintain which
  * peers announce compact blocks.
@@ -1840,10 +2033,7 @@ bool PeerManagerImpl::AlreadyHave(const CInv& inv)
                 m_recent_rejects.reset();
             }
 
-            {
-                LOCK(g_cs_orphans);
-                if (mapOrphanTransactions.count(inv.hash)) return true;
-            }
+            if (m_orphanage.HaveTx(inv.hash)) return true;
 
             {
                 LOCK(m_recent_confirmed_transactions_mutex);
@@ -1867,7 +2057,7 @@ bool PeerManagerImpl::AlreadyHave(const CInv& inv)
                                         m_llmq_ctx->isman->IsLocked(inv.hash);
 
             return (!fIgnoreRecentRejects && m_recent_rejects.contains(inv.hash)) ||
-                   (inv.IsMsgDstx() && static_cast<bool>(::dstxManager->GetDSTX(inv.hash))) ||
+                   (inv.IsMsgDstx() && ::dstxManager->HasDSTX(inv.hash)) ||
                    m_mempool.exists(inv.hash) ||
                    (g_txindex != nullptr && g_txindex->HasTx(inv.hash));
         }
@@ -1917,13 +2107,34 @@ bool PeerManagerImpl::AlreadyHaveBlock(const uint256& block_hash)
 
 void PeerManagerImpl::RelayTransaction(const uint256& txid)
 {
-    CInv inv(::dstxManager->GetDSTX(txid) ? MSG_DSTX : MSG_TX, txid);
+    CInv inv(::dstxManager->HasDSTX(txid) ? MSG_DSTX : MSG_TX, txid);
     m_connman.ForEachNode([&inv](CNode* pnode)
     {
         pnode->PushInventory(inv);
     });
 }
 
+void PeerManagerImpl::AnnounceReconciledTxs(CNode& peer, const std::vector<uint256>& txids)
+{
+    const CNetMsgMaker msgMaker(peer.GetCommonVersion());
+    std::vector<CInv> vInv;
+    LOCK(peer.m_tx_relay->cs_tx_inventory);
+    for (const uint256& txid : txids) {
+        if (peer.m_tx_relay->filterInventoryKnown.contains(txid) || !m_mempool.exists(txid)) {
+            continue;
+        }
+        peer.m_tx_relay->filterInventoryKnown.insert(txid);
+        vInv.emplace_back(MSG_TX, txid);
+        if (vInv.size() == MAX_INV_SZ) {
+            m_connman.PushMessage(&peer, msgMaker.Make(NetMsgType::INV, vInv));
+            vInv.clear();
+        }
+    }
+    if (!vInv.empty()) {
+        m_connman.PushMessage(&peer, msgMaker.Make(NetMsgType::INV, vInv));
+    }
+}
+
 static void RelayAddress(const CAddress& addr, bool fReachable, const CConnman& connman)
 {
     if (!fReachable && !addr.IsRelayable()) return;
@@ -1963,6 +2174,80 @@ static void RelayAddress(const CAddress& addr, bool fReachable, const CConnman&
     connman.ForEachNodeThen(std::move(sortfunc), std::move(pushfunc));
 }
 
+bool PeerManagerImpl::MakeFilteredBlockMsgs(CNode& node, const CBlock& block, llmq::CInstantSendManager& isman, std::vector<CSerializedNetMsg>& msgs)
+{
+    if (!node.RelayAddrsWithConn()) return false;
+    CMerkleBlock merkleBlock;
+    {
+        LOCK(node.m_tx_relay->cs_filter);
+        if (!node.m_tx_relay->pfilter) return false;
+        merkleBlock = CMerkleBlock(block, *node.m_tx_relay->pfilter);
+    }
+    const CNetMsgMaker msgMaker(node.GetCommonVersion());
+    msgs.push_back(msgMaker.Make(NetMsgType::MERKLEBLOCK, merkleBlock));
+    // CMerkleBlock just contains hashes, so also push any transactions in the block the client did not see
+    // This avoids hurting performance by pointlessly requiring a round-trip
+    // Note that there is currently no way for a node to request any single transactions we didn't send here -
+    // they must either disconnect and retry or request the full block.
+    // Thus, the protocol spec specified allows for us to provide duplicate txn here,
+    // however we MUST always provide at least what the remote peer needs
+    for (const auto& [index, txid] : merkleBlock.vMatchedTxn) {
+        msgs.push_back(msgMaker.Make(NetMsgType::TX, *block.vtx[index]));
+    }
+    for (const auto& [index, txid] : merkleBlock.vMatchedTxn) {
+        auto islock = isman.GetInstantSendLockByTxid(txid);
+        if (islock != nullptr) {
+            msgs.push_back(msgMaker.Make(NetMsgType::ISDLOCK, *islock));
+        }
+    }
+    return true;
+}
+
+void PeerManagerImpl::PrepareFilteredBlocks(const std::shared_ptr<const CBlock>& pblock)
+{
+    if (m_filtered_block_pool.size() == 0) return;
+
+    const std::vector<CNode*> nodes = m_connman.CopyNodeVector([](const CNode* pnode) {
+        if (!pnode->fSuccessfullyConnected || pnode->fDisconnect || !pnode->RelayAddrsWithConn()) return false;
+        LOCK(pnode->m_tx_relay->cs_filter);
+        return pnode->m_tx_relay->pfilter != nullptr;
+    });
+    for (CNode* pnode : nodes) {
+        PeerRef peer = GetPeerRef(pnode->GetId());
+        if (!peer) {
+            pnode->Release();
+            continue;
+        }
+        // The node reference taken by CopyNodeVector is released by the worker
+        m_filtered_block_pool.push([this, pblock, pnode, peer](int) {
+            std::vector<CSerializedNetMsg> msgs;
+            if (MakeFilteredBlockMsgs(*pnode, *pblock, *m_llmq_ctx->isman, msgs)) {
+                LOCK(peer->m_prepared_filtered_blocks_mutex);
+                peer->m_prepared_filtered_blocks.push_back({pblock->GetHash(), std::move(msgs)});
+                if (peer->m_prepared_filtered_blocks.size() > MAX_PREPARED_FILTERED_BLOCKS) {
+                    peer->m_prepared_filtered_blocks.pop_front();
+                }
+            }
+            pnode->Release();
+        });
+    }
+}
+
+bool PeerManagerImpl::TakePreparedFilteredBlock(NodeId nodeid, const uint256& hash, std::vector<CSerializedNetMsg>& msgs)
+{
+    PeerRef peer = GetPeerRef(nodeid);
+    if (!peer) return false;
+    LOCK(peer->m_prepared_filtered_blocks_mutex);
+    auto& prepared = peer->m_prepared_filtered_blocks;
+    const auto it = std::find_if(prepared.begin(), prepared.end(), [&hash](const Peer::PreparedFilteredBlock& entry) {
+        return entry.m_block_hash == hash;
+    });
+    if (it == prepared.end()) return false;
+    msgs = std::move(it->m_msgs);
+    prepared.erase(it);
+    return true;
+}
+
 void PeerManagerImpl::ProcessGetBlockData(CNode& pfrom, const CChainParams& chainparams, const CInv& inv, CConnman& connman, llmq::CInstantSendManager& isman)
 {
     bool send = false;
@@ -2034,8 +2319,21 @@ void PeerManagerImpl::ProcessGetBlockData(CNode& pfrom, const CChainParams& chai
     if (send && (pindex->nStatus & BLOCK_HAVE_DATA))
     {
         std::shared_ptr<const CBlock> pblock;
-        if (a_recent_block && a_recent_block->GetHash() == pindex->GetBlockHash()) {
+        std::vector<CSerializedNetMsg> prepared_msgs;
+        if (inv.IsMsgFilteredBlk() && TakePreparedFilteredBlock(pfrom.GetId(), pindex->GetBlockHash(), prepared_msgs)) {
+            // Built by the filtered block workers when the block was connected
+            for (CSerializedNetMsg& msg : prepared_msgs) {
+                connman.PushMessage(&pfrom, std::move(msg));
+            }
+        } else if (a_recent_block && a_recent_block->GetHash() == pindex->GetBlockHash()) {
             pblock = a_recent_block;
+        } else if (inv.IsMsgBlk()) {
+            // Send block from disk as it is stored, without deserializing and reserializing it
+            const auto raw_block{ReadRawBlockFromDisk(pindex->GetBlockPos(), chainparams.MessageStart())};
+            if (!raw_block) {
+                assert(!"cannot load block from disk");
+            }
+            connman.PushMessage(&pfrom, msgMaker.Make(NetMsgType::BLOCK, Span{*raw_block}));
         } else {
             // Send block from disk
             std::shared_ptr<CBlock> pblockRead = std::make_shared<CBlock>();
@@ -2047,32 +2345,10 @@ void PeerManagerImpl::ProcessGetBlockData(CNode& pfrom, const CChainParams& chai
             if (inv.IsMsgBlk()) {
                 connman.PushMessage(&pfrom, msgMaker.Make(NetMsgType::BLOCK, *pblock));
             } else if (inv.IsMsgFilteredBlk()) {
-                bool sendMerkleBlock = false;
-                CMerkleBlock merkleBlock;
-                if (pfrom.RelayAddrsWithConn()) {
-                    LOCK(pfrom.m_tx_relay->cs_filter);
-                    if (pfrom.m_tx_relay->pfilter) {
-                        sendMerkleBlock = true;
-                        merkleBlock = CMerkleBlock(*pblock, *pfrom.m_tx_relay->pfilter);
-                    }
-                }
-                if (sendMerkleBlock) {
-                    connman.PushMessage(&pfrom, msgMaker.Make(NetMsgType::MERKLEBLOCK, merkleBlock));
-                    // CMerkleBlock just contains hashes, so also push any transactions in the block the client did not see
-                    // This avoids hurting performance by pointlessly requiring a round-trip
-                    // Note that there is currently no way for a node to request any single transactions we didn't send here -
-                    // they must either disconnect and retry or request the full block.
-                    // Thus, the protocol spec specified allows for us to provide duplicate txn here,
-                    // however we MUST always provide at least what the remote peer needs
-                    typedef std::pair<unsigned int, uint256> PairType;
-                    for (PairType &pair : merkleBlock.vMatchedTxn) {
-                        connman.PushMessage(&pfrom, msgMaker.Make(NetMsgType::TX, *pblock->vtx[pair.first]));
-                    }
-                    for (PairType &pair : merkleBlock.vMatchedTxn) {
-                        auto islock = isman.GetInstantSendLockByTxid(pair.second);
-                        if (islock != nullptr) {
-                            connman.PushMessage(&pfrom, msgMaker.Make(NetMsgType::ISDLOCK, *islock));
-                        }
+                std::vector<CSerializedNetMsg> msgs;
+                if (MakeFilteredBlockMsgs(pfrom, *pblock, isman, msgs)) {
+                    for (CSerializedNetMsg& msg : msgs) {
+                        connman.PushMessage(&pfrom, std::move(msg));
                     }
                 }
                 // else
@@ -2370,6 +2646,16 @@ void PeerManagerImpl::ProcessHeadersMessage(CNode& pfrom, const std::vector<CBlo
         return;
     }
 
+    // Hash the headers and check their proof of work in parallel before taking
+    // cs_main, so that only contextual checks are done while holding the lock.
+    std::vector<uint256> pow_hashes;
+    if (!CheckHeadersProofOfWork(headers, pow_hashes, m_chainparams.GetConsensus())) {
+        BlockValidationState state;
+        state.Invalid(BlockValidationResult::BLOCK_INVALID_HEADER, "high-hash", "proof of work failed");
+        MaybePunishNodeForBlock(pfrom.GetId(), state, via_compact_block, "invalid header received");
+        return;
+    }
+
     bool received_new_header = false;
     const CBlockIndex *pindexLast = nullptr;
     {
@@ -2389,7 +2675,7 @@ void PeerManagerImpl::ProcessHeadersMessage(CNode& pfrom, const std::vector<CBlo
             std::string msg_type = (pfrom.nServices & NODE_HEADERS_COMPRESSED) ? NetMsgType::GETHEADERS2 : NetMsgType::GETHEADERS;
             m_connman.PushMessage(&pfrom, msgMaker.Make(msg_type, m_chainman.ActiveChain().GetLocator(pindexBestHeader), uint256()));
             LogPrint(BCLog::NET, "received header %s: missing prev block %s, sending %s (%d) to end (peer=%d, nUnconnectingHeaders=%d)\n",
-                    headers[0].GetHash().ToString(),
+                    pow_hashes[0].ToString(),
                     headers[0].hashPrevBlock.ToString(),
                     msg_type,
                     pindexBestHeader->nHeight,
@@ -2397,7 +2683,7 @@ void PeerManagerImpl::ProcessHeadersMessage(CNode& pfrom, const std::vector<CBlo
             // Set hashLastUnknownBlock for this peer, so that if we
             // eventually get the headers - even from a different peer -
             // we can use this peer to download.
-            UpdateBlockAvailability(pfrom.GetId(), headers.back().GetHash());
+            UpdateBlockAvailability(pfrom.GetId(), pow_hashes.back());
 
             if (nodestate->nUnconnectingHeaders % MAX_UNCONNECTING_HEADERS == 0) {
                 Misbehaving(pfrom.GetId(), 20, strprintf("%d non-connecting headers", nodestate->nUnconnectingHeaders));
@@ -2406,12 +2692,12 @@ void PeerManagerImpl::ProcessHeadersMessage(CNode& pfrom, const std::vector<CBlo
         }
 
         uint256 hashLastBlock;
-        for (const CBlockHeader& header : headers) {
-            if (!hashLastBlock.IsNull() && header.hashPrevBlock != hashLastBlock) {
+        for (size_t i = 0; i < nCount; ++i) {
+            if (!hashLastBlock.IsNull() && headers[i].hashPrevBlock != hashLastBlock) {
                 Misbehaving(pfrom.GetId(), 20, "non-continuous headers sequence");
                 return;
             }
-            hashLastBlock = header.GetHash();
+            hashLastBlock = pow_hashes[i];
         }
 
         // If we don't have the last header, then they'll have given us
@@ -2422,7 +2708,7 @@ void PeerManagerImpl::ProcessHeadersMessage(CNode& pfrom, const std::vector<CBlo
     }
 
     BlockValidationState state;
-    if (!m_chainman.ProcessNewBlockHeaders(headers, state, m_chainparams, &pindexLast)) {
+    if (!m_chainman.ProcessNewBlockHeaders(headers, state, m_chainparams, &pindexLast, &pow_hashes)) {
         if (state.IsInvalid()) {
             MaybePunishNodeForBlock(pfrom.GetId(), state, via_compact_block, "invalid header received");
             return;
@@ -2484,7 +2770,7 @@ void PeerManagerImpl::ProcessHeadersMessage(CNode& pfrom, const std::vector<CBlo
                 std::vector<CInv> vGetData;
                 // Download as much as possible, from earliest to latest.
                 for (const CBlockIndex *pindex : reverse_iterate(vToFetch)) {
-                    if (nodestate->nBlocksInFlight >= MAX_BLOCKS_IN_TRANSIT_PER_PEER) {
+                    if (nodestate->nBlocksInFlight >= nodestate->nBlockDownloadWindow) {
                         // Can't download any more from this peer
                         break;
                     }
@@ -2550,8 +2836,113 @@ void PeerManagerImpl::ProcessHeadersMessage(CNode& pfrom, const std::vector<CBlo
  *                                  orphan will be reconsidered on each call of this function. This set
  *                                  may be added to if accepting an orphan causes its children to be
  *                                  reconsidered.
+ * @param[in]      process_all      Reconsider the whole set (and the children it grows by) in one go,
+ *                                  used to resolve all orphans that a new block unblocked as one batch.
  */
-void PeerManagerImpl::ProcessOrphanTx(std::set<uint256>& orphan_work_set)
+void PeerManagerImpl::RequestOrphanParents(CNode& pfrom, const CTransaction& tx)
+{
+    AssertLockHeld(cs_main);
+
+    const auto current_time = GetTime<std::chrono::microseconds>();
+    for (const CTxIn& txin : tx.vin) {
+        CInv _inv(MSG_TX, txin.prevout.hash);
+        pfrom.AddKnownInventory(_inv.hash);
+        if (!AlreadyHave(_inv)) RequestObject(State(pfrom.GetId()), _inv, current_time);
+        // We don't know if the previous tx was a regular or a mixing one, try both
+        CInv _inv2(MSG_DSTX, txin.prevout.hash);
+        pfrom.AddKnownInventory(_inv2.hash);
+        if (!AlreadyHave(_inv2)) RequestObject(State(pfrom.GetId()), _inv2, current_time);
+    }
+}
+
+bool PeerManagerImpl::MaybeRequestAncestorPackage(CNode& pfrom, Peer& peer, const uint256& txid)
+{
+    AssertLockHeld(cs_main);
+    AssertLockHeld(g_cs_orphans);
+
+    const auto current_time = GetTime<std::chrono::microseconds>();
+    if (peer.m_package_request) {
+        if (current_time < peer.m_package_request->m_time + PACKAGE_REQUEST_TIMEOUT) return false;
+        LogPrint(BCLog::NET, "ancestor package request for %s to peer=%d timed out\n", peer.m_package_request->m_txid.ToString(), pfrom.GetId());
+        if (const auto [orphan, from_peer] = m_orphanage.GetTx(peer.m_package_request->m_txid); orphan) {
+            RequestOrphanParents(pfrom, *orphan);
+        }
+    }
+    peer.m_package_request = Peer::PackageRequest{txid, {}, current_time};
+    m_connman.PushMessage(&pfrom, CNetMsgMaker(pfrom.GetCommonVersion()).Make(NetMsgType::GETPKGINFO, txid));
+    return true;
+}
+
+void PeerManagerImpl::ProcessAncestorPackage(CNode& pfrom, Peer& peer, const std::vector<CTransactionRef>& received)
+{
+    AssertLockHeld(cs_main);
+    AssertLockHeld(g_cs_orphans);
+
+    const std::vector<uint256> txids = std::move(peer.m_package_request->m_package);
+    peer.m_package_request.reset();
+
+    std::map<uint256, CTransactionRef> received_by_txid;
+    for (const CTransactionRef& tx : received) {
+        received_by_txid.emplace(tx->GetHash(), tx);
+    }
+
+    Package package;
+    for (const uint256& txid : txids) {
+        if (m_mempool.exists(txid)) continue;
+        if (const auto it = received_by_txid.find(txid); it != received_by_txid.end()) {
+            package.push_back(it->second);
+        } else if (const auto [orphan, from_peer] = m_orphanage.GetTx(txid); orphan) {
+            package.push_back(orphan);
+        } else {
+            LogPrint(BCLog::MEMPOOL, "ancestor package of %s from peer=%d misses %s\n", txids.back().ToString(), pfrom.GetId(), txid.ToString());
+            return;
+        }
+    }
+    // Everything made it into the mempool in the meantime
+    if (package.empty()) return;
+
+    const PackageMempoolAcceptResult result = ProcessNewPackage(m_chainman.ActiveChainstate(), m_mempool, package, /* test_accept */ false);
+    if (result.m_state.IsInvalid()) {
+        LogPrint(BCLog::MEMPOOLREJ, "ancestor package of %s from peer=%d was not accepted: %s\n", txids.back().ToString(),
+                 pfrom.GetId(), result.m_state.ToString());
+        if (result.m_state.GetResult() == PackageValidationResult::PCKG_POLICY) {
+            // The package as a whole doesn't fit our policy, don't fetch it again for the same orphan
+            m_recent_rejects.insert(txids.back());
+            m_orphanage.EraseTx(txids.back());
+        }
+    }
+
+    for (const CTransactionRef& ptx : package) {
+        const uint256& txid = ptx->GetHash();
+        const auto it = result.m_tx_results.find(txid);
+        // Validation stopped before this transaction
+        if (it == result.m_tx_results.end()) continue;
+        const MempoolAcceptResult& tx_result = it->second;
+
+        if (tx_result.m_result_type == MempoolAcceptResult::ResultType::VALID) {
+            RelayTransaction(txid);
+            m_orphanage.AddChildrenToWorkSet(*ptx, peer.m_orphan_work_set);
+            m_orphanage.EraseTx(txid);
+            pfrom.nLastTXTime = GetTime();
+            LogPrint(BCLog::MEMPOOL, "AcceptToMemoryPool: peer=%d: accepted %s in package (poolsz %u txn, %u kB)\n",
+                     pfrom.GetId(), txid.ToString(), m_mempool.size(), m_mempool.DynamicMemoryUsage() / 1000);
+        } else if (tx_result.m_state.GetResult() != TxValidationResult::TX_MISSING_INPUTS) {
+            m_recent_rejects.insert(txid);
+            m_orphanage.EraseTx(txid);
+            if (tx_result.m_state.IsInvalid()) {
+                // Only the transactions the peer sent us count against it, the others came from the orphanage
+                if (received_by_txid.count(txid)) MaybePunishNodeForTx(pfrom.GetId(), tx_result.m_state);
+                m_llmq_ctx->isman->TransactionRemovedFromMempool(ptx);
+            }
+        }
+    }
+    m_mempool.check(m_chainman.ActiveChainstate());
+
+    // Recursively process any orphan transactions that depended on the package
+    ProcessOrphanTx(peer.m_orphan_work_set);
+}
+
+void PeerManagerImpl::ProcessOrphanTx(std::set<uint256>& orphan_work_set, bool process_all)
 {
     AssertLockHeld(cs_main);
     AssertLockHeld(g_cs_orphans);
@@ -2560,41 +2951,33 @@ void PeerManagerImpl::ProcessOrphanTx(std::set<uint256>& orphan_work_set)
         const uint256 orphanHash = *orphan_work_set.begin();
         orphan_work_set.erase(orphan_work_set.begin());
 
-        auto orphan_it = mapOrphanTransactions.find(orphanHash);
-        if (orphan_it == mapOrphanTransactions.end()) continue;
+        const auto [porphanTx, from_peer] = m_orphanage.GetTx(orphanHash);
+        if (porphanTx == nullptr) continue;
 
-        const CTransactionRef porphanTx = orphan_it->second.tx;
         const MempoolAcceptResult result = AcceptToMemoryPool(m_chainman.ActiveChainstate(), m_mempool, porphanTx, false /* bypass_limits */);
         const TxValidationState& state = result.m_state;
 
         if (result.m_result_type == MempoolAcceptResult::ResultType::VALID) {
             LogPrint(BCLog::MEMPOOL, "   accepted orphan tx %s\n", orphanHash.ToString());
             RelayTransaction(porphanTx->GetHash());
-            for (unsigned int i = 0; i < porphanTx->vout.size(); i++) {
-                auto it_by_prev = mapOrphanTransactionsByPrev.find(COutPoint(orphanHash, i));
-                if (it_by_prev != mapOrphanTransactionsByPrev.end()) {
-                    for (const auto& elem : it_by_prev->second) {
-                        orphan_work_set.insert(elem->first);
-                    }
-                }
-            }
-            EraseOrphanTx(orphanHash);
-            break;
+            m_orphanage.AddChildrenToWorkSet(*porphanTx, orphan_work_set);
+            m_orphanage.EraseTx(orphanHash);
+            if (!process_all) break;
         } else if (state.GetResult() != TxValidationResult::TX_MISSING_INPUTS) {
             if (state.IsInvalid()) {
                 LogPrint(BCLog::MEMPOOL, "   invalid orphan tx %s from peer=%d. %s\n",
                     orphanHash.ToString(),
-                    orphan_it->second.fromPeer,
+                    from_peer,
                     state.ToString());
                 // Maybe punish peer that gave us an invalid orphan tx
-                MaybePunishNodeForTx(orphan_it->second.fromPeer, state);
+                MaybePunishNodeForTx(from_peer, state);
             }
             // Has inputs but not accepted to mempool
             // Probably non-standard or insufficient fee
             LogPrint(BCLog::MEMPOOL, "   removed orphan tx %s\n", orphanHash.ToString());
             m_recent_rejects.insert(orphanHash);
-            EraseOrphanTx(orphanHash);
-            break;
+            m_orphanage.EraseTx(orphanHash);
+            if (!process_all) break;
         }
     }
     m_mempool.check(m_chainman.ActiveChainstate());
@@ -2779,7 +3162,7 @@ std::pair<bool /*ret*/, bool /*do_return*/> static ValidateDSTX(CTxMemPool& memp
         LogPrint(BCLog::COINJOIN, "DSTX -- Invalid DSTX structure: %s\n", hashTx.ToString());
         return {false, true};
     }
-    if (::dstxManager->GetDSTX(hashTx)) {
+    if (::dstxManager->HasDSTX(hashTx)) {
         LogPrint(BCLog::COINJOIN, "DSTX -- Already have %s, skipping...\n", hashTx.ToString());
         return {true, true}; // not an error
     }
@@ -2848,6 +3231,71 @@ void PeerManagerImpl::ProcessBlock(CNode& pfrom, const std::shared_ptr<const CBl
     }
 }
 
+void PeerManagerImpl::ProcessReceivedBlock(CNode& pfrom, const std::shared_ptr<CBlock>& pblock, int64_t nTimeReceived)
+{
+    LogPrint(BCLog::NET, "received block %s peer=%d\n", pblock->GetHash().ToString(), pfrom.GetId());
+
+    bool forceProcessing = false;
+    const uint256 hash(pblock->GetHash());
+    {
+        LOCK(cs_main);
+        UpdateBlockDownloadStats(pfrom.GetId(), hash, ::GetSerializeSize(*pblock, PROTOCOL_VERSION), nTimeReceived);
+        // Also always process if we requested the block explicitly, as we may
+        // need it even though it is not a candidate for a new best tip.
+        forceProcessing |= MarkBlockAsReceived(hash);
+        // mapBlockSource is only used for punishing peers and setting
+        // which peers send us compact blocks, so the race between here and
+        // cs_main in ProcessNewBlock is fine.
+        mapBlockSource.emplace(hash, std::make_pair(pfrom.GetId(), true));
+    }
+    ProcessBlock(pfrom, pblock, forceProcessing);
+}
+
+void PeerManagerImpl::QueueBlockPrecheck(Peer& peer, CDataStream& vRecv, int64_t nTimeReceived)
+{
+    auto pending = std::make_shared<PendingBlock>(std::move(vRecv), nTimeReceived);
+    WITH_LOCK(peer.m_pending_blocks_mutex, peer.m_pending_blocks.push_back(pending));
+
+    m_block_precheck_pool.push([this, pending](int) {
+        try {
+            auto pblock = std::make_shared<CBlock>();
+            pending->vRecv >> *pblock;
+            // A block failing here is left unmarked, CheckBlock() rejects it again under cs_main
+            // and takes care of punishing the peer.
+            BlockValidationState state;
+            PreCheckBlock(*pblock, state, m_chainparams.GetConsensus());
+            pending->pblock = std::move(pblock);
+        } catch (const std::exception& e) {
+            pending->strError = e.what();
+        }
+        pending->fDone = true;
+        m_connman.WakeMessageHandler();
+    });
+}
+
+bool PeerManagerImpl::ProcessPendingBlock(CNode& pfrom, Peer& peer)
+{
+    std::shared_ptr<PendingBlock> pending;
+    {
+        LOCK(peer.m_pending_blocks_mutex);
+        if (peer.m_pending_blocks.empty() || !peer.m_pending_blocks.front()->fDone) return false;
+        pending = std::move(peer.m_pending_blocks.front());
+        peer.m_pending_blocks.pop_front();
+    }
+
+    // Also checked when queueing, but we may have started importing in the meantime
+    if (fImporting || fReindex) {
+        LogPrint(BCLog::NET, "Unexpected block message received from peer %d\n", pfrom.GetId());
+    } else if (pending->pblock) {
+        ProcessReceivedBlock(pfrom, pending->pblock, pending->nTimeReceived);
+    } else {
+        LogPrint(BCLog::NET, "%s(%s): Exception '%s' caught\n", __func__, NetMsgType::BLOCK, pending->strError);
+    }
+
+    LOCK(peer.m_pending_blocks_mutex);
+    return !peer.m_pending_blocks.empty() && peer.m_pending_blocks.front()->fDone;
+}
+
 void PeerManagerImpl::ProcessPeerMsgRet(const PeerMsgRet& ret, CNode& pfrom)
 {
     if (!ret) Misbehaving(pfrom.GetId(), ret.error().score, ret.error().message);
@@ -2984,6 +3432,18 @@ void PeerManagerImpl::ProcessMessage(
             m_connman.PushMessage(&pfrom, msg_maker.Make(NetMsgType::SENDADDRV2));
         }
 
+        // Signal support for transaction reconciliation, but only if we are going to relay
+        // transactions with this peer at all.
+        if (m_txreconciliation && fRelay && !m_ignore_incoming_txs && pfrom.RelayAddrsWithConn() && !pfrom.IsBlockRelayOnly()) {
+            const uint64_t recon_salt = m_txreconciliation->PreRegisterPeer(pfrom.GetId());
+            m_connman.PushMessage(&pfrom, msg_maker.Make(NetMsgType::SENDSIDRECON, TXRECONCILIATION_VERSION, recon_salt));
+        }
+
+        // Signal support for package relay under the same conditions
+        if (m_package_relay && fRelay && !m_ignore_incoming_txs && pfrom.RelayAddrsWithConn() && !pfrom.IsBlockRelayOnly()) {
+            m_connman.PushMessage(&pfrom, msg_maker.Make(NetMsgType::SENDPACKAGES, PACKAGE_RELAY_VERSION));
+        }
+
         m_connman.PushMessage(&pfrom, msg_maker.Make(NetMsgType::VERACK));
 
         pfrom.nServices = nServices;
@@ -3149,6 +3609,64 @@ void PeerManagerImpl::ProcessMessage(
         return;
     }
 
+    // Received from a peer demonstrating readiness to announce transactions via reconciliations.
+    // This feature negotiation must happen between VERSION and VERACK to avoid relay problems
+    // from switching announcement protocols after the connection is up.
+    if (msg_type == NetMsgType::SENDSIDRECON) {
+        if (!m_txreconciliation) {
+            LogPrint(BCLog::NET, "sendsidrecon from peer=%d ignored, as our node does not have txreconciliation enabled\n", pfrom.GetId());
+            return;
+        }
+
+        if (pfrom.fSuccessfullyConnected) {
+            LogPrint(BCLog::NET, "sendtxrcncl received after verack from peer=%d; disconnecting\n", pfrom.GetId());
+            pfrom.fDisconnect = true;
+            return;
+        }
+
+        uint32_t peer_txreconcl_version;
+        uint64_t remote_salt;
+        vRecv >> peer_txreconcl_version >> remote_salt;
+
+        const ReconciliationRegisterResult result = m_txreconciliation->RegisterPeer(pfrom.GetId(), pfrom.IsInboundConn(),
+                                                                                     peer_txreconcl_version, remote_salt);
+        switch (result) {
+        case ReconciliationRegisterResult::NOT_FOUND:
+            LogPrint(BCLog::NET, "Ignore unexpected txreconciliation signal from peer=%d\n", pfrom.GetId());
+            break;
+        case ReconciliationRegisterResult::SUCCESS:
+            break;
+        case ReconciliationRegisterResult::ALREADY_REGISTERED:
+            LogPrint(BCLog::NET, "txreconciliation protocol violation from peer=%d (sendtxrcncl received from already registered peer); disconnecting\n", pfrom.GetId());
+            pfrom.fDisconnect = true;
+            return;
+        case ReconciliationRegisterResult::PROTOCOL_VIOLATION:
+            LogPrint(BCLog::NET, "txreconciliation protocol violation from peer=%d; disconnecting\n", pfrom.GetId());
+            pfrom.fDisconnect = true;
+            return;
+        }
+        return;
+    }
+
+    // Received from a peer willing to relay ancestor packages. Like SENDSIDRECON, it must be sent
+    // between VERSION and VERACK.
+    if (msg_type == NetMsgType::SENDPACKAGES) {
+        if (pfrom.fSuccessfullyConnected) {
+            LogPrint(BCLog::NET, "sendpackages received after verack from peer=%d; disconnecting\n", pfrom.GetId());
+            pfrom.fDisconnect = true;
+            return;
+        }
+
+        uint32_t peer_package_relay_version;
+        vRecv >> peer_package_relay_version;
+        // We only signaled it ourselves if we are going to relay transactions with this peer
+        if (m_package_relay && !m_ignore_incoming_txs && pfrom.RelayAddrsWithConn() && !pfrom.IsBlockRelayOnly() &&
+            peer_package_relay_version >= PACKAGE_RELAY_VERSION) {
+            peer->m_package_relay = true;
+        }
+        return;
+    }
+
     if (!pfrom.fSuccessfullyConnected) {
         LogPrint(BCLog::NET, "Unsupported message \"%s\" prior to verack from peer=%d\n", SanitizeString(msg_type), pfrom.GetId());
         return;
@@ -3277,6 +3795,69 @@ void PeerManagerImpl::ProcessMessage(
         return;
     }
 
+    if (msg_type == NetMsgType::SENDCMPCTLOCKS) {
+        bool b;
+        vRecv >> b;
+        pfrom.fSendCompactLocks = b;
+        return;
+    }
+
+    if (msg_type == NetMsgType::REQSIDLIST) {
+        if (!m_txreconciliation) return;
+        // We answer with the full list of our short ids, so the size of the remote set is only
+        // informational.
+        uint16_t remote_set_size;
+        vRecv >> remote_set_size;
+        const auto short_ids = m_txreconciliation->RespondToReconciliationRequest(pfrom.GetId());
+        if (!short_ids) {
+            LogPrint(BCLog::NET, "Ignore unexpected reqsidlist from peer=%d\n", pfrom.GetId());
+            return;
+        }
+        m_connman.PushMessage(&pfrom, msgMaker.Make(NetMsgType::SIDLIST, *short_ids));
+        return;
+    }
+
+    if (msg_type == NetMsgType::SIDLIST) {
+        if (!m_txreconciliation) return;
+        std::vector<uint32_t> remote_short_ids;
+        vRecv >> remote_short_ids;
+        if (remote_short_ids.size() > MAX_RECONSET_SIZE) {
+            Misbehaving(pfrom.GetId(), 20, strprintf("sidlist message size = %u", remote_short_ids.size()));
+            return;
+        }
+        std::vector<uint256> txs_to_announce;
+        std::vector<uint32_t> short_ids_to_request;
+        if (!m_txreconciliation->HandleSketch(pfrom.GetId(), remote_short_ids, txs_to_announce, short_ids_to_request)) {
+            LogPrint(BCLog::NET, "Ignore unexpected sidlist from peer=%d\n", pfrom.GetId());
+            return;
+        }
+        if (!short_ids_to_request.empty()) {
+            m_connman.PushMessage(&pfrom, msgMaker.Make(NetMsgType::SIDLISTDIFF, short_ids_to_request));
+        }
+        AnnounceReconciledTxs(pfrom, txs_to_announce);
+        return;
+    }
+
+    if (msg_type == NetMsgType::SIDLISTDIFF) {
+        if (!m_txreconciliation) return;
+        std::vector<uint32_t> short_ids;
+        vRecv >> short_ids;
+        if (short_ids.size() > MAX_RECONSET_SIZE) {
+            Misbehaving(pfrom.GetId(), 20, strprintf("sidlistdiff message size = %u", short_ids.size()));
+            return;
+        }
+        AnnounceReconciledTxs(pfrom, m_txreconciliation->HandleReconciliationDifference(pfrom.GetId(), short_ids));
+        return;
+    }
+
+    if (msg_type == NetMsgType::CMPCTISDLOCK || msg_type == NetMsgType::CMPCTCLSIG) {
+        // Both compact messages lead with the hash of the full object, remember it so that we don't relay
+        // the reconstructed object back to pfrom. The message itself is handled by the LLMQ managers below.
+        uint256 hash;
+        CDataStream(vRecv) >> hash;
+        pfrom.AddKnownInventory(hash);
+    }
+
     if (msg_type == NetMsgType::INV) {
         std::vector<CInv> vInv;
         vRecv >> vInv;
@@ -3340,6 +3921,13 @@ void PeerManagerImpl::ProcessMessage(
                 };
 
                 pfrom.AddKnownInventory(inv.hash);
+                if (inv.type == MSG_QUORUM_RECOVERED_SIG) {
+                    peer->AddKnownRecoveredSig(inv.hash);
+                }
+                if (m_txreconciliation && inv.IsMsgTx()) {
+                    // The peer has it, no need to reconcile it with them
+                    m_txreconciliation->TryRemoveFromSet(pfrom.GetId(), inv.hash);
+                }
                 if (fBlocksOnly && NetMessageViolatesBlocksOnly(inv.GetCommand())) {
                     LogPrint(BCLog::NET, "%s (%s) inv sent in violation of protocol, disconnecting peer=%d\n", inv.GetCommand(), inv.hash.ToString(), pfrom.GetId());
                     pfrom.fDisconnect = true;
@@ -3557,7 +4145,7 @@ void PeerManagerImpl::ProcessMessage(
                 pindex = m_chainman.ActiveChain().Next(pindex);
         }
 
-        const auto send_headers = [this /* for m_connman */, &hashStop, &pindex, &nodestate, &pfrom, &msgMaker](auto msg_type, auto& v_headers, auto callback) {
+        const auto send_headers = [this /* for m_connman */, &hashStop, &pindex, &nodestate, &pfrom](auto& v_headers, auto callback, auto make_msg) {
             int nLimit = MAX_HEADERS_RESULTS;
             for (; pindex; pindex = m_chainman.ActiveChain().Next(pindex)) {
                 v_headers.push_back(callback(pindex, m_chainparams));
@@ -3578,24 +4166,24 @@ void PeerManagerImpl::ProcessMessage(
             // will re-announce the new block via headers (or compact blocks again)
             // in the SendMessages logic.
             nodestate->pindexBestHeaderSent = pindex ? pindex : m_chainman.ActiveChain().Tip();
-            m_connman.PushMessage(&pfrom, msgMaker.Make(msg_type, v_headers));
+            m_connman.PushMessage(&pfrom, make_msg(v_headers));
         };
 
         LogPrint(BCLog::NET, "%s %d to %s from peer=%d\n", msg_type, (pindex ? pindex->nHeight : -1), hashStop.IsNull() ? "end" : hashStop.ToString(), pfrom.GetId());
         if (msg_type == NetMsgType::GETHEADERS) {
-            // we must use CBlocks, as CBlockHeaders won't include the 0x00 nTx count at the end
-            std::vector<CBlock> v_headers;
-            send_headers(NetMsgType::HEADERS, v_headers, [](const auto block_pindex, const auto m_chainparams) { return block_pindex->GetBlockHeader(m_chainparams.GetConsensus()); });
+            std::vector<const CBlockIndex*> v_headers;
+            send_headers(v_headers, [](const auto block_pindex, const auto m_chainparams) { return block_pindex; },
+                [this](const auto& v_headers) { return m_headers_cache.MakeHeadersMsg(v_headers, m_chainparams.GetConsensus()); });
         } else if (msg_type == NetMsgType::GETHEADERS2) {
             // Keeps track of the last 7 unique version blocks
             std::list<int32_t> last_unique_versions;
             std::vector<CompressibleBlockHeader> v_headers;
 
-            send_headers(NetMsgType::HEADERS2, v_headers, [&v_headers, &last_unique_versions](const auto block_pindex, const auto m_chainparams) {
+            send_headers(v_headers, [&v_headers, &last_unique_versions](const auto block_pindex, const auto m_chainparams) {
                 CompressibleBlockHeader compressible_header{block_pindex->GetBlockHeader(m_chainparams.GetConsensus())};
                 if (!v_headers.empty()) compressible_header.Compress(v_headers, last_unique_versions); // first block is always uncompressed
                 return compressible_header;
-            });
+            }, [&msgMaker](const auto& v_headers) { return msgMaker.Make(NetMsgType::HEADERS2, v_headers); });
         }
         return;
     }
@@ -3666,14 +4254,7 @@ void PeerManagerImpl::ProcessMessage(
             m_mempool.check(m_chainman.ActiveChainstate());
             RelayTransaction(tx.GetHash());
 
-            for (unsigned int i = 0; i < tx.vout.size(); i++) {
-                auto it_by_prev = mapOrphanTransactionsByPrev.find(COutPoint(txid, i));
-                if (it_by_prev != mapOrphanTransactionsByPrev.end()) {
-                    for (const auto& elem : it_by_prev->second) {
-                        peer->m_orphan_work_set.insert(elem->first);
-                    }
-                }
-            }
+            m_orphanage.AddChildrenToWorkSet(tx, peer->m_orphan_work_set);
 
             pfrom.nLastTXTime = GetTime();
 
@@ -3694,25 +4275,22 @@ void PeerManagerImpl::ProcessMessage(
                     break;
                 }
             }
-            if (!fRejectedParents) {
-                const auto current_time = GetTime<std::chrono::microseconds>();
-
-                for (const CTxIn& txin : tx.vin) {
-                    CInv _inv(MSG_TX, txin.prevout.hash);
-                    pfrom.AddKnownInventory(_inv.hash);
-                    if (!AlreadyHave(_inv)) RequestObject(State(pfrom.GetId()), _inv, current_time);
-                    // We don't know if the previous tx was a regular or a mixing one, try both
-                    CInv _inv2(MSG_DSTX, txin.prevout.hash);
-                    pfrom.AddKnownInventory(_inv2.hash);
-                    if (!AlreadyHave(_inv2)) RequestObject(State(pfrom.GetId()), _inv2, current_time);
+            // A package relay peer can send the parents along with the orphan, so that they are
+            // validated together. This also gives a parent which was rejected for its fee rate
+            // another chance, when the orphan pays for it.
+            if (!fRejectedParents || peer->m_package_relay) {
+                if (!(peer->m_package_relay && MaybeRequestAncestorPackage(pfrom, *peer, txid)) && !fRejectedParents) {
+                    RequestOrphanParents(pfrom, tx);
+                }
+                if (m_orphanage.AddTx(ptx, pfrom.GetId())) {
+                    AddToCompactExtraTransactions(ptx);
                 }
-                AddOrphanTx(ptx, pfrom.GetId());
 
-                // DoS prevention: do not allow mapOrphanTransactions to grow unbounded (see CVE-2012-3789)
+                // DoS prevention: do not allow m_orphanage to grow unbounded (see CVE-2012-3789)
                 unsigned int nMaxOrphanTxSize = (unsigned int)std::max((int64_t)0, gArgs.GetArg("-maxorphantxsize", DEFAULT_MAX_ORPHAN_TRANSACTIONS_SIZE)) * 1000000;
-                unsigned int nEvicted = LimitOrphanTxSize(nMaxOrphanTxSize);
+                unsigned int nEvicted = m_orphanage.LimitOrphans(nMaxOrphanTxSize, nMaxOrphanTxSize / MAX_PEER_ORPHANS_SIZE_DIVISOR);
                 if (nEvicted > 0) {
-                    LogPrint(BCLog::MEMPOOL, "mapOrphan overflow, removed %u tx\n", nEvicted);
+                    LogPrint(BCLog::MEMPOOL, "orphanage overflow, removed %u tx\n", nEvicted);
                 }
             } else {
                 LogPrint(BCLog::MEMPOOL, "not keeping orphan with rejected parents %s\n",tx.GetHash().ToString());
@@ -3755,6 +4333,116 @@ void PeerManagerImpl::ProcessMessage(
         return;
     }
 
+    if (msg_type == NetMsgType::GETPKGINFO) {
+        if (!peer->m_package_relay) {
+            LogPrint(BCLog::NET, "Ignore unexpected getpkginfo from peer=%d\n", pfrom.GetId());
+            return;
+        }
+        uint256 txid;
+        vRecv >> txid;
+
+        // Answer with an empty package if we can't give out the transaction, so that the peer
+        // falls back to fetching its parents one by one
+        std::vector<uint256> package;
+        const std::chrono::seconds now = GetTime<std::chrono::seconds>();
+        if (FindTxForGetData(&pfrom, txid, pfrom.m_tx_relay->m_last_mempool_req.load(), now)) {
+            package = m_mempool.GetAncestorPackage(txid, MAX_PACKAGE_COUNT);
+        }
+        if (package.size() > 1) {
+            // Make the ancestors requestable in GETPKGTXNS, as when sending a transaction in reply to GETDATA
+            LOCK(cs_main);
+            CNodeState* state = State(pfrom.GetId());
+            for (auto it = package.begin(); it != package.end() - 1; ++it) {
+                state->m_recently_announced_invs.insert(*it);
+            }
+        }
+        m_connman.PushMessage(&pfrom, msgMaker.Make(NetMsgType::ANCPKGINFO, package));
+        return;
+    }
+
+    if (msg_type == NetMsgType::ANCPKGINFO) {
+        std::vector<uint256> package;
+        vRecv >> package;
+        if (package.size() > MAX_PACKAGE_COUNT) {
+            Misbehaving(pfrom.GetId(), 20, strprintf("ancpkginfo message size = %u", package.size()));
+            return;
+        }
+
+        LOCK2(cs_main, g_cs_orphans);
+        if (!peer->m_package_request || !peer->m_package_request->m_package.empty()) {
+            LogPrint(BCLog::NET, "Ignore unexpected ancpkginfo from peer=%d\n", pfrom.GetId());
+            return;
+        }
+        const uint256 txid = peer->m_package_request->m_txid;
+        if (package.empty() || package.back() != txid) {
+            LogPrint(BCLog::NET, "peer=%d has no ancestor package of %s\n", pfrom.GetId(), txid.ToString());
+            peer->m_package_request.reset();
+            if (const auto [orphan, from_peer] = m_orphanage.GetTx(txid); orphan) {
+                RequestOrphanParents(pfrom, *orphan);
+            }
+            return;
+        }
+
+        std::vector<uint256> txids_to_request;
+        for (const uint256& hash : package) {
+            if (!m_mempool.exists(hash) && m_orphanage.GetTx(hash).first == nullptr) {
+                txids_to_request.push_back(hash);
+            }
+        }
+        peer->m_package_request->m_package = std::move(package);
+        if (txids_to_request.empty()) {
+            ProcessAncestorPackage(pfrom, *peer, {});
+        } else {
+            m_connman.PushMessage(&pfrom, msgMaker.Make(NetMsgType::GETPKGTXNS, txids_to_request));
+        }
+        return;
+    }
+
+    if (msg_type == NetMsgType::GETPKGTXNS) {
+        if (!peer->m_package_relay) {
+            LogPrint(BCLog::NET, "Ignore unexpected getpkgtxns from peer=%d\n", pfrom.GetId());
+            return;
+        }
+        std::vector<uint256> txids;
+        vRecv >> txids;
+        if (txids.size() > MAX_PACKAGE_COUNT) {
+            Misbehaving(pfrom.GetId(), 20, strprintf("getpkgtxns message size = %u", txids.size()));
+            return;
+        }
+
+        std::vector<CTransactionRef> txs;
+        const std::chrono::seconds now = GetTime<std::chrono::seconds>();
+        for (const uint256& txid : txids) {
+            if (CTransactionRef tx = FindTxForGetData(&pfrom, txid, pfrom.m_tx_relay->m_last_mempool_req.load(), now)) {
+                txs.push_back(std::move(tx));
+            }
+        }
+        m_connman.PushMessage(&pfrom, msgMaker.Make(NetMsgType::PKGTXNS, txs));
+        return;
+    }
+
+    if (msg_type == NetMsgType::PKGTXNS) {
+        std::vector<CTransactionRef> txs;
+        vRecv >> txs;
+        if (txs.size() > MAX_PACKAGE_COUNT) {
+            Misbehaving(pfrom.GetId(), 20, strprintf("pkgtxns message size = %u", txs.size()));
+            return;
+        }
+
+        LOCK2(cs_main, g_cs_orphans);
+        if (!peer->m_package_request || peer->m_package_request->m_package.empty()) {
+            LogPrint(BCLog::NET, "Ignore unexpected pkgtxns from peer=%d\n", pfrom.GetId());
+            return;
+        }
+        for (const CTransactionRef& tx : txs) {
+            pfrom.AddKnownInventory(tx->GetHash());
+            // The transactions may have been requested one by one as well
+            EraseObjectRequest(pfrom.GetId(), CInv(MSG_TX, tx->GetHash()));
+        }
+        ProcessAncestorPackage(pfrom, *peer, txs);
+        return;
+    }
+
     if (msg_type == NetMsgType::CMPCTBLOCK)
     {
         // Ignore cmpctblock received while importing
@@ -3861,7 +4549,7 @@ void PeerManagerImpl::ProcessMessage(
                 }
 
                 PartiallyDownloadedBlock& partialBlock = *(*queuedBlockIt)->partialBlock;
-                ReadStatus status = partialBlock.InitData(cmpctblock, vExtraTxnForCompact);
+                ReadStatus status = partialBlock.InitData(cmpctblock, vExtraTxnForCompact, vIsLockedTxnForCompact);
                 if (status == READ_STATUS_INVALID) {
                     MarkBlockAsReceived(pindex->GetBlockHash()); // Reset in-flight state in case Misbehaving does not result in a disconnect
                     Misbehaving(pfrom.GetId(), 100, "invalid compact block");
@@ -3896,7 +4584,7 @@ void PeerManagerImpl::ProcessMessage(
                 // Optimistically try to reconstruct anyway since we might be
                 // able to without any round trips.
                 PartiallyDownloadedBlock tempBlock(&m_mempool);
-                ReadStatus status = tempBlock.InitData(cmpctblock, vExtraTxnForCompact);
+                ReadStatus status = tempBlock.InitData(cmpctblock, vExtraTxnForCompact, vIsLockedTxnForCompact);
                 if (status != READ_STATUS_OK) {
                     // TODO: don't ignore failures
                     return;
@@ -4081,24 +4769,14 @@ void PeerManagerImpl::ProcessMessage(
             return;
         }
 
+        if (m_block_precheck_pool.size() > 0) {
+            QueueBlockPrecheck(*peer, vRecv, nTimeReceived);
+            return;
+        }
+
         std::shared_ptr<CBlock> pblock = std::make_shared<CBlock>();
         vRecv >> *pblock;
-
-        LogPrint(BCLog::NET, "received block %s peer=%d\n", pblock->GetHash().ToString(), pfrom.GetId());
-
-        bool forceProcessing = false;
-        const uint256 hash(pblock->GetHash());
-        {
-            LOCK(cs_main);
-            // Also always process if we requested the block explicitly, as we may
-            // need it even though it is not a candidate for a new best tip.
-            forceProcessing |= MarkBlockAsReceived(hash);
-            // mapBlockSource is only used for punishing peers and setting
-            // which peers send us compact blocks, so the race between here and
-            // cs_main in ProcessNewBlock is fine.
-            mapBlockSource.emplace(hash, std::make_pair(pfrom.GetId(), true));
-        }
-        ProcessBlock(pfrom, pblock, forceProcessing);
+        ProcessReceivedBlock(pfrom, pblock, nTimeReceived);
         return;
     }
 
@@ -4306,10 +4984,9 @@ void PeerManagerImpl::ProcessMessage(
 
         LOCK(cs_main);
 
-        CSimplifiedMNListDiff mnListDiff;
         std::string strError;
-        if (BuildSimplifiedMNListDiff(cmd.baseBlockHash, cmd.blockHash, mnListDiff, *m_llmq_ctx->quorum_block_processor, strError)) {
-            m_connman.PushMessage(&pfrom, msgMaker.Make(NetMsgType::MNLISTDIFF, mnListDiff));
+        if (const auto mnListDiff = m_mnlistdiff_cache.Get(cmd.baseBlockHash, cmd.blockHash, *m_llmq_ctx->quorum_block_processor, strError)) {
+            m_connman.PushMessage(&pfrom, msgMaker.Make(NetMsgType::MNLISTDIFF, *mnListDiff));
         } else {
             strError = strprintf("getmnlistdiff failed for baseBlockHash=%s, blockHash=%s. error=%s", cmd.baseBlockHash.ToString(), cmd.blockHash.ToString(), strError);
             Misbehaving(pfrom.GetId(), 1, strError);
@@ -4345,10 +5022,21 @@ void PeerManagerImpl::ProcessMessage(
 
         LOCK(cs_main);
 
+        const uint256 tipHash = m_chainman.ActiveChain().Tip()->GetBlockHash();
+        if (const auto cached = m_qrinfo_cache.Get(cmd, tipHash, pfrom.GetCommonVersion())) {
+            CSerializedNetMsg msg;
+            msg.command = NetMsgType::QUORUMROTATIONINFO;
+            msg.data = *cached;
+            m_connman.PushMessage(&pfrom, std::move(msg));
+            return;
+        }
+
         llmq::CQuorumRotationInfo quorumRotationInfoRet;
         std::string strError;
         if (BuildQuorumRotationInfo(cmd, quorumRotationInfoRet, *m_llmq_ctx->qman, *m_llmq_ctx->quorum_block_processor, strError)) {
-            m_connman.PushMessage(&pfrom, msgMaker.Make(NetMsgType::QUORUMROTATIONINFO, quorumRotationInfoRet));
+            CSerializedNetMsg msg = msgMaker.Make(NetMsgType::QUORUMROTATIONINFO, quorumRotationInfoRet);
+            m_qrinfo_cache.Add(cmd, tipHash, pfrom.GetCommonVersion(), std::make_shared<const std::vector<unsigned char>>(msg.data));
+            m_connman.PushMessage(&pfrom, std::move(msg));
         } else {
             strError = strprintf("getquorumrotationinfo failed for size(baseBlockHashes)=%d, blockRequestHash=%s. error=%s", cmd.baseBlockHashes.size(), cmd.blockRequestHash.ToString(), strError);
             Misbehaving(pfrom.GetId(), 1, strError);
@@ -4368,7 +5056,7 @@ void PeerManagerImpl::ProcessMessage(
         CNodeState *state = State(pfrom.GetId());
         std::vector<CInv> vInv;
         vRecv >> vInv;
-        if (vInv.size() <= MAX_PEER_OBJECT_IN_FLIGHT + MAX_BLOCKS_IN_TRANSIT_PER_PEER) {
+        if (vInv.size() <= MAX_PEER_OBJECT_IN_FLIGHT + MAX_ADAPTIVE_BLOCKS_IN_TRANSIT_PER_PEER) {
             for (CInv &inv : vInv) {
                 if (inv.IsKnownType()) {
                     // If we receive a NOTFOUND message for a txid we requested, erase
@@ -4398,24 +5086,39 @@ void PeerManagerImpl::ProcessMessage(
 
     if (found)
     {
+        if (IsParallelMessage(msg_type)) {
+            // We may not hold m_serial_msgproc_mutex, so don't pass these through the other extensions
+            if (msg_type == NetMsgType::SPORK || msg_type == NetMsgType::GETSPORKS) {
+                ProcessPeerMsgRet(sporkManager->ProcessMessage(pfrom, m_connman, msg_type, vRecv), pfrom);
+            } else if (msg_type == NetMsgType::MNAUTH) {
+                ProcessPeerMsgRet(CMNAuth::ProcessMessage(pfrom, *this, m_connman, *m_llmq_ctx->bls_worker, msg_type, vRecv), pfrom);
+            } else {
+                m_llmq_ctx->shareman->ProcessMessage(pfrom, *sporkManager, msg_type, vRecv);
+            }
+            return;
+        }
+        if (msg_type == NetMsgType::QSIGREC) {
+            // the hash of a recovered sig is the hash of its serialization
+            peer->AddKnownRecoveredSig(Hash(vRecv));
+        }
         //probably one the extensions
 #ifdef ENABLE_WALLET
-        ProcessPeerMsgRet(m_cj_ctx->queueman->ProcessMessage(pfrom, msg_type, vRecv), pfrom);
+        ProcessPeerMsgRet(m_cj_ctx->queueman->ProcessMessage(pfrom, *this, *m_llmq_ctx->bls_worker, msg_type, vRecv), pfrom);
         for (auto& pair : m_cj_ctx->walletman->raw()) {
             pair.second->ProcessMessage(pfrom, m_connman, m_mempool, msg_type, vRecv);
         }
 #endif // ENABLE_WALLET
-        ProcessPeerMsgRet(m_cj_ctx->server->ProcessMessage(pfrom, msg_type, vRecv), pfrom);
+        ProcessPeerMsgRet(m_cj_ctx->server->ProcessMessage(pfrom, *this, *m_llmq_ctx->bls_worker, msg_type, vRecv), pfrom);
         ProcessPeerMsgRet(sporkManager->ProcessMessage(pfrom, m_connman, msg_type, vRecv), pfrom);
         ::masternodeSync->ProcessMessage(pfrom, msg_type, vRecv);
-        ProcessPeerMsgRet(m_govman.ProcessMessage(pfrom, m_connman, msg_type, vRecv), pfrom);
-        ProcessPeerMsgRet(CMNAuth::ProcessMessage(pfrom, m_connman, msg_type, vRecv), pfrom);
+        ProcessPeerMsgRet(m_govman.ProcessMessage(pfrom, m_connman, *m_llmq_ctx->bls_worker, msg_type, vRecv), pfrom);
+        ProcessPeerMsgRet(CMNAuth::ProcessMessage(pfrom, *this, m_connman, *m_llmq_ctx->bls_worker, msg_type, vRecv), pfrom);
         ProcessPeerMsgRet(m_llmq_ctx->quorum_block_processor->ProcessMessage(pfrom, msg_type, vRecv), pfrom);
         ProcessPeerMsgRet(m_llmq_ctx->qdkgsman->ProcessMessage(pfrom, this, msg_type, vRecv), pfrom);
         ProcessPeerMsgRet(m_llmq_ctx->qman->ProcessMessage(pfrom, msg_type, vRecv), pfrom);
         m_llmq_ctx->shareman->ProcessMessage(pfrom, *sporkManager, msg_type, vRecv);
         ProcessPeerMsgRet(m_llmq_ctx->sigman->ProcessMessage(pfrom, this, msg_type, vRecv), pfrom);
-        ProcessPeerMsgRet(m_llmq_ctx->clhandler->ProcessMessage(pfrom, msg_type, vRecv), pfrom);
+        ProcessPeerMsgRet(m_llmq_ctx->clhandler->ProcessMessage(pfrom, this, msg_type, vRecv), pfrom);
         ProcessPeerMsgRet(m_llmq_ctx->isman->ProcessMessage(pfrom, this, msg_type, vRecv), pfrom);
         return;
     }
@@ -4477,23 +5180,31 @@ bool PeerManagerImpl::ProcessMessages(CNode* pfrom, std::atomic<bool>& interrupt
     PeerRef peer = GetPeerRef(pfrom->GetId());
     if (peer == nullptr) return false;
 
+    // The budget can't reach the node itself, so pick up its verdict here
+    pfrom->fPauseRecvBudget = llmq::pendingMessagesBudget.IsPaused(pfrom->GetId());
+
     {
-        LOCK(peer->m_getdata_requests_mutex);
+        LOCK2(m_serial_msgproc_mutex, peer->m_getdata_requests_mutex);
         if (!peer->m_getdata_requests.empty()) {
             ProcessGetData(*pfrom, *peer, interruptMsgProc);
         }
     }
 
     {
+        LOCK(m_serial_msgproc_mutex);
         LOCK2(cs_main, g_cs_orphans);
         if (!peer->m_orphan_work_set.empty()) {
             ProcessOrphanTx(peer->m_orphan_work_set);
         }
     }
 
+    bool fMorePendingBlocks = WITH_LOCK(m_serial_msgproc_mutex, return ProcessPendingBlock(*pfrom, *peer));
+
     if (pfrom->fDisconnect)
         return false;
 
+    if (fMorePendingBlocks) return true;
+
     // this maintains the order of responses
     // and prevents m_getdata_requests to grow unbounded
     {
@@ -4509,6 +5220,20 @@ bool PeerManagerImpl::ProcessMessages(CNode* pfrom, std::atomic<bool>& interrupt
     // Don't bother if send buffer is too full to respond anyway
     if (pfrom->fPauseSend) return false;
 
+    // The messages after an MNAUTH may rely on the peer being verified, we are woken up once that's done
+    if (pfrom->m_mnauth_pending) return false;
+
+    {
+        // Only further blocks may overtake a block which is still being prechecked, the peer's other
+        // messages wait for it. We are woken up once the precheck is done.
+        LOCK(peer->m_pending_blocks_mutex);
+        if (!peer->m_pending_blocks.empty()) {
+            if (peer->m_pending_blocks.size() >= MAX_PENDING_BLOCKS_PER_PEER) return false;
+            LOCK(pfrom->cs_vProcessMsg);
+            if (!pfrom->vProcessMsg.empty() && pfrom->vProcessMsg.front().m_command != NetMsgType::BLOCK) return false;
+        }
+    }
+
     std::list<CNetMessage> msgs;
     {
         LOCK(pfrom->cs_vProcessMsg);
@@ -4528,11 +5253,31 @@ bool PeerManagerImpl::ProcessMessages(CNode* pfrom, std::atomic<bool>& interrupt
     msg.SetVersion(pfrom->GetCommonVersion());
     const std::string& msg_type = msg.m_command;
 
+    TRACE6(net, inbound_message,
+        pfrom->GetId(),
+        pfrom->GetAddrName().c_str(),
+        pfrom->ConnectionTypeAsString().c_str(),
+        msg_type.c_str(),
+        msg.m_recv.size(),
+        msg.m_recv.data()
+    );
+
     // Message size
     unsigned int nMessageSize = msg.m_message_size;
 
-    try {
+    const auto process_message = [&] {
+        const int64_t nProcessStart = GetTimeMicros();
         ProcessMessage(*pfrom, msg_type, msg.m_recv, msg.m_time, interruptMsgProc);
+        RecordNetMsgStats(msg_type, nProcessStart - msg.m_time, GetTimeMicros() - nProcessStart);
+    };
+
+    try {
+        if (IsParallelMessage(msg_type)) {
+            process_message();
+        } else {
+            LOCK(m_serial_msgproc_mutex);
+            process_message();
+        }
         if (interruptMsgProc) return false;
         {
             LOCK(peer->m_getdata_requests_mutex);
@@ -4547,6 +5292,47 @@ bool PeerManagerImpl::ProcessMessages(CNode* pfrom, std::atomic<bool>& interrupt
     return fMoreWork;
 }
 
+static size_t NetMsgStatsBucket(uint64_t us)
+{
+    size_t bucket{0};
+    for (us >>= 1; us > 0 && bucket + 1 < NET_MSG_STATS_HISTOGRAM_BUCKETS; us >>= 1) ++bucket;
+    return bucket;
+}
+
+void PeerManagerImpl::RecordNetMsgStats(const std::string& msg_type, int64_t wait_us, int64_t process_us)
+{
+    // The receipt time comes from the socket handler thread, don't let clock adjustments make it negative
+    const uint64_t wait{uint64_t(std::max<int64_t>(wait_us, 0))};
+    const uint64_t process{uint64_t(std::max<int64_t>(process_us, 0))};
+    {
+        LOCK(m_net_msg_stats_mutex);
+        auto it = m_net_msg_stats.find(msg_type);
+        if (it == m_net_msg_stats.end()) it = m_net_msg_stats.find(NET_MESSAGE_COMMAND_OTHER);
+        NetMsgStats& stats = it->second;
+        stats.count++;
+        stats.process_us += process;
+        stats.max_process_us = std::max(stats.max_process_us, process);
+        stats.wait_us += wait;
+        stats.max_wait_us = std::max(stats.max_wait_us, wait);
+        stats.process_histogram[NetMsgStatsBucket(process)]++;
+        stats.wait_histogram[NetMsgStatsBucket(wait)]++;
+    }
+    statsClient.timing("message.received." + SanitizeString(msg_type) + ".process_us", process, 1.0f);
+    statsClient.timing("message.received." + SanitizeString(msg_type) + ".wait_us", wait, 1.0f);
+}
+
+std::map<std::string, NetMsgStats> PeerManagerImpl::GetNetMsgStats(bool reset)
+{
+    LOCK(m_net_msg_stats_mutex);
+    std::map<std::string, NetMsgStats> ret;
+    for (auto& [msg_type, stats] : m_net_msg_stats) {
+        if (stats.count == 0) continue;
+        ret.emplace(msg_type, stats);
+        if (reset) stats = NetMsgStats{};
+    }
+    return ret;
+}
+
 void PeerManagerImpl::ConsiderEviction(CNode& pto, int64_t time_in_seconds)
 {
     AssertLockHeld(cs_main);
@@ -4757,6 +5543,8 @@ bool PeerManagerImpl::SendMessages(CNode* pto)
 {
     assert(m_llmq_ctx);
 
+    LOCK(m_serial_msgproc_mutex);
+
     const Consensus::Params& consensusParams = m_chainparams.GetConsensus();
 
     // We must call MaybeDiscourageAndDisconnect first, to ensure that we'll
@@ -4899,7 +5687,7 @@ bool PeerManagerImpl::SendMessages(CNode* pto)
             // blocks, or if the peer doesn't want headers, just
             // add all to the inv queue.
             LOCK(pto->cs_inventory);
-            std::vector<CBlock> vHeaders;
+            std::vector<const CBlockIndex*> vHeaders;
             bool fRevertToInv = ((!state.fPreferHeaders && !state.fPreferHeadersCompressed &&
                                  (!state.fPreferHeaderAndIDs || pto->vBlockHashesToAnnounce.size() > 1)) ||
                                  pto->vBlockHashesToAnnounce.size() > MAX_BLOCKS_TO_ANNOUNCE);
@@ -4946,14 +5734,14 @@ bool PeerManagerImpl::SendMessages(CNode* pto)
                     }
                     if (fFoundStartingHeader) {
                         // add this to the headers message
-                        vHeaders.push_back(pindex->GetBlockHeader(consensusParams));
+                        vHeaders.push_back(pindex);
                     } else if (PeerHasHeader(&state, pindex)) {
                         continue; // keep looking for the first new block
                     } else if (pindex->pprev == nullptr || PeerHasHeader(&state, pindex->pprev) || isPrevDevnetGenesisBlock) {
                         // Peer doesn't have this header but they do have the prior one.
                         // Start sending headers.
                         fFoundStartingHeader = true;
-                        vHeaders.push_back(pindex->GetBlockHeader(consensusParams));
+                        vHeaders.push_back(pindex);
                     } else {
                         // Peer doesn't have this header or the prior one -- nothing will
                         // connect, so bail out.
@@ -4967,7 +5755,7 @@ bool PeerManagerImpl::SendMessages(CNode* pto)
                     // We only send up to 1 block as header-and-ids, as otherwise
                     // probably means we're doing an initial-ish-sync or they're slow
                     LogPrint(BCLog::NET, "%s sending header-and-ids %s to peer=%d\n", __func__,
-                            vHeaders.front().GetHash().ToString(), pto->GetId());
+                            vHeaders.front()->GetBlockHash().ToString(), pto->GetId());
 
                     bool fGotBlockFromCache = false;
                     {
@@ -4990,8 +5778,8 @@ bool PeerManagerImpl::SendMessages(CNode* pto)
                     std::list<int32_t> last_unique_versions;
 
                     // Save other headers compressed
-                    std::for_each(vHeaders.cbegin(), vHeaders.cend(), [&vHeadersCompressed, &last_unique_versions](const auto& block) {
-                        CompressibleBlockHeader compressible_header{block.GetBlockHeader()};
+                    std::for_each(vHeaders.cbegin(), vHeaders.cend(), [&vHeadersCompressed, &last_unique_versions, &consensusParams](const CBlockIndex* header_pindex) {
+                        CompressibleBlockHeader compressible_header{header_pindex->GetBlockHeader(consensusParams)};
                         compressible_header.Compress(vHeadersCompressed, last_unique_versions);
                         vHeadersCompressed.push_back(compressible_header);
                     });
@@ -5003,13 +5791,13 @@ bool PeerManagerImpl::SendMessages(CNode* pto)
                     if (vHeaders.size() > 1) {
                         LogPrint(BCLog::NET, "%s: %u headers, range (%s, %s), to peer=%d\n", __func__,
                                 vHeaders.size(),
-                                vHeaders.front().GetHash().ToString(),
-                                vHeaders.back().GetHash().ToString(), pto->GetId());
+                                vHeaders.front()->GetBlockHash().ToString(),
+                                vHeaders.back()->GetBlockHash().ToString(), pto->GetId());
                     } else {
                         LogPrint(BCLog::NET, "%s: sending header %s to peer=%d\n", __func__,
-                                vHeaders.front().GetHash().ToString(), pto->GetId());
+                                vHeaders.front()->GetBlockHash().ToString(), pto->GetId());
                     }
-                    m_connman.PushMessage(pto, msgMaker.Make(NetMsgType::HEADERS, vHeaders));
+                    m_connman.PushMessage(pto, m_headers_cache.MakeHeadersMsg(vHeaders, consensusParams));
                     state.pindexBestHeaderSent = pBestIndex;
                 } else
                     fRevertToInv = true;
@@ -5117,7 +5905,7 @@ bool PeerManagerImpl::SendMessages(CNode* pto)
                         pto->m_tx_relay->setInventoryTxToSend.erase(hash);
                         if (pto->m_tx_relay->pfilter && !pto->m_tx_relay->pfilter->IsRelevantAndUpdate(*txinfo.tx)) continue;
 
-                        int nInvType = ::dstxManager->GetDSTX(hash) ? MSG_DSTX : MSG_TX;
+                        int nInvType = ::dstxManager->HasDSTX(hash) ? MSG_DSTX : MSG_TX;
                         queueAndMaybePushInv(CInv(nInvType, hash));
 
                         const auto islock = m_llmq_ctx->isman->GetInstantSendLockByTxid(hash);
@@ -5171,6 +5959,11 @@ bool PeerManagerImpl::SendMessages(CNode* pto)
                             continue;
                         }
                         if (pto->m_tx_relay->pfilter && !pto->m_tx_relay->pfilter->IsRelevantAndUpdate(*txinfo.tx)) continue;
+                        const int nInvType = ::dstxManager->HasDSTX(hash) ? MSG_DSTX : MSG_TX;
+                        // Plain transactions are reconciled with peers which support it. DSTX and special
+                        // transactions are rare and expected to propagate fast, they are always flooded.
+                        const bool fReconcile = m_txreconciliation && nInvType == MSG_TX && txinfo.tx->nType == TRANSACTION_NORMAL &&
+                                                !m_txreconciliation->ShouldFloodTo(pto->GetId());
                         // Send
                         State(pto->GetId())->m_recently_announced_invs.insert(hash);
                         nRelayedTransactions++;
@@ -5187,10 +5980,18 @@ bool PeerManagerImpl::SendMessages(CNode* pto)
                                 vRelayExpiration.emplace_back(count_microseconds(current_time + std::chrono::microseconds{RELAY_TX_CACHE_TIME}), ret.first);
                             }
                         }
-                        int nInvType = ::dstxManager->GetDSTX(hash) ? MSG_DSTX : MSG_TX;
+                        if (fReconcile && m_txreconciliation->AddToSet(pto->GetId(), hash)) {
+                            continue;
+                        }
                         queueAndMaybePushInv(CInv(nInvType, hash));
                     }
                 }
+
+                if (m_txreconciliation) {
+                    if (const auto set_size = m_txreconciliation->InitiateReconciliationRequest(pto->GetId(), current_time)) {
+                        m_connman.PushMessage(pto, msgMaker.Make(NetMsgType::REQSIDLIST, *set_size));
+                    }
+                }
             }
 
             {
@@ -5198,6 +5999,7 @@ bool PeerManagerImpl::SendMessages(CNode* pto)
                 LOCK2(pto->m_tx_relay->cs_tx_inventory, pto->m_tx_relay->cs_filter);
 
                 bool fSendIS = pto->m_tx_relay->fRelayTxes && !pto->IsBlockRelayOnly();
+                const PeerRef peer = GetPeerRef(pto->GetId());
 
                 for (const auto& inv : pto->m_tx_relay->vInventoryOtherToSend) {
                     if (!pto->m_tx_relay->fRelayTxes && NetMessageViolatesBlocksOnly(inv.GetCommand())) {
@@ -5209,6 +6011,26 @@ bool PeerManagerImpl::SendMessages(CNode* pto)
                     if (!fSendIS && inv.type == MSG_ISDLOCK) {
                         continue;
                     }
+                    if (inv.type == MSG_QUORUM_RECOVERED_SIG && peer && !peer->AddKnownRecoveredSig(inv.hash)) {
+                        continue;
+                    }
+                    if (pto->fSendCompactLocks && pto->fSendRecSigs) {
+                        // This peer receives our plain recovered sigs, so it can rebuild ISLOCKs and CLSIGs from
+                        // their compact form. Push that right away instead of waiting for it to ask for the full one.
+                        if (inv.type == MSG_ISDLOCK) {
+                            if (llmq::CInstantSendLock islock; m_llmq_ctx->isman->GetInstantSendLockByHash(inv.hash, islock)) {
+                                pto->m_tx_relay->filterInventoryKnown.insert(inv.hash);
+                                m_connman.PushMessage(pto, msgMaker.Make(NetMsgType::CMPCTISDLOCK, llmq::CCompactInstantSendLock(inv.hash, islock)));
+                                continue;
+                            }
+                        } else if (inv.type == MSG_CLSIG) {
+                            if (llmq::CChainLockSig clsig; m_llmq_ctx->clhandler->GetChainLockByHash(inv.hash, clsig)) {
+                                pto->m_tx_relay->filterInventoryKnown.insert(inv.hash);
+                                m_connman.PushMessage(pto, msgMaker.Make(NetMsgType::CMPCTCLSIG, llmq::CCompactChainLockSig(inv.hash, clsig)));
+                                continue;
+                            }
+                        }
+                    }
                     queueAndMaybePushInv(inv);
                 }
                 pto->m_tx_relay->vInventoryOtherToSend.clear();
@@ -5282,10 +6104,26 @@ bool PeerManagerImpl::SendMessages(CNode* pto)
         // Message: getdata (blocks)
         //
         std::vector<CInv> vGetData;
-        if (!pto->fClient && pto->CanRelay() && ((fFetch && !pto->m_limited_node) || !m_chainman.ActiveChainstate().IsInitialBlockDownload()) && state.nBlocksInFlight < MAX_BLOCKS_IN_TRANSIT_PER_PEER) {
+        state.nBlockDownloadWindow = GetBlockDownloadWindow(state, pto->nMinPingUsecTime);
+        if (!pto->fClient && pto->CanRelay() && ((fFetch && !pto->m_limited_node) || !m_chainman.ActiveChainstate().IsInitialBlockDownload()) && state.nBlocksInFlight < state.nBlockDownloadWindow) {
             std::vector<const CBlockIndex*> vToDownload;
             NodeId staller = -1;
-            FindNextBlocksToDownload(pto->GetId(), MAX_BLOCKS_IN_TRANSIT_PER_PEER - state.nBlocksInFlight, vToDownload, staller);
+            const CBlockIndex* pindexStaller = nullptr;
+            FindNextBlocksToDownload(pto->GetId(), state.nBlockDownloadWindow - state.nBlocksInFlight, vToDownload, staller, &pindexStaller);
+            if (vToDownload.empty() && staller != -1 && pindexStaller != nullptr && state.dBlockDownloadRate > 0) {
+                // The download window is held up by a block in flight from another peer. If we are
+                // clearly faster than that peer, and it had more time than we'd need, take the block
+                // over instead of waiting for the stalling timeout to disconnect the other peer.
+                const CNodeState* stallerState = State(staller);
+                const auto itInFlight = mapBlocksInFlight.find(pindexStaller->GetBlockHash());
+                if (stallerState != nullptr && itInFlight != mapBlocksInFlight.end() &&
+                    state.dBlockDownloadRate >= BLOCK_REREQUEST_MIN_SPEEDUP * stallerState->dBlockDownloadRate &&
+                    count_microseconds(current_time) - itInFlight->second.second->nTimeRequested > state.nBlockDownloadLatency) {
+                    LogPrint(BCLog::NET, "Re-requesting block %s (%d) stalled by peer=%d from faster peer=%d\n", pindexStaller->GetBlockHash().ToString(),
+                        pindexStaller->nHeight, staller, pto->GetId());
+                    vToDownload.push_back(pindexStaller);
+                }
+            }
             for (const CBlockIndex *pindex : vToDownload) {
                 vGetData.push_back(CInv(MSG_BLOCK, pindex->GetBlockHash()));
                 MarkBlockAsInFlight(pto->GetId(), pindex->GetBlockHash(), pindex);
@@ -5375,16 +6213,3 @@ bool PeerManagerImpl::SendMessages(CNode* pto)
     } // release cs_main
     return true;
 }
-
-class CNetProcessingCleanup
-{
-public:
-    CNetProcessingCleanup() {}
-    ~CNetProcessingCleanup() {
-        // orphan transactions
-        mapOrphanTransactions.clear();
-        mapOrphanTransactionsByPrev.clear();
-        nMapOrphanTransactionsSize = 0;
-    }
-};
-static CNetProcessingCleanup instance_of_cnetprocessingcleanup;
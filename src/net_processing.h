@@ -10,7 +10,10 @@
 #include <sync.h>
 #include <validationinterface.h>
 
+#include <array>
 #include <atomic>
+#include <map>
+#include <string>
 
 class CAddrMan;
 class CTxMemPool;
@@ -27,14 +30,43 @@ extern RecursiveMutex g_cs_orphans;
 static const unsigned int DEFAULT_MAX_ORPHAN_TRANSACTIONS_SIZE = 10; // this allows around 100 TXs of max size (and many more of normal size)
 /** Default number of orphan+recently-replaced txn to keep around for block reconstruction */
 static const unsigned int DEFAULT_BLOCK_RECONSTRUCTION_EXTRA_TXN = 100;
+/** Default number of recently InstantSend-locked txn to keep around for block reconstruction */
+static const unsigned int DEFAULT_BLOCK_RECONSTRUCTION_ISLOCK_TXN = 1000;
+/** Default for -blockprecheckthreads, number of threads deserializing and prechecking received blocks */
+static const int DEFAULT_BLOCK_PRECHECK_THREADS = 2;
+static const int MAX_BLOCK_PRECHECK_THREADS = 16;
+/** Default for -filteredblockthreads, number of threads building the filtered blocks of connected blocks for bloom filter peers */
+static const int DEFAULT_FILTERED_BLOCK_THREADS = 2;
+static const int MAX_FILTERED_BLOCK_THREADS = 16;
 static const bool DEFAULT_PEERBLOOMFILTERS = true;
 static const bool DEFAULT_PEERBLOCKFILTERS = false;
+/** Default for -packagerelay, relay ancestor packages of orphans with peers that support it */
+static const bool DEFAULT_PACKAGE_RELAY = true;
+
+/** Number of histogram buckets of NetMsgStats, bucket i counts durations shorter than 2^(i+1) microseconds */
+static constexpr size_t NET_MSG_STATS_HISTOGRAM_BUCKETS = 24;
+
+/** Processing time accounting of one message type since startup or the last reset */
+struct NetMsgStats {
+    uint64_t count{0};
+    //! Time spent in ProcessMessage, including the LLMQ, governance and CoinJoin handlers it dispatches to
+    uint64_t process_us{0};
+    uint64_t max_process_us{0};
+    //! Time from receipt until processing started, i.e. queued behind other messages or waiting for the message handler
+    uint64_t wait_us{0};
+    uint64_t max_wait_us{0};
+    std::array<uint64_t, NET_MSG_STATS_HISTOGRAM_BUCKETS> process_histogram{};
+    std::array<uint64_t, NET_MSG_STATS_HISTOGRAM_BUCKETS> wait_histogram{};
+};
 
 struct CNodeStateStats {
     int m_misbehavior_score = 0;
     int nSyncHeight = -1;
     int nCommonHeight = -1;
     std::vector<int> vHeightInFlight;
+    int nBlockDownloadWindow = 0;
+    double dBlockDownloadRate = 0;
+    int64_t nBlockDownloadLatency = 0;
 };
 
 class PeerManager : public CValidationInterface, public NetEventsInterface
@@ -49,6 +81,9 @@ public:
     /** Get statistics from node state */
     virtual bool GetNodeStateStats(NodeId nodeid, CNodeStateStats& stats) = 0;
 
+    /** Get the processing time accounting of all message types received so far, optionally clearing it */
+    virtual std::map<std::string, NetMsgStats> GetNetMsgStats(bool reset) = 0;
+
     /** Whether this node ignores txs received over p2p. */
     virtual bool IgnoresIncomingTxs() = 0;
 
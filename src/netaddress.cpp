@@ -1153,6 +1153,19 @@ bool CSubNet::Match(const CNetAddr &addr) const
     return true;
 }
 
+int CSubNet::GetPrefixLength() const
+{
+    if (!valid || (network.m_net != NET_IPV4 && network.m_net != NET_IPV6)) {
+        return -1;
+    }
+
+    int cidr = 0;
+    for (size_t i = 0; i < network.m_addr.size() && netmask[i] != 0x00; ++i) {
+        cidr += NetmaskBits(netmask[i]);
+    }
+    return cidr;
+}
+
 std::string CSubNet::ToString() const
 {
     std::string suffix;
@@ -542,6 +542,12 @@ public:
 
     bool Match(const CNetAddr &addr) const;
 
+    /**
+     * @returns The CIDR prefix length of a valid IPv4 or IPv6 subnet, -1 for
+     *          any other subnet (single-host Tor/I2P/CJDNS ones included).
+     */
+    int GetPrefixLength() const;
+
     std::string ToString() const;
     bool IsValid() const;
 
@@ -30,32 +30,37 @@ CNetFulfilledRequestManager::~CNetFulfilledRequestManager()
     m_db->Store(*this);
 }
 
+static CService SquashAddress(const CService& addr)
+{
+    return Params().AllowMultiplePorts() ? addr : CService(addr, 0);
+}
+
 void CNetFulfilledRequestManager::AddFulfilledRequest(const CService& addr, const std::string& strRequest)
 {
+    FulfilledRequestKey key{SquashAddress(addr), strRequest};
+    const int64_t expire = GetTime() + Params().FulfilledRequestExpireTime();
     LOCK(cs_mapFulfilledRequests);
-    CService addrSquashed = Params().AllowMultiplePorts() ? addr : CService(addr, 0);
-    mapFulfilledRequests[addrSquashed][strRequest] = GetTime() + Params().FulfilledRequestExpireTime();
+    mapFulfilledRequests.insert_or_assign(std::move(key), expire);
 }
 
-bool CNetFulfilledRequestManager::HasFulfilledRequest(const CService& addr, const std::string& strRequest)
+bool CNetFulfilledRequestManager::HasFulfilledRequest(const CService& addr, const std::string& strRequest) const
 {
+    const FulfilledRequestKey key{SquashAddress(addr), strRequest};
     LOCK(cs_mapFulfilledRequests);
-    CService addrSquashed = Params().AllowMultiplePorts() ? addr : CService(addr, 0);
-    fulfilledreqmap_t::iterator it = mapFulfilledRequests.find(addrSquashed);
-
-    return  it != mapFulfilledRequests.end() &&
-            it->second.find(strRequest) != it->second.end() &&
-            it->second[strRequest] > GetTime();
+    const auto it = mapFulfilledRequests.find(key);
+    return it != mapFulfilledRequests.end() && it->second > GetTime();
 }
 
 void CNetFulfilledRequestManager::RemoveAllFulfilledRequests(const CService& addr)
 {
+    const CService addrSquashed = SquashAddress(addr);
     LOCK(cs_mapFulfilledRequests);
-    CService addrSquashed = Params().AllowMultiplePorts() ? addr : CService(addr, 0);
-    fulfilledreqmap_t::iterator it = mapFulfilledRequests.find(addrSquashed);
-
-    if (it != mapFulfilledRequests.end()) {
-        mapFulfilledRequests.erase(it++);
+    for (auto it = mapFulfilledRequests.begin(); it != mapFulfilledRequests.end();) {
+        if (it->first.first == addrSquashed) {
+            it = mapFulfilledRequests.erase(it);
+        } else {
+            ++it;
+        }
     }
 }
 
@@ -64,19 +69,9 @@ void CNetFulfilledRequestManager::CheckAndRemove()
     LOCK(cs_mapFulfilledRequests);
 
     int64_t now = GetTime();
-    fulfilledreqmap_t::iterator it = mapFulfilledRequests.begin();
-
-    while(it != mapFulfilledRequests.end()) {
-        fulfilledreqmapentry_t::iterator it_entry = it->second.begin();
-        while(it_entry != it->second.end()) {
-            if(now > it_entry->second) {
-                it->second.erase(it_entry++);
-            } else {
-                ++it_entry;
-            }
-        }
-        if(it->second.size() == 0) {
-            mapFulfilledRequests.erase(it++);
+    for (auto it = mapFulfilledRequests.begin(); it != mapFulfilledRequests.end();) {
+        if (now > it->second) {
+            it = mapFulfilledRequests.erase(it);
         } else {
             ++it;
         }
@@ -91,8 +86,9 @@ void NetFulfilledRequestStore::Clear()
 
 std::string NetFulfilledRequestStore::ToString() const
 {
+    LOCK(cs_mapFulfilledRequests);
     std::ostringstream info;
-    info << "Nodes with fulfilled requests: " << (int)mapFulfilledRequests.size();
+    info << "Fulfilled requests: " << (int)mapFulfilledRequests.size();
     return info.str();
 }
 
@@ -6,36 +6,77 @@
 #define BITCOIN_NETFULFILLEDMAN_H
 
 #include <netaddress.h>
+#include <saltedhasher.h>
 #include <serialize.h>
 #include <sync.h>
 
+#include <map>
 #include <memory>
+#include <string>
+#include <unordered_map>
+#include <utility>
 
 template<typename T>
 class CFlatDB;
 class CNetFulfilledRequestManager;
 
+/** A request, keyed by the (port squashed) address of the node and the request name */
+using FulfilledRequestKey = std::pair<CService, std::string>;
+
+template<>
+struct SaltedHasherImpl<FulfilledRequestKey>
+{
+    static std::size_t CalcHash(const FulfilledRequestKey& v, uint64_t k0, uint64_t k1)
+    {
+        const std::vector<unsigned char> addr_key{v.first.GetKey()};
+        return CSipHasher(k0, k1).Write(addr_key.data(), addr_key.size())
+                                 .Write((const unsigned char*)v.second.data(), v.second.size()).Finalize();
+    }
+};
+
 class NetFulfilledRequestStore
 {
 protected:
+    // The on-disk format, grouped by node
     typedef std::map<std::string, int64_t> fulfilledreqmapentry_t;
     typedef std::map<CService, fulfilledreqmapentry_t> fulfilledreqmap_t;
 
 protected:
-    //keep track of what node has/was asked for and when
-    fulfilledreqmap_t mapFulfilledRequests;
-    mutable RecursiveMutex cs_mapFulfilledRequests;
+    mutable Mutex cs_mapFulfilledRequests;
+    //keep track of what node has/was asked for and when, so a lookup is a single hash table probe
+    std::unordered_map<FulfilledRequestKey, int64_t, StaticSaltedHasher> mapFulfilledRequests GUARDED_BY(cs_mapFulfilledRequests);
 
 public:
-    SERIALIZE_METHODS(NetFulfilledRequestStore, obj)
+    template<typename Stream>
+    void Serialize(Stream& s) const LOCKS_EXCLUDED(cs_mapFulfilledRequests)
+    {
+        fulfilledreqmap_t mapByNode;
+        {
+            LOCK(cs_mapFulfilledRequests);
+            for (const auto& [key, expire] : mapFulfilledRequests) {
+                mapByNode[key.first][key.second] = expire;
+            }
+        }
+        s << mapByNode;
+    }
+
+    template<typename Stream>
+    void Unserialize(Stream& s) LOCKS_EXCLUDED(cs_mapFulfilledRequests)
     {
-        LOCK(obj.cs_mapFulfilledRequests);
-        READWRITE(obj.mapFulfilledRequests);
+        fulfilledreqmap_t mapByNode;
+        s >> mapByNode;
+        LOCK(cs_mapFulfilledRequests);
+        mapFulfilledRequests.clear();
+        for (auto& [addr, requests] : mapByNode) {
+            for (auto& [request, expire] : requests) {
+                mapFulfilledRequests.emplace(FulfilledRequestKey{addr, std::move(request)}, expire);
+            }
+        }
     }
 
-    void Clear();
+    void Clear() LOCKS_EXCLUDED(cs_mapFulfilledRequests);
 
-    std::string ToString() const;
+    std::string ToString() const LOCKS_EXCLUDED(cs_mapFulfilledRequests);
 };
 
 // Fulfilled requests are used to prevent nodes from asking for the same data on sync
@@ -54,12 +95,12 @@ public:
     ~CNetFulfilledRequestManager();
 
     bool IsValid() const { return is_valid; }
-    void CheckAndRemove();
+    void CheckAndRemove() LOCKS_EXCLUDED(cs_mapFulfilledRequests);
 
-    void AddFulfilledRequest(const CService& addr, const std::string& strRequest);
-    bool HasFulfilledRequest(const CService& addr, const std::string& strRequest);
+    void AddFulfilledRequest(const CService& addr, const std::string& strRequest) LOCKS_EXCLUDED(cs_mapFulfilledRequests);
+    bool HasFulfilledRequest(const CService& addr, const std::string& strRequest) const LOCKS_EXCLUDED(cs_mapFulfilledRequests);
 
-    void RemoveAllFulfilledRequests(const CService& addr);
+    void RemoveAllFulfilledRequests(const CService& addr) LOCKS_EXCLUDED(cs_mapFulfilledRequests);
 
     void DoMaintenance();
 };
@@ -0,0 +1,171 @@
+// Copyright (c) 2024 The Maximus developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <node/blockindexsnapshot.h>
+
+#include <arith_uint256.h>
+#include <chain.h>
+#include <crypto/common.h>
+#include <crypto/sha256.h>
+#include <flatfile.h>
+#include <uint256.h>
+#include <util/system.h>
+
+#include <cstring>
+#include <memory>
+#include <unordered_map>
+
+static constexpr uint32_t SNAPSHOT_MAGIC{0x4942584d}; // "MXBI"
+static constexpr uint32_t SNAPSHOT_VERSION{1};
+// magic, version, marker, number of records
+static constexpr size_t SNAPSHOT_HEADER_SIZE{4 + 4 + 32 + 8};
+// hash, parent, height, file, data pos, undo pos, chain work, tx count, status, version, merkle root, time, bits, nonce
+static constexpr size_t SNAPSHOT_RECORD_SIZE{32 + 4 + 4 + 4 + 4 + 4 + 32 + 4 + 4 + 4 + 32 + 4 + 4 + 4};
+static constexpr size_t SNAPSHOT_CHECKSUM_SIZE{CSHA256::OUTPUT_SIZE};
+static_assert(SNAPSHOT_RECORD_SIZE == 140);
+static constexpr uint32_t SNAPSHOT_NO_PARENT{0xffffffff};
+
+static void WriteHash(uint8_t* ptr, const uint256& hash)
+{
+    memcpy(ptr, hash.begin(), 32);
+}
+
+static uint256 ReadHash(const uint8_t* ptr)
+{
+    return uint256(Span<const unsigned char>{ptr, 32});
+}
+
+bool WriteBlockIndexSnapshot(const fs::path& path, const std::vector<const CBlockIndex*>& sorted_by_height, const uint256& marker)
+{
+    const size_t count = sorted_by_height.size();
+    std::vector<uint8_t> data(SNAPSHOT_HEADER_SIZE + count * SNAPSHOT_RECORD_SIZE + SNAPSHOT_CHECKSUM_SIZE);
+    WriteLE32(data.data(), SNAPSHOT_MAGIC);
+    WriteLE32(data.data() + 4, SNAPSHOT_VERSION);
+    WriteHash(data.data() + 8, marker);
+    WriteLE64(data.data() + 40, count);
+
+    std::unordered_map<const CBlockIndex*, uint32_t> records;
+    records.reserve(count);
+    for (size_t i = 0; i < count; i++) {
+        const CBlockIndex* pindex = sorted_by_height[i];
+        uint32_t parent{SNAPSHOT_NO_PARENT};
+        if (pindex->pprev != nullptr) {
+            const auto it = records.find(pindex->pprev);
+            if (it == records.end()) {
+                return error("%s: parent of %s missing", __func__, pindex->GetBlockHash().ToString());
+            }
+            parent = it->second;
+        }
+        records.emplace(pindex, uint32_t(i));
+
+        uint8_t* ptr = data.data() + SNAPSHOT_HEADER_SIZE + i * SNAPSHOT_RECORD_SIZE;
+        WriteHash(ptr, pindex->GetBlockHash());
+        WriteLE32(ptr + 32, parent);
+        WriteLE32(ptr + 36, uint32_t(pindex->nHeight));
+        WriteLE32(ptr + 40, uint32_t(pindex->nFile));
+        WriteLE32(ptr + 44, pindex->nDataPos);
+        WriteLE32(ptr + 48, pindex->nUndoPos);
+        WriteHash(ptr + 52, ArithToUint256(pindex->nChainWork));
+        WriteLE32(ptr + 84, pindex->nTx);
+        WriteLE32(ptr + 88, pindex->nStatus);
+        WriteLE32(ptr + 92, uint32_t(pindex->nVersion));
+        WriteHash(ptr + 96, pindex->hashMerkleRoot);
+        WriteLE32(ptr + 128, pindex->nTime);
+        WriteLE32(ptr + 132, pindex->nBits);
+        WriteLE32(ptr + 136, pindex->nNonce);
+    }
+    CSHA256().Write(data.data(), data.size() - SNAPSHOT_CHECKSUM_SIZE).Finalize(data.data() + data.size() - SNAPSHOT_CHECKSUM_SIZE);
+
+    fs::path path_tmp = path;
+    path_tmp += ".new";
+    FILE* file = fsbridge::fopen(path_tmp, "wb");
+    if (file == nullptr) {
+        return error("%s: failed to open %s", __func__, path_tmp.string());
+    }
+    const bool written = fwrite(data.data(), 1, data.size(), file) == data.size() && FileCommit(file);
+    if (fclose(file) != 0 || !written) {
+        fs::remove(path_tmp);
+        return error("%s: failed to write %s", __func__, path_tmp.string());
+    }
+    if (!RenameOver(path_tmp, path)) {
+        fs::remove(path_tmp);
+        return error("%s: failed to rename %s", __func__, path_tmp.string());
+    }
+    return true;
+}
+
+bool ReadBlockIndexSnapshot(const fs::path& path, const uint256& marker,
+                            const std::function<CBlockIndex*(const uint256&)>& insert_block_index,
+                            std::vector<CBlockIndex*>& sorted_by_height)
+{
+    if (!fs::exists(path)) {
+        return false;
+    }
+
+    // The records are parsed in place from the mapping, files are only read into memory without mmap
+    std::vector<uint8_t> buffer;
+    Span<const uint8_t> data;
+    const auto mapped = MapFile(path);
+    if (mapped != nullptr) {
+        data = mapped->Data();
+    } else {
+        FILE* file = fsbridge::fopen(path, "rb");
+        if (file == nullptr) {
+            return error("%s: failed to open %s", __func__, path.string());
+        }
+        buffer.resize(fs::file_size(path));
+        const bool read = fread(buffer.data(), 1, buffer.size(), file) == buffer.size();
+        fclose(file);
+        if (!read) {
+            return error("%s: failed to read %s", __func__, path.string());
+        }
+        data = buffer;
+    }
+
+    if (data.size() < SNAPSHOT_HEADER_SIZE + SNAPSHOT_CHECKSUM_SIZE ||
+        ReadLE32(data.data()) != SNAPSHOT_MAGIC || ReadLE32(data.data() + 4) != SNAPSHOT_VERSION) {
+        return error("%s: %s is not a block index snapshot", __func__, path.string());
+    }
+    if (ReadHash(data.data() + 8) != marker) {
+        return error("%s: %s doesn't belong to the block index database", __func__, path.string());
+    }
+    const uint64_t count = ReadLE64(data.data() + 40);
+    if (count > (data.size() - SNAPSHOT_HEADER_SIZE - SNAPSHOT_CHECKSUM_SIZE) / SNAPSHOT_RECORD_SIZE ||
+        data.size() != SNAPSHOT_HEADER_SIZE + count * SNAPSHOT_RECORD_SIZE + SNAPSHOT_CHECKSUM_SIZE) {
+        return error("%s: %s has an unexpected size", __func__, path.string());
+    }
+    uint8_t checksum[SNAPSHOT_CHECKSUM_SIZE];
+    CSHA256().Write(data.data(), data.size() - SNAPSHOT_CHECKSUM_SIZE).Finalize(checksum);
+    if (memcmp(checksum, data.data() + data.size() - SNAPSHOT_CHECKSUM_SIZE, SNAPSHOT_CHECKSUM_SIZE) != 0) {
+        return error("%s: %s is corrupt", __func__, path.string());
+    }
+
+    sorted_by_height.clear();
+    sorted_by_height.reserve(count);
+    for (size_t i = 0; i < count; i++) {
+        const uint8_t* ptr = data.data() + SNAPSHOT_HEADER_SIZE + i * SNAPSHOT_RECORD_SIZE;
+        CBlockIndex* pindex = insert_block_index(ReadHash(ptr));
+        const uint32_t parent = ReadLE32(ptr + 32);
+        if (parent != SNAPSHOT_NO_PARENT) {
+            if (parent >= i) {
+                return error("%s: %s has an entry before its parent", __func__, path.string());
+            }
+            pindex->pprev = sorted_by_height[parent];
+        }
+        pindex->nHeight        = int(ReadLE32(ptr + 36));
+        pindex->nFile          = int(ReadLE32(ptr + 40));
+        pindex->nDataPos       = ReadLE32(ptr + 44);
+        pindex->nUndoPos       = ReadLE32(ptr + 48);
+        pindex->nChainWork     = UintToArith256(ReadHash(ptr + 52));
+        pindex->nTx            = ReadLE32(ptr + 84);
+        pindex->nStatus        = ReadLE32(ptr + 88);
+        pindex->nVersion       = int32_t(ReadLE32(ptr + 92));
+        pindex->hashMerkleRoot = ReadHash(ptr + 96);
+        pindex->nTime          = ReadLE32(ptr + 128);
+        pindex->nBits          = ReadLE32(ptr + 132);
+        pindex->nNonce         = ReadLE32(ptr + 136);
+        sorted_by_height.push_back(pindex);
+    }
+    return true;
+}
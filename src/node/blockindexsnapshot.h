@@ -0,0 +1,41 @@
+// Copyright (c) 2024 The Maximus developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_NODE_BLOCKINDEXSNAPSHOT_H
+#define BITCOIN_NODE_BLOCKINDEXSNAPSHOT_H
+
+#include <fs.h>
+
+#include <functional>
+#include <vector>
+
+class CBlockIndex;
+class uint256;
+
+static constexpr bool DEFAULT_BLOCK_INDEX_SNAPSHOT{true};
+/** Name of the block index snapshot in the data directory */
+static const char* const BLOCK_INDEX_SNAPSHOT_FILENAME = "blockindex.dat";
+
+/**
+ * The block index snapshot holds the block tree database entries together with the chain work, in height order
+ * and as fixed-size little-endian records. Parents are referenced by record number, so loading it needs neither a
+ * LevelDB iteration nor a sort nor the hash lookups of the parents. The file is memory mapped where possible.
+ *
+ * A snapshot is only consistent with the block tree database that holds its marker, see
+ * CBlockTreeDB::WriteBlockIndexSnapshotMarker.
+ */
+
+/** Write the given entries, in which every parent has to come before its children, through a temporary file. */
+bool WriteBlockIndexSnapshot(const fs::path& path, const std::vector<const CBlockIndex*>& sorted_by_height, const uint256& marker);
+
+/**
+ * Read a snapshot written with the given marker. Entries are created with insert_block_index and returned in height
+ * order, with all fields stored in the block tree database as well as nChainWork set. Returns false if there is no
+ * such snapshot or it is corrupt, in which case some of the entries may have been created already.
+ */
+bool ReadBlockIndexSnapshot(const fs::path& path, const uint256& marker,
+                            const std::function<CBlockIndex*(const uint256&)>& insert_block_index,
+                            std::vector<CBlockIndex*>& sorted_by_height);
+
+#endif // BITCOIN_NODE_BLOCKINDEXSNAPSHOT_H
@@ -7,6 +7,7 @@
 #include <chain.h>
 #include <chainparams.h>
 #include <consensus/validation.h>
+#include <crypto/common.h>
 #include <dsnotificationinterface.h>
 #include <evo/deterministicmns.h>
 #include <flatfile.h>
@@ -19,6 +20,10 @@
 #include <validation.h>
 #include <walletinitinterface.h>
 
+#include <list>
+#include <map>
+#include <type_traits>
+
 // From validation. TODO move here
 bool FindBlockPos(FlatFilePos& pos, unsigned int nAddSize, unsigned int nHeight, CChain& active_chain, uint64_t nTime, bool fKnown = false);
 
@@ -45,6 +50,263 @@ static bool WriteBlockToDisk(const CBlock& block, FlatFilePos& pos, const CMessa
     return true;
 }
 
+/** Size of the message start and block size preceding each block in the block files */
+static constexpr unsigned int BLOCK_STORAGE_HEADER_SIZE{8};
+/** Memory used at most by the raw blocks kept in the block read cache */
+static constexpr size_t BLOCK_READ_CACHE_SIZE{32 << 20};
+/** Bytes read past a block when it is read right after the one preceding it in the file */
+static constexpr size_t BLOCK_READAHEAD_SIZE{4 << 20};
+/** Block files mapped into memory at most at once with -blockmmap */
+static constexpr size_t MAX_MAPPED_BLOCK_FILES{8};
+/** Memory used at most by the auxpows kept in the auxpow cache */
+static constexpr size_t AUXPOW_CACHE_SIZE{8 << 20};
+
+using RawBlockPtr = std::shared_ptr<const std::vector<uint8_t>>;
+
+namespace {
+/** Recently read raw blocks by their position, least recently used ones evicted first */
+class BlockReadCache
+{
+    using Key = std::pair<int, unsigned int>;
+    struct Entry {
+        RawBlockPtr block;
+        std::list<Key>::iterator lru_it;
+    };
+
+    Mutex m_mutex;
+    std::map<Key, Entry> m_blocks GUARDED_BY(m_mutex);
+    std::list<Key> m_lru GUARDED_BY(m_mutex);
+    size_t m_size GUARDED_BY(m_mutex){0};
+    /** Position of the block following the one last read from disk */
+    FlatFilePos m_next_pos GUARDED_BY(m_mutex);
+    /** Memory mappings of block files by their number */
+    std::map<int, std::shared_ptr<const MappedFlatFile>> m_mapped_files GUARDED_BY(m_mutex);
+
+public:
+    RawBlockPtr Get(const FlatFilePos& pos) EXCLUSIVE_LOCKS_REQUIRED(!m_mutex)
+    {
+        LOCK(m_mutex);
+        const auto it = m_blocks.find({pos.nFile, pos.nPos});
+        if (it == m_blocks.end()) return nullptr;
+        m_lru.splice(m_lru.begin(), m_lru, it->second.lru_it);
+        return it->second.block;
+    }
+
+    void Insert(const FlatFilePos& pos, RawBlockPtr block) EXCLUSIVE_LOCKS_REQUIRED(!m_mutex)
+    {
+        if (block->size() > BLOCK_READ_CACHE_SIZE / 4) return;
+        LOCK(m_mutex);
+        const Key key{pos.nFile, pos.nPos};
+        if (m_blocks.count(key)) return;
+        m_size += block->size();
+        m_lru.push_front(key);
+        m_blocks.emplace(key, Entry{std::move(block), m_lru.begin()});
+        while (m_size > BLOCK_READ_CACHE_SIZE) {
+            const auto it = m_blocks.find(m_lru.back());
+            m_size -= it->second.block->size();
+            m_blocks.erase(it);
+            m_lru.pop_back();
+        }
+    }
+
+    /** Map a block file, which must not be appended to or truncated anymore */
+    std::shared_ptr<const MappedFlatFile> GetMapping(int nFile) EXCLUSIVE_LOCKS_REQUIRED(!m_mutex)
+    {
+        {
+            LOCK(m_mutex);
+            const auto it = m_mapped_files.find(nFile);
+            if (it != m_mapped_files.end()) return it->second;
+        }
+        auto mapping = MapBlockFile(FlatFilePos{nFile, 0});
+        if (!mapping) return nullptr;
+        LOCK(m_mutex);
+        if (m_mapped_files.size() >= MAX_MAPPED_BLOCK_FILES && !m_mapped_files.count(nFile)) {
+            // Readers still holding the evicted mapping keep it alive until they are done
+            m_mapped_files.erase(m_mapped_files.begin());
+        }
+        return m_mapped_files.try_emplace(nFile, std::move(mapping)).first->second;
+    }
+
+    void EraseFile(int nFile) EXCLUSIVE_LOCKS_REQUIRED(!m_mutex)
+    {
+        LOCK(m_mutex);
+        m_mapped_files.erase(nFile);
+        for (auto it = m_blocks.lower_bound({nFile, 0}); it != m_blocks.end() && it->first.first == nFile;) {
+            m_size -= it->second.block->size();
+            m_lru.erase(it->second.lru_it);
+            it = m_blocks.erase(it);
+        }
+    }
+
+    /** Whether pos is that of the block following the ones last read from disk */
+    bool IsNextRead(const FlatFilePos& pos) EXCLUSIVE_LOCKS_REQUIRED(!m_mutex)
+    {
+        LOCK(m_mutex);
+        return pos == m_next_pos;
+    }
+
+    void SetNextRead(const FlatFilePos& next_pos) EXCLUSIVE_LOCKS_REQUIRED(!m_mutex)
+    {
+        LOCK(m_mutex);
+        m_next_pos = next_pos;
+    }
+};
+
+BlockReadCache g_block_read_cache;
+
+/**
+ * Verified auxpows of recently read merge-mined headers by block hash. The block index only has the pure header,
+ * the auxpow is read from the block file when the full header is needed. Headers are served to every syncing peer
+ * and by getblockheader, this spares reading, deserializing and checking them again each time.
+ */
+class AuxpowCache
+{
+    struct Entry {
+        std::shared_ptr<CAuxPow> auxpow;
+        size_t usage;
+        std::list<uint256>::iterator lru_it;
+    };
+
+    Mutex m_mutex;
+    std::map<uint256, Entry> m_auxpows GUARDED_BY(m_mutex);
+    std::list<uint256> m_lru GUARDED_BY(m_mutex);
+    size_t m_size GUARDED_BY(m_mutex){0};
+
+public:
+    std::shared_ptr<CAuxPow> Get(const uint256& hash) EXCLUSIVE_LOCKS_REQUIRED(!m_mutex)
+    {
+        LOCK(m_mutex);
+        const auto it = m_auxpows.find(hash);
+        if (it == m_auxpows.end()) return nullptr;
+        m_lru.splice(m_lru.begin(), m_lru, it->second.lru_it);
+        return it->second.auxpow;
+    }
+
+    void Insert(const uint256& hash, std::shared_ptr<CAuxPow> auxpow) EXCLUSIVE_LOCKS_REQUIRED(!m_mutex)
+    {
+        // The serialized size is a good enough estimate, the coinbase and branches dominate both
+        const size_t usage{sizeof(CAuxPow) + sizeof(CTransaction) + ::GetSerializeSize(*auxpow, PROTOCOL_VERSION)};
+        LOCK(m_mutex);
+        if (m_auxpows.count(hash)) return;
+        m_size += usage;
+        m_lru.push_front(hash);
+        m_auxpows.emplace(hash, Entry{std::move(auxpow), usage, m_lru.begin()});
+        while (m_size > AUXPOW_CACHE_SIZE) {
+            const auto it = m_auxpows.find(m_lru.back());
+            m_size -= it->second.usage;
+            m_auxpows.erase(it);
+            m_lru.pop_back();
+        }
+    }
+};
+
+AuxpowCache g_auxpow_cache;
+
+/** Read the block at pos from the mapping of its file, checking the storage header preceding it */
+RawBlockPtr ReadRawBlockFromMapping(const MappedFlatFile& mapping, const FlatFilePos& pos, const CMessageHeader::MessageStartChars& message_start)
+{
+    const Span<const uint8_t> data{mapping.Data()};
+    if (data.size() < pos.nPos) {
+        error("%s: Block position %s is past the end of the file", __func__, pos.ToString());
+        return nullptr;
+    }
+    const Span<const uint8_t> header{data.subspan(pos.nPos - BLOCK_STORAGE_HEADER_SIZE, BLOCK_STORAGE_HEADER_SIZE)};
+    if (memcmp(header.data(), message_start, CMessageHeader::MESSAGE_START_SIZE)) {
+        error("%s: Block magic mismatch for %s: %s versus expected %s", __func__, pos.ToString(),
+              HexStr(header.first(CMessageHeader::MESSAGE_START_SIZE)), HexStr(message_start));
+        return nullptr;
+    }
+    const uint32_t blk_size{ReadLE32(header.data() + CMessageHeader::MESSAGE_START_SIZE)};
+    if (data.size() - pos.nPos < blk_size) {
+        error("%s: Block at %s is past the end of the file", __func__, pos.ToString());
+        return nullptr;
+    }
+    const Span<const uint8_t> block{data.subspan(pos.nPos, blk_size)};
+    return std::make_shared<const std::vector<uint8_t>>(block.begin(), block.end());
+}
+} // namespace
+
+RawBlockPtr ReadRawBlockFromDisk(const FlatFilePos& pos, const CMessageHeader::MessageStartChars& message_start)
+{
+    if (auto block = g_block_read_cache.Get(pos)) {
+        return block;
+    }
+
+    if (pos.nPos < BLOCK_STORAGE_HEADER_SIZE) {
+        error("%s: Invalid block position %s", __func__, pos.ToString());
+        return nullptr;
+    }
+
+    // Files still appended to are read, as they may be truncated when they are finalized
+    if (gArgs.GetBoolArg("-blockmmap", DEFAULT_BLOCK_MMAP) && pos.nFile < GetLastBlockFileNumber()) {
+        if (const auto mapping = g_block_read_cache.GetMapping(pos.nFile)) {
+            auto block = ReadRawBlockFromMapping(*mapping, pos, message_start);
+            if (block) g_block_read_cache.Insert(pos, block);
+            return block;
+        }
+    }
+
+    FlatFilePos header_pos{pos.nFile, pos.nPos - BLOCK_STORAGE_HEADER_SIZE};
+    CAutoFile filein(OpenBlockFile(header_pos, true), SER_DISK, CLIENT_VERSION);
+    if (filein.IsNull()) {
+        error("ReadBlockFromDisk: OpenBlockFile failed for %s", pos.ToString());
+        return nullptr;
+    }
+
+    // Read the storage header and the block, and blocks following it in the file if it was read right after the one
+    // preceding it. Blocks may still be appended to the last block file, so there is no reading ahead in that one.
+    CMessageHeader::MessageStartChars blk_start;
+    unsigned int blk_size;
+    std::vector<uint8_t> buffer;
+    try {
+        filein >> blk_start >> blk_size;
+        if (memcmp(blk_start, message_start, CMessageHeader::MESSAGE_START_SIZE)) {
+            error("%s: Block magic mismatch for %s: %s versus expected %s", __func__, pos.ToString(),
+                  HexStr(blk_start), HexStr(message_start));
+            return nullptr;
+        }
+        if (blk_size > MAX_SIZE) {
+            error("%s: Block data is larger than maximum deserialization size for %s: %s versus %s", __func__,
+                  pos.ToString(), blk_size, MAX_SIZE);
+            return nullptr;
+        }
+        const bool readahead{g_block_read_cache.IsNextRead(pos) && pos.nFile < GetLastBlockFileNumber()};
+        buffer.resize(blk_size + (readahead ? BLOCK_READAHEAD_SIZE : 0));
+        const size_t read = fread(buffer.data(), 1, buffer.size(), filein.Get());
+        if (read < blk_size) {
+            throw std::ios_base::failure("end of file");
+        }
+        buffer.resize(read);
+    } catch (const std::exception& e) {
+        error("%s: Read from block file failed: %s for %s", __func__, e.what(), pos.ToString());
+        return nullptr;
+    }
+
+    auto block = std::make_shared<const std::vector<uint8_t>>(buffer.begin(), buffer.begin() + blk_size);
+    g_block_read_cache.Insert(pos, block);
+
+    // Cache the complete blocks read ahead, up to the first position that doesn't hold one
+    size_t offset{blk_size};
+    FlatFilePos next_pos{pos.nFile, pos.nPos + blk_size + BLOCK_STORAGE_HEADER_SIZE};
+    while (buffer.size() - offset >= BLOCK_STORAGE_HEADER_SIZE) {
+        if (memcmp(buffer.data() + offset, message_start, CMessageHeader::MESSAGE_START_SIZE)) break;
+        const uint32_t next_size{ReadLE32(buffer.data() + offset + CMessageHeader::MESSAGE_START_SIZE)};
+        offset += BLOCK_STORAGE_HEADER_SIZE;
+        if (buffer.size() - offset < next_size) break;
+        g_block_read_cache.Insert(next_pos, std::make_shared<const std::vector<uint8_t>>(buffer.begin() + offset, buffer.begin() + offset + next_size));
+        offset += next_size;
+        next_pos.nPos += next_size + BLOCK_STORAGE_HEADER_SIZE;
+    }
+    g_block_read_cache.SetNextRead(next_pos);
+
+    return block;
+}
+
+void EraseBlockReadCache(int nFile)
+{
+    g_block_read_cache.EraseFile(nFile);
+}
+
 /* Generic implementation of block reading that can handle
    both a block and its header.  */
 
@@ -53,15 +315,27 @@ static bool ReadBlockOrHeader(T& block, const FlatFilePos& pos, const Consensus:
 {
     block.SetNull();
 
-    // Open history file to read
-    CAutoFile filein(OpenBlockFile(pos, true), SER_DISK, CLIENT_VERSION);
-    if (filein.IsNull()) {
-        return error("ReadBlockFromDisk: OpenBlockFile failed for %s", pos.ToString());
+    // Blocks are read through the block read cache, headers only take their bytes from it if the block is there
+    RawBlockPtr raw_block;
+    if constexpr (std::is_same_v<T, CBlock>) {
+        raw_block = ReadRawBlockFromDisk(pos, Params().MessageStart());
+        if (!raw_block) return false;
+    } else {
+        raw_block = g_block_read_cache.Get(pos);
     }
 
     // Read block
     try {
-        filein >> block;
+        if (raw_block) {
+            SpanReader{SER_DISK, CLIENT_VERSION, *raw_block, 0} >> block;
+        } else {
+            // Open history file to read
+            CAutoFile filein(OpenBlockFile(pos, true), SER_DISK, CLIENT_VERSION);
+            if (filein.IsNull()) {
+                return error("ReadBlockFromDisk: OpenBlockFile failed for %s", pos.ToString());
+            }
+            filein >> block;
+        }
     } catch (const std::exception& e) {
         return error("%s: Deserialize or I/O error - %s at %s", __func__, e.what(), pos.ToString());
     }
@@ -82,7 +356,7 @@ static bool ReadBlockOrHeader(T& block, const CBlockIndex* pindex, const Consens
     if (!ReadBlockOrHeader(block, block_pos, consensusParams)) {
         return false;
     }
-    if (block.GetHash() != pindex->GetBlockHash()) {
+    if (GetPoWHashCached(block) != pindex->GetBlockHash()) {
         return error("ReadBlockFromDisk(CBlock&, CBlockIndex*): GetHash() doesn't match index for %s at %s",
                      pindex->ToString(), block_pos.ToString());
     }
@@ -101,7 +375,25 @@ bool ReadBlockFromDisk(CBlock& block, const CBlockIndex* pindex, const Consensus
 
 bool ReadBlockHeaderFromDisk(CBlockHeader& block, const CBlockIndex* pindex, const Consensus::Params& consensusParams)
 {
-    return ReadBlockOrHeader(block, pindex, consensusParams);
+    if (auto auxpow = g_auxpow_cache.Get(pindex->GetBlockHash())) {
+        // The rest of the header is what the block index has, its hash matched when the auxpow was cached
+        block.SetNull();
+        block.nVersion = pindex->nVersion;
+        if (pindex->pprev) block.hashPrevBlock = pindex->pprev->GetBlockHash();
+        block.hashMerkleRoot = pindex->hashMerkleRoot;
+        block.nTime = pindex->nTime;
+        block.nBits = pindex->nBits;
+        block.nNonce = pindex->nNonce;
+        block.auxpow = std::move(auxpow);
+        return true;
+    }
+    if (!ReadBlockOrHeader(block, pindex, consensusParams)) {
+        return false;
+    }
+    if (block.auxpow) {
+        g_auxpow_cache.Insert(pindex->GetBlockHash(), block.auxpow);
+    }
+    return true;
 }
 
 /** Store block on disk. If dbp is non-nullptr, the file is known to already reside on disk */
@@ -148,23 +440,10 @@ void ThreadImport(ChainstateManager& chainman, CDSNotificationInterface& dsnfi,
 
         // -reindex
         if (fReindex) {
-            int nFile = 0;
-            while (true) {
-                FlatFilePos pos(nFile, 0);
-                if (!fs::exists(GetBlockPosFilename(pos))) {
-                    break; // No block files left to reindex
-                }
-                FILE* file = OpenBlockFile(pos, true);
-                if (!file) {
-                    break; // This error is logged in OpenBlockFile
-                }
-                LogPrintf("Reindexing block file blk%05u.dat...\n", (unsigned int)nFile);
-                chainman.ActiveChainstate().LoadExternalBlockFile(file, &pos);
-                if (ShutdownRequested()) {
-                    LogPrintf("Shutdown requested. Exit %s\n", __func__);
-                    return;
-                }
-                nFile++;
+            chainman.ActiveChainstate().ReindexBlockFiles();
+            if (ShutdownRequested()) {
+                LogPrintf("Shutdown requested. Exit %s\n", __func__);
+                return;
             }
             pblocktree->WriteReindexing(false);
             fReindex = false;
@@ -9,6 +9,7 @@
 #include <protocol.h> // For CMessageHeader::MessageStartChars
 
 #include <cstdint>
+#include <memory>
 #include <vector>
 
 class ArgsManager;
@@ -26,12 +27,23 @@ struct Params;
 }
 
 static constexpr bool DEFAULT_STOPAFTERBLOCKIMPORT{false};
+static constexpr bool DEFAULT_BLOCK_MMAP{false};
 
 /** Functions for disk access for blocks */
 bool ReadBlockFromDisk(CBlock& block, const FlatFilePos& pos, const Consensus::Params& consensusParams);
 bool ReadBlockFromDisk(CBlock& block, const CBlockIndex* pindex, const Consensus::Params& consensusParams);
 bool ReadBlockHeaderFromDisk(CBlockHeader& block, const CBlockIndex* pindex, const Consensus::Params& consensusParams);
 
+/**
+ * Read the block stored at pos in its serialized form, which is also the one sent to peers. Recently read blocks are
+ * kept in a memory-bounded cache, and reading the blocks of a file in sequence (rescans, index syncs) reads ahead.
+ * With -blockmmap, blocks of the files no longer appended to are copied from a memory mapping of their file instead.
+ * Returns nullptr if the block can't be read.
+ */
+std::shared_ptr<const std::vector<uint8_t>> ReadRawBlockFromDisk(const FlatFilePos& pos, const CMessageHeader::MessageStartChars& message_start);
+/** Drop the cached blocks of a block file, e.g. when it is pruned */
+void EraseBlockReadCache(int nFile);
+
 bool UndoReadFromDisk(CBlockUndo& blockundo, const CBlockIndex* pindex);
 
 FlatFilePos SaveBlockToDisk(const CBlock& block, int nHeight, CChain& active_chain, const CChainParams& chainparams, const FlatFilePos* dbp);
@@ -0,0 +1,51 @@
+// Copyright (c) 2024 The Maximus developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <node/chainsnapshot.h>
+
+#include <chain.h>
+#include <sync.h>
+#include <validation.h>
+
+static ChainSnapshotRef g_chain_snapshot{std::make_shared<const ChainSnapshot>()};
+
+int ChainSnapshot::Height() const
+{
+    return tip ? tip->nHeight : -1;
+}
+
+ChainSnapshotRef GetChainSnapshot()
+{
+    return std::atomic_load(&g_chain_snapshot);
+}
+
+void PublishChainTip(const CBlockIndex* tip, CDeterministicMNList mn_list)
+{
+    auto snapshot = std::make_shared<ChainSnapshot>();
+    snapshot->tip = tip;
+    snapshot->mn_list = std::move(mn_list);
+    std::atomic_store(&g_chain_snapshot, ChainSnapshotRef{std::move(snapshot)});
+}
+
+void ResetChainSnapshot()
+{
+    std::atomic_store(&g_chain_snapshot, std::make_shared<const ChainSnapshot>());
+}
+
+const CBlockIndex* GetChainSnapshotTip(const ChainstateManager& chainman)
+{
+    if (const CBlockIndex* tip = GetChainSnapshot()->tip) return tip;
+    return WITH_LOCK(cs_main, return chainman.ActiveChain().Tip());
+}
+
+ChainSnapshotRef GetChainSnapshot(const ChainstateManager& chainman, CDeterministicMNManager& dmnman)
+{
+    ChainSnapshotRef snapshot = GetChainSnapshot();
+    if (snapshot->tip) return snapshot;
+
+    auto fallback = std::make_shared<ChainSnapshot>();
+    fallback->tip = WITH_LOCK(cs_main, return chainman.ActiveChain().Tip());
+    if (fallback->tip) fallback->mn_list = dmnman.GetListForBlock(fallback->tip);
+    return fallback;
+}
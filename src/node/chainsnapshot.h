@@ -0,0 +1,43 @@
+// Copyright (c) 2024 The Maximus developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_NODE_CHAINSNAPSHOT_H
+#define BITCOIN_NODE_CHAINSNAPSHOT_H
+
+#include <evo/deterministicmns.h>
+
+#include <memory>
+
+class CBlockIndex;
+class CDeterministicMNManager;
+class ChainstateManager;
+
+/**
+ * Immutable view of the active chain tip, published every time the tip changes.
+ * Read-only RPCs use it instead of taking cs_main just to look at the tip. Block index entries are
+ * never freed while the node runs, so the tip pointer stays valid after newer snapshots replace this one.
+ */
+struct ChainSnapshot {
+    const CBlockIndex* tip{nullptr};
+    //! Masternode list at tip
+    CDeterministicMNList mn_list;
+
+    int Height() const;
+};
+
+using ChainSnapshotRef = std::shared_ptr<const ChainSnapshot>;
+
+/** Latest published snapshot. Never null, tip is null until the first tip was published. */
+ChainSnapshotRef GetChainSnapshot();
+/** Publish a new tip. Called in tip order, with cs_main held. */
+void PublishChainTip(const CBlockIndex* tip, CDeterministicMNList mn_list);
+/** Forget the published state, on shutdown before the block index is unloaded */
+void ResetChainSnapshot();
+
+/** Active chain tip from the snapshot, or read under cs_main if none has been published yet */
+const CBlockIndex* GetChainSnapshotTip(const ChainstateManager& chainman);
+/** Latest published snapshot, or one built under cs_main if none has been published yet */
+ChainSnapshotRef GetChainSnapshot(const ChainstateManager& chainman, CDeterministicMNManager& dmnman);
+
+#endif // BITCOIN_NODE_CHAINSNAPSHOT_H
@@ -0,0 +1,112 @@
+// Copyright (c) 2024 The Maximus developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <node/coinsprefetcher.h>
+
+#include <logging.h>
+#include <primitives/block.h>
+#include <txdb.h>
+#include <util/hasher.h>
+#include <util/system.h>
+
+#include <algorithm>
+#include <unordered_set>
+
+void CoinsPrefetcher::Start(int threads_num)
+{
+    if (threads_num <= 0) return;
+    m_pool.resize(threads_num);
+    RenameThreadPool(m_pool, "coinsprefetch");
+}
+
+void CoinsPrefetcher::Stop()
+{
+    m_pool.clear_queue();
+    m_pool.stop(true);
+    LOCK(m_mutex);
+    m_jobs.clear();
+    m_job_order.clear();
+}
+
+void CoinsPrefetcher::Prefetch(const CBlock& block, const CCoinsViewCache& cache, const CCoinsViewDB& db)
+{
+    AssertLockHeld(::cs_main);
+    if (m_pool.size() == 0) return;
+
+    const uint256 block_hash = block.GetHash();
+    if (WITH_LOCK(m_mutex, return m_jobs.count(block_hash))) return;
+
+    std::unordered_set<uint256, SaltedTxidHasher> block_txids;
+    for (const auto& tx : block.vtx) {
+        block_txids.insert(tx->GetHash());
+    }
+    std::vector<COutPoint> outpoints;
+    for (const auto& tx : block.vtx) {
+        if (tx->IsCoinBase()) continue;
+        for (const CTxIn& txin : tx->vin) {
+            // Outputs created by the block itself are never in the database
+            if (block_txids.count(txin.prevout.hash) || cache.HaveCoinInCache(txin.prevout)) continue;
+            outpoints.push_back(txin.prevout);
+        }
+    }
+    if (outpoints.empty()) return;
+
+    Job job{&db, db.GetBestBlock(), {}};
+    if (job.db_best_block.IsNull()) return;
+    for (size_t begin = 0; begin < outpoints.size(); begin += COINS_PREFETCH_CHUNK) {
+        const size_t end = std::min(begin + COINS_PREFETCH_CHUNK, outpoints.size());
+        std::vector<COutPoint> chunk(outpoints.begin() + begin, outpoints.begin() + end);
+        job.chunks.push_back(m_pool.push([&db, best_block = job.db_best_block, chunk = std::move(chunk)](int) {
+            FetchedCoins ret;
+            if (db.GetBestBlock() != best_block) return ret;
+            ret = db.GetCoins(chunk);
+            // The database was (or is being) flushed meanwhile, we may have seen any mix of states
+            if (db.GetBestBlock() != best_block) ret.clear();
+            return ret;
+        }));
+    }
+
+    LOCK(m_mutex);
+    m_jobs.emplace(block_hash, std::move(job));
+    m_job_order.push_back(block_hash);
+    while (m_job_order.size() > MAX_COINS_PREFETCH_BLOCKS) {
+        // Likely a block we won't connect soon, its tasks still run but their results are dropped
+        m_jobs.erase(m_job_order.front());
+        m_job_order.pop_front();
+    }
+}
+
+size_t CoinsPrefetcher::Apply(const uint256& block_hash, CCoinsViewCache& cache, const CCoinsViewDB& db)
+{
+    AssertLockHeld(::cs_main);
+
+    Job job;
+    {
+        LOCK(m_mutex);
+        auto it = m_jobs.find(block_hash);
+        if (it == m_jobs.end()) return 0;
+        job = std::move(it->second);
+        m_jobs.erase(it);
+        m_job_order.erase(std::find(m_job_order.begin(), m_job_order.end(), block_hash));
+    }
+
+    // Flushes need cs_main, so the database can't change while we're adding the coins
+    if (job.db != &db || db.GetBestBlock() != job.db_best_block) return 0;
+
+    size_t added = 0;
+    for (auto& chunk : job.chunks) {
+        FetchedCoins coins;
+        try {
+            coins = chunk.get();
+        } catch (const std::future_error&) {
+            // Dropped by Stop()
+            continue;
+        }
+        for (auto& [outpoint, coin] : coins) {
+            added += cache.AddFetchedCoin(outpoint, std::move(coin));
+        }
+    }
+    LogPrint(BCLog::BENCHMARK, "    - Prefetched %u coins for block %s\n", added, block_hash.ToString());
+    return added;
+}
@@ -0,0 +1,71 @@
+// Copyright (c) 2024 The Maximus developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_NODE_COINSPREFETCHER_H
+#define BITCOIN_NODE_COINSPREFETCHER_H
+
+#include <coins.h>
+#include <ctpl_stl.h>
+#include <sync.h>
+#include <uint256.h>
+
+#include <deque>
+#include <future>
+#include <map>
+#include <utility>
+#include <vector>
+
+class CBlock;
+class CCoinsViewDB;
+
+extern RecursiveMutex cs_main;
+
+/** Maximum number of blocks whose coins are being prefetched at the same time. */
+static constexpr size_t MAX_COINS_PREFETCH_BLOCKS{16};
+/** Number of outpoints looked up by a single prefetch task. */
+static constexpr size_t COINS_PREFETCH_CHUNK{64};
+
+/**
+ * Reads the coins spent by blocks we are about to connect from the coins database on a pool of
+ * worker threads, so that ConnectBlock() finds them in the coins cache instead of reading them
+ * from LevelDB one by one.
+ *
+ * The reads run without cs_main while the chainstate may be flushed concurrently. Every task reads
+ * the best block of the database before and after its lookups, a flush in between (including one
+ * which is still in progress, during which the best block is not set) makes it drop its results.
+ * Coins are only added to the cache when the database is still at the same best block, and only
+ * for outpoints the cache has no entry for, exactly like a cache miss would have added them.
+ */
+class CoinsPrefetcher
+{
+public:
+    void Start(int threads_num);
+    void Stop();
+
+    /** Start fetching the coins spent by the block which are neither created by itself nor in the cache already. */
+    void Prefetch(const CBlock& block, const CCoinsViewCache& cache, const CCoinsViewDB& db) EXCLUSIVE_LOCKS_REQUIRED(::cs_main, !m_mutex);
+
+    /**
+     * Wait for the coins of the block (if they are prefetched) and add those which are still valid
+     * to the cache, which must be backed by db. Returns the number of coins added.
+     */
+    size_t Apply(const uint256& block_hash, CCoinsViewCache& cache, const CCoinsViewDB& db) EXCLUSIVE_LOCKS_REQUIRED(::cs_main, !m_mutex);
+
+private:
+    using FetchedCoins = std::vector<std::pair<COutPoint, Coin>>;
+
+    struct Job {
+        const CCoinsViewDB* db;
+        uint256 db_best_block;
+        std::vector<std::future<FetchedCoins>> chunks;
+    };
+
+    Mutex m_mutex;
+    std::map<uint256, Job> m_jobs GUARDED_BY(m_mutex);
+    //! Block hashes of m_jobs in the order they were started, to drop the oldest one above MAX_COINS_PREFETCH_BLOCKS
+    std::deque<uint256> m_job_order GUARDED_BY(m_mutex);
+    ctpl::thread_pool m_pool;
+};
+
+#endif // BITCOIN_NODE_COINSPREFETCHER_H
@@ -16,7 +16,17 @@
 #include <util/system.h>
 #include <validation.h>
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <exception>
+#include <future>
 #include <map>
+#include <type_traits>
+#include <vector>
+
+//! Maximum number of threads scanning the coins database for MuHash and plain statistics
+static constexpr size_t MAX_COINSTATS_SCAN_THREADS{8};
 
 uint64_t GetBogoSize(const CScript& script_pub_key)
 {
@@ -77,6 +87,10 @@ static void ApplyHash(MuHash3072& muhash, const uint256& hash, const std::map<ui
     }
 }
 
+// Combine the hash of a part of the coins into the hash of the whole set
+static void CombineHash(MuHash3072& muhash, const MuHash3072& part) { muhash *= part; }
+static void CombineHash(std::nullptr_t, std::nullptr_t) {}
+
 static void ApplyStats(CCoinsStats& stats, const uint256& hash, const std::map<uint32_t, Coin>& outputs)
 {
     assert(!outputs.empty());
@@ -103,36 +117,28 @@ static void ApplyStats(CCoinsStats& stats, std::nullptr_t, const uint256& hash,
     }
 }
 
-//! Calculate statistics about the unspent transaction output set
-template <typename T>
-static bool GetUTXOStats(CCoinsView* view, BlockManager& blockman, CCoinsStats& stats, T hash_obj, const std::function<void()>& interruption_point, const CBlockIndex* pindex)
+static void AddStats(CCoinsStats& stats, const CCoinsStats& part)
 {
-    std::unique_ptr<CCoinsViewCursor> pcursor(view->Cursor());
-    assert(pcursor);
-
-    if (!pindex) {
-        LOCK(cs_main);
-        assert(std::addressof(g_chainman.m_blockman) == std::addressof(blockman));
-        pindex = blockman.LookupBlockIndex(view->GetBestBlock());
-    }
-    stats.nHeight = Assert(pindex)->nHeight;
-    stats.hashBlock = pindex->GetBlockHash();
-
-    // Use CoinStatsIndex if it is requested and available and a hash_type of Muhash or None was requested
-    if ((stats.m_hash_type == CoinStatsHashType::MUHASH || stats.m_hash_type == CoinStatsHashType::NONE) && g_coin_stats_index && stats.index_requested) {
-        stats.index_used = true;
-        return g_coin_stats_index->LookUpStats(pindex, stats);
+    stats.nTransactions += part.nTransactions;
+    stats.nTransactionOutputs += part.nTransactionOutputs;
+    stats.nBogoSize += part.nBogoSize;
+    if (stats.total_amount.has_value()) {
+        stats.total_amount = part.total_amount.has_value() ? CheckedAdd(*stats.total_amount, *part.total_amount) : std::nullopt;
     }
+    stats.coins_count += part.coins_count;
+}
 
-    PrepareHash(hash_obj, stats);
-
+//! Add the coins of the cursor to the statistics and the hash
+template <typename T>
+static bool ScanCoins(CCoinsViewCursor& cursor, CCoinsStats& stats, T& hash_obj, const std::function<void()>& interruption_point)
+{
     uint256 prevkey;
     std::map<uint32_t, Coin> outputs;
-    while (pcursor->Valid()) {
+    while (cursor.Valid()) {
         interruption_point();
         COutPoint key;
         Coin coin;
-        if (pcursor->GetKey(key) && pcursor->GetValue(coin)) {
+        if (cursor.GetKey(key) && cursor.GetValue(coin)) {
             if (!outputs.empty() && key.hash != prevkey) {
                 ApplyStats(stats, prevkey, outputs);
                 ApplyHash(hash_obj, prevkey, outputs);
@@ -144,12 +150,97 @@ static bool GetUTXOStats(CCoinsView* view, BlockManager& blockman, CCoinsStats&
         } else {
             return error("%s: unable to read value", __func__);
         }
-        pcursor->Next();
+        cursor.Next();
     }
     if (!outputs.empty()) {
         ApplyStats(stats, prevkey, outputs);
         ApplyHash(hash_obj, prevkey, outputs);
     }
+    return true;
+}
+
+//! ScanCoins for the cursors of all parts on a thread each, combining their statistics and hashes
+template <typename T>
+static bool ScanCoinsParallel(const std::vector<std::unique_ptr<CCoinsViewCursor>>& cursors, CCoinsStats& stats, T& hash_obj, const std::function<void()>& interruption_point)
+{
+    struct ScanInterrupted {};
+    std::atomic<bool> interrupted{false};
+    const std::function<void()> part_interruption_point = [&interrupted] {
+        if (interrupted) throw ScanInterrupted{};
+    };
+
+    std::vector<CCoinsStats> part_stats(cursors.size(), CCoinsStats{stats.m_hash_type});
+    std::vector<T> part_hashes(cursors.size());
+    std::vector<std::future<bool>> scans;
+    for (size_t i = 0; i < cursors.size(); ++i) {
+        scans.push_back(std::async(std::launch::async, [&, i] {
+            try {
+                return ScanCoins(*cursors[i], part_stats[i], part_hashes[i], part_interruption_point);
+            } catch (const ScanInterrupted&) {
+                return false;
+            }
+        }));
+    }
+
+    // Only this thread may run the caller's interruption point, when it throws the scans are
+    // stopped and waited for before passing the exception on
+    std::exception_ptr interruption;
+    for (auto& scan : scans) {
+        while (scan.wait_for(std::chrono::milliseconds{100}) != std::future_status::ready) {
+            if (interruption || !interruption_point) continue;
+            try {
+                interruption_point();
+            } catch (...) {
+                interruption = std::current_exception();
+                interrupted = true;
+            }
+        }
+    }
+    if (interruption) std::rethrow_exception(interruption);
+
+    bool success{true};
+    for (size_t i = 0; i < scans.size(); ++i) {
+        success &= scans[i].get();
+        AddStats(stats, part_stats[i]);
+        CombineHash(hash_obj, part_hashes[i]);
+    }
+    return success;
+}
+
+//! Calculate statistics about the unspent transaction output set
+template <typename T>
+static bool GetUTXOStats(CCoinsView* view, BlockManager& blockman, CCoinsStats& stats, T hash_obj, const std::function<void()>& interruption_point, const CBlockIndex* pindex)
+{
+    // The serialized hash depends on the order of the coins, MuHash and the plain statistics
+    // don't, so they are computed over parts of the coins at the same time
+    constexpr bool ordered{std::is_same_v<T, CHashWriter>};
+    const auto cursors = view->RangeCursors(ordered ? 1 : std::clamp<size_t>(GetNumCores(), 1, MAX_COINSTATS_SCAN_THREADS));
+    assert(!cursors.empty() && cursors.front());
+
+    if (!pindex) {
+        LOCK(cs_main);
+        assert(std::addressof(g_chainman.m_blockman) == std::addressof(blockman));
+        pindex = blockman.LookupBlockIndex(cursors.front()->GetBestBlock());
+    }
+    stats.nHeight = Assert(pindex)->nHeight;
+    stats.hashBlock = pindex->GetBlockHash();
+
+    // Use CoinStatsIndex if it is requested and available and a hash_type of Muhash or None was requested
+    if ((stats.m_hash_type == CoinStatsHashType::MUHASH || stats.m_hash_type == CoinStatsHashType::NONE) && g_coin_stats_index && stats.index_requested) {
+        stats.index_used = true;
+        return g_coin_stats_index->LookUpStats(pindex, stats);
+    }
+
+    PrepareHash(hash_obj, stats);
+
+    bool scanned;
+    if constexpr (ordered) {
+        scanned = ScanCoins(*cursors.front(), stats, hash_obj, interruption_point);
+    } else {
+        scanned = cursors.size() == 1 ? ScanCoins(*cursors.front(), stats, hash_obj, interruption_point)
+                                      : ScanCoinsParallel(cursors, stats, hash_obj, interruption_point);
+    }
+    if (!scanned) return false;
 
     FinalizeHash(hash_obj, stats);
 
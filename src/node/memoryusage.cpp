@@ -0,0 +1,46 @@
+// Copyright (c) 2024 The Maximus developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <node/memoryusage.h>
+
+#include <addrman.h>
+#include <evo/deterministicmns.h>
+#include <governance/governance.h>
+#include <llmq/context.h>
+#include <llmq/instantsend.h>
+#include <llmq/quorums.h>
+#include <llmq/signing_shares.h>
+#include <masternode/meta.h>
+#include <net.h>
+#include <node/context.h>
+#include <txmempool.h>
+
+std::vector<std::pair<std::string, size_t>> GetSubsystemMemoryUsage(const NodeContext& node)
+{
+    std::vector<std::pair<std::string, size_t>> ret;
+    if (node.mempool) {
+        ret.emplace_back("mempool", node.mempool->DynamicMemoryUsage());
+    }
+    if (node.dmnman) {
+        ret.emplace_back("masternodeLists", node.dmnman->GetListsCacheMemoryUsage());
+    }
+    if (node.llmq_ctx) {
+        ret.emplace_back("quorums", node.llmq_ctx->qman->DynamicMemoryUsage());
+        ret.emplace_back("sigShares", node.llmq_ctx->shareman->DynamicMemoryUsage());
+        ret.emplace_back("instantSend", node.llmq_ctx->isman->DynamicMemoryUsage());
+    }
+    if (node.govman) {
+        ret.emplace_back("governance", node.govman->DynamicMemoryUsage());
+    }
+    if (node.mn_metaman) {
+        ret.emplace_back("masternodeMeta", node.mn_metaman->DynamicMemoryUsage());
+    }
+    if (node.addrman) {
+        ret.emplace_back("addrman", node.addrman->DynamicMemoryUsage());
+    }
+    if (node.connman) {
+        ret.emplace_back("peerBuffers", node.connman->GetPeerBuffersSize());
+    }
+    return ret;
+}
@@ -0,0 +1,22 @@
+// Copyright (c) 2024 The Maximus developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_NODE_MEMORYUSAGE_H
+#define BITCOIN_NODE_MEMORYUSAGE_H
+
+#include <cstddef>
+#include <string>
+#include <utility>
+#include <vector>
+
+struct NodeContext;
+
+/**
+ * Estimated heap usage in bytes of the major in-memory structures of the node, by subsystem name. Subsystems
+ * which are not running are left out. These are estimates in the style of DynamicMemoryUsage: allocator
+ * overhead is approximated and memory shared between subsystems is only counted by its owner.
+ */
+std::vector<std::pair<std::string, size_t>> GetSubsystemMemoryUsage(const NodeContext& node);
+
+#endif // BITCOIN_NODE_MEMORYUSAGE_H
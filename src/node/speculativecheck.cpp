@@ -0,0 +1,80 @@
+// Copyright (c) 2024 The Maximus developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <node/speculativecheck.h>
+
+#include <coins.h>
+#include <logging.h>
+#include <primitives/block.h>
+#include <script/interpreter.h>
+#include <util/hasher.h>
+#include <util/system.h>
+#include <validation.h>
+
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+void SpeculativeBlockChecker::Start(int threads_num)
+{
+    if (threads_num <= 0) return;
+    m_pool.resize(threads_num);
+    RenameThreadPool(m_pool, "speccheck");
+}
+
+void SpeculativeBlockChecker::Stop()
+{
+    m_pool.clear_queue();
+    m_pool.stop(true);
+}
+
+void SpeculativeBlockChecker::Check(const std::shared_ptr<const CBlock>& pblock, unsigned int flags, const CCoinsViewCache& coins)
+{
+    AssertLockHeld(::cs_main);
+    if (m_pool.size() == 0) return;
+
+    // Transactions to check by their index in the block, with the outputs they spend
+    std::vector<std::pair<size_t, std::vector<CTxOut>>> txs;
+    std::unordered_map<COutPoint, CTxOut, SaltedOutpointHasher> block_outputs;
+    for (size_t i = 0; i < pblock->vtx.size(); ++i) {
+        const CTransaction& tx = *pblock->vtx[i];
+        if (!tx.IsCoinBase()) {
+            std::vector<CTxOut> spent_outputs;
+            spent_outputs.reserve(tx.vin.size());
+            for (const CTxIn& txin : tx.vin) {
+                if (const auto it = block_outputs.find(txin.prevout); it != block_outputs.end()) {
+                    spent_outputs.push_back(it->second);
+                    continue;
+                }
+                const Coin& coin = coins.AccessCoin(txin.prevout);
+                if (coin.IsSpent()) break;
+                spent_outputs.push_back(coin.out);
+            }
+            if (spent_outputs.size() == tx.vin.size()) {
+                txs.emplace_back(i, std::move(spent_outputs));
+            }
+        }
+        for (uint32_t n = 0; n < tx.vout.size(); ++n) {
+            block_outputs.emplace(COutPoint(tx.GetHash(), n), tx.vout[n]);
+        }
+    }
+    if (txs.empty()) return;
+
+    m_pool.push([pblock, flags, txs = std::move(txs)](int) {
+        size_t inputs{0}, valid{0};
+        for (const auto& [i, spent_outputs] : txs) {
+            const CTransaction& tx = *pblock->vtx[i];
+            PrecomputedTransactionData txdata;
+            txdata.Init(tx, std::vector<CTxOut>(spent_outputs));
+            for (unsigned int j = 0; j < tx.vin.size(); ++j) {
+                // Only valid signatures are cached, an invalid block still fails in ConnectBlock() as usual
+                CScriptCheck check(spent_outputs[j], tx, j, flags, /* cacheIn = */ true, &txdata);
+                valid += check();
+                ++inputs;
+            }
+        }
+        LogPrint(BCLog::BENCHMARK, "Speculatively checked %u inputs (%u valid) of competing block %s\n",
+                 inputs, valid, pblock->GetHash().ToString());
+    });
+}
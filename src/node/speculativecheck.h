@@ -0,0 +1,43 @@
+// Copyright (c) 2024 The Maximus developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_NODE_SPECULATIVECHECK_H
+#define BITCOIN_NODE_SPECULATIVECHECK_H
+
+#include <ctpl_stl.h>
+#include <sync.h>
+
+#include <memory>
+
+class CBlock;
+class CCoinsViewCache;
+
+extern RecursiveMutex cs_main;
+
+/** Default for -speculativechecks */
+static constexpr bool DEFAULT_SPECULATIVE_CHECKS{true};
+
+/**
+ * Verifies the scripts of blocks which compete with the active tip on a worker thread while they are not connected.
+ * Valid signatures are stored in the signature cache, so if such a block wins later, the reorg finds them there
+ * instead of verifying them while holding cs_main.
+ *
+ * The spent coins are taken from the coins cache of the active chain when the check is queued. Coins spent by the
+ * active tip are missing there, transactions spending one of them (usually those in both blocks, whose signatures
+ * are cached since they were accepted to the mempool) are skipped.
+ */
+class SpeculativeBlockChecker
+{
+public:
+    void Start(int threads_num);
+    void Stop();
+
+    /** Queue the script checks of the block, with the script verification flags it would be connected with. */
+    void Check(const std::shared_ptr<const CBlock>& pblock, unsigned int flags, const CCoinsViewCache& coins) EXCLUSIVE_LOCKS_REQUIRED(::cs_main);
+
+private:
+    ctpl::thread_pool m_pool;
+};
+
+#endif // BITCOIN_NODE_SPECULATIVECHECK_H
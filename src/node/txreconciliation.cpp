@@ -0,0 +1,331 @@
+// Copyright (c) 2024 The Maximus developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <node/txreconciliation.h>
+
+#include <crypto/siphash.h>
+#include <hash.h>
+#include <logging.h>
+#include <random.h>
+#include <util/check.h>
+
+#include <limits>
+#include <set>
+#include <unordered_map>
+#include <variant>
+
+namespace {
+
+/** Static salt component used to compute short txids for reconciliation. */
+const std::string RECON_STATIC_SALT = "Tx Relay Salting";
+
+/** Keeps track of the reconciliation-related state of a single registered peer. */
+class TxReconciliationState
+{
+public:
+    /** Whether we send REQSIDLIST to this peer (it is our outbound peer) or answer its requests. */
+    const bool m_we_initiate;
+    /** Whether transactions are still flooded to this peer besides being reconciled. */
+    bool m_flood_to{false};
+
+    /** Keys of the short id function, derived from both salts. */
+    const uint64_t m_k0, m_k1;
+
+    /** Transactions we want to announce to the peer during the next reconciliation. */
+    std::set<uint256> m_local_set;
+
+    /** As a responder: the set we sent in our last sketch, until the peer sends SIDLISTDIFF. */
+    std::unordered_map<uint32_t, uint256> m_sent_sketch;
+
+    /** As an initiator: when we sent the REQSIDLIST we are waiting for the sketch of. */
+    std::optional<std::chrono::microseconds> m_request_sent;
+    /** As an initiator: when the next REQSIDLIST is due. */
+    std::chrono::microseconds m_next_request{0};
+
+    TxReconciliationState(bool we_initiate, uint64_t k0, uint64_t k1) : m_we_initiate(we_initiate), m_k0(k0), m_k1(k1) {}
+
+    uint32_t ComputeShortID(const uint256& txid) const
+    {
+        return static_cast<uint32_t>(SipHashUint256(m_k0, m_k1, txid));
+    }
+};
+
+} // namespace
+
+/** Actual implementation for TxReconciliationTracker's data structure. */
+class TxReconciliationTracker::Impl
+{
+private:
+    mutable Mutex m_txreconciliation_mutex;
+
+    // Local protocol version
+    const uint32_t m_recon_version;
+
+    /**
+     * Keeps track of reconciliation states of eligible peers.
+     * For pre-registered peers, the locally generated salt is stored.
+     * For registered peers, the locally generated salt is forgotten, and the state (including
+     * "full" salt) is stored instead.
+     */
+    std::unordered_map<NodeId, std::variant<uint64_t, TxReconciliationState>> m_states GUARDED_BY(m_txreconciliation_mutex);
+
+    /** How many registered outbound peers we are currently flooding to. */
+    size_t m_outbound_flooding_peers GUARDED_BY(m_txreconciliation_mutex){0};
+
+    TxReconciliationState* GetRegisteredState(NodeId peer_id) EXCLUSIVE_LOCKS_REQUIRED(m_txreconciliation_mutex)
+    {
+        auto it = m_states.find(peer_id);
+        if (it == m_states.end()) return nullptr;
+        return std::get_if<TxReconciliationState>(&it->second);
+    }
+
+public:
+    explicit Impl(uint32_t recon_version) : m_recon_version(recon_version) {}
+
+    uint64_t PreRegisterPeer(NodeId peer_id) EXCLUSIVE_LOCKS_REQUIRED(!m_txreconciliation_mutex)
+    {
+        AssertLockNotHeld(m_txreconciliation_mutex);
+        LOCK(m_txreconciliation_mutex);
+
+        LogPrint(BCLog::NET, "Pre-register peer=%d for reconciling\n", peer_id);
+        const uint64_t local_salt{GetRand(UINT64_MAX)};
+
+        // We do this exactly once per peer (which are unique by NodeId, see GetNewNodeId) so it's
+        // safe to assume we don't have this record yet.
+        Assume(m_states.emplace(peer_id, local_salt).second);
+        return local_salt;
+    }
+
+    ReconciliationRegisterResult RegisterPeer(NodeId peer_id, bool is_peer_inbound, uint32_t peer_recon_version,
+                                              uint64_t remote_salt) EXCLUSIVE_LOCKS_REQUIRED(!m_txreconciliation_mutex)
+    {
+        AssertLockNotHeld(m_txreconciliation_mutex);
+        LOCK(m_txreconciliation_mutex);
+        auto recon_state = m_states.find(peer_id);
+
+        if (recon_state == m_states.end()) return ReconciliationRegisterResult::NOT_FOUND;
+
+        if (std::holds_alternative<TxReconciliationState>(recon_state->second)) {
+            return ReconciliationRegisterResult::ALREADY_REGISTERED;
+        }
+
+        uint64_t local_salt = *std::get_if<uint64_t>(&recon_state->second);
+
+        // If the peer supports the version which is lower than ours, we downgrade to the version
+        // it supports. For now, this only guarantees that nodes with future reconciliation
+        // versions have the choice of reconciling with this current version. However, they also
+        // have the choice to refuse supporting reconciliations if the common version is not
+        // satisfactory (e.g. too low).
+        const uint32_t recon_version{std::min(peer_recon_version, m_recon_version)};
+        // v1 is the lowest version, so suggesting something below must be a protocol violation.
+        if (recon_version < 1) return ReconciliationRegisterResult::PROTOCOL_VIOLATION;
+
+        LogPrint(BCLog::NET, "Register peer=%d (inbound=%i)\n", peer_id, is_peer_inbound);
+
+        // Both sides combine the salts in ascending order so that they end up with the same keys.
+        CHashWriter hasher(SER_GETHASH, 0);
+        hasher << RECON_STATIC_SALT << std::min(local_salt, remote_salt) << std::max(local_salt, remote_salt);
+        const uint256 full_salt{hasher.GetHash()};
+
+        auto& state = recon_state->second.emplace<TxReconciliationState>(/*we_initiate=*/!is_peer_inbound, full_salt.GetUint64(0), full_salt.GetUint64(1));
+        if (!is_peer_inbound && m_outbound_flooding_peers < MAX_OUTBOUND_FLOOD_TO) {
+            state.m_flood_to = true;
+            ++m_outbound_flooding_peers;
+        }
+        return ReconciliationRegisterResult::SUCCESS;
+    }
+
+    void ForgetPeer(NodeId peer_id) EXCLUSIVE_LOCKS_REQUIRED(!m_txreconciliation_mutex)
+    {
+        AssertLockNotHeld(m_txreconciliation_mutex);
+        LOCK(m_txreconciliation_mutex);
+        auto it = m_states.find(peer_id);
+        if (it == m_states.end()) return;
+        if (const auto* state = std::get_if<TxReconciliationState>(&it->second); state && state->m_flood_to) {
+            --m_outbound_flooding_peers;
+        }
+        m_states.erase(it);
+        LogPrint(BCLog::NET, "Forget txreconciliation state of peer=%d\n", peer_id);
+    }
+
+    bool IsPeerRegistered(NodeId peer_id) const EXCLUSIVE_LOCKS_REQUIRED(!m_txreconciliation_mutex)
+    {
+        AssertLockNotHeld(m_txreconciliation_mutex);
+        LOCK(m_txreconciliation_mutex);
+        auto recon_state = m_states.find(peer_id);
+        return (recon_state != m_states.end() &&
+                std::holds_alternative<TxReconciliationState>(recon_state->second));
+    }
+
+    bool ShouldFloodTo(NodeId peer_id) EXCLUSIVE_LOCKS_REQUIRED(!m_txreconciliation_mutex)
+    {
+        AssertLockNotHeld(m_txreconciliation_mutex);
+        LOCK(m_txreconciliation_mutex);
+        const auto* state = GetRegisteredState(peer_id);
+        return state == nullptr || state->m_flood_to;
+    }
+
+    bool AddToSet(NodeId peer_id, const uint256& txid) EXCLUSIVE_LOCKS_REQUIRED(!m_txreconciliation_mutex)
+    {
+        AssertLockNotHeld(m_txreconciliation_mutex);
+        LOCK(m_txreconciliation_mutex);
+        auto* state = GetRegisteredState(peer_id);
+        if (state == nullptr || state->m_local_set.size() >= MAX_RECONSET_SIZE) return false;
+        state->m_local_set.insert(txid);
+        return true;
+    }
+
+    void TryRemoveFromSet(NodeId peer_id, const uint256& txid) EXCLUSIVE_LOCKS_REQUIRED(!m_txreconciliation_mutex)
+    {
+        AssertLockNotHeld(m_txreconciliation_mutex);
+        LOCK(m_txreconciliation_mutex);
+        auto* state = GetRegisteredState(peer_id);
+        if (state == nullptr) return;
+        state->m_local_set.erase(txid);
+    }
+
+    std::optional<uint16_t> InitiateReconciliationRequest(NodeId peer_id, std::chrono::microseconds now) EXCLUSIVE_LOCKS_REQUIRED(!m_txreconciliation_mutex)
+    {
+        AssertLockNotHeld(m_txreconciliation_mutex);
+        LOCK(m_txreconciliation_mutex);
+        auto* state = GetRegisteredState(peer_id);
+        if (state == nullptr || !state->m_we_initiate || now < state->m_next_request) {
+            return std::nullopt;
+        }
+        if (state->m_request_sent) {
+            // Still pending a whole interval after it was sent, the peer dropped or ignored the
+            // request. Give up on it, our set is still there and goes into the next one.
+            LogPrint(BCLog::NET, "Reconciliation request to peer=%d timed out\n", peer_id);
+        }
+        state->m_request_sent = now;
+        state->m_next_request = now + RECON_REQUEST_INTERVAL;
+        return static_cast<uint16_t>(std::min<size_t>(state->m_local_set.size(), std::numeric_limits<uint16_t>::max()));
+    }
+
+    std::optional<std::vector<uint32_t>> RespondToReconciliationRequest(NodeId peer_id) EXCLUSIVE_LOCKS_REQUIRED(!m_txreconciliation_mutex)
+    {
+        AssertLockNotHeld(m_txreconciliation_mutex);
+        LOCK(m_txreconciliation_mutex);
+        auto* state = GetRegisteredState(peer_id);
+        if (state == nullptr || state->m_we_initiate) return std::nullopt;
+
+        // Whatever the peer didn't ask for from the previous round it already has.
+        state->m_sent_sketch.clear();
+        std::vector<uint32_t> short_ids;
+        short_ids.reserve(state->m_local_set.size());
+        for (const auto& txid : state->m_local_set) {
+            const uint32_t short_id = state->ComputeShortID(txid);
+            if (state->m_sent_sketch.emplace(short_id, txid).second) {
+                short_ids.push_back(short_id);
+            }
+        }
+        state->m_local_set.clear();
+        return short_ids;
+    }
+
+    bool HandleSketch(NodeId peer_id, const std::vector<uint32_t>& remote_short_ids, std::vector<uint256>& txs_to_announce,
+                      std::vector<uint32_t>& short_ids_to_request) EXCLUSIVE_LOCKS_REQUIRED(!m_txreconciliation_mutex)
+    {
+        AssertLockNotHeld(m_txreconciliation_mutex);
+        LOCK(m_txreconciliation_mutex);
+        auto* state = GetRegisteredState(peer_id);
+        if (state == nullptr || !state->m_we_initiate || !state->m_request_sent) return false;
+        state->m_request_sent.reset();
+
+        const std::set<uint32_t> remote_set(remote_short_ids.begin(), remote_short_ids.end());
+        std::set<uint32_t> local_short_ids;
+        for (const auto& txid : state->m_local_set) {
+            const uint32_t short_id = state->ComputeShortID(txid);
+            local_short_ids.insert(short_id);
+            if (remote_set.count(short_id) == 0) {
+                txs_to_announce.push_back(txid);
+            }
+        }
+        for (const uint32_t short_id : remote_set) {
+            if (local_short_ids.count(short_id) == 0) {
+                short_ids_to_request.push_back(short_id);
+            }
+        }
+        state->m_local_set.clear();
+        return true;
+    }
+
+    std::vector<uint256> HandleReconciliationDifference(NodeId peer_id, const std::vector<uint32_t>& short_ids) EXCLUSIVE_LOCKS_REQUIRED(!m_txreconciliation_mutex)
+    {
+        AssertLockNotHeld(m_txreconciliation_mutex);
+        LOCK(m_txreconciliation_mutex);
+        std::vector<uint256> ret;
+        auto* state = GetRegisteredState(peer_id);
+        if (state == nullptr || state->m_we_initiate) return ret;
+
+        for (const uint32_t short_id : short_ids) {
+            if (const auto it = state->m_sent_sketch.find(short_id); it != state->m_sent_sketch.end()) {
+                ret.push_back(it->second);
+            }
+        }
+        state->m_sent_sketch.clear();
+        return ret;
+    }
+};
+
+TxReconciliationTracker::TxReconciliationTracker(uint32_t recon_version) : m_impl{std::make_unique<TxReconciliationTracker::Impl>(recon_version)} {}
+
+TxReconciliationTracker::~TxReconciliationTracker() = default;
+
+uint64_t TxReconciliationTracker::PreRegisterPeer(NodeId peer_id)
+{
+    return m_impl->PreRegisterPeer(peer_id);
+}
+
+ReconciliationRegisterResult TxReconciliationTracker::RegisterPeer(NodeId peer_id, bool is_peer_inbound,
+                                                                   uint32_t peer_recon_version, uint64_t remote_salt)
+{
+    return m_impl->RegisterPeer(peer_id, is_peer_inbound, peer_recon_version, remote_salt);
+}
+
+void TxReconciliationTracker::ForgetPeer(NodeId peer_id)
+{
+    m_impl->ForgetPeer(peer_id);
+}
+
+bool TxReconciliationTracker::IsPeerRegistered(NodeId peer_id) const
+{
+    return m_impl->IsPeerRegistered(peer_id);
+}
+
+bool TxReconciliationTracker::ShouldFloodTo(NodeId peer_id) const
+{
+    return m_impl->ShouldFloodTo(peer_id);
+}
+
+bool TxReconciliationTracker::AddToSet(NodeId peer_id, const uint256& txid)
+{
+    return m_impl->AddToSet(peer_id, txid);
+}
+
+void TxReconciliationTracker::TryRemoveFromSet(NodeId peer_id, const uint256& txid)
+{
+    m_impl->TryRemoveFromSet(peer_id, txid);
+}
+
+std::optional<uint16_t> TxReconciliationTracker::InitiateReconciliationRequest(NodeId peer_id, std::chrono::microseconds now)
+{
+    return m_impl->InitiateReconciliationRequest(peer_id, now);
+}
+
+std::optional<std::vector<uint32_t>> TxReconciliationTracker::RespondToReconciliationRequest(NodeId peer_id)
+{
+    return m_impl->RespondToReconciliationRequest(peer_id);
+}
+
+bool TxReconciliationTracker::HandleSketch(NodeId peer_id, const std::vector<uint32_t>& remote_short_ids,
+                                           std::vector<uint256>& txs_to_announce, std::vector<uint32_t>& short_ids_to_request)
+{
+    return m_impl->HandleSketch(peer_id, remote_short_ids, txs_to_announce, short_ids_to_request);
+}
+
+std::vector<uint256> TxReconciliationTracker::HandleReconciliationDifference(NodeId peer_id, const std::vector<uint32_t>& short_ids)
+{
+    return m_impl->HandleReconciliationDifference(peer_id, short_ids);
+}
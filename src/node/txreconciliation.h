@@ -0,0 +1,127 @@
+// Copyright (c) 2024 The Maximus developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_NODE_TXRECONCILIATION_H
+#define BITCOIN_NODE_TXRECONCILIATION_H
+
+#include <net.h>
+#include <sync.h>
+#include <uint256.h>
+
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <vector>
+
+/** Whether transaction reconciliation protocol should be enabled by default. */
+static constexpr bool DEFAULT_TXRECONCILIATION_ENABLE{false};
+/** Supported version of the short id list reconciliation protocol (SENDSIDRECON) */
+static constexpr uint32_t TXRECONCILIATION_VERSION{1};
+/** How many reconciling outbound peers we still flood transactions to. */
+static constexpr size_t MAX_OUTBOUND_FLOOD_TO{2};
+/** How often an initiator asks each of its peers to reconcile. */
+static constexpr std::chrono::seconds RECON_REQUEST_INTERVAL{8};
+/** Upper bound on the reconciliation set of a single peer, transactions beyond it are flooded. */
+static constexpr size_t MAX_RECONSET_SIZE{3000};
+
+enum class ReconciliationRegisterResult {
+    NOT_FOUND,
+    SUCCESS,
+    ALREADY_REGISTERED,
+    PROTOCOL_VIOLATION,
+};
+
+/**
+ * Transaction reconciliation is a way for nodes to efficiently announce transactions.
+ * Instead of sending an INV for every transaction to every peer, transactions are collected
+ * in a per-peer reconciliation set. Periodically the initiator (the side which made the
+ * outbound connection) sends REQSIDLIST, the responder answers with SIDLIST holding the
+ * salted 32-bit short ids of its set, and the initiator then announces what the responder
+ * is missing via INV and asks for what it is missing itself via SIDLISTDIFF.
+ *
+ * Reconciliation is negotiated with SENDSIDRECON between VERSION and VERACK. Both sides
+ * contribute a random salt, the short ids are keyed with a hash of both salts so that they
+ * can't be predicted by third parties.
+ *
+ * The message flow resembles BIP330 but the wire format does not: sets are exchanged as plain
+ * short id lists instead of sketches, so the messages have their own names and version. A
+ * sketch based encoding would have to be negotiated separately.
+ *
+ * This class keeps track of the reconciliation state of every peer. It is thread-safe.
+ */
+class TxReconciliationTracker
+{
+private:
+    class Impl;
+    const std::unique_ptr<Impl> m_impl;
+
+public:
+    explicit TxReconciliationTracker(uint32_t recon_version);
+    ~TxReconciliationTracker();
+
+    /**
+     * Step 0. Generates and stores a local salt for the peer. Returns the salt to be sent
+     * in SENDSIDRECON. Called before sending VERACK.
+     */
+    uint64_t PreRegisterPeer(NodeId peer_id);
+
+    /**
+     * Step 1. Once the peer sent its SENDSIDRECON, finish the negotiation. The peer becomes
+     * registered only if it was pre-registered before.
+     */
+    ReconciliationRegisterResult RegisterPeer(NodeId peer_id, bool is_peer_inbound,
+                                              uint32_t peer_recon_version, uint64_t remote_salt);
+
+    /** Attempts to forget reconciliation-related state of the peer (if we previously stored any). */
+    void ForgetPeer(NodeId peer_id);
+
+    /** Check if a peer is registered to reconcile transactions with us. */
+    bool IsPeerRegistered(NodeId peer_id) const;
+
+    /**
+     * Whether transactions should still be flooded to this registered peer. This is the case
+     * for the first few outbound peers, to keep transaction propagation fast.
+     */
+    bool ShouldFloodTo(NodeId peer_id) const;
+
+    /**
+     * Queue a transaction to be announced to the peer during the next reconciliation.
+     * Returns false if the set is full and the transaction should be flooded instead.
+     */
+    bool AddToSet(NodeId peer_id, const uint256& txid);
+
+    /** Drop a transaction the peer doesn't need from its set, e.g. because it announced it to us. */
+    void TryRemoveFromSet(NodeId peer_id, const uint256& txid);
+
+    /**
+     * For peers we initiate reconciliation with: if it's time for the next round, returns the
+     * size of our local set to be sent in REQSIDLIST. A request which wasn't answered within
+     * RECON_REQUEST_INTERVAL is given up on and replaced by a new one.
+     */
+    std::optional<uint16_t> InitiateReconciliationRequest(NodeId peer_id, std::chrono::microseconds now);
+
+    /**
+     * For peers that initiate reconciliation with us: returns the short ids of our set to be sent
+     * in SIDLIST, or nullopt if the request is not allowed. The set is moved aside until the
+     * peer tells us what it is missing.
+     */
+    std::optional<std::vector<uint32_t>> RespondToReconciliationRequest(NodeId peer_id);
+
+    /**
+     * For peers we initiate reconciliation with: given the short ids of the remote set, fills
+     * txs_to_announce with transactions the peer is missing and short_ids_to_request with
+     * short ids we don't know. Clears the local set. Returns false if no request was pending.
+     */
+    bool HandleSketch(NodeId peer_id, const std::vector<uint32_t>& remote_short_ids,
+                      std::vector<uint256>& txs_to_announce, std::vector<uint32_t>& short_ids_to_request);
+
+    /**
+     * For peers that initiate reconciliation with us: returns the transactions the peer asked
+     * for in SIDLISTDIFF and finishes the round. Unknown short ids are ignored.
+     */
+    std::vector<uint256> HandleReconciliationDifference(NodeId peer_id, const std::vector<uint32_t>& short_ids);
+};
+
+#endif // BITCOIN_NODE_TXRECONCILIATION_H
@@ -26,16 +26,22 @@ public:
     //! initial block download for the assumeutxo chainstate.
     unsigned int m_nchaintx = 0;
 
+    //! The number of evo database entries (masternode lists, quorum commitments, credit pool
+    //! and MNHF state) following the coins, which blocks after the base are validated against.
+    uint64_t m_evodb_count = 0;
+
     SnapshotMetadata() { }
     SnapshotMetadata(
         const uint256& base_blockhash,
         uint64_t coins_count,
-        unsigned int nchaintx) :
+        unsigned int nchaintx,
+        uint64_t evodb_count) :
             m_base_blockhash(base_blockhash),
             m_coins_count(coins_count),
-            m_nchaintx(nchaintx) { }
+            m_nchaintx(nchaintx),
+            m_evodb_count(evodb_count) { }
 
-    SERIALIZE_METHODS(SnapshotMetadata, obj) { READWRITE(obj.m_base_blockhash, obj.m_coins_count, obj.m_nchaintx); }
+    SERIALIZE_METHODS(SnapshotMetadata, obj) { READWRITE(obj.m_base_blockhash, obj.m_coins_count, obj.m_nchaintx, obj.m_evodb_count); }
 };
 
 #endif // BITCOIN_NODE_UTXO_SNAPSHOT_H
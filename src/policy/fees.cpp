@@ -16,6 +16,8 @@
 static const char* FEE_ESTIMATES_FILENAME = "fee_estimates.dat";
 
 static constexpr double INF_FEERATE = 1e99;
+/** Decay weight at which the moving averages are normalized, after over 1700 blocks with the shortest half-life */
+static constexpr double MIN_DECAY_WEIGHT = 1e-30;
 
 std::string StringForFeeEstimateHorizon(FeeEstimateHorizon horizon)
 {
@@ -83,6 +85,11 @@ private:
 
     double decay;
 
+    // The moving averages above are stored divided by this weight, the product of the decays
+    // of all blocks since they were last normalized. Decaying them for a new block only has to
+    // update the weight, and a data point is added with a value of 1 / weight.
+    double m_decay_weight{1};
+
     // Resolution (# of blocks) with which confirmations are tracked
     unsigned int scale;
 
@@ -95,6 +102,9 @@ private:
 
     void resizeInMemoryCounters(size_t newbuckets);
 
+    /** Fold the decay weight into the moving averages, before it gets small enough to lose precision */
+    void NormalizeMovingAverages();
+
 public:
     /**
      * Create new TxConfirmStats. This is called by BlockPolicyEstimator's
@@ -200,24 +210,34 @@ void TxConfirmStats::Record(int blocksToConfirm, double feerate)
         return;
     int periodsToConfirm = (blocksToConfirm + scale - 1) / scale;
     unsigned int bucketindex = bucketMap.lower_bound(feerate)->second;
+    const double weight = 1 / m_decay_weight;
     for (size_t i = periodsToConfirm; i <= confAvg.size(); i++) {
-        confAvg[i - 1][bucketindex]++;
+        confAvg[i - 1][bucketindex] += weight;
     }
-    txCtAvg[bucketindex]++;
-    m_feerate_avg[bucketindex] += feerate;
+    txCtAvg[bucketindex] += weight;
+    m_feerate_avg[bucketindex] += feerate * weight;
 }
 
 void TxConfirmStats::UpdateMovingAverages()
+{
+    m_decay_weight *= decay;
+    if (m_decay_weight < MIN_DECAY_WEIGHT) {
+        NormalizeMovingAverages();
+    }
+}
+
+void TxConfirmStats::NormalizeMovingAverages()
 {
     assert(confAvg.size() == failAvg.size());
     for (unsigned int j = 0; j < buckets.size(); j++) {
         for (unsigned int i = 0; i < confAvg.size(); i++) {
-            confAvg[i][j] *= decay;
-            failAvg[i][j] *= decay;
+            confAvg[i][j] *= m_decay_weight;
+            failAvg[i][j] *= m_decay_weight;
         }
-        m_feerate_avg[j] *= decay;
-        txCtAvg[j] *= decay;
+        m_feerate_avg[j] *= m_decay_weight;
+        txCtAvg[j] *= m_decay_weight;
     }
+    m_decay_weight = 1;
 }
 
 // returns -1 on error conditions
@@ -232,6 +252,8 @@ double TxConfirmStats::EstimateMedianVal(int confTarget, double sufficientTxVal,
     double failNum = 0; // Number of tx's that were never confirmed but removed from the mempool after confTarget
     const int periodTarget = (confTarget + scale - 1) / scale;
     const int maxbucketindex = buckets.size() - 1;
+    // Scales the stored moving averages to their actual values
+    const double weight = m_decay_weight;
 
     // We'll combine buckets until we have enough samples.
     // The near and far variables will define the range we've combined
@@ -257,9 +279,9 @@ double TxConfirmStats::EstimateMedianVal(int confTarget, double sufficientTxVal,
             newBucketRange = false;
         }
         curFarBucket = bucket;
-        nConf += confAvg[periodTarget - 1][bucket];
-        totalNum += txCtAvg[bucket];
-        failNum += failAvg[periodTarget - 1][bucket];
+        nConf += confAvg[periodTarget - 1][bucket] * weight;
+        totalNum += txCtAvg[bucket] * weight;
+        failNum += failAvg[periodTarget - 1][bucket] * weight;
         for (unsigned int confct = confTarget; confct < GetMaxConfirms(); confct++)
             extraNum += unconfTxs[(nBlockHeight - confct) % bins][bucket];
         extraNum += oldUnconfTxs[bucket];
@@ -317,13 +339,13 @@ double TxConfirmStats::EstimateMedianVal(int confTarget, double sufficientTxVal,
     unsigned int minBucket = std::min(bestNearBucket, bestFarBucket);
     unsigned int maxBucket = std::max(bestNearBucket, bestFarBucket);
     for (unsigned int j = minBucket; j <= maxBucket; j++) {
-        txSum += txCtAvg[j];
+        txSum += txCtAvg[j] * weight;
     }
     if (foundAnswer && txSum != 0) {
         txSum = txSum / 2;
         for (unsigned int j = minBucket; j <= maxBucket; j++) {
-            if (txCtAvg[j] < txSum)
-                txSum -= txCtAvg[j];
+            if (txCtAvg[j] * weight < txSum)
+                txSum -= txCtAvg[j] * weight;
             else { // we're in the right bucket
                 median = m_feerate_avg[j] / txCtAvg[j];
                 break;
@@ -376,12 +398,27 @@ double TxConfirmStats::EstimateMedianVal(int confTarget, double sufficientTxVal,
 
 void TxConfirmStats::Write(CAutoFile& fileout) const
 {
+    // The file holds the actual moving averages, so that it doesn't depend on the decay weight
+    const auto weighted = [this](std::vector<double> avg) {
+        for (auto& val : avg) {
+            val *= m_decay_weight;
+        }
+        return avg;
+    };
+    std::vector<std::vector<double>> conf_avg, fail_avg;
+    conf_avg.reserve(confAvg.size());
+    fail_avg.reserve(failAvg.size());
+    for (size_t i = 0; i < confAvg.size(); i++) {
+        conf_avg.emplace_back(weighted(confAvg[i]));
+        fail_avg.emplace_back(weighted(failAvg[i]));
+    }
+
     fileout << Using<EncodedDoubleFormatter>(decay);
     fileout << scale;
-    fileout << Using<VectorFormatter<EncodedDoubleFormatter>>(m_feerate_avg);
-    fileout << Using<VectorFormatter<EncodedDoubleFormatter>>(txCtAvg);
-    fileout << Using<VectorFormatter<VectorFormatter<EncodedDoubleFormatter>>>(confAvg);
-    fileout << Using<VectorFormatter<VectorFormatter<EncodedDoubleFormatter>>>(failAvg);
+    fileout << Using<VectorFormatter<EncodedDoubleFormatter>>(weighted(m_feerate_avg));
+    fileout << Using<VectorFormatter<EncodedDoubleFormatter>>(weighted(txCtAvg));
+    fileout << Using<VectorFormatter<VectorFormatter<EncodedDoubleFormatter>>>(conf_avg);
+    fileout << Using<VectorFormatter<VectorFormatter<EncodedDoubleFormatter>>>(fail_avg);
 }
 
 void TxConfirmStats::Read(CAutoFile& filein, int nFileVersion, size_t numBuckets)
@@ -435,6 +472,7 @@ void TxConfirmStats::Read(CAutoFile& filein, int nFileVersion, size_t numBuckets
     // Resize the current block variables which aren't stored in the data file
     // to match the number of confirms and buckets
     resizeInMemoryCounters(numBuckets);
+    m_decay_weight = 1;
 
     LogPrint(BCLog::ESTIMATEFEE, "Reading estimates: %u buckets counting confirms up to %u blocks\n",
              numBuckets, maxConfirms);
@@ -479,8 +517,9 @@ void TxConfirmStats::removeTx(unsigned int entryHeight, unsigned int nBestSeenHe
     if (!inBlock && (unsigned int)blocksAgo >= scale) { // Only counts as a failure if not confirmed for entire period
         assert(scale != 0);
         unsigned int periodsAgo = blocksAgo / scale;
+        const double weight = 1 / m_decay_weight;
         for (size_t i = 0; i < periodsAgo && i < failAvg.size(); i++) {
-            failAvg[i][bucketindex]++;
+            failAvg[i][bucketindex] += weight;
         }
     }
 }
@@ -499,12 +538,14 @@ bool CBlockPolicyEstimator::removeTx(uint256 hash, bool inBlock)
 bool CBlockPolicyEstimator::_removeTx(const uint256& hash, bool inBlock)
 {
     AssertLockHeld(m_cs_fee_estimator);
-    std::map<uint256, TxStatsInfo>::iterator pos = mapMemPoolTxs.find(hash);
+    auto pos = mapMemPoolTxs.find(hash);
     if (pos != mapMemPoolTxs.end()) {
         feeStats->removeTx(pos->second.blockHeight, nBestSeenHeight, pos->second.bucketIndex, inBlock);
         shortStats->removeTx(pos->second.blockHeight, nBestSeenHeight, pos->second.bucketIndex, inBlock);
         longStats->removeTx(pos->second.blockHeight, nBestSeenHeight, pos->second.bucketIndex, inBlock);
-        mapMemPoolTxs.erase(hash);
+        mapMemPoolTxs.erase(pos);
+        // Removing a tracked tx changes the unconfirmed and failed counts the estimates are based on
+        m_smart_fee_cache.clear();
         return true;
     } else {
         return false;
@@ -624,6 +665,7 @@ void CBlockPolicyEstimator::processBlock(unsigned int nBlockHeight,
     // calls to removeTx (via processBlockTx) correctly calculate age
     // of unconfirmed txs to remove from tracking.
     nBestSeenHeight = nBlockHeight;
+    m_smart_fee_cache.clear();
 
     // Update unconfirmed circular buffer
     feeStats->ClearCurrent(nBlockHeight);
@@ -813,6 +855,23 @@ CFeeRate CBlockPolicyEstimator::estimateSmartFee(int confTarget, FeeCalculation
 {
     LOCK(m_cs_fee_estimator);
 
+    // New mempool txs don't affect the estimates (they are only counted once they are unconfirmed
+    // for at least one block), so the results stay valid until a block or a tracked tx removal
+    const auto key = std::make_pair(confTarget, conservative);
+    auto it = m_smart_fee_cache.find(key);
+    if (it == m_smart_fee_cache.end()) {
+        FeeCalculation calc;
+        const CFeeRate fee_rate = _estimateSmartFee(confTarget, &calc, conservative);
+        it = m_smart_fee_cache.emplace(key, std::make_pair(fee_rate, calc)).first;
+    }
+    if (feeCalc) *feeCalc = it->second.second;
+    return it->second.first;
+}
+
+CFeeRate CBlockPolicyEstimator::_estimateSmartFee(int confTarget, FeeCalculation *feeCalc, bool conservative) const
+{
+    AssertLockHeld(m_cs_fee_estimator);
+
     if (feeCalc) {
         feeCalc->desiredTarget = confTarget;
         feeCalc->returnedTarget = confTarget;
@@ -975,6 +1034,7 @@ bool CBlockPolicyEstimator::Read(CAutoFile& filein)
             nBestSeenHeight = nFileBestSeenHeight;
             historicalFirst = nFileHistoricalFirst;
             historicalBest = nFileHistoricalBest;
+            m_smart_fee_cache.clear();
         }
     }
     catch (const std::exception& e) {
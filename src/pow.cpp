@@ -7,11 +7,21 @@
 
 #include <arith_uint256.h>
 #include <chain.h>
+#include <hash.h>
 #include <primitives/block.h>
+#include <saltedhasher.h>
+#include <sync.h>
 #include <uint256.h>
+#include <unordered_lru_cache.h>
 
 #include <math.h>
 
+/** Number of headers whose proof-of-work hash is memoized by GetPoWHashCached */
+static constexpr size_t POW_HASH_CACHE_SIZE = 4096;
+
+static Mutex cs_pow_hash_cache;
+static unordered_lru_cache<uint256, uint256, StaticSaltedHasher, POW_HASH_CACHE_SIZE> pow_hash_cache GUARDED_BY(cs_pow_hash_cache);
+
 unsigned int static DarkGravityWave(const CBlockIndex* pindexLast, const Consensus::Params& params) {
     /* current difficulty formula, dash - DarkGravity v3, written by Evan Duffield - evan@dash.org */
     const arith_uint256 bnPowLimit = UintToArith256(params.powLimit);
@@ -181,3 +191,20 @@ bool CheckProofOfWork(uint256 hash, unsigned int nBits, const Consensus::Params&
 
     return true;
 }
+
+uint256 GetPoWHashCached(const CPureBlockHeader& header)
+{
+    unsigned char vch[CPureBlockHeader::POW_HEADER_SIZE];
+    header.SerializePoWHeader(vch);
+
+    uint256 key;
+    CHash256().Write(vch).Finalize(key);
+
+    uint256 hash;
+    if (WITH_LOCK(cs_pow_hash_cache, return pow_hash_cache.get(key, hash))) {
+        return hash;
+    }
+    hash = HashX11(vch, vch + sizeof(vch));
+    WITH_LOCK(cs_pow_hash_cache, pow_hash_cache.insert(key, hash));
+    return hash;
+}
@@ -12,6 +12,7 @@
 
 class CBlockHeader;
 class CBlockIndex;
+class CPureBlockHeader;
 class uint256;
 
 unsigned int GetNextWorkRequired(const CBlockIndex* pindexLast, const CBlockHeader *pblock, const Consensus::Params&);
@@ -21,4 +22,12 @@ unsigned int CalculateNextWorkRequired(const CBlockIndex* pindexLast, int64_t nF
 /** Check whether a block hash satisfies the proof-of-work requirement specified by nBits */
 bool CheckProofOfWork(uint256 hash, unsigned int nBits, const Consensus::Params&);
 
+/**
+ * Return the X11 proof-of-work hash of a header, memoized in a small salted
+ * LRU keyed by the (much cheaper) SHA256d of the header. Used on paths that
+ * re-hash the same headers, e.g. re-reading blocks from disk or re-checking
+ * auxpow parent headers. The miner should keep calling GetPoWHash() directly.
+ */
+uint256 GetPoWHashCached(const CPureBlockHeader& header);
+
 #endif // BITCOIN_POW_H
@@ -196,6 +196,7 @@ public:
 
     // memory only
     mutable bool fChecked;
+    mutable bool fPreChecked;
 
     CBlock()
     {
@@ -219,6 +220,7 @@ public:
         CBlockHeader::SetNull();
         vtx.clear();
         fChecked = false;
+        fPreChecked = false;
         txoutDevfee = CTxOut();
     }
 
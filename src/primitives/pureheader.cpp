@@ -6,8 +6,12 @@
 #include "primitives/pureheader.h"
 
 #include "chainparams.h"
+#include "crypto/common.h"
+#include "crypto/x11.h"
 #include "hash.h"
 
+#include <string.h>
+
 void CPureBlockHeader::SetBaseVersion(int32_t nBaseVersion, int32_t nChainId)
 {
     assert(nBaseVersion >= 1 && nBaseVersion < VERSION_AUXPOW);
@@ -22,8 +26,30 @@ uint256 CPureBlockHeader::GetHash() const
 
 uint256 CPureBlockHeader::GetPoWHash() const
 {
-    std::vector<unsigned char> vch(80);
-    CVectorWriter ss(SER_GETHASH, PROTOCOL_VERSION, vch, 0);
-    ss << *this;
-    return HashX11((const char *)vch.data(), (const char *)vch.data() + vch.size());
+    unsigned char header[POW_HEADER_SIZE];
+    SerializePoWHeader(header);
+    return HashX11(header, header + POW_HEADER_SIZE);
+}
+
+void CPureBlockHeader::SerializePoWHeader(unsigned char* out) const
+{
+    WriteLE32(out, nVersion);
+    memcpy(out + 4, hashPrevBlock.begin(), 32);
+    memcpy(out + 36, hashMerkleRoot.begin(), 32);
+    WriteLE32(out + 68, nTime);
+    WriteLE32(out + 72, nBits);
+    WriteLE32(out + 76, nNonce);
+}
+
+std::vector<uint256> CPureBlockHeader::HashPoWHeaders(const std::vector<unsigned char>& vch)
+{
+    const size_t count = vch.size() / POW_HEADER_SIZE;
+    std::vector<unsigned char> out(count * 32);
+    X11Hash80(out.data(), vch.data(), count);
+
+    std::vector<uint256> ret(count);
+    for (size_t i = 0; i < count; ++i) {
+        memcpy(ret[i].begin(), out.data() + 32 * i, 32);
+    }
+    return ret;
 }
\ No newline at end of file
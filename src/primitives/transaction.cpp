@@ -92,10 +92,70 @@ uint256 CTransaction::ComputeHash() const
     return SerializeHash(*this);
 }
 
+unsigned int CTransaction::ComputeTotalSize() const
+{
+    CSizeComputer s(PROTOCOL_VERSION);
+    Serialize<CSizeComputer>(s);
+    return s.size();
+}
+
 /* For backward compatibility, the hash is initialized to 0. TODO: remove the need for this default constructor entirely. */
-CTransaction::CTransaction() : vin(), vout(), nVersion(CTransaction::CURRENT_VERSION), nType(TRANSACTION_NORMAL), nLockTime(0), hash{} {}
-CTransaction::CTransaction(const CMutableTransaction& tx) : vin(tx.vin), vout(tx.vout), nVersion(tx.nVersion), nType(tx.nType), nLockTime(tx.nLockTime), vExtraPayload(tx.vExtraPayload), hash{ComputeHash()} {}
-CTransaction::CTransaction(CMutableTransaction&& tx) : vin(std::move(tx.vin)), vout(std::move(tx.vout)), nVersion(tx.nVersion), nType(tx.nType), nLockTime(tx.nLockTime), vExtraPayload(tx.vExtraPayload), hash{ComputeHash()} {}
+CTransaction::CTransaction() : vin(), vout(), nVersion(CTransaction::CURRENT_VERSION), nType(TRANSACTION_NORMAL), nLockTime(0), hash{}, m_total_size{ComputeTotalSize()} {}
+CTransaction::CTransaction(const CMutableTransaction& tx) : vin(tx.vin), vout(tx.vout), nVersion(tx.nVersion), nType(tx.nType), nLockTime(tx.nLockTime), vExtraPayload(tx.vExtraPayload), hash{ComputeHash()}, m_total_size{ComputeTotalSize()} {}
+CTransaction::CTransaction(CMutableTransaction&& tx) : vin(std::move(tx.vin)), vout(std::move(tx.vout)), nVersion(tx.nVersion), nType(tx.nType), nLockTime(tx.nLockTime), vExtraPayload(std::move(tx.vExtraPayload)), hash{ComputeHash()}, m_total_size{ComputeTotalSize()} {}
+CTransaction::CTransaction(const CTransaction& tx) : vin(tx.vin), vout(tx.vout), nVersion(tx.nVersion), nType(tx.nType), nLockTime(tx.nLockTime), vExtraPayload(tx.vExtraPayload), hash{tx.hash}, m_total_size{tx.m_total_size} {}
+
+CTransaction::~CTransaction()
+{
+    delete m_cached_payload.load(std::memory_order_acquire);
+    delete m_script_elements.load(std::memory_order_acquire);
+}
+
+const CachedTxPayload* CTransaction::SetCachedPayload(std::unique_ptr<const CachedTxPayload> payload) const
+{
+    const CachedTxPayload* expected{nullptr};
+    if (m_cached_payload.compare_exchange_strong(expected, payload.get(), std::memory_order_acq_rel)) {
+        return payload.release();
+    }
+    return expected;
+}
+
+const TxScriptElements& CTransaction::GetScriptElements() const
+{
+    const TxScriptElements* elements = m_script_elements.load(std::memory_order_acquire);
+    if (elements != nullptr) return *elements;
+
+    auto extracted = std::make_unique<const TxScriptElements>(*this);
+    const TxScriptElements* expected{nullptr};
+    if (m_script_elements.compare_exchange_strong(expected, extracted.get(), std::memory_order_acq_rel)) {
+        return *extracted.release();
+    }
+    // Another thread was faster
+    return *expected;
+}
+
+TxScriptElements::TxScriptElements(const CTransaction& tx) : outputs(tx.vout.size())
+{
+    script_ends.reserve(tx.vout.size() + tx.vin.size());
+    auto extract = [this](const CScript& script) {
+        CScript::const_iterator pc = script.begin();
+        std::vector<unsigned char> element;
+        while (pc < script.end()) {
+            opcodetype opcode;
+            if (!script.GetOp(pc, opcode, element)) break;
+            if (element.empty()) continue;
+            data.insert(data.end(), element.begin(), element.end());
+            element_ends.push_back(data.size());
+        }
+        script_ends.push_back(element_ends.size());
+    };
+    for (const CTxOut& txout : tx.vout) {
+        extract(txout.scriptPubKey);
+    }
+    for (const CTxIn& txin : tx.vin) {
+        extract(txin.scriptSig);
+    }
+}
 
 CAmount CTransaction::GetValueOut() const
 {
@@ -109,11 +169,6 @@ CAmount CTransaction::GetValueOut() const
     return nValueOut;
 }
 
-unsigned int CTransaction::GetTotalSize() const
-{
-    return ::GetSerializeSize(*this, PROTOCOL_VERSION);
-}
-
 std::string CTransaction::ToString() const
 {
     std::string str;
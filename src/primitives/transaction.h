@@ -10,6 +10,9 @@
 #include <script/script.h>
 #include <serialize.h>
 #include <uint256.h>
+
+#include <atomic>
+#include <memory>
 #include <tuple>
 
 /** Transaction types */
@@ -175,6 +178,48 @@ public:
 };
 
 struct CMutableTransaction;
+class CTransaction;
+
+/**
+ * Memory only. The data elements pushed by the scripts of a transaction, which bloom filters are
+ * matched against. Extracted once per transaction, see CTransaction::GetScriptElements().
+ */
+struct TxScriptElements
+{
+    /** The data of all elements, back to back */
+    std::vector<unsigned char> data;
+    /** The end offset in data of every element */
+    std::vector<uint32_t> element_ends;
+    /** The end index in element_ends of the elements of every scriptPubKey, followed by every scriptSig */
+    std::vector<uint32_t> script_ends;
+    /** The number of outputs, i.e. where the scriptSigs start in script_ends */
+    size_t outputs;
+
+    explicit TxScriptElements(const CTransaction& tx);
+
+    /** Element i, in the order of the scripts */
+    Span<const unsigned char> Element(size_t i) const
+    {
+        const size_t begin = i == 0 ? 0 : element_ends[i - 1];
+        return Span<const unsigned char>(data.data() + begin, element_ends[i] - begin);
+    }
+    /** The range of element indexes of the scriptPubKey of output n */
+    std::pair<size_t, size_t> OutputElements(size_t n) const { return ScriptElements(n); }
+    /** The range of element indexes of the scriptSig of input n */
+    std::pair<size_t, size_t> InputElements(size_t n) const { return ScriptElements(outputs + n); }
+
+private:
+    std::pair<size_t, size_t> ScriptElements(size_t script) const
+    {
+        return {script == 0 ? 0 : script_ends[script - 1], script_ends[script]};
+    }
+};
+
+/** Memory only. Base of the special transaction payload a CTransaction caches once it was parsed, see GetTxPayload() */
+struct CachedTxPayload
+{
+    virtual ~CachedTxPayload() = default;
+};
 
 /** The basic transaction that is broadcasted on the network and contained in
  * blocks.  A transaction can contain multiple inputs and outputs.
@@ -206,8 +251,14 @@ public:
 private:
     /** Memory only. */
     const uint256 hash;
+    const unsigned int m_total_size;
+    /** Memory only. Payload parsed from vExtraPayload on first use, owned by the transaction. */
+    mutable std::atomic<const CachedTxPayload*> m_cached_payload{nullptr};
+    /** Memory only. Script data elements extracted on first use, owned by the transaction. */
+    mutable std::atomic<const TxScriptElements*> m_script_elements{nullptr};
 
     uint256 ComputeHash() const;
+    unsigned int ComputeTotalSize() const;
 
 public:
     /** Construct a CTransaction that qualifies as IsNull() */
@@ -217,6 +268,10 @@ public:
     explicit CTransaction(const CMutableTransaction &tx);
     CTransaction(CMutableTransaction &&tx);
 
+    /** The copy starts without a cached payload and script elements. */
+    CTransaction(const CTransaction& tx);
+    ~CTransaction();
+
     template <typename Stream>
     inline void Serialize(Stream& s) const {
         int32_t n32bitVersion = this->nVersion | (this->nType << 16);
@@ -228,6 +283,12 @@ public:
             s << vExtraPayload;
     }
 
+    /** The size doesn't depend on the stream, use the one computed on construction. */
+    void Serialize(CSizeComputer& s) const
+    {
+        s.seek(m_total_size);
+    }
+
     /** This deserializing constructor is provided instead of an Unserialize method.
      *  Unserialize is not possible, since it would require overwriting const fields. */
     template <typename Stream>
@@ -247,7 +308,18 @@ public:
      * "Total Size" defined in BIP141 and BIP144.
      * @return Total transaction size in bytes
      */
-    unsigned int GetTotalSize() const;
+    unsigned int GetTotalSize() const { return m_total_size; }
+
+    /** The cached payload, nullptr if not parsed yet */
+    const CachedTxPayload* GetCachedPayload() const { return m_cached_payload.load(std::memory_order_acquire); }
+    /**
+     * Cache a parsed payload, unless another thread was faster. Returns the payload which is
+     * cached in the end, either this one or the other thread's.
+     */
+    const CachedTxPayload* SetCachedPayload(std::unique_ptr<const CachedTxPayload> payload) const;
+
+    /** The data elements pushed by the scripts, extracted on first use */
+    const TxScriptElements& GetScriptElements() const;
 
     bool IsCoinBase() const
     {
@@ -7,7 +7,9 @@
 
 #include <util/system.h>
 
+#include <array>
 #include <atomic>
+#include <map>
 
 static std::atomic<bool> g_initial_block_download_completed(false);
 
@@ -64,6 +66,7 @@ MAKE_MSG(SYNCSTATUSCOUNT, "ssc");
 MAKE_MSG(MNGOVERNANCESYNC, "govsync");
 MAKE_MSG(MNGOVERNANCEOBJECT, "govobj");
 MAKE_MSG(MNGOVERNANCEOBJECTVOTE, "govobjvote");
+MAKE_MSG(MNGOVERNANCEOBJECTVOTES, "govobjvotes");
 MAKE_MSG(GETMNLISTDIFF, "getmnlistd");
 MAKE_MSG(MNLISTDIFF, "mnlistdiff");
 MAKE_MSG(QSENDRECSIGS, "qsendrecsigs");
@@ -79,10 +82,23 @@ MAKE_MSG(QGETSIGSHARES, "qgetsigs");
 MAKE_MSG(QBSIGSHARES, "qbsigs");
 MAKE_MSG(QSIGREC, "qsigrec");
 MAKE_MSG(QSIGSHARE, "qsigshare");
+MAKE_MSG(QSIGSHARESBUNDLE, "qsigsbundle");
 MAKE_MSG(QGETDATA, "qgetdata");
 MAKE_MSG(QDATA, "qdata");
 MAKE_MSG(CLSIG, "clsig");
 MAKE_MSG(ISDLOCK, "isdlock");
+MAKE_MSG(SENDCMPCTLOCKS, "sendcmpctlks");
+MAKE_MSG(CMPCTISDLOCK, "cmpctisdlock");
+MAKE_MSG(CMPCTCLSIG, "cmpctclsig");
+MAKE_MSG(SENDSIDRECON, "sendsidrecon");
+MAKE_MSG(REQSIDLIST, "reqsidlist");
+MAKE_MSG(SIDLIST, "sidlist");
+MAKE_MSG(SIDLISTDIFF, "sidlistdiff");
+MAKE_MSG(SENDPACKAGES, "sendpackages");
+MAKE_MSG(GETPKGINFO, "getpkginfo");
+MAKE_MSG(ANCPKGINFO, "ancpkginfo");
+MAKE_MSG(GETPKGTXNS, "getpkgtxns");
+MAKE_MSG(PKGTXNS, "pkgtxns");
 MAKE_MSG(MNAUTH, "mnauth");
 MAKE_MSG(GETHEADERS2, "getheaders2");
 MAKE_MSG(SENDHEADERS2, "sendheaders2");
@@ -144,6 +160,7 @@ const static std::string allNetMessageTypes[] = {
     NetMsgType::MNGOVERNANCESYNC,
     NetMsgType::MNGOVERNANCEOBJECT,
     NetMsgType::MNGOVERNANCEOBJECTVOTE,
+    NetMsgType::MNGOVERNANCEOBJECTVOTES,
     NetMsgType::GETMNLISTDIFF,
     NetMsgType::MNLISTDIFF,
     NetMsgType::QSENDRECSIGS,
@@ -159,10 +176,23 @@ const static std::string allNetMessageTypes[] = {
     NetMsgType::QBSIGSHARES,
     NetMsgType::QSIGREC,
     NetMsgType::QSIGSHARE,
+    NetMsgType::QSIGSHARESBUNDLE,
     NetMsgType::QGETDATA,
     NetMsgType::QDATA,
     NetMsgType::CLSIG,
     NetMsgType::ISDLOCK,
+    NetMsgType::SENDCMPCTLOCKS,
+    NetMsgType::CMPCTISDLOCK,
+    NetMsgType::CMPCTCLSIG,
+    NetMsgType::SENDSIDRECON,
+    NetMsgType::REQSIDLIST,
+    NetMsgType::SIDLIST,
+    NetMsgType::SIDLISTDIFF,
+    NetMsgType::SENDPACKAGES,
+    NetMsgType::GETPKGINFO,
+    NetMsgType::ANCPKGINFO,
+    NetMsgType::GETPKGTXNS,
+    NetMsgType::PKGTXNS,
     NetMsgType::MNAUTH,
     NetMsgType::GETHEADERS2,
     NetMsgType::SENDHEADERS2,
@@ -176,6 +206,8 @@ const static std::vector<std::string> allNetMessageTypesVec(std::begin(allNetMes
  *  NOTE: Unlike the list above, this list is sorted alphabetically.
  */
 const static std::string netMessageTypesViolateBlocksOnly[] = {
+    NetMsgType::ANCPKGINFO,
+    NetMsgType::CMPCTISDLOCK,
     NetMsgType::DSACCEPT,
     NetMsgType::DSCOMPLETE,
     NetMsgType::DSFINALTX,
@@ -184,6 +216,9 @@ const static std::string netMessageTypesViolateBlocksOnly[] = {
     NetMsgType::DSSTATUSUPDATE,
     NetMsgType::DSTX,
     NetMsgType::DSVIN,
+    NetMsgType::GETPKGINFO,
+    NetMsgType::GETPKGTXNS,
+    NetMsgType::PKGTXNS,
     NetMsgType::QBSIGSHARES,
     NetMsgType::QCOMPLAINT,
     NetMsgType::QCONTRIB,
@@ -196,12 +231,86 @@ const static std::string netMessageTypesViolateBlocksOnly[] = {
     NetMsgType::QSIGREC,
     NetMsgType::QSIGSESANN,
     NetMsgType::QSIGSHARE,
+    NetMsgType::QSIGSHARESBUNDLE,
     NetMsgType::QSIGSHARESINV,
     NetMsgType::QWATCH,
+    NetMsgType::REQSIDLIST,
+    NetMsgType::SIDLIST,
+    NetMsgType::SIDLISTDIFF,
     NetMsgType::TX,
 };
 const static std::set<std::string> netMessageTypesViolateBlocksOnlySet(std::begin(netMessageTypesViolateBlocksOnly), std::end(netMessageTypesViolateBlocksOnly));
 
+/** One-byte message type ids of the BIP324 v2 transport. Ids 1 to 28 are the ones assigned by BIP324, id 5
+ *  (feefilter) is not used on this network. The frequent Maximus messages (LLMQ signing, InstantSend, ChainLocks,
+ *  CoinJoin queues and governance votes) get ids from V2_MAXIMUS_SHORT_ID_START on, so that they don't have to
+ *  carry the 12-byte message type. Ids must never be reassigned, only appended.
+ */
+const static std::pair<uint8_t, const char*> v2ShortMessageIds[] = {
+    {1, NetMsgType::ADDR},
+    {2, NetMsgType::BLOCK},
+    {3, NetMsgType::BLOCKTXN},
+    {4, NetMsgType::CMPCTBLOCK},
+    {6, NetMsgType::FILTERADD},
+    {7, NetMsgType::FILTERCLEAR},
+    {8, NetMsgType::FILTERLOAD},
+    {9, NetMsgType::GETBLOCKS},
+    {10, NetMsgType::GETBLOCKTXN},
+    {11, NetMsgType::GETDATA},
+    {12, NetMsgType::GETHEADERS},
+    {13, NetMsgType::HEADERS},
+    {14, NetMsgType::INV},
+    {15, NetMsgType::MEMPOOL},
+    {16, NetMsgType::MERKLEBLOCK},
+    {17, NetMsgType::NOTFOUND},
+    {18, NetMsgType::PING},
+    {19, NetMsgType::PONG},
+    {20, NetMsgType::SENDCMPCT},
+    {21, NetMsgType::TX},
+    {22, NetMsgType::GETCFILTERS},
+    {23, NetMsgType::CFILTER},
+    {24, NetMsgType::GETCFHEADERS},
+    {25, NetMsgType::CFHEADERS},
+    {26, NetMsgType::GETCFCHECKPT},
+    {27, NetMsgType::CFCHECKPT},
+    {28, NetMsgType::ADDRV2},
+    // Maximus message types
+    {V2_MAXIMUS_SHORT_ID_START + 0, NetMsgType::QSIGSHARE},
+    {V2_MAXIMUS_SHORT_ID_START + 1, NetMsgType::QBSIGSHARES},
+    {V2_MAXIMUS_SHORT_ID_START + 2, NetMsgType::QSIGSHARESINV},
+    {V2_MAXIMUS_SHORT_ID_START + 3, NetMsgType::QGETSIGSHARES},
+    {V2_MAXIMUS_SHORT_ID_START + 4, NetMsgType::QSIGSESANN},
+    {V2_MAXIMUS_SHORT_ID_START + 5, NetMsgType::QSIGREC},
+    {V2_MAXIMUS_SHORT_ID_START + 6, NetMsgType::ISDLOCK},
+    {V2_MAXIMUS_SHORT_ID_START + 7, NetMsgType::CLSIG},
+    {V2_MAXIMUS_SHORT_ID_START + 8, NetMsgType::DSQUEUE},
+    {V2_MAXIMUS_SHORT_ID_START + 9, NetMsgType::MNGOVERNANCEOBJECTVOTE},
+    {V2_MAXIMUS_SHORT_ID_START + 10, NetMsgType::CMPCTISDLOCK},
+    {V2_MAXIMUS_SHORT_ID_START + 11, NetMsgType::CMPCTCLSIG},
+    {V2_MAXIMUS_SHORT_ID_START + 12, NetMsgType::DSTX},
+    {V2_MAXIMUS_SHORT_ID_START + 13, NetMsgType::HEADERS2},
+    {V2_MAXIMUS_SHORT_ID_START + 14, NetMsgType::GETHEADERS2},
+    {V2_MAXIMUS_SHORT_ID_START + 15, NetMsgType::MNAUTH},
+    {V2_MAXIMUS_SHORT_ID_START + 16, NetMsgType::QSENDRECSIGS},
+    {V2_MAXIMUS_SHORT_ID_START + 17, NetMsgType::QSIGSHARESBUNDLE},
+};
+
+static const std::array<std::string, 256> v2MessageTypesById = [] {
+    std::array<std::string, 256> ret;
+    for (const auto& [id, msg_type] : v2ShortMessageIds) {
+        ret[id] = msg_type;
+    }
+    return ret;
+}();
+
+static const std::map<std::string, uint8_t> v2ShortMessageIdsByType = [] {
+    std::map<std::string, uint8_t> ret;
+    for (const auto& [id, msg_type] : v2ShortMessageIds) {
+        ret.emplace(msg_type, id);
+    }
+    return ret;
+}();
+
 CMessageHeader::CMessageHeader()
 {
     memset(pchMessageStart, 0, MESSAGE_START_SIZE);
@@ -331,6 +440,20 @@ bool NetMessageViolatesBlocksOnly(const std::string& msg_type)
     return netMessageTypesViolateBlocksOnlySet.find(msg_type) != netMessageTypesViolateBlocksOnlySet.end();
 }
 
+std::optional<uint8_t> GetV2ShortMessageId(const std::string& msg_type)
+{
+    const auto it = v2ShortMessageIdsByType.find(msg_type);
+    if (it == v2ShortMessageIdsByType.end()) return std::nullopt;
+    return it->second;
+}
+
+std::optional<std::string> GetV2MessageType(uint8_t short_id)
+{
+    const std::string& msg_type = v2MessageTypesById[short_id];
+    if (msg_type.empty()) return std::nullopt;
+    return msg_type;
+}
+
 /**
  * Convert a service flag (NODE_*) to a human readable string.
  * It supports unknown service flags which will be returned as "UNKNOWN[...]".
@@ -18,6 +18,7 @@
 #include <version.h>
 
 #include <limits>
+#include <optional>
 #include <stdint.h>
 #include <string>
 
@@ -270,6 +271,7 @@ extern const char* SYNCSTATUSCOUNT;
 extern const char* MNGOVERNANCESYNC;
 extern const char* MNGOVERNANCEOBJECT;
 extern const char* MNGOVERNANCEOBJECTVOTE;
+extern const char* MNGOVERNANCEOBJECTVOTES;
 extern const char* GETMNLISTDIFF;
 extern const char* MNLISTDIFF;
 extern const char* QSENDRECSIGS;
@@ -285,10 +287,52 @@ extern const char* QGETSIGSHARES;
 extern const char* QBSIGSHARES;
 extern const char* QSIGREC;
 extern const char* QSIGSHARE;
+extern const char* QSIGSHARESBUNDLE;
 extern const char* QGETDATA;
 extern const char* QDATA;
 extern const char* CLSIG;
 extern const char* ISDLOCK;
+extern const char* SENDCMPCTLOCKS;
+extern const char* CMPCTISDLOCK;
+extern const char* CMPCTCLSIG;
+/**
+ * Contains a 4-byte reconciliation protocol version and an 8-byte salt.
+ * Indicates that a node is willing to reconcile transactions instead of flooding them.
+ * Must be sent between VERSION and VERACK.
+ * The short id list reconciliation messages are not BIP330: sets are exchanged as plain
+ * lists of salted 32-bit short ids rather than as sketches.
+ */
+extern const char* SENDSIDRECON;
+/** Contains the 2-byte size of the initiator's set, asks the peer for its short id list. */
+extern const char* REQSIDLIST;
+/** Contains the salted 32-bit short ids of the responder's reconciliation set. */
+extern const char* SIDLIST;
+/** Contains the short ids from a SIDLIST the initiator is missing, answered with INVs. */
+extern const char* SIDLISTDIFF;
+/**
+ * Contains a 4-byte package relay protocol version.
+ * Indicates that a node is willing to relay ancestor packages of transactions.
+ * Must be sent between VERSION and VERACK.
+ */
+extern const char* SENDPACKAGES;
+/**
+ * Contains the txid of a transaction. The peer should respond with an
+ * "ancpkginfo" message if the transaction is in its mempool.
+ */
+extern const char* GETPKGINFO;
+/**
+ * Contains the txids of the unconfirmed ancestors of a transaction followed by
+ * the txid of the transaction itself, parents before children.
+ */
+extern const char* ANCPKGINFO;
+/**
+ * Contains a list of txids. The peer should respond with a "pkgtxns" message.
+ */
+extern const char* GETPKGTXNS;
+/**
+ * Contains a list of transactions, sent in response to a "getpkgtxns" message.
+ */
+extern const char* PKGTXNS;
 extern const char* MNAUTH;
 extern const char* GETHEADERS2;
 extern const char* SENDHEADERS2;
@@ -303,6 +347,18 @@ const std::vector<std::string>& getAllNetMessageTypes();
 /* Whether the message type violates blocks-relay-only policy */
 bool NetMessageViolatesBlocksOnly(const std::string& msg_type);
 
+/** First of the short BIP324 message type ids assigned to Maximus specific messages */
+static constexpr uint8_t V2_MAXIMUS_SHORT_ID_START{128};
+
+/**
+ * Get the one-byte BIP324 message type id of a message type. Messages without one are sent with the
+ * 0 byte followed by the 12-byte message type.
+ */
+std::optional<uint8_t> GetV2ShortMessageId(const std::string& msg_type);
+
+/* Get the message type of a one-byte BIP324 message type id, if the id is assigned */
+std::optional<std::string> GetV2MessageType(uint8_t short_id);
+
 /** nServices flags */
 enum ServiceFlags : uint64_t {
     // NOTE: When adding here, be sure to update serviceFlagToStr too
@@ -16,28 +16,278 @@
 #include <univalue.h>
 
 #include <QMessageBox>
-#include <QTableWidgetItem>
+#include <QThread>
 #include <QtGui/QClipboard>
 
-template <typename T>
-class CMasternodeListWidgetItem : public QTableWidgetItem
+#include <algorithm>
+
+///
+/// Masternode Model
+///
+
+MasternodeModel::Entry MasternodeModel::makeEntry(const CDeterministicMNCPtr& dmn) const
+{
+    Entry entry;
+    entry.dmn = dmn;
+
+    entry.service = QString::fromStdString(dmn->pdmnState->addr.ToString());
+    auto addr_key = dmn->pdmnState->addr.GetKey();
+    entry.serviceKey = QString::fromLatin1(QByteArray(reinterpret_cast<const char*>(addr_key.data()), addr_key.size()).toHex());
+
+    CTxDestination payeeDest;
+    entry.payout = tr("UNKNOWN");
+    if (ExtractDestination(dmn->pdmnState->scriptPayout, payeeDest)) {
+        entry.payout = QString::fromStdString(EncodeDestination(payeeDest));
+    }
+
+    entry.operatorReward = tr("NONE");
+    if (dmn->nOperatorReward) {
+        entry.operatorReward = QString::number(dmn->nOperatorReward / 100.0, 'f', 2) + "% ";
+
+        if (dmn->pdmnState->scriptOperatorPayout != CScript()) {
+            CTxDestination operatorDest;
+            if (ExtractDestination(dmn->pdmnState->scriptOperatorPayout, operatorDest)) {
+                entry.operatorReward += tr("to %1").arg(QString::fromStdString(EncodeDestination(operatorDest)));
+            } else {
+                entry.operatorReward += tr("to UNKNOWN");
+            }
+        } else {
+            entry.operatorReward += tr("but not claimed");
+        }
+    }
+
+    entry.owner = QString::fromStdString(EncodeDestination(PKHash(dmn->pdmnState->keyIDOwner)));
+    entry.voting = QString::fromStdString(EncodeDestination(PKHash(dmn->pdmnState->keyIDVoting)));
+    entry.proTxHash = QString::fromStdString(dmn->proTxHash.ToString());
+    return entry;
+}
+
+int MasternodeModel::rowCount(const QModelIndex& index) const
 {
-    T itemData;
+    return m_data.size();
+}
 
-public:
-    explicit CMasternodeListWidgetItem(const QString& text, const T& data, int type = Type) :
-        QTableWidgetItem(text, type),
-        itemData(data) {}
+int MasternodeModel::columnCount(const QModelIndex& index) const
+{
+    return Column::_COUNT;
+}
 
-    bool operator<(const QTableWidgetItem& other) const override
+QVariant MasternodeModel::data(const QModelIndex& index, int role) const
+{
+    if (role != Qt::DisplayRole && role != Qt::EditRole) return {};
+    const auto& entry = m_data[index.row()];
+    const auto& dmn = *entry.dmn;
+
+    switch (index.column()) {
+    case Column::SERVICE:
+        // Edit role is used for sorting, so return the raw values where possible
+        return role == Qt::EditRole ? entry.serviceKey : entry.service;
+    // Disable EvoNodes
+    // case Column::TYPE:
+    //     return QString::fromStdString(std::string(GetMnType(dmn.nType).description));
+    case Column::STATUS:
+        return dmn.pdmnState->IsBanned() ? tr("POSE_BANNED") : tr("ENABLED");
+    case Column::POSE:
+        return dmn.pdmnState->nPoSePenalty;
+    case Column::REGISTERED:
+        return dmn.pdmnState->nRegisteredHeight;
+    case Column::LAST_PAYMENT:
+        return dmn.pdmnState->nLastPaidHeight;
+    case Column::NEXT_PAYMENT:
+    {
+        auto it = m_next_payments.find(dmn.proTxHash);
+        if (it == m_next_payments.end()) {
+            return role == Qt::EditRole ? QVariant(0) : QVariant(QString("UNKNOWN"));
+        }
+        return it->second;
+    }
+    case Column::PAYOUT_ADDRESS:
+        return entry.payout;
+    case Column::OPERATOR_REWARD:
+        return role == Qt::EditRole ? QVariant(int{dmn.nOperatorReward}) : QVariant(entry.operatorReward);
+    case Column::COLLATERAL_ADDRESS:
     {
-        return itemData < ((CMasternodeListWidgetItem*)&other)->itemData;
+        auto it = m_collateral_addresses.find(dmn.collateralOutpoint);
+        return it != m_collateral_addresses.end() ? it->second : tr("UNKNOWN");
+    }
+    case Column::OWNER_ADDRESS:
+        return entry.owner;
+    case Column::VOTING_ADDRESS:
+        return entry.voting;
+    case Column::PROTX_HASH:
+        return entry.proTxHash;
+    default:
+        return {};
+    };
+    return {};
+}
+
+QVariant MasternodeModel::headerData(int section, Qt::Orientation orientation, int role) const
+{
+    if (orientation != Qt::Horizontal || role != Qt::DisplayRole) return {};
+    switch (section) {
+    case Column::SERVICE:
+        return tr("Service");
+    // Disable EvoNodes
+    // case Column::TYPE:
+    //     return tr("Type");
+    case Column::STATUS:
+        return tr("Status");
+    case Column::POSE:
+        return tr("PoSe Score");
+    case Column::REGISTERED:
+        return tr("Registered");
+    case Column::LAST_PAYMENT:
+        return tr("Last Paid");
+    case Column::NEXT_PAYMENT:
+        return tr("Next Payment");
+    case Column::PAYOUT_ADDRESS:
+        return tr("Payout Address");
+    case Column::OPERATOR_REWARD:
+        return tr("Operator Reward");
+    case Column::COLLATERAL_ADDRESS:
+        return tr("Collateral Address");
+    case Column::OWNER_ADDRESS:
+        return tr("Owner Address");
+    case Column::VOTING_ADDRESS:
+        return tr("Voting Address");
+    case Column::PROTX_HASH:
+        return tr("ProTx Hash");
+    default:
+        return {};
+    }
+}
+
+int MasternodeModel::columnWidth(int section)
+{
+    switch (section) {
+    case Column::SERVICE:
+        return 200;
+    // Disable EvoNodes
+    // case Column::TYPE:
+    //     return 160;
+    case Column::STATUS:
+    case Column::POSE:
+    case Column::REGISTERED:
+    case Column::LAST_PAYMENT:
+        return 80;
+    case Column::NEXT_PAYMENT:
+        return 100;
+    default:
+        return 130;
+    }
+}
+
+std::vector<COutPoint> MasternodeModel::setList(const CDeterministicMNList& mnList, const std::vector<CDeterministicMNCPtr>& projectedPayees)
+{
+    const auto diff = m_list.BuildDiff(mnList);
+
+    if (!diff.removedMns.empty()) {
+        // Remove from the highest row down so the rows of the remaining masternodes stay valid
+        std::vector<int> rows;
+        for (const auto internalId : diff.removedMns) {
+            const auto dmn = m_list.GetMNByInternalId(internalId);
+            if (!dmn) continue;
+            auto it = m_rows.find(dmn->proTxHash);
+            if (it == m_rows.end()) continue;
+            rows.emplace_back(it->second);
+            m_collateral_addresses.erase(dmn->collateralOutpoint);
+        }
+        std::sort(rows.rbegin(), rows.rend());
+        for (const int row : rows) {
+            beginRemoveRows({}, row, row);
+            m_data.erase(m_data.begin() + row);
+            endRemoveRows();
+        }
+        m_rows.clear();
+        for (size_t i = 0; i < m_data.size(); ++i) {
+            m_rows.emplace(m_data[i].dmn->proTxHash, i);
+        }
+    }
+
+    for (const auto& [internalId, stateDiff] : diff.updatedMns) {
+        const auto dmn = mnList.GetMNByInternalId(internalId);
+        if (!dmn) continue;
+        auto it = m_rows.find(dmn->proTxHash);
+        if (it == m_rows.end()) continue;
+        m_data[it->second] = makeEntry(dmn);
+        Q_EMIT dataChanged(createIndex(it->second, 0), createIndex(it->second, Column::_COUNT - 1));
+    }
+
+    std::vector<COutPoint> unresolved;
+    if (!diff.addedMNs.empty()) {
+        const int first = m_data.size();
+        beginInsertRows({}, first, first + diff.addedMNs.size() - 1);
+        for (const auto& dmn : diff.addedMNs) {
+            m_rows.emplace(dmn->proTxHash, m_data.size());
+            m_data.emplace_back(makeEntry(dmn));
+            if (!m_collateral_addresses.count(dmn->collateralOutpoint)) {
+                unresolved.emplace_back(dmn->collateralOutpoint);
+            }
+        }
+        endInsertRows();
+    }
+
+    m_list = mnList;
+
+    m_next_payments.clear();
+    for (size_t i = 0; i < projectedPayees.size(); i++) {
+        m_next_payments.emplace(projectedPayees[i]->proTxHash, mnList.GetHeight() + (int)i + 1);
+    }
+    if (!m_data.empty()) {
+        Q_EMIT dataChanged(createIndex(0, Column::NEXT_PAYMENT), createIndex(m_data.size() - 1, Column::NEXT_PAYMENT));
+    }
+
+    return unresolved;
+}
+
+void MasternodeModel::setCollateralAddresses(const std::vector<std::pair<COutPoint, QString>>& addresses)
+{
+    for (const auto& [outpoint, address] : addresses) {
+        m_collateral_addresses[outpoint] = address;
+    }
+    if (!addresses.empty() && !m_data.empty()) {
+        Q_EMIT dataChanged(createIndex(0, Column::COLLATERAL_ADDRESS), createIndex(m_data.size() - 1, Column::COLLATERAL_ADDRESS));
+    }
+}
+
+CDeterministicMNCPtr MasternodeModel::getMNAt(const QModelIndex& index) const
+{
+    if (!index.isValid() || index.row() >= (int)m_data.size()) return nullptr;
+    return m_data[index.row()].dmn;
+}
+
+///
+/// Masternode Filter Proxy
+///
+
+void MasternodeFilterProxy::setMyMasternodes(std::optional<std::set<uint256>> my_masternodes)
+{
+    if (m_my_masternodes == my_masternodes) return;
+    m_my_masternodes = std::move(my_masternodes);
+    invalidateFilter();
+}
+
+bool MasternodeFilterProxy::filterAcceptsRow(int source_row, const QModelIndex& source_parent) const
+{
+    if (m_my_masternodes) {
+        const auto dmn = static_cast<const MasternodeModel*>(sourceModel())->getMNAt(sourceModel()->index(source_row, 0, source_parent));
+        if (!dmn || !m_my_masternodes->count(dmn->proTxHash)) return false;
     }
-};
+    return QSortFilterProxyModel::filterAcceptsRow(source_row, source_parent);
+}
+
+//
+// Masternode List main widget.
+//
 
 MasternodeList::MasternodeList(QWidget* parent) :
     QWidget(parent),
-    ui(new Ui::MasternodeList)
+    ui(new Ui::MasternodeList),
+    masternodeModel(new MasternodeModel(this)),
+    masternodeModelProxy(new MasternodeFilterProxy(this)),
+    collateralThread(new QThread(this)),
+    collateralWorker(new QObject())
 {
     ui->setupUi(this);
 
@@ -46,40 +296,35 @@ MasternodeList::MasternodeList(QWidget* parent) :
                      }, GUIUtil::FontWeight::Bold, 14);
     GUIUtil::setFont({ui->label_filter_2}, GUIUtil::FontWeight::Normal, 15);
 
-    int columnAddressWidth = 200;
-    // Disable EvoNodes
-    // int columnTypeWidth = 160;
-    int columnStatusWidth = 80;
-    int columnPoSeScoreWidth = 80;
-    int columnRegisteredWidth = 80;
-    int columnLastPaidWidth = 80;
-    int columnNextPaymentWidth = 100;
-    int columnPayeeWidth = 130;
-    int columnOperatorRewardWidth = 130;
-    int columnCollateralWidth = 130;
-    int columnOwnerWidth = 130;
-    int columnVotingWidth = 130;
-
-    ui->tableWidgetMasternodesDIP3->setColumnWidth(COLUMN_SERVICE, columnAddressWidth);
-    // Disable EvoNodes
-    // ui->tableWidgetMasternodesDIP3->setColumnWidth(COLUMN_TYPE, columnTypeWidth);
-    ui->tableWidgetMasternodesDIP3->setColumnWidth(COLUMN_STATUS, columnStatusWidth);
-    ui->tableWidgetMasternodesDIP3->setColumnWidth(COLUMN_POSE, columnPoSeScoreWidth);
-    ui->tableWidgetMasternodesDIP3->setColumnWidth(COLUMN_REGISTERED, columnRegisteredWidth);
-    ui->tableWidgetMasternodesDIP3->setColumnWidth(COLUMN_LAST_PAYMENT, columnLastPaidWidth);
-    ui->tableWidgetMasternodesDIP3->setColumnWidth(COLUMN_NEXT_PAYMENT, columnNextPaymentWidth);
-    ui->tableWidgetMasternodesDIP3->setColumnWidth(COLUMN_PAYOUT_ADDRESS, columnPayeeWidth);
-    ui->tableWidgetMasternodesDIP3->setColumnWidth(COLUMN_OPERATOR_REWARD, columnOperatorRewardWidth);
-    ui->tableWidgetMasternodesDIP3->setColumnWidth(COLUMN_COLLATERAL_ADDRESS, columnCollateralWidth);
-    ui->tableWidgetMasternodesDIP3->setColumnWidth(COLUMN_OWNER_ADDRESS, columnOwnerWidth);
-    ui->tableWidgetMasternodesDIP3->setColumnWidth(COLUMN_VOTING_ADDRESS, columnVotingWidth);
-
-    // dummy column for proTxHash
-    ui->tableWidgetMasternodesDIP3->insertColumn(COLUMN_PROTX_HASH);
-    ui->tableWidgetMasternodesDIP3->setColumnHidden(COLUMN_PROTX_HASH, true);
-
-    ui->tableWidgetMasternodesDIP3->setContextMenuPolicy(Qt::CustomContextMenu);
-    ui->tableWidgetMasternodesDIP3->verticalHeader()->setVisible(false);
+    masternodeModelProxy->setSourceModel(masternodeModel);
+    ui->tableViewMasternodesDIP3->setModel(masternodeModelProxy);
+    ui->tableViewMasternodesDIP3->setSelectionBehavior(QAbstractItemView::SelectRows);
+    ui->tableViewMasternodesDIP3->verticalHeader()->setVisible(false);
+
+    for (int i = 0; i < masternodeModel->columnCount(); ++i) {
+        ui->tableViewMasternodesDIP3->setColumnWidth(i, masternodeModel->columnWidth(i));
+    }
+    // proTxHash column is only used for filtering
+    ui->tableViewMasternodesDIP3->setColumnHidden(MasternodeModel::Column::PROTX_HASH, true);
+
+    // Set up sorting.
+    masternodeModelProxy->setSortRole(Qt::EditRole);
+    ui->tableViewMasternodesDIP3->setSortingEnabled(true);
+
+    // Set up filtering, matching the text against all columns.
+    masternodeModelProxy->setFilterKeyColumn(-1);
+
+    // Changes to number of rows should update masternode count display.
+    connect(masternodeModelProxy, &QSortFilterProxyModel::rowsInserted, this, &MasternodeList::updateMasternodeCount);
+    connect(masternodeModelProxy, &QSortFilterProxyModel::rowsRemoved, this, &MasternodeList::updateMasternodeCount);
+    connect(masternodeModelProxy, &QSortFilterProxyModel::layoutChanged, this, &MasternodeList::updateMasternodeCount);
+    connect(masternodeModelProxy, &QSortFilterProxyModel::modelReset, this, &MasternodeList::updateMasternodeCount);
+
+    collateralWorker->moveToThread(collateralThread);
+    connect(collateralThread, &QThread::finished, collateralWorker, &QObject::deleteLater);
+    collateralThread->start();
+
+    ui->tableViewMasternodesDIP3->setContextMenuPolicy(Qt::CustomContextMenu);
 
     ui->checkBoxMyMasternodesOnly->setEnabled(false);
 
@@ -88,8 +333,8 @@ MasternodeList::MasternodeList(QWidget* parent) :
     contextMenuDIP3 = new QMenu(this);
     contextMenuDIP3->addAction(copyProTxHashAction);
     contextMenuDIP3->addAction(copyCollateralOutpointAction);
-    connect(ui->tableWidgetMasternodesDIP3, &QTableWidget::customContextMenuRequested, this, &MasternodeList::showContextMenuDIP3);
-    connect(ui->tableWidgetMasternodesDIP3, &QTableWidget::doubleClicked, this, &MasternodeList::extraInfoDIP3_clicked);
+    connect(ui->tableViewMasternodesDIP3, &QTableView::customContextMenuRequested, this, &MasternodeList::showContextMenuDIP3);
+    connect(ui->tableViewMasternodesDIP3, &QTableView::doubleClicked, this, &MasternodeList::extraInfoDIP3_clicked);
     connect(copyProTxHashAction, &QAction::triggered, this, &MasternodeList::copyProTxHash_clicked);
     connect(copyCollateralOutpointAction, &QAction::triggered, this, &MasternodeList::copyCollateralOutpoint_clicked);
 
@@ -102,6 +347,8 @@ MasternodeList::MasternodeList(QWidget* parent) :
 
 MasternodeList::~MasternodeList()
 {
+    collateralThread->quit();
+    collateralThread->wait();
     delete ui;
 }
 
@@ -122,8 +369,7 @@ void MasternodeList::setWalletModel(WalletModel* model)
 
 void MasternodeList::showContextMenuDIP3(const QPoint& point)
 {
-    QTableWidgetItem* item = ui->tableWidgetMasternodesDIP3->itemAt(point);
-    if (item) contextMenuDIP3->exec(QCursor::pos());
+    if (ui->tableViewMasternodesDIP3->indexAt(point).isValid()) contextMenuDIP3->exec(QCursor::pos());
 }
 
 void MasternodeList::handleMasternodeListChanged()
@@ -141,17 +387,7 @@ void MasternodeList::updateDIP3ListScheduled()
         return;
     }
 
-    // To prevent high cpu usage update only once in MASTERNODELIST_FILTER_COOLDOWN_SECONDS seconds
-    // after filter was last changed unless we want to force the update.
-    if (fFilterUpdatedDIP3) {
-        int64_t nSecondsToWait = nTimeFilterUpdatedDIP3 - GetTime() + MASTERNODELIST_FILTER_COOLDOWN_SECONDS;
-        ui->countLabelDIP3->setText(tr("Please wait...") + " " + QString::number(nSecondsToWait));
-
-        if (nSecondsToWait <= 0) {
-            updateDIP3List();
-            fFilterUpdatedDIP3 = false;
-        }
-    } else if (mnListChanged) {
+    if (mnListChanged) {
         int64_t nMnListUpdateSecods = clientModel->masternodeSync().isBlockchainSynced() ? MASTERNODELIST_UPDATE_SECONDS : MASTERNODELIST_UPDATE_SECONDS * 10;
         int64_t nSecondsToWait = nTimeUpdatedDIP3 - GetTime() + nMnListUpdateSecods;
 
@@ -177,165 +413,82 @@ void MasternodeList::updateDIP3List()
         return;
     }
 
-    std::map<uint256, CTxDestination> mapCollateralDests;
-
-    {
-        // Get all UTXOs for each MN collateral in one go so that we can reduce locking overhead for cs_main
-        // We also do this outside of the below Qt list update loop to reduce cs_main locking time to a minimum
-        mnList.ForEachMN(false, [&](auto& dmn) {
-            CTxDestination collateralDest;
-            Coin coin;
-            if (clientModel->node().getUnspentOutput(dmn.collateralOutpoint, coin) && ExtractDestination(coin.out.scriptPubKey, collateralDest)) {
-                mapCollateralDests.emplace(dmn.proTxHash, collateralDest);
-            }
-        });
-    }
-
     LOCK(cs_dip3list);
 
-    QString strToFilter;
-    ui->countLabelDIP3->setText(tr("Updating..."));
-    ui->tableWidgetMasternodesDIP3->setSortingEnabled(false);
-    ui->tableWidgetMasternodesDIP3->clearContents();
-    ui->tableWidgetMasternodesDIP3->setRowCount(0);
-
     nTimeUpdatedDIP3 = GetTime();
 
-    std::map<uint256, int> nextPayments;
-    for (size_t i = 0; i < projectedPayees.size(); i++) {
-        const auto& dmn = projectedPayees[i];
-        nextPayments.emplace(dmn->proTxHash, mnList.GetHeight() + (int)i + 1);
+    // Only the masternodes which changed since the last update are touched, see MasternodeModel::setList
+    auto unresolved = masternodeModel->setList(mnList, projectedPayees);
+    if (!unresolved.empty()) {
+        resolveCollateralAddresses(std::move(unresolved));
     }
 
-    std::set<COutPoint> setOutpts;
     if (walletModel && ui->checkBoxMyMasternodesOnly->isChecked()) {
-        std::vector<COutPoint> vOutpts;
-        walletModel->wallet().listProTxCoins(vOutpts);
-        for (const auto& outpt : vOutpts) {
-            setOutpts.emplace(outpt);
-        }
+        updateMyMasternodes(mnList);
     }
+}
 
+void MasternodeList::updateMyMasternodes(const CDeterministicMNList& mnList)
+{
+    std::set<COutPoint> setOutpts;
+    std::vector<COutPoint> vOutpts;
+    walletModel->wallet().listProTxCoins(vOutpts);
+    for (const auto& outpt : vOutpts) {
+        setOutpts.emplace(outpt);
+    }
+
+    std::set<uint256> myMasternodes;
     mnList.ForEachMN(false, [&](auto& dmn) {
-        if (walletModel && ui->checkBoxMyMasternodesOnly->isChecked()) {
-            bool fMyMasternode = setOutpts.count(dmn.collateralOutpoint) ||
-                walletModel->wallet().isSpendable(PKHash(dmn.pdmnState->keyIDOwner)) ||
-                walletModel->wallet().isSpendable(PKHash(dmn.pdmnState->keyIDVoting)) ||
-                walletModel->wallet().isSpendable(dmn.pdmnState->scriptPayout) ||
-                walletModel->wallet().isSpendable(dmn.pdmnState->scriptOperatorPayout);
-            if (!fMyMasternode) return;
-        }
-        // populate list
-        // Address, Protocol, Status, Active Seconds, Last Seen, Pub Key
-        auto addr_key = dmn.pdmnState->addr.GetKey();
-        QByteArray addr_ba(reinterpret_cast<const char*>(addr_key.data()), addr_key.size());
-        QTableWidgetItem* addressItem = new CMasternodeListWidgetItem<QByteArray>(QString::fromStdString(dmn.pdmnState->addr.ToString()), addr_ba);
-        // Disable EvoNodes
-        // QTableWidgetItem* typeItem = new QTableWidgetItem(QString::fromStdString(std::string(GetMnType(dmn.nType).description)));
-        QTableWidgetItem* statusItem = new QTableWidgetItem(dmn.pdmnState->IsBanned() ? tr("POSE_BANNED") : tr("ENABLED"));
-        QTableWidgetItem* PoSeScoreItem = new CMasternodeListWidgetItem<int>(QString::number(dmn.pdmnState->nPoSePenalty), dmn.pdmnState->nPoSePenalty);
-        QTableWidgetItem* registeredItem = new CMasternodeListWidgetItem<int>(QString::number(dmn.pdmnState->nRegisteredHeight), dmn.pdmnState->nRegisteredHeight);
-        QTableWidgetItem* lastPaidItem = new CMasternodeListWidgetItem<int>(QString::number(dmn.pdmnState->nLastPaidHeight), dmn.pdmnState->nLastPaidHeight);
-
-        QString strNextPayment = "UNKNOWN";
-        int nNextPayment = 0;
-        if (nextPayments.count(dmn.proTxHash)) {
-            nNextPayment = nextPayments[dmn.proTxHash];
-            strNextPayment = QString::number(nNextPayment);
-        }
-        QTableWidgetItem* nextPaymentItem = new CMasternodeListWidgetItem<int>(strNextPayment, nNextPayment);
+        bool fMyMasternode = setOutpts.count(dmn.collateralOutpoint) ||
+            walletModel->wallet().isSpendable(PKHash(dmn.pdmnState->keyIDOwner)) ||
+            walletModel->wallet().isSpendable(PKHash(dmn.pdmnState->keyIDVoting)) ||
+            walletModel->wallet().isSpendable(dmn.pdmnState->scriptPayout) ||
+            walletModel->wallet().isSpendable(dmn.pdmnState->scriptOperatorPayout);
+        if (fMyMasternode) myMasternodes.emplace(dmn.proTxHash);
+    });
+    masternodeModelProxy->setMyMasternodes(std::move(myMasternodes));
+}
 
-        CTxDestination payeeDest;
-        QString payeeStr = tr("UNKNOWN");
-        if (ExtractDestination(dmn.pdmnState->scriptPayout, payeeDest)) {
-            payeeStr = QString::fromStdString(EncodeDestination(payeeDest));
-        }
-        QTableWidgetItem* payeeItem = new QTableWidgetItem(payeeStr);
-
-        QString operatorRewardStr = tr("NONE");
-        if (dmn.nOperatorReward) {
-            operatorRewardStr = QString::number(dmn.nOperatorReward / 100.0, 'f', 2) + "% ";
-
-            if (dmn.pdmnState->scriptOperatorPayout != CScript()) {
-                CTxDestination operatorDest;
-                if (ExtractDestination(dmn.pdmnState->scriptOperatorPayout, operatorDest)) {
-                    operatorRewardStr += tr("to %1").arg(QString::fromStdString(EncodeDestination(operatorDest)));
-                } else {
-                    operatorRewardStr += tr("to UNKNOWN");
-                }
-            } else {
-                operatorRewardStr += tr("but not claimed");
+void MasternodeList::resolveCollateralAddresses(std::vector<COutPoint> outpoints)
+{
+    // Looking up thousands of collaterals takes cs_main for each of them, so do it on the worker thread and hand
+    // the addresses back to the model on the GUI thread. Until then the column shows UNKNOWN.
+    QMetaObject::invokeMethod(collateralWorker, [node = &clientModel->node(), model = masternodeModel, outpoints = std::move(outpoints)] {
+        std::vector<std::pair<COutPoint, QString>> addresses;
+        addresses.reserve(outpoints.size());
+        for (const auto& outpoint : outpoints) {
+            if (node->shutdownRequested()) return;
+            CTxDestination collateralDest;
+            Coin coin;
+            if (node->getUnspentOutput(outpoint, coin) && ExtractDestination(coin.out.scriptPubKey, collateralDest)) {
+                addresses.emplace_back(outpoint, QString::fromStdString(EncodeDestination(collateralDest)));
             }
         }
-        QTableWidgetItem* operatorRewardItem = new CMasternodeListWidgetItem<uint16_t>(operatorRewardStr, dmn.nOperatorReward);
-
-        QString collateralStr = tr("UNKNOWN");
-        auto collateralDestIt = mapCollateralDests.find(dmn.proTxHash);
-        if (collateralDestIt != mapCollateralDests.end()) {
-            collateralStr = QString::fromStdString(EncodeDestination(collateralDestIt->second));
-        }
-        QTableWidgetItem* collateralItem = new QTableWidgetItem(collateralStr);
-
-        QString ownerStr = QString::fromStdString(EncodeDestination(PKHash(dmn.pdmnState->keyIDOwner)));
-        QTableWidgetItem* ownerItem = new QTableWidgetItem(ownerStr);
-
-        QString votingStr = QString::fromStdString(EncodeDestination(PKHash(dmn.pdmnState->keyIDVoting)));
-        QTableWidgetItem* votingItem = new QTableWidgetItem(votingStr);
-
-        QTableWidgetItem* proTxHashItem = new QTableWidgetItem(QString::fromStdString(dmn.proTxHash.ToString()));
-
-        if (strCurrentFilterDIP3 != "") {
-            strToFilter = addressItem->text() + " " +
-                          // Disable EvoNodes
-                          // typeItem->text() + " " +
-                          statusItem->text() + " " +
-                          PoSeScoreItem->text() + " " +
-                          registeredItem->text() + " " +
-                          lastPaidItem->text() + " " +
-                          nextPaymentItem->text() + " " +
-                          payeeItem->text() + " " +
-                          operatorRewardItem->text() + " " +
-                          collateralItem->text() + " " +
-                          ownerItem->text() + " " +
-                          votingItem->text() + " " +
-                          proTxHashItem->text();
-            if (!strToFilter.contains(strCurrentFilterDIP3)) return;
-        }
-
-        ui->tableWidgetMasternodesDIP3->insertRow(0);
-        ui->tableWidgetMasternodesDIP3->setItem(0, COLUMN_SERVICE, addressItem);
-        // Disable EvoNodes
-        // ui->tableWidgetMasternodesDIP3->setItem(0, COLUMN_TYPE, typeItem);
-        ui->tableWidgetMasternodesDIP3->setItem(0, COLUMN_STATUS, statusItem);
-        ui->tableWidgetMasternodesDIP3->setItem(0, COLUMN_POSE, PoSeScoreItem);
-        ui->tableWidgetMasternodesDIP3->setItem(0, COLUMN_REGISTERED, registeredItem);
-        ui->tableWidgetMasternodesDIP3->setItem(0, COLUMN_LAST_PAYMENT, lastPaidItem);
-        ui->tableWidgetMasternodesDIP3->setItem(0, COLUMN_NEXT_PAYMENT, nextPaymentItem);
-        ui->tableWidgetMasternodesDIP3->setItem(0, COLUMN_PAYOUT_ADDRESS, payeeItem);
-        ui->tableWidgetMasternodesDIP3->setItem(0, COLUMN_OPERATOR_REWARD, operatorRewardItem);
-        ui->tableWidgetMasternodesDIP3->setItem(0, COLUMN_COLLATERAL_ADDRESS, collateralItem);
-        ui->tableWidgetMasternodesDIP3->setItem(0, COLUMN_OWNER_ADDRESS, ownerItem);
-        ui->tableWidgetMasternodesDIP3->setItem(0, COLUMN_VOTING_ADDRESS, votingItem);
-        ui->tableWidgetMasternodesDIP3->setItem(0, COLUMN_PROTX_HASH, proTxHashItem);
-    });
+        QMetaObject::invokeMethod(model, [model, addresses = std::move(addresses)] {
+            model->setCollateralAddresses(addresses);
+        }, Qt::QueuedConnection);
+    }, Qt::QueuedConnection);
+}
 
-    ui->countLabelDIP3->setText(QString::number(ui->tableWidgetMasternodesDIP3->rowCount()));
-    ui->tableWidgetMasternodesDIP3->setSortingEnabled(true);
+void MasternodeList::updateMasternodeCount() const
+{
+    ui->countLabelDIP3->setText(QString::number(masternodeModelProxy->rowCount()));
 }
 
 void MasternodeList::on_filterLineEditDIP3_textChanged(const QString& strFilterIn)
 {
-    strCurrentFilterDIP3 = strFilterIn;
-    nTimeFilterUpdatedDIP3 = GetTime();
-    fFilterUpdatedDIP3 = true;
-    ui->countLabelDIP3->setText(tr("Please wait...") + " " + QString::number(MASTERNODELIST_FILTER_COOLDOWN_SECONDS));
+    masternodeModelProxy->setFilterFixedString(strFilterIn);
+    updateMasternodeCount();
 }
 
 void MasternodeList::on_checkBoxMyMasternodesOnly_stateChanged(int state)
 {
-    // no cooldown
-    nTimeFilterUpdatedDIP3 = GetTime() - MASTERNODELIST_FILTER_COOLDOWN_SECONDS;
-    fFilterUpdatedDIP3 = true;
+    if (walletModel && clientModel && state == Qt::Checked) {
+        updateMyMasternodes(clientModel->getMasternodeList().first);
+    } else {
+        masternodeModelProxy->setMyMasternodes(std::nullopt);
+    }
+    updateMasternodeCount();
 }
 
 CDeterministicMNCPtr MasternodeList::GetSelectedDIP3MN()
@@ -344,24 +497,20 @@ CDeterministicMNCPtr MasternodeList::GetSelectedDIP3MN()
         return nullptr;
     }
 
-    std::string strProTxHash;
+    uint256 proTxHash;
     {
         LOCK(cs_dip3list);
 
-        QItemSelectionModel* selectionModel = ui->tableWidgetMasternodesDIP3->selectionModel();
-        QModelIndexList selected = selectionModel->selectedRows();
-
+        QModelIndexList selected = ui->tableViewMasternodesDIP3->selectionModel()->selectedRows();
         if (selected.count() == 0) return nullptr;
 
-        QModelIndex index = selected.at(0);
-        int nSelectedRow = index.row();
-        strProTxHash = ui->tableWidgetMasternodesDIP3->item(nSelectedRow, COLUMN_PROTX_HASH)->text().toStdString();
+        const auto dmn = masternodeModel->getMNAt(masternodeModelProxy->mapToSource(selected.at(0)));
+        if (!dmn) return nullptr;
+        proTxHash = dmn->proTxHash;
     }
 
-    uint256 proTxHash;
-    proTxHash.SetHex(strProTxHash);
-
-    return clientModel->getMasternodeList().first.GetMN(proTxHash);;
+    // Return the current state of the masternode rather than the one the table was last updated with
+    return clientModel->getMasternodeList().first.GetMN(proTxHash);
 }
 
 void MasternodeList::extraInfoDIP3_clicked()
@@ -5,30 +5,39 @@
 #ifndef BITCOIN_QT_MASTERNODELIST_H
 #define BITCOIN_QT_MASTERNODELIST_H
 
+#include <evo/deterministicmns.h>
 #include <primitives/transaction.h>
+#include <saltedhasher.h>
 #include <sync.h>
 #include <util/system.h>
 
+#include <QAbstractTableModel>
 #include <QMenu>
+#include <QSortFilterProxyModel>
 #include <QTimer>
 #include <QWidget>
 
+#include <map>
+#include <optional>
+#include <set>
+#include <unordered_map>
+#include <vector>
+
 #define MASTERNODELIST_UPDATE_SECONDS 3
-#define MASTERNODELIST_FILTER_COOLDOWN_SECONDS 3
 
 namespace Ui
 {
 class MasternodeList;
 }
 
-class CDeterministicMN;
-using CDeterministicMNCPtr = std::shared_ptr<const CDeterministicMN>;
-
 class ClientModel;
+class MasternodeFilterProxy;
+class MasternodeModel;
 class WalletModel;
 
 QT_BEGIN_NAMESPACE
 class QModelIndex;
+class QThread;
 QT_END_NAMESPACE
 
 /** Masternode Manager page widget */
@@ -40,47 +49,35 @@ public:
     explicit MasternodeList(QWidget* parent = 0);
     ~MasternodeList();
 
-    enum {
-        COLUMN_SERVICE,
-        // Disable EvoNodes
-        // COLUMN_TYPE,
-        COLUMN_STATUS,
-        COLUMN_POSE,
-        COLUMN_REGISTERED,
-        COLUMN_LAST_PAYMENT,
-        COLUMN_NEXT_PAYMENT,
-        COLUMN_PAYOUT_ADDRESS,
-        COLUMN_OPERATOR_REWARD,
-        COLUMN_COLLATERAL_ADDRESS,
-        COLUMN_OWNER_ADDRESS,
-        COLUMN_VOTING_ADDRESS,
-        COLUMN_PROTX_HASH,
-    };
-
     void setClientModel(ClientModel* clientModel);
     void setWalletModel(WalletModel* walletModel);
 
 private:
     QMenu* contextMenuDIP3;
-    int64_t nTimeFilterUpdatedDIP3{0};
     int64_t nTimeUpdatedDIP3{0};
-    bool fFilterUpdatedDIP3{true};
 
     QTimer* timer;
     Ui::MasternodeList* ui;
     ClientModel* clientModel{nullptr};
     WalletModel* walletModel{nullptr};
 
-    // Protects tableWidgetMasternodesDIP3
-    RecursiveMutex cs_dip3list;
+    MasternodeModel* masternodeModel;
+    MasternodeFilterProxy* masternodeModelProxy;
+
+    // Collateral addresses are looked up in the UTXO set on this thread, see resolveCollateralAddresses()
+    QThread* collateralThread;
+    QObject* collateralWorker;
 
-    QString strCurrentFilterDIP3;
+    // Protects mnListChanged
+    RecursiveMutex cs_dip3list;
 
     bool mnListChanged{true};
 
     CDeterministicMNCPtr GetSelectedDIP3MN();
 
     void updateDIP3List();
+    void updateMyMasternodes(const CDeterministicMNList& mnList);
+    void resolveCollateralAddresses(std::vector<COutPoint> outpoints);
 
 Q_SIGNALS:
     void doubleClicked(const QModelIndex&);
@@ -96,5 +93,94 @@ private Q_SLOTS:
 
     void handleMasternodeListChanged();
     void updateDIP3ListScheduled();
+    void updateMasternodeCount() const;
+};
+
+/**
+ * Table model of the masternode list. It is updated with the diff to each new list, so rows are only inserted,
+ * removed or changed for the masternodes which actually changed, and their display strings are built once.
+ */
+class MasternodeModel : public QAbstractTableModel
+{
+    Q_OBJECT
+
+private:
+    struct Entry {
+        CDeterministicMNCPtr dmn;
+        QString service;
+        //! The service address in a sortable form
+        QString serviceKey;
+        QString payout;
+        QString operatorReward;
+        QString owner;
+        QString voting;
+        QString proTxHash;
+    };
+
+    std::vector<Entry> m_data;
+    //! Row of each masternode by proTxHash
+    std::unordered_map<uint256, int, StaticSaltedHasher> m_rows;
+    //! The list m_data was last updated to
+    CDeterministicMNList m_list;
+    std::unordered_map<uint256, int, StaticSaltedHasher> m_next_payments;
+    std::map<COutPoint, QString> m_collateral_addresses;
+
+    Entry makeEntry(const CDeterministicMNCPtr& dmn) const;
+
+public:
+    explicit MasternodeModel(QObject* parent = nullptr) :
+        QAbstractTableModel(parent){};
+
+    enum Column : int {
+        SERVICE = 0,
+        // Disable EvoNodes
+        // TYPE,
+        STATUS,
+        POSE,
+        REGISTERED,
+        LAST_PAYMENT,
+        NEXT_PAYMENT,
+        PAYOUT_ADDRESS,
+        OPERATOR_REWARD,
+        COLLATERAL_ADDRESS,
+        OWNER_ADDRESS,
+        VOTING_ADDRESS,
+        PROTX_HASH,
+        _COUNT // for internal use only
+    };
+
+    int rowCount(const QModelIndex& parent = QModelIndex()) const override;
+    int columnCount(const QModelIndex& parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex& index, int role) const override;
+    QVariant headerData(int section, Qt::Orientation orientation, int role) const override;
+    static int columnWidth(int section);
+
+    /**
+     * Apply the changes from the current list to mnList and set the next payment heights. Returns the collateral
+     * outpoints of added masternodes whose collateral address is not known yet.
+     */
+    std::vector<COutPoint> setList(const CDeterministicMNList& mnList, const std::vector<CDeterministicMNCPtr>& projectedPayees);
+    void setCollateralAddresses(const std::vector<std::pair<COutPoint, QString>>& addresses);
+
+    CDeterministicMNCPtr getMNAt(const QModelIndex& index) const;
+};
+
+/** Filters the masternode table by a text matching any column and, optionally, by the masternodes of the wallet */
+class MasternodeFilterProxy : public QSortFilterProxyModel
+{
+    Q_OBJECT
+
+private:
+    std::optional<std::set<uint256>> m_my_masternodes;
+
+public:
+    explicit MasternodeFilterProxy(QObject* parent = nullptr) :
+        QSortFilterProxyModel(parent){};
+
+    /** Only accept the masternodes with these proTxHashes, or all with std::nullopt */
+    void setMyMasternodes(std::optional<std::set<uint256>> my_masternodes);
+
+protected:
+    bool filterAcceptsRow(int source_row, const QModelIndex& source_parent) const override;
 };
 #endif // BITCOIN_QT_MASTERNODELIST_H
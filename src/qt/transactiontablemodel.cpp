@@ -13,11 +13,13 @@
 
 #include <core_io.h>
 #include <interfaces/handler.h>
+#include <util/hasher.h>
 #include <uint256.h>
 #include <util/system.h>
 
 #include <algorithm>
 #include <functional>
+#include <unordered_map>
 
 #include <QColor>
 #include <QDateTime>
@@ -37,22 +39,8 @@ static int column_alignments[] = {
         Qt::AlignRight|Qt::AlignVCenter /* amount */
     };
 
-// Comparison operator for sort/binary search of model tx list
-struct TxLessThan
-{
-    bool operator()(const TransactionRecord &a, const TransactionRecord &b) const
-    {
-        return a.hash < b.hash;
-    }
-    bool operator()(const TransactionRecord &a, const uint256 &b) const
-    {
-        return a.hash < b;
-    }
-    bool operator()(const uint256 &a, const TransactionRecord &b) const
-    {
-        return a < b.hash;
-    }
-};
+//! Number of wallet transactions decomposed into records per fetchMore() call
+static const size_t TX_PAGE_SIZE = 1000;
 
 // queue notifications to show a non freezing progress dialog e.g. for rescan
 struct TransactionNotification
@@ -90,10 +78,18 @@ public:
     TransactionTableModel *parent;
 
     /* Local cache of wallet.
-     * As it is in the same order as the CWallet, by definition
-     * this is sorted by sha256.
+     * Records are kept in the order they were loaded, the transactions of the
+     * wallet are paged in most recent first as the views ask for more rows.
      */
     QList<TransactionRecord> cachedWallet;
+    /* Row of the first record of each transaction in cachedWallet,
+     * the records of a transaction are always adjacent.
+     */
+    std::unordered_map<uint256, int, SaltedTxidHasher> cachedIndex;
+
+    /* Wallet transactions which are not loaded yet, most recent first */
+    std::vector<uint256> pendingTxs;
+    size_t pendingPos = 0;
 
     bool fQueueNotifications = false;
     std::vector< TransactionNotification > vQueueNotifications;
@@ -103,6 +99,7 @@ public:
     void ShowProgress(const std::string &title, int nProgress);
 
     /* Query entire wallet anew from core.
+     * Only the hashes are fetched here, records are created by loadMore().
      */
     void refreshWallet(interfaces::Wallet& wallet)
     {
@@ -110,17 +107,73 @@ public:
         parent->beginResetModel();
         try {
             cachedWallet.clear();
-            for (const auto& wtx : wallet.getWalletTxs()) {
-                if (TransactionRecord::showTransaction()) {
-                    cachedWallet.append(TransactionRecord::decomposeTransaction(wallet, wtx));
-                }
-            }
+            cachedIndex.clear();
+            pendingTxs = wallet.getWalletTxHashes();
+            pendingPos = 0;
+            cachedWallet.append(decomposeNextPage(wallet));
+            reindex();
         } catch(const std::exception& e) {
             QMessageBox::critical(nullptr, PACKAGE_NAME, QString("Failed to refresh wallet table: ") + QString::fromStdString(e.what()));
         }
         parent->endResetModel();
     }
 
+    bool canLoadMore() const
+    {
+        return pendingPos < pendingTxs.size();
+    }
+
+    /* Append the records of the next page of wallet transactions */
+    void loadMore(interfaces::Wallet& wallet)
+    {
+        QList<TransactionRecord> toInsert = decomposeNextPage(wallet);
+        if (toInsert.isEmpty()) return;
+
+        parent->beginInsertRows(QModelIndex(), cachedWallet.size(), cachedWallet.size() + toInsert.size() - 1);
+        for (const TransactionRecord& rec : toInsert) {
+            cachedIndex.emplace(rec.hash, cachedWallet.size());
+            cachedWallet.append(rec);
+        }
+        parent->endInsertRows();
+    }
+
+    /* Decompose the next TX_PAGE_SIZE pending transactions, skipping the ones
+     * which were added to the model by a notification in the meantime.
+     */
+    QList<TransactionRecord> decomposeNextPage(interfaces::Wallet& wallet)
+    {
+        QList<TransactionRecord> result;
+        if (!TransactionRecord::showTransaction()) {
+            pendingPos = pendingTxs.size();
+            return result;
+        }
+        while (result.isEmpty() && canLoadMore()) {
+            std::vector<uint256> page;
+            for (; pendingPos < pendingTxs.size() && page.size() < TX_PAGE_SIZE; ++pendingPos) {
+                if (!cachedIndex.count(pendingTxs[pendingPos])) {
+                    page.emplace_back(pendingTxs[pendingPos]);
+                }
+            }
+            for (const auto& wtx : wallet.getWalletTxs(page)) {
+                result.append(TransactionRecord::decomposeTransaction(wallet, wtx));
+            }
+        }
+        if (!canLoadMore()) {
+            pendingTxs.clear();
+            pendingTxs.shrink_to_fit();
+            pendingPos = 0;
+        }
+        return result;
+    }
+
+    void reindex()
+    {
+        cachedIndex.clear();
+        for (int i = 0; i < cachedWallet.size(); ++i) {
+            cachedIndex.emplace(cachedWallet[i].hash, i);
+        }
+    }
+
     /* Update our model of the wallet incrementally, to synchronize our model of the wallet
        with that of the core.
 
@@ -131,13 +184,13 @@ public:
         qDebug() << "TransactionTablePriv::updateWallet: " + QString::fromStdString(hash.ToString()) + " " + QString::number(status);
 
         // Find bounds of this transaction in model
-        QList<TransactionRecord>::iterator lower = std::lower_bound(
-            cachedWallet.begin(), cachedWallet.end(), hash, TxLessThan());
-        QList<TransactionRecord>::iterator upper = std::upper_bound(
-            cachedWallet.begin(), cachedWallet.end(), hash, TxLessThan());
-        int lowerIndex = (lower - cachedWallet.begin());
-        int upperIndex = (upper - cachedWallet.begin());
-        bool inModel = (lower != upper);
+        auto it = cachedIndex.find(hash);
+        bool inModel = (it != cachedIndex.end());
+        int lowerIndex = inModel ? it->second : cachedWallet.size();
+        int upperIndex = lowerIndex;
+        while (upperIndex < cachedWallet.size() && cachedWallet[upperIndex].hash == hash) {
+            ++upperIndex;
+        }
 
         if(status == CT_UPDATED)
         {
@@ -168,18 +221,14 @@ public:
                     qWarning() << "TransactionTablePriv::updateWallet: Warning: Got CT_NEW, but transaction is not in wallet";
                     break;
                 }
-                // Added -- insert at the right position
+                // Added -- append, the views sort the records themselves
                 QList<TransactionRecord> toInsert =
                         TransactionRecord::decomposeTransaction(wallet, wtx);
                 if(!toInsert.isEmpty()) /* only if something to insert */
                 {
                     parent->beginInsertRows(QModelIndex(), lowerIndex, lowerIndex+toInsert.size()-1);
-                    int insert_idx = lowerIndex;
-                    for (const TransactionRecord &rec : toInsert)
-                    {
-                        cachedWallet.insert(insert_idx, rec);
-                        insert_idx += 1;
-                    }
+                    cachedIndex.emplace(hash, lowerIndex);
+                    cachedWallet.append(toInsert);
                     parent->endInsertRows();
                 }
             }
@@ -192,7 +241,8 @@ public:
             }
             // Removed -- remove entire transaction from table
             parent->beginRemoveRows(QModelIndex(), lowerIndex, upperIndex-1);
-            cachedWallet.erase(lower, upper);
+            cachedWallet.erase(cachedWallet.begin() + lowerIndex, cachedWallet.begin() + upperIndex);
+            reindex();
             parent->endRemoveRows();
             break;
         case CT_UPDATED:
@@ -202,7 +252,7 @@ public:
                 TransactionRecord *rec = &cachedWallet[i];
                 rec->status.needsUpdate = true;
             }
-            Q_EMIT parent->dataChanged(parent->index(lowerIndex, TransactionTableModel::Status), parent->index(upperIndex, TransactionTableModel::Status));
+            Q_EMIT parent->dataChanged(parent->index(lowerIndex, TransactionTableModel::Status), parent->index(upperIndex - 1, TransactionTableModel::Status));
             break;
         }
     }
@@ -327,6 +377,26 @@ int TransactionTableModel::getChainLockHeight() const
     return cachedChainLockHeight;
 }
 
+bool TransactionTableModel::canFetchMore(const QModelIndex &parent) const
+{
+    if (parent.isValid()) {
+        return false;
+    }
+    return priv->canLoadMore();
+}
+
+void TransactionTableModel::fetchMore(const QModelIndex &parent)
+{
+    if (parent.isValid()) {
+        return;
+    }
+    // Paged in rows are not new transactions, don't show notifications for them
+    const bool fProcessing = fProcessingQueuedTransactions;
+    fProcessingQueuedTransactions = true;
+    priv->loadMore(walletModel->wallet());
+    fProcessingQueuedTransactions = fProcessing;
+}
+
 int TransactionTableModel::rowCount(const QModelIndex &parent) const
 {
     if (parent.isValid()) {
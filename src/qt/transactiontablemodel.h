@@ -82,6 +82,9 @@ public:
     QVariant data(const QModelIndex &index, int role) const override;
     QVariant headerData(int section, Qt::Orientation orientation, int role) const override;
     QModelIndex index(int row, int column, const QModelIndex & parent = QModelIndex()) const override;
+    /** Wallet transactions are loaded in pages, most recent first, as the views scroll down */
+    bool canFetchMore(const QModelIndex &parent) const override;
+    void fetchMore(const QModelIndex &parent) override;
     bool processingQueuedTransactions() const { return fProcessingQueuedTransactions; }
     void updateChainLockHeight(int chainLockHeight);
     int getChainLockHeight() const;
@@ -394,6 +394,11 @@ void TransactionView::exportClicked()
     if (filename.isNull())
         return;
 
+    // Transactions are loaded as the table is scrolled, make sure the whole history is exported
+    while (transactionProxyModel->canFetchMore(QModelIndex())) {
+        transactionProxyModel->fetchMore(QModelIndex());
+    }
+
     CSVModelWriter writer(filename);
 
     // name, column, role
@@ -7,9 +7,13 @@
 #include <chainparams.h>
 #include <context.h>
 #include <core_io.h>
+#include <evo/simplifiedmns.h>
 #include <httpserver.h>
+#include <index/addressindex.h>
 #include <index/txindex.h>
+#include <key_io.h>
 #include <llmq/chainlocks.h>
+#include <llmq/commitment.h>
 #include <llmq/context.h>
 #include <llmq/instantsend.h>
 #include <node/blockstorage.h>
@@ -19,6 +23,7 @@
 #include <rpc/blockchain.h>
 #include <rpc/protocol.h>
 #include <rpc/server.h>
+#include <spentindex.h>
 #include <streams.h>
 #include <sync.h>
 #include <txmempool.h>
@@ -704,6 +709,127 @@ static bool rest_blockhash_by_height(const CoreContext& context, HTTPRequest* re
     }
 }
 
+static bool rest_mnlistdiff(const CoreContext& context, HTTPRequest* req, const std::string& strURIPart)
+{
+    if (!CheckWarmup(req))
+        return false;
+    std::string param;
+    const RetFormat rf = ParseDataFormat(param, strURIPart);
+    std::vector<std::string> path = SplitString(param, '/');
+
+    if (path.size() != 2)
+        return RESTERR(req, HTTP_BAD_REQUEST, "Invalid URI format. Use /rest/mnlistdiff/<basehash>/<hash>.<ext>.");
+
+    uint256 base_hash, hash;
+    if (!ParseHashStr(path[0], base_hash))
+        return RESTERR(req, HTTP_BAD_REQUEST, "Invalid hash: " + SanitizeString(path[0]));
+    if (!ParseHashStr(path[1], hash))
+        return RESTERR(req, HTTP_BAD_REQUEST, "Invalid hash: " + SanitizeString(path[1]));
+
+    const NodeContext* node = GetNodeContext(context, req);
+    if (!node) return false;
+    if (!node->llmq_ctx) {
+        return RESTERR(req, HTTP_INTERNAL_SERVER_ERROR, "LLMQ context not found");
+    }
+
+    CSimplifiedMNListDiff mn_list_diff;
+    std::string error;
+    {
+        LOCK(cs_main);
+        if (!BuildSimplifiedMNListDiff(base_hash, hash, mn_list_diff, *node->llmq_ctx->quorum_block_processor, error)) {
+            return RESTERR(req, HTTP_NOT_FOUND, error);
+        }
+    }
+
+    switch (rf) {
+    case RetFormat::BINARY: {
+        CDataStream ss_diff(SER_NETWORK, PROTOCOL_VERSION);
+        ss_diff << mn_list_diff;
+        req->WriteHeader("Content-Type", "application/octet-stream");
+        req->WriteReply(HTTP_OK, ss_diff.str());
+        return true;
+    }
+    case RetFormat::HEX: {
+        CDataStream ss_diff(SER_NETWORK, PROTOCOL_VERSION);
+        ss_diff << mn_list_diff;
+        req->WriteHeader("Content-Type", "text/plain");
+        req->WriteReply(HTTP_OK, HexStr(ss_diff) + "\n");
+        return true;
+    }
+    case RetFormat::JSON: {
+        req->WriteHeader("Content-Type", "application/json");
+        req->WriteReply(HTTP_OK, mn_list_diff.ToJson().write() + "\n");
+        return true;
+    }
+    default: {
+        return RESTERR(req, HTTP_NOT_FOUND, "output format not found (available: " + AvailableDataFormatsString() + ")");
+    }
+    }
+}
+
+static bool rest_address_utxos(const CoreContext& context, HTTPRequest* req, const std::string& strURIPart)
+{
+    if (!CheckWarmup(req))
+        return false;
+    std::string param;
+    const RetFormat rf = ParseDataFormat(param, strURIPart);
+
+    const CTxDestination dest = DecodeDestination(param);
+    const PKHash* pkhash = std::get_if<PKHash>(&dest);
+    const ScriptHash* script_hash = std::get_if<ScriptHash>(&dest);
+    if (!pkhash && !script_hash)
+        return RESTERR(req, HTTP_BAD_REQUEST, "Invalid address: " + SanitizeString(param));
+    const AddressType type = pkhash ? AddressType::P2PK_OR_P2PKH : AddressType::P2SH;
+    const uint160 address_bytes = pkhash ? uint160(*pkhash) : uint160(*script_hash);
+
+    if (g_address_index) {
+        g_address_index->BlockUntilSyncedToCurrentChain();
+    }
+
+    std::vector<std::pair<CAddressUnspentKey, CAddressUnspentValue>> unspent_outputs;
+    if (!GetAddressUnspent(address_bytes, type, unspent_outputs))
+        return RESTERR(req, HTTP_NOT_FOUND, "No information available for address, is -addressindex enabled?");
+    std::sort(unspent_outputs.begin(), unspent_outputs.end(), [](const auto& a, const auto& b) {
+        return a.second.m_block_height < b.second.m_block_height;
+    });
+
+    switch (rf) {
+    case RetFormat::BINARY: {
+        CDataStream ss_utxos(SER_NETWORK, PROTOCOL_VERSION);
+        ss_utxos << unspent_outputs;
+        req->WriteHeader("Content-Type", "application/octet-stream");
+        req->WriteReply(HTTP_OK, ss_utxos.str());
+        return true;
+    }
+    case RetFormat::HEX: {
+        CDataStream ss_utxos(SER_NETWORK, PROTOCOL_VERSION);
+        ss_utxos << unspent_outputs;
+        req->WriteHeader("Content-Type", "text/plain");
+        req->WriteReply(HTTP_OK, HexStr(ss_utxos) + "\n");
+        return true;
+    }
+    case RetFormat::JSON: {
+        UniValue utxos(UniValue::VARR);
+        for (const auto& [key, value] : unspent_outputs) {
+            UniValue utxo(UniValue::VOBJ);
+            utxo.pushKV("address", param);
+            utxo.pushKV("txid", key.m_tx_hash.GetHex());
+            utxo.pushKV("outputIndex", (int)key.m_tx_index);
+            utxo.pushKV("script", HexStr(value.m_tx_script));
+            utxo.pushKV("satoshis", value.m_amount);
+            utxo.pushKV("height", value.m_block_height);
+            utxos.push_back(std::move(utxo));
+        }
+        req->WriteHeader("Content-Type", "application/json");
+        req->WriteReply(HTTP_OK, utxos.write() + "\n");
+        return true;
+    }
+    default: {
+        return RESTERR(req, HTTP_NOT_FOUND, "output format not found (available: " + AvailableDataFormatsString() + ")");
+    }
+    }
+}
+
 static const struct {
     const char* prefix;
     bool (*handler)(const CoreContext& context, HTTPRequest* req, const std::string& strReq);
@@ -717,6 +843,8 @@ static const struct {
       {"/rest/headers/", rest_headers},
       {"/rest/getutxos", rest_getutxos},
       {"/rest/blockhashbyheight/", rest_blockhash_by_height},
+      {"/rest/mnlistdiff/", rest_mnlistdiff},
+      {"/rest/addressutxos/", rest_address_utxos},
 };
 
 void StartREST(const CoreContext& context)
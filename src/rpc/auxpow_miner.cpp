@@ -8,6 +8,7 @@
 #include <auxpow.h>
 #include <chainparams.h>
 #include <deploymentstatus.h>
+#include <hash.h>
 #include <node/context.h>
 #include <rpc/blockchain.h>
 #include <rpc/protocol.h>
@@ -111,7 +112,7 @@ const CBlock* AuxpowMiner::getCurrentBlock(const ChainstateManager& chainman,
 
         /* Save in our map of constructed blocks.  */
         pblockCur = &newBlock->block;
-        curBlocks.emplace(scriptID, pblockCur);
+        curBlocks.insert_or_assign (scriptID, pblockCur);
         blocks[pblockCur->GetHash()] = pblockCur;
         templates.push_back (std::move (newBlock));
       }
@@ -184,21 +185,55 @@ AuxpowMiner::submitAuxBlock (const JSONRPCRequest& request,
   const auto& node = EnsureAnyNodeContext (request.context);
   auto& chainman = EnsureChainman (node);
 
+  const std::vector<unsigned char> vchAuxPow = ParseHex (auxpowHex);
+  const uint256 submissionHash
+      = (CHashWriter (SER_GETHASH, 0) << hashHex << vchAuxPow).GetHash ();
+
   std::shared_ptr<CBlock> shared_block;
+  std::shared_future<bool> pending;
+  std::promise<bool> promise;
   {
     LOCK (cs);
     const CBlock* pblock = lookupSavedBlock (hashHex);
-    shared_block = std::make_shared<CBlock> (*pblock);
+    const auto iter = submissions.find (submissionHash);
+    if (iter != submissions.end ())
+      pending = iter->second;
+    else
+      {
+        shared_block = std::make_shared<CBlock> (*pblock);
+        submissions.emplace (submissionHash, promise.get_future ().share ());
+      }
   }
 
-  const std::vector<unsigned char> vchAuxPow = ParseHex (auxpowHex);
-  CDataStream ss(vchAuxPow, SER_GETHASH, PROTOCOL_VERSION);
-  std::unique_ptr<CAuxPow> pow(new CAuxPow());
-  ss >> *pow;
-  shared_block->SetAuxpow (std::move (pow));
-  assert (shared_block->GetHash().GetHex() == hashHex);
+  if (pending.valid ())
+    return pending.get ();
+
+  bool result;
+  try
+    {
+      CDataStream ss(vchAuxPow, SER_GETHASH, PROTOCOL_VERSION);
+      std::unique_ptr<CAuxPow> pow(new CAuxPow());
+      ss >> *pow;
+      shared_block->SetAuxpow (std::move (pow));
+      assert (shared_block->GetHash().GetHex() == hashHex);
+
+      /* Check the proof before queueing up for cs_main in ProcessNewBlock.
+         Invalid proofs are rejected here, on the RPC thread and in parallel
+         with other submissions; for valid ones the parent block's PoW hash
+         is in the cache afterwards.  */
+      result = CheckProofOfWork (*shared_block, Params ().GetConsensus ())
+                && chainman.ProcessNewBlock (Params(), shared_block, true, nullptr);
+    }
+  catch (...)
+    {
+      promise.set_exception (std::current_exception ());
+      WITH_LOCK (cs, submissions.erase (submissionHash));
+      throw;
+    }
 
-  return chainman.ProcessNewBlock (Params(), shared_block, true, nullptr);
+  promise.set_value (result);
+  WITH_LOCK (cs, submissions.erase (submissionHash));
+  return result;
 }
 
 AuxpowMiner&
@@ -5,6 +5,7 @@
 #ifndef MAXIMUS_RPC_AUXPOW_MINER_H
 #define MAXIMUS_RPC_AUXPOW_MINER_H
 
+#include <crypto/common.h>
 #include <miner.h>
 #include <rpc/request.h>
 #include <script/script.h>
@@ -13,10 +14,12 @@
 #include <txmempool.h>
 #include <uint256.h>
 #include <univalue.h>
+#include <util/hasher.h>
 
-#include <map>
+#include <future>
 #include <memory>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 class ChainstateManager;
@@ -40,14 +43,27 @@ class AuxpowMiner
 
 private:
 
+  /** Hasher for the coinbase script hashes in curBlocks.  */
+  struct ScriptIDHasher
+  {
+    size_t operator() (const CScriptID& id) const { return ReadLE64 (id.begin ()); }
+  };
+
   /** The lock used for state in this object.  */
   mutable RecursiveMutex cs;
   /** All currently "active" block templates.  */
   std::vector<std::unique_ptr<CBlockTemplate>> templates;
   /** Maps block hashes to pointers in vTemplates.  Does not own the memory.  */
-  std::map<uint256, const CBlock*> blocks;
+  std::unordered_map<uint256, const CBlock*, BlockHasher> blocks;
   /** Maps coinbase script hashes to pointers in vTemplates.  Does not own the memory.  */
-  std::map<CScriptID, const CBlock*> curBlocks;
+  std::unordered_map<CScriptID, const CBlock*, ScriptIDHasher> curBlocks;
+
+  /**
+   * Submissions currently being processed, keyed by the hash of the block
+   * hash and auxpow.  Identical submissions that come in meanwhile wait for
+   * the result instead of validating the same proof again.
+   */
+  mutable std::unordered_map<uint256, std::shared_future<bool>, BlockHasher> submissions GUARDED_BY (cs);
 
   /** The current extra nonce for block creation.  */
   unsigned extraNonce = 0;
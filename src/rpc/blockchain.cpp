@@ -16,17 +16,20 @@
 #include <consensus/validation.h>
 #include <deploymentinfo.h>
 #include <deploymentstatus.h>
+#include <index/addressindex.h>
 #include <index/blockfilterindex.h>
 #include <index/coinstatsindex.h>
 #include <index/txindex.h>
 #include <llmq/context.h>
 #include <node/blockstorage.h>
+#include <node/chainsnapshot.h>
 #include <node/coinstats.h>
 #include <node/context.h>
 #include <node/utxo_snapshot.h>
 #include <policy/feerate.h>
 #include <policy/fees.h>
 #include <policy/policy.h>
+#include <pow.h>
 #include <primitives/transaction.h>
 #include <rpc/server.h>
 #include <rpc/util.h>
@@ -134,6 +137,14 @@ LLMQContext& EnsureAnyLLMQContext(const CoreContext& context)
     return EnsureLLMQContext(EnsureAnyNodeContext(context));
 }
 
+void EnsureAddressIndexSynced()
+{
+    if (g_address_index && !g_address_index->BlockUntilSyncedToCurrentChain()) {
+        throw JSONRPCError(RPC_MISC_ERROR, strprintf("Unable to read the index because addressindex is still syncing. Current height: %d",
+                                                     g_address_index->GetSummary().best_block_height));
+    }
+}
+
 /* Calculate the difficulty for a given block index.
  */
 double GetDifficulty(const CBlockIndex* blockindex)
@@ -237,9 +248,9 @@ UniValue blockToJSON(const CBlock& block, const CBlockIndex* tip, const CBlockIn
 
     result.pushKV("hash", blockindex->GetBlockHash().GetHex());
     if (block.auxpow)
-        result.pushKV("pow_hash", block.auxpow->getParentBlockPoWHash().GetHex());
+        result.pushKV("pow_hash", GetPoWHashCached(block.auxpow->getParentBlock()).GetHex());
     else
-        result.pushKV("pow_hash", block.GetPoWHash().GetHex());
+        result.pushKV("pow_hash", GetPoWHashCached(block).GetHex());
     const CBlockIndex* pnext;
     int confirmations = ComputeNextBlockAndDepth(tip, blockindex, pnext);
     result.pushKV("confirmations", confirmations);
@@ -254,12 +265,12 @@ UniValue blockToJSON(const CBlock& block, const CBlockIndex* tip, const CBlockIn
             bool fLocked = isman.IsLocked(tx->GetHash());
             objTx.pushKV("instantlock", fLocked || result["chainlock"].get_bool());
             objTx.pushKV("instantlock_internal", fLocked);
-            txs.push_back(objTx);
+            txs.push_back(std::move(objTx));
         }
         else
             txs.push_back(tx->GetHash().GetHex());
     }
-    result.pushKV("tx", txs);
+    result.pushKV("tx", std::move(txs));
     if (!block.vtx[0]->vExtraPayload.empty()) {
         if (const auto opt_cbTx = GetTxPayload<CCbTx>(block.vtx[0]->vExtraPayload)) {
             result.pushKV("cbTx", opt_cbTx->ToJson());
@@ -284,8 +295,7 @@ static UniValue getblockcount(const JSONRPCRequest& request)
     }.Check(request);
 
     ChainstateManager& chainman = EnsureAnyChainman(request.context);
-    LOCK(cs_main);
-    return chainman.ActiveChain().Height();
+    return GetChainSnapshotTip(chainman)->nHeight;
 }
 
 UniValue AuxpowToJSON(const CAuxPow& auxpow, const bool verbose, const NodeContext& node, CChainState& active_chainstate)
@@ -345,8 +355,7 @@ static UniValue getbestblockhash(const JSONRPCRequest& request)
     }.Check(request);
 
     ChainstateManager& chainman = EnsureAnyChainman(request.context);
-    LOCK(cs_main);
-    return chainman.ActiveChain().Tip()->GetBlockHash().GetHex();
+    return GetChainSnapshotTip(chainman)->GetBlockHash().GetHex();
 }
 
 static UniValue getbestchainlock(const JSONRPCRequest& request)
@@ -550,8 +559,7 @@ static UniValue getdifficulty(const JSONRPCRequest& request)
     }.Check(request);
 
     ChainstateManager& chainman = EnsureAnyChainman(request.context);
-    LOCK(cs_main);
-    return GetDifficulty(chainman.ActiveChain().Tip());
+    return GetDifficulty(GetChainSnapshotTip(chainman));
 }
 
 static std::vector<RPCResult> MempoolEntryDescription() { return {
@@ -581,34 +589,85 @@ static std::vector<RPCResult> MempoolEntryDescription() { return {
     RPCResult{RPCResult::Type::BOOL, "unbroadcast", "Whether this transaction is currently unbroadcast (initial broadcast not yet acknowledged by any peers)"}
 };}
 
-static void entryToJSON(const CTxMemPool& pool, UniValue& info, const CTxMemPoolEntry& e, llmq::CInstantSendManager* isman) EXCLUSIVE_LOCKS_REQUIRED(pool.cs)
+/**
+ * Copy of the data of a mempool entry which the mempool RPCs report. These are taken while holding pool.cs and turned
+ * into JSON after releasing it, so that building large replies doesn't hold back transaction acceptance.
+ */
+struct MempoolEntrySnapshot {
+    uint256 txid;
+    CAmount fee;
+    CAmount modified_fee;
+    CAmount ancestor_fees;
+    CAmount descendant_fees;
+    size_t vsize;
+    int64_t time;
+    unsigned int height;
+    uint64_t descendant_count;
+    uint64_t descendant_size;
+    uint64_t ancestor_count;
+    uint64_t ancestor_size;
+    std::vector<uint256> depends;
+    std::vector<uint256> spent_by;
+    bool unbroadcast;
+};
+
+static MempoolEntrySnapshot SnapshotEntry(const CTxMemPool& pool, const CTxMemPoolEntry& e) EXCLUSIVE_LOCKS_REQUIRED(pool.cs)
 {
     AssertLockHeld(pool.cs);
 
+    MempoolEntrySnapshot snapshot;
+    const CTransaction& tx = e.GetTx();
+    snapshot.txid = tx.GetHash();
+    snapshot.fee = e.GetFee();
+    snapshot.modified_fee = e.GetModifiedFee();
+    snapshot.ancestor_fees = e.GetModFeesWithAncestors();
+    snapshot.descendant_fees = e.GetModFeesWithDescendants();
+    snapshot.vsize = e.GetTxSize();
+    snapshot.time = count_seconds(e.GetTime());
+    snapshot.height = e.GetHeight();
+    snapshot.descendant_count = e.GetCountWithDescendants();
+    snapshot.descendant_size = e.GetSizeWithDescendants();
+    snapshot.ancestor_count = e.GetCountWithAncestors();
+    snapshot.ancestor_size = e.GetSizeWithAncestors();
+    for (const CTxIn& txin : tx.vin) {
+        if (pool.exists(txin.prevout.hash)) {
+            snapshot.depends.push_back(txin.prevout.hash);
+        }
+    }
+    const CTxMemPool::txiter& it = pool.mapTx.find(snapshot.txid);
+    const CTxMemPool::setEntries& setChildren = pool.GetMemPoolChildren(it);
+    snapshot.spent_by.reserve(setChildren.size());
+    for (CTxMemPool::txiter childiter : setChildren) {
+        snapshot.spent_by.push_back(childiter->GetTx().GetHash());
+    }
+    snapshot.unbroadcast = pool.IsUnbroadcastTx(snapshot.txid);
+    return snapshot;
+}
+
+static void entryToJSON(UniValue& info, const MempoolEntrySnapshot& e, llmq::CInstantSendManager* isman)
+{
     UniValue fees(UniValue::VOBJ);
-    fees.pushKV("base", ValueFromAmount(e.GetFee()));
-    fees.pushKV("modified", ValueFromAmount(e.GetModifiedFee()));
-    fees.pushKV("ancestor", ValueFromAmount(e.GetModFeesWithAncestors()));
-    fees.pushKV("descendant", ValueFromAmount(e.GetModFeesWithDescendants()));
+    fees.pushKV("base", ValueFromAmount(e.fee));
+    fees.pushKV("modified", ValueFromAmount(e.modified_fee));
+    fees.pushKV("ancestor", ValueFromAmount(e.ancestor_fees));
+    fees.pushKV("descendant", ValueFromAmount(e.descendant_fees));
     info.pushKV("fees", fees);
 
-    info.pushKV("vsize", (int)e.GetTxSize());
-    info.pushKV("fee", ValueFromAmount(e.GetFee()));
-    info.pushKV("modifiedfee", ValueFromAmount(e.GetModifiedFee()));
-    info.pushKV("time", count_seconds(e.GetTime()));
-    info.pushKV("height", (int)e.GetHeight());
-    info.pushKV("descendantcount", e.GetCountWithDescendants());
-    info.pushKV("descendantsize", e.GetSizeWithDescendants());
-    info.pushKV("descendantfees", e.GetModFeesWithDescendants());
-    info.pushKV("ancestorcount", e.GetCountWithAncestors());
-    info.pushKV("ancestorsize", e.GetSizeWithAncestors());
-    info.pushKV("ancestorfees", e.GetModFeesWithAncestors());
-    const CTransaction& tx = e.GetTx();
+    info.pushKV("vsize", (int)e.vsize);
+    info.pushKV("fee", ValueFromAmount(e.fee));
+    info.pushKV("modifiedfee", ValueFromAmount(e.modified_fee));
+    info.pushKV("time", e.time);
+    info.pushKV("height", (int)e.height);
+    info.pushKV("descendantcount", e.descendant_count);
+    info.pushKV("descendantsize", e.descendant_size);
+    info.pushKV("descendantfees", e.descendant_fees);
+    info.pushKV("ancestorcount", e.ancestor_count);
+    info.pushKV("ancestorsize", e.ancestor_size);
+    info.pushKV("ancestorfees", e.ancestor_fees);
     std::set<std::string> setDepends;
-    for (const CTxIn& txin : tx.vin)
+    for (const uint256& dep : e.depends)
     {
-        if (pool.exists(txin.prevout.hash))
-            setDepends.insert(txin.prevout.hash.ToString());
+        setDepends.insert(dep.ToString());
     }
 
     UniValue depends(UniValue::VARR);
@@ -620,32 +679,42 @@ static void entryToJSON(const CTxMemPool& pool, UniValue& info, const CTxMemPool
     info.pushKV("depends", depends);
 
     UniValue spent(UniValue::VARR);
-    const CTxMemPool::txiter& it = pool.mapTx.find(tx.GetHash());
-    const CTxMemPool::setEntries& setChildren = pool.GetMemPoolChildren(it);
-    for (CTxMemPool::txiter childiter : setChildren) {
-        spent.push_back(childiter->GetTx().GetHash().ToString());
+    for (const uint256& child : e.spent_by) {
+        spent.push_back(child.ToString());
     }
 
     info.pushKV("spentby", spent);
-    info.pushKV("instantlock", isman ? (isman->IsLocked(tx.GetHash()) ? "true" : "false") : "unknown");
-    info.pushKV("unbroadcast", pool.IsUnbroadcastTx(tx.GetHash()));
+    info.pushKV("instantlock", isman ? (isman->IsLocked(e.txid) ? "true" : "false") : "unknown");
+    info.pushKV("unbroadcast", e.unbroadcast);
+}
+
+/** Turn snapshots into an object of entries keyed by txid, without holding any mempool lock */
+static UniValue SnapshotsToJSON(const std::vector<MempoolEntrySnapshot>& snapshots, llmq::CInstantSendManager* isman)
+{
+    UniValue o(UniValue::VOBJ);
+    for (const MempoolEntrySnapshot& e : snapshots) {
+        UniValue info(UniValue::VOBJ);
+        entryToJSON(info, e, isman);
+        // Mempool has unique entries so there is no advantage in using
+        // UniValue::pushKV, which checks if the key already exists in O(N).
+        // UniValue::__pushKV is used instead which currently is O(1).
+        o.__pushKV(e.txid.ToString(), std::move(info));
+    }
+    return o;
 }
 
 UniValue MempoolToJSON(const CTxMemPool& pool, llmq::CInstantSendManager* isman, bool verbose)
 {
     if (verbose) {
-        LOCK(pool.cs);
-        UniValue o(UniValue::VOBJ);
-        for (const CTxMemPoolEntry& e : pool.mapTx) {
-            const uint256& hash = e.GetTx().GetHash();
-            UniValue info(UniValue::VOBJ);
-            entryToJSON(pool, info, e, isman);
-            // Mempool has unique entries so there is no advantage in using
-            // UniValue::pushKV, which checks if the key already exists in O(N).
-            // UniValue::__pushKV is used instead which currently is O(1).
-            o.__pushKV(hash.ToString(), info);
+        std::vector<MempoolEntrySnapshot> snapshots;
+        {
+            LOCK(pool.cs);
+            snapshots.reserve(pool.mapTx.size());
+            for (const CTxMemPoolEntry& e : pool.mapTx) {
+                snapshots.push_back(SnapshotEntry(pool, e));
+            }
         }
-        return o;
+        return SnapshotsToJSON(snapshots, isman);
     } else {
         std::vector<uint256> vtxid;
         pool.queryHashes(vtxid);
@@ -727,35 +796,39 @@ static UniValue getmempoolancestors(const JSONRPCRequest& request)
     const NodeContext& node = EnsureAnyNodeContext(request.context);
 
     const CTxMemPool& mempool = EnsureMemPool(node);
-    LOCK(mempool.cs);
+    std::vector<uint256> txids;
+    std::vector<MempoolEntrySnapshot> snapshots;
+    {
+        LOCK(mempool.cs);
 
-    CTxMemPool::txiter it = mempool.mapTx.find(hash);
-    if (it == mempool.mapTx.end()) {
-        throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "Transaction not in mempool");
-    }
+        CTxMemPool::txiter it = mempool.mapTx.find(hash);
+        if (it == mempool.mapTx.end()) {
+            throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "Transaction not in mempool");
+        }
+
+        CTxMemPool::setEntries setAncestors;
+        uint64_t noLimit = std::numeric_limits<uint64_t>::max();
+        std::string dummy;
+        mempool.CalculateMemPoolAncestors(*it, setAncestors, noLimit, noLimit, noLimit, noLimit, dummy, false);
 
-    CTxMemPool::setEntries setAncestors;
-    uint64_t noLimit = std::numeric_limits<uint64_t>::max();
-    std::string dummy;
-    mempool.CalculateMemPoolAncestors(*it, setAncestors, noLimit, noLimit, noLimit, noLimit, dummy, false);
+        for (CTxMemPool::txiter ancestorIt : setAncestors) {
+            if (fVerbose) {
+                snapshots.push_back(SnapshotEntry(mempool, *ancestorIt));
+            } else {
+                txids.push_back(ancestorIt->GetTx().GetHash());
+            }
+        }
+    }
 
     if (!fVerbose) {
         UniValue o(UniValue::VARR);
-        for (CTxMemPool::txiter ancestorIt : setAncestors) {
-            o.push_back(ancestorIt->GetTx().GetHash().ToString());
+        for (const uint256& txid : txids) {
+            o.push_back(txid.ToString());
         }
         return o;
     } else {
-        UniValue o(UniValue::VOBJ);
         LLMQContext& llmq_ctx = EnsureLLMQContext(node);
-        for (CTxMemPool::txiter ancestorIt : setAncestors) {
-            const CTxMemPoolEntry &e = *ancestorIt;
-            const uint256& _hash = e.GetTx().GetHash();
-            UniValue info(UniValue::VOBJ);
-            entryToJSON(mempool, info, e, llmq_ctx.isman);
-            o.pushKV(_hash.ToString(), info);
-        }
-        return o;
+        return SnapshotsToJSON(snapshots, llmq_ctx.isman);
     }
 }
 
@@ -792,36 +865,40 @@ static UniValue getmempooldescendants(const JSONRPCRequest& request)
     const NodeContext& node = EnsureAnyNodeContext(request.context);
 
     const CTxMemPool& mempool = EnsureMemPool(node);
-    LOCK(mempool.cs);
+    std::vector<uint256> txids;
+    std::vector<MempoolEntrySnapshot> snapshots;
+    {
+        LOCK(mempool.cs);
 
-    CTxMemPool::txiter it = mempool.mapTx.find(hash);
-    if (it == mempool.mapTx.end()) {
-        throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "Transaction not in mempool");
-    }
+        CTxMemPool::txiter it = mempool.mapTx.find(hash);
+        if (it == mempool.mapTx.end()) {
+            throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "Transaction not in mempool");
+        }
 
-    CTxMemPool::setEntries setDescendants;
-    mempool.CalculateDescendants(it, setDescendants);
-    // CTxMemPool::CalculateDescendants will include the given tx
-    setDescendants.erase(it);
+        CTxMemPool::vecEntries descendants;
+        mempool.CalculateDescendants(it, descendants);
+        // CTxMemPool::CalculateDescendants will include the given tx, first
+        const CTxMemPool::setEntries setDescendants(descendants.begin() + 1, descendants.end());
+
+        for (CTxMemPool::txiter descendantIt : setDescendants) {
+            if (fVerbose) {
+                snapshots.push_back(SnapshotEntry(mempool, *descendantIt));
+            } else {
+                txids.push_back(descendantIt->GetTx().GetHash());
+            }
+        }
+    }
 
     if (!fVerbose) {
         UniValue o(UniValue::VARR);
-        for (CTxMemPool::txiter descendantIt : setDescendants) {
-            o.push_back(descendantIt->GetTx().GetHash().ToString());
+        for (const uint256& txid : txids) {
+            o.push_back(txid.ToString());
         }
 
         return o;
     } else {
-        UniValue o(UniValue::VOBJ);
         LLMQContext& llmq_ctx = EnsureLLMQContext(node);
-        for (CTxMemPool::txiter descendantIt : setDescendants) {
-            const CTxMemPoolEntry &e = *descendantIt;
-            const uint256& _hash = e.GetTx().GetHash();
-            UniValue info(UniValue::VOBJ);
-            entryToJSON(mempool, info, e, llmq_ctx.isman);
-            o.pushKV(_hash.ToString(), info);
-        }
-        return o;
+        return SnapshotsToJSON(snapshots, llmq_ctx.isman);
     }
 }
 
@@ -845,17 +922,19 @@ static UniValue getmempoolentry(const JSONRPCRequest& request)
     const NodeContext& node = EnsureAnyNodeContext(request.context);
 
     const CTxMemPool& mempool = EnsureMemPool(node);
-    LOCK(mempool.cs);
+    const MempoolEntrySnapshot snapshot = [&] {
+        LOCK(mempool.cs);
 
-    CTxMemPool::txiter it = mempool.mapTx.find(hash);
-    if (it == mempool.mapTx.end()) {
-        throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "Transaction not in mempool");
-    }
+        CTxMemPool::txiter it = mempool.mapTx.find(hash);
+        if (it == mempool.mapTx.end()) {
+            throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "Transaction not in mempool");
+        }
+        return SnapshotEntry(mempool, *it);
+    }();
 
-    const CTxMemPoolEntry &e = *it;
     UniValue info(UniValue::VOBJ);
     LLMQContext& llmq_ctx = EnsureLLMQContext(node);
-    entryToJSON(mempool, info, e, llmq_ctx.isman);
+    entryToJSON(info, snapshot, llmq_ctx.isman);
     return info;
 }
 
@@ -880,6 +959,8 @@ static UniValue getblockhashes(const JSONRPCRequest& request)
     unsigned int low = request.params[1].get_int();
     std::vector<uint256> blockHashes;
 
+    EnsureAddressIndexSynced();
+
     if (!GetTimestampIndex(high, low, blockHashes)) {
         throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "No information available for block hashes");
     }
@@ -2932,6 +3013,8 @@ UniValue dumptxoutset(const JSONRPCRequest& request)
                     {RPCResult::Type::NUM, "coins_written", "the number of coins written in the snapshot"},
                     {RPCResult::Type::STR_HEX, "base_hash", "the hash of the base of the snapshot"},
                     {RPCResult::Type::NUM, "base_height", "the height of the base of the snapshot"},
+                    {RPCResult::Type::NUM, "evodb_entries_written", "the number of evo database entries written in the snapshot"},
+                    {RPCResult::Type::STR_HEX, "evodb_hash", "the hash of the evo database entries"},
                     {RPCResult::Type::STR, "path", "the absolute path that the snapshot was written to"},
                 }
         },
@@ -2965,6 +3048,8 @@ UniValue dumptxoutset(const JSONRPCRequest& request)
 UniValue CreateUTXOSnapshot(NodeContext& node, CChainState& chainstate, CAutoFile& afile)
 {
     std::unique_ptr<CCoinsViewCursor> pcursor;
+    std::unique_ptr<CDBIterator> evo_cursor;
+    uint64_t evodb_count;
     CCoinsStats stats{CoinStatsHashType::NONE};
     CBlockIndex* tip;
 
@@ -2992,9 +3077,13 @@ UniValue CreateUTXOSnapshot(NodeContext& node, CChainState& chainstate, CAutoFil
         pcursor = chainstate.CoinsDB().Cursor();
         tip = chainstate.m_blockman.LookupBlockIndex(stats.hashBlock);
         CHECK_NONFATAL(tip);
+
+        // The evo database was committed by the same flush, its cursor is a snapshot as well
+        evo_cursor.reset(node.evodb->GetRawDB().NewIterator());
+        evodb_count = CEvoDB::CountSnapshotEntries(*evo_cursor);
     }
 
-    SnapshotMetadata metadata{tip->GetBlockHash(), stats.coins_count, tip->nChainTx};
+    SnapshotMetadata metadata{tip->GetBlockHash(), stats.coins_count, tip->nChainTx, evodb_count};
 
     afile << metadata;
 
@@ -3013,12 +3102,16 @@ UniValue CreateUTXOSnapshot(NodeContext& node, CChainState& chainstate, CAutoFil
         pcursor->Next();
     }
 
+    const uint256 evodb_hash = CEvoDB::DumpSnapshot(*evo_cursor, afile);
+
     afile.fclose();
 
     UniValue result(UniValue::VOBJ);
     result.pushKV("coins_written", stats.coins_count);
     result.pushKV("base_hash", tip->GetBlockHash().ToString());
     result.pushKV("base_height", tip->nHeight);
+    result.pushKV("evodb_entries_written", evodb_count);
+    result.pushKV("evodb_hash", evodb_hash.ToString());
 
     return result;
 }
@@ -66,6 +66,8 @@ CBlockPolicyEstimator& EnsureFeeEstimator(const NodeContext& node);
 CBlockPolicyEstimator& EnsureAnyFeeEstimator(const CoreContext& context);
 LLMQContext& EnsureLLMQContext(const NodeContext& node);
 LLMQContext& EnsureAnyLLMQContext(const CoreContext& context);
+/** Throw unless the address index, if enabled, caught up with the active chain */
+void EnsureAddressIndexSynced();
 
 /**
  * Helper to create UTXO snapshots given a chainstate and a file handle.
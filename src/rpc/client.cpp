@@ -172,6 +172,7 @@ static const CRPCConvertParam vRPCConvertParams[] =
     { "setwalletflag", 1, "value" },
     { "getmempoolancestors", 1, "verbose" },
     { "getmempooldescendants", 1, "verbose" },
+    { "getlockstats", 0, "reset" },
     { "logging", 0, "include" },
     { "logging", 1, "exclude" },
     { "sporkupdate", 1, "value" },
@@ -213,6 +214,7 @@ static const CRPCConvertParam vRPCConvertParams[] =
     { "unloadwallet", 1, "load_on_startup"},
     { "upgradetohd", 3, "rescan"},
     { "getnodeaddresses", 0, "count"},
+    { "getnetmsgstats", 0, "reset" },
     { "addpeeraddress", 1, "port"},
     { "stop", 0, "wait" },
 };
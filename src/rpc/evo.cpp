@@ -20,6 +20,7 @@
 #include <masternode/meta.h>
 #include <messagesigner.h>
 #include <netbase.h>
+#include <node/chainsnapshot.h>
 #include <node/context.h>
 #include <rpc/blockchain.h>
 #include <rpc/server.h>
@@ -614,7 +615,7 @@ static UniValue protx_register_common_wrapper(const JSONRPCRequest& request,
         EnsureWalletIsUnlocked(wallet.get());
     }
 
-    const bool isV19active{DeploymentActiveAfter(WITH_LOCK(cs_main, return chainman.ActiveChain().Tip();), Params().GetConsensus(), Consensus::DEPLOYMENT_V19)};
+    const bool isV19active{DeploymentActiveAfter(GetChainSnapshotTip(chainman), Params().GetConsensus(), Consensus::DEPLOYMENT_V19)};
     if (isEvoRequested && !isV19active) {
         throw JSONRPCError(RPC_INVALID_REQUEST, "EvoNodes aren't allowed yet");
     }
@@ -941,7 +942,7 @@ static UniValue protx_update_service_common_wrapper(const JSONRPCRequest& reques
 
     const NodeContext& node = EnsureAnyNodeContext(request.context);
 
-    const bool isV19active{DeploymentActiveAfter(WITH_LOCK(cs_main, return chainman.ActiveChain().Tip();), Params().GetConsensus(), Consensus::DEPLOYMENT_V19)};
+    const bool isV19active{DeploymentActiveAfter(GetChainSnapshotTip(chainman), Params().GetConsensus(), Consensus::DEPLOYMENT_V19)};
     const bool is_bls_legacy = !isV19active;
     if (isEvoRequested && !isV19active) {
         throw JSONRPCError(RPC_INVALID_REQUEST, "EvoNodes aren't allowed yet");
@@ -1086,7 +1087,7 @@ static UniValue protx_update_registrar_wrapper(const JSONRPCRequest& request, co
     ptx.keyIDVoting = dmn->pdmnState->keyIDVoting;
     ptx.scriptPayout = dmn->pdmnState->scriptPayout;
 
-    const bool isV19Active{DeploymentActiveAfter(WITH_LOCK(cs_main, return chainman.ActiveChain().Tip();), Params().GetConsensus(), Consensus::DEPLOYMENT_V19)};
+    const bool isV19Active{DeploymentActiveAfter(GetChainSnapshotTip(chainman), Params().GetConsensus(), Consensus::DEPLOYMENT_V19)};
     const bool use_legacy = isV19Active ? specific_legacy_bls_scheme : true;
 
     if (request.params[1].get_str() != "") {
@@ -1189,7 +1190,7 @@ static UniValue protx_revoke(const JSONRPCRequest& request, const ChainstateMana
 
     const NodeContext& node = EnsureAnyNodeContext(request.context);
 
-    const bool isV19active{DeploymentActiveAfter(WITH_LOCK(cs_main, return chainman.ActiveChain().Tip();), Params().GetConsensus(), Consensus::DEPLOYMENT_V19)};
+    const bool isV19active{DeploymentActiveAfter(GetChainSnapshotTip(chainman), Params().GetConsensus(), Consensus::DEPLOYMENT_V19)};
     const bool is_bls_legacy = !isV19active;
     CProUpRevTx ptx;
     ptx.nVersion = CProUpRevTx::GetVersion(isV19active);
@@ -1748,7 +1749,7 @@ static UniValue bls_generate(const JSONRPCRequest& request, const ChainstateMana
 
     CBLSSecretKey sk;
     sk.MakeNewKey();
-    bool bls_legacy_scheme{!DeploymentActiveAfter(WITH_LOCK(cs_main, return chainman.ActiveChain().Tip();), Params().GetConsensus(), Consensus::DEPLOYMENT_V19)};
+    bool bls_legacy_scheme{!DeploymentActiveAfter(GetChainSnapshotTip(chainman), Params().GetConsensus(), Consensus::DEPLOYMENT_V19)};
     if (!request.params[0].isNull()) {
         bls_legacy_scheme = ParseBoolV(request.params[0], "bls_legacy_scheme");
     }
@@ -1785,7 +1786,7 @@ static UniValue bls_fromsecret(const JSONRPCRequest& request, const ChainstateMa
 {
     bls_fromsecret_help(request);
 
-    bool bls_legacy_scheme{!DeploymentActiveAfter(WITH_LOCK(cs_main, return chainman.ActiveChain().Tip();), Params().GetConsensus(), Consensus::DEPLOYMENT_V19)};
+    bool bls_legacy_scheme{!DeploymentActiveAfter(GetChainSnapshotTip(chainman), Params().GetConsensus(), Consensus::DEPLOYMENT_V19)};
     if (!request.params[1].isNull()) {
         bls_legacy_scheme = ParseBoolV(request.params[1], "bls_legacy_scheme");
     }
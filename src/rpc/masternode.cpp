@@ -7,6 +7,7 @@
 #include <governance/classes.h>
 #include <index/txindex.h>
 #include <node/blockstorage.h>
+#include <node/chainsnapshot.h>
 #include <node/context.h>
 #include <governance/governance.h>
 #include <masternode/node.h>
@@ -108,7 +109,7 @@ static UniValue masternode_count(const JSONRPCRequest& request)
 
     const NodeContext& node = EnsureAnyNodeContext(request.context);
 
-    auto mnList = node.dmnman->GetListAtChainTip();
+    const auto& mnList = GetChainSnapshot(EnsureChainman(node), *node.dmnman)->mn_list;
     int total = mnList.GetAllMNsCount();
     int enabled = mnList.GetValidMNsCount();
 
@@ -339,12 +340,8 @@ static UniValue masternode_winners(const JSONRPCRequest& request, const Chainsta
 {
     masternode_winners_help(request);
 
-    const CBlockIndex* pindexTip{nullptr};
-    {
-        LOCK(cs_main);
-        pindexTip = chainman.ActiveChain().Tip();
-        if (!pindexTip) return NullUniValue;
-    }
+    const CBlockIndex* pindexTip = GetChainSnapshotTip(chainman);
+    if (!pindexTip) return NullUniValue;
 
     int nCount = 10;
     std::string strFilter = "";
@@ -604,7 +601,8 @@ static UniValue masternodelist(const JSONRPCRequest& request, ChainstateManager&
 
     UniValue obj(UniValue::VOBJ);
 
-    auto mnList = node.dmnman->GetListAtChainTip();
+    const ChainSnapshotRef snapshot = GetChainSnapshot(chainman, *node.dmnman);
+    const auto& mnList = snapshot->mn_list;
     auto dmnToStatus = [&](auto& dmn) {
         if (mnList.IsMNValid(dmn)) {
             return "ENABLED";
@@ -619,14 +617,13 @@ static UniValue masternodelist(const JSONRPCRequest& request, ChainstateManager&
             return (int)0;
         }
 
-        LOCK(cs_main);
-        const CBlockIndex* pindex = chainman.ActiveChain()[dmn.pdmnState->nLastPaidHeight];
+        const CBlockIndex* pindex = snapshot->tip->GetAncestor(dmn.pdmnState->nLastPaidHeight);
         return (int)pindex->nTime;
     };
 
     bool showRecentMnsOnly = strMode == "recent";
     bool showEvoOnly = strMode == "evo";
-    int tipHeight = WITH_LOCK(cs_main, return chainman.ActiveChain().Tip()->nHeight);
+    int tipHeight = snapshot->tip->nHeight;
     mnList.ForEachMN(false, [&](auto& dmn) {
         if (showRecentMnsOnly && mnList.IsMNPoSeBanned(dmn)) {
             if (tipHeight - dmn.pdmnState->GetBannedHeight() > Params().GetConsensus().nSuperblockCycle) {
@@ -7,9 +7,11 @@
 #include <addressindex.h>
 #include <chainparams.h>
 #include <consensus/consensus.h>
+#include <dbwrapper.h>
 #include <deploymentstatus.h>
 #include <evo/mnauth.h>
 #include <httpserver.h>
+#include <index/addressindex.h>
 #include <index/blockfilterindex.h>
 #include <index/coinstatsindex.h>
 #include <index/txindex.h>
@@ -18,6 +20,7 @@
 #include <key_io.h>
 #include <net.h>
 #include <node/context.h>
+#include <node/memoryusage.h>
 #include <rpc/blockchain.h>
 #include <rpc/server.h>
 #include <rpc/util.h>
@@ -33,7 +36,9 @@
 #include <masternode/sync.h>
 #include <spork.h>
 
+#include <optional>
 #include <stdint.h>
+
 #ifdef HAVE_MALLOC_INFO
 #include <malloc.h>
 #endif
@@ -779,6 +784,8 @@ static UniValue getaddressutxos(const JSONRPCRequest& request)
         throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "Invalid address");
     }
 
+    EnsureAddressIndexSynced();
+
     std::vector<std::pair<CAddressUnspentKey, CAddressUnspentValue> > unspentOutputs;
 
     for (const auto& address : addresses) {
@@ -810,10 +817,47 @@ static UniValue getaddressutxos(const JSONRPCRequest& request)
     return result;
 }
 
+/** Parse the optional "limit" and "cursor" of a paginated address index query. */
+static void getPaginationFromParams(const UniValue& params, int& limit, std::optional<CAddressIndexKey>& cursor)
+{
+    limit = 0;
+    cursor.reset();
+    if (!params[0].isObject()) return;
+
+    const UniValue& limitValue = find_value(params[0].get_obj(), "limit");
+    if (!limitValue.isNull()) {
+        limit = limitValue.get_int();
+        if (limit <= 0) {
+            throw JSONRPCError(RPC_INVALID_PARAMETER, "Limit is expected to be positive");
+        }
+    }
+
+    const UniValue& cursorValue = find_value(params[0].get_obj(), "cursor");
+    if (!cursorValue.isNull()) {
+        const std::string& hex = cursorValue.get_str();
+        CAddressIndexKey key;
+        if (!IsHex(hex) || hex.size() != 2 * key.GetSerializeSize(SER_DISK, CLIENT_VERSION)) {
+            throw JSONRPCError(RPC_INVALID_PARAMETER, "Invalid cursor");
+        }
+        CDataStream ssKey(ParseHex(hex), SER_DISK, CLIENT_VERSION);
+        ssKey >> key;
+        cursor = key;
+    }
+}
+
+static std::string cursorToHex(const CAddressIndexKey& key)
+{
+    CDataStream ssKey(SER_DISK, CLIENT_VERSION);
+    ssKey << key;
+    return HexStr(ssKey);
+}
+
 static UniValue getaddressdeltas(const JSONRPCRequest& request)
 {
     RPCHelpMan{"getaddressdeltas",
-        "\nReturns all changes for an address (requires addressindex to be enabled).\n",
+        "\nReturns all changes for an address (requires addressindex to be enabled).\n"
+        "The request object may also hold \"start\" and \"end\" block heights, \"limit\" and \"cursor\".\n"
+        "With \"limit\" at most that many deltas are returned, together with a \"cursor\" to pass in to fetch the next page.\n",
         {
             {"addresses", RPCArg::Type::ARR, /* default */ "", "",
                 {
@@ -821,21 +865,30 @@ static UniValue getaddressdeltas(const JSONRPCRequest& request)
                 },
             },
         },
-        RPCResult{
-            RPCResult::Type::ARR, "", "",
-            {
-                {RPCResult::Type::OBJ, "", "",
+        RPCResults{
+            RPCResult{"if limit is not set",
+                RPCResult::Type::ARR, "", "",
                 {
-                    {RPCResult::Type::NUM, "satoshis", "The difference of muffs"},
-                    {RPCResult::Type::STR_HEX, "txid", "The related txid"},
-                    {RPCResult::Type::NUM, "index", "The related input or output index"},
-                    {RPCResult::Type::NUM, "blockindex", "The related block index"},
-                    {RPCResult::Type::NUM, "height", "The block height"},
-                    {RPCResult::Type::STR, "address", "The base58check encoded address"},
+                    {RPCResult::Type::OBJ, "", "",
+                    {
+                        {RPCResult::Type::NUM, "satoshis", "The difference of muffs"},
+                        {RPCResult::Type::STR_HEX, "txid", "The related txid"},
+                        {RPCResult::Type::NUM, "index", "The related input or output index"},
+                        {RPCResult::Type::NUM, "blockindex", "The related block index"},
+                        {RPCResult::Type::NUM, "height", "The block height"},
+                        {RPCResult::Type::STR, "address", "The base58check encoded address"},
+                    }},
                 }},
-            }},
+            RPCResult{"if limit is set",
+                RPCResult::Type::OBJ, "", "",
+                {
+                    {RPCResult::Type::ARR, "deltas", "The deltas, as above", {{RPCResult::Type::ELISION, "", ""}}},
+                    {RPCResult::Type::STR_HEX, "cursor", /* optional */ true, "The cursor of the next page (only present if there are more deltas)"},
+                }},
+        },
         RPCExamples{
             HelpExampleCli("getaddressdeltas", "'{\"addresses\": [\"" + EXAMPLE_ADDRESS[0] + "\"]}'")
+    + HelpExampleCli("getaddressdeltas", "'{\"addresses\": [\"" + EXAMPLE_ADDRESS[0] + "\"], \"limit\": 1000}'")
     + HelpExampleRpc("getaddressdeltas", "{\"addresses\": [\"" + EXAMPLE_ADDRESS[0] + "\"]}")
         },
     }.Check(request);
@@ -854,6 +907,13 @@ static UniValue getaddressdeltas(const JSONRPCRequest& request)
             throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "End value is expected to be greater than start");
         }
     }
+    if (start <= 0 || end <= 0) {
+        start = end = 0;
+    }
+
+    int limit;
+    std::optional<CAddressIndexKey> cursor;
+    getPaginationFromParams(request.params, limit, cursor);
 
     std::vector<std::pair<uint160, AddressType> > addresses;
 
@@ -861,38 +921,60 @@ static UniValue getaddressdeltas(const JSONRPCRequest& request)
         throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "Invalid address");
     }
 
-    std::vector<std::pair<CAddressIndexKey, CAmount> > addressIndex;
+    EnsureAddressIndexSynced();
 
-    for (const auto& address : addresses) {
-        if (start > 0 && end > 0) {
-            if (!GetAddressIndex(address.first, address.second, addressIndex, start, end)) {
-                throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "No information available for address");
-            }
-        } else {
-            if (!GetAddressIndex(address.first, address.second, addressIndex)) {
-                throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "No information available for address");
-            }
-        }
-    }
+    UniValue deltas(UniValue::VARR);
+    std::optional<CAddressIndexKey> next;
+    // A cursor points into one of the addresses, the ones before it were finished on earlier pages
+    bool reached_cursor = !cursor.has_value();
 
-    UniValue result(UniValue::VARR);
+    for (const auto& [addressHash, addressType] : addresses) {
+        const CAddressIndexKey* from = nullptr;
+        if (!reached_cursor) {
+            if (cursor->m_address_type != addressType || cursor->m_address_bytes != addressHash) continue;
+            reached_cursor = true;
+            from = &*cursor;
+        }
 
-    for (const auto& [indexKey, indexDelta] : addressIndex) {
         std::string address;
-        if (!getAddressFromIndex(indexKey.m_address_type, indexKey.m_address_bytes, address)) {
+        if (!getAddressFromIndex(addressType, addressHash, address)) {
             throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "Unknown address type");
         }
 
-        UniValue delta(UniValue::VOBJ);
-        delta.pushKV("satoshis", indexDelta);
-        delta.pushKV("txid", indexKey.m_tx_hash.GetHex());
-        delta.pushKV("index", (int)indexKey.m_tx_index);
-        delta.pushKV("blockindex", (int)indexKey.m_block_tx_pos);
-        delta.pushKV("height", indexKey.m_block_height);
-        delta.pushKV("address", address);
-        result.push_back(delta);
+        const auto push_delta = [&](const CAddressIndexKey& indexKey, CAmount indexDelta) {
+            if (limit > 0 && (int)deltas.size() >= limit) {
+                next = indexKey;
+                return false;
+            }
+            UniValue delta(UniValue::VOBJ);
+            delta.pushKV("satoshis", indexDelta);
+            delta.pushKV("txid", indexKey.m_tx_hash.GetHex());
+            delta.pushKV("index", (int)indexKey.m_tx_index);
+            delta.pushKV("blockindex", (int)indexKey.m_block_tx_pos);
+            delta.pushKV("height", indexKey.m_block_height);
+            delta.pushKV("address", address);
+            deltas.push_back(delta);
+            return true;
+        };
+        if (!ScanAddressIndex(addressHash, addressType, start, end, from, push_delta)) {
+            throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "No information available for address");
+        }
+        if (next) break;
+    }
+
+    if (!reached_cursor) {
+        throw JSONRPCError(RPC_INVALID_PARAMETER, "Invalid cursor");
+    }
+
+    if (limit == 0) {
+        return deltas;
     }
 
+    UniValue result(UniValue::VOBJ);
+    result.pushKV("deltas", deltas);
+    if (next) {
+        result.pushKV("cursor", cursorToHex(*next));
+    }
     return result;
 }
 
@@ -927,38 +1009,39 @@ static UniValue getaddressbalance(const JSONRPCRequest& request)
         throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "Invalid address");
     }
 
-    std::vector<std::pair<CAddressIndexKey, CAmount> > addressIndex;
-
-    for (const auto& address : addresses) {
-        if (!GetAddressIndex(address.first, address.second, addressIndex)) {
-            throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "No information available for address");
-        }
-    }
+    EnsureAddressIndexSynced();
 
     ChainstateManager& chainman = EnsureAnyChainman(request.context);
     int nHeight = WITH_LOCK(cs_main, return chainman.ActiveChain().Height());
 
     CAmount balance = 0;
-    CAmount balance_spendable = 0;
     CAmount balance_immature = 0;
     CAmount received = 0;
 
-    for (const auto& [indexKey, indexDelta] : addressIndex) {
-        if (indexDelta > 0) {
-            received += indexDelta;
-        }
-        if (indexKey.m_block_tx_pos == 0 && nHeight - indexKey.m_block_height < COINBASE_MATURITY) {
+    // The totals are kept up to date by the index, only coinbase outputs of the last
+    // COINBASE_MATURITY blocks need to be looked at for the immature part.
+    const int immature_start = std::max(1, nHeight - COINBASE_MATURITY + 1);
+    const auto add_immature = [&](const CAddressIndexKey& indexKey, CAmount indexDelta) {
+        if (indexKey.m_block_tx_pos == 0) {
             balance_immature += indexDelta;
-        } else {
-            balance_spendable += indexDelta;
         }
-        balance += indexDelta;
+        return true;
+    };
+
+    for (const auto& [addressHash, addressType] : addresses) {
+        CAddressBalanceValue value;
+        if (!GetAddressBalance(addressHash, addressType, value) ||
+            !ScanAddressIndex(addressHash, addressType, immature_start, 0, nullptr, add_immature)) {
+            throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "No information available for address");
+        }
+        balance += value.m_balance;
+        received += value.m_received;
     }
 
     UniValue result(UniValue::VOBJ);
     result.pushKV("balance", balance);
     result.pushKV("balance_immature", balance_immature);
-    result.pushKV("balance_spendable", balance_spendable);
+    result.pushKV("balance_spendable", balance - balance_immature);
     result.pushKV("received", received);
 
     return result;
@@ -968,7 +1051,9 @@ static UniValue getaddressbalance(const JSONRPCRequest& request)
 static UniValue getaddresstxids(const JSONRPCRequest& request)
 {
     RPCHelpMan{"getaddresstxids",
-        "\nReturns the txids for an address(es) (requires addressindex to be enabled).\n",
+        "\nReturns the txids for an address(es) (requires addressindex to be enabled).\n"
+        "The request object may also hold \"start\" and \"end\" block heights, \"limit\" and \"cursor\".\n"
+        "With \"limit\" at most that many txids of a single address are returned, together with a \"cursor\" to pass in to fetch the next page.\n",
         {
             {"addresses", RPCArg::Type::ARR, /* default */ "", "",
                 {
@@ -976,12 +1061,21 @@ static UniValue getaddresstxids(const JSONRPCRequest& request)
                 },
             },
         },
-        RPCResult{
-            RPCResult::Type::ARR, "", "",
-            {{RPCResult::Type::STR_HEX, "transactionid", "The transaction id"}}
+        RPCResults{
+            RPCResult{"if limit is not set",
+                RPCResult::Type::ARR, "", "",
+                {{RPCResult::Type::STR_HEX, "transactionid", "The transaction id"}}
+            },
+            RPCResult{"if limit is set",
+                RPCResult::Type::OBJ, "", "",
+                {
+                    {RPCResult::Type::ARR, "txids", "", {{RPCResult::Type::STR_HEX, "transactionid", "The transaction id"}}},
+                    {RPCResult::Type::STR_HEX, "cursor", /* optional */ true, "The cursor of the next page (only present if there are more txids)"},
+                }},
         },
         RPCExamples{
             HelpExampleCli("getaddresstxids", "'{\"addresses\": [\"" + EXAMPLE_ADDRESS[0] + "\"]}'")
+    + HelpExampleCli("getaddresstxids", "'{\"addresses\": [\"" + EXAMPLE_ADDRESS[0] + "\"], \"limit\": 1000}'")
     + HelpExampleRpc("getaddresstxids", "{\"addresses\": [\"" + EXAMPLE_ADDRESS[0] + "\"]}")
         },
     }.Check(request);
@@ -1002,34 +1096,46 @@ static UniValue getaddresstxids(const JSONRPCRequest& request)
             end = endValue.get_int();
         }
     }
+    if (start <= 0 || end <= 0) {
+        start = end = 0;
+    }
 
-    std::vector<std::pair<CAddressIndexKey, CAmount> > addressIndex;
-
-    for (const auto& address : addresses) {
-        if (start > 0 && end > 0) {
-            if (!GetAddressIndex(address.first, address.second, addressIndex, start, end)) {
-                throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "No information available for address");
-            }
-        } else {
-            if (!GetAddressIndex(address.first, address.second, addressIndex)) {
-                throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "No information available for address");
-            }
-        }
+    int limit;
+    std::optional<CAddressIndexKey> cursor;
+    getPaginationFromParams(request.params, limit, cursor);
+    if ((limit > 0 || cursor) && addresses.size() != 1) {
+        throw JSONRPCError(RPC_INVALID_PARAMETER, "Pagination is only supported for a single address");
+    }
+    if (cursor && (cursor->m_address_type != addresses[0].second || cursor->m_address_bytes != addresses[0].first)) {
+        throw JSONRPCError(RPC_INVALID_PARAMETER, "Invalid cursor");
     }
 
+    EnsureAddressIndexSynced();
+
     std::set<std::pair<int, std::string> > txids;
     UniValue result(UniValue::VARR);
+    std::optional<CAddressIndexKey> next;
+    // The entries of a transaction are adjacent in the index of a single address
+    uint256 last_txid;
 
-    for (const auto& [indexKey, _]: addressIndex) {
-        int height = indexKey.m_block_height;
-        std::string txid = indexKey.m_tx_hash.GetHex();
-
+    const auto push_txid = [&](const CAddressIndexKey& indexKey, CAmount) {
         if (addresses.size() > 1) {
-            txids.insert(std::make_pair(height, txid));
-        } else {
-            if (txids.insert(std::make_pair(height, txid)).second) {
-                result.push_back(txid);
-            }
+            txids.insert(std::make_pair(indexKey.m_block_height, indexKey.m_tx_hash.GetHex()));
+            return true;
+        }
+        if (!result.empty() && indexKey.m_tx_hash == last_txid) return true;
+        if (limit > 0 && (int)result.size() >= limit) {
+            next = indexKey;
+            return false;
+        }
+        last_txid = indexKey.m_tx_hash;
+        result.push_back(last_txid.GetHex());
+        return true;
+    };
+
+    for (const auto& [addressHash, addressType] : addresses) {
+        if (!ScanAddressIndex(addressHash, addressType, start, end, cursor ? &*cursor : nullptr, push_txid)) {
+            throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "No information available for address");
         }
     }
 
@@ -1039,7 +1145,16 @@ static UniValue getaddresstxids(const JSONRPCRequest& request)
         }
     }
 
-    return result;
+    if (limit == 0) {
+        return result;
+    }
+
+    UniValue page(UniValue::VOBJ);
+    page.pushKV("txids", result);
+    if (next) {
+        page.pushKV("cursor", cursorToHex(*next));
+    }
+    return page;
 
 }
 
@@ -1080,6 +1195,8 @@ static UniValue getspentinfo(const JSONRPCRequest& request)
     CSpentIndexKey key(txid, outputIndex);
     CSpentIndexValue value;
 
+    EnsureAddressIndexSynced();
+
     CTxMemPool& mempool = EnsureAnyMemPool(request.context);
     if (!GetSpentIndex(mempool, key, value)) {
         throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "Unable to get spent info");
@@ -1181,6 +1298,10 @@ static UniValue getmemoryinfo(const JSONRPCRequest& request)
                         {RPCResult::Type::NUM, "chunks_used", "Number allocated chunks"},
                         {RPCResult::Type::NUM, "chunks_free", "Number unused chunks"},
                     }},
+                    {RPCResult::Type::OBJ_DYN, "subsystems", "Estimated heap usage of the major in-memory structures of the node",
+                    {
+                        {RPCResult::Type::NUM, "name", "Number of bytes used by this subsystem (mempool, masternodeLists, quorums, sigShares, instantSend, governance, masternodeMeta, addrman, peerBuffers)"},
+                    }},
                 }
             },
             RPCResult{"mode \"mallocinfo\"",
@@ -1197,6 +1318,11 @@ static UniValue getmemoryinfo(const JSONRPCRequest& request)
     if (mode == "stats") {
         UniValue obj(UniValue::VOBJ);
         obj.pushKV("locked", RPCLockedMemoryInfo());
+        UniValue subsystems(UniValue::VOBJ);
+        for (const auto& [name, usage] : GetSubsystemMemoryUsage(EnsureAnyNodeContext(request.context))) {
+            subsystems.pushKV(name, (uint64_t)usage);
+        }
+        obj.pushKV("subsystems", subsystems);
         return obj;
     } else if (mode == "mallocinfo") {
 #ifdef HAVE_MALLOC_INFO
@@ -1209,6 +1335,186 @@ static UniValue getmemoryinfo(const JSONRPCRequest& request)
     }
 }
 
+static UniValue getdbstats(const JSONRPCRequest& request)
+{
+    RPCHelpMan{"getdbstats",
+        "Returns the LevelDB tuning and block cache statistics of the open databases.\n",
+        {},
+        RPCResult{
+            RPCResult::Type::ARR, "", "",
+            {
+                {RPCResult::Type::OBJ, "", "",
+                {
+                    {RPCResult::Type::STR, "name", "Name of the database"},
+                    {RPCResult::Type::BOOL, "shared_cache", "Whether the database uses the block cache shared with other databases"},
+                    {RPCResult::Type::NUM, "bloom_bits", "Bits per key of the bloom filter, 0 if disabled"},
+                    {RPCResult::Type::NUM, "write_buffer_size", "Size of the write buffer in bytes"},
+                    {RPCResult::Type::NUM, "cache_size", "Capacity of the block cache in bytes"},
+                    {RPCResult::Type::NUM, "cache_usage", "Bytes currently held by the block cache"},
+                    {RPCResult::Type::NUM, "cache_hits", "Block cache lookups of this database which found the block"},
+                    {RPCResult::Type::NUM, "cache_misses", "Block cache lookups of this database which had to read the block"},
+                    {RPCResult::Type::NUM, "hit_rate", "Share of the lookups which were hits"},
+                    {RPCResult::Type::NUM, "memory_usage", "Approximate memory usage reported by LevelDB in bytes"},
+                    {RPCResult::Type::BOOL, "own_compaction_thread", "Whether the database compacts on a thread of its own"},
+                    {RPCResult::Type::NUM, "level0_files", "Level 0 files waiting for compaction"},
+                    {RPCResult::Type::NUM, "write_slowdowns", "Writes delayed because of too many level 0 files"},
+                    {RPCResult::Type::NUM, "write_stops", "Writes stopped until compaction caught up"},
+                    {RPCResult::Type::NUM, "write_stall_ms", "Time taken by the delayed and stopped writes in milliseconds"},
+                    {RPCResult::Type::NUM, "compaction_seconds", "Time spent compacting since the database was opened"},
+                    {RPCResult::Type::NUM, "compaction_read_mib", "Data read by compactions in MiB"},
+                    {RPCResult::Type::NUM, "compaction_write_mib", "Data written by compactions in MiB"},
+                }},
+            }
+        },
+        RPCExamples{
+            HelpExampleCli("getdbstats", "")
+    + HelpExampleRpc("getdbstats", "")
+        },
+    }.Check(request);
+
+    UniValue ret(UniValue::VARR);
+    for (const DBStats& stats : GetDBStats()) {
+        UniValue obj(UniValue::VOBJ);
+        obj.pushKV("name", stats.name);
+        obj.pushKV("shared_cache", stats.shared_cache);
+        obj.pushKV("bloom_bits", stats.bloom_bits);
+        obj.pushKV("write_buffer_size", (uint64_t)stats.write_buffer_size);
+        obj.pushKV("cache_size", (uint64_t)stats.cache_size);
+        obj.pushKV("cache_usage", (uint64_t)stats.cache_usage);
+        obj.pushKV("cache_hits", stats.cache_hits);
+        obj.pushKV("cache_misses", stats.cache_misses);
+        const uint64_t lookups = stats.cache_hits + stats.cache_misses;
+        obj.pushKV("hit_rate", lookups ? (double)stats.cache_hits / lookups : 0.0);
+        obj.pushKV("memory_usage", (uint64_t)stats.memory_usage);
+        obj.pushKV("own_compaction_thread", stats.own_compaction_thread);
+        obj.pushKV("level0_files", stats.level0_files);
+        obj.pushKV("write_slowdowns", stats.write_slowdowns);
+        obj.pushKV("write_stops", stats.write_stops);
+        obj.pushKV("write_stall_ms", stats.write_stall_us / 1000.0);
+        obj.pushKV("compaction_seconds", stats.compaction_seconds);
+        obj.pushKV("compaction_read_mib", stats.compaction_read_mib);
+        obj.pushKV("compaction_write_mib", stats.compaction_write_mib);
+        ret.push_back(obj);
+    }
+    return ret;
+}
+
+static UniValue LockStatsToJSON(const LockSiteStats& stats)
+{
+    UniValue obj(UniValue::VOBJ);
+    obj.pushKV("acquisitions", stats.samples * LOCK_STATS_SAMPLE_RATE + stats.contentions);
+    obj.pushKV("contentions", stats.contentions);
+    obj.pushKV("wait_us", stats.wait_us);
+    obj.pushKV("max_wait_us", stats.max_wait_us);
+    obj.pushKV("avg_hold_us", stats.holds ? (double)stats.hold_us / stats.holds : 0.0);
+    return obj;
+}
+
+static UniValue LockHistogramToJSON(const std::array<uint64_t, LOCK_STATS_HISTOGRAM_BUCKETS>& histogram)
+{
+    UniValue arr(UniValue::VARR);
+    for (const uint64_t count : histogram) {
+        arr.push_back(count);
+    }
+    return arr;
+}
+
+static UniValue getlockstats(const JSONRPCRequest& request)
+{
+    RPCHelpMan{"getlockstats",
+        "Returns the lock contention profile collected since startup or the last reset, per lock and call site.\n"
+        "Profiling has to be enabled with -lockstats. One in " + ToString(LOCK_STATS_SAMPLE_RATE) + " uncontended acquisitions is sampled,\n"
+        "so acquisition counts and hold times are estimates. Hold times of locks waited on with a condition\n"
+        "variable include the time spent waiting.\n"
+        "Histogram bucket i counts waits or holds shorter than 2^(i+1) microseconds, the last bucket is open-ended.\n",
+        {
+            {"reset", RPCArg::Type::BOOL, /* default */ "false", "Clear the counters after reading them"},
+        },
+        RPCResult{
+            RPCResult::Type::OBJ, "", "",
+            {
+                {RPCResult::Type::BOOL, "enabled", "Whether lock profiling is running"},
+                {RPCResult::Type::ARR, "locks", "Locks ordered by total wait time",
+                {
+                    {RPCResult::Type::OBJ, "", "",
+                    {
+                        {RPCResult::Type::STR, "lock", "Lock expression as passed to LOCK()"},
+                        {RPCResult::Type::NUM, "acquisitions", "Estimated number of acquisitions"},
+                        {RPCResult::Type::NUM, "contentions", "Acquisitions which had to wait"},
+                        {RPCResult::Type::NUM, "wait_us", "Total time spent waiting in microseconds"},
+                        {RPCResult::Type::NUM, "max_wait_us", "Longest single wait in microseconds"},
+                        {RPCResult::Type::NUM, "avg_hold_us", "Average time the lock was held in microseconds"},
+                        {RPCResult::Type::ARR, "wait_histogram", "Wait times", {{RPCResult::Type::NUM, "", "Count"}}},
+                        {RPCResult::Type::ARR, "hold_histogram", "Hold times", {{RPCResult::Type::NUM, "", "Count"}}},
+                        {RPCResult::Type::ARR, "sites", "Call sites ordered by total wait time",
+                        {
+                            {RPCResult::Type::OBJ, "", "",
+                            {
+                                {RPCResult::Type::STR, "location", "Source file and line"},
+                                {RPCResult::Type::NUM, "acquisitions", "Estimated number of acquisitions"},
+                                {RPCResult::Type::NUM, "contentions", "Acquisitions which had to wait"},
+                                {RPCResult::Type::NUM, "wait_us", "Total time spent waiting in microseconds"},
+                                {RPCResult::Type::NUM, "max_wait_us", "Longest single wait in microseconds"},
+                                {RPCResult::Type::NUM, "avg_hold_us", "Average time the lock was held in microseconds"},
+                            }},
+                        }},
+                    }},
+                }},
+            }
+        },
+        RPCExamples{
+            HelpExampleCli("getlockstats", "")
+    + HelpExampleCli("getlockstats", "true")
+    + HelpExampleRpc("getlockstats", "")
+        },
+    }.Check(request);
+
+    const bool reset = !request.params[0].isNull() && request.params[0].get_bool();
+
+    // The same header can be compiled into several units, so merge sites by their printed location
+    std::map<std::string, std::map<std::string, LockSiteStats>> by_lock;
+    for (const LockSiteStats& site : GetLockStats()) {
+        MergeLockStats(by_lock[site.lock_name][strprintf("%s:%d", site.file, site.line)], site);
+    }
+    if (reset) ResetLockStats();
+
+    std::vector<std::pair<LockSiteStats, UniValue>> locks;
+    for (const auto& [lock_name, sites] : by_lock) {
+        LockSiteStats total;
+        std::vector<std::pair<uint64_t, UniValue>> site_objs;
+        for (const auto& [location, site] : sites) {
+            MergeLockStats(total, site);
+            UniValue site_obj(UniValue::VOBJ);
+            site_obj.pushKV("location", location);
+            site_obj.pushKVs(LockStatsToJSON(site));
+            site_objs.emplace_back(site.wait_us, site_obj);
+        }
+        std::stable_sort(site_objs.begin(), site_objs.end(), [](const auto& a, const auto& b) { return a.first > b.first; });
+
+        UniValue obj(UniValue::VOBJ);
+        obj.pushKV("lock", lock_name);
+        obj.pushKVs(LockStatsToJSON(total));
+        obj.pushKV("wait_histogram", LockHistogramToJSON(total.wait_histogram));
+        obj.pushKV("hold_histogram", LockHistogramToJSON(total.hold_histogram));
+        UniValue sites_arr(UniValue::VARR);
+        for (auto& [wait_us, site_obj] : site_objs) {
+            sites_arr.push_back(std::move(site_obj));
+        }
+        obj.pushKV("sites", sites_arr);
+        locks.emplace_back(total, obj);
+    }
+    std::stable_sort(locks.begin(), locks.end(), [](const auto& a, const auto& b) { return a.first.wait_us > b.first.wait_us; });
+
+    UniValue ret(UniValue::VOBJ);
+    ret.pushKV("enabled", g_lock_stats_enabled.load());
+    UniValue locks_arr(UniValue::VARR);
+    for (auto& [total, obj] : locks) {
+        locks_arr.push_back(std::move(obj));
+    }
+    ret.pushKV("locks", locks_arr);
+    return ret;
+}
+
 static void EnableOrDisableLogCategories(UniValue cats, bool enable) {
     cats = cats.get_array();
     for (unsigned int i = 0; i < cats.size(); ++i) {
@@ -1364,6 +1670,10 @@ static RPCHelpMan getindexinfo()
         result.pushKVs(SummaryToJSON(g_coin_stats_index->GetSummary(), index_name));
     }
 
+    if (g_address_index) {
+        result.pushKVs(SummaryToJSON(g_address_index->GetSummary(), index_name));
+    }
+
     ForEachBlockFilterIndex([&result, &index_name](const BlockFilterIndex& index) {
         result.pushKVs(SummaryToJSON(index.GetSummary(), index_name));
     });
@@ -1380,6 +1690,8 @@ static const CRPCCommand commands[] =
   //  --------------------- ------------------------  -----------------------  ----------
     { "control",            "debug",                  &debug,                  {} },
     { "control",            "getmemoryinfo",          &getmemoryinfo,          {"mode"} },
+    { "control",            "getdbstats",             &getdbstats,             {} },
+    { "control",            "getlockstats",           &getlockstats,           {"reset"} },
     { "control",            "logging",                &logging,                {"include", "exclude"}},
     { "util",               "validateaddress",        &validateaddress,        {"address"} },
     { "util",               "createmultisig",         &createmultisig,         {"nrequired","keys"} },
@@ -141,6 +141,9 @@ static UniValue getpeerinfo(const JSONRPCRequest& request)
                     {
                         {RPCResult::Type::NUM, "n", "The heights of blocks we're currently asking from this peer"},
                     }},
+                    {RPCResult::Type::NUM, "blockwindow", "The number of blocks we allow to be in flight from this peer"},
+                    {RPCResult::Type::NUM, "blockrate", "The measured block download rate from this peer, in bytes per second"},
+                    {RPCResult::Type::NUM, "blocklatency", "The measured time between requesting a block and receiving it, in seconds"},
                     {RPCResult::Type::BOOL, "whitelisted", "Whether the peer is whitelisted"},
                     {RPCResult::Type::OBJ_DYN, "bytessent_per_msg", "",
                     {
@@ -232,6 +235,9 @@ static UniValue getpeerinfo(const JSONRPCRequest& request)
                 heights.push_back(height);
             }
             obj.pushKV("inflight", heights);
+            obj.pushKV("blockwindow", statestats.nBlockDownloadWindow);
+            obj.pushKV("blockrate", (int64_t)statestats.dBlockDownloadRate);
+            obj.pushKV("blocklatency", ((double)statestats.nBlockDownloadLatency) / 1e6);
         }
         obj.pushKV("whitelisted", stats.m_legacyWhitelisted);
         UniValue permissions(UniValue::VARR);
@@ -474,6 +480,68 @@ static UniValue getnettotals(const JSONRPCRequest& request)
     return obj;
 }
 
+static UniValue NetMsgHistogramToJSON(const std::array<uint64_t, NET_MSG_STATS_HISTOGRAM_BUCKETS>& histogram)
+{
+    UniValue arr(UniValue::VARR);
+    for (const uint64_t count : histogram) {
+        arr.push_back(count);
+    }
+    return arr;
+}
+
+static UniValue getnetmsgstats(const JSONRPCRequest& request)
+{
+    RPCHelpMan{"getnetmsgstats",
+        "\nReturns the time spent on received messages since startup or the last reset, per message type.\n"
+        "Processing time is the wall time of the message handler including the LLMQ, governance and CoinJoin\n"
+        "handlers it dispatches to, wait time is the time from receipt until processing started.\n"
+        "Histogram bucket i counts durations shorter than 2^(i+1) microseconds, the last bucket is open-ended.\n",
+        {
+            {"reset", RPCArg::Type::BOOL, /* default */ "false", "Clear the counters after reading them"},
+        },
+        RPCResult{
+            RPCResult::Type::OBJ_DYN, "", "Message types which were received at least once",
+            {
+                {RPCResult::Type::OBJ, "msgtype", "",
+                {
+                    {RPCResult::Type::NUM, "count", "Number of processed messages"},
+                    {RPCResult::Type::NUM, "process_us", "Total processing time in microseconds"},
+                    {RPCResult::Type::NUM, "max_process_us", "Longest processing time in microseconds"},
+                    {RPCResult::Type::NUM, "wait_us", "Total wait time in microseconds"},
+                    {RPCResult::Type::NUM, "max_wait_us", "Longest wait time in microseconds"},
+                    {RPCResult::Type::ARR, "process_histogram", "Processing times", {{RPCResult::Type::NUM, "", "Count"}}},
+                    {RPCResult::Type::ARR, "wait_histogram", "Wait times", {{RPCResult::Type::NUM, "", "Count"}}},
+                }},
+            }
+        },
+        RPCExamples{
+            HelpExampleCli("getnetmsgstats", "")
+    + HelpExampleCli("getnetmsgstats", "true")
+    + HelpExampleRpc("getnetmsgstats", "")
+        },
+    }.Check(request);
+
+    const NodeContext& node = EnsureAnyNodeContext(request.context);
+    if (!node.peerman) {
+        throw JSONRPCError(RPC_CLIENT_P2P_DISABLED, "Error: Peer-to-peer functionality missing or disabled");
+    }
+    const bool reset = !request.params[0].isNull() && request.params[0].get_bool();
+
+    UniValue ret(UniValue::VOBJ);
+    for (const auto& [msg_type, stats] : node.peerman->GetNetMsgStats(reset)) {
+        UniValue obj(UniValue::VOBJ);
+        obj.pushKV("count", stats.count);
+        obj.pushKV("process_us", stats.process_us);
+        obj.pushKV("max_process_us", stats.max_process_us);
+        obj.pushKV("wait_us", stats.wait_us);
+        obj.pushKV("max_wait_us", stats.max_wait_us);
+        obj.pushKV("process_histogram", NetMsgHistogramToJSON(stats.process_histogram));
+        obj.pushKV("wait_histogram", NetMsgHistogramToJSON(stats.wait_histogram));
+        ret.pushKV(msg_type, obj);
+    }
+    return ret;
+}
+
 static UniValue GetNetworksInfo()
 {
     UniValue networks(UniValue::VARR);
@@ -913,6 +981,7 @@ static const CRPCCommand commands[] =
     { "network",            "disconnectnode",         &disconnectnode,         {"address", "nodeid"} },
     { "network",            "getaddednodeinfo",       &getaddednodeinfo,       {"node"} },
     { "network",            "getnettotals",           &getnettotals,           {} },
+    { "network",            "getnetmsgstats",         &getnetmsgstats,         {"reset"} },
     { "network",            "getnetworkinfo",         &getnetworkinfo,         {} },
     { "network",            "setban",                 &setban,                 {"subnet", "command", "bantime", "absolute"} },
     { "network",            "listbanned",             &listbanned,             {} },
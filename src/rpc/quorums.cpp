@@ -5,6 +5,7 @@
 #include <chainparams.h>
 #include <deploymentstatus.h>
 #include <index/txindex.h>
+#include <node/chainsnapshot.h>
 #include <node/context.h>
 #include <rpc/blockchain.h>
 #include <rpc/server.h>
@@ -74,7 +75,7 @@ static UniValue quorum_list(const JSONRPCRequest& request, const ChainstateManag
 
     UniValue ret(UniValue::VOBJ);
 
-    CBlockIndex* pindexTip = WITH_LOCK(cs_main, return chainman.ActiveChain().Tip());
+    const CBlockIndex* pindexTip = GetChainSnapshotTip(chainman);
 
     for (const auto& type : llmq::GetEnabledQuorumTypes(pindexTip)) {
         const auto& llmq_params_opt = Params().GetLLMQ(type);
@@ -292,7 +293,7 @@ static UniValue quorum_dkgstatus(const JSONRPCRequest& request, const Chainstate
 
     auto ret = status.ToJson(detailLevel);
 
-    CBlockIndex* pindexTip = WITH_LOCK(cs_main, return chainman.ActiveChain().Tip());
+    const CBlockIndex* pindexTip = GetChainSnapshotTip(chainman);
     int tipHeight = pindexTip->nHeight;
 
     auto proTxHash = WITH_LOCK(activeMasternodeInfoCs, return activeMasternodeInfo.proTxHash);
@@ -394,7 +395,7 @@ static UniValue quorum_memberof(const JSONRPCRequest& request, const ChainstateM
         }
     }
 
-    const CBlockIndex* pindexTip = WITH_LOCK(cs_main, return chainman.ActiveChain().Tip());
+    const CBlockIndex* pindexTip = GetChainSnapshotTip(chainman);
     auto mnList = node.dmnman->GetListForBlock(pindexTip);
     auto dmn = mnList.GetMN(protxHash);
     if (!dmn) {
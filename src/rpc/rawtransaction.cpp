@@ -11,6 +11,7 @@
 #include <consensus/validation.h>
 #include <core_io.h>
 #include <evo/creditpool.h>
+#include <index/addressindex.h>
 #include <index/txindex.h>
 #include <init.h>
 #include <key_io.h>
@@ -67,21 +68,18 @@ void TxToJSON(const CTransaction& tx, const uint256 hashBlock, CTxMemPool& mempo
 
     // Add spent information if spentindex is enabled
     CSpentIndexTxInfo txSpentInfo;
-    for (const auto& txin : tx.vin) {
+    if (fSpentIndex) {
+        std::vector<CSpentIndexKey> spentKeys;
+        spentKeys.reserve(tx.vin.size() + tx.vout.size());
         if (!tx.IsCoinBase()) {
-            CSpentIndexValue spentInfo;
-            CSpentIndexKey spentKey(txin.prevout.hash, txin.prevout.n);
-            if (GetSpentIndex(mempool, spentKey, spentInfo)) {
-                txSpentInfo.mSpentInfo.emplace(spentKey, spentInfo);
+            for (const auto& txin : tx.vin) {
+                spentKeys.emplace_back(txin.prevout.hash, txin.prevout.n);
             }
         }
-    }
-    for (unsigned int i = 0; i < tx.vout.size(); i++) {
-        CSpentIndexValue spentInfo;
-        CSpentIndexKey spentKey(txid, i);
-        if (GetSpentIndex(mempool, spentKey, spentInfo)) {
-            txSpentInfo.mSpentInfo.emplace(spentKey, spentInfo);
+        for (unsigned int i = 0; i < tx.vout.size(); i++) {
+            spentKeys.emplace_back(txid, i);
         }
+        GetSpentIndexes(mempool, spentKeys, txSpentInfo);
     }
 
     TxToUniv(tx, uint256(), entry, true, &txSpentInfo);
@@ -233,6 +231,10 @@ static UniValue getrawtransaction(const JSONRPCRequest& request)
     if (g_txindex && !blockindex) {
         f_txindex_ready = g_txindex->BlockUntilSyncedToCurrentChain();
     }
+    // The spent info of the transaction comes from the address index
+    if (fVerbose && fSpentIndex) {
+        EnsureAddressIndexSynced();
+    }
 
     uint256 hash_block;
     const CTransactionRef tx = GetTransaction(blockindex, node.mempool.get(), hash, Params().GetConsensus(), hash_block);
@@ -542,19 +544,7 @@ static UniValue getassetunlockstatuses(const JSONRPCRequest& request)
             if (poolOnTip.has_value() && poolOnTip->indexes.Contains(index)) {
                 return "mined";
             }
-            bool is_mempooled = [&]() {
-                LOCK(mempool.cs);
-                return std::any_of(mempool.mapTx.begin(), mempool.mapTx.end(), [index](const CTxMemPoolEntry &e) {
-                    if (e.GetTx().nType == CAssetUnlockPayload::SPECIALTX_TYPE) {
-                        if (auto opt_assetUnlockTx = GetTxPayload<CAssetUnlockPayload>(e.GetTx())) {
-                            return index == opt_assetUnlockTx->getIndex();
-                        } else {
-                            throw JSONRPCError(RPC_TRANSACTION_ERROR, "bad-assetunlocktx-payload");
-                        }
-                    }
-                    return false;
-                });
-            }();
+            const bool is_mempooled = mempool.existsAssetUnlockIndex(index);
             return is_mempooled && !nSpecificCoreHeight.has_value() ? "mempooled" : "unknown";
         };
         obj.pushKV("status", status_to_push());
@@ -48,6 +48,67 @@ std::string JSONRPCReply(const UniValue& result, const UniValue& error, const Un
     return reply.write() + "\n";
 }
 
+void JSONStreamWriter::WriteValue(const UniValue& val)
+{
+    switch (val.getType()) {
+    case UniValue::VOBJ: {
+        const std::vector<std::string>& keys = val.getKeys();
+        const std::vector<UniValue>& values = val.getValues();
+        m_buf += '{';
+        for (size_t i = 0; i < keys.size(); ++i) {
+            if (i > 0) m_buf += ',';
+            m_buf += UniValue(keys[i]).write();
+            m_buf += ':';
+            WriteValue(values[i]);
+        }
+        m_buf += '}';
+        break;
+    }
+    case UniValue::VARR: {
+        const std::vector<UniValue>& values = val.getValues();
+        m_buf += '[';
+        for (size_t i = 0; i < values.size(); ++i) {
+            if (i > 0) m_buf += ',';
+            WriteValue(values[i]);
+        }
+        m_buf += ']';
+        break;
+    }
+    default:
+        m_buf += val.write();
+    }
+    if (m_buf.size() >= m_chunk_size) Flush();
+}
+
+void JSONStreamWriter::Write(const UniValue& val)
+{
+    WriteValue(val);
+}
+
+void JSONStreamWriter::WriteReply(const UniValue& result, const UniValue& error, const UniValue& id)
+{
+    WriteRaw("{\"result\":");
+    WriteValue(error.isNull() ? result : NullUniValue);
+    WriteRaw(",\"error\":");
+    WriteValue(error);
+    WriteRaw(",\"id\":");
+    WriteValue(id);
+    WriteRaw("}");
+}
+
+void JSONStreamWriter::WriteRaw(const std::string& str)
+{
+    m_buf += str;
+    if (m_buf.size() >= m_chunk_size) Flush();
+}
+
+void JSONStreamWriter::Flush()
+{
+    if (m_buf.empty()) return;
+    m_sink(m_buf);
+    m_buf.clear();
+}
+
 UniValue JSONRPCError(int code, const std::string& message)
 {
     UniValue error(UniValue::VOBJ);
@@ -8,6 +8,7 @@
 
 #include <context.h>
 
+#include <functional>
 #include <string>
 
 // #include <univalue.h>
@@ -18,6 +19,38 @@ UniValue JSONRPCReplyObj(const UniValue& result, const UniValue& error, const Un
 std::string JSONRPCReply(const UniValue& result, const UniValue& error, const UniValue& id);
 UniValue JSONRPCError(int code, const std::string& message);
 
+/** Receives consecutive pieces of serialized JSON */
+using JSONSink = std::function<void(const std::string& chunk)>;
+
+/** Bytes of serialized JSON collected before they are passed to the sink */
+static constexpr size_t JSON_STREAM_CHUNK_SIZE{64 * 1024};
+
+/**
+ * Serializes UniValue trees exactly like UniValue::write() without indentation, but passes
+ * the output to a sink in chunks instead of building one string. A large reply then never
+ * exists as a contiguous copy next to the tree it was built from.
+ */
+class JSONStreamWriter
+{
+public:
+    explicit JSONStreamWriter(JSONSink sink, size_t chunk_size = JSON_STREAM_CHUNK_SIZE)
+        : m_sink(std::move(sink)), m_chunk_size(chunk_size) {}
+
+    void Write(const UniValue& val);
+    /** Write the reply JSONRPCReply() returns, without copying result into a reply object */
+    void WriteReply(const UniValue& result, const UniValue& error, const UniValue& id);
+    void WriteRaw(const std::string& str);
+    /** Pass everything written so far to the sink. Must be called once writing is done. */
+    void Flush();
+
+private:
+    void WriteValue(const UniValue& val);
+
+    const JSONSink m_sink;
+    const size_t m_chunk_size;
+    std::string m_buf;
+};
+
 /** Generate a new RPC authentication cookie and write it to disk */
 bool GenerateAuthCookie(std::string *cookie_out);
 /** Read the RPC authentication cookie from disk */
@@ -7,20 +7,26 @@
 #include <rpc/server.h>
 
 #include <chainparams.h>
+#include <httpserver.h>
 #include <rpc/util.h>
 #include <shutdown.h>
 #include <sync.h>
 #include <util/strencodings.h>
 #include <util/string.h>
 #include <util/system.h>
+#include <util/threadbudget.h>
 
 #include <boost/signals2/signal.hpp>
+#include <ctpl_stl.h>
 
 #include <algorithm>
 #include <atomic>
 #include <cassert>
+#include <deque>
+#include <future>
 #include <memory> // for unique_ptr
 #include <mutex>
+#include <set>
 #include <unordered_map>
 
 static Mutex g_rpc_warmup_mutex;
@@ -32,6 +38,10 @@ static RPCTimerInterface* timerInterface = nullptr;
 /* Map of name to timer. */
 static Mutex g_deadline_timers_mutex;
 static std::map<std::string, std::unique_ptr<RPCTimerBase> > deadlineTimers GUARDED_BY(g_deadline_timers_mutex);
+/* Pool running the read-only calls of batch requests, see JSONRPCExecBatch */
+static Mutex g_rpc_batch_mutex;
+static ctpl::thread_pool g_rpc_batch_pool;
+static bool g_rpc_batch_pool_running GUARDED_BY(g_rpc_batch_mutex) = false;
 static bool ExecuteCommand(const CRPCCommand& command, const JSONRPCRequest& request, UniValue& result, bool last_handler, const std::multimap<std::string, std::vector<UniValue>>& mapPlatformRestrictions);
 
 // Any commands submitted by this user will have their commands filtered based on the mapPlatformRestrictions
@@ -244,6 +254,15 @@ static RPCHelpMan getrpcinfo()
                             }},
                         }},
                         {RPCResult::Type::STR, "logpath", "The complete file path to the debug log"},
+                        {RPCResult::Type::OBJ_DYN, "queue_times", "Time requests spent in the HTTP work queue, per RPC method",
+                        {
+                            {RPCResult::Type::OBJ, "method", "",
+                            {
+                                {RPCResult::Type::NUM, "count", "Number of requests picked up by a worker"},
+                                {RPCResult::Type::NUM, "total", "Total queue time in microseconds"},
+                                {RPCResult::Type::NUM, "max", "Longest queue time in microseconds"},
+                            }},
+                        }},
                     }
                 },
                 RPCExamples{
@@ -268,6 +287,16 @@ static RPCHelpMan getrpcinfo()
     UniValue log_path(UniValue::VSTR, path);
     result.pushKV("logpath", log_path);
 
+    UniValue queue_times(UniValue::VOBJ);
+    for (const auto& [label, stats] : GetHTTPQueueTimeStats()) {
+        UniValue entry(UniValue::VOBJ);
+        entry.pushKV("count", stats.count);
+        entry.pushKV("total", stats.total_us);
+        entry.pushKV("max", stats.max_us);
+        queue_times.pushKV(label, entry);
+    }
+    result.pushKV("queue_times", queue_times);
+
     return result;
 }
     };
@@ -322,6 +351,13 @@ void StartRPC()
 {
     LogPrint(BCLog::RPC, "Starting RPC\n");
     g_rpc_running = true;
+    const int nBatchThreads = std::clamp<int>(gArgs.GetArg("-rpcbatchthreads", GetThreadBudget(TaskPriority::BACKGROUND, DEFAULT_RPC_BATCH_THREADS)), 0, MAX_RPC_BATCH_THREADS);
+    if (nBatchThreads > 0) {
+        LOCK(g_rpc_batch_mutex);
+        g_rpc_batch_pool.resize(nBatchThreads);
+        RenameThreadPool(g_rpc_batch_pool, "rpcbatch");
+        g_rpc_batch_pool_running = true;
+    }
     g_rpcSignals.Started();
 }
 
@@ -344,6 +380,12 @@ void StopRPC()
     std::call_once(g_rpc_stop_flag, []() {
         LogPrint(BCLog::RPC, "Stopping RPC\n");
         WITH_LOCK(g_deadline_timers_mutex, deadlineTimers.clear());
+        {
+            // HTTP workers may still be executing batches, make them fall back to executing calls themselves
+            LOCK(g_rpc_batch_mutex);
+            g_rpc_batch_pool_running = false;
+            g_rpc_batch_pool.stop(true);
+        }
         DeleteAuthCookie();
         g_rpcSignals.Stopped();
     });
@@ -387,36 +429,99 @@ bool IsDeprecatedRPCEnabled(const std::string& method)
     return find(enabled_methods.begin(), enabled_methods.end(), method) != enabled_methods.end();
 }
 
-static UniValue JSONRPCExecOne(JSONRPCRequest jreq, const UniValue& req)
+/**
+ * Methods which only read node state and don't depend on the calls before them in a batch. Consecutive calls of
+ * these are executed concurrently by JSONRPCExecBatch.
+ */
+static const std::set<std::string> PARALLEL_BATCH_METHODS{
+    "decoderawtransaction",
+    "decodescript",
+    "getaddressbalance",
+    "getaddressdeltas",
+    "getaddresstxids",
+    "getaddressutxos",
+    "getbestblockhash",
+    "getblock",
+    "getblockcount",
+    "getblockhash",
+    "getblockhashes",
+    "getblockheader",
+    "getblockheaders",
+    "getblockstats",
+    "getmempoolentry",
+    "getrawtransaction",
+    "getspentinfo",
+    "gettxout",
+    "gettxoutproof",
+    "verifytxoutproof",
+};
+
+struct BatchCallReply {
+    UniValue result;
+    UniValue error;
+    UniValue id;
+};
+
+static BatchCallReply JSONRPCExecOne(JSONRPCRequest jreq, const UniValue& req)
 {
-    UniValue rpc_result(UniValue::VOBJ);
+    BatchCallReply reply;
 
     try {
         jreq.parse(req);
 
-        UniValue result = tableRPC.execute(jreq);
-        rpc_result = JSONRPCReplyObj(result, NullUniValue, jreq.id);
+        reply.result = tableRPC.execute(jreq);
     }
     catch (const UniValue& objError)
     {
-        rpc_result = JSONRPCReplyObj(NullUniValue, objError, jreq.id);
+        reply.error = objError;
     }
     catch (const std::exception& e)
     {
-        rpc_result = JSONRPCReplyObj(NullUniValue,
-                                     JSONRPCError(RPC_PARSE_ERROR, e.what()), jreq.id);
+        reply.error = JSONRPCError(RPC_PARSE_ERROR, e.what());
     }
 
-    return rpc_result;
+    reply.id = jreq.id;
+    return reply;
+}
+
+static bool IsParallelBatchCall(const UniValue& req)
+{
+    if (!req.isObject()) return false;
+    const UniValue& method = find_value(req, "method");
+    return method.isStr() && PARALLEL_BATCH_METHODS.count(method.get_str());
 }
 
-std::string JSONRPCExecBatch(const JSONRPCRequest& jreq, const UniValue& vReq)
+void JSONRPCExecBatch(const JSONRPCRequest& jreq, const UniValue& vReq, JSONStreamWriter& writer)
 {
-    UniValue ret(UniValue::VARR);
-    for (unsigned int reqIdx = 0; reqIdx < vReq.size(); reqIdx++)
-        ret.push_back(JSONRPCExecOne(jreq, vReq[reqIdx]));
+    // Replies of calls running on g_rpc_batch_pool, in request order
+    std::deque<std::future<BatchCallReply>> inFlight;
+    size_t nWritten{0};
+    const auto writeReply = [&](const BatchCallReply& reply) {
+        if (nWritten++ > 0) writer.WriteRaw(",");
+        writer.WriteReply(reply.result, reply.error, reply.id);
+    };
+    const auto writeOldest = [&]() {
+        writeReply(inFlight.front().get());
+        inFlight.pop_front();
+    };
 
-    return ret.write() + "\n";
+    writer.WriteRaw("[");
+    for (unsigned int reqIdx = 0; reqIdx < vReq.size(); reqIdx++) {
+        const UniValue& req = vReq[reqIdx];
+        if (IsParallelBatchCall(req)) {
+            if (inFlight.size() >= MAX_RPC_BATCH_CONCURRENCY) writeOldest();
+            LOCK(g_rpc_batch_mutex);
+            if (g_rpc_batch_pool_running) {
+                inFlight.emplace_back(g_rpc_batch_pool.push([jreq, &req](int) { return JSONRPCExecOne(jreq, req); }));
+                continue;
+            }
+        }
+        // Anything else may depend on or change what the calls before it see, run it after them
+        while (!inFlight.empty()) writeOldest();
+        writeReply(JSONRPCExecOne(jreq, req));
+    }
+    while (!inFlight.empty()) writeOldest();
+    writer.WriteRaw("]\n");
 }
 
 /**
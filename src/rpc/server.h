@@ -178,9 +178,19 @@ bool IsDeprecatedRPCEnabled(const std::string& method);
 
 extern CRPCTable tableRPC;
 
+/** Default for -rpcbatchthreads, before applying the thread budget */
+static const int DEFAULT_RPC_BATCH_THREADS = 8;
+static const int MAX_RPC_BATCH_THREADS = 64;
+/** Maximum number of calls of a single batch request executing at the same time */
+static const size_t MAX_RPC_BATCH_CONCURRENCY = 8;
+
 void StartRPC();
 void InterruptRPC();
 void StopRPC();
-std::string JSONRPCExecBatch(const JSONRPCRequest& jreq, const UniValue& vReq);
+/**
+ * Execute a batch of requests, streaming the replies to writer in request order. Runs of read-only calls are
+ * executed concurrently on the batch pool, all other calls after the calls before them have completed.
+ */
+void JSONRPCExecBatch(const JSONRPCRequest& jreq, const UniValue& vReq, JSONStreamWriter& writer);
 
 #endif // BITCOIN_RPC_SERVER_H
@@ -9,6 +9,7 @@
 
 #include <assert.h>
 #include <functional>
+#include <optional>
 #include <utility>
 
 CScheduler::CScheduler()
@@ -30,38 +31,63 @@ void CScheduler::serviceQueue()
     // newTaskMutex is locked throughout this loop EXCEPT
     // when the thread is waiting or when the user's function
     // is called.
+    std::optional<SchedulerLane> running;
     while (!shouldStop()) {
         try {
-            while (!shouldStop() && taskQueue.empty()) {
-                // Wait until there is something to do.
-                newTaskScheduled.wait(lock);
-            }
-
-            // Wait until either there is a new task, or until
-            // the time of the first item on the queue:
-
-            while (!shouldStop() && !taskQueue.empty()) {
-                std::chrono::system_clock::time_point timeToWaitFor = taskQueue.begin()->first;
-                if (newTaskScheduled.wait_until(lock, timeToWaitFor) == std::cv_status::timeout) {
-                    break; // Exit loop after timeout, it means we reached the time of the event
+            // Pick the due task of the highest priority lane that isn't busy, or find out how long
+            // to wait for the next one. Tasks of busy lanes are waited for by the threads running them.
+            const auto now = std::chrono::system_clock::now();
+            auto next = taskQueue.end();
+            std::optional<std::chrono::system_clock::time_point> timeToWaitFor;
+            for (auto it = taskQueue.begin(); it != taskQueue.end(); ++it) {
+                if (m_busy_lanes & LaneBit(it->second.lane)) continue;
+                if (it->first > now) {
+                    timeToWaitFor = it->first;
+                    break;
+                }
+                if (next == taskQueue.end() || it->second.lane < next->second.lane) {
+                    next = it;
                 }
             }
 
-            // If there are multiple threads, the queue can empty while we're waiting (another
-            // thread may service the task we were waiting on).
-            if (shouldStop() || taskQueue.empty())
+            if (next == taskQueue.end()) {
+                // Wait until either there is a new task or a lane became idle, or until
+                // the time of the first task that can run
+                if (timeToWaitFor) {
+                    newTaskScheduled.wait_until(lock, *timeToWaitFor);
+                } else {
+                    newTaskScheduled.wait(lock);
+                }
                 continue;
+            }
 
-            Function f = taskQueue.begin()->second;
-            taskQueue.erase(taskQueue.begin());
+            Task task = std::move(next->second);
+            taskQueue.erase(next);
+            running = task.lane;
+            m_busy_lanes |= LaneBit(task.lane);
 
+            const auto start = std::chrono::steady_clock::now();
             {
                 // Unlock before calling f, so it can reschedule itself or another task
                 // without deadlocking:
                 REVERSE_LOCK(lock);
-                f();
+                task.f();
+            }
+            const auto duration = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start);
+
+            running.reset();
+            m_busy_lanes &= ~LaneBit(task.lane);
+            // More tasks of this lane may have become due while it was busy
+            newTaskScheduled.notify_all();
+            if (!task.name.empty()) {
+                auto& stats = m_task_stats[task.name];
+                stats.lane = task.lane;
+                stats.runs++;
+                stats.total += duration;
+                stats.max = std::max(stats.max, duration);
             }
         } catch (...) {
+            if (running) m_busy_lanes &= ~LaneBit(*running);
             --nThreadsServicingQueue;
             throw;
         }
@@ -70,11 +96,11 @@ void CScheduler::serviceQueue()
     newTaskScheduled.notify_one();
 }
 
-void CScheduler::schedule(CScheduler::Function f, std::chrono::system_clock::time_point t)
+void CScheduler::schedule(CScheduler::Function f, std::chrono::system_clock::time_point t, SchedulerLane lane, const std::string& name)
 {
     {
         LOCK(newTaskMutex);
-        taskQueue.insert(std::make_pair(t, f));
+        taskQueue.emplace(t, Task{std::move(f), lane, name});
     }
     newTaskScheduled.notify_one();
 }
@@ -87,7 +113,7 @@ void CScheduler::MockForward(std::chrono::seconds delta_seconds)
         LOCK(newTaskMutex);
 
         // use temp_queue to maintain updated schedule
-        std::multimap<std::chrono::system_clock::time_point, Function> temp_queue;
+        std::multimap<std::chrono::system_clock::time_point, Task> temp_queue;
 
         for (const auto& element : taskQueue) {
             temp_queue.emplace_hint(temp_queue.cend(), element.first - delta_seconds, element.second);
@@ -101,15 +127,15 @@ void CScheduler::MockForward(std::chrono::seconds delta_seconds)
     newTaskScheduled.notify_one();
 }
 
-static void Repeat(CScheduler& s, CScheduler::Function f, std::chrono::milliseconds delta)
+static void Repeat(CScheduler& s, CScheduler::Function f, std::chrono::milliseconds delta, SchedulerLane lane, const std::string& name)
 {
     f();
-    s.scheduleFromNow([=, &s] { Repeat(s, f, delta); }, delta);
+    s.scheduleFromNow([=, &s] { Repeat(s, f, delta, lane, name); }, delta, lane, name);
 }
 
-void CScheduler::scheduleEvery(CScheduler::Function f, std::chrono::milliseconds delta)
+void CScheduler::scheduleEvery(CScheduler::Function f, std::chrono::milliseconds delta, SchedulerLane lane, const std::string& name)
 {
-    scheduleFromNow([=] { Repeat(*this, f, delta); }, delta);
+    scheduleFromNow([=] { Repeat(*this, f, delta, lane, name); }, delta, lane, name);
 }
 
 size_t CScheduler::getQueueInfo(std::chrono::system_clock::time_point& first,
@@ -130,6 +156,23 @@ bool CScheduler::AreThreadsServicingQueue() const
     return nThreadsServicingQueue;
 }
 
+std::map<std::string, SchedulerTaskStats> CScheduler::GetTaskStats() const
+{
+    LOCK(newTaskMutex);
+    return m_task_stats;
+}
+
+std::string SchedulerLaneName(SchedulerLane lane)
+{
+    switch (lane) {
+    case SchedulerLane::DEFAULT: return "default";
+    case SchedulerLane::NETWORK: return "network";
+    case SchedulerLane::LLMQ: return "llmq";
+    case SchedulerLane::MAINTENANCE: return "maintenance";
+    } // no default case, so the compiler can warn about missing cases
+    assert(false);
+}
+
 
 void SingleThreadedSchedulerClient::MaybeScheduleProcessQueue()
 {
@@ -12,11 +12,45 @@
 #include <chrono>
 #include <condition_variable>
 #include <cstddef>
+#include <cstdint>
 #include <functional>
 #include <list>
 #include <map>
+#include <string>
 #include <thread>
 #include <utility>
+#include <vector>
+
+//! Threads servicing the scheduler queue of a node. With one, every task runs after the other.
+static constexpr int DEFAULT_SCHEDULER_THREADS{1};
+static constexpr int MAX_SCHEDULER_THREADS{8};
+
+/**
+ * Tasks of a lane are run one at a time and in the order they became due, so a slow task only
+ * holds back the rest of its lane while other threads keep servicing the other lanes. Tasks of
+ * different lanes only run at the same time with more than one servicing thread. When several
+ * tasks are due, the one of the lane listed first here runs first.
+ */
+enum class SchedulerLane : uint8_t {
+    //! Validation interface callbacks and untagged tasks
+    DEFAULT,
+    //! Peer and address management
+    NETWORK,
+    //! LLMQ and masternode housekeeping
+    LLMQ,
+    //! Governance, CoinJoin and wallet maintenance
+    MAINTENANCE,
+};
+
+std::string SchedulerLaneName(SchedulerLane lane);
+
+//! Run times of the executions of a named task
+struct SchedulerTaskStats {
+    SchedulerLane lane{SchedulerLane::DEFAULT};
+    uint64_t runs{0};
+    std::chrono::microseconds total{0};
+    std::chrono::microseconds max{0};
+};
 
 /**
  * Simple class for background tasks that should be run
@@ -42,16 +76,18 @@ public:
     ~CScheduler();
 
     std::thread m_service_thread;
+    //! Further threads running serviceQueue, joined by stop() as well
+    std::vector<std::thread> m_extra_service_threads;
 
     typedef std::function<void()> Function;
 
-    /** Call func at/after time t */
-    void schedule(Function f, std::chrono::system_clock::time_point t);
+    /** Call func at/after time t. Run times of tasks with a name are recorded, see GetTaskStats(). */
+    void schedule(Function f, std::chrono::system_clock::time_point t, SchedulerLane lane = SchedulerLane::DEFAULT, const std::string& name = {});
 
     /** Call f once after the delta has passed */
-    void scheduleFromNow(Function f, std::chrono::milliseconds delta)
+    void scheduleFromNow(Function f, std::chrono::milliseconds delta, SchedulerLane lane = SchedulerLane::DEFAULT, const std::string& name = {})
     {
-        schedule(std::move(f), std::chrono::system_clock::now() + delta);
+        schedule(std::move(f), std::chrono::system_clock::now() + delta, lane, name);
     }
 
     /**
@@ -60,7 +96,7 @@ public:
      * The timing is not exact: Every time f is finished, it is rescheduled to run again after delta. If you need more
      * accurate scheduling, don't use this method.
      */
-    void scheduleEvery(Function f, std::chrono::milliseconds delta);
+    void scheduleEvery(Function f, std::chrono::milliseconds delta, SchedulerLane lane = SchedulerLane::DEFAULT, const std::string& name = {});
 
     /**
      * Mock the scheduler to fast forward in time.
@@ -79,14 +115,14 @@ public:
     {
         WITH_LOCK(newTaskMutex, stopRequested = true);
         newTaskScheduled.notify_all();
-        if (m_service_thread.joinable()) m_service_thread.join();
+        JoinServiceThreads();
     }
     /** Tell any threads running serviceQueue to stop when there is no work left to be done */
     void StopWhenDrained()
     {
         WITH_LOCK(newTaskMutex, stopWhenEmpty = true);
         newTaskScheduled.notify_all();
-        if (m_service_thread.joinable()) m_service_thread.join();
+        JoinServiceThreads();
     }
 
     /**
@@ -99,14 +135,37 @@ public:
     /** Returns true if there are threads actively running in serviceQueue() */
     bool AreThreadsServicingQueue() const;
 
+    /** Run times of the named tasks so far, by name */
+    std::map<std::string, SchedulerTaskStats> GetTaskStats() const;
+
 private:
+    struct Task {
+        Function f;
+        SchedulerLane lane;
+        std::string name;
+    };
+
     mutable Mutex newTaskMutex;
     std::condition_variable newTaskScheduled;
-    std::multimap<std::chrono::system_clock::time_point, Function> taskQueue GUARDED_BY(newTaskMutex);
+    std::multimap<std::chrono::system_clock::time_point, Task> taskQueue GUARDED_BY(newTaskMutex);
+    //! Bit per lane with a task running
+    uint32_t m_busy_lanes GUARDED_BY(newTaskMutex){0};
+    std::map<std::string, SchedulerTaskStats> m_task_stats GUARDED_BY(newTaskMutex);
     int nThreadsServicingQueue GUARDED_BY(newTaskMutex){0};
     bool stopRequested GUARDED_BY(newTaskMutex){false};
     bool stopWhenEmpty GUARDED_BY(newTaskMutex){false};
     bool shouldStop() const EXCLUSIVE_LOCKS_REQUIRED(newTaskMutex) { return stopRequested || (stopWhenEmpty && taskQueue.empty()); }
+
+    static uint32_t LaneBit(SchedulerLane lane) { return 1u << uint8_t(lane); }
+
+    void JoinServiceThreads()
+    {
+        if (m_service_thread.joinable()) m_service_thread.join();
+        for (auto& thread : m_extra_service_threads) {
+            if (thread.joinable()) thread.join();
+        }
+        m_extra_service_threads.clear();
+    }
 };
 
 /**
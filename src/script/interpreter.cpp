@@ -10,6 +10,7 @@
 #include <crypto/sha256.h>
 #include <pubkey.h>
 #include <script/script.h>
+#include <streams.h>
 #include <uint256.h>
 
 typedef std::vector<unsigned char> valtype;
@@ -1523,6 +1524,27 @@ void PrecomputedTransactionData::Init(const T& txTo, std::vector<CTxOut>&& spent
 
     m_spent_outputs = std::move(spent_outputs);
 
+    CVectorWriter inputs(SER_GETHASH, 0, m_legacy_inputs, 0);
+    for (const auto& txin : txTo.vin) {
+        inputs << txin.prevout << CScript() << txin.nSequence;
+    }
+    assert(m_legacy_inputs.size() == txTo.vin.size() * LEGACY_BLANK_INPUT_SIZE);
+    CVectorWriter outputs(SER_GETHASH, 0, m_legacy_outputs, 0, txTo.vout, txTo.nLockTime);
+    if (txTo.nVersion == 3 && txTo.nType != TRANSACTION_NORMAL) {
+        outputs << txTo.vExtraPayload;
+    }
+
+    std::vector<unsigned char> header;
+    const int32_t n32bitVersion = txTo.nVersion | (txTo.nType << 16);
+    CVectorWriter(SER_GETHASH, 0, header, 0, n32bitVersion, COMPACTSIZE(uint64_t(txTo.vin.size())));
+    CSHA256 sha;
+    sha.Write(header.data(), header.size());
+    m_legacy_midstates.reserve(txTo.vin.size());
+    for (size_t i = 0; i < txTo.vin.size(); i++) {
+        m_legacy_midstates.push_back(sha);
+        sha.Write(m_legacy_inputs.data() + i * LEGACY_BLANK_INPUT_SIZE, LEGACY_BLANK_INPUT_SIZE);
+    }
+
     m_ready = true;
 }
 
@@ -1554,6 +1576,40 @@ uint256 SignatureHash(const CScript& scriptCode, const T& txTo, unsigned int nIn
     // Wrapper to serialize only the necessary parts of the transaction being signed
     CTransactionSignatureSerializer<T> txTmp(txTo, scriptCode, nIn, nHashType);
 
+    // SIGHASH_ALL, with or without ANYONECANPAY, from the parts serialized by the cache. Any
+    // base type other than SINGLE and NONE is treated as ALL, like the serializer does.
+    const int nBaseType = nHashType & 0x1f;
+    if (cache && cache->m_ready && cache->m_legacy_midstates.size() == txTo.vin.size() &&
+        nBaseType != SIGHASH_SINGLE && nBaseType != SIGHASH_NONE) {
+        const bool fAnyoneCanPay = !!(nHashType & SIGHASH_ANYONECANPAY);
+        CSHA256 sha;
+        if (fAnyoneCanPay) {
+            unsigned char header[5];
+            WriteLE32(header, uint32_t(txTo.nVersion | (txTo.nType << 16)));
+            header[4] = 1; // only the input being signed
+            sha.Write(header, sizeof(header));
+        } else {
+            sha = cache->m_legacy_midstates[nIn];
+        }
+        std::vector<unsigned char> input;
+        CVectorWriter writer(SER_GETHASH, 0, input, 0);
+        txTmp.SerializeInput(writer, nIn);
+        sha.Write(input.data(), input.size());
+        if (!fAnyoneCanPay) {
+            const size_t offset = (nIn + 1) * LEGACY_BLANK_INPUT_SIZE;
+            sha.Write(cache->m_legacy_inputs.data() + offset, cache->m_legacy_inputs.size() - offset);
+        }
+        sha.Write(cache->m_legacy_outputs.data(), cache->m_legacy_outputs.size());
+        unsigned char hash_type[4];
+        WriteLE32(hash_type, uint32_t(nHashType));
+        sha.Write(hash_type, sizeof(hash_type));
+
+        uint256 result;
+        sha.Finalize(result.begin());
+        sha.Reset().Write(result.begin(), CSHA256::OUTPUT_SIZE).Finalize(result.begin());
+        return result;
+    }
+
     // Serialize and hash
     CHashWriter ss(SER_GETHASH, 0);
     ss << txTmp << nHashType;
@@ -1679,6 +1735,80 @@ bool GenericTransactionSignatureChecker<T>::CheckSequence(const CScriptNum& nSeq
 template class GenericTransactionSignatureChecker<CTransaction>;
 template class GenericTransactionSignatureChecker<CMutableTransaction>;
 
+/**
+ * Builds the stack of a scriptSig made of data pushes only, without the interpreter loop.
+ * Returns false for anything EvalScript might treat differently (other opcodes, oversized or
+ * non-minimal pushes, too many elements), in which case the caller has to use EvalScript.
+ */
+static bool EvalPushOnlyScript(const CScript& script, unsigned int flags, std::vector<valtype>& stack)
+{
+    if (script.size() > MAX_SCRIPT_SIZE)
+        return false;
+    const bool fRequireMinimal = (flags & SCRIPT_VERIFY_MINIMALDATA) != 0;
+    opcodetype opcode;
+    valtype vchPushValue;
+    CScript::const_iterator pc = script.begin();
+    while (pc < script.end()) {
+        if (!script.GetOp(pc, opcode, vchPushValue) || opcode > OP_PUSHDATA4)
+            return false;
+        if (vchPushValue.size() > MAX_SCRIPT_ELEMENT_SIZE || (fRequireMinimal && !CheckMinimalPush(vchPushValue, opcode)))
+            return false;
+        if (stack.size() >= MAX_STACK_SIZE)
+            return false;
+        stack.push_back(std::move(vchPushValue));
+    }
+    return true;
+}
+
+/**
+ * P2PKH spent by <sig> <pubkey>: the checks and errors of interpreting
+ * DUP HASH160 <hash> EQUALVERIFY CHECKSIG on that stack, without the interpreter.
+ */
+static bool VerifyP2PKH(const valtype& vchSig, const valtype& vchPubKey, const CScript& scriptPubKey, unsigned int flags, const BaseSignatureChecker& checker, ScriptError* serror)
+{
+    valtype vchHash(20);
+    CHash160().Write(vchPubKey).Finalize(vchHash);
+    if (!std::equal(vchHash.begin(), vchHash.end(), scriptPubKey.begin() + 3))
+        return set_error(serror, SCRIPT_ERR_EQUALVERIFY);
+
+    bool fSuccess = true;
+    if (!EvalChecksig(vchSig, vchPubKey, scriptPubKey.begin(), scriptPubKey.end(), flags, checker, SigVersion::BASE, serror, fSuccess))
+        // serror is set
+        return false;
+    if (!fSuccess)
+        return set_error(serror, SCRIPT_ERR_EVAL_FALSE);
+    // The stack holds only the CHECKSIG result, which satisfies CLEANSTACK
+    return set_success(serror);
+}
+
+/**
+ * P2SH spent by a push-only scriptSig: compares the hash of the serialized script directly
+ * instead of interpreting HASH160 <hash> EQUAL on a copy of the stack, then evaluates the
+ * redeem script like VerifyScript does.
+ */
+static bool VerifyP2SH(std::vector<valtype>& stack, const CScript& scriptPubKey, unsigned int flags, const BaseSignatureChecker& checker, ScriptError* serror)
+{
+    valtype vchHash(20);
+    CHash160().Write(stack.back()).Finalize(vchHash);
+    if (!std::equal(vchHash.begin(), vchHash.end(), scriptPubKey.begin() + 2))
+        return set_error(serror, SCRIPT_ERR_EVAL_FALSE);
+
+    const valtype& pubKeySerialized = stack.back();
+    CScript pubKey2(pubKeySerialized.begin(), pubKeySerialized.end());
+    popstack(stack);
+
+    if (!EvalScript(stack, pubKey2, flags, checker, SigVersion::BASE, serror))
+        // serror is set
+        return false;
+    if (stack.empty())
+        return set_error(serror, SCRIPT_ERR_EVAL_FALSE);
+    if (!CastToBool(stack.back()))
+        return set_error(serror, SCRIPT_ERR_EVAL_FALSE);
+    if ((flags & SCRIPT_VERIFY_CLEANSTACK) != 0 && stack.size() != 1)
+        return set_error(serror, SCRIPT_ERR_CLEANSTACK);
+    return set_success(serror);
+}
+
 bool VerifyScript(const CScript& scriptSig, const CScript& scriptPubKey, unsigned int flags, const BaseSignatureChecker& checker, ScriptError* serror)
 {
     set_error(serror, SCRIPT_ERR_UNKNOWN_ERROR);
@@ -1690,9 +1820,19 @@ bool VerifyScript(const CScript& scriptSig, const CScript& scriptPubKey, unsigne
     // scriptSig and scriptPubKey must be evaluated sequentially on the same stack
     // rather than being simply concatenated (see CVE-2010-5141)
     std::vector<std::vector<unsigned char> > stack, stackCopy;
-    if (!EvalScript(stack, scriptSig, flags, checker, SigVersion::BASE, serror))
-        // serror is set
-        return false;
+    if (EvalPushOnlyScript(scriptSig, flags, stack)) {
+        // Nearly every input spends one of these two templates, skip the interpreter for them.
+        // The stack limit keeps the P2SH shortcut from missing a STACK_SIZE error of the hash push.
+        if (stack.size() == 2 && scriptPubKey.IsPayToPublicKeyHash())
+            return VerifyP2PKH(stack[0], stack[1], scriptPubKey, flags, checker, serror);
+        if ((flags & SCRIPT_VERIFY_P2SH) && scriptPubKey.IsPayToScriptHash() && !stack.empty() && stack.size() < MAX_STACK_SIZE)
+            return VerifyP2SH(stack, scriptPubKey, flags, checker, serror);
+    } else {
+        stack.clear();
+        if (!EvalScript(stack, scriptSig, flags, checker, SigVersion::BASE, serror))
+            // serror is set
+            return false;
+    }
     if (flags & SCRIPT_VERIFY_P2SH)
         stackCopy = stack;
     if (!EvalScript(stack, scriptPubKey, flags, checker, SigVersion::BASE, serror))
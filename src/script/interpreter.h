@@ -6,6 +6,7 @@
 #ifndef BITCOIN_SCRIPT_INTERPRETER_H
 #define BITCOIN_SCRIPT_INTERPRETER_H
 
+#include <crypto/sha256.h>
 #include <script/script_error.h>
 #include <primitives/transaction.h>
 
@@ -115,6 +116,15 @@ struct PrecomputedTransactionData
     bool m_ready = false;
     std::vector<CTxOut> m_spent_outputs;
 
+    // Legacy SIGHASH_ALL preimages of a transaction only differ in the input being signed, so
+    // the rest is serialized once here. Otherwise hashing all n inputs costs O(n^2).
+    //! SHA256 state after the preimage header and the blanked inputs before each input
+    std::vector<CSHA256> m_legacy_midstates;
+    //! The inputs with empty scripts, LEGACY_BLANK_INPUT_SIZE bytes each
+    std::vector<unsigned char> m_legacy_inputs;
+    //! The outputs, nLockTime and the extra payload, the end of every SIGHASH_ALL preimage
+    std::vector<unsigned char> m_legacy_outputs;
+
     PrecomputedTransactionData() = default;
 
     template <class T>
@@ -124,6 +134,9 @@ struct PrecomputedTransactionData
     explicit PrecomputedTransactionData(const T& tx);
 };
 
+//! Size of an input in the legacy signature hash preimage when it isn't the one being signed
+static constexpr size_t LEGACY_BLANK_INPUT_SIZE{32 + 4 + 1 + 4};
+
 enum class SigVersion
 {
     BASE = 0,
@@ -1469,4 +1469,13 @@ size_t GetSerializeSizeMany(int nVersion, const T&... t)
     return sc.size();
 }
 
+/**
+ * Whether a stream keeps its data in a buffer it can hand out views of with ReadView(), so that
+ * fixed size objects can be parsed in place instead of being read into a copy first.
+ */
+template <typename Stream, typename = void>
+struct has_read_view : std::false_type {};
+template <typename Stream>
+struct has_read_view<Stream, std::void_t<decltype(std::declval<Stream&>().ReadView(size_t{}))>> : std::true_type {};
+
 #endif // BITCOIN_SERIALIZE_H
@@ -27,19 +27,21 @@ std::unique_ptr<CSporkManager> sporkManager;
 
 const std::string SporkStore::SERIALIZATION_VERSION_STRING = "CSporkManager-Version-2";
 
+/** Position of a spork in sporkDefs and in the value arrays of CSporkManager */
+static std::optional<size_t> GetSporkDefIndex(SporkId nSporkID)
+{
+    for (size_t i = 0; i < sporkDefs.size(); ++i) {
+        if (sporkDefs[i].sporkId == nSporkID) return i;
+    }
+    return std::nullopt;
+}
+
 std::optional<SporkValue> CSporkManager::SporkValueIfActive(SporkId nSporkID) const
 {
     AssertLockHeld(cs);
 
     if (!mapSporksActive.count(nSporkID)) return std::nullopt;
 
-    {
-        LOCK(cs_mapSporksCachedValues);
-        if (auto it = mapSporksCachedValues.find(nSporkID); it != mapSporksCachedValues.end()) {
-            return {it->second};
-        }
-    }
-
     // calc how many values we have and how many signers vote for every value
     std::unordered_map<SporkValue, int> mapValueCounts;
     for (const auto& [_, spork] : mapSporksActive.at(nSporkID)) {
@@ -47,10 +49,6 @@ std::optional<SporkValue> CSporkManager::SporkValueIfActive(SporkId nSporkID) co
         if (mapValueCounts.at(spork.nValue) >= nMinSporkKeys) {
             // nMinSporkKeys is always more than the half of the max spork keys number,
             // so there is only one such value and we can stop here
-            {
-                LOCK(cs_mapSporksCachedValues);
-                mapSporksCachedValues[nSporkID] = spork.nValue;
-            }
             return {spork.nValue};
         }
     }
@@ -58,6 +56,16 @@ std::optional<SporkValue> CSporkManager::SporkValueIfActive(SporkId nSporkID) co
     return std::nullopt;
 }
 
+void CSporkManager::UpdateSporkValues()
+{
+    AssertLockHeld(cs);
+
+    for (size_t i = 0; i < sporkDefs.size(); ++i) {
+        const SporkValue nValue = SporkValueIfActive(sporkDefs[i].sporkId).value_or(sporkDefs[i].defaultValue);
+        m_spork_values[i].store(nValue, std::memory_order_relaxed);
+    }
+}
+
 void SporkStore::Clear()
 {
     LOCK(cs);
@@ -70,6 +78,10 @@ void SporkStore::Clear()
 CSporkManager::CSporkManager() :
     m_db{std::make_unique<db_type>("sporks.dat", "magicSporkCache")}
 {
+    for (size_t i = 0; i < sporkDefs.size(); ++i) {
+        m_spork_values[i].store(sporkDefs[i].defaultValue, std::memory_order_relaxed);
+        m_spork_active_values[i].store(SPORK_VALUE_NOT_ACTIVE, std::memory_order_relaxed);
+    }
 }
 
 CSporkManager::~CSporkManager()
@@ -85,6 +97,7 @@ bool CSporkManager::LoadCache()
     if (is_valid) {
         CheckAndRemove();
     }
+    WITH_LOCK(cs, UpdateSporkValues());
     return is_valid;
 }
 
@@ -112,6 +125,7 @@ void CSporkManager::CheckAndRemove()
         }
         ++itActive;
     }
+    UpdateSporkValues();
 
     for (auto itByHash = mapSporksByHash.begin(); itByHash != mapSporksByHash.end();) {
         bool found = false;
@@ -191,9 +205,7 @@ PeerMsgRet CSporkManager::ProcessSpork(const CNode& peer, CConnman& connman, CDa
         LOCK(cs); // make sure to not lock this together with cs_main
         mapSporksByHash[hash] = spork;
         mapSporksActive[spork.nSporkID][keyIDSigner] = spork;
-        // Clear cached values on new spork being processed
-        WITH_LOCK(cs_mapSporksCachedActive, mapSporksCachedActive.erase(spork.nSporkID));
-        WITH_LOCK(cs_mapSporksCachedValues, mapSporksCachedValues.erase(spork.nSporkID));
+        UpdateSporkValues();
     }
     spork.Relay(connman);
     return {};
@@ -232,9 +244,7 @@ bool CSporkManager::UpdateSpork(SporkId nSporkID, SporkValue nValue, CConnman& c
 
         mapSporksByHash[spork.GetHash()] = spork;
         mapSporksActive[nSporkID][*opt_keyIDSigner] = spork;
-        // Clear cached values on new spork being processed
-        WITH_LOCK(cs_mapSporksCachedActive, mapSporksCachedActive.erase(spork.nSporkID));
-        WITH_LOCK(cs_mapSporksCachedValues, mapSporksCachedValues.erase(spork.nSporkID));
+        UpdateSporkValues();
     }
 
     spork.Relay(connman);
@@ -243,41 +253,36 @@ bool CSporkManager::UpdateSpork(SporkId nSporkID, SporkValue nValue, CConnman& c
 
 bool CSporkManager::IsSporkActive(SporkId nSporkID) const
 {
-    // If nSporkID is cached, and the cached value is true, then return early true
-    {
-        LOCK(cs_mapSporksCachedActive);
-        if (auto it = mapSporksCachedActive.find(nSporkID); it != mapSporksCachedActive.end() && it->second) {
-            return true;
-        }
-    }
+    const auto index = GetSporkDefIndex(nSporkID);
+    if (!index) return GetSporkValue(nSporkID) < GetAdjustedTime();
 
-    SporkValue nSporkValue = GetSporkValue(nSporkID);
+    const SporkValue nSporkValue = m_spork_values[*index].load(std::memory_order_relaxed);
+    if (m_spork_active_values[*index].load(std::memory_order_relaxed) == nSporkValue) {
+        return true;
+    }
     // Get time is somewhat costly it looks like
     bool ret = nSporkValue < GetAdjustedTime();
     // Only cache true values
     if (ret) {
-        LOCK(cs_mapSporksCachedActive);
-        mapSporksCachedActive[nSporkID] = ret;
+        m_spork_active_values[*index].store(nSporkValue, std::memory_order_relaxed);
     }
     return ret;
 }
 
 SporkValue CSporkManager::GetSporkValue(SporkId nSporkID) const
 {
+    if (const auto index = GetSporkDefIndex(nSporkID)) {
+        return m_spork_values[*index].load(std::memory_order_relaxed);
+    }
+
     LOCK(cs);
 
     if (auto opt_sporkValue = SporkValueIfActive(nSporkID)) {
         return *opt_sporkValue;
     }
 
-
-    if (auto optSpork = ranges::find_if_opt(sporkDefs,
-                                            [&nSporkID](const auto& sporkDef){return sporkDef.sporkId == nSporkID;})) {
-        return optSpork->defaultValue;
-    } else {
-        LogPrint(BCLog::SPORK, "CSporkManager::GetSporkValue -- Unknown Spork ID %d\n", nSporkID);
-        return -1;
-    }
+    LogPrint(BCLog::SPORK, "CSporkManager::GetSporkValue -- Unknown Spork ID %d\n", nSporkID);
+    return -1;
 }
 
 SporkId CSporkManager::GetSporkIDByName(std::string_view strName)
@@ -322,6 +327,7 @@ bool CSporkManager::SetMinSporkKeys(int minSporkKeys)
         return false;
     }
     nMinSporkKeys = minSporkKeys;
+    UpdateSporkValues();
     return true;
 }
 
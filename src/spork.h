@@ -15,6 +15,8 @@
 #include <uint256.h>
 
 #include <array>
+#include <atomic>
+#include <limits>
 #include <optional>
 #include <string_view>
 #include <unordered_map>
@@ -221,11 +223,19 @@ private:
     const std::unique_ptr<db_type> m_db;
     bool is_valid{false};
 
-    mutable Mutex cs_mapSporksCachedActive;
-    mutable std::unordered_map<const SporkId, bool> mapSporksCachedActive GUARDED_BY(cs_mapSporksCachedActive);
+    //! Marks a spork in m_spork_active_values whose value wasn't seen active yet
+    static constexpr SporkValue SPORK_VALUE_NOT_ACTIVE{std::numeric_limits<SporkValue>::max()};
 
-    mutable Mutex cs_mapSporksCachedValues;
-    mutable std::unordered_map<SporkId, SporkValue> mapSporksCachedValues GUARDED_BY(cs_mapSporksCachedValues);
+    /**
+     * Current value of every spork in sporkDefs, at the same index. Recomputed under cs whenever the
+     * spork messages or the signer threshold change, so reading a spork value is a single atomic load.
+     */
+    std::array<std::atomic<SporkValue>, sporkDefs.size()> m_spork_values;
+    /**
+     * The last value of every spork that IsSporkActive found to be in the past. Spork values are
+     * timestamps, a value that was active once stays active, which saves getting the adjusted time.
+     */
+    mutable std::array<std::atomic<SporkValue>, sporkDefs.size()> m_spork_active_values;
 
     std::set<CKeyID> setSporkPubKeyIDs GUARDED_BY(cs);
     int nMinSporkKeys GUARDED_BY(cs) {std::numeric_limits<int>::max()};
@@ -237,6 +247,11 @@ private:
      */
     std::optional<SporkValue> SporkValueIfActive(SporkId nSporkID) const EXCLUSIVE_LOCKS_REQUIRED(cs);
 
+    /**
+     * UpdateSporkValues publishes the current value of every known spork in m_spork_values.
+     */
+    void UpdateSporkValues() EXCLUSIVE_LOCKS_REQUIRED(cs);
+
 public:
     CSporkManager();
     ~CSporkManager();
@@ -289,7 +304,7 @@ public:
      * instead, and therefore this method doesn't make sense and should not be
      * used.
      */
-    bool IsSporkActive(SporkId nSporkID) const;
+    bool IsSporkActive(SporkId nSporkID) const LOCKS_EXCLUDED(cs);
 
     /**
      * GetSporkValue returns the spork value given a Spork ID. If no active spork
@@ -33,10 +33,14 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include <compat.h>
 #include <netbase.h>
 #include <random.h>
+#include <sync.h>
+#include <tinyformat.h>
 #include <util/system.h>
 
+#include <atomic>
 #include <cmath>
 #include <cstdio>
+#include <map>
 
 statsd::StatsdClient statsClient;
 
@@ -61,6 +65,12 @@ inline bool should_send(float sample_rate)
     return sample_rate > p;
 }
 
+struct Metric {
+    std::string type;
+    double value{0};
+    uint64_t count{0};
+};
+
 struct _StatsdClientData {
     SOCKET  sock;
     struct  sockaddr_in server;
@@ -72,6 +82,10 @@ struct _StatsdClientData {
     bool    init;
 
     char    errmsg[1024];
+
+    std::atomic<bool> metrics_enabled{false};
+    mutable Mutex cs_metrics;
+    std::map<std::string, Metric> metrics GUARDED_BY(cs_metrics);
 };
 
 StatsdClient::StatsdClient(const std::string& host, int port, const std::string& ns) :
@@ -170,8 +184,56 @@ int StatsdClient::timing(const std::string& key, size_t ms, float sample_rate)
     return send(key, ms, "ms", sample_rate);
 }
 
+void StatsdClient::setMetricsEnabled(bool enabled)
+{
+    d->metrics_enabled = enabled;
+}
+
+bool StatsdClient::metricsEnabled() const
+{
+    return d->metrics_enabled;
+}
+
+void StatsdClient::record(const std::string& key, double value, const std::string& type)
+{
+    LOCK(d->cs_metrics);
+    Metric& metric = d->metrics[key];
+    metric.type = type;
+    if (type == "g") {
+        metric.value = value;
+    } else {
+        // counters and timings accumulate, timings are exported as a count and a sum
+        metric.value += value;
+        ++metric.count;
+    }
+}
+
+std::string StatsdClient::prometheusMetrics() const
+{
+    std::string ret;
+    LOCK(d->cs_metrics);
+    for (const auto& [key, metric] : d->metrics) {
+        std::string name = "maximus_";
+        for (const char c : key) {
+            name += (isalnum((unsigned char)c) || c == '_') ? c : '_';
+        }
+        if (metric.type == "c") {
+            ret += strprintf("# TYPE %s counter\n%s %.17g\n", name, name, metric.value);
+        } else if (metric.type == "g") {
+            ret += strprintf("# TYPE %s gauge\n%s %.17g\n", name, name, metric.value);
+        } else {
+            ret += strprintf("# TYPE %s summary\n%s_sum %.17g\n%s_count %d\n", name, name, metric.value, name, metric.count);
+        }
+    }
+    return ret;
+}
+
 int StatsdClient::send(std::string key, size_t value, const std::string& type, float sample_rate)
 {
+    if (d->metrics_enabled) {
+        record(key, (double)(ssize_t)value, type);
+    }
+
     if (!should_send(sample_rate)) {
         return 0;
     }
@@ -199,6 +261,10 @@ int StatsdClient::send(std::string key, size_t value, const std::string& type, f
 
 int StatsdClient::sendDouble(std::string key, double value, const std::string& type, float sample_rate)
 {
+    if (d->metrics_enabled) {
+        record(key, value, type);
+    }
+
     if (!should_send(sample_rate)) {
         return 0;
     }
@@ -19,6 +19,9 @@ static const int DEFAULT_STATSD_PERIOD = 60;
 static const int MIN_STATSD_PERIOD = 5;
 static const int MAX_STATSD_PERIOD = 60 * 60;
 
+//! Serve the stats in the Prometheus text format at /metrics on the RPC port
+static const bool DEFAULT_METRICS_ENABLE = false;
+
 namespace statsd {
 
 struct _StatsdClientData;
@@ -41,6 +44,17 @@ class StatsdClient {
         int gaugeDouble(const std::string& key, double value, float sample_rate = 1.0);
         int timing(const std::string& key, size_t ms, float sample_rate = 1.0);
 
+    public:
+        /**
+         * Keep the latest value of every stat in process, in addition to sending it
+         * to statsd: counters are summed, gauges keep their last value and timings
+         * are kept as count and sum.
+         */
+        void setMetricsEnabled(bool enabled);
+        bool metricsEnabled() const;
+        /** The stats kept since setMetricsEnabled(true) in the Prometheus text exposition format */
+        std::string prometheusMetrics() const;
+
     public:
         /**
          * (Low Level Api) manually send a message
@@ -59,6 +73,7 @@ class StatsdClient {
     protected:
         int init();
         static void cleanup(std::string& key);
+        void record(const std::string& key, double value, const std::string& type);
 
     protected:
         std::unique_ptr<struct _StatsdClientData> d;
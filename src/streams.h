@@ -23,6 +23,73 @@
 #include <utility>
 #include <vector>
 
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+namespace util {
+/**
+ * XOR data with key, repeated from its key_offset-th byte on. This runs on every database value, so keys whose size
+ * divides 8, like the obfuscation key, are applied 8 or 16 bytes at a time instead of byte by byte.
+ */
+inline void Xor(Span<std::byte> write, Span<const std::byte> key, size_t key_offset = 0)
+{
+    if (key.size() == 0) {
+        return;
+    }
+    key_offset %= key.size();
+
+    size_t i = 0;
+    if (8 % key.size() == 0 && write.size() >= 8) {
+        // The key rotated to line up with write[0] and repeated, any multiple of 8 bytes further it lines up again
+        uint8_t pattern[16];
+        for (size_t j = 0; j < sizeof(pattern); ++j) {
+            pattern[j] = uint8_t(key[(key_offset + j) % key.size()]);
+        }
+        uint8_t* data = reinterpret_cast<uint8_t*>(write.data());
+#if defined(__SSE2__)
+        const __m128i k = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pattern));
+        for (; i + 32 <= write.size(); i += 32) {
+            const __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+            const __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i + 16));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(data + i), _mm_xor_si128(a, k));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(data + i + 16), _mm_xor_si128(b, k));
+        }
+        for (; i + 16 <= write.size(); i += 16) {
+            const __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(data + i), _mm_xor_si128(a, k));
+        }
+#elif defined(__ARM_NEON)
+        const uint8x16_t k = vld1q_u8(pattern);
+        for (; i + 32 <= write.size(); i += 32) {
+            vst1q_u8(data + i, veorq_u8(vld1q_u8(data + i), k));
+            vst1q_u8(data + i + 16, veorq_u8(vld1q_u8(data + i + 16), k));
+        }
+        for (; i + 16 <= write.size(); i += 16) {
+            vst1q_u8(data + i, veorq_u8(vld1q_u8(data + i), k));
+        }
+#endif
+        uint64_t k64;
+        memcpy(&k64, pattern, sizeof(k64));
+        for (; i + 8 <= write.size(); i += 8) {
+            uint64_t v;
+            memcpy(&v, data + i, sizeof(v));
+            v ^= k64;
+            memcpy(data + i, &v, sizeof(v));
+        }
+    }
+
+    // Whatever is left, or all of it for other key sizes. The key index is advanced instead of computed with a %,
+    // which would be a division for each byte.
+    for (size_t j = (key_offset + i) % key.size(); i < write.size(); ++i) {
+        write[i] ^= key[j++];
+        if (j == key.size()) j = 0;
+    }
+}
+} // namespace util
+
 template<typename Stream>
 class OverrideStream
 {
@@ -198,6 +265,25 @@ public:
         memcpy(dst.data(), m_data.data(), dst.size());
         m_data = m_data.subspan(dst.size());
     }
+
+    /** Skip the next size bytes and return a view of them, valid as long as the underlying data */
+    Span<const std::byte> ReadView(size_t size)
+    {
+        if (size > m_data.size()) {
+            throw std::ios_base::failure("SpanReader::ReadView(): end of data");
+        }
+        Span<const std::byte> ret{AsBytes(m_data.first(size))};
+        m_data = m_data.subspan(size);
+        return ret;
+    }
+
+    void ignore(size_t num_ignore)
+    {
+        if (num_ignore > m_data.size()) {
+            throw std::ios_base::failure("SpanReader::ignore(): end of data");
+        }
+        m_data = m_data.subspan(num_ignore);
+    }
 };
 
 /** Double ended buffer combining vector and stream-like interfaces.
@@ -295,6 +381,21 @@ public:
         m_read_pos = next_read_pos.value();
     }
 
+    /**
+     * Skip the next size bytes and return a view of them. Unlike read(), this never releases the
+     * buffer, so the view stays valid until the stream is written to or cleared.
+     */
+    Span<const value_type> ReadView(size_t size)
+    {
+        auto next_read_pos{CheckedAdd(m_read_pos, size)};
+        if (!next_read_pos.has_value() || next_read_pos.value() > vch.size()) {
+            throw std::ios_base::failure("DataStream::ReadView(): end of data");
+        }
+        Span<const value_type> ret{vch.data() + m_read_pos, size};
+        m_read_pos = next_read_pos.value();
+        return ret;
+    }
+
     void ignore(size_t num_ignore)
     {
         // Ignore from the beginning of the buffer
@@ -347,20 +448,7 @@ public:
      */
     void Xor(const std::vector<unsigned char>& key)
     {
-        if (key.size() == 0) {
-            return;
-        }
-
-        for (size_type i = 0, j = 0; i != size(); i++) {
-            vch[i] ^= std::byte{key[j++]};
-
-            // This potentially acts on very many bytes of data, so it's
-            // important that we calculate `j`, i.e. the `key` index in this
-            // way instead of doing a %, which would effectively be a division
-            // for each byte Xor'd -- much slower than need be.
-            if (j == key.size())
-                j = 0;
-        }
+        util::Xor(MakeWritableByteSpan(*this), MakeByteSpan(key));
     }
 };
 
@@ -13,6 +13,8 @@
 #include <util/strencodings.h>
 #include <util/threadnames.h>
 
+#include <algorithm>
+#include <chrono>
 #include <map>
 #include <mutex>
 #include <set>
@@ -33,6 +35,153 @@ void PrintLockContention(const char* pszName, const char* pszFile, int nLine)
 }
 #endif /* DEBUG_LOCKCONTENTION */
 
+std::atomic<bool> g_lock_stats_enabled{false};
+
+//
+// Lock contention profiling.
+// Call sites are registered lock-free in a fixed open-addressing table keyed by the
+// name and __FILE__ pointers and the line of the LOCK() macro, so recording never takes a lock itself.
+//
+
+struct LockSite {
+    std::atomic<uint64_t> key{0};
+    std::atomic<const char*> name{nullptr};
+    std::atomic<const char*> file{nullptr};
+    std::atomic<int> line{0};
+    std::atomic<uint64_t> samples{0};
+    std::atomic<uint64_t> contentions{0};
+    std::atomic<uint64_t> wait_us{0};
+    std::atomic<uint64_t> max_wait_us{0};
+    std::atomic<uint64_t> holds{0};
+    std::atomic<uint64_t> hold_us{0};
+    std::array<std::atomic<uint64_t>, LOCK_STATS_HISTOGRAM_BUCKETS> wait_histogram{};
+    std::array<std::atomic<uint64_t>, LOCK_STATS_HISTOGRAM_BUCKETS> hold_histogram{};
+};
+
+static constexpr size_t LOCK_SITE_TABLE_SIZE{4096};
+static constexpr size_t LOCK_SITE_MAX_PROBES{64};
+static LockSite g_lock_sites[LOCK_SITE_TABLE_SIZE];
+
+static size_t LockStatsBucket(uint64_t us)
+{
+    size_t bucket{0};
+    for (us >>= 1; us > 0 && bucket + 1 < LOCK_STATS_HISTOGRAM_BUCKETS; us >>= 1) ++bucket;
+    return bucket;
+}
+
+LockSite* LockStatsSite(const char* pszName, const char* pszFile, int nLine)
+{
+    // LOCK2() places two sites on one line, so the lock name is part of the key
+    const uint64_t key = ((reinterpret_cast<uintptr_t>(pszFile) * 0x9E3779B97F4A7C15ULL) ^
+                          (reinterpret_cast<uintptr_t>(pszName) * 0xC2B2AE3D27D4EB4FULL) ^ static_cast<uint32_t>(nLine)) | 1;
+    const size_t start = (key ^ (key >> 32)) % LOCK_SITE_TABLE_SIZE;
+    for (size_t probe = 0; probe < LOCK_SITE_MAX_PROBES; ++probe) {
+        LockSite& site = g_lock_sites[(start + probe) % LOCK_SITE_TABLE_SIZE];
+        uint64_t current = site.key.load(std::memory_order_acquire);
+        if (current == 0) {
+            if (site.key.compare_exchange_strong(current, key, std::memory_order_acq_rel)) {
+                site.name.store(pszName, std::memory_order_relaxed);
+                site.line.store(nLine, std::memory_order_relaxed);
+                site.file.store(pszFile, std::memory_order_release);
+                return &site;
+            }
+        }
+        if (current == key) return &site;
+    }
+    return nullptr;
+}
+
+bool LockStatsShouldSample()
+{
+    static thread_local uint32_t acquisitions{0};
+    return ++acquisitions % LOCK_STATS_SAMPLE_RATE == 0;
+}
+
+int64_t LockStatsNowMicros()
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void LockStatsRecordSample(LockSite* site)
+{
+    site->samples.fetch_add(1, std::memory_order_relaxed);
+}
+
+void LockStatsRecordWait(LockSite* site, int64_t wait_us)
+{
+    const uint64_t us = std::max<int64_t>(wait_us, 0);
+    site->contentions.fetch_add(1, std::memory_order_relaxed);
+    site->wait_us.fetch_add(us, std::memory_order_relaxed);
+    site->wait_histogram[LockStatsBucket(us)].fetch_add(1, std::memory_order_relaxed);
+    uint64_t max = site->max_wait_us.load(std::memory_order_relaxed);
+    while (us > max && !site->max_wait_us.compare_exchange_weak(max, us, std::memory_order_relaxed)) {}
+}
+
+void LockStatsRecordHold(LockSite* site, int64_t hold_us)
+{
+    const uint64_t us = std::max<int64_t>(hold_us, 0);
+    site->holds.fetch_add(1, std::memory_order_relaxed);
+    site->hold_us.fetch_add(us, std::memory_order_relaxed);
+    site->hold_histogram[LockStatsBucket(us)].fetch_add(1, std::memory_order_relaxed);
+}
+
+std::vector<LockSiteStats> GetLockStats()
+{
+    std::vector<LockSiteStats> ret;
+    for (const LockSite& site : g_lock_sites) {
+        const char* file = site.file.load(std::memory_order_acquire);
+        if (file == nullptr) continue;
+        LockSiteStats stats;
+        stats.samples = site.samples.load(std::memory_order_relaxed);
+        stats.contentions = site.contentions.load(std::memory_order_relaxed);
+        stats.holds = site.holds.load(std::memory_order_relaxed);
+        if (stats.samples == 0 && stats.contentions == 0 && stats.holds == 0) continue;
+        stats.lock_name = site.name.load(std::memory_order_relaxed);
+        stats.file = file;
+        stats.line = site.line.load(std::memory_order_relaxed);
+        stats.wait_us = site.wait_us.load(std::memory_order_relaxed);
+        stats.max_wait_us = site.max_wait_us.load(std::memory_order_relaxed);
+        stats.hold_us = site.hold_us.load(std::memory_order_relaxed);
+        for (size_t i = 0; i < LOCK_STATS_HISTOGRAM_BUCKETS; ++i) {
+            stats.wait_histogram[i] = site.wait_histogram[i].load(std::memory_order_relaxed);
+            stats.hold_histogram[i] = site.hold_histogram[i].load(std::memory_order_relaxed);
+        }
+        ret.push_back(std::move(stats));
+    }
+    return ret;
+}
+
+void MergeLockStats(LockSiteStats& into, const LockSiteStats& from)
+{
+    into.samples += from.samples;
+    into.contentions += from.contentions;
+    into.wait_us += from.wait_us;
+    into.max_wait_us = std::max(into.max_wait_us, from.max_wait_us);
+    into.holds += from.holds;
+    into.hold_us += from.hold_us;
+    for (size_t i = 0; i < LOCK_STATS_HISTOGRAM_BUCKETS; ++i) {
+        into.wait_histogram[i] += from.wait_histogram[i];
+        into.hold_histogram[i] += from.hold_histogram[i];
+    }
+}
+
+void ResetLockStats()
+{
+    // Registered call sites stay in the table, only their counters are cleared
+    for (LockSite& site : g_lock_sites) {
+        site.samples.store(0, std::memory_order_relaxed);
+        site.contentions.store(0, std::memory_order_relaxed);
+        site.wait_us.store(0, std::memory_order_relaxed);
+        site.max_wait_us.store(0, std::memory_order_relaxed);
+        site.holds.store(0, std::memory_order_relaxed);
+        site.hold_us.store(0, std::memory_order_relaxed);
+        for (size_t i = 0; i < LOCK_STATS_HISTOGRAM_BUCKETS; ++i) {
+            site.wait_histogram[i].store(0, std::memory_order_relaxed);
+            site.hold_histogram[i].store(0, std::memory_order_relaxed);
+        }
+    }
+}
+
 #ifdef DEBUG_LOCKORDER
 //
 // Early deadlock detection.
@@ -9,10 +9,14 @@
 #include <threadsafety.h>
 #include <util/macros.h>
 
+#include <array>
+#include <atomic>
 #include <condition_variable>
+#include <cstdint>
 #include <mutex>
 #include <string>
 #include <thread>
+#include <vector>
 
 /////////////////////////////////////////////////
 //                                             //
@@ -128,14 +132,67 @@ typedef AnnotatedMixin<std::mutex> Mutex;
 void PrintLockContention(const char* pszName, const char* pszFile, int nLine);
 #endif
 
+/**
+ * Lock contention profiling, enabled at runtime with -lockstats.
+ *
+ * Every contended acquisition through LOCK()/WAIT_LOCK() records its wait and
+ * hold time against the call site. One in LOCK_STATS_SAMPLE_RATE uncontended
+ * acquisitions is sampled for its hold time as well. When disabled, the cost is
+ * a single relaxed atomic load per acquisition.
+ */
+static constexpr bool DEFAULT_LOCKSTATS{false};
+static constexpr uint32_t LOCK_STATS_SAMPLE_RATE{16};
+//! Wait and hold time histograms use log2 buckets of microseconds: <2us, <4us, ..., the last one open-ended
+static constexpr size_t LOCK_STATS_HISTOGRAM_BUCKETS{24};
+
+extern std::atomic<bool> g_lock_stats_enabled;
+
+struct LockSite;
+
+struct LockSiteStats {
+    std::string lock_name;
+    std::string file;
+    int line{0};
+    //! Uncontended acquisitions that were sampled
+    uint64_t samples{0};
+    uint64_t contentions{0};
+    uint64_t wait_us{0};
+    uint64_t max_wait_us{0};
+    //! Number of timed holds and their total duration
+    uint64_t holds{0};
+    uint64_t hold_us{0};
+    std::array<uint64_t, LOCK_STATS_HISTOGRAM_BUCKETS> wait_histogram{};
+    std::array<uint64_t, LOCK_STATS_HISTOGRAM_BUCKETS> hold_histogram{};
+};
+
+/** Find or register the stats slot of a lock call site, nullptr if the table is full */
+LockSite* LockStatsSite(const char* pszName, const char* pszFile, int nLine);
+bool LockStatsShouldSample();
+int64_t LockStatsNowMicros();
+void LockStatsRecordSample(LockSite* site);
+void LockStatsRecordWait(LockSite* site, int64_t wait_us);
+void LockStatsRecordHold(LockSite* site, int64_t hold_us);
+/** Snapshot of all call sites that recorded anything */
+std::vector<LockSiteStats> GetLockStats();
+/** Fold the counters of one call site into another, e.g. to get per-lock totals */
+void MergeLockStats(LockSiteStats& into, const LockSiteStats& from);
+void ResetLockStats();
+
 /** Wrapper around std::unique_lock style lock for Mutex. */
 template <typename Mutex, typename Base = typename Mutex::UniqueLock>
 class SCOPED_LOCKABLE UniqueLock : public Base
 {
 private:
+    LockSite* m_stats_site{nullptr};
+    int64_t m_stats_acquired{0};
+
     void Enter(const char* pszName, const char* pszFile, int nLine)
     {
         EnterCritical(pszName, pszFile, nLine, Base::mutex());
+        if (g_lock_stats_enabled.load(std::memory_order_relaxed)) {
+            ProfiledEnter(pszName, pszFile, nLine);
+            return;
+        }
 #ifdef DEBUG_LOCKCONTENTION
         if (!Base::try_lock()) {
             PrintLockContention(pszName, pszFile, nLine);
@@ -146,6 +203,34 @@ private:
 #endif
     }
 
+    void ProfiledEnter(const char* pszName, const char* pszFile, int nLine)
+    {
+        if (Base::try_lock()) {
+            if (LockStatsShouldSample() && (m_stats_site = LockStatsSite(pszName, pszFile, nLine))) {
+                LockStatsRecordSample(m_stats_site);
+                m_stats_acquired = LockStatsNowMicros();
+            }
+            return;
+        }
+#ifdef DEBUG_LOCKCONTENTION
+        PrintLockContention(pszName, pszFile, nLine);
+#endif
+        const int64_t wait_start = LockStatsNowMicros();
+        Base::lock();
+        m_stats_acquired = LockStatsNowMicros();
+        if ((m_stats_site = LockStatsSite(pszName, pszFile, nLine))) {
+            LockStatsRecordWait(m_stats_site, m_stats_acquired - wait_start);
+        }
+    }
+
+    void StatsRelease()
+    {
+        if (m_stats_site) {
+            LockStatsRecordHold(m_stats_site, LockStatsNowMicros() - m_stats_acquired);
+            m_stats_site = nullptr;
+        }
+    }
+
     bool TryEnter(const char* pszName, const char* pszFile, int nLine)
     {
         EnterCritical(pszName, pszFile, nLine, Base::mutex(), true);
@@ -178,8 +263,10 @@ public:
 
     ~UniqueLock() UNLOCK_FUNCTION()
     {
-        if (Base::owns_lock())
+        if (Base::owns_lock()) {
+            StatsRelease();
             LeaveCritical();
+        }
     }
 
     operator bool()
@@ -199,6 +286,7 @@ public:
     public:
         explicit reverse_lock(UniqueLock& _lock, const char* _guardname, const char* _file, int _line) : lock(_lock), file(_file), line(_line) {
             CheckLastCritical((void*)lock.mutex(), lockname, _guardname, _file, _line);
+            lock.StatsRelease();
             lock.unlock();
             LeaveCritical();
             lock.swap(templock);
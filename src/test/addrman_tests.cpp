@@ -262,6 +262,30 @@ BOOST_AUTO_TEST_CASE(addrman_select)
     BOOST_CHECK_EQUAL(ports.size(), 3U);
 }
 
+BOOST_AUTO_TEST_CASE(addrman_select_sparse)
+{
+    CAddrManTest addrman;
+
+    // One entry in each table, Select has to find them without probing the empty positions.
+    CService addr1 = ResolveService("250.1.1.1", 8333);
+    CService addr2 = ResolveService("250.1.1.2", 9999);
+    BOOST_CHECK(addrman.Add(CAddress(addr1, NODE_NONE), ResolveIP("252.2.2.2")));
+    BOOST_CHECK(addrman.Add(CAddress(addr2, NODE_NONE), ResolveIP("252.2.2.2")));
+    addrman.Good(CAddress(addr2, NODE_NONE));
+
+    std::set<uint16_t> ports;
+    for (int i = 0; i < 50; ++i) {
+        ports.insert(addrman.Select().GetPort());
+        BOOST_CHECK_EQUAL(addrman.Select(/* newOnly */ true).ToString(), "250.1.1.1:8333");
+    }
+    BOOST_CHECK_EQUAL(ports.size(), 2U);
+
+    // Moving the last new entry to tried leaves nothing to select from the new table.
+    addrman.Good(CAddress(addr1, NODE_NONE));
+    BOOST_CHECK_EQUAL(addrman.Select(/* newOnly */ true).ToString(), "[::]:0");
+    BOOST_CHECK_EQUAL(addrman.size(), 2U);
+}
+
 BOOST_AUTO_TEST_CASE(addrman_new_collisions)
 {
     CAddrManTest addrman;
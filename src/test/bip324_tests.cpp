@@ -0,0 +1,146 @@
+// Copyright (c) 2024 The Maximus developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <bip324.h>
+#include <key.h>
+#include <protocol.h>
+#include <random.h>
+#include <test/util/setup_common.h>
+#include <uint256.h>
+
+#include <vector>
+
+#include <boost/test/unit_test.hpp>
+
+BOOST_FIXTURE_TEST_SUITE(bip324_tests, BasicTestingSetup)
+
+namespace {
+
+CKey NewKey()
+{
+    CKey key;
+    key.MakeNewKey(true);
+    return key;
+}
+
+std::vector<std::byte> RandomBytes(size_t len)
+{
+    std::vector<std::byte> ret(len);
+    for (auto& b : ret) {
+        b = std::byte(InsecureRandBits(8));
+    }
+    return ret;
+}
+
+/** Send a packet from sender to receiver, returning the encrypted packet. */
+std::vector<std::byte> SendPacket(BIP324Cipher& sender, BIP324Cipher& receiver, Span<const std::byte> contents, Span<const std::byte> aad, bool ignore)
+{
+    std::vector<std::byte> packet(contents.size() + BIP324Cipher::EXPANSION);
+    sender.Encrypt(contents, aad, ignore, packet);
+
+    const uint32_t len = receiver.DecryptLength(Span{packet}.first(BIP324Cipher::LENGTH_LEN));
+    BOOST_CHECK_EQUAL(len, contents.size());
+
+    std::vector<std::byte> decrypted(len);
+    bool decrypted_ignore{!ignore};
+    BOOST_CHECK(receiver.Decrypt(Span{packet}.subspan(BIP324Cipher::LENGTH_LEN), aad, decrypted_ignore, decrypted));
+    BOOST_CHECK(decrypted == std::vector<std::byte>(contents.begin(), contents.end()));
+    BOOST_CHECK_EQUAL(decrypted_ignore, ignore);
+    return packet;
+}
+
+} // namespace
+
+BOOST_AUTO_TEST_CASE(bip324_roundtrip)
+{
+    const uint256 ent_initiator = InsecureRand256(), ent_responder = InsecureRand256();
+    BIP324Cipher initiator(NewKey(), AsBytes(Span{ent_initiator}));
+    BIP324Cipher responder(NewKey(), AsBytes(Span{ent_responder}));
+    BOOST_CHECK(!initiator && !responder);
+
+    initiator.Initialize(responder.GetOurPubKey(), true);
+    responder.Initialize(initiator.GetOurPubKey(), false);
+    BOOST_CHECK(initiator && responder);
+
+    BOOST_CHECK(std::equal(initiator.GetSessionID().begin(), initiator.GetSessionID().end(), responder.GetSessionID().begin()));
+    BOOST_CHECK(std::equal(initiator.GetSendGarbageTerminator().begin(), initiator.GetSendGarbageTerminator().end(), responder.GetReceiveGarbageTerminator().begin()));
+    BOOST_CHECK(std::equal(responder.GetSendGarbageTerminator().begin(), responder.GetSendGarbageTerminator().end(), initiator.GetReceiveGarbageTerminator().begin()));
+    BOOST_CHECK(!std::equal(initiator.GetSendGarbageTerminator().begin(), initiator.GetSendGarbageTerminator().end(), initiator.GetReceiveGarbageTerminator().begin()));
+
+    // Enough packets in both directions to go through a few rekeys
+    const auto garbage = RandomBytes(InsecureRandRange(100));
+    for (unsigned i = 0; i < BIP324Cipher::REKEY_INTERVAL * 3; ++i) {
+        const auto contents = RandomBytes(InsecureRandRange(i % 16 == 0 ? 5000 : 100));
+        const bool ignore = InsecureRandBool();
+        // As in the handshake, the garbage is authenticated with the first packet
+        const Span<const std::byte> aad = i == 0 ? Span<const std::byte>{garbage} : Span<const std::byte>{};
+        if (InsecureRandBool()) {
+            SendPacket(initiator, responder, contents, aad, ignore);
+        } else {
+            SendPacket(responder, initiator, contents, aad, ignore);
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(bip324_self_decrypt)
+{
+    const uint256 ent = InsecureRand256(), ent_other = InsecureRand256();
+    BIP324Cipher cipher(NewKey(), AsBytes(Span{ent}));
+    const BIP324Cipher other(NewKey(), AsBytes(Span{ent_other}));
+    cipher.Initialize(other.GetOurPubKey(), true, /*self_decrypt=*/true);
+    BOOST_CHECK(std::equal(cipher.GetSendGarbageTerminator().begin(), cipher.GetSendGarbageTerminator().end(), cipher.GetReceiveGarbageTerminator().begin()));
+
+    for (int i = 0; i < 10; ++i) {
+        SendPacket(cipher, cipher, RandomBytes(InsecureRandRange(100)), {}, false);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(bip324_tampering)
+{
+    const uint256 ent_initiator = InsecureRand256(), ent_responder = InsecureRand256();
+    BIP324Cipher initiator(NewKey(), AsBytes(Span{ent_initiator}));
+    BIP324Cipher responder(NewKey(), AsBytes(Span{ent_responder}));
+    initiator.Initialize(responder.GetOurPubKey(), true);
+    responder.Initialize(initiator.GetOurPubKey(), false);
+
+    const auto contents = RandomBytes(64);
+    std::vector<std::byte> packet(contents.size() + BIP324Cipher::EXPANSION);
+    initiator.Encrypt(contents, {}, false, packet);
+
+    // Flip a bit in the authenticated part of the packet
+    packet[BIP324Cipher::LENGTH_LEN + InsecureRandRange(packet.size() - BIP324Cipher::LENGTH_LEN)] ^= std::byte(1 << InsecureRandBits(3));
+    BOOST_CHECK_EQUAL(responder.DecryptLength(Span{packet}.first(BIP324Cipher::LENGTH_LEN)), contents.size());
+    std::vector<std::byte> decrypted(contents.size());
+    bool ignore;
+    BOOST_CHECK(!responder.Decrypt(Span{packet}.subspan(BIP324Cipher::LENGTH_LEN), {}, ignore, decrypted));
+}
+
+BOOST_AUTO_TEST_CASE(v2_short_message_ids)
+{
+    // Ids assigned by BIP324
+    BOOST_CHECK_EQUAL(*GetV2ShortMessageId(NetMsgType::ADDR), 1);
+    BOOST_CHECK_EQUAL(*GetV2ShortMessageId(NetMsgType::INV), 14);
+    BOOST_CHECK_EQUAL(*GetV2ShortMessageId(NetMsgType::ADDRV2), 28);
+    BOOST_CHECK(!GetV2MessageType(0));
+    BOOST_CHECK(!GetV2MessageType(5));
+
+    // Frequent Maximus messages fit in one byte as well
+    for (const char* msg_type : {NetMsgType::QSIGSHARE, NetMsgType::QBSIGSHARES, NetMsgType::ISDLOCK, NetMsgType::CLSIG, NetMsgType::DSQUEUE, NetMsgType::MNGOVERNANCEOBJECTVOTE}) {
+        const auto id = GetV2ShortMessageId(msg_type);
+        BOOST_REQUIRE(id);
+        BOOST_CHECK(*id >= V2_MAXIMUS_SHORT_ID_START);
+    }
+    BOOST_CHECK(!GetV2ShortMessageId(NetMsgType::VERSION));
+
+    // Every assigned id maps back to its message type, and only known types have one
+    const auto& all_types = getAllNetMessageTypes();
+    for (int id = 0; id < 256; ++id) {
+        const auto msg_type = GetV2MessageType(id);
+        if (!msg_type) continue;
+        BOOST_CHECK(std::find(all_types.begin(), all_types.end(), *msg_type) != all_types.end());
+        BOOST_CHECK_EQUAL(*GetV2ShortMessageId(*msg_type), id);
+    }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -19,6 +19,7 @@
 #include <test/util/blockfilter.h>
 #include <test/util/index.h>
 #include <test/util/setup_common.h>
+#include <util/string.h>
 #include <validation.h>
 
 #include <boost/test/unit_test.hpp>
@@ -268,6 +269,30 @@ BOOST_FIXTURE_TEST_CASE(blockfilter_index_initial_sync, BuildChainTestingSetup)
     filter_index.Stop();
 }
 
+BOOST_FIXTURE_TEST_CASE(blockfilter_index_sync_threads, BuildChainTestingSetup)
+{
+    // The initial sync reads the blocks on the sync thread itself and builds every filter in
+    // WriteBlock, blockfilter_index_initial_sync covers the reader threads and PrepareBlock
+    gArgs.ForceSetArg("-indexsyncthreads", "0");
+    BlockFilterIndex filter_index(BlockFilterType::BASIC_FILTER, 1 << 20, true);
+    BOOST_REQUIRE(filter_index.Start(::ChainstateActive()));
+    IndexWaitSynced(filter_index);
+
+    {
+        LOCK(cs_main);
+        uint256 last_header;
+        for (const CBlockIndex* block_index = ::ChainActive().Genesis();
+             block_index != nullptr;
+             block_index = ::ChainActive().Next(block_index)) {
+            CheckFilterLookups(filter_index, block_index, last_header);
+        }
+    }
+
+    filter_index.Interrupt();
+    filter_index.Stop();
+    gArgs.ForceSetArg("-indexsyncthreads", ToString(DEFAULT_INDEX_SYNC_THREADS));
+}
+
 BOOST_FIXTURE_TEST_CASE(blockfilter_index_init_destroy, BasicTestingSetup)
 {
     BlockFilterIndex* filter_index;
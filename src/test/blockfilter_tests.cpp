@@ -10,6 +10,7 @@
 #include <serialize.h>
 #include <streams.h>
 #include <univalue.h>
+#include <util/golombrice.h>
 #include <util/strencodings.h>
 
 #include <boost/test/unit_test.hpp>
@@ -39,6 +40,61 @@ BOOST_AUTO_TEST_CASE(gcsfilter_test)
     }
 }
 
+BOOST_AUTO_TEST_CASE(gcsfilter_golomb_rice_coding)
+{
+    FastRandomContext rng(true);
+    for (uint8_t P : {0, 1, 19, 56, 57, 63}) {
+        std::vector<uint64_t> values(200);
+        for (auto& value : values) {
+            // Mostly small quotients, a few long runs of unary ones
+            value = (rng.randrange(rng.randrange(10) ? 4 : 200) << P) | (P ? rng.randbits(P) : 0);
+        }
+
+        std::vector<unsigned char> expected, encoded;
+        {
+            CVectorWriter stream(SER_NETWORK, 0, expected, 0);
+            BitStreamWriter<CVectorWriter> bitwriter(stream);
+            for (uint64_t value : values) GolombRiceEncode(bitwriter, P, value);
+            bitwriter.Flush();
+        }
+        GolombRiceWriter writer{encoded, P};
+        for (uint64_t value : values) writer.Encode(value);
+        writer.Flush();
+        BOOST_CHECK(encoded == expected);
+
+        GolombRiceReader reader{encoded, P};
+        for (uint64_t value : values) BOOST_CHECK_EQUAL(reader.Decode(), value);
+        BOOST_CHECK_EQUAL(reader.BytesRead(), encoded.size());
+        if (P > 0) {
+            // Reading past the end fails like the bit stream does
+            BOOST_CHECK_THROW(reader.Decode(), std::ios_base::failure);
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(gcsfilter_decoded_copies)
+{
+    GCSFilter::ElementSet elements;
+    for (int i = 0; i < 1000; ++i) {
+        GCSFilter::Element element(32);
+        element[0] = i;
+        element[1] = i >> 8;
+        elements.insert(std::move(element));
+    }
+    GCSFilter filter({0, 0, 19, 784931}, elements);
+    GCSFilter::Element element(*elements.begin());
+    // Copies taken before and after the filter was decoded match the same
+    GCSFilter copy_before(filter);
+    BOOST_CHECK(filter.Match(element));
+    GCSFilter copy_after(filter);
+    BOOST_CHECK(copy_before.Match(element));
+    BOOST_CHECK(copy_after.MatchAny(elements));
+
+    GCSFilter reconstructed(filter.GetParams(), filter.GetEncoded());
+    BOOST_CHECK(reconstructed.GetEncoded() == filter.GetEncoded());
+    BOOST_CHECK(reconstructed.MatchAny(elements));
+}
+
 BOOST_AUTO_TEST_CASE(gcsfilter_default_constructor)
 {
     GCSFilter filter;
@@ -0,0 +1,133 @@
+// Copyright (c) 2024 The Maximus developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <chain.h>
+#include <fs.h>
+#include <node/blockindexsnapshot.h>
+#include <random.h>
+#include <txdb.h>
+#include <util/system.h>
+#include <validation.h>
+
+#include <test/util/setup_common.h>
+
+#include <boost/test/unit_test.hpp>
+
+#include <algorithm>
+#include <map>
+#include <memory>
+
+BOOST_FIXTURE_TEST_SUITE(blockindexsnapshot_tests, TestChain100Setup)
+
+// Entries created by ReadBlockIndexSnapshot, owned by the test
+struct SnapshotIndex {
+    std::map<uint256, std::unique_ptr<CBlockIndex>> entries;
+
+    CBlockIndex* Insert(const uint256& hash)
+    {
+        auto& entry = entries[hash];
+        if (!entry) {
+            entry = std::make_unique<CBlockIndex>();
+            entry->phashBlock = &entries.find(hash)->first;
+        }
+        return entry.get();
+    }
+
+    bool Read(const fs::path& path, const uint256& marker, std::vector<CBlockIndex*>& sorted)
+    {
+        entries.clear();
+        return ReadBlockIndexSnapshot(path, marker, [this](const uint256& hash) { return Insert(hash); }, sorted);
+    }
+};
+
+static std::vector<const CBlockIndex*> SortedBlockIndex(const BlockMap& block_index)
+{
+    std::vector<const CBlockIndex*> sorted;
+    for (const auto& [hash, pindex] : block_index) {
+        sorted.push_back(pindex);
+    }
+    std::sort(sorted.begin(), sorted.end(), [](const CBlockIndex* a, const CBlockIndex* b) { return a->nHeight < b->nHeight; });
+    return sorted;
+}
+
+BOOST_AUTO_TEST_CASE(snapshot_roundtrip)
+{
+    const fs::path path = GetDataDir() / "blockindex_test.dat";
+    const uint256 marker = GetRandHash();
+    LOCK(cs_main);
+    const auto expected = SortedBlockIndex(m_node.chainman->BlockIndex());
+    BOOST_REQUIRE(WriteBlockIndexSnapshot(path, expected, marker));
+
+    SnapshotIndex index;
+    std::vector<CBlockIndex*> sorted;
+    BOOST_REQUIRE(index.Read(path, marker, sorted));
+    BOOST_REQUIRE_EQUAL(sorted.size(), expected.size());
+    for (size_t i = 0; i < sorted.size(); i++) {
+        const CBlockIndex* a = expected[i];
+        const CBlockIndex* b = sorted[i];
+        BOOST_CHECK(a->GetBlockHash() == b->GetBlockHash());
+        BOOST_CHECK((a->pprev ? a->pprev->GetBlockHash() : uint256()) == (b->pprev ? b->pprev->GetBlockHash() : uint256()));
+        BOOST_CHECK_EQUAL(a->nHeight, b->nHeight);
+        BOOST_CHECK_EQUAL(a->nFile, b->nFile);
+        BOOST_CHECK_EQUAL(a->nDataPos, b->nDataPos);
+        BOOST_CHECK_EQUAL(a->nUndoPos, b->nUndoPos);
+        BOOST_CHECK(a->nChainWork == b->nChainWork);
+        BOOST_CHECK_EQUAL(a->nTx, b->nTx);
+        BOOST_CHECK_EQUAL(a->nStatus, b->nStatus);
+        BOOST_CHECK_EQUAL(a->nVersion, b->nVersion);
+        BOOST_CHECK(a->hashMerkleRoot == b->hashMerkleRoot);
+        BOOST_CHECK_EQUAL(a->nTime, b->nTime);
+        BOOST_CHECK_EQUAL(a->nBits, b->nBits);
+        BOOST_CHECK_EQUAL(a->nNonce, b->nNonce);
+    }
+
+    // A snapshot of another block index database is ignored
+    BOOST_CHECK(!index.Read(path, GetRandHash(), sorted));
+
+    // Corrupt snapshots are rejected
+    std::vector<uint8_t> data(fs::file_size(path));
+    {
+        FILE* file = fsbridge::fopen(path, "rb");
+        BOOST_REQUIRE(fread(data.data(), 1, data.size(), file) == data.size());
+        fclose(file);
+    }
+    const auto write_modified = [&](const std::vector<uint8_t>& modified) {
+        FILE* file = fsbridge::fopen(path, "wb");
+        BOOST_REQUIRE(fwrite(modified.data(), 1, modified.size(), file) == modified.size());
+        fclose(file);
+    };
+    auto flipped = data;
+    flipped[data.size() / 2] ^= 1;
+    write_modified(flipped);
+    BOOST_CHECK(!index.Read(path, marker, sorted));
+    write_modified(std::vector<uint8_t>(data.begin(), data.end() - 1));
+    BOOST_CHECK(!index.Read(path, marker, sorted));
+
+    fs::remove(path);
+    BOOST_CHECK(!index.Read(path, marker, sorted));
+}
+
+BOOST_AUTO_TEST_CASE(snapshot_marker)
+{
+    LOCK(cs_main);
+    // Entries waiting to be flushed would be missing from the database
+    m_node.chainman->ActiveChainstate().ForceFlushStateToDisk();
+    BOOST_REQUIRE(m_node.chainman->m_blockman.WriteBlockIndexSnapshot(*pblocktree));
+
+    uint256 marker;
+    BOOST_REQUIRE(pblocktree->ReadBlockIndexSnapshotMarker(marker));
+    SnapshotIndex index;
+    std::vector<CBlockIndex*> sorted;
+    BOOST_CHECK(index.Read(GetDataDir() / BLOCK_INDEX_SNAPSHOT_FILENAME, marker, sorted));
+    BOOST_CHECK_EQUAL(sorted.size(), m_node.chainman->BlockIndex().size());
+
+    // A new snapshot replaces the marker
+    BOOST_REQUIRE(m_node.chainman->m_blockman.WriteBlockIndexSnapshot(*pblocktree));
+    BOOST_CHECK(!index.Read(GetDataDir() / BLOCK_INDEX_SNAPSHOT_FILENAME, marker, sorted));
+
+    BOOST_CHECK(pblocktree->EraseBlockIndexSnapshotMarker());
+    BOOST_CHECK(!pblocktree->ReadBlockIndexSnapshotMarker(marker));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,89 @@
+// Copyright (c) 2024 The Maximus developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <chain.h>
+#include <chainparams.h>
+#include <flatfile.h>
+#include <node/blockstorage.h>
+#include <primitives/block.h>
+#include <streams.h>
+#include <validation.h>
+
+#include <test/util/setup_common.h>
+
+#include <boost/test/unit_test.hpp>
+
+BOOST_FIXTURE_TEST_SUITE(blockstorage_tests, TestChain100Setup)
+
+BOOST_AUTO_TEST_CASE(read_raw_block)
+{
+    const CChainParams& chainparams = Params();
+
+    for (int height = 0; height <= 100; ++height) {
+        const CBlockIndex* pindex = WITH_LOCK(cs_main, return m_node.chainman->ActiveChain()[height]);
+        const FlatFilePos pos = WITH_LOCK(cs_main, return pindex->GetBlockPos());
+
+        const auto raw_block = ReadRawBlockFromDisk(pos, chainparams.MessageStart());
+        BOOST_REQUIRE(raw_block);
+
+        // The raw block is the block as serialized for peers
+        CBlock block;
+        BOOST_REQUIRE(ReadBlockFromDisk(block, pindex, chainparams.GetConsensus()));
+        CDataStream ss(SER_NETWORK, PROTOCOL_VERSION);
+        ss << block;
+        BOOST_CHECK(MakeUCharSpan(ss) == Span{*raw_block});
+
+        // Reading it again is served from the cache
+        BOOST_CHECK(ReadRawBlockFromDisk(pos, chainparams.MessageStart()) == raw_block);
+
+        CBlockHeader header;
+        BOOST_REQUIRE(ReadBlockHeaderFromDisk(header, pindex, chainparams.GetConsensus()));
+        BOOST_CHECK(header.GetHash() == block.GetHash());
+    }
+
+    const FlatFilePos tip_pos = WITH_LOCK(cs_main, return m_node.chainman->ActiveChain().Tip()->GetBlockPos());
+    const auto raw_tip = ReadRawBlockFromDisk(tip_pos, chainparams.MessageStart());
+    BOOST_REQUIRE(raw_tip);
+
+    // Dropping the cached blocks of the file reads them from disk again
+    EraseBlockReadCache(tip_pos.nFile);
+    const auto reread_tip = ReadRawBlockFromDisk(tip_pos, chainparams.MessageStart());
+    BOOST_REQUIRE(reread_tip);
+    BOOST_CHECK(reread_tip != raw_tip);
+    BOOST_CHECK(*reread_tip == *raw_tip);
+
+    // Positions which don't hold a block
+    BOOST_CHECK(!ReadRawBlockFromDisk(FlatFilePos{tip_pos.nFile, 0}, chainparams.MessageStart()));
+    BOOST_CHECK(!ReadRawBlockFromDisk(FlatFilePos{tip_pos.nFile, tip_pos.nPos + 1}, chainparams.MessageStart()));
+}
+
+struct MappedBlockFilesSetup : public TestChainSetup {
+    // Small block files, so that the chain spans several of them
+    MappedBlockFilesSetup() : TestChainSetup(300, {"-fastprune", "-blockmmap"}) {}
+};
+
+BOOST_FIXTURE_TEST_CASE(read_mapped_block, MappedBlockFilesSetup)
+{
+    const CChainParams& chainparams = Params();
+    const int tip_file = WITH_LOCK(cs_main, return m_node.chainman->ActiveChain().Tip()->GetBlockPos().nFile);
+    BOOST_CHECK(tip_file > 0);
+
+    // Blocks of the finalized files are read from their mapping, the others from the file, with the same result
+    for (int height = 0; height <= 300; ++height) {
+        const CBlockIndex* pindex = WITH_LOCK(cs_main, return m_node.chainman->ActiveChain()[height]);
+        const FlatFilePos pos = WITH_LOCK(cs_main, return pindex->GetBlockPos());
+        EraseBlockReadCache(pos.nFile);
+
+        const auto raw_block = ReadRawBlockFromDisk(pos, chainparams.MessageStart());
+        BOOST_REQUIRE(raw_block);
+
+        CBlock block;
+        BOOST_REQUIRE(ReadBlockFromDisk(block, pindex, chainparams.GetConsensus()));
+        CDataStream ss(SER_NETWORK, PROTOCOL_VERSION);
+        ss << block;
+        BOOST_CHECK(MakeUCharSpan(ss) == Span{*raw_block});
+    }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -163,6 +163,41 @@ BOOST_AUTO_TEST_CASE(bloom_match)
     BOOST_CHECK_MESSAGE(!filter.IsRelevantAndUpdate(tx), "Simple Bloom filter matched COutPoint for an output we didn't care about");
 }
 
+BOOST_AUTO_TEST_CASE(bloom_script_elements)
+{
+    const std::vector<unsigned char> sig_data = ParseHex("3045022100");
+    const std::vector<unsigned char> key_data = ParseHex("99108ad8ed9bb6274d3980bab5a85c048f0950c8");
+    CMutableTransaction mtx;
+    mtx.vin.resize(2);
+    mtx.vin[0].scriptSig = CScript() << sig_data << OP_0 << key_data;
+    // A push running past the end of the script ends the elements of the script
+    mtx.vin[1].scriptSig = CScript() << key_data;
+    mtx.vin[1].scriptSig.push_back(0x4c);
+    mtx.vout.resize(2);
+    mtx.vout[0].scriptPubKey = CScript() << OP_DUP << OP_HASH160 << key_data << OP_EQUALVERIFY << OP_CHECKSIG;
+    const CTransaction tx(mtx);
+
+    // Empty pushes are skipped, outputs come first
+    const TxScriptElements& elements = tx.GetScriptElements();
+    BOOST_CHECK_EQUAL(elements.element_ends.size(), 4U);
+    BOOST_CHECK(elements.OutputElements(0) == std::make_pair(size_t{0}, size_t{1}));
+    BOOST_CHECK(elements.OutputElements(1) == std::make_pair(size_t{1}, size_t{1}));
+    BOOST_CHECK(elements.InputElements(0) == std::make_pair(size_t{1}, size_t{3}));
+    BOOST_CHECK(elements.InputElements(1) == std::make_pair(size_t{3}, size_t{4}));
+    BOOST_CHECK(elements.Element(0) == Span<const unsigned char>(key_data));
+    BOOST_CHECK(elements.Element(1) == Span<const unsigned char>(sig_data));
+    BOOST_CHECK(elements.Element(2) == Span<const unsigned char>(key_data));
+    // Extracted once
+    BOOST_CHECK_EQUAL(&tx.GetScriptElements(), &elements);
+
+    CBloomFilter filter(10, 0.000001, 0, BLOOM_UPDATE_NONE);
+    filter.insert(sig_data);
+    BOOST_CHECK_MESSAGE(filter.IsRelevantAndUpdate(tx), "Simple Bloom filter didn't match scriptSig element");
+    CBloomFilter filter2(10, 0.000001, 0, BLOOM_UPDATE_NONE);
+    filter2.insert(ParseHex("00"));
+    BOOST_CHECK_MESSAGE(!filter2.IsRelevantAndUpdate(tx), "Simple Bloom filter matched random data");
+}
+
 BOOST_AUTO_TEST_CASE(dip2_bloom_match)
 {
     //TODO: Provide raw data for basic scheme as well
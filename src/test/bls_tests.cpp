@@ -4,11 +4,15 @@
 
 #include <bls/bls.h>
 #include <bls/bls_batchverifier.h>
+#include <bls/bls_sigcache.h>
+#include <bls/bls_worker.h>
 #include <clientversion.h>
 #include <random.h>
 #include <streams.h>
 #include <util/irange.h>
 
+#include <test/util/setup_common.h>
+
 #include <boost/test/unit_test.hpp>
 
 BOOST_AUTO_TEST_SUITE(bls_tests)
@@ -59,6 +63,37 @@ void FuncSerialize(const bool legacy_scheme)
     return;
 }
 
+void FuncLazyPublicKey(const bool legacy_scheme)
+{
+    bls::bls_legacy_scheme.store(legacy_scheme);
+
+    CBLSSecretKey sk;
+    sk.MakeNewKey();
+    const CBLSPublicKey pk = sk.GetPublicKey();
+
+    // Independent lazy copies of the same key decompress to the same point, the second one
+    // through the interned key of the first
+    for (int i = 0; i < 2; ++i) {
+        CDataStream ds(SER_DISK, CLIENT_VERSION);
+        ds << pk;
+        CBLSLazyPublicKey lazy_pk;
+        ds >> lazy_pk;
+        BOOST_CHECK(lazy_pk.Get().IsValid());
+        BOOST_CHECK(lazy_pk.Get() == pk);
+    }
+
+    // Nothing invalid gets interned, here an x coordinate outside of the field
+    const std::vector<uint8_t> vecBytes(CBLSPublicKey::SerSize, 0xff);
+    for (int i = 0; i < 2; ++i) {
+        CDataStream ds(vecBytes, SER_DISK, CLIENT_VERSION);
+        CBLSLazyPublicKey lazy_pk;
+        ds >> lazy_pk;
+        BOOST_CHECK(!lazy_pk.Get().IsValid());
+    }
+    CBLSLazyPublicKey null_pk;
+    BOOST_CHECK(!null_pk.Get().IsValid());
+}
+
 void FuncSetHexStr(const bool legacy_scheme)
 {
     bls::bls_legacy_scheme.store(legacy_scheme);
@@ -280,9 +315,9 @@ static void AddMessage(std::vector<Message>& vec, uint32_t sourceId, uint32_t ms
     vec.emplace_back(m);
 }
 
-static void Verify(std::vector<Message>& vec, bool secureVerification, bool perMessageFallback)
+static void Verify(std::vector<Message>& vec, bool secureVerification, bool perMessageFallback, CBLSWorker* worker)
 {
-    CBLSBatchVerifier<uint32_t, uint32_t> batchVerifier(secureVerification, perMessageFallback);
+    CBLSBatchVerifier<uint32_t, uint32_t> batchVerifier(secureVerification, perMessageFallback, 0, false, worker);
 
     std::set<uint32_t> expectedBadMessages;
     std::set<uint32_t> expectedBadSources;
@@ -306,12 +341,12 @@ static void Verify(std::vector<Message>& vec, bool secureVerification, bool perM
     }
 }
 
-static void Verify(std::vector<Message>& vec)
+static void Verify(std::vector<Message>& vec, CBLSWorker* worker = nullptr)
 {
-    Verify(vec, false, false);
-    Verify(vec, true, false);
-    Verify(vec, false, true);
-    Verify(vec, true, true);
+    Verify(vec, false, false, worker);
+    Verify(vec, true, false, worker);
+    Verify(vec, false, true, worker);
+    Verify(vec, true, true, worker);
 }
 
 void FuncBatchVerifier(const bool legacy_scheme)
@@ -359,6 +394,88 @@ void FuncBatchVerifier(const bool legacy_scheme)
     Verify(msgs);
 }
 
+void FuncBatchVerifierParallel(const bool legacy_scheme)
+{
+    bls::bls_legacy_scheme.store(legacy_scheme);
+
+    CBLSWorker worker;
+    worker.Start();
+
+    // enough messages for the batch to be split up between the workers
+    std::vector<Message> msgs;
+    for (uint32_t i = 0; i < 40; ++i) {
+        AddMessage(msgs, i % 10, i, uint8_t(i % 30), true);
+    }
+    Verify(msgs, &worker);
+
+    // invalid sigs from two sources, one of them a duplicate message hash
+    AddMessage(msgs, 3, 40, 40, false);
+    AddMessage(msgs, 7, 41, 5, false);
+    Verify(msgs, &worker);
+
+    // a source with only an invalid sig
+    AddMessage(msgs, 11, 42, 42, false);
+    Verify(msgs, &worker);
+
+    worker.Stop();
+}
+
+void FuncSigCache(const bool legacy_scheme)
+{
+    bls::bls_legacy_scheme.store(legacy_scheme);
+
+    CBLSSecretKey sk1, sk2;
+    sk1.MakeNewKey();
+    sk2.MakeNewKey();
+    const CBLSPublicKey pk1 = sk1.GetPublicKey();
+    const CBLSPublicKey pk2 = sk2.GetPublicKey();
+    const uint256 hash = GetRandHash();
+    const CBLSSignature sig1 = sk1.Sign(hash);
+
+    BOOST_CHECK(!BLSSigCacheContains(pk1, hash, sig1));
+    BOOST_CHECK(VerifyInsecureCached(sig1, pk1, hash));
+    BOOST_CHECK(BLSSigCacheContains(pk1, hash, sig1));
+    BOOST_CHECK(VerifyInsecureCached(sig1, pk1, hash));
+
+    // Invalid results are not kept
+    BOOST_CHECK(!VerifyInsecureCached(sig1, pk2, hash));
+    BOOST_CHECK(!BLSSigCacheContains(pk2, hash, sig1));
+
+    // Entries don't carry over to the other scheme
+    bls::bls_legacy_scheme.store(!legacy_scheme);
+    BOOST_CHECK(!BLSSigCacheContains(pk1, hash, sig1));
+    bls::bls_legacy_scheme.store(legacy_scheme);
+
+    std::vector<CBLSPublicKey> pks{pk1, pk2};
+    std::vector<CBLSSignature> sigs{sig1, sk2.Sign(hash)};
+    const CBLSSignature agg_sig = CBLSSignature::AggregateSecure(sigs, pks, hash);
+    BOOST_CHECK(VerifySecureAggregatedCached(agg_sig, pks, hash));
+    BOOST_CHECK(VerifySecureAggregatedCached(agg_sig, pks, hash));
+    // An aggregated entry doesn't stand for a single key
+    BOOST_CHECK(!BLSSigCacheContains(pk1, hash, agg_sig));
+    std::vector<CBLSPublicKey> pks_swapped{pk2, pk2};
+    BOOST_CHECK(!VerifySecureAggregatedCached(agg_sig, pks_swapped, hash));
+
+    // A batch verifier using the cache skips cached messages and only caches the ones it
+    // verified on their own
+    const uint256 hash2 = GetRandHash();
+    const uint256 hash3 = GetRandHash();
+    const CBLSSignature sig2 = sk2.Sign(hash2);
+    CBLSBatchVerifier<uint32_t, uint32_t> batchVerifier(false, true, 0, /* useSigCache */ true);
+    batchVerifier.PushMessage(1, 1, hash, sig1, pk1);
+    BOOST_CHECK_EQUAL(batchVerifier.GetUniqueSourceCount(), 0U);
+    batchVerifier.PushMessage(2, 2, hash2, sig2, pk2);
+    batchVerifier.PushMessage(2, 3, hash3, sk1.Sign(hash3), pk1);
+    batchVerifier.Verify();
+    BOOST_CHECK(batchVerifier.badSources.empty());
+    BOOST_CHECK(!BLSSigCacheContains(pk2, hash2, sig2));
+
+    CBLSBatchVerifier<uint32_t, uint32_t> singleVerifier(false, true, 0, /* useSigCache */ true);
+    singleVerifier.PushMessage(1, 1, hash2, sig2, pk2);
+    singleVerifier.Verify();
+    BOOST_CHECK(BLSSigCacheContains(pk2, hash2, sig2));
+}
+
 void FuncThresholdSignature(const bool legacy_scheme)
 {
     bls::bls_legacy_scheme.store(legacy_scheme);
@@ -407,6 +524,23 @@ void FuncThresholdSignature(const bool legacy_scheme)
         BOOST_CHECK_EQUAL(rec_share_sig == thr_sig, m_shares >= m_threshold);
         BOOST_CHECK_EQUAL(rec_share_sig.VerifyInsecure(thr_pk, hash), m_shares >= m_threshold);
     }
+
+    // Recovering from the same ids again reuses their Lagrange coefficients, which must not depend on the message
+    // and must follow the order of the ids
+    const uint256 hash2 = GetRandHash();
+    std::vector<CBLSSignature> v_share_sigs;
+    std::vector<CBLSId> v_share_ids;
+    for (const auto j : irange::range(m_threshold)) {
+        v_share_sigs.emplace_back(v_size_sk_shares[j].Sign(hash2));
+        v_share_ids.push_back(v_size_ids[j]);
+    }
+    for ([[maybe_unused]] const auto i : irange::range(2)) {
+        CBLSSignature rec_share_sig;
+        BOOST_CHECK(rec_share_sig.Recover(v_share_sigs, v_share_ids));
+        BOOST_CHECK(rec_share_sig == thr_sk.Sign(hash2));
+        std::reverse(v_share_sigs.begin(), v_share_sigs.end());
+        std::reverse(v_share_ids.begin(), v_share_ids.end());
+    }
 }
 
 BOOST_AUTO_TEST_CASE(bls_sethexstr_tests)
@@ -421,6 +555,12 @@ BOOST_AUTO_TEST_CASE(bls_serialize_tests)
     FuncSerialize(false);
 }
 
+BOOST_AUTO_TEST_CASE(bls_lazy_pubkey_tests)
+{
+    FuncLazyPublicKey(true);
+    FuncLazyPublicKey(false);
+}
+
 BOOST_AUTO_TEST_CASE(bls_sig_tests)
 {
     FuncSign(true);
@@ -451,6 +591,36 @@ BOOST_AUTO_TEST_CASE(bls_sig_agg_secure_tests)
     FuncSigAggSecure(false);
 }
 
+void FuncDecryptContributions(const bool legacy_scheme)
+{
+    bls::bls_legacy_scheme.store(legacy_scheme);
+
+    CBLSWorker worker;
+    worker.Start();
+
+    CBLSSecretKey recipient;
+    recipient.MakeNewKey();
+    const size_t idx{5};
+
+    // more contributions than fit into a single batch, like the encrypted contributions of a QDATA message
+    std::vector<CBLSSecretKey> contributions(20);
+    std::vector<CBLSIESEncryptedObject<CBLSSecretKey>> vecEncrypted(contributions.size());
+    for (const auto i : irange::range(contributions.size())) {
+        contributions[i].MakeNewKey();
+        BOOST_CHECK(vecEncrypted[i].Encrypt(idx, recipient.GetPublicKey(), contributions[i], PROTOCOL_VERSION));
+    }
+
+    std::vector<CBLSSecretKey> decrypted;
+    BOOST_CHECK(worker.DecryptContributions(vecEncrypted, idx, recipient, decrypted));
+    BOOST_CHECK(decrypted == contributions);
+
+    // a single truncated contribution fails the whole set
+    vecEncrypted[13].data.resize(16);
+    BOOST_CHECK(!worker.DecryptContributions(vecEncrypted, idx, recipient, decrypted));
+
+    worker.Stop();
+}
+
 BOOST_AUTO_TEST_CASE(bls_dh_exchange_tests)
 {
     FuncDHExchange(true);
@@ -463,6 +633,24 @@ BOOST_AUTO_TEST_CASE(batch_verifier_tests)
     FuncBatchVerifier(false);
 }
 
+BOOST_AUTO_TEST_CASE(batch_verifier_parallel_tests)
+{
+    FuncBatchVerifierParallel(true);
+    FuncBatchVerifierParallel(false);
+}
+
+BOOST_AUTO_TEST_CASE(bls_decrypt_contributions_tests)
+{
+    FuncDecryptContributions(true);
+    FuncDecryptContributions(false);
+}
+
+BOOST_FIXTURE_TEST_CASE(bls_sigcache_tests, BasicTestingSetup)
+{
+    FuncSigCache(true);
+    FuncSigCache(false);
+}
+
 BOOST_AUTO_TEST_CASE(bls_threshold_signature_tests)
 {
     FuncThresholdSignature(true);
@@ -164,4 +164,23 @@ BOOST_AUTO_TEST_CASE(cachemultimap_test)
     BOOST_CHECK(Compare(cmmapTest1, mapTest4));
 }
 
+BOOST_AUTO_TEST_CASE(cachemultimap_evict_same_key)
+{
+    // Evicting the only value of the key being inserted must not lose the new value
+    CacheMultiMap<int,int> cmmapTest(2);
+    BOOST_CHECK(cmmapTest.Insert(1, 10));
+    BOOST_CHECK(cmmapTest.Insert(2, 20));
+    BOOST_CHECK(cmmapTest.Insert(1, 11));
+    BOOST_CHECK(cmmapTest.GetSize() == 2);
+
+    std::vector<int> vecVals;
+    BOOST_CHECK(cmmapTest.GetAll(1, vecVals));
+    BOOST_CHECK(vecVals.size() == 1 && vecVals[0] == 11);
+
+    BOOST_CHECK(cmmapTest.Insert(3, 30));
+    BOOST_CHECK(!cmmapTest.HasKey(2));
+    BOOST_CHECK(cmmapTest.HasKey(1));
+    BOOST_CHECK(cmmapTest.HasKey(3));
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,38 @@
+// Copyright (c) 2024 The Maximus developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <chain.h>
+#include <node/chainsnapshot.h>
+#include <validation.h>
+
+#include <test/util/setup_common.h>
+
+#include <boost/test/unit_test.hpp>
+
+BOOST_FIXTURE_TEST_SUITE(chainsnapshot_tests, TestChain100Setup)
+
+BOOST_AUTO_TEST_CASE(publish_and_fallback)
+{
+    const CBlockIndex* tip = WITH_LOCK(cs_main, return m_node.chainman->ActiveChain().Tip());
+    BOOST_REQUIRE(tip && tip->pprev);
+
+    // Nothing published yet: the tip is read from the active chain
+    ResetChainSnapshot();
+    BOOST_CHECK(GetChainSnapshot()->tip == nullptr);
+    BOOST_CHECK_EQUAL(GetChainSnapshot()->Height(), -1);
+    BOOST_CHECK_EQUAL(GetChainSnapshotTip(*m_node.chainman), tip);
+
+    // A published tip is returned as is, without looking at the active chain
+    ChainSnapshotRef old_snapshot = GetChainSnapshot();
+    PublishChainTip(tip->pprev, CDeterministicMNList{});
+    BOOST_CHECK_EQUAL(GetChainSnapshotTip(*m_node.chainman), tip->pprev);
+    BOOST_CHECK_EQUAL(GetChainSnapshot()->Height(), tip->nHeight - 1);
+    // Snapshots are immutable, readers holding an older one are not affected
+    BOOST_CHECK(old_snapshot->tip == nullptr);
+
+    ResetChainSnapshot();
+    BOOST_CHECK_EQUAL(GetChainSnapshotTip(*m_node.chainman), tip);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -12,6 +12,7 @@
 #include <undo.h>
 #include <util/strencodings.h>
 
+#include <limits>
 #include <map>
 #include <vector>
 
@@ -53,7 +54,7 @@ public:
 
     uint256 GetBestBlock() const override { return hashBestBlock_; }
 
-    bool BatchWrite(CCoinsMap& mapCoins, const uint256& hashBlock) override
+    bool BatchWrite(CCoinsMap& mapCoins, const uint256& hashBlock, bool erase = true) override
     {
         for (CCoinsMap::iterator it = mapCoins.begin(); it != mapCoins.end(); ) {
             if (it->second.flags & CCoinsCacheEntry::DIRTY) {
@@ -64,7 +65,7 @@ public:
                     map_.erase(it->first);
                 }
             }
-            mapCoins.erase(it++);
+            it = erase ? mapCoins.erase(it) : std::next(it);
         }
         if (!hashBlock.IsNull())
             hashBestBlock_ = hashBlock;
@@ -608,7 +609,8 @@ void GetCoinsMapEntry(const CCoinsMap& map, CAmount& value, char& flags)
 
 void WriteCoinsViewEntry(CCoinsView& view, CAmount value, char flags)
 {
-    CCoinsMap map;
+    CCoinsMapMemoryResource resource;
+    CCoinsMap map{0, CCoinsMap::hasher{}, CCoinsMap::key_equal{}, &resource};
     InsertCoinsMapEntry(map, value, flags);
     BOOST_CHECK(view.BatchWrite(map, {}));
 }
@@ -877,4 +879,143 @@ BOOST_AUTO_TEST_CASE(ccoins_write)
                     CheckWriteCoins(parent_value, child_value, parent_value, parent_flags, child_flags, parent_flags);
 }
 
+BOOST_AUTO_TEST_CASE(ccoins_add_fetched)
+{
+    CCoinsView base;
+    CCoinsViewCacheTest cache(&base);
+    const COutPoint outpoint(InsecureRand256(), 0);
+
+    Coin coin;
+    coin.out.nValue = InsecureRand32();
+    coin.nHeight = 1;
+    BOOST_CHECK(cache.AddFetchedCoin(outpoint, Coin(coin)));
+    BOOST_CHECK(cache.HaveCoinInCache(outpoint));
+    BOOST_CHECK(cache.AccessCoin(outpoint) == coin);
+    // Fetched coins are neither dirty nor fresh, they only mirror the base
+    BOOST_CHECK_EQUAL(cache.map().at(outpoint).flags, 0);
+    cache.SelfTest();
+
+    // An entry already in the cache is never replaced
+    Coin other = coin;
+    other.out.nValue += 1;
+    BOOST_CHECK(!cache.AddFetchedCoin(outpoint, std::move(other)));
+    BOOST_CHECK(cache.AccessCoin(outpoint) == coin);
+    BOOST_CHECK(cache.SpendCoin(outpoint));
+    BOOST_CHECK(!cache.AddFetchedCoin(outpoint, Coin(coin)));
+    BOOST_CHECK(!cache.HaveCoin(outpoint));
+
+    // Spent coins are never added
+    BOOST_CHECK(!cache.AddFetchedCoin(COutPoint(InsecureRand256(), 1), Coin()));
+    cache.SelfTest();
+}
+
+BOOST_AUTO_TEST_CASE(ccoins_sync_evict)
+{
+    CCoinsViewTest base;
+    CCoinsViewCacheTest cache(&base);
+
+    std::vector<COutPoint> outpoints;
+    Coin coin;
+    coin.out.nValue = InsecureRand32();
+    coin.nHeight = 1;
+    for (uint32_t i = 0; i < 3; ++i) {
+        outpoints.emplace_back(InsecureRand256(), i);
+        cache.AddCoin(outpoints.back(), Coin(coin), false);
+    }
+    BOOST_CHECK(cache.SpendCoin(outpoints[2]));
+    cache.SetBestBlock(InsecureRand256());
+
+    // Syncing writes everything but keeps the unspent coins, clean
+    BOOST_CHECK(cache.Sync());
+    BOOST_CHECK_EQUAL(cache.GetCacheSize(), 2U);
+    for (const auto& entry : cache.map()) {
+        BOOST_CHECK_EQUAL(entry.second.flags, 0);
+        BOOST_CHECK(!entry.second.coin.IsSpent());
+    }
+    Coin written;
+    BOOST_CHECK(base.GetCoin(outpoints[0], written) && written == coin);
+    BOOST_CHECK(base.GetCoin(outpoints[1], written) && written == coin);
+    BOOST_CHECK(base.GetBestBlock() == cache.GetBestBlock());
+    cache.SelfTest();
+
+    // New coins count as used, so the first eviction keeps them all
+    BOOST_CHECK_EQUAL(cache.EvictCold(std::numeric_limits<size_t>::max()), 2U);
+    cache.SelfTest();
+
+    // Only the coin looked up since then survives the next one
+    BOOST_CHECK(cache.AccessCoin(outpoints[1]) == coin);
+    BOOST_CHECK_EQUAL(cache.EvictCold(std::numeric_limits<size_t>::max()), 1U);
+    BOOST_CHECK(cache.HaveCoinInCache(outpoints[1]));
+    BOOST_CHECK(!cache.HaveCoinInCache(outpoints[0]));
+    cache.SelfTest();
+
+    // Nothing is kept without a budget, but the coins are still in the base
+    BOOST_CHECK(cache.AccessCoin(outpoints[1]) == coin);
+    BOOST_CHECK_EQUAL(cache.EvictCold(0), 0U);
+    BOOST_CHECK_EQUAL(cache.GetCacheSize(), 0U);
+    BOOST_CHECK(cache.HaveCoin(outpoints[0]));
+    cache.SelfTest();
+}
+
+static std::vector<COutPoint> CursorOutpoints(CCoinsViewCursor& cursor)
+{
+    std::vector<COutPoint> outpoints;
+    for (; cursor.Valid(); cursor.Next()) {
+        COutPoint outpoint;
+        BOOST_REQUIRE(cursor.GetKey(outpoint));
+        outpoints.push_back(outpoint);
+    }
+    return outpoints;
+}
+
+BOOST_AUTO_TEST_CASE(ccoins_db_range_cursors)
+{
+    CCoinsViewDB db{"test", /*nCacheSize*/ 1 << 20, /*fMemory*/ true, /*fWipe*/ false};
+    const uint256 best_block = InsecureRand256();
+    {
+        CCoinsViewCache cache(&db);
+        Coin coin;
+        coin.out.nValue = InsecureRand32();
+        coin.nHeight = 1;
+        for (int i = 0; i < 500; ++i) {
+            const uint256 txid = InsecureRand256();
+            const uint32_t outputs = 1 + InsecureRandRange(3);
+            for (uint32_t n = 0; n < outputs; ++n) {
+                cache.AddCoin(COutPoint(txid, n), Coin(coin), false);
+            }
+        }
+        cache.SetBestBlock(best_block);
+        BOOST_REQUIRE(cache.Flush());
+    }
+    const auto expected = CursorOutpoints(*db.Cursor());
+
+    for (size_t ranges : {1, 3, 16, 1000}) {
+        const auto cursors = db.RangeCursors(ranges);
+        BOOST_CHECK_EQUAL(cursors.size(), std::min<size_t>(ranges, 256));
+        // The parts are consecutive and together they are the whole set
+        std::vector<COutPoint> outpoints;
+        for (const auto& cursor : cursors) {
+            BOOST_CHECK(cursor->GetBestBlock() == best_block);
+            for (const auto& outpoint : CursorOutpoints(*cursor)) outpoints.push_back(outpoint);
+        }
+        BOOST_CHECK(outpoints == expected);
+    }
+
+    // The cursors keep reading the state they were created at
+    auto cursors = db.RangeCursors(4);
+    {
+        CCoinsViewCache cache(&db);
+        cache.SpendCoin(expected.front());
+        cache.SetBestBlock(InsecureRand256());
+        BOOST_REQUIRE(cache.Flush());
+    }
+    std::vector<COutPoint> outpoints;
+    for (const auto& cursor : cursors) {
+        BOOST_CHECK(cursor->GetBestBlock() == best_block);
+        for (const auto& outpoint : CursorOutpoints(*cursor)) outpoints.push_back(outpoint);
+    }
+    BOOST_CHECK(outpoints == expected);
+    BOOST_CHECK_EQUAL(CursorOutpoints(*db.Cursor()).size(), expected.size() - 1);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
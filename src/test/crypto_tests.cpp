@@ -4,6 +4,7 @@
 
 #include <crypto/aes.h>
 #include <crypto/chacha20.h>
+#include <crypto/chacha20poly1305.h>
 #include <crypto/chacha_poly_aead.h>
 #include <crypto/hkdf_sha256_32.h>
 #include <crypto/hmac_sha256.h>
@@ -16,6 +17,9 @@
 #include <crypto/sha256.h>
 #include <crypto/sha3.h>
 #include <crypto/sha512.h>
+#include <crypto/x11.h>
+#include <hash.h>
+#include <primitives/block.h>
 #include <random.h>
 #include <streams.h>
 #include <test/util/setup_common.h>
@@ -449,6 +453,23 @@ BOOST_AUTO_TEST_CASE(aes_testvectors) {
     TestAES256("603deb1015ca71be2b73aef0857d77811f352c073b6108d72d9810a30914dff4", "f69f2445df4f9b17ad2b417be66c3710", "23304b7a39f9f3ff067d8d8f9e24ecc7");
 }
 
+BOOST_AUTO_TEST_CASE(aes_autodetect_matches_ctaes) {
+    // Whatever implementation AES256AutoDetect picked has to agree with ctaes on random keys and blocks
+    for (int i = 0; i < 100; ++i) {
+        unsigned char key[AES256_KEYSIZE], plaintext[AES_BLOCKSIZE], ciphertext[AES_BLOCKSIZE], expected[AES_BLOCKSIZE], decrypted[AES_BLOCKSIZE];
+        GetRandBytes(key, sizeof(key));
+        GetRandBytes(plaintext, sizeof(plaintext));
+        AES256_ctx ctx;
+        AES256_init(&ctx, key);
+        AES256_encrypt(&ctx, 1, expected, plaintext);
+
+        AES256Encrypt(key).Encrypt(ciphertext, plaintext);
+        BOOST_CHECK(memcmp(ciphertext, expected, sizeof(expected)) == 0);
+        AES256Decrypt(key).Decrypt(decrypted, ciphertext);
+        BOOST_CHECK(memcmp(decrypted, plaintext, sizeof(plaintext)) == 0);
+    }
+}
+
 BOOST_AUTO_TEST_CASE(aes_cbc_testvectors) {
     // NIST AES CBC 256-bit encryption test-vectors
     TestAES256CBC("603deb1015ca71be2b73aef0857d77811f352c073b6108d72d9810a30914dff4", \
@@ -623,6 +644,27 @@ BOOST_AUTO_TEST_CASE(chacha20_midblock)
     BOOST_CHECK_EQUAL(0, memcmp(b3, block + 12, 52));
 }
 
+BOOST_AUTO_TEST_CASE(chacha20_multiblock)
+{
+    // Long runs go through the multi-block kernel if one is available, single blocks never do
+    const auto key = ParseHex("000102030405060708090a0b0c0d0e0f101112131415161718191a1b1c1d1e1f");
+    for (const uint64_t pos : {0ull, 0xfffffffbull}) {
+        std::vector<unsigned char> in(64 * 19), out1(in.size()), out2(in.size());
+        for (size_t i = 0; i < in.size(); ++i) {
+            in[i] = InsecureRandBits(8);
+        }
+        ChaCha20 c20{key.data()};
+        c20.SetIV(0x0706050403020100ull);
+        c20.Seek64(pos);
+        c20.Crypt(in.data(), out1.data(), in.size());
+        c20.Seek64(pos);
+        for (size_t i = 0; i < in.size(); i += 64) {
+            c20.Crypt(in.data() + i, out2.data() + i, 64);
+        }
+        BOOST_CHECK(out1 == out2);
+    }
+}
+
 BOOST_AUTO_TEST_CASE(poly1305_testvector)
 {
     // RFC 7539, section 2.5.2.
@@ -838,6 +880,71 @@ BOOST_AUTO_TEST_CASE(chacha20_poly1305_aead_testvector)
         "f039c6689eaeef0456685200feaab9d54bbd9acde4410a3b6f4321296f4a8ca2604b49727d8892c57e005d799b2a38e85e809f20146e08eec75169691c8d4f54a0d51a1e1c7b381e0474eb02f994be9415ef3ffcbd2343f0601e1f3b172a1d494f838824e4df570f8e3b0c04e27966e36c82abd352d07054ef7bd36b84c63f9369afe7ed79b94f953873006b920c3fa251a771de1b63da927058ade119aa898b8c97e42a606b2f6df1e2d957c22f7593c1e2002f4252f4c9ae4bf773499e5cfcfe14dfc1ede26508953f88553bf4a76a802f6a0068d59295b01503fd9a600067624203e880fdf53933b96e1f4d9eb3f4e363dd8165a278ff667a41ee42b9892b077cefff92b93441f7be74cf10e6cd");
 }
 
+static void TestRFC8439AEAD(const std::string& hex_plain, const std::string& hex_aad, const std::string& hex_key, uint32_t nonce_a, uint64_t nonce_b, const std::string& hex_cipher)
+{
+    const auto plain = ParseHex(hex_plain);
+    const auto aad = ParseHex(hex_aad);
+    const auto key = ParseHex(hex_key);
+    const auto expected = ParseHex(hex_cipher);
+
+    AEADChaCha20Poly1305 aead{key.data()};
+    for (size_t split = 0; split <= plain.size(); split += 17) {
+        std::vector<unsigned char> cipher(plain.size() + AEADChaCha20Poly1305::EXPANSION);
+        aead.Encrypt(plain.data(), split, plain.data() + split, plain.size() - split, aad.data(), aad.size(), {nonce_a, nonce_b}, cipher.data());
+        BOOST_CHECK_EQUAL(HexStr(cipher), HexStr(expected));
+
+        std::vector<unsigned char> decrypted(plain.size());
+        BOOST_CHECK(aead.Decrypt(cipher.data(), cipher.size(), aad.data(), aad.size(), {nonce_a, nonce_b}, decrypted.data(), split, decrypted.data() + split, plain.size() - split));
+        BOOST_CHECK(decrypted == plain);
+
+        // Any modification of the ciphertext, the tag, the aad or the nonce must be detected
+        cipher[InsecureRandRange(cipher.size())] ^= 1 << InsecureRandBits(3);
+        BOOST_CHECK(!aead.Decrypt(cipher.data(), cipher.size(), aad.data(), aad.size(), {nonce_a, nonce_b}, decrypted.data(), split, decrypted.data() + split, plain.size() - split));
+        BOOST_CHECK(!aead.Decrypt(expected.data(), expected.size(), aad.data(), aad.size(), {nonce_a + 1, nonce_b}, decrypted.data(), split, decrypted.data() + split, plain.size() - split));
+        if (!aad.empty()) {
+            BOOST_CHECK(!aead.Decrypt(expected.data(), expected.size(), aad.data(), aad.size() - 1, {nonce_a, nonce_b}, decrypted.data(), split, decrypted.data() + split, plain.size() - split));
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(chacha20poly1305_testvectors)
+{
+    // RFC 8439, section 2.8.2.
+    TestRFC8439AEAD("4c616469657320616e642047656e746c656d656e206f662074686520636c617373206f66202739393a204966204920636f756c"
+                    "64206f6666657220796f75206f6e6c79206f6e652074697020666f7220746865206675747572652c2073756e73637265656e20"
+                    "776f756c642062652069742e",
+                    "50515253c0c1c2c3c4c5c6c7", "808182838485868788898a8b8c8d8e8f909192939495969798999a9b9c9d9e9f",
+                    7, 0x4746454443424140,
+                    "d31a8d34648e60db7b86afbc53ef7ec2a4aded51296e08fea9e2b5a736ee62d63dbea45e8ca9671282fafb69da92728b1a71"
+                    "de0a9e060b2905d6a5b67ecd3b3692ddbd7f2d778b8c9803aee328091b58fab324e4fad675945585808b4831d7bc3ff4def0"
+                    "8e4b7a9de576d26586cec64b61161ae10b594f09e26a7e902ecbd0600691");
+    // Empty plaintext and aad, only the tag
+    TestRFC8439AEAD("", "", "0000000000000000000000000000000000000000000000000000000000000000", 0, 0,
+                    "4eb972c9a8fb3a1b382bb4d36f5ffad1");
+
+    // Forward-secure variants with a rekey every 3 chunks
+    const auto key = ParseHex("808182838485868788898a8b8c8d8e8f909192939495969798999a9b9c9d9e9f");
+    FSChaCha20 fsc20{key.data(), 3};
+    std::vector<unsigned char> stream(24);
+    const unsigned char zeros[3] = {0};
+    for (size_t i = 0; i < stream.size(); i += 3) {
+        fsc20.Crypt(zeros, stream.data() + i, 3);
+    }
+    BOOST_CHECK_EQUAL(HexStr(stream), "f4fa2fcdf72b1edecdb92fdedcc34182d9f288d7379d2ec8");
+
+    const auto plain = ParseHex("0001020304050607");
+    const unsigned char aad[3] = {'a', 'a', 'd'};
+    FSChaCha20Poly1305 enc{key.data(), 3}, dec{key.data(), 3};
+    for (int i = 0; i < 8; ++i) {
+        std::vector<unsigned char> cipher(plain.size() + FSChaCha20Poly1305::EXPANSION), decrypted(plain.size());
+        enc.Encrypt(plain.data(), plain.size(), nullptr, 0, aad, sizeof(aad), cipher.data());
+        if (i == 0) BOOST_CHECK_EQUAL(HexStr(cipher), "2a5d18ae3a5fe8ccb19ca2d5f1dc6bc49eb9ebf09d2a2164");
+        if (i == 7) BOOST_CHECK_EQUAL(HexStr(cipher), "6f299d3966716b791e70f799d420656707eeea589af467f8");
+        BOOST_CHECK(dec.Decrypt(cipher.data(), cipher.size(), aad, sizeof(aad), decrypted.data(), decrypted.size(), nullptr, 0));
+        BOOST_CHECK(decrypted == plain);
+    }
+}
+
 BOOST_AUTO_TEST_CASE(countbits_tests)
 {
     FastRandomContext ctx;
@@ -876,6 +983,58 @@ BOOST_AUTO_TEST_CASE(sha256d64)
     }
 }
 
+BOOST_AUTO_TEST_CASE(sha256s64)
+{
+    for (int i = 0; i <= 32; ++i) {
+        unsigned char in[64 * 32];
+        unsigned char out1[32 * 32], out2[32 * 32];
+        for (int j = 0; j < 64 * i; ++j) {
+            in[j] = InsecureRandBits(8);
+        }
+        for (int j = 0; j < i; ++j) {
+            CSHA256().Write(in + 64 * j, 64).Finalize(out1 + 32 * j);
+        }
+        SHA256S64(out2, in, i);
+        BOOST_CHECK(memcmp(out1, out2, 32 * i) == 0);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(x11_hash80)
+{
+    for (int i = 0; i <= 19; ++i) {
+        unsigned char in[80 * 19];
+        unsigned char out1[32 * 19], out2[32 * 19];
+        for (int j = 0; j < 80 * i; ++j) {
+            in[j] = InsecureRandBits(8);
+        }
+        for (int j = 0; j < i; ++j) {
+            const uint256 hash = HashX11(in + 80 * j, in + 80 * (j + 1));
+            memcpy(out1 + 32 * j, hash.begin(), 32);
+        }
+        X11Hash80(out2, in, i);
+        BOOST_CHECK(memcmp(out1, out2, 32 * i) == 0);
+    }
+
+    std::vector<CBlockHeader> headers(13);
+    for (auto& header : headers) {
+        header.nVersion = InsecureRand32();
+        header.hashPrevBlock = InsecureRand256();
+        header.hashMerkleRoot = InsecureRand256();
+        header.nTime = InsecureRand32();
+        header.nBits = InsecureRand32();
+        header.nNonce = InsecureRand32();
+    }
+    const std::vector<uint256> hashes = CPureBlockHeader::GetPoWHashes(headers);
+    BOOST_REQUIRE_EQUAL(hashes.size(), headers.size());
+    for (size_t i = 0; i < headers.size(); ++i) {
+        CDataStream ss(SER_GETHASH, PROTOCOL_VERSION);
+        ss << static_cast<const CPureBlockHeader&>(headers[i]);
+        BOOST_CHECK_EQUAL(ss.size(), CPureBlockHeader::POW_HEADER_SIZE);
+        BOOST_CHECK(headers[i].GetPoWHash() == HashX11(ss.begin(), ss.end()));
+        BOOST_CHECK(hashes[i] == headers[i].GetPoWHash());
+    }
+}
+
 static void TestSHA3_256(const std::string& input, const std::string& output)
 {
     const auto in_bytes = ParseHex(input);
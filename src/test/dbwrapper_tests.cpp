@@ -7,6 +7,7 @@
 #include <uint256.h>
 
 #include <memory>
+#include <optional>
 
 #include <boost/test/unit_test.hpp>
 
@@ -158,6 +159,112 @@ BOOST_AUTO_TEST_CASE(dbwrapper_batch)
     }
 }
 
+BOOST_AUTO_TEST_CASE(dbwrapper_shared_cache)
+{
+    InitSharedDBCache(1 << 20);
+    const DBProfile shared{/*bloom_bits=*/0, /*write_buffer_size=*/1 << 16, /*shared_cache=*/true};
+    CDBWrapper dbw1(GetDataDir() / "dbwrapper_shared_1", (1 << 20), true, false, false, shared);
+    CDBWrapper dbw2(GetDataDir() / "dbwrapper_shared_2", (1 << 20), true, false, false, shared);
+    CDBWrapper dbw3(GetDataDir() / "dbwrapper_shared_3", (1 << 22), true, false, false);
+    InitSharedDBCache(0);
+
+    // The databases sharing the cache read back their own values of the same keys
+    for (CDBWrapper* dbw : {&dbw1, &dbw2, &dbw3}) {
+        for (uint32_t i = 0; i < 100; i++) {
+            BOOST_CHECK(dbw->Write(i, uint256{uint8_t(dbw == &dbw1 ? 1 : 2)}));
+        }
+        dbw->CompactFull();
+    }
+    uint256 res;
+    BOOST_CHECK(dbw1.Read(uint32_t{7}, res) && res == uint256{1});
+    BOOST_CHECK(dbw2.Read(uint32_t{7}, res) && res == uint256{2});
+    BOOST_CHECK(dbw1.Read(uint32_t{7}, res) && res == uint256{1});
+
+    auto stats1 = dbw1.GetStats();
+    auto stats3 = dbw3.GetStats();
+    BOOST_CHECK(stats1.shared_cache);
+    BOOST_CHECK_EQUAL(stats1.cache_size, 1 << 20);
+    BOOST_CHECK_EQUAL(stats1.write_buffer_size, 1 << 16);
+    BOOST_CHECK_EQUAL(stats1.bloom_bits, 0);
+    BOOST_CHECK(!stats3.shared_cache);
+    BOOST_CHECK_EQUAL(stats3.cache_size, 1 << 21);
+    BOOST_CHECK_EQUAL(stats3.bloom_bits, 10);
+    BOOST_CHECK(stats1.cache_hits > 0);
+
+    bool found = false;
+    for (const auto& stats : GetDBStats()) {
+        found |= stats.name == "dbwrapper_shared_2";
+    }
+    BOOST_CHECK(found);
+}
+
+BOOST_AUTO_TEST_CASE(dbwrapper_own_compaction_thread)
+{
+    // a small write buffer makes the writes below flush and compact many tables on the database's own thread
+    const DBProfile profile{/*bloom_bits=*/10, /*write_buffer_size=*/1 << 14, /*shared_cache=*/false, /*own_compaction_thread=*/true};
+    for (const bool memory : {true, false}) {
+        CDBWrapper dbw(GetDataDir() / "dbwrapper_compaction", (1 << 20), memory, true, false, profile);
+        for (uint32_t i = 0; i < 20000; i++) {
+            BOOST_CHECK(dbw.Write(i, uint256{uint8_t(i)}));
+        }
+        uint256 res;
+        for (uint32_t i = 0; i < 20000; i += 997) {
+            BOOST_CHECK(dbw.Read(i, res) && res == uint256{uint8_t(i)});
+        }
+        dbw.CompactFull();
+        BOOST_CHECK(dbw.Read(uint32_t{12345}, res) && res == uint256{uint8_t(12345)});
+
+        const auto stats = dbw.GetStats();
+        BOOST_CHECK(stats.own_compaction_thread);
+        BOOST_CHECK_EQUAL(stats.level0_files, 0);
+        BOOST_CHECK(stats.write_stall_us == 0 || stats.write_slowdowns + stats.write_stops > 0);
+    }
+}
+
+// Test reading several keys at once, small batches are read inline and large ones on the read threads
+BOOST_AUTO_TEST_CASE(dbwrapper_multiread)
+{
+    // Perform tests both obfuscated and non-obfuscated.
+    for (const bool obfuscate : {false, true}) {
+        fs::path ph = GetDataDir() / (obfuscate ? "dbwrapper_multiread_obfuscate_true" : "dbwrapper_multiread_obfuscate_false");
+        CDBWrapper dbw(ph, (1 << 20), true, false, obfuscate);
+
+        std::vector<uint32_t> keys;
+        std::vector<uint256> written;
+        CDBBatch batch(dbw);
+        for (uint32_t i = 0; i < 1000; i++) {
+            keys.push_back(i);
+            written.push_back(InsecureRand256());
+            // Leave every third key out
+            if (i % 3 != 0) {
+                batch.Write(i, written.back());
+            }
+        }
+        BOOST_CHECK(dbw.WriteBatch(batch));
+
+        for (size_t count : {size_t{0}, size_t{5}, keys.size()}) {
+            std::vector<uint32_t> batch_keys(keys.begin(), keys.begin() + count);
+            std::vector<std::optional<uint256>> values;
+            dbw.MultiRead(batch_keys, values);
+            std::vector<bool> exists = dbw.MultiExists(batch_keys);
+            BOOST_REQUIRE_EQUAL(values.size(), count);
+            BOOST_REQUIRE_EQUAL(exists.size(), count);
+            for (size_t i = 0; i < count; i++) {
+                BOOST_CHECK_EQUAL(values[i].has_value(), i % 3 != 0);
+                BOOST_CHECK_EQUAL(exists[i], i % 3 != 0);
+                if (values[i]) {
+                    BOOST_CHECK_EQUAL(values[i]->ToString(), written[i].ToString());
+                }
+            }
+        }
+
+        // Values which can't be deserialized are treated as missing
+        std::vector<std::optional<std::pair<uint256, uint256>>> too_big;
+        dbw.MultiRead(std::vector<uint32_t>{1, 2}, too_big);
+        BOOST_CHECK(!too_big[0] && !too_big[1]);
+    }
+}
+
 BOOST_AUTO_TEST_CASE(dbwrapper_iterator)
 {
     // Perform tests both obfuscated and non-obfuscated.
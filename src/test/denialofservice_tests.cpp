@@ -9,12 +9,14 @@
 #include <llmq/context.h>
 #include <net.h>
 #include <net_processing.h>
+#include <netbase.h>
 #include <pubkey.h>
 #include <script/sign.h>
 #include <script/signingprovider.h>
 #include <script/standard.h>
 #include <test/util/net.h>
 #include <test/util/setup_common.h>
+#include <txorphanage.h>
 #include <util/string.h>
 #include <util/system.h>
 #include <util/time.h>
@@ -27,18 +29,6 @@
 #include <boost/test/unit_test.hpp>
 
 
-// Tests these internal-to-net_processing.cpp methods:
-extern bool AddOrphanTx(const CTransactionRef& tx, NodeId peer);
-extern void EraseOrphansFor(NodeId peer);
-extern unsigned int LimitOrphanTxSize(unsigned int nMaxOrphans);
-
-struct COrphanTx {
-    CTransactionRef tx;
-    NodeId fromPeer;
-    int64_t nTimeExpire;
-};
-extern std::map<uint256, COrphanTx> mapOrphanTransactions GUARDED_BY(g_cs_orphans);
-
 static CService ip(uint32_t i)
 {
     struct in_addr s;
@@ -324,16 +314,66 @@ BOOST_AUTO_TEST_CASE(DoS_bantime)
     peerLogic->FinalizeNode(dummyNode);
 }
 
-static CTransactionRef RandomOrphan()
+BOOST_AUTO_TEST_CASE(DoS_subnet_banning)
 {
-    std::map<uint256, COrphanTx>::iterator it;
-    LOCK2(cs_main, g_cs_orphans);
-    it = mapOrphanTransactions.lower_bound(InsecureRand256());
-    if (it == mapOrphanTransactions.end())
-        it = mapOrphanTransactions.begin();
-    return it->second.tx;
+    auto banman = std::make_unique<BanMan>(GetDataDir() / "banlist", nullptr, DEFAULT_MISBEHAVING_BANTIME);
+    banman->ClearBanned();
+    const int64_t nStartTime = GetTime();
+    SetMockTime(nStartTime);
+
+    CNetAddr addr_v4, addr_v4_other, addr_v6, addr_v6_other, addr_onion;
+    BOOST_REQUIRE(LookupHost("10.1.2.3", addr_v4, false));
+    BOOST_REQUIRE(LookupHost("10.2.0.1", addr_v4_other, false));
+    BOOST_REQUIRE(LookupHost("2001:db8:1::1", addr_v6, false));
+    BOOST_REQUIRE(LookupHost("2001:db8:2::1", addr_v6_other, false));
+    BOOST_REQUIRE(addr_onion.SetSpecial("pg6mmjiyjmcrsslvykfwnntlaru7p5svn6y2ymmju6nubxndf4pscryd.onion"));
+
+    BOOST_CHECK(!banman->IsBanned(addr_v4));
+
+    banman->Ban(CSubNet(addr_v4, 16));
+    banman->Ban(CSubNet(addr_v6, 48), 10);
+    banman->Ban(addr_onion);
+    BOOST_CHECK(banman->IsBanned(addr_v4));
+    BOOST_CHECK(!banman->IsBanned(addr_v4_other));
+    BOOST_CHECK(banman->IsBanned(addr_v6));
+    BOOST_CHECK(!banman->IsBanned(addr_v6_other));
+    BOOST_CHECK(banman->IsBanned(addr_onion));
+    BOOST_CHECK(banman->IsBanned(CSubNet(addr_v4, 16)));
+    BOOST_CHECK(!banman->IsBanned(CSubNet(addr_v4)));
+
+    // a wider ban covers both addresses, unbanning the narrower one leaves it in place
+    banman->Ban(CSubNet(addr_v4, 8));
+    BOOST_CHECK(banman->IsBanned(addr_v4_other));
+    BOOST_CHECK(banman->Unban(CSubNet(addr_v4, 16)));
+    BOOST_CHECK(banman->IsBanned(addr_v4));
+    BOOST_CHECK(banman->Unban(CSubNet(addr_v4, 8)));
+    BOOST_CHECK(!banman->IsBanned(addr_v4));
+    BOOST_CHECK(!banman->IsBanned(addr_v4_other));
+
+    // expired bans no longer match, even before they are swept
+    SetMockTime(nStartTime + 11);
+    BOOST_CHECK(!banman->IsBanned(addr_v6));
+    BOOST_CHECK(banman->IsBanned(addr_onion));
+
+    banman->ClearBanned();
+    BOOST_CHECK(!banman->IsBanned(addr_onion));
+    SetMockTime(0);
 }
 
+class TxOrphanageTest : public TxOrphanage
+{
+public:
+    inline size_t CountOrphans() const EXCLUSIVE_LOCKS_REQUIRED(g_cs_orphans)
+    {
+        return m_orphans.size();
+    }
+
+    CTransactionRef RandomOrphan() EXCLUSIVE_LOCKS_REQUIRED(g_cs_orphans)
+    {
+        return m_orphans.at(m_orphan_list[InsecureRandRange(m_orphan_list.size())]).tx;
+    }
+};
+
 static void MakeNewKeyWithFastRandomContext(CKey& key)
 {
     std::vector<unsigned char> keydata;
@@ -357,6 +397,9 @@ BOOST_AUTO_TEST_CASE(DoS_mapOrphans)
     FillableSigningProvider keystore;
     BOOST_CHECK(keystore.AddKey(key));
 
+    TxOrphanageTest orphanage;
+    LOCK(g_cs_orphans);
+
     // 50 orphan transactions:
     for (int i = 0; i < 50; i++)
     {
@@ -369,13 +412,13 @@ BOOST_AUTO_TEST_CASE(DoS_mapOrphans)
         tx.vout[0].nValue = 1*CENT;
         tx.vout[0].scriptPubKey = GetScriptForDestination(PKHash(key.GetPubKey()));
 
-        AddOrphanTx(MakeTransactionRef(tx), i);
+        orphanage.AddTx(MakeTransactionRef(tx), i);
     }
 
     // ... and 50 that depend on other orphans:
     for (int i = 0; i < 50; i++)
     {
-        CTransactionRef txPrev = RandomOrphan();
+        CTransactionRef txPrev = orphanage.RandomOrphan();
 
         CMutableTransaction tx;
         tx.vin.resize(1);
@@ -386,13 +429,13 @@ BOOST_AUTO_TEST_CASE(DoS_mapOrphans)
         tx.vout[0].scriptPubKey = GetScriptForDestination(PKHash(key.GetPubKey()));
         BOOST_CHECK(SignSignature(keystore, *txPrev, tx, 0, SIGHASH_ALL));
 
-        AddOrphanTx(MakeTransactionRef(tx), i);
+        orphanage.AddTx(MakeTransactionRef(tx), i);
     }
 
     // This really-big orphan should be ignored:
     for (int i = 0; i < 10; i++)
     {
-        CTransactionRef txPrev = RandomOrphan();
+        CTransactionRef txPrev = orphanage.RandomOrphan();
 
         CMutableTransaction tx;
         tx.vout.resize(1);
@@ -410,25 +453,34 @@ BOOST_AUTO_TEST_CASE(DoS_mapOrphans)
         for (unsigned int j = 1; j < tx.vin.size(); j++)
             tx.vin[j].scriptSig = tx.vin[0].scriptSig;
 
-        BOOST_CHECK(!AddOrphanTx(MakeTransactionRef(tx), i));
+        BOOST_CHECK(!orphanage.AddTx(MakeTransactionRef(tx), i));
     }
 
-    LOCK2(cs_main, g_cs_orphans);
-    // Test EraseOrphansFor:
+    // Test EraseForPeer:
     for (NodeId i = 0; i < 3; i++)
     {
-        size_t sizeBefore = mapOrphanTransactions.size();
-        EraseOrphansFor(i);
-        BOOST_CHECK(mapOrphanTransactions.size() < sizeBefore);
+        size_t sizeBefore = orphanage.CountOrphans();
+        orphanage.EraseForPeer(i);
+        BOOST_CHECK(orphanage.CountOrphans() < sizeBefore);
+        BOOST_CHECK_EQUAL(orphanage.PeerOrphanSize(i), 0U);
+    }
+
+    // Test the per-peer budget of LimitOrphans():
+    const size_t peer_size = orphanage.PeerOrphanSize(3);
+    BOOST_REQUIRE(peer_size > 0);
+    const size_t total_size = orphanage.TotalOrphanSize();
+    orphanage.LimitOrphans(total_size, peer_size - 1);
+    BOOST_CHECK(orphanage.PeerOrphanSize(3) < peer_size);
+    for (NodeId i = 0; i < 50; i++) {
+        BOOST_CHECK(orphanage.PeerOrphanSize(i) < peer_size);
     }
 
-    // Test LimitOrphanTxSize() function:
-    LimitOrphanTxSize(40);
-    BOOST_CHECK(mapOrphanTransactions.size() <= 40);
-    LimitOrphanTxSize(10);
-    BOOST_CHECK(mapOrphanTransactions.size() <= 10);
-    LimitOrphanTxSize(0);
-    BOOST_CHECK(mapOrphanTransactions.empty());
+    // Test the total size limit of LimitOrphans():
+    orphanage.LimitOrphans(orphanage.TotalOrphanSize() / 2, total_size);
+    BOOST_CHECK(orphanage.TotalOrphanSize() <= total_size / 2);
+    orphanage.LimitOrphans(0, total_size);
+    BOOST_CHECK_EQUAL(orphanage.CountOrphans(), 0U);
+    BOOST_CHECK_EQUAL(orphanage.TotalOrphanSize(), 0U);
 }
 
 BOOST_AUTO_TEST_SUITE_END()
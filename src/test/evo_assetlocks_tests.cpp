@@ -157,6 +157,26 @@ BOOST_FIXTURE_TEST_CASE(evo_assetlock, TestChain100Setup)
         BOOST_CHECK(opt_payload->getVersion() == 1);
     }
 
+    // Immutable transactions cache their parsed payload and serialized size
+    {
+        const CTransaction ctx(tx);
+        BOOST_CHECK(ctx.GetCachedPayload() == nullptr);
+        const auto opt_payload = GetTxPayload<CAssetLockPayload>(ctx);
+        BOOST_CHECK(opt_payload.has_value());
+        const CachedTxPayload* cached = ctx.GetCachedPayload();
+        BOOST_CHECK(cached != nullptr);
+        BOOST_CHECK(GetTxPayload<CAssetLockPayload>(ctx)->getCreditOutputs() == opt_payload->getCreditOutputs());
+        BOOST_CHECK(ctx.GetCachedPayload() == cached);
+        // A copy parses its own
+        const CTransaction ctx_copy(ctx);
+        BOOST_CHECK(ctx_copy.GetCachedPayload() == nullptr);
+
+        CDataStream ds(SER_NETWORK, PROTOCOL_VERSION);
+        ds << ctx;
+        BOOST_CHECK_EQUAL(ctx.GetTotalSize(), ds.size());
+        BOOST_CHECK_EQUAL(::GetSerializeSize(ctx, PROTOCOL_VERSION), ds.size());
+    }
+
     {
         // Wrong type "Asset Unlock TX" instead "Asset Lock TX"
         CMutableTransaction txWrongType = tx;
@@ -458,9 +458,14 @@ void FuncDIP3Protx(TestChainSetup& setup)
     dmnman.UpdatedBlockTip(::ChainActive().Tip());
     nHeight++;
 
-    // check MN reward payments
+    // check MN reward payments, the projection made before must hold as long as no masternode changes
+    const auto projectedPayees = dmnman.GetListAtChainTip().GetProjectedMNPayees(::ChainActive().Tip(), 20);
+    BOOST_CHECK(!projectedPayees.empty());
     for (size_t i = 0; i < 20; i++) {
         auto dmnExpectedPayee = dmnman.GetListAtChainTip().GetMNPayee(::ChainActive().Tip());
+        if (i < projectedPayees.size()) {
+            BOOST_CHECK_EQUAL(projectedPayees[i]->proTxHash.ToString(), dmnExpectedPayee->proTxHash.ToString());
+        }
 
         CBlock block = setup.CreateAndProcessBlock({}, setup.coinbaseKey);
         dmnman.UpdatedBlockTip(::ChainActive().Tip());
@@ -857,4 +862,173 @@ BOOST_AUTO_TEST_CASE(verify_db_legacy)
     FuncVerifyDB(setup);
 }
 
+BOOST_AUTO_TEST_CASE(mnlist_shared_memory_usage)
+{
+    CDeterministicMNList list(uint256(), 0, 0);
+    for (uint64_t i = 0; i < 1000; i++) {
+        auto dmn = std::make_shared<CDeterministicMN>(i);
+        dmn->proTxHash = ArithToUint256(i + 1);
+        dmn->collateralOutpoint = COutPoint(dmn->proTxHash, 0);
+        auto state = std::make_shared<CDeterministicMNState>();
+        state->keyIDOwner = CKeyID(uint160(ParseHex(strprintf("%040x", i + 1))));
+        dmn->pdmnState = state;
+        list.AddMN(dmn);
+    }
+
+    std::unordered_set<const void*> seen;
+    const size_t usage = list.DynamicMemoryUsage(seen);
+    BOOST_CHECK_GT(usage, 1000 * (sizeof(CDeterministicMN) + sizeof(CDeterministicMNState)));
+    // everything is shared with the list itself
+    BOOST_CHECK_EQUAL(list.DynamicMemoryUsage(seen), 0);
+
+    // a copy with one updated masternode only adds the new state and the map nodes leading to it
+    auto list2 = list;
+    auto newState = std::make_shared<CDeterministicMNState>(*list.GetMN(ArithToUint256(1))->pdmnState);
+    newState->nPoSePenalty = 10;
+    list2.UpdateMN(ArithToUint256(1), newState);
+    const size_t usage2 = list2.DynamicMemoryUsage(seen);
+    BOOST_CHECK_GT(usage2, sizeof(CDeterministicMNState));
+    BOOST_CHECK_LT(usage2, usage / 10);
+}
+
+BOOST_AUTO_TEST_CASE(mnlist_undo_diff)
+{
+    const auto make_mn = [](uint64_t i) {
+        auto dmn = std::make_shared<CDeterministicMN>(i);
+        dmn->proTxHash = ArithToUint256(i + 1);
+        dmn->collateralOutpoint = COutPoint(dmn->proTxHash, 0);
+        auto state = std::make_shared<CDeterministicMNState>();
+        state->keyIDOwner = CKeyID(uint160(ParseHex(strprintf("%040x", i + 1))));
+        dmn->pdmnState = state;
+        return dmn;
+    };
+    CDeterministicMNList list(uint256(), 0, 0);
+    for (uint64_t i = 0; i < 10; i++) {
+        list.AddMN(make_mn(i));
+    }
+
+    // remove, add and update a masternode
+    auto list2 = list;
+    list2.RemoveMN(ArithToUint256(3));
+    list2.AddMN(make_mn(10));
+    auto newState = std::make_shared<CDeterministicMNState>(*list.GetMN(ArithToUint256(5))->pdmnState);
+    newState->nPoSePenalty = 10;
+    list2.UpdateMN(ArithToUint256(5), newState);
+    BOOST_CHECK_EQUAL(list2.GetTotalRegisteredCount(), 11U);
+
+    const auto diff = list.BuildDiff(list2);
+    const auto undo = list2.BuildUndoDiff(list, diff);
+    BOOST_CHECK(undo.addedMNs.size() == 1 && undo.addedMNs[0]->proTxHash == ArithToUint256(3));
+    BOOST_CHECK(undo.removedMns == std::set<uint64_t>{10});
+    BOOST_CHECK_EQUAL(undo.updatedMNs.size(), 1U);
+
+    const uint256 block_hash;
+    CBlockIndex index;
+    index.phashBlock = &block_hash;
+    index.nHeight = 0;
+    auto restored = list2.ApplyDiff(&index, undo);
+    restored.SetTotalRegisteredCount(list.GetTotalRegisteredCount());
+    BOOST_CHECK(restored == list);
+    BOOST_CHECK_EQUAL(restored.GetMN(ArithToUint256(5))->pdmnState->nPoSePenalty, 0);
+}
+
+BOOST_AUTO_TEST_CASE(mnlist_valid_index)
+{
+    CDeterministicMNList list(uint256(), 0, 0);
+    for (uint64_t i = 0; i < 20; i++) {
+        auto dmn = std::make_shared<CDeterministicMN>(i);
+        dmn->proTxHash = ArithToUint256(i + 1);
+        dmn->collateralOutpoint = COutPoint(dmn->proTxHash, 0);
+        auto state = std::make_shared<CDeterministicMNState>();
+        state->keyIDOwner = CKeyID(uint160(ParseHex(strprintf("%040x", i + 1))));
+        if (i % 4 == 0) state->BanIfNotBanned(1);
+        dmn->pdmnState = state;
+        list.AddMN(dmn);
+    }
+    const auto check_index = [](const CDeterministicMNList& l) {
+        std::vector<uint256> expected, actual;
+        l.ForEachMN(false, [&](const CDeterministicMN& dmn) {
+            if (CDeterministicMNList::IsMNValid(dmn)) expected.push_back(dmn.proTxHash);
+        });
+        l.ForEachMN(true, [&](const CDeterministicMN& dmn) { actual.push_back(dmn.proTxHash); });
+        BOOST_CHECK(actual == expected);
+        BOOST_CHECK_EQUAL(l.GetValidMNsCount(), expected.size());
+        BOOST_CHECK_EQUAL(l.GetValidWeightedMNsCount(), expected.size());
+        for (const auto& proTxHash : expected) {
+            BOOST_CHECK(l.GetValidMN(proTxHash) != nullptr);
+        }
+    };
+    check_index(list);
+    BOOST_CHECK_EQUAL(list.GetValidMNsCount(), 15U);
+    BOOST_CHECK(list.GetValidMN(ArithToUint256(1)) == nullptr);
+
+    // banning, reviving and removing masternodes keeps the index in sync, copies don't affect each other
+    auto list2 = list;
+    auto banned = std::make_shared<CDeterministicMNState>(*list.GetMN(ArithToUint256(2))->pdmnState);
+    banned->BanIfNotBanned(2);
+    list2.UpdateMN(ArithToUint256(2), banned);
+    auto revived = std::make_shared<CDeterministicMNState>(*list.GetMN(ArithToUint256(1))->pdmnState);
+    revived->Revive(2);
+    list2.UpdateMN(ArithToUint256(1), revived);
+    list2.RemoveMN(ArithToUint256(3));
+    list2.RemoveMN(ArithToUint256(5));
+    check_index(list);
+    check_index(list2);
+    BOOST_CHECK_EQUAL(list2.GetValidMNsCount(), 14U);
+}
+
+BOOST_AUTO_TEST_CASE(mnlist_compact_snapshot)
+{
+    const CScript pool_payout = CScript() << OP_DUP << OP_HASH160 << ToByteVector(uint160(ParseHex("0101010101010101010101010101010101010101"))) << OP_EQUALVERIFY << OP_CHECKSIG;
+    const auto rand160 = [] {
+        const uint256 r = InsecureRand256();
+        return uint160(std::vector<unsigned char>(r.begin(), r.begin() + 20));
+    };
+    CDeterministicMNList list(InsecureRand256(), 1000, 30);
+    for (uint64_t i = 0; i < 30; i++) {
+        auto dmn = std::make_shared<CDeterministicMN>(i, i % 5 == 0 ? MnType::Evo : MnType::Regular);
+        dmn->proTxHash = InsecureRand256();
+        dmn->collateralOutpoint = COutPoint(InsecureRand256(), i);
+        dmn->nOperatorReward = i * 10;
+        auto state = std::make_shared<CDeterministicMNState>();
+        state->nVersion = i % 2 == 0 ? CProRegTx::LEGACY_BLS_VERSION : CProRegTx::BASIC_BLS_VERSION;
+        state->nRegisteredHeight = i;
+        state->nLastPaidHeight = 900 + i;
+        state->nPoSePenalty = i % 7;
+        if (i % 4 == 0) state->BanIfNotBanned(950);
+        if (i % 3 != 0) state->UpdateConfirmedHash(dmn->proTxHash, InsecureRand256());
+        state->keyIDOwner = CKeyID(rand160());
+        state->keyIDVoting = i % 2 == 0 ? state->keyIDOwner : CKeyID(rand160());
+        if (i % 6 != 0) {
+            CBLSSecretKey sk;
+            sk.MakeNewKey();
+            state->pubKeyOperator.Set(sk.GetPublicKey(), state->nVersion == CProRegTx::LEGACY_BLS_VERSION);
+            state->addr = LookupNumeric("1.2.3.4", 1000 + i);
+        }
+        state->scriptPayout = i < 20 ? pool_payout : GetScriptForDestination(PKHash(rand160()));
+        if (dmn->nType == MnType::Evo) {
+            state->platformNodeID = rand160();
+            state->platformP2PPort = 26656;
+            state->platformHTTPPort = 443;
+        }
+        dmn->pdmnState = state;
+        list.AddMN(dmn, false);
+    }
+
+    CDataStream full(SER_DISK, CLIENT_VERSION);
+    full << list;
+    CDataStream compact(SER_DISK, CLIENT_VERSION);
+    compact << CDeterministicMNListCompactSnapshot(list);
+    BOOST_CHECK_LT(compact.size(), full.size());
+
+    // the compact snapshot loads into the same list as the full one
+    CDeterministicMNListCompactSnapshot loaded;
+    compact >> loaded;
+    BOOST_CHECK(compact.empty());
+    CDataStream reloaded(SER_DISK, CLIENT_VERSION);
+    reloaded << loaded.list;
+    BOOST_CHECK(reloaded.str() == full.str());
+    BOOST_CHECK_EQUAL(loaded.list.GetValidMNsCount(), list.GetValidMNsCount());
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -5,6 +5,7 @@
 #include <test/util/setup_common.h>
 
 #include <bls/bls.h>
+#include <consensus/merkle.h>
 #include <evo/simplifiedmns.h>
 #include <netbase.h>
 
@@ -69,4 +70,104 @@ BOOST_AUTO_TEST_CASE(simplifiedmns_merkleroots)
 
     BOOST_CHECK(expectedMerkleRoot == calculatedMerkleRoot);
 }
+
+BOOST_AUTO_TEST_CASE(simplifiedmns_merkletree_incremental)
+{
+    CSimplifiedMNListMerkleTree tree;
+    std::map<uint256, uint256> expected;
+
+    auto check = [&]() {
+        std::vector<uint256> leaves;
+        for (const auto& p : expected) {
+            leaves.emplace_back(p.second);
+        }
+        bool expectedMutated, mutated;
+        const uint256 expectedRoot = ComputeMerkleRoot(leaves, &expectedMutated);
+        BOOST_CHECK_EQUAL(tree.size(), expected.size());
+        BOOST_CHECK_EQUAL(tree.GetMerkleRoot(&mutated), expectedRoot);
+        BOOST_CHECK_EQUAL(mutated, expectedMutated);
+    };
+    check();
+
+    for (int round = 0; round < 200; round++) {
+        std::vector<uint256> removed;
+        std::map<uint256, uint256> upserted;
+        const int numChanges = InsecureRandRange(round % 10 == 0 ? 50 : 5) + 1;
+        for (int i = 0; i < numChanges; i++) {
+            const int action = InsecureRandRange(3);
+            if (action == 0 && !expected.empty()) {
+                // remove an existing leaf
+                auto it = std::next(expected.begin(), InsecureRandRange(expected.size()));
+                removed.emplace_back(it->first);
+                expected.erase(it);
+            } else if (action == 1 && !expected.empty()) {
+                // replace the hash of an existing leaf, so that equal neighbours show up every now and then
+                auto it = std::next(expected.begin(), InsecureRandRange(expected.size()));
+                it->second = InsecureRandBool() ? it->second : InsecureRand256();
+                if (InsecureRandRange(8) == 0) {
+                    it->second = expected.begin()->second;
+                }
+                upserted[it->first] = it->second;
+            } else {
+                const uint256 key = InsecureRand256();
+                expected[key] = InsecureRand256();
+                upserted[key] = expected[key];
+            }
+        }
+        // leaves which are removed and added again in the same update
+        if (round % 7 == 0 && !expected.empty()) {
+            auto it = std::next(expected.begin(), InsecureRandRange(expected.size()));
+            it->second = InsecureRand256();
+            removed.emplace_back(it->first);
+            upserted[it->first] = it->second;
+        }
+        for (const auto& key : removed) {
+            if (!expected.count(key)) {
+                upserted.erase(key);
+            }
+        }
+        tree.Apply(removed, upserted);
+        check();
+    }
+
+    // shrinking down to nothing again
+    std::vector<uint256> removed;
+    for (const auto& p : expected) {
+        removed.emplace_back(p.first);
+    }
+    expected.clear();
+    tree.Apply(removed, {});
+    check();
+}
+BOOST_AUTO_TEST_CASE(simplifiedmns_entry_cache)
+{
+    auto dmn = std::make_shared<CDeterministicMN>(1);
+    dmn->proTxHash = InsecureRand256();
+    auto state = std::make_shared<CDeterministicMNState>();
+    state->confirmedHash = InsecureRand256();
+    dmn->pdmnState = state;
+
+    // the same state gives the same entry
+    const auto cached = GetSimplifiedMNListEntry(*dmn);
+    BOOST_CHECK(cached->entry == CSimplifiedMNListEntry(*dmn));
+    BOOST_CHECK_EQUAL(cached->hash, CSimplifiedMNListEntry(*dmn).CalcHash());
+    BOOST_CHECK(GetSimplifiedMNListEntry(*dmn) == cached);
+
+    // an updated masternode gets a new entry, the entry of its old state stays as it was
+    auto dmn2 = std::make_shared<CDeterministicMN>(*dmn);
+    auto state2 = std::make_shared<CDeterministicMNState>(*state);
+    state2->BanIfNotBanned(10);
+    dmn2->pdmnState = state2;
+    const auto cached2 = GetSimplifiedMNListEntry(*dmn2);
+    BOOST_CHECK(cached2 != cached);
+    BOOST_CHECK(!cached2->entry.isValid);
+    BOOST_CHECK_EQUAL(cached2->hash, CSimplifiedMNListEntry(*dmn2).CalcHash());
+    BOOST_CHECK(cached->entry.isValid);
+
+    // a different masternode sharing the state doesn't get the other one's entry
+    auto dmn3 = std::make_shared<CDeterministicMN>(*dmn);
+    dmn3->proTxHash = InsecureRand256();
+    BOOST_CHECK(GetSimplifiedMNListEntry(*dmn3)->entry.proRegTxHash == dmn3->proTxHash);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
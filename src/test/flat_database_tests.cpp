@@ -0,0 +1,66 @@
+// Copyright (c) 2024 The Maximus developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <flat-database.h>
+#include <serialize.h>
+
+#include <test/util/setup_common.h>
+
+#include <boost/test/unit_test.hpp>
+
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace {
+struct FlatDBTestObject {
+    std::vector<std::string> items;
+
+    SERIALIZE_METHODS(FlatDBTestObject, obj)
+    {
+        READWRITE(obj.items);
+    }
+
+    void Clear() { items.clear(); }
+    std::string ToString() const { return strprintf("items: %d", items.size()); }
+};
+} // namespace
+
+BOOST_FIXTURE_TEST_SUITE(flat_database_tests, BasicTestingSetup)
+
+BOOST_AUTO_TEST_CASE(flat_database_roundtrip)
+{
+    FlatDBTestObject obj;
+    for (int i = 0; i < 1000; ++i) {
+        obj.items.emplace_back(strprintf("item %d", i));
+    }
+
+    CFlatDB<FlatDBTestObject> flatdb("flatdbtest.dat", "magicFlatDBTest");
+    BOOST_CHECK(flatdb.Store(obj));
+
+    // the streamed file matches the original layout: header, object and the hash of both
+    CDataStream ssExpected(SER_DISK, CLIENT_VERSION);
+    ssExpected << std::string("magicFlatDBTest") << Params().MessageStart() << obj;
+    ssExpected << Hash(ssExpected);
+    std::ifstream file((GetDataDir() / "flatdbtest.dat").string(), std::ios::binary);
+    std::vector<char> vchFile((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    file.close();
+    BOOST_CHECK(vchFile.size() == ssExpected.size());
+    BOOST_CHECK(std::equal(vchFile.begin(), vchFile.end(), UCharCast(ssExpected.data())));
+
+    FlatDBTestObject loaded;
+    BOOST_CHECK(flatdb.Load(loaded));
+    BOOST_CHECK(loaded.items == obj.items);
+
+    // flip a bit inside the object data, the file must be rejected as corrupted
+    vchFile[vchFile.size() / 2] ^= 1;
+    std::ofstream out((GetDataDir() / "flatdbtest.dat").string(), std::ios::binary | std::ios::trunc);
+    out.write(vchFile.data(), vchFile.size());
+    out.close();
+    FlatDBTestObject corrupted;
+    BOOST_CHECK(!flatdb.Load(corrupted));
+    BOOST_CHECK(corrupted.items.empty());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
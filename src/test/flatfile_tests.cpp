@@ -86,6 +86,35 @@ BOOST_AUTO_TEST_CASE(flatfile_open)
     }
 }
 
+BOOST_AUTO_TEST_CASE(flatfile_map)
+{
+    const auto data_dir = GetDataDir();
+    FlatFileSeq seq(data_dir, "a", 100);
+
+    // Missing and empty files can't be mapped
+    BOOST_CHECK(!seq.Map(FlatFilePos(0, 0)));
+    fclose(seq.Open(FlatFilePos(0, 0)));
+    BOOST_CHECK(!seq.Map(FlatFilePos(0, 0)));
+
+    const std::string text("A purely peer-to-peer version of electronic cash");
+    {
+        CAutoFile file(seq.Open(FlatFilePos(0, 0)), SER_DISK, CLIENT_VERSION);
+        file << LIMITED_STRING(text, 256);
+    }
+
+    const auto mapped = seq.Map(FlatFilePos(0, 123));
+#ifndef WIN32
+    BOOST_REQUIRE(mapped);
+    // The mapping holds the whole file, whatever the position
+    BOOST_CHECK_EQUAL(mapped->Data().size(), GetSerializeSize(LIMITED_STRING(text, 256), CLIENT_VERSION));
+    std::string mapped_text;
+    SpanReader{SER_DISK, CLIENT_VERSION, mapped->Data(), 0} >> LIMITED_STRING(mapped_text, 256);
+    BOOST_CHECK_EQUAL(mapped_text, text);
+#else
+    BOOST_CHECK(!mapped);
+#endif
+}
+
 BOOST_AUTO_TEST_CASE(flatfile_allocate)
 {
     const auto data_dir = GetDataDir();
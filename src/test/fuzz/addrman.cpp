@@ -111,7 +111,7 @@ public:
                     if (vvTried[bucket][bucket_pos] == -1) {
                         int id;
                         CAddrInfo* addr_info = Create(addr, source, &id);
-                        vvTried[bucket][bucket_pos] = id;
+                        SetTried(bucket, bucket_pos, id);
                         addr_info->fInTried = true;
                         ++nTried;
                     }
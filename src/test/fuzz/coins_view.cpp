@@ -74,6 +74,12 @@ FUZZ_TARGET_INIT(coins_view, initialize_coins_view)
             [&] {
                 (void)coins_view_cache.Flush();
             },
+            [&] {
+                (void)coins_view_cache.Sync();
+                if (fuzzed_data_provider.ConsumeBool()) {
+                    (void)coins_view_cache.EvictCold(fuzzed_data_provider.ConsumeIntegral<size_t>());
+                }
+            },
             [&] {
                 coins_view_cache.SetBestBlock(ConsumeUInt256(fuzzed_data_provider));
             },
@@ -112,7 +118,8 @@ FUZZ_TARGET_INIT(coins_view, initialize_coins_view)
                 random_mutable_transaction = *opt_mutable_transaction;
             },
             [&] {
-                CCoinsMap coins_map;
+                CCoinsMapMemoryResource resource;
+                CCoinsMap coins_map{0, SaltedOutpointHasher{}, CCoinsMap::key_equal{}, &resource};
                 while (fuzzed_data_provider.ConsumeBool()) {
                     CCoinsCacheEntry coins_cache_entry;
                     coins_cache_entry.flags = fuzzed_data_provider.ConsumeIntegral<unsigned char>();
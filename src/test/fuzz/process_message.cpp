@@ -145,6 +145,7 @@ FUZZ_TARGET_MSG(getqrinfo);
 FUZZ_TARGET_MSG(getsporks);
 FUZZ_TARGET_MSG(govobj);
 FUZZ_TARGET_MSG(govobjvote);
+FUZZ_TARGET_MSG(govobjvotes);
 FUZZ_TARGET_MSG(govsync);
 FUZZ_TARGET_MSG(headers);
 FUZZ_TARGET_MSG(headers2);
@@ -169,6 +170,7 @@ FUZZ_TARGET_MSG(qpcommit);
 FUZZ_TARGET_MSG(qrinfo);
 FUZZ_TARGET_MSG(qsendrecsigs);
 FUZZ_TARGET_MSG(qsigrec);
+FUZZ_TARGET_MSG(qsigsbundle);
 FUZZ_TARGET_MSG(qsigsesann);
 FUZZ_TARGET_MSG(qsigshare);
 FUZZ_TARGET_MSG(qsigsinv);
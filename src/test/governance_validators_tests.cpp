@@ -1,7 +1,9 @@
 // Copyright (c) 2014-2023 The Dash Core developers
 
+#include <governance/object.h>
 #include <governance/validators.h>
 #include <util/strencodings.h>
+#include <util/time.h>
 
 #include <test/data/proposals_invalid.json.h>
 #include <test/data/proposals_valid.json.h>
@@ -79,4 +81,23 @@ BOOST_AUTO_TEST_CASE(invalid_proposals_test)
     }
 }
 
+BOOST_AUTO_TEST_CASE(object_data_validity_test)
+{
+    // IsDataValid is what UpdateCachesAndClean runs off the locks, it must accept expired proposals
+    UniValue tests = read_json(std::string(json_tests::proposals_valid, json_tests::proposals_valid + sizeof(json_tests::proposals_valid)));
+
+    BOOST_CHECK_MESSAGE(tests.size(), "Empty `tests`");
+    for (size_t i = 0; i < tests.size(); ++i) {
+        const CGovernanceObject govobj(uint256(), 1, GetTime(), uint256(), HexStr(tests[i][0].write()));
+        BOOST_CHECK(govobj.GetObjectType() == GovernanceObject::PROPOSAL);
+        std::string strError;
+        BOOST_CHECK_MESSAGE(govobj.IsDataValid(strError), strError);
+    }
+
+    const CGovernanceObject unparsable(uint256(), 1, GetTime(), uint256(), HexStr(std::string{"not json"}));
+    std::string strError;
+    BOOST_CHECK(!unparsable.IsDataValid(strError));
+    BOOST_CHECK_EQUAL(strError, "Object data unparsable");
+}
+
 BOOST_AUTO_TEST_SUITE_END()
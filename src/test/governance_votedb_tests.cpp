@@ -0,0 +1,74 @@
+// Copyright (c) 2024 The Maximus developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <clientversion.h>
+#include <governance/votedb.h>
+
+#include <test/util/setup_common.h>
+
+#include <boost/test/unit_test.hpp>
+
+BOOST_FIXTURE_TEST_SUITE(governance_votedb_tests, BasicTestingSetup)
+
+static CGovernanceVote MakeVote(const COutPoint& outpoint, const uint256& parent, vote_signal_enum_t signal, vote_outcome_enum_t outcome, int64_t nTime)
+{
+    CGovernanceVote vote(outpoint, parent, signal, outcome);
+    vote.SetTime(nTime);
+    return vote;
+}
+
+BOOST_AUTO_TEST_CASE(votefile_per_masternode)
+{
+    const uint256 parent = InsecureRand256();
+    const COutPoint mn1(InsecureRand256(), 0);
+    const COutPoint mn2(InsecureRand256(), 1);
+
+    CGovernanceObjectVoteFile file;
+    const auto vote1 = MakeVote(mn1, parent, VOTE_SIGNAL_FUNDING, VOTE_OUTCOME_YES, 1000);
+    const auto vote2 = MakeVote(mn2, parent, VOTE_SIGNAL_FUNDING, VOTE_OUTCOME_NO, 1000);
+    const auto vote3 = MakeVote(mn1, parent, VOTE_SIGNAL_DELETE, VOTE_OUTCOME_NO, 1000);
+    file.AddVote(vote1);
+    file.AddVote(vote2);
+    file.AddVote(vote3);
+    // duplicates are ignored
+    file.AddVote(vote1);
+    BOOST_CHECK_EQUAL(file.GetVoteCount(), 3);
+
+    // a newer vote for the same signal replaces the older one, other signals are untouched
+    const auto vote4 = MakeVote(mn1, parent, VOTE_SIGNAL_FUNDING, VOTE_OUTCOME_NO, 2000);
+    file.AddVote(vote4);
+    BOOST_CHECK_EQUAL(file.GetVoteCount(), 3);
+    BOOST_CHECK(!file.HasVote(vote1.GetHash()));
+    BOOST_CHECK(file.HasVote(vote3.GetHash()));
+    BOOST_CHECK(file.HasVote(vote4.GetHash()));
+
+    // an older vote doesn't replace a newer one
+    const auto vote5 = MakeVote(mn2, parent, VOTE_SIGNAL_FUNDING, VOTE_OUTCOME_YES, 500);
+    file.AddVote(vote5);
+    BOOST_CHECK_EQUAL(file.GetVoteCount(), 4);
+    BOOST_CHECK(file.HasVote(vote2.GetHash()));
+
+    // the index survives copies and serialization
+    CGovernanceObjectVoteFile copy(file);
+    CDataStream ss(SER_DISK, CLIENT_VERSION);
+    ss << file;
+    CGovernanceObjectVoteFile loaded;
+    ss >> loaded;
+
+    for (auto* f : {&file, &copy, &loaded}) {
+        f->RemoveVotesFromMasternode(mn1);
+        BOOST_CHECK_EQUAL(f->GetVoteCount(), 2);
+        BOOST_CHECK_EQUAL(f->GetVotes().size(), 2U);
+        BOOST_CHECK(!f->HasVote(vote3.GetHash()));
+        BOOST_CHECK(!f->HasVote(vote4.GetHash()));
+        BOOST_CHECK(f->HasVote(vote2.GetHash()));
+        BOOST_CHECK(f->HasVote(vote5.GetHash()));
+
+        f->RemoveVotesFromMasternode(mn2);
+        BOOST_CHECK_EQUAL(f->GetVoteCount(), 0);
+        BOOST_CHECK(f->GetVotes().empty());
+    }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
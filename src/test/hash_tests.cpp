@@ -120,6 +120,14 @@ BOOST_AUTO_TEST_CASE(siphash)
         hasher3.Write(uint64_t(x)|(uint64_t(x+1)<<8)|(uint64_t(x+2)<<16)|(uint64_t(x+3)<<24)|
                      (uint64_t(x+4)<<32)|(uint64_t(x+5)<<40)|(uint64_t(x+6)<<48)|(uint64_t(x+7)<<56));
     }
+    // Check test vectors from spec, all at once and split at an unaligned position
+    unsigned char testvec_in[std::size(siphash_4_2_testvec)];
+    for (size_t x = 0; x < std::size(testvec_in); ++x) testvec_in[x] = x;
+    for (size_t x = 0; x < std::size(siphash_4_2_testvec); ++x) {
+        BOOST_CHECK_EQUAL(CSipHasher(0x0706050403020100ULL, 0x0F0E0D0C0B0A0908ULL).Write(testvec_in, x).Finalize(), siphash_4_2_testvec[x]);
+        const size_t split = std::min<size_t>(x, 3);
+        BOOST_CHECK_EQUAL(CSipHasher(0x0706050403020100ULL, 0x0F0E0D0C0B0A0908ULL).Write(testvec_in, split).Write(testvec_in + split, x - split).Finalize(), siphash_4_2_testvec[x]);
+    }
 
     CHashWriter ss(SER_DISK, CLIENT_VERSION);
     CMutableTransaction tx;
@@ -0,0 +1,107 @@
+// Copyright (c) 2024 The Maximus developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <llmq/clsig.h>
+#include <llmq/instantsend.h>
+#include <llmq/signing.h>
+#include <streams.h>
+#include <version.h>
+
+#include <test/util/setup_common.h>
+
+#include <boost/test/unit_test.hpp>
+
+using namespace llmq;
+
+template <typename T>
+static T RoundTrip(const T& obj)
+{
+    CDataStream ss(SER_NETWORK, PROTOCOL_VERSION);
+    ss << obj;
+    T ret;
+    ss >> ret;
+    return ret;
+}
+
+static CRecoveredSig MakeRecoveredSig(const uint256& id, const uint256& msgHash)
+{
+    CBLSSecretKey sk;
+    sk.MakeNewKey();
+    return CRecoveredSig(Consensus::LLMQType::LLMQ_TEST, uint256::ONE, id, msgHash, sk.Sign(msgHash));
+}
+
+BOOST_FIXTURE_TEST_SUITE(llmq_compactlocks_tests, BasicTestingSetup)
+
+BOOST_AUTO_TEST_CASE(compact_chainlock)
+{
+    const int32_t nHeight{1000};
+    const uint256 blockHash = InsecureRand256();
+    const uint256 requestId = ::SerializeHash(std::make_pair(CLSIG_REQUESTID_PREFIX, nHeight));
+    const CRecoveredSig recSig = MakeRecoveredSig(requestId, blockHash);
+    const CChainLockSig clsig(nHeight, blockHash, recSig.sig.Get());
+    const uint256 hash = ::SerializeHash(clsig);
+
+    const CCompactChainLockSig cmpctclsig = RoundTrip(CCompactChainLockSig(hash, clsig));
+    BOOST_CHECK(cmpctclsig.hash == hash);
+
+    // with the recovered sig the full CLSIG is rebuilt
+    const CChainLockSig rebuilt = cmpctclsig.Expand(recSig.sig.Get());
+    BOOST_CHECK(cmpctclsig.Matches(rebuilt));
+    BOOST_CHECK(::SerializeHash(rebuilt) == hash);
+    BOOST_CHECK_EQUAL(rebuilt.ToString(), clsig.ToString());
+
+    // a recovered sig made by another quorum doesn't give the same CLSIG, so it has to be fetched instead
+    const CRecoveredSig otherSig = MakeRecoveredSig(requestId, blockHash);
+    BOOST_CHECK(!cmpctclsig.Matches(cmpctclsig.Expand(otherSig.sig.Get())));
+
+    // so does a compact CLSIG which doesn't belong to the announced hash
+    CCompactChainLockSig tampered = cmpctclsig;
+    tampered.nHeight++;
+    BOOST_CHECK(!tampered.Matches(tampered.Expand(recSig.sig.Get())));
+}
+
+BOOST_AUTO_TEST_CASE(compact_instantsendlock)
+{
+    CMutableTransaction mtx;
+    for (int i = 0; i < 3; ++i) {
+        mtx.vin.emplace_back(COutPoint(InsecureRand256(), i));
+    }
+    mtx.vout.emplace_back(1 * COIN, CScript() << OP_TRUE);
+    const CTransaction tx(mtx);
+
+    CInstantSendLock islock;
+    for (const auto& in : tx.vin) {
+        islock.inputs.emplace_back(in.prevout);
+    }
+    islock.txid = tx.GetHash();
+    islock.cycleHash = InsecureRand256();
+    const CRecoveredSig recSig = MakeRecoveredSig(islock.GetRequestId(), islock.txid);
+    islock.sig = recSig.sig;
+    const uint256 hash = ::SerializeHash(islock);
+
+    const CCompactInstantSendLock cmpctislock = RoundTrip(CCompactInstantSendLock(hash, islock));
+    BOOST_CHECK(cmpctislock.hash == hash);
+
+    // the inputs come from the transaction, which also gives the request id of the recovered sig
+    const CInstantSendLockPtr rebuilt = cmpctislock.Expand(tx);
+    BOOST_CHECK(rebuilt->inputs == islock.inputs);
+    BOOST_CHECK(rebuilt->GetRequestId() == recSig.getId());
+    BOOST_CHECK(!cmpctislock.Matches(*rebuilt));
+    rebuilt->sig = recSig.sig;
+    BOOST_CHECK(cmpctislock.Matches(*rebuilt));
+    BOOST_CHECK(::SerializeHash(*rebuilt) == hash);
+
+    // a recovered sig made by another quorum doesn't give the same ISLOCK, so it has to be fetched instead
+    rebuilt->sig = MakeRecoveredSig(recSig.getId(), islock.txid).sig;
+    BOOST_CHECK(!cmpctislock.Matches(*rebuilt));
+
+    // so does a compact ISLOCK which doesn't belong to the announced hash
+    CCompactInstantSendLock tampered = cmpctislock;
+    tampered.cycleHash = InsecureRand256();
+    const CInstantSendLockPtr fromTampered = tampered.Expand(tx);
+    fromTampered->sig = recSig.sig;
+    BOOST_CHECK(!tampered.Matches(*fromTampered));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
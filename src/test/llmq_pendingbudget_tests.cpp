@@ -0,0 +1,62 @@
+// Copyright (c) 2024 The Maximus developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <llmq/pendingbudget.h>
+
+#include <test/util/setup_common.h>
+
+#include <boost/test/unit_test.hpp>
+
+using namespace llmq;
+
+BOOST_FIXTURE_TEST_SUITE(llmq_pendingbudget_tests, BasicTestingSetup)
+
+BOOST_AUTO_TEST_CASE(pause_heaviest_peer)
+{
+    CPendingMessagesBudget budget(1000);
+
+    // below the budget nobody is paused
+    budget.Charge(1, 600);
+    budget.Charge(2, 300);
+    BOOST_CHECK(!budget.IsPaused(1));
+    BOOST_CHECK(!budget.IsPaused(2));
+    BOOST_CHECK_EQUAL(budget.GetUsage(), 900U);
+
+    // a light peer which crosses the budget keeps going, the heavy one doesn't
+    budget.Charge(2, 150);
+    BOOST_CHECK(!budget.IsPaused(2));
+    budget.Charge(1, 100);
+    BOOST_CHECK(budget.IsPaused(1));
+    BOOST_CHECK(!budget.IsPaused(2));
+    BOOST_CHECK_EQUAL(budget.GetPausedCount(), 1U);
+
+    // still above 3/4 of the budget
+    budget.Release(2, 200);
+    BOOST_CHECK(budget.IsPaused(1));
+
+    budget.Release(1, 400);
+    BOOST_CHECK(!budget.IsPaused(1));
+    BOOST_CHECK_EQUAL(budget.GetUsage(), 550U);
+
+    // releasing more than was charged or for unknown peers doesn't underflow
+    budget.Release(2, 1000);
+    budget.Release(3, 1000);
+    BOOST_CHECK_EQUAL(budget.GetUsage(), 300U);
+}
+
+BOOST_AUTO_TEST_CASE(remove_node)
+{
+    CPendingMessagesBudget budget(100);
+    budget.Charge(1, 200);
+    BOOST_CHECK(budget.IsPaused(1));
+    budget.RemoveNode(1);
+    BOOST_CHECK(!budget.IsPaused(1));
+    BOOST_CHECK_EQUAL(budget.GetUsage(), 0U);
+
+    // messages of unknown peers are never charged
+    budget.Charge(-1, 500);
+    BOOST_CHECK_EQUAL(budget.GetUsage(), 0U);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,89 @@
+// Copyright (c) 2024 The Maximus developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <llmq/signing_shares.h>
+
+#include <test/util/setup_common.h>
+
+#include <boost/test/unit_test.hpp>
+
+using namespace llmq;
+
+BOOST_FIXTURE_TEST_SUITE(llmq_signing_shares_tests, BasicTestingSetup)
+
+BOOST_AUTO_TEST_CASE(sigsharemap_flat_session)
+{
+    const uint256 signHash = uint256::ONE;
+    SigShareMap<int64_t> map;
+
+    // members arrive out of order and beyond the initially allocated table
+    for (uint16_t member : {7, 0, 399, 64, 63}) {
+        BOOST_CHECK(map.Add({signHash, member}, member * 10));
+    }
+    BOOST_CHECK(!map.Add({signHash, 7}, 1));
+    BOOST_CHECK_EQUAL(map.CountForSignHash(signHash), 5U);
+    BOOST_CHECK_EQUAL(*map.Get({signHash, 399}), 3990);
+    BOOST_CHECK(map.Get({signHash, 1}) == nullptr);
+    BOOST_CHECK(!map.Has({uint256::ZERO, 0}));
+
+    // erasing moves the last entry into the freed slot, lookups must still be correct afterwards
+    map.Erase({signHash, 7});
+    BOOST_CHECK(!map.Has({signHash, 7}));
+    for (uint16_t member : {0, 399, 64, 63}) {
+        BOOST_CHECK_EQUAL(*map.Get({signHash, member}), member * 10);
+    }
+
+    map.EraseIf([](const SigShareKey& k, int64_t) { return k.second >= 63; });
+    BOOST_CHECK_EQUAL(map.CountForSignHash(signHash), 1U);
+    BOOST_CHECK(map.Has({signHash, 0}));
+
+    size_t seen{0};
+    map.ForEach([&](const SigShareKey& k, int64_t v) {
+        BOOST_CHECK_EQUAL(k.second, 0);
+        BOOST_CHECK_EQUAL(v, 0);
+        ++seen;
+    });
+    BOOST_CHECK_EQUAL(seen, 1U);
+
+    map.Erase({signHash, 0});
+    BOOST_CHECK(map.Empty());
+    BOOST_CHECK(map.GetAllForSignHash(signHash) == nullptr);
+}
+
+BOOST_AUTO_TEST_CASE(sigsharesstore_add_and_timeout)
+{
+    CSigSharesStore store;
+    uint256 id;
+    std::vector<CSigShare> sigShares;
+    for (uint16_t member = 0; member < 3; member++) {
+        sigShares.emplace_back(Consensus::LLMQType::LLMQ_TEST, uint256::ONE, id, id, member, CBLSLazySignature());
+        sigShares.back().UpdateKey();
+    }
+    const uint256 signHash = sigShares[0].GetSignHash();
+
+    size_t count{0};
+    BOOST_CHECK(store.Add(sigShares[0], 100, count));
+    BOOST_CHECK_EQUAL(count, 1U);
+    BOOST_CHECK(store.Add(sigShares[2], 200, count));
+    BOOST_CHECK_EQUAL(count, 2U);
+    BOOST_CHECK(!store.Add(sigShares[2], 300, count));
+
+    BOOST_CHECK(store.Has(sigShares[2].GetKey()));
+    BOOST_CHECK(!store.Has(sigShares[1].GetKey()));
+    BOOST_CHECK(store.Get(sigShares[0].GetKey()).has_value());
+    BOOST_CHECK(!store.Get(sigShares[1].GetKey()).has_value());
+
+    // the session was last seen at 200
+    BOOST_CHECK(store.GetTimedOutSessions(259, 60).empty());
+    BOOST_CHECK(store.GetTimedOutSessions(260, 60) == std::vector<uint256>{signHash});
+
+    BOOST_CHECK(store.WithSigSharesForSignHash(signHash, [](const auto& m) { BOOST_CHECK_EQUAL(m.size(), 2U); }));
+
+    store.EraseAllForSignHash(signHash);
+    BOOST_CHECK_EQUAL(store.CountForSignHash(signHash), 0U);
+    BOOST_CHECK(store.GetTimedOutSessions(1000, 60).empty());
+    BOOST_CHECK(!store.WithSigSharesForSignHash(signHash, [](const auto&) { BOOST_ERROR("no sig shares expected"); }));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
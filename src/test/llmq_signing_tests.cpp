@@ -0,0 +1,48 @@
+// Copyright (c) 2024 The Maximus developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <llmq/signing.h>
+
+#include <test/util/setup_common.h>
+
+#include <boost/test/unit_test.hpp>
+
+using namespace llmq;
+
+BOOST_FIXTURE_TEST_SUITE(llmq_signing_tests, BasicTestingSetup)
+
+BOOST_AUTO_TEST_CASE(recsigsdb_filtered_lookups)
+{
+    const auto llmqType = Consensus::LLMQType::LLMQ_TEST;
+    CRecoveredSigsDb db(/*fMemory=*/true, /*fWipe=*/false);
+    std::vector<CRecoveredSig> recSigs;
+    for (int i = 0; i < 10; ++i) {
+        CBLSSecretKey sk;
+        sk.MakeNewKey();
+        const uint256 id = InsecureRand256();
+        const uint256 msgHash = InsecureRand256();
+        recSigs.emplace_back(llmqType, uint256::ONE, id, msgHash, sk.Sign(msgHash));
+        db.WriteRecoveredSig(recSigs.back());
+    }
+
+    for (const auto& recSig : recSigs) {
+        BOOST_CHECK(db.HasRecoveredSig(llmqType, recSig.getId(), recSig.getMsgHash()));
+        BOOST_CHECK(db.HasRecoveredSigForId(llmqType, recSig.getId()));
+        BOOST_CHECK(db.HasRecoveredSigForSession(recSig.buildSignHash()));
+        BOOST_CHECK(db.HasRecoveredSigForHash(recSig.GetHash()));
+    }
+    for (int i = 0; i < 100; ++i) {
+        const uint256 unknown = InsecureRand256();
+        BOOST_CHECK(!db.HasRecoveredSigForId(llmqType, unknown));
+        BOOST_CHECK(!db.HasRecoveredSigForSession(unknown));
+        BOOST_CHECK(!db.HasRecoveredSigForHash(unknown));
+    }
+
+    // truncated sigs are still known by their hash
+    db.TruncateRecoveredSig(llmqType, recSigs[0].getId());
+    BOOST_CHECK(!db.HasRecoveredSigForId(llmqType, recSigs[0].getId()));
+    BOOST_CHECK(db.HasRecoveredSigForHash(recSigs[0].GetHash()));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
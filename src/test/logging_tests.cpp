@@ -3,10 +3,14 @@
 // file COPYING or http://www.opensource.org/licenses/mit-license.php.
 
 #include <logging.h>
+#include <logging/ringbuffer.h>
 #include <logging/timer.h>
 #include <test/util/setup_common.h>
 
 #include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
 
 #include <boost/test/unit_test.hpp>
 
@@ -33,4 +37,87 @@ BOOST_AUTO_TEST_CASE(logging_timer)
     SetMockTime(0);
 }
 
+BOOST_AUTO_TEST_CASE(logging_ringbuffer)
+{
+    BCLog::RingBuffer<std::string> buffer(3);
+    BOOST_CHECK_EQUAL(buffer.Capacity(), 4U);
+    BOOST_CHECK(buffer.Empty());
+
+    std::string str;
+    BOOST_CHECK(!buffer.TryPop(str));
+    // wrap around a few times
+    for (int round = 0; round < 3; round++) {
+        for (int i = 0; i < 4; i++) {
+            BOOST_CHECK(buffer.TryPush(std::to_string(i)));
+        }
+        std::string overflow{"overflow"};
+        BOOST_CHECK(!buffer.TryPush(std::move(overflow)));
+        BOOST_CHECK_EQUAL(overflow, "overflow");
+        for (int i = 0; i < 4; i++) {
+            BOOST_CHECK(buffer.TryPop(str));
+            BOOST_CHECK_EQUAL(str, std::to_string(i));
+        }
+        BOOST_CHECK(!buffer.TryPop(str));
+        BOOST_CHECK(buffer.Empty());
+    }
+
+    // concurrent producers, every value arrives exactly once and in order per producer
+    constexpr int PRODUCERS{4};
+    constexpr int VALUES{10000};
+    BCLog::RingBuffer<std::string> shared(64);
+    std::vector<std::thread> producers;
+    for (int p = 0; p < PRODUCERS; p++) {
+        producers.emplace_back([&shared, p] {
+            for (int i = 0; i < VALUES; i++) {
+                std::string value = strprintf("%d %d", p, i);
+                while (!shared.TryPush(std::move(value))) {
+                    std::this_thread::yield();
+                }
+            }
+        });
+    }
+    std::vector<int> next(PRODUCERS, 0);
+    for (int received = 0; received < PRODUCERS * VALUES;) {
+        if (!shared.TryPop(str)) {
+            std::this_thread::yield();
+            continue;
+        }
+        int p, i;
+        BOOST_REQUIRE_EQUAL(sscanf(str.c_str(), "%d %d", &p, &i), 2);
+        BOOST_REQUIRE(p >= 0 && p < PRODUCERS);
+        BOOST_CHECK_EQUAL(i, next[p]++);
+        received++;
+    }
+    for (auto& t : producers) t.join();
+    BOOST_CHECK(!shared.TryPop(str));
+}
+
+BOOST_AUTO_TEST_CASE(logging_async)
+{
+    BCLog::Logger logger;
+    logger.m_log_timestamps = false;
+    logger.m_async_capacity = 16;
+    std::vector<std::string> lines;
+    logger.PushBackCallback([&lines](const std::string& s) { lines.push_back(s); });
+
+    logger.LogPrintStr("before start\n");
+    BOOST_CHECK(logger.StartLogging());
+    BOOST_CHECK(logger.Enabled());
+    for (int i = 0; i < 10; i++) {
+        logger.LogPrintStr(strprintf("line %d\n", i));
+    }
+    logger.StopAsyncLogging();
+    logger.LogPrintStr("after stop\n");
+
+    // Fewer lines than the queue holds, so nothing was dropped and all arrive in order
+    std::vector<std::string> expected{"before start\n"};
+    for (int i = 0; i < 10; i++) {
+        expected.push_back(strprintf("line %d\n", i));
+    }
+    expected.push_back("after stop\n");
+    BOOST_CHECK_EQUAL(logger.GetAsyncDropped(), 0U);
+    BOOST_CHECK_EQUAL_COLLECTIONS(lines.begin(), lines.end(), expected.begin(), expected.end());
+    logger.DisconnectTestLogger();
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -2,7 +2,10 @@
 // Distributed under the MIT software license, see the accompanying
 // file COPYING or http://www.opensource.org/licenses/mit-license.php.
 
+#include <evo/assetlocktx.h>
+#include <evo/specialtx.h>
 #include <policy/policy.h>
+#include <script/standard.h>
 #include <txmempool.h>
 #include <util/system.h>
 #include <util/time.h>
@@ -77,6 +80,20 @@ BOOST_AUTO_TEST_CASE(MempoolRemoveTest)
         testPool.addUnchecked(entry.FromTx(txChild[i]));
         testPool.addUnchecked(entry.FromTx(txGrandChild[i]));
     }
+    // Both descendant walks find the parent and its six descendants, the vector one parent first:
+    {
+        CTxMemPool::txiter parentIt = testPool.mapTx.find(txParent.GetHash());
+        CTxMemPool::vecEntries descendants;
+        CTxMemPool::setEntries setDescendants;
+        testPool.CalculateDescendants(parentIt, descendants);
+        testPool.CalculateDescendants(parentIt, setDescendants);
+        BOOST_CHECK_EQUAL(descendants.size(), 7U);
+        BOOST_CHECK(descendants.front() == parentIt);
+        BOOST_CHECK(CTxMemPool::setEntries(descendants.begin(), descendants.end()) == setDescendants);
+        // The vector overload starts afresh on every call
+        testPool.CalculateDescendants(testPool.mapTx.find(txChild[0].GetHash()), descendants);
+        BOOST_CHECK_EQUAL(descendants.size(), 2U);
+    }
     // Remove Child[0], GrandChild[0] should be removed:
     poolSize = testPool.size();
     testPool.removeRecursive(CTransaction(txChild[0]), REMOVAL_REASON_DUMMY);
@@ -106,6 +123,19 @@ BOOST_AUTO_TEST_CASE(MempoolRemoveTest)
     testPool.removeRecursive(CTransaction(txParent), REMOVAL_REASON_DUMMY);
     BOOST_CHECK_EQUAL(testPool.size(), poolSize - 6);
     BOOST_CHECK_EQUAL(testPool.size(), 0U);
+
+    // Batched removal of overlapping trees and a tx which isn't in the pool:
+    testPool.addUnchecked(entry.FromTx(txParent));
+    for (int i = 0; i < 3; i++)
+    {
+        testPool.addUnchecked(entry.FromTx(txChild[i]));
+        testPool.addUnchecked(entry.FromTx(txGrandChild[i]));
+    }
+    testPool.removeRecursive({MakeTransactionRef(txChild[0]), MakeTransactionRef(txGrandChild[0]), MakeTransactionRef(txChild[1])}, REMOVAL_REASON_DUMMY);
+    BOOST_CHECK_EQUAL(testPool.size(), 3U);
+    BOOST_CHECK(testPool.exists(txChild[2].GetHash()));
+    testPool.removeRecursive({MakeTransactionRef(txChild[0]), MakeTransactionRef(txParent)}, REMOVAL_REASON_DUMMY);
+    BOOST_CHECK_EQUAL(testPool.size(), 0U);
 }
 
 template<typename name>
@@ -575,6 +605,43 @@ BOOST_AUTO_TEST_CASE(MempoolSizeLimitTest)
     SetMockTime(0);
 }
 
+BOOST_AUTO_TEST_CASE(MempoolSizeLimitBatchTest)
+{
+    CTxMemPool pool;
+    LOCK2(cs_main, pool.cs);
+    TestMemPoolEntryHelper entry;
+
+    // Unrelated transactions, in order of increasing feerate
+    std::vector<CTransactionRef> txs;
+    for (int i = 0; i < 50; ++i) {
+        CMutableTransaction tx = CMutableTransaction();
+        tx.vin.resize(1);
+        tx.vin[0].scriptSig = CScript() << i;
+        tx.vout.resize(1);
+        tx.vout[0].scriptPubKey = CScript() << OP_1 << OP_EQUAL;
+        tx.vout[0].nValue = 10 * COIN;
+        txs.push_back(MakeTransactionRef(tx));
+        pool.addUnchecked(entry.Fee(1000LL + 100 * i).FromTx(txs.back()));
+    }
+
+    // All packages that have to go are removed in one batch
+    const size_t limit = pool.DynamicMemoryUsage() / 2;
+    pool.TrimToSize(limit);
+    BOOST_CHECK(pool.DynamicMemoryUsage() <= limit);
+    size_t removed = 0;
+    while (removed < txs.size() && !pool.exists(txs[removed]->GetHash())) {
+        ++removed;
+    }
+    BOOST_CHECK(removed > 1 && removed < txs.size());
+    for (size_t i = removed; i < txs.size(); ++i) {
+        BOOST_CHECK(pool.exists(txs[i]->GetHash()));
+    }
+
+    // ... but not more than that
+    pool.addUnchecked(entry.Fee(1000LL + 100 * (removed - 1)).FromTx(txs[removed - 1]));
+    BOOST_CHECK(pool.DynamicMemoryUsage() > limit);
+}
+
 inline CTransactionRef make_tx(std::vector<CAmount>&& output_values, std::vector<CTransactionRef>&& inputs=std::vector<CTransactionRef>(), std::vector<uint32_t>&& input_indices=std::vector<uint32_t>())
 {
     CMutableTransaction tx = CMutableTransaction();
@@ -788,4 +855,143 @@ BOOST_AUTO_TEST_CASE(MempoolAncestryTests)
     BOOST_CHECK_EQUAL(descendants, 4ULL);
 }
 
+BOOST_AUTO_TEST_CASE(MempoolAddressIndexTest)
+{
+    TestMemPoolEntryHelper entry;
+    const uint160 addressA{ParseHex("0102030405060708090a0b0c0d0e0f1011121314")};
+    const uint160 addressB{ParseHex("1112131415161718191a1b1c1d1e1f2021222324")};
+
+    // tx[0] pays A twice, tx[1] pays A and B, tx[2] pays A
+    CMutableTransaction tx[3];
+    for (int i = 0; i < 3; i++) {
+        tx[i].vin.resize(1);
+        tx[i].vin[0].prevout = COutPoint(InsecureRand256(), 0);
+        tx[i].vout.resize(2);
+        for (int j = 0; j < 2; j++) {
+            tx[i].vout[j].scriptPubKey = GetScriptForDestination(PKHash(i == 1 && j == 1 ? addressB : addressA));
+            tx[i].vout[j].nValue = (i * 2 + j + 1) * COIN;
+        }
+    }
+    tx[2].vout.resize(1);
+
+    CTxMemPool testPool;
+    LOCK2(cs_main, testPool.cs);
+    CCoinsView dummy;
+    CCoinsViewCache view(&dummy);
+
+    const std::vector<std::pair<uint160, AddressType>> addresses{{addressA, AddressType::P2PK_OR_P2PKH}};
+    const auto get_deltas = [&]() {
+        std::vector<std::pair<CMempoolAddressDeltaKey, CMempoolAddressDelta>> results;
+        BOOST_CHECK(testPool.getAddressIndex(addresses, results));
+        return results;
+    };
+
+    for (int i = 0; i < 3; i++) {
+        testPool.addUnchecked(entry.FromTx(tx[i]));
+        const size_t usage = testPool.DynamicMemoryUsage();
+        testPool.addAddressIndex(entry.FromTx(tx[i]), view);
+        // The index is accounted for in the mempool usage
+        BOOST_CHECK(testPool.DynamicMemoryUsage() > usage);
+    }
+    BOOST_CHECK_EQUAL(get_deltas().size(), 4U);
+
+    // Removing a transaction moves the deltas of the others around in the bucket
+    testPool.removeRecursive(CTransaction(tx[0]), REMOVAL_REASON_DUMMY);
+    auto deltas = get_deltas();
+    BOOST_CHECK_EQUAL(deltas.size(), 2U);
+    for (const auto& [key, delta] : deltas) {
+        BOOST_CHECK(key.m_tx_hash == tx[1].GetHash() || key.m_tx_hash == tx[2].GetHash());
+        BOOST_CHECK_EQUAL(key.m_tx_index, 0U);
+        BOOST_CHECK_EQUAL(delta.m_amount, key.m_tx_hash == tx[1].GetHash() ? 3 * COIN : 5 * COIN);
+    }
+
+    testPool.removeRecursive(CTransaction(tx[2]), REMOVAL_REASON_DUMMY);
+    deltas = get_deltas();
+    BOOST_CHECK_EQUAL(deltas.size(), 1U);
+    BOOST_CHECK(deltas[0].first.m_tx_hash == tx[1].GetHash());
+
+    testPool.removeRecursive(CTransaction(tx[1]), REMOVAL_REASON_DUMMY);
+    BOOST_CHECK(get_deltas().empty());
+}
+
+BOOST_AUTO_TEST_CASE(MempoolSpentIndexTest)
+{
+    TestMemPoolEntryHelper entry;
+    const uint160 address{ParseHex("0102030405060708090a0b0c0d0e0f1011121314")};
+
+    CTxMemPool testPool;
+    LOCK2(cs_main, testPool.cs);
+    CCoinsView dummy;
+    CCoinsViewCache view(&dummy);
+
+    CMutableTransaction tx;
+    tx.vin.resize(2);
+    for (uint32_t j = 0; j < 2; j++) {
+        tx.vin[j].prevout = COutPoint(InsecureRand256(), j);
+        view.AddCoin(tx.vin[j].prevout, Coin(CTxOut((j + 1) * COIN, GetScriptForDestination(PKHash(address))), 1, false), false);
+    }
+    tx.vout.resize(1);
+    tx.vout[0].nValue = COIN;
+
+    testPool.addUnchecked(entry.FromTx(tx));
+    testPool.addSpentIndex(entry.FromTx(tx), view);
+
+    // Both spent outputs are found in one call, the unknown key is reported back
+    const CSpentIndexKey unknown(InsecureRand256(), 0);
+    std::vector<CSpentIndexKey> keys{{tx.vin[0].prevout.hash, tx.vin[0].prevout.n}, unknown, {tx.vin[1].prevout.hash, tx.vin[1].prevout.n}};
+    CSpentIndexTxInfo info;
+    std::vector<CSpentIndexKey> missing;
+    testPool.getSpentIndexes(keys, info, missing);
+    BOOST_CHECK_EQUAL(info.mSpentInfo.size(), 2U);
+    BOOST_CHECK_EQUAL(missing.size(), 1U);
+    BOOST_CHECK(missing[0].m_tx_hash == unknown.m_tx_hash);
+    for (uint32_t j = 0; j < 2; j++) {
+        const auto it = info.mSpentInfo.find(keys[j * 2]);
+        BOOST_REQUIRE(it != info.mSpentInfo.end());
+        BOOST_CHECK(it->second.m_tx_hash == tx.GetHash());
+        BOOST_CHECK_EQUAL(it->second.m_tx_index, j);
+        BOOST_CHECK_EQUAL(it->second.m_amount, (j + 1) * COIN);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(MempoolAssetUnlockIndexTest)
+{
+    TestMemPoolEntryHelper entry;
+
+    const auto make_unlock = [](uint64_t index, CAmount value) {
+        CMutableTransaction tx;
+        tx.nVersion = 3;
+        tx.nType = TRANSACTION_ASSET_UNLOCK;
+        tx.vout.emplace_back(value, CScript() << OP_TRUE);
+        SetTxPayload(tx, CAssetUnlockPayload(1, index, 1000, 100, uint256::ONE, CBLSSignature()));
+        return tx;
+    };
+    const CMutableTransaction unlock1{make_unlock(101, COIN)};
+    const CMutableTransaction unlock2{make_unlock(102, COIN)};
+    // same withdrawal index as unlock1, different tx
+    const CMutableTransaction unlock1_dup{make_unlock(101, 2 * COIN)};
+
+    CTxMemPool testPool;
+    LOCK2(cs_main, testPool.cs);
+    BOOST_CHECK(!testPool.hasAssetLockUnlockTxs());
+
+    testPool.addUnchecked(entry.FromTx(unlock1));
+    testPool.addUnchecked(entry.FromTx(unlock2));
+    BOOST_CHECK(testPool.hasAssetLockUnlockTxs());
+    BOOST_CHECK(testPool.existsAssetUnlockIndex(101));
+    BOOST_CHECK(testPool.existsAssetUnlockIndex(102));
+    BOOST_CHECK(!testPool.existsAssetUnlockIndex(103));
+    BOOST_CHECK(testPool.existsProviderTxConflict(CTransaction(unlock1_dup)));
+    BOOST_CHECK(!testPool.existsProviderTxConflict(CTransaction(make_unlock(103, COIN))));
+
+    testPool.removeRecursive(CTransaction(unlock1), REMOVAL_REASON_DUMMY);
+    BOOST_CHECK(!testPool.existsAssetUnlockIndex(101));
+    BOOST_CHECK(!testPool.existsProviderTxConflict(CTransaction(unlock1_dup)));
+    BOOST_CHECK(testPool.hasAssetLockUnlockTxs());
+
+    testPool.removeRecursive(CTransaction(unlock2), REMOVAL_REASON_DUMMY);
+    BOOST_CHECK(!testPool.existsAssetUnlockIndex(102));
+    BOOST_CHECK(!testPool.hasAssetLockUnlockTxs());
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -326,4 +326,40 @@ BOOST_AUTO_TEST_CASE(merkle_test_LeftSubtreeRightSubtree)
     BOOST_CHECK_EQUAL(root, rootOfLR);
 }
 
+BOOST_AUTO_TEST_CASE(merkle_test_levels)
+{
+    for (const size_t count : {0, 1, 2, 3, 7, 8, 9, 31, 100}) {
+        std::vector<uint256> leaves(count);
+        for (auto& leaf : leaves) {
+            leaf = InsecureRand256();
+        }
+        const auto levels = ComputeMerkleLevels(leaves);
+        BOOST_CHECK(levels[0] == leaves);
+        BOOST_CHECK_EQUAL(levels.back().size(), std::min<size_t>(count, 1));
+        if (count != 0) {
+            BOOST_CHECK_EQUAL(levels.back()[0], ComputeMerkleRoot(leaves));
+        }
+
+        for (size_t i = 0; i + 1 < levels.size(); i++) {
+            // every inner node is the hash of its children, with the last child of an odd level paired with itself
+            for (size_t j = 0; j < levels[i + 1].size(); j++) {
+                const uint256& left = levels[i][2 * j];
+                const uint256& right = 2 * j + 1 < levels[i].size() ? levels[i][2 * j + 1] : left;
+                BOOST_CHECK_EQUAL(levels[i + 1][j], Hash(left, right));
+            }
+
+            // recomputing a subset of the parents gives the same hashes
+            std::vector<size_t> positions;
+            for (size_t j = 0; j < levels[i + 1].size(); j += 1 + InsecureRandRange(3)) {
+                positions.push_back(j);
+            }
+            std::vector<uint256> parents(levels[i + 1].size());
+            ComputeMerkleParents(levels[i], positions, parents);
+            for (const size_t j : positions) {
+                BOOST_CHECK_EQUAL(parents[j], levels[i + 1][j]);
+            }
+        }
+    }
+}
+
 BOOST_AUTO_TEST_SUITE_END()
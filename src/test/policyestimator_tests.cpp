@@ -2,8 +2,11 @@
 // Distributed under the MIT software license, see the accompanying
 // file COPYING or http://www.opensource.org/licenses/mit-license.php.
 
+#include <clientversion.h>
+#include <fs.h>
 #include <policy/fees.h>
 #include <policy/policy.h>
+#include <streams.h>
 #include <txmempool.h>
 #include <uint256.h>
 #include <util/time.h>
@@ -180,4 +183,72 @@ BOOST_AUTO_TEST_CASE(BlockPolicyEstimates)
     }
 }
 
+BOOST_AUTO_TEST_CASE(BlockPolicyEstimatesPersistence)
+{
+    CBlockPolicyEstimator feeEst;
+    CTxMemPool mpool(&feeEst);
+    LOCK2(cs_main, mpool.cs);
+    TestMemPoolEntryHelper entry;
+
+    CMutableTransaction tx;
+    tx.vin.resize(1);
+    tx.vout.resize(1);
+
+    // Higher fee txs get mined sooner
+    std::vector<uint256> txHashes[10];
+    std::vector<CTransactionRef> block;
+    int blocknum = 0;
+    while (blocknum < 100) {
+        for (int j = 0; j < 10; j++) {
+            tx.vin[0].prevout.n = 100 * blocknum + j;
+            mpool.addUnchecked(entry.Fee(1000 * (j + 1)).Time(GetTime()).Height(blocknum).FromTx(tx));
+            txHashes[j].push_back(tx.GetHash());
+        }
+        for (int j = 9 - blocknum % 10; j < 10; j++) {
+            for (const auto& hash : txHashes[j]) {
+                if (auto ptx = mpool.get(hash)) block.push_back(ptx);
+            }
+            txHashes[j].clear();
+        }
+        mpool.removeForBlock(block, ++blocknum);
+        block.clear();
+    }
+
+    // Cached smart fee estimates match the ones calculated after a block cleared the cache
+    FeeCalculation feeCalc;
+    const CFeeRate smartFee = feeEst.estimateSmartFee(6, &feeCalc, true);
+    BOOST_CHECK(smartFee != CFeeRate(0));
+    FeeCalculation cachedFeeCalc;
+    BOOST_CHECK(feeEst.estimateSmartFee(6, &cachedFeeCalc, true) == smartFee);
+    BOOST_CHECK_EQUAL(cachedFeeCalc.returnedTarget, feeCalc.returnedTarget);
+    BOOST_CHECK(cachedFeeCalc.reason == feeCalc.reason);
+
+    // The written estimates don't depend on the lazily applied decay
+    const fs::path path = GetDataDir() / "fee_estimates_test.dat";
+    {
+        CAutoFile file(fsbridge::fopen(path, "wb"), SER_DISK, CLIENT_VERSION);
+        BOOST_REQUIRE(feeEst.Write(file));
+    }
+    CBlockPolicyEstimator feeEstRead;
+    {
+        CAutoFile file(fsbridge::fopen(path, "rb"), SER_DISK, CLIENT_VERSION);
+        BOOST_REQUIRE(feeEstRead.Read(file));
+    }
+
+    // Enough empty blocks to normalize the moving averages of all horizons on the way
+    std::vector<const CTxMemPoolEntry*> noEntries;
+    for (int i = 0; i <= 2000; i += 250) {
+        for (int target = 1; target <= 48; target++) {
+            for (const auto horizon : {FeeEstimateHorizon::SHORT_HALFLIFE, FeeEstimateHorizon::MED_HALFLIFE, FeeEstimateHorizon::LONG_HALFLIFE}) {
+                BOOST_CHECK(feeEstRead.estimateRawFee(target, 0.85, horizon) == feeEst.estimateRawFee(target, 0.85, horizon));
+            }
+            BOOST_CHECK(feeEstRead.estimateSmartFee(target, nullptr, false) == feeEst.estimateSmartFee(target, nullptr, false));
+        }
+        for (int j = 0; j < 250; j++) {
+            feeEst.processBlock(++blocknum, noEntries);
+            feeEstRead.processBlock(blocknum, noEntries);
+        }
+    }
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -5,7 +5,9 @@
 #include <chain.h>
 #include <chainparams.h>
 #include <pow.h>
+#include <primitives/block.h>
 #include <test/util/setup_common.h>
+#include <validation.h>
 
 #include <boost/test/unit_test.hpp>
 
@@ -254,4 +256,54 @@ BOOST_AUTO_TEST_CASE(GetBlockProofEquivalentTime_test)
     }
 }
 
+BOOST_AUTO_TEST_CASE(CheckHeadersProofOfWork_test)
+{
+    const auto chainParams = CreateChainParams(*m_node.args, CBaseChainParams::REGTEST);
+    const auto& consensus = chainParams->GetConsensus();
+
+    // Mine a batch of legacy (chain ID free) headers against the regtest pow limit.
+    std::vector<CBlockHeader> headers(150);
+    for (size_t i = 0; i < headers.size(); ++i) {
+        headers[i].nVersion = 1;
+        headers[i].hashPrevBlock = i ? headers[i - 1].GetHash() : uint256();
+        headers[i].hashMerkleRoot = InsecureRand256();
+        headers[i].nTime = 1269211443 + i;
+        headers[i].nBits = UintToArith256(consensus.powLimit).GetCompact();
+        while (!CheckProofOfWork(headers[i], consensus)) ++headers[i].nNonce;
+    }
+
+    std::vector<uint256> pow_hashes;
+    BOOST_CHECK(CheckHeadersProofOfWork(headers, pow_hashes, consensus));
+    BOOST_REQUIRE_EQUAL(pow_hashes.size(), headers.size());
+    for (size_t i = 0; i < headers.size(); ++i) {
+        BOOST_CHECK(pow_hashes[i] == headers[i].GetPoWHash());
+    }
+
+    // A single header with bad proof of work fails the whole batch.
+    CBlockHeader& bad = headers[InsecureRandRange(headers.size())];
+    while (CheckProofOfWork(bad, consensus)) ++bad.nNonce;
+    BOOST_CHECK(!CheckHeadersProofOfWork(headers, pow_hashes, consensus));
+}
+
+BOOST_AUTO_TEST_CASE(GetPoWHashCached_test)
+{
+    CBlockHeader header;
+    header.nVersion = 1;
+    header.hashPrevBlock = InsecureRand256();
+    header.hashMerkleRoot = InsecureRand256();
+    header.nTime = 1269211443;
+    header.nBits = 0x207fffff;
+
+    for (int i = 0; i < 100; ++i) {
+        header.nNonce = i;
+        const uint256 hash = header.GetPoWHash();
+        BOOST_CHECK(GetPoWHashCached(header) == hash);
+        // A second lookup is served from the memo and must agree as well.
+        BOOST_CHECK(GetPoWHashCached(header) == hash);
+    }
+    // Earlier entries are still correct after more headers were memoized.
+    header.nNonce = 0;
+    BOOST_CHECK(GetPoWHashCached(header) == header.GetPoWHash());
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -295,6 +295,33 @@ BOOST_AUTO_TEST_CASE(json_parse_errors)
     BOOST_CHECK_THROW(ParseNonRFCJSONValue("3J98t1WpEZ73CNmQviecrnyiWrnqRhWNL"), std::runtime_error);
 }
 
+BOOST_AUTO_TEST_CASE(json_stream_writer)
+{
+    const UniValue val = JSON(R"({"a":[1,"two\n",{"b":null,"c":true}],"\"k\"":-1.5,"e":{},"f":[]})");
+
+    // Tiny chunks force a flush after nearly every value
+    std::string streamed;
+    size_t chunks{0};
+    JSONStreamWriter writer([&](const std::string& chunk) { streamed += chunk; ++chunks; }, 4);
+    writer.Write(val);
+    writer.Flush();
+    BOOST_CHECK_EQUAL(streamed, val.write());
+    BOOST_CHECK(chunks > 1);
+
+    const UniValue id{7};
+    streamed.clear();
+    writer.WriteReply(val, NullUniValue, id);
+    writer.WriteRaw("\n");
+    writer.Flush();
+    BOOST_CHECK_EQUAL(streamed, JSONRPCReply(val, NullUniValue, id));
+
+    const UniValue error = JSONRPCError(RPC_MISC_ERROR, "failed");
+    streamed.clear();
+    writer.WriteReply(val, error, id);
+    writer.Flush();
+    BOOST_CHECK_EQUAL(streamed + "\n", JSONRPCReply(val, error, id));
+}
+
 BOOST_AUTO_TEST_CASE(rpc_ban)
 {
     BOOST_CHECK_NO_THROW(CallRPC(std::string("clearbanned")));
@@ -8,7 +8,9 @@
 
 #include <boost/test/unit_test.hpp>
 
+#include <atomic>
 #include <functional>
+#include <future>
 #include <mutex>
 #include <thread>
 #include <vector>
@@ -169,7 +171,100 @@ BOOST_AUTO_TEST_CASE(singlethreadedscheduler_ordered)
     BOOST_CHECK_EQUAL(counter2, 100);
 }
 
+BOOST_AUTO_TEST_CASE(lanes_priority)
+{
+    CScheduler scheduler;
+    std::vector<SchedulerLane> order;
+    const auto now = std::chrono::system_clock::now();
+
+    // All of them are due once the thread starts, the lane decides over the order
+    scheduler.schedule([&] { order.push_back(SchedulerLane::MAINTENANCE); }, now - std::chrono::milliseconds{3}, SchedulerLane::MAINTENANCE);
+    scheduler.schedule([&] { order.push_back(SchedulerLane::NETWORK); }, now - std::chrono::milliseconds{2}, SchedulerLane::NETWORK);
+    scheduler.schedule([&] { order.push_back(SchedulerLane::DEFAULT); }, now - std::chrono::milliseconds{1});
+
+    scheduler.m_service_thread = std::thread([&] { scheduler.serviceQueue(); });
+    scheduler.StopWhenDrained();
+
+    BOOST_REQUIRE_EQUAL(order.size(), 3U);
+    BOOST_CHECK(order[0] == SchedulerLane::DEFAULT);
+    BOOST_CHECK(order[1] == SchedulerLane::NETWORK);
+    BOOST_CHECK(order[2] == SchedulerLane::MAINTENANCE);
+}
+
+BOOST_AUTO_TEST_CASE(lanes_concurrency)
+{
+    CScheduler scheduler;
+    for (int i = 0; i < 3; i++) {
+        scheduler.m_extra_service_threads.emplace_back([&] { scheduler.serviceQueue(); });
+    }
+
+    // A blocked maintenance task doesn't hold back the other lanes
+    std::promise<void> release;
+    std::shared_future<void> released{release.get_future()};
+    std::promise<void> network_done;
+    scheduler.scheduleFromNow([&] { released.wait(); }, std::chrono::milliseconds{0}, SchedulerLane::MAINTENANCE);
+    scheduler.scheduleFromNow([&] { network_done.set_value(); }, std::chrono::milliseconds{1}, SchedulerLane::NETWORK);
+    BOOST_CHECK(network_done.get_future().wait_for(std::chrono::seconds{30}) == std::future_status::ready);
+    release.set_value();
+
+    // Tasks of one lane never run at the same time, even with idle threads around
+    std::atomic<int> running{0};
+    std::atomic<int> max_running{0};
+    for (int i = 0; i < 20; i++) {
+        scheduler.scheduleFromNow([&] {
+            const int n = ++running;
+            int prev = max_running.load();
+            while (prev < n && !max_running.compare_exchange_weak(prev, n)) {}
+            std::this_thread::sleep_for(std::chrono::milliseconds{1});
+            --running;
+        }, std::chrono::milliseconds{0}, SchedulerLane::LLMQ, "llmqtask");
+    }
+    scheduler.StopWhenDrained();
+    BOOST_CHECK_EQUAL(max_running.load(), 1);
+
+    const auto stats = scheduler.GetTaskStats();
+    BOOST_REQUIRE_EQUAL(stats.count("llmqtask"), 1U);
+    BOOST_CHECK(stats.at("llmqtask").lane == SchedulerLane::LLMQ);
+    BOOST_CHECK_EQUAL(stats.at("llmqtask").runs, 20U);
+    BOOST_CHECK(stats.at("llmqtask").max >= std::chrono::milliseconds{1});
+    BOOST_CHECK(stats.at("llmqtask").total >= stats.at("llmqtask").max);
+}
+
 /* disabled for now. See discussion in https://github.com/bitcoin/bitcoin/pull/18174
+BOOST_AUTO_TEST_CASE(lanes_default_serial)
+{
+    CScheduler scheduler;
+    for (int i = 0; i < 4; i++) {
+        scheduler.m_extra_service_threads.emplace_back([&] { scheduler.serviceQueue(); });
+    }
+
+    // Default lane tasks run one at a time and in the order they became due, however many
+    // threads service the queue
+    std::atomic<int> running{0};
+    std::atomic<int> max_running{0};
+    Mutex order_mutex;
+    std::vector<int> order;
+    const auto now = std::chrono::system_clock::now();
+    for (int i = 0; i < 20; i++) {
+        scheduler.schedule([&, i] {
+            const int n = ++running;
+            int prev = max_running.load();
+            while (prev < n && !max_running.compare_exchange_weak(prev, n)) {}
+            WITH_LOCK(order_mutex, order.push_back(i));
+            std::this_thread::sleep_for(std::chrono::milliseconds{1});
+            --running;
+        }, now + std::chrono::microseconds{i});
+    }
+    scheduler.StopWhenDrained();
+
+    BOOST_CHECK_EQUAL(max_running.load(), 1);
+    LOCK(order_mutex);
+    BOOST_REQUIRE_EQUAL(order.size(), 20U);
+    for (int i = 0; i < 20; i++) {
+        BOOST_CHECK_EQUAL(order[i], i);
+    }
+}
+
 BOOST_AUTO_TEST_CASE(mockforward)
 {
     CScheduler scheduler;
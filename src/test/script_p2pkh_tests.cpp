@@ -2,8 +2,14 @@
 // Distributed under the MIT software license, see the accompanying
 // file COPYING or http://www.opensource.org/licenses/mit-license.php.
 
+#include <key.h>
+#include <primitives/transaction.h>
+#include <script/interpreter.h>
 #include <script/script.h>
+#include <script/script_error.h>
+#include <script/standard.h>
 #include <test/util/setup_common.h>
+#include <tinyformat.h>
 
 #include <boost/test/unit_test.hpp>
 
@@ -54,4 +60,62 @@ BOOST_AUTO_TEST_CASE(IsPayToPublicKeyHash)
 
 }
 
+// VerifyScript skips the interpreter for P2PKH. The same output behind an OP_CODESEPARATOR still
+// goes through EvalScript and signs the same script code, so both have to reach the same verdict.
+BOOST_AUTO_TEST_CASE(VerifyScriptP2PKHTemplate)
+{
+    CKey key, other;
+    key.MakeNewKey(true);
+    other.MakeNewKey(false);
+    const std::vector<unsigned char> pubkey = ToByteVector(key.GetPubKey());
+    const CScript p2pkh = GetScriptForDestination(PKHash(key.GetPubKey()));
+    CScript interpreted = CScript() << OP_CODESEPARATOR;
+    interpreted.insert(interpreted.end(), p2pkh.begin(), p2pkh.end());
+    BOOST_CHECK(!interpreted.IsPayToPublicKeyHash());
+
+    CMutableTransaction tx;
+    tx.vin.resize(1);
+    tx.vout.resize(1);
+    tx.vout[0].nValue = 1;
+    const CAmount amount{0};
+    std::vector<unsigned char> sig;
+    BOOST_REQUIRE(key.Sign(SignatureHash(p2pkh, tx, 0, SIGHASH_ALL, amount, SigVersion::BASE), sig));
+    sig.push_back(SIGHASH_ALL);
+    std::vector<unsigned char> bad_sig{sig};
+    bad_sig[10] ^= 1;
+    const std::vector<unsigned char> no_hashtype(sig.begin(), sig.end() - 1);
+    CScript non_minimal = CScript() << sig << OP_PUSHDATA1;
+    non_minimal.push_back(pubkey.size());
+    non_minimal.insert(non_minimal.end(), pubkey.begin(), pubkey.end());
+
+    const std::vector<CScript> scriptSigs{
+        CScript() << sig << pubkey,
+        CScript() << bad_sig << pubkey,
+        CScript() << no_hashtype << pubkey,
+        CScript() << std::vector<unsigned char>{} << pubkey,
+        CScript() << sig << ToByteVector(other.GetPubKey()),
+        CScript() << sig,
+        CScript() << sig << pubkey << pubkey,
+        CScript() << OP_1 << pubkey,
+        non_minimal,
+    };
+    const unsigned int flag_sets[] = {
+        SCRIPT_VERIFY_NONE,
+        SCRIPT_VERIFY_STRICTENC | SCRIPT_VERIFY_NULLFAIL,
+        SCRIPT_VERIFY_P2SH | SCRIPT_VERIFY_CLEANSTACK,
+        SCRIPT_VERIFY_P2SH | SCRIPT_VERIFY_STRICTENC | SCRIPT_VERIFY_DERSIG | SCRIPT_VERIFY_LOW_S | SCRIPT_VERIFY_SIGPUSHONLY |
+            SCRIPT_VERIFY_MINIMALDATA | SCRIPT_VERIFY_NULLFAIL | SCRIPT_VERIFY_CLEANSTACK,
+    };
+    for (const unsigned int flags : flag_sets) {
+        const MutableTransactionSignatureChecker checker(&tx, 0, amount);
+        BOOST_CHECK(VerifyScript(scriptSigs[0], p2pkh, flags, checker));
+        for (size_t i = 0; i < scriptSigs.size(); i++) {
+            ScriptError err_template, err_interpreted;
+            const bool ret = VerifyScript(scriptSigs[i], p2pkh, flags, checker, &err_template);
+            BOOST_CHECK_MESSAGE(ret == VerifyScript(scriptSigs[i], interpreted, flags, checker, &err_interpreted), strprintf("scriptSig %u flags %x", i, flags));
+            BOOST_CHECK_EQUAL(ScriptErrorString(err_template), ScriptErrorString(err_interpreted));
+        }
+    }
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -133,6 +133,8 @@ BOOST_AUTO_TEST_CASE(sighash_test)
         uint256 sh, sho;
         sho = SignatureHashOld(scriptCode, CTransaction(txTo), nIn, nHashType);
         sh = SignatureHash(scriptCode, txTo, nIn, nHashType, 0, SigVersion::BASE);
+        const PrecomputedTransactionData txdata(txTo);
+        BOOST_CHECK(SignatureHash(scriptCode, txTo, nIn, nHashType, 0, SigVersion::BASE, &txdata) == sho);
         #if defined(PRINT_SIGHASH_JSON)
         CDataStream ss(SER_NETWORK, PROTOCOL_VERSION);
         ss << txTo;
@@ -200,6 +202,38 @@ BOOST_AUTO_TEST_CASE(sighash_from_data)
 
         sh = SignatureHash(scriptCode, *tx, nIn, nHashType, 0, SigVersion::BASE);
         BOOST_CHECK_MESSAGE(sh.GetHex() == sigHashHex, strTest);
+        const PrecomputedTransactionData txdata(*tx);
+        sh = SignatureHash(scriptCode, *tx, nIn, nHashType, 0, SigVersion::BASE, &txdata);
+        BOOST_CHECK_MESSAGE(sh.GetHex() == sigHashHex, strTest);
+    }
+}
+
+// A large mixing-like special transaction, hashed for every input from the precomputed parts
+BOOST_AUTO_TEST_CASE(sighash_precomputed_large_tx)
+{
+    CMutableTransaction tx;
+    RandomTransaction(tx, false);
+    tx.nVersion = 3;
+    tx.nType = TRANSACTION_PROVIDER_REGISTER;
+    tx.vExtraPayload = g_insecure_rand_ctx.randbytes(100);
+    tx.vin.resize(200);
+    tx.vout.resize(200);
+    for (auto& txin : tx.vin) {
+        txin.prevout = COutPoint(InsecureRand256(), InsecureRandBits(2));
+        txin.nSequence = InsecureRand32();
+    }
+    for (auto& txout : tx.vout) {
+        txout.nValue = InsecureRandRange(100000000);
+        RandomScript(txout.scriptPubKey);
+    }
+    const PrecomputedTransactionData txdata(tx);
+    CScript scriptCode;
+    RandomScript(scriptCode);
+    for (const int nHashType : {int{SIGHASH_ALL}, SIGHASH_ALL | SIGHASH_ANYONECANPAY, 0, int{SIGHASH_SINGLE}, SIGHASH_NONE | SIGHASH_ANYONECANPAY}) {
+        for (unsigned int nIn = 0; nIn < tx.vin.size(); nIn++) {
+            BOOST_CHECK(SignatureHash(scriptCode, tx, nIn, nHashType, 0, SigVersion::BASE, &txdata) ==
+                        SignatureHash(scriptCode, tx, nIn, nHashType, 0, SigVersion::BASE));
+        }
     }
 }
 BOOST_AUTO_TEST_SUITE_END()
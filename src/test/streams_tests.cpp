@@ -125,6 +125,32 @@ BOOST_AUTO_TEST_CASE(streams_vector_reader_rvalue)
     BOOST_CHECK(reader.empty());
 }
 
+BOOST_AUTO_TEST_CASE(streams_read_view)
+{
+    static_assert(has_read_view<SpanReader>::value);
+    static_assert(has_read_view<CDataStream>::value);
+    static_assert(!has_read_view<CAutoFile>::value);
+
+    std::vector<uint8_t> data{1, 2, 3, 4, 5};
+    SpanReader reader{SER_NETWORK, INIT_PROTO_VERSION, data, 0};
+    auto view = reader.ReadView(2);
+    // The view points into the data, nothing was copied
+    BOOST_CHECK(UCharCast(view.data()) == data.data());
+    BOOST_CHECK_EQUAL(view.size(), 2U);
+    BOOST_CHECK_EQUAL(reader.size(), 3U);
+    BOOST_CHECK_THROW(reader.ReadView(4), std::ios_base::failure);
+
+    CDataStream ds(data, SER_NETWORK, INIT_PROTO_VERSION);
+    uint8_t first;
+    ds >> first;
+    view = ds.ReadView(4);
+    BOOST_CHECK(UCharCast(view.data()) == UCharCast(ds.data()) - 4);
+    // Reading up to the end keeps the buffer and thereby the view alive
+    BOOST_CHECK(ds.empty());
+    BOOST_CHECK_EQUAL(std::to_integer<uint8_t>(view[3]), 5);
+    BOOST_CHECK_THROW(ds.ReadView(1), std::ios_base::failure);
+}
+
 BOOST_AUTO_TEST_CASE(bitstream_reader_writer)
 {
     CDataStream data(SER_NETWORK, INIT_PROTO_VERSION);
@@ -194,6 +220,25 @@ BOOST_AUTO_TEST_CASE(streams_serializedata_xor)
     }
 }
 
+BOOST_AUTO_TEST_CASE(streams_xor_wide)
+{
+    // The word and vector paths must match a byte by byte XOR for every length, key size and offset
+    for (size_t key_size : {1, 2, 3, 4, 8}) {
+        const std::vector<std::byte> key = g_insecure_rand_ctx.randbytes<std::byte>(key_size);
+        for (size_t len = 0; len < 80; ++len) {
+            for (size_t offset = 0; offset < key_size; ++offset) {
+                std::vector<std::byte> actual = g_insecure_rand_ctx.randbytes<std::byte>(len);
+                std::vector<std::byte> expected = actual;
+                for (size_t i = 0; i < expected.size(); ++i) {
+                    expected[i] ^= key[(offset + i) % key_size];
+                }
+                util::Xor(actual, key, offset);
+                BOOST_CHECK(actual == expected);
+            }
+        }
+    }
+}
+
 BOOST_AUTO_TEST_CASE(streams_buffered_file)
 {
     FILE* file = fsbridge::fopen("streams_test_tmp", "w+b");
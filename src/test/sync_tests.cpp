@@ -7,8 +7,11 @@
 
 #include <boost/test/unit_test.hpp>
 
+#include <chrono>
+#include <future>
 #include <mutex>
 #include <stdexcept>
+#include <thread>
 
 namespace {
 template <typename MutexType>
@@ -140,4 +143,44 @@ BOOST_AUTO_TEST_CASE(double_lock_recursive_mutex)
 }
 #endif /* DEBUG_LOCKORDER */
 
+BOOST_AUTO_TEST_CASE(lock_stats_contention)
+{
+    ResetLockStats();
+    g_lock_stats_enabled = true;
+
+    Mutex contended_mutex;
+    std::promise<void> locked;
+    std::thread holder([&] {
+        LOCK(contended_mutex);
+        locked.set_value();
+        std::this_thread::sleep_for(std::chrono::milliseconds{20});
+    });
+    locked.get_future().wait();
+    {
+        LOCK(contended_mutex);
+    }
+    holder.join();
+    g_lock_stats_enabled = false;
+
+    uint64_t contentions{0}, wait_us{0}, holds{0};
+    for (const LockSiteStats& site : GetLockStats()) {
+        if (site.lock_name != "contended_mutex") continue;
+        contentions += site.contentions;
+        wait_us += site.wait_us;
+        holds += site.holds;
+    }
+    BOOST_CHECK_EQUAL(contentions, 1U);
+    BOOST_CHECK(wait_us > 0);
+    BOOST_CHECK(holds >= 1);
+
+    // Disabled profiling records nothing and a reset clears what was recorded
+    {
+        LOCK(contended_mutex);
+    }
+    ResetLockStats();
+    for (const LockSiteStats& site : GetLockStats()) {
+        BOOST_CHECK(site.lock_name != "contended_mutex");
+    }
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,176 @@
+// Copyright (c) 2024 The Maximus developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <node/txreconciliation.h>
+
+#include <test/util/setup_common.h>
+
+#include <boost/test/unit_test.hpp>
+
+BOOST_FIXTURE_TEST_SUITE(txreconciliation_tests, BasicTestingSetup)
+
+BOOST_AUTO_TEST_CASE(RegisterPeerTest)
+{
+    TxReconciliationTracker tracker(TXRECONCILIATION_VERSION);
+    const uint64_t salt = 0;
+
+    // Prepare a peer for reconciliation.
+    tracker.PreRegisterPeer(0);
+
+    // Invalid version.
+    BOOST_CHECK_EQUAL(tracker.RegisterPeer(/*peer_id=*/0, /*is_peer_inbound=*/true,
+                                           /*peer_recon_version=*/0, salt),
+                      ReconciliationRegisterResult::PROTOCOL_VIOLATION);
+
+    // Valid registration (inbound and outbound peers).
+    BOOST_REQUIRE(!tracker.IsPeerRegistered(0));
+    BOOST_REQUIRE_EQUAL(tracker.RegisterPeer(0, true, 1, salt), ReconciliationRegisterResult::SUCCESS);
+    BOOST_CHECK(tracker.IsPeerRegistered(0));
+    BOOST_REQUIRE(!tracker.IsPeerRegistered(1));
+    tracker.PreRegisterPeer(1);
+    BOOST_REQUIRE(tracker.RegisterPeer(1, false, 1, salt) == ReconciliationRegisterResult::SUCCESS);
+    BOOST_CHECK(tracker.IsPeerRegistered(1));
+
+    // Reconciliation version is higher than ours, should be able to register.
+    BOOST_REQUIRE(!tracker.IsPeerRegistered(2));
+    tracker.PreRegisterPeer(2);
+    BOOST_REQUIRE(tracker.RegisterPeer(2, true, 2, salt) == ReconciliationRegisterResult::SUCCESS);
+    BOOST_CHECK(tracker.IsPeerRegistered(2));
+
+    // Try registering for the second time.
+    BOOST_REQUIRE(tracker.RegisterPeer(1, false, 1, salt) == ReconciliationRegisterResult::ALREADY_REGISTERED);
+
+    // Do not register if there were no pre-registration for the peer.
+    BOOST_REQUIRE_EQUAL(tracker.RegisterPeer(100, true, 1, salt), ReconciliationRegisterResult::NOT_FOUND);
+    BOOST_CHECK(!tracker.IsPeerRegistered(100));
+}
+
+BOOST_AUTO_TEST_CASE(ForgetPeerTest)
+{
+    TxReconciliationTracker tracker(TXRECONCILIATION_VERSION);
+    NodeId peer_id0 = 0;
+
+    // Removing peer after pre-registering works and does not let to register the peer.
+    tracker.PreRegisterPeer(peer_id0);
+    tracker.ForgetPeer(peer_id0);
+    BOOST_CHECK_EQUAL(tracker.RegisterPeer(peer_id0, true, 1, 1), ReconciliationRegisterResult::NOT_FOUND);
+
+    // Removing peer after it is registered works.
+    tracker.PreRegisterPeer(peer_id0);
+    BOOST_REQUIRE(!tracker.IsPeerRegistered(peer_id0));
+    BOOST_REQUIRE_EQUAL(tracker.RegisterPeer(peer_id0, true, 1, 1), ReconciliationRegisterResult::SUCCESS);
+    BOOST_CHECK(tracker.IsPeerRegistered(peer_id0));
+    tracker.ForgetPeer(peer_id0);
+    BOOST_CHECK(!tracker.IsPeerRegistered(peer_id0));
+}
+
+BOOST_AUTO_TEST_CASE(FloodToTest)
+{
+    TxReconciliationTracker tracker(TXRECONCILIATION_VERSION);
+
+    // Unregistered peers are always flooded to.
+    BOOST_CHECK(tracker.ShouldFloodTo(0));
+
+    // Only the first few outbound peers keep being flooded to, inbound peers never.
+    for (NodeId peer_id = 0; peer_id < NodeId(MAX_OUTBOUND_FLOOD_TO) + 1; ++peer_id) {
+        tracker.PreRegisterPeer(peer_id);
+        BOOST_REQUIRE_EQUAL(tracker.RegisterPeer(peer_id, false, 1, 1), ReconciliationRegisterResult::SUCCESS);
+        BOOST_CHECK_EQUAL(tracker.ShouldFloodTo(peer_id), peer_id < NodeId(MAX_OUTBOUND_FLOOD_TO));
+    }
+    const NodeId inbound_peer = 100;
+    tracker.PreRegisterPeer(inbound_peer);
+    BOOST_REQUIRE_EQUAL(tracker.RegisterPeer(inbound_peer, true, 1, 1), ReconciliationRegisterResult::SUCCESS);
+    BOOST_CHECK(!tracker.ShouldFloodTo(inbound_peer));
+
+    // Forgetting a flooding outbound peer frees up its slot.
+    tracker.ForgetPeer(0);
+    const NodeId new_outbound_peer = 101;
+    tracker.PreRegisterPeer(new_outbound_peer);
+    BOOST_REQUIRE_EQUAL(tracker.RegisterPeer(new_outbound_peer, false, 1, 1), ReconciliationRegisterResult::SUCCESS);
+    BOOST_CHECK(tracker.ShouldFloodTo(new_outbound_peer));
+}
+
+BOOST_AUTO_TEST_CASE(ReconciliationRoundTest)
+{
+    // Simulate both ends of one connection: node A made the outbound connection to node B.
+    TxReconciliationTracker tracker_a(TXRECONCILIATION_VERSION);
+    TxReconciliationTracker tracker_b(TXRECONCILIATION_VERSION);
+    const NodeId peer_b = 0, peer_a = 0;
+    const uint64_t salt_a = tracker_a.PreRegisterPeer(peer_b);
+    const uint64_t salt_b = tracker_b.PreRegisterPeer(peer_a);
+    BOOST_REQUIRE_EQUAL(tracker_a.RegisterPeer(peer_b, /*is_peer_inbound=*/false, 1, salt_b), ReconciliationRegisterResult::SUCCESS);
+    BOOST_REQUIRE_EQUAL(tracker_b.RegisterPeer(peer_a, /*is_peer_inbound=*/true, 1, salt_a), ReconciliationRegisterResult::SUCCESS);
+
+    const uint256 shared_tx = InsecureRand256(), only_a_tx = InsecureRand256(), only_b_tx = InsecureRand256();
+    BOOST_CHECK(tracker_a.AddToSet(peer_b, shared_tx));
+    BOOST_CHECK(tracker_a.AddToSet(peer_b, only_a_tx));
+    BOOST_CHECK(tracker_b.AddToSet(peer_a, shared_tx));
+    BOOST_CHECK(tracker_b.AddToSet(peer_a, only_b_tx));
+
+    // Only the initiator starts a round, and only once per interval.
+    const auto now = std::chrono::microseconds{1000};
+    BOOST_CHECK(!tracker_b.InitiateReconciliationRequest(peer_a, now));
+    const auto set_size = tracker_a.InitiateReconciliationRequest(peer_b, now);
+    BOOST_REQUIRE(set_size);
+    BOOST_CHECK_EQUAL(*set_size, 2);
+    BOOST_CHECK(!tracker_a.InitiateReconciliationRequest(peer_b, now));
+
+    // Only the responder answers with its short ids.
+    BOOST_CHECK(!tracker_a.RespondToReconciliationRequest(peer_b));
+    const auto sketch = tracker_b.RespondToReconciliationRequest(peer_a);
+    BOOST_REQUIRE(sketch);
+    BOOST_CHECK_EQUAL(sketch->size(), 2U);
+
+    std::vector<uint256> txs_to_announce;
+    std::vector<uint32_t> short_ids_to_request;
+    BOOST_REQUIRE(tracker_a.HandleSketch(peer_b, *sketch, txs_to_announce, short_ids_to_request));
+    BOOST_REQUIRE_EQUAL(txs_to_announce.size(), 1U);
+    BOOST_CHECK(txs_to_announce[0] == only_a_tx);
+    BOOST_REQUIRE_EQUAL(short_ids_to_request.size(), 1U);
+
+    // A second sketch for the same request is not accepted.
+    BOOST_CHECK(!tracker_a.HandleSketch(peer_b, *sketch, txs_to_announce, short_ids_to_request));
+
+    const auto requested = tracker_b.HandleReconciliationDifference(peer_a, short_ids_to_request);
+    BOOST_REQUIRE_EQUAL(requested.size(), 1U);
+    BOOST_CHECK(requested[0] == only_b_tx);
+
+    // The next round can start once the interval passed, with the sets emptied by the previous one.
+    BOOST_CHECK(!tracker_a.InitiateReconciliationRequest(peer_b, now + RECON_REQUEST_INTERVAL - std::chrono::microseconds{1}));
+    const auto next_set_size = tracker_a.InitiateReconciliationRequest(peer_b, now + RECON_REQUEST_INTERVAL);
+    BOOST_REQUIRE(next_set_size);
+    BOOST_CHECK_EQUAL(*next_set_size, 0);
+}
+
+BOOST_AUTO_TEST_CASE(UnansweredRequestTest)
+{
+    TxReconciliationTracker tracker(TXRECONCILIATION_VERSION);
+    const NodeId peer_id = 0;
+    tracker.PreRegisterPeer(peer_id);
+    BOOST_REQUIRE_EQUAL(tracker.RegisterPeer(peer_id, /*is_peer_inbound=*/false, 1, 1), ReconciliationRegisterResult::SUCCESS);
+    const uint256 tx = InsecureRand256();
+    BOOST_CHECK(tracker.AddToSet(peer_id, tx));
+
+    const auto now = std::chrono::microseconds{1000};
+    const auto set_size = tracker.InitiateReconciliationRequest(peer_id, now);
+    BOOST_REQUIRE(set_size);
+    BOOST_CHECK_EQUAL(*set_size, 1);
+
+    // The peer never answers. The request is waited for during one interval only, after that a
+    // new one is sent with the set kept from the failed round.
+    BOOST_CHECK(!tracker.InitiateReconciliationRequest(peer_id, now + RECON_REQUEST_INTERVAL - std::chrono::microseconds{1}));
+    const auto retry_set_size = tracker.InitiateReconciliationRequest(peer_id, now + RECON_REQUEST_INTERVAL);
+    BOOST_REQUIRE(retry_set_size);
+    BOOST_CHECK_EQUAL(*retry_set_size, 1);
+
+    // The peer answers the new request, the round finishes as usual.
+    std::vector<uint256> txs_to_announce;
+    std::vector<uint32_t> short_ids_to_request;
+    BOOST_REQUIRE(tracker.HandleSketch(peer_id, {}, txs_to_announce, short_ids_to_request));
+    BOOST_REQUIRE_EQUAL(txs_to_announce.size(), 1U);
+    BOOST_CHECK(txs_to_announce[0] == tx);
+    BOOST_CHECK(short_ids_to_request.empty());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
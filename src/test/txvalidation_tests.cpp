@@ -144,4 +144,98 @@ BOOST_FIXTURE_TEST_CASE(package_tests, TestChain100Setup)
     // Check that mempool size hasn't changed.
     BOOST_CHECK_EQUAL(m_node.mempool->size(), initialPoolSize);
 }
+
+BOOST_FIXTURE_TEST_CASE(package_submit_tests, TestChain100Setup)
+{
+    LOCK(cs_main);
+    unsigned int initialPoolSize = m_node.mempool->size();
+
+    // A parent paying no fee and a child paying for both
+    CKey parent_key;
+    parent_key.MakeNewKey(true);
+    CScript parent_locking_script = GetScriptForDestination(PKHash(parent_key.GetPubKey()));
+    const CAmount coinbase_value = m_coinbase_txns[0]->vout[0].nValue;
+    CTransactionRef tx_parent = MakeTransactionRef(CreateValidMempoolTransaction(m_coinbase_txns[0], 0, 0, coinbaseKey, parent_locking_script,
+                                                                                 coinbase_value, /* submit */ false));
+    CKey child_key;
+    child_key.MakeNewKey(true);
+    CScript child_locking_script = GetScriptForDestination(PKHash(child_key.GetPubKey()));
+    CTransactionRef tx_child = MakeTransactionRef(CreateValidMempoolTransaction(tx_parent, 0, 101, parent_key, child_locking_script,
+                                                                                coinbase_value - COIN, /* submit */ false));
+
+    // On its own the parent doesn't make it
+    const MempoolAcceptResult result_parent = AcceptToMemoryPool(m_node.chainman->ActiveChainstate(), *m_node.mempool, tx_parent, /* bypass_limits */ false);
+    BOOST_CHECK(result_parent.m_result_type == MempoolAcceptResult::ResultType::INVALID);
+    BOOST_CHECK_EQUAL(result_parent.m_state.GetRejectReason(), "min relay fee not met");
+
+    // Testing the package still judges every transaction on its own
+    const auto result_test = ProcessNewPackage(m_node.chainman->ActiveChainstate(), *m_node.mempool, {tx_parent, tx_child}, /* test_accept */ true);
+    BOOST_CHECK(result_test.m_state.IsInvalid());
+    BOOST_CHECK_EQUAL(m_node.mempool->size(), initialPoolSize);
+
+    // Submitted as a package, the fee of the child counts for the parent
+    const auto result_submit = ProcessNewPackage(m_node.chainman->ActiveChainstate(), *m_node.mempool, {tx_parent, tx_child}, /* test_accept */ false);
+    BOOST_CHECK_MESSAGE(result_submit.m_state.IsValid(),
+                        "Package submission unexpectedly failed: " << result_submit.m_state.GetRejectReason());
+    BOOST_CHECK_EQUAL(result_submit.m_tx_results.size(), 2U);
+    BOOST_CHECK_EQUAL(m_node.mempool->size(), initialPoolSize + 2);
+    BOOST_CHECK(m_node.mempool->exists(tx_parent->GetHash()));
+    BOOST_CHECK(m_node.mempool->exists(tx_child->GetHash()));
+
+    // The ancestor package of the child is announced parents first
+    const std::vector<uint256> package = m_node.mempool->GetAncestorPackage(tx_child->GetHash(), MAX_PACKAGE_COUNT);
+    BOOST_CHECK(package == std::vector<uint256>({tx_parent->GetHash(), tx_child->GetHash()}));
+    BOOST_CHECK(m_node.mempool->GetAncestorPackage(tx_child->GetHash(), 1).empty());
+
+    // A package paying no fee at all is not accepted
+    const CAmount child_value = tx_child->vout[0].nValue;
+    CTransactionRef tx_parent2 = MakeTransactionRef(CreateValidMempoolTransaction(tx_child, 0, 101, child_key, parent_locking_script,
+                                                                                  child_value, /* submit */ false));
+    CTransactionRef tx_child2 = MakeTransactionRef(CreateValidMempoolTransaction(tx_parent2, 0, 101, parent_key, child_locking_script,
+                                                                                 child_value, /* submit */ false));
+    const auto result_no_fee = ProcessNewPackage(m_node.chainman->ActiveChainstate(), *m_node.mempool, {tx_parent2, tx_child2}, /* test_accept */ false);
+    BOOST_CHECK(result_no_fee.m_state.IsInvalid());
+    BOOST_CHECK_EQUAL(result_no_fee.m_state.GetResult(), PackageValidationResult::PCKG_POLICY);
+    BOOST_CHECK_EQUAL(result_no_fee.m_state.GetRejectReason(), "package-fee-too-low");
+    BOOST_CHECK_EQUAL(m_node.mempool->size(), initialPoolSize + 2);
+}
+
+BOOST_FIXTURE_TEST_CASE(batch_accept_tests, TestChain100Setup)
+{
+    // Mature the coinbases of the second and third blocks too
+    const CScript coinbase_script = CScript() << ToByteVector(coinbaseKey.GetPubKey()) << OP_CHECKSIG;
+    for (int i = 0; i < 2; ++i) {
+        CreateAndProcessBlock({}, coinbase_script);
+    }
+
+    LOCK(cs_main);
+    unsigned int initialPoolSize = m_node.mempool->size();
+
+    CKey key;
+    key.MakeNewKey(true);
+    const CScript locking_script = GetScriptForDestination(PKHash(key.GetPubKey()));
+    CTransactionRef tx_a = MakeTransactionRef(CreateValidMempoolTransaction(m_coinbase_txns[0], 0, 1, coinbaseKey, locking_script, CAmount(49 * COIN), /* submit */ false));
+    CTransactionRef tx_b = MakeTransactionRef(CreateValidMempoolTransaction(m_coinbase_txns[1], 0, 2, coinbaseKey, locking_script, CAmount(49 * COIN), /* submit */ false));
+    // Spends an output of the batch and double spends another one of it
+    CTransactionRef tx_child = MakeTransactionRef(CreateValidMempoolTransaction(tx_a, 0, 103, key, locking_script, CAmount(48 * COIN), /* submit */ false));
+    CTransactionRef tx_conflict = MakeTransactionRef(CreateValidMempoolTransaction(m_coinbase_txns[1], 0, 2, coinbaseKey, locking_script, CAmount(48 * COIN), /* submit */ false));
+
+    const std::vector<MempoolAcceptResult> results = AcceptToMemoryPoolBatch(m_node.chainman->ActiveChainstate(), *m_node.mempool,
+                                                                             {tx_a, tx_child, tx_b, tx_conflict, create_placeholder_tx(1, 1)}, /* bypass_limits */ false);
+    BOOST_CHECK_EQUAL(results.size(), 5U);
+    for (size_t i = 0; i < 3; ++i) {
+        BOOST_CHECK_MESSAGE(results[i].m_result_type == MempoolAcceptResult::ResultType::VALID,
+                            "Batch acceptance unexpectedly failed: " << results[i].m_state.GetRejectReason());
+    }
+    // The dependent child and the double spend are judged after the rest, in order
+    BOOST_CHECK(results[3].m_result_type == MempoolAcceptResult::ResultType::INVALID);
+    BOOST_CHECK_EQUAL(results[3].m_state.GetRejectReason(), "txn-mempool-conflict");
+    BOOST_CHECK(results[4].m_result_type == MempoolAcceptResult::ResultType::INVALID);
+    BOOST_CHECK_EQUAL(results[4].m_state.GetRejectReason(), "bad-txns-inputs-missingorspent");
+
+    BOOST_CHECK_EQUAL(m_node.mempool->size(), initialPoolSize + 3);
+    BOOST_CHECK(m_node.mempool->exists(tx_a->GetHash()));
+    BOOST_CHECK(m_node.mempool->exists(tx_b->GetHash()));
+    BOOST_CHECK(m_node.mempool->exists(tx_child->GetHash()));
+}
 BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,119 @@
+// Copyright (c) 2024 The Maximus developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <saltedhasher.h>
+#include <uint256.h>
+#include <unordered_lru_cache.h>
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include <boost/test/unit_test.hpp>
+
+BOOST_AUTO_TEST_SUITE(unordered_lru_cache_tests)
+
+static uint256 MakeKey(int i)
+{
+    uint256 key;
+    *key.begin() = i & 0xff;
+    *(key.begin() + 1) = (i >> 8) & 0xff;
+    return key;
+}
+
+BOOST_AUTO_TEST_CASE(lru_eviction)
+{
+    unordered_lru_cache<uint256, int, StaticSaltedHasher> cache(10);
+    for (int i = 0; i < 20; ++i) {
+        cache.insert(MakeKey(i), i);
+    }
+    // touch the first entry, so it survives the truncation below
+    BOOST_CHECK(cache.exists(MakeKey(0)));
+    cache.insert(MakeKey(20), 20);
+    int value{-1};
+    BOOST_CHECK(cache.get(MakeKey(0), value) && value == 0);
+    BOOST_CHECK(!cache.exists(MakeKey(1)));
+    BOOST_CHECK(cache.get(MakeKey(20), value) && value == 20);
+
+    cache.erase(MakeKey(20));
+    BOOST_CHECK(!cache.exists(MakeKey(20)));
+}
+
+BOOST_AUTO_TEST_CASE(lru_memory_usage)
+{
+    unordered_lru_cache<uint256, int, StaticSaltedHasher> cache(10);
+    const size_t empty_usage{cache.DynamicMemoryUsage()};
+    for (int i = 0; i < 5; ++i) {
+        cache.insert(MakeKey(i), i);
+    }
+    BOOST_CHECK_EQUAL(cache.size(), 5U);
+    BOOST_CHECK_GT(cache.DynamicMemoryUsage(), empty_usage);
+
+    int sum{0};
+    cache.for_each([&sum](const uint256&, int value) { sum += value; });
+    BOOST_CHECK_EQUAL(sum, 0 + 1 + 2 + 3 + 4);
+}
+
+BOOST_AUTO_TEST_CASE(sharded_concurrent_access)
+{
+    sharded_unordered_lru_cache<uint256, int, StaticSaltedHasher, 4096, 8> cache;
+    for (int i = 0; i < 1000; ++i) {
+        cache.insert(MakeKey(i), i);
+    }
+
+    std::atomic<int> misses{0};
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t) {
+        threads.emplace_back([&, t] {
+            for (int n = 0; n < 5000; ++n) {
+                const int i = (n * 7 + t) % 1000;
+                int value{-1};
+                if (!cache.get(MakeKey(i), value) || value != i) ++misses;
+                // writers on other keys must not disturb the readers
+                cache.insert(MakeKey(1000 + t), n);
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    BOOST_CHECK_EQUAL(misses, 0);
+
+    cache.erase(MakeKey(5));
+    BOOST_CHECK(!cache.exists(MakeKey(5)));
+    cache.clear();
+    BOOST_CHECK(!cache.exists(MakeKey(6)));
+}
+
+BOOST_AUTO_TEST_CASE(sharded_clock_eviction)
+{
+    sharded_unordered_lru_cache<uint256, int, StaticSaltedHasher, 4, 1> cache("test_clock");
+    for (int i = 0; i < 4; ++i) {
+        cache.insert(MakeKey(i), i);
+    }
+
+    // the hand skips the referenced entry and evicts the next one
+    int value{-1};
+    BOOST_CHECK(cache.get(MakeKey(0), value) && value == 0);
+    cache.insert(MakeKey(4), 4);
+    BOOST_CHECK(cache.exists(MakeKey(0)));
+    BOOST_CHECK(!cache.exists(MakeKey(1)));
+    BOOST_CHECK(cache.exists(MakeKey(4)));
+
+    // erasing keeps the remaining entries reachable
+    cache.erase(MakeKey(2));
+    BOOST_CHECK(cache.exists(MakeKey(3)));
+    BOOST_CHECK(!cache.exists(MakeKey(2)));
+
+    std::shared_ptr<const LRUCacheStats> stats;
+    for (const auto& [name, s] : GetLRUCacheStats()) {
+        if (name == "test_clock") stats = s;
+    }
+    BOOST_REQUIRE(stats);
+    BOOST_CHECK_EQUAL(stats->hits, 4);
+    BOOST_CHECK_EQUAL(stats->misses, 2);
+    BOOST_CHECK_EQUAL(stats->evictions, 1);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
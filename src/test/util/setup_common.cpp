@@ -11,7 +11,10 @@
 #include <consensus/params.h>
 #include <consensus/validation.h>
 #include <deploymentstatus.h>
+#include <crypto/aes.h>
+#include <crypto/chacha20.h>
 #include <crypto/sha256.h>
+#include <crypto/x11.h>
 #include <flat-database.h>
 #include <governance/governance.h>
 #include <index/txindex.h>
@@ -57,6 +60,7 @@
 #include <walletinitinterface.h>
 
 #include <bls/bls.h>
+#include <bls/bls_sigcache.h>
 #ifdef ENABLE_WALLET
 #include <coinjoin/client.h>
 #endif // ENABLE_WALLET
@@ -159,12 +163,16 @@ BasicTestingSetup::BasicTestingSetup(const std::string& chainName, const std::ve
     AppInitParameterInteraction(*m_node.args);
     LogInstance().StartLogging();
     SHA256AutoDetect();
+    X11AutoDetect();
+    ChaCha20AutoDetect();
+    AES256AutoDetect();
     ECC_Start();
     BLSInit();
     SetupEnvironment();
     SetupNetworking();
     InitSignatureCache();
     InitScriptExecutionCache();
+    InitBLSSignatureCache();
     m_node.addrman = std::make_unique<CAddrMan>();
     m_node.chain = interfaces::MakeChain(m_node);
     // while g_wallet_init_interface is init here at very early stage
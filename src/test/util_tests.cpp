@@ -20,6 +20,7 @@
 #include <util/spanparsing.h>
 #include <util/strencodings.h>
 #include <util/string.h>
+#include <util/threadbudget.h>
 #include <util/time.h>
 #include <util/vector.h>
 
@@ -2635,4 +2636,21 @@ BOOST_AUTO_TEST_CASE(message_hash)
     BOOST_CHECK_NE(message_hash1, signature_hash);
 }
 
+BOOST_AUTO_TEST_CASE(thread_budget)
+{
+    SetThreadBudget(8);
+    BOOST_CHECK_EQUAL(GetThreadBudget(TaskPriority::CONSENSUS, 16), 8);
+    BOOST_CHECK_EQUAL(GetThreadBudget(TaskPriority::LLMQ, 16), 4);
+    BOOST_CHECK_EQUAL(GetThreadBudget(TaskPriority::BACKGROUND, 16), 2);
+    BOOST_CHECK_EQUAL(GetThreadBudget(TaskPriority::CONSENSUS, 3), 3);
+
+    // every pool gets a thread
+    SetThreadBudget(2);
+    BOOST_CHECK_EQUAL(GetThreadBudget(TaskPriority::LLMQ, 4), 1);
+    BOOST_CHECK_EQUAL(GetThreadBudget(TaskPriority::BACKGROUND, 4), 1);
+
+    SetThreadBudget(0);
+    BOOST_CHECK_EQUAL(GetThreadBudget(TaskPriority::CONSENSUS, 1024), GetNumCores());
+}
+
 BOOST_AUTO_TEST_SUITE_END()
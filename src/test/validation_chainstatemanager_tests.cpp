@@ -282,6 +282,11 @@ BOOST_FIXTURE_TEST_CASE(chainstatemanager_activate_snapshot, TestChain100Setup)
             // Wrong hash
             metadata.m_base_blockhash = uint256::ONE;
     }));
+    BOOST_REQUIRE(!CreateAndActivateUTXOSnapshot(
+        m_node, m_path_root, [](CAutoFile& auto_infile, SnapshotMetadata& metadata) {
+            // Evodb entries count is larger than entries in file
+            metadata.m_evodb_count += 1;
+    }));
 
     BOOST_REQUIRE(CreateAndActivateUTXOSnapshot(m_node, m_path_root));
 
@@ -294,6 +299,9 @@ BOOST_FIXTURE_TEST_CASE(chainstatemanager_activate_snapshot, TestChain100Setup)
     // To be checked against later when we try loading a subsequent snapshot.
     uint256 loaded_snapshot_blockhash{*chainman.SnapshotBlockhash()};
 
+    // The evo database state was imported at the snapshot base.
+    BOOST_CHECK(m_node.evodb->VerifyBestBlock(loaded_snapshot_blockhash));
+
     // Make some assertions about the both chainstates. These checks ensure the
     // legacy chainstate hasn't changed and that the newly created chainstate
     // reflects the expected content.
@@ -2,6 +2,8 @@
 // Distributed under the MIT software license, see the accompanying
 // file COPYING or http://www.opensource.org/licenses/mit-license.php.
 
+#include <chainparams.h>
+#include <consensus/validation.h>
 #include <net.h>
 #include <uint256.h>
 #include <validation.h>
@@ -35,4 +37,29 @@ BOOST_AUTO_TEST_CASE(test_assumeutxo)
     BOOST_CHECK_EQUAL(out210.nChainTx, (unsigned int)210);
 }
 
+//! Test that CheckBlock() builds on the context-free checks of PreCheckBlock().
+BOOST_AUTO_TEST_CASE(test_precheckblock)
+{
+    const auto params = CreateChainParams(*m_node.args, CBaseChainParams::REGTEST);
+    const Consensus::Params& consensus = params->GetConsensus();
+
+    CBlock block = params->GenesisBlock();
+    BlockValidationState state;
+    BOOST_CHECK(PreCheckBlock(block, state, consensus));
+    BOOST_CHECK(block.fPreChecked);
+    BOOST_CHECK(!block.fChecked);
+    BOOST_CHECK(CheckBlock(block, state, consensus, 1));
+    BOOST_CHECK(block.fChecked);
+
+    // A block which doesn't match its merkle root is left unmarked and CheckBlock() still rejects it
+    CBlock mutated = params->GenesisBlock();
+    mutated.vtx.push_back(mutated.vtx.back());
+    BOOST_CHECK(!PreCheckBlock(mutated, state, consensus));
+    BOOST_CHECK_EQUAL(state.GetRejectReason(), "bad-txnmrklroot");
+    BOOST_CHECK(!mutated.fPreChecked);
+    BlockValidationState state2;
+    BOOST_CHECK(!CheckBlock(mutated, state2, consensus, 1));
+    BOOST_CHECK(!mutated.fChecked);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -5,11 +5,17 @@
 #include <boost/test/unit_test.hpp>
 #include <consensus/validation.h>
 #include <primitives/block.h>
+#include <primitives/transaction.h>
 #include <scheduler.h>
 #include <test/util/setup_common.h>
 #include <util/check.h>
 #include <validationinterface.h>
 
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
 BOOST_FIXTURE_TEST_SUITE(validationinterface_tests, ChainTestingSetup)
 
 struct TestSubscriberNoop final : public CValidationInterface {
@@ -91,4 +97,57 @@ BOOST_AUTO_TEST_CASE(unregister_all_during_call)
     BOOST_CHECK(destroyed);
 }
 
+class TestTxSubscriber : public CValidationInterface
+{
+public:
+    explicit TestTxSubscriber(std::function<void(const CTransactionRef&)> on_tx) : m_on_tx(std::move(on_tx)) {}
+    void TransactionAddedToMempool(const CTransactionRef& tx, int64_t) override { m_on_tx(tx); }
+    std::function<void(const CTransactionRef&)> m_on_tx;
+};
+
+BOOST_AUTO_TEST_CASE(own_queue_subscriber)
+{
+    // A second thread, to show that the queues still don't run at the same time
+    m_node.scheduler->m_extra_service_threads.emplace_back([&] { m_node.scheduler->serviceQueue(); });
+
+    std::atomic<int> running{0};
+    std::atomic<int> max_running{0};
+    auto on_tx = [&](std::vector<uint256>& txids, const CTransactionRef& tx) {
+        const int n = ++running;
+        int prev = max_running.load();
+        while (prev < n && !max_running.compare_exchange_weak(prev, n)) {}
+        std::this_thread::sleep_for(std::chrono::milliseconds{1});
+        txids.push_back(tx->GetHash());
+        --running;
+    };
+    std::vector<uint256> shared_txids;
+    TestTxSubscriber shared([&](const CTransactionRef& tx) { on_tx(shared_txids, tx); });
+    std::vector<uint256> own_txids;
+    TestTxSubscriber own([&](const CTransactionRef& tx) { on_tx(own_txids, tx); });
+
+    RegisterValidationInterface(&shared);
+    RegisterValidationInterface(&own, /*own_queue=*/true);
+
+    std::vector<CTransactionRef> txs;
+    for (int i = 0; i < 5; i++) {
+        CMutableTransaction mtx;
+        mtx.nLockTime = i;
+        txs.push_back(MakeTransactionRef(mtx));
+        GetMainSignals().TransactionAddedToMempool(txs.back(), 0);
+    }
+
+    // Waits for both queues, each of them delivered in order and one callback at a time
+    SyncWithValidationInterfaceQueue();
+    BOOST_CHECK_EQUAL(max_running.load(), 1);
+    BOOST_REQUIRE_EQUAL(shared_txids.size(), txs.size());
+    BOOST_REQUIRE_EQUAL(own_txids.size(), txs.size());
+    for (size_t i = 0; i < txs.size(); i++) {
+        BOOST_CHECK(shared_txids[i] == txs[i]->GetHash());
+        BOOST_CHECK(own_txids[i] == txs[i]->GetHash());
+    }
+
+    UnregisterValidationInterface(&own);
+    UnregisterValidationInterface(&shared);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -17,6 +17,7 @@
 #include <util/moneystr.h>
 #include <util/system.h>
 #include <util/time.h>
+#include <util/trace.h>
 #include <validation.h>
 #include <validationinterface.h>
 
@@ -26,8 +27,11 @@
 #include <evo/deterministicmns.h>
 #include <llmq/instantsend.h>
 
+#include <algorithm>
 #include <cmath>
+#include <limits>
 #include <optional>
+#include <tuple>
 
 CTxMemPoolEntry::CTxMemPoolEntry(const CTransactionRef& _tx, const CAmount& _nFee,
                                  int64_t _nTime, unsigned int _entryHeight,
@@ -69,39 +73,46 @@ size_t CTxMemPoolEntry::GetTxSize() const
 // descendants.
 void CTxMemPool::UpdateForDescendants(txiter updateIt, cacheMap &cachedDescendants, const std::set<uint256> &setExclude)
 {
-    setEntries stageEntries, setAllDescendants;
-    stageEntries = GetMemPoolChildren(updateIt);
+    WITH_FRESH_EPOCH(m_epoch);
+    // Entries are marked visited when they are first reached, so each in-mempool
+    // descendant is staged or added to vecAllDescendants once.
+    vecEntries stageEntries, vecAllDescendants;
+    for (txiter childEntry : GetMemPoolChildren(updateIt)) {
+        if (!visited(childEntry)) stageEntries.push_back(childEntry);
+    }
 
     while (!stageEntries.empty()) {
-        const txiter cit = *stageEntries.begin();
-        setAllDescendants.insert(cit);
-        stageEntries.erase(cit);
+        const txiter cit = stageEntries.back();
+        stageEntries.pop_back();
+        vecAllDescendants.push_back(cit);
         const setEntries &setChildren = GetMemPoolChildren(cit);
         for (txiter childEntry : setChildren) {
+            if (visited(childEntry)) continue;
             cacheMap::iterator cacheIt = cachedDescendants.find(childEntry);
             if (cacheIt != cachedDescendants.end()) {
                 // We've already calculated this one, just add the entries for this set
                 // but don't traverse again.
                 for (txiter cacheEntry : cacheIt->second) {
-                    setAllDescendants.insert(cacheEntry);
+                    if (!visited(cacheEntry)) vecAllDescendants.push_back(cacheEntry);
                 }
-            } else if (!setAllDescendants.count(childEntry)) {
+            } else {
                 // Schedule for later processing
-                stageEntries.insert(childEntry);
+                stageEntries.push_back(childEntry);
             }
         }
     }
-    // setAllDescendants now contains all in-mempool descendants of updateIt.
+    // vecAllDescendants now contains all in-mempool descendants of updateIt.
     // Update and add to cached descendant map
     int64_t modifySize = 0;
     CAmount modifyFee = 0;
     int64_t modifyCount = 0;
-    for (txiter cit : setAllDescendants) {
+    vecEntries& cached = cachedDescendants[updateIt];
+    for (txiter cit : vecAllDescendants) {
         if (!setExclude.count(cit->GetTx().GetHash())) {
             modifySize += cit->GetTxSize();
             modifyFee += cit->GetModifiedFee();
             modifyCount++;
-            cachedDescendants[updateIt].insert(cit);
+            cached.push_back(cit);
             // Update ancestor state for each descendant
             mapTx.modify(cit, update_ancestor_state(updateIt->GetTxSize(), updateIt->GetModifiedFee(), 1, updateIt->GetSigOpCount()));
         }
@@ -161,37 +172,51 @@ void CTxMemPool::UpdateTransactionsFromBlock(const std::vector<uint256> &vHashes
 
 bool CTxMemPool::CalculateMemPoolAncestors(const CTxMemPoolEntry &entry, setEntries &setAncestors, uint64_t limitAncestorCount, uint64_t limitAncestorSize, uint64_t limitDescendantCount, uint64_t limitDescendantSize, std::string &errString, bool fSearchForParents /* = true */) const
 {
-    setEntries parentHashes;
     const CTransaction &tx = entry.GetTx();
 
+    WITH_FRESH_EPOCH(m_epoch);
+    // Ancestors are marked visited when they are staged, so each one is staged
+    // (and counted) once however many paths lead to it.
+    vecEntries staged;
+
     if (fSearchForParents) {
         // Get parents of this transaction that are in the mempool
         // GetMemPoolParents() is only valid for entries in the mempool, so we
         // iterate mapTx to find parents.
         for (unsigned int i = 0; i < tx.vin.size(); i++) {
             std::optional<txiter> piter = GetIter(tx.vin[i].prevout.hash);
-            if (piter) {
-                parentHashes.insert(*piter);
-                if (parentHashes.size() + 1 > limitAncestorCount) {
+            if (piter && !visited(*piter)) {
+                staged.push_back(*piter);
+                if (staged.size() + 1 > limitAncestorCount) {
                     errString = strprintf("too many unconfirmed parents [limit: %u]", limitAncestorCount);
                     return false;
                 }
+                // The ancestors of a parent are ancestors of this tx too, so a parent
+                // whose own package is over the limits fails without any walk.
+                if ((*piter)->GetCountWithAncestors() + 1 > limitAncestorCount) {
+                    errString = strprintf("too many unconfirmed ancestors [limit: %u]", limitAncestorCount);
+                    return false;
+                } else if ((*piter)->GetSizeWithAncestors() + entry.GetTxSize() > limitAncestorSize) {
+                    errString = strprintf("exceeds ancestor size limit [limit: %u]", limitAncestorSize);
+                    return false;
+                }
             }
         }
     } else {
         // If we're not searching for parents, we require this to be an
         // entry in the mempool already.
         txiter it = mapTx.iterator_to(entry);
-        parentHashes = GetMemPoolParents(it);
+        for (txiter piter : GetMemPoolParents(it)) {
+            visited(piter);
+            staged.push_back(piter);
+        }
     }
 
     size_t totalSizeWithAncestors = entry.GetTxSize();
 
-    while (!parentHashes.empty()) {
-        txiter stageit = *parentHashes.begin();
+    for (size_t i = 0; i < staged.size(); ++i) {
+        txiter stageit = staged[i];
 
-        setAncestors.insert(stageit);
-        parentHashes.erase(stageit);
         totalSizeWithAncestors += stageit->GetTxSize();
 
         if (stageit->GetSizeWithDescendants() + entry.GetTxSize() > limitDescendantSize) {
@@ -208,16 +233,16 @@ bool CTxMemPool::CalculateMemPoolAncestors(const CTxMemPoolEntry &entry, setEntr
         const setEntries & setMemPoolParents = GetMemPoolParents(stageit);
         for (txiter phash : setMemPoolParents) {
             // If this is a new ancestor, add it.
-            if (setAncestors.count(phash) == 0) {
-                parentHashes.insert(phash);
-            }
-            if (parentHashes.size() + setAncestors.size() + 1 > limitAncestorCount) {
+            if (visited(phash)) continue;
+            staged.push_back(phash);
+            if (staged.size() + 1 > limitAncestorCount) {
                 errString = strprintf("too many unconfirmed ancestors [limit: %u]", limitAncestorCount);
                 return false;
             }
         }
     }
 
+    setAncestors.insert(staged.begin(), staged.end());
     return true;
 }
 
@@ -282,6 +307,7 @@ void CTxMemPool::UpdateForRemoveFromMempool(const setEntries &entriesToRemove, b
             }
         }
     }
+    std::map<txiter, std::tuple<int64_t, CAmount, int64_t>, CompareIteratorByHash> ancestorUpdates;
     for (txiter removeIt : entriesToRemove) {
         setEntries setAncestors;
         const CTxMemPoolEntry &entry = *removeIt;
@@ -304,9 +330,24 @@ void CTxMemPool::UpdateForRemoveFromMempool(const setEntries &entriesToRemove, b
         // and it's important that we use the mapLinks[] notion of ancestor
         // transactions as the set of things to update for removal.
         CalculateMemPoolAncestors(entry, setAncestors, nNoLimit, nNoLimit, nNoLimit, nNoLimit, dummy, false);
-        // Note that UpdateAncestorsOf severs the child links that point to
-        // removeIt in the entries for the parents of removeIt.
-        UpdateAncestorsOf(false, removeIt, setAncestors);
+        // Sever the child links that point to removeIt in the entries for the
+        // parents of removeIt.
+        for (txiter piter : GetMemPoolParents(removeIt)) {
+            UpdateChild(piter, removeIt, false);
+        }
+        // Ancestors shared by several of the removed transactions get their
+        // descendant state updated once, and those removed as well not at all.
+        for (txiter ancestorIt : setAncestors) {
+            if (entriesToRemove.count(ancestorIt)) continue;
+            auto& [modifySize, modifyFee, modifyCount] = ancestorUpdates[ancestorIt];
+            modifySize -= removeIt->GetTxSize();
+            modifyFee -= removeIt->GetModifiedFee();
+            --modifyCount;
+        }
+    }
+    for (const auto& [ancestorIt, update] : ancestorUpdates) {
+        const auto& [modifySize, modifyFee, modifyCount] = update;
+        mapTx.modify(ancestorIt, update_descendant_state(modifySize, modifyFee, modifyCount));
     }
     // After updating all the ancestor sizes, we can now sever the link between each
     // transaction being removed and any mempool children (ie, update setMemPoolParents
@@ -366,6 +407,12 @@ void CTxMemPool::addUnchecked(const CTxMemPoolEntry &entry, setEntries &setAnces
     indexed_transaction_set::iterator newit = mapTx.insert(entry).first;
     mapLinks.insert(make_pair(newit, TxLinks()));
 
+    TRACE3(mempool, added,
+        entry.GetTx().GetHash().data(),
+        entry.GetTxSize(),
+        entry.GetFee()
+    );
+
     // Update transaction for any feeDelta created by PrioritiseTransaction
     CAmount delta{0};
     ApplyDelta(entry.GetTx().GetHash(), delta);
@@ -446,9 +493,13 @@ void CTxMemPool::addUnchecked(const CTxMemPoolEntry &entry, setEntries &setAnces
         if (dmn->pdmnState->pubKeyOperator.Get() != CBLSPublicKey()) {
             newit->isKeyChangeProTx = true;
         }
+    } else if (tx.nType == TRANSACTION_ASSET_LOCK) {
+        ++nAssetLockUnlockTxs;
     } else if (tx.nType == TRANSACTION_ASSET_UNLOCK) {
         auto assetUnlockTx = *Assert(GetTxPayload<CAssetUnlockPayload>(tx));
         mapAssetUnlockExpiry.insert({tx.GetHash(), assetUnlockTx.getHeightToExpiry()});
+        mapAssetUnlockIndexes.emplace(assetUnlockTx.getIndex(), tx.GetHash());
+        ++nAssetLockUnlockTxs;
     } else if (tx.nType == TRANSACTION_MNHF_SIGNAL) {
         PrioritiseTransaction(tx.GetHash(), 0.1 * COIN);
     }
@@ -458,9 +509,19 @@ void CTxMemPool::addAddressIndex(const CTxMemPoolEntry &entry, const CCoinsViewC
 {
     LOCK(cs);
     const CTransaction& tx = entry.GetTx();
-    std::vector<CMempoolAddressDeltaKey> inserted;
-
     uint256 txhash = tx.GetHash();
+    if (mapAddressInserted.count(txhash)) return;
+
+    std::vector<std::pair<addressKey, size_t> > inserted;
+    const auto insert = [&](const CMempoolAddressDeltaKey& key, const CMempoolAddressDelta& delta) {
+        addressKey address{key.m_address_type, key.m_address_bytes};
+        addressDeltaBucket& bucket = mapAddress[address];
+        m_index_usage -= memusage::DynamicUsage(bucket);
+        bucket.emplace_back(key, delta);
+        m_index_usage += memusage::DynamicUsage(bucket);
+        inserted.emplace_back(address, bucket.size() - 1);
+    };
+
     for (unsigned int j = 0; j < tx.vin.size(); j++) {
         const CTxIn input = tx.vin[j];
         const Coin& coin = view.AccessCoin(input.prevout);
@@ -475,8 +536,7 @@ void CTxMemPool::addAddressIndex(const CTxMemPoolEntry &entry, const CCoinsViewC
 
         CMempoolAddressDeltaKey key(address_type, address_bytes, txhash, j, /* tx_spent */ true);
         CMempoolAddressDelta delta(entry.GetTime(), prevout.nValue * -1, input.prevout.hash, input.prevout.n);
-        mapAddress.insert(std::make_pair(key, delta));
-        inserted.push_back(key);
+        insert(key, delta);
     }
 
     for (unsigned int k = 0; k < tx.vout.size(); k++) {
@@ -490,23 +550,24 @@ void CTxMemPool::addAddressIndex(const CTxMemPoolEntry &entry, const CCoinsViewC
         }
 
         CMempoolAddressDeltaKey key(address_type, address_bytes, txhash, k, /* tx_spent */ false);
-        mapAddress.insert(std::make_pair(key, CMempoolAddressDelta(entry.GetTime(), out.nValue)));
-        inserted.push_back(key);
+        insert(key, CMempoolAddressDelta(entry.GetTime(), out.nValue));
     }
 
-    mapAddressInserted.insert(std::make_pair(txhash, inserted));
+    m_index_usage += memusage::DynamicUsage(inserted);
+    mapAddressInserted.emplace(txhash, std::move(inserted));
 }
 
-bool CTxMemPool::getAddressIndex(std::vector<std::pair<uint160, AddressType> > &addresses,
+bool CTxMemPool::getAddressIndex(const std::vector<std::pair<uint160, AddressType> >& addresses,
                                  std::vector<std::pair<CMempoolAddressDeltaKey, CMempoolAddressDelta> > &results)
 {
     LOCK(cs);
     for (const auto& address : addresses) {
-        addressDeltaMap::iterator ait = mapAddress.lower_bound(CMempoolAddressDeltaKey(address.second, address.first));
-        while (ait != mapAddress.end() && (*ait).first.m_address_bytes == address.first && (*ait).first.m_address_type == address.second) {
-            results.push_back(*ait);
-            ait++;
+        const auto ait = mapAddress.find(addressKey{address.second, address.first});
+        if (ait == mapAddress.end()) continue;
+        if (addresses.size() == 1) {
+            results.reserve(results.size() + ait->second.size());
         }
+        results.insert(results.end(), ait->second.begin(), ait->second.end());
     }
     return true;
 }
@@ -515,14 +576,36 @@ bool CTxMemPool::removeAddressIndex(const uint256 txhash)
 {
     LOCK(cs);
     addressDeltaMapInserted::iterator it = mapAddressInserted.find(txhash);
-
-    if (it != mapAddressInserted.end()) {
-        std::vector<CMempoolAddressDeltaKey> keys = (*it).second;
-        for (std::vector<CMempoolAddressDeltaKey>::iterator mit = keys.begin(); mit != keys.end(); mit++) {
-            mapAddress.erase(*mit);
+    if (it == mapAddressInserted.end()) return true;
+
+    // Position of a delta that has been removed already
+    static constexpr size_t REMOVED{std::numeric_limits<size_t>::max()};
+    for (size_t i = 0; i < it->second.size(); ++i) {
+        const auto [address, pos] = it->second[i];
+        it->second[i].second = REMOVED;
+        const auto bucket_it = mapAddress.find(address);
+        assert(bucket_it != mapAddress.end() && pos < bucket_it->second.size());
+        addressDeltaBucket& bucket = bucket_it->second;
+
+        m_index_usage -= memusage::DynamicUsage(bucket);
+        if (pos + 1 != bucket.size()) {
+            // Unless we're removing the last delta, move the last delta to the position we're
+            // removing and point the record of its transaction (which may be this one) there.
+            bucket[pos] = std::move(bucket.back());
+            auto& moved = mapAddressInserted.at(bucket[pos].first.m_tx_hash);
+            const auto moved_it = std::find(moved.begin(), moved.end(), std::make_pair(address, bucket.size() - 1));
+            assert(moved_it != moved.end());
+            moved_it->second = pos;
+        }
+        bucket.pop_back();
+        if (bucket.empty()) {
+            mapAddress.erase(bucket_it);
+        } else {
+            m_index_usage += memusage::DynamicUsage(bucket);
         }
-        mapAddressInserted.erase(it);
     }
+    m_index_usage -= memusage::DynamicUsage(it->second);
+    mapAddressInserted.erase(it);
 
     return true;
 }
@@ -532,7 +615,7 @@ void CTxMemPool::addSpentIndex(const CTxMemPoolEntry &entry, const CCoinsViewCac
     LOCK(cs);
 
     const CTransaction& tx = entry.GetTx();
-    std::vector<CSpentIndexKey> inserted;
+    std::vector<COutPoint> inserted;
 
     uint256 txhash = tx.GetHash();
     for (unsigned int j = 0; j < tx.vin.size(); j++) {
@@ -547,14 +630,14 @@ void CTxMemPool::addSpentIndex(const CTxMemPoolEntry &entry, const CCoinsViewCac
             continue;
         }
 
-        CSpentIndexKey key = CSpentIndexKey(input.prevout.hash, input.prevout.n);
         CSpentIndexValue value = CSpentIndexValue(txhash, j, -1, prevout.nValue, address_type, address_bytes);
 
-        mapSpent.insert(std::make_pair(key, value));
-        inserted.push_back(key);
+        mapSpent.insert(std::make_pair(input.prevout, value));
+        inserted.push_back(input.prevout);
     }
 
-    mapSpentInserted.insert(make_pair(txhash, inserted));
+    m_index_usage += memusage::DynamicUsage(inserted);
+    mapSpentInserted.emplace(txhash, std::move(inserted));
 }
 
 bool CTxMemPool::getSpentIndex(CSpentIndexKey &key, CSpentIndexValue &value)
@@ -562,7 +645,7 @@ bool CTxMemPool::getSpentIndex(CSpentIndexKey &key, CSpentIndexValue &value)
     LOCK(cs);
     mapSpentIndex::iterator it;
 
-    it = mapSpent.find(key);
+    it = mapSpent.find(COutPoint(key.m_tx_hash, key.m_tx_index));
     if (it != mapSpent.end()) {
         value = it->second;
         return true;
@@ -570,16 +653,29 @@ bool CTxMemPool::getSpentIndex(CSpentIndexKey &key, CSpentIndexValue &value)
     return false;
 }
 
+void CTxMemPool::getSpentIndexes(const std::vector<CSpentIndexKey>& keys, CSpentIndexTxInfo& info, std::vector<CSpentIndexKey>& missing)
+{
+    LOCK(cs);
+    for (const auto& key : keys) {
+        auto it = mapSpent.find(COutPoint(key.m_tx_hash, key.m_tx_index));
+        if (it != mapSpent.end()) {
+            info.mSpentInfo.emplace(key, it->second);
+        } else {
+            missing.push_back(key);
+        }
+    }
+}
+
 bool CTxMemPool::removeSpentIndex(const uint256 txhash)
 {
     LOCK(cs);
     mapSpentIndexInserted::iterator it = mapSpentInserted.find(txhash);
 
     if (it != mapSpentInserted.end()) {
-        std::vector<CSpentIndexKey> keys = (*it).second;
-        for (std::vector<CSpentIndexKey>::iterator mit = keys.begin(); mit != keys.end(); mit++) {
-            mapSpent.erase(*mit);
+        for (const COutPoint& outpoint : it->second) {
+            mapSpent.erase(outpoint);
         }
+        m_index_usage -= memusage::DynamicUsage(it->second);
         mapSpentInserted.erase(it);
     }
 
@@ -596,6 +692,14 @@ void CTxMemPool::removeUnchecked(txiter it, MemPoolRemovalReason reason)
         GetMainSignals().TransactionRemovedFromMempool(it->GetSharedTx(), reason);
     }
 
+    TRACE5(mempool, removed,
+        it->GetTx().GetHash().data(),
+        static_cast<uint32_t>(reason),
+        it->GetTxSize(),
+        it->GetFee(),
+        count_seconds(it->GetTime())
+    );
+
     const uint256 hash = it->GetTx().GetHash();
     for (const CTxIn& txin : it->GetTx().vin)
         mapNextTx.erase(txin.prevout);
@@ -643,8 +747,16 @@ void CTxMemPool::removeUnchecked(txiter it, MemPoolRemovalReason reason)
     } else if (it->GetTx().nType == TRANSACTION_PROVIDER_UPDATE_REVOKE) {
         auto proTx = *Assert(GetTxPayload<CProUpRevTx>(it->GetTx()));
         eraseProTxRef(proTx.proTxHash, it->GetTx().GetHash());
+    } else if (it->GetTx().nType == TRANSACTION_ASSET_LOCK) {
+        --nAssetLockUnlockTxs;
     } else if (it->GetTx().nType == TRANSACTION_ASSET_UNLOCK) {
+        auto assetUnlockTx = *Assert(GetTxPayload<CAssetUnlockPayload>(it->GetTx()));
         mapAssetUnlockExpiry.erase(it->GetTx().GetHash());
+        if (auto indexIt = mapAssetUnlockIndexes.find(assetUnlockTx.getIndex());
+            indexIt != mapAssetUnlockIndexes.end() && indexIt->second == it->GetTx().GetHash()) {
+            mapAssetUnlockIndexes.erase(indexIt);
+        }
+        --nAssetLockUnlockTxs;
     }
 
     totalTxSize -= it->GetTxSize();
@@ -667,22 +779,39 @@ void CTxMemPool::removeUnchecked(txiter it, MemPoolRemovalReason reason)
 // can save time by not iterating over those entries.
 void CTxMemPool::CalculateDescendants(txiter entryit, setEntries& setDescendants) const
 {
-    setEntries stage;
-    if (setDescendants.count(entryit) == 0) {
-        stage.insert(entryit);
+    // Entries are inserted into setDescendants when they are staged, so the
+    // insertion itself tells whether a child still has to be walked.
+    vecEntries stage;
+    if (setDescendants.insert(entryit).second) {
+        stage.push_back(entryit);
     }
     // Traverse down the children of entry, only adding children that are not
     // accounted for in setDescendants already (because those children have either
     // already been walked, or will be walked in this iteration).
     while (!stage.empty()) {
-        txiter it = *stage.begin();
-        setDescendants.insert(it);
-        stage.erase(it);
+        txiter it = stage.back();
+        stage.pop_back();
 
         const setEntries &setChildren = GetMemPoolChildren(it);
         for (txiter childiter : setChildren) {
-            if (!setDescendants.count(childiter)) {
-                stage.insert(childiter);
+            if (setDescendants.insert(childiter).second) {
+                stage.push_back(childiter);
+            }
+        }
+    }
+}
+
+void CTxMemPool::CalculateDescendants(txiter entryit, vecEntries& descendants) const
+{
+    WITH_FRESH_EPOCH(m_epoch);
+    descendants.clear();
+    visited(entryit);
+    descendants.push_back(entryit);
+    // descendants doubles as the queue of entries whose children are still to be walked
+    for (size_t i = 0; i < descendants.size(); ++i) {
+        for (txiter childiter : GetMemPoolChildren(descendants[i])) {
+            if (!visited(childiter)) {
+                descendants.push_back(childiter);
             }
         }
     }
@@ -718,6 +847,19 @@ void CTxMemPool::removeRecursive(const CTransaction &origTx, MemPoolRemovalReaso
         RemoveStaged(setAllRemoves, false, reason);
 }
 
+void CTxMemPool::removeRecursive(const std::vector<CTransactionRef>& vtx, MemPoolRemovalReason reason)
+{
+    AssertLockHeld(cs);
+    setEntries setAllRemoves;
+    for (const auto& tx : vtx) {
+        txiter it = mapTx.find(tx->GetHash());
+        if (it != mapTx.end()) {
+            CalculateDescendants(it, setAllRemoves);
+        }
+    }
+    RemoveStaged(setAllRemoves, false, reason);
+}
+
 void CTxMemPool::removeForReorg(CChainState& active_chainstate, int flags) EXCLUSIVE_LOCKS_REQUIRED(cs_main)
 {
     // Remove transactions spending a coinbase which are now immature and no-longer-final transactions
@@ -995,6 +1137,13 @@ void CTxMemPool::_clear()
     mapNextTx.clear();
     mapProTxAddresses.clear();
     mapProTxPubKeyIDs.clear();
+    mapAssetUnlockIndexes.clear();
+    nAssetLockUnlockTxs = 0;
+    mapAddress.clear();
+    mapAddressInserted.clear();
+    mapSpent.clear();
+    mapSpentInserted.clear();
+    m_index_usage = 0;
     totalTxSize = 0;
     m_total_fee = 0;
     cachedInnerUsage = 0;
@@ -1234,6 +1383,31 @@ TxMempoolInfo CTxMemPool::info(const uint256& hash) const
     return GetInfo(i);
 }
 
+std::vector<uint256> CTxMemPool::GetAncestorPackage(const uint256& txid, size_t max_count) const
+{
+    LOCK(cs);
+    indexed_transaction_set::const_iterator it = mapTx.find(txid);
+    if (it == mapTx.end() || it->GetCountWithAncestors() > max_count) return {};
+
+    setEntries ancestors;
+    std::string dummy;
+    CalculateMemPoolAncestors(*it, ancestors, std::numeric_limits<uint64_t>::max(), std::numeric_limits<uint64_t>::max(),
+                              std::numeric_limits<uint64_t>::max(), std::numeric_limits<uint64_t>::max(), dummy, false);
+    // An ancestor has fewer ancestors than each of its descendants, so this is a topological order
+    std::vector<txiter> sorted(ancestors.begin(), ancestors.end());
+    std::sort(sorted.begin(), sorted.end(), [](const txiter& a, const txiter& b) {
+        return a->GetCountWithAncestors() < b->GetCountWithAncestors();
+    });
+
+    std::vector<uint256> ret;
+    ret.reserve(sorted.size() + 1);
+    for (const txiter& ancestor : sorted) {
+        ret.push_back(ancestor->GetTx().GetHash());
+    }
+    ret.push_back(txid);
+    return ret;
+}
+
 bool CTxMemPool::existsProviderTxConflict(const CTransaction &tx) const {
     LOCK(cs);
 
@@ -1321,10 +1495,24 @@ bool CTxMemPool::existsProviderTxConflict(const CTransaction &tx) const {
                 return true;
             }
         }
+    } else if (tx.nType == TRANSACTION_ASSET_UNLOCK) {
+        const auto opt_assetUnlockTx = GetTxPayload<CAssetUnlockPayload>(tx);
+        if (!opt_assetUnlockTx) {
+            LogPrint(BCLog::MEMPOOL, "%s: ERROR: Invalid transaction payload, tx: %s\n", __func__, tx.GetHash().ToString());
+            return true; // i.e. can't decode payload == conflict
+        }
+        // only one withdrawal with a given index can ever be mined
+        return mapAssetUnlockIndexes.count(opt_assetUnlockTx->getIndex()) > 0;
     }
     return false;
 }
 
+bool CTxMemPool::existsAssetUnlockIndex(uint64_t index) const
+{
+    LOCK(cs);
+    return mapAssetUnlockIndexes.count(index) > 0;
+}
+
 void CTxMemPool::PrioritiseTransaction(const uint256& hash, const CAmount& nFeeDelta)
 {
     {
@@ -1343,11 +1531,11 @@ void CTxMemPool::PrioritiseTransaction(const uint256& hash, const CAmount& nFeeD
                 mapTx.modify(ancestorIt, update_descendant_state(0, nFeeDelta, 0));
             }
             // Now update all descendants' modified fees with ancestors
-            setEntries setDescendants;
-            CalculateDescendants(it, setDescendants);
-            setDescendants.erase(it);
-            for (txiter descendantIt : setDescendants) {
-                mapTx.modify(descendantIt, update_ancestor_state(0, nFeeDelta, 0, 0));
+            vecEntries descendants;
+            CalculateDescendants(it, descendants);
+            // CalculateDescendants puts the given tx first
+            for (size_t i = 1; i < descendants.size(); ++i) {
+                mapTx.modify(descendants[i], update_ancestor_state(0, nFeeDelta, 0, 0));
             }
             ++nTransactionsUpdated;
         }
@@ -1437,7 +1625,8 @@ void CCoinsViewMemPool::PackageAddTransaction(const CTransactionRef& tx)
 size_t CTxMemPool::DynamicMemoryUsage() const {
     LOCK(cs);
     // Estimate the overhead of mapTx to be 12 pointers + an allocation, as no exact formula for boost::multi_index_contained is implemented.
-    return memusage::MallocUsage(sizeof(CTxMemPoolEntry) + 12 * sizeof(void*)) * mapTx.size() + memusage::DynamicUsage(mapNextTx) + memusage::DynamicUsage(mapDeltas) + memusage::DynamicUsage(mapLinks) + memusage::DynamicUsage(vTxHashes) + cachedInnerUsage;
+    return memusage::MallocUsage(sizeof(CTxMemPoolEntry) + 12 * sizeof(void*)) * mapTx.size() + memusage::DynamicUsage(mapNextTx) + memusage::DynamicUsage(mapDeltas) + memusage::DynamicUsage(mapLinks) + memusage::DynamicUsage(vTxHashes) + cachedInnerUsage +
+           memusage::DynamicUsage(mapAddress) + memusage::DynamicUsage(mapAddressInserted) + memusage::DynamicUsage(mapSpent) + memusage::DynamicUsage(mapSpentInserted) + m_index_usage;
 }
 
 void CTxMemPool::RemoveUnbroadcastTx(const uint256& txid, const bool unchecked) {
@@ -1449,6 +1638,33 @@ void CTxMemPool::RemoveUnbroadcastTx(const uint256& txid, const bool unchecked)
     }
 }
 
+size_t CTxMemPool::RemovalUsageUpperBound(txiter entry) const
+{
+    AssertLockHeld(cs);
+    const TxLinks& links = mapLinks.find(entry)->second;
+    size_t usage = memusage::MallocUsage(sizeof(CTxMemPoolEntry) + 12 * sizeof(void*)) + entry->DynamicMemoryUsage();
+    // its links, and where it appears in the links of its parents and children
+    usage += memusage::IncrementalDynamicUsage(mapLinks) + memusage::DynamicUsage(links.parents) + memusage::DynamicUsage(links.children);
+    usage += (links.parents.size() + links.children.size()) * memusage::IncrementalDynamicUsage(links.parents);
+    usage += entry->GetTx().vin.size() * memusage::IncrementalDynamicUsage(mapNextTx);
+
+    const uint256& hash = entry->GetTx().GetHash();
+    const auto address_it = mapAddressInserted.find(hash);
+    if (address_it != mapAddressInserted.end()) {
+        usage += memusage::IncrementalDynamicUsage(mapAddressInserted) + memusage::DynamicUsage(address_it->second);
+        for (const auto& [address, pos] : address_it->second) {
+            // at most the whole bucket, when this is its last delta
+            usage += memusage::IncrementalDynamicUsage(mapAddress) + memusage::DynamicUsage(mapAddress.find(address)->second);
+        }
+    }
+    const auto spent_it = mapSpentInserted.find(hash);
+    if (spent_it != mapSpentInserted.end()) {
+        usage += memusage::IncrementalDynamicUsage(mapSpentInserted) + memusage::DynamicUsage(spent_it->second);
+        usage += spent_it->second.size() * memusage::IncrementalDynamicUsage(mapSpent);
+    }
+    return usage;
+}
+
 void CTxMemPool::RemoveStaged(setEntries &stage, bool updateDescendants, MemPoolRemovalReason reason) {
     AssertLockHeld(cs);
     UpdateForRemoveFromMempool(stage, updateDescendants);
@@ -1461,20 +1677,33 @@ int CTxMemPool::Expire(std::chrono::seconds time)
 {
     AssertLockHeld(cs);
     indexed_transaction_set::index<entry_time>::type::iterator it = mapTx.get<entry_time>().begin();
-    setEntries toremove;
-    while (it != mapTx.get<entry_time>().end() && it->GetTime() < time) {
-        // locked txes do not expire until mined and have sufficient confirmations
-        if (llmq::quorumInstantSendManager->IsLocked(it->GetTx().GetHash())) {
+    // The union of the descendants of all expired transactions is collected in
+    // a single pass, and removed in one go.
+    vecEntries toremove;
+    {
+        WITH_FRESH_EPOCH(m_epoch);
+        while (it != mapTx.get<entry_time>().end() && it->GetTime() < time) {
+            // locked txes do not expire until mined and have sufficient confirmations
+            if (llmq::quorumInstantSendManager->IsLocked(it->GetTx().GetHash())) {
+                it++;
+                continue;
+            }
+            const txiter removeit = mapTx.project<0>(it);
             it++;
-            continue;
+            // already a descendant of an earlier expired transaction
+            if (visited(removeit)) continue;
+            const size_t first = toremove.size();
+            toremove.push_back(removeit);
+            for (size_t i = first; i < toremove.size(); ++i) {
+                for (txiter childiter : GetMemPoolChildren(toremove[i])) {
+                    if (!visited(childiter)) {
+                        toremove.push_back(childiter);
+                    }
+                }
+            }
         }
-        toremove.insert(mapTx.project<0>(it));
-        it++;
-    }
-    setEntries stage;
-    for (txiter removeit : toremove) {
-        CalculateDescendants(removeit, stage);
     }
+    setEntries stage(toremove.begin(), toremove.end());
     RemoveStaged(stage, false, MemPoolRemovalReason::EXPIRY);
     return stage.size();
 }
@@ -1563,32 +1792,75 @@ void CTxMemPool::TrimToSize(size_t sizelimit, std::vector<COutPoint>* pvNoSpends
 
     unsigned nTxnRemoved = 0;
     CFeeRate maxFeeRateRemoved(0);
-    while (!mapTx.empty() && DynamicMemoryUsage() > sizelimit) {
-        indexed_transaction_set::index<descendant_score>::type::iterator it = mapTx.get<descendant_score>().begin();
-
-        // We set the new mempool min fee to the feerate of the removed set, plus the
-        // "minimum reasonable fee rate" (ie some value under which we consider txn
-        // to have 0 fee). This way, we don't allow txn to enter mempool with feerate
-        // equal to txn which were removed with no block in between.
-        CFeeRate removed(it->GetModFeesWithDescendants(), it->GetSizeWithDescendants());
-        removed += incrementalRelayFee;
-        trackPackageRemoved(removed);
-        maxFeeRateRemoved = std::max(maxFeeRateRemoved, removed);
-
-        setEntries stage;
-        CalculateDescendants(mapTx.project<0>(it), stage);
+    size_t usage;
+    while (!mapTx.empty() && (usage = DynamicMemoryUsage()) > sizelimit) {
+        // Rather than removing the package with the lowest descendant score and
+        // looking again, take as many of the lowest scoring packages as it needs
+        // to get below sizelimit and remove them at once. A package only joins
+        // the batch while the ones before it have no parents outside the batch,
+        // as otherwise their removal changes the descendant scores of what is
+        // left. The batch is then what one at a time removal would have taken,
+        // and overestimating the freed memory at worst takes another round.
+        vecEntries batch;
+        {
+            WITH_FRESH_EPOCH(m_epoch);
+            size_t freed = 0;
+            size_t hashes_size = vTxHashes.size();
+            size_t hashes_capacity = vTxHashes.capacity();
+            bool isolated = true;
+            for (auto it = mapTx.get<descendant_score>().begin(); it != mapTx.get<descendant_score>().end() && isolated && freed < usage - sizelimit; ++it) {
+                const txiter root = mapTx.project<0>(it);
+                // already a descendant of an earlier package
+                if (visited(root)) continue;
+
+                // We set the new mempool min fee to the feerate of the removed set, plus the
+                // "minimum reasonable fee rate" (ie some value under which we consider txn
+                // to have 0 fee). This way, we don't allow txn to enter mempool with feerate
+                // equal to txn which were removed with no block in between.
+                CFeeRate removed(it->GetModFeesWithDescendants(), it->GetSizeWithDescendants());
+                removed += incrementalRelayFee;
+                trackPackageRemoved(removed);
+                maxFeeRateRemoved = std::max(maxFeeRateRemoved, removed);
+
+                const size_t first = batch.size();
+                batch.push_back(root);
+                for (size_t i = first; i < batch.size(); ++i) {
+                    for (txiter childiter : GetMemPoolChildren(batch[i])) {
+                        if (!visited(childiter)) {
+                            batch.push_back(childiter);
+                        }
+                    }
+                }
+                for (size_t i = first; i < batch.size(); ++i) {
+                    freed += RemovalUsageUpperBound(batch[i]);
+                    // removeUnchecked shrinks vTxHashes once it is less than half full
+                    if (hashes_size > 1 && --hashes_size * 2 < hashes_capacity) {
+                        freed += memusage::MallocUsage(hashes_capacity * sizeof(vTxHashes[0])) - memusage::MallocUsage(hashes_size * sizeof(vTxHashes[0]));
+                        hashes_capacity = hashes_size;
+                    }
+                    for (txiter parentiter : GetMemPoolParents(batch[i])) {
+                        // This marks a parent outside the batch as visited, which
+                        // doesn't matter as the batch ends with this package.
+                        if (!visited(parentiter)) {
+                            isolated = false;
+                        }
+                    }
+                }
+            }
+        }
+        setEntries stage(batch.begin(), batch.end());
         nTxnRemoved += stage.size();
 
-        std::vector<CTransaction> txn;
+        std::vector<CTransactionRef> txn;
         if (pvNoSpendsRemaining) {
             txn.reserve(stage.size());
             for (txiter iter : stage)
-                txn.push_back(iter->GetTx());
+                txn.push_back(iter->GetSharedTx());
         }
         RemoveStaged(stage, false, MemPoolRemovalReason::SIZELIMIT);
         if (pvNoSpendsRemaining) {
-            for (const CTransaction& tx : txn) {
-                for (const CTxIn& txin : tx.vin) {
+            for (const CTransactionRef& tx : txn) {
+                for (const CTxIn& txin : tx->vin) {
                     if (exists(txin.prevout.hash)) continue;
                     pvNoSpendsRemaining->push_back(txin.prevout);
                 }
@@ -11,6 +11,7 @@
 #include <optional>
 #include <set>
 #include <string>
+#include <unordered_map>
 #include <utility>
 #include <vector>
 
@@ -334,6 +335,19 @@ struct descendant_score {};
 struct entry_time {};
 struct ancestor_score {};
 
+/** Hasher for the (type, hash) of an address in the mempool address index. */
+class MempoolAddressHasher
+{
+private:
+    SaltedSipHasher m_hasher;
+
+public:
+    size_t operator()(const std::pair<AddressType, uint160>& address) const
+    {
+        return m_hasher(Span<const unsigned char>{address.second.begin(), address.second.size()}) ^ ToUnderlying(address.first);
+    }
+};
+
 class CBlockPolicyEstimator;
 
 /**
@@ -529,12 +543,13 @@ public:
         }
     };
     typedef std::set<txiter, CompareIteratorByHash> setEntries;
+    typedef std::vector<txiter> vecEntries;
 
     const setEntries & GetMemPoolParents(txiter entry) const EXCLUSIVE_LOCKS_REQUIRED(cs);
     const setEntries & GetMemPoolChildren(txiter entry) const EXCLUSIVE_LOCKS_REQUIRED(cs);
     uint64_t CalculateDescendantMaximum(txiter entry) const EXCLUSIVE_LOCKS_REQUIRED(cs);
 private:
-    typedef std::map<txiter, setEntries, CompareIteratorByHash> cacheMap;
+    typedef std::map<txiter, vecEntries, CompareIteratorByHash> cacheMap;
 
     struct TxLinks {
         setEntries parents;
@@ -544,24 +559,36 @@ private:
     typedef std::map<txiter, TxLinks, CompareIteratorByHash> txlinksMap;
     txlinksMap mapLinks;
 
-    typedef std::map<CMempoolAddressDeltaKey, CMempoolAddressDelta, CMempoolAddressDeltaKeyCompare> addressDeltaMap;
+    /**
+     * The address index keeps the deltas of each address in a bucket of its own, so looking
+     * up an address is a single hash lookup. mapAddressInserted records, per transaction, the
+     * bucket and position of each of its deltas, which are swap-removed with the transaction.
+     */
+    typedef std::pair<AddressType, uint160> addressKey;
+    typedef std::vector<std::pair<CMempoolAddressDeltaKey, CMempoolAddressDelta> > addressDeltaBucket;
+    typedef std::unordered_map<addressKey, addressDeltaBucket, MempoolAddressHasher> addressDeltaMap;
     addressDeltaMap mapAddress;
 
-    typedef std::map<uint256, std::vector<CMempoolAddressDeltaKey> > addressDeltaMapInserted;
+    typedef std::unordered_map<uint256, std::vector<std::pair<addressKey, size_t> >, SaltedTxidHasher> addressDeltaMapInserted;
     addressDeltaMapInserted mapAddressInserted;
 
-    typedef std::map<CSpentIndexKey, CSpentIndexValue, CSpentIndexKeyCompare> mapSpentIndex;
+    typedef std::unordered_map<COutPoint, CSpentIndexValue, SaltedOutpointHasher> mapSpentIndex;
     mapSpentIndex mapSpent;
 
-    typedef std::map<uint256, std::vector<CSpentIndexKey> > mapSpentIndexInserted;
+    typedef std::unordered_map<uint256, std::vector<COutPoint>, SaltedTxidHasher> mapSpentIndexInserted;
     mapSpentIndexInserted mapSpentInserted;
 
+    //! Heap usage of the buckets and vectors held by the address and spent index maps
+    size_t m_index_usage{0};
+
     std::multimap<uint256, uint256> mapProTxRefs; // proTxHash -> transaction (all TXs that refer to an existing proTx)
     std::map<CService, uint256> mapProTxAddresses;
     std::map<CKeyID, uint256> mapProTxPubKeyIDs;
     std::map<uint256, uint256> mapProTxBlsPubKeyHashes;
     std::map<COutPoint, uint256> mapProTxCollaterals;
     std::map<uint256, int /* expiry height */> mapAssetUnlockExpiry; // tx hash -> height
+    std::unordered_map<uint64_t, uint256> mapAssetUnlockIndexes; // withdrawal index -> tx hash
+    size_t nAssetLockUnlockTxs{0}; // number of asset lock and asset unlock txs in the pool
 
     void UpdateParent(txiter entry, txiter parent, bool add) EXCLUSIVE_LOCKS_REQUIRED(cs);
     void UpdateChild(txiter entry, txiter child, bool add) EXCLUSIVE_LOCKS_REQUIRED(cs);
@@ -606,15 +633,19 @@ public:
     void addUnchecked(const CTxMemPoolEntry& entry, setEntries& setAncestors, bool validFeeEstimate = true) EXCLUSIVE_LOCKS_REQUIRED(cs, cs_main);
 
     void addAddressIndex(const CTxMemPoolEntry &entry, const CCoinsViewCache &view);
-    bool getAddressIndex(std::vector<std::pair<uint160, AddressType> > &addresses,
+    bool getAddressIndex(const std::vector<std::pair<uint160, AddressType> >& addresses,
                          std::vector<std::pair<CMempoolAddressDeltaKey, CMempoolAddressDelta> > &results);
     bool removeAddressIndex(const uint256 txhash);
 
     void addSpentIndex(const CTxMemPoolEntry &entry, const CCoinsViewCache &view);
     bool getSpentIndex(CSpentIndexKey &key, CSpentIndexValue &value);
+    /** Add the entries found for keys to info, keys not in the mempool are returned in missing */
+    void getSpentIndexes(const std::vector<CSpentIndexKey>& keys, CSpentIndexTxInfo& info, std::vector<CSpentIndexKey>& missing);
     bool removeSpentIndex(const uint256 txhash);
 
     void removeRecursive(const CTransaction& tx, MemPoolRemovalReason reason) EXCLUSIVE_LOCKS_REQUIRED(cs);
+    /** Remove the in-mempool transactions of vtx and all their descendants in a single pass */
+    void removeRecursive(const std::vector<CTransactionRef>& vtx, MemPoolRemovalReason reason) EXCLUSIVE_LOCKS_REQUIRED(cs);
     void removeForReorg(CChainState& active_chainstate, int flags) EXCLUSIVE_LOCKS_REQUIRED(cs, cs_main);
     void removeConflicts(const CTransaction& tx) EXCLUSIVE_LOCKS_REQUIRED(cs);
     void removeProTxPubKeyConflicts(const CTransaction &tx, const CKeyID &keyId) EXCLUSIVE_LOCKS_REQUIRED(cs);
@@ -682,6 +713,7 @@ public:
      *  errString = populated with error reason if any limits are hit
      *  fSearchForParents = whether to search a tx's vin for in-mempool parents, or
      *    look up parents from mapLinks. Must be true for entries not in the mempool
+     *  The walk uses the epoch markers, so no Epoch::Guard may be held by the caller.
      */
     bool CalculateMemPoolAncestors(const CTxMemPoolEntry& entry, setEntries& setAncestors, uint64_t limitAncestorCount, uint64_t limitAncestorSize, uint64_t limitDescendantCount, uint64_t limitDescendantSize, std::string& errString, bool fSearchForParents = true) const EXCLUSIVE_LOCKS_REQUIRED(cs);
 
@@ -689,6 +721,10 @@ public:
      *  Assumes that setDescendants includes all in-mempool descendants of anything
      *  already in it.  */
     void CalculateDescendants(txiter it, setEntries& setDescendants) const EXCLUSIVE_LOCKS_REQUIRED(cs);
+    /** Replace the contents of descendants with it and all its in-mempool descendants,
+     *  it coming first. Walks with the epoch markers, so must not be called while
+     *  an Epoch::Guard is held. */
+    void CalculateDescendants(txiter it, vecEntries& descendants) const EXCLUSIVE_LOCKS_REQUIRED(cs);
 
     /** The minimum fee to get into the mempool, which may itself not be enough
       *  for larger-sized transactions.
@@ -747,8 +783,20 @@ public:
     TxMempoolInfo info(const uint256& hash) const;
     std::vector<TxMempoolInfo> infoAll() const;
 
+    /**
+     * Get the txids of the in-mempool ancestors of a transaction followed by the transaction itself,
+     * parents before children. Empty if the transaction is not in the mempool or the package would
+     * have more than max_count transactions.
+     */
+    std::vector<uint256> GetAncestorPackage(const uint256& txid, size_t max_count) const;
+
     bool existsProviderTxConflict(const CTransaction &tx) const;
 
+    /** Whether an asset unlock tx with this withdrawal index is in the pool */
+    bool existsAssetUnlockIndex(uint64_t index) const;
+    /** Whether the pool has any asset lock or asset unlock tx, i.e. anything the credit pool would have to check */
+    bool hasAssetLockUnlockTxs() const EXCLUSIVE_LOCKS_REQUIRED(cs) { return nAssetLockUnlockTxs > 0; }
+
     size_t DynamicMemoryUsage() const;
 
     /** Adds a transaction to the unbroadcast set */
@@ -801,6 +849,8 @@ private:
       * If updateDescendants is true, then also update in-mempool descendants'
       * ancestor state. */
     void UpdateForRemoveFromMempool(const setEntries &entriesToRemove, bool updateDescendants) EXCLUSIVE_LOCKS_REQUIRED(cs);
+    /** Upper bound of the DynamicMemoryUsage() given back by removing entry, not counting vTxHashes. */
+    size_t RemovalUsageUpperBound(txiter entry) const EXCLUSIVE_LOCKS_REQUIRED(cs);
     /** Sever link between specified transaction and direct children. */
     void UpdateChildrenForRemoval(txiter entry) EXCLUSIVE_LOCKS_REQUIRED(cs);
 
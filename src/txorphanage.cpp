@@ -0,0 +1,246 @@
+// Copyright (c) 2021 The Bitcoin Core developers
+// Copyright (c) 2024 The Maximus developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <txorphanage.h>
+
+#include <consensus/validation.h>
+#include <logging.h>
+#include <policy/policy.h>
+#include <random.h>
+#include <statsd_client.h>
+#include <util/time.h>
+
+#include <cassert>
+
+RecursiveMutex g_cs_orphans;
+
+namespace {
+/** Swap-remove txid from a vector of orphans, fixing up the position of the moved entry. */
+template <typename Map, typename Pos>
+void EraseFromList(std::vector<uint256>& list, size_t pos, Map& orphans, Pos OrphanTxPos)
+{
+    if (pos + 1 != list.size()) {
+        // Unless we're deleting the last entry, move the last entry to the position we're deleting.
+        list[pos] = list.back();
+        orphans.at(list[pos]).*OrphanTxPos = pos;
+    }
+    list.pop_back();
+}
+} // namespace
+
+bool TxOrphanage::AddTx(const CTransactionRef& tx, NodeId peer)
+{
+    AssertLockHeld(g_cs_orphans);
+
+    const uint256& hash = tx->GetHash();
+    if (m_orphans.count(hash))
+        return false;
+
+    // Ignore big transactions, to avoid a
+    // send-big-orphans memory exhaustion attack. If a peer has a legitimate
+    // large transaction with a missing parent then we assume
+    // it will rebroadcast it later, after the parent transaction(s)
+    // have been mined or received.
+    // 100 orphans, each of which is at most 99,999 bytes big is
+    // at most 10 megabytes of orphans and somewhat more byprev index (in the worst case):
+    unsigned int sz = GetSerializeSize(*tx, CTransaction::CURRENT_VERSION);
+    if (sz > MAX_STANDARD_TX_SIZE)
+    {
+        LogPrint(BCLog::MEMPOOL, "ignoring large orphan tx (size: %u, hash: %s)\n", sz, hash.ToString());
+        return false;
+    }
+
+    auto& peer_orphans = m_peer_orphans[peer];
+    const int64_t nTimeExpire = GetTime() + ORPHAN_TX_EXPIRE_TIME;
+    auto ret = m_orphans.emplace(hash, OrphanTx{tx, peer, nTimeExpire, m_orphan_list.size(), peer_orphans.m_orphan_list.size(), sz});
+    assert(ret.second);
+    m_orphan_list.push_back(hash);
+    peer_orphans.m_orphan_list.push_back(hash);
+    peer_orphans.m_size += sz;
+    m_expiry_queue.emplace_back(nTimeExpire, hash);
+    for (const CTxIn& txin : tx->vin) {
+        m_outpoint_to_orphan[txin.prevout].push_back(hash);
+    }
+
+    m_orphans_size += sz;
+
+    LogPrint(BCLog::MEMPOOL, "stored orphan tx %s (mapsz %u outsz %u)\n", hash.ToString(),
+             m_orphans.size(), m_outpoint_to_orphan.size());
+    statsClient.inc("transactions.orphans.add", 1.0f);
+    statsClient.gauge("transactions.orphans", m_orphans.size());
+    return true;
+}
+
+int TxOrphanage::EraseTx(const uint256& txid)
+{
+    AssertLockHeld(g_cs_orphans);
+    const auto it = m_orphans.find(txid);
+    if (it == m_orphans.end())
+        return 0;
+    for (const CTxIn& txin : it->second.tx->vin)
+    {
+        auto itPrev = m_outpoint_to_orphan.find(txin.prevout);
+        if (itPrev == m_outpoint_to_orphan.end())
+            continue;
+        auto& children = itPrev->second;
+        children.erase(std::remove(children.begin(), children.end(), txid), children.end());
+        if (children.empty())
+            m_outpoint_to_orphan.erase(itPrev);
+    }
+
+    assert(m_orphan_list[it->second.list_pos] == txid);
+    EraseFromList(m_orphan_list, it->second.list_pos, m_orphans, &OrphanTx::list_pos);
+
+    const auto peer_it = m_peer_orphans.find(it->second.fromPeer);
+    assert(peer_it != m_peer_orphans.end());
+    auto& peer_orphans = peer_it->second;
+    assert(peer_orphans.m_orphan_list[it->second.peer_list_pos] == txid);
+    EraseFromList(peer_orphans.m_orphan_list, it->second.peer_list_pos, m_orphans, &OrphanTx::peer_list_pos);
+    assert(peer_orphans.m_size >= it->second.nTxSize);
+    peer_orphans.m_size -= it->second.nTxSize;
+    if (peer_orphans.m_orphan_list.empty()) {
+        m_peer_orphans.erase(peer_it);
+    }
+
+    assert(m_orphans_size >= it->second.nTxSize);
+    m_orphans_size -= it->second.nTxSize;
+    m_orphans.erase(it);
+    statsClient.inc("transactions.orphans.remove", 1.0f);
+    statsClient.gauge("transactions.orphans", m_orphans.size());
+    return 1;
+}
+
+void TxOrphanage::EraseForPeer(NodeId peer)
+{
+    AssertLockHeld(g_cs_orphans);
+
+    const auto peer_it = m_peer_orphans.find(peer);
+    if (peer_it == m_peer_orphans.end()) return;
+
+    // EraseTx drops the peer entry together with its last orphan
+    const std::vector<uint256> peer_orphans = peer_it->second.m_orphan_list;
+    int nErased = 0;
+    for (const uint256& txid : peer_orphans) {
+        nErased += EraseTx(txid);
+    }
+    if (nErased > 0) LogPrint(BCLog::MEMPOOL, "Erased %d orphan tx from peer=%d\n", nErased, peer);
+}
+
+unsigned int TxOrphanage::LimitOrphans(size_t max_orphans_size, size_t max_peer_orphans_size)
+{
+    AssertLockHeld(g_cs_orphans);
+
+    // Sweep out expired orphan pool entries. The queue is in insertion order which, with a fixed
+    // expiry time, is also expiry order.
+    int nErased = 0;
+    const int64_t nNow = GetTime();
+    while (!m_expiry_queue.empty() && m_expiry_queue.front().first <= nNow) {
+        const auto [nTimeExpire, txid] = m_expiry_queue.front();
+        m_expiry_queue.pop_front();
+        const auto it = m_orphans.find(txid);
+        // Skip entries of orphans which are gone already or were re-added later
+        if (it != m_orphans.end() && it->second.nTimeExpire == nTimeExpire) {
+            nErased += EraseTx(txid);
+        }
+    }
+    if (nErased > 0) LogPrint(BCLog::MEMPOOL, "Erased %d orphan tx due to expiration\n", nErased);
+
+    // Orphans which were erased for other reasons leave their entries behind, drop them
+    // before they outnumber the live ones.
+    if (m_expiry_queue.size() > 2 * m_orphans.size() + 100) {
+        std::deque<std::pair<int64_t, uint256>> live;
+        for (const auto& entry : m_expiry_queue) {
+            const auto it = m_orphans.find(entry.second);
+            if (it != m_orphans.end() && it->second.nTimeExpire == entry.first) live.push_back(entry);
+        }
+        m_expiry_queue.swap(live);
+    }
+
+    unsigned int nEvicted = 0;
+    FastRandomContext rng;
+    // Keep a single peer from filling the pool on its own
+    for (auto peer_it = m_peer_orphans.begin(); peer_it != m_peer_orphans.end();) {
+        const NodeId peer = peer_it->first;
+        ++peer_it; // EraseTx may drop the entry we're at
+        for (auto it = m_peer_orphans.find(peer); it != m_peer_orphans.end() && it->second.m_size > max_peer_orphans_size; it = m_peer_orphans.find(peer)) {
+            const auto& peer_list = it->second.m_orphan_list;
+            EraseTx(peer_list[rng.randrange(peer_list.size())]);
+            ++nEvicted;
+        }
+    }
+    while (!m_orphans.empty() && m_orphans_size > max_orphans_size)
+    {
+        // Evict a random orphan:
+        size_t randompos = rng.randrange(m_orphan_list.size());
+        EraseTx(m_orphan_list[randompos]);
+        ++nEvicted;
+    }
+    return nEvicted;
+}
+
+void TxOrphanage::AddChildrenToWorkSet(const CTransaction& tx, std::set<uint256>& orphan_work_set) const
+{
+    AssertLockHeld(g_cs_orphans);
+    for (unsigned int i = 0; i < tx.vout.size(); i++) {
+        const auto it_by_prev = m_outpoint_to_orphan.find(COutPoint(tx.GetHash(), i));
+        if (it_by_prev != m_outpoint_to_orphan.end()) {
+            orphan_work_set.insert(it_by_prev->second.begin(), it_by_prev->second.end());
+        }
+    }
+}
+
+bool TxOrphanage::HaveTx(const uint256& txid) const
+{
+    LOCK(g_cs_orphans);
+    return m_orphans.count(txid);
+}
+
+std::pair<CTransactionRef, NodeId> TxOrphanage::GetTx(const uint256& txid) const
+{
+    AssertLockHeld(g_cs_orphans);
+
+    const auto it = m_orphans.find(txid);
+    if (it == m_orphans.end()) return {nullptr, -1};
+    return {it->second.tx, it->second.fromPeer};
+}
+
+size_t TxOrphanage::PeerOrphanSize(NodeId peer) const
+{
+    AssertLockHeld(g_cs_orphans);
+
+    const auto it = m_peer_orphans.find(peer);
+    return it == m_peer_orphans.end() ? 0 : it->second.m_size;
+}
+
+void TxOrphanage::EraseForBlock(const CBlock& block, std::set<uint256>& orphan_work_set)
+{
+    AssertLockHeld(g_cs_orphans);
+
+    std::vector<uint256> vOrphanErase;
+
+    for (const CTransactionRef& ptx : block.vtx) {
+        const CTransaction& tx = *ptx;
+
+        // Which orphan pool entries we should reprocess and potentially try to accept into mempool again?
+        AddChildrenToWorkSet(tx, orphan_work_set);
+
+        // Which orphan pool entries must we evict?
+        for (const auto& txin : tx.vin) {
+            auto itByPrev = m_outpoint_to_orphan.find(txin.prevout);
+            if (itByPrev == m_outpoint_to_orphan.end()) continue;
+            vOrphanErase.insert(vOrphanErase.end(), itByPrev->second.begin(), itByPrev->second.end());
+        }
+    }
+
+    // Erase orphan transactions included or precluded by this block
+    if (vOrphanErase.size()) {
+        int nErased = 0;
+        for (const uint256& orphanHash : vOrphanErase) {
+            nErased += EraseTx(orphanHash);
+            orphan_work_set.erase(orphanHash);
+        }
+        LogPrint(BCLog::MEMPOOL, "Erased %d orphan tx included or conflicted by block\n", nErased);
+    }
+}
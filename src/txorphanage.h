@@ -0,0 +1,121 @@
+// Copyright (c) 2021 The Bitcoin Core developers
+// Copyright (c) 2024 The Maximus developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_TXORPHANAGE_H
+#define BITCOIN_TXORPHANAGE_H
+
+#include <net.h>
+#include <primitives/block.h>
+#include <primitives/transaction.h>
+#include <sync.h>
+#include <util/hasher.h>
+
+#include <deque>
+#include <set>
+#include <unordered_map>
+#include <vector>
+
+/** Expiration time for orphan transactions in seconds */
+static constexpr int64_t ORPHAN_TX_EXPIRE_TIME = 20 * 60;
+
+/** Guards orphan transactions and extra txs for compact blocks */
+extern RecursiveMutex g_cs_orphans;
+
+/** A class to track orphan transactions (failed on TX_MISSING_INPUTS)
+ * Since we cannot distinguish orphans from bad transactions with
+ * non-existent inputs, we heavily limit the number of orphans
+ * we keep and the duration we keep them for.
+ *
+ * All lookups are hash based, every peer has a byte budget, and
+ * evictions (random, per peer or by expiry) don't scan the whole pool.
+ */
+class TxOrphanage {
+public:
+    /** Add a new orphan transaction */
+    bool AddTx(const CTransactionRef& tx, NodeId peer) EXCLUSIVE_LOCKS_REQUIRED(g_cs_orphans);
+
+    /** Check if we already have an orphan transaction */
+    bool HaveTx(const uint256& txid) const LOCKS_EXCLUDED(g_cs_orphans);
+
+    /** Get an orphan transaction and its originating peer
+     * (Transaction ref will be nullptr if not found)
+     */
+    std::pair<CTransactionRef, NodeId> GetTx(const uint256& txid) const EXCLUSIVE_LOCKS_REQUIRED(g_cs_orphans);
+
+    /** Erase an orphan by txid */
+    int EraseTx(const uint256& txid) EXCLUSIVE_LOCKS_REQUIRED(g_cs_orphans);
+
+    /** Erase all orphans announced by a peer (eg, after that peer disconnects) */
+    void EraseForPeer(NodeId peer) EXCLUSIVE_LOCKS_REQUIRED(g_cs_orphans);
+
+    /**
+     * Erase all orphans included in or invalidated by a new block, and collect the orphans
+     * spending outputs of its transactions into orphan_work_set, so that the whole block is
+     * resolved in one pass.
+     */
+    void EraseForBlock(const CBlock& block, std::set<uint256>& orphan_work_set) EXCLUSIVE_LOCKS_REQUIRED(g_cs_orphans);
+
+    /**
+     * Expire old orphans, then evict orphans of peers using more than max_peer_orphans_size
+     * bytes and finally random orphans until the pool is at most max_orphans_size bytes.
+     * Returns the number of evicted orphans (not counting expired ones).
+     */
+    unsigned int LimitOrphans(size_t max_orphans_size, size_t max_peer_orphans_size) EXCLUSIVE_LOCKS_REQUIRED(g_cs_orphans);
+
+    /** Add any orphans that list a particular tx as a parent into an orphan work set */
+    void AddChildrenToWorkSet(const CTransaction& tx, std::set<uint256>& orphan_work_set) const EXCLUSIVE_LOCKS_REQUIRED(g_cs_orphans);
+
+    /** Return how many entries exist in the orphanage */
+    size_t Size() EXCLUSIVE_LOCKS_REQUIRED(g_cs_orphans)
+    {
+        return m_orphans.size();
+    }
+
+    /** Return the total serialized size of all orphans */
+    size_t TotalOrphanSize() EXCLUSIVE_LOCKS_REQUIRED(g_cs_orphans)
+    {
+        return m_orphans_size;
+    }
+
+    /** Return the total serialized size of the orphans announced by a peer */
+    size_t PeerOrphanSize(NodeId peer) const EXCLUSIVE_LOCKS_REQUIRED(g_cs_orphans);
+
+protected:
+    struct OrphanTx {
+        CTransactionRef tx;
+        NodeId fromPeer;
+        int64_t nTimeExpire;
+        size_t list_pos;
+        size_t peer_list_pos;
+        size_t nTxSize;
+    };
+
+    /** Map from txid to orphan transaction record. Limited by
+     *  -maxorphantxsize/DEFAULT_MAX_ORPHAN_TRANSACTIONS_SIZE */
+    std::unordered_map<uint256, OrphanTx, SaltedTxidHasher> m_orphans GUARDED_BY(g_cs_orphans);
+
+    /** Index from the parents' COutPoint into the m_orphans. Used
+     *  to remove orphan transactions from the m_orphans */
+    std::unordered_map<COutPoint, std::vector<uint256>, SaltedOutpointHasher> m_outpoint_to_orphan GUARDED_BY(g_cs_orphans);
+
+    /** Orphan transactions in vector for quick random eviction */
+    std::vector<uint256> m_orphan_list GUARDED_BY(g_cs_orphans);
+
+    struct PeerOrphans {
+        /** Orphans announced by the peer, for quick per-peer eviction */
+        std::vector<uint256> m_orphan_list;
+        /** Total serialized size of these orphans */
+        size_t m_size{0};
+    };
+    std::unordered_map<NodeId, PeerOrphans> m_peer_orphans GUARDED_BY(g_cs_orphans);
+
+    /** Orphans in the order they expire. Entries of erased orphans are skipped when they come up. */
+    std::deque<std::pair<int64_t, uint256>> m_expiry_queue GUARDED_BY(g_cs_orphans);
+
+    /** Total serialized size of all orphans */
+    size_t m_orphans_size GUARDED_BY(g_cs_orphans){0};
+};
+
+#endif // BITCOIN_TXORPHANAGE_H
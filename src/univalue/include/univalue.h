@@ -12,6 +12,8 @@
 #include <string>
 #include <vector>
 #include <map>
+#include <memory>
+#include <unordered_map>
 #include <cassert>
 
 class UniValue {
@@ -45,6 +47,10 @@ public:
         std::string s(val_);
         setStr(s);
     }
+    UniValue(const UniValue& other);
+    UniValue(UniValue&& other) noexcept = default;
+    UniValue& operator=(const UniValue& other);
+    UniValue& operator=(UniValue&& other) noexcept = default;
 
     void clear();
 
@@ -82,6 +88,7 @@ public:
     bool isObject() const { return (typ == VOBJ); }
 
     bool push_back(const UniValue& val);
+    bool push_back(UniValue&& val);
     bool push_back(const std::string& val_) {
         UniValue tmpVal(VSTR, val_);
         return push_back(tmpVal);
@@ -113,7 +120,9 @@ public:
     bool push_backV(const std::vector<UniValue>& vec);
 
     void __pushKV(const std::string& key, const UniValue& val);
+    void __pushKV(const std::string& key, UniValue&& val);
     bool pushKV(const std::string& key, const UniValue& val);
+    bool pushKV(const std::string& key, UniValue&& val);
     bool pushKV(const std::string& key, const std::string& val_) {
         UniValue tmpVal(VSTR, val_);
         return pushKV(key, tmpVal);
@@ -154,12 +163,19 @@ public:
     }
 
 private:
+    // Objects with at least this many keys keep a hash index of their keys
+    static const size_t KEY_INDEX_MIN_KEYS = 32;
+    typedef std::unordered_map<std::string, size_t> KeyIndex;
+
     UniValue::VType typ;
     std::string val;                       // numbers are stored as C++ strings
     std::vector<std::string> keys;
     std::vector<UniValue> values;
+    std::unique_ptr<KeyIndex> keyIndex;    // first position of each key, only for large objects
 
+    void appendKey(const std::string& key);
     bool findKey(const std::string& key, size_t& retIdx) const;
+    void writeTo(unsigned int prettyIndent, unsigned int indentLevel, std::string& s) const;
     void writeArray(unsigned int prettyIndent, unsigned int indentLevel, std::string& s) const;
     void writeObject(unsigned int prettyIndent, unsigned int indentLevel, std::string& s) const;
 
@@ -12,12 +12,28 @@
 
 const UniValue NullUniValue;
 
+UniValue::UniValue(const UniValue& other) :
+    typ(other.typ), val(other.val), keys(other.keys), values(other.values),
+    keyIndex(other.keyIndex ? new KeyIndex(*other.keyIndex) : nullptr)
+{
+}
+
+UniValue& UniValue::operator=(const UniValue& other)
+{
+    if (this != &other) {
+        UniValue tmp(other);
+        *this = std::move(tmp);
+    }
+    return *this;
+}
+
 void UniValue::clear()
 {
     typ = VNULL;
     val.clear();
     keys.clear();
     values.clear();
+    keyIndex.reset();
 }
 
 bool UniValue::setNull()
@@ -114,6 +130,15 @@ bool UniValue::push_back(const UniValue& val_)
     return true;
 }
 
+bool UniValue::push_back(UniValue&& val_)
+{
+    if (typ != VARR)
+        return false;
+
+    values.push_back(std::move(val_));
+    return true;
+}
+
 bool UniValue::push_backV(const std::vector<UniValue>& vec)
 {
     if (typ != VARR)
@@ -124,12 +149,31 @@ bool UniValue::push_backV(const std::vector<UniValue>& vec)
     return true;
 }
 
-void UniValue::__pushKV(const std::string& key, const UniValue& val_)
+void UniValue::appendKey(const std::string& key)
 {
     keys.push_back(key);
+    if (keyIndex) {
+        keyIndex->emplace(key, keys.size() - 1);
+    } else if (keys.size() >= KEY_INDEX_MIN_KEYS) {
+        keyIndex.reset(new KeyIndex);
+        keyIndex->reserve(keys.size() * 2);
+        for (size_t i = 0; i < keys.size(); i++)
+            keyIndex->emplace(keys[i], i);
+    }
+}
+
+void UniValue::__pushKV(const std::string& key, const UniValue& val_)
+{
+    appendKey(key);
     values.push_back(val_);
 }
 
+void UniValue::__pushKV(const std::string& key, UniValue&& val_)
+{
+    appendKey(key);
+    values.push_back(std::move(val_));
+}
+
 bool UniValue::pushKV(const std::string& key, const UniValue& val_)
 {
     if (typ != VOBJ)
@@ -143,6 +187,19 @@ bool UniValue::pushKV(const std::string& key, const UniValue& val_)
     return true;
 }
 
+bool UniValue::pushKV(const std::string& key, UniValue&& val_)
+{
+    if (typ != VOBJ)
+        return false;
+
+    size_t idx;
+    if (findKey(key, idx))
+        values[idx] = std::move(val_);
+    else
+        __pushKV(key, std::move(val_));
+    return true;
+}
+
 bool UniValue::pushKVs(const UniValue& obj)
 {
     if (typ != VOBJ || obj.typ != VOBJ)
@@ -166,6 +223,14 @@ void UniValue::getObjMap(std::map<std::string,UniValue>& kv) const
 
 bool UniValue::findKey(const std::string& key, size_t& retIdx) const
 {
+    if (keyIndex) {
+        KeyIndex::const_iterator it = keyIndex->find(key);
+        if (it == keyIndex->end())
+            return false;
+        retIdx = it->second;
+        return true;
+    }
+
     for (size_t i = 0; i < keys.size(); i++) {
         if (keys[i] == key) {
             retIdx = i;
@@ -235,10 +300,10 @@ const char *uvTypeName(UniValue::VType t)
 
 const UniValue& find_value(const UniValue& obj, const std::string& name)
 {
-    for (unsigned int i = 0; i < obj.keys.size(); i++)
-        if (obj.keys[i] == name)
-            return obj.values.at(i);
+    size_t index;
+    if (!obj.findKey(name, index))
+        return NullUniValue;
 
-    return NullUniValue;
+    return obj.values.at(index);
 }
 
@@ -41,6 +41,16 @@ public:
                 push_back_u(codepoint);
         }
     }
+    // Write a run of 7-bit ASCII characters
+    void append_ascii(const char *begin, const char *end)
+    {
+        if (state == 0) {
+            str.append(begin, end - begin);
+        } else {
+            for (const char *p = begin; p != end; p++)
+                push_back(static_cast<unsigned char>(*p));
+        }
+    }
     // Write codepoint directly, possibly collating surrogate pairs
     void push_back_u(unsigned int codepoint_)
     {
@@ -7,22 +7,23 @@
 #include "univalue.h"
 #include "univalue_escapes.h"
 
-static std::string json_escape(const std::string& inS)
+// Append inS to outS as a quoted JSON string. Runs of characters which need
+// no escaping are appended at once.
+static void json_escape(const std::string& inS, std::string& outS)
 {
-    std::string outS;
-    outS.reserve(inS.size() * 2);
-
-    for (unsigned int i = 0; i < inS.size(); i++) {
-        unsigned char ch = static_cast<unsigned char>(inS[i]);
-        const char *escStr = escapes[ch];
-
-        if (escStr)
+    outS += '"';
+    const char *run = inS.data();
+    const char *end = inS.data() + inS.size();
+    for (const char *p = run; p != end; p++) {
+        const char *escStr = escapes[static_cast<unsigned char>(*p)];
+        if (escStr) {
+            outS.append(run, p - run);
             outS += escStr;
-        else
-            outS += static_cast<char>(ch);
+            run = p + 1;
+        }
     }
-
-    return outS;
+    outS.append(run, end - run);
+    outS += '"';
 }
 
 std::string UniValue::write(unsigned int prettyIndent,
@@ -35,18 +36,25 @@ std::string UniValue::write(unsigned int prettyIndent,
     if (modIndent == 0)
         modIndent = 1;
 
+    writeTo(prettyIndent, modIndent, s);
+
+    return s;
+}
+
+void UniValue::writeTo(unsigned int prettyIndent, unsigned int indentLevel, std::string& s) const
+{
     switch (typ) {
     case VNULL:
         s += "null";
         break;
     case VOBJ:
-        writeObject(prettyIndent, modIndent, s);
+        writeObject(prettyIndent, indentLevel, s);
         break;
     case VARR:
-        writeArray(prettyIndent, modIndent, s);
+        writeArray(prettyIndent, indentLevel, s);
         break;
     case VSTR:
-        s += "\"" + json_escape(val) + "\"";
+        json_escape(val, s);
         break;
     case VNUM:
         s += val;
@@ -55,8 +63,6 @@ std::string UniValue::write(unsigned int prettyIndent,
         s += (val == "1" ? "true" : "false");
         break;
     }
-
-    return s;
 }
 
 static void indentStr(unsigned int prettyIndent, unsigned int indentLevel, std::string& s)
@@ -73,7 +79,7 @@ void UniValue::writeArray(unsigned int prettyIndent, unsigned int indentLevel, s
     for (unsigned int i = 0; i < values.size(); i++) {
         if (prettyIndent)
             indentStr(prettyIndent, indentLevel, s);
-        s += values[i].write(prettyIndent, indentLevel + 1);
+        values[i].writeTo(prettyIndent, indentLevel + 1, s);
         if (i != (values.size() - 1)) {
             s += ",";
         }
@@ -95,10 +101,11 @@ void UniValue::writeObject(unsigned int prettyIndent, unsigned int indentLevel,
     for (unsigned int i = 0; i < keys.size(); i++) {
         if (prettyIndent)
             indentStr(prettyIndent, indentLevel, s);
-        s += "\"" + json_escape(keys[i]) + "\":";
+        json_escape(keys[i], s);
+        s += ':';
         if (prettyIndent)
             s += " ";
-        s += values.at(i).write(prettyIndent, indentLevel + 1);
+        values.at(i).writeTo(prettyIndent, indentLevel + 1, s);
         if (i != (values.size() - 1))
             s += ",";
         if (prettyIndent)
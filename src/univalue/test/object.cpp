@@ -359,6 +359,52 @@ BOOST_AUTO_TEST_CASE(univalue_object)
 
 }
 
+BOOST_AUTO_TEST_CASE(univalue_large_object)
+{
+    // Enough keys for lookups to go through the key index
+    UniValue obj(UniValue::VOBJ);
+    for (int i = 0; i < 100; i++) {
+        UniValue entry(UniValue::VARR);
+        entry.push_back(i);
+        obj.pushKV("key" + std::to_string(i), std::move(entry));
+    }
+    BOOST_CHECK_EQUAL(obj.size(), 100);
+    BOOST_CHECK_EQUAL(obj["key0"][0].get_int(), 0);
+    BOOST_CHECK_EQUAL(find_value(obj, "key99")[0].get_int(), 99);
+    BOOST_CHECK(!obj.exists("key100"));
+
+    // Replacing a value keeps its position
+    obj.pushKV("key50", "replaced");
+    BOOST_CHECK_EQUAL(obj.size(), 100);
+    BOOST_CHECK_EQUAL(obj.getKeys()[50], "key50");
+    BOOST_CHECK_EQUAL(obj["key50"].get_str(), "replaced");
+
+    // Copies are independent
+    UniValue copy = obj;
+    copy.pushKV("extra", 1);
+    BOOST_CHECK(copy.exists("extra"));
+    BOOST_CHECK(!obj.exists("extra"));
+    BOOST_CHECK_EQUAL(copy["key99"][0].get_int(), 99);
+
+    // Moved-to objects keep their lookups
+    UniValue moved = std::move(copy);
+    BOOST_CHECK_EQUAL(moved["extra"].get_int(), 1);
+
+    // Parsed objects with duplicate keys find the first occurrence, like small ones
+    std::string json = "{";
+    for (int i = 0; i < 100; i++)
+        json += "\"k" + std::to_string(i % 50) + "\":" + std::to_string(i) + ",";
+    json.back() = '}';
+    UniValue parsed;
+    BOOST_CHECK(parsed.read(json));
+    BOOST_CHECK_EQUAL(parsed.size(), 100);
+    BOOST_CHECK_EQUAL(parsed["k10"].get_int(), 10);
+    BOOST_CHECK_EQUAL(parsed.write(), json);
+
+    parsed.setObject();
+    BOOST_CHECK(!parsed.exists("k10"));
+}
+
 static const char *json1 =
 "[1.10000000,{\"key1\":\"str\\u0000\",\"key2\":800,\"key3\":{\"name\":\"martian http://test.com\"}}]";
 
@@ -414,6 +460,7 @@ int main (int argc, char *argv[])
     univalue_set();
     univalue_array();
     univalue_object();
+    univalue_large_object();
     univalue_readwrite();
     return 0;
 }
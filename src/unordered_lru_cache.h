@@ -5,10 +5,19 @@
 #ifndef BITCOIN_UNORDERED_LRU_CACHE_H
 #define BITCOIN_UNORDERED_LRU_CACHE_H
 
+#include <memusage.h>
+#include <sync.h>
+
 #include <algorithm>
+#include <array>
+#include <atomic>
 #include <cassert>
 #include <cstdint>
+#include <map>
+#include <memory>
+#include <string>
 #include <unordered_map>
+#include <utility>
 #include <vector>
 
 template<typename Key, typename Value, typename Hasher, size_t MaxSize = 0, size_t TruncateThreshold = 0>
@@ -32,6 +41,19 @@ public:
     }
 
     size_t max_size() const { return maxSize; }
+    size_t size() const { return cacheMap.size(); }
+
+    /** Memory used by the entries themselves, without what their values point to */
+    size_t DynamicMemoryUsage() const { return memusage::DynamicUsage(cacheMap); }
+
+    /** Calls func(key, value) for every entry without touching their access order */
+    template<typename Callable>
+    void for_each(Callable&& func) const
+    {
+        for (const auto& [key, value] : cacheMap) {
+            func(key, value.first);
+        }
+    }
 
     template<typename Value2>
     void _emplace(const Key& key, Value2&& v)
@@ -101,8 +123,8 @@ private:
         for (auto it = cacheMap.begin(); it != cacheMap.end(); ++it) {
             vec.emplace_back(it);
         }
-        // sort by last access time (descending order)
-        std::sort(vec.begin(), vec.end(), [](const Iterator& it1, const Iterator& it2) {
+        // partition by last access time, the maxSize most recently accessed entries first
+        std::nth_element(vec.begin(), vec.begin() + maxSize, vec.end(), [](const Iterator& it1, const Iterator& it2) {
             return it1->second.second > it2->second.second;
         });
 
@@ -112,4 +134,204 @@ private:
     }
 };
 
+/** Hit, miss and eviction counts of a named sharded_unordered_lru_cache, reported by GetLRUCacheStats() */
+struct LRUCacheStats {
+    std::atomic<uint64_t> hits{0};
+    std::atomic<uint64_t> misses{0};
+    std::atomic<uint64_t> evictions{0};
+};
+
+namespace lru_cache_detail {
+inline Mutex g_stats_mutex;
+inline std::map<std::string, std::shared_ptr<LRUCacheStats>> g_stats GUARDED_BY(g_stats_mutex);
+} // namespace lru_cache_detail
+
+/** Caches registered under the same name share their counters */
+inline std::shared_ptr<LRUCacheStats> RegisterLRUCacheStats(const std::string& name)
+{
+    LOCK(lru_cache_detail::g_stats_mutex);
+    auto& stats = lru_cache_detail::g_stats[name];
+    if (!stats) {
+        stats = std::make_shared<LRUCacheStats>();
+    }
+    return stats;
+}
+
+inline std::vector<std::pair<std::string, std::shared_ptr<const LRUCacheStats>>> GetLRUCacheStats()
+{
+    LOCK(lru_cache_detail::g_stats_mutex);
+    return {lru_cache_detail::g_stats.begin(), lru_cache_detail::g_stats.end()};
+}
+
+/**
+ * Thread-safe variant of unordered_lru_cache, split into Shards independently locked segments so that
+ * concurrent lookups of different keys rarely wait for each other.
+ *
+ * Each segment holds a fixed number of slots and evicts with the CLOCK algorithm: a lookup marks its
+ * slot as referenced, and a full segment advances its hand over the slots, clearing the marks, until it
+ * finds an unreferenced slot to reuse. This approximates LRU without sorting and without growing beyond
+ * the configured size. The size is MaxSize unless given to the constructor.
+ *
+ * Caches constructed with a name count their hits, misses and evictions, see GetLRUCacheStats().
+ */
+template<typename Key, typename Value, typename Hasher, size_t MaxSize = 0, size_t Shards = 16>
+class sharded_unordered_lru_cache
+{
+private:
+    static_assert(Shards > 0);
+
+    struct Slot {
+        Key key;
+        Value value;
+        bool referenced;
+    };
+
+    struct Shard {
+        Mutex cs;
+        std::vector<Slot> slots GUARDED_BY(cs);
+        std::unordered_map<Key, size_t, Hasher> index GUARDED_BY(cs);
+        size_t hand GUARDED_BY(cs) {0};
+    };
+
+    std::array<Shard, Shards> shards;
+    const size_t shardSize;
+    Hasher hasher;
+    const std::shared_ptr<LRUCacheStats> stats;
+
+    Shard& GetShard(const Key& key)
+    {
+        // the low bits also pick the bucket inside the shard, use the upper half of size_t here (shifting a 32 bit
+        // size_t by 32 would be undefined)
+        const uint64_t hash{hasher(key)};
+        return shards[(hash >> (sizeof(size_t) * 4)) % Shards];
+    }
+
+    void Count(std::atomic<uint64_t> LRUCacheStats::*counter)
+    {
+        if (stats) {
+            ((*stats).*counter).fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    template<typename Value2>
+    void _emplace(const Key& key, Value2&& v)
+    {
+        Shard& shard = GetShard(key);
+        LOCK(shard.cs);
+        auto it = shard.index.find(key);
+        if (it != shard.index.end()) {
+            Slot& slot = shard.slots[it->second];
+            slot.value = std::forward<Value2>(v);
+            slot.referenced = true;
+            return;
+        }
+        if (shard.slots.size() < shardSize) {
+            shard.index.emplace(key, shard.slots.size());
+            shard.slots.push_back(Slot{key, std::forward<Value2>(v), false});
+            return;
+        }
+        while (shard.slots[shard.hand].referenced) {
+            shard.slots[shard.hand].referenced = false;
+            shard.hand = (shard.hand + 1) % shard.slots.size();
+        }
+        Slot& slot = shard.slots[shard.hand];
+        shard.index.erase(slot.key);
+        shard.index.emplace(key, shard.hand);
+        slot.key = key;
+        slot.value = std::forward<Value2>(v);
+        shard.hand = (shard.hand + 1) % shard.slots.size();
+        Count(&LRUCacheStats::evictions);
+    }
+
+public:
+    explicit sharded_unordered_lru_cache(const std::string& name = "", size_t maxSize = MaxSize) :
+        shardSize(std::max<size_t>(maxSize / Shards, 1)),
+        stats(name.empty() ? nullptr : RegisterLRUCacheStats(name))
+    {
+        // either specify maxSize through template arguments or the constructor and fail otherwise
+        assert(maxSize != 0);
+        for (Shard& shard : shards) {
+            LOCK(shard.cs);
+            shard.index.reserve(shardSize);
+        }
+    }
+
+    size_t max_size() const { return shardSize * Shards; }
+
+    void emplace(const Key& key, Value&& v)
+    {
+        _emplace(key, std::move(v));
+    }
+
+    void insert(const Key& key, const Value& v)
+    {
+        _emplace(key, v);
+    }
+
+    bool get(const Key& key, Value& value)
+    {
+        Shard& shard = GetShard(key);
+        {
+            LOCK(shard.cs);
+            auto it = shard.index.find(key);
+            if (it != shard.index.end()) {
+                Slot& slot = shard.slots[it->second];
+                slot.referenced = true;
+                value = slot.value;
+                Count(&LRUCacheStats::hits);
+                return true;
+            }
+        }
+        Count(&LRUCacheStats::misses);
+        return false;
+    }
+
+    bool exists(const Key& key)
+    {
+        Shard& shard = GetShard(key);
+        {
+            LOCK(shard.cs);
+            auto it = shard.index.find(key);
+            if (it != shard.index.end()) {
+                shard.slots[it->second].referenced = true;
+                Count(&LRUCacheStats::hits);
+                return true;
+            }
+        }
+        Count(&LRUCacheStats::misses);
+        return false;
+    }
+
+    void erase(const Key& key)
+    {
+        Shard& shard = GetShard(key);
+        LOCK(shard.cs);
+        auto it = shard.index.find(key);
+        if (it == shard.index.end()) {
+            return;
+        }
+        // move the last slot into the hole so the slots stay contiguous
+        const size_t pos = it->second;
+        shard.index.erase(it);
+        if (pos != shard.slots.size() - 1) {
+            shard.slots[pos] = std::move(shard.slots.back());
+            shard.index[shard.slots[pos].key] = pos;
+        }
+        shard.slots.pop_back();
+        if (shard.hand >= shard.slots.size()) {
+            shard.hand = 0;
+        }
+    }
+
+    void clear()
+    {
+        for (Shard& shard : shards) {
+            LOCK(shard.cs);
+            shard.slots.clear();
+            shard.index.clear();
+            shard.hand = 0;
+        }
+    }
+};
+
 #endif // BITCOIN_UNORDERED_LRU_CACHE_H
@@ -7,9 +7,14 @@
 
 #include <util/fastrange.h>
 
+#include <crypto/common.h>
+#include <span.h>
 #include <streams.h>
 
+#include <algorithm>
 #include <cstdint>
+#include <ios>
+#include <vector>
 
 template <typename OStream>
 void GolombRiceEncode(BitStreamWriter<OStream>& bitwriter, uint8_t P, uint64_t x)
@@ -42,4 +47,135 @@ uint64_t GolombRiceDecode(BitStreamReader<IStream>& bitreader, uint8_t P)
     return (q << P) + r;
 }
 
+/**
+ * Golomb-Rice encoder appending to a byte vector through a 64-bit accumulator, which produces
+ * the same bytes as GolombRiceEncode on a BitStreamWriter without going through it bit by bit.
+ */
+class GolombRiceWriter
+{
+private:
+    std::vector<unsigned char>& m_out;
+    const uint8_t m_P;
+    //! Pending bits in the low m_nbits bits, less than 8 between calls
+    uint64_t m_acc{0};
+    int m_nbits{0};
+
+    void WriteBits(uint64_t data, int nbits)
+    {
+        // nbits <= 56, so the accumulator can't overflow
+        m_acc = (m_acc << nbits) | (data & ((uint64_t{1} << nbits) - 1));
+        m_nbits += nbits;
+        while (m_nbits >= 8) {
+            m_nbits -= 8;
+            m_out.push_back(static_cast<unsigned char>(m_acc >> m_nbits));
+        }
+    }
+
+public:
+    GolombRiceWriter(std::vector<unsigned char>& out, uint8_t P) : m_out(out), m_P(P) {}
+
+    void Encode(uint64_t x)
+    {
+        uint64_t q = x >> m_P;
+        while (q > 0) {
+            const int nbits = q <= 56 ? static_cast<int>(q) : 56;
+            WriteBits(~0ULL, nbits);
+            q -= nbits;
+        }
+        WriteBits(0, 1);
+        if (m_P > 56) {
+            WriteBits(x >> 56, m_P - 56);
+            WriteBits(x, 56);
+        } else {
+            WriteBits(x, m_P);
+        }
+    }
+
+    /** Write the remaining bits, padded with zeros to a full byte. */
+    void Flush()
+    {
+        if (m_nbits > 0) {
+            m_out.push_back(static_cast<unsigned char>(m_acc << (8 - m_nbits)));
+            m_nbits = 0;
+        }
+    }
+};
+
+/**
+ * Golomb-Rice decoder reading a byte span 64 bits at a time, counting the unary quotient with
+ * a single bit scan instead of bit by bit like GolombRiceDecode. Throws std::ios_base::failure
+ * when reading past the end of the data.
+ */
+class GolombRiceReader
+{
+private:
+    const Span<const unsigned char> m_data;
+    const uint8_t m_P;
+    //! Position of the next bit, counting from the most significant bit of the first byte
+    uint64_t m_pos{0};
+
+    /** The next bits in the high bits of the result, at least 57 of them unless at the end of the data. */
+    uint64_t Peek() const
+    {
+        const size_t byte = m_pos >> 3;
+        uint64_t word;
+        if (byte + 8 <= m_data.size()) {
+            word = ReadBE64(m_data.data() + byte);
+        } else {
+            word = 0;
+            for (size_t i = 0; byte + i < m_data.size(); ++i) {
+                word |= uint64_t{m_data[byte + i]} << (56 - 8 * i);
+            }
+        }
+        return word << (m_pos & 7);
+    }
+
+    uint64_t Remaining() const { return uint64_t{m_data.size()} * 8 - m_pos; }
+
+    uint64_t ReadBits(int nbits)
+    {
+        if (nbits == 0) return 0;
+        if (Remaining() < uint64_t(nbits)) {
+            throw std::ios_base::failure("GolombRiceReader::ReadBits(): end of data");
+        }
+        const uint64_t ret = Peek() >> (64 - nbits);
+        m_pos += nbits;
+        return ret;
+    }
+
+public:
+    GolombRiceReader(Span<const unsigned char> data, uint8_t P) : m_data(data), m_P(P) {}
+
+    uint64_t Decode()
+    {
+        uint64_t q = 0;
+        while (true) {
+            const uint64_t valid = std::min<uint64_t>(Remaining(), 57);
+            if (valid == 0) {
+                throw std::ios_base::failure("GolombRiceReader::Decode(): end of data");
+            }
+            // Number of leading one bits, the zero ending the quotient must be within the valid bits
+            const uint64_t ones = 64 - CountBits(~Peek());
+            if (ones < valid) {
+                q += ones;
+                m_pos += ones + 1;
+                break;
+            }
+            q += valid;
+            m_pos += valid;
+        }
+        uint64_t r;
+        if (m_P > 56) {
+            r = ReadBits(m_P - 56) << 56;
+            r |= ReadBits(56);
+        } else {
+            r = ReadBits(m_P);
+        }
+        return (q << m_P) + r;
+    }
+
+    /** Number of bytes the decoded values were read from, including a partially read last byte. */
+    size_t BytesRead() const { return (m_pos + 7) >> 3; }
+};
+
 #endif // BITCOIN_UTIL_GOLOMBRICE_H
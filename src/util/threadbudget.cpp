@@ -0,0 +1,29 @@
+// Copyright (c) 2024 The Maximus developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <util/threadbudget.h>
+
+#include <util/system.h>
+
+#include <algorithm>
+#include <atomic>
+
+static std::atomic<int> g_thread_budget{DEFAULT_WORKER_THREADS};
+
+void SetThreadBudget(int threads)
+{
+    g_thread_budget = threads;
+}
+
+int GetThreadBudget(TaskPriority priority, int max_threads)
+{
+    int budget = g_thread_budget.load();
+    if (budget <= 0) budget = GetNumCores();
+    switch (priority) {
+    case TaskPriority::CONSENSUS: break;
+    case TaskPriority::LLMQ: budget /= 2; break;
+    case TaskPriority::BACKGROUND: budget /= 4; break;
+    }
+    return std::clamp(budget, 1, std::max(max_threads, 1));
+}
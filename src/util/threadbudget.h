@@ -0,0 +1,31 @@
+// Copyright (c) 2024 The Maximus developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_UTIL_THREADBUDGET_H
+#define BITCOIN_UTIL_THREADBUDGET_H
+
+/** Classes of work done on worker pools, a pool's share of the thread budget depends on its class */
+enum class TaskPriority {
+    //! Validation work which holds back the chain tip
+    CONSENSUS,
+    //! Latency sensitive LLMQ work: signing sessions, DKG contributions and quorum data
+    LLMQ,
+    //! Work which only makes later operations faster
+    BACKGROUND,
+};
+
+/** Default for -workerthreads, 0 = the number of cores */
+static constexpr int DEFAULT_WORKER_THREADS{0};
+
+/** Set the number of threads worker pools are sized from, <= 0 for the number of cores */
+void SetThreadBudget(int threads);
+
+/**
+ * Number of threads a worker pool of the given class should run: the whole budget for CONSENSUS, half of it for LLMQ
+ * and a quarter for BACKGROUND, but at least 1 and at most max_threads. This keeps the pools of the lower classes
+ * small on machines with few cores, where they would otherwise compete with validation for them.
+ */
+int GetThreadBudget(TaskPriority priority, int max_threads);
+
+#endif // BITCOIN_UTIL_THREADBUDGET_H
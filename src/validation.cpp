@@ -16,15 +16,21 @@
 #include <consensus/tx_check.h>
 #include <consensus/tx_verify.h>
 #include <consensus/validation.h>
+#include <crypto/common.h>
+#include <ctpl_stl.h>
 #include <cuckoocache.h>
 #include <deploymentstatus.h>
 #include <flatfile.h>
 #include <hash.h>
+#include <index/addressindex.h>
 #include <index/blockfilterindex.h>
 #include <logging.h>
 #include <logging/timer.h>
+#include <node/blockindexsnapshot.h>
 #include <node/blockstorage.h>
+#include <node/coinsprefetcher.h>
 #include <node/coinstats.h>
+#include <node/speculativecheck.h>
 #include <node/ui_interface.h>
 #include <policy/policy.h>
 #include <policy/settings.h>
@@ -48,6 +54,7 @@
 #include <util/strencodings.h>
 #include <util/translation.h>
 #include <util/system.h>
+#include <util/trace.h>
 #include <validationinterface.h>
 #include <warnings.h>
 
@@ -66,7 +73,9 @@
 
 #include <statsd_client.h>
 
+#include <algorithm>
 #include <deque>
+#include <future>
 #include <numeric>
 #include <optional>
 #include <string>
@@ -215,6 +224,7 @@ CBlockIndex* BlockManager::FindForkInGlobalIndex(const CChain& chain, const CBlo
 std::unique_ptr<CBlockTreeDB> pblocktree;
 
 bool CheckInputScripts(const CTransaction& tx, TxValidationState &state, const CCoinsViewCache &inputs, unsigned int flags, bool cacheSigStore, bool cacheFullScriptStore, PrecomputedTransactionData& txdata, std::vector<CScriptCheck> *pvChecks = nullptr);
+static CCheckQueue<CScriptCheck> scriptcheckqueue(128);
 static FILE* OpenUndoFile(const FlatFilePos &pos, bool fReadOnly = false);
 static FlatFileSeq BlockFileSeq();
 static FlatFileSeq UndoFileSeq();
@@ -552,6 +562,12 @@ public:
          */
         std::vector<COutPoint>& m_coins_to_uncache;
         const bool m_test_accept;
+        /*
+         * Whether the fee rate requirements are checked against the whole package
+         * instead of every transaction on its own, so that a child can pay for its
+         * low-fee parents.
+         */
+        const bool m_package_feerates;
     };
 
     // Single transaction acceptance
@@ -560,10 +576,23 @@ public:
     /**
     * Multiple transaction acceptance. Transactions may or may not be interdependent,
     * but must not conflict with each other. Parents must come before children if any
-    * dependencies exist.
+    * dependencies exist. Unless test accepting, either all transactions are added to
+    * the mempool or none is (apart from the ones size limiting evicts afterwards).
     */
     PackageMempoolAcceptResult AcceptMultipleTransactions(const std::vector<CTransactionRef>& txns, ATMPArgs& args) EXCLUSIVE_LOCKS_REQUIRED(cs_main);
 
+    /**
+    * Batch acceptance of transactions which neither spend nor conflict with each other,
+    * with one ATMPArgs per transaction. The scripts of the whole batch are verified on the
+    * script check worker threads and the accepted transactions are added under a single
+    * hold of the mempool lock. The result of a transaction is left empty when it can't be
+    * judged along with the batch (it depends on or conflicts with another one of it, or an
+    * earlier one used up the package limits it needed); such a transaction is to be run
+    * through AcceptSingleTransaction afterwards.
+    */
+    void AcceptTransactionBatch(const std::vector<CTransactionRef>& txns, std::vector<ATMPArgs>& args,
+                                std::vector<std::optional<MempoolAcceptResult>>& results) EXCLUSIVE_LOCKS_REQUIRED(cs_main);
+
 private:
     // All the intermediate state that gets passed between the various levels
     // of checking a given transaction.
@@ -598,8 +627,9 @@ private:
 
     // Try to add the transaction to the mempool, removing any conflicts first.
     // Returns true if the transaction is in the mempool after any size
-    // limiting is performed, false otherwise.
-    bool Finalize(const ATMPArgs& args, Workspace& ws) EXCLUSIVE_LOCKS_REQUIRED(cs_main, m_pool.cs);
+    // limiting is performed, false otherwise. With limit_size false the caller
+    // is left to limit the mempool size.
+    bool Finalize(const ATMPArgs& args, Workspace& ws, bool limit_size = true) EXCLUSIVE_LOCKS_REQUIRED(cs_main, m_pool.cs);
 
     // Compare a package's feerate against minimum allowed.
     bool CheckFeeRate(size_t package_size, CAmount package_fee, TxValidationState& state) EXCLUSIVE_LOCKS_REQUIRED(cs_main, m_pool.cs)
@@ -801,7 +831,7 @@ bool MemPoolAccept::PreChecks(ATMPArgs& args, Workspace& ws)
     // Checking of fee for MNHF_SIGNAL should be skipped: mnhf does not have
     // inputs, outputs, or fee
     if (tx.nVersion != 3 || tx.nType != TRANSACTION_MNHF_SIGNAL) {
-        if (!bypass_limits && !CheckFeeRate(nSize, nModifiedFees, state)) return false;
+        if (!bypass_limits && !args.m_package_feerates && !CheckFeeRate(nSize, nModifiedFees, state)) return false;
     }
 
     // Calculate in-mempool ancestors, up to a limit.
@@ -889,7 +919,7 @@ bool MemPoolAccept::ConsensusScriptChecks(const ATMPArgs& args, Workspace& ws, P
     return true;
 }
 
-bool MemPoolAccept::Finalize(const ATMPArgs& args, Workspace& ws)
+bool MemPoolAccept::Finalize(const ATMPArgs& args, Workspace& ws, bool limit_size)
 {
     const CTransaction& tx = *ws.m_ptx;
     const uint256& hash = ws.m_hash;
@@ -929,7 +959,7 @@ bool MemPoolAccept::Finalize(const ATMPArgs& args, Workspace& ws)
         m_pool.addSpentIndex(*entry, m_view);
     }
 
-    if (!bypass_limits) {
+    if (!bypass_limits && limit_size) {
         assert(std::addressof(::ChainstateActive().CoinsTip()) == std::addressof(m_active_chainstate.CoinsTip()));
         LimitMempoolSize(m_pool, m_active_chainstate.CoinsTip(), gArgs.GetArg("-maxmempool", DEFAULT_MAX_MEMPOOL_SIZE) * 1000000, std::chrono::hours{gArgs.GetArg("-mempoolexpiry", DEFAULT_MEMPOOL_EXPIRY)});
         if (!m_pool.exists(hash))
@@ -1006,9 +1036,52 @@ PackageMempoolAcceptResult MemPoolAccept::AcceptMultipleTransactions(const std::
         m_viewmempool.PackageAddTransaction(ws.m_ptx);
     }
 
+    if (args.m_package_feerates) {
+        // The package as a whole has to meet the fee rate requirements, no matter how the fees
+        // are spread over its transactions.
+        size_t package_size{0};
+        CAmount package_fee{0};
+        for (const Workspace& ws : workspaces) {
+            package_size += ws.m_entry->GetTxSize();
+            package_fee += ws.m_modified_fees;
+        }
+        TxValidationState package_fee_state;
+        if (!args.m_bypass_limits && !CheckFeeRate(package_size, package_fee, package_fee_state)) {
+            package_state.Invalid(PackageValidationResult::PCKG_POLICY, "package-fee-too-low", package_fee_state.GetDebugMessage());
+            return PackageMempoolAcceptResult(package_state, std::move(results));
+        }
+    }
+
+    if (!args.m_test_accept) {
+        // PreChecks only saw the in-mempool ancestors of each transaction. Check the limits as if
+        // every transaction of the package had all of them and the whole package as ancestors, so
+        // that adding the package below can't fail half way.
+        CTxMemPool::setEntries mempool_ancestors;
+        size_t package_size{0};
+        for (const Workspace& ws : workspaces) {
+            mempool_ancestors.insert(ws.m_ancestors.cbegin(), ws.m_ancestors.cend());
+            package_size += ws.m_entry->GetTxSize();
+        }
+        size_t ancestors_size{package_size};
+        bool within_limits = mempool_ancestors.size() + workspaces.size() <= m_limit_ancestors;
+        for (const CTxMemPool::txiter& ancestor : mempool_ancestors) {
+            ancestors_size += ancestor->GetTxSize();
+            within_limits = within_limits &&
+                            ancestor->GetCountWithDescendants() + workspaces.size() <= m_limit_descendants &&
+                            ancestor->GetSizeWithDescendants() + package_size <= m_limit_descendant_size;
+        }
+        if (!within_limits || ancestors_size > m_limit_ancestor_size) {
+            package_state.Invalid(PackageValidationResult::PCKG_POLICY, "package-mempool-limits");
+            return PackageMempoolAcceptResult(package_state, std::move(results));
+        }
+    }
+
+    std::vector<PrecomputedTransactionData> txdata;
+    txdata.reserve(workspaces.size());
     for (Workspace& ws : workspaces) {
-        PrecomputedTransactionData txdata;
-        if (!PolicyScriptChecks(args, ws, txdata)) {
+        txdata.emplace_back(*ws.m_ptx);
+        if (!PolicyScriptChecks(args, ws, txdata.back()) ||
+            (!args.m_test_accept && !ConsensusScriptChecks(args, ws, txdata.back()))) {
             // Exit early to avoid doing pointless work. Update the failed tx result; the rest are unfinished.
             package_state.Invalid(PackageValidationResult::PCKG_TX, "transaction failed");
             results.emplace(ws.m_ptx -> GetHash(), MempoolAcceptResult::Failure(ws.m_state));
@@ -1021,10 +1094,141 @@ PackageMempoolAcceptResult MemPoolAccept::AcceptMultipleTransactions(const std::
                             MempoolAcceptResult::Success(ws.m_base_fees));
         }
     }
+    if (args.m_test_accept) return PackageMempoolAcceptResult(package_state, std::move(results));
+
+    for (size_t i = 0; i < workspaces.size(); ++i) {
+        Workspace& ws = workspaces[i];
+        if (i > 0) {
+            // The transactions of the package added so far may be ancestors of this one
+            ws.m_ancestors.clear();
+            std::string dummy;
+            const bool ancestors_ok = m_pool.CalculateMemPoolAncestors(*ws.m_entry, ws.m_ancestors, m_limit_ancestors, m_limit_ancestor_size, m_limit_descendants, m_limit_descendant_size, dummy);
+            // Implied by the package limits checked above
+            Assume(ancestors_ok);
+        }
+        Finalize(args, ws, /* limit_size = */ false);
+    }
+
+    if (!args.m_bypass_limits) {
+        assert(std::addressof(::ChainstateActive().CoinsTip()) == std::addressof(m_active_chainstate.CoinsTip()));
+        LimitMempoolSize(m_pool, m_active_chainstate.CoinsTip(), gArgs.GetArg("-maxmempool", DEFAULT_MAX_MEMPOOL_SIZE) * 1000000, std::chrono::hours{gArgs.GetArg("-mempoolexpiry", DEFAULT_MEMPOOL_EXPIRY)});
+    }
+    for (Workspace& ws : workspaces) {
+        if (!m_pool.exists(ws.m_hash)) {
+            ws.m_state.Invalid(TxValidationResult::TX_MEMPOOL_POLICY, "mempool full");
+            if (package_state.IsValid()) package_state.Invalid(PackageValidationResult::PCKG_TX, "transaction failed");
+            results.emplace(ws.m_hash, MempoolAcceptResult::Failure(ws.m_state));
+            continue;
+        }
+        GetMainSignals().TransactionAddedToMempool(ws.m_ptx, args.m_accept_time);
+        statsClient.inc("transactions.accepted", 1.0f);
+        statsClient.count("transactions.inputs", ws.m_ptx->vin.size(), 1.0f);
+        statsClient.count("transactions.outputs", ws.m_ptx->vout.size(), 1.0f);
+        results.emplace(ws.m_hash, MempoolAcceptResult::Success(ws.m_base_fees));
+    }
 
     return PackageMempoolAcceptResult(package_state, std::move(results));
 }
 
+void MemPoolAccept::AcceptTransactionBatch(const std::vector<CTransactionRef>& txns, std::vector<ATMPArgs>& args,
+                                           std::vector<std::optional<MempoolAcceptResult>>& results)
+{
+    AssertLockHeld(cs_main);
+    assert(txns.size() == args.size() && txns.size() == results.size());
+    LOCK(m_pool.cs);
+
+    // Transactions spending an output of the batch, or an outpoint an earlier one of the
+    // batch spends too, can only be judged once the others are in the mempool. So are the
+    // ones PreChecks would make remove conflicts, which might be ancestors of others.
+    std::set<uint256> batch_txids;
+    for (const CTransactionRef& ptx : txns) {
+        batch_txids.insert(ptx->GetHash());
+    }
+    std::set<COutPoint> batch_spent;
+    std::vector<Workspace> workspaces;
+    std::vector<size_t> positions;
+    workspaces.reserve(txns.size());
+    for (size_t i = 0; i < txns.size(); ++i) {
+        const CTransaction& tx = *txns[i];
+        bool related = llmq::quorumInstantSendManager->IsWaitingForTx(tx.GetHash());
+        for (const CTxIn& txin : tx.vin) {
+            // Insert every outpoint, so that a later spender is left over as well
+            if (!batch_spent.insert(txin.prevout).second || batch_txids.count(txin.prevout.hash)) {
+                related = true;
+            }
+        }
+        if (related) continue;
+
+        Workspace ws(txns[i]);
+        // All the coins of the batch are pulled into m_view here, before any script is run
+        if (!PreChecks(args[i], ws)) {
+            results[i].emplace(MempoolAcceptResult::Failure(ws.m_state));
+            continue;
+        }
+        workspaces.push_back(std::move(ws));
+        positions.push_back(i);
+    }
+
+    // Run the scripts of the whole batch on the worker threads first. Valid signatures land
+    // in the signature cache, so the per-transaction checks below mostly hit the cache; they
+    // are what attributes any failure to its transaction.
+    std::vector<PrecomputedTransactionData> txdata(workspaces.size());
+    if (g_parallel_script_checks) {
+        std::vector<CScriptCheck> checks;
+        for (size_t k = 0; k < workspaces.size(); ++k) {
+            TxValidationState state_dummy;
+            CheckInputScripts(*workspaces[k].m_ptx, state_dummy, m_view, STANDARD_SCRIPT_VERIFY_FLAGS, /* cacheSigStore = */ true, /* cacheFullScriptStore = */ false, txdata[k], &checks);
+        }
+        if (checks.size() > 1) {
+            CCheckQueueControl<CScriptCheck> control(&scriptcheckqueue);
+            control.Add(checks);
+            control.Wait();
+        }
+    }
+
+    std::vector<size_t> added;
+    for (size_t k = 0; k < workspaces.size(); ++k) {
+        Workspace& ws = workspaces[k];
+        const size_t i = positions[k];
+        if (!PolicyScriptChecks(args[i], ws, txdata[k]) || !ConsensusScriptChecks(args[i], ws, txdata[k])) {
+            results[i].emplace(MempoolAcceptResult::Failure(ws.m_state));
+            continue;
+        }
+        if (!added.empty()) {
+            // Earlier transactions of the batch may share in-mempool ancestors with this one
+            ws.m_ancestors.clear();
+            std::string dummy;
+            if (!m_pool.CalculateMemPoolAncestors(*ws.m_entry, ws.m_ancestors, m_limit_ancestors, m_limit_ancestor_size, m_limit_descendants, m_limit_descendant_size, dummy)) {
+                continue;
+            }
+        }
+        if (!Finalize(args[i], ws, /* limit_size = */ false)) {
+            results[i].emplace(MempoolAcceptResult::Failure(ws.m_state));
+            continue;
+        }
+        added.push_back(k);
+    }
+
+    if (!added.empty() && !args[positions[added.front()]].m_bypass_limits) {
+        assert(std::addressof(::ChainstateActive().CoinsTip()) == std::addressof(m_active_chainstate.CoinsTip()));
+        LimitMempoolSize(m_pool, m_active_chainstate.CoinsTip(), gArgs.GetArg("-maxmempool", DEFAULT_MAX_MEMPOOL_SIZE) * 1000000, std::chrono::hours{gArgs.GetArg("-mempoolexpiry", DEFAULT_MEMPOOL_EXPIRY)});
+    }
+    for (size_t k : added) {
+        Workspace& ws = workspaces[k];
+        const size_t i = positions[k];
+        if (!m_pool.exists(ws.m_hash)) {
+            ws.m_state.Invalid(TxValidationResult::TX_MEMPOOL_POLICY, "mempool full");
+            results[i].emplace(MempoolAcceptResult::Failure(ws.m_state));
+            continue;
+        }
+        GetMainSignals().TransactionAddedToMempool(ws.m_ptx, args[i].m_accept_time);
+        statsClient.inc("transactions.accepted", 1.0f);
+        statsClient.count("transactions.inputs", ws.m_ptx->vin.size(), 1.0f);
+        statsClient.count("transactions.outputs", ws.m_ptx->vout.size(), 1.0f);
+        results[i].emplace(MempoolAcceptResult::Success(ws.m_base_fees));
+    }
+}
+
 } // anon namespace
 
 /** (try to) add transaction to memory pool with a specified acceptance time **/
@@ -1034,7 +1238,7 @@ static MempoolAcceptResult AcceptToMemoryPoolWithTime(const CChainParams& chainp
                                                       EXCLUSIVE_LOCKS_REQUIRED(cs_main)
 {
     std::vector<COutPoint> coins_to_uncache;
-    MemPoolAccept::ATMPArgs args { chainparams, nAcceptTime, bypass_limits, coins_to_uncache, test_accept };
+    MemPoolAccept::ATMPArgs args { chainparams, nAcceptTime, bypass_limits, coins_to_uncache, test_accept, /* package_feerates */ false };
 
     assert(std::addressof(::ChainstateActive()) == std::addressof(active_chainstate));
     const MempoolAcceptResult result = MemPoolAccept(pool, active_chainstate).AcceptSingleTransaction(tx, args);
@@ -1063,33 +1267,95 @@ MempoolAcceptResult AcceptToMemoryPool(CChainState& active_chainstate, CTxMemPoo
     return AcceptToMemoryPoolWithTime(Params(), pool, active_chainstate, tx, GetTime(), bypass_limits, test_accept);
 }
 
+/** Number of transactions read from mempool.dat before they are accepted as one batch */
+static constexpr size_t MEMPOOL_LOAD_BATCH_SIZE = 100;
+
+/** (try to) add a batch of transactions to memory pool, each with its own acceptance time **/
+static std::vector<MempoolAcceptResult> AcceptToMemoryPoolBatchWithTime(const CChainParams& chainparams, CTxMemPool& pool, CChainState& active_chainstate,
+                                                                        const std::vector<CTransactionRef>& txns, const std::vector<int64_t>& accept_times,
+                                                                        bool bypass_limits)
+                                                                        EXCLUSIVE_LOCKS_REQUIRED(cs_main)
+{
+    assert(txns.size() == accept_times.size());
+    std::vector<std::vector<COutPoint>> coins_to_uncache(txns.size());
+    std::vector<MemPoolAccept::ATMPArgs> args;
+    args.reserve(txns.size());
+    for (size_t i = 0; i < txns.size(); ++i) {
+        args.push_back(MemPoolAccept::ATMPArgs{ chainparams, accept_times[i], bypass_limits, coins_to_uncache[i], /* test_accept */ false, /* package_feerates */ false });
+    }
+
+    assert(std::addressof(::ChainstateActive()) == std::addressof(active_chainstate));
+    std::vector<MempoolAcceptResult> results;
+    results.reserve(txns.size());
+    {
+        // Held throughout, so that mempool readers see the batch added all at once
+        LOCK(pool.cs);
+        std::vector<std::optional<MempoolAcceptResult>> batch_results(txns.size());
+        MemPoolAccept(pool, active_chainstate).AcceptTransactionBatch(txns, args, batch_results);
+
+        for (size_t i = 0; i < txns.size(); ++i) {
+            if (batch_results[i]) {
+                results.push_back(*batch_results[i]);
+            } else {
+                // Left over by the batch; taken in order, so it is judged after the ones before it
+                results.push_back(MemPoolAccept(pool, active_chainstate).AcceptSingleTransaction(txns[i], args[i]));
+            }
+            if (results.back().m_result_type != MempoolAcceptResult::ResultType::VALID) {
+                LogPrint(BCLog::MEMPOOL, "%s: %s %s (%s)\n", __func__, txns[i]->GetHash().ToString(), results.back().m_state.GetRejectReason(), results.back().m_state.GetDebugMessage());
+                // See AcceptToMemoryPoolWithTime()
+                for (const COutPoint& hashTx : coins_to_uncache[i])
+                    active_chainstate.CoinsTip().Uncache(hashTx);
+            }
+        }
+    }
+    // After we've (potentially) uncached entries, ensure our coins cache is still within its size limits
+    BlockValidationState state_dummy;
+    active_chainstate.FlushStateToDisk(state_dummy, FlushStateMode::PERIODIC);
+    return results;
+}
+
+std::vector<MempoolAcceptResult> AcceptToMemoryPoolBatch(CChainState& active_chainstate, CTxMemPool& pool,
+                                                         const std::vector<CTransactionRef>& txns, bool bypass_limits)
+{
+    assert(std::addressof(::ChainstateActive()) == std::addressof(active_chainstate));
+    return AcceptToMemoryPoolBatchWithTime(Params(), pool, active_chainstate, txns, std::vector<int64_t>(txns.size(), GetTime()), bypass_limits);
+}
+
 PackageMempoolAcceptResult ProcessNewPackage(CChainState& active_chainstate, CTxMemPool& pool,
                                              const Package& package, bool test_accept)
 {
     AssertLockHeld(cs_main);
-    assert(test_accept); // Only allow package accept dry-runs (testmempoolaccept RPC).
     assert(!package.empty());
     assert(std::all_of(package.cbegin(), package.cend(), [](const auto& tx){return tx != nullptr;}));
 
     std::vector<COutPoint> coins_to_uncache;
     const CChainParams& chainparams = Params();
-    MemPoolAccept::ATMPArgs args { chainparams, GetTime(), /* bypass_limits */ false, coins_to_uncache, test_accept };
+    // The package fee rate is only evaluated when submitting; the testmempoolaccept RPC judges
+    // every transaction of the package on its own as before.
+    MemPoolAccept::ATMPArgs args { chainparams, GetTime(), /* bypass_limits */ false, coins_to_uncache, test_accept, /* package_feerates */ !test_accept };
     assert(std::addressof(::ChainstateActive()) == std::addressof(active_chainstate));
     const PackageMempoolAcceptResult result = MemPoolAccept(pool, active_chainstate).AcceptMultipleTransactions(package, args);
 
     // Uncache coins pertaining to transactions that were not submitted to the mempool.
-    for (const COutPoint& hashTx : coins_to_uncache) {
-        active_chainstate.CoinsTip().Uncache(hashTx);
+    if (test_accept || result.m_state.IsInvalid()) {
+        for (const COutPoint& hashTx : coins_to_uncache) {
+            active_chainstate.CoinsTip().Uncache(hashTx);
+        }
+    }
+    if (!test_accept) {
+        // After we've (potentially) uncached entries, ensure our coins cache is still within its size limits
+        BlockValidationState state_dummy;
+        active_chainstate.FlushStateToDisk(state_dummy, FlushStateMode::PERIODIC);
     }
     return result;
 }
 
 bool GetTimestampIndex(const unsigned int &high, const unsigned int &low, std::vector<uint256> &hashes)
 {
-    if (!fTimestampIndex)
+    if (!fTimestampIndex || !g_address_index)
         return error("Timestamp index not enabled");
 
-    if (!pblocktree->ReadTimestampIndex(high, low, hashes))
+    if (!g_address_index->ReadTimestampIndex(high, low, hashes))
         return error("Unable to get hashes for timestamps");
 
     return true;
@@ -1103,31 +1369,56 @@ bool GetSpentIndex(CTxMemPool& mempool, CSpentIndexKey &key, CSpentIndexValue &v
     if (mempool.getSpentIndex(key, value))
         return true;
 
-    if (!pblocktree->ReadSpentIndex(key, value))
+    if (!g_address_index || !g_address_index->ReadSpentIndex(key, value))
         return false;
 
     return true;
 }
 
-bool GetAddressIndex(uint160 addressHash, AddressType type,
-                     std::vector<std::pair<CAddressIndexKey, CAmount> > &addressIndex, int start, int end)
+bool GetSpentIndexes(CTxMemPool& mempool, const std::vector<CSpentIndexKey>& keys, CSpentIndexTxInfo& info)
+{
+    if (!fSpentIndex)
+        return false;
+
+    std::vector<CSpentIndexKey> missing;
+    mempool.getSpentIndexes(keys, info, missing);
+
+    if (missing.empty())
+        return true;
+
+    return g_address_index && g_address_index->ReadSpentIndexes(missing, info);
+}
+
+bool ScanAddressIndex(uint160 addressHash, AddressType type, int start, int end, const CAddressIndexKey* from,
+                      const std::function<bool(const CAddressIndexKey&, CAmount)>& fn)
 {
-    if (!fAddressIndex)
+    if (!fAddressIndex || !g_address_index)
         return error("address index not enabled");
 
-    if (!pblocktree->ReadAddressIndex(addressHash, type, addressIndex, start, end))
+    if (!g_address_index->ScanAddressIndex(addressHash, type, start, end, from, fn))
         return error("unable to get txids for address");
 
     return true;
 }
 
+bool GetAddressBalance(uint160 addressHash, AddressType type, CAddressBalanceValue& value)
+{
+    if (!fAddressIndex || !g_address_index)
+        return error("address index not enabled");
+
+    if (!g_address_index->ReadAddressBalance(addressHash, type, value))
+        return error("unable to get balance for address");
+
+    return true;
+}
+
 bool GetAddressUnspent(uint160 addressHash, AddressType type,
                        std::vector<std::pair<CAddressUnspentKey, CAddressUnspentValue> > &unspentOutputs)
 {
-    if (!fAddressIndex)
+    if (!fAddressIndex || !g_address_index)
         return error("address index not enabled");
 
-    if (!pblocktree->ReadAddressUnspentIndex(addressHash, type, unspentOutputs))
+    if (!g_address_index->ReadAddressUnspentIndex(addressHash, type, unspentOutputs))
         return error("unable to get txids for address");
 
     return true;
@@ -1677,10 +1968,6 @@ DisconnectResult CChainState::DisconnectBlock(const CBlock& block, const CBlockI
         return DISCONNECT_FAILED;
     }
 
-    std::vector<std::pair<CAddressIndexKey, CAmount> > addressIndex;
-    std::vector<std::pair<CAddressUnspentKey, CAddressUnspentValue> > addressUnspentIndex;
-    std::vector<std::pair<CSpentIndexKey, CSpentIndexValue> > spentIndex;
-
     std::optional<MNListUpdates> mnlist_updates_opt{std::nullopt};
     if (!UndoSpecialTxsInBlock(block, pindex, m_mnhfManager, *m_quorum_block_processor, mnlist_updates_opt)) {
         error("DisconnectBlock(): UndoSpecialTxsInBlock failed");
@@ -1693,25 +1980,6 @@ DisconnectResult CChainState::DisconnectBlock(const CBlock& block, const CBlockI
         uint256 hash = tx.GetHash();
         bool is_coinbase = tx.IsCoinBase();
 
-        if (fAddressIndex) {
-            for (unsigned int k = tx.vout.size(); k-- > 0;) {
-                const CTxOut &out = tx.vout[k];
-
-                AddressType address_type{AddressType::UNKNOWN};
-                uint160 address_bytes;
-
-                if (!AddressBytesFromScript(out.scriptPubKey, address_type, address_bytes)) {
-                    continue;
-                }
-
-                // undo receiving activity
-                addressIndex.push_back(std::make_pair(CAddressIndexKey(address_type, address_bytes, pindex->nHeight, i, hash, k, false), out.nValue));
-
-                // undo unspent index
-                addressUnspentIndex.push_back(std::make_pair(CAddressUnspentKey(address_type, address_bytes, hash, k), CAddressUnspentValue()));
-            }
-        }
-
         // Check that all outputs are available and match the outputs in the block itself
         // exactly.
         for (size_t o = 0; o < tx.vout.size(); o++) {
@@ -1734,66 +2002,14 @@ DisconnectResult CChainState::DisconnectBlock(const CBlock& block, const CBlockI
             }
             for (unsigned int j = tx.vin.size(); j-- > 0;) {
                 const COutPoint &out = tx.vin[j].prevout;
-                int undoHeight = txundo.vprevout[j].nHeight;
                 int res = ApplyTxInUndo(std::move(txundo.vprevout[j]), view, out);
                 if (res == DISCONNECT_FAILED) return DISCONNECT_FAILED;
                 fClean = fClean && res != DISCONNECT_UNCLEAN;
-
-                const CTxIn input = tx.vin[j];
-
-                if (fSpentIndex) {
-                    // undo and delete the spent index
-                    spentIndex.push_back(std::make_pair(CSpentIndexKey(input.prevout.hash, input.prevout.n), CSpentIndexValue()));
-                }
-
-                if (fAddressIndex) {
-                    const Coin &coin = view.AccessCoin(tx.vin[j].prevout);
-                    const CTxOut &prevout = coin.out;
-
-                    AddressType address_type{AddressType::UNKNOWN};
-                    uint160 address_bytes;
-
-                    if (!AddressBytesFromScript(prevout.scriptPubKey, address_type, address_bytes)) {
-                        continue;
-                    }
-
-                    // undo spending activity
-                    addressIndex.push_back(std::make_pair(CAddressIndexKey(address_type, address_bytes, pindex->nHeight, i, hash, j, true), prevout.nValue * -1));
-
-                    // restore unspent index
-                    addressUnspentIndex.push_back(std::make_pair(CAddressUnspentKey(address_type, address_bytes, input.prevout.hash, input.prevout.n), CAddressUnspentValue(prevout.nValue, prevout.scriptPubKey, undoHeight)));
-                }
             }
             // At this point, all of txundo.vprevout should have been moved out.
         }
     }
 
-
-    if (fSpentIndex) {
-        if (!pblocktree->UpdateSpentIndex(spentIndex)) {
-            AbortNode("Failed to delete spent index");
-            return DISCONNECT_FAILED;
-        }
-    }
-
-    if (fAddressIndex) {
-        if (!pblocktree->EraseAddressIndex(addressIndex)) {
-            AbortNode("Failed to delete address index");
-            return DISCONNECT_FAILED;
-        }
-        if (!pblocktree->UpdateAddressUnspentIndex(addressUnspentIndex)) {
-            AbortNode("Failed to write address unspent index");
-            return DISCONNECT_FAILED;
-        }
-    }
-
-    if (fTimestampIndex) {
-        if (!pblocktree->EraseTimestampIndex(CTimestampIndexKey(pindex->nTime, pindex->GetBlockHash()))) {
-            AbortNode("Failed to delete timestamp index");
-            return DISCONNECT_FAILED;
-        }
-    }
-
     // move best block pointer to prevout block
     view.SetBestBlock(pindex->pprev->GetBlockHash());
     m_evoDb.WriteBestBlock(pindex->pprev->GetBlockHash());
@@ -1860,16 +2076,121 @@ static bool WriteUndoDataForBlock(const CBlockUndo& blockundo, BlockValidationSt
     return true;
 }
 
-static CCheckQueue<CScriptCheck> scriptcheckqueue(128);
+/**
+ * Closure representing the proof-of-work check of a contiguous run of headers.
+ * The X11 hashes of the run are computed with the batched engine and written
+ * to the caller-provided output slots.
+ */
+class CHeaderPoWCheck
+{
+private:
+    const CBlockHeader* m_headers{nullptr};
+    uint256* m_hashes{nullptr};
+    size_t m_count{0};
+    const Consensus::Params* m_params{nullptr};
+
+public:
+    CHeaderPoWCheck() = default;
+    CHeaderPoWCheck(const CBlockHeader* headers, uint256* hashes, size_t count, const Consensus::Params& params) :
+        m_headers(headers), m_hashes(hashes), m_count(count), m_params(&params) {}
+
+    bool operator()()
+    {
+        const std::vector<uint256> hashes = CPureBlockHeader::GetPoWHashes(m_headers, m_count);
+        for (size_t i = 0; i < m_count; ++i) {
+            m_hashes[i] = hashes[i];
+            if (!CheckProofOfWork(m_headers[i], hashes[i], *m_params)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    void swap(CHeaderPoWCheck& check)
+    {
+        std::swap(m_headers, check.m_headers);
+        std::swap(m_hashes, check.m_hashes);
+        std::swap(m_count, check.m_count);
+        std::swap(m_params, check.m_params);
+    }
+};
+
+/** Number of headers hashed by a single CHeaderPoWCheck */
+static constexpr size_t HEADER_POW_CHECK_CHUNK = 64;
+
+static CCheckQueue<CHeaderPoWCheck> headerpowcheckqueue(1);
+
+/** Reads the coins spent by received blocks ahead of their ConnectBlock() */
+static CoinsPrefetcher g_coins_prefetcher;
+
+/** Verifies the scripts of blocks competing with the tip, see ProcessNewBlock() */
+static SpeculativeBlockChecker g_speculative_checker;
 
 void StartScriptCheckWorkerThreads(int threads_num)
 {
     scriptcheckqueue.StartWorkerThreads(threads_num);
+    headerpowcheckqueue.StartWorkerThreads(threads_num, "headerpow");
+    StartSpecialTxCheckWorkerThreads(threads_num);
+    g_coins_prefetcher.Start(threads_num);
+    if (gArgs.GetBoolArg("-speculativechecks", DEFAULT_SPECULATIVE_CHECKS)) {
+        g_speculative_checker.Start(1);
+    }
 }
 
 void StopScriptCheckWorkerThreads()
 {
     scriptcheckqueue.StopWorkerThreads();
+    headerpowcheckqueue.StopWorkerThreads();
+    StopSpecialTxCheckWorkerThreads();
+    g_coins_prefetcher.Stop();
+    g_speculative_checker.Stop();
+}
+
+bool CheckHeadersProofOfWork(const std::vector<CBlockHeader>& headers, std::vector<uint256>& pow_hashes, const Consensus::Params& params)
+{
+    pow_hashes.assign(headers.size(), uint256());
+
+    std::vector<CHeaderPoWCheck> checks;
+    for (size_t i = 0; i < headers.size(); i += HEADER_POW_CHECK_CHUNK) {
+        const size_t count = std::min(HEADER_POW_CHECK_CHUNK, headers.size() - i);
+        checks.emplace_back(headers.data() + i, pow_hashes.data() + i, count, params);
+    }
+
+    if (!g_parallel_script_checks || checks.size() < 2) {
+        for (CHeaderPoWCheck& check : checks) {
+            if (!check()) return false;
+        }
+        return true;
+    }
+
+    CCheckQueueControl<CHeaderPoWCheck> control(&headerpowcheckqueue);
+    control.Add(checks);
+    return control.Wait();
+}
+
+bool CheckTransactionScripts(const CTransaction& tx, std::vector<CTxOut>&& spent_outputs, unsigned int flags)
+{
+    if (spent_outputs.size() != tx.vin.size()) return false;
+
+    PrecomputedTransactionData txdata;
+    txdata.Init(tx, std::move(spent_outputs));
+
+    std::vector<CScriptCheck> checks;
+    checks.reserve(tx.vin.size());
+    for (unsigned int i = 0; i < tx.vin.size(); i++) {
+        checks.emplace_back(txdata.m_spent_outputs[i], tx, i, flags, /* cacheIn */ true, &txdata);
+    }
+
+    if (!g_parallel_script_checks || checks.size() < 2) {
+        for (CScriptCheck& check : checks) {
+            if (!check()) return false;
+        }
+        return true;
+    }
+
+    CCheckQueueControl<CScriptCheck> control(&scriptcheckqueue);
+    control.Add(checks);
+    return control.Wait();
 }
 
 bool GetBlockHash(uint256& hashRet, int nBlockHeight)
@@ -1960,11 +2281,12 @@ static int64_t nTimePayeeValid = 0;
 static int64_t nTimeProcessSpecial = 0;
 static int64_t nTimeMaximusSpecific = 0;
 static int64_t nTimeConnect = 0;
-static int64_t nTimeIndexConnect = 0;
-static int64_t nTimeIndexWrite = 0;
 static int64_t nTimeCallbacks = 0;
 static int64_t nTimeTotal = 0;
 static int64_t nBlocksTotal = 0;
+// PoW and context-free checks also run outside cs_main (headers, PreCheckBlock)
+static std::atomic<int64_t> nTimePoW{0};
+static std::atomic<int64_t> nTimeCheckBlock{0};
 
 /** Apply the effects of this block (with given index) on the UTXO set represented by coins.
  *  Validity checks that depend on the UTXO set are also done; ConnectBlock()
@@ -2142,9 +2464,6 @@ bool CChainState::ConnectBlock(const CBlock& block, BlockValidationState& state,
     int nInputs = 0;
     unsigned int nSigOps = 0;
     blockundo.vtxundo.reserve(block.vtx.size() - 1);
-    std::vector<std::pair<CAddressIndexKey, CAmount> > addressIndex;
-    std::vector<std::pair<CAddressUnspentKey, CAddressUnspentValue> > addressUnspentIndex;
-    std::vector<std::pair<CSpentIndexKey, CSpentIndexValue> > spentIndex;
 
     bool fDIP0001Active_context = pindex->nHeight >= Params().GetConsensus().DIP0001Height;
 
@@ -2158,12 +2477,9 @@ bool CChainState::ConnectBlock(const CBlock& block, BlockValidationState& state,
     int64_t nTime2_1 = GetTimeMicros(); nTimeProcessSpecial += nTime2_1 - nTime2;
     LogPrint(BCLog::BENCHMARK, "      - ProcessSpecialTxsInBlock: %.2fms [%.2fs (%.2fms/blk)]\n", MILLI * (nTime2_1 - nTime2), nTimeProcessSpecial * MICRO, nTimeProcessSpecial * MILLI / nBlocksTotal);
 
-    int64_t nTime2_index = 0;
-
     for (unsigned int i = 0; i < block.vtx.size(); i++)
     {
         const CTransaction &tx = *(block.vtx[i]);
-        const uint256 txhash = tx.GetHash();
 
         nInputs += tx.vin.size();
 
@@ -2195,37 +2511,6 @@ bool CChainState::ConnectBlock(const CBlock& block, BlockValidationState& state,
                 LogPrintf("ERROR: %s: contains a non-BIP68-final transaction\n", __func__);
                 return state.Invalid(BlockValidationResult::BLOCK_CONSENSUS, "bad-txns-nonfinal");
             }
-
-            if (fAddressIndex || fSpentIndex)
-            {
-                int64_t nTime2_index1 = GetTimeMicros();
-
-                for (size_t j = 0; j < tx.vin.size(); j++) {
-                    const CTxIn input = tx.vin[j];
-                    const Coin& coin = view.AccessCoin(tx.vin[j].prevout);
-                    const CTxOut &prevout = coin.out;
-
-                    AddressType address_type{AddressType::UNKNOWN};
-                    uint160 address_bytes;
-
-                    AddressBytesFromScript(prevout.scriptPubKey, address_type, address_bytes);
-
-                    if (fAddressIndex && address_type != AddressType::UNKNOWN) {
-                        // record spending activity
-                        addressIndex.push_back(std::make_pair(CAddressIndexKey(address_type, address_bytes, pindex->nHeight, i, txhash, j, true), prevout.nValue * -1));
-
-                        // remove address from unspent index
-                        addressUnspentIndex.push_back(std::make_pair(CAddressUnspentKey(address_type, address_bytes, input.prevout.hash, input.prevout.n), CAddressUnspentValue()));
-                    }
-
-                    if (fSpentIndex) {
-                        // add the spent index to determine the txid and input that spent an output
-                        // and to find the amount and address from an input
-                        spentIndex.push_back(std::make_pair(CSpentIndexKey(input.prevout.hash, input.prevout.n), CSpentIndexValue(txhash, j, pindex->nHeight, prevout.nValue, address_type, address_bytes)));
-                    }
-                }
-                nTime2_index += GetTimeMicros() - nTime2_index1;
-            }
         }
 
         // GetTransactionSigOpCount counts 2 types of sigops:
@@ -2254,27 +2539,6 @@ bool CChainState::ConnectBlock(const CBlock& block, BlockValidationState& state,
             control.Add(vChecks);
         }
 
-        if (fAddressIndex) {
-            int64_t nTime2_index2 = GetTimeMicros();
-            for (unsigned int k = 0; k < tx.vout.size(); k++) {
-                const CTxOut &out = tx.vout[k];
-
-                AddressType address_type{AddressType::UNKNOWN};
-                uint160 address_bytes;
-
-                if (!AddressBytesFromScript(out.scriptPubKey, address_type, address_bytes)) {
-                    continue;
-                }
-
-                // record receiving activity
-                addressIndex.push_back(std::make_pair(CAddressIndexKey(address_type, address_bytes, pindex->nHeight, i, txhash, k, false), out.nValue));
-
-                // record unspent output
-                addressUnspentIndex.push_back(std::make_pair(CAddressUnspentKey(address_type, address_bytes, txhash, k), CAddressUnspentValue(out.nValue, out.scriptPubKey, pindex->nHeight)));
-            }
-            nTime2_index += GetTimeMicros() - nTime2_index2;
-        }
-
         CTxUndo undoDummy;
         if (i > 0) {
             blockundo.vtxundo.push_back(CTxUndo());
@@ -2282,8 +2546,6 @@ bool CChainState::ConnectBlock(const CBlock& block, BlockValidationState& state,
         UpdateCoins(tx, view, i == 0 ? undoDummy : blockundo.vtxundo.back(), pindex->nHeight);
     }
 
-    nTimeIndexConnect += nTime2_index;
-    LogPrint(BCLog::BENCHMARK, "        - Connect index: %.2fms [%.2fs (%.2fms/blk)]\n", MILLI * nTime2_index, nTimeIndexConnect * MICRO, nTimeIndexConnect * MILLI / nBlocksTotal);
     int64_t nTime3 = GetTimeMicros(); nTimeConnect += nTime3 - nTime2;
     LogPrint(BCLog::BENCHMARK, "      - Connect %u transactions: %.2fms (%.3fms/tx, %.3fms/txin) [%.2fs (%.2fms/blk)]\n", (unsigned)block.vtx.size(), MILLI * (nTime3 - nTime2), MILLI * (nTime3 - nTime2) / block.vtx.size(), nInputs <= 1 ? 0 : MILLI * (nTime3 - nTime2) / (nInputs-1), nTimeConnect * MICRO, nTimeConnect * MILLI / nBlocksTotal);
 
@@ -2382,29 +2644,6 @@ bool CChainState::ConnectBlock(const CBlock& block, BlockValidationState& state,
         setDirtyBlockIndex.insert(pindex);
     }
 
-    int64_t nTime6 = GetTimeMicros();
-
-    if (fAddressIndex) {
-        if (!pblocktree->WriteAddressIndex(addressIndex)) {
-            return AbortNode(state, "Failed to write address index");
-        }
-
-        if (!pblocktree->UpdateAddressUnspentIndex(addressUnspentIndex)) {
-            return AbortNode(state, "Failed to write address unspent index");
-        }
-    }
-
-    if (fSpentIndex)
-        if (!pblocktree->UpdateSpentIndex(spentIndex))
-            return AbortNode(state, "Failed to write transaction index");
-
-    if (fTimestampIndex)
-        if (!pblocktree->WriteTimestampIndex(CTimestampIndexKey(pindex->nTime, pindex->GetBlockHash())))
-            return AbortNode(state, "Failed to write timestamp index");
-
-    int64_t nTime7 = GetTimeMicros(); nTimeIndexWrite += nTime7 - nTime6;
-    LogPrint(BCLog::BENCHMARK, "      - Index writing: %.2fms [%.2fs (%.2fms/blk)]\n", MILLI * (nTime7 - nTime6), nTimeIndexWrite * MICRO, nTimeIndexWrite * MILLI / nBlocksTotal);
-
     assert(pindex->phashBlock);
     // add this block to the view's block chain
     view.SetBestBlock(pindex->GetBlockHash());
@@ -2419,6 +2658,18 @@ bool CChainState::ConnectBlock(const CBlock& block, BlockValidationState& state,
     int64_t nTime8 = GetTimeMicros(); nTimeCallbacks += nTime8 - nTime5;
     LogPrint(BCLog::BENCHMARK, "    - Callbacks: %.2fms [%.2fs (%.2fms/blk)]\n", MILLI * (nTime8 - nTime5), nTimeCallbacks * MICRO, nTimeCallbacks * MILLI / nBlocksTotal);
 
+    TRACE9(validation, block_connected,
+        pindex->phashBlock->data(),
+        pindex->nHeight,
+        block.vtx.size(),
+        nInputs,
+        nSigOps,
+        nTime3 - nTime2, // inputs, UpdateCoins and special transactions
+        nTime4 - nTime3, // waiting for script checks
+        nTime5 - nTime4, // maximus specific checks
+        nTime8 - nTimeStart
+    );
+
     statsClient.timing("ConnectBlock_ms", (nTime8 - nTimeStart) / 1000, 1.0f);
     statsClient.gauge("blocks.tip.SizeBytes", ::GetSerializeSize(block, PROTOCOL_VERSION), 1.0f);
     statsClient.gauge("blocks.tip.Height", m_chain.Height(), 1.0f);
@@ -2525,7 +2776,7 @@ bool CChainState::FlushStateToDisk(
         // The cache is over the limit, we have to write now.
         bool fCacheCritical = mode == FlushStateMode::IF_NEEDED && cache_state >= CoinsCacheSizeState::CRITICAL;
         // The evodb cache is too large
-        bool fEvoDbCacheCritical = mode == FlushStateMode::IF_NEEDED && m_evoDb.GetMemoryUsage() >= (64 << 20);
+        bool fEvoDbCacheCritical = mode == FlushStateMode::IF_NEEDED && m_evoDb.IsFlushNeeded(IsInitialBlockDownload());
         // It's been a while since we wrote the block index to disk. Do this frequently, so we don't need to redownload after a crash.
         bool fPeriodicWrite = mode == FlushStateMode::PERIODIC && nNow > nLastWrite + DATABASE_WRITE_INTERVAL;
         // It's been very long since we flushed the cache. Do this infrequently, to optimize cache usage.
@@ -2576,6 +2827,7 @@ bool CChainState::FlushStateToDisk(
         }
         // Flush best chain related state. This can only be done if the blocks / block index write was also done.
         if (fDoFullFlush && !CoinsTip().GetBestBlock().IsNull()) {
+            [[maybe_unused]] const int64_t nFlushStart = GetTimeMicros();
             {
                 LOG_TIME_SECONDS(strprintf("write coins cache to disk (%d coins, %.2fkB)",
                     coins_count, coins_mem_usage / 1000));
@@ -2589,9 +2841,29 @@ bool CChainState::FlushStateToDisk(
                     return AbortNode(state, "Disk space is too low!", _("Disk space is too low!"));
                 }
                 // Flush the chainstate (which may refer to block index entries).
-                if (!CoinsTip().Flush())
-                    return AbortNode(state, "Failed to write to coin database");
+                // Only an explicit flush (shutdown, cache resize, RPC) empties the
+                // cache. Otherwise it keeps its coins so block validation doesn't
+                // have to read them back from disk, unless memory ran short, in
+                // which case only the recently used half of the budget survives.
+                if (mode == FlushStateMode::ALWAYS) {
+                    if (!CoinsTip().Flush())
+                        return AbortNode(state, "Failed to write to coin database");
+                } else {
+                    if (!CoinsTip().Sync())
+                        return AbortNode(state, "Failed to write to coin database");
+                    if (fCacheLarge || fCacheCritical) {
+                        const size_t nKept = CoinsTip().EvictCold(m_coinstip_cache_size_bytes / 2);
+                        LogPrint(BCLog::COINDB, "Kept %d of %d coins in the cache after flush\n", nKept, coins_count);
+                    }
+                }
             }
+            TRACE5(utxocache, flush,
+                GetTimeMicros() - nFlushStart,
+                static_cast<uint32_t>(mode),
+                coins_count,
+                coins_mem_usage,
+                fFlushForPrune
+            );
             {
                 LOG_TIME_SECONDS("write evodb cache to disk");
                 if (!m_evoDb.CommitRootTransaction()) {
@@ -2753,11 +3025,32 @@ bool CChainState::DisconnectTip(BlockValidationState& state, DisconnectedBlockTr
 }
 
 static int64_t nTimeReadFromDisk = 0;
+static int64_t nTimePrefetch = 0;
 static int64_t nTimeConnectTotal = 0;
 static int64_t nTimeFlush = 0;
+static int64_t nTimeEvoCommit = 0;
 static int64_t nTimeChainState = 0;
 static int64_t nTimePostConnect = 0;
 
+BlockValidationTimings GetBlockValidationTimings()
+{
+    LOCK(cs_main);
+    BlockValidationTimings timings;
+    timings.blocks = nBlocksTotal;
+    timings.pow = nTimePoW;
+    timings.check_block = nTimeCheckBlock;
+    timings.prefetch = nTimePrefetch;
+    timings.connect_inputs = nTimeConnect - nTimeProcessSpecial;
+    timings.script_checks = nTimeVerify - nTimeConnect;
+    timings.special_txes = nTimeProcessSpecial;
+    timings.maximus_specific = nTimeMaximusSpecific;
+    timings.coins_flush = nTimeFlush - nTimeEvoCommit;
+    timings.evo_commit = nTimeEvoCommit;
+    timings.chainstate_flush = nTimeChainState;
+    timings.total = nTimeTotal;
+    return timings;
+}
+
 struct PerBlockConnectTrace {
     CBlockIndex* pindex = nullptr;
     std::shared_ptr<const CBlock> pblock;
@@ -2830,6 +3123,8 @@ bool CChainState::ConnectTip(BlockValidationState& state, CBlockIndex* pindexNew
     {
         auto dbTx = m_evoDb.BeginTransaction();
 
+        g_coins_prefetcher.Apply(pindexNew->GetBlockHash(), CoinsTip(), CoinsDB());
+        nTimePrefetch += GetTimeMicros() - nTime2;
         CCoinsViewCache view(&CoinsTip());
         bool rv = ConnectBlock(blockConnecting, state, pindexNew, view);
         GetMainSignals().BlockChecked(blockConnecting, state);
@@ -2843,7 +3138,9 @@ bool CChainState::ConnectTip(BlockValidationState& state, CBlockIndex* pindexNew
         LogPrint(BCLog::BENCHMARK, "  - Connect total: %.2fms [%.2fs (%.2fms/blk)]\n", (nTime3 - nTime2) * MILLI, nTimeConnectTotal * MICRO, nTimeConnectTotal * MILLI / nBlocksTotal);
         bool flushed = view.Flush();
         assert(flushed);
+        int64_t nTime3_1 = GetTimeMicros();
         dbTx->Commit();
+        nTimeEvoCommit += GetTimeMicros() - nTime3_1;
     }
     int64_t nTime4 = GetTimeMicros(); nTimeFlush += nTime4 - nTime3;
     LogPrint(BCLog::BENCHMARK, "  - Flush: %.2fms [%.2fs (%.2fms/blk)]\n", (nTime4 - nTime3) * MILLI, nTimeFlush * MICRO, nTimeFlush * MILLI / nBlocksTotal);
@@ -3706,6 +4003,11 @@ static bool FindUndoPos(BlockValidationState &state, int nFile, FlatFilePos &pos
 }
 
 bool CheckProofOfWork(const CBlockHeader& block, const Consensus::Params& params)
+{
+    return CheckProofOfWork(block, GetPoWHashCached(block), params);
+}
+
+bool CheckProofOfWork(const CBlockHeader& block, const uint256& pow_hash, const Consensus::Params& params)
 {
     /* Except for legacy blocks with full version 1, ensure that
        the chain ID is correct.  Legacy blocks are not allowed since
@@ -3723,7 +4025,7 @@ bool CheckProofOfWork(const CBlockHeader& block, const Consensus::Params& params
             return error("%s : no auxpow on block with auxpow version",
                          __func__);
 
-        if (!CheckProofOfWork(block.GetPoWHash(), block.nBits, params))
+        if (!CheckProofOfWork(pow_hash, block.nBits, params))
             return error("%s : non-AUX proof of work failed", __func__);
 
         return true;
@@ -3733,9 +4035,9 @@ bool CheckProofOfWork(const CBlockHeader& block, const Consensus::Params& params
     if (!block.IsAuxpow())
         return error("%s : auxpow on block with non-auxpow version", __func__);
 
-    if (!block.auxpow->check(block.GetHash(), block.GetChainId(), params))
+    if (!block.auxpow->check(pow_hash, block.GetChainId(), params))
         return error("%s : AUX POW is not valid", __func__);
-    if (!CheckProofOfWork(block.auxpow->getParentBlockPoWHash(), block.nBits, params))
+    if (!CheckProofOfWork(GetPoWHashCached(block.auxpow->getParentBlock()), block.nBits, params))
         return error("%s : AUX proof of work failed", __func__);
 
     return true;
@@ -3744,8 +4046,13 @@ bool CheckProofOfWork(const CBlockHeader& block, const Consensus::Params& params
 static bool CheckBlockHeader(const CBlockHeader& block, BlockValidationState& state, const Consensus::Params& consensusParams, bool fCheckPOW = true)
 {
     // Check proof of work matches claimed amount
-    if (fCheckPOW && !CheckProofOfWork(block, consensusParams))
-        return state.Invalid(BlockValidationResult::BLOCK_INVALID_HEADER, "high-hash", "proof of work failed");
+    if (fCheckPOW) {
+        int64_t nTimeStart = GetTimeMicros();
+        bool fPoWValid = CheckProofOfWork(block, consensusParams);
+        nTimePoW += GetTimeMicros() - nTimeStart;
+        if (!fPoWValid)
+            return state.Invalid(BlockValidationResult::BLOCK_INVALID_HEADER, "high-hash", "proof of work failed");
+    }
 
     
     // Check DevNet
@@ -3759,20 +4066,16 @@ static bool CheckBlockHeader(const CBlockHeader& block, BlockValidationState& st
     return true;
 }
 
-bool CheckBlock(const CBlock& block, BlockValidationState& state, const Consensus::Params& consensusParams, int nHeight, bool fCheckPOW, bool fCheckMerkleRoot)
+/** The part of CheckBlock() which depends on nothing but the block itself */
+static bool CheckBlockContents(const CBlock& block, BlockValidationState& state, const Consensus::Params& consensusParams, bool fCheckPOW, bool fCheckMerkleRoot)
 {
-    // These are checks that are independent of context.
-
-    auto start = Now<SteadyMicroseconds>();
-
-    if (block.fChecked)
-        return true;
-
     // Check that the header is valid (particularly PoW).  This is mostly
     // redundant with the call in AcceptBlockHeader.
     if (!CheckBlockHeader(block, state, consensusParams, fCheckPOW))
         return false;
 
+    int64_t nTimeStart = GetTimeMicros();
+
     // Check the merkle root.
     if (fCheckMerkleRoot) {
         bool mutated;
@@ -3804,7 +4107,6 @@ bool CheckBlock(const CBlock& block, BlockValidationState& state, const Consensu
 
     // Check transactions
     // Must check for duplicate inputs (see CVE-2018-17144)
-    CAmount blockSubsidy = GetBlockSubsidyInner(1, nHeight - 1, consensusParams, false);
     for (const auto& tx : block.vtx) {
         TxValidationState tx_state;
         if (!CheckTransaction(*tx, tx_state)) {
@@ -3814,15 +4116,6 @@ bool CheckBlock(const CBlock& block, BlockValidationState& state, const Consensu
             return state.Invalid(BlockValidationResult::BLOCK_CONSENSUS, tx_state.GetRejectReason(),
                                  strprintf("Transaction check failed (tx hash %s) %s", tx->GetHash().ToString(), tx_state.GetDebugMessage()));
         }
-
-        // Check devfee in coinbase transaction
-        if (tx->IsCoinBase()) {
-            DevfeePayment devfeePayment = Params().GetConsensus().nDevfeePayment;
-            CAmount devfeeReward = devfeePayment.getDevfeePaymentAmount(nHeight - 1, blockSubsidy);
-            int devfeeStartHeight = devfeePayment.getStartBlock();
-            if(nHeight > devfeeStartHeight && devfeeReward && !devfeePayment.IsBlockPayeeValid(*tx, nHeight - 1, blockSubsidy))
-                return state.Invalid(BlockValidationResult::BLOCK_CONSENSUS, "bad-cb-devfee-payment-not-found", "oops");
-        }
     }
 
     unsigned int nSigOps = 0;
@@ -3834,7 +4127,44 @@ bool CheckBlock(const CBlock& block, BlockValidationState& state, const Consensu
     if (nSigOps > MaxBlockSigOps())
         return state.Invalid(BlockValidationResult::BLOCK_CONSENSUS, "bad-blk-sigops", "out-of-bounds SigOpCount");
 
-    if (fCheckPOW && fCheckMerkleRoot)
+    nTimeCheckBlock += GetTimeMicros() - nTimeStart;
+    return true;
+}
+
+bool PreCheckBlock(const CBlock& block, BlockValidationState& state, const Consensus::Params& consensusParams)
+{
+    if (block.fChecked || block.fPreChecked)
+        return true;
+
+    if (!CheckBlockContents(block, state, consensusParams, /*fCheckPOW=*/true, /*fCheckMerkleRoot=*/true))
+        return false;
+
+    block.fPreChecked = true;
+    return true;
+}
+
+bool CheckBlock(const CBlock& block, BlockValidationState& state, const Consensus::Params& consensusParams, int nHeight, bool fCheckPOW, bool fCheckMerkleRoot)
+{
+    // These are checks that are independent of context.
+
+    auto start = Now<SteadyMicroseconds>();
+
+    if (block.fChecked)
+        return true;
+
+    // A successful PreCheckBlock() did all of the context-free checks with PoW and merkle root already
+    if (!block.fPreChecked && !CheckBlockContents(block, state, consensusParams, fCheckPOW, fCheckMerkleRoot))
+        return false;
+
+    // Check devfee in coinbase transaction
+    CAmount blockSubsidy = GetBlockSubsidyInner(1, nHeight - 1, consensusParams, false);
+    DevfeePayment devfeePayment = Params().GetConsensus().nDevfeePayment;
+    CAmount devfeeReward = devfeePayment.getDevfeePaymentAmount(nHeight - 1, blockSubsidy);
+    int devfeeStartHeight = devfeePayment.getStartBlock();
+    if(nHeight > devfeeStartHeight && devfeeReward && !devfeePayment.IsBlockPayeeValid(*block.vtx[0], nHeight - 1, blockSubsidy))
+        return state.Invalid(BlockValidationResult::BLOCK_CONSENSUS, "bad-cb-devfee-payment-not-found", "oops");
+
+    if ((fCheckPOW && fCheckMerkleRoot) || block.fPreChecked)
         block.fChecked = true;
 
     auto finish = Now<SteadyMicroseconds>();
@@ -4001,11 +4331,11 @@ static bool ContextualCheckBlock(const CBlock& block, BlockValidationState& stat
     return true;
 }
 
-bool BlockManager::AcceptBlockHeader(const CBlockHeader& block, BlockValidationState& state, const CChainParams& chainparams, CBlockIndex** ppindex)
+bool BlockManager::AcceptBlockHeader(const CBlockHeader& block, BlockValidationState& state, const CChainParams& chainparams, CBlockIndex** ppindex, const uint256* pow_checked_hash)
 {
     AssertLockHeld(cs_main);
     // Check for duplicate
-    uint256 hash = block.GetHash();
+    uint256 hash = pow_checked_hash ? *pow_checked_hash : GetPoWHashCached(block);
     BlockMap::iterator miSelf = m_block_index.find(hash);
     CBlockIndex *pindex = nullptr;
 
@@ -4027,7 +4357,7 @@ bool BlockManager::AcceptBlockHeader(const CBlockHeader& block, BlockValidationS
             return true;
         }
 
-        if (!CheckBlockHeader(block, state, chainparams.GetConsensus())) {
+        if (!CheckBlockHeader(block, state, chainparams.GetConsensus(), /*fCheckPOW=*/pow_checked_hash == nullptr)) {
             LogPrint(BCLog::VALIDATION, "%s: Consensus::CheckBlockHeader: %s, %s\n", __func__, hash.ToString(), state.ToString());
             return false;
         }
@@ -4116,16 +4446,17 @@ bool BlockManager::AcceptBlockHeader(const CBlockHeader& block, BlockValidationS
 }
 
 // Exposed wrapper for AcceptBlockHeader
-bool ChainstateManager::ProcessNewBlockHeaders(const std::vector<CBlockHeader>& headers, BlockValidationState& state, const CChainParams& chainparams, const CBlockIndex** ppindex)
+bool ChainstateManager::ProcessNewBlockHeaders(const std::vector<CBlockHeader>& headers, BlockValidationState& state, const CChainParams& chainparams, const CBlockIndex** ppindex, const std::vector<uint256>* pow_checked_hashes)
 {
     assert(std::addressof(::ChainstateActive()) == std::addressof(ActiveChainstate()));
+    assert(pow_checked_hashes == nullptr || pow_checked_hashes->size() == headers.size());
     AssertLockNotHeld(cs_main);
     {
         LOCK(cs_main);
-        for (const CBlockHeader& header : headers) {
+        for (size_t i = 0; i < headers.size(); ++i) {
             CBlockIndex *pindex = nullptr; // Use a temp pindex instead of ppindex to avoid a const_cast
             bool accepted = m_blockman.AcceptBlockHeader(
-                header, state, chainparams, &pindex);
+                headers[i], state, chainparams, &pindex, pow_checked_hashes ? &(*pow_checked_hashes)[i] : nullptr);
             ActiveChainstate().CheckBlockIndex();
 
             if (!accepted) {
@@ -4244,8 +4575,8 @@ bool ChainstateManager::ProcessNewBlock(const CChainParams& chainparams, const s
     AssertLockNotHeld(cs_main);
     assert(std::addressof(::ChainstateActive()) == std::addressof(ActiveChainstate()));
 
+    CBlockIndex *pindex = nullptr;
     {
-        CBlockIndex *pindex = nullptr;
         if (fNewBlock) *fNewBlock = false;
         BlockValidationState state;
 
@@ -4268,6 +4599,10 @@ bool ChainstateManager::ProcessNewBlock(const CChainParams& chainparams, const s
             GetMainSignals().BlockChecked(*pblock, state);
             return error("%s: AcceptBlock FAILED: %s", __func__, state.ToString());
         }
+        if (pindex && pindex->nHeight > ChainActive().Height() && pindex->nHeight <= ChainActive().Height() + (int)MAX_COINS_PREFETCH_BLOCKS) {
+            // Start reading the coins the block spends, while the blocks before it are connected
+            g_coins_prefetcher.Prefetch(*pblock, ActiveChainstate().CoinsTip(), ActiveChainstate().CoinsDB());
+        }
     }
 
     NotifyHeaderTip(ActiveChainstate());
@@ -4276,6 +4611,17 @@ bool ChainstateManager::ProcessNewBlock(const CChainParams& chainparams, const s
     if (!ActiveChainstate().ActivateBestChain(state, pblock))
         return error("%s: ActivateBestChain failed: %s", __func__, state.ToString());
 
+    if (pindex) {
+        // A block which did not become the tip but competes with it may still win, verify its scripts meanwhile so
+        // that a reorg to it finds them in the signature cache
+        LOCK(cs_main);
+        const CBlockIndex* tip = ChainActive().Tip();
+        if (tip && pindex != tip && pindex->pprev == tip->pprev && (pindex->nStatus & BLOCK_HAVE_DATA) &&
+            !(pindex->nStatus & BLOCK_FAILED_MASK) && !ActiveChainstate().IsInitialBlockDownload()) {
+            g_speculative_checker.Check(pblock, GetBlockScriptFlags(pindex, chainparams.GetConsensus()), ActiveChainstate().CoinsTip());
+        }
+    }
+
     LogPrintf("%s : ACCEPTED\n", __func__);
     return true;
 }
@@ -4389,6 +4735,7 @@ void UnlinkPrunedFiles(const std::set<int>& setFilesToPrune)
 {
     for (std::set<int>::iterator it = setFilesToPrune.begin(); it != setFilesToPrune.end(); ++it) {
         FlatFilePos pos(*it, 0);
+        EraseBlockReadCache(*it);
         fs::remove(BlockFileSeq().FileName(pos));
         fs::remove(UndoFileSeq().FileName(pos));
         LogPrintf("Prune: %s deleted blk/rev (%05u)\n", __func__, *it);
@@ -4501,6 +4848,10 @@ FILE* OpenBlockFile(const FlatFilePos &pos, bool fReadOnly) {
     return BlockFileSeq().Open(pos, fReadOnly);
 }
 
+std::shared_ptr<const MappedFlatFile> MapBlockFile(const FlatFilePos &pos) {
+    return BlockFileSeq().Map(pos);
+}
+
 /** Open an undo file (rev?????.dat) */
 static FILE* OpenUndoFile(const FlatFilePos &pos, bool fReadOnly) {
     return UndoFileSeq().Open(pos, fReadOnly);
@@ -4536,28 +4887,36 @@ bool BlockManager::LoadBlockIndex(
     CBlockTreeDB& blocktree,
     std::set<CBlockIndex*, CBlockIndexWorkComparator>& block_index_candidates)
 {
-    if (!blocktree.LoadBlockIndexGuts(consensus_params, [this](const uint256& hash) EXCLUSIVE_LOCKS_REQUIRED(cs_main) { return this->InsertBlockIndex(hash); }))
-        return false;
-
-    // Calculate nChainWork
+    // The snapshot comes sorted and with nChainWork
     std::vector<std::pair<int, CBlockIndex*> > vSortedByHeight;
-    vSortedByHeight.reserve(m_block_index.size());
-    for (const std::pair<const uint256, CBlockIndex*>& item : m_block_index)
-    {
-        CBlockIndex* pindex = item.second;
-        vSortedByHeight.push_back(std::make_pair(pindex->nHeight, pindex));
+    const bool fFromSnapshot = LoadBlockIndexSnapshot(blocktree, vSortedByHeight);
+    if (!fFromSnapshot) {
+        if (!blocktree.LoadBlockIndexGuts(consensus_params, [this](const uint256& hash) EXCLUSIVE_LOCKS_REQUIRED(cs_main) { return this->InsertBlockIndex(hash); }))
+            return false;
+
+        vSortedByHeight.reserve(m_block_index.size());
+        for (const std::pair<const uint256, CBlockIndex*>& item : m_block_index) {
+            vSortedByHeight.push_back(std::make_pair(item.second->nHeight, item.second));
+        }
+        sort(vSortedByHeight.begin(), vSortedByHeight.end());
+    }
 
-        // build m_blockman.m_prev_block_index
+    // build m_blockman.m_prev_block_index
+    for (const std::pair<const uint256, CBlockIndex*>& item : m_block_index) {
+        CBlockIndex* pindex = item.second;
         if (pindex->pprev) {
             m_prev_block_index.emplace(pindex->pprev->GetBlockHash(), pindex);
         }
     }
-    sort(vSortedByHeight.begin(), vSortedByHeight.end());
+
+    // Calculate nChainWork
     for (const std::pair<int, CBlockIndex*>& item : vSortedByHeight)
     {
         if (ShutdownRequested()) return false;
         CBlockIndex* pindex = item.second;
-        pindex->nChainWork = (pindex->pprev ? pindex->pprev->nChainWork : 0) + GetBlockProof(*pindex);
+        if (!fFromSnapshot) {
+            pindex->nChainWork = (pindex->pprev ? pindex->pprev->nChainWork : 0) + GetBlockProof(*pindex);
+        }
         pindex->nTimeMax = (pindex->pprev ? std::max(pindex->pprev->nTimeMax, pindex->nTime) : pindex->nTime);
         // We can link the chain of blocks for which we've received transactions at some point.
         // Pruned nodes may have deleted the block.
@@ -4591,6 +4950,64 @@ bool BlockManager::LoadBlockIndex(
     return true;
 }
 
+bool BlockManager::LoadBlockIndexSnapshot(CBlockTreeDB& blocktree, std::vector<std::pair<int, CBlockIndex*>>& sorted_by_height)
+{
+    AssertLockHeld(cs_main);
+
+    uint256 marker;
+    if (!m_block_index.empty() || !blocktree.ReadBlockIndexSnapshotMarker(marker)) {
+        return false;
+    }
+    // From here on the block index can be modified, the snapshot is outdated then
+    if (!blocktree.EraseBlockIndexSnapshotMarker()) {
+        return false;
+    }
+
+    int64_t nStart = GetTimeMillis();
+    std::vector<CBlockIndex*> loaded;
+    if (!ReadBlockIndexSnapshot(GetDataDir() / BLOCK_INDEX_SNAPSHOT_FILENAME, marker,
+                                [this](const uint256& hash) EXCLUSIVE_LOCKS_REQUIRED(cs_main) { return this->InsertBlockIndex(hash); },
+                                loaded)) {
+        LogPrintf("%s: can't use the block index snapshot, loading the block index database\n", __func__);
+        Unload();
+        return false;
+    }
+    sorted_by_height.clear();
+    sorted_by_height.reserve(loaded.size());
+    for (CBlockIndex* pindex : loaded) {
+        sorted_by_height.emplace_back(pindex->nHeight, pindex);
+    }
+    LogPrintf("%s: loaded %u block index entries from the snapshot in %dms\n", __func__, loaded.size(), GetTimeMillis() - nStart);
+    return true;
+}
+
+bool BlockManager::WriteBlockIndexSnapshot(CBlockTreeDB& blocktree)
+{
+    AssertLockHeld(cs_main);
+
+    if (!gArgs.GetBoolArg("-blockindexsnapshot", DEFAULT_BLOCK_INDEX_SNAPSHOT) || !setDirtyBlockIndex.empty()) {
+        return false;
+    }
+
+    int64_t nStart = GetTimeMillis();
+    std::vector<const CBlockIndex*> sorted_by_height;
+    sorted_by_height.reserve(m_block_index.size());
+    for (const auto& [hash, pindex] : m_block_index) {
+        sorted_by_height.push_back(pindex);
+    }
+    std::sort(sorted_by_height.begin(), sorted_by_height.end(), [](const CBlockIndex* a, const CBlockIndex* b) {
+        return a->nHeight < b->nHeight;
+    });
+
+    const uint256 marker = GetRandHash();
+    if (!::WriteBlockIndexSnapshot(GetDataDir() / BLOCK_INDEX_SNAPSHOT_FILENAME, sorted_by_height, marker) ||
+        !blocktree.WriteBlockIndexSnapshotMarker(marker)) {
+        return false;
+    }
+    LogPrintf("%s: wrote %u block index entries in %dms\n", __func__, sorted_by_height.size(), GetTimeMillis() - nStart);
+    return true;
+}
+
 void BlockManager::Unload() {
     m_failed_blocks.clear();
     m_blocks_unlinked.clear();
@@ -4656,18 +5073,6 @@ bool CChainState::LoadBlockIndexDB()
     pblocktree->ReadReindexing(fReindexing);
     if(fReindexing) fReindex = true;
 
-    // Check whether we have an address index
-    pblocktree->ReadFlag("addressindex", fAddressIndex);
-    LogPrintf("%s: address index %s\n", __func__, fAddressIndex ? "enabled" : "disabled");
-
-    // Check whether we have a timestamp index
-    pblocktree->ReadFlag("timestampindex", fTimestampIndex);
-    LogPrintf("%s: timestamp index %s\n", __func__, fTimestampIndex ? "enabled" : "disabled");
-
-    // Check whether we have a spent index
-    pblocktree->ReadFlag("spentindex", fSpentIndex);
-    LogPrintf("%s: spent index %s\n", __func__, fSpentIndex ? "enabled" : "disabled");
-
     return true;
 }
 
@@ -4852,62 +5257,8 @@ bool CChainState::RollforwardBlock(const CBlockIndex* pindex, CCoinsViewCache& i
             pindex->GetBlockHash().ToString(), state.ToString());
     }
 
-    std::vector<std::pair<CAddressIndexKey, CAmount> > addressIndex;
-    std::vector<std::pair<CAddressUnspentKey, CAddressUnspentValue> > addressUnspentIndex;
-    std::vector<std::pair<CSpentIndexKey, CSpentIndexValue> > spentIndex;
-
-    for (size_t i = 0; i < block.vtx.size(); i++) {
-        const CTransactionRef& tx = block.vtx[i];
-        const uint256 txhash = tx->GetHash();
-
+    for (const CTransactionRef& tx : block.vtx) {
         if (!tx->IsCoinBase()) {
-            // Update indexes
-            if (fAddressIndex || fSpentIndex) {
-                for (size_t j = 0; j < tx->vin.size(); j++) {
-                    const CTxIn input = tx->vin[j];
-                    const Coin& coin = inputs.AccessCoin(tx->vin[j].prevout);
-                    const CTxOut& prevout = coin.out;
-
-                    AddressType address_type{AddressType::UNKNOWN};
-                    uint160 address_bytes;
-
-                    AddressBytesFromScript(prevout.scriptPubKey, address_type, address_bytes);
-
-                    if (fAddressIndex && address_type != AddressType::UNKNOWN) {
-                        // record spending activity
-                        addressIndex.push_back(std::make_pair(CAddressIndexKey(address_type, address_bytes, pindex->nHeight, i, txhash, j, true), prevout.nValue * -1));
-
-                        // remove address from unspent index
-                        addressUnspentIndex.push_back(std::make_pair(CAddressUnspentKey(address_type, address_bytes, input.prevout.hash, input.prevout.n), CAddressUnspentValue()));
-                    }
-
-                    if (fSpentIndex) {
-                        // add the spent index to determine the txid and input that spent an output
-                        // and to find the amount and address from an input
-                        spentIndex.push_back(std::make_pair(CSpentIndexKey(input.prevout.hash, input.prevout.n), CSpentIndexValue(txhash, j, pindex->nHeight, prevout.nValue, address_type, address_bytes)));
-                    }
-                }
-            }
-
-            if (fAddressIndex) {
-                for (size_t k = 0; k < tx->vout.size(); k++) {
-                    const CTxOut& out = tx->vout[k];
-
-                    AddressType address_type{AddressType::UNKNOWN};
-                    uint160 address_bytes;
-
-                    if (!AddressBytesFromScript(out.scriptPubKey, address_type, address_bytes)) {
-                        continue;
-                    }
-
-                    // record receiving activity
-                    addressIndex.push_back(std::make_pair(CAddressIndexKey(address_type, address_bytes, pindex->nHeight, i, txhash, k, false), out.nValue));
-
-                    // record unspent output
-                    addressUnspentIndex.push_back(std::make_pair(CAddressUnspentKey(address_type, address_bytes, txhash, k), CAddressUnspentValue(out.nValue, out.scriptPubKey, pindex->nHeight)));
-                }
-            }
-
             for (const CTxIn &txin : tx->vin) {
                 inputs.SpendCoin(txin.prevout);
             }
@@ -4916,26 +5267,6 @@ bool CChainState::RollforwardBlock(const CBlockIndex* pindex, CCoinsViewCache& i
         AddCoins(inputs, *tx, pindex->nHeight, true);
     }
 
-    if (fAddressIndex) {
-        if (!pblocktree->WriteAddressIndex(addressIndex)) {
-            return error("RollforwardBlock(MAXIMUS): Failed to write address index");
-        }
-
-        if (!pblocktree->UpdateAddressUnspentIndex(addressUnspentIndex)) {
-            return error("RollforwardBlock(MAXIMUS): Failed to write address unspent index");
-        }
-    }
-
-    if (fSpentIndex) {
-        if (!pblocktree->UpdateSpentIndex(spentIndex))
-            return error("RollforwardBlock(MAXIMUS): Failed to write transaction index");
-    }
-
-    if (fTimestampIndex) {
-        if (!pblocktree->WriteTimestampIndex(CTimestampIndexKey(pindex->nTime, pindex->GetBlockHash())))
-            return error("RollforwardBlock(MAXIMUS): Failed to write timestamp index");
-    }
-
     return true;
 }
 
@@ -5060,18 +5391,6 @@ bool ChainstateManager::LoadBlockIndex()
         // needs_init.
 
         LogPrintf("Initializing databases...\n");
-
-        // Use the provided setting for -addressindex in the new database
-        fAddressIndex = gArgs.GetBoolArg("-addressindex", DEFAULT_ADDRESSINDEX);
-        pblocktree->WriteFlag("addressindex", fAddressIndex);
-
-        // Use the provided setting for -timestampindex in the new database
-        fTimestampIndex = gArgs.GetBoolArg("-timestampindex", DEFAULT_TIMESTAMPINDEX);
-        pblocktree->WriteFlag("timestampindex", fTimestampIndex);
-
-        // Use the provided setting for -spentindex in the new database
-        fSpentIndex = gArgs.GetBoolArg("-spentindex", DEFAULT_SPENTINDEX);
-        pblocktree->WriteFlag("spentindex", fSpentIndex);
     }
     return true;
 }
@@ -5120,10 +5439,86 @@ bool CChainState::LoadGenesisBlock()
     return true;
 }
 
+// Map of disk positions for blocks with unknown parent (only used for reindex)
+static std::multimap<uint256, FlatFilePos> mapBlocksUnknownParent;
+
+bool CChainState::LoadExternalBlock(const std::shared_ptr<CBlock>& pblock, FlatFilePos* dbp, int& nLoaded)
+{
+    const CBlock& block = *pblock;
+    uint256 hash = block.GetHash();
+    {
+        LOCK(cs_main);
+        // detect out of order blocks, and store them for later
+        assert(std::addressof(g_chainman.m_blockman) == std::addressof(m_blockman));
+        if (hash != m_params.GetConsensus().hashGenesisBlock && !m_blockman.LookupBlockIndex(block.hashPrevBlock)) {
+            LogPrint(BCLog::REINDEX, "%s: Out of order block %s, parent %s not known\n", __func__, hash.ToString(),
+                    block.hashPrevBlock.ToString());
+            if (dbp)
+                mapBlocksUnknownParent.insert(std::make_pair(block.hashPrevBlock, *dbp));
+            return true;
+        }
+
+        // process in case the block isn't known yet
+        assert(std::addressof(g_chainman.m_blockman) == std::addressof(m_blockman));
+        CBlockIndex* pindex = m_blockman.LookupBlockIndex(hash);
+        if (!pindex || (pindex->nStatus & BLOCK_HAVE_DATA) == 0) {
+          BlockValidationState state;
+          assert(std::addressof(::ChainstateActive()) == std::addressof(*this));
+          if (AcceptBlock(pblock, state, nullptr, true, dbp, nullptr)) {
+              nLoaded++;
+          }
+          if (state.IsError()) {
+              return false;
+          }
+        } else if (hash != m_params.GetConsensus().hashGenesisBlock && pindex->nHeight % 1000 == 0) {
+            LogPrint(BCLog::REINDEX, "Block Import: already had block %s at height %d\n", hash.ToString(), pindex->nHeight);
+        }
+    }
+
+    // Activate the genesis block so normal node progress can continue
+    if (hash == m_params.GetConsensus().hashGenesisBlock) {
+        assert(std::addressof(::ChainstateActive()) == std::addressof(*this));
+        BlockValidationState state;
+        if (!ActivateBestChain(state, nullptr)) {
+            return false;
+        }
+    }
+
+    assert(std::addressof(::ChainstateActive()) == std::addressof(*this));
+    NotifyHeaderTip(*this);
+
+    // Recursively process earlier encountered successors of this block
+    std::deque<uint256> queue;
+    queue.push_back(hash);
+    while (!queue.empty()) {
+        uint256 head = queue.front();
+        queue.pop_front();
+        std::pair<std::multimap<uint256, FlatFilePos>::iterator, std::multimap<uint256, FlatFilePos>::iterator> range = mapBlocksUnknownParent.equal_range(head);
+        while (range.first != range.second) {
+            std::multimap<uint256, FlatFilePos>::iterator it = range.first;
+            std::shared_ptr<CBlock> pblockrecursive = std::make_shared<CBlock>();
+            if (ReadBlockFromDisk(*pblockrecursive, it->second, m_params.GetConsensus())) {
+                LogPrint(BCLog::REINDEX, "%s: Processing out of order child %s of %s\n", __func__, pblockrecursive->GetHash().ToString(),
+                        head.ToString());
+                LOCK(cs_main);
+                assert(std::addressof(::ChainstateActive()) == std::addressof(*this));
+                BlockValidationState dummy;
+                if (AcceptBlock(pblockrecursive, dummy, nullptr, true, &it->second, nullptr)) {
+                    nLoaded++;
+                    queue.push_back(pblockrecursive->GetHash());
+                }
+            }
+            range.first++;
+            mapBlocksUnknownParent.erase(it);
+            assert(std::addressof(::ChainstateActive()) == std::addressof(*this));
+            NotifyHeaderTip(*this);
+        }
+    }
+    return true;
+}
+
 void CChainState::LoadExternalBlockFile(FILE* fileIn, FlatFilePos* dbp)
 {
-    // Map of disk positions for blocks with unknown parent (only used for reindex)
-    static std::multimap<uint256, FlatFilePos> mapBlocksUnknownParent;
     int64_t nStart = GetTimeMillis();
 
     int nLoaded = 0;
@@ -5167,74 +5562,8 @@ void CChainState::LoadExternalBlockFile(FILE* fileIn, FlatFilePos* dbp)
                 blkdat >> block;
                 nRewind = blkdat.GetPos();
 
-                uint256 hash = block.GetHash();
-                {
-                    LOCK(cs_main);
-                    // detect out of order blocks, and store them for later
-                    assert(std::addressof(g_chainman.m_blockman) == std::addressof(m_blockman));
-                    if (hash != m_params.GetConsensus().hashGenesisBlock && !m_blockman.LookupBlockIndex(block.hashPrevBlock)) {
-                        LogPrint(BCLog::REINDEX, "%s: Out of order block %s, parent %s not known\n", __func__, hash.ToString(),
-                                block.hashPrevBlock.ToString());
-                        if (dbp)
-                            mapBlocksUnknownParent.insert(std::make_pair(block.hashPrevBlock, *dbp));
-                        continue;
-                    }
-
-                    // process in case the block isn't known yet
-                    assert(std::addressof(g_chainman.m_blockman) == std::addressof(m_blockman));
-                    CBlockIndex* pindex = m_blockman.LookupBlockIndex(hash);
-                    if (!pindex || (pindex->nStatus & BLOCK_HAVE_DATA) == 0) {
-                      BlockValidationState state;
-                      assert(std::addressof(::ChainstateActive()) == std::addressof(*this));
-                      if (AcceptBlock(pblock, state, nullptr, true, dbp, nullptr)) {
-                          nLoaded++;
-                      }
-                      if (state.IsError()) {
-                          break;
-                      }
-                    } else if (hash != m_params.GetConsensus().hashGenesisBlock && pindex->nHeight % 1000 == 0) {
-                        LogPrint(BCLog::REINDEX, "Block Import: already had block %s at height %d\n", hash.ToString(), pindex->nHeight);
-                    }
-                }
-
-                // Activate the genesis block so normal node progress can continue
-                if (hash == m_params.GetConsensus().hashGenesisBlock) {
-                    assert(std::addressof(::ChainstateActive()) == std::addressof(*this));
-                    BlockValidationState state;
-                    if (!ActivateBestChain(state, nullptr)) {
-                        break;
-                    }
-                }
-
-                assert(std::addressof(::ChainstateActive()) == std::addressof(*this));
-                NotifyHeaderTip(*this);
-
-                // Recursively process earlier encountered successors of this block
-                std::deque<uint256> queue;
-                queue.push_back(hash);
-                while (!queue.empty()) {
-                    uint256 head = queue.front();
-                    queue.pop_front();
-                    std::pair<std::multimap<uint256, FlatFilePos>::iterator, std::multimap<uint256, FlatFilePos>::iterator> range = mapBlocksUnknownParent.equal_range(head);
-                    while (range.first != range.second) {
-                        std::multimap<uint256, FlatFilePos>::iterator it = range.first;
-                        std::shared_ptr<CBlock> pblockrecursive = std::make_shared<CBlock>();
-                        if (ReadBlockFromDisk(*pblockrecursive, it->second, m_params.GetConsensus())) {
-                            LogPrint(BCLog::REINDEX, "%s: Processing out of order child %s of %s\n", __func__, pblockrecursive->GetHash().ToString(),
-                                    head.ToString());
-                            LOCK(cs_main);
-                            assert(std::addressof(::ChainstateActive()) == std::addressof(*this));
-                            BlockValidationState dummy;
-                            if (AcceptBlock(pblockrecursive, dummy, nullptr, true, &it->second, nullptr)) {
-                                nLoaded++;
-                                queue.push_back(pblockrecursive->GetHash());
-                            }
-                        }
-                        range.first++;
-                        mapBlocksUnknownParent.erase(it);
-                        assert(std::addressof(::ChainstateActive()) == std::addressof(*this));
-                        NotifyHeaderTip(*this);
-                    }
+                if (!LoadExternalBlock(pblock, dbp, nLoaded)) {
+                    break;
                 }
             } catch (const std::exception& e) {
                 LogPrintf("%s: Deserialize or I/O error - %s\n", __func__, e.what());
@@ -5246,6 +5575,147 @@ void CChainState::LoadExternalBlockFile(FILE* fileIn, FlatFilePos* dbp)
     LogPrintf("Loaded %i blocks from external file in %dms\n", nLoaded, GetTimeMillis() - nStart);
 }
 
+namespace {
+/** Blocks of one block file, deserialized and pre-checked ahead of being accepted */
+struct ScannedBlockFile {
+    //! false if the file does not exist or could not be read
+    bool found{false};
+    //! false if a record could not be deserialized; such files go through LoadExternalBlockFile()
+    bool complete{true};
+    std::vector<std::pair<std::shared_ptr<CBlock>, FlatFilePos>> blocks;
+};
+
+/** Number of blocks deserialized and pre-checked by a single check job */
+static constexpr size_t REINDEX_CHECK_CHUNK_SIZE{64};
+
+ScannedBlockFile ScanBlockFile(int nFile, const CChainParams& params, ctpl::thread_pool& check_pool)
+{
+    ScannedBlockFile result;
+    FlatFilePos pos(nFile, 0);
+    if (!fs::exists(GetBlockPosFilename(pos))) {
+        return result;
+    }
+    CAutoFile file(OpenBlockFile(pos, true), SER_DISK, CLIENT_VERSION);
+    if (file.IsNull()) {
+        return result; // This error is logged in OpenBlockFile
+    }
+    std::vector<uint8_t> data;
+    try {
+        if (fseek(file.Get(), 0, SEEK_END) != 0) {
+            return result;
+        }
+        long file_size = ftell(file.Get());
+        if (file_size < 0 || fseek(file.Get(), 0, SEEK_SET) != 0) {
+            return result;
+        }
+        data.resize(file_size);
+        file.read(MakeWritableByteSpan(data));
+    } catch (const std::exception& e) {
+        LogPrintf("%s: Failed to read blk%05u.dat - %s\n", __func__, (unsigned int)nFile, e.what());
+        return result;
+    }
+    result.found = true;
+
+    // Locate the records the same way LoadExternalBlockFile() does: message start, then size
+    const unsigned int nMaxBlockSize = MaxBlockSize();
+    const size_t header_size = CMessageHeader::MESSAGE_START_SIZE + sizeof(uint32_t);
+    std::vector<std::pair<size_t, size_t>> records;
+    size_t offset = 0;
+    while (offset + header_size <= data.size()) {
+        if (memcmp(data.data() + offset, params.MessageStart(), CMessageHeader::MESSAGE_START_SIZE)) {
+            offset++;
+            continue;
+        }
+        uint32_t nSize = ReadLE32(data.data() + offset + CMessageHeader::MESSAGE_START_SIZE);
+        if (nSize < 80 || nSize > nMaxBlockSize || offset + header_size + nSize > data.size()) {
+            offset++;
+            continue;
+        }
+        records.emplace_back(offset + header_size, nSize);
+        offset += header_size + nSize;
+    }
+
+    result.blocks.resize(records.size());
+    std::vector<std::future<bool>> futures;
+    for (size_t begin = 0; begin < records.size(); begin += REINDEX_CHECK_CHUNK_SIZE) {
+        const size_t end = std::min(begin + REINDEX_CHECK_CHUNK_SIZE, records.size());
+        futures.emplace_back(check_pool.push([&, begin, end](int) {
+            bool ok = true;
+            for (size_t i = begin; i < end; i++) {
+                auto pblock = std::make_shared<CBlock>();
+                try {
+                    SpanReader{SER_DISK, CLIENT_VERSION, Span{data}.subspan(records[i].first, records[i].second), 0} >> *pblock;
+                } catch (const std::exception&) {
+                    ok = false;
+                    continue;
+                }
+                // Failures are not reported here; AcceptBlock() repeats the checks and marks the block
+                BlockValidationState state;
+                PreCheckBlock(*pblock, state, params.GetConsensus());
+                result.blocks[i] = {std::move(pblock), FlatFilePos(nFile, records[i].first)};
+            }
+            return ok;
+        }));
+    }
+    for (auto& future : futures) {
+        result.complete &= future.get();
+    }
+    return result;
+}
+} // namespace
+
+void CChainState::ReindexBlockFiles()
+{
+    // Reading and splitting the next file runs on its own thread so that it never waits on a
+    // pool it is itself a job of; deserialization and context-free checks use the check pool.
+    // read_pool is declared last so that it is drained before the pool its job pushes to goes away.
+    ctpl::thread_pool check_pool(std::clamp(GetNumCores() - 1, 1, MAX_SCRIPTCHECK_THREADS));
+    ctpl::thread_pool read_pool(1);
+    RenameThreadPool(read_pool, "reidx-read");
+    RenameThreadPool(check_pool, "reidx-check");
+
+    auto scan = [&](int nFile) {
+        return read_pool.push([this, nFile, &check_pool](int) { return ScanBlockFile(nFile, m_params, check_pool); });
+    };
+
+    int nFile = 0;
+    auto next = scan(nFile);
+    while (true) {
+        ScannedBlockFile scanned = next.get();
+        if (!scanned.found) {
+            break; // No block files left to reindex
+        }
+        next = scan(nFile + 1);
+
+        LogPrintf("Reindexing block file blk%05u.dat...\n", (unsigned int)nFile);
+        if (!scanned.complete) {
+            // Let the byte-by-byte scan of the streaming import deal with damaged files
+            FlatFilePos pos(nFile, 0);
+            if (FILE* file = OpenBlockFile(pos, true)) {
+                LoadExternalBlockFile(file, &pos);
+            }
+        } else {
+            int64_t nStart = GetTimeMillis();
+            int nLoaded = 0;
+            try {
+                for (auto& [pblock, pos] : scanned.blocks) {
+                    if (ShutdownRequested()) break;
+                    if (!LoadExternalBlock(pblock, &pos, nLoaded)) break;
+                    // Release the block once accepted, it is no longer needed here
+                    pblock.reset();
+                }
+            } catch (const std::runtime_error& e) {
+                AbortNode(std::string("System error: ") + e.what());
+            }
+            LogPrintf("Loaded %i blocks from external file in %dms\n", nLoaded, GetTimeMillis() - nStart);
+        }
+        if (ShutdownRequested()) {
+            return;
+        }
+        nFile++;
+    }
+}
+
 void CChainState::CheckBlockIndex()
 {
     if (!fCheckBlockIndex) {
@@ -5487,6 +5957,13 @@ CBlockFileInfo* GetBlockFileInfo(size_t n)
     return &vinfoBlockFile.at(n);
 }
 
+int GetLastBlockFileNumber()
+{
+    LOCK(cs_LastBlockFile);
+
+    return nLastBlockFile;
+}
+
 static const uint64_t MEMPOOL_DUMP_VERSION = 1;
 
 bool LoadMempool(CTxMemPool& pool, CChainState& active_chainstate, FopenFn mockable_fopen_function)
@@ -5515,41 +5992,73 @@ bool LoadMempool(CTxMemPool& pool, CChainState& active_chainstate, FopenFn mocka
         }
         uint64_t num;
         file >> num;
-        while (num) {
-            --num;
-            CTransactionRef tx;
-            int64_t nTime;
-            int64_t nFeeDelta;
-            file >> tx;
-            file >> nTime;
-            file >> nFeeDelta;
-
-            CAmount amountdelta = nFeeDelta;
-            if (amountdelta) {
-                pool.PrioritiseTransaction(tx->GetHash(), amountdelta);
+        // Unexpired transactions are accepted in batches, most of them being unrelated. The next
+        // batch is deserialized on another thread while the current one is validated.
+        struct LoadBatch {
+            std::vector<CTransactionRef> txs;
+            std::vector<int64_t> times;
+            std::vector<std::pair<uint256, CAmount>> deltas;
+        };
+        const auto read_batch = [&file, &num, &expired, nNow, nExpiryTimeout]() {
+            LoadBatch batch;
+            while (num && batch.txs.size() < MEMPOOL_LOAD_BATCH_SIZE) {
+                --num;
+                CTransactionRef tx;
+                int64_t nTime;
+                int64_t nFeeDelta;
+                file >> tx;
+                file >> nTime;
+                file >> nFeeDelta;
+
+                CAmount amountdelta = nFeeDelta;
+                if (amountdelta) {
+                    batch.deltas.emplace_back(tx->GetHash(), amountdelta);
+                }
+                if (nTime > nNow - nExpiryTimeout) {
+                    batch.txs.push_back(std::move(tx));
+                    batch.times.push_back(nTime);
+                } else {
+                    ++expired;
+                }
             }
-            if (nTime > nNow - nExpiryTimeout) {
-                LOCK(cs_main);
-                assert(std::addressof(::ChainstateActive()) == std::addressof(active_chainstate));
-                if (AcceptToMemoryPoolWithTime(chainparams, pool, active_chainstate, tx, nTime, false /* bypass_limits */,
-                                               false /* test_accept */).m_result_type == MempoolAcceptResult::ResultType::VALID) {
+            return batch;
+        };
+        const auto accept_batch = [&](const std::vector<CTransactionRef>& batch_txs, const std::vector<int64_t>& batch_times) {
+            if (batch_txs.empty()) return;
+            LOCK(cs_main);
+            assert(std::addressof(::ChainstateActive()) == std::addressof(active_chainstate));
+            const std::vector<MempoolAcceptResult> results = AcceptToMemoryPoolBatchWithTime(chainparams, pool, active_chainstate, batch_txs, batch_times, false /* bypass_limits */);
+            for (size_t i = 0; i < results.size(); ++i) {
+                if (results[i].m_result_type == MempoolAcceptResult::ResultType::VALID) {
                     ++count;
                 } else {
                     // mempool may contain the transaction already, e.g. from
                     // wallet(s) having loaded it while we were processing
                     // mempool transactions; consider these as valid, instead of
                     // failed, but mark them as 'already there'
-                    if (pool.exists(tx->GetHash())) {
+                    if (pool.exists(batch_txs[i]->GetHash())) {
                         ++already_there;
                     } else {
                         ++failed;
                     }
                 }
-            } else {
-                ++expired;
             }
+        };
+        // Only the reader touches file, num and expired until its batch is taken
+        std::future<LoadBatch> next_batch = std::async(std::launch::async, read_batch);
+        while (true) {
+            LoadBatch batch = next_batch.get();
+            const bool more = num > 0;
+            if (more) {
+                next_batch = std::async(std::launch::async, read_batch);
+            }
+            for (const auto& [txid, delta] : batch.deltas) {
+                pool.PrioritiseTransaction(txid, delta);
+            }
+            accept_batch(batch.txs, batch.times);
             if (ShutdownRequested())
                 return false;
+            if (!more) break;
         }
         std::map<uint256, CAmount> mapDeltas;
         file >> mapDeltas;
@@ -5917,6 +6426,20 @@ bool ChainstateManager::PopulateAndValidateSnapshot(
     // method.
     coins_cache.SetBestBlock(base_blockhash);
 
+    // The evo database state at the base follows the coins. It is only written once the
+    // coins have been validated as well.
+    CDBBatch evodb_batch(snapshot_chainstate.m_evoDb.GetRawDB());
+    const auto evodb_hash = snapshot_chainstate.m_evoDb.ReadSnapshot(coins_file, metadata.m_evodb_count, evodb_batch);
+    if (!evodb_hash) {
+        LogPrintf("[snapshot] bad snapshot - failed to read %d evodb entries\n", metadata.m_evodb_count);
+        return false;
+    }
+    if (!au_data.hash_evodb.IsNull() && *evodb_hash != au_data.hash_evodb) {
+        LogPrintf("[snapshot] bad snapshot evodb hash: expected %s, got %s\n",
+            au_data.hash_evodb.ToString(), evodb_hash->ToString());
+        return false;
+    }
+
     bool out_of_coins{false};
     try {
         coins_file >> outpoint;
@@ -5960,6 +6483,12 @@ bool ChainstateManager::PopulateAndValidateSnapshot(
         return false;
     }
 
+    LogPrintf("[snapshot] writing %d evodb entries (hash %s)\n", metadata.m_evodb_count, evodb_hash->ToString());
+    if (!snapshot_chainstate.m_evoDb.ApplySnapshot(evodb_batch, base_blockhash)) {
+        LogPrintf("[snapshot] failed to write evodb entries\n");
+        return false;
+    }
+
     snapshot_chainstate.m_chain.SetTip(snapshot_start_block);
 
     // The remainder of this function requires modifying data protected by cs_main.
@@ -31,6 +31,7 @@
 #include <util/hasher.h>
 
 #include <atomic>
+#include <functional>
 #include <map>
 #include <memory>
 #include <optional>
@@ -186,6 +187,8 @@ extern const std::vector<std::string> CHECKLEVEL_DOC;
 
 /** Open a block file (blk?????.dat) */
 FILE* OpenBlockFile(const FlatFilePos &pos, bool fReadOnly = false);
+/** Map a block file (blk?????.dat) into memory, see FlatFileSeq::Map */
+std::shared_ptr<const MappedFlatFile> MapBlockFile(const FlatFilePos &pos);
 /** Translation to a filesystem path */
 fs::path GetBlockPosFilename(const FlatFilePos &pos);
 /** Unload database information */
@@ -194,6 +197,23 @@ void UnloadBlockIndex(CTxMemPool* mempool, ChainstateManager& chainman);
 void StartScriptCheckWorkerThreads(int threads_num);
 /** Stop all of the script checking worker threads */
 void StopScriptCheckWorkerThreads();
+/**
+ * Compute the proof-of-work hashes of a batch of headers and check their proof
+ * of work (context-free, see CheckProofOfWork), spreading the work over the
+ * script check worker threads. Does not require cs_main.
+ * @param[out] pow_hashes The hash of every header, in the same order as headers
+ * @returns false if the proof of work of any header is invalid
+ */
+bool CheckHeadersProofOfWork(const std::vector<CBlockHeader>& headers, std::vector<uint256>& pow_hashes, const Consensus::Params& params);
+
+/**
+ * Verify the input scripts of a transaction against the outputs it spends, spreading the
+ * work over the script check worker threads. Valid signatures are stored in the signature
+ * cache, so a following AcceptToMemoryPool doesn't verify them again under cs_main.
+ * Does not require cs_main.
+ * @param[in] spent_outputs The output spent by every input, in the same order as tx.vin
+ */
+bool CheckTransactionScripts(const CTransaction& tx, std::vector<CTxOut>&& spent_outputs, unsigned int flags);
 
 CTransactionRef GetTransaction(const CBlockIndex* const block_index, const CTxMemPool* const mempool, const uint256& hash, const Consensus::Params& consensusParams, uint256& hashBlock);
 
@@ -217,6 +237,8 @@ CAmount GetMasternodePayment(int nHeight, CAmount blockValue, bool fV20Active);
  * @return True if the PoW is correct.
  */
 bool CheckProofOfWork(const CBlockHeader& block, const Consensus::Params& params);
+/** Same as above, with the X11 hash of the header already computed. */
+bool CheckProofOfWork(const CBlockHeader& block, const uint256& pow_hash, const Consensus::Params& params);
 
 /** Guess verification progress (as a fraction between 0.0=genesis and 1.0=current tip). */
 double GuessVerificationProgress(const ChainTxData& data, const CBlockIndex* pindex);
@@ -299,12 +321,27 @@ MempoolAcceptResult AcceptToMemoryPool(CChainState& active_chainstate, CTxMemPoo
                                        bool bypass_limits, bool test_accept=false) EXCLUSIVE_LOCKS_REQUIRED(cs_main);
 
 /**
-* Atomically test acceptance of a package. If the package only contains one tx, package rules still
-* apply. The transaction(s) cannot spend the same inputs as any transaction in the mempool.
+ * (Try to) add a batch of transactions to the memory pool, with the same outcome as calling
+ * AcceptToMemoryPool on each of them in turn. Transactions which neither spend nor conflict
+ * with another one of the batch are checked together: their coins are looked up in one pass
+ * and their scripts verified on the script check worker threads. The batch is added under a
+ * single hold of the mempool lock.
+ * @param[in]  bypass_limits   When true, don't enforce mempool fee limits.
+ * @returns the result of every transaction, in the same order as txns.
+ */
+std::vector<MempoolAcceptResult> AcceptToMemoryPoolBatch(CChainState& active_chainstate, CTxMemPool& pool,
+                                                         const std::vector<CTransactionRef>& txns, bool bypass_limits) EXCLUSIVE_LOCKS_REQUIRED(cs_main);
+
+/**
+* Atomically test acceptance of a package, or submit it. If the package only contains one tx, package
+* rules still apply. The transaction(s) cannot spend the same inputs as any transaction in the mempool.
+* When submitting, the fee rate requirements apply to the package as a whole, so a child can pay for
+* its parents, and either all transactions are added to the mempool or none is.
 * @param[in]    txns                Group of transactions which may be independent or contain
 *                                   parent-child dependencies. The transactions must not conflict
 *                                   with each other, i.e., must not spend the same inputs. If any
 *                                   dependencies exist, parents must appear before children.
+* @param[in]    test_accept         When true, run validation checks but don't submit to mempool.
 * @returns a PackageMempoolAcceptResult which includes a MempoolAcceptResult for each transaction.
 * If a transaction fails, validation will exit early and some results may be missing.
 */
@@ -399,9 +436,12 @@ public:
 
 bool GetTimestampIndex(const unsigned int &high, const unsigned int &low, std::vector<uint256> &hashes);
 bool GetSpentIndex(CTxMemPool& mempool, CSpentIndexKey &key, CSpentIndexValue &value);
-bool GetAddressIndex(uint160 addressHash, AddressType type,
-                     std::vector<std::pair<CAddressIndexKey, CAmount> > &addressIndex,
-                     int start = 0, int end = 0);
+/** Look up several spent index keys at once, the entries found are added to info */
+bool GetSpentIndexes(CTxMemPool& mempool, const std::vector<CSpentIndexKey>& keys, CSpentIndexTxInfo& info);
+/** Stream the address index entries of an address to fn, see AddressIndex::ScanAddressIndex */
+bool ScanAddressIndex(uint160 addressHash, AddressType type, int start, int end, const CAddressIndexKey* from,
+                      const std::function<bool(const CAddressIndexKey&, CAmount)>& fn);
+bool GetAddressBalance(uint160 addressHash, AddressType type, CAddressBalanceValue& value);
 bool GetAddressUnspent(uint160 addressHash, AddressType type,
                        std::vector<std::pair<CAddressUnspentKey, CAddressUnspentValue> > &unspentOutputs);
 /** Initializes the script-execution cache */
@@ -409,9 +449,37 @@ void InitScriptExecutionCache();
 
 /** Functions for validating blocks and updating the block tree */
 
+/**
+ * Cumulative time in microseconds spent in the phases of block validation since startup. The same
+ * figures are logged per block with -debug=bench; this makes them available to tools measuring a
+ * whole sync, like the block replay mode of bench_maximus.
+ */
+struct BlockValidationTimings {
+    int64_t blocks{0};           //!< number of blocks connected
+    int64_t pow{0};              //!< proof of work checks of headers and blocks
+    int64_t check_block{0};      //!< context-free block checks (merkle root, transactions, limits)
+    int64_t prefetch{0};         //!< waiting for the coins prefetched for the block
+    int64_t connect_inputs{0};   //!< fetching inputs and queueing script checks
+    int64_t script_checks{0};    //!< waiting for the script check workers
+    int64_t special_txes{0};     //!< ProcessSpecialTxsInBlock
+    int64_t maximus_specific{0}; //!< IS filter, subsidy, credit pool, block value and payee checks
+    int64_t coins_flush{0};      //!< flushing the block's coins view into the tip cache
+    int64_t evo_commit{0};       //!< committing the block's evo db transaction
+    int64_t chainstate_flush{0}; //!< writing the chainstate to disk when needed
+    int64_t total{0};            //!< ConnectTip in total
+};
+BlockValidationTimings GetBlockValidationTimings();
+
 /** Context-independent validity checks */
 bool CheckBlock(const CBlock& block, BlockValidationState& state, const Consensus::Params& consensusParams, int nHeight, bool fCheckPOW = true, bool fCheckMerkleRoot = true);
 
+/**
+ * The checks of CheckBlock() that don't depend on the chain (PoW, merkle root, transactions and
+ * limits), which may be done in advance and without cs_main on a block no other thread has access
+ * to yet. On success the block is marked so that CheckBlock() only does what's left.
+ */
+bool PreCheckBlock(const CBlock& block, BlockValidationState& state, const Consensus::Params& consensusParams);
+
 /** Check a block is completely valid from start to finish (only works on top of our current best block) */
 bool TestBlockValidity(BlockValidationState& state,
                        llmq::CChainLocksHandler& clhandler,
@@ -490,6 +558,14 @@ private:
      */
     void FindFilesToPrune(std::set<int>& setFilesToPrune, uint64_t nPruneAfterHeight, int chain_tip_height, int prune_height, bool is_ibd);
 
+    /**
+     * Load m_block_index from the snapshot written at the last clean shutdown, if it belongs to blocktree. The
+     * snapshot marker is erased first, so the snapshot can't be used again once the block index changed.
+     *
+     * @param[out] sorted_by_height  The loaded entries with their height, in height order
+     */
+    bool LoadBlockIndexSnapshot(CBlockTreeDB& blocktree, std::vector<std::pair<int, CBlockIndex*>>& sorted_by_height) EXCLUSIVE_LOCKS_REQUIRED(cs_main);
+
 public:
     BlockMap m_block_index GUARDED_BY(cs_main);
     PrevBlockMap m_prev_block_index GUARDED_BY(cs_main);
@@ -536,6 +612,12 @@ public:
     /** Clear all data members. */
     void Unload() EXCLUSIVE_LOCKS_REQUIRED(cs_main);
 
+    /**
+     * Write the block index snapshot loaded by the next LoadBlockIndex, on shutdown after the last flush. Nothing is
+     * written while block index entries are still waiting to be flushed to blocktree.
+     */
+    bool WriteBlockIndexSnapshot(CBlockTreeDB& blocktree) EXCLUSIVE_LOCKS_REQUIRED(cs_main);
+
     CBlockIndex* AddToBlockIndex(const CBlockHeader& block, const uint256& hash, enum BlockStatus nStatus = BLOCK_VALID_TREE) EXCLUSIVE_LOCKS_REQUIRED(cs_main);
     /** Create a new block index entry for a given block hash */
     CBlockIndex* InsertBlockIndex(const uint256& hash) EXCLUSIVE_LOCKS_REQUIRED(cs_main);
@@ -546,12 +628,15 @@ public:
     /**
      * If a block header hasn't already been seen, call CheckBlockHeader on it, ensure
      * that it doesn't descend from an invalid block, and then add it to m_block_index.
+     * If pow_checked_hash is set, the proof of work of the header has already been
+     * verified and pow_checked_hash is its hash.
      */
     bool AcceptBlockHeader(
         const CBlockHeader& block,
         BlockValidationState& state,
         const CChainParams& chainparams,
-        CBlockIndex** ppindex) EXCLUSIVE_LOCKS_REQUIRED(cs_main);
+        CBlockIndex** ppindex,
+        const uint256* pow_checked_hash = nullptr) EXCLUSIVE_LOCKS_REQUIRED(cs_main);
 
     CBlockIndex* LookupBlockIndex(const uint256& hash) const EXCLUSIVE_LOCKS_REQUIRED(cs_main);
 
@@ -767,6 +852,13 @@ public:
     /** Import blocks from an external file */
     void LoadExternalBlockFile(FILE* fileIn, FlatFilePos* dbp = nullptr);
 
+    /**
+     * Re-import all blk?????.dat files for -reindex. Files are read, split into
+     * blocks and pre-checked on worker threads one file ahead of the thread that
+     * accepts them, which still happens serially and in file order.
+     */
+    void ReindexBlockFiles();
+
     /**
      * Update the on-disk chain state.
      * The caches and indexes are flushed depending on the mode we're called with
@@ -880,6 +972,12 @@ private:
 
     bool RollforwardBlock(const CBlockIndex* pindex, CCoinsViewCache& inputs) EXCLUSIVE_LOCKS_REQUIRED(cs_main);
 
+    /**
+     * Accept a single block read from a block file, then any of its previously
+     * seen out of order children. Returns false if importing should stop.
+     */
+    bool LoadExternalBlock(const std::shared_ptr<CBlock>& pblock, FlatFilePos* dbp, int& nLoaded) LOCKS_EXCLUDED(cs_main);
+
     //! Mark a block as conflicting
     bool MarkConflictingBlock(BlockValidationState& state, CBlockIndex* pindex) EXCLUSIVE_LOCKS_REQUIRED(cs_main);
 
@@ -1131,8 +1229,9 @@ public:
      * @param[in]  chainparams The params for the chain we want to connect to
      * @param[out] ppindex If set, the pointer will be set to point to the last new block index object for the given headers
      * @param[out] first_invalid First header that fails validation, if one exists
+     * @param[in]  pow_checked_hashes If set, the hashes of the headers, whose proof of work was already verified by CheckHeadersProofOfWork
      */
-    bool ProcessNewBlockHeaders(const std::vector<CBlockHeader>& block, BlockValidationState& state, const CChainParams& chainparams, const CBlockIndex** ppindex = nullptr) LOCKS_EXCLUDED(cs_main);
+    bool ProcessNewBlockHeaders(const std::vector<CBlockHeader>& block, BlockValidationState& state, const CChainParams& chainparams, const CBlockIndex** ppindex = nullptr, const std::vector<uint256>* pow_checked_hashes = nullptr) LOCKS_EXCLUDED(cs_main);
 
     //! Load the block tree and coins database from disk, initializing state if we're running with -reindex
     bool LoadBlockIndex() EXCLUSIVE_LOCKS_REQUIRED(cs_main);
@@ -1170,6 +1269,9 @@ bool GetBlockHash(uint256& hashRet, int nBlockHeight = -1);
 /** Get block file info entry for one block file */
 CBlockFileInfo* GetBlockFileInfo(size_t n);
 
+/** Get the number of the block file new blocks are appended to */
+int GetLastBlockFileNumber();
+
 using FopenFn = std::function<FILE*(const fs::path&, const char*)>;
 
 /** Dump the mempool to disk. */
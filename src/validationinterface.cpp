@@ -17,9 +17,11 @@
 #include <llmq/clsig.h>
 #include <llmq/signing.h>
 
+#include <atomic>
 #include <future>
 #include <unordered_map>
 #include <utility>
+#include <vector>
 
 //! The MainSignalsInstance manages a list of shared_ptr<CValidationInterface>
 //! callbacks.
@@ -28,16 +30,42 @@
 //! registered, and a std::list is to used to store the callbacks that are
 //! currently registered as well as any callbacks that are just unregistered
 //! and about to be deleted when they are done executing.
+//!
+//! Subscribers registered with their own queue get the background callbacks
+//! through it instead of the shared queue, so they don't wait behind the other
+//! subscribers. The queues share the scheduler's default lane and never run at
+//! the same time.
 struct MainSignalsInstance {
 private:
+    //! Background callbacks of one subscriber, in the order they were generated
+    struct SubscriberQueue {
+        SingleThreadedSchedulerClient client;
+        std::atomic<bool> registered{true};
+        explicit SubscriberQueue(CScheduler& scheduler) : client(scheduler) {}
+    };
+
+    CScheduler& m_scheduler;
     Mutex m_mutex;
     //! List entries consist of a callback pointer and reference count. The
     //! count is equal to the number of current executions of that entry, plus 1
     //! if it's registered. It cannot be 0 because that would imply it is
     //! unregistered and also not being executed (so shouldn't exist).
-    struct ListEntry { std::shared_ptr<CValidationInterface> callbacks; int count = 1; };
+    struct ListEntry { std::shared_ptr<CValidationInterface> callbacks; int count = 1; std::shared_ptr<SubscriberQueue> queue; };
     std::list<ListEntry> m_list GUARDED_BY(m_mutex);
     std::unordered_map<CValidationInterface*, std::list<ListEntry>::iterator> m_map GUARDED_BY(m_mutex);
+    //! Every subscriber queue created so far. They are only destroyed with this instance, as the
+    //! scheduler may still hold a reference to them after their subscriber was unregistered.
+    std::vector<std::shared_ptr<SubscriberQueue>> m_queues GUARDED_BY(m_mutex);
+
+    std::vector<SingleThreadedSchedulerClient*> GetQueues() EXCLUSIVE_LOCKS_REQUIRED(!m_mutex)
+    {
+        std::vector<SingleThreadedSchedulerClient*> queues{&m_schedulerClient};
+        LOCK(m_mutex);
+        for (const auto& queue : m_queues) {
+            queues.push_back(&queue->client);
+        }
+        return queues;
+    }
 
 public:
     // We are not allowed to assume the scheduler only runs in one thread,
@@ -45,13 +73,18 @@ public:
     // our own queue here :(
     SingleThreadedSchedulerClient m_schedulerClient;
 
-    explicit MainSignalsInstance(CScheduler& scheduler LIFETIMEBOUND) : m_schedulerClient(scheduler) {}
+    explicit MainSignalsInstance(CScheduler& scheduler LIFETIMEBOUND) : m_scheduler(scheduler), m_schedulerClient(scheduler) {}
 
-    void Register(std::shared_ptr<CValidationInterface> callbacks)
+    void Register(std::shared_ptr<CValidationInterface> callbacks, bool own_queue)
     {
         LOCK(m_mutex);
         auto inserted = m_map.emplace(callbacks.get(), m_list.end());
-        if (inserted.second) inserted.first->second = m_list.emplace(m_list.end());
+        if (inserted.second) {
+            inserted.first->second = m_list.emplace(m_list.end());
+            if (own_queue) {
+                inserted.first->second->queue = m_queues.emplace_back(std::make_shared<SubscriberQueue>(m_scheduler));
+            }
+        }
         inserted.first->second->callbacks = std::move(callbacks);
     }
 
@@ -60,6 +93,7 @@ public:
         LOCK(m_mutex);
         auto it = m_map.find(callbacks);
         if (it != m_map.end()) {
+            if (it->second->queue) it->second->queue->registered = false;
             if (!--it->second->count) m_list.erase(it->second);
             m_map.erase(it);
         }
@@ -73,15 +107,20 @@ public:
     {
         LOCK(m_mutex);
         for (const auto& entry : m_map) {
+            if (entry.second->queue) entry.second->queue->registered = false;
             if (!--entry.second->count) m_list.erase(entry.second);
         }
         m_map.clear();
     }
 
-    template<typename F> void Iterate(F&& f)
+    template<typename F> void Iterate(F&& f, bool shared_queue_only = false)
     {
         WAIT_LOCK(m_mutex, lock);
         for (auto it = m_list.begin(); it != m_list.end();) {
+            if (shared_queue_only && it->queue) {
+                ++it;
+                continue;
+            }
             ++it->count;
             {
                 REVERSE_LOCK(lock);
@@ -90,6 +129,56 @@ public:
             it = --it->count ? std::next(it) : m_list.erase(it);
         }
     }
+
+    //! Queue a background callback for every subscriber, log is called once when the shared queue gets to it
+    template<typename F> void Enqueue(std::function<void()> log, F event)
+    {
+        m_schedulerClient.AddToProcessQueue([this, log = std::move(log), event] {
+            log();
+            Iterate(event, /*shared_queue_only=*/true);
+        });
+        LOCK(m_mutex);
+        for (const auto& entry : m_list) {
+            if (!entry.queue || !entry.queue->registered) continue;
+            // The shared_ptr keeps the subscriber alive until the callback ran, see #18338
+            entry.queue->client.AddToProcessQueue([queue = entry.queue, callbacks = entry.callbacks, event] {
+                if (queue->registered) event(*callbacks);
+            });
+        }
+    }
+
+    //! Call func once all queues got through the callbacks queued before
+    void CallAfterQueues(std::function<void()> func)
+    {
+        const auto queues = GetQueues();
+        if (queues.size() == 1) {
+            m_schedulerClient.AddToProcessQueue(std::move(func));
+            return;
+        }
+        auto remaining = std::make_shared<std::atomic<size_t>>(queues.size());
+        auto shared_func = std::make_shared<std::function<void()>>(std::move(func));
+        for (auto* queue : queues) {
+            queue->AddToProcessQueue([remaining, shared_func] {
+                if (--*remaining == 0) (*shared_func)();
+            });
+        }
+    }
+
+    void EmptyQueues()
+    {
+        for (auto* queue : GetQueues()) {
+            queue->EmptyQueue();
+        }
+    }
+
+    size_t CallbacksPending()
+    {
+        size_t pending{0};
+        for (auto* queue : GetQueues()) {
+            pending += queue->CallbacksPending();
+        }
+        return pending;
+    }
 };
 
 static CMainSignals g_signals;
@@ -108,14 +197,14 @@ void CMainSignals::UnregisterBackgroundSignalScheduler()
 void CMainSignals::FlushBackgroundCallbacks()
 {
     if (m_internals) {
-        m_internals->m_schedulerClient.EmptyQueue();
+        m_internals->EmptyQueues();
     }
 }
 
 size_t CMainSignals::CallbacksPending()
 {
     if (!m_internals) return 0;
-    return m_internals->m_schedulerClient.CallbacksPending();
+    return m_internals->CallbacksPending();
 }
 
 CMainSignals& GetMainSignals()
@@ -123,18 +212,18 @@ CMainSignals& GetMainSignals()
     return g_signals;
 }
 
-void RegisterSharedValidationInterface(std::shared_ptr<CValidationInterface> callbacks)
+void RegisterSharedValidationInterface(std::shared_ptr<CValidationInterface> callbacks, bool own_queue)
 {
     // Each connection captures the shared_ptr to ensure that each callback is
     // executed before the subscriber is destroyed. For more details see #18338.
-    g_signals.m_internals->Register(std::move(callbacks));
+    g_signals.m_internals->Register(std::move(callbacks), own_queue);
 }
 
-void RegisterValidationInterface(CValidationInterface* callbacks)
+void RegisterValidationInterface(CValidationInterface* callbacks, bool own_queue)
 {
     // Create a shared_ptr with a no-op deleter - CValidationInterface lifecycle
     // is managed by the caller.
-    RegisterSharedValidationInterface({callbacks, [](CValidationInterface*){}});
+    RegisterSharedValidationInterface({callbacks, [](CValidationInterface*){}}, own_queue);
 }
 
 void UnregisterSharedValidationInterface(std::shared_ptr<CValidationInterface> callbacks)
@@ -159,7 +248,7 @@ void UnregisterAllValidationInterfaces()
 
 void CallFunctionInValidationInterfaceQueue(std::function<void()> func)
 {
-    g_signals.m_internals->m_schedulerClient.AddToProcessQueue(std::move(func));
+    g_signals.m_internals->CallAfterQueues(std::move(func));
 }
 
 void SyncWithValidationInterfaceQueue()
@@ -181,10 +270,9 @@ void SyncWithValidationInterfaceQueue()
     do {                                                       \
         auto local_name = (name);                              \
         LOG_EVENT("Enqueuing " fmt, local_name, __VA_ARGS__);  \
-        m_internals->m_schedulerClient.AddToProcessQueue([=] { \
+        m_internals->Enqueue([=] {                             \
             LOG_EVENT(fmt, local_name, __VA_ARGS__);           \
-            event();                                           \
-        });                                                    \
+        }, event);                                             \
     } while (0)
 
 #define LOG_EVENT(fmt, ...) \
@@ -195,8 +283,8 @@ void CMainSignals::UpdatedBlockTip(const CBlockIndex *pindexNew, const CBlockInd
     // the chain actually updates. One way to ensure this is for the caller to invoke this signal
     // in the same critical section where the chain is updated
 
-    auto event = [pindexNew, pindexFork, fInitialDownload, this] {
-        m_internals->Iterate([&](CValidationInterface& callbacks) { callbacks.UpdatedBlockTip(pindexNew, pindexFork, fInitialDownload); });
+    auto event = [pindexNew, pindexFork, fInitialDownload](CValidationInterface& callbacks) {
+        callbacks.UpdatedBlockTip(pindexNew, pindexFork, fInitialDownload);
     };
     ENQUEUE_AND_LOG_EVENT(event, "%s: new block hash=%s fork block hash=%s (in IBD=%s)", __func__,
                           pindexNew->GetBlockHash().ToString(),
@@ -209,24 +297,24 @@ void CMainSignals::SynchronousUpdatedBlockTip(const CBlockIndex *pindexNew, cons
 }
 
 void CMainSignals::TransactionAddedToMempool(const CTransactionRef& tx, int64_t nAcceptTime) {
-    auto event = [tx, nAcceptTime, this] {
-        m_internals->Iterate([&](CValidationInterface& callbacks) { callbacks.TransactionAddedToMempool(tx, nAcceptTime); });
+    auto event = [tx, nAcceptTime](CValidationInterface& callbacks) {
+        callbacks.TransactionAddedToMempool(tx, nAcceptTime);
     };
     ENQUEUE_AND_LOG_EVENT(event, "%s: txid=%s", __func__,
                           tx->GetHash().ToString());
 }
 
 void CMainSignals::TransactionRemovedFromMempool(const CTransactionRef& tx, MemPoolRemovalReason reason) {
-    auto event = [tx, reason, this] {
-        m_internals->Iterate([&](CValidationInterface& callbacks) { callbacks.TransactionRemovedFromMempool(tx, reason); });
+    auto event = [tx, reason](CValidationInterface& callbacks) {
+        callbacks.TransactionRemovedFromMempool(tx, reason);
     };
     ENQUEUE_AND_LOG_EVENT(event, "%s: txid=%s", __func__,
                           tx->GetHash().ToString());
 }
 
 void CMainSignals::BlockConnected(const std::shared_ptr<const CBlock> &pblock, const CBlockIndex *pindex) {
-    auto event = [pblock, pindex, this] {
-        m_internals->Iterate([&](CValidationInterface& callbacks) { callbacks.BlockConnected(pblock, pindex); });
+    auto event = [pblock, pindex](CValidationInterface& callbacks) {
+        callbacks.BlockConnected(pblock, pindex);
     };
     ENQUEUE_AND_LOG_EVENT(event, "%s: block hash=%s block height=%d", __func__,
                           pblock->GetHash().ToString(),
@@ -234,8 +322,8 @@ void CMainSignals::BlockConnected(const std::shared_ptr<const CBlock> &pblock, c
 }
 
 void CMainSignals::BlockDisconnected(const std::shared_ptr<const CBlock> &pblock, const CBlockIndex* pindex) {
-    auto event = [pblock, pindex, this] {
-        m_internals->Iterate([&](CValidationInterface& callbacks) { callbacks.BlockDisconnected(pblock, pindex); });
+    auto event = [pblock, pindex](CValidationInterface& callbacks) {
+        callbacks.BlockDisconnected(pblock, pindex);
     };
     ENQUEUE_AND_LOG_EVENT(event, "%s: block hash=%s block height=%d", __func__,
                           pblock->GetHash().ToString(),
@@ -243,8 +331,8 @@ void CMainSignals::BlockDisconnected(const std::shared_ptr<const CBlock> &pblock
 }
 
 void CMainSignals::ChainStateFlushed(const CBlockLocator &locator) {
-    auto event = [locator, this] {
-        m_internals->Iterate([&](CValidationInterface& callbacks) { callbacks.ChainStateFlushed(locator); });
+    auto event = [locator](CValidationInterface& callbacks) {
+        callbacks.ChainStateFlushed(locator);
     };
     ENQUEUE_AND_LOG_EVENT(event, "%s: block hash=%s", __func__,
                           locator.IsNull() ? "null" : locator.vHave.front().ToString());
@@ -272,16 +360,16 @@ void CMainSignals::NotifyHeaderTip(const CBlockIndex *pindexNew, bool fInitialDo
 }
 
 void CMainSignals::NotifyTransactionLock(const CTransactionRef &tx, const std::shared_ptr<const llmq::CInstantSendLock>& islock) {
-    auto event = [tx, islock, this] {
-        m_internals->Iterate([&](CValidationInterface& callbacks) { callbacks.NotifyTransactionLock(tx, islock); });
+    auto event = [tx, islock](CValidationInterface& callbacks) {
+        callbacks.NotifyTransactionLock(tx, islock);
     };
     ENQUEUE_AND_LOG_EVENT(event, "%s: transaction lock txid=%s", __func__,
                           tx->GetHash().ToString());
 }
 
 void CMainSignals::NotifyChainLock(const CBlockIndex* pindex, const std::shared_ptr<const llmq::CChainLockSig>& clsig) {
-    auto event = [pindex, clsig, this] {
-        m_internals->Iterate([&](CValidationInterface& callbacks) { callbacks.NotifyChainLock(pindex, clsig); });
+    auto event = [pindex, clsig](CValidationInterface& callbacks) {
+        callbacks.NotifyChainLock(pindex, clsig);
     };
     ENQUEUE_AND_LOG_EVENT(event, "%s: notify chainlock at block=%s cl=%s", __func__,
             pindex->GetBlockHash().ToString(),
@@ -289,22 +377,22 @@ void CMainSignals::NotifyChainLock(const CBlockIndex* pindex, const std::shared_
 }
 
 void CMainSignals::NotifyGovernanceVote(const std::shared_ptr<const CGovernanceVote>& vote) {
-    auto event = [vote, this] {
-        m_internals->Iterate([&](CValidationInterface& callbacks) { callbacks.NotifyGovernanceVote(vote); });
+    auto event = [vote](CValidationInterface& callbacks) {
+        callbacks.NotifyGovernanceVote(vote);
     };
     ENQUEUE_AND_LOG_EVENT(event, "%s: notify governance vote: %s", __func__, vote->GetHash().ToString());
 }
 
 void CMainSignals::NotifyGovernanceObject(const std::shared_ptr<const Governance::Object>& object) {
-    auto event = [object, this] {
-        m_internals->Iterate([&](CValidationInterface& callbacks) { callbacks.NotifyGovernanceObject(object); });
+    auto event = [object](CValidationInterface& callbacks) {
+        callbacks.NotifyGovernanceObject(object);
     };
     ENQUEUE_AND_LOG_EVENT(event, "%s: notify governance object: %s", __func__, object->GetHash().ToString());
 }
 
 void CMainSignals::NotifyInstantSendDoubleSpendAttempt(const CTransactionRef& currentTx, const CTransactionRef& previousTx) {
-    auto event = [currentTx, previousTx, this] {
-        m_internals->Iterate([&](CValidationInterface& callbacks) { callbacks.NotifyInstantSendDoubleSpendAttempt(currentTx, previousTx); });
+    auto event = [currentTx, previousTx](CValidationInterface& callbacks) {
+        callbacks.NotifyInstantSendDoubleSpendAttempt(currentTx, previousTx);
     };
     ENQUEUE_AND_LOG_EVENT(event, "%s: notify instant doublespendattempt currenttxid=%s previoustxid=%s", __func__,
             currentTx->GetHash().ToString(),
@@ -312,8 +400,8 @@ void CMainSignals::NotifyInstantSendDoubleSpendAttempt(const CTransactionRef& cu
 }
 
 void CMainSignals::NotifyRecoveredSig(const std::shared_ptr<const llmq::CRecoveredSig>& sig) {
-    auto event = [sig, this] {
-        m_internals->Iterate([&](CValidationInterface& callbacks) { callbacks.NotifyRecoveredSig(sig); });
+    auto event = [sig](CValidationInterface& callbacks) {
+        callbacks.NotifyRecoveredSig(sig);
     };
     ENQUEUE_AND_LOG_EVENT(event, "%s: notify recoveredsig=%s", __func__,
             sig->GetHash().ToString());
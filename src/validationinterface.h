@@ -37,8 +37,14 @@ namespace llmq {
     class CRecoveredSig;
 } // namespace llmq
 
-/** Register subscriber */
-void RegisterValidationInterface(CValidationInterface* callbacks);
+/**
+ * Register subscriber. With own_queue its background callbacks get a queue of their own, so they
+ * are interleaved with those of other subscribers instead of waiting behind their backlog. All
+ * queues are serviced on the scheduler's default lane, so no two background callbacks ever run at
+ * the same time. Each subscriber gets its callbacks in order, but a subscriber on its own queue may
+ * be ahead of or behind the others. SyncWithValidationInterfaceQueue() waits for every queue.
+ */
+void RegisterValidationInterface(CValidationInterface* callbacks, bool own_queue = false);
 /** Unregister subscriber. DEPRECATED. This is not safe to use when the RPC server or main message handler thread is running. */
 void UnregisterValidationInterface(CValidationInterface* callbacks);
 /** Unregister all subscribers */
@@ -48,8 +54,8 @@ void UnregisterAllValidationInterfaces();
 // notification is sent. These are useful for race-free cleanup, since
 // unregistration is nonblocking and can return before the last notification is
 // processed.
-/** Register subscriber */
-void RegisterSharedValidationInterface(std::shared_ptr<CValidationInterface> callbacks);
+/** Register subscriber, see RegisterValidationInterface() for own_queue */
+void RegisterSharedValidationInterface(std::shared_ptr<CValidationInterface> callbacks, bool own_queue = false);
 /** Unregister subscriber */
 void UnregisterSharedValidationInterface(std::shared_ptr<CValidationInterface> callbacks);
 
@@ -206,7 +212,7 @@ class CMainSignals {
 private:
     std::unique_ptr<MainSignalsInstance> m_internals;
 
-    friend void ::RegisterSharedValidationInterface(std::shared_ptr<CValidationInterface>);
+    friend void ::RegisterSharedValidationInterface(std::shared_ptr<CValidationInterface>, bool);
     friend void ::UnregisterValidationInterface(CValidationInterface*);
     friend void ::UnregisterAllValidationInterfaces();
     friend void ::CallFunctionInValidationInterfaceQueue(std::function<void ()> func);
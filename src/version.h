@@ -11,7 +11,7 @@
  */
 
 
-static const int PROTOCOL_VERSION = 70231;
+static const int PROTOCOL_VERSION = 70234;
 
 //! initial proto version, to be increased after version/verack negotiation
 static const int INIT_PROTO_VERSION = 209;
@@ -55,6 +55,15 @@ static const int MNLISTDIFF_CHAINLOCKS_PROTO_VERSION = 70230;
 //! Legacy ISLOCK messages and a corresponding INV were dropped in this version
 static const int NO_LEGACY_ISLOCK_PROTO_VERSION = 70231;
 
+//! Votes requested via "govsync" are sent in "govobjvotes" batches starting with this version
+static const int GOVOBJVOTES_PROTO_VERSION = 70232;
+
+//! All sig share traffic for a peer is sent in "qsigsbundle" messages starting with this version
+static const int SIGSHARES_BUNDLE_PROTO_VERSION = 70233;
+
+//! SENDCMPCTLOCKS, CMPCTISDLOCK and CMPCTCLSIG were introduced in this version
+static const int COMPACT_LOCKS_PROTO_VERSION = 70234;
+
 // Make sure that none of the values above collide with `ADDRV2_FORMAT`.
 
 #endif // BITCOIN_VERSION_H
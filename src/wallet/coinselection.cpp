@@ -7,6 +7,7 @@
 #include <policy/feerate.h>
 #include <util/system.h>
 #include <util/moneystr.h>
+#include <util/time.h>
 
 #include <coinjoin/common.h>
 
@@ -61,11 +62,16 @@ struct {
  *        that were selected.
  * @param CAmount not_input_fees -> The fees that need to be paid for the outputs and fixed size
  *        overhead (version, locktime, marker and flag)
+ * @param std::chrono::microseconds max_duration -> Wall-clock budget for the search. When it runs
+ *        out the best solution found so far is used, as if TOTAL_TRIES had been exhausted.
  */
 
 static const size_t TOTAL_TRIES = 100000;
+//! How many tries to run between checks of the clock
+static const size_t TRIES_PER_CLOCK_CHECK = 1024;
 
-bool SelectCoinsBnB(std::vector<OutputGroup>& utxo_pool, const CAmount& target_value, const CAmount& cost_of_change, std::set<CInputCoin>& out_set, CAmount& value_ret, CAmount not_input_fees)
+bool SelectCoinsBnB(std::vector<OutputGroup>& utxo_pool, const CAmount& target_value, const CAmount& cost_of_change, std::set<CInputCoin>& out_set, CAmount& value_ret, CAmount not_input_fees,
+                    std::chrono::microseconds max_duration)
 {
     out_set.clear();
     CAmount curr_value = 0;
@@ -92,8 +98,13 @@ bool SelectCoinsBnB(std::vector<OutputGroup>& utxo_pool, const CAmount& target_v
     std::vector<bool> best_selection;
     CAmount best_waste = MAX_MONEY;
 
+    const auto deadline = SteadyClock::now() + max_duration;
+
     // Depth First search loop for choosing the UTXOs
     for (size_t i = 0; i < TOTAL_TRIES; ++i) {
+        if (i > 0 && i % TRIES_PER_CLOCK_CHECK == 0 && SteadyClock::now() > deadline) {
+            break;
+        }
         // Conditions for starting a backtrack
         bool backtrack = false;
         if (curr_value + curr_available_value < actual_target ||                // Cannot possibly reach target with the amount remaining in the curr_available_value.
@@ -9,6 +9,8 @@
 #include <primitives/transaction.h>
 #include <random.h>
 
+#include <chrono>
+
 class CFeeRate;
 
 //! target minimum change amount
@@ -101,7 +103,11 @@ struct OutputGroup
     OutputGroup GetPositiveOnlyGroup();
 };
 
-bool SelectCoinsBnB(std::vector<OutputGroup>& utxo_pool, const CAmount& target_value, const CAmount& cost_of_change, std::set<CInputCoin>& out_set, CAmount& value_ret, CAmount not_input_fees);
+//! Wall-clock budget for a single Branch and Bound search, on top of its iteration limit
+static constexpr std::chrono::milliseconds DEFAULT_BNB_MAX_DURATION{100};
+
+bool SelectCoinsBnB(std::vector<OutputGroup>& utxo_pool, const CAmount& target_value, const CAmount& cost_of_change, std::set<CInputCoin>& out_set, CAmount& value_ret, CAmount not_input_fees,
+                    std::chrono::microseconds max_duration = DEFAULT_BNB_MAX_DURATION);
 
 // Original coin selection algorithm as a fallback
 bool KnapsackSolver(const CAmount& nTargetValue, std::vector<OutputGroup>& groups, std::set<CInputCoin>& setCoinsRet, CAmount& nValueRet, bool fFulyMixedOnly, CAmount maxTxFee);
@@ -336,6 +336,29 @@ public:
         }
         return result;
     }
+    std::vector<WalletTx> getWalletTxs(const std::vector<uint256>& txids) override
+    {
+        LOCK(m_wallet->cs_wallet);
+        std::vector<WalletTx> result;
+        result.reserve(txids.size());
+        for (const auto& txid : txids) {
+            auto mi = m_wallet->mapWallet.find(txid);
+            if (mi != m_wallet->mapWallet.end()) {
+                result.emplace_back(MakeWalletTx(*m_wallet, mi->second));
+            }
+        }
+        return result;
+    }
+    std::vector<uint256> getWalletTxHashes() override
+    {
+        LOCK(m_wallet->cs_wallet);
+        std::vector<uint256> result;
+        result.reserve(m_wallet->wtxOrdered.size());
+        for (auto it = m_wallet->wtxOrdered.rbegin(); it != m_wallet->wtxOrdered.rend(); ++it) {
+            result.emplace_back(it->second->GetHash());
+        }
+        return result;
+    }
     bool tryGetTxStatus(const uint256& txid,
         interfaces::WalletTxStatus& tx_status,
         int& num_blocks,
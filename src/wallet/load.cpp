@@ -131,9 +131,9 @@ void StartWallets(CScheduler& scheduler, const ArgsManager& args)
 
     // Schedule periodic wallet flushes and tx rebroadcasts
     if (args.GetBoolArg("-flushwallet", DEFAULT_FLUSHWALLET)) {
-        scheduler.scheduleEvery(MaybeCompactWalletDB, std::chrono::milliseconds{500});
+        scheduler.scheduleEvery(MaybeCompactWalletDB, std::chrono::milliseconds{500}, SchedulerLane::MAINTENANCE, "walletflush");
     }
-    scheduler.scheduleEvery(MaybeResendWalletTxs, std::chrono::milliseconds{1000});
+    scheduler.scheduleEvery(MaybeResendWalletTxs, std::chrono::milliseconds{1000}, SchedulerLane::MAINTENANCE, "walletresend");
 }
 
 void FlushWallets()
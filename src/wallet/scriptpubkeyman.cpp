@@ -11,9 +11,12 @@
 #include <util/bip32.h>
 #include <util/strencodings.h>
 #include <util/system.h>
+#include <util/threadbudget.h>
 #include <util/translation.h>
 #include <wallet/scriptpubkeyman.h>
 
+#include <future>
+
 bool LegacyScriptPubKeyMan::GetNewDestination(CTxDestination& dest, std::string& error)
 {
     LOCK(cs_KeyStore);
@@ -190,24 +193,47 @@ bool LegacyScriptPubKeyMan::CheckDecryptionKey(const CKeyingMaterial& master_key
 
         bool keyPass = mapCryptedKeys.empty(); // Always pass when there are no encrypted keys
         bool keyFail = false;
-        CryptedKeyMap::const_iterator mi = mapCryptedKeys.begin();
-        WalletBatch batch(m_storage.GetDatabase());
-        for (; mi != mapCryptedKeys.end(); ++mi)
-        {
-            const CPubKey &vchPubKey = (*mi).second.first;
-            const std::vector<unsigned char> &vchCryptedSecret = (*mi).second.second;
-            CKey key;
-            if (!DecryptKey(master_key, vchCryptedSecret, vchPubKey, key))
-            {
-                keyFail = true;
-                break;
+        if (fDecryptionThoroughlyChecked) {
+            // Checking a single key is enough once all of them were checked
+            if (!mapCryptedKeys.empty()) {
+                const auto& [vchPubKey, vchCryptedSecret] = mapCryptedKeys.begin()->second;
+                CKey key;
+                keyPass = DecryptKey(master_key, vchCryptedSecret, vchPubKey, key);
+                keyFail = !keyPass;
+            }
+        } else {
+            std::vector<const std::pair<CPubKey, std::vector<unsigned char>>*> crypted_keys;
+            crypted_keys.reserve(mapCryptedKeys.size());
+            for (const auto& [id, crypted_key] : mapCryptedKeys) {
+                crypted_keys.push_back(&crypted_key);
+            }
+            // Decrypting and verifying every key is costly for big wallets, spread it over a few threads
+            std::vector<char> decrypted(crypted_keys.size(), 0);
+            constexpr size_t MIN_PARALLEL_CHECK_KEYS{64};
+            const size_t nThreads = crypted_keys.size() < MIN_PARALLEL_CHECK_KEYS ? 1 : std::min<size_t>(GetThreadBudget(TaskPriority::BACKGROUND, 8), crypted_keys.size());
+            const auto check_part = [&](size_t first) {
+                for (size_t i = first; i < crypted_keys.size(); i += nThreads) {
+                    CKey key;
+                    decrypted[i] = DecryptKey(master_key, crypted_keys[i]->second, crypted_keys[i]->first, key);
+                }
+            };
+            std::vector<std::future<void>> workers;
+            for (size_t t = 1; t < nThreads; ++t) {
+                workers.push_back(std::async(std::launch::async, check_part, t));
+            }
+            check_part(0);
+            for (auto& worker : workers) {
+                worker.get();
             }
-            keyPass = true;
-            if (fDecryptionThoroughlyChecked)
-                break;
-            else {
+            for (const char ok : decrypted) {
+                (ok ? keyPass : keyFail) = true;
+            }
+            if (!keyFail) {
                 // Rewrite these encrypted keys with checksums
-                batch.WriteCryptedKey(vchPubKey, vchCryptedSecret, mapKeyMetadata[vchPubKey.GetID()]);
+                WalletBatch batch(m_storage.GetDatabase());
+                for (const auto* crypted_key : crypted_keys) {
+                    batch.WriteCryptedKey(crypted_key->first, crypted_key->second, mapKeyMetadata[crypted_key->first.GetID()]);
+                }
             }
         }
         if (keyPass && keyFail)
@@ -1244,8 +1270,7 @@ CPubKey LegacyScriptPubKeyMan::GenerateNewKey(WalletBatch &batch, uint32_t nAcco
     CPubKey pubkey;
     // use HD key derivation if HD was enabled during wallet creation and a non-null HD chain is present
     if (IsHDEnabled()) {
-        DeriveNewChildKey(batch, metadata, secret, nAccountIndex, fInternal);
-        pubkey = secret.GetPubKey();
+        pubkey = DeriveNewChildKey(batch, metadata, nAccountIndex, fInternal);
     } else {
         secret.MakeNewKey(fCompressed);
 
@@ -1268,50 +1293,108 @@ CPubKey LegacyScriptPubKeyMan::GenerateNewKey(WalletBatch &batch, uint32_t nAcco
     return pubkey;
 }
 
-void LegacyScriptPubKeyMan::DeriveNewChildKey(WalletBatch &batch, CKeyMetadata& metadata, CKey& secretRet, uint32_t nAccountIndex, bool fInternal)
+LegacyScriptPubKeyMan::HDChainPubKey& LegacyScriptPubKeyMan::GetHDChainPubKey(const CHDChain& hdChainCurrent, uint32_t nAccountIndex, bool fInternal)
 {
-    CHDChain hdChainTmp;
-    if (!GetHDChain(hdChainTmp)) {
-        throw std::runtime_error(std::string(__func__) + ": GetHDChain failed");
+    AssertLockHeld(cs_KeyStore);
+    HDChainPubKey& chain = m_hd_chain_pubkeys[{nAccountIndex, fInternal}];
+    if (chain.hdchain_id == hdChainCurrent.GetID() && !chain.hdchain_id.IsNull()) {
+        return chain;
     }
 
+    CHDChain hdChainTmp(hdChainCurrent);
     if (!DecryptHDChain(m_storage.GetEncryptionKey(), hdChainTmp))
         throw std::runtime_error(std::string(__func__) + ": DecryptHDChain failed");
     // make sure seed matches this chain
     if (hdChainTmp.GetID() != hdChainTmp.GetSeedHash())
         throw std::runtime_error(std::string(__func__) + ": Wrong HD chain!");
 
+    CExtKey chainKey;
+    KeyOriginInfo chain_origin;
+    hdChainTmp.DeriveChainExtKey(nAccountIndex, fInternal, chainKey, chain_origin);
+    chain.hdchain_id = hdChainTmp.GetID();
+    chain.chain_pubkey = chainKey.Neuter();
+    chain.chain_origin = chain_origin;
+    chain.children.clear();
+    return chain;
+}
+
+void LegacyScriptPubKeyMan::PrederiveHDChildKeys(uint32_t nAccountIndex, bool fInternal, uint32_t count)
+{
+    AssertLockHeld(cs_KeyStore);
+    // Not worth starting threads for
+    constexpr uint32_t MIN_PREDERIVE_KEYS{64};
+    if (count < MIN_PREDERIVE_KEYS) return;
+
+    CHDChain hdChainCurrent;
     CHDAccount acc;
-    if (!hdChainTmp.GetAccount(nAccountIndex, acc))
+    if (!GetHDChain(hdChainCurrent) || !hdChainCurrent.GetAccount(nAccountIndex, acc)) return;
+    HDChainPubKey& chain = GetHDChainPubKey(hdChainCurrent, nAccountIndex, fInternal);
+
+    const uint32_t nFirstIndex = fInternal ? acc.nInternalChainCounter : acc.nExternalChainCounter;
+    std::vector<std::optional<CExtPubKey>> children(count);
+    const size_t nThreads = std::min<size_t>(GetThreadBudget(TaskPriority::BACKGROUND, 8), count);
+    std::vector<std::future<void>> workers;
+    for (size_t t = 0; t < nThreads; ++t) {
+        workers.push_back(std::async(std::launch::async, [&, t] {
+            for (size_t i = t; i < children.size(); i += nThreads) {
+                CExtPubKey child;
+                if (chain.chain_pubkey.Derive(child, nFirstIndex + i)) {
+                    children[i] = child;
+                }
+            }
+        }));
+    }
+    for (auto& worker : workers) {
+        worker.get();
+    }
+
+    // Keys which failed to derive are left to DeriveNewChildKey
+    for (size_t i = 0; i < children.size(); ++i) {
+        if (children[i]) chain.children.emplace(nFirstIndex + i, *children[i]);
+    }
+}
+
+CPubKey LegacyScriptPubKeyMan::DeriveNewChildKey(WalletBatch &batch, CKeyMetadata& metadata, uint32_t nAccountIndex, bool fInternal)
+{
+    CHDChain hdChainCurrent;
+    if (!GetHDChain(hdChainCurrent)) {
+        throw std::runtime_error(std::string(__func__) + ": GetHDChain failed");
+    }
+
+    CHDAccount acc;
+    if (!hdChainCurrent.GetAccount(nAccountIndex, acc))
         throw std::runtime_error(std::string(__func__) + ": Wrong HD account!");
 
+    // Address keys use non-hardened derivation, so they can be derived from the public key of their chain
+    HDChainPubKey& chain = GetHDChainPubKey(hdChainCurrent, nAccountIndex, fInternal);
+
     // derive child key at next index, skip keys already known to the wallet
-    CExtKey childKey;
-    KeyOriginInfo key_origin_tmp;
+    CExtPubKey childKey;
     uint32_t nChildIndex = fInternal ? acc.nInternalChainCounter : acc.nExternalChainCounter;
     do {
-        // NOTE: DeriveChildExtKey updates key_origin, make sure to clear it.
-        key_origin_tmp.clear();
-        hdChainTmp.DeriveChildExtKey(nAccountIndex, fInternal, nChildIndex, childKey, key_origin_tmp);
+        // drop keys derived ahead for indexes the counter has moved past since
+        chain.children.erase(chain.children.begin(), chain.children.lower_bound(nChildIndex));
+        if (!chain.children.empty() && chain.children.begin()->first == nChildIndex) {
+            childKey = chain.children.begin()->second;
+            chain.children.erase(chain.children.begin());
+        } else if (!chain.chain_pubkey.Derive(childKey, nChildIndex)) {
+            throw std::runtime_error(std::string(__func__) + ": Derive failed");
+        }
         // increment childkey index
         nChildIndex++;
-    } while (HaveKey(childKey.key.GetPubKey().GetID()));
-    metadata.key_origin = key_origin_tmp;
+    } while (HaveKey(childKey.pubkey.GetID()));
+    metadata.key_origin = chain.chain_origin;
+    metadata.key_origin.path.push_back(nChildIndex - 1);
     assert(!metadata.has_key_origin);
     metadata.has_key_origin = true;
-    secretRet = childKey.key;
 
-    CPubKey pubkey = secretRet.GetPubKey();
-    assert(secretRet.VerifyPubKey(pubkey));
+    const CPubKey& pubkey = childKey.pubkey;
 
     // store metadata
     mapKeyMetadata[pubkey.GetID()] = metadata;
     UpdateTimeFirstKey(metadata.nCreateTime);
 
     // update the chain model in the database
-    CHDChain hdChainCurrent;
-    GetHDChain(hdChainCurrent);
-
     if (fInternal) {
         acc.nInternalChainCounter = nChildIndex;
     }
@@ -1331,8 +1414,10 @@ void LegacyScriptPubKeyMan::DeriveNewChildKey(WalletBatch &batch, CKeyMetadata&
             throw std::runtime_error(std::string(__func__) + ": SetHDChain failed");
     }
 
-    if (!AddHDPubKey(batch, childKey.Neuter(), fInternal))
+    if (!AddHDPubKey(batch, childKey, fInternal))
         throw std::runtime_error(std::string(__func__) + ": AddHDPubKey failed");
+
+    return pubkey;
 }
 
 void LegacyScriptPubKeyMan::LoadKeyPool(int64_t nIndex, const CKeyPool &keypool)
@@ -1443,15 +1528,31 @@ bool LegacyScriptPubKeyMan::TopUpInner(unsigned int kpSize)
             m_storage.UpdateProgress(strMsg, 0);
         }
 
+        // Commit new keys in groups instead of one database transaction per record
+        constexpr int64_t KEYS_PER_TRANSACTION = 1000;
+
+        if (IsHDEnabled()) {
+            PrederiveHDChildKeys(0, false, missingExternal);
+            PrederiveHDChildKeys(0, true, missingInternal);
+        }
+
         bool fInternal = false;
         int64_t current_index{0};
         WalletBatch batch(m_storage.GetDatabase());
+        bool in_txn{false};
 
         for (current_index = 0; current_index < total_missing; ++current_index) {
             if (current_index == missingExternal) {
                 fInternal = true;
             }
 
+            if (current_index % KEYS_PER_TRANSACTION == 0) {
+                if (in_txn && !batch.TxnCommit()) {
+                    throw std::runtime_error(std::string(__func__) + ": committing keypool keys failed");
+                }
+                in_txn = batch.TxnBegin();
+            }
+
             // TODO: implement keypools for all accounts?
             CPubKey pubkey(GenerateNewKey(batch, 0, fInternal));
             AddKeypoolPubkeyWithDB(pubkey, fInternal, batch);
@@ -1466,6 +1567,9 @@ bool LegacyScriptPubKeyMan::TopUpInner(unsigned int kpSize)
                 }
             }
         }
+        if (in_txn && !batch.TxnCommit()) {
+            throw std::runtime_error(std::string(__func__) + ": committing keypool keys failed");
+        }
         WalletLogPrintf("Keypool added %d keys, size=%u (%u internal)\n",
                   current_index + 1, setInternalKeyPool.size() + setExternalKeyPool.size(), setInternalKeyPool.size());
         if (should_show_progress) {
@@ -1757,6 +1861,34 @@ std::set<CKeyID> LegacyScriptPubKeyMan::GetKeys() const
     return set_address;
 }
 
+std::vector<CScript> LegacyScriptPubKeyMan::GetScriptPubKeys() const
+{
+    LOCK(cs_KeyStore);
+    std::vector<CScript> ret;
+    const auto add_pubkey = [&ret](const CPubKey& pubkey) {
+        ret.push_back(GetScriptForRawPubKey(pubkey));
+        ret.push_back(GetScriptForDestination(PKHash(pubkey)));
+    };
+    for (const auto& [_, key] : mapKeys) {
+        add_pubkey(key.GetPubKey());
+    }
+    for (const auto& [_, crypted] : mapCryptedKeys) {
+        add_pubkey(crypted.first);
+    }
+    for (const auto& [_, hdpubkey] : mapHdPubKeys) {
+        add_pubkey(hdpubkey.extPubKey.pubkey);
+    }
+    for (const auto& [_, pubkey] : mapWatchKeys) {
+        add_pubkey(pubkey);
+    }
+    for (const auto& [_, script] : mapScripts) {
+        ret.push_back(script);
+        ret.push_back(GetScriptForDestination(ScriptHash(script)));
+    }
+    ret.insert(ret.end(), setWatchOnly.begin(), setWatchOnly.end());
+    return ret;
+}
+
 bool LegacyScriptPubKeyMan::GetHDChain(CHDChain& hdChainRet) const
 {
     LOCK(cs_KeyStore);
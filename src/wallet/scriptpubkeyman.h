@@ -279,7 +279,22 @@ private:
     CHDChain cryptedHDChain GUARDED_BY(cs_KeyStore);
 
     /* HD derive new child key (on internal or external chain) */
-    void DeriveNewChildKey(WalletBatch& batch, CKeyMetadata& metadata, CKey& secretRet, uint32_t nAccountIndex, bool fInternal /*= false*/) EXCLUSIVE_LOCKS_REQUIRED(cs_KeyStore);
+    CPubKey DeriveNewChildKey(WalletBatch& batch, CKeyMetadata& metadata, uint32_t nAccountIndex, bool fInternal /*= false*/) EXCLUSIVE_LOCKS_REQUIRED(cs_KeyStore);
+
+    /** Public key of an HD chain, new keypool keys are derived from it without decrypting the seed again */
+    struct HDChainPubKey {
+        uint256 hdchain_id;
+        CExtPubKey chain_pubkey;
+        KeyOriginInfo chain_origin;
+        //! Child keys derived ahead of use by PrederiveHDChildKeys, by child index
+        std::map<uint32_t, CExtPubKey> children;
+    };
+    /** Cached chain keys by account and whether the chain is the internal one */
+    std::map<std::pair<uint32_t, bool>, HDChainPubKey> m_hd_chain_pubkeys GUARDED_BY(cs_KeyStore);
+    /** Get the cached key of a chain of hdChainCurrent, deriving it from the decrypted seed when it isn't cached yet */
+    HDChainPubKey& GetHDChainPubKey(const CHDChain& hdChainCurrent, uint32_t nAccountIndex, bool fInternal) EXCLUSIVE_LOCKS_REQUIRED(cs_KeyStore);
+    /** Derive the next count child keys of a chain in parallel, for DeriveNewChildKey to pick up */
+    void PrederiveHDChildKeys(uint32_t nAccountIndex, bool fInternal, uint32_t count) EXCLUSIVE_LOCKS_REQUIRED(cs_KeyStore);
 
     std::set<int64_t> setInternalKeyPool GUARDED_BY(cs_KeyStore);
     std::set<int64_t> setExternalKeyPool GUARDED_BY(cs_KeyStore);
@@ -481,8 +496,17 @@ public:
      */
     void MarkReserveKeysAsUsed(int64_t keypool_id) EXCLUSIVE_LOCKS_REQUIRED(cs_KeyStore);
     const std::map<CKeyID, int64_t>& GetAllReserveKeys() const { return m_pool_key_to_index; }
+    //! Highest keypool index used so far, grows whenever the keypool is topped up
+    int64_t GetMaxKeyPoolIndex() const { LOCK(cs_KeyStore); return m_max_keypool_index; }
 
     std::set<CKeyID> GetKeys() const override;
+
+    /**
+     * All scriptPubKeys outputs to this wallet can have: P2PK and P2PKH for
+     * every key, P2SH and bare for every script, and the watch-only scripts.
+     * May include scripts that are not actually IsMine, never misses one.
+     */
+    std::vector<CScript> GetScriptPubKeys() const;
 };
 
 /** Wraps a LegacyScriptPubKeyMan so that it can be returned in a new unique_ptr. Does not provide privkeys */
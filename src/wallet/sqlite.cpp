@@ -238,6 +238,13 @@ void SQLiteDatabase::Open()
     // Enable fullfsync for the platforms that use it
     SetPragma(m_db, "fullfsync", "true", "Failed to enable fullfsync");
 
+    if (!m_mock) {
+        // Use write-ahead logging so that a commit only has to sync the log instead of both the
+        // rollback journal and the database file. Because the locking mode is already exclusive,
+        // no shared-memory index is created next to the wallet file.
+        SetPragma(m_db, "journal_mode", "WAL", "Failed to enable write-ahead logging");
+    }
+
     if (gArgs.GetBoolArg("-unsafesqlitesync", false)) {
         // Use normal synchronous mode for the journal
         LogPrintf("WARNING SQLite is configured to not wait for data to be flushed to disk. Data loss and corruption may occur.\n");
@@ -282,6 +289,16 @@ void SQLiteDatabase::Open()
     }
 }
 
+void SQLiteDatabase::Flush()
+{
+    if (!m_db || m_mock) return;
+    // Move everything committed to the write-ahead log into the database file
+    int ret = sqlite3_exec(m_db, "PRAGMA wal_checkpoint(TRUNCATE)", nullptr, nullptr, nullptr);
+    if (ret != SQLITE_OK) {
+        LogPrintf("SQLiteDatabase: Failed to checkpoint the write-ahead log: %s\n", sqlite3_errstr(ret));
+    }
+}
+
 bool SQLiteDatabase::Rewrite(const char* skip)
 {
     // Rewrite the database using the VACUUM command: https://sqlite.org/lang_vacuum.html
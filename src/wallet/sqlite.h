@@ -90,15 +90,18 @@ public:
      */
     bool Backup(const std::string& dest) const override;
 
+    /** Checkpoint the write-ahead log into the database file */
+    void Flush() override;
+
     /** No-ops
      *
-     * SQLite always flushes everything to the database file after each transaction
+     * SQLite makes every transaction durable in the write-ahead log on commit
      * (each Read/Write/Erase that we do is its own transaction unless we called
-     * TxnBegin) so there is no need to have Flush or Periodic Flush.
+     * TxnBegin) and checkpoints the log on its own, so there is no need for a
+     * Periodic Flush.
      *
      * There is no DB env to reload, so ReloadDbEnv has nothing to do
      */
-    void Flush() override {}
     bool PeriodicFlush() override { return false; }
     void ReloadDbEnv() override {}
 
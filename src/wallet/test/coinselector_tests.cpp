@@ -231,6 +231,16 @@ BOOST_AUTO_TEST_CASE(bnb_search_test)
     target = make_hard_case(14, utxo_pool);
     BOOST_CHECK(SelectCoinsBnB(GroupCoins(utxo_pool), target, 0, selection, value_ret, not_input_fees)); // Should not exhaust
 
+    // Time budget test: an exhausted budget stops the search but keeps solutions found before the first clock check
+    target = make_hard_case(17, utxo_pool);
+    BOOST_CHECK(!SelectCoinsBnB(GroupCoins(utxo_pool), target, 0, selection, value_ret, not_input_fees, std::chrono::microseconds{0}));
+    utxo_pool.clear();
+    add_coin(1 * CENT, 1, utxo_pool);
+    add_coin(2 * CENT, 2, utxo_pool);
+    BOOST_CHECK(SelectCoinsBnB(GroupCoins(utxo_pool), 2 * CENT, 0, selection, value_ret, not_input_fees, std::chrono::microseconds{0}));
+    BOOST_CHECK_EQUAL(value_ret, 2 * CENT);
+    selection.clear();
+
     // Test same value early bailout optimization
     utxo_pool.clear();
     add_coin(7 * CENT, 7, actual_selection);
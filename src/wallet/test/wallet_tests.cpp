@@ -1190,6 +1190,36 @@ BOOST_FIXTURE_TEST_CASE(select_coins_grouped_by_addresses, ListCoinsTestingSetup
     BOOST_CHECK_EQUAL(wallet->GetAvailableBalance(), (500 + 499) * COIN);
 }
 
+BOOST_FIXTURE_TEST_CASE(balance_cache, ListCoinsTestingSetup)
+{
+    // Passing coin control bypasses the cache, which gives the freshly computed balance to compare against
+    CCoinControl coin_control;
+
+    const CWallet::Balance before = wallet->GetBalance();
+    BOOST_CHECK_EQUAL(before.m_mine_trusted, 500 * COIN);
+    BOOST_CHECK_EQUAL(wallet->GetBalance().m_mine_immature, before.m_mine_immature);
+    BOOST_CHECK_EQUAL(wallet->GetBalance(0, true, false, &coin_control).m_mine_immature, before.m_mine_immature);
+
+    // A new block matures the next coinbase, so the cached balance has to be dropped
+    const CBlock block = CreateAndProcessBlock({}, GetScriptForRawPubKey(coinbaseKey.GetPubKey()));
+    wallet->blockConnected(block, ::ChainActive().Height());
+    const CWallet::Balance after = wallet->GetBalance();
+    BOOST_CHECK_EQUAL(after.m_mine_trusted, 1000 * COIN);
+    BOOST_CHECK_EQUAL(after.m_mine_trusted, wallet->GetBalance(0, true, false, &coin_control).m_mine_trusted);
+    BOOST_CHECK_EQUAL(after.m_mine_immature, wallet->GetBalance(0, true, false, &coin_control).m_mine_immature);
+
+    // Spending from the wallet changes it as well
+    CTransactionRef tx;
+    CAmount fee;
+    int changePos = -1;
+    bilingual_str error;
+    BOOST_CHECK(wallet->CreateTransaction({CRecipient{GetScriptForRawPubKey({}), 100 * COIN, true /* subtract fee */}},
+                                          tx, fee, changePos, error, coin_control));
+    wallet->CommitTransaction(tx, {}, {});
+    BOOST_CHECK_EQUAL(wallet->GetBalance().m_mine_trusted, wallet->GetBalance(0, true, false, &coin_control).m_mine_trusted);
+    BOOST_CHECK(wallet->GetBalance().m_mine_trusted < after.m_mine_trusted);
+}
+
 BOOST_FIXTURE_TEST_CASE(wallet_disableprivkeys, TestChain100Setup)
 {
     NodeContext node;
@@ -6,6 +6,7 @@
 
 #include <wallet/wallet.h>
 
+#include <blockfilter.h>
 #include <chain.h>
 #include <chainparams.h>
 #include <consensus/consensus.h>
@@ -32,6 +33,7 @@
 #include <util/fees.h>
 #include <util/moneystr.h>
 #include <util/string.h>
+#include <util/threadbudget.h>
 #include <util/translation.h>
 #ifdef USE_BDB
 #include <wallet/bdb.h>
@@ -49,6 +51,8 @@
 
 #include <algorithm>
 #include <assert.h>
+#include <deque>
+#include <future>
 
 using interfaces::FoundBlock;
 
@@ -574,10 +578,31 @@ bool CWallet::IsSpent(const uint256& hash, unsigned int n) const
     return false;
 }
 
+bool CWallet::AddWalletUTXO(const COutPoint& outpoint, CAmount nValue)
+{
+    AssertLockHeld(cs_wallet);
+    if (!setWalletUTXO.insert(outpoint).second) return false;
+    if (const int nDenom = CoinJoin::AmountToDenomination(nValue); nDenom > 0) {
+        mapDenominatedUTXO[nDenom].insert(outpoint);
+    }
+    return true;
+}
+
+void CWallet::EraseWalletUTXO(const COutPoint& outpoint)
+{
+    AssertLockHeld(cs_wallet);
+    if (setWalletUTXO.erase(outpoint) == 0) return;
+    const auto it = mapWallet.find(outpoint.hash);
+    if (it == mapWallet.end() || outpoint.n >= it->second.tx->vout.size()) return;
+    if (const int nDenom = CoinJoin::AmountToDenomination(it->second.tx->vout[outpoint.n].nValue); nDenom > 0) {
+        mapDenominatedUTXO[nDenom].erase(outpoint);
+    }
+}
+
 void CWallet::AddToSpends(const COutPoint& outpoint, const uint256& wtxid)
 {
     mapTxSpends.insert(std::make_pair(outpoint, wtxid));
-    setWalletUTXO.erase(outpoint);
+    EraseWalletUTXO(outpoint);
 
     setLockedCoins.erase(outpoint);
 
@@ -882,7 +907,7 @@ CWalletTx* CWallet::AddToWallet(CTransactionRef tx, const CWalletTx::Confirmatio
         std::vector<std::pair<const CTransactionRef&, unsigned int>> outputs;
         for(unsigned int i = 0; i < wtx.tx->vout.size(); ++i) {
             if (IsMine(wtx.tx->vout[i]) && !IsSpent(hash, i)) {
-                setWalletUTXO.insert(COutPoint(hash, i));
+                AddWalletUTXO(COutPoint(hash, i), wtx.tx->vout[i].nValue);
                 outputs.emplace_back(wtx.tx, i);
             }
         }
@@ -908,7 +933,7 @@ CWalletTx* CWallet::AddToWallet(CTransactionRef tx, const CWalletTx::Confirmatio
         std::vector<std::pair<const CTransactionRef&, unsigned int>> outputs;
         for(unsigned int i = 0; i < wtx.tx->vout.size(); ++i) {
             if (IsMine(wtx.tx->vout[i]) && !IsSpent(hash, i)) {
-                bool new_utxo = setWalletUTXO.insert(COutPoint(hash, i)).second;
+                bool new_utxo = AddWalletUTXO(COutPoint(hash, i), wtx.tx->vout[i].nValue);
                 if (new_utxo) {
                     outputs.emplace_back(wtx.tx, i);
                     fUpdated = true;
@@ -967,27 +992,7 @@ bool CWallet::LoadToWallet(const uint256& hash, const UpdateWalletTxFn& fill_wtx
     if (!fill_wtx(wtx, ins.second)) {
         return false;
     }
-    // If wallet doesn't have a chain (e.g maximus-wallet), don't bother to update txn.
-    if (HaveChain()) {
-        bool active;
-        int height;
-        if (chain().findBlock(wtx.m_confirm.hashBlock, FoundBlock().inActiveChain(active).height(height)) && active) {
-            // Update cached block height variable since it not stored in the
-            // serialized transaction.
-            wtx.m_confirm.block_height = height;
-        } else if (wtx.isConflicted() || wtx.isConfirmed()) {
-            // If tx block (or conflicting block) was reorged out of chain
-            // while the wallet was shutdown, change tx status to UNCONFIRMED
-            // and reset block height, hash, and index. ABANDONED tx don't have
-            // associated blocks and don't need to be updated. The case where a
-            // transaction was reorged out while online and then reconfirmed
-            // while offline is covered by the rescan logic.
-            wtx.setUnconfirmed();
-            wtx.m_confirm.hashBlock = uint256();
-            wtx.m_confirm.block_height = 0;
-            wtx.m_confirm.nIndex = 0;
-        }
-    }
+    UpdateLoadedTxChainState(wtx);
     if (/* insertion took place */ ins.second) {
         wtx.m_it_wtxOrdered = wtxOrdered.insert(std::make_pair(wtx.nOrderPos, &wtx));
     }
@@ -1004,6 +1009,107 @@ bool CWallet::LoadToWallet(const uint256& hash, const UpdateWalletTxFn& fill_wtx
     return true;
 }
 
+std::vector<bool> CWallet::LoadToWallet(const std::vector<uint256>& hashes, const FillWalletTxFn& fill_wtx)
+{
+    AssertLockHeld(cs_wallet);
+
+    std::vector<CWalletTx*> wtxs(hashes.size(), nullptr);
+    for (size_t i = 0; i < hashes.size(); ++i) {
+        const auto ins = mapWallet.emplace(std::piecewise_construct, std::forward_as_tuple(hashes[i]), std::forward_as_tuple(this, nullptr));
+        // the database can't have duplicates, leave anything loaded before alone
+        if (ins.second) wtxs[i] = &ins.first->second;
+    }
+
+    // Each transaction is only touched by one thread, std::vector<bool> can't be written concurrently
+    std::vector<char> filled(hashes.size(), 0);
+    const auto fill_part = [&](size_t first, size_t step) {
+        for (size_t i = first; i < wtxs.size(); i += step) {
+            filled[i] = wtxs[i] != nullptr && fill_wtx(i, *wtxs[i]);
+        }
+    };
+    // Not worth starting threads for
+    constexpr size_t MIN_PARALLEL_LOAD_TXS{256};
+    const size_t nThreads = hashes.size() < MIN_PARALLEL_LOAD_TXS ? 1 : std::min<size_t>(GetThreadBudget(TaskPriority::BACKGROUND, 8), hashes.size());
+    std::vector<std::future<void>> workers;
+    for (size_t t = 1; t < nThreads; ++t) {
+        workers.push_back(std::async(std::launch::async, fill_part, t, nThreads));
+    }
+    fill_part(0, nThreads);
+    for (auto& worker : workers) {
+        worker.get();
+    }
+
+    std::vector<bool> ret(hashes.size(), false);
+    std::vector<std::pair<COutPoint, uint256>> spends;
+    for (size_t i = 0; i < hashes.size(); ++i) {
+        if (!filled[i]) {
+            if (wtxs[i] != nullptr) mapWallet.erase(hashes[i]);
+            continue;
+        }
+        CWalletTx& wtx = *wtxs[i];
+        UpdateLoadedTxChainState(wtx);
+        wtx.m_it_wtxOrdered = wtxOrdered.insert(std::make_pair(wtx.nOrderPos, &wtx));
+        if (!wtx.IsCoinBase()) {
+            for (const CTxIn& txin : wtx.tx->vin) {
+                spends.emplace_back(txin.prevout, hashes[i]);
+            }
+        }
+        ret[i] = true;
+    }
+
+    // Sorted, so that every insert lands at the end of mapTxSpends
+    std::sort(spends.begin(), spends.end());
+    for (const auto& [outpoint, wtxid] : spends) {
+        mapTxSpends.emplace_hint(mapTxSpends.end(), outpoint, wtxid);
+        EraseWalletUTXO(outpoint);
+        setLockedCoins.erase(outpoint);
+    }
+    // The transactions spending the same outpoint only need their metadata synced once, with all of them known
+    for (auto it = mapTxSpends.begin(); it != mapTxSpends.end();) {
+        const auto range = mapTxSpends.equal_range(it->first);
+        if (std::next(range.first) != range.second) {
+            SyncMetaData(range);
+        }
+        it = range.second;
+    }
+
+    for (size_t i = 0; i < hashes.size(); ++i) {
+        if (!ret[i]) continue;
+        for (const CTxIn& txin : wtxs[i]->tx->vin) {
+            auto it = mapWallet.find(txin.prevout.hash);
+            if (it != mapWallet.end() && it->second.isConflicted()) {
+                MarkConflicted(it->second.m_confirm.hashBlock, it->second.m_confirm.block_height, hashes[i]);
+            }
+        }
+    }
+    return ret;
+}
+
+void CWallet::UpdateLoadedTxChainState(CWalletTx& wtx)
+{
+    // If wallet doesn't have a chain (e.g maximus-wallet), don't bother to update txn.
+    if (!HaveChain()) return;
+
+    bool active;
+    int height;
+    if (chain().findBlock(wtx.m_confirm.hashBlock, FoundBlock().inActiveChain(active).height(height)) && active) {
+        // Update cached block height variable since it not stored in the
+        // serialized transaction.
+        wtx.m_confirm.block_height = height;
+    } else if (wtx.isConflicted() || wtx.isConfirmed()) {
+        // If tx block (or conflicting block) was reorged out of chain
+        // while the wallet was shutdown, change tx status to UNCONFIRMED
+        // and reset block height, hash, and index. ABANDONED tx don't have
+        // associated blocks and don't need to be updated. The case where a
+        // transaction was reorged out while online and then reconfirmed
+        // while offline is covered by the rescan logic.
+        wtx.setUnconfirmed();
+        wtx.m_confirm.hashBlock = uint256();
+        wtx.m_confirm.block_height = 0;
+        wtx.m_confirm.nIndex = 0;
+    }
+}
+
 bool CWallet::AddToWalletIfInvolvingMe(const CTransactionRef& ptx, CWalletTx::Confirmation confirm, WalletBatch& batch, bool fUpdate)
 {
     const CTransaction& tx = *ptx;
@@ -1226,6 +1332,7 @@ void CWallet::transactionAddedToMempool(const CTransactionRef& tx, int64_t nAcce
     auto it = mapWallet.find(tx->GetHash());
     if (it != mapWallet.end()) {
         it->second.fInMempool = true;
+        MarkBalanceDirty();
     }
 }
 
@@ -1235,6 +1342,7 @@ void CWallet::transactionRemovedFromMempool(const CTransactionRef& tx, MemPoolRe
         auto it = mapWallet.find(tx->GetHash());
         if (it != mapWallet.end()) {
             it->second.fInMempool = false;
+            MarkBalanceDirty();
         }
     }
     // Handle transactions that were removed from the mempool because they
@@ -1286,6 +1394,7 @@ void CWallet::blockConnected(const CBlock& block, int height)
     // reset cache to make sure no longer immature coins are included
     fAnonymizableTallyCached = false;
     fAnonymizableTallyCachedNonDenom = false;
+    MarkBalanceDirty();
 }
 
 void CWallet::blockDisconnected(const CBlock& block, int height)
@@ -1306,6 +1415,7 @@ void CWallet::blockDisconnected(const CBlock& block, int height)
     // reset cache to make sure no longer mature coins are excluded
     fAnonymizableTallyCached = false;
     fAnonymizableTallyCachedNonDenom = false;
+    MarkBalanceDirty();
 }
 
 void CWallet::updatedBlockTip()
@@ -1921,6 +2031,72 @@ int64_t CWallet::RescanFromTime(int64_t startTime, const WalletRescanReserver& r
     return startTime;
 }
 
+namespace {
+//! How many blocks a rescan reads ahead of the one it is scanning
+constexpr size_t RESCAN_PREFETCH_BLOCKS{8};
+
+struct RescanBlock {
+    uint256 hash;
+    int height{0};
+    //! What the block filter says about the block, nullopt if it was not consulted
+    std::optional<bool> filter_match;
+    //! The block being read, unless the filter ruled it out
+    std::future<CBlock> data;
+};
+
+/**
+ * Tells from the compact block filters whether a block can contain anything
+ * for the wallet, so that a rescan only reads the blocks that may matter.
+ */
+class FastWalletRescanFilter
+{
+public:
+    explicit FastWalletRescanFilter(const CWallet& wallet) : m_wallet(wallet)
+    {
+        if (const LegacyScriptPubKeyMan* spk_man = m_wallet.GetLegacyScriptPubKeyMan()) {
+            m_max_keypool_index = spk_man->GetMaxKeyPoolIndex();
+            for (const CScript& script : spk_man->GetScriptPubKeys()) {
+                AddScript(script);
+            }
+        }
+    }
+
+    //! Add the keys the keypool was topped up with since the last call, return whether there were any
+    bool UpdateIfNeeded()
+    {
+        LegacyScriptPubKeyMan* spk_man = m_wallet.GetLegacyScriptPubKeyMan();
+        if (!spk_man || spk_man->GetMaxKeyPoolIndex() == m_max_keypool_index) return false;
+
+        LOCK(spk_man->cs_KeyStore);
+        m_max_keypool_index = spk_man->GetMaxKeyPoolIndex();
+        const size_t old_size = m_filter_set.size();
+        for (const auto& [keyid, _] : spk_man->GetAllReserveKeys()) {
+            CPubKey pubkey;
+            if (spk_man->GetPubKey(keyid, pubkey)) {
+                AddScript(GetScriptForRawPubKey(pubkey));
+                AddScript(GetScriptForDestination(PKHash(pubkey)));
+            }
+        }
+        return m_filter_set.size() != old_size;
+    }
+
+    std::optional<bool> MatchesBlock(const uint256& block_hash) const
+    {
+        return m_wallet.chain().blockFilterMatchesAny(BlockFilterType::BASIC_FILTER, block_hash, m_filter_set);
+    }
+
+private:
+    void AddScript(const CScript& script)
+    {
+        m_filter_set.emplace(script.begin(), script.end());
+    }
+
+    const CWallet& m_wallet;
+    int64_t m_max_keypool_index{0};
+    GCSFilter::ElementSet m_filter_set;
+};
+} // namespace
+
 /**
  * Scan the block chain (starting in start_block) for transactions
  * from or to us. If fUpdate is true, found transactions that already
@@ -1965,7 +2141,65 @@ CWallet::ScanResult CWallet::ScanForWalletTransactions(const uint256& start_bloc
     double progress_current = progress_begin;
     int block_height = start_height;
     WalletBatch batch(GetDatabase());
-    while (!fAbortRescan && !chain().shutdownRequested()) {
+
+    std::unique_ptr<FastWalletRescanFilter> fast_rescan_filter;
+    if (chain().hasBlockFilterIndex(BlockFilterType::BASIC_FILTER)) {
+        fast_rescan_filter = std::make_unique<FastWalletRescanFilter>(*this);
+        WalletLogPrintf("Rescan skips blocks whose block filter matches none of the wallet's scripts\n");
+    }
+
+    // Blocks ahead of the one being scanned. Their data is read on background
+    // threads in the meantime, unless the block filter rules them out.
+    std::deque<RescanBlock> queue;
+    std::optional<uint256> queue_next_hash{start_block};
+    int queue_next_height = start_height;
+    uint256 last_queued_hash;
+    bool queued_max_height = false;
+    const auto read_block = [this](RescanBlock& entry) {
+        entry.data = std::async(std::launch::async, [this, hash = entry.hash] {
+            CBlock block;
+            chain().findBlock(hash, FoundBlock().data(block));
+            return block;
+        });
+    };
+    const auto fill_queue = [&] {
+        if (!queue_next_hash && !queued_max_height && queue.empty() && !last_queued_hash.IsNull()) {
+            // The scan caught up with the queue, see whether the tip moved on in the meantime
+            bool next_block = false;
+            uint256 next_block_hash;
+            chain().findBlock(last_queued_hash, FoundBlock().nextBlock(FoundBlock().inActiveChain(next_block).hash(next_block_hash)));
+            if (next_block) queue_next_hash = next_block_hash;
+        }
+        while (queue_next_hash && queue.size() < RESCAN_PREFETCH_BLOCKS) {
+            RescanBlock& entry = queue.emplace_back();
+            entry.hash = *queue_next_hash;
+            entry.height = queue_next_height;
+            if (fast_rescan_filter) entry.filter_match = fast_rescan_filter->MatchesBlock(entry.hash);
+            if (entry.filter_match != false) read_block(entry);
+
+            last_queued_hash = entry.hash;
+            queue_next_hash.reset();
+            if (max_height && queue_next_height >= *max_height) {
+                queued_max_height = true;
+                break;
+            }
+            bool next_block = false;
+            uint256 next_block_hash;
+            chain().findBlock(last_queued_hash, FoundBlock().nextBlock(FoundBlock().inActiveChain(next_block).hash(next_block_hash)));
+            if (next_block) {
+                queue_next_hash = next_block_hash;
+                ++queue_next_height;
+            }
+        }
+    };
+
+    fill_queue();
+    while (!queue.empty() && !fAbortRescan && !chain().shutdownRequested()) {
+        RescanBlock entry = std::move(queue.front());
+        queue.pop_front();
+        block_hash = entry.hash;
+        block_height = entry.height;
+
         if (progress_end - progress_begin > 0.0) {
             m_scanning_progress = (progress_current - progress_begin) / (progress_end - progress_begin);
         } else { // avoid divide-by-zero for single block scan range (i.e. start and stop hashes are equal)
@@ -1979,51 +2213,55 @@ CWallet::ScanResult CWallet::ScanForWalletTransactions(const uint256& start_bloc
             WalletLogPrintf("Still rescanning. At block %d. Progress=%f\n", block_height, progress_current);
         }
 
-        // Read block data
-        CBlock block;
-        chain().findBlock(block_hash, FoundBlock().data(block));
-
-        // Find next block separately from reading data above, because reading
-        // is slow and there might be a reorg while it is read.
-        bool block_still_active = false;
-        bool next_block = false;
-        uint256 next_block_hash;
-        chain().findBlock(block_hash, FoundBlock().inActiveChain(block_still_active).nextBlock(FoundBlock().inActiveChain(next_block).hash(next_block_hash)));
-
-        if (!block.IsNull()) {
-            LOCK(cs_wallet);
-            if (!block_still_active) {
-                // Abort scan if current block is no longer active, to prevent
-                // marking transactions as coming from the wrong block.
-                result.last_failed_block = block_hash;
-                result.status = ScanResult::FAILURE;
-                break;
-            }
-            for (size_t posInBlock = 0; posInBlock < block.vtx.size(); ++posInBlock) {
-                SyncTransaction(block.vtx[posInBlock], {CWalletTx::Status::CONFIRMED, block_height, block_hash, (int)posInBlock}, batch, fUpdate);
-            }
-            // scan succeeded, record block as most recent successfully scanned
+        if (entry.filter_match == false) {
+            // Nothing in this block pays to or spends from the wallet
             result.last_scanned_block = block_hash;
             result.last_scanned_height = block_height;
         } else {
-            // could not scan block, keep scanning but record this block as the most recent failure
-            result.last_failed_block = block_hash;
-            result.status = ScanResult::FAILURE;
-        }
-        if (max_height && block_height >= *max_height) {
-            break;
+            CBlock block = entry.data.get();
+
+            // Check whether the block is still active separately from reading
+            // its data, because reading is slow and there might be a reorg
+            // while it is read.
+            bool block_still_active = false;
+            chain().findBlock(block_hash, FoundBlock().inActiveChain(block_still_active));
+
+            if (!block.IsNull()) {
+                LOCK(cs_wallet);
+                if (!block_still_active) {
+                    // Abort scan if current block is no longer active, to prevent
+                    // marking transactions as coming from the wrong block.
+                    result.last_failed_block = block_hash;
+                    result.status = ScanResult::FAILURE;
+                    break;
+                }
+                for (size_t posInBlock = 0; posInBlock < block.vtx.size(); ++posInBlock) {
+                    SyncTransaction(block.vtx[posInBlock], {CWalletTx::Status::CONFIRMED, block_height, block_hash, (int)posInBlock}, batch, fUpdate);
+                }
+                // scan succeeded, record block as most recent successfully scanned
+                result.last_scanned_block = block_hash;
+                result.last_scanned_height = block_height;
+            } else {
+                // could not scan block, keep scanning but record this block as the most recent failure
+                result.last_failed_block = block_hash;
+                result.status = ScanResult::FAILURE;
+            }
         }
-        {
-            if (!next_block) {
-                // break successfully when rescan has reached the tip, or
-                // previous block is no longer on the chain due to a reorg
-                break;
+
+        // The keypool may have been topped up by what was found, the blocks
+        // already ruled out have to be checked against the new keys as well
+        if (fast_rescan_filter && fast_rescan_filter->UpdateIfNeeded()) {
+            for (RescanBlock& queued : queue) {
+                if (queued.filter_match != false) continue;
+                queued.filter_match = fast_rescan_filter->MatchesBlock(queued.hash);
+                if (queued.filter_match != false) read_block(queued);
             }
+        }
 
-            // increment block and verification progress
-            block_hash = next_block_hash;
-            ++block_height;
-            progress_current = chain().guessVerificationProgress(block_hash);
+        fill_queue();
+        if (!queue.empty()) {
+            // increment verification progress
+            progress_current = chain().guessVerificationProgress(queue.front().hash);
 
             // handle updated tip hash
             const uint256 prev_tip_hash = tip_hash;
@@ -2076,6 +2314,20 @@ void CWallet::ReacceptWalletTransactions()
     }
 }
 
+void CWalletTx::MarkDirty()
+{
+    m_amounts[DEBIT].Reset();
+    m_amounts[CREDIT].Reset();
+    m_amounts[ANON_CREDIT].Reset();
+    m_amounts[DENOM_CREDIT].Reset();
+    m_amounts[DENOM_UCREDIT].Reset();
+    m_amounts[IMMATURE_CREDIT].Reset();
+    m_amounts[AVAILABLE_CREDIT].Reset();
+    fChangeCached = false;
+    m_is_cache_empty = true;
+    if (pwallet) pwallet->MarkBalanceDirty();
+}
+
 bool CWalletTx::CanBeResent() const
 {
     return
@@ -2454,12 +2706,53 @@ std::unordered_set<const CWalletTx*, WalletTxHasher> CWallet::GetSpendableTXs()
     return ret;
 }
 
+std::unordered_set<const CWalletTx*, WalletTxHasher> CWallet::GetSpendableDenominatedTXs(std::optional<int> nDenom) const
+{
+    AssertLockHeld(cs_wallet);
+
+    std::unordered_set<const CWalletTx*, WalletTxHasher> ret;
+    for (const auto& [denom, setOutpoints] : mapDenominatedUTXO) {
+        if (nDenom && denom != *nDenom) continue;
+        for (const auto& outpoint : setOutpoints) {
+            const auto jt = mapWallet.find(outpoint.hash);
+            if (jt != mapWallet.end()) {
+                ret.emplace(&jt->second);
+            }
+        }
+    }
+    return ret;
+}
+
 CWallet::Balance CWallet::GetBalance(const int min_depth, const bool avoid_reuse, const bool fAddLocked, const CCoinControl* coinControl) const
 {
+    LOCK(cs_wallet);
+    if (coinControl) {
+        return ComputeBalance(min_depth, avoid_reuse, fAddLocked, coinControl);
+    }
+
+    // Read the epoch first, so that a change racing the computation leaves a stale entry behind, not a wrong one
+    const uint64_t epoch = m_balance_epoch;
+    const auto key = std::make_tuple(min_depth, avoid_reuse, fAddLocked, CCoinJoinClientOptions::IsEnabled());
+    const auto it = m_balance_cache.find(key);
+    if (it != m_balance_cache.end() && it->second.first == epoch) {
+        return it->second.second;
+    }
+
+    Balance ret = ComputeBalance(min_depth, avoid_reuse, fAddLocked, coinControl);
+    if (m_balance_cache.size() >= 16) {
+        m_balance_cache.clear();
+    }
+    m_balance_cache[key] = std::make_pair(epoch, ret);
+    return ret;
+}
+
+CWallet::Balance CWallet::ComputeBalance(const int min_depth, const bool avoid_reuse, const bool fAddLocked, const CCoinControl* coinControl) const
+{
+    AssertLockHeld(cs_wallet);
+
     Balance ret;
     isminefilter reuse_filter = avoid_reuse ? ISMINE_NO : ISMINE_USED;
     {
-        LOCK(cs_wallet);
         std::set<uint256> trusted_parents;
         for (auto pcoin : GetSpendableTXs()) {
             const bool is_trusted{pcoin->IsTrusted(trusted_parents)};
@@ -2518,11 +2811,11 @@ float CWallet::GetAverageAnonymizedRounds() const
     int nCount = 0;
 
     LOCK(cs_wallet);
-    for (const auto& outpoint : setWalletUTXO) {
-        if(!IsDenominated(outpoint)) continue;
-
-        nTotal += GetCappedOutpointCoinJoinRounds(outpoint);
-        nCount++;
+    for (const auto& [_, setOutpoints] : mapDenominatedUTXO) {
+        for (const auto& outpoint : setOutpoints) {
+            nTotal += GetCappedOutpointCoinJoinRounds(outpoint);
+            nCount++;
+        }
     }
 
     if(nCount == 0) return 0;
@@ -2539,16 +2832,16 @@ CAmount CWallet::GetNormalizedAnonymizedBalance() const
     CAmount nTotal = 0;
 
     LOCK(cs_wallet);
-    for (const auto& outpoint : setWalletUTXO) {
-        const auto it = mapWallet.find(outpoint.hash);
-        if (it == mapWallet.end()) continue;
+    for (const auto& [nDenom, setOutpoints] : mapDenominatedUTXO) {
+        const CAmount nValue = CoinJoin::DenominationToAmount(nDenom);
+        for (const auto& outpoint : setOutpoints) {
+            const auto it = mapWallet.find(outpoint.hash);
+            if (it == mapWallet.end()) continue;
+            if (it->second.GetDepthInMainChain() < 0) continue;
 
-        CAmount nValue = it->second.tx->vout[outpoint.n].nValue;
-        if (!CoinJoin::IsDenominatedAmount(nValue)) continue;
-        if (it->second.GetDepthInMainChain() < 0) continue;
-
-        int nRounds = GetCappedOutpointCoinJoinRounds(outpoint);
-        nTotal += nValue * nRounds / CCoinJoinClientOptions::GetRounds();
+            int nRounds = GetCappedOutpointCoinJoinRounds(outpoint);
+            nTotal += nValue * nRounds / CCoinJoinClientOptions::GetRounds();
+        }
     }
 
     return nTotal;
@@ -2583,8 +2876,15 @@ void CWallet::AvailableCoins(std::vector<COutput> &vCoins, bool fOnlySafe, const
     const int min_depth = {coinControl ? coinControl->m_min_depth : DEFAULT_MIN_DEPTH};
     const int max_depth = {coinControl ? coinControl->m_max_depth : DEFAULT_MAX_DEPTH};
 
+    // Mixing only ever spends denominated outputs, which are indexed separately
+    const bool fOnlyDenominated = nCoinType == CoinType::ONLY_READY_TO_MIX || nCoinType == CoinType::ONLY_FULLY_MIXED;
+    std::optional<int> nOnlyDenom;
+    if (fOnlyDenominated && nMinimumAmount == nMaximumAmount && CoinJoin::IsDenominatedAmount(nMinimumAmount)) {
+        nOnlyDenom = CoinJoin::AmountToDenomination(nMinimumAmount);
+    }
+
     std::set<uint256> trusted_parents;
-    for (auto pcoin : GetSpendableTXs()) {
+    for (auto pcoin : fOnlyDenominated ? GetSpendableDenominatedTXs(nOnlyDenom) : GetSpendableTXs()) {
         const uint256& wtxid = pcoin->GetHash();
 
         if (!chain().checkFinalTx(*pcoin->tx))
@@ -2768,7 +3068,17 @@ static bool isGroupISLocked(const OutputGroup& group, interfaces::Chain& chain)
     });
 }
 
-bool CWallet::SelectCoinsMinConf(const CAmount& nTargetValue, const CoinEligibilityFilter& eligibility_filter, std::vector<OutputGroup> groups,
+/**
+ * Check eligibility, looking up InstantSend locks only for groups whose depth alone
+ * does not decide it. Most coins in a large wallet are deep enough to skip the lookup.
+ */
+static bool isGroupEligible(const OutputGroup& group, const CoinEligibilityFilter& eligibility_filter, interfaces::Chain& chain)
+{
+    if (group.EligibleForSpending(eligibility_filter, false /* isISLocked */)) return true;
+    return group.EligibleForSpending(eligibility_filter, true /* isISLocked */) && isGroupISLocked(group, chain);
+}
+
+bool CWallet::SelectCoinsMinConf(const CAmount& nTargetValue, const CoinEligibilityFilter& eligibility_filter, const std::vector<OutputGroup>& groups,
                                  std::set<CInputCoin>& setCoinsRet, CAmount& nValueRet, const CoinSelectionParams& coin_selection_params, bool& bnb_used, CoinType nCoinType) const
 {
     setCoinsRet.clear();
@@ -2786,10 +3096,11 @@ bool CWallet::SelectCoinsMinConf(const CAmount& nTargetValue, const CoinEligibil
         CAmount cost_of_change = GetDiscardRate(*this).GetFee(coin_selection_params.change_spend_size) + coin_selection_params.effective_fee.GetFee(coin_selection_params.change_output_size);
 
         // Filter by the min conf specs and add to utxo_pool and calculate effective value
-        for (OutputGroup& group : groups) {
-            bool isISLocked = isGroupISLocked(group, chain());
-            if (!group.EligibleForSpending(eligibility_filter, isISLocked)) continue;
+        for (const OutputGroup& candidate : groups) {
+            if (!isGroupEligible(candidate, eligibility_filter, chain())) continue;
 
+            // Only eligible groups are copied; the caller's groups are reused for every filter pass
+            OutputGroup group = candidate;
             if (coin_selection_params.m_subtract_fee_outputs) {
                 // Set the effective feerate to 0 as we don't want to use the effective value since the fees will be deducted from the output
                 group.SetFees(CFeeRate(0) /* effective_feerate */, long_term_feerate);
@@ -2807,8 +3118,7 @@ bool CWallet::SelectCoinsMinConf(const CAmount& nTargetValue, const CoinEligibil
     } else {
         // Filter by the min conf specs and add to utxo_pool
         for (const OutputGroup& group : groups) {
-            bool isISLocked = isGroupISLocked(group, chain());
-            if (!group.EligibleForSpending(eligibility_filter, isISLocked)) continue;
+            if (!isGroupEligible(group, eligibility_filter, chain())) continue;
             utxo_pool.push_back(group);
         }
         bnb_used = false;
@@ -3180,7 +3490,7 @@ bool CWallet::SelectTxDSInsByDenomination(int nDenom, CAmount nValueMax, std::ve
 
     CCoinControl coin_control;
     coin_control.nCoinType = CoinType::ONLY_READY_TO_MIX;
-    AvailableCoins(vCoins, true, &coin_control);
+    AvailableCoins(vCoins, true, &coin_control, nDenomAmount, nDenomAmount);
     WalletCJLogPrint((*this), "CWallet::%s -- vCoins.size(): %d\n", __func__, vCoins.size());
 
     Shuffle(vCoins.rbegin(), vCoins.rend(), FastRandomContext());
@@ -3401,7 +3711,13 @@ int CWallet::CountInputsWithAmount(CAmount nInputAmount) const
 
     LOCK(cs_wallet);
 
-    for (const auto& outpoint : setWalletUTXO) {
+    // Denominated amounts only need to look at their own bucket
+    const int nDenom = CoinJoin::AmountToDenomination(nInputAmount);
+    const auto itDenom = mapDenominatedUTXO.find(nDenom);
+    if (nDenom > 0 && itDenom == mapDenominatedUTXO.end()) return 0;
+    const std::set<COutPoint>& setOutpoints = nDenom > 0 ? itDenom->second : setWalletUTXO;
+
+    for (const auto& outpoint : setOutpoints) {
         const auto it = mapWallet.find(outpoint.hash);
         if (it == mapWallet.end()) continue;
         if (it->second.tx->vout[outpoint.n].nValue != nInputAmount) continue;
@@ -3892,7 +4208,7 @@ DBErrors CWallet::LoadWallet(bool& fFirstRunRet)
             for (auto& pair : mapWallet) {
                 for(unsigned int i = 0; i < pair.second.tx->vout.size(); ++i) {
                     if (IsMine(pair.second.tx->vout[i]) && !IsSpent(pair.first, i)) {
-                        setWalletUTXO.insert(COutPoint(pair.first, i));
+                        AddWalletUTXO(COutPoint(pair.first, i), pair.second.tx->vout[i].nValue);
                     }
                 }
             }
@@ -5155,6 +5471,8 @@ void CWallet::notifyTransactionLock(const CTransactionRef &tx, const std::shared
     uint256 txHash = tx->GetHash();
     std::map<uint256, CWalletTx>::const_iterator mi = mapWallet.find(txHash);
     if (mi != mapWallet.end()){
+        // The lock makes the transaction trusted
+        MarkBalanceDirty();
         NotifyTransactionChanged(this, txHash, CT_UPDATED);
         NotifyISLockReceived();
 #if HAVE_SYSTEM
@@ -5179,6 +5497,7 @@ void CWallet::notifyTransactionLock(const CTransactionRef &tx, const std::shared
 
 void CWallet::notifyChainLock(const CBlockIndex* pindexChainLock, const std::shared_ptr<const llmq::CChainLockSig>& clsig)
 {
+    MarkBalanceDirty();
     NotifyChainLockReceived(pindexChainLock->nHeight);
 }
 
@@ -5277,8 +5596,11 @@ std::vector<OutputGroup> CWallet::GroupOutputs(const std::vector<COutput>& outpu
             CTxDestination dst;
             CInputCoin input_coin = output.GetInputCoin();
 
-            size_t ancestors, descendants;
-            chain().getTransactionAncestry(output.tx->GetHash(), ancestors, descendants);
+            // Only unconfirmed transactions can have in-mempool ancestors or descendants
+            size_t ancestors{0}, descendants{0};
+            if (output.nDepth == 0) {
+                chain().getTransactionAncestry(output.tx->GetHash(), ancestors, descendants);
+            }
             if (!single_coin && ExtractDestination(output.tx->tx->vout[output.i].scriptPubKey, dst)) {
                 auto it = gmap.find(dst);
                 if (it != gmap.end()) {
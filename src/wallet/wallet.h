@@ -38,6 +38,7 @@
 #include <stdexcept>
 #include <stdint.h>
 #include <string>
+#include <tuple>
 #include <unordered_set>
 #include <utility>
 #include <vector>
@@ -470,18 +471,7 @@ public:
     }
 
     //! make sure balances are recalculated
-    void MarkDirty()
-    {
-        m_amounts[DEBIT].Reset();
-        m_amounts[CREDIT].Reset();
-        m_amounts[ANON_CREDIT].Reset();
-        m_amounts[DENOM_CREDIT].Reset();
-        m_amounts[DENOM_UCREDIT].Reset();
-        m_amounts[IMMATURE_CREDIT].Reset();
-        m_amounts[AVAILABLE_CREDIT].Reset();
-        fChangeCached = false;
-        m_is_cache_empty = true;
-    }
+    void MarkDirty();
 
     const CWallet* GetWallet() const
     {
@@ -710,9 +700,18 @@ private:
     void AddToSpends(const COutPoint& outpoint, const uint256& wtxid) EXCLUSIVE_LOCKS_REQUIRED(cs_wallet);
     void AddToSpends(const uint256& wtxid) EXCLUSIVE_LOCKS_REQUIRED(cs_wallet);
 
+    /** Update the block height of a transaction read from disk, or mark it unconfirmed if its block isn't active anymore */
+    void UpdateLoadedTxChainState(CWalletTx& wtx) EXCLUSIVE_LOCKS_REQUIRED(cs_wallet);
+
     std::set<COutPoint> setWalletUTXO;
+    /** The denominated outputs of setWalletUTXO, by denomination */
+    std::map<int, std::set<COutPoint>> mapDenominatedUTXO;
     mutable std::map<COutPoint, int> mapOutpointRoundsCache;
 
+    /** Add or remove an entry of setWalletUTXO, keeping mapDenominatedUTXO in sync */
+    bool AddWalletUTXO(const COutPoint& outpoint, CAmount nValue) EXCLUSIVE_LOCKS_REQUIRED(cs_wallet);
+    void EraseWalletUTXO(const COutPoint& outpoint) EXCLUSIVE_LOCKS_REQUIRED(cs_wallet);
+
     /**
      * Add a transaction to the wallet, or update it.  pIndex and posInBlock should
      * be set when the transaction was known to be included in a block.  When
@@ -770,6 +769,8 @@ private:
 
     // A helper function which loops through wallet UTXOs
     std::unordered_set<const CWalletTx*, WalletTxHasher> GetSpendableTXs() const EXCLUSIVE_LOCKS_REQUIRED(cs_wallet);
+    /** Like GetSpendableTXs, but only the transactions with denominated (or, if given, nDenom) outputs */
+    std::unordered_set<const CWalletTx*, WalletTxHasher> GetSpendableDenominatedTXs(std::optional<int> nDenom = std::nullopt) const EXCLUSIVE_LOCKS_REQUIRED(cs_wallet);
 
     /**
      * The following is used to keep track of how far behind the wallet is
@@ -911,7 +912,7 @@ public:
      * completion the coin set and corresponding actual target value is
      * assembled
      */
-    bool SelectCoinsMinConf(const CAmount& nTargetValue, const CoinEligibilityFilter& eligibility_filter, std::vector<OutputGroup> groups, std::set<CInputCoin>& setCoinsRet, CAmount& nValueRet, const CoinSelectionParams& coin_selection_params, bool& bnb_used, CoinType nCoinType = CoinType::ALL_COINS) const;
+    bool SelectCoinsMinConf(const CAmount& nTargetValue, const CoinEligibilityFilter& eligibility_filter, const std::vector<OutputGroup>& groups, std::set<CInputCoin>& setCoinsRet, CAmount& nValueRet, const CoinSelectionParams& coin_selection_params, bool& bnb_used, CoinType nCoinType = CoinType::ALL_COINS) const;
 
     // Coin selection
     bool SelectTxDSInsByDenomination(int nDenom, CAmount nValueMax, std::vector<CTxDSIn>& vecTxDSInRet);
@@ -1004,6 +1005,17 @@ public:
 
     CWalletTx* AddToWallet(CTransactionRef tx, const CWalletTx::Confirmation& confirm, const UpdateWalletTxFn& update_wtx=nullptr, bool fFlushOnClose=true);
     bool LoadToWallet(const uint256& hash, const UpdateWalletTxFn& fill_wtx) EXCLUSIVE_LOCKS_REQUIRED(cs_wallet);
+
+    //! Callback filling the i-th transaction of a bulk load, called from several threads at once
+    using FillWalletTxFn = std::function<bool(size_t i, CWalletTx& wtx)>;
+
+    /**
+     * Load many transactions at once when the wallet is loaded. They are filled in parallel, and spends, metadata and
+     * conflicts are updated once all of them are in mapWallet instead of after each of them.
+     *
+     * @return for each hash whether its transaction was loaded, the ones fill_wtx failed for are not added
+     */
+    std::vector<bool> LoadToWallet(const std::vector<uint256>& hashes, const FillWalletTxFn& fill_wtx) EXCLUSIVE_LOCKS_REQUIRED(cs_wallet);
     void transactionAddedToMempool(const CTransactionRef& tx, int64_t nAcceptTime) override;
     void blockConnected(const CBlock& block, int height) override;
     void blockDisconnected(const CBlock& block, int height) override;
@@ -1041,6 +1053,21 @@ public:
         CAmount m_denominated_untrusted_pending{0};
     };
     Balance GetBalance(const int min_depth = 0, const bool avoid_reuse = true, const bool fAddLocked = false, const CCoinControl* coinControl = nullptr) const;
+    //! Drop the balances cached by GetBalance, whenever anything they are computed from changes
+    void MarkBalanceDirty() const { ++m_balance_epoch; }
+
+private:
+    Balance ComputeBalance(const int min_depth, const bool avoid_reuse, const bool fAddLocked, const CCoinControl* coinControl) const EXCLUSIVE_LOCKS_REQUIRED(cs_wallet);
+
+    /**
+     * GetBalance results without coin control, keyed by (min_depth, avoid_reuse, fAddLocked, CoinJoin enabled).
+     * An entry is only valid while m_balance_epoch still has the value it was computed at, so a
+     * wallet with a huge mapWallet answers repeated balance queries between blocks without rescanning it.
+     */
+    mutable std::map<std::tuple<int, bool, bool, bool>, std::pair<uint64_t, Balance>> m_balance_cache GUARDED_BY(cs_wallet);
+    mutable std::atomic<uint64_t> m_balance_epoch{0};
+
+public:
 
     CAmount GetAnonymizableBalance(bool fSkipDenominated = false, bool fSkipUnconfirmed = true) const;
     float GetAverageAnonymizedRounds() const;
@@ -1385,6 +1412,7 @@ public:
         AssertLockHeld(cs_wallet);
         m_last_block_processed_height = block_height;
         m_last_block_processed = block_hash;
+        MarkBalanceDirty();
     };
 
     //! Connect the signals from ScriptPubKeyMans to the signals in CWallet
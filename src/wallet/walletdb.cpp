@@ -238,6 +238,52 @@ public:
     }
 };
 
+/** Deserialize a tx record into wtx, undoing the serialization changes of 31600. Sets fUpgraded if it has to be rewritten. */
+static bool ReadWalletTx(const uint256& hash, CDataStream& ssValue, CWalletTx& wtx, bool& fUpgraded, std::string& strErr)
+{
+    ssValue >> wtx;
+    if (wtx.GetHash() != hash)
+        return false;
+
+    // Undo serialize changes in 31600
+    if (31404 <= wtx.fTimeReceivedIsTxTime && wtx.fTimeReceivedIsTxTime <= 31703)
+    {
+        if (!ssValue.empty())
+        {
+            uint8_t fTmp;
+            uint8_t fUnused;
+            std::string unused_string;
+            ssValue >> fTmp >> fUnused >> unused_string;
+            strErr = strprintf("LoadWallet() upgrading tx ver=%d %d %s",
+                               wtx.fTimeReceivedIsTxTime, fTmp, hash.ToString());
+            wtx.fTimeReceivedIsTxTime = fTmp;
+        }
+        else
+        {
+            strErr = strprintf("LoadWallet() repairing tx ver=%d %s", wtx.fTimeReceivedIsTxTime, hash.ToString());
+            wtx.fTimeReceivedIsTxTime = 0;
+        }
+        fUpgraded = true;
+    }
+    return true;
+}
+
+/** Whether ssKey is the key of a tx record, in which case hash is set. Leaves ssKey unread otherwise. */
+static bool ReadTxRecordKey(CDataStream& ssKey, uint256& hash)
+{
+    try {
+        std::string strType;
+        ssKey >> strType;
+        if (strType == DBKeys::TX) {
+            ssKey >> hash;
+            return true;
+        }
+    } catch (...) {
+    }
+    ssKey.Rewind();
+    return false;
+}
+
 static bool
 ReadKeyValue(CWallet* pwallet, CDataStream& ssKey, CDataStream& ssValue,
              CWalletScanState &wss, std::string& strType, std::string& strErr, const KeyFilterFn& filter_fn = nullptr) EXCLUSIVE_LOCKS_REQUIRED(pwallet->cs_wallet)
@@ -268,30 +314,11 @@ ReadKeyValue(CWallet* pwallet, CDataStream& ssKey, CDataStream& ssValue,
             // callback fills with transaction metadata.
             auto fill_wtx = [&](CWalletTx& wtx, bool new_tx) {
                 assert(new_tx);
-                ssValue >> wtx;
-                if (wtx.GetHash() != hash)
+                bool fUpgraded = false;
+                if (!ReadWalletTx(hash, ssValue, wtx, fUpgraded, strErr))
                     return false;
-
-                // Undo serialize changes in 31600
-                if (31404 <= wtx.fTimeReceivedIsTxTime && wtx.fTimeReceivedIsTxTime <= 31703)
-                {
-                    if (!ssValue.empty())
-                    {
-                        uint8_t fTmp;
-                        uint8_t fUnused;
-                        std::string unused_string;
-                        ssValue >> fTmp >> fUnused >> unused_string;
-                        strErr = strprintf("LoadWallet() upgrading tx ver=%d %d %s",
-                                           wtx.fTimeReceivedIsTxTime, fTmp, hash.ToString());
-                        wtx.fTimeReceivedIsTxTime = fTmp;
-                    }
-                    else
-                    {
-                        strErr = strprintf("LoadWallet() repairing tx ver=%d %s", wtx.fTimeReceivedIsTxTime, hash.ToString());
-                        wtx.fTimeReceivedIsTxTime = 0;
-                    }
+                if (fUpgraded)
                     wss.vWalletUpgrade.push_back(hash);
-                }
 
                 if (wtx.nOrderPos == -1)
                     wss.fAnyUnordered = true;
@@ -572,6 +599,10 @@ DBErrors WalletBatch::LoadWallet(CWallet* pwallet)
             return DBErrors::CORRUPT;
         }
 
+        // Transactions are deserialized together once every record was read, see below
+        std::vector<uint256> tx_hashes;
+        std::vector<CDataStream> tx_values;
+
         while (true)
         {
             // Read next record
@@ -589,6 +620,13 @@ DBErrors WalletBatch::LoadWallet(CWallet* pwallet)
                 return DBErrors::CORRUPT;
             }
 
+            uint256 tx_hash;
+            if (ReadTxRecordKey(ssKey, tx_hash)) {
+                tx_hashes.push_back(tx_hash);
+                tx_values.push_back(std::move(ssValue));
+                continue;
+            }
+
             // Try to be tolerant of single corrupt records:
             std::string strType, strErr;
             if (!ReadKeyValue(pwallet, ssKey, ssValue, wss, strType, strErr))
@@ -612,6 +650,42 @@ DBErrors WalletBatch::LoadWallet(CWallet* pwallet)
                 pwallet->WalletLogPrintf("%s\n", strErr);
         }
 
+        // Deserialize the transactions in parallel and let the wallet index their spends in one go
+        struct TxLoadResult {
+            bool fUpgraded{false};
+            std::string strErr;
+        };
+        std::vector<TxLoadResult> tx_results(tx_hashes.size());
+        auto fill_wtx = [&](size_t i, CWalletTx& wtx) {
+            try {
+                return ReadWalletTx(tx_hashes[i], tx_values[i], wtx, tx_results[i].fUpgraded, tx_results[i].strErr);
+            } catch (const std::exception& e) {
+                if (tx_results[i].strErr.empty()) {
+                    tx_results[i].strErr = e.what();
+                }
+            } catch (...) {
+                if (tx_results[i].strErr.empty()) {
+                    tx_results[i].strErr = "Caught unknown exception in ReadWalletTx";
+                }
+            }
+            return false;
+        };
+        const std::vector<bool> tx_loaded = pwallet->LoadToWallet(tx_hashes, fill_wtx);
+        for (size_t i = 0; i < tx_hashes.size(); ++i) {
+            if (!tx_loaded[i]) {
+                // Leave a bad transaction record alone, but warn the user and rescan
+                fNoncriticalErrors = true;
+                gArgs.SoftSetBoolArg("-rescan", true);
+            } else {
+                if (tx_results[i].fUpgraded)
+                    wss.vWalletUpgrade.push_back(tx_hashes[i]);
+                if (pwallet->mapWallet.at(tx_hashes[i]).nOrderPos == -1)
+                    wss.fAnyUnordered = true;
+            }
+            if (!tx_results[i].strErr.empty())
+                pwallet->WalletLogPrintf("%s\n", tx_results[i].strErr);
+        }
+
         // Store initial external keypool size since we mostly use external keys in mixing
         pwallet->nKeysLeftSinceAutoBackup = pwallet->KeypoolCountExternalKeys();
         pwallet->WalletLogPrintf("nKeysLeftSinceAutoBackup: %d\n", pwallet->nKeysLeftSinceAutoBackup);
@@ -13,12 +13,12 @@ CZMQAbstractNotifier::~CZMQAbstractNotifier()
     assert(!psocket);
 }
 
-bool CZMQAbstractNotifier::NotifyBlock(const CBlockIndex * /*CBlockIndex*/)
+bool CZMQAbstractNotifier::NotifyBlock(const CBlockIndex * /*CBlockIndex*/, const std::shared_ptr<const CBlock>& /*pblock*/)
 {
     return true;
 }
 
-bool CZMQAbstractNotifier::NotifyChainLock(const CBlockIndex * /*CBlockIndex*/, const std::shared_ptr<const llmq::CChainLockSig> & /*clsig*/)
+bool CZMQAbstractNotifier::NotifyChainLock(const CBlockIndex * /*CBlockIndex*/, const std::shared_ptr<const llmq::CChainLockSig> & /*clsig*/, const std::shared_ptr<const CBlock>& /*pblock*/)
 {
     return true;
 }
@@ -52,3 +52,8 @@ bool CZMQAbstractNotifier::NotifyRecoveredSig(const std::shared_ptr<const llmq::
 {
     return true;
 }
+
+bool CZMQAbstractNotifier::Flush(bool /*force*/)
+{
+    return true;
+}
@@ -6,9 +6,11 @@
 #define BITCOIN_ZMQ_ZMQABSTRACTNOTIFIER_H
 
 
+#include <chrono>
 #include <memory>
 #include <string>
 
+class CBlock;
 class CBlockIndex;
 class CGovernanceVote;
 class CTransaction;
@@ -33,6 +35,8 @@ class CZMQAbstractNotifier
 {
 public:
     static const int DEFAULT_ZMQ_SNDHWM {1000};
+    static const size_t DEFAULT_ZMQ_BATCH_SIZE {65536};
+    static const int64_t DEFAULT_ZMQ_BATCH_INTERVAL {100};
 
     CZMQAbstractNotifier() : psocket(nullptr), outbound_message_high_water_mark(DEFAULT_ZMQ_SNDHWM) { }
     virtual ~CZMQAbstractNotifier();
@@ -53,24 +57,35 @@ public:
             outbound_message_high_water_mark = sndhwm;
         }
     }
+    std::chrono::milliseconds GetBatchInterval() const { return batch_interval; }
+    // Pack events into one frame of up to max_bytes, sent no later than interval after its first event
+    void SetBatchLimits(size_t max_bytes, std::chrono::milliseconds interval) {
+        batch_max_bytes = max_bytes;
+        batch_interval = interval;
+    }
 
     virtual bool Initialize(void *pcontext) = 0;
     virtual void Shutdown() = 0;
 
-    virtual bool NotifyBlock(const CBlockIndex *pindex);
-    virtual bool NotifyChainLock(const CBlockIndex *pindex, const std::shared_ptr<const llmq::CChainLockSig>& clsig);
+    // pblock is the block pindex points to if it is still in memory, or null
+    virtual bool NotifyBlock(const CBlockIndex *pindex, const std::shared_ptr<const CBlock>& pblock);
+    virtual bool NotifyChainLock(const CBlockIndex *pindex, const std::shared_ptr<const llmq::CChainLockSig>& clsig, const std::shared_ptr<const CBlock>& pblock);
     virtual bool NotifyTransaction(const CTransaction &transaction);
     virtual bool NotifyTransactionLock(const CTransactionRef& transaction, const std::shared_ptr<const llmq::CInstantSendLock>& islock);
     virtual bool NotifyGovernanceVote(const std::shared_ptr<const CGovernanceVote>& vote);
     virtual bool NotifyGovernanceObject(const std::shared_ptr<const Governance::Object>& object);
     virtual bool NotifyInstantSendDoubleSpendAttempt(const CTransactionRef& currentTx, const CTransactionRef& previousTx);
     virtual bool NotifyRecoveredSig(const std::shared_ptr<const llmq::CRecoveredSig>& sig);
+    // Send a pending batch frame if it is due, or unconditionally if force is set
+    virtual bool Flush(bool force);
 
 protected:
     void *psocket;
     std::string type;
     std::string address;
     int outbound_message_high_water_mark; // aka SNDHWM
+    size_t batch_max_bytes {0}; //!< 0 if events are published one message each
+    std::chrono::milliseconds batch_interval {0};
 };
 
 #endif // BITCOIN_ZMQ_ZMQABSTRACTNOTIFIER_H
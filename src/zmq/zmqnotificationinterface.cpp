@@ -10,6 +10,7 @@
 
 #include <validation.h>
 #include <util/system.h>
+#include <util/thread.h>
 
 CZMQNotificationInterface::CZMQNotificationInterface() : pcontext(nullptr)
 {
@@ -23,6 +24,7 @@ CZMQNotificationInterface::~CZMQNotificationInterface()
 std::list<const CZMQAbstractNotifier*> CZMQNotificationInterface::GetActiveNotifiers() const
 {
     std::list<const CZMQAbstractNotifier*> result;
+    LOCK(m_notifiers_mutex);
     for (const auto& n : notifiers) {
         result.push_back(n.get());
     }
@@ -35,6 +37,7 @@ CZMQNotificationInterface* CZMQNotificationInterface::Create()
     factories["pubhashblock"] = CZMQAbstractNotifier::Create<CZMQPublishHashBlockNotifier>;
     factories["pubhashchainlock"] = CZMQAbstractNotifier::Create<CZMQPublishHashChainLockNotifier>;
     factories["pubhashtx"] = CZMQAbstractNotifier::Create<CZMQPublishHashTransactionNotifier>;
+    factories["pubhashtxbatch"] = CZMQAbstractNotifier::Create<CZMQPublishHashTransactionNotifier>;
     factories["pubhashtxlock"] = CZMQAbstractNotifier::Create<CZMQPublishHashTransactionLockNotifier>;
     factories["pubhashgovernancevote"] = CZMQAbstractNotifier::Create<CZMQPublishHashGovernanceVoteNotifier>;
     factories["pubhashgovernanceobject"] = CZMQAbstractNotifier::Create<CZMQPublishHashGovernanceObjectNotifier>;
@@ -44,23 +47,33 @@ CZMQNotificationInterface* CZMQNotificationInterface::Create()
     factories["pubrawchainlock"] = CZMQAbstractNotifier::Create<CZMQPublishRawChainLockNotifier>;
     factories["pubrawchainlocksig"] = CZMQAbstractNotifier::Create<CZMQPublishRawChainLockSigNotifier>;
     factories["pubrawtx"] = CZMQAbstractNotifier::Create<CZMQPublishRawTransactionNotifier>;
+    factories["pubrawtxbatch"] = CZMQAbstractNotifier::Create<CZMQPublishRawTransactionNotifier>;
     factories["pubrawtxlock"] = CZMQAbstractNotifier::Create<CZMQPublishRawTransactionLockNotifier>;
+    factories["pubrawtxlockbatch"] = CZMQAbstractNotifier::Create<CZMQPublishRawTransactionLockNotifier>;
     factories["pubrawtxlocksig"] = CZMQAbstractNotifier::Create<CZMQPublishRawTransactionLockSigNotifier>;
     factories["pubrawgovernancevote"] = CZMQAbstractNotifier::Create<CZMQPublishRawGovernanceVoteNotifier>;
     factories["pubrawgovernanceobject"] = CZMQAbstractNotifier::Create<CZMQPublishRawGovernanceObjectNotifier>;
     factories["pubrawinstantsenddoublespend"] = CZMQAbstractNotifier::Create<CZMQPublishRawInstantSendDoubleSpendNotifier>;
     factories["pubrawrecoveredsig"] = CZMQAbstractNotifier::Create<CZMQPublishRawRecoveredSigNotifier>;
+    factories["pubrawrecoveredsigbatch"] = CZMQAbstractNotifier::Create<CZMQPublishRawRecoveredSigNotifier>;
+
+    const size_t batch_size = std::max<int64_t>(1, gArgs.GetArg("-zmqbatchsize", CZMQAbstractNotifier::DEFAULT_ZMQ_BATCH_SIZE));
+    const std::chrono::milliseconds batch_interval{std::max<int64_t>(1, gArgs.GetArg("-zmqbatchinterval", CZMQAbstractNotifier::DEFAULT_ZMQ_BATCH_INTERVAL))};
 
     std::list<std::unique_ptr<CZMQAbstractNotifier>> notifiers;
     for (const auto& entry : factories)
     {
         std::string arg("-zmq" + entry.first);
         const auto& factory = entry.second;
+        const bool batched = entry.first.size() > 5 && entry.first.compare(entry.first.size() - 5, 5, "batch") == 0;
         for (const std::string& address : gArgs.GetArgs(arg)) {
             std::unique_ptr<CZMQAbstractNotifier> notifier = factory();
             notifier->SetType(entry.first);
             notifier->SetAddress(address);
             notifier->SetOutboundMessageHighWaterMark(static_cast<int>(gArgs.GetArg(arg + "hwm", CZMQAbstractNotifier::DEFAULT_ZMQ_SNDHWM)));
+            if (batched) {
+                notifier->SetBatchLimits(batch_size, batch_interval);
+            }
             notifiers.push_back(std::move(notifier));
         }
     }
@@ -68,7 +81,8 @@ CZMQNotificationInterface* CZMQNotificationInterface::Create()
     if (!notifiers.empty())
     {
         std::unique_ptr<CZMQNotificationInterface> notificationInterface(new CZMQNotificationInterface());
-        notificationInterface->notifiers = std::move(notifiers);
+        WITH_LOCK(notificationInterface->m_notifiers_mutex, notificationInterface->notifiers = std::move(notifiers));
+        notificationInterface->m_max_queue_size = std::max<int64_t>(1, gArgs.GetArg("-zmqqueuesize", DEFAULT_ZMQ_QUEUE_SIZE));
 
         if (notificationInterface->Initialize()) {
             return notificationInterface.release();
@@ -96,15 +110,20 @@ bool CZMQNotificationInterface::Initialize()
         return false;
     }
 
-    for (auto& notifier : notifiers) {
-        if (notifier->Initialize(pcontext)) {
-            LogPrint(BCLog::ZMQ, "zmq: Notifier %s ready (address = %s)\n", notifier->GetType(), notifier->GetAddress());
-        } else {
-            LogPrint(BCLog::ZMQ, "zmq: Notifier %s failed (address = %s)\n", notifier->GetType(), notifier->GetAddress());
-            return false;
+    {
+        LOCK(m_notifiers_mutex);
+        for (auto& notifier : notifiers) {
+            if (notifier->Initialize(pcontext)) {
+                LogPrint(BCLog::ZMQ, "zmq: Notifier %s ready (address = %s)\n", notifier->GetType(), notifier->GetAddress());
+            } else {
+                LogPrint(BCLog::ZMQ, "zmq: Notifier %s failed (address = %s)\n", notifier->GetType(), notifier->GetAddress());
+                return false;
+            }
         }
     }
 
+    m_publish_thread = std::thread(&util::TraceThread, "zmqpub", [this] { ThreadPublish(); });
+
     return true;
 }
 
@@ -112,8 +131,15 @@ bool CZMQNotificationInterface::Initialize()
 void CZMQNotificationInterface::Shutdown()
 {
     LogPrint(BCLog::ZMQ, "zmq: Shutdown notification interface\n");
+    if (m_publish_thread.joinable()) {
+        // Let the publisher thread flush what is already queued before the sockets go away
+        WITH_LOCK(m_queue_mutex, m_stop = true);
+        m_queue_cv.notify_all();
+        m_publish_thread.join();
+    }
     if (pcontext)
     {
+        LOCK(m_notifiers_mutex);
         for (auto& notifier : notifiers) {
             LogPrint(BCLog::ZMQ, "zmq: Shutdown notifier %s at %s\n", notifier->GetType(), notifier->GetAddress());
             notifier->Shutdown();
@@ -138,6 +164,77 @@ void TryForEachAndRemoveFailed(std::list<std::unique_ptr<CZMQAbstractNotifier>>&
         }
     }
 }
+
+void NotifyTransaction(std::list<std::unique_ptr<CZMQAbstractNotifier>>& notifiers, const CTransaction& tx)
+{
+    TryForEachAndRemoveFailed(notifiers, [&tx](CZMQAbstractNotifier* notifier) {
+        return notifier->NotifyTransaction(tx);
+    });
+}
+}
+
+void CZMQNotificationInterface::Enqueue(Notification func)
+{
+    {
+        LOCK(m_queue_mutex);
+        if (m_stop) return;
+        if (m_queue.size() >= m_max_queue_size) {
+            // Dropping keeps validation moving; the sequence numbers tell subscribers what they missed
+            ++m_dropped;
+            return;
+        }
+        m_queue.push_back(std::move(func));
+    }
+    m_queue_cv.notify_one();
+}
+
+void CZMQNotificationInterface::ThreadPublish()
+{
+    // Batched topics need a wakeup even when nothing is queued, to send frames that are due
+    std::chrono::milliseconds flush_interval{0};
+    WITH_LOCK(m_notifiers_mutex, for (const auto& n : notifiers) {
+        if (n->GetBatchInterval().count() > 0 && (flush_interval.count() == 0 || n->GetBatchInterval() < flush_interval)) {
+            flush_interval = n->GetBatchInterval();
+        }
+    });
+
+    while (true) {
+        Notification func;
+        bool stop{false};
+        {
+            WAIT_LOCK(m_queue_mutex, lock);
+            auto ready = [this]() EXCLUSIVE_LOCKS_REQUIRED(m_queue_mutex) { return m_stop || !m_queue.empty(); };
+            if (flush_interval.count() > 0) {
+                m_queue_cv.wait_for(lock, flush_interval, ready);
+            } else {
+                m_queue_cv.wait(lock, ready);
+            }
+            if (!m_queue.empty()) {
+                func = std::move(m_queue.front());
+                m_queue.pop_front();
+                if (m_queue.empty() && m_dropped > 0) {
+                    LogPrintf("zmq: Publisher queue overflowed, dropped %d notifications\n", m_dropped);
+                    m_dropped = 0;
+                }
+            } else {
+                // Only stop once everything queued has been published
+                stop = m_stop;
+            }
+        }
+
+        LOCK(m_notifiers_mutex);
+        if (func) {
+            func(notifiers);
+        }
+        if (flush_interval.count() > 0 || stop) {
+            TryForEachAndRemoveFailed(notifiers, [stop](CZMQAbstractNotifier* notifier) {
+                return notifier->Flush(stop);
+            });
+        }
+        if (stop) {
+            return;
+        }
+    }
 }
 
 void CZMQNotificationInterface::UpdatedBlockTip(const CBlockIndex *pindexNew, const CBlockIndex *pindexFork, bool fInitialDownload)
@@ -145,77 +242,110 @@ void CZMQNotificationInterface::UpdatedBlockTip(const CBlockIndex *pindexNew, co
     if (fInitialDownload || pindexNew == pindexFork) // In IBD or blocks were disconnected without any new ones
         return;
 
-    TryForEachAndRemoveFailed(notifiers, [pindexNew](CZMQAbstractNotifier* notifier) {
-        return notifier->NotifyBlock(pindexNew);
+    std::shared_ptr<const CBlock> pblock;
+    {
+        LOCK(m_queue_mutex);
+        if (m_last_block_index == pindexNew) pblock = m_last_block;
+    }
+
+    Enqueue([pindexNew, pblock](NotifierList& notifiers) {
+        TryForEachAndRemoveFailed(notifiers, [pindexNew, &pblock](CZMQAbstractNotifier* notifier) {
+            return notifier->NotifyBlock(pindexNew, pblock);
+        });
     });
 }
 
 void CZMQNotificationInterface::NotifyChainLock(const CBlockIndex *pindex, const std::shared_ptr<const llmq::CChainLockSig>& clsig)
 {
-    TryForEachAndRemoveFailed(notifiers, [pindex, &clsig](CZMQAbstractNotifier* notifier) {
-        return notifier->NotifyChainLock(pindex, clsig);
+    std::shared_ptr<const CBlock> pblock;
+    {
+        LOCK(m_queue_mutex);
+        if (m_last_block_index == pindex) pblock = m_last_block;
+    }
+
+    Enqueue([pindex, clsig, pblock](NotifierList& notifiers) {
+        TryForEachAndRemoveFailed(notifiers, [pindex, &clsig, &pblock](CZMQAbstractNotifier* notifier) {
+            return notifier->NotifyChainLock(pindex, clsig, pblock);
+        });
     });
 }
 
 void CZMQNotificationInterface::TransactionAddedToMempool(const CTransactionRef& ptx, int64_t nAcceptTime)
 {
-    // Used by BlockConnected and BlockDisconnected as well, because they're
-    // all the same external callback.
-    const CTransaction& tx = *ptx;
-
-    TryForEachAndRemoveFailed(notifiers, [&tx](CZMQAbstractNotifier* notifier) {
-        return notifier->NotifyTransaction(tx);
+    Enqueue([ptx](NotifierList& notifiers) {
+        NotifyTransaction(notifiers, *ptx);
     });
 }
 
 void CZMQNotificationInterface::BlockConnected(const std::shared_ptr<const CBlock>& pblock, const CBlockIndex* pindexConnected)
 {
-    for (const CTransactionRef& ptx : pblock->vtx) {
-        // Do a normal notify for each transaction added in the block
-        TransactionAddedToMempool(ptx, 0);
+    {
+        LOCK(m_queue_mutex);
+        m_last_block_index = pindexConnected;
+        m_last_block = pblock;
     }
+
+    // One queue entry for the whole block, the transactions are published in order from it
+    Enqueue([pblock](NotifierList& notifiers) {
+        for (const CTransactionRef& ptx : pblock->vtx) {
+            // Do a normal notify for each transaction added in the block
+            NotifyTransaction(notifiers, *ptx);
+        }
+    });
 }
 
 void CZMQNotificationInterface::BlockDisconnected(const std::shared_ptr<const CBlock>& pblock, const CBlockIndex* pindexDisconnected)
 {
-    for (const CTransactionRef& ptx : pblock->vtx) {
-        // Do a normal notify for each transaction removed in block disconnection
-        TransactionAddedToMempool(ptx, 0);
-    }
+    Enqueue([pblock](NotifierList& notifiers) {
+        for (const CTransactionRef& ptx : pblock->vtx) {
+            // Do a normal notify for each transaction removed in block disconnection
+            NotifyTransaction(notifiers, *ptx);
+        }
+    });
 }
 
 void CZMQNotificationInterface::NotifyTransactionLock(const CTransactionRef& tx, const std::shared_ptr<const llmq::CInstantSendLock>& islock)
 {
-    TryForEachAndRemoveFailed(notifiers, [&tx, &islock](CZMQAbstractNotifier* notifier) {
-        return notifier->NotifyTransactionLock(tx, islock);
+    Enqueue([tx, islock](NotifierList& notifiers) {
+        TryForEachAndRemoveFailed(notifiers, [&tx, &islock](CZMQAbstractNotifier* notifier) {
+            return notifier->NotifyTransactionLock(tx, islock);
+        });
     });
 }
 
 void CZMQNotificationInterface::NotifyGovernanceVote(const std::shared_ptr<const CGovernanceVote> &vote)
 {
-    TryForEachAndRemoveFailed(notifiers, [&vote](CZMQAbstractNotifier* notifier) {
-        return notifier->NotifyGovernanceVote(vote);
+    Enqueue([vote](NotifierList& notifiers) {
+        TryForEachAndRemoveFailed(notifiers, [&vote](CZMQAbstractNotifier* notifier) {
+            return notifier->NotifyGovernanceVote(vote);
+        });
     });
 }
 
 void CZMQNotificationInterface::NotifyGovernanceObject(const std::shared_ptr<const Governance::Object> &object)
 {
-    TryForEachAndRemoveFailed(notifiers, [&object](CZMQAbstractNotifier* notifier) {
-        return notifier->NotifyGovernanceObject(object);
+    Enqueue([object](NotifierList& notifiers) {
+        TryForEachAndRemoveFailed(notifiers, [&object](CZMQAbstractNotifier* notifier) {
+            return notifier->NotifyGovernanceObject(object);
+        });
     });
 }
 
 void CZMQNotificationInterface::NotifyInstantSendDoubleSpendAttempt(const CTransactionRef& currentTx, const CTransactionRef& previousTx)
 {
-    TryForEachAndRemoveFailed(notifiers, [&currentTx, &previousTx](CZMQAbstractNotifier* notifier) {
-        return notifier->NotifyInstantSendDoubleSpendAttempt(currentTx, previousTx);
+    Enqueue([currentTx, previousTx](NotifierList& notifiers) {
+        TryForEachAndRemoveFailed(notifiers, [&currentTx, &previousTx](CZMQAbstractNotifier* notifier) {
+            return notifier->NotifyInstantSendDoubleSpendAttempt(currentTx, previousTx);
+        });
     });
 }
 
 void CZMQNotificationInterface::NotifyRecoveredSig(const std::shared_ptr<const llmq::CRecoveredSig>& sig)
 {
-    TryForEachAndRemoveFailed(notifiers, [&sig](CZMQAbstractNotifier* notifier) {
-        return notifier->NotifyRecoveredSig(sig);
+    Enqueue([sig](NotifierList& notifiers) {
+        TryForEachAndRemoveFailed(notifiers, [&sig](CZMQAbstractNotifier* notifier) {
+            return notifier->NotifyRecoveredSig(sig);
+        });
     });
 }
 
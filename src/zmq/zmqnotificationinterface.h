@@ -5,9 +5,15 @@
 #ifndef BITCOIN_ZMQ_ZMQNOTIFICATIONINTERFACE_H
 #define BITCOIN_ZMQ_ZMQNOTIFICATIONINTERFACE_H
 
+#include <sync.h>
 #include <validationinterface.h>
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
 #include <list>
 #include <memory>
+#include <thread>
 
 class CBlockIndex;
 class CZMQAbstractNotifier;
@@ -15,9 +21,12 @@ class CZMQAbstractNotifier;
 class CZMQNotificationInterface final : public CValidationInterface
 {
 public:
+    //! Default for -zmqqueuesize, the number of notifications waiting to be published
+    static constexpr size_t DEFAULT_ZMQ_QUEUE_SIZE = 10000;
+
     virtual ~CZMQNotificationInterface();
 
-    std::list<const CZMQAbstractNotifier*> GetActiveNotifiers() const;
+    std::list<const CZMQAbstractNotifier*> GetActiveNotifiers() const LOCKS_EXCLUDED(m_notifiers_mutex);
 
     static CZMQNotificationInterface* Create();
 
@@ -40,8 +49,33 @@ protected:
 private:
     CZMQNotificationInterface();
 
+    /**
+     * Hand a notification over to the publisher thread. Serializing and sending
+     * happen there, so a slow consumer never holds up the validation queue. If
+     * the queue is full the notification is dropped; subscribers can spot the
+     * gap from the per-topic sequence number.
+     */
+    using NotifierList = std::list<std::unique_ptr<CZMQAbstractNotifier>>;
+    using Notification = std::function<void(NotifierList&)>;
+    void Enqueue(Notification func) LOCKS_EXCLUDED(m_queue_mutex);
+    void ThreadPublish() LOCKS_EXCLUDED(m_queue_mutex);
+
     void *pcontext;
-    std::list<std::unique_ptr<CZMQAbstractNotifier>> notifiers;
+
+    mutable Mutex m_notifiers_mutex;
+    NotifierList notifiers GUARDED_BY(m_notifiers_mutex);
+
+    Mutex m_queue_mutex;
+    std::condition_variable m_queue_cv;
+    std::deque<Notification> m_queue GUARDED_BY(m_queue_mutex);
+    size_t m_max_queue_size{DEFAULT_ZMQ_QUEUE_SIZE};
+    uint64_t m_dropped GUARDED_BY(m_queue_mutex){0};
+    bool m_stop GUARDED_BY(m_queue_mutex){false};
+    std::thread m_publish_thread;
+
+    //! Last connected block, so the raw block publishers don't have to read it back from disk
+    const CBlockIndex* m_last_block_index GUARDED_BY(m_queue_mutex){nullptr};
+    std::shared_ptr<const CBlock> m_last_block GUARDED_BY(m_queue_mutex);
 };
 
 extern CZMQNotificationInterface* g_zmq_notification_interface;
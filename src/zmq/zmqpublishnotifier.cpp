@@ -178,7 +178,7 @@ void CZMQAbstractPublishNotifier::Shutdown()
     psocket = nullptr;
 }
 
-bool CZMQAbstractPublishNotifier::SendZmqMessage(const char *command, const void* data, size_t size)
+bool CZMQAbstractPublishNotifier::SendFrame(const char *command, const void* data, size_t size)
 {
     assert(psocket);
 
@@ -195,7 +195,50 @@ bool CZMQAbstractPublishNotifier::SendZmqMessage(const char *command, const void
     return true;
 }
 
-bool CZMQPublishHashBlockNotifier::NotifyBlock(const CBlockIndex *pindex)
+bool CZMQAbstractPublishNotifier::SendBatch()
+{
+    bool ret = SendFrame(batch_command.c_str(), batch_data.data(), batch_data.size());
+    batch_data.clear();
+    return ret;
+}
+
+bool CZMQAbstractPublishNotifier::SendZmqMessage(const char *command, const void* data, size_t size)
+{
+    if (batch_max_bytes == 0) {
+        return SendFrame(command, data, size);
+    }
+
+    std::string topic = std::string(command) + "batch";
+    if (!batch_data.empty() && topic != batch_command && !SendBatch()) {
+        return false;
+    }
+    if (batch_data.empty()) {
+        batch_command = std::move(topic);
+        batch_start = std::chrono::steady_clock::now();
+    }
+
+    CVectorWriter writer(SER_NETWORK, PROTOCOL_VERSION, batch_data, batch_data.size());
+    WriteCompactSize(writer, size);
+    batch_data.insert(batch_data.end(), static_cast<const unsigned char*>(data), static_cast<const unsigned char*>(data) + size);
+
+    if (batch_data.size() >= batch_max_bytes) {
+        return SendBatch();
+    }
+    return true;
+}
+
+bool CZMQAbstractPublishNotifier::Flush(bool force)
+{
+    if (batch_data.empty()) {
+        return true;
+    }
+    if (!force && std::chrono::steady_clock::now() - batch_start < batch_interval) {
+        return true;
+    }
+    return SendBatch();
+}
+
+bool CZMQPublishHashBlockNotifier::NotifyBlock(const CBlockIndex *pindex, const std::shared_ptr<const CBlock>& pblock)
 {
     uint256 hash = pindex->GetBlockHash();
     LogPrint(BCLog::ZMQ, "zmq: Publish hashblock %s to %s\n", hash.GetHex(), this->address);
@@ -205,7 +248,7 @@ bool CZMQPublishHashBlockNotifier::NotifyBlock(const CBlockIndex *pindex)
     return SendZmqMessage(MSG_HASHBLOCK, data, 32);
 }
 
-bool CZMQPublishHashChainLockNotifier::NotifyChainLock(const CBlockIndex *pindex, const std::shared_ptr<const llmq::CChainLockSig>& clsig)
+bool CZMQPublishHashChainLockNotifier::NotifyChainLock(const CBlockIndex *pindex, const std::shared_ptr<const llmq::CChainLockSig>& clsig, const std::shared_ptr<const CBlock>& pblock)
 {
     uint256 hash = pindex->GetBlockHash();
     LogPrint(BCLog::ZMQ, "zmq: Publish hashchainlock %s\n", hash.GetHex());
@@ -277,66 +320,59 @@ bool CZMQPublishHashRecoveredSigNotifier::NotifyRecoveredSig(const std::shared_p
     return SendZmqMessage(MSG_HASHRECSIG, data, 32);
 }
 
-bool CZMQPublishRawBlockNotifier::NotifyBlock(const CBlockIndex *pindex)
+// Serialize the block pindex points to, reading it from disk only if it is not in memory anymore
+static bool SerializeBlock(CDataStream& ss, const CBlockIndex* pindex, const std::shared_ptr<const CBlock>& pblock)
 {
-    LogPrint(BCLog::ZMQ, "zmq: Publish rawblock %s to %s\n", pindex->GetBlockHash().GetHex(), this->address);
+    if (pblock) {
+        ss << *pblock;
+        return true;
+    }
 
-    const Consensus::Params& consensusParams = Params().GetConsensus();
-    CDataStream ss(SER_NETWORK, PROTOCOL_VERSION);
+    CBlock block;
     {
         LOCK(cs_main);
-        CBlock block;
-        if(!ReadBlockFromDisk(block, pindex, consensusParams))
-        {
+        if (!ReadBlockFromDisk(block, pindex, Params().GetConsensus())) {
             zmqError("Can't read block from disk");
             return false;
         }
+    }
+    ss << block;
+    return true;
+}
 
-        ss << block;
+bool CZMQPublishRawBlockNotifier::NotifyBlock(const CBlockIndex *pindex, const std::shared_ptr<const CBlock>& pblock)
+{
+    LogPrint(BCLog::ZMQ, "zmq: Publish rawblock %s to %s\n", pindex->GetBlockHash().GetHex(), this->address);
+
+    CDataStream ss(SER_NETWORK, PROTOCOL_VERSION);
+    if (!SerializeBlock(ss, pindex, pblock)) {
+        return false;
     }
 
     return SendZmqMessage(MSG_RAWBLOCK, &(*ss.begin()), ss.size());
 }
 
-bool CZMQPublishRawChainLockNotifier::NotifyChainLock(const CBlockIndex *pindex, const std::shared_ptr<const llmq::CChainLockSig>& clsig)
+bool CZMQPublishRawChainLockNotifier::NotifyChainLock(const CBlockIndex *pindex, const std::shared_ptr<const llmq::CChainLockSig>& clsig, const std::shared_ptr<const CBlock>& pblock)
 {
     LogPrint(BCLog::ZMQ, "zmq: Publish rawchainlock %s\n", pindex->GetBlockHash().GetHex());
 
-    const Consensus::Params& consensusParams = Params().GetConsensus();
     CDataStream ss(SER_NETWORK, PROTOCOL_VERSION);
-    {
-        LOCK(cs_main);
-        CBlock block;
-        if(!ReadBlockFromDisk(block, pindex, consensusParams))
-        {
-            zmqError("Can't read block from disk");
-            return false;
-        }
-
-        ss << block;
+    if (!SerializeBlock(ss, pindex, pblock)) {
+        return false;
     }
 
     return SendZmqMessage(MSG_RAWCHAINLOCK, &(*ss.begin()), ss.size());
 }
 
-bool CZMQPublishRawChainLockSigNotifier::NotifyChainLock(const CBlockIndex *pindex, const std::shared_ptr<const llmq::CChainLockSig>& clsig)
+bool CZMQPublishRawChainLockSigNotifier::NotifyChainLock(const CBlockIndex *pindex, const std::shared_ptr<const llmq::CChainLockSig>& clsig, const std::shared_ptr<const CBlock>& pblock)
 {
     LogPrint(BCLog::ZMQ, "zmq: Publish rawchainlocksig %s\n", pindex->GetBlockHash().GetHex());
 
-    const Consensus::Params& consensusParams = Params().GetConsensus();
     CDataStream ss(SER_NETWORK, PROTOCOL_VERSION);
-    {
-        LOCK(cs_main);
-        CBlock block;
-        if(!ReadBlockFromDisk(block, pindex, consensusParams))
-        {
-            zmqError("Can't read block from disk");
-            return false;
-        }
-
-        ss << block;
-        ss << *clsig;
+    if (!SerializeBlock(ss, pindex, pblock)) {
+        return false;
     }
+    ss << *clsig;
 
     return SendZmqMessage(MSG_RAWCLSIG, &(*ss.begin()), ss.size());
 }
@@ -7,6 +7,9 @@
 
 #include <zmq/zmqabstractnotifier.h>
 
+#include <string>
+#include <vector>
+
 class CBlockIndex;
 class CGovernanceVote;
 
@@ -21,6 +24,13 @@ class CZMQAbstractPublishNotifier : public CZMQAbstractNotifier
 private:
     uint32_t nSequence {0U}; //!< upcounting per message sequence number
 
+    std::string batch_command; //!< topic of the pending batch frame
+    std::vector<unsigned char> batch_data;
+    std::chrono::steady_clock::time_point batch_start;
+
+    bool SendFrame(const char *command, const void* data, size_t size);
+    bool SendBatch();
+
 public:
 
     /* send zmq multipart message
@@ -28,23 +38,27 @@ public:
           * command
           * data
           * message sequence number
+
+       For batched topics the data is appended to the pending frame of
+       topic "<command>batch" instead, prefixed by its CompactSize length.
     */
     bool SendZmqMessage(const char *command, const void* data, size_t size);
 
     bool Initialize(void *pcontext) override;
     void Shutdown() override;
+    bool Flush(bool force) override;
 };
 
 class CZMQPublishHashBlockNotifier : public CZMQAbstractPublishNotifier
 {
 public:
-    bool NotifyBlock(const CBlockIndex *pindex) override;
+    bool NotifyBlock(const CBlockIndex *pindex, const std::shared_ptr<const CBlock>& pblock) override;
 };
 
 class CZMQPublishHashChainLockNotifier : public CZMQAbstractPublishNotifier
 {
 public:
-    bool NotifyChainLock(const CBlockIndex *pindex, const std::shared_ptr<const llmq::CChainLockSig>& clsig) override;
+    bool NotifyChainLock(const CBlockIndex *pindex, const std::shared_ptr<const llmq::CChainLockSig>& clsig, const std::shared_ptr<const CBlock>& pblock) override;
 };
 
 class CZMQPublishHashTransactionNotifier : public CZMQAbstractPublishNotifier
@@ -86,19 +100,19 @@ public:
 class CZMQPublishRawBlockNotifier : public CZMQAbstractPublishNotifier
 {
 public:
-    bool NotifyBlock(const CBlockIndex *pindex) override;
+    bool NotifyBlock(const CBlockIndex *pindex, const std::shared_ptr<const CBlock>& pblock) override;
 };
 
 class CZMQPublishRawChainLockNotifier : public CZMQAbstractPublishNotifier
 {
 public:
-    bool NotifyChainLock(const CBlockIndex *pindex, const std::shared_ptr<const llmq::CChainLockSig>& clsig) override;
+    bool NotifyChainLock(const CBlockIndex *pindex, const std::shared_ptr<const llmq::CChainLockSig>& clsig, const std::shared_ptr<const CBlock>& pblock) override;
 };
 
 class CZMQPublishRawChainLockSigNotifier : public CZMQAbstractPublishNotifier
 {
 public:
-    bool NotifyChainLock(const CBlockIndex *pindex, const std::shared_ptr<const llmq::CChainLockSig>& clsig) override;
+    bool NotifyChainLock(const CBlockIndex *pindex, const std::shared_ptr<const llmq::CChainLockSig>& clsig, const std::shared_ptr<const CBlock>& pblock) override;
 };
 
 class CZMQPublishRawTransactionNotifier : public CZMQAbstractPublishNotifier
@@ -11,7 +11,6 @@ import binascii
 
 from test_framework.messages import COIN, COutPoint, CTransaction, CTxIn, CTxOut
 from test_framework.test_framework import BitcoinTestFramework
-from test_framework.test_node import ErrorMatch
 from test_framework.script import CScript, OP_CHECKSIG, OP_DUP, OP_EQUAL, OP_EQUALVERIFY, OP_HASH160
 from test_framework.util import assert_equal
 
@@ -40,15 +39,13 @@ class AddressIndexTest(BitcoinTestFramework):
         self.import_deterministic_coinbase_privkeys()
 
     def run_test(self):
-        self.log.info("Test that settings can't be changed without -reindex...")
-        self.stop_node(1)
-        self.nodes[1].assert_start_raises_init_error(["-addressindex=0"], "You need to rebuild the database using -reindex to change -addressindex", match=ErrorMatch.PARTIAL_REGEX)
-        self.start_node(1, ["-addressindex=0", "-reindex"])
+        self.log.info("Test that changing the setting rebuilds the index in the background...")
+        self.restart_node(1, ["-addressindex=0"])
+        assert_equal(self.nodes[1].getindexinfo("addressindex"), {})
         self.connect_nodes(0, 1)
         self.sync_all()
-        self.stop_node(1)
-        self.nodes[1].assert_start_raises_init_error(["-addressindex"], "You need to rebuild the database using -reindex to change -addressindex", match=ErrorMatch.PARTIAL_REGEX)
-        self.start_node(1, ["-addressindex", "-reindex"])
+        self.restart_node(1, ["-addressindex"])
+        self.wait_until(lambda: self.nodes[1].getindexinfo("addressindex")["addressindex"]["synced"])
         self.connect_nodes(0, 1)
         self.sync_all()
 
@@ -70,6 +67,16 @@ class AddressIndexTest(BitcoinTestFramework):
         assert_equal(balance_mining["balance_immature"], 100 * 500 * COIN)
         assert_equal(balance_mining["balance_spendable"], 5 * 500 * COIN)
 
+        self.log.info("Test that a rebuilt index has the same balances...")
+        self.restart_node(1, ["-addressindex", "-timestampindex"])
+        self.wait_until(lambda: self.nodes[1].getindexinfo("addressindex")["addressindex"]["synced"])
+        assert_equal(self.nodes[1].getaddressbalance(mining_address), balance_mining)
+        self.restart_node(1, ["-addressindex"])
+        self.wait_until(lambda: self.nodes[1].getindexinfo("addressindex")["addressindex"]["synced"])
+        assert_equal(self.nodes[1].getaddressbalance(mining_address), balance_mining)
+        self.connect_nodes(0, 1)
+        self.sync_all()
+
         # Check p2pkh and p2sh address indexes
         self.log.info("Testing p2pkh and p2sh address index...")
 
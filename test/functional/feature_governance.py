@@ -8,7 +8,7 @@ import json
 
 from test_framework.messages import uint256_to_string
 from test_framework.test_framework import MaximusTestFramework
-from test_framework.util import assert_equal, satoshi_round, set_node_times, wait_until
+from test_framework.util import assert_equal, p2p_port, satoshi_round, set_node_times, wait_until
 
 class MaximusGovernanceTest (MaximusTestFramework):
     def set_test_params(self):
@@ -365,6 +365,22 @@ class MaximusGovernanceTest (MaximusTestFramework):
             self.check_superblockbudget(True)
             self.check_superblock()
 
+        # Tallies must follow the masternode list when blocks are disconnected again
+        self.log.info("Check vote tallies across an invalidateblock reorg")
+        node = self.nodes[0]
+        assert_equal(node.gobject("get", self.p0_hash)["FundingResult"]["NoCount"], 1)
+        protx_hash = node.protx("register_fund", node.getnewaddress(), "127.0.0.1:%d" % p2p_port(len(self.nodes)), node.getnewaddress(),
+                                node.bls("generate")["public"], node.getnewaddress(), 0, node.getnewaddress())
+        registration_block = node.generate(1)[0]
+        self.sync_blocks()
+        node.gobject("vote-alias", self.p0_hash, map_vote_signals[1], map_vote_outcomes[2], protx_hash)
+        assert_equal(node.gobject("get", self.p0_hash)["FundingResult"]["NoCount"], 2)
+        # the vote of a masternode which is gone with the disconnected block must not be counted anymore
+        node.invalidateblock(registration_block)
+        assert_equal(node.gobject("get", self.p0_hash)["FundingResult"]["NoCount"], 1)
+        node.reconsiderblock(registration_block)
+        assert_equal(node.getbestblockhash(), registration_block)
+
 
 if __name__ == '__main__':
     MaximusGovernanceTest().main()
@@ -12,7 +12,6 @@ from decimal import Decimal
 
 from test_framework.messages import COIN, COutPoint, CTransaction, CTxIn, CTxOut
 from test_framework.script import CScript, OP_CHECKSIG, OP_DUP, OP_EQUALVERIFY, OP_HASH160
-from test_framework.test_node import ErrorMatch
 from test_framework.test_framework import BitcoinTestFramework
 from test_framework.util import assert_equal
 
@@ -41,15 +40,13 @@ class SpentIndexTest(BitcoinTestFramework):
         self.import_deterministic_coinbase_privkeys()
 
     def run_test(self):
-        self.log.info("Test that settings can't be changed without -reindex...")
-        self.stop_node(1)
-        self.nodes[1].assert_start_raises_init_error(["-spentindex=0"], "You need to rebuild the database using -reindex to change -spentindex", match=ErrorMatch.PARTIAL_REGEX)
-        self.start_node(1, ["-spentindex=0", "-reindex"])
+        self.log.info("Test that changing the setting rebuilds the index in the background...")
+        self.restart_node(1, ["-spentindex=0"])
+        assert_equal(self.nodes[1].getindexinfo("addressindex"), {})
         self.connect_nodes(0, 1)
         self.sync_all()
-        self.stop_node(1)
-        self.nodes[1].assert_start_raises_init_error(["-spentindex"], "You need to rebuild the database using -reindex to change -spentindex", match=ErrorMatch.PARTIAL_REGEX)
-        self.start_node(1, ["-spentindex", "-reindex"])
+        self.restart_node(1, ["-spentindex"])
+        self.wait_until(lambda: self.nodes[1].getindexinfo("addressindex")["addressindex"]["synced"])
         self.connect_nodes(0, 1)
         self.sync_all()
 
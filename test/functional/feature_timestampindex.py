@@ -8,7 +8,6 @@
 #
 
 from test_framework.test_framework import BitcoinTestFramework
-from test_framework.test_node import ErrorMatch
 from test_framework.util import assert_equal
 
 
@@ -33,15 +32,13 @@ class TimestampIndexTest(BitcoinTestFramework):
         self.sync_all()
 
     def run_test(self):
-        self.log.info("Test that settings can't be changed without -reindex...")
-        self.stop_node(1)
-        self.nodes[1].assert_start_raises_init_error(["-timestampindex=0"], "You need to rebuild the database using -reindex to change -timestampindex", match=ErrorMatch.PARTIAL_REGEX)
-        self.start_node(1, ["-timestampindex=0", "-reindex"])
+        self.log.info("Test that changing the setting rebuilds the index in the background...")
+        self.restart_node(1, ["-timestampindex=0"])
+        assert_equal(self.nodes[1].getindexinfo("addressindex"), {})
         self.connect_nodes(0, 1)
         self.sync_all()
-        self.stop_node(1)
-        self.nodes[1].assert_start_raises_init_error(["-timestampindex"], "You need to rebuild the database using -reindex to change -timestampindex", match=ErrorMatch.PARTIAL_REGEX)
-        self.start_node(1, ["-timestampindex", "-reindex"])
+        self.restart_node(1, ["-timestampindex"])
+        self.wait_until(lambda: self.nodes[1].getindexinfo("addressindex")["addressindex"]["synced"])
         self.connect_nodes(0, 1)
         self.sync_all()
 
@@ -14,6 +14,7 @@ class HTTPBasicsTest (BitcoinTestFramework):
     def set_test_params(self):
         self.num_nodes = 3
         self.supports_cli = False
+        self.extra_args = [[], [], ["-metrics"]]
 
     def setup_network(self):
         self.setup_nodes()
@@ -104,6 +105,27 @@ class HTTPBasicsTest (BitcoinTestFramework):
         out1 = conn.getresponse()
         assert_equal(out1.status, http.client.BAD_REQUEST)
 
+        # Prometheus metrics are only served with -metrics and need the RPC credentials
+        self.nodes[2].generatetoaddress(1, self.nodes[2].get_deterministic_priv_key().address)
+        conn = http.client.HTTPConnection(urlNode2.hostname, urlNode2.port)
+        conn.connect()
+        conn.request('GET', '/metrics')
+        out1 = conn.getresponse()
+        out1.read()
+        assert_equal(out1.status, http.client.UNAUTHORIZED)
+        conn.request('GET', '/metrics', '', headers)
+        out1 = conn.getresponse()
+        assert_equal(out1.status, http.client.OK)
+        metrics = out1.read().decode()
+        assert '# TYPE maximus_blocks_tip_Height gauge' in metrics
+        assert '# TYPE maximus_ConnectBlock_ms summary' in metrics
+
+        conn = http.client.HTTPConnection(url.hostname, url.port)
+        conn.connect()
+        conn.request('GET', '/metrics', '', headers)
+        out1 = conn.getresponse()
+        assert_equal(out1.status, http.client.NOT_FOUND)
+
 
 if __name__ == '__main__':
     HTTPBasicsTest ().main ()
@@ -342,5 +342,17 @@ class RESTTest (BitcoinTestFramework):
         json_obj = self.test_rest_request("/chaininfo")
         assert_equal(json_obj['bestblockhash'], bb_hash)
 
+        self.log.info("Test the /mnlistdiff URI")
+
+        null_hash = "00" * 32
+        json_obj = self.test_rest_request(f"/mnlistdiff/{null_hash}/{bb_hash}")
+        assert_equal(json_obj['baseBlockHash'], null_hash)
+        assert_equal(json_obj['blockHash'], bb_hash)
+        resp_bytes = self.test_rest_request(f"/mnlistdiff/{null_hash}/{bb_hash}", req_type=ReqType.BIN, ret_type=RetType.BYTES)
+        resp_hex = self.test_rest_request(f"/mnlistdiff/{null_hash}/{bb_hash}", req_type=ReqType.HEX, ret_type=RetType.OBJ)
+        assert_equal(resp_bytes.hex(), resp_hex.read().decode('utf-8').rstrip())
+        self.test_rest_request(f"/mnlistdiff/{null_hash}/{UNKNOWN_PARAM}", ret_type=RetType.OBJ, status=404)
+        self.test_rest_request(f"/mnlistdiff/{INVALID_PARAM}/{bb_hash}", ret_type=RetType.OBJ, status=400)
+
 if __name__ == '__main__':
     RESTTest().main()
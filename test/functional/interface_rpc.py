@@ -47,6 +47,7 @@ class RPCInterfaceTest(BitcoinTestFramework):
         assert_equal(command['method'], 'getrpcinfo')
         assert_greater_than_or_equal(command['duration'], 0)
         assert_equal(info['logpath'], os.path.join(self.nodes[0].datadir, self.chain, 'debug.log'))
+        assert_greater_than_or_equal(info['queue_times']['getrpcinfo']['count'], 1)
 
     def test_batch_request(self):
         self.log.info("Testing basic JSON-RPC batch request...")
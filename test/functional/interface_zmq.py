@@ -79,6 +79,7 @@ class ZMQTest (BitcoinTestFramework):
         try:
             self._zmq_test()
             self.test_multiple_interfaces()
+            self.test_batched_topics()
         finally:
             # Destroy the ZMQ context.
             self.log.debug("Destroying ZMQ context")
@@ -156,5 +157,39 @@ class ZMQTest (BitcoinTestFramework):
         assert_equal(self.nodes[0].getbestblockhash(), subscribers[0]['hashblock'].receive().hex())
         assert_equal(self.nodes[0].getbestblockhash(), subscribers[1]['hashblock'].receive().hex())
 
+    def test_batched_topics(self):
+        import zmq
+        address = 'tcp://127.0.0.1:28336'
+        socket = self.zmq_context.socket(zmq.SUB)
+        socket.set(zmq.RCVTIMEO, 60000)
+        hashtxbatch = ZMQSubscriber(socket, b"hashtxbatch")
+        socket.connect(address)
+
+        self.restart_node(0, ['-zmqpubhashtxbatch=%s' % address, '-zmqbatchinterval=2000'])
+        sleep(0.2)
+
+        self.log.info("Test that batched topics pack several events into one frame")
+        num_blocks = 3
+        genhashes = self.nodes[0].generatetoaddress(num_blocks, ADDRESS_BCRT1_UNSPENDABLE)
+        coinbase_txids = [self.nodes[0].getblock(h)["tx"][0] for h in genhashes]
+
+        txids = []
+        while len(txids) < num_blocks:
+            body = hashtxbatch.receive()
+            pos = 0
+            while pos < len(body):
+                # Every hash is prefixed by its CompactSize length
+                assert_equal(body[pos], 32)
+                txids.append(body[pos + 1:pos + 33].hex())
+                pos += 33
+            assert_equal(pos, len(body))
+        assert_equal(txids, coinbase_txids)
+        # Blocks were mined well within the flush interval, so fewer frames than events
+        assert hashtxbatch.sequence < num_blocks
+
+        assert_equal(self.nodes[0].getzmqnotifications(), [
+            {"type": "pubhashtxbatch", "address": address, "hwm": 1000},
+        ])
+
 if __name__ == '__main__':
     ZMQTest().main()
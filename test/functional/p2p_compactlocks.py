@@ -0,0 +1,60 @@
+#!/usr/bin/env python3
+# Copyright (c) 2024 The Maximus developers
+# Distributed under the MIT software license, see the accompanying
+# file COPYING or http://www.opensource.org/licenses/mit-license.php.
+"""Test the fallback of CMPCTISDLOCK/CMPCTCLSIG processing.
+
+A compact lock which can't be rebuilt from the mempool and the recovered sigs
+must be requested in full from the peer that announced it.
+"""
+import random
+
+from test_framework.messages import (
+    msg_cmpctclsig,
+    msg_cmpctisdlock,
+)
+from test_framework.p2p import P2PInterface, p2p_lock
+from test_framework.test_framework import BitcoinTestFramework
+
+MSG_CLSIG = 29
+MSG_ISDLOCK = 31
+
+
+class CompactLocksTest(BitcoinTestFramework):
+    def set_test_params(self):
+        self.num_nodes = 1
+        self.setup_clean_chain = True
+        self.extra_args = [["-sporkkey=cP4EKFyJsHT39LDqgdcB43Y3YXjNyjb5Fuas1GQSeAtjnZWmZEQK"]]
+
+    def requested(self, peer, inv_type, hash):
+        with p2p_lock:
+            getdata = peer.last_message.get("getdata")
+            return getdata is not None and any(inv.type == inv_type and inv.hash == hash for inv in getdata.inv)
+
+    def run_test(self):
+        node = self.nodes[0]
+        peer = node.add_p2p_connection(P2PInterface())
+
+        self.log.info("Compact locks are ignored while their spork is off")
+        peer.send_and_ping(msg_cmpctclsig(random.getrandbits(256), 1, random.getrandbits(256)))
+        peer.send_and_ping(msg_cmpctisdlock(random.getrandbits(256), 1, random.getrandbits(256), random.getrandbits(256)))
+        with p2p_lock:
+            assert "getdata" not in peer.last_message
+
+        node.sporkupdate("SPORK_2_INSTANTSEND_ENABLED", 0)
+        node.sporkupdate("SPORK_19_CHAINLOCKS_ENABLED", 0)
+        self.wait_until(lambda: node.spork("active")["SPORK_2_INSTANTSEND_ENABLED"] and node.spork("active")["SPORK_19_CHAINLOCKS_ENABLED"])
+
+        self.log.info("A CMPCTCLSIG without a matching recovered sig falls back to requesting the CLSIG")
+        clsig_hash = random.getrandbits(256)
+        peer.send_message(msg_cmpctclsig(clsig_hash, 1, random.getrandbits(256)))
+        self.wait_until(lambda: self.requested(peer, MSG_CLSIG, clsig_hash))
+
+        self.log.info("A CMPCTISDLOCK for an unknown transaction falls back to requesting the ISDLOCK")
+        islock_hash = random.getrandbits(256)
+        peer.send_message(msg_cmpctisdlock(islock_hash, 1, random.getrandbits(256), random.getrandbits(256)))
+        self.wait_until(lambda: self.requested(peer, MSG_ISDLOCK, islock_hash))
+
+
+if __name__ == '__main__':
+    CompactLocksTest().main()
@@ -39,11 +39,14 @@ class DumptxoutsetTest(BitcoinTestFramework):
             out['base_hash'],
             '0266fa3cd96867c40f2f3056da3b66daf8fb4c83ec4f3f5344fd3fe9755794b5')
 
-        with open(str(expected_path), 'rb') as f:
-            digest = hashlib.sha256(f.read()).hexdigest()
-            # UTXO snapshot hash should be deterministic based on mocked time.
-            assert_equal(
-                digest, '83ec62f0b9d9f2cdfe4514e8996d5ba0a6aa4cf74517988670d912db83bc0318')
+        assert_equal(len(out['evodb_hash']), 64)
+
+        # The snapshot, including its evodb section, is deterministic for the same chain state.
+        out2 = node.dumptxoutset(FILENAME + '.2')
+        assert_equal(out2['evodb_entries_written'], out['evodb_entries_written'])
+        assert_equal(out2['evodb_hash'], out['evodb_hash'])
+        with open(str(expected_path), 'rb') as f, open(out2['path'], 'rb') as f2:
+            assert_equal(hashlib.sha256(f.read()).hexdigest(), hashlib.sha256(f2.read()).hexdigest())
 
         # Specifying a path to an existing file will fail.
         assert_raises_rpc_error(
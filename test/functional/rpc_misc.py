@@ -20,6 +20,7 @@ class RpcMiscTest(BitcoinTestFramework):
     def set_test_params(self):
         self.num_nodes = 1
         self.supports_cli = False
+        self.extra_args = [["-lockstats"]]
 
     def run_test(self):
         node = self.nodes[0]
@@ -54,6 +55,15 @@ class RpcMiscTest(BitcoinTestFramework):
 
         assert_raises_rpc_error(-8, "unknown mode foobar", node.getmemoryinfo, mode="foobar")
 
+        self.log.info("test getlockstats")
+        lockstats = node.getlockstats()
+        assert_equal(lockstats['enabled'], True)
+        assert any(lock['lock'] == 'cs_main' for lock in lockstats['locks'])
+        for lock in lockstats['locks']:
+            assert_equal(len(lock['wait_histogram']), 24)
+            assert_equal(sum(site['contentions'] for site in lock['sites']), lock['contentions'])
+        node.getlockstats(reset=True)
+
         self.log.info("test logging rpc and help")
 
         # Test logging RPC returns the expected number of logging categories.
@@ -58,6 +58,7 @@ class NetTest(MaximusTestFramework):
         self.test_connection_count()
         self.test_getpeerinfo()
         self.test_getnettotals()
+        self.test_getnetmsgstats()
         self.test_getnetworkinfo()
         self.test_getaddednodeinfo()
         self.test_service_flags()
@@ -87,6 +88,20 @@ class NetTest(MaximusTestFramework):
             self.wait_until(lambda: peer_after()['bytesrecv_per_msg'].get('pong', 0) >= peer_before['bytesrecv_per_msg'].get('pong', 0) + 32, timeout=1)
             self.wait_until(lambda: peer_after()['bytessent_per_msg'].get('ping', 0) >= peer_before['bytessent_per_msg'].get('ping', 0) + 32, timeout=1)
 
+    def test_getnetmsgstats(self):
+        self.log.info("Test getnetmsgstats")
+        # The pongs of the pings above have been processed
+        stats = self.nodes[0].getnetmsgstats()
+        assert 'pong' in stats
+        pong = stats['pong']
+        assert pong['count'] > 0
+        assert pong['max_process_us'] <= pong['process_us']
+        assert_equal(sum(pong['process_histogram']), pong['count'])
+        assert_equal(sum(pong['wait_histogram']), pong['count'])
+
+        self.nodes[0].getnetmsgstats(reset=True)
+        assert 'version' not in self.nodes[0].getnetmsgstats()
+
     def test_getnetworkinfo(self):
         self.log.info("Test getnetworkinfo")
         info = self.nodes[0].getnetworkinfo()
@@ -2266,6 +2266,60 @@ class msg_isdlock:
                (self.nVersion, repr(self.inputs), self.txid, self.cycleHash)
 
 
+class msg_cmpctclsig:
+    __slots__ = ("hash", "height", "blockHash")
+    msgtype = b"cmpctclsig"
+
+    def __init__(self, hash=0, height=0, blockHash=0):
+        self.hash = hash
+        self.height = height
+        self.blockHash = blockHash
+
+    def deserialize(self, f):
+        self.hash = deser_uint256(f)
+        self.height = struct.unpack('<i', f.read(4))[0]
+        self.blockHash = deser_uint256(f)
+
+    def serialize(self):
+        r = b""
+        r += ser_uint256(self.hash)
+        r += struct.pack('<i', self.height)
+        r += ser_uint256(self.blockHash)
+        return r
+
+    def __repr__(self):
+        return "msg_cmpctclsig(hash=%064x, height=%d, blockHash=%064x)" % (self.hash, self.height, self.blockHash)
+
+
+class msg_cmpctisdlock:
+    __slots__ = ("hash", "nVersion", "txid", "cycleHash")
+    msgtype = b"cmpctisdlock"
+
+    def __init__(self, hash=0, nVersion=1, txid=0, cycleHash=0):
+        self.hash = hash
+        self.nVersion = nVersion
+        self.txid = txid
+        self.cycleHash = cycleHash
+
+    def deserialize(self, f):
+        self.hash = deser_uint256(f)
+        self.nVersion = struct.unpack("<B", f.read(1))[0]
+        self.txid = deser_uint256(f)
+        self.cycleHash = deser_uint256(f)
+
+    def serialize(self):
+        r = b""
+        r += ser_uint256(self.hash)
+        r += struct.pack("<B", self.nVersion)
+        r += ser_uint256(self.txid)
+        r += ser_uint256(self.cycleHash)
+        return r
+
+    def __repr__(self):
+        return "msg_cmpctisdlock(hash=%064x, nVersion=%d, txid=%064x, cycleHash=%064x)" % \
+               (self.hash, self.nVersion, self.txid, self.cycleHash)
+
+
 class msg_qsigshare:
     __slots__ = ("sig_shares",)
     msgtype = b"qsigshare"
@@ -43,6 +43,8 @@ from test_framework.messages import (
     msg_cfilter,
     msg_clsig,
     msg_cmpctblock,
+    msg_cmpctclsig,
+    msg_cmpctisdlock,
     msg_filteradd,
     msg_filterclear,
     msg_filterload,
@@ -123,6 +125,8 @@ MESSAGEMAP = {
     b"version": msg_version,
     # Maximus Specific
     b"clsig": msg_clsig,
+    b"cmpctclsig": msg_cmpctclsig,
+    b"cmpctisdlock": msg_cmpctisdlock,
     b"getmnlistd": msg_getmnlistd,
     b"getsporks": None,
     b"govsync": None,
@@ -439,6 +443,8 @@ class P2PInterface(P2PConnection):
 
     def on_mnlistdiff(self, message): pass
     def on_clsig(self, message): pass
+    def on_cmpctclsig(self, message): pass
+    def on_cmpctisdlock(self, message): pass
     def on_islock(self, message): pass
     def on_isdlock(self, message): pass
 
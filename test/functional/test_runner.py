@@ -103,6 +103,7 @@ BASE_SCRIPTS = [
     'p2p_quorum_data.py',
     # vv Tests less than 2m vv
     'p2p_instantsend.py',
+    'p2p_compactlocks.py',
     'wallet_basic.py',
     'wallet_labels.py',
     'p2p_timeouts.py',
@@ -221,6 +222,7 @@ BASE_SCRIPTS = [
     'mempool_accept.py',
     'mempool_expiry.py',
     'wallet_import_rescan.py',
+    'wallet_fast_rescan.py',
     'wallet_import_with_label.py',
     'wallet_upgradewallet.py',
     'wallet_mnemonicbits.py',
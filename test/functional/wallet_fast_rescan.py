@@ -0,0 +1,60 @@
+#!/usr/bin/env python3
+# Copyright (c) 2024 The Maximus developers
+# Distributed under the MIT software license, see the accompanying
+# file COPYING or http://www.opensource.org/licenses/mit-license.php.
+"""Test that rescans skip blocks using the block filter index, and find the same transactions."""
+
+from decimal import Decimal
+
+from test_framework.test_framework import BitcoinTestFramework
+from test_framework.util import assert_equal
+
+
+class WalletFastRescanTest(BitcoinTestFramework):
+    def set_test_params(self):
+        self.setup_clean_chain = True
+        self.num_nodes = 1
+        self.extra_args = [["-blockfilterindex=1"]]
+
+    def skip_test_if_missing_module(self):
+        self.skip_if_no_wallet()
+
+    def run_test(self):
+        node = self.nodes[0]
+        funder = node.get_wallet_rpc(self.default_wallet_name)
+        node.generatetoaddress(101, funder.getnewaddress())
+
+        self.log.info("Create a key in a throwaway wallet and pay to it in a few different blocks")
+        node.createwallet(wallet_name="source")
+        source = node.get_wallet_rpc("source")
+        addresses = [source.getnewaddress() for _ in range(3)]
+        privkeys = [source.dumpprivkey(address) for address in addresses]
+        node.unloadwallet("source")
+
+        total = Decimal(0)
+        for i, address in enumerate(addresses):
+            amount = Decimal(i + 1)
+            funder.sendtoaddress(address, amount)
+            total += amount
+            # Leave blocks in between that have nothing for these keys
+            node.generatetoaddress(5, funder.getnewaddress())
+        self.wait_until(lambda: all(i["synced"] for i in node.getindexinfo().values()))
+
+        self.log.info("Import the keys into a fresh wallet, rescanning with the block filters")
+        node.createwallet(wallet_name="fast", disable_private_keys=False, blank=True)
+        fast = node.get_wallet_rpc("fast")
+        with node.assert_debug_log(["Rescan skips blocks whose block filter matches none of the wallet's scripts"]):
+            for privkey in privkeys[:-1]:
+                fast.importprivkey(privkey, "", False)
+            fast.importprivkey(privkeys[-1], "", True)
+        assert_equal(fast.getbalance(), total)
+        assert_equal(len(fast.listtransactions()), len(addresses))
+
+        self.log.info("Rescan again and make sure nothing changes")
+        fast.rescanblockchain()
+        assert_equal(fast.getbalance(), total)
+        assert_equal(len(fast.listtransactions()), len(addresses))
+
+
+if __name__ == '__main__':
+    WalletFastRescanTest().main()